@@ -13,6 +13,7 @@
 #include "isl_tab.h"
 #include <isl_int.h>
 #include <isl_config.h>
+#include "isl_task.h"
 
 struct tab_lp {
 	struct isl_ctx  *ctx;
@@ -43,10 +44,31 @@ struct tab_lp {
 #define GBR_is_zero(a)			    (mpq_sgn(a) == 0)
 #define GBR_numref(a)			    mpq_numref(a)
 #define GBR_denref(a)			    mpq_denref(a)
+#ifdef USE_SMALL_INT_OPT
+#define GBR_floor(a, b)	isl_sioimath_fdiv_q((a),			\
+	    isl_sioimath_encode_big(GBR_numref(b)),			\
+	    isl_sioimath_encode_big(GBR_denref(b)))
+#define GBR_ceil(a, b)	isl_sioimath_cdiv_q((a),			\
+	    isl_sioimath_encode_big(GBR_numref(b)),			\
+	    isl_sioimath_encode_big(GBR_denref(b)))
+#define GBR_set_num_neg(a, b)                              \
+	do {                                               \
+		isl_sioimath_scratchspace_t scratch;       \
+		mpz_neg(GBR_numref(*a),                    \
+		    isl_sioimath_bigarg_src(*b, &scratch));\
+	} while (0)
+#define GBR_set_den(a, b)                                  \
+	do {                                               \
+		isl_sioimath_scratchspace_t scratch;       \
+		mpz_set(GBR_denref(*a),                    \
+		    isl_sioimath_bigarg_src(*b, &scratch));\
+	} while (0)
+#else /* USE_SMALL_INT_OPT */
 #define GBR_floor(a,b)			    mpz_fdiv_q(a,GBR_numref(b),GBR_denref(b))
 #define GBR_ceil(a,b)			    mpz_cdiv_q(a,GBR_numref(b),GBR_denref(b))
 #define GBR_set_num_neg(a, b)		    mpz_neg(GBR_numref(*a), b);
 #define GBR_set_den(a, b)		    mpz_set(GBR_denref(*a), b);
+#endif /* USE_SMALL_INT_OPT */
 #endif /* USE_GMP_FOR_MP */
 
 #ifdef USE_IMATH_FOR_MP
@@ -96,6 +118,8 @@ static int add_lp_row(struct tab_lp *lp, isl_int *row, int dim);
 static void get_alpha(struct tab_lp* lp, int row, GBR_type *alpha);
 static int del_lp_row(struct tab_lp *lp) WARN_UNUSED;
 static int cut_lp_to_hyperplane(struct tab_lp *lp, isl_int *row);
+static struct tab_lp *fork_lp(struct tab_lp *lp, isl_int *row, int dim);
+static int join_lp(struct tab_lp *lp, struct tab_lp *fork);
 
 #define GBR_LP			    	    struct tab_lp
 #define GBR_lp_init(P)		    	    init_lp(P)
@@ -109,6 +133,8 @@ static int cut_lp_to_hyperplane(struct tab_lp *lp, isl_int *row);
 #define GBR_lp_del_row(lp)		    del_lp_row(lp)
 #define GBR_lp_is_fixed(lp)		    (lp)->is_fixed
 #define GBR_lp_cut(lp, obj)	    	    cut_lp_to_hyperplane(lp, obj)
+#define GBR_lp_fork(lp, obj, dim)	    fork_lp(lp, obj, dim)
+#define GBR_lp_join(lp, fork)		    join_lp(lp, fork)
 #include "basis_reduction_templ.c"
 
 /* Set up a tableau for the Cartesian product of bset with itself.
@@ -291,3 +317,159 @@ static int del_lp_row(struct tab_lp *lp)
 	lp->neq--;
 	return isl_tab_rollback(lp->tab, lp->stack[lp->neq]);
 }
+
+/* Return a copy of "lp" in "ctx" with objective function "row",
+ * for solving it independently of "lp".
+ * The undo records of "lp" are not needed for a single solve.
+ * The dual values of "lp" are copied along since the caller may
+ * read them even if the solve does not update them.
+ */
+static struct tab_lp *copy_lp_to_ctx(struct tab_lp *lp, isl_int *row,
+	isl_ctx *ctx)
+{
+	struct tab_lp *copy;
+
+	copy = isl_calloc_type(ctx, struct tab_lp);
+	if (!copy)
+		return NULL;
+
+	isl_int_init(copy->opt);
+	isl_int_init(copy->opt_denom);
+	isl_int_init(copy->tmp);
+	isl_int_init(copy->tmp2);
+
+	copy->dim = lp->dim;
+	copy->ctx = ctx;
+	isl_ctx_ref(copy->ctx);
+	copy->row = isl_vec_alloc(copy->ctx, 1 + 2 * copy->dim);
+	copy->tab = isl_tab_copy_to_ctx(lp->tab, copy->ctx);
+	if (!copy->row || !copy->tab)
+		goto error;
+	if (lp->tab->dual) {
+		copy->tab->dual = isl_vec_copy_to_ctx(lp->tab->dual, copy->ctx);
+		if (!copy->tab->dual)
+			goto error;
+	}
+	copy->con_offset = lp->con_offset;
+	copy->neq = lp->neq;
+	copy->obj = row;
+
+	return copy;
+error:
+	delete_lp(copy);
+	return NULL;
+}
+
+/* Return an LP with the same constraints as "lp" and
+ * objective function "row" that is solved together with "lp"
+ * by join_lp, if the gbr_threads option is set to a value greater than one.
+ * Otherwise, return NULL such that the caller solves the LP itself.
+ *
+ * The returned LP does not have a tableau of its own.
+ * It only receives the outcome of the solve in join_lp.
+ */
+static struct tab_lp *fork_lp(struct tab_lp *lp, isl_int *row, int dim)
+{
+	struct tab_lp *fork;
+
+	if (lp->ctx->opt->gbr_threads <= 1)
+		return NULL;
+
+	fork = isl_calloc_type(lp->ctx, struct tab_lp);
+	if (!fork)
+		return NULL;
+
+	isl_int_init(fork->opt);
+	isl_int_init(fork->opt_denom);
+	isl_int_init(fork->tmp);
+	isl_int_init(fork->tmp2);
+
+	fork->dim = lp->dim;
+	fork->ctx = lp->ctx;
+	isl_ctx_ref(fork->ctx);
+	fork->con_offset = lp->con_offset;
+	fork->neq = lp->neq;
+	set_lp_obj(fork, row, dim);
+
+	return fork;
+}
+
+/* Data used by join_lp.
+ * "lp" and "fork" are the LPs of the two tasks and
+ * "res" are the copies that are solved by these tasks.
+ */
+struct isl_gbr_tasks {
+	struct tab_lp *lp;
+	struct tab_lp *fork;
+	struct tab_lp *res[2];
+};
+
+/* Solve a copy in "ctx" of the LP of task "k",
+ * with the constraints of data->lp.
+ */
+static isl_stat gbr_task_run(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_gbr_tasks *data = user;
+	struct tab_lp *lp_k = k ? data->fork : data->lp;
+
+	data->res[k] = copy_lp_to_ctx(data->lp, lp_k->obj, ctx);
+	if (!data->res[k])
+		return isl_stat_error;
+	if (solve_lp(data->res[k]) < 0) {
+		delete_lp(data->res[k]);
+		data->res[k] = NULL;
+		return isl_stat_error;
+	}
+	return isl_stat_ok;
+}
+
+/* Store the outcome of the solve of task "k" in the corresponding LP,
+ * which lives in "ctx".
+ * The tableau of this LP, if any, is not updated, apart from
+ * its dual values, since it is only needed for obtaining these dual values.
+ */
+static isl_stat gbr_task_merge(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_gbr_tasks *data = user;
+	struct tab_lp *lp_k = k ? data->fork : data->lp;
+	struct tab_lp *res = data->res[k];
+	isl_vec *dual;
+
+	isl_int_set(lp_k->opt, res->opt);
+	isl_int_set(lp_k->opt_denom, res->opt_denom);
+	lp_k->is_fixed = res->is_fixed;
+	if (!lp_k->tab) {
+		lp_k->tab = isl_tab_copy_to_ctx(res->tab, ctx);
+		if (!lp_k->tab)
+			goto error;
+	}
+	dual = isl_vec_copy_to_ctx(res->tab->dual, ctx);
+	if (res->tab->dual && !dual)
+		goto error;
+	isl_vec_free(lp_k->tab->dual);
+	lp_k->tab->dual = dual;
+
+	delete_lp(res);
+	data->res[k] = NULL;
+	return isl_stat_ok;
+error:
+	delete_lp(res);
+	data->res[k] = NULL;
+	return isl_stat_error;
+}
+
+/* Solve "lp", with its current objective function, and
+ * the LP "fork" constructed by fork_lp.
+ * The two LPs are solved in tasks of isl_ctx_run_tasks,
+ * using up to as many threads as specified by the gbr_threads option.
+ * Each task solves a copy of the LP in a child context.
+ */
+static int join_lp(struct tab_lp *lp, struct tab_lp *fork)
+{
+	struct isl_gbr_tasks data = { lp, fork };
+
+	if (isl_ctx_run_tasks(lp->ctx, 2, lp->ctx->opt->gbr_threads,
+				&gbr_task_run, &gbr_task_merge, &data) < 0)
+		return -1;
+	return 0;
+}
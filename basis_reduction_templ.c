@@ -42,11 +42,12 @@ static void save_alpha(GBR_LP *lp, int first, int n, GBR_type *alpha)
  *  for Integer Programming" of Cook el al. to compute a reduced basis.
  * We use \epsilon = 1/4.
  *
- * If ctx->opt->gbr_only_first is set, the user is only interested
+ * If "gbr_only_first" is set, the user is only interested
  * in the first direction.  In this case we stop the basis reduction when
  * the width in the first direction becomes smaller than 2.
  */
-struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
+struct isl_tab *isl_tab_compute_reduced_basis_only_first(struct isl_tab *tab,
+	int gbr_only_first)
 {
 	unsigned dim;
 	struct isl_ctx *ctx;
@@ -56,7 +57,7 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 	GBR_type F_old, alpha, F_new;
 	int row;
 	isl_int tmp;
-	struct isl_vec *b_tmp;
+	struct isl_vec *b_tmp[2] = { NULL, NULL };
 	GBR_type *F = NULL;
 	GBR_type *alpha_buffer[2] = { NULL, NULL };
 	GBR_type *alpha_saved;
@@ -71,7 +72,6 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 	int fixed_saved = 0;
 	int mu_fixed[2];
 	int n_bounded;
-	int gbr_only_first;
 
 	if (!tab)
 		return NULL;
@@ -80,7 +80,6 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 		return tab;
 
 	ctx = tab->mat->ctx;
-	gbr_only_first = ctx->opt->gbr_only_first;
 	dim = tab->n_var;
 	B = tab->basis;
 	if (!B)
@@ -103,8 +102,9 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 	GBR_init(two);
 	GBR_init(one);
 
-	b_tmp = isl_vec_alloc(ctx, dim);
-	if (!b_tmp)
+	b_tmp[0] = isl_vec_alloc(ctx, dim);
+	b_tmp[1] = isl_vec_alloc(ctx, dim);
+	if (!b_tmp[0] || !b_tmp[1])
 		goto error;
 
 	F = isl_alloc_array(ctx, GBR_type, n_bounded);
@@ -186,21 +186,39 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 			isl_int_set(tmp, mu[0]);
 		else {
 			int j;
+			int r = 0;
+			GBR_LP *fork;
 
-			for (j = 0; j <= 1; ++j) {
-				isl_int_set(tmp, mu[j]);
-				isl_seq_combine(b_tmp->el,
+			for (j = 0; j <= 1; ++j)
+				isl_seq_combine(b_tmp[j]->el,
 						ctx->one, B->row[1+i+1]+1,
-						tmp, B->row[1+i]+1, dim);
-				GBR_lp_set_obj(lp, b_tmp->el, dim);
+						mu[j], B->row[1+i]+1, dim);
+			fork = GBR_lp_fork(lp, b_tmp[1]->el, dim);
+			if (fork) {
+				GBR_lp_set_obj(lp, b_tmp[0]->el, dim);
+				r = GBR_lp_join(lp, fork);
+			}
+			for (j = 0; j <= 1; ++j) {
+				GBR_LP *lp_j = lp;
+
 				ctx->stats->gbr_solved_lps++;
-				if (GBR_lp_solve(lp) < 0)
-					goto error;
-				GBR_lp_get_obj_val(lp, &mu_F[j]);
-				mu_fixed[j] = GBR_lp_is_fixed(lp);
+				if (fork) {
+					if (j == 1)
+						lp_j = fork;
+				} else {
+					GBR_lp_set_obj(lp, b_tmp[j]->el, dim);
+					r = GBR_lp_solve(lp);
+				}
+				if (r < 0)
+					break;
+				GBR_lp_get_obj_val(lp_j, &mu_F[j]);
+				mu_fixed[j] = GBR_lp_is_fixed(lp_j);
 				if (i > 0)
-					save_alpha(lp, row-i, i, alpha_buffer[j]);
+					save_alpha(lp_j, row-i, i, alpha_buffer[j]);
 			}
+			GBR_lp_delete(fork);
+			if (j <= 1)
+				goto error;
 
 			if (GBR_lt(mu_F[0], mu_F[1]))
 				j = 0;
@@ -284,7 +302,8 @@ error:
 	free(alpha_buffer[0]);
 	free(alpha_buffer[1]);
 
-	isl_vec_free(b_tmp);
+	isl_vec_free(b_tmp[0]);
+	isl_vec_free(b_tmp[1]);
 
 	GBR_clear(alpha);
 	GBR_clear(F_old);
@@ -304,6 +323,18 @@ error:
 	return tab;
 }
 
+/* Compute a reduced basis for the set represented by the tableau "tab",
+ * stopping early if the gbr_only_first option is set.
+ */
+struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
+{
+	if (!tab)
+		return NULL;
+
+	return isl_tab_compute_reduced_basis_only_first(tab,
+					    tab->mat->ctx->opt->gbr_only_first);
+}
+
 /* Compute an affine form of a reduced basis of the given basic
  * non-parametric set, which is assumed to be bounded and not
  * include any integer divisions.
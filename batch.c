@@ -0,0 +1,260 @@
+/*
+ * Use of this software is governed by the MIT license
+ */
+
+/* A driver for applications that solve one problem per input file,
+ * allowing a collection of problems to be processed in a single run.
+ *
+ * If no file names are specified, then a single problem is read
+ * from stdin.  Otherwise, each of the named files is processed and
+ * if there is more than one of them, then the result of each problem
+ * is preceded by a header line containing the name of the file.
+ * A file name of "-" refers to stdin.
+ *
+ * If more than one thread is requested, then the files are distributed
+ * over that many threads, each with its own (child) isl_ctx.
+ * The output of each problem is then collected in a temporary file and
+ * only printed once all problems have been solved, in the order
+ * of the file names, such that the output does not depend
+ * on the number of threads.
+ *
+ * If "timing" is set, then the wall clock time taken by each problem
+ * is printed on stderr, along with the total time.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <isl_config.h>
+
+#ifdef HAVE_GETTIMEOFDAY
+#include <sys/time.h>
+#endif
+
+#include "isl_task.h"
+#include "batch.h"
+
+/* Return the current wall clock time in seconds.
+ */
+static double wall_time(void)
+{
+#ifdef HAVE_GETTIMEOFDAY
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + 1e-6 * tv.tv_usec;
+#else
+	return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Check that none of the remaining "argc" - 1 arguments in "argv"
+ * (after option parsing) looks like an option, other than "-",
+ * which refers to stdin.
+ * Return 0 if they are all file names and -1 otherwise.
+ */
+int batch_check_args(int argc, char **argv)
+{
+	int i;
+
+	for (i = 1; i < argc; ++i) {
+		if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0)
+			continue;
+		fprintf(stderr, "%s: unrecognized option: %s\n",
+			argv[0], argv[i]);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Solve the problem in the file called "name" using "fn",
+ * printing the result on "out".
+ * Return 0 on success and -1 on error.
+ */
+static int process_file(isl_ctx *ctx, const char *name, FILE *out,
+	batch_fn fn, void *user)
+{
+	FILE *file;
+	int r;
+
+	if (strcmp(name, "-") == 0)
+		return fn(ctx, stdin, out, user);
+	file = fopen(name, "r");
+	if (!file) {
+		fprintf(stderr, "unable to open %s\n", name);
+		return -1;
+	}
+	r = fn(ctx, file, out, user);
+	fclose(file);
+
+	return r;
+}
+
+/* The state of a single problem.
+ *
+ * "out" collects the output of the problem if it is solved
+ * by a separate thread.
+ * "time" is the time it took to solve the problem.
+ * "r" is the result of solving the problem.
+ */
+struct batch_problem {
+	FILE *out;
+	double time;
+	int r;
+};
+
+/* Solve the problem in the file called "name" using "fn",
+ * printing the result on "out" and recording the outcome in "problem".
+ */
+static void solve(isl_ctx *ctx, const char *name, FILE *out,
+	struct batch_problem *problem, batch_fn fn, void *user)
+{
+	double start;
+
+	start = wall_time();
+	problem->r = process_file(ctx, name, out, fn, user);
+	problem->time = wall_time() - start;
+}
+
+/* Data used by solve_threads.
+ */
+struct batch_tasks {
+	char **names;
+	struct batch_problem *problems;
+	batch_fn fn;
+	void *user;
+};
+
+/* Solve problem "i" of "user" in "ctx".
+ * Any failure is recorded in the problem itself rather than
+ * reported to isl_ctx_run_tasks since the problem should not be solved
+ * a second time, as it may already have produced some output.
+ */
+static isl_stat batch_task_run(isl_ctx *ctx, int i, void *user)
+{
+	struct batch_tasks *data = user;
+	struct batch_problem *problem = &data->problems[i];
+
+	if (!problem->out)
+		problem->r = -1;
+	else
+		solve(ctx, data->names[i], problem->out, problem,
+			data->fn, data->user);
+
+	return isl_stat_ok;
+}
+
+/* The output of each problem is printed by batch_process,
+ * so there is nothing left to be done here.
+ */
+static isl_stat batch_task_merge(isl_ctx *ctx, int i, void *user)
+{
+	return isl_stat_ok;
+}
+
+/* Solve the "n" problems in the files called "names" using up to
+ * "n_thread" threads, each with its own child context of "ctx".
+ * The output of each problem is collected in problems[i].out.
+ * Each problem is solved in a task of isl_ctx_run_tasks,
+ * which hands out the problems dynamically such that
+ * a few expensive problems do not keep the other threads waiting.
+ */
+static void solve_threads(isl_ctx *ctx, int n, char **names,
+	struct batch_problem *problems, int n_thread, batch_fn fn, void *user)
+{
+	int i;
+	struct batch_tasks data = { names, problems, fn, user };
+
+	if (isl_ctx_run_tasks(ctx, n, n_thread, &batch_task_run,
+				&batch_task_merge, &data) >= 0)
+		return;
+	for (i = 0; i < n; ++i)
+		problems[i].r = -1;
+}
+
+/* Copy the contents of the temporary file "file" to stdout.
+ */
+static void dump(FILE *file)
+{
+	char buf[4096];
+	size_t n;
+
+	rewind(file);
+	while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+		fwrite(buf, 1, n, stdout);
+}
+
+/* Print the outcome of the problem in the file called "name",
+ * i.e., a header if "header" is set, the output collected
+ * in problem->out, if any, and the time if "timing" is set.
+ */
+static void report(const char *name, struct batch_problem *problem,
+	int header, int timing)
+{
+	if (header)
+		printf("==> %s <==\n", name);
+	if (problem->out)
+		dump(problem->out);
+	fflush(stdout);
+	if (timing)
+		fprintf(stderr, "%s: %.3f s%s\n", name, problem->time,
+			problem->r < 0 ? " (failed)" : "");
+}
+
+/* Solve the "n" problems in the files called "names" using "fn",
+ * or the single problem on stdin if "n" is zero,
+ * using "n_thread" threads if it is greater than one.
+ * Return 0 if all problems were solved successfully and -1 otherwise.
+ */
+int batch_process(isl_ctx *ctx, int n, char **names, int n_thread,
+	int timing, batch_fn fn, void *user)
+{
+	static char *std_in[] = { "-" };
+	int i;
+	int r = 0;
+	int header = n > 1;
+	double start;
+	struct batch_problem *problems;
+
+	if (n == 0) {
+		n = 1;
+		names = std_in;
+	}
+	problems = calloc(n, sizeof(*problems));
+	if (!problems)
+		return -1;
+
+	start = wall_time();
+	if (n_thread > 1 && n > 1) {
+		for (i = 0; i < n; ++i) {
+			problems[i].out = tmpfile();
+			if (!problems[i].out)
+				fprintf(stderr, "unable to create temporary "
+					"file for %s\n", names[i]);
+		}
+		solve_threads(ctx, n, names, problems, n_thread, fn, user);
+		for (i = 0; i < n; ++i) {
+			report(names[i], &problems[i], header, timing);
+			if (problems[i].out)
+				fclose(problems[i].out);
+		}
+	} else {
+		for (i = 0; i < n; ++i) {
+			if (header)
+				printf("==> %s <==\n", names[i]);
+			solve(ctx, names[i], stdout, &problems[i], fn, user);
+			report(names[i], &problems[i], 0, timing);
+		}
+	}
+	if (timing)
+		fprintf(stderr, "total: %.3f s\n", wall_time() - start);
+
+	for (i = 0; i < n; ++i)
+		if (problems[i].r < 0)
+			r = -1;
+	free(problems);
+
+	return r;
+}
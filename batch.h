@@ -0,0 +1,17 @@
+#ifndef ISL_BATCH_H
+#define ISL_BATCH_H
+
+#include <stdio.h>
+#include <isl/ctx.h>
+
+/* A function that reads a single problem from "in", solves it
+ * using "ctx" and prints the result on "out".
+ * It returns 0 on success and -1 on error.
+ */
+typedef int (*batch_fn)(isl_ctx *ctx, FILE *in, FILE *out, void *user);
+
+int batch_process(isl_ctx *ctx, int n, char **names, int n_thread,
+	int timing, batch_fn fn, void *user);
+int batch_check_args(int argc, char **argv);
+
+#endif
@@ -0,0 +1,1249 @@
+/*
+ * Use of this software is governed by the MIT license
+ */
+
+/* This program times a number of key operations on representative inputs
+ * and prints the results in JSON format.
+ * For each combination of operation and input, the operation is
+ * performed a (configurable) number of times and the minimal and
+ * average wall clock time is reported, along with the average
+ * number of operations performed by the isl_ctx (see
+ * isl_ctx_get_operations), the average number of allocations
+ * and allocated bytes (see isl_ctx_get_memory_stats)
+ * and the maximal resident set size
+ * of the process so far, as reported by getrusage.
+ * Note that the latter only ever increases and that it is expressed
+ * in kilobytes on most systems.
+ * Some operations are also timed on generated workloads
+ * of increasing size to expose the scaling behavior of the operations.
+ *
+ * With the --check option, each operation is instead performed once
+ * and the number of operations is compared against a stored baseline.
+ * Since the number of operations does not depend on the load
+ * of the machine, this allows performance regressions to be detected
+ * reliably.  The --baseline option prints the numbers of operations
+ * in the format of such a baseline file.
+ *
+ * With the --replay option, only coalescing of the map stored
+ * in the given file is timed (or checked).  This is meant for
+ * replaying the most expensive coalescing inputs recorded through
+ * the --isl-stats-top-coalesce option, as extracted by isl_stats.py.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <isl_config.h>
+
+#ifdef HAVE_GETTIMEOFDAY
+#include <sys/time.h>
+#endif
+#ifdef HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+
+#include <isl/ctx.h>
+#include <isl/options.h>
+#include <isl/set.h>
+#include <isl/map.h>
+#include <isl/union_set.h>
+#include <isl/union_map.h>
+#include <isl/val.h>
+#include <isl/printer.h>
+#include <isl/flow.h>
+#include <isl/schedule.h>
+#include <isl/schedule_node.h>
+#include <isl/ast_build.h>
+#include <isl/version.h>
+
+#include "isl_srcdir.c"
+
+#define ARRAY_SIZE(array) (sizeof(array)/sizeof(*array))
+
+struct options {
+	struct isl_options	*isl;
+	int			 repeat;
+	char			*only;
+	int			 max_size;
+	char			*check;
+	int			 tolerance;
+	int			 baseline;
+	char			*replay;
+};
+
+ISL_ARGS_START(struct options, options_args)
+ISL_ARG_CHILD(struct options, isl, "isl", &isl_options_args, "isl options")
+ISL_ARG_INT(struct options, repeat, 0, "repeat", "n", 5,
+	"number of times each operation is performed on each input")
+ISL_ARG_STR(struct options, only, 0, "only", "operation", NULL,
+	"only time the given operation")
+ISL_ARG_INT(struct options, max_size, 0, "max-size", "size", 64,
+	"maximal size of the generated workloads")
+ISL_ARG_STR(struct options, check, 0, "check", "file", NULL,
+	"check the numbers of operations against the baseline in \"file\"")
+ISL_ARG_INT(struct options, tolerance, 0, "tolerance", "percentage", 100,
+	"percentage by which the number of operations may exceed "
+	"the baseline")
+ISL_ARG_BOOL(struct options, baseline, 0, "baseline", 0,
+	"print the numbers of operations in the format of a baseline file")
+ISL_ARG_STR(struct options, replay, 0, "replay", "file", NULL,
+	"only time coalescing of the map in \"file\"")
+ISL_ARGS_END
+
+ISL_ARG_DEF(bench_options, struct options, options_args)
+
+/* The input of a benchmark.
+ * Only the fields that are relevant for the operation are set.
+ */
+struct bench_input {
+	isl_set *set;
+	isl_map *map1;
+	isl_map *map2;
+	isl_union_set *uset;
+	isl_union_access_info *access;
+	isl_schedule_constraints *sc;
+	isl_schedule *schedule;
+};
+
+/* Free all fields of "in".
+ */
+static void bench_input_clear(struct bench_input *in)
+{
+	isl_set_free(in->set);
+	isl_map_free(in->map1);
+	isl_map_free(in->map2);
+	isl_union_set_free(in->uset);
+	isl_union_access_info_free(in->access);
+	isl_schedule_constraints_free(in->sc);
+	isl_schedule_free(in->schedule);
+}
+
+/* Read "set" into "in".
+ */
+static isl_stat setup_set(isl_ctx *ctx, struct bench_input *in,
+	const char *set, const char *unused)
+{
+	in->set = isl_set_read_from_str(ctx, set);
+	return in->set ? isl_stat_ok : isl_stat_error;
+}
+
+/* Read "map1" and, if it is not NULL, "map2" into "in".
+ */
+static isl_stat setup_maps(isl_ctx *ctx, struct bench_input *in,
+	const char *map1, const char *map2)
+{
+	in->map1 = isl_map_read_from_str(ctx, map1);
+	if (!in->map1)
+		return isl_stat_error;
+	if (!map2)
+		return isl_stat_ok;
+	in->map2 = isl_map_read_from_str(ctx, map2);
+	return in->map2 ? isl_stat_ok : isl_stat_error;
+}
+
+/* Open the file "name" in the test_inputs directory of the source tree.
+ */
+static FILE *open_input(const char *name)
+{
+	char *pattern = "%s/test_inputs/%s";
+	char *filename;
+	FILE *file;
+	size_t length;
+
+	length = strlen(pattern) - 4 + strlen(srcdir) + strlen(name) + 1;
+	filename = malloc(length);
+	if (!filename)
+		return NULL;
+	sprintf(filename, pattern, srcdir, name);
+	file = fopen(filename, "r");
+	if (!file)
+		fprintf(stderr, "unable to open %s\n", filename);
+	free(filename);
+
+	return file;
+}
+
+/* Read an isl_union_access_info from the file "name" into "in".
+ */
+static isl_stat setup_access(isl_ctx *ctx, struct bench_input *in,
+	const char *name, const char *unused)
+{
+	FILE *file;
+
+	file = open_input(name);
+	if (!file)
+		return isl_stat_error;
+	in->access = isl_union_access_info_read_from_file(ctx, file);
+	fclose(file);
+
+	return in->access ? isl_stat_ok : isl_stat_error;
+}
+
+/* Read an isl_schedule_constraints object from the file "name" into "in".
+ */
+static isl_stat setup_sc(isl_ctx *ctx, struct bench_input *in,
+	const char *name, const char *unused)
+{
+	FILE *file;
+
+	file = open_input(name);
+	if (!file)
+		return isl_stat_error;
+	in->sc = isl_schedule_constraints_read_from_file(ctx, file);
+	fclose(file);
+
+	return in->sc ? isl_stat_ok : isl_stat_error;
+}
+
+/* Read a schedule tree from the file "name" into "in".
+ */
+static isl_stat setup_schedule(isl_ctx *ctx, struct bench_input *in,
+	const char *name, const char *unused)
+{
+	FILE *file;
+
+	file = open_input(name);
+	if (!file)
+		return isl_stat_error;
+	in->schedule = isl_schedule_read_from_file(ctx, file);
+	fclose(file);
+
+	return in->schedule ? isl_stat_ok : isl_stat_error;
+}
+
+/* Read a map from the file "name" into "in".
+ * The map is read in binary format if the file starts
+ * with the magic of that format and in isl format otherwise.
+ * Unlike the other inputs, "name" is not relative to
+ * the test_inputs directory.
+ */
+static isl_stat setup_replay(isl_ctx *ctx, struct bench_input *in,
+	const char *name, const char *unused)
+{
+	FILE *file;
+	char magic[4];
+	size_t n;
+
+	file = fopen(name, "rb");
+	if (!file) {
+		fprintf(stderr, "unable to open %s\n", name);
+		return isl_stat_error;
+	}
+	n = fread(magic, 1, sizeof(magic), file);
+	rewind(file);
+	if (n == sizeof(magic) && !memcmp(magic, "ISLB", sizeof(magic)))
+		in->map1 = isl_map_read_from_binary_file(ctx, file);
+	else
+		in->map1 = isl_map_read_from_file(ctx, file);
+	fclose(file);
+
+	return in->map1 ? isl_stat_ok : isl_stat_error;
+}
+
+static isl_stat run_coalesce_union(struct bench_input *in)
+{
+	isl_union_set *res;
+
+	res = isl_union_set_coalesce(isl_union_set_copy(in->uset));
+	isl_union_set_free(res);
+	return res ? isl_stat_ok : isl_stat_error;
+}
+
+static isl_stat run_coalesce(struct bench_input *in)
+{
+	isl_map *res;
+
+	res = isl_map_coalesce(isl_map_copy(in->map1));
+	isl_map_free(res);
+	return res ? isl_stat_ok : isl_stat_error;
+}
+
+static isl_stat run_gist(struct bench_input *in)
+{
+	isl_map *res;
+
+	res = isl_map_gist(isl_map_copy(in->map1), isl_map_copy(in->map2));
+	isl_map_free(res);
+	return res ? isl_stat_ok : isl_stat_error;
+}
+
+static isl_stat run_subtract(struct bench_input *in)
+{
+	isl_map *res;
+
+	res = isl_map_subtract(isl_map_copy(in->map1),
+				isl_map_copy(in->map2));
+	isl_map_free(res);
+	return res ? isl_stat_ok : isl_stat_error;
+}
+
+static isl_stat run_lexmin(struct bench_input *in)
+{
+	isl_map *res;
+
+	res = isl_map_lexmin(isl_map_copy(in->map1));
+	isl_map_free(res);
+	return res ? isl_stat_ok : isl_stat_error;
+}
+
+static isl_stat run_card(struct bench_input *in)
+{
+	isl_val *res;
+
+	res = isl_set_count_val(in->set);
+	isl_val_free(res);
+	return res ? isl_stat_ok : isl_stat_error;
+}
+
+static isl_stat run_compute_flow(struct bench_input *in)
+{
+	isl_union_flow *res;
+
+	res = isl_union_access_info_compute_flow(
+				isl_union_access_info_copy(in->access));
+	isl_union_flow_free(res);
+	return res ? isl_stat_ok : isl_stat_error;
+}
+
+static isl_stat run_compute_schedule(struct bench_input *in)
+{
+	isl_schedule *res;
+
+	res = isl_schedule_constraints_compute_schedule(
+				isl_schedule_constraints_copy(in->sc));
+	isl_schedule_free(res);
+	return res ? isl_stat_ok : isl_stat_error;
+}
+
+static isl_stat run_ast(struct bench_input *in)
+{
+	isl_ast_build *build;
+	isl_ast_node *res;
+
+	build = isl_ast_build_alloc(isl_schedule_get_ctx(in->schedule));
+	res = isl_ast_build_node_from_schedule(build,
+					isl_schedule_copy(in->schedule));
+	isl_ast_build_free(build);
+	isl_ast_node_free(res);
+	return res ? isl_stat_ok : isl_stat_error;
+}
+
+/* The benchmarks.
+ * "operation" is the name of the operation that is timed and
+ * "input" is a description of the input.
+ * "setup" reads the input from "arg1" and "arg2" and
+ * "run" performs the operation once.
+ */
+static struct {
+	const char *operation;
+	const char *input;
+	isl_stat (*setup)(isl_ctx *ctx, struct bench_input *in,
+		const char *arg1, const char *arg2);
+	isl_stat (*run)(struct bench_input *in);
+	const char *arg1;
+	const char *arg2;
+} benchmarks[] = {
+	{ "coalesce", "tiles", &setup_maps, &run_coalesce,
+	  "{ [i, j] : 0 <= i <= 9 and 0 <= j <= 9; "
+	    "[i, j] : 10 <= i <= 19 and 0 <= j <= 9; "
+	    "[i, j] : 0 <= i <= 9 and 10 <= j <= 19; "
+	    "[i, j] : 10 <= i <= 19 and 10 <= j <= 19 }" },
+	{ "coalesce", "parametric-strided", &setup_maps, &run_coalesce,
+	  "[n, m] -> { [i, j] : 0 <= i < n and 0 <= j < m and "
+		"i mod 2 = 0; "
+	    "[i, j] : 0 <= i < n and 0 <= j < m and i mod 2 = 1; "
+	    "[i, j] : i = n and 0 <= j < m }" },
+	{ "gist", "stencil-context", &setup_maps, &run_gist,
+	  "[n] -> { [t, i] : 0 <= t < n and 1 <= i < n - 1 and "
+		"i + t >= 1 and t mod 4 = 0 }",
+	  "[n] -> { [t, i] : n >= 8 and 0 <= t and i >= 1 and "
+		"t mod 2 = 0 }" },
+	{ "gist", "disjunctive", &setup_maps, &run_gist,
+	  "{ [i] -> [j] : i >= 1 and j >= 1 or i >= 2 and j <= 10 or "
+		"i <= -5 and j = 2i }",
+	  "{ [i] -> [j] : i >= 1 or i <= -5 }" },
+	{ "subtract", "holes", &setup_maps, &run_subtract,
+	  "[n] -> { [i, j, k] : 0 <= i, j, k <= n }",
+	  "[n] -> { [i, j, k] : 1 <= i, j, k <= n - 1 and "
+		"(i + j + k) mod 3 = 0 }" },
+	{ "subtract", "triangles", &setup_maps, &run_subtract,
+	  "{ [i, j] : 0 <= j <= i <= 100 }",
+	  "{ [i, j] : 0 <= i <= j <= 100; [i, j] : i = 2j + 1 }" },
+	{ "lexmin", "parametric", &setup_maps, &run_lexmin,
+	  "[n, m] -> { [i] -> [j, k] : 0 <= j <= n and 0 <= k <= m and "
+		"3j + 5k >= i and j + k <= n + m }" },
+	{ "lexmin", "existential", &setup_maps, &run_lexmin,
+	  "[n] -> { [i, j] : exists (a, b : i = 4a + 1 and j = 6b + 5 and "
+		"i + j >= n and 0 <= i, j <= 2n) }" },
+	{ "card", "triangle", &setup_set, &run_card,
+	  "{ [i, j] : 0 <= i < 200 and 0 <= j <= i }" },
+	{ "card", "strided", &setup_set, &run_card,
+	  "{ [i, j, k] : 0 <= i < 30 and 0 <= j < 30 and "
+		"i <= k <= i + j and k mod 3 = 0 }" },
+	{ "compute_flow", "flow/multi.ai", &setup_access, &run_compute_flow,
+	  "flow/multi.ai" },
+	{ "compute_flow", "flow/mixed_loop-tree.ai", &setup_access,
+	  &run_compute_flow, "flow/mixed_loop-tree.ai" },
+	{ "compute_schedule", "schedule/poliwoda.sc", &setup_sc,
+	  &run_compute_schedule, "schedule/poliwoda.sc" },
+	{ "compute_schedule", "schedule/niewang.sc", &setup_sc,
+	  &run_compute_schedule, "schedule/niewang.sc" },
+	{ "ast", "codegen/correlation.st", &setup_schedule, &run_ast,
+	  "codegen/correlation.st" },
+	{ "ast", "codegen/cholesky.st", &setup_schedule, &run_ast,
+	  "codegen/cholesky.st" },
+	{ "ast", "codegen/gemm.st", &setup_schedule, &run_ast,
+	  "codegen/gemm.st" },
+};
+
+/* Print "S<k>" to "p".
+ */
+static __isl_give isl_printer *print_stmt(__isl_take isl_printer *p,
+	const char *name, int k)
+{
+	p = isl_printer_print_str(p, name);
+	return isl_printer_print_int(p, k);
+}
+
+/* Extract the string printed to "p" and free "p".
+ */
+static char *printer_to_str(__isl_take isl_printer *p)
+{
+	char *str;
+
+	str = isl_printer_get_str(p);
+	isl_printer_free(p);
+	return str;
+}
+
+/* Construct schedule constraints on the instances in "domain"
+ * with "deps" as validity, coincidence and proximity constraints.
+ * "deps" is first restricted to "domain".
+ * The strings are freed.
+ */
+static __isl_give isl_schedule_constraints *sc_from_str(isl_ctx *ctx,
+	char *domain, char *deps)
+{
+	isl_union_set *dom;
+	isl_union_map *dep;
+	isl_schedule_constraints *sc;
+
+	dom = domain ? isl_union_set_read_from_str(ctx, domain) : NULL;
+	dep = deps ? isl_union_map_read_from_str(ctx, deps) : NULL;
+	free(domain);
+	free(deps);
+	dep = isl_union_map_intersect_domain(dep, isl_union_set_copy(dom));
+	dep = isl_union_map_intersect_range(dep, isl_union_set_copy(dom));
+	sc = isl_schedule_constraints_on_domain(dom);
+	sc = isl_schedule_constraints_set_validity(sc, isl_union_map_copy(dep));
+	sc = isl_schedule_constraints_set_coincidence(sc,
+						isl_union_map_copy(dep));
+	sc = isl_schedule_constraints_set_proximity(sc, dep);
+
+	return sc;
+}
+
+/* Construct schedule constraints for a sequence of "n" stencil statements
+ * inside a time loop.  Each statement reads the three neighboring
+ * elements written by the previous statement and the first statement
+ * reads those written by the last statement in the previous iteration
+ * of the time loop.
+ */
+static isl_stat gen_stencil(isl_ctx *ctx, struct bench_input *in, int n)
+{
+	isl_printer *p;
+	char *domain, *deps;
+	int k;
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_print_str(p, "[T, N] -> { ");
+	for (k = 0; k < n; ++k) {
+		if (k)
+			p = isl_printer_print_str(p, "; ");
+		p = print_stmt(p, "S", k);
+		p = isl_printer_print_str(p,
+			"[t, i] : 0 <= t < T and 1 <= i < N - 1");
+	}
+	p = isl_printer_print_str(p, " }");
+	domain = printer_to_str(p);
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_print_str(p, "[T, N] -> { ");
+	for (k = 0; k < n; ++k) {
+		if (k)
+			p = isl_printer_print_str(p, "; ");
+		p = print_stmt(p, "S", k);
+		p = isl_printer_print_str(p, "[t, i] -> ");
+		p = print_stmt(p, "S", (k + 1) % n);
+		p = isl_printer_print_str(p, k == n - 1 ? "[t + 1, j]" : "[t, j]");
+		p = isl_printer_print_str(p, " : -1 <= i - j <= 1");
+	}
+	p = isl_printer_print_str(p, " }");
+	deps = printer_to_str(p);
+
+	in->sc = sc_from_str(ctx, domain, deps);
+	return in->sc ? isl_stat_ok : isl_stat_error;
+}
+
+/* Construct schedule constraints for a chain of "n" matrix multiplications
+ * C_{k+1} = C_k * A_k, each consisting of an initialization statement Z_k
+ * and an update statement S_k.
+ * Each update statement reads all elements of a row of the result
+ * of the previous multiplication.
+ */
+static isl_stat gen_matrix_chain(isl_ctx *ctx, struct bench_input *in,
+	int n)
+{
+	isl_printer *p;
+	char *domain, *deps;
+	int k;
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_print_str(p, "[N] -> { ");
+	for (k = 0; k < n; ++k) {
+		if (k)
+			p = isl_printer_print_str(p, "; ");
+		p = print_stmt(p, "Z", k);
+		p = isl_printer_print_str(p, "[i, j] : 0 <= i, j < N; ");
+		p = print_stmt(p, "S", k);
+		p = isl_printer_print_str(p, "[i, j, l] : 0 <= i, j, l < N");
+	}
+	p = isl_printer_print_str(p, " }");
+	domain = printer_to_str(p);
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_print_str(p, "[N] -> { ");
+	for (k = 0; k < n; ++k) {
+		if (k)
+			p = isl_printer_print_str(p, "; ");
+		p = print_stmt(p, "Z", k);
+		p = isl_printer_print_str(p, "[i, j] -> ");
+		p = print_stmt(p, "S", k);
+		p = isl_printer_print_str(p, "[i, j, 0]; ");
+		p = print_stmt(p, "S", k);
+		p = isl_printer_print_str(p, "[i, j, l] -> ");
+		p = print_stmt(p, "S", k);
+		p = isl_printer_print_str(p, "[i, j, l + 1]");
+		if (k == 0)
+			continue;
+		p = isl_printer_print_str(p, "; ");
+		p = print_stmt(p, "S", k - 1);
+		p = isl_printer_print_str(p, "[i, l, N - 1] -> ");
+		p = print_stmt(p, "S", k);
+		p = isl_printer_print_str(p, "[i, j, l]");
+	}
+	p = isl_printer_print_str(p, " }");
+	deps = printer_to_str(p);
+
+	in->sc = sc_from_str(ctx, domain, deps);
+	return in->sc ? isl_stat_ok : isl_stat_error;
+}
+
+/* Print the tuple "[i0, ..., i<n-1>]" with "shift" added
+ * to element "pos", if it is non-negative.
+ */
+static __isl_give isl_printer *print_iterators(__isl_take isl_printer *p,
+	int n, int pos, int shift)
+{
+	int k;
+
+	p = isl_printer_print_str(p, "[");
+	for (k = 0; k < n; ++k) {
+		if (k)
+			p = isl_printer_print_str(p, ", ");
+		p = isl_printer_print_str(p, "i");
+		p = isl_printer_print_int(p, k);
+		if (k != pos)
+			continue;
+		p = isl_printer_print_str(p, " + ");
+		p = isl_printer_print_int(p, shift);
+	}
+	return isl_printer_print_str(p, "]");
+}
+
+/* Construct schedule constraints for a single statement
+ * in a loop nest of depth "n", with a unit dependence along each loop and
+ * a dependence that moves backward along the innermost loop.
+ */
+static isl_stat gen_deep_nest(isl_ctx *ctx, struct bench_input *in, int n)
+{
+	isl_printer *p;
+	char *domain, *deps;
+	int k;
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_print_str(p, "[N] -> { S");
+	p = print_iterators(p, n, -1, 0);
+	p = isl_printer_print_str(p, " : ");
+	for (k = 0; k < n; ++k) {
+		if (k)
+			p = isl_printer_print_str(p, " and ");
+		p = isl_printer_print_str(p, "0 <= i");
+		p = isl_printer_print_int(p, k);
+		p = isl_printer_print_str(p, " < N");
+	}
+	p = isl_printer_print_str(p, " }");
+	domain = printer_to_str(p);
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_print_str(p, "[N] -> { ");
+	for (k = 0; k < n; ++k) {
+		p = isl_printer_print_str(p, "S");
+		p = print_iterators(p, n, -1, 0);
+		p = isl_printer_print_str(p, " -> S");
+		p = print_iterators(p, n, k, 1);
+		p = isl_printer_print_str(p, "; ");
+	}
+	p = isl_printer_print_str(p, "S");
+	p = print_iterators(p, n, -1, 0);
+	p = isl_printer_print_str(p, " -> S");
+	if (n > 1) {
+		p = isl_printer_print_str(p, "[");
+		for (k = 0; k < n; ++k) {
+			if (k)
+				p = isl_printer_print_str(p, ", ");
+			p = isl_printer_print_str(p, "i");
+			p = isl_printer_print_int(p, k);
+			if (k == n - 2)
+				p = isl_printer_print_str(p, " + 1");
+			if (k == n - 1)
+				p = isl_printer_print_str(p, " - 1");
+		}
+		p = isl_printer_print_str(p, "]");
+	} else {
+		p = print_iterators(p, n, 0, 2);
+	}
+	p = isl_printer_print_str(p, " }");
+	deps = printer_to_str(p);
+
+	in->sc = sc_from_str(ctx, domain, deps);
+	return in->sc ? isl_stat_ok : isl_stat_error;
+}
+
+/* Construct schedule constraints for "n" independent statements
+ * with disjoint domains, each carrying a dependence along its inner loop.
+ */
+static isl_stat gen_disjoint(isl_ctx *ctx, struct bench_input *in, int n)
+{
+	isl_printer *p;
+	char *domain, *deps;
+	int k;
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_print_str(p, "[N] -> { ");
+	for (k = 0; k < n; ++k) {
+		if (k)
+			p = isl_printer_print_str(p, "; ");
+		p = print_stmt(p, "S", k);
+		p = isl_printer_print_str(p, "[i, j] : 0 <= i < N and ");
+		p = isl_printer_print_int(p, k);
+		p = isl_printer_print_str(p, " <= j < N");
+	}
+	p = isl_printer_print_str(p, " }");
+	domain = printer_to_str(p);
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_print_str(p, "[N] -> { ");
+	for (k = 0; k < n; ++k) {
+		if (k)
+			p = isl_printer_print_str(p, "; ");
+		p = print_stmt(p, "S", k);
+		p = isl_printer_print_str(p, "[i, j] -> ");
+		p = print_stmt(p, "S", k);
+		p = isl_printer_print_str(p, "[i, j + 1]");
+	}
+	p = isl_printer_print_str(p, " }");
+	deps = printer_to_str(p);
+
+	in->sc = sc_from_str(ctx, domain, deps);
+	return in->sc ? isl_stat_ok : isl_stat_error;
+}
+
+/* Construct a set consisting of "n" adjacent blocks of increasing height
+ * that can only partly be coalesced.
+ */
+static isl_stat gen_staircase(isl_ctx *ctx, struct bench_input *in, int n)
+{
+	isl_printer *p;
+	char *str;
+	int k;
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_print_str(p, "{ ");
+	for (k = 0; k < n; ++k) {
+		if (k)
+			p = isl_printer_print_str(p, "; ");
+		p = isl_printer_print_str(p, "S[i, j] : ");
+		p = isl_printer_print_int(p, 10 * k);
+		p = isl_printer_print_str(p, " <= i <= ");
+		p = isl_printer_print_int(p, 10 * k + 9);
+		p = isl_printer_print_str(p, " and 0 <= j <= ");
+		p = isl_printer_print_int(p, k / 2);
+	}
+	p = isl_printer_print_str(p, " }");
+	str = printer_to_str(p);
+
+	in->uset = str ? isl_union_set_read_from_str(ctx, str) : NULL;
+	free(str);
+	return in->uset ? isl_stat_ok : isl_stat_error;
+}
+
+/* Tile the permutable band "node" with tile size 32 in each member.
+ */
+static __isl_give isl_schedule_node *tile_band(
+	__isl_take isl_schedule_node *node, void *user)
+{
+	isl_ctx *ctx;
+	isl_space *space;
+	isl_multi_val *sizes;
+	isl_size n;
+	isl_bool permutable;
+	int i;
+
+	if (isl_schedule_node_get_type(node) != isl_schedule_node_band)
+		return node;
+	n = isl_schedule_node_band_n_member(node);
+	permutable = isl_schedule_node_band_get_permutable(node);
+	if (n < 0 || permutable < 0)
+		return isl_schedule_node_free(node);
+	if (n < 2 || !permutable)
+		return node;
+
+	ctx = isl_schedule_node_get_ctx(node);
+	space = isl_schedule_node_band_get_space(node);
+	sizes = isl_multi_val_zero(space);
+	for (i = 0; i < n; ++i)
+		sizes = isl_multi_val_set_val(sizes, i,
+					isl_val_int_from_si(ctx, 32));
+	return isl_schedule_node_band_tile(node, sizes);
+}
+
+/* Compute a schedule for the schedule constraints constructed by "gen"
+ * and store it in "in", with all permutable bands tiled.
+ */
+static isl_stat gen_tiled_schedule(isl_ctx *ctx, struct bench_input *in,
+	int n, isl_stat (*gen)(isl_ctx *ctx, struct bench_input *in, int n))
+{
+	if (gen(ctx, in, n) < 0)
+		return isl_stat_error;
+	in->schedule = isl_schedule_constraints_compute_schedule(in->sc);
+	in->sc = NULL;
+	in->schedule = isl_schedule_map_schedule_node_bottom_up(in->schedule,
+							&tile_band, NULL);
+	return in->schedule ? isl_stat_ok : isl_stat_error;
+}
+
+static isl_stat gen_stencil_schedule(isl_ctx *ctx, struct bench_input *in,
+	int n)
+{
+	return gen_tiled_schedule(ctx, in, n, &gen_stencil);
+}
+
+static isl_stat gen_matrix_chain_schedule(isl_ctx *ctx,
+	struct bench_input *in, int n)
+{
+	return gen_tiled_schedule(ctx, in, n, &gen_matrix_chain);
+}
+
+static isl_stat gen_deep_nest_schedule(isl_ctx *ctx, struct bench_input *in,
+	int n)
+{
+	return gen_tiled_schedule(ctx, in, n, &gen_deep_nest);
+}
+
+static isl_stat gen_disjoint_schedule(isl_ctx *ctx, struct bench_input *in,
+	int n)
+{
+	return gen_tiled_schedule(ctx, in, n, &gen_disjoint);
+}
+
+/* The benchmarks on generated workloads.
+ * "operation" is the name of the operation that is timed and
+ * "workload" is the name of the generator.
+ * "gen" generates the input of size "n" and
+ * "run" performs the operation once.
+ * The operation is timed for sizes 1, 2, 4, ... up to "max_size",
+ * or the --max-size option, if it is smaller.
+ */
+static struct {
+	const char *operation;
+	const char *workload;
+	isl_stat (*gen)(isl_ctx *ctx, struct bench_input *in, int n);
+	isl_stat (*run)(struct bench_input *in);
+	int max_size;
+} scaled_benchmarks[] = {
+	{ "coalesce", "staircase", &gen_staircase, &run_coalesce_union, 64 },
+	{ "compute_schedule", "stencil", &gen_stencil,
+	  &run_compute_schedule, 16 },
+	{ "compute_schedule", "matrix-chain", &gen_matrix_chain,
+	  &run_compute_schedule, 8 },
+	{ "compute_schedule", "deep-nest", &gen_deep_nest,
+	  &run_compute_schedule, 8 },
+	{ "compute_schedule", "disjoint", &gen_disjoint,
+	  &run_compute_schedule, 64 },
+	{ "ast", "stencil", &gen_stencil_schedule, &run_ast, 16 },
+	{ "ast", "matrix-chain", &gen_matrix_chain_schedule, &run_ast, 8 },
+	{ "ast", "deep-nest", &gen_deep_nest_schedule, &run_ast, 8 },
+	{ "ast", "disjoint", &gen_disjoint_schedule, &run_ast, 64 },
+};
+
+/* Return the current wall clock time in seconds.
+ */
+static double wall_time(void)
+{
+#ifdef HAVE_GETTIMEOFDAY
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + 1e-6 * tv.tv_usec;
+#else
+	return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Return the maximal resident set size of the process so far,
+ * or -1 if it is not available.
+ */
+static long max_rss(void)
+{
+#ifdef HAVE_GETRUSAGE
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) < 0)
+		return -1;
+	return usage.ru_maxrss;
+#else
+	return -1;
+#endif
+}
+
+/* Print "s" as a JSON string, dropping any trailing newline.
+ */
+static void print_json_string(const char *s)
+{
+	putchar('"');
+	for (; *s; ++s) {
+		if (*s == '\n' && !s[1])
+			break;
+		if (*s == '"' || *s == '\\')
+			printf("\\%c", *s);
+		else if (*s == '\n')
+			printf("\\n");
+		else
+			putchar(*s);
+	}
+	putchar('"');
+}
+
+/* A baseline number of operations "operations" of "operation"
+ * on "input", of size "size" if it is non-negative.
+ */
+struct bench_baseline {
+	char *operation;
+	char *input;
+	int size;
+	unsigned long operations;
+};
+
+/* The state of the benchmark driver.
+ * "options" are the command line options.
+ * "baseline" contains the "n_baseline" baselines read from
+ * the --check file, if any.
+ * "first" is set if no benchmark has been printed yet.
+ * "failed" is set if any benchmark exceeded its budget.
+ */
+struct bench_state {
+	struct options *options;
+	int n_baseline;
+	struct bench_baseline *baseline;
+	int first;
+	int failed;
+};
+
+/* Free the baselines in "state".
+ */
+static void free_baselines(struct bench_state *state)
+{
+	int i;
+
+	for (i = 0; i < state->n_baseline; ++i) {
+		free(state->baseline[i].operation);
+		free(state->baseline[i].input);
+	}
+	free(state->baseline);
+}
+
+/* Read the baselines in "filename" into "state".
+ * Each non-empty line that does not start with a '#' consists of
+ * the name of an operation, the description of the input,
+ * the size of the input (or "-" for a fixed input) and
+ * the number of operations, separated by white space.
+ */
+static isl_stat read_baselines(struct bench_state *state,
+	const char *filename)
+{
+	FILE *file;
+	char line[1024];
+	isl_stat r = isl_stat_ok;
+
+	file = fopen(filename, "r");
+	if (!file) {
+		fprintf(stderr, "unable to open %s\n", filename);
+		return isl_stat_error;
+	}
+	while (r >= 0 && fgets(line, sizeof(line), file)) {
+		char operation[256], input[256], size[32];
+		unsigned long operations;
+		struct bench_baseline *baseline;
+
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+		if (sscanf(line, "%255s %255s %31s %lu",
+			    operation, input, size, &operations) != 4) {
+			fprintf(stderr, "invalid line in %s: %s",
+				filename, line);
+			r = isl_stat_error;
+			break;
+		}
+		baseline = realloc(state->baseline,
+			    (state->n_baseline + 1) * sizeof(*baseline));
+		if (!baseline) {
+			r = isl_stat_error;
+			break;
+		}
+		state->baseline = baseline;
+		baseline = &state->baseline[state->n_baseline];
+		baseline->operation = strdup(operation);
+		baseline->input = strdup(input);
+		baseline->size = strcmp(size, "-") ? atoi(size) : -1;
+		baseline->operations = operations;
+		state->n_baseline++;
+		if (!baseline->operation || !baseline->input)
+			r = isl_stat_error;
+	}
+	fclose(file);
+
+	return r;
+}
+
+/* Return the baseline of "operation" on "input" of size "size"
+ * in "state", or NULL if there is no such baseline.
+ */
+static struct bench_baseline *find_baseline(struct bench_state *state,
+	const char *operation, const char *input, int size)
+{
+	int i;
+
+	for (i = 0; i < state->n_baseline; ++i) {
+		struct bench_baseline *baseline = &state->baseline[i];
+
+		if (baseline->size == size &&
+		    !strcmp(baseline->operation, operation) &&
+		    !strcmp(baseline->input, input))
+			return baseline;
+	}
+
+	return NULL;
+}
+
+/* The number of operations by which a benchmark may exceed
+ * its baseline, on top of the relative tolerance.
+ * This avoids spurious failures on benchmarks that perform
+ * very few operations.
+ */
+#define BUDGET_SLACK	1000
+
+/* The factor by which the number of operations needs to exceed
+ * the budget of a benchmark for the computation to be aborted.
+ */
+#define ABORT_FACTOR	10
+
+/* Perform the operation "run" on the input "in" once and
+ * check that the number of operations does not exceed
+ * the budget derived from the baseline in "state".
+ * A multiple of the budget is imposed as the maximal number
+ * of operations such that an operation that is much slower
+ * than expected, e.g., because it has become asymptotically worse,
+ * is aborted instead of taking a very long time to complete.
+ * The result of the check is printed.
+ * "operation", "input" and "size" describe the operation and the input.
+ * "in" is cleared.
+ */
+static isl_stat check(isl_ctx *ctx, struct bench_state *state,
+	const char *operation, const char *input, int size,
+	isl_stat (*run)(struct bench_input *in), struct bench_input *in)
+{
+	struct bench_baseline *baseline;
+	unsigned long budget, operations;
+	isl_stat r;
+	int exceeded;
+
+	baseline = find_baseline(state, operation, input, size);
+	if (!baseline) {
+		bench_input_clear(in);
+		fprintf(stderr, "no baseline for %s on %s", operation, input);
+		if (size >= 0)
+			fprintf(stderr, " of size %d", size);
+		fprintf(stderr, "\n");
+		return isl_stat_error;
+	}
+	budget = baseline->operations;
+	budget += budget * state->options->tolerance / 100 + BUDGET_SLACK;
+
+	isl_ctx_reset_operations(ctx);
+	isl_ctx_set_max_operations(ctx, ABORT_FACTOR * budget);
+	r = run(in);
+	operations = isl_ctx_get_operations(ctx);
+	isl_ctx_set_max_operations(ctx, 0);
+	exceeded = operations > budget ||
+		    (r < 0 && isl_ctx_last_error(ctx) == isl_error_quota);
+	isl_ctx_reset_error(ctx);
+	bench_input_clear(in);
+	if (r < 0 && !exceeded) {
+		fprintf(stderr, "%s on %s failed\n", operation, input);
+		return isl_stat_error;
+	}
+
+	printf("%s: %s on %s", exceeded ? "FAIL" : "PASS", operation, input);
+	if (size >= 0)
+		printf(" of size %d", size);
+	if (r < 0)
+		printf(": aborted after");
+	else
+		printf(":");
+	printf(" %lu operations (baseline %lu, budget %lu)\n",
+		operations, baseline->operations, budget);
+	if (exceeded)
+		state->failed = 1;
+
+	return isl_stat_ok;
+}
+
+/* Perform the operation "run" on the input "in" once and
+ * print the number of operations in the format of a baseline file.
+ * "operation", "input" and "size" describe the operation and the input.
+ * "in" is cleared.
+ */
+static isl_stat print_baseline(isl_ctx *ctx, const char *operation,
+	const char *input, int size, isl_stat (*run)(struct bench_input *in),
+	struct bench_input *in)
+{
+	isl_stat r;
+
+	isl_ctx_reset_operations(ctx);
+	r = run(in);
+	bench_input_clear(in);
+	if (r < 0) {
+		fprintf(stderr, "%s on %s failed\n", operation, input);
+		return isl_stat_error;
+	}
+
+	printf("%s %s ", operation, input);
+	if (size >= 0)
+		printf("%d", size);
+	else
+		printf("-");
+	printf(" %lu\n", isl_ctx_get_operations(ctx));
+
+	return isl_stat_ok;
+}
+
+/* Time the operation "run" on the input "in" by performing it
+ * "repeat" times and print the result as a JSON object,
+ * preceded by a comma if "first" is not set.
+ * "operation" and "input" describe the operation and the input.
+ * If "size" is non-negative, then the input was generated
+ * with this size.
+ * "in" is cleared.
+ */
+static isl_stat bench(isl_ctx *ctx, const char *operation,
+	const char *input, int size, isl_stat (*run)(struct bench_input *in),
+	struct bench_input *in, int repeat, int first)
+{
+	double min = 0, total = 0;
+	unsigned long operations;
+	struct isl_memory_stats memory;
+	isl_stat r = isl_stat_ok;
+	int j;
+
+	isl_ctx_reset_operations(ctx);
+	isl_ctx_reset_memory(ctx);
+	for (j = 0; r >= 0 && j < repeat; ++j) {
+		double start, time;
+
+		start = wall_time();
+		r = run(in);
+		time = wall_time() - start;
+		if (j == 0 || time < min)
+			min = time;
+		total += time;
+	}
+	operations = isl_ctx_get_operations(ctx);
+	if (isl_ctx_get_memory_stats(ctx, &memory) < 0)
+		r = isl_stat_error;
+	bench_input_clear(in);
+	if (r < 0) {
+		fprintf(stderr, "%s on %s failed\n", operation, input);
+		return isl_stat_error;
+	}
+
+	printf("%s\n    { \"operation\": \"%s\", \"input\": \"%s\", ",
+		first ? "" : ",", operation, input);
+	if (size >= 0)
+		printf("\"size\": %d, ", size);
+	printf("\"runs\": %d,\n", repeat);
+	printf("      \"time_min\": %g, \"time_mean\": %g, "
+		"\"operations\": %lu,\n", min, total / repeat,
+		operations / repeat);
+	printf("      \"allocations\": %lu, \"bytes_allocated\": %lu, "
+		"\"max_rss\": %ld }",
+		(memory.n_alloc + memory.n_realloc) / repeat,
+		(unsigned long) (memory.bytes / repeat), max_rss());
+
+	return isl_stat_ok;
+}
+
+/* Process the operation "run" on the input "in"
+ * according to the options in "state", i.e.,
+ * check it against its baseline, print its baseline or time it.
+ * "operation", "input" and "size" describe the operation and the input.
+ * "in" is cleared.
+ */
+static isl_stat process(isl_ctx *ctx, struct bench_state *state,
+	const char *operation, const char *input, int size,
+	isl_stat (*run)(struct bench_input *in), struct bench_input *in)
+{
+	struct options *options = state->options;
+	isl_stat r;
+
+	if (options->check)
+		return check(ctx, state, operation, input, size, run, in);
+	if (options->baseline)
+		return print_baseline(ctx, operation, input, size, run, in);
+	r = bench(ctx, operation, input, size, run, in, options->repeat,
+		    state->first);
+	state->first = 0;
+	return r;
+}
+
+/* Process benchmark "i" on its fixed input.
+ */
+static isl_stat bench_fixed(isl_ctx *ctx, struct bench_state *state, int i)
+{
+	struct bench_input in = { NULL };
+
+	if (benchmarks[i].setup(ctx, &in, benchmarks[i].arg1,
+				benchmarks[i].arg2) < 0) {
+		bench_input_clear(&in);
+		fprintf(stderr, "unable to set up %s on %s\n",
+			benchmarks[i].operation, benchmarks[i].input);
+		return isl_stat_error;
+	}
+	return process(ctx, state, benchmarks[i].operation,
+			benchmarks[i].input, -1, benchmarks[i].run, &in);
+}
+
+/* Process benchmark "i" on generated inputs of size 1, 2, 4, ...
+ * up to the maximal size of the benchmark and the --max-size option.
+ */
+static isl_stat bench_scaled(isl_ctx *ctx, struct bench_state *state, int i)
+{
+	int n;
+	int max_size = state->options->max_size;
+
+	for (n = 1; n <= scaled_benchmarks[i].max_size && n <= max_size;
+	     n *= 2) {
+		struct bench_input in = { NULL };
+
+		if (scaled_benchmarks[i].gen(ctx, &in, n) < 0) {
+			bench_input_clear(&in);
+			fprintf(stderr, "unable to generate %s of size %d\n",
+				scaled_benchmarks[i].workload, n);
+			return isl_stat_error;
+		}
+		if (process(ctx, state, scaled_benchmarks[i].operation,
+			    scaled_benchmarks[i].workload, n,
+			    scaled_benchmarks[i].run, &in) < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Process coalescing of the map in the --replay file.
+ */
+static isl_stat bench_replay(isl_ctx *ctx, struct bench_state *state)
+{
+	struct bench_input in = { NULL };
+	const char *name = state->options->replay;
+
+	if (setup_replay(ctx, &in, name, NULL) < 0) {
+		bench_input_clear(&in);
+		fprintf(stderr, "unable to set up coalesce on %s\n", name);
+		return isl_stat_error;
+	}
+	return process(ctx, state, "coalesce", name, -1, &run_coalesce, &in);
+}
+
+/* Should the benchmarks for "operation" be run?
+ */
+static int selected(struct options *options, const char *operation)
+{
+	return !options->only || !strcmp(options->only, operation);
+}
+
+int main(int argc, char **argv)
+{
+	isl_ctx *ctx;
+	struct options *options;
+	struct bench_state state = { NULL };
+	int i;
+	int json;
+	isl_stat r = isl_stat_ok;
+
+	options = bench_options_new_with_defaults();
+	argc = bench_options_parse(options, argc, argv, ISL_ARG_ALL);
+	ctx = isl_ctx_alloc_with_options(&options_args, options);
+	if (!ctx)
+		return EXIT_FAILURE;
+	if (options->repeat < 1)
+		options->repeat = 1;
+	state.options = options;
+	state.first = 1;
+	json = !options->check && !options->baseline;
+	if (options->check) {
+		isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+		r = read_baselines(&state, options->check);
+	}
+
+	if (json) {
+		printf("{ \"version\": ");
+		print_json_string(isl_version());
+		printf(",\n  \"benchmarks\": [");
+	}
+	if (r >= 0 && options->replay)
+		r = bench_replay(ctx, &state);
+	for (i = 0; r >= 0 && !options->replay &&
+		    i < ARRAY_SIZE(benchmarks); ++i) {
+		if (!selected(options, benchmarks[i].operation))
+			continue;
+		r = bench_fixed(ctx, &state, i);
+	}
+	for (i = 0; r >= 0 && !options->replay &&
+		    i < ARRAY_SIZE(scaled_benchmarks); ++i) {
+		if (!selected(options, scaled_benchmarks[i].operation))
+			continue;
+		r = bench_scaled(ctx, &state, i);
+	}
+	if (json)
+		printf("\n  ]\n}\n");
+
+	free_baselines(&state);
+	isl_ctx_free(ctx);
+
+	if (r < 0 || state.failed)
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <stdlib.h>
 #include <isl/stream.h>
 #include <isl_map_private.h>
 #include <isl/polynomial.h>
@@ -6,11 +7,15 @@
 #include <isl/val.h>
 #include <isl/options.h>
 
+#include "batch.h"
+
 struct bound_options {
 	struct isl_options	*isl;
 	unsigned		 verify;
 	int			 print_all;
 	int			 continue_on_error;
+	int			 threads;
+	int			 time;
 };
 
 ISL_ARGS_START(struct bound_options, bound_options_args)
@@ -19,6 +24,10 @@ ISL_ARG_CHILD(struct bound_options, isl, "isl", &isl_options_args,
 ISL_ARG_BOOL(struct bound_options, verify, 'T', "verify", 0, NULL)
 ISL_ARG_BOOL(struct bound_options, print_all, 'A', "print-all", 0, NULL)
 ISL_ARG_BOOL(struct bound_options, continue_on_error, '\0', "continue-on-error", 0, NULL)
+ISL_ARG_INT(struct bound_options, threads, 0, "threads", "n", 1,
+	"number of threads over which to distribute the input files")
+ISL_ARG_BOOL(struct bound_options, time, 0, "time", 0,
+	"print the time taken by each input file on stderr")
 ISL_ARGS_END
 
 ISL_ARG_DEF(bound_options, struct bound_options, bound_options_args)
@@ -50,6 +59,7 @@ static __isl_give isl_set *set_bounds(__isl_take isl_set *set)
 
 struct verify_point_bound {
 	struct bound_options *options;
+	FILE *out;
 	int stride;
 	int n;
 	int exact;
@@ -75,7 +85,7 @@ static isl_stat verify_point(__isl_take isl_point *pnt, void *user)
 	isl_bool bounded;
 	int sign;
 	int ok;
-	FILE *out = vpb->options->print_all ? stdout : stderr;
+	FILE *out = vpb->options->print_all ? vpb->out : stderr;
 
 	vpb->n--;
 
@@ -178,7 +188,7 @@ error:
 
 static int check_solution(__isl_take isl_pw_qpolynomial_fold *pwf,
 	__isl_take isl_pw_qpolynomial_fold *bound, int exact,
-	struct bound_options *options)
+	struct bound_options *options, FILE *out)
 {
 	struct verify_point_bound vpb;
 	isl_int count, max;
@@ -203,6 +213,7 @@ static int check_solution(__isl_take isl_pw_qpolynomial_fold *pwf,
 	isl_int_clear(count);
 
 	vpb.options = options;
+	vpb.out = out;
 	vpb.pwf = pwf;
 	vpb.bound = bound;
 	vpb.n = n;
@@ -212,9 +223,9 @@ static int check_solution(__isl_take isl_pw_qpolynomial_fold *pwf,
 
 	if (!options->print_all) {
 		for (i = 0; i < vpb.n; i += vpb.stride)
-			printf(".");
-		printf("\r");
-		fflush(stdout);
+			fprintf(out, ".");
+		fprintf(out, "\r");
+		fflush(out);
 	}
 
 	isl_set_foreach_point(context, verify_point, &vpb);
@@ -225,7 +236,7 @@ static int check_solution(__isl_take isl_pw_qpolynomial_fold *pwf,
 	isl_pw_qpolynomial_fold_free(bound);
 
 	if (!options->print_all)
-		printf("\n");
+		fprintf(out, "\n");
 
 	if (vpb.error) {
 		fprintf(stderr, "Check failed !\n");
@@ -235,24 +246,24 @@ static int check_solution(__isl_take isl_pw_qpolynomial_fold *pwf,
 	return 0;
 }
 
-int main(int argc, char **argv)
+/* Read a single piecewise quasipolynomial (fold) from "in",
+ * compute a bound and print it on "out" or, if options->verify is set,
+ * check the bound and print the progress of the check on "out".
+ * Return 0 on success and -1 on error.
+ * Any error is reset such that further inputs can be processed
+ * using the same isl_ctx.
+ */
+static int bound(isl_ctx *ctx, FILE *in, FILE *out, void *user)
 {
-	isl_ctx *ctx;
+	struct bound_options *options = user;
 	isl_pw_qpolynomial_fold *copy;
 	isl_pw_qpolynomial_fold *pwf;
 	isl_stream *s;
 	struct isl_obj obj;
-	struct bound_options *options;
 	isl_bool exact;
 	int r = 0;
 
-	options = bound_options_new_with_defaults();
-	assert(options);
-	argc = bound_options_parse(options, argc, argv, ISL_ARG_ALL);
-
-	ctx = isl_ctx_alloc_with_options(&bound_options_args, options);
-
-	s = isl_stream_new_file(ctx, stdin);
+	s = isl_stream_new_file(ctx, in);
 	obj = isl_stream_read_obj(s);
 	if (obj.type == isl_obj_pw_qpolynomial)
 		pwf = isl_pw_qpolynomial_fold_from_pw_qpolynomial(isl_fold_max,
@@ -271,19 +282,48 @@ int main(int argc, char **argv)
 	pwf = isl_pw_qpolynomial_fold_coalesce(pwf);
 
 	if (options->verify) {
-		r = check_solution(copy, pwf, exact, options);
+		r = check_solution(copy, pwf, exact, options, out);
 	} else {
 		if (!exact)
-			printf("# NOT exact\n");
-		isl_pw_qpolynomial_fold_print(pwf, stdout, 0);
-		fprintf(stdout, "\n");
+			fprintf(out, "# NOT exact\n");
+		isl_pw_qpolynomial_fold_print(pwf, out, 0);
+		fprintf(out, "\n");
 		isl_pw_qpolynomial_fold_free(pwf);
 	}
 
+	if (0) {
 error:
+		r = -1;
+	}
 	isl_stream_free(s);
 
-	isl_ctx_free(ctx);
+	if (r < 0)
+		isl_ctx_reset_error(ctx);
 
 	return r;
 }
+
+int main(int argc, char **argv)
+{
+	isl_ctx *ctx;
+	struct bound_options *options;
+	int r;
+
+	options = bound_options_new_with_defaults();
+	assert(options);
+	argc = bound_options_parse(options, argc, argv, 0);
+
+	ctx = isl_ctx_alloc_with_options(&bound_options_args, options);
+
+	if (batch_check_args(argc, argv) < 0) {
+		isl_ctx_free(ctx);
+		return EXIT_FAILURE;
+	}
+
+	r = batch_process(ctx, argc - 1, argv + 1, options->threads,
+			options->time, &bound, options);
+
+	isl_ctx_free(ctx);
+
+	return r < 0 ? EXIT_FAILURE : 0;
+}
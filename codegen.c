@@ -16,10 +16,18 @@
  * - a schedule map
  * - a context
  * - a relation describing AST generation options
+ *
+ * The input is read from stdin, unless one or more file names
+ * are specified on the command line.  In the latter case,
+ * each of the files is processed in turn, reusing the same isl_ctx,
+ * and if there is more than one file, then each AST is preceded
+ * by a header line containing the name of the file.
  */
 
 #include <assert.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <isl/ast.h>
 #include <isl/ast_build.h>
 #include <isl/options.h>
@@ -194,33 +202,28 @@ static __isl_give isl_ast_node *construct_ast_from_schedule(
 	return tree;
 }
 
-/* Read an object from stdin.
+/* Read an object from "file".
  * If it is a (union) map, then assume an input specified by
  * schedule map, context and options and construct an AST from
  * those elements
  * If it is a schedule object, then construct the AST from the schedule.
+ * Print the AST on stdout.
+ * Return 0 on success and -1 on error.
+ * Any error is reset such that further inputs can be processed
+ * using the same isl_ctx.
  */
-int main(int argc, char **argv)
+static int codegen(isl_ctx *ctx, FILE *file)
 {
-	isl_ctx *ctx;
 	isl_stream *s;
 	isl_ast_node *tree = NULL;
-	struct options *options;
 	isl_printer *p;
 	struct isl_obj obj;
-	int r = EXIT_SUCCESS;
-
-	options = cg_options_new_with_defaults();
-	assert(options);
-	ctx = isl_ctx_alloc_with_options(&options_args, options);
-	isl_options_set_ast_build_detect_min_max(ctx, 1);
-	isl_options_set_ast_print_outermost_block(ctx, 0);
-	argc = cg_options_parse(options, argc, argv, ISL_ARG_ALL);
+	int r = 0;
 
-	s = isl_stream_new_file(ctx, stdin);
+	s = isl_stream_new_file(ctx, file);
 	obj = isl_stream_read_obj(s);
 	if (obj.v == NULL) {
-		r = EXIT_FAILURE;
+		r = -1;
 	} else if (obj.type == isl_obj_map) {
 		isl_union_map *umap;
 
@@ -233,7 +236,7 @@ int main(int argc, char **argv)
 	} else {
 		obj.type->free(obj.v);
 		isl_die(ctx, isl_error_invalid, "unknown input",
-			r = EXIT_FAILURE);
+			r = -1);
 	}
 	isl_stream_free(s);
 
@@ -244,6 +247,70 @@ int main(int argc, char **argv)
 
 	isl_ast_node_free(tree);
 
+	if (r < 0)
+		isl_ctx_reset_error(ctx);
+	return r;
+}
+
+/* Process the file called "name" using "fn", printing a header line
+ * before the result if "header" is set.
+ * A file name of "-" refers to stdin.
+ * Return 0 on success and -1 on error.
+ */
+static int process_file(isl_ctx *ctx, const char *name, int header,
+	int (*fn)(isl_ctx *ctx, FILE *file))
+{
+	FILE *file;
+	int r;
+
+	if (header)
+		printf("==> %s <==\n", name);
+	if (strcmp(name, "-") == 0)
+		return fn(ctx, stdin);
+	file = fopen(name, "r");
+	if (!file) {
+		fprintf(stderr, "unable to open %s\n", name);
+		return -1;
+	}
+	r = fn(ctx, file);
+	fclose(file);
+
+	return r;
+}
+
+/* Generate code for the input read from stdin or,
+ * if any file names are specified on the command line,
+ * for the input read from each of those files.
+ */
+int main(int argc, char **argv)
+{
+	isl_ctx *ctx;
+	struct options *options;
+	int i;
+	int r = EXIT_SUCCESS;
+
+	options = cg_options_new_with_defaults();
+	assert(options);
+	ctx = isl_ctx_alloc_with_options(&options_args, options);
+	isl_options_set_ast_build_detect_min_max(ctx, 1);
+	isl_options_set_ast_print_outermost_block(ctx, 0);
+	argc = cg_options_parse(options, argc, argv, 0);
+
+	for (i = 1; i < argc; ++i) {
+		if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0)
+			continue;
+		fprintf(stderr, "%s: unrecognized option: %s\n",
+			argv[0], argv[i]);
+		isl_ctx_free(ctx);
+		return EXIT_FAILURE;
+	}
+
+	if (argc <= 1 && codegen(ctx, stdin) < 0)
+		r = EXIT_FAILURE;
+	for (i = 1; i < argc; ++i)
+		if (process_file(ctx, argv[i], argc > 2, &codegen) < 0)
+			r = EXIT_FAILURE;
+
 	isl_ctx_free(ctx);
 	return r;
 }
@@ -8,27 +8,36 @@
 
 /* This program takes an isl_union_access_info object as input and
  * prints the corresponding dependences.
+ *
+ * The input is read from stdin, unless one or more file names
+ * are specified on the command line.  In the latter case,
+ * each of the files is processed in turn, reusing the same isl_ctx,
+ * and if there is more than one file, then each result is preceded
+ * by a header line containing the name of the file.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <isl/options.h>
 #include <isl/printer.h>
 #include <isl/union_map.h>
 #include <isl/flow.h>
 #include <isl/schedule.h>
 
-int main(int argc, char **argv)
+/* Read an isl_union_access_info object from "file",
+ * compute the corresponding dependences and print them on stdout.
+ * Return 0 on success and -1 on error.
+ * Any error is reset such that further inputs can be processed
+ * using the same isl_ctx.
+ */
+static int compute_flow(isl_ctx *ctx, FILE *file)
 {
-	isl_ctx *ctx;
 	isl_printer *p;
 	isl_union_access_info *access;
 	isl_union_flow *flow;
-	struct isl_options *options;
 
-	options = isl_options_new_with_defaults();
-	argc = isl_options_parse(options, argc, argv, ISL_ARG_ALL);
-	ctx = isl_ctx_alloc_with_options(&isl_options_args, options);
-
-	access = isl_union_access_info_read_from_file(ctx, stdin);
+	access = isl_union_access_info_read_from_file(ctx, file);
 	flow = isl_union_access_info_compute_flow(access);
 
 	p = isl_printer_to_file(ctx, stdout);
@@ -38,7 +47,65 @@ int main(int argc, char **argv)
 
 	isl_union_flow_free(flow);
 
+	if (p)
+		return 0;
+	isl_ctx_reset_error(ctx);
+	return -1;
+}
+
+/* Process the file called "name" using "fn", printing a header line
+ * before the result if "header" is set.
+ * A file name of "-" refers to stdin.
+ * Return 0 on success and -1 on error.
+ */
+static int process_file(isl_ctx *ctx, const char *name, int header,
+	int (*fn)(isl_ctx *ctx, FILE *file))
+{
+	FILE *file;
+	int r;
+
+	if (header)
+		printf("==> %s <==\n", name);
+	if (strcmp(name, "-") == 0)
+		return fn(ctx, stdin);
+	file = fopen(name, "r");
+	if (!file) {
+		fprintf(stderr, "unable to open %s\n", name);
+		return -1;
+	}
+	r = fn(ctx, file);
+	fclose(file);
+
+	return r;
+}
+
+int main(int argc, char **argv)
+{
+	isl_ctx *ctx;
+	struct isl_options *options;
+	int i;
+	int r = EXIT_SUCCESS;
+
+	options = isl_options_new_with_defaults();
+	argc = isl_options_parse(options, argc, argv, 0);
+	ctx = isl_ctx_alloc_with_options(&isl_options_args, options);
+
+	for (i = 1; i < argc; ++i) {
+		if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0)
+			continue;
+		fprintf(stderr, "%s: unrecognized option: %s\n",
+			argv[0], argv[i]);
+		isl_ctx_free(ctx);
+		return EXIT_FAILURE;
+	}
+
+	if (argc <= 1)
+		compute_flow(ctx, stdin);
+	for (i = 1; i < argc; ++i)
+		if (process_file(ctx, argv[i], argc > 2, &compute_flow) < 0)
+			r = EXIT_FAILURE;
+
 	isl_ctx_free(ctx);
 
-	return 0;
+	return r;
 }
@@ -37,6 +37,8 @@ __isl_give isl_aff *isl_space_param_aff_on_domain_id(
 	__isl_take isl_space *space, __isl_take isl_id *id);
 
 __isl_give isl_aff *isl_aff_copy(__isl_keep isl_aff *aff);
+__isl_give isl_aff *isl_aff_copy_to_ctx(__isl_keep isl_aff *aff,
+	isl_ctx *ctx);
 __isl_null isl_aff *isl_aff_free(__isl_take isl_aff *aff);
 
 isl_ctx *isl_aff_get_ctx(__isl_keep isl_aff *aff);
@@ -272,6 +274,8 @@ __isl_give isl_pw_aff *isl_pw_aff_union_add(__isl_take isl_pw_aff *pwaff1,
 	__isl_take isl_pw_aff *pwaff2);
 
 __isl_give isl_pw_aff *isl_pw_aff_copy(__isl_keep isl_pw_aff *pwaff);
+__isl_give isl_pw_aff *isl_pw_aff_copy_to_ctx(__isl_keep isl_pw_aff *pa,
+	isl_ctx *ctx);
 __isl_null isl_pw_aff *isl_pw_aff_free(__isl_take isl_pw_aff *pwaff);
 
 isl_size isl_pw_aff_dim(__isl_keep isl_pw_aff *pwaff, enum isl_dim_type type);
@@ -503,6 +507,8 @@ ISL_DECLARE_MULTI_WITH_DOMAIN(aff)
 ISL_DECLARE_MULTI_BIND_DOMAIN(aff)
 ISL_DECLARE_MULTI_UNBIND_PARAMS(aff)
 
+__isl_give isl_multi_aff *isl_multi_aff_copy_to_ctx(
+	__isl_keep isl_multi_aff *ma, isl_ctx *ctx);
 __isl_constructor
 __isl_give isl_multi_aff *isl_multi_aff_from_aff(__isl_take isl_aff *aff);
 __isl_export
@@ -590,6 +596,9 @@ ISL_DECLARE_MULTI_BIND_DOMAIN(pw_aff)
 ISL_DECLARE_MULTI_PARAM(pw_aff)
 ISL_DECLARE_MULTI_UNBIND_PARAMS(pw_aff)
 
+__isl_give isl_multi_pw_aff *isl_multi_pw_aff_copy_to_ctx(
+	__isl_keep isl_multi_pw_aff *mpa, isl_ctx *ctx);
+
 __isl_export
 __isl_give isl_pw_multi_aff *isl_pw_multi_aff_zero(__isl_take isl_space *space);
 __isl_overload
@@ -628,6 +637,8 @@ __isl_give isl_pw_multi_aff *isl_pw_multi_aff_alloc(__isl_take isl_set *set,
 	__isl_take isl_multi_aff *maff);
 __isl_give isl_pw_multi_aff *isl_pw_multi_aff_copy(
 	__isl_keep isl_pw_multi_aff *pma);
+__isl_give isl_pw_multi_aff *isl_pw_multi_aff_copy_to_ctx(
+	__isl_keep isl_pw_multi_aff *pma, isl_ctx *ctx);
 __isl_null isl_pw_multi_aff *isl_pw_multi_aff_free(
 	__isl_take isl_pw_multi_aff *pma);
 
@@ -867,6 +878,19 @@ __isl_give isl_pw_multi_aff *isl_pw_multi_aff_read_from_str(isl_ctx *ctx,
 	const char *str);
 void isl_pw_multi_aff_dump(__isl_keep isl_pw_multi_aff *pma);
 
+__isl_give isl_pw_multi_aff_evaluator *
+isl_pw_multi_aff_evaluator_from_pw_multi_aff(
+	__isl_take isl_pw_multi_aff *pma);
+__isl_null isl_pw_multi_aff_evaluator *isl_pw_multi_aff_evaluator_free(
+	__isl_take isl_pw_multi_aff_evaluator *ev);
+isl_ctx *isl_pw_multi_aff_evaluator_get_ctx(
+	__isl_keep isl_pw_multi_aff_evaluator *ev);
+isl_stat isl_pw_multi_aff_evaluator_eval(
+	__isl_keep isl_pw_multi_aff_evaluator *ev, const long *coords, int n,
+	long *res, int *defined);
+isl_bool isl_pw_multi_aff_evaluator_domain_contains(
+	__isl_keep isl_pw_multi_aff_evaluator *ev, const long *coords);
+
 
 __isl_overload
 __isl_give isl_union_pw_multi_aff *isl_union_pw_multi_aff_empty_ctx(
@@ -894,6 +918,8 @@ __isl_give isl_union_pw_aff *isl_union_pw_aff_param_on_domain_id(
 	__isl_take isl_union_set *domain, __isl_take isl_id *id);
 __isl_give isl_union_pw_multi_aff *isl_union_pw_multi_aff_copy(
 	__isl_keep isl_union_pw_multi_aff *upma);
+__isl_give isl_union_pw_multi_aff *isl_union_pw_multi_aff_copy_to_ctx(
+	__isl_keep isl_union_pw_multi_aff *upma, isl_ctx *ctx);
 __isl_null isl_union_pw_multi_aff *isl_union_pw_multi_aff_free(
 	__isl_take isl_union_pw_multi_aff *upma);
 
@@ -1198,6 +1224,8 @@ void isl_multi_pw_aff_dump(__isl_keep isl_multi_pw_aff *mpa);
 
 __isl_give isl_union_pw_aff *isl_union_pw_aff_copy(
 	__isl_keep isl_union_pw_aff *upa);
+__isl_give isl_union_pw_aff *isl_union_pw_aff_copy_to_ctx(
+	__isl_keep isl_union_pw_aff *upa, isl_ctx *ctx);
 __isl_null isl_union_pw_aff *isl_union_pw_aff_free(
 	__isl_take isl_union_pw_aff *upa);
 
@@ -1362,6 +1390,9 @@ ISL_DECLARE_MULTI_DROP_DIMS(union_pw_aff)
 ISL_DECLARE_MULTI_DIM_ID(union_pw_aff)
 ISL_DECLARE_MULTI_TUPLE_ID(union_pw_aff)
 
+__isl_give isl_multi_union_pw_aff *isl_multi_union_pw_aff_copy_to_ctx(
+	__isl_keep isl_multi_union_pw_aff *mupa, isl_ctx *ctx);
+
 __isl_export
 __isl_give isl_multi_union_pw_aff *isl_multi_aff_to_multi_union_pw_aff(
         __isl_take isl_multi_aff *ma);
@@ -34,6 +34,9 @@ typedef struct isl_pw_multi_aff isl_pw_multi_aff;
 
 ISL_DECLARE_EXPORTED_LIST_TYPE(pw_multi_aff)
 
+struct isl_pw_multi_aff_evaluator;
+typedef struct isl_pw_multi_aff_evaluator isl_pw_multi_aff_evaluator;
+
 struct __isl_export isl_union_pw_multi_aff;
 typedef struct isl_union_pw_multi_aff isl_union_pw_multi_aff;
 
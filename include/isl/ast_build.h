@@ -43,6 +43,15 @@ int isl_options_get_ast_build_allow_else(isl_ctx *ctx);
 isl_stat isl_options_set_ast_build_allow_or(isl_ctx *ctx, int val);
 int isl_options_get_ast_build_allow_or(isl_ctx *ctx);
 
+#define ISL_AST_BUILD_QUALITY_FULL		0
+#define ISL_AST_BUILD_QUALITY_LIMITED		1
+#define ISL_AST_BUILD_QUALITY_ATOMIC		2
+isl_stat isl_options_set_ast_build_quality(isl_ctx *ctx, int val);
+int isl_options_get_ast_build_quality(isl_ctx *ctx);
+
+isl_stat isl_options_set_ast_build_component_budget(isl_ctx *ctx, int val);
+int isl_options_get_ast_build_component_budget(isl_ctx *ctx);
+
 isl_ctx *isl_ast_build_get_ctx(__isl_keep isl_ast_build *build);
 
 __isl_constructor
@@ -91,10 +100,16 @@ __isl_give isl_ast_build *isl_ast_build_set_after_each_mark(
 	__isl_take isl_ast_build *build,
 	__isl_give isl_ast_node *(*fn)(__isl_take isl_ast_node *node,
 		__isl_keep isl_ast_build *build, void *user), void *user);
+__isl_give isl_ast_build *isl_ast_build_set_after_each_if(
+	__isl_take isl_ast_build *build,
+	__isl_give isl_ast_node *(*fn)(__isl_take isl_ast_node *node,
+		__isl_keep isl_ast_build *build, void *user), void *user);
 __isl_give isl_ast_build *isl_ast_build_set_create_leaf(
 	__isl_take isl_ast_build *build,
 	__isl_give isl_ast_node *(*fn)(__isl_take isl_ast_build *build,
 		void *user), void *user);
+__isl_give isl_ast_build *isl_ast_build_set_reuse_subtrees(
+	__isl_take isl_ast_build *build, int reuse);
 
 __isl_overload
 __isl_give isl_ast_expr *isl_ast_build_expr_from_set(
@@ -118,6 +133,8 @@ __isl_give isl_ast_expr *isl_ast_build_call_from_multi_pw_aff(
 __isl_overload
 __isl_give isl_ast_node *isl_ast_build_node_from_schedule(
 	__isl_keep isl_ast_build *build, __isl_take isl_schedule *schedule);
+__isl_give isl_ast_node *isl_ast_build_node_from_schedule_subtree(
+	__isl_keep isl_ast_build *build, __isl_take isl_schedule_node *node);
 __isl_export
 __isl_give isl_ast_node *isl_ast_build_node_from_schedule_map(
 	__isl_keep isl_ast_build *build, __isl_take isl_union_map *schedule);
@@ -45,6 +45,10 @@ isl_stat isl_basic_map_foreach_constraint(__isl_keep isl_basic_map *bmap,
 	isl_stat (*fn)(__isl_take isl_constraint *c, void *user), void *user);
 isl_stat isl_basic_set_foreach_constraint(__isl_keep isl_basic_set *bset,
 	isl_stat (*fn)(__isl_take isl_constraint *c, void *user), void *user);
+isl_bool isl_basic_map_every_constraint(__isl_keep isl_basic_map *bmap,
+	isl_bool (*test)(__isl_keep isl_constraint *c, void *user), void *user);
+isl_bool isl_basic_set_every_constraint(__isl_keep isl_basic_set *bset,
+	isl_bool (*test)(__isl_keep isl_constraint *c, void *user), void *user);
 __isl_give isl_constraint_list *isl_basic_map_get_constraint_list(
 	__isl_keep isl_basic_map *bmap);
 __isl_give isl_constraint_list *isl_basic_set_get_constraint_list(
@@ -49,13 +49,15 @@ extern "C" {
  * control the behavior of the library and some caches.
  *
  * An object allocated within a given ctx should never be used inside
- * another ctx.  Functions for moving objects from one ctx to another
- * will be added as the need arises.
+ * another ctx.  Sets and relations can be copied to another ctx
+ * using the isl_*_copy_to_ctx functions.
  *
  * A given context should only be used inside a single thread.
- * A global context for synchronization between different threads
- * as well as functions for moving a context to a different thread
- * will be added as the need arises.
+ * A child context, allocated using isl_ctx_alloc_child, shares
+ * the options of its parent and can be used in a different thread
+ * from its parent and from the other children.
+ * Objects of the parent can be copied to a child while no thread
+ * modifies the parent or any of its objects.
  *
  * If anything goes wrong (out of memory, failed assertion), then
  * the library will currently simply abort.  This will be made
@@ -68,8 +70,78 @@ extern "C" {
  * (in case of pointer return type).
  * The only exception is the isl_ctx argument, which should never be NULL.
  */
+/* Statistics about the operations performed within an isl_ctx.
+ * The counters count the number of times the corresponding operation
+ * was performed, while the timers contain the cumulative processor time
+ * (in seconds) spent in these operations.
+ * The timers are only updated if the "time_stats" option is set.
+ * The gist_*_decided counters keep track of how many of the inequality
+ * simplifications performed by gist could be completed
+ * using only plain (hash based) checks, using only bounds
+ * on individual variables or required the construction of a tableau.
+ * Similarly, the empty_*_decided counters keep track of how many
+ * integer emptiness checks on basic maps could be decided
+ * using only plain checks, were shown to be empty using
+ * bounds on individual variables, were shown to be non-empty
+ * by a trivial candidate point or required the computation of a sample.
+ */
 struct isl_stats {
 	long	gbr_solved_lps;
+	long	tab_pivots;
+	long	pip_solves;
+	long	coalesce_pair_tests;
+	long	gist_calls;
+	long	gist_plain_decided;
+	long	gist_bounds_decided;
+	long	gist_tab_decided;
+	long	empty_plain_decided;
+	long	empty_bounds_decided;
+	long	empty_point_decided;
+	long	empty_sample_decided;
+	long	schedule_lp_solves;
+	long	flow_computations;
+	long	sample_cache_hits;
+	long	sample_cache_misses;
+	long	flow_cache_hits;
+	long	flow_cache_misses;
+	long	lexopt_cache_hits;
+	long	lexopt_cache_misses;
+	long	ast_expr_cache_hits;
+	long	ast_expr_cache_misses;
+	long	ast_subtree_reuses;
+	long	schedule_component_reuses;
+	long	schedule_coef_cache_hits;
+	long	schedule_coef_cache_misses;
+	long	schedule_lp_backend_accepts;
+	long	schedule_lp_backend_rejects;
+	long	schedule_offload_accepts;
+	long	schedule_offload_rejects;
+	long	simple_hull_cache_hits;
+	long	simple_hull_cache_misses;
+	long	ast_stride_cache_hits;
+	long	ast_stride_cache_misses;
+	long	project_out_fm;
+	long	compute_divs_pip;
+
+	double	pip_time;
+	double	coalesce_pair_time;
+	double	gist_time;
+	double	schedule_lp_time;
+	double	flow_time;
+};
+/* Statistics on the memory allocated through an isl_ctx.
+ * "n_alloc" and "n_realloc" count the number of (re)allocations and
+ * "bytes" is the total number of bytes requested by these (re)allocations,
+ * where a reallocation is counted for its full new size.
+ * Since the corresponding deallocations are not tracked,
+ * "bytes" is an upper bound on the memory in use.
+ * "max_request" is the size of the largest single request.
+ */
+struct isl_memory_stats {
+	unsigned long	n_alloc;
+	unsigned long	n_realloc;
+	size_t		bytes;
+	size_t		max_request;
 };
 enum isl_error {
 	isl_error_none = 0,
@@ -161,6 +233,8 @@ struct isl_options *isl_ctx_options(isl_ctx *ctx);
 isl_ctx *isl_ctx_alloc_with_options(struct isl_args *args,
 	__isl_take void *opt);
 isl_ctx *isl_ctx_alloc(void);
+isl_ctx *isl_ctx_alloc_child(isl_ctx *parent);
+isl_ctx *isl_ctx_get_parent(isl_ctx *ctx);
 void *isl_ctx_peek_options(isl_ctx *ctx, struct isl_args *args);
 int isl_ctx_parse_options(isl_ctx *ctx, int argc, char **argv, unsigned flags);
 void isl_ctx_ref(struct isl_ctx *ctx);
@@ -171,10 +245,44 @@ void isl_ctx_abort(isl_ctx *ctx);
 void isl_ctx_resume(isl_ctx *ctx);
 int isl_ctx_aborted(isl_ctx *ctx);
 
+isl_stat isl_ctx_get_stats(isl_ctx *ctx, struct isl_stats *stats);
+void isl_ctx_reset_stats(isl_ctx *ctx);
+__isl_give char *isl_ctx_stats_to_json_str(isl_ctx *ctx);
+isl_stat isl_ctx_print_stats_json(isl_ctx *ctx, FILE *out);
+
 void isl_ctx_set_max_operations(isl_ctx *ctx, unsigned long max_operations);
 unsigned long isl_ctx_get_max_operations(isl_ctx *ctx);
+unsigned long isl_ctx_get_operations(isl_ctx *ctx);
 void isl_ctx_reset_operations(isl_ctx *ctx);
 
+isl_stat isl_ctx_get_memory_stats(isl_ctx *ctx,
+	struct isl_memory_stats *stats);
+void isl_ctx_set_max_allocated_bytes(isl_ctx *ctx,
+	size_t max_allocated_bytes);
+size_t isl_ctx_get_max_allocated_bytes(isl_ctx *ctx);
+void isl_ctx_reset_memory(isl_ctx *ctx);
+isl_stat isl_ctx_set_allocator(isl_ctx *ctx,
+	void *(*malloc_fn)(size_t size, void *user),
+	void *(*calloc_fn)(size_t nmemb, size_t size, void *user),
+	void *(*realloc_fn)(void *ptr, size_t size, void *user),
+	void *user);
+
+isl_stat isl_ctx_push_budget(isl_ctx *ctx, const char *name,
+	unsigned long max_operations);
+isl_stat isl_ctx_pop_budget(isl_ctx *ctx);
+unsigned long isl_ctx_get_budget_operations(isl_ctx *ctx, const char *name);
+
+isl_stat isl_ctx_push_arena(isl_ctx *ctx);
+isl_stat isl_ctx_pop_arena(isl_ctx *ctx);
+isl_stat isl_ctx_trim_memory(isl_ctx *ctx);
+
+isl_stat isl_ctx_set_scope_hooks(isl_ctx *ctx,
+	void (*enter)(isl_ctx *ctx, const char *name, void *user),
+	void (*leave)(isl_ctx *ctx, const char *name, void *user),
+	void *user);
+int isl_ctx_get_scope_depth(isl_ctx *ctx);
+const char *isl_ctx_get_scope_name(isl_ctx *ctx, int pos);
+
 #define ISL_ARG_CTX_DECL(prefix,st,args)				\
 st *isl_ctx_peek_ ## prefix(isl_ctx *ctx);
 
@@ -9,6 +9,7 @@
 #include <isl/val_type.h>
 #include <isl/space_type.h>
 #include <isl/aff_type.h>
+#include <isl/list.h>
 
 #if defined(__cplusplus)
 extern "C" {
@@ -17,6 +18,8 @@ extern "C" {
 struct __isl_export isl_fixed_box;
 typedef struct isl_fixed_box isl_fixed_box;
 
+ISL_DECLARE_LIST(fixed_box)
+
 isl_ctx *isl_fixed_box_get_ctx(__isl_keep isl_fixed_box *box);
 __isl_export
 __isl_give isl_space *isl_fixed_box_get_space(__isl_keep isl_fixed_box *box);
@@ -95,6 +95,8 @@ __isl_export
 __isl_give isl_union_access_info *isl_union_access_info_set_schedule_map(
 	__isl_take isl_union_access_info *access,
 	__isl_take isl_union_map *schedule_map);
+__isl_give isl_union_access_info *isl_union_access_info_set_approximate(
+	__isl_take isl_union_access_info *access, int approximate);
 __isl_give isl_union_access_info *isl_union_access_info_copy(
 	__isl_keep isl_union_access_info *access);
 __isl_null isl_union_access_info *isl_union_access_info_free(
@@ -113,6 +115,9 @@ __isl_give char *isl_union_access_info_to_str(
 __isl_export
 __isl_give isl_union_flow *isl_union_access_info_compute_flow(
 	__isl_take isl_union_access_info *access);
+__isl_give isl_union_flow *isl_union_access_info_update_flow(
+	__isl_take isl_union_access_info *access,
+	__isl_take isl_union_flow *flow, __isl_take isl_union_set *data);
 
 isl_ctx *isl_union_flow_get_ctx(__isl_keep isl_union_flow *flow);
 __isl_give isl_union_flow *isl_union_flow_copy(
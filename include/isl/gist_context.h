@@ -0,0 +1,43 @@
+/*
+ * Use of this software is governed by the MIT license
+ */
+
+#ifndef ISL_GIST_CONTEXT_H
+#define ISL_GIST_CONTEXT_H
+
+#include <isl/ctx.h>
+#include <isl/map_type.h>
+#include <isl/aff_type.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct isl_gist_context;
+typedef struct isl_gist_context isl_gist_context;
+
+isl_ctx *isl_gist_context_get_ctx(__isl_keep isl_gist_context *context);
+
+__isl_give isl_gist_context *isl_gist_context_from_map(
+	__isl_take isl_map *map);
+__isl_give isl_gist_context *isl_gist_context_from_set(
+	__isl_take isl_set *set);
+__isl_give isl_gist_context *isl_gist_context_copy(
+	__isl_keep isl_gist_context *context);
+__isl_null isl_gist_context *isl_gist_context_free(
+	__isl_take isl_gist_context *context);
+
+__isl_give isl_map *isl_map_gist_prepared(__isl_take isl_map *map,
+	__isl_keep isl_gist_context *context);
+__isl_give isl_set *isl_set_gist_prepared(__isl_take isl_set *set,
+	__isl_keep isl_gist_context *context);
+__isl_give isl_aff *isl_aff_gist_prepared(__isl_take isl_aff *aff,
+	__isl_keep isl_gist_context *context);
+__isl_give isl_pw_aff *isl_pw_aff_gist_prepared(__isl_take isl_pw_aff *pa,
+	__isl_keep isl_gist_context *context);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -59,6 +59,10 @@ void isl_hash_table_free(struct isl_ctx *ctx, struct isl_hash_table *table);
 int isl_hash_table_init(struct isl_ctx *ctx, struct isl_hash_table *table,
 			int min_size);
 void isl_hash_table_clear(struct isl_hash_table *table);
+isl_stat isl_hash_table_reserve(struct isl_ctx *ctx,
+	struct isl_hash_table *table, int n);
+isl_stat isl_hash_table_shrink(struct isl_ctx *ctx,
+	struct isl_hash_table *table);
 extern struct isl_hash_table_entry *isl_hash_table_entry_none;
 struct isl_hash_table_entry *isl_hash_table_find(struct isl_ctx *ctx,
 			    struct isl_hash_table *table,
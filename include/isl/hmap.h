@@ -17,11 +17,15 @@ typedef struct ISL_HMAP	ISL_HMAP;
 __isl_give ISL_HMAP *ISL_FN(ISL_HMAP,alloc)(isl_ctx *ctx, int min_size);
 __isl_give ISL_HMAP *ISL_FN(ISL_HMAP,copy)(__isl_keep ISL_HMAP *hmap);
 __isl_null ISL_HMAP *ISL_FN(ISL_HMAP,free)(__isl_take ISL_HMAP *hmap);
+__isl_give ISL_HMAP *ISL_FN(ISL_HMAP,reserve)(__isl_take ISL_HMAP *hmap,
+	int n);
 
 isl_ctx *ISL_FN(ISL_HMAP,get_ctx)(__isl_keep ISL_HMAP *hmap);
 
 __isl_give ISL_MAYBE(ISL_VAL) ISL_FN(ISL_HMAP,try_get)(
 	__isl_keep ISL_HMAP *hmap, __isl_keep ISL_KEY *key);
+__isl_keep ISL_VAL *ISL_FN(ISL_HMAP,peek)(__isl_keep ISL_HMAP *hmap,
+	__isl_keep ISL_KEY *key);
 isl_bool ISL_FN(ISL_HMAP,has)(__isl_keep ISL_HMAP *hmap,
 	__isl_keep ISL_KEY *key);
 __isl_give ISL_VAL *ISL_FN(ISL_HMAP,get)(__isl_keep ISL_HMAP *hmap,
@@ -128,6 +128,20 @@ __isl_give ISL_HMAP *ISL_FN(ISL_HMAP,copy)(__isl_keep ISL_HMAP *hmap)
 	return hmap;
 }
 
+/* Make sure that "hmap" can hold at least "n" key-value pairs
+ * without having to grow its internal hash table.
+ */
+__isl_give ISL_HMAP *ISL_FN(ISL_HMAP,reserve)(__isl_take ISL_HMAP *hmap,
+	int n)
+{
+	hmap = ISL_FN(ISL_HMAP,cow)(hmap);
+	if (!hmap)
+		return NULL;
+	if (isl_hash_table_reserve(hmap->ctx, &hmap->table, n) < 0)
+		return ISL_FN(ISL_HMAP,free)(hmap);
+	return hmap;
+}
+
 static isl_bool has_key(const void *entry, const void *c_key)
 {
 	const ISL_S(pair) *pair = entry;
@@ -136,44 +150,69 @@ static isl_bool has_key(const void *entry, const void *c_key)
 	return ISL_KEY_IS_EQUAL(pair->key, key);
 }
 
-/* If "hmap" contains a value associated to "key", then return
- * (isl_bool_true, copy of value).
- * Otherwise, return
- * (isl_bool_false, NULL).
- * If an error occurs, then return
- * (isl_bool_error, NULL).
+/* Look for the key-value pair in "hmap" with key "key" and
+ * store it in *pair.
+ * Return isl_bool_true if such a pair was found and
+ * isl_bool_false if not.
  */
-__isl_give ISL_MAYBE(ISL_VAL) ISL_FN(ISL_HMAP,try_get)(
-	__isl_keep ISL_HMAP *hmap, __isl_keep ISL_KEY *key)
+static isl_bool find_pair(__isl_keep ISL_HMAP *hmap, __isl_keep ISL_KEY *key,
+	ISL_S(pair) **pair)
 {
 	struct isl_hash_table_entry *entry;
-	ISL_S(pair) *pair;
 	uint32_t hash;
-	ISL_MAYBE(ISL_VAL) res = { isl_bool_false, NULL };
 
 	if (!hmap || !key)
-		goto error;
+		return isl_bool_error;
 
 	hash = ISL_FN(ISL_KEY,get_hash)(key);
 	entry = isl_hash_table_find(hmap->ctx, &hmap->table, hash,
 					&has_key, key, 0);
 
 	if (!entry)
-		goto error;
+		return isl_bool_error;
 	if (entry == isl_hash_table_entry_none)
-		return res;
+		return isl_bool_false;
 
-	pair = entry->data;
+	*pair = entry->data;
+	return isl_bool_true;
+}
+
+/* If "hmap" contains a value associated to "key", then return
+ * (isl_bool_true, copy of value).
+ * Otherwise, return
+ * (isl_bool_false, NULL).
+ * If an error occurs, then return
+ * (isl_bool_error, NULL).
+ */
+__isl_give ISL_MAYBE(ISL_VAL) ISL_FN(ISL_HMAP,try_get)(
+	__isl_keep ISL_HMAP *hmap, __isl_keep ISL_KEY *key)
+{
+	ISL_S(pair) *pair;
+	ISL_MAYBE(ISL_VAL) res = { isl_bool_false, NULL };
+
+	res.valid = find_pair(hmap, key, &pair);
+	if (res.valid <= 0)
+		return res;
 
-	res.valid = isl_bool_true;
 	res.value = ISL_FN(ISL_VAL,copy)(pair->val);
 	if (!res.value)
 		res.valid = isl_bool_error;
 	return res;
-error:
-	res.valid = isl_bool_error;
-	res.value = NULL;
-	return res;
+}
+
+/* If "hmap" contains a value associated to "key", then return
+ * that value without taking a new reference.
+ * The value remains valid as long as "hmap" is not modified or freed.
+ * Otherwise, or if an error occurs, return NULL.
+ */
+__isl_keep ISL_VAL *ISL_FN(ISL_HMAP,peek)(__isl_keep ISL_HMAP *hmap,
+	__isl_keep ISL_KEY *key)
+{
+	ISL_S(pair) *pair;
+
+	if (find_pair(hmap, key, &pair) <= 0)
+		return NULL;
+	return pair->val;
 }
 
 /* If "hmap" contains a value associated to "key", then return
@@ -183,12 +222,9 @@ error:
 isl_bool ISL_FN(ISL_HMAP,has)(__isl_keep ISL_HMAP *hmap,
 	__isl_keep ISL_KEY *key)
 {
-	ISL_MAYBE(ISL_VAL) res;
-
-	res = ISL_FN(ISL_HMAP,try_get)(hmap, key);
-	ISL_FN(ISL_VAL,free)(res.value);
+	ISL_S(pair) *pair;
 
-	return res.valid;
+	return find_pair(hmap, key, &pair);
 }
 
 /* If "hmap" contains a value associated to "key", then return
@@ -230,11 +266,13 @@ __isl_give ISL_HMAP *ISL_FN(ISL_HMAP,drop)(__isl_take ISL_HMAP *hmap,
 		return hmap;
 	}
 
-	hmap = ISL_FN(ISL_HMAP,cow)(hmap);
-	if (!hmap)
-		goto error;
-	entry = isl_hash_table_find(hmap->ctx, &hmap->table, hash,
-					&has_key, key, 0);
+	if (hmap->ref != 1) {
+		hmap = ISL_FN(ISL_HMAP,cow)(hmap);
+		if (!hmap)
+			goto error;
+		entry = isl_hash_table_find(hmap->ctx, &hmap->table, hash,
+						&has_key, key, 0);
+	}
 	ISL_FN(ISL_KEY,free)(key);
 
 	if (!entry)
@@ -261,6 +299,9 @@ error:
  * is replaced.
  * If key happened to be mapped to "val" already, then we leave
  * "hmap" untouched.
+ * This is only checked if "hmap" is shared, since it avoids
+ * a needless copy in that case.  Otherwise, the key is looked up
+ * only once and an equal value is simply replaced.
  */
 __isl_give ISL_HMAP *ISL_FN(ISL_HMAP,set)(__isl_take ISL_HMAP *hmap,
 	__isl_take ISL_KEY *key, __isl_take ISL_VAL *val)
@@ -273,20 +314,22 @@ __isl_give ISL_HMAP *ISL_FN(ISL_HMAP,set)(__isl_take ISL_HMAP *hmap,
 		goto error;
 
 	hash = ISL_FN(ISL_KEY,get_hash)(key);
-	entry = isl_hash_table_find(hmap->ctx, &hmap->table, hash,
-					&has_key, key, 0);
-	if (!entry)
-		goto error;
-	if (entry != isl_hash_table_entry_none) {
-		isl_bool equal;
-		pair = entry->data;
-		equal = ISL_VAL_IS_EQUAL(pair->val, val);
-		if (equal < 0)
+	if (hmap->ref != 1) {
+		entry = isl_hash_table_find(hmap->ctx, &hmap->table, hash,
+						&has_key, key, 0);
+		if (!entry)
 			goto error;
-		if (equal) {
-			ISL_FN(ISL_KEY,free)(key);
-			ISL_FN(ISL_VAL,free)(val);
-			return hmap;
+		if (entry != isl_hash_table_entry_none) {
+			isl_bool equal;
+			pair = entry->data;
+			equal = ISL_VAL_IS_EQUAL(pair->val, val);
+			if (equal < 0)
+				goto error;
+			if (equal) {
+				ISL_FN(ISL_KEY,free)(key);
+				ISL_FN(ISL_VAL,free)(val);
+				return hmap;
+			}
 		}
 	}
 
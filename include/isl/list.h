@@ -34,6 +34,10 @@ __isl_give isl_##EL##_list *isl_##EL##_list_from_##EL(			\
 	__isl_take isl_##EL *el);					\
 CONSTRUCTOR								\
 __isl_give isl_##EL##_list *isl_##EL##_list_alloc(isl_ctx *ctx, int n);	\
+__isl_give isl_##EL##_list *isl_##EL##_list_from_array(isl_ctx *ctx,	\
+	int n, __isl_take isl_##EL **array);				\
+__isl_give isl_##EL##_list *isl_##EL##_list_reserve(			\
+	__isl_take isl_##EL##_list *list, int n);			\
 __isl_give isl_##EL##_list *isl_##EL##_list_copy(			\
 	__isl_keep isl_##EL##_list *list);				\
 __isl_null isl_##EL##_list *isl_##EL##_list_free(			\
@@ -20,6 +20,8 @@ __isl_give isl_local_space *isl_local_space_from_space(
 
 __isl_give isl_local_space *isl_local_space_copy(
 	__isl_keep isl_local_space *ls);
+__isl_give isl_local_space *isl_local_space_copy_to_ctx(
+	__isl_keep isl_local_space *ls, isl_ctx *ctx);
 __isl_null isl_local_space *isl_local_space_free(
 	__isl_take isl_local_space *ls);
 
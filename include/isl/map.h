@@ -120,6 +120,8 @@ isl_bool isl_basic_map_is_rational(__isl_keep isl_basic_map *bmap);
 __isl_give isl_basic_map *isl_basic_map_identity(__isl_take isl_space *space);
 __isl_null isl_basic_map *isl_basic_map_free(__isl_take isl_basic_map *bmap);
 __isl_give isl_basic_map *isl_basic_map_copy(__isl_keep isl_basic_map *bmap);
+__isl_give isl_basic_map *isl_basic_map_copy_to_ctx(
+	__isl_keep isl_basic_map *bmap, isl_ctx *ctx);
 __isl_give isl_basic_map *isl_basic_map_equal(
 	__isl_take isl_space *space, unsigned n_equal);
 __isl_give isl_basic_map *isl_basic_map_less_at(__isl_take isl_space *space,
@@ -202,6 +204,17 @@ __isl_give isl_basic_map *isl_basic_map_read_from_str(isl_ctx *ctx,
 __isl_give isl_map *isl_map_read_from_file(isl_ctx *ctx, FILE *input);
 __isl_constructor
 __isl_give isl_map *isl_map_read_from_str(isl_ctx *ctx, const char *str);
+__isl_give isl_basic_map *isl_basic_map_read_from_binary_file(isl_ctx *ctx,
+	FILE *input);
+__isl_give isl_basic_map *isl_basic_map_read_from_binary_str(isl_ctx *ctx,
+	const char *str);
+__isl_give isl_basic_map *isl_basic_map_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos);
+__isl_give isl_map *isl_map_read_from_binary_file(isl_ctx *ctx, FILE *input);
+__isl_give isl_map *isl_map_read_from_binary_str(isl_ctx *ctx,
+	const char *str);
+__isl_give isl_map *isl_map_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos);
 void isl_basic_map_dump(__isl_keep isl_basic_map *bmap);
 void isl_map_dump(__isl_keep isl_map *map);
 __isl_give char *isl_basic_map_to_str(__isl_keep isl_basic_map *bmap);
@@ -298,6 +311,8 @@ isl_bool isl_basic_map_is_empty(__isl_keep isl_basic_map *bmap);
 __isl_export
 isl_bool isl_basic_map_is_subset(__isl_keep isl_basic_map *bmap1,
 		__isl_keep isl_basic_map *bmap2);
+isl_bool isl_basic_map_plain_is_subset(__isl_keep isl_basic_map *bmap1,
+	__isl_keep isl_basic_map *bmap2);
 isl_bool isl_basic_map_is_strict_subset(__isl_keep isl_basic_map *bmap1,
 		__isl_keep isl_basic_map *bmap2);
 
@@ -323,6 +338,7 @@ __isl_give isl_map *isl_map_lex_gt(__isl_take isl_space *set_space);
 __isl_give isl_map *isl_map_lex_ge(__isl_take isl_space *set_space);
 __isl_null isl_map *isl_map_free(__isl_take isl_map *map);
 __isl_give isl_map *isl_map_copy(__isl_keep isl_map *map);
+__isl_give isl_map *isl_map_copy_to_ctx(__isl_keep isl_map *map, isl_ctx *ctx);
 __isl_export
 __isl_give isl_map *isl_map_reverse(__isl_take isl_map *map);
 __isl_export
@@ -456,6 +472,10 @@ __isl_export
 __isl_give isl_basic_set *isl_basic_map_deltas(__isl_take isl_basic_map *bmap);
 __isl_export
 __isl_give isl_set *isl_map_deltas(__isl_take isl_map *map);
+__isl_give isl_multi_val *isl_map_get_deltas_min_sign(
+	__isl_keep isl_map *map);
+__isl_give isl_multi_val *isl_map_get_deltas_max_sign(
+	__isl_keep isl_map *map);
 __isl_give isl_basic_map *isl_basic_map_deltas_map(
 	__isl_take isl_basic_map *bmap);
 __isl_give isl_map *isl_map_deltas_map(__isl_take isl_map *map);
@@ -597,6 +617,8 @@ __isl_export
 isl_bool isl_map_is_empty(__isl_keep isl_map *map);
 __isl_export
 isl_bool isl_map_is_subset(__isl_keep isl_map *map1, __isl_keep isl_map *map2);
+isl_bool isl_map_plain_is_subset(__isl_keep isl_map *map1,
+	__isl_keep isl_map *map2);
 __isl_export
 isl_bool isl_map_is_strict_subset(__isl_keep isl_map *map1,
 	__isl_keep isl_map *map2);
@@ -699,6 +721,8 @@ __isl_give isl_fixed_box *isl_map_get_range_simple_fixed_box_hull(
 
 __isl_export
 __isl_give isl_map *isl_map_coalesce(__isl_take isl_map *map);
+__isl_give isl_map *isl_map_union_coalesce(__isl_take isl_map *map1,
+	__isl_take isl_map *map2);
 
 isl_bool isl_map_plain_is_equal(__isl_keep isl_map *map1,
 	__isl_keep isl_map *map2);
@@ -707,9 +731,15 @@ uint32_t isl_map_get_hash(__isl_keep isl_map *map);
 
 __isl_export
 isl_size isl_map_n_basic_map(__isl_keep isl_map *map);
+double isl_basic_map_estimate_cost(__isl_keep isl_basic_map *bmap);
+double isl_map_estimate_cost(__isl_keep isl_map *map);
 __isl_export
 isl_stat isl_map_foreach_basic_map(__isl_keep isl_map *map,
 	isl_stat (*fn)(__isl_take isl_basic_map *bmap, void *user), void *user);
+__isl_export
+isl_bool isl_map_every_basic_map(__isl_keep isl_map *map,
+	isl_bool (*test)(__isl_keep isl_basic_map *bmap, void *user),
+	void *user);
 __isl_give isl_basic_map_list *isl_map_get_basic_map_list(
 	__isl_keep isl_map *map);
 
@@ -767,6 +797,9 @@ __isl_give isl_basic_map *isl_basic_map_from_constraint_matrices(
 	__isl_take isl_mat *eq, __isl_take isl_mat *ineq, enum isl_dim_type c1,
 	enum isl_dim_type c2, enum isl_dim_type c3,
 	enum isl_dim_type c4, enum isl_dim_type c5);
+__isl_give isl_basic_map *isl_basic_map_from_int64_constraints(
+	__isl_take isl_space *space, unsigned n_exist,
+	unsigned n_eq, const int64_t *eq, unsigned n_ineq, const int64_t *ineq);
 
 __isl_give isl_basic_map *isl_basic_map_from_aff(__isl_take isl_aff *aff);
 __isl_give isl_basic_map *isl_basic_map_from_multi_aff(
@@ -41,6 +41,9 @@ __isl_give isl_mat *isl_mat_set_element_si(__isl_take isl_mat *mat,
 	int row, int col, int v);
 __isl_give isl_mat *isl_mat_set_element_val(__isl_take isl_mat *mat,
 	int row, int col, __isl_take isl_val *v);
+isl_stat isl_mat_get_elements_si(__isl_keep isl_mat *mat, long *data);
+__isl_give isl_mat *isl_mat_from_elements_si(isl_ctx *ctx,
+	unsigned n_row, unsigned n_col, const long *data);
 
 __isl_give isl_mat *isl_mat_swap_cols(__isl_take isl_mat *mat,
 	unsigned i, unsigned j);
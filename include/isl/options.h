@@ -21,10 +21,19 @@ struct isl_options;
 
 ISL_ARG_DECL(isl_options, struct isl_options, isl_options_args)
 
+isl_stat isl_options_set_threads(isl_ctx *ctx, int val);
+int isl_options_get_threads(isl_ctx *ctx);
+
 #define			ISL_BOUND_BERNSTEIN	0
 #define			ISL_BOUND_RANGE		1
 isl_stat isl_options_set_bound(isl_ctx *ctx, int val);
 int isl_options_get_bound(isl_ctx *ctx);
+isl_stat isl_options_set_bound_threads(isl_ctx *ctx, int val);
+int isl_options_get_bound_threads(isl_ctx *ctx);
+isl_stat isl_options_set_bernstein_threads(isl_ctx *ctx, int val);
+int isl_options_get_bernstein_threads(isl_ctx *ctx);
+isl_stat isl_options_set_scan_threads(isl_ctx *ctx, int val);
+int isl_options_get_scan_threads(isl_ctx *ctx);
 
 #define			ISL_ON_ERROR_WARN	0
 #define			ISL_ON_ERROR_CONTINUE	1
@@ -34,21 +43,77 @@ int isl_options_get_on_error(isl_ctx *ctx);
 
 isl_stat isl_options_set_gbr_only_first(isl_ctx *ctx, int val);
 int isl_options_get_gbr_only_first(isl_ctx *ctx);
+isl_stat isl_options_set_gbr_threads(isl_ctx *ctx, int val);
+int isl_options_get_gbr_threads(isl_ctx *ctx);
+
+isl_stat isl_options_set_closure_budget(isl_ctx *ctx, int val);
+int isl_options_get_closure_budget(isl_ctx *ctx);
+isl_stat isl_options_set_closure_threads(isl_ctx *ctx, int val);
+int isl_options_get_closure_threads(isl_ctx *ctx);
 
 #define		ISL_SCHEDULE_ALGORITHM_ISL		0
 #define		ISL_SCHEDULE_ALGORITHM_FEAUTRIER	1
 isl_stat isl_options_set_schedule_algorithm(isl_ctx *ctx, int val);
 int isl_options_get_schedule_algorithm(isl_ctx *ctx);
+isl_stat isl_options_set_schedule_budget(isl_ctx *ctx, int val);
+int isl_options_get_schedule_budget(isl_ctx *ctx);
 
 isl_stat isl_options_set_pip_symmetry(isl_ctx *ctx, int val);
 int isl_options_get_pip_symmetry(isl_ctx *ctx);
 
+isl_stat isl_options_set_pip_threads(isl_ctx *ctx, int val);
+int isl_options_get_pip_threads(isl_ctx *ctx);
+
+isl_stat isl_options_set_convex_hull_threads(isl_ctx *ctx, int val);
+int isl_options_get_convex_hull_threads(isl_ctx *ctx);
+isl_stat isl_options_set_convex_hull_max_facets(isl_ctx *ctx, int val);
+int isl_options_get_convex_hull_max_facets(isl_ctx *ctx);
+
 isl_stat isl_options_set_coalesce_bounded_wrapping(isl_ctx *ctx, int val);
 int isl_options_get_coalesce_bounded_wrapping(isl_ctx *ctx);
 
 isl_stat isl_options_set_coalesce_preserve_locals(isl_ctx *ctx, int val);
 int isl_options_get_coalesce_preserve_locals(isl_ctx *ctx);
 
+isl_stat isl_options_set_coalesce_threads(isl_ctx *ctx, int val);
+int isl_options_get_coalesce_threads(isl_ctx *ctx);
+
+isl_stat isl_options_set_union_map_threads(isl_ctx *ctx, int val);
+int isl_options_get_union_map_threads(isl_ctx *ctx);
+
+isl_stat isl_options_set_flow_threads(isl_ctx *ctx, int val);
+int isl_options_get_flow_threads(isl_ctx *ctx);
+isl_stat isl_options_set_flow_cache_size(isl_ctx *ctx, int val);
+int isl_options_get_flow_cache_size(isl_ctx *ctx);
+
+isl_stat isl_options_set_intern_spaces(isl_ctx *ctx, int val);
+int isl_options_get_intern_spaces(isl_ctx *ctx);
+
+isl_stat isl_options_set_memory_lean(isl_ctx *ctx, int val);
+int isl_options_get_memory_lean(isl_ctx *ctx);
+
+isl_stat isl_options_set_time_stats(isl_ctx *ctx, int val);
+int isl_options_get_time_stats(isl_ctx *ctx);
+isl_stat isl_options_set_stats_json(isl_ctx *ctx, const char *val);
+const char *isl_options_get_stats_json(isl_ctx *ctx);
+isl_stat isl_options_set_stats_top_coalesce(isl_ctx *ctx, int val);
+int isl_options_get_stats_top_coalesce(isl_ctx *ctx);
+
+isl_stat isl_options_set_sample_cache_size(isl_ctx *ctx, int val);
+int isl_options_get_sample_cache_size(isl_ctx *ctx);
+
+isl_stat isl_options_set_lexopt_cache_size(isl_ctx *ctx, int val);
+int isl_options_get_lexopt_cache_size(isl_ctx *ctx);
+
+#define ISL_PROJECT_OUT_AUTO	0
+#define ISL_PROJECT_OUT_DIV	1
+#define ISL_PROJECT_OUT_FM	2
+isl_stat isl_options_set_project_out(isl_ctx *ctx, int val);
+int isl_options_get_project_out(isl_ctx *ctx);
+
+isl_stat isl_options_set_pw_coalesce_threshold(isl_ctx *ctx, int val);
+int isl_options_get_pw_coalesce_threshold(isl_ctx *ctx);
+
 #if defined(__cplusplus)
 }
 #endif
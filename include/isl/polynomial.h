@@ -48,6 +48,8 @@ __isl_give isl_qpolynomial *isl_qpolynomial_var_on_domain(
 	__isl_take isl_space *domain,
 	enum isl_dim_type type, unsigned pos);
 __isl_give isl_qpolynomial *isl_qpolynomial_copy(__isl_keep isl_qpolynomial *qp);
+__isl_give isl_qpolynomial *isl_qpolynomial_copy_to_ctx(
+	__isl_keep isl_qpolynomial *qp, isl_ctx *ctx);
 __isl_null isl_qpolynomial *isl_qpolynomial_free(
 	__isl_take isl_qpolynomial *qp);
 
@@ -153,6 +155,8 @@ __isl_give isl_pw_qpolynomial *isl_pw_qpolynomial_from_qpolynomial(
 	__isl_take isl_qpolynomial *qp);
 __isl_give isl_pw_qpolynomial *isl_pw_qpolynomial_copy(
 	__isl_keep isl_pw_qpolynomial *pwqp);
+__isl_give isl_pw_qpolynomial *isl_pw_qpolynomial_copy_to_ctx(
+	__isl_keep isl_pw_qpolynomial *pwqp, isl_ctx *ctx);
 __isl_null isl_pw_qpolynomial *isl_pw_qpolynomial_free(
 	__isl_take isl_pw_qpolynomial *pwqp);
 
@@ -310,6 +314,8 @@ __isl_give isl_qpolynomial_fold *isl_qpolynomial_fold_alloc(
 	enum isl_fold type, __isl_take isl_qpolynomial *qp);
 __isl_give isl_qpolynomial_fold *isl_qpolynomial_fold_copy(
 	__isl_keep isl_qpolynomial_fold *fold);
+__isl_give isl_qpolynomial_fold *isl_qpolynomial_fold_copy_to_ctx(
+	__isl_keep isl_qpolynomial_fold *fold, isl_ctx *ctx);
 __isl_null isl_qpolynomial_fold *isl_qpolynomial_fold_free(
 	__isl_take isl_qpolynomial_fold *fold);
 
@@ -386,6 +392,8 @@ isl_pw_qpolynomial_fold_from_qpolynomial_fold(
 	__isl_take isl_qpolynomial_fold *fold);
 __isl_give isl_pw_qpolynomial_fold *isl_pw_qpolynomial_fold_copy(
 	__isl_keep isl_pw_qpolynomial_fold *pwf);
+__isl_give isl_pw_qpolynomial_fold *isl_pw_qpolynomial_fold_copy_to_ctx(
+	__isl_keep isl_pw_qpolynomial_fold *pwf, isl_ctx *ctx);
 __isl_null isl_pw_qpolynomial_fold *isl_pw_qpolynomial_fold_free(
 	__isl_take isl_pw_qpolynomial_fold *pwf);
 
@@ -12,6 +12,8 @@ extern "C" {
 
 __isl_give isl_printer *isl_printer_to_file(isl_ctx *ctx, FILE *file);
 __isl_give isl_printer *isl_printer_to_str(isl_ctx *ctx);
+__isl_give isl_printer *isl_printer_to_callback(isl_ctx *ctx,
+	isl_stat (*write)(const char *s, size_t len, void *user), void *user);
 __isl_null isl_printer *isl_printer_free(__isl_take isl_printer *printer);
 
 isl_ctx *isl_printer_get_ctx(__isl_keep isl_printer *printer);
@@ -31,6 +33,7 @@ __isl_give isl_printer *isl_printer_indent(__isl_take isl_printer *p,
 #define ISL_FORMAT_C			4
 #define ISL_FORMAT_LATEX		5
 #define ISL_FORMAT_EXT_POLYLIB		6
+#define ISL_FORMAT_BINARY		7
 __isl_give isl_printer *isl_printer_set_output_format(__isl_take isl_printer *p,
 	int output_format);
 int isl_printer_get_output_format(__isl_keep isl_printer *p);
@@ -40,6 +43,9 @@ int isl_printer_get_output_format(__isl_keep isl_printer *p);
 __isl_give isl_printer *isl_printer_set_yaml_style(__isl_take isl_printer *p,
 	int yaml_style);
 int isl_printer_get_yaml_style(__isl_keep isl_printer *p);
+__isl_give isl_printer *isl_printer_set_yaml_anchors(
+	__isl_take isl_printer *p, int anchors);
+int isl_printer_get_yaml_anchors(__isl_keep isl_printer *p);
 
 __isl_give isl_printer *isl_printer_set_indent_prefix(__isl_take isl_printer *p,
 	const char *prefix);
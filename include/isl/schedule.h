@@ -9,6 +9,7 @@
 #include <isl/set_type.h>
 #include <isl/list.h>
 #include <isl/printer_type.h>
+#include <isl/vec.h>
 
 #if defined(__cplusplus)
 extern "C" {
@@ -44,6 +45,21 @@ int isl_options_get_schedule_separate_components(isl_ctx *ctx);
 isl_stat isl_options_set_schedule_serialize_sccs(isl_ctx *ctx, int val);
 int isl_options_get_schedule_serialize_sccs(isl_ctx *ctx);
 
+isl_stat isl_options_set_schedule_threads(isl_ctx *ctx, int val);
+int isl_options_get_schedule_threads(isl_ctx *ctx);
+isl_stat isl_options_set_schedule_coefficients_threads(isl_ctx *ctx, int val);
+int isl_options_get_schedule_coefficients_threads(isl_ctx *ctx);
+
+isl_stat isl_options_set_schedule_trace(isl_ctx *ctx, int val);
+int isl_options_get_schedule_trace(isl_ctx *ctx);
+
+isl_stat isl_options_set_schedule_lp_backend(isl_ctx *ctx,
+	__isl_give isl_vec *(*fn)(__isl_keep isl_basic_set *lp, void *user),
+	void *user);
+isl_stat isl_options_set_schedule_offload(isl_ctx *ctx,
+	__isl_give char *(*fn)(isl_ctx *ctx, const char *sc, void *user),
+	void *user);
+
 isl_stat isl_options_set_schedule_whole_component(isl_ctx *ctx, int val);
 int isl_options_get_schedule_whole_component(isl_ctx *ctx);
 
@@ -113,6 +129,13 @@ __isl_give isl_schedule_constraints *isl_schedule_constraints_read_from_str(
 	isl_ctx *ctx, const char *str);
 __isl_give isl_schedule_constraints *isl_schedule_constraints_read_from_file(
 	isl_ctx *ctx, FILE *input);
+__isl_give isl_schedule_constraints *
+isl_schedule_constraints_read_from_binary_file(isl_ctx *ctx, FILE *input);
+__isl_give isl_schedule_constraints *
+isl_schedule_constraints_read_from_binary_str(isl_ctx *ctx, const char *str);
+__isl_give isl_schedule_constraints *
+isl_schedule_constraints_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos);
 __isl_give isl_printer *isl_printer_print_schedule_constraints(
 	__isl_take isl_printer *p, __isl_keep isl_schedule_constraints *sc);
 void isl_schedule_constraints_dump(__isl_keep isl_schedule_constraints *sc);
@@ -122,6 +145,10 @@ __isl_give char *isl_schedule_constraints_to_str(
 __isl_export
 __isl_give isl_schedule *isl_schedule_constraints_compute_schedule(
 	__isl_take isl_schedule_constraints *sc);
+__isl_give isl_schedule *isl_schedule_constraints_recompute_schedule(
+	__isl_take isl_schedule_constraints *sc,
+	__isl_take isl_schedule_constraints *prev_sc,
+	__isl_take isl_schedule *prev);
 
 __isl_give isl_schedule *isl_union_set_compute_schedule(
 	__isl_take isl_union_set *domain,
@@ -133,6 +160,8 @@ __isl_export
 __isl_give isl_schedule *isl_schedule_from_domain(
 	__isl_take isl_union_set *domain);
 __isl_give isl_schedule *isl_schedule_copy(__isl_keep isl_schedule *sched);
+__isl_give isl_schedule *isl_schedule_copy_to_ctx(
+	__isl_keep isl_schedule *schedule, isl_ctx *ctx);
 __isl_null isl_schedule *isl_schedule_free(__isl_take isl_schedule *sched);
 __isl_export
 __isl_give isl_union_map *isl_schedule_get_map(__isl_keep isl_schedule *sched);
@@ -189,6 +218,12 @@ __isl_give isl_schedule *isl_schedule_read_from_file(isl_ctx *ctx, FILE *input);
 __isl_constructor
 __isl_give isl_schedule *isl_schedule_read_from_str(isl_ctx *ctx,
 	const char *str);
+__isl_give isl_schedule *isl_schedule_read_from_binary_file(isl_ctx *ctx,
+	FILE *input);
+__isl_give isl_schedule *isl_schedule_read_from_binary_str(isl_ctx *ctx,
+	const char *str);
+__isl_give isl_schedule *isl_schedule_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos);
 __isl_give isl_printer *isl_printer_print_schedule(__isl_take isl_printer *p,
 	__isl_keep isl_schedule *schedule);
 void isl_schedule_dump(__isl_keep isl_schedule *schedule);
@@ -97,6 +97,8 @@ int isl_basic_set_is_rational(__isl_keep isl_basic_set *bset);
 
 __isl_null isl_basic_set *isl_basic_set_free(__isl_take isl_basic_set *bset);
 __isl_give isl_basic_set *isl_basic_set_copy(__isl_keep isl_basic_set *bset);
+__isl_give isl_basic_set *isl_basic_set_copy_to_ctx(
+	__isl_keep isl_basic_set *bset, isl_ctx *ctx);
 __isl_give isl_basic_set *isl_basic_set_empty(__isl_take isl_space *space);
 __isl_give isl_basic_set *isl_basic_set_universe(__isl_take isl_space *space);
 __isl_give isl_basic_set *isl_basic_set_nat_universe(
@@ -145,6 +147,17 @@ __isl_give isl_basic_set *isl_basic_set_read_from_str(isl_ctx *ctx,
 __isl_give isl_set *isl_set_read_from_file(isl_ctx *ctx, FILE *input);
 __isl_constructor
 __isl_give isl_set *isl_set_read_from_str(isl_ctx *ctx, const char *str);
+__isl_give isl_basic_set *isl_basic_set_read_from_binary_file(isl_ctx *ctx,
+	FILE *input);
+__isl_give isl_basic_set *isl_basic_set_read_from_binary_str(isl_ctx *ctx,
+	const char *str);
+__isl_give isl_basic_set *isl_basic_set_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos);
+__isl_give isl_set *isl_set_read_from_binary_file(isl_ctx *ctx, FILE *input);
+__isl_give isl_set *isl_set_read_from_binary_str(isl_ctx *ctx,
+	const char *str);
+__isl_give isl_set *isl_set_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos);
 void isl_basic_set_dump(__isl_keep isl_basic_set *bset);
 void isl_set_dump(__isl_keep isl_set *set);
 __isl_give isl_printer *isl_printer_print_basic_set(
@@ -270,6 +283,8 @@ isl_bool isl_basic_set_is_bounded(__isl_keep isl_basic_set *bset);
 __isl_export
 isl_bool isl_basic_set_is_subset(__isl_keep isl_basic_set *bset1,
 	__isl_keep isl_basic_set *bset2);
+isl_bool isl_basic_set_plain_is_subset(__isl_keep isl_basic_set *bset1,
+	__isl_keep isl_basic_set *bset2);
 isl_bool isl_basic_set_plain_is_equal(__isl_keep isl_basic_set *bset1,
 	__isl_keep isl_basic_set *bset2);
 
@@ -281,6 +296,7 @@ __isl_export
 __isl_give isl_set *isl_space_universe_set(__isl_take isl_space *space);
 __isl_give isl_set *isl_set_nat_universe(__isl_take isl_space *space);
 __isl_give isl_set *isl_set_copy(__isl_keep isl_set *set);
+__isl_give isl_set *isl_set_copy_to_ctx(__isl_keep isl_set *set, isl_ctx *ctx);
 __isl_null isl_set *isl_set_free(__isl_take isl_set *set);
 __isl_export
 __isl_give isl_set *isl_basic_set_to_set(__isl_take isl_basic_set *bset);
@@ -439,6 +455,8 @@ isl_bool isl_set_is_empty(__isl_keep isl_set *set);
 isl_bool isl_set_is_bounded(__isl_keep isl_set *set);
 __isl_export
 isl_bool isl_set_is_subset(__isl_keep isl_set *set1, __isl_keep isl_set *set2);
+isl_bool isl_set_plain_is_subset(__isl_keep isl_set *set1,
+	__isl_keep isl_set *set2);
 __isl_export
 isl_bool isl_set_is_strict_subset(__isl_keep isl_set *set1,
 	__isl_keep isl_set *set2);
@@ -447,6 +465,10 @@ isl_bool isl_set_is_equal(__isl_keep isl_set *set1, __isl_keep isl_set *set2);
 __isl_export
 isl_bool isl_set_is_disjoint(__isl_keep isl_set *set1,
 	__isl_keep isl_set *set2);
+isl_bool isl_set_list_intersect_is_empty(__isl_keep isl_set_list *list,
+	__isl_keep isl_set *context);
+isl_bool isl_basic_set_list_is_subset_of_set(
+	__isl_keep isl_basic_set_list *list, __isl_keep isl_set *set);
 __isl_export
 isl_bool isl_set_is_singleton(__isl_keep isl_set *set);
 isl_bool isl_set_is_box(__isl_keep isl_set *set);
@@ -506,6 +528,8 @@ __isl_give isl_fixed_box *isl_set_get_simple_fixed_box_hull(
 
 __isl_export
 __isl_give isl_set *isl_set_coalesce(__isl_take isl_set *set);
+__isl_give isl_set *isl_set_union_coalesce(__isl_take isl_set *set1,
+	__isl_take isl_set *set2);
 
 int isl_set_plain_cmp(__isl_keep isl_set *set1, __isl_keep isl_set *set2);
 isl_bool isl_set_plain_is_equal(__isl_keep isl_set *set1,
@@ -520,12 +544,19 @@ isl_size isl_set_n_basic_set(__isl_keep isl_set *set);
 __isl_export
 isl_stat isl_set_foreach_basic_set(__isl_keep isl_set *set,
 	isl_stat (*fn)(__isl_take isl_basic_set *bset, void *user), void *user);
+__isl_export
+isl_bool isl_set_every_basic_set(__isl_keep isl_set *set,
+	isl_bool (*test)(__isl_keep isl_basic_set *bset, void *user),
+	void *user);
 __isl_give isl_basic_set_list *isl_set_get_basic_set_list(
 	__isl_keep isl_set *set);
 
 __isl_export
 isl_stat isl_set_foreach_point(__isl_keep isl_set *set,
 	isl_stat (*fn)(__isl_take isl_point *pnt, void *user), void *user);
+isl_stat isl_set_foreach_point_block(__isl_keep isl_set *set,
+	long *coords, int block_size,
+	isl_stat (*fn)(long *coords, int n, void *user), void *user);
 __isl_give isl_val *isl_set_count_val(__isl_keep isl_set *set);
 
 __isl_constructor
@@ -552,6 +583,8 @@ __isl_give isl_map *isl_set_lex_gt_set(__isl_take isl_set *set1,
 	__isl_take isl_set *set2);
 
 int isl_set_size(__isl_keep isl_set *set);
+double isl_basic_set_estimate_cost(__isl_keep isl_basic_set *bset);
+double isl_set_estimate_cost(__isl_keep isl_set *set);
 
 __isl_give isl_basic_set *isl_basic_set_align_params(
 	__isl_take isl_basic_set *bset, __isl_take isl_space *model);
@@ -571,6 +604,9 @@ __isl_give isl_basic_set *isl_basic_set_from_constraint_matrices(
 	__isl_take isl_space *space,
 	__isl_take isl_mat *eq, __isl_take isl_mat *ineq, enum isl_dim_type c1,
 	enum isl_dim_type c2, enum isl_dim_type c3, enum isl_dim_type c4);
+__isl_give isl_basic_set *isl_basic_set_from_int64_constraints(
+	__isl_take isl_space *space, unsigned n_exist,
+	unsigned n_eq, const int64_t *eq, unsigned n_ineq, const int64_t *ineq);
 
 __isl_give isl_basic_set *isl_basic_set_from_multi_aff(
 	__isl_take isl_multi_aff *ma);
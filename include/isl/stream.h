@@ -83,6 +83,8 @@ __isl_give isl_pw_qpolynomial *isl_stream_read_pw_qpolynomial(
 	__isl_keep isl_stream *s);
 __isl_give isl_union_set *isl_stream_read_union_set(__isl_keep isl_stream *s);
 __isl_give isl_union_map *isl_stream_read_union_map(__isl_keep isl_stream *s);
+isl_stat isl_stream_read_union_map_foreach(__isl_keep isl_stream *s,
+	isl_stat (*fn)(__isl_take isl_map *map, void *user), void *user);
 __isl_give isl_schedule *isl_stream_read_schedule(isl_stream *s);
 
 int isl_stream_yaml_read_start_mapping(__isl_keep isl_stream *s);
@@ -90,6 +92,7 @@ int isl_stream_yaml_read_end_mapping(__isl_keep isl_stream *s);
 int isl_stream_yaml_read_start_sequence(__isl_keep isl_stream *s);
 int isl_stream_yaml_read_end_sequence(__isl_keep isl_stream *s);
 int isl_stream_yaml_next(__isl_keep isl_stream *s);
+__isl_give char *isl_stream_yaml_read_str(__isl_keep isl_stream *s);
 
 #if defined(__cplusplus)
 }
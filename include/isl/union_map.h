@@ -8,6 +8,7 @@
 #include <isl/union_map_type.h>
 #include <isl/printer.h>
 #include <isl/val_type.h>
+#include <isl/fixed_box.h>
 
 #if defined(__cplusplus)
 extern "C" {
@@ -33,7 +34,11 @@ __isl_give isl_union_map *isl_union_map_empty_space(
 	__isl_take isl_space *space);
 __isl_give isl_union_map *isl_union_map_empty(__isl_take isl_space *space);
 __isl_give isl_union_map *isl_union_map_copy(__isl_keep isl_union_map *umap);
+__isl_give isl_union_map *isl_union_map_copy_to_ctx(
+	__isl_keep isl_union_map *umap, isl_ctx *ctx);
 __isl_null isl_union_map *isl_union_map_free(__isl_take isl_union_map *umap);
+__isl_give isl_union_map *isl_union_map_reserve(__isl_take isl_union_map *umap,
+	int n);
 
 isl_ctx *isl_union_map_get_ctx(__isl_keep isl_union_map *umap);
 __isl_export
@@ -81,6 +86,9 @@ __isl_give isl_union_map *isl_union_map_remove_redundancies(
 	__isl_take isl_union_map *umap);
 __isl_give isl_union_map *isl_union_map_simple_hull(
 	__isl_take isl_union_map *umap);
+__isl_give isl_fixed_box_list *
+isl_union_map_get_range_simple_fixed_box_hull_list(
+	__isl_keep isl_union_map *umap);
 __isl_export
 __isl_give isl_union_map *isl_union_map_coalesce(
 	__isl_take isl_union_map *umap);
@@ -200,6 +208,10 @@ __isl_give isl_union_map *isl_union_map_apply_domain(
 __isl_export
 __isl_give isl_union_map *isl_union_map_apply_range(
 	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2);
+__isl_give isl_union_set *isl_union_map_apply_range_domain(
+	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2);
+__isl_give isl_union_set *isl_union_map_apply_range_range(
+	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2);
 __isl_overload
 __isl_give isl_union_map *isl_union_map_preimage_domain_multi_aff(
 	__isl_take isl_union_map *umap, __isl_take isl_multi_aff *ma);
@@ -273,6 +285,8 @@ isl_bool isl_union_map_is_subset(__isl_keep isl_union_map *umap1,
 __isl_export
 isl_bool isl_union_map_is_equal(__isl_keep isl_union_map *umap1,
 	__isl_keep isl_union_map *umap2);
+isl_bool isl_union_map_plain_is_equal(__isl_keep isl_union_map *umap1,
+	__isl_keep isl_union_map *umap2);
 __isl_export
 isl_bool isl_union_map_is_disjoint(__isl_keep isl_union_map *umap1,
 	__isl_keep isl_union_map *umap2);
@@ -283,6 +297,7 @@ isl_bool isl_union_map_is_strict_subset(__isl_keep isl_union_map *umap1,
 uint32_t isl_union_map_get_hash(__isl_keep isl_union_map *umap);
 
 isl_size isl_union_map_n_map(__isl_keep isl_union_map *umap);
+double isl_union_map_estimate_cost(__isl_keep isl_union_map *umap);
 __isl_export
 isl_stat isl_union_map_foreach_map(__isl_keep isl_union_map *umap,
 	isl_stat (*fn)(__isl_take isl_map *map, void *user), void *user);
@@ -347,6 +362,12 @@ __isl_give isl_union_map *isl_union_map_read_from_file(isl_ctx *ctx,
 __isl_constructor
 __isl_give isl_union_map *isl_union_map_read_from_str(isl_ctx *ctx,
 	const char *str);
+__isl_give isl_union_map *isl_union_map_read_from_binary_file(isl_ctx *ctx,
+	FILE *input);
+__isl_give isl_union_map *isl_union_map_read_from_binary_str(isl_ctx *ctx,
+	const char *str);
+__isl_give isl_union_map *isl_union_map_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos);
 __isl_give char *isl_union_map_to_str(__isl_keep isl_union_map *umap);
 __isl_give isl_printer *isl_printer_print_union_map(__isl_take isl_printer *p,
 	__isl_keep isl_union_map *umap);
@@ -24,7 +24,11 @@ __isl_give isl_union_set *isl_union_set_empty_space(
 	__isl_take isl_space *space);
 __isl_give isl_union_set *isl_union_set_empty(__isl_take isl_space *space);
 __isl_give isl_union_set *isl_union_set_copy(__isl_keep isl_union_set *uset);
+__isl_give isl_union_set *isl_union_set_copy_to_ctx(
+	__isl_keep isl_union_set *uset, isl_ctx *ctx);
 __isl_null isl_union_set *isl_union_set_free(__isl_take isl_union_set *uset);
+__isl_give isl_union_set *isl_union_set_reserve(__isl_take isl_union_set *uset,
+	int n);
 
 isl_ctx *isl_union_set_get_ctx(__isl_keep isl_union_set *uset);
 __isl_export
@@ -127,6 +131,7 @@ isl_bool isl_union_set_is_strict_subset(__isl_keep isl_union_set *uset1,
 uint32_t isl_union_set_get_hash(__isl_keep isl_union_set *uset);
 
 isl_size isl_union_set_n_set(__isl_keep isl_union_set *uset);
+double isl_union_set_estimate_cost(__isl_keep isl_union_set *uset);
 __isl_export
 isl_stat isl_union_set_foreach_set(__isl_keep isl_union_set *uset,
 	isl_stat (*fn)(__isl_take isl_set *set, void *user), void *user);
@@ -181,6 +186,12 @@ __isl_give isl_union_set *isl_union_set_read_from_file(isl_ctx *ctx,
 __isl_constructor
 __isl_give isl_union_set *isl_union_set_read_from_str(isl_ctx *ctx,
 	const char *str);
+__isl_give isl_union_set *isl_union_set_read_from_binary_file(isl_ctx *ctx,
+	FILE *input);
+__isl_give isl_union_set *isl_union_set_read_from_binary_str(isl_ctx *ctx,
+	const char *str);
+__isl_give isl_union_set *isl_union_set_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos);
 __isl_give char *isl_union_set_to_str(__isl_keep isl_union_set *uset);
 __isl_give isl_printer *isl_printer_print_union_set(__isl_take isl_printer *p,
 	__isl_keep isl_union_set *uset);
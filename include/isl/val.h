@@ -22,6 +22,9 @@ ISL_DECLARE_MULTI_DIM_ID(val)
 ISL_DECLARE_MULTI_TUPLE_ID(val)
 ISL_DECLARE_MULTI_WITH_DOMAIN(val)
 
+__isl_give isl_multi_val *isl_multi_val_copy_to_ctx(
+	__isl_keep isl_multi_val *mv, isl_ctx *ctx);
+
 __isl_export
 __isl_give isl_val *isl_val_zero(isl_ctx *ctx);
 __isl_export
@@ -41,6 +44,7 @@ __isl_give isl_val *isl_val_int_from_chunks(isl_ctx *ctx, size_t n,
 	size_t size, const void *chunks);
 
 __isl_give isl_val *isl_val_copy(__isl_keep isl_val *v);
+__isl_give isl_val *isl_val_copy_to_ctx(__isl_keep isl_val *v, isl_ctx *ctx);
 __isl_null isl_val *isl_val_free(__isl_take isl_val *v);
 
 isl_ctx *isl_val_get_ctx(__isl_keep isl_val *val);
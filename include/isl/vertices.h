@@ -25,6 +25,8 @@ __isl_null isl_vertex *isl_vertex_free(__isl_take isl_vertex *vertex);
 
 __isl_give isl_vertices *isl_basic_set_compute_vertices(
 	__isl_keep isl_basic_set *bset);
+__isl_give isl_vertices *isl_vertices_intersect_params(
+	__isl_take isl_vertices *vertices, __isl_take isl_basic_set *context);
 isl_ctx *isl_vertices_get_ctx(__isl_keep isl_vertices *vertices);
 isl_size isl_vertices_get_n_vertices(__isl_keep isl_vertices *vertices);
 isl_stat isl_vertices_foreach_vertex(__isl_keep isl_vertices *vertices,
@@ -492,6 +492,9 @@ void cpp_generator::class_printer::print_method_group(
  * will already be copies of the actual parameters.  It is consequently possible
  * to directly take the pointer from these values, which saves
  * an unnecessary copy.
+ * The exception is a method with an "rvalue" reference qualifier,
+ * where "this" refers to an object that is about to be destroyed and
+ * whose pointer can therefore also be taken directly.
  *
  * In case the parameter is a callback function, two parameters get printed,
  * a wrapper for the callback function and a pointer to the actual
@@ -501,7 +504,8 @@ void cpp_generator::class_printer::print_method_group(
  * in a structure called <name>_data.
  * The caller of this function must ensure that these variables exist.
  */
-void Method::print_param_use(ostream &os, int pos) const
+void Method::print_param_use(ostream &os, int pos,
+	RefQualifier qualifier) const
 {
 	ParmVarDecl *param = fd->getParamDecl(pos);
 	bool load_from_this_ptr = pos == 0 && kind == member_method;
@@ -530,13 +534,25 @@ void Method::print_param_use(ostream &os, int pos) const
 	if (generator::keeps(param)) {
 		os << "get()";
 	} else {
-		if (load_from_this_ptr)
+		if (load_from_this_ptr && qualifier != rvalue)
 			os << "copy()";
 		else
 			os << "release()";
 	}
 }
 
+/* Does this method take ownership of the isl object
+ * corresponding to "this"?
+ * That is, is it a member method with an isl function
+ * that does not keep its first argument?
+ */
+bool Method::takes_this() const
+{
+	if (kind != member_method)
+		return false;
+	return !generator::keeps(fd->getParamDecl(0));
+}
+
 /* Does the isl function from which this method is derived
  * modify an object of a subclass based on a type function?
  */
@@ -612,13 +628,19 @@ ParmVarDecl *cpp_generator::class_printer::get_param(FunctionDecl *fd,
  * for these constructors, whereas without a comment not every user would
  * know that implicit construction is allowed in absence of an explicit keyword.
  *
+ * Member methods are marked const, with the reference qualifier
+ * specified by "qualifier", if any.
+ * An "rvalue" method is not marked const since it takes the pointer
+ * of the object on which it is called.
+ *
  * Note that in case "method" is a ConversionMethod, the argument returned
  * by Method::get_param may be different from the original argument.
  * The name of the argument is, however, derived from the original
  * function argument.
  */
 void cpp_generator::class_printer::print_method_header(
-	const Method &method, const cpp_type_printer &type_printer)
+	const Method &method, const cpp_type_printer &type_printer,
+	Method::RefQualifier qualifier)
 {
 	string rettype_str = type_printer.return_type(method);
 
@@ -661,7 +683,13 @@ void cpp_generator::class_printer::print_method_header(
 			os << cpptype << " " << name;
 	});
 
-	if (method.kind == Method::Kind::member_method)
+	if (method.kind != Method::Kind::member_method)
+		return;
+	if (qualifier == Method::rvalue)
+		os << " &&";
+	else if (qualifier == Method::lvalue)
+		os << " const &";
+	else
 		os << " const";
 }
 
@@ -1280,12 +1308,13 @@ EnumMethod::EnumMethod(const isl_class &clazz, FunctionDecl *fd,
  * then it corresponds to the enum value corresponding to this EnumMethod.
  * Otherwise, delegate to Method::print_param_use.
  */
-void EnumMethod::print_param_use(ostream &os, int pos) const
+void EnumMethod::print_param_use(ostream &os, int pos,
+	RefQualifier qualifier) const
 {
 	if (pos == num_params())
 		os << enum_name;
 	else
-		Method::print_param_use(os, pos);
+		Method::print_param_use(os, pos, qualifier);
 }
 
 /* Return the number of parameters of the method
@@ -15,6 +15,13 @@
  * from the default name derived from "fd".
  * "kind" is the type of the method.
  * "callbacks" stores the callback arguments.
+ *
+ * A member method may be printed with a reference qualifier
+ * on the implicit "this" argument.
+ * "plain" means no reference qualifier, while "lvalue" and "rvalue"
+ * correspond to the "const &" and "&&" qualifiers.
+ * In the "rvalue" case, "this" is passed to the isl function
+ * by releasing the underlying object rather than by copying it.
  */
 struct Method {
 	enum Kind {
@@ -22,6 +29,11 @@ struct Method {
 		member_method,
 		constructor,
 	};
+	enum RefQualifier {
+		plain,
+		lvalue,
+		rvalue,
+	};
 
 	struct list_combiner;
 	static list_combiner print_combiner(std::ostream &os);
@@ -35,7 +47,9 @@ struct Method {
 	virtual int num_params() const;
 	virtual bool param_needs_copy(int pos) const;
 	virtual clang::ParmVarDecl *get_param(int pos) const;
-	virtual void print_param_use(ostream &os, int pos) const;
+	virtual void print_param_use(ostream &os, int pos,
+		RefQualifier qualifier = plain) const;
+	bool takes_this() const;
 	bool is_subclass_mutator() const;
 	static void on_arg_list(int start, int end,
 		const list_combiner &combiner,
@@ -118,7 +132,8 @@ struct EnumMethod : public Method {
 		const std::string &method_name, const std::string &enum_name);
 
 	virtual int num_params() const override;
-	virtual void print_param_use(ostream &os, int pos) const override;
+	virtual void print_param_use(ostream &os, int pos,
+		RefQualifier qualifier = plain) const override;
 
 	std::string enum_name;
 };
@@ -206,7 +221,8 @@ struct cpp_generator::class_printer {
 	ParmVarDecl *get_param(FunctionDecl *fd, int pos,
 		const std::vector<bool> &convert);
 	void print_method_header(const Method &method,
-		const cpp_type_printer &type_printer);
+		const cpp_type_printer &type_printer,
+		Method::RefQualifier qualifier = Method::plain);
 };
 
 #endif
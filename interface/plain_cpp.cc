@@ -363,11 +363,19 @@ void plain_cpp_generator::decl_printer::print_method(
 	print_full_method_header(method);
 }
 
+/* Print a declaration for "method" with reference qualifier "qualifier".
+ */
+void plain_cpp_generator::decl_printer::print_qualified_method(
+	const Method &method, Method::RefQualifier qualifier)
+{
+	print_full_method_header(method, qualifier);
+}
+
 /* Print declarations for "method".
  */
 void plain_cpp_generator::decl_printer::print_method(const Method &method)
 {
-	print_full_method_header(method);
+	print_ref_qualified_methods(method);
 }
 
 /* Print a declaration for a constructor for the "id" class
@@ -387,6 +395,15 @@ void plain_cpp_generator::decl_printer::print_id_user(bool optional)
 	print_id_user_header(optional);
 }
 
+/* Print a declaration for the method "name" of a list class
+ * returning an iterator over the elements of the list.
+ */
+void plain_cpp_generator::decl_printer::print_list_range(
+	const std::string &name)
+{
+	print_list_range_header(name);
+}
+
 /* Print declarations of copy assignment operator.
  *
  * Each class has one assignment operator.
@@ -639,7 +656,7 @@ void plain_cpp_generator::decl_printer::print_persistent_callbacks()
 
 	osprintf(os, "public:\n");
 	for (const auto &callback : clazz.persistent_callbacks)
-		print_method(Method(clazz, callback));
+		print_full_method_header(Method(clazz, callback));
 }
 
 /* Print a declaration for the "get" method "fd",
@@ -901,7 +918,8 @@ void plain_cpp_generator::impl_printer::print_public_constructors()
 }
 
 /* Print definition for "method",
- * without any automatic type conversions.
+ * without any automatic type conversions,
+ * with reference qualifier "qualifier".
  *
  * This method distinguishes three kinds of methods: member methods, static
  * methods, and constructors.
@@ -920,14 +938,18 @@ void plain_cpp_generator::impl_printer::print_public_constructors()
  * during the isl function call, an exception is thrown.
  * During the function call, isl is made not to print any error message
  * because the error message is included in the exception.
+ * Note that the isl::ctx is saved before the call because,
+ * in case of an "rvalue" reference qualifier,
+ * the pointer of "this" is released by the call.
  */
-void plain_cpp_generator::impl_printer::print_method(const Method &method)
+void plain_cpp_generator::impl_printer::print_qualified_method(
+	const Method &method, Method::RefQualifier qualifier)
 {
 	string methodname = method.fd->getName().str();
 	int num_params = method.c_num_params();
 
 	osprintf(os, "\n");
-	print_full_method_header(method);
+	print_full_method_header(method, qualifier);
 	osprintf(os, "{\n");
 	print_argument_validity_check(method);
 	print_save_ctx(method);
@@ -939,7 +961,7 @@ void plain_cpp_generator::impl_printer::print_method(const Method &method)
 	osprintf(os, "  auto res = %s", methodname.c_str());
 
 	method.print_fd_arg_list(os, 0, num_params, [&] (int i, int arg) {
-		method.print_param_use(os, i);
+		method.print_param_use(os, i, qualifier);
 	});
 	osprintf(os, ";\n");
 
@@ -953,6 +975,14 @@ void plain_cpp_generator::impl_printer::print_method(const Method &method)
 	osprintf(os, "}\n");
 }
 
+/* Print definitions for "method",
+ * without any automatic type conversions.
+ */
+void plain_cpp_generator::impl_printer::print_method(const Method &method)
+{
+	print_ref_qualified_methods(method);
+}
+
 /* Convert argument of type "src" to "dst", with a name specified by "dst".
  *
  * If "src" is the same as "dst", then no argument conversion is needed.
@@ -1091,6 +1121,33 @@ void plain_cpp_generator::impl_printer::print_id_user(bool optional)
 	os << "}\n";
 }
 
+/* Print a definition for the method "name" of a list class
+ * returning an iterator over the elements of the list.
+ *
+ * The "begin" iterator refers to the first element, while
+ * the "end" iterator refers to the position beyond the last element.
+ * The number of elements is obtained directly from the isl_*_list.
+ * In the checked C++ bindings, an invalid list is treated
+ * as an empty list.
+ */
+void plain_cpp_generator::impl_printer::print_list_range(
+	const std::string &name)
+{
+	string type = list_iterator_type();
+
+	os << "\n";
+	print_list_range_header(name);
+	os << "{\n";
+	if (name == "begin") {
+		os << "  return " << type << "(*this, 0);\n";
+	} else {
+		print_check_ptr("ptr");
+		os << "  auto n = " << clazz.name << "_size(ptr);\n";
+		os << "  return " << type << "(*this, n < 0 ? 0 : n);\n";
+	}
+	os << "}\n";
+}
+
 /* Print implementation of copy assignment operator.
  *
  * If the class has any persistent callbacks, then copy them
@@ -1620,17 +1677,43 @@ void plain_cpp_generator::impl_printer::print_method_return(
 	}
 }
 
+/* Print declarations or definitions for "method".
+ *
+ * If "method" takes ownership of the isl object corresponding to "this",
+ * then print two versions, one for lvalues, which passes a copy
+ * of the object to the isl function, and one for rvalues,
+ * which passes the object itself.
+ * The rvalue version avoids a copy/free round trip
+ * on temporary objects, e.g., in chained calls such as
+ *
+ *	s.intersect(t).coalesce()
+ *
+ * and allows the isl function to modify the object in place.
+ * Otherwise, print a single version without reference qualifier.
+ */
+void plain_cpp_generator::plain_printer::print_ref_qualified_methods(
+	const Method &method)
+{
+	if (!method.takes_this())
+		return print_qualified_method(method, Method::plain);
+
+	print_qualified_method(method, Method::lvalue);
+	print_qualified_method(method, Method::rvalue);
+}
+
 /* Print the header for "method", including the terminating semicolon
  * in case of a declaration and a newline.
+ * "qualifier" is the reference qualifier of the implicit "this" argument
+ * in case "method" is a member method.
  *
  * Use the appropriate type printer to print argument and return types.
  */
 void plain_cpp_generator::plain_printer::print_full_method_header(
-	const Method &method)
+	const Method &method, Method::RefQualifier qualifier)
 {
 	auto type_printer = generator.type_printer();
 
-	print_method_header(method, *type_printer);
+	print_method_header(method, *type_printer, qualifier);
 
 	if (declarations)
 		osprintf(os, ";");
@@ -1867,15 +1950,70 @@ void plain_cpp_generator::plain_printer::print_special_id()
 	});
 }
 
+/* Return the C++ type of an iterator over the elements
+ * of the list class that is being printed.
+ * The element type is obtained by dropping the "_list" suffix
+ * from the name of the list class.
+ */
+std::string plain_cpp_generator::plain_printer::list_iterator_type()
+{
+	string el = clazz.name.substr(0, clazz.name.length() - 5);
+
+	return "list_iterator<" + cppstring + ", " + type2cpp(el) + ">";
+}
+
+/* Print the header of the method "name" of a list class
+ * returning an iterator over the elements of the list.
+ */
+void plain_cpp_generator::plain_printer::print_list_range_header(
+	const std::string &name)
+{
+	if (declarations)
+		os << "  inline ";
+	os << list_iterator_type() << " ";
+	if (!declarations)
+		os << cppstring << "::";
+	os << name << "() const";
+	if (declarations)
+		os << ";";
+	os << "\n";
+}
+
+/* Print declarations or definitions of the special methods
+ * of a list class that are not automatically derived from the C interface.
+ *
+ * In particular, print "begin" and "end" methods
+ * such that the elements of the list can be traversed
+ * in a range-based for loop.
+ */
+void plain_cpp_generator::plain_printer::print_special_list()
+{
+	os << "\n";
+	print_list_range("begin");
+	print_list_range("end");
+}
+
+/* Does "name" have a "_list" suffix?
+ */
+static bool is_list_name(const std::string &name)
+{
+	size_t len = name.length();
+
+	return len > 5 && name.compare(len - 5, 5, "_list") == 0;
+}
+
 /* Print declarations or definitions of any special methods of this class
  * not automatically derived from the C interface.
  *
- * In particular, print special methods for the "id" class.
+ * In particular, print special methods for the "id" class and
+ * for list classes.
  */
 void plain_cpp_generator::plain_printer::print_special()
 {
 	if (clazz.name == "isl_id")
 		print_special_id();
+	if (is_list_name(clazz.name))
+		print_special_list();
 }
 
 /* Print declarations or definitions of the public methods.
@@ -77,7 +77,8 @@ struct plain_cpp_generator::plain_printer : public cpp_generator::class_printer
 
 	void print_persistent_callback_prototype(FunctionDecl *method);
 	void print_persistent_callback_setter_prototype(FunctionDecl *method);
-	void print_full_method_header(const Method &method);
+	void print_full_method_header(const Method &method,
+		Method::RefQualifier qualifier = Method::plain);
 	void print_callback_data_decl(ParmVarDecl *param, const string &name);
 	virtual bool want_descendent_overloads(const function_set &methods)
 		override;
@@ -89,12 +90,19 @@ struct plain_cpp_generator::plain_printer : public cpp_generator::class_printer
 	virtual void print_ctx() = 0;
 	virtual void print_method_separator() = 0;
 	virtual void print_persistent_callbacks() = 0;
+	virtual void print_qualified_method(const Method &method,
+		Method::RefQualifier qualifier) = 0;
+	void print_ref_qualified_methods(const Method &method);
 	void print_public_methods();
 	void print_id_constructor_user_header();
 	void print_id_user_header(bool optional);
 	virtual void print_id_constructor_user() = 0;
 	virtual void print_id_user(bool optional) = 0;
 	void print_special_id();
+	std::string list_iterator_type();
+	void print_list_range_header(const std::string &name);
+	virtual void print_list_range(const std::string &name) = 0;
+	void print_special_list();
 	void print_special();
 };
 
@@ -120,11 +128,14 @@ struct plain_cpp_generator::decl_printer :
 	virtual void print_method_separator() override;
 	void print_persistent_callback_data(FunctionDecl *method);
 	virtual void print_persistent_callbacks() override;
+	virtual void print_qualified_method(const Method &method,
+		Method::RefQualifier qualifier) override;
 	virtual void print_method(const Method &method) override;
 	virtual void print_method(const ConversionMethod &method) override;
 	virtual void print_get_method(FunctionDecl *fd) override;
 	virtual void print_id_constructor_user() override;
 	virtual void print_id_user(bool optional) override;
+	virtual void print_list_range(const std::string &name) override;
 };
 
 /* A helper class for printing method definitions of a class.
@@ -137,6 +148,8 @@ struct plain_cpp_generator::impl_printer :
 		plain_printer(os, clazz, generator, false) {}
 
 	void print_arg_conversion(ParmVarDecl *dst, ParmVarDecl *src);
+	virtual void print_qualified_method(const Method &method,
+		Method::RefQualifier qualifier) override;
 	virtual void print_method(const Method &method) override;
 	virtual void print_method(const ConversionMethod &method) override;
 	virtual void print_get_method(FunctionDecl *fd) override;
@@ -169,6 +182,7 @@ struct plain_cpp_generator::impl_printer :
 	void print_callback_local(ParmVarDecl *param);
 	virtual void print_id_constructor_user() override;
 	virtual void print_id_user(bool optional) override;
+	virtual void print_list_range(const std::string &name) override;
 };
 
 #endif
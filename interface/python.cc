@@ -822,17 +822,97 @@ static const char *const id_user = &R"(
         return isl.isl_id_get_user(self.ptr)
 )"[1];
 
+/* The definitions of "basic_set" methods for extracting
+ * all constraints of a basic set and for constructing a basic set
+ * from its constraints, without the initial newline.
+ *
+ * The constraints are transferred in bulk through an isl_mat,
+ * with the coefficients of the parameters, the set variables and
+ * the existentially quantified variables, followed by the constant term
+ * in each row.  See mat_to_array and mat_from_array in isl.py.top.
+ */
+static const char *const basic_set_constraint_matrix = &R"(
+    def constraint_matrix(self):
+        arg0 = self
+        if not arg0.__class__ is basic_set:
+            arg0 = basic_set(arg0)
+        eq = isl.isl_basic_set_equalities_matrix(arg0.ptr,
+            isl_dim_param, isl_dim_set, isl_dim_div, isl_dim_cst)
+        ineq = isl.isl_basic_set_inequalities_matrix(arg0.ptr,
+            isl_dim_param, isl_dim_set, isl_dim_div, isl_dim_cst)
+        return (mat_to_array(eq), mat_to_array(ineq))
+    @staticmethod
+    def from_constraint_matrix(space, eq, ineq):
+        ctx = space.ctx
+        n_col = isl.isl_space_dim(space.ptr, isl_dim_all)
+        if n_col < 0:
+            raise Error
+        eq = mat_from_array(ctx, eq, 1 + n_col)
+        ineq = mat_from_array(ctx, ineq, 1 + n_col)
+        res = isl.isl_basic_set_from_constraint_matrices(
+            isl.isl_space_copy(space.ptr), eq, ineq,
+            isl_dim_param, isl_dim_set, isl_dim_div, isl_dim_cst)
+        if not res:
+            raise Error
+        return basic_set(ctx=ctx, ptr=res)
+)"[1];
+
+/* The definition of a "set" method for enumerating
+ * all integer points of a bounded set, without the initial newline.
+ *
+ * The points are collected in blocks by isl_set_foreach_point_block
+ * such that only a single Python callback is performed per block.
+ * Each row of the result contains the values of the parameters
+ * followed by the values of the set variables of a point.
+ */
+static const char *const set_points_array = &R"(
+    def points_array(self):
+        arg0 = self
+        if not arg0.__class__ is set:
+            arg0 = set(arg0)
+        dim = isl.isl_set_dim(arg0.ptr, isl_dim_all)
+        if dim < 0:
+            raise Error
+        block_size = 1024
+        coords = (c_long * (block_size * max(dim, 1)))()
+        blocks = []
+        n_point = [0]
+        exc_info = [None]
+        def cb_func(cb_coords, n, cb_user):
+            try:
+                blocks.append(string_at(cb_coords,
+                    n * dim * sizeof(c_long)))
+                n_point[0] += n
+            except BaseException as e:
+                exc_info[0] = e
+                return -1
+            return 0
+        cb = point_block_fn(cb_func)
+        res = isl.isl_set_foreach_point_block(arg0.ptr, coords,
+            block_size, cb, None)
+        if exc_info[0] is not None:
+            raise exc_info[0]
+        if res < 0:
+            raise Error
+        data = b''.join(blocks)
+        buf = (c_long * (n_point[0] * dim)).from_buffer_copy(data)
+        return array_from_buffer(buf, n_point[0], dim)
+)"[1];
+
 /* Print any special methods of this class that are not
  * automatically derived from the C interface.
  *
- * In particular, print a special method for the "id" class.
+ * In particular, print a special method for the "id" class and
+ * the bulk conversion methods for the "basic_set" and "set" classes.
  */
 void python_generator::print_special_methods(const isl_class &clazz)
 {
-	if (clazz.name != "isl_id")
-		return;
-
-	printf("%s", id_user);
+	if (clazz.name == "isl_id")
+		printf("%s", id_user);
+	else if (clazz.name == "isl_basic_set")
+		printf("%s", basic_set_constraint_matrix);
+	else if (clazz.name == "isl_set")
+		printf("%s", set_points_array);
 }
 
 /* If "clazz" has a type function describing subclasses,
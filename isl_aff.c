@@ -18,6 +18,7 @@
  * and Cerebras Systems, 175 S San Antonio Rd, Los Altos, CA, USA
  */
 
+#include <limits.h>
 #include <isl_ctx_private.h>
 #include <isl_map_private.h>
 #include <isl_union_map_private.h>
@@ -32,8 +33,12 @@
 #include <isl/set.h>
 #include <isl_val_private.h>
 #include <isl_point_private.h>
+#include <isl_gist_context_private.h>
 #include <isl_config.h>
 
+#include <bset_from_bmap.c>
+#include <set_from_map.c>
+
 #undef EL_BASE
 #define EL_BASE aff
 
@@ -158,6 +163,22 @@ __isl_give isl_aff *isl_aff_dup(__isl_keep isl_aff *aff)
 					    isl_vec_copy(aff->v));
 }
 
+/* Return a copy of "aff" in "ctx".
+ * Unless "aff" already belongs to "ctx", "aff" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_aff *isl_aff_copy_to_ctx(__isl_keep isl_aff *aff, isl_ctx *ctx)
+{
+	if (!aff)
+		return NULL;
+	if (isl_aff_get_ctx(aff) == ctx)
+		return isl_aff_copy(aff);
+
+	return isl_aff_alloc_vec_validated(
+				isl_local_space_copy_to_ctx(aff->ls, ctx),
+				isl_vec_copy_to_ctx(aff->v, ctx));
+}
+
 __isl_give isl_aff *isl_aff_cow(__isl_take isl_aff *aff)
 {
 	if (!aff)
@@ -1927,6 +1948,10 @@ static __isl_give isl_aff *set_nan_free(__isl_take isl_aff *aff1,
 /* Return the sum of "aff1" and "aff2".
  *
  * If either of the two is NaN, then the result is NaN.
+ *
+ * If the two expressions live in the same local space
+ * (typically because they share the same isl_local_space object),
+ * then there is no need to merge the divs.
  */
 __isl_give isl_aff *isl_aff_add(__isl_take isl_aff *aff1,
 	__isl_take isl_aff *aff2)
@@ -1960,6 +1985,15 @@ __isl_give isl_aff *isl_aff_add(__isl_take isl_aff *aff1,
 		goto error;
 	if (n_div1 == 0 && n_div2 == 0)
 		return add_expanded(aff1, aff2);
+	if (n_div1 == n_div2) {
+		isl_bool equal;
+
+		equal = isl_local_space_is_equal(aff1->ls, aff2->ls);
+		if (equal < 0)
+			goto error;
+		if (equal)
+			return add_expanded(aff1, aff2);
+	}
 
 	exp1 = isl_alloc_array(ctx, int, n_div1);
 	exp2 = isl_alloc_array(ctx, int, n_div2);
@@ -2290,6 +2324,39 @@ __isl_give isl_aff *isl_aff_gist(__isl_take isl_aff *aff,
 	return isl_aff_substitute_equalities_lifted(aff, hull);
 }
 
+/* Simplify "aff" with respect to the context represented by "context"
+ * as in isl_aff_gist.
+ * If "aff" does not involve any integer divisions,
+ * then lifting the context to the local space of "aff" has no effect,
+ * so that the affine hull of the context does not depend on "aff".
+ * In this case, use the affine hull that is cached in "context".
+ * Otherwise, or if the spaces do not match exactly,
+ * simply call isl_aff_gist.
+ */
+__isl_give isl_aff *isl_aff_gist_prepared(__isl_take isl_aff *aff,
+	__isl_keep isl_gist_context *context)
+{
+	isl_size n_div;
+	isl_bool equal;
+	isl_basic_map *hull;
+
+	if (!aff || !context)
+		return isl_aff_free(aff);
+	n_div = isl_aff_domain_dim(aff, isl_dim_div);
+	if (n_div < 0)
+		return isl_aff_free(aff);
+	equal = isl_space_is_equal(isl_aff_peek_domain_space(aff),
+				    isl_map_peek_space(context->map));
+	if (equal < 0)
+		return isl_aff_free(aff);
+	if (n_div > 0 || !equal)
+		return isl_aff_gist(aff,
+				set_from_map(isl_map_copy(context->map)));
+
+	hull = isl_gist_context_get_affine_hull(context);
+	return isl_aff_substitute_equalities_lifted(aff, bset_from_bmap(hull));
+}
+
 __isl_give isl_aff *isl_aff_gist_params(__isl_take isl_aff *aff,
 	__isl_take isl_set *context)
 {
@@ -2839,6 +2906,88 @@ static __isl_give isl_aff *isl_aff_zero_in_space(__isl_take isl_space *space)
 #include <isl_pw_sub_templ.c>
 #include <isl_pw_union_opt.c>
 
+/* Return a copy of "pa" in "ctx".
+ * Unless "pa" already belongs to "ctx", "pa" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_pw_aff *isl_pw_aff_copy_to_ctx(__isl_keep isl_pw_aff *pa,
+	isl_ctx *ctx)
+{
+	int i;
+	isl_space *space;
+	isl_pw_aff *dup;
+
+	if (!pa)
+		return NULL;
+	if (isl_pw_aff_get_ctx(pa) == ctx)
+		return isl_pw_aff_copy(pa);
+
+	space = isl_space_copy_to_ctx(isl_pw_aff_peek_space(pa), ctx);
+	dup = isl_pw_aff_alloc_size(space, pa->n);
+	for (i = 0; i < pa->n; ++i) {
+		isl_set *set;
+		isl_aff *aff;
+
+		set = isl_set_copy_to_ctx(pa->p[i].set, ctx);
+		aff = isl_aff_copy_to_ctx(pa->p[i].aff, ctx);
+		dup = isl_pw_aff_add_piece(dup, set, aff);
+	}
+	return dup;
+}
+
+/* Simplify "pa" with respect to the context represented by "context"
+ * as in isl_pw_aff_gist, reusing the preprocessing of the context.
+ *
+ * If "pa" consists of a single piece with a universe domain,
+ * then the domain is not affected and the function value
+ * only needs to be simplified with respect to the context itself.
+ * Avoid the intersection with the context in this common case.
+ * If the context is the universe or if it is (obviously) empty,
+ * then fall back to the general case to obtain the same result
+ * as isl_pw_aff_gist.
+ */
+__isl_give isl_pw_aff *isl_pw_aff_gist_prepared(__isl_take isl_pw_aff *pa,
+	__isl_keep isl_gist_context *context)
+{
+	isl_bool equal;
+	isl_set *set;
+	isl_basic_set *hull;
+
+	if (!pa || !context)
+		return isl_pw_aff_free(pa);
+	set = set_from_map(isl_map_copy(context->map));
+	equal = isl_space_has_equal_params(isl_pw_aff_peek_space(pa),
+					    isl_set_peek_space(set));
+	if (equal < 0)
+		goto error;
+	if (!equal)
+		return isl_pw_aff_gist(pa, set);
+
+	if (pa->n == 1 && !context->universe) {
+		isl_bool universe, empty;
+		isl_aff *aff;
+
+		universe = isl_set_plain_is_universe(pa->p[0].set);
+		empty = isl_set_plain_is_empty(set);
+		if (universe < 0 || empty < 0)
+			goto error;
+		if (universe && !empty) {
+			isl_set_free(set);
+			aff = isl_pw_aff_take_base_at(pa, 0);
+			aff = isl_aff_gist_prepared(aff, context);
+			return isl_pw_aff_restore_base_at(pa, 0, aff);
+		}
+	}
+
+	hull = bset_from_bmap(isl_basic_map_copy(context->hull));
+	return isl_pw_aff_gist_fn_hull(pa, set, hull, &isl_aff_gist,
+					&isl_set_gist_basic_set);
+error:
+	isl_set_free(set);
+	isl_pw_aff_free(pa);
+	return NULL;
+}
+
 #undef BASE
 #define BASE pw_aff
 
@@ -2850,6 +2999,53 @@ static __isl_give isl_aff *isl_aff_zero_in_space(__isl_take isl_space *space)
 
 #include <isl_union_pw_templ.c>
 
+/* Internal data structure for isl_union_pw_aff_copy_to_ctx.
+ * "ctx" is the context to which the parts are copied and
+ * "res" collects the copies.
+ */
+struct isl_union_pw_aff_copy_to_ctx_data {
+	isl_ctx *ctx;
+	isl_union_pw_aff *res;
+};
+
+/* Add a copy of the isl_pw_aff that "entry" points to in data->ctx
+ * to data->res.
+ */
+static isl_stat copy_pw_aff_to_ctx(void **entry, void *user)
+{
+	struct isl_union_pw_aff_copy_to_ctx_data *data = user;
+	isl_pw_aff *pa = *entry;
+
+	data->res = isl_union_pw_aff_add_pw_aff(data->res,
+					isl_pw_aff_copy_to_ctx(pa, data->ctx));
+
+	return data->res ? isl_stat_ok : isl_stat_error;
+}
+
+/* Return a copy of "upa" in "ctx".
+ * Unless "upa" already belongs to "ctx", "upa" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_union_pw_aff *isl_union_pw_aff_copy_to_ctx(
+	__isl_keep isl_union_pw_aff *upa, isl_ctx *ctx)
+{
+	struct isl_union_pw_aff_copy_to_ctx_data data = { ctx };
+	isl_space *space;
+
+	if (!upa)
+		return NULL;
+	if (isl_union_pw_aff_get_ctx(upa) == ctx)
+		return isl_union_pw_aff_copy(upa);
+
+	space = isl_space_copy_to_ctx(isl_union_pw_aff_peek_space(upa), ctx);
+	data.res = isl_union_pw_aff_empty(space);
+	if (isl_union_pw_aff_foreach_inplace(upa,
+					&copy_pw_aff_to_ctx, &data) < 0)
+		data.res = isl_union_pw_aff_free(data.res);
+
+	return data.res;
+}
+
 /* Compute a piecewise quasi-affine expression with a domain that
  * is the union of those of pwaff1 and pwaff2 and such that on each
  * cell, the quasi-affine expression is the maximum of those of pwaff1
@@ -3025,7 +3221,7 @@ __isl_give isl_set *isl_pw_aff_bind_id(__isl_take isl_pw_aff *pa,
 	return bound;
 }
 
-/* Return a set containing those elements in the shared domain
+/* Return a set containing those elements in the shared domain "set1"
  * of pwaff1 and pwaff2 where pwaff1 is greater than (or equal) to pwaff2.
  *
  * We compute the difference on the shared domain and then construct
@@ -3034,14 +3230,10 @@ __isl_give isl_set *isl_pw_aff_bind_id(__isl_take isl_pw_aff *pa,
  * If equal is set, we only return the elements where pwaff1 and pwaff2
  * are equal.
  */
-static __isl_give isl_set *pw_aff_gte_set(__isl_take isl_pw_aff *pwaff1,
-	__isl_take isl_pw_aff *pwaff2, int strict, int equal)
+static __isl_give isl_set *pw_aff_gte_set_on_domain(
+	__isl_take isl_pw_aff *pwaff1, __isl_take isl_pw_aff *pwaff2,
+	__isl_take isl_set *set1, int strict, int equal)
 {
-	isl_set *set1, *set2;
-
-	set1 = isl_pw_aff_domain(isl_pw_aff_copy(pwaff1));
-	set2 = isl_pw_aff_domain(isl_pw_aff_copy(pwaff2));
-	set1 = isl_set_intersect(set1, set2);
 	pwaff1 = isl_pw_aff_intersect_domain(pwaff1, isl_set_copy(set1));
 	pwaff2 = isl_pw_aff_intersect_domain(pwaff2, isl_set_copy(set1));
 	pwaff1 = isl_pw_aff_add(pwaff1, isl_pw_aff_neg(pwaff2));
@@ -3060,6 +3252,21 @@ static __isl_give isl_set *pw_aff_gte_set(__isl_take isl_pw_aff *pwaff1,
 	return isl_pw_aff_nonneg_set(pwaff1);
 }
 
+/* Return a set containing those elements in the shared domain
+ * of pwaff1 and pwaff2 where pwaff1 is greater than (or equal) to pwaff2,
+ * as in pw_aff_gte_set_on_domain, computing the shared domain first.
+ */
+static __isl_give isl_set *pw_aff_gte_set(__isl_take isl_pw_aff *pwaff1,
+	__isl_take isl_pw_aff *pwaff2, int strict, int equal)
+{
+	isl_set *set1, *set2;
+
+	set1 = isl_pw_aff_domain(isl_pw_aff_copy(pwaff1));
+	set2 = isl_pw_aff_domain(isl_pw_aff_copy(pwaff2));
+	set1 = isl_set_intersect(set1, set2);
+	return pw_aff_gte_set_on_domain(pwaff1, pwaff2, set1, strict, equal);
+}
+
 /* Return a set containing those elements in the shared domain
  * of pwaff1 and pwaff2 where pwaff1 is equal to pwaff2.
  */
@@ -3661,6 +3868,12 @@ static __isl_give isl_pw_aff *replace_by_nan(__isl_take isl_pw_aff *pa1,
 	return pa;
 }
 
+/* Return an expression for the minimum of "pwaff1" and "pwaff2",
+ * assuming their parameters have been aligned.
+ * The shared domain of the two expressions is computed only once
+ * and is used both for computing the set where "pwaff1"
+ * is smaller than or equal to "pwaff2" and for its complement.
+ */
 static __isl_give isl_pw_aff *pw_aff_min(__isl_take isl_pw_aff *pwaff1,
 	__isl_take isl_pw_aff *pwaff2)
 {
@@ -3669,12 +3882,16 @@ static __isl_give isl_pw_aff *pw_aff_min(__isl_take isl_pw_aff *pwaff1,
 
 	dom = isl_set_intersect(isl_pw_aff_domain(isl_pw_aff_copy(pwaff1)),
 				isl_pw_aff_domain(isl_pw_aff_copy(pwaff2)));
-	le = isl_pw_aff_le_set(isl_pw_aff_copy(pwaff1),
-				isl_pw_aff_copy(pwaff2));
+	le = pw_aff_gte_set_on_domain(isl_pw_aff_copy(pwaff2),
+			isl_pw_aff_copy(pwaff1), isl_set_copy(dom), 0, 0);
 	dom = isl_set_subtract(dom, isl_set_copy(le));
 	return isl_pw_aff_select(le, pwaff1, dom, pwaff2);
 }
 
+/* Return an expression for the maximum of "pwaff1" and "pwaff2",
+ * assuming their parameters have been aligned.
+ * The shared domain is computed only once, as in pw_aff_min.
+ */
 static __isl_give isl_pw_aff *pw_aff_max(__isl_take isl_pw_aff *pwaff1,
 	__isl_take isl_pw_aff *pwaff2)
 {
@@ -3683,8 +3900,8 @@ static __isl_give isl_pw_aff *pw_aff_max(__isl_take isl_pw_aff *pwaff1,
 
 	dom = isl_set_intersect(isl_pw_aff_domain(isl_pw_aff_copy(pwaff1)),
 				isl_pw_aff_domain(isl_pw_aff_copy(pwaff2)));
-	ge = isl_pw_aff_ge_set(isl_pw_aff_copy(pwaff1),
-				isl_pw_aff_copy(pwaff2));
+	ge = pw_aff_gte_set_on_domain(isl_pw_aff_copy(pwaff1),
+			isl_pw_aff_copy(pwaff2), isl_set_copy(dom), 0, 0);
 	dom = isl_set_subtract(dom, isl_set_copy(ge));
 	return isl_pw_aff_select(ge, pwaff1, dom, pwaff2);
 }
@@ -3923,6 +4140,30 @@ static __isl_give isl_basic_set *isl_multi_aff_domain(
 #define DOMBASE basic_set
 #include <isl_multi_bind_templ.c>
 
+/* Return a copy of "ma" in "ctx".
+ * Unless "ma" already belongs to "ctx", "ma" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_multi_aff *isl_multi_aff_copy_to_ctx(
+	__isl_keep isl_multi_aff *ma, isl_ctx *ctx)
+{
+	int i;
+	isl_space *space;
+	isl_multi_aff *dup;
+
+	if (!ma)
+		return NULL;
+	if (isl_multi_aff_get_ctx(ma) == ctx)
+		return isl_multi_aff_copy(ma);
+
+	space = isl_space_copy_to_ctx(isl_multi_aff_peek_space(ma), ctx);
+	dup = isl_multi_aff_alloc(space);
+	for (i = 0; i < ma->n; ++i)
+		dup = isl_multi_aff_set_at(dup, i,
+				    isl_aff_copy_to_ctx(ma->u.p[i], ctx));
+	return dup;
+}
+
 /* Construct an isl_multi_aff living in "space" that corresponds
  * to the affine transformation matrix "mat".
  */
@@ -4527,6 +4768,35 @@ __isl_give isl_set *isl_multi_aff_lex_gt_set(__isl_take isl_multi_aff *ma1,
 #include <isl_pw_range_tuple_id_templ.c>
 #include <isl_pw_union_opt.c>
 
+/* Return a copy of "pma" in "ctx".
+ * Unless "pma" already belongs to "ctx", "pma" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_pw_multi_aff *isl_pw_multi_aff_copy_to_ctx(
+	__isl_keep isl_pw_multi_aff *pma, isl_ctx *ctx)
+{
+	int i;
+	isl_space *space;
+	isl_pw_multi_aff *dup;
+
+	if (!pma)
+		return NULL;
+	if (isl_pw_multi_aff_get_ctx(pma) == ctx)
+		return isl_pw_multi_aff_copy(pma);
+
+	space = isl_space_copy_to_ctx(isl_pw_multi_aff_peek_space(pma), ctx);
+	dup = isl_pw_multi_aff_alloc_size(space, pma->n);
+	for (i = 0; i < pma->n; ++i) {
+		isl_set *set;
+		isl_multi_aff *ma;
+
+		set = isl_set_copy_to_ctx(pma->p[i].set, ctx);
+		ma = isl_multi_aff_copy_to_ctx(pma->p[i].maff, ctx);
+		dup = isl_pw_multi_aff_add_piece(dup, set, ma);
+	}
+	return dup;
+}
+
 #undef BASE
 #define BASE pw_multi_aff
 
@@ -4539,6 +4809,54 @@ __isl_give isl_set *isl_multi_aff_lex_gt_set(__isl_take isl_multi_aff *ma1,
 
 #include <isl_union_pw_templ.c>
 
+/* Internal data structure for isl_union_pw_multi_aff_copy_to_ctx.
+ * "ctx" is the context to which the parts are copied and
+ * "res" collects the copies.
+ */
+struct isl_union_pw_multi_aff_copy_to_ctx_data {
+	isl_ctx *ctx;
+	isl_union_pw_multi_aff *res;
+};
+
+/* Add a copy of the isl_pw_multi_aff that "entry" points to in data->ctx
+ * to data->res.
+ */
+static isl_stat copy_pw_multi_aff_to_ctx(void **entry, void *user)
+{
+	struct isl_union_pw_multi_aff_copy_to_ctx_data *data = user;
+	isl_pw_multi_aff *pma = *entry;
+
+	data->res = isl_union_pw_multi_aff_add_pw_multi_aff(data->res,
+				isl_pw_multi_aff_copy_to_ctx(pma, data->ctx));
+
+	return data->res ? isl_stat_ok : isl_stat_error;
+}
+
+/* Return a copy of "upma" in "ctx".
+ * Unless "upma" already belongs to "ctx", "upma" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_union_pw_multi_aff *isl_union_pw_multi_aff_copy_to_ctx(
+	__isl_keep isl_union_pw_multi_aff *upma, isl_ctx *ctx)
+{
+	struct isl_union_pw_multi_aff_copy_to_ctx_data data = { ctx };
+	isl_space *space;
+
+	if (!upma)
+		return NULL;
+	if (isl_union_pw_multi_aff_get_ctx(upma) == ctx)
+		return isl_union_pw_multi_aff_copy(upma);
+
+	space = isl_space_copy_to_ctx(isl_union_pw_multi_aff_peek_space(upma),
+					ctx);
+	data.res = isl_union_pw_multi_aff_empty(space);
+	if (isl_union_pw_multi_aff_foreach_inplace(upma,
+				    &copy_pw_multi_aff_to_ctx, &data) < 0)
+		data.res = isl_union_pw_multi_aff_free(data.res);
+
+	return data.res;
+}
+
 /* Generic function for extracting a factor from a product "pma".
  * "check_space" checks that the space is that of the right kind of product.
  * "space_factor" extracts the factor from the space.
@@ -5498,6 +5816,91 @@ error:
 	return NULL;
 }
 
+/* Is every basic map of "map" obviously single-valued and
+ * are the domains of these basic maps pairwise disjoint?
+ * The domains of the basic maps are stored in "dom",
+ * which has room for map->n elements, if the result is true.
+ * Otherwise, any domains that have been stored are freed again.
+ *
+ * The single-valuedness test is performed first since it is cheap and
+ * since it ensures that the domains can be computed by eliminating
+ * the output dimensions through their defining equalities.
+ */
+static isl_bool plain_single_valued_disjoint_disjuncts(__isl_keep isl_map *map,
+	isl_basic_set **dom)
+{
+	int i, j;
+	isl_bool ok = isl_bool_true;
+
+	for (i = 0; i < map->n; ++i) {
+		ok = isl_basic_map_plain_is_single_valued(map->p[i]);
+		if (ok < 0 || !ok)
+			return ok;
+	}
+
+	for (i = 0; ok == isl_bool_true && i < map->n; ++i) {
+		dom[i] = isl_basic_map_domain(isl_basic_map_copy(map->p[i]));
+		if (!dom[i])
+			ok = isl_bool_error;
+		for (j = 0; ok == isl_bool_true && j < i; ++j)
+			ok = isl_basic_set_is_disjoint(dom[i], dom[j]);
+	}
+	if (ok == isl_bool_true)
+		return ok;
+
+	for (j = 0; j < i; ++j)
+		isl_basic_set_free(dom[j]);
+	return ok;
+}
+
+/* Try and create an isl_pw_multi_aff that is equivalent to the given isl_map,
+ * where each basic map of "map" is obviously single-valued and
+ * where the domains of these basic maps are pairwise disjoint.
+ * The output dimensions can then be extracted directly from
+ * the equalities of each basic map, without having to check
+ * whether "map" is single-valued as a whole or
+ * to compute any lexicographic minima.
+ *
+ * Return isl_bool_true and store the result in "pma" if "map" is
+ * of this form and isl_bool_false if it is not.
+ * In the latter case, "map" is left untouched.
+ */
+static isl_bool pw_multi_aff_from_plain_disjuncts(__isl_keep isl_map *map,
+	isl_pw_multi_aff **pma)
+{
+	int i;
+	isl_ctx *ctx;
+	isl_basic_set **dom;
+	isl_bool ok;
+
+	ctx = isl_map_get_ctx(map);
+	dom = isl_alloc_array(ctx, isl_basic_set *, map->n);
+	if (!dom)
+		return isl_bool_error;
+	ok = plain_single_valued_disjoint_disjuncts(map, dom);
+	if (ok < 0 || !ok) {
+		free(dom);
+		return ok;
+	}
+
+	*pma = isl_pw_multi_aff_empty(isl_map_get_space(map));
+	for (i = 0; i < map->n; ++i) {
+		isl_set *dom_i;
+		isl_basic_map *bmap;
+		isl_pw_multi_aff *pma_i;
+
+		dom_i = isl_set_from_basic_set(dom[i]);
+		bmap = isl_basic_map_copy(map->p[i]);
+		pma_i = plain_pw_multi_aff_from_map(dom_i, bmap);
+		*pma = isl_pw_multi_aff_add_disjoint(*pma, pma_i);
+	}
+	free(dom);
+
+	if (!*pma)
+		return isl_bool_error;
+	return isl_bool_true;
+}
+
 /* Try and create an isl_pw_multi_aff that is equivalent to the given isl_map.
  *
  * As a special case, we first check if all output dimensions are uniquely
@@ -5505,14 +5908,20 @@ error:
  * domain.  If so, we extract the desired isl_pw_multi_aff directly
  * from the affine hull of "map" and its domain.
  *
+ * Similarly, if "map" consists of several basic maps,
+ * each of which is obviously single-valued, with disjoint domains,
+ * then the isl_pw_multi_aff is extracted from these basic maps directly.
+ *
  * Otherwise, continue with pw_multi_aff_from_map_check_strides for more
  * special cases.
  */
 __isl_give isl_pw_multi_aff *isl_pw_multi_aff_from_map(__isl_take isl_map *map)
 {
 	isl_bool sv;
+	isl_bool plain;
 	isl_size n;
 	isl_basic_map *hull;
+	isl_pw_multi_aff *pma;
 
 	n = isl_map_n_basic_map(map);
 	if (n < 0)
@@ -5532,8 +5941,20 @@ __isl_give isl_pw_multi_aff *isl_pw_multi_aff_from_map(__isl_take isl_map *map)
 	sv = isl_basic_map_plain_is_single_valued(hull);
 	if (sv >= 0 && sv)
 		return plain_pw_multi_aff_from_map(isl_map_domain(map), hull);
-	if (sv >= 0)
-		return pw_multi_aff_from_map_check_strides(map, hull);
+	if (sv < 0 || !map)
+		goto error_hull;
+	plain = isl_bool_false;
+	if (map->n > 1)
+		plain = pw_multi_aff_from_plain_disjuncts(map, &pma);
+	if (plain < 0)
+		goto error_hull;
+	if (plain) {
+		isl_basic_map_free(hull);
+		isl_map_free(map);
+		return pma;
+	}
+	return pw_multi_aff_from_map_check_strides(map, hull);
+error_hull:
 	isl_basic_map_free(hull);
 error:
 	isl_map_free(map);
@@ -6022,11 +6443,41 @@ error:
 	return NULL;
 }
 
+/* If the local space of "dst" is the same as that of "src",
+ * but not the same object, then let "dst" refer to the local space
+ * of "src" instead, provided "dst" is not shared.
+ * This allows the memory of the copy to be reclaimed and
+ * it allows later comparisons of the two local spaces
+ * to be short-circuited.
+ */
+static __isl_give isl_aff *share_local_space(__isl_take isl_aff *dst,
+	__isl_keep isl_aff *src)
+{
+	isl_bool equal;
+
+	if (!dst || !src)
+		return isl_aff_free(dst);
+	if (dst->ls == src->ls || dst->ref != 1)
+		return dst;
+	equal = isl_local_space_is_equal(dst->ls, src->ls);
+	if (equal < 0)
+		return isl_aff_free(dst);
+	if (!equal)
+		return dst;
+	isl_local_space_free(dst->ls);
+	dst->ls = isl_local_space_copy(src->ls);
+	return dst;
+}
+
 /* Extend the local space of "dst" to include the divs
  * in the local space of "src".
  *
  * If "src" does not have any divs or if the local spaces of "dst" and
  * "src" are the same, then no extension is required.
+ * If the local space of "dst" ends up being the same as that of "src",
+ * then let "dst" share the local space of "src".
+ * In particular, after isl_multi_aff_align_divs, all elements
+ * share the same local space.
  */
 __isl_give isl_aff *isl_aff_align_divs(__isl_take isl_aff *dst,
 	__isl_keep isl_aff *src)
@@ -6057,7 +6508,7 @@ __isl_give isl_aff *isl_aff_align_divs(__isl_take isl_aff *dst,
 	if (equal < 0 || src_n_div < 0 || dst_n_div < 0)
 		return isl_aff_free(dst);
 	if (equal)
-		return dst;
+		return share_local_space(dst, src);
 
 	exp1 = isl_alloc_array(ctx, int, src_n_div);
 	exp2 = isl_alloc_array(ctx, int, dst_n_div);
@@ -6069,7 +6520,7 @@ __isl_give isl_aff *isl_aff_align_divs(__isl_take isl_aff *dst,
 	free(exp1);
 	free(exp2);
 
-	return dst;
+	return share_local_space(dst, src);
 error:
 	free(exp1);
 	free(exp2);
@@ -6625,6 +7076,33 @@ error:
 #include <isl_multi_zero_templ.c>
 #include <isl_multi_unbind_params_templ.c>
 
+/* Return a copy of "mpa" in "ctx".
+ * Unless "mpa" already belongs to "ctx", "mpa" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_multi_pw_aff *isl_multi_pw_aff_copy_to_ctx(
+	__isl_keep isl_multi_pw_aff *mpa, isl_ctx *ctx)
+{
+	int i;
+	isl_space *space;
+	isl_multi_pw_aff *dup;
+
+	if (!mpa)
+		return NULL;
+	if (isl_multi_pw_aff_get_ctx(mpa) == ctx)
+		return isl_multi_pw_aff_copy(mpa);
+
+	space = isl_space_copy_to_ctx(isl_multi_pw_aff_peek_space(mpa), ctx);
+	dup = isl_multi_pw_aff_alloc(space);
+	for (i = 0; i < mpa->n; ++i)
+		dup = isl_multi_pw_aff_set_at(dup, i,
+			    isl_pw_aff_copy_to_ctx(mpa->u.p[i], ctx));
+	if (isl_multi_pw_aff_has_explicit_domain(mpa))
+		dup = isl_multi_pw_aff_set_explicit_domain(dup,
+			    isl_set_copy_to_ctx(mpa->u.dom, ctx));
+	return dup;
+}
+
 /* Is every element of "mpa" defined over a single universe domain?
  */
 isl_bool isl_multi_pw_aff_isa_multi_aff(__isl_keep isl_multi_pw_aff *mpa)
@@ -8564,6 +9042,34 @@ error:
 #include <isl_multi_union_add_templ.c>
 #include <isl_multi_zero_space_templ.c>
 
+/* Return a copy of "mupa" in "ctx".
+ * Unless "mupa" already belongs to "ctx", "mupa" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_multi_union_pw_aff *isl_multi_union_pw_aff_copy_to_ctx(
+	__isl_keep isl_multi_union_pw_aff *mupa, isl_ctx *ctx)
+{
+	int i;
+	isl_space *space;
+	isl_multi_union_pw_aff *dup;
+
+	if (!mupa)
+		return NULL;
+	if (isl_multi_union_pw_aff_get_ctx(mupa) == ctx)
+		return isl_multi_union_pw_aff_copy(mupa);
+
+	space = isl_space_copy_to_ctx(isl_multi_union_pw_aff_peek_space(mupa),
+					ctx);
+	dup = isl_multi_union_pw_aff_alloc(space);
+	for (i = 0; i < mupa->n; ++i)
+		dup = isl_multi_union_pw_aff_set_at(dup, i,
+			    isl_union_pw_aff_copy_to_ctx(mupa->u.p[i], ctx));
+	if (isl_multi_union_pw_aff_has_explicit_domain(mupa))
+		dup = isl_multi_union_pw_aff_set_explicit_domain(dup,
+			    isl_union_set_copy_to_ctx(mupa->u.dom, ctx));
+	return dup;
+}
+
 /* Does "mupa" have a non-trivial explicit domain?
  *
  * The explicit domain, if present, is trivial if it represents
@@ -9955,3 +10461,706 @@ error:
 	isl_point_free(pnt);
 	return NULL;
 }
+
+/* A compiled representation of a piecewise multi-affine expression
+ * for evaluating it on many integer points.
+ *
+ * "pma" is the original expression, which is used to evaluate
+ * points for which the compiled representation may overflow,
+ * with "pa" the corresponding piecewise affine expressions and
+ * "dom" its domain.
+ * "dim" is the number of coordinates of a point in the domain,
+ * i.e., the number of parameters and input dimensions.
+ * "n_out" is the number of output dimensions.
+ * If "exact" is set, then some coefficients do not fit in a long
+ * and all points are evaluated using "pma".
+ * Otherwise, "piece" contains the "n_piece" compiled pieces and
+ * "v" is a buffer with room for the values (including local variables)
+ * of a point in any of the pieces.
+ */
+struct isl_pw_multi_aff_evaluator {
+	isl_pw_multi_aff *pma;
+	isl_pw_aff **pa;
+	isl_set *dom;
+	int dim;
+	int n_out;
+	int exact;
+
+	int n_piece;
+	struct isl_pw_multi_aff_evaluator_piece *piece;
+	long *v;
+};
+
+/* A compiled piece of an isl_pw_multi_aff_evaluator.
+ *
+ * All rows have length "len" and refer to a vector containing
+ * the constant 1, the coordinates of the point and
+ * the values of the "n_local" local variables of the piece.
+ * "local" contains the definitions of the local variables,
+ * each as a denominator followed by a row, where the row
+ * only involves earlier local variables.
+ * The domain of the piece is the union of "n_bset" basic sets,
+ * with "n_eq" and "n_ineq" the numbers of their equality and
+ * inequality constraints.  The constraints themselves are stored in "cons",
+ * one basic set after the other, with equality constraints first.
+ * "out" contains the "n_out" output expressions of the piece,
+ * each as a denominator followed by a row.
+ * The piece can be evaluated in long arithmetic without overflow
+ * on points with coordinates bounded in absolute value by "max_coord".
+ */
+struct isl_pw_multi_aff_evaluator_piece {
+	int len;
+	int n_local;
+	long *local;
+	int n_bset;
+	int *n_eq;
+	int *n_ineq;
+	long *cons;
+	long *out;
+	double max_coord;
+};
+
+/* Return the isl_ctx to which "ev" belongs.
+ */
+isl_ctx *isl_pw_multi_aff_evaluator_get_ctx(
+	__isl_keep isl_pw_multi_aff_evaluator *ev)
+{
+	return ev ? isl_pw_multi_aff_get_ctx(ev->pma) : NULL;
+}
+
+/* Free "ev" and return NULL.
+ */
+__isl_null isl_pw_multi_aff_evaluator *isl_pw_multi_aff_evaluator_free(
+	__isl_take isl_pw_multi_aff_evaluator *ev)
+{
+	int i;
+
+	if (!ev)
+		return NULL;
+
+	for (i = 0; ev->pa && i < ev->n_out; ++i)
+		isl_pw_aff_free(ev->pa[i]);
+	free(ev->pa);
+	for (i = 0; ev->piece && i < ev->n_piece; ++i) {
+		free(ev->piece[i].local);
+		free(ev->piece[i].n_eq);
+		free(ev->piece[i].n_ineq);
+		free(ev->piece[i].cons);
+		free(ev->piece[i].out);
+	}
+	free(ev->piece);
+	free(ev->v);
+	isl_set_free(ev->dom);
+	isl_pw_multi_aff_free(ev->pma);
+	free(ev);
+
+	return NULL;
+}
+
+/* Copy the "n" coefficients in "src" to "dst", given that the coefficients
+ * of the local variables in "src" start at position "pos" and
+ * should be moved to position "off" in "dst".
+ * Return isl_bool_false if any of the coefficients does not fit in a long.
+ */
+static isl_bool evaluator_copy_row(long *dst, isl_int *src, int n,
+	int pos, int off)
+{
+	int i;
+
+	for (i = 0; i < n; ++i) {
+		int j = i < pos ? i : off + (i - pos);
+
+		if (!isl_int_fits_slong(src[i]))
+			return isl_bool_false;
+		dst[j] = isl_int_get_si(src[i]);
+	}
+
+	return isl_bool_true;
+}
+
+/* Store the definitions of the local variables in "div"
+ * in piece->local, starting at local variable "off",
+ * where the row of each local variable starts with its denominator.
+ * Return isl_bool_false if any of the local variables is unknown
+ * or if any coefficient does not fit in a long.
+ */
+static isl_bool evaluator_add_locals(
+	struct isl_pw_multi_aff_evaluator_piece *piece, isl_int **div,
+	int n_div, int dim, int off)
+{
+	int i;
+
+	for (i = 0; i < n_div; ++i) {
+		long *row = piece->local + (off + i) * (1 + piece->len);
+		isl_bool ok;
+
+		if (isl_int_is_zero(div[i][0]))
+			return isl_bool_false;
+		ok = evaluator_copy_row(row, div[i], 2 + dim, 2 + dim, 0);
+		if (ok == isl_bool_true)
+			ok = evaluator_copy_row(row + 2 + dim, div[i] + 2 + dim,
+						n_div, 0, off);
+		if (ok != isl_bool_true)
+			return ok;
+	}
+
+	return isl_bool_true;
+}
+
+/* Compile the piece of "pma" with domain "set" and expression "ma"
+ * into "piece", where "dim" is the number of parameters and
+ * input dimensions.
+ * "set" is assumed to have known local variables.
+ * Return isl_bool_false if the piece cannot be represented
+ * using coefficients that fit in a long.
+ */
+static isl_bool evaluator_compile_piece(
+	struct isl_pw_multi_aff_evaluator_piece *piece,
+	__isl_keep isl_set *set, __isl_keep isl_multi_aff *ma, int dim)
+{
+	isl_ctx *ctx = isl_set_get_ctx(set);
+	int i, j, n_cons, off;
+	int n_out = ma->n;
+	long *cons;
+
+	piece->n_bset = set->n;
+	piece->n_local = 0;
+	n_cons = 0;
+	for (i = 0; i < set->n; ++i) {
+		piece->n_local += set->p[i]->n_div;
+		n_cons += set->p[i]->n_eq + set->p[i]->n_ineq;
+	}
+	for (i = 0; i < n_out; ++i) {
+		if (isl_aff_is_nan(ma->u.p[i]))
+			return isl_bool_false;
+		piece->n_local += ma->u.p[i]->ls->div->n_row;
+	}
+	piece->len = 1 + dim + piece->n_local;
+
+	piece->n_eq = isl_alloc_array(ctx, int, set->n);
+	piece->n_ineq = isl_alloc_array(ctx, int, set->n);
+	piece->local = isl_calloc_array(ctx, long,
+					piece->n_local * (1 + piece->len));
+	piece->cons = isl_calloc_array(ctx, long, n_cons * piece->len);
+	piece->out = isl_calloc_array(ctx, long, n_out * (1 + piece->len));
+	if ((set->n && (!piece->n_eq || !piece->n_ineq)) ||
+	    (piece->n_local && !piece->local) ||
+	    (n_cons && !piece->cons) || (n_out && !piece->out))
+		return isl_bool_error;
+
+	off = 0;
+	cons = piece->cons;
+	for (i = 0; i < set->n; ++i) {
+		isl_basic_set *bset = set->p[i];
+		isl_bool ok;
+
+		piece->n_eq[i] = bset->n_eq;
+		piece->n_ineq[i] = bset->n_ineq;
+		ok = evaluator_add_locals(piece, bset->div, bset->n_div,
+					dim, off);
+		for (j = 0; ok == isl_bool_true && j < bset->n_eq; ++j) {
+			ok = evaluator_copy_row(cons, bset->eq[j],
+					1 + dim + bset->n_div, 1 + dim, 1 + dim + off);
+			cons += piece->len;
+		}
+		for (j = 0; ok == isl_bool_true && j < bset->n_ineq; ++j) {
+			ok = evaluator_copy_row(cons, bset->ineq[j],
+					1 + dim + bset->n_div, 1 + dim, 1 + dim + off);
+			cons += piece->len;
+		}
+		if (ok != isl_bool_true)
+			return ok;
+		off += bset->n_div;
+	}
+	for (i = 0; i < n_out; ++i) {
+		isl_aff *aff = ma->u.p[i];
+		long *row = piece->out + i * (1 + piece->len);
+		int n_div = aff->ls->div->n_row;
+		isl_bool ok;
+
+		ok = evaluator_add_locals(piece, aff->ls->div->row, n_div,
+					dim, off);
+		if (ok == isl_bool_true)
+			ok = evaluator_copy_row(row, aff->v->el,
+					2 + dim + n_div, 2 + dim, 2 + dim + off);
+		if (ok != isl_bool_true)
+			return ok;
+		off += n_div;
+	}
+
+	return isl_bool_true;
+}
+
+/* Return the absolute value of "d".
+ */
+static double evaluator_abs(double d)
+{
+	return d < 0 ? -d : d;
+}
+
+/* Compute bounds "a" + "b" * M on the absolute value of the inner product
+ * of the "len" elements of "row" and a vector with the absolute value
+ * of element "i" bounded by ra[i] + rb[i] * M.
+ */
+static void evaluator_row_bound(long *row, double *ra, double *rb, int len,
+	double *a, double *b)
+{
+	int i;
+
+	*a = 0;
+	*b = 0;
+	for (i = 0; i < len; ++i) {
+		*a += evaluator_abs(row[i]) * ra[i];
+		*b += evaluator_abs(row[i]) * rb[i];
+	}
+}
+
+/* Update *max_coord such that "a" + "b" * *max_coord remains
+ * below "limit".
+ */
+static void evaluator_limit(double a, double b, double limit,
+	double *max_coord)
+{
+	if (a > limit)
+		*max_coord = -1;
+	else if (b > 0 && (limit - a) / b < *max_coord)
+		*max_coord = (limit - a) / b;
+}
+
+/* Compute piece->max_coord, the maximal absolute value M
+ * of the coordinates of a point for which "piece" can be evaluated
+ * in long arithmetic without overflow.
+ * "ra" and "rb" have room for bounds ra[i] + rb[i] * M on the absolute
+ * values of all elements of the vector of values of the point,
+ * which are computed in turn for the local variables.
+ * The bounds are computed in floating point and compared against
+ * a threshold that leaves a generous margin for rounding errors.
+ */
+static void evaluator_piece_set_max_coord(
+	struct isl_pw_multi_aff_evaluator_piece *piece, double *ra, double *rb,
+	int dim, int n_out)
+{
+	int i, n_cons;
+	double a, b;
+	const double limit = LONG_MAX / 8;
+
+	piece->max_coord = limit;
+	ra[0] = 1;
+	rb[0] = 0;
+	for (i = 0; i < dim; ++i) {
+		ra[1 + i] = 0;
+		rb[1 + i] = 1;
+	}
+	for (i = 0; i < piece->n_local; ++i) {
+		ra[1 + dim + i] = 0;
+		rb[1 + dim + i] = 0;
+	}
+	for (i = 0; i < piece->n_local; ++i) {
+		long *row = piece->local + i * (1 + piece->len);
+
+		evaluator_row_bound(row + 1, ra, rb, piece->len, &a, &b);
+		evaluator_limit(a, b, limit, &piece->max_coord);
+		ra[1 + dim + i] = a / row[0] + 1;
+		rb[1 + dim + i] = b / row[0];
+	}
+	n_cons = 0;
+	for (i = 0; i < piece->n_bset; ++i)
+		n_cons += piece->n_eq[i] + piece->n_ineq[i];
+	for (i = 0; i < n_cons; ++i) {
+		evaluator_row_bound(piece->cons + i * piece->len,
+					ra, rb, piece->len, &a, &b);
+		evaluator_limit(a, b, limit, &piece->max_coord);
+	}
+	for (i = 0; i < n_out; ++i) {
+		evaluator_row_bound(piece->out + i * (1 + piece->len) + 1,
+					ra, rb, piece->len, &a, &b);
+		evaluator_limit(a, b, limit, &piece->max_coord);
+	}
+}
+
+/* Compute the overflow thresholds of the compiled pieces of "ev" and
+ * allocate the buffer ev->v.
+ */
+static isl_stat evaluator_set_max_coord(isl_pw_multi_aff_evaluator *ev)
+{
+	isl_ctx *ctx = isl_pw_multi_aff_evaluator_get_ctx(ev);
+	int i, max_len;
+	double *ra, *rb;
+
+	max_len = 1 + ev->dim;
+	for (i = 0; i < ev->n_piece; ++i)
+		if (ev->piece[i].len > max_len)
+			max_len = ev->piece[i].len;
+	ev->v = isl_alloc_array(ctx, long, max_len);
+	ra = isl_alloc_array(ctx, double, max_len);
+	rb = isl_alloc_array(ctx, double, max_len);
+	if (!ev->v || !ra || !rb) {
+		free(ra);
+		free(rb);
+		return isl_stat_error;
+	}
+
+	for (i = 0; i < ev->n_piece; ++i)
+		evaluator_piece_set_max_coord(&ev->piece[i], ra, rb,
+						ev->dim, ev->n_out);
+
+	free(ra);
+	free(rb);
+	return isl_stat_ok;
+}
+
+/* Compile "pma" into an isl_pw_multi_aff_evaluator.
+ *
+ * The local variables of the piece domains are first made explicit.
+ * If any coefficient does not fit in a long, then the result
+ * is marked "exact" and all evaluations are performed on "pma" itself.
+ */
+__isl_give isl_pw_multi_aff_evaluator *
+isl_pw_multi_aff_evaluator_from_pw_multi_aff(__isl_take isl_pw_multi_aff *pma)
+{
+	isl_ctx *ctx;
+	isl_pw_multi_aff_evaluator *ev;
+	isl_size nparam, n_in, n_out;
+	int i, dim;
+
+	nparam = isl_pw_multi_aff_dim(pma, isl_dim_param);
+	n_in = isl_pw_multi_aff_dim(pma, isl_dim_in);
+	n_out = isl_pw_multi_aff_dim(pma, isl_dim_out);
+	if (nparam < 0 || n_in < 0 || n_out < 0)
+		goto error;
+	dim = nparam + n_in;
+
+	ctx = isl_pw_multi_aff_get_ctx(pma);
+	ev = isl_calloc_type(ctx, isl_pw_multi_aff_evaluator);
+	if (!ev)
+		goto error;
+	ev->pma = pma;
+	ev->dim = dim;
+	ev->n_out = n_out;
+	ev->dom = isl_pw_multi_aff_domain(isl_pw_multi_aff_copy(pma));
+	ev->pa = isl_calloc_array(ctx, isl_pw_aff *, n_out);
+	if (!ev->dom || (n_out && !ev->pa))
+		return isl_pw_multi_aff_evaluator_free(ev);
+	for (i = 0; i < n_out; ++i) {
+		ev->pa[i] = isl_pw_multi_aff_get_pw_aff(pma, i);
+		if (!ev->pa[i])
+			return isl_pw_multi_aff_evaluator_free(ev);
+	}
+
+	ev->n_piece = pma->n;
+	ev->piece = isl_calloc_array(ctx,
+			struct isl_pw_multi_aff_evaluator_piece, pma->n);
+	if (pma->n && !ev->piece)
+		return isl_pw_multi_aff_evaluator_free(ev);
+	for (i = 0; !ev->exact && i < pma->n; ++i) {
+		isl_set *set;
+		isl_bool ok;
+
+		set = isl_set_compute_divs(isl_set_copy(pma->p[i].set));
+		if (!set)
+			return isl_pw_multi_aff_evaluator_free(ev);
+		ok = evaluator_compile_piece(&ev->piece[i], set,
+						pma->p[i].maff, dim);
+		isl_set_free(set);
+		if (ok < 0)
+			return isl_pw_multi_aff_evaluator_free(ev);
+		if (!ok)
+			ev->exact = 1;
+	}
+	if (!ev->exact && evaluator_set_max_coord(ev) < 0)
+		return isl_pw_multi_aff_evaluator_free(ev);
+
+	return ev;
+error:
+	isl_pw_multi_aff_free(pma);
+	return NULL;
+}
+
+/* Return the inner product of the "len" elements of "row" and "v".
+ */
+static long evaluator_inner_product(long *row, long *v, int len)
+{
+	int i;
+	long r = 0;
+
+	for (i = 0; i < len; ++i)
+		r += row[i] * v[i];
+
+	return r;
+}
+
+/* Does the point with values (including local variables) "v"
+ * satisfy the constraints of one of the basic sets in the domain of "piece"?
+ */
+static int evaluator_piece_contains(
+	struct isl_pw_multi_aff_evaluator_piece *piece, long *v)
+{
+	int i, j;
+	long *cons = piece->cons;
+
+	for (i = 0; i < piece->n_bset; ++i) {
+		int n_eq = piece->n_eq[i];
+		int n = n_eq + piece->n_ineq[i];
+
+		for (j = 0; j < n; ++j) {
+			long r;
+
+			r = evaluator_inner_product(cons + j * piece->len,
+							v, piece->len);
+			if (j < n_eq ? r != 0 : r < 0)
+				break;
+		}
+		if (j >= n)
+			return 1;
+		cons += n * piece->len;
+	}
+
+	return 0;
+}
+
+/* Return the maximal absolute value of the "dim" elements of "coords".
+ */
+static double evaluator_max_coord(const long *coords, int dim)
+{
+	int i;
+	double max = 0;
+
+	for (i = 0; i < dim; ++i) {
+		double b = evaluator_abs(coords[i]);
+
+		if (b > max)
+			max = b;
+	}
+
+	return max;
+}
+
+/* Evaluate the point with coordinates "coords" on the compiled pieces
+ * of "ev", storing the result in "res", if "res" is not NULL.
+ * "max" is the maximal absolute value of the coordinates.
+ * Return 1 if the point belongs to one of the pieces,
+ * 0 if it does not and -1 if the value is not integral.
+ * If the point could belong to a piece that cannot be evaluated
+ * in long arithmetic for coordinates of this size, then return -2.
+ */
+static int evaluator_eval_compiled(isl_pw_multi_aff_evaluator *ev,
+	const long *coords, double max, long *res)
+{
+	int i, k;
+	long *v = ev->v;
+
+	v[0] = 1;
+	for (k = 0; k < ev->dim; ++k)
+		v[1 + k] = coords[k];
+	for (i = 0; i < ev->n_piece; ++i) {
+		struct isl_pw_multi_aff_evaluator_piece *piece = &ev->piece[i];
+
+		if (max > piece->max_coord)
+			return -2;
+		for (k = 0; k < piece->n_local; ++k) {
+			long *row = piece->local + k * (1 + piece->len);
+			long num;
+
+			num = evaluator_inner_product(row + 1, v, piece->len);
+			v[1 + ev->dim + k] = num / row[0];
+			if (num % row[0] != 0 && num < 0)
+				v[1 + ev->dim + k]--;
+		}
+		if (!evaluator_piece_contains(piece, v))
+			continue;
+		for (k = 0; res && k < ev->n_out; ++k) {
+			long *row = piece->out + k * (1 + piece->len);
+			long num;
+
+			num = evaluator_inner_product(row + 1, v, piece->len);
+			if (num % row[0] != 0)
+				return -1;
+			res[k] = num / row[0];
+		}
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Construct an isl_point in the domain space of "ev"
+ * with coordinates "coords".
+ */
+static __isl_give isl_point *evaluator_point(isl_pw_multi_aff_evaluator *ev,
+	const long *coords)
+{
+	isl_ctx *ctx = isl_pw_multi_aff_evaluator_get_ctx(ev);
+	isl_size nparam;
+	isl_point *pnt;
+	int i;
+
+	nparam = isl_set_dim(ev->dom, isl_dim_param);
+	if (nparam < 0)
+		return NULL;
+	pnt = isl_point_zero(isl_set_get_space(ev->dom));
+	for (i = 0; i < ev->dim; ++i) {
+		enum isl_dim_type type;
+		int pos;
+
+		type = i < nparam ? isl_dim_param : isl_dim_set;
+		pos = i < nparam ? i : i - nparam;
+		pnt = isl_point_set_coordinate_val(pnt, type, pos,
+					isl_val_int_from_si(ctx, coords[i]));
+	}
+
+	return pnt;
+}
+
+/* Does "pnt" belong to the domain of "ev"?
+ */
+static isl_bool evaluator_domain_contains_point(
+	isl_pw_multi_aff_evaluator *ev, __isl_keep isl_point *pnt)
+{
+	isl_set *set;
+	isl_bool in;
+
+	set = isl_set_from_point(isl_point_copy(pnt));
+	in = isl_set_is_subset(set, ev->dom);
+	isl_set_free(set);
+
+	return in;
+}
+
+/* Evaluate "ev" on the point with coordinates "coords"
+ * using exact arithmetic on the original expression,
+ * storing the result in "res".
+ * Return 1 if the point belongs to the domain,
+ * 0 if it does not and -1 on error.
+ */
+static int evaluator_eval_exact(isl_pw_multi_aff_evaluator *ev,
+	const long *coords, long *res)
+{
+	isl_ctx *ctx = isl_pw_multi_aff_evaluator_get_ctx(ev);
+	isl_point *pnt;
+	isl_bool in;
+	int i;
+
+	pnt = evaluator_point(ev, coords);
+	in = evaluator_domain_contains_point(ev, pnt);
+	if (in < 0 || !in) {
+		isl_point_free(pnt);
+		return in < 0 ? -1 : 0;
+	}
+	for (i = 0; i < ev->n_out; ++i) {
+		isl_val *v;
+		int ok;
+
+		v = isl_pw_aff_eval(isl_pw_aff_copy(ev->pa[i]),
+					isl_point_copy(pnt));
+		ok = v && isl_val_is_int(v) && isl_int_fits_slong(v->n);
+		if (ok)
+			res[i] = isl_int_get_si(v->n);
+		isl_val_free(v);
+		if (!ok) {
+			isl_point_free(pnt);
+			isl_die(ctx, isl_error_invalid,
+				"value is not an integer that fits in a long",
+				return -1);
+		}
+	}
+	isl_point_free(pnt);
+
+	return 1;
+}
+
+/* Evaluate "ev" on the "n" points with coordinates in "coords",
+ * each consisting of the values of the parameters followed by
+ * the values of the input dimensions, and store the output values
+ * in "res", which needs to have room for "n" times the number
+ * of output dimensions values.
+ * If "defined" is not NULL, then defined[i] is set to 1 if point "i"
+ * belongs to the domain of the expression and to 0 otherwise.
+ * If "defined" is NULL, then it is an error for a point
+ * to lie outside of the domain.
+ * The values of a point outside the domain are set to zero.
+ *
+ * The compiled pieces are evaluated in long arithmetic
+ * if the maximal absolute value of the coordinates of a point
+ * guarantees that no overflow can occur.
+ * Otherwise, the point is evaluated in exact arithmetic.
+ */
+isl_stat isl_pw_multi_aff_evaluator_eval(
+	__isl_keep isl_pw_multi_aff_evaluator *ev, const long *coords, int n,
+	long *res, int *defined)
+{
+	isl_ctx *ctx;
+	int i, j;
+
+	if (!ev)
+		return isl_stat_error;
+	ctx = isl_pw_multi_aff_evaluator_get_ctx(ev);
+	if (n > 0 && (!coords || (ev->n_out > 0 && !res)))
+		isl_die(ctx, isl_error_invalid, "invalid buffer",
+			return isl_stat_error);
+
+	for (i = 0; i < n; ++i) {
+		const long *c = coords + i * ev->dim;
+		long *r = res ? res + i * ev->n_out : NULL;
+		int in = -2;
+
+		if (!ev->exact)
+			in = evaluator_eval_compiled(ev, c,
+					evaluator_max_coord(c, ev->dim), r);
+		if (in == -1)
+			isl_die(ctx, isl_error_invalid,
+				"value is not integral", return isl_stat_error);
+		if (in == -2)
+			in = evaluator_eval_exact(ev, c, r);
+		if (in < 0)
+			return isl_stat_error;
+		if (!in) {
+			if (!defined)
+				isl_die(ctx, isl_error_invalid,
+					"point outside of domain",
+					return isl_stat_error);
+			for (j = 0; j < ev->n_out; ++j)
+				r[j] = 0;
+		}
+		if (defined)
+			defined[i] = in;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Does the point with coordinates "coords", consisting of
+ * the values of the parameters followed by the values
+ * of the input dimensions, belong to the domain of "ev"?
+ *
+ * Only the constraints of the compiled pieces are evaluated
+ * if no overflow can occur.  Otherwise, the test is performed
+ * in exact arithmetic.
+ */
+isl_bool isl_pw_multi_aff_evaluator_domain_contains(
+	__isl_keep isl_pw_multi_aff_evaluator *ev, const long *coords)
+{
+	isl_point *pnt;
+	isl_bool in;
+
+	if (!ev)
+		return isl_bool_error;
+	if (!coords)
+		isl_die(isl_pw_multi_aff_evaluator_get_ctx(ev),
+			isl_error_invalid, "invalid buffer",
+			return isl_bool_error);
+
+	if (!ev->exact) {
+		int r;
+
+		r = evaluator_eval_compiled(ev, coords,
+				evaluator_max_coord(coords, ev->dim), NULL);
+		if (r >= 0)
+			return isl_bool_ok(r);
+	}
+
+	pnt = evaluator_point(ev, coords);
+	in = evaluator_domain_contains_point(ev, pnt);
+	isl_point_free(pnt);
+
+	return in;
+}
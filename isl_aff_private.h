@@ -106,6 +106,8 @@ __isl_give isl_aff *isl_stream_read_aff(__isl_keep isl_stream *s);
 
 __isl_give isl_pw_aff *isl_pw_aff_alloc_size(__isl_take isl_space *space,
 	int n);
+__isl_give isl_pw_aff *isl_pw_aff_add_piece(__isl_take isl_pw_aff *pwaff,
+	__isl_take isl_set *set, __isl_take isl_aff *aff);
 __isl_give isl_pw_aff *isl_pw_aff_reset_space(__isl_take isl_pw_aff *pwaff,
 	__isl_take isl_space *space);
 __isl_give isl_pw_aff *isl_pw_aff_reset_domain_space(
@@ -162,6 +164,12 @@ __isl_give isl_pw_multi_aff *isl_pw_multi_aff_move_dims(
 	enum isl_dim_type dst_type, unsigned dst_pos,
 	enum isl_dim_type src_type, unsigned src_pos, unsigned n);
 
+__isl_give isl_pw_multi_aff *isl_pw_multi_aff_alloc_size(
+	__isl_take isl_space *space, int n);
+__isl_give isl_pw_multi_aff *isl_pw_multi_aff_add_piece(
+	__isl_take isl_pw_multi_aff *pma,
+	__isl_take isl_set *set, __isl_take isl_multi_aff *maff);
+
 __isl_give isl_pw_multi_aff *isl_pw_multi_aff_reset_domain_space(
 	__isl_take isl_pw_multi_aff *pwmaff, __isl_take isl_space *space);
 __isl_give isl_pw_multi_aff *isl_pw_multi_aff_reset_space(
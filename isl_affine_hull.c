@@ -38,6 +38,8 @@ __isl_give isl_basic_map *isl_basic_map_implicit_equalities(
 		return bmap;
 
 	bmap = isl_basic_map_gauss(bmap, NULL);
+	if (!bmap)
+		return NULL;
 	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY))
 		return bmap;
 	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_NO_IMPLICIT))
@@ -51,6 +53,8 @@ __isl_give isl_basic_map *isl_basic_map_implicit_equalities(
 	bmap = isl_basic_map_update_from_tab(bmap, tab);
 	isl_tab_free(tab);
 	bmap = isl_basic_map_gauss(bmap, NULL);
+	if (!bmap)
+		return NULL;
 	ISL_F_SET(bmap, ISL_BASIC_MAP_NO_IMPLICIT);
 	return bmap;
 error:
@@ -486,6 +490,37 @@ static __isl_give isl_basic_set *initialize_hull(__isl_keep isl_basic_set *bset,
 	return hull;
 }
 
+/* Add the integer points in the rows of "seeds" to "hull",
+ * skipping those that already belong to "hull".
+ */
+static __isl_give isl_basic_set *add_seeds(__isl_take isl_basic_set *hull,
+	__isl_keep isl_mat *seeds)
+{
+	int i;
+
+	if (!seeds)
+		return hull;
+
+	for (i = 0; i < seeds->n_row; ++i) {
+		isl_bool contains;
+		isl_vec *sample;
+
+		sample = isl_mat_get_row(seeds, i);
+		contains = isl_basic_set_contains(hull, sample);
+		if (contains < 0) {
+			isl_vec_free(sample);
+			return isl_basic_set_free(hull);
+		}
+		if (contains) {
+			isl_vec_free(sample);
+			continue;
+		}
+		hull = affine_hull(hull, isl_basic_set_from_vec(sample));
+	}
+
+	return hull;
+}
+
 /* Look for all equalities satisfied by the integer points in bset,
  * which is assumed to be bounded.
  *
@@ -494,9 +529,16 @@ static __isl_give isl_basic_set *initialize_hull(__isl_keep isl_basic_set *bset,
  * In particular, for each equality satisfied by the points so far,
  * we check if there is any point on a hyperplane parallel to the
  * corresponding hyperplane shifted by at least one (in either direction).
+ *
+ * "seeds" may be either NULL or a matrix with known integer points
+ * of "bset" as rows.  These points are added to the initial
+ * approximation of the hull, such that no search needs to be performed
+ * for the equalities that they already violate.
+ * If "bset" does not have a valid sample point, then the first
+ * of these points is used as sample point.
  */
 static __isl_give isl_basic_set *uset_affine_hull_bounded(
-	__isl_take isl_basic_set *bset)
+	__isl_take isl_basic_set *bset, __isl_keep isl_mat *seeds)
 {
 	struct isl_vec *sample = NULL;
 	struct isl_basic_set *hull;
@@ -523,6 +565,15 @@ static __isl_give isl_basic_set *uset_affine_hull_bounded(
 			bset->sample = NULL;
 		}
 	}
+	if (!sample && seeds && seeds->n_row > 0) {
+		if (dim == 0)
+			return bset;
+		sample = isl_mat_get_row(seeds, 0);
+		if (!sample)
+			goto error;
+		isl_vec_free(bset->sample);
+		bset->sample = isl_vec_copy(sample);
+	}
 
 	tab = isl_tab_from_basic_set(bset, 1);
 	if (!tab)
@@ -552,6 +603,7 @@ static __isl_give isl_basic_set *uset_affine_hull_bounded(
 	}
 
 	hull = initialize_hull(bset, sample);
+	hull = add_seeds(hull, seeds);
 
 	hull = extend_affine_hull(tab, hull, bset);
 	isl_basic_set_free(bset);
@@ -726,14 +778,19 @@ error:
  *
  * The affine hull in the original space is then obtained as
  * A = preimage(A'', Q_1).
+ *
+ * The known integer points of "bset" in the rows of "seeds", if any,
+ * are mapped to points of S'' in the same way.
  */
 static __isl_give isl_basic_set *affine_hull_with_cone(
-	__isl_take isl_basic_set *bset, __isl_take isl_basic_set *cone)
+	__isl_take isl_basic_set *bset, __isl_take isl_basic_set *cone,
+	__isl_keep isl_mat *seeds)
 {
 	isl_size total;
 	unsigned cone_dim;
 	struct isl_basic_set *hull;
 	struct isl_mat *M, *U, *Q;
+	isl_mat *seeds_Q = NULL;
 
 	total = isl_basic_set_dim(cone, isl_dim_all);
 	if (!bset || total < 0)
@@ -759,8 +816,12 @@ static __isl_give isl_basic_set *affine_hull_with_cone(
 
 	if (bset && bset->sample && bset->sample->size == 1 + total)
 		bset->sample = isl_mat_vec_product(isl_mat_copy(Q), bset->sample);
+	if (seeds)
+		seeds_Q = isl_mat_product(isl_mat_copy(seeds),
+				isl_mat_transpose(isl_mat_copy(Q)));
 
-	hull = uset_affine_hull_bounded(bset);
+	hull = uset_affine_hull_bounded(bset, seeds_Q);
+	isl_mat_free(seeds_Q);
 
 	if (!hull) {
 		isl_mat_free(Q);
@@ -804,9 +865,12 @@ error:
  * in these directions.
  * In particular, if the recession cone is full-dimensional, then
  * the affine hull is simply the whole universe.
+ *
+ * "seeds" may be either NULL or a matrix with known integer points
+ * of "bset" as rows.
  */
 static __isl_give isl_basic_set *uset_affine_hull(
-	__isl_take isl_basic_set *bset)
+	__isl_take isl_basic_set *bset, __isl_keep isl_mat *seeds)
 {
 	struct isl_basic_set *cone;
 	isl_size total;
@@ -829,10 +893,10 @@ static __isl_give isl_basic_set *uset_affine_hull(
 	if (total < 0)
 		bset = isl_basic_set_free(bset);
 	if (cone->n_eq < total)
-		return affine_hull_with_cone(bset, cone);
+		return affine_hull_with_cone(bset, cone, seeds);
 
 	isl_basic_set_free(cone);
-	return uset_affine_hull_bounded(bset);
+	return uset_affine_hull_bounded(bset, seeds);
 error:
 	isl_basic_set_free(bset);
 	return NULL;
@@ -850,14 +914,20 @@ error:
  * The resulting basic set has all meaning about the dimensions removed.
  * In particular, dimensions that correspond to existential variables
  * in bmap and that are found to be fixed are not removed.
+ *
+ * "seeds" may be either NULL or a matrix with known integer points
+ * of the underlying set of "bmap" as rows.
+ * If the equalities are removed, then these points are mapped
+ * to the reduced space as well.
  */
 static __isl_give isl_basic_set *equalities_in_underlying_set(
-	__isl_take isl_basic_map *bmap)
+	__isl_take isl_basic_map *bmap, __isl_keep isl_mat *seeds)
 {
 	struct isl_mat *T1 = NULL;
 	struct isl_mat *T2 = NULL;
 	struct isl_basic_set *bset = NULL;
 	struct isl_basic_set *hull = NULL;
+	isl_mat *seeds_T2;
 
 	bset = isl_basic_map_underlying_set(bmap);
 	if (!bset)
@@ -867,9 +937,15 @@ static __isl_give isl_basic_set *equalities_in_underlying_set(
 	if (!bset)
 		goto error;
 
-	hull = uset_affine_hull(bset);
 	if (!T2)
-		return hull;
+		return uset_affine_hull(bset, seeds);
+
+	seeds_T2 = NULL;
+	if (seeds)
+		seeds_T2 = isl_mat_product(isl_mat_copy(seeds),
+				isl_mat_transpose(isl_mat_copy(T2)));
+	hull = uset_affine_hull(bset, seeds_T2);
+	isl_mat_free(seeds_T2);
 
 	if (!hull) {
 		isl_mat_free(T1);
@@ -897,14 +973,63 @@ error:
 	return NULL;
 }
 
+/* Return a matrix with as rows those rows of "samples" that
+ * are integer points of "bmap" (including its local variables).
+ * Return NULL if there are no such rows.
+ */
+static __isl_give isl_mat *samples_in(__isl_keep isl_basic_map *bmap,
+	__isl_keep isl_mat *samples, isl_size total, isl_bool *error)
+{
+	int i;
+	isl_mat *seeds;
+
+	*error = isl_bool_false;
+	if (!samples || samples->n_row == 0 || samples->n_col != 1 + total)
+		return NULL;
+
+	seeds = isl_mat_alloc(isl_basic_map_get_ctx(bmap), 0, 1 + total);
+	for (i = 0; i < samples->n_row; ++i) {
+		isl_bool contains;
+		isl_vec *sample;
+
+		sample = isl_mat_get_row(samples, i);
+		contains = isl_basic_map_contains(bmap, sample);
+		if (contains < 0 || !seeds) {
+			isl_vec_free(sample);
+			*error = isl_bool_true;
+			return isl_mat_free(seeds);
+		}
+		if (contains)
+			seeds = isl_mat_vec_concat(seeds, sample);
+		else
+			isl_vec_free(sample);
+	}
+	if (!seeds) {
+		*error = isl_bool_true;
+		return NULL;
+	}
+	if (seeds->n_row == 0)
+		return isl_mat_free(seeds);
+
+	return seeds;
+}
+
 /* Detect and make explicit all equalities satisfied by the (integer)
  * points in bmap.
+ *
+ * "samples" may be either NULL or a matrix of integer points,
+ * with the same number of variables as "bmap" (including
+ * its local variables), that are known to the caller.
+ * Those that belong to "bmap" are used to seed the computation,
+ * such that fewer integer points need to be searched for.
  */
-__isl_give isl_basic_map *isl_basic_map_detect_equalities(
-	__isl_take isl_basic_map *bmap)
+__isl_give isl_basic_map *isl_basic_map_detect_equalities_with_samples(
+	__isl_take isl_basic_map *bmap, __isl_keep isl_mat *samples)
 {
 	int i, j;
 	isl_size total;
+	isl_bool error;
+	isl_mat *seeds;
 	struct isl_basic_set *hull = NULL;
 
 	if (!bmap)
@@ -918,7 +1043,14 @@ __isl_give isl_basic_map *isl_basic_map_detect_equalities(
 	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_RATIONAL))
 		return isl_basic_map_implicit_equalities(bmap);
 
-	hull = equalities_in_underlying_set(isl_basic_map_copy(bmap));
+	total = isl_basic_map_dim(bmap, isl_dim_all);
+	if (total < 0)
+		return isl_basic_map_free(bmap);
+	seeds = samples_in(bmap, samples, total, &error);
+	if (error)
+		return isl_basic_map_free(bmap);
+	hull = equalities_in_underlying_set(isl_basic_map_copy(bmap), seeds);
+	isl_mat_free(seeds);
 	if (!hull)
 		goto error;
 	if (ISL_F_ISSET(hull, ISL_BASIC_SET_EMPTY)) {
@@ -947,6 +1079,15 @@ error:
 	return NULL;
 }
 
+/* Detect and make explicit all equalities satisfied by the (integer)
+ * points in bmap.
+ */
+__isl_give isl_basic_map *isl_basic_map_detect_equalities(
+	__isl_take isl_basic_map *bmap)
+{
+	return isl_basic_map_detect_equalities_with_samples(bmap, NULL);
+}
+
 __isl_give isl_basic_set *isl_basic_set_detect_equalities(
 						__isl_take isl_basic_set *bset)
 {
@@ -954,10 +1095,64 @@ __isl_give isl_basic_set *isl_basic_set_detect_equalities(
 		isl_basic_map_detect_equalities(bset_to_bmap(bset)));
 }
 
+/* Add the sample point of "bmap" to "samples", if it has one
+ * of the right size.
+ */
+static __isl_give isl_mat *add_sample(__isl_take isl_mat *samples,
+	__isl_keep isl_basic_map *bmap)
+{
+	if (!samples || !bmap->sample ||
+	    bmap->sample->size != samples->n_col)
+		return samples;
+	return isl_mat_vec_concat(samples, isl_vec_copy(bmap->sample));
+}
+
+/* Detect and make explicit all equalities satisfied by the (integer)
+ * points in each of the basic maps of "map".
+ *
+ * The basic maps of a map often share some of their integer points,
+ * so the sample points found for the basic maps that have already
+ * been handled are used to seed the computation for the remaining ones.
+ * Only basic maps with the same number of local variables
+ * as the first (handled) basic map are taken into account.
+ */
 __isl_give isl_map *isl_map_detect_equalities(__isl_take isl_map *map)
 {
-	return isl_map_inline_foreach_basic_map(map,
+	int i;
+	isl_size total;
+	isl_mat *samples;
+
+	if (!map)
+		return NULL;
+	if (map->n <= 1)
+		return isl_map_inline_foreach_basic_map(map,
 					    &isl_basic_map_detect_equalities);
+
+	total = isl_basic_map_dim(map->p[map->n - 1], isl_dim_all);
+	if (total < 0)
+		return isl_map_free(map);
+	samples = isl_mat_alloc(isl_map_get_ctx(map), 0, 1 + total);
+	for (i = map->n - 1; i >= 0; --i) {
+		isl_basic_map *bmap;
+
+		bmap = isl_basic_map_copy(map->p[i]);
+		bmap = isl_basic_map_detect_equalities_with_samples(bmap,
+								    samples);
+		if (!bmap)
+			goto error;
+		samples = add_sample(samples, bmap);
+		isl_basic_map_free(map->p[i]);
+		map->p[i] = bmap;
+		if (!samples)
+			goto error;
+	}
+
+	isl_mat_free(samples);
+	return isl_map_remove_empty_parts(map);
+error:
+	isl_mat_free(samples);
+	isl_map_free(map);
+	return NULL;
 }
 
 __isl_give isl_set *isl_set_detect_equalities(__isl_take isl_set *set)
@@ -19,8 +19,12 @@
 #include <isl/map.h>
 #include <isl/union_set.h>
 #include <isl/union_map.h>
+#include <isl/hash.h>
+#include <isl_ctx_private.h>
 #include <isl_ast_build_private.h>
 #include <isl_ast_private.h>
+#include <isl_ast_graft_private.h>
+#include <isl_schedule_node_private.h>
 #include <isl_config.h>
 
 /* Construct a map that isolates the current dimension.
@@ -46,6 +50,93 @@ __isl_give isl_map *isl_ast_build_map_to_iterator(
 	return map;
 }
 
+/* An entry in the stride cache of an isl_ast_build,
+ * recording that the stride information of "set" at position "pos"
+ * consists of the stride "stride" and the offset "offset".
+ */
+struct isl_ast_build_stride_entry {
+	isl_set *set;
+	int pos;
+	isl_val *stride;
+	isl_aff *offset;
+};
+
+/* A cache of the stride information detected by
+ * isl_ast_build_detect_strides, shared by all isl_ast_build objects
+ * derived from the same isl_ast_build_from_context call.
+ *
+ * "table" contains the cache entries, hashed on the set and the position.
+ */
+struct isl_ast_build_stride_cache {
+	int ref;
+	isl_ctx *ctx;
+
+	struct isl_hash_table table;
+};
+
+/* Create an empty stride cache.
+ */
+static struct isl_ast_build_stride_cache *isl_ast_build_stride_cache_alloc(
+	isl_ctx *ctx)
+{
+	struct isl_ast_build_stride_cache *cache;
+
+	cache = isl_calloc_type(ctx, struct isl_ast_build_stride_cache);
+	if (!cache)
+		return NULL;
+	cache->ref = 1;
+	cache->ctx = ctx;
+	if (isl_hash_table_init(ctx, &cache->table, 4) < 0) {
+		free(cache);
+		return NULL;
+	}
+
+	return cache;
+}
+
+static struct isl_ast_build_stride_cache *isl_ast_build_stride_cache_copy(
+	struct isl_ast_build_stride_cache *cache)
+{
+	if (!cache)
+		return NULL;
+
+	cache->ref++;
+	return cache;
+}
+
+/* isl_hash_table_foreach callback for freeing the stride cache entry
+ * that "entry" points to.
+ */
+static isl_stat free_stride_entry(void **entry, void *user)
+{
+	struct isl_ast_build_stride_entry *stride_entry = *entry;
+
+	isl_set_free(stride_entry->set);
+	isl_val_free(stride_entry->stride);
+	isl_aff_free(stride_entry->offset);
+	free(stride_entry);
+
+	return isl_stat_ok;
+}
+
+static struct isl_ast_build_stride_cache *isl_ast_build_stride_cache_free(
+	struct isl_ast_build_stride_cache *cache)
+{
+	isl_ctx *ctx;
+
+	if (!cache)
+		return NULL;
+	if (--cache->ref > 0)
+		return NULL;
+
+	ctx = cache->ctx;
+	isl_hash_table_foreach(ctx, &cache->table, &free_stride_entry, NULL);
+	isl_hash_table_clear(&cache->table);
+	free(cache);
+
+	return NULL;
+}
+
 /* Initialize the information derived during the AST generation to default
  * values for a schedule domain in "space".
  *
@@ -83,7 +174,8 @@ static __isl_give isl_ast_build *isl_ast_build_init_derived(
 
 	if (!build->iterators || !build->domain || !build->generated ||
 	    !build->pending || !build->values || !build->internal2input ||
-	    !build->strides || !build->offsets || !build->options)
+	    !build->strides || !build->offsets || !build->options ||
+	    !build->stride_cache)
 		return isl_ast_build_free(build);
 
 	return build;
@@ -140,6 +232,7 @@ __isl_give isl_ast_build *isl_ast_build_from_context(__isl_take isl_set *set)
 	build->generated = isl_set_copy(build->domain);
 	build->pending = isl_set_universe(isl_set_get_space(build->domain));
 	build->options = isl_union_map_empty(isl_space_params_alloc(ctx, 0));
+	build->stride_cache = isl_ast_build_stride_cache_alloc(ctx);
 	build->depth = n;
 	build->iterators = isl_id_list_alloc(ctx, n);
 	for (i = 0; i < n; ++i) {
@@ -220,9 +313,15 @@ __isl_give isl_ast_build *isl_ast_build_dup(__isl_keep isl_ast_build *build)
 	dup->before_each_mark_user = build->before_each_mark_user;
 	dup->after_each_mark = build->after_each_mark;
 	dup->after_each_mark_user = build->after_each_mark_user;
+	dup->after_each_if = build->after_each_if;
+	dup->after_each_if_user = build->after_each_if_user;
 	dup->create_leaf = build->create_leaf;
 	dup->create_leaf_user = build->create_leaf_user;
 	dup->node = isl_schedule_node_copy(build->node);
+	dup->subtree_cache = isl_ast_build_subtree_cache_copy(
+						build->subtree_cache);
+	dup->stride_cache = isl_ast_build_stride_cache_copy(
+						build->stride_cache);
 	if (build->loop_type) {
 		int i;
 
@@ -289,13 +388,632 @@ error:
 	return NULL;
 }
 
+/* An entry in a cache of ASTs generated for schedule subtrees.
+ * "tree" is the schedule subtree, "executed" the inverse schedule
+ * from which the AST was generated and "build" a copy
+ * of the isl_ast_build from which the AST was generated,
+ * without a reference to the cache.
+ * "list" contains the generated AST.
+ * "generation" is the most recent generation (see below)
+ * in which the entry was added or used.
+ */
+struct isl_ast_build_subtree_entry {
+	isl_schedule_tree *tree;
+	isl_union_map *executed;
+	isl_ast_build *build;
+	isl_ast_graft_list *list;
+	int generation;
+};
+
+/* A cache of ASTs generated for schedule subtrees,
+ * shared by all isl_ast_build objects derived from
+ * the one on which isl_ast_build_set_reuse_subtrees was called.
+ *
+ * "table" contains the cache entries, hashed on the address of the subtree.
+ * "active" is the number of AST generations that are currently
+ * using the cache.  These may be nested.
+ * "generation" is incremented whenever "active" becomes non-zero.
+ */
+struct isl_ast_build_subtree_cache {
+	int ref;
+	isl_ctx *ctx;
+
+	struct isl_hash_table table;
+	int active;
+	int generation;
+};
+
+/* Free the subtree cache entry that "entry" points to.
+ */
+static void free_subtree_entry(struct isl_ast_build_subtree_entry *entry)
+{
+	isl_schedule_tree_free(entry->tree);
+	isl_union_map_free(entry->executed);
+	isl_ast_build_free(entry->build);
+	isl_ast_graft_list_free(entry->list);
+	free(entry);
+}
+
+/* isl_hash_table_foreach callback for freeing the subtree cache entry
+ * that "entry" points to.
+ */
+static isl_stat free_subtree_entry_entry(void **entry, void *user)
+{
+	free_subtree_entry(*entry);
+	return isl_stat_ok;
+}
+
+__isl_give struct isl_ast_build_subtree_cache *
+isl_ast_build_subtree_cache_copy(struct isl_ast_build_subtree_cache *cache)
+{
+	if (!cache)
+		return NULL;
+
+	cache->ref++;
+	return cache;
+}
+
+__isl_null struct isl_ast_build_subtree_cache *
+isl_ast_build_subtree_cache_free(struct isl_ast_build_subtree_cache *cache)
+{
+	isl_ctx *ctx;
+
+	if (!cache)
+		return NULL;
+	if (--cache->ref > 0)
+		return NULL;
+
+	ctx = cache->ctx;
+	isl_hash_table_foreach(ctx, &cache->table,
+				&free_subtree_entry_entry, NULL);
+	isl_hash_table_clear(&cache->table);
+	free(cache);
+
+	return NULL;
+}
+
+/* Enable or disable the reuse of ASTs generated for schedule subtrees
+ * in AST generations from a schedule tree using "build" or
+ * an isl_ast_build derived from "build" depending on "reuse".
+ * Enabling reuse on an isl_ast_build that already has a cache
+ * keeps the contents of the cache.
+ */
+__isl_give isl_ast_build *isl_ast_build_set_reuse_subtrees(
+	__isl_take isl_ast_build *build, int reuse)
+{
+	isl_ctx *ctx;
+	struct isl_ast_build_subtree_cache *cache;
+
+	if (!build)
+		return NULL;
+	if (!reuse == !build->subtree_cache)
+		return build;
+	build = isl_ast_build_cow(build);
+	if (!build)
+		return NULL;
+	if (!reuse) {
+		build->subtree_cache =
+			isl_ast_build_subtree_cache_free(build->subtree_cache);
+		return build;
+	}
+
+	ctx = isl_ast_build_get_ctx(build);
+	cache = isl_calloc_type(ctx, struct isl_ast_build_subtree_cache);
+	if (!cache)
+		return isl_ast_build_free(build);
+	cache->ref = 1;
+	cache->ctx = ctx;
+	if (isl_hash_table_init(ctx, &cache->table, 4) < 0) {
+		free(cache);
+		return isl_ast_build_free(build);
+	}
+	build->subtree_cache = cache;
+
+	return build;
+}
+
+/* Are "id1" and "id2" the same?
+ */
+static isl_bool id_is_equal(__isl_keep isl_id *id1, __isl_keep isl_id *id2)
+{
+	return isl_bool_ok(id1 == id2);
+}
+
+/* Do "list1" and "list2" contain the same identifiers?
+ */
+static isl_bool id_list_is_equal(__isl_keep isl_id_list *list1,
+	__isl_keep isl_id_list *list2)
+{
+	int i;
+	isl_size n1, n2;
+
+	n1 = isl_id_list_n_id(list1);
+	n2 = isl_id_list_n_id(list2);
+	if (n1 < 0 || n2 < 0)
+		return isl_bool_error;
+	if (n1 != n2)
+		return isl_bool_false;
+	for (i = 0; i < n1; ++i) {
+		isl_id *id1, *id2;
+		isl_bool equal;
+
+		id1 = isl_id_list_get_at(list1, i);
+		id2 = isl_id_list_get_at(list2, i);
+		equal = id_is_equal(id1, id2);
+		isl_id_free(id1);
+		isl_id_free(id2);
+		if (equal < 0 || !equal)
+			return equal;
+	}
+
+	return isl_bool_true;
+}
+
+/* Are "set1" and "set2" obviously equal, where either may be NULL?
+ */
+static isl_bool opt_set_is_equal(__isl_keep isl_set *set1,
+	__isl_keep isl_set *set2)
+{
+	if (!set1 || !set2)
+		return isl_bool_ok(set1 == set2);
+	return isl_set_plain_is_equal(set1, set2);
+}
+
+/* Are "ma1" and "ma2" obviously equal, where either may be NULL?
+ */
+static isl_bool opt_multi_aff_is_equal(__isl_keep isl_multi_aff *ma1,
+	__isl_keep isl_multi_aff *ma2)
+{
+	if (!ma1 || !ma2)
+		return isl_bool_ok(ma1 == ma2);
+	return isl_multi_aff_plain_is_equal(ma1, ma2);
+}
+
+/* Are "pa1" and "pa2" obviously equal, where either may be NULL?
+ */
+static isl_bool opt_pw_aff_is_equal(__isl_keep isl_pw_aff *pa1,
+	__isl_keep isl_pw_aff *pa2)
+{
+	if (!pa1 || !pa2)
+		return isl_bool_ok(pa1 == pa2);
+	return isl_pw_aff_plain_is_equal(pa1, pa2);
+}
+
+/* Do "build1" and "build2" have the same callbacks?
+ */
+static isl_bool has_equal_callbacks(__isl_keep isl_ast_build *build1,
+	__isl_keep isl_ast_build *build2)
+{
+	return isl_bool_ok(
+	    build1->at_each_domain == build2->at_each_domain &&
+	    build1->at_each_domain_user == build2->at_each_domain_user &&
+	    build1->before_each_for == build2->before_each_for &&
+	    build1->before_each_for_user == build2->before_each_for_user &&
+	    build1->after_each_for == build2->after_each_for &&
+	    build1->after_each_for_user == build2->after_each_for_user &&
+	    build1->before_each_mark == build2->before_each_mark &&
+	    build1->before_each_mark_user == build2->before_each_mark_user &&
+	    build1->after_each_mark == build2->after_each_mark &&
+	    build1->after_each_mark_user == build2->after_each_mark_user &&
+	    build1->after_each_if == build2->after_each_if &&
+	    build1->after_each_if_user == build2->after_each_if_user &&
+	    build1->create_leaf == build2->create_leaf &&
+	    build1->create_leaf_user == build2->create_leaf_user);
+}
+
+/* Do "build1" and "build2" obviously represent the same context
+ * for generating an AST?
+ * That is, are all fields that affect the generated AST obviously equal?
+ * build->executed is not taken into account since it is only
+ * used by callbacks.
+ */
+static isl_bool isl_ast_build_plain_is_equal_context(
+	__isl_keep isl_ast_build *build1, __isl_keep isl_ast_build *build2)
+{
+	int i;
+	isl_bool equal;
+
+	if (!build1 || !build2)
+		return isl_bool_error;
+	if (build1 == build2)
+		return isl_bool_true;
+	if (build1->outer_pos != build2->outer_pos ||
+	    build1->depth != build2->depth ||
+	    build1->single_valued != build2->single_valued ||
+	    build1->n != build2->n)
+		return isl_bool_false;
+	for (i = 0; i < build1->n; ++i)
+		if (build1->loop_type[i] != build2->loop_type[i])
+			return isl_bool_false;
+	equal = has_equal_callbacks(build1, build2);
+	if (equal >= 0 && equal)
+		equal = id_list_is_equal(build1->iterators, build2->iterators);
+	if (equal >= 0 && equal)
+		equal = isl_set_plain_is_equal(build1->domain, build2->domain);
+	if (equal >= 0 && equal)
+		equal = isl_set_plain_is_equal(build1->generated,
+						build2->generated);
+	if (equal >= 0 && equal)
+		equal = isl_set_plain_is_equal(build1->pending, build2->pending);
+	if (equal >= 0 && equal)
+		equal = isl_multi_aff_plain_is_equal(build1->values,
+						build2->values);
+	if (equal >= 0 && equal)
+		equal = opt_pw_aff_is_equal(build1->value, build2->value);
+	if (equal >= 0 && equal)
+		equal = isl_vec_is_equal(build1->strides, build2->strides);
+	if (equal >= 0 && equal)
+		equal = isl_multi_aff_plain_is_equal(build1->offsets,
+						build2->offsets);
+	if (equal >= 0 && equal)
+		equal = opt_multi_aff_is_equal(build1->internal2input,
+						build2->internal2input);
+	if (equal >= 0 && equal)
+		equal = isl_union_map_plain_is_equal(build1->options,
+						build2->options);
+	if (equal >= 0 && equal)
+		equal = opt_set_is_equal(build1->isolated, build2->isolated);
+	if (equal >= 0 && equal && (build1->node || build2->node)) {
+		if (!build1->node || !build2->node)
+			return isl_bool_false;
+		equal = isl_schedule_node_is_equal(build1->node, build2->node);
+	}
+
+	return equal;
+}
+
+/* Internal data structure for isl_ast_build_find_subtree.
+ *
+ * "tree" is the schedule subtree that is being looked up.
+ * "executed" and "build" are the inverse schedule and isl_ast_build
+ * from which the AST is about to be generated.
+ */
+struct isl_ast_build_subtree_key {
+	isl_schedule_tree *tree;
+	isl_union_map *executed;
+	isl_ast_build *build;
+};
+
+/* isl_hash_table_find callback for looking up the subtree cache entry
+ * corresponding to the key "val".
+ * Any error in the comparison is treated as a mismatch.
+ */
+static isl_bool has_subtree_key(const void *entry, const void *val)
+{
+	const struct isl_ast_build_subtree_entry *subtree_entry = entry;
+	const struct isl_ast_build_subtree_key *key = val;
+	isl_bool equal;
+
+	if (subtree_entry->tree != key->tree)
+		return isl_bool_false;
+	equal = isl_union_map_plain_is_equal(subtree_entry->executed,
+						key->executed);
+	if (equal >= 0 && equal)
+		equal = isl_ast_build_plain_is_equal_context(
+					subtree_entry->build, key->build);
+	if (equal < 0) {
+		isl_ctx *ctx = isl_ast_build_get_ctx(key->build);
+		isl_ctx_reset_error(ctx);
+		return isl_bool_false;
+	}
+	return equal;
+}
+
+/* Return the hash value of the address of "tree".
+ */
+static uint32_t subtree_hash(isl_schedule_tree *tree)
+{
+	uint32_t hash;
+
+	hash = isl_hash_init();
+	isl_hash_builtin(hash, tree);
+	return hash;
+}
+
+/* Look up the AST previously generated for the subtree at "node"
+ * from the inverse schedule "executed" and "build".
+ * Return a copy of this AST if it can be found or
+ * NULL if there is no such AST (or if reuse has not been enabled).
+ * The copy has fresh grafts because grafts may be modified in place.
+ */
+__isl_give isl_ast_graft_list *isl_ast_build_find_subtree(
+	__isl_keep isl_ast_build *build, __isl_keep isl_schedule_node *node,
+	__isl_keep isl_union_map *executed)
+{
+	isl_ctx *ctx;
+	struct isl_ast_build_subtree_cache *cache;
+	struct isl_ast_build_subtree_key key;
+	struct isl_hash_table_entry *entry;
+	struct isl_ast_build_subtree_entry *subtree_entry;
+
+	if (!build || !build->subtree_cache || !node || !executed)
+		return NULL;
+
+	ctx = isl_ast_build_get_ctx(build);
+	cache = build->subtree_cache;
+	key.tree = isl_schedule_node_get_tree(node);
+	key.executed = executed;
+	key.build = build;
+	entry = isl_hash_table_find(ctx, &cache->table, subtree_hash(key.tree),
+				    &has_subtree_key, &key, 0);
+	isl_schedule_tree_free(key.tree);
+	if (!entry || entry == isl_hash_table_entry_none)
+		return NULL;
+
+	ctx->stats->ast_subtree_reuses++;
+	subtree_entry = entry->data;
+	subtree_entry->generation = cache->generation;
+	return isl_ast_graft_list_dup_grafts(subtree_entry->list);
+}
+
+/* Record that "list" was generated for the subtree at "node"
+ * from the inverse schedule "executed" and "build",
+ * provided reuse has been enabled.
+ */
+isl_stat isl_ast_build_add_subtree(__isl_keep isl_ast_build *build,
+	__isl_keep isl_schedule_node *node, __isl_keep isl_union_map *executed,
+	__isl_keep isl_ast_graft_list *list)
+{
+	isl_ctx *ctx;
+	struct isl_ast_build_subtree_cache *cache;
+	struct isl_ast_build_subtree_key key;
+	struct isl_hash_table_entry *entry;
+	struct isl_ast_build_subtree_entry *subtree_entry;
+
+	if (!build || !node || !executed || !list)
+		return isl_stat_error;
+	if (!build->subtree_cache)
+		return isl_stat_ok;
+
+	ctx = isl_ast_build_get_ctx(build);
+	cache = build->subtree_cache;
+	key.tree = isl_schedule_node_get_tree(node);
+	key.executed = executed;
+	key.build = build;
+	entry = isl_hash_table_find(ctx, &cache->table, subtree_hash(key.tree),
+				    &has_subtree_key, &key, 1);
+	if (!entry || entry->data) {
+		isl_schedule_tree_free(key.tree);
+		return entry ? isl_stat_ok : isl_stat_error;
+	}
+
+	subtree_entry = isl_calloc_type(ctx, struct isl_ast_build_subtree_entry);
+	if (!subtree_entry) {
+		isl_schedule_tree_free(key.tree);
+		isl_hash_table_remove(ctx, &cache->table, entry);
+		return isl_stat_error;
+	}
+	entry->data = subtree_entry;
+	subtree_entry->tree = key.tree;
+	subtree_entry->executed = isl_union_map_copy(executed);
+	subtree_entry->build = isl_ast_build_dup(build);
+	if (subtree_entry->build)
+		subtree_entry->build->subtree_cache =
+		    isl_ast_build_subtree_cache_free(
+				subtree_entry->build->subtree_cache);
+	subtree_entry->list = isl_ast_graft_list_dup_grafts(list);
+	subtree_entry->generation = cache->generation;
+	if (!subtree_entry->executed || !subtree_entry->build ||
+	    !subtree_entry->list) {
+		isl_hash_table_remove(ctx, &cache->table, entry);
+		free_subtree_entry(subtree_entry);
+		return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Start an AST generation that may use the subtree cache of "build",
+ * if any.
+ * If no other AST generation is using the cache,
+ * then start a new generation of cache entries.
+ */
+void isl_ast_build_subtree_cache_enter(__isl_keep isl_ast_build *build)
+{
+	struct isl_ast_build_subtree_cache *cache;
+
+	if (!build || !build->subtree_cache)
+		return;
+	cache = build->subtree_cache;
+	if (cache->active++ == 0)
+		cache->generation++;
+}
+
+/* isl_hash_table_find callback that never finds a match,
+ * used for inserting entries that are known not to appear yet.
+ */
+static isl_bool no_match(const void *entry, const void *val)
+{
+	return isl_bool_false;
+}
+
+/* isl_hash_table_foreach callback for moving the subtree cache entry
+ * that "entry" points to to the hash table of the cache "user"
+ * if it was added or used in the current generation and
+ * for freeing the entry otherwise.
+ */
+static isl_stat move_or_free_subtree_entry(void **entry, void *user)
+{
+	struct isl_ast_build_subtree_cache *cache = user;
+	struct isl_ast_build_subtree_entry *subtree_entry = *entry;
+	struct isl_hash_table_entry *table_entry;
+
+	if (subtree_entry->generation != cache->generation) {
+		free_subtree_entry(subtree_entry);
+		return isl_stat_ok;
+	}
+	table_entry = isl_hash_table_find(cache->ctx, &cache->table,
+				subtree_hash(subtree_entry->tree),
+				&no_match, NULL, 1);
+	if (!table_entry) {
+		free_subtree_entry(subtree_entry);
+		return isl_stat_ok;
+	}
+	table_entry->data = subtree_entry;
+	return isl_stat_ok;
+}
+
+/* Finish an AST generation that may have used the subtree cache of "build",
+ * if any.
+ * If no other AST generation is using the cache,
+ * then remove all entries that were not added or used
+ * in the current generation, such that the cache only keeps
+ * the ASTs of subtrees that appear in the most recent schedule tree.
+ * The remaining entries are moved to a fresh hash table.
+ */
+void isl_ast_build_subtree_cache_leave(__isl_keep isl_ast_build *build)
+{
+	struct isl_ast_build_subtree_cache *cache;
+	struct isl_hash_table old;
+
+	if (!build || !build->subtree_cache)
+		return;
+	cache = build->subtree_cache;
+	if (--cache->active > 0)
+		return;
+	old = cache->table;
+	if (isl_hash_table_init(cache->ctx, &cache->table, old.n) < 0) {
+		cache->table = old;
+		return;
+	}
+	isl_hash_table_foreach(cache->ctx, &old,
+				&move_or_free_subtree_entry, cache);
+	isl_hash_table_clear(&old);
+}
+
+/* An entry in the expression cache of an isl_ast_build,
+ * mapping the piecewise affine expression "pa" to "expr".
+ */
+struct isl_ast_build_expr_cache_entry {
+	isl_pw_aff *pa;
+	isl_ast_expr *expr;
+};
+
+/* Free the expression cache entry that "entry" points to.
+ */
+static isl_stat free_expr_cache_entry(void **entry, void *user)
+{
+	struct isl_ast_build_expr_cache_entry *cache_entry = *entry;
+
+	isl_pw_aff_free(cache_entry->pa);
+	isl_ast_expr_free(cache_entry->expr);
+	free(cache_entry);
+
+	return isl_stat_ok;
+}
+
+/* Clear build->expr_cache.
+ * This needs to be called whenever "build" is modified
+ * since the cached expressions depend on the entire isl_ast_build.
+ */
+static void isl_ast_build_reset_expr_cache(__isl_keep isl_ast_build *build)
+{
+	isl_ctx *ctx;
+
+	if (!build || !build->expr_cache)
+		return;
+
+	ctx = isl_ast_build_get_ctx(build);
+	isl_hash_table_foreach(ctx, build->expr_cache,
+				&free_expr_cache_entry, NULL);
+	isl_hash_table_free(ctx, build->expr_cache);
+	build->expr_cache = NULL;
+}
+
+/* isl_hash_table_find callback for looking up the cache entry
+ * for the piecewise affine expression "val".
+ */
+static isl_bool has_pw_aff(const void *entry, const void *val)
+{
+	const struct isl_ast_build_expr_cache_entry *cache_entry = entry;
+	isl_pw_aff *pa = (isl_pw_aff *) val;
+
+	return isl_pw_aff_plain_is_equal(cache_entry->pa, pa);
+}
+
+/* Return a copy of the expression cached for "pa" in "build",
+ * or NULL if there is no such expression.
+ * Hits and misses are recorded in the statistics of the isl_ctx.
+ */
+__isl_give isl_ast_expr *isl_ast_build_expr_cache_find(
+	__isl_keep isl_ast_build *build, __isl_keep isl_pw_aff *pa)
+{
+	isl_ctx *ctx;
+	uint32_t hash;
+	struct isl_hash_table_entry *entry;
+	struct isl_ast_build_expr_cache_entry *cache_entry;
+
+	if (!build || !pa)
+		return NULL;
+
+	ctx = isl_ast_build_get_ctx(build);
+	if (!build->expr_cache) {
+		ctx->stats->ast_expr_cache_misses++;
+		return NULL;
+	}
+	hash = isl_pw_aff_get_hash(pa);
+	entry = isl_hash_table_find(ctx, build->expr_cache, hash,
+				    &has_pw_aff, pa, 0);
+	if (!entry || entry == isl_hash_table_entry_none) {
+		ctx->stats->ast_expr_cache_misses++;
+		return NULL;
+	}
+	ctx->stats->ast_expr_cache_hits++;
+	cache_entry = entry->data;
+	return isl_ast_expr_copy(cache_entry->expr);
+}
+
+/* Record "expr" as the expression corresponding to "pa" in "build".
+ */
+isl_stat isl_ast_build_expr_cache_add(__isl_keep isl_ast_build *build,
+	__isl_keep isl_pw_aff *pa, __isl_keep isl_ast_expr *expr)
+{
+	isl_ctx *ctx;
+	uint32_t hash;
+	struct isl_hash_table_entry *entry;
+	struct isl_ast_build_expr_cache_entry *cache_entry;
+
+	if (!build || !pa || !expr)
+		return isl_stat_error;
+
+	ctx = isl_ast_build_get_ctx(build);
+	if (!build->expr_cache)
+		build->expr_cache = isl_hash_table_alloc(ctx, 1);
+	if (!build->expr_cache)
+		return isl_stat_error;
+	hash = isl_pw_aff_get_hash(pa);
+	entry = isl_hash_table_find(ctx, build->expr_cache, hash,
+				    &has_pw_aff, pa, 1);
+	if (!entry)
+		return isl_stat_error;
+	if (entry->data)
+		return isl_stat_ok;
+	cache_entry = isl_alloc_type(ctx,
+				struct isl_ast_build_expr_cache_entry);
+	if (!cache_entry) {
+		isl_hash_table_remove(ctx, build->expr_cache, entry);
+		return isl_stat_error;
+	}
+	cache_entry->pa = isl_pw_aff_copy(pa);
+	cache_entry->expr = isl_ast_expr_copy(expr);
+	entry->data = cache_entry;
+
+	return isl_stat_ok;
+}
+
+/* Prepare "build" for modification.
+ * If "build" is not shared, then it is modified in place and
+ * any cached expressions are no longer valid.
+ */
 __isl_give isl_ast_build *isl_ast_build_cow(__isl_take isl_ast_build *build)
 {
 	if (!build)
 		return NULL;
 
-	if (build->ref == 1)
+	if (build->ref == 1) {
+		isl_ast_build_reset_expr_cache(build);
 		return build;
+	}
 	build->ref--;
 	return isl_ast_build_dup(build);
 }
@@ -309,6 +1027,7 @@ __isl_null isl_ast_build *isl_ast_build_free(
 	if (--build->ref > 0)
 		return NULL;
 
+	isl_ast_build_reset_expr_cache(build);
 	isl_id_list_free(build->iterators);
 	isl_set_free(build->domain);
 	isl_set_free(build->generated);
@@ -324,6 +1043,8 @@ __isl_null isl_ast_build *isl_ast_build_free(
 	isl_schedule_node_free(build->node);
 	free(build->loop_type);
 	isl_set_free(build->isolated);
+	isl_ast_build_subtree_cache_free(build->subtree_cache);
+	isl_ast_build_stride_cache_free(build->stride_cache);
 
 	free(build);
 
@@ -479,6 +1200,24 @@ __isl_give isl_ast_build *isl_ast_build_set_after_each_mark(
 	return build;
 }
 
+/* Set the "after_each_if" callback of "build" to "fn".
+ */
+__isl_give isl_ast_build *isl_ast_build_set_after_each_if(
+	__isl_take isl_ast_build *build,
+	__isl_give isl_ast_node *(*fn)(__isl_take isl_ast_node *node,
+		__isl_keep isl_ast_build *build, void *user), void *user)
+{
+	build = isl_ast_build_cow(build);
+
+	if (!build)
+		return NULL;
+
+	build->after_each_if = fn;
+	build->after_each_if_user = user;
+
+	return build;
+}
+
 /* Set the "create_leaf" callback of "build" to "fn".
  */
 __isl_give isl_ast_build *isl_ast_build_set_create_leaf(
@@ -523,6 +1262,8 @@ __isl_give isl_ast_build *isl_ast_build_clear_local_info(
 	build->before_each_mark_user = NULL;
 	build->after_each_mark = NULL;
 	build->after_each_mark_user = NULL;
+	build->after_each_if = NULL;
+	build->after_each_if_user = NULL;
 	build->create_leaf = NULL;
 	build->create_leaf_user = NULL;
 
@@ -1424,6 +2165,97 @@ __isl_give isl_ast_build *isl_ast_build_include_stride(
 	return build;
 }
 
+/* isl_hash_table_find callback for looking up the stride cache entry
+ * for the set and position in "val".
+ */
+static isl_bool has_set_at_pos(const void *entry, const void *val)
+{
+	const struct isl_ast_build_stride_entry *stride_entry = entry;
+	const struct isl_ast_build_stride_entry *key = val;
+
+	if (stride_entry->pos != key->pos)
+		return isl_bool_false;
+	return isl_set_plain_is_equal(stride_entry->set, key->set);
+}
+
+/* Return the hash value of the stride cache key formed by "set" and "pos".
+ */
+static uint32_t stride_entry_hash(__isl_keep isl_set *set, int pos)
+{
+	uint32_t hash;
+
+	hash = isl_set_get_hash(set);
+	isl_hash_hash(hash, pos);
+
+	return hash;
+}
+
+/* Compute the stride and offset of "set" at position "pos",
+ * reusing the result of a previous computation on the same set
+ * at the same position from any isl_ast_build derived
+ * from the same root as "build".
+ * Hits and misses are recorded in the statistics of the isl_ctx.
+ *
+ * Sets that are only plainly equal to a cached set are considered
+ * to be the same, which is the case in particular for copies.
+ * If anything goes wrong while adding an entry to the cache,
+ * then the result is still returned, just not cached.
+ */
+static isl_stat get_stride_info(__isl_keep isl_ast_build *build,
+	__isl_keep isl_set *set, int pos,
+	__isl_give isl_val **stride, __isl_give isl_aff **offset)
+{
+	isl_ctx *ctx;
+	uint32_t hash;
+	isl_stride_info *si;
+	struct isl_ast_build_stride_cache *cache;
+	struct isl_hash_table_entry *entry;
+	struct isl_ast_build_stride_entry key;
+	struct isl_ast_build_stride_entry *stride_entry;
+
+	ctx = isl_ast_build_get_ctx(build);
+	cache = build->stride_cache;
+	key.set = set;
+	key.pos = pos;
+	hash = stride_entry_hash(set, pos);
+	entry = isl_hash_table_find(ctx, &cache->table, hash,
+				    &has_set_at_pos, &key, 0);
+	if (!entry)
+		return isl_stat_error;
+	if (entry != isl_hash_table_entry_none) {
+		ctx->stats->ast_stride_cache_hits++;
+		stride_entry = entry->data;
+		*stride = isl_val_copy(stride_entry->stride);
+		*offset = isl_aff_copy(stride_entry->offset);
+		return isl_stat_ok;
+	}
+	ctx->stats->ast_stride_cache_misses++;
+
+	si = isl_set_get_stride_info(set, pos);
+	*stride = isl_stride_info_get_stride(si);
+	*offset = isl_stride_info_get_offset(si);
+	isl_stride_info_free(si);
+	if (!*stride || !*offset)
+		return isl_stat_error;
+
+	stride_entry = isl_alloc_type(ctx, struct isl_ast_build_stride_entry);
+	if (!stride_entry)
+		return isl_stat_ok;
+	entry = isl_hash_table_find(ctx, &cache->table, hash,
+				    &has_set_at_pos, &key, 1);
+	if (!entry) {
+		free(stride_entry);
+		return isl_stat_ok;
+	}
+	stride_entry->set = isl_set_copy(set);
+	stride_entry->pos = pos;
+	stride_entry->stride = isl_val_copy(*stride);
+	stride_entry->offset = isl_aff_copy(*offset);
+	entry->data = stride_entry;
+
+	return isl_stat_ok;
+}
+
 /* Check if the constraints in "set" imply any stride on the current
  * dimension and, if so, record the stride information in "build"
  * and return the updated "build".
@@ -1434,24 +2266,28 @@ __isl_give isl_ast_build *isl_ast_build_include_stride(
  * the domain.
  * The assumption ensures that the lower bound does not depend
  * on inner dimensions.
+ *
+ * The same set is typically analyzed several times,
+ * e.g., by foreach_iteration and when the node is created,
+ * so the stride information is looked up in build->stride_cache first.
  */
 __isl_give isl_ast_build *isl_ast_build_detect_strides(
 	__isl_take isl_ast_build *build, __isl_take isl_set *set)
 {
 	isl_size pos;
 	isl_bool no_stride;
-	isl_val *stride;
-	isl_aff *offset;
-	isl_stride_info *si;
+	isl_val *stride = NULL;
+	isl_aff *offset = NULL;
 
 	pos = isl_ast_build_get_depth(build);
-	if (pos < 0)
+	if (pos < 0 || !set)
 		goto error;
 
-	si = isl_set_get_stride_info(set, pos);
-	stride = isl_stride_info_get_stride(si);
-	offset = isl_stride_info_get_offset(si);
-	isl_stride_info_free(si);
+	if (get_stride_info(build, set, pos, &stride, &offset) < 0) {
+		isl_val_free(stride);
+		isl_aff_free(offset);
+		goto error;
+	}
 	isl_set_free(set);
 
 	no_stride = isl_val_is_one(stride);
@@ -1464,7 +2300,7 @@ __isl_give isl_ast_build *isl_ast_build_detect_strides(
 	return build;
 error:
 	isl_set_free(set);
-	return NULL;
+	return isl_ast_build_free(build);
 }
 
 /* Does "map" not involve the input dimension data->depth?
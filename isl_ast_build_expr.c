@@ -727,7 +727,7 @@ static int mod_constraint_is_simpler(struct isl_extract_mod_data *data,
  * by a very large number, say the largest or smallest possible
  * variable in the representation of some integer type.
  */
-static isl_stat check_parallel_or_opposite(__isl_take isl_constraint *c,
+static isl_bool check_parallel_or_opposite(__isl_keep isl_constraint *c,
 	void *user)
 {
 	struct isl_extract_mod_data *data = user;
@@ -740,7 +740,7 @@ static isl_stat check_parallel_or_opposite(__isl_take isl_constraint *c,
 	for (t = 0; t < 2; ++t) {
 		n[t] = isl_constraint_dim(c, c_type[t]);
 		if (n[t] < 0)
-			return isl_stat_error;
+			return isl_bool_error;
 		for (i = 0; i < n[t]; ++i) {
 			int a, b;
 
@@ -790,12 +790,10 @@ static isl_stat check_parallel_or_opposite(__isl_take isl_constraint *c,
 		data->sign = parallel ? 1 : -1;
 	}
 
-	isl_constraint_free(c);
-
 	if (data->sign != 0 && data->nonneg == NULL)
-		return isl_stat_error;
+		return isl_bool_error;
 
-	return isl_stat_ok;
+	return isl_bool_true;
 }
 
 /* Given that data->v * div_i in data->aff is of the form
@@ -881,7 +879,7 @@ static int try_extract_mod(struct isl_extract_mod_data *data)
 {
 	isl_basic_set *hull;
 	isl_val *v1, *v2;
-	isl_stat r;
+	isl_bool r;
 	isl_size n;
 
 	if (!data->build)
@@ -898,7 +896,7 @@ static int try_extract_mod(struct isl_extract_mod_data *data)
 	hull = isl_basic_set_remove_divs(hull);
 	data->sign = 0;
 	data->nonneg = NULL;
-	r = isl_basic_set_foreach_constraint(hull, &check_parallel_or_opposite,
+	r = isl_basic_set_every_constraint(hull, &check_parallel_or_opposite,
 					data);
 	isl_basic_set_free(hull);
 
@@ -2272,7 +2270,7 @@ error:
  *
  * The domain of "pa" lives in the internal schedule space.
  */
-__isl_give isl_ast_expr *isl_ast_build_expr_from_pw_aff_internal(
+static __isl_give isl_ast_expr *expr_from_pw_aff(
 	__isl_keep isl_ast_build *build, __isl_take isl_pw_aff *pa)
 {
 	struct isl_from_pw_aff_data data = { NULL };
@@ -2299,6 +2297,33 @@ error:
 	return NULL;
 }
 
+/* Construct an isl_ast_expr that evaluates "pa".
+ * The result is simplified in terms of build->domain.
+ *
+ * The domain of "pa" lives in the internal schedule space.
+ *
+ * The same expressions are frequently constructed several times
+ * from the same isl_ast_build, e.g., for the bounds of sibling loops.
+ * Reuse any previously constructed expression for "pa" in "build".
+ */
+__isl_give isl_ast_expr *isl_ast_build_expr_from_pw_aff_internal(
+	__isl_keep isl_ast_build *build, __isl_take isl_pw_aff *pa)
+{
+	isl_ast_expr *res;
+
+	res = isl_ast_build_expr_cache_find(build, pa);
+	if (res) {
+		isl_pw_aff_free(pa);
+		return res;
+	}
+	res = expr_from_pw_aff(build, isl_pw_aff_copy(pa));
+	if (res && isl_ast_build_expr_cache_add(build, pa, res) < 0)
+		res = isl_ast_expr_free(res);
+	isl_pw_aff_free(pa);
+
+	return res;
+}
+
 /* Construct an isl_ast_expr that evaluates "pa".
  * The result is simplified in terms of build->domain.
  *
@@ -7,6 +7,7 @@
 #include <isl/set.h>
 #include <isl/list.h>
 #include <isl/schedule_node.h>
+#include <isl_ast_graft_private.h>
 
 /* An isl_ast_build represents the context in which AST is being
  * generated.  That is, it (mostly) contains information about outer
@@ -116,6 +117,9 @@
  * The "after_each_mark" callback is called after we have handled the subtree
  * of an isl_schedule_node_mark node.
  *
+ * The "after_each_if" callback is called on each if node
+ * after it has been created.
+ *
  * "executed" contains the inverse schedule at this point
  * of the AST generation.
  * It is currently only used in isl_ast_build_get_schedule, which is
@@ -141,6 +145,25 @@
  * "isolated" is the piece of the schedule domain isolated by the isolate
  * option on the current band.  This set may be NULL if we have not checked
  * for the isolate option yet.
+ *
+ * "subtree_cache" caches the ASTs generated for schedule subtrees
+ * across AST generations if isl_ast_build_set_reuse_subtrees
+ * was called.  It is shared by all isl_ast_build objects derived from
+ * the one on which this function was called.
+ * It is NULL if subtrees should not be reused.
+ *
+ * "stride_cache" caches the stride information detected
+ * by isl_ast_build_detect_strides, keyed on the set and the depth.
+ * Since this information only depends on the set and the depth,
+ * the cache is shared by all isl_ast_build objects derived from
+ * the same isl_ast_build_from_context call and it is not cleared
+ * when an isl_ast_build is modified.
+ *
+ * "expr_cache" caches the results of isl_ast_build_expr_from_pw_aff_internal
+ * for this isl_ast_build, keyed on the input piecewise affine expression.
+ * It may be NULL if no expressions have been cached yet.
+ * Like "schedule_map", it is not copied along with the isl_ast_build and
+ * it is cleared whenever the isl_ast_build is modified.
  */
 struct isl_ast_build {
 	int ref;
@@ -186,6 +209,11 @@ struct isl_ast_build {
 		__isl_keep isl_ast_build *context, void *user);
 	void *after_each_mark_user;
 
+	__isl_give isl_ast_node *(*after_each_if)(
+		__isl_take isl_ast_node *node,
+		__isl_keep isl_ast_build *context, void *user);
+	void *after_each_if_user;
+
 	__isl_give isl_ast_node *(*create_leaf)(
 		__isl_take isl_ast_build *build, void *user);
 	void *create_leaf_user;
@@ -197,8 +225,25 @@ struct isl_ast_build {
 	int n;
 	enum isl_ast_loop_type *loop_type;
 	isl_set *isolated;
+
+	struct isl_ast_build_subtree_cache *subtree_cache;
+	struct isl_ast_build_stride_cache *stride_cache;
+	struct isl_hash_table *expr_cache;
 };
 
+__isl_give struct isl_ast_build_subtree_cache *
+isl_ast_build_subtree_cache_copy(struct isl_ast_build_subtree_cache *cache);
+__isl_null struct isl_ast_build_subtree_cache *
+isl_ast_build_subtree_cache_free(struct isl_ast_build_subtree_cache *cache);
+void isl_ast_build_subtree_cache_enter(__isl_keep isl_ast_build *build);
+void isl_ast_build_subtree_cache_leave(__isl_keep isl_ast_build *build);
+__isl_give isl_ast_graft_list *isl_ast_build_find_subtree(
+	__isl_keep isl_ast_build *build, __isl_keep isl_schedule_node *node,
+	__isl_keep isl_union_map *executed);
+isl_stat isl_ast_build_add_subtree(__isl_keep isl_ast_build *build,
+	__isl_keep isl_schedule_node *node, __isl_keep isl_union_map *executed,
+	__isl_keep isl_ast_graft_list *list);
+
 __isl_give isl_ast_build *isl_ast_build_clear_local_info(
 	__isl_take isl_ast_build *build);
 __isl_give isl_ast_build *isl_ast_build_increase_depth(
@@ -255,6 +300,11 @@ int isl_ast_build_has_value(__isl_keep isl_ast_build *build);
 __isl_give isl_id *isl_ast_build_get_iterator_id(
 	__isl_keep isl_ast_build *build, int pos);
 
+__isl_give isl_ast_expr *isl_ast_build_expr_cache_find(
+	__isl_keep isl_ast_build *build, __isl_keep isl_pw_aff *pa);
+isl_stat isl_ast_build_expr_cache_add(__isl_keep isl_ast_build *build,
+	__isl_keep isl_pw_aff *pa, __isl_keep isl_ast_expr *expr);
+
 int isl_ast_build_has_schedule_node(__isl_keep isl_ast_build *build);
 __isl_give isl_schedule_node *isl_ast_build_get_schedule_node(
 	__isl_keep isl_ast_build *build);
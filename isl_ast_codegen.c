@@ -11,6 +11,8 @@
  */
 
 #include <limits.h>
+#include <isl_ctx_private.h>
+#include <isl_union_map_private.h>
 #include <isl/id.h>
 #include <isl/val.h>
 #include <isl/space.h>
@@ -466,6 +468,156 @@ static __isl_give isl_aff *lower_bound(__isl_keep isl_constraint *c,
 	return aff;
 }
 
+/* Internal data structure used inside collect_bound.
+ *
+ * "pos" is the position of the dimension that is being bounded.
+ * "upper" is set if upper bounds are being collected.
+ * "bound" collects the maximum of the lower bounds
+ * or the minimum of the upper bounds.  It is NULL initially.
+ */
+struct isl_ast_collect_bound_data {
+	int pos;
+	int upper;
+	isl_pw_aff *bound;
+};
+
+/* If "c" is a lower bound (or upper bound if data->upper is set)
+ * on dimension data->pos, then combine the corresponding integer bound
+ * with data->bound.
+ * An equality constraint involving the dimension is both
+ * a lower bound and an upper bound.
+ */
+static isl_stat collect_bound(__isl_take isl_constraint *c, void *user)
+{
+	struct isl_ast_collect_bound_data *data = user;
+	isl_bool is_bound;
+	isl_aff *aff;
+	isl_pw_aff *pa;
+
+	is_bound = isl_constraint_is_equality(c);
+	if (is_bound >= 0 && is_bound)
+		is_bound = isl_constraint_involves_dims(c,
+						isl_dim_set, data->pos, 1);
+	else if (is_bound >= 0 && data->upper)
+		is_bound = isl_constraint_is_upper_bound(c,
+						isl_dim_set, data->pos);
+	else if (is_bound >= 0)
+		is_bound = isl_constraint_is_lower_bound(c,
+						isl_dim_set, data->pos);
+	if (is_bound < 0 || !is_bound) {
+		isl_constraint_free(c);
+		return is_bound < 0 ? isl_stat_error : isl_stat_ok;
+	}
+
+	aff = isl_constraint_get_bound(c, isl_dim_set, data->pos);
+	isl_constraint_free(c);
+	if (data->upper)
+		aff = isl_aff_floor(aff);
+	else
+		aff = isl_aff_ceil(aff);
+	pa = isl_pw_aff_from_aff(aff);
+	if (!data->bound)
+		data->bound = pa;
+	else if (data->upper)
+		data->bound = isl_pw_aff_min(data->bound, pa);
+	else
+		data->bound = isl_pw_aff_max(data->bound, pa);
+
+	return isl_stat_non_null(data->bound);
+}
+
+/* Return the exact lower bound (or upper bound if "upper" is set)
+ * of dimension "pos" of the basic set "bset", which is assumed
+ * not to involve any local variables and to have such a bound.
+ *
+ * Since "bset" does not involve any local variables, the optimum
+ * is simply the largest lower bound (or the smallest upper bound)
+ * imposed by the constraints of "bset", rounded to an integer,
+ * on the elements of the outer dimensions for which "bset" is not empty.
+ * These elements are obtained by (exactly) eliminating dimension "pos"
+ * from "bset".
+ */
+static __isl_give isl_pw_aff *basic_set_bound(__isl_take isl_basic_set *bset,
+	int pos, int upper)
+{
+	struct isl_ast_collect_bound_data data = { pos, upper, NULL };
+	isl_set *dom;
+
+	if (isl_basic_set_foreach_constraint(bset, &collect_bound, &data) < 0)
+		data.bound = isl_pw_aff_free(data.bound);
+	bset = isl_basic_set_eliminate(bset, isl_dim_set, pos, 1);
+	dom = isl_set_from_basic_set(bset);
+
+	return isl_pw_aff_intersect_domain(data.bound, dom);
+}
+
+/* Return the exact lower bound (or upper bound if "upper" is set)
+ * of dimension "pos" of "set", which is assumed not to involve
+ * any local variables and to have such a bound in each of its disjuncts.
+ *
+ * The bound is computed on each disjunct separately
+ * and the results are combined into their minimum (or maximum).
+ */
+static __isl_give isl_pw_aff *plain_bound(__isl_take isl_set *set,
+	int pos, int upper)
+{
+	int i;
+	isl_size n;
+	isl_basic_set_list *list;
+	isl_pw_aff *pa = NULL;
+
+	list = isl_set_get_basic_set_list(set);
+	isl_set_free(set);
+	n = isl_basic_set_list_n_basic_set(list);
+	if (n < 0)
+		goto error;
+
+	for (i = 0; i < n; ++i) {
+		isl_basic_set *bset;
+		isl_pw_aff *pa_i;
+
+		bset = isl_basic_set_list_get_basic_set(list, i);
+		pa_i = basic_set_bound(bset, pos, upper);
+		if (!pa)
+			pa = pa_i;
+		else if (upper)
+			pa = isl_pw_aff_union_max(pa, pa_i);
+		else
+			pa = isl_pw_aff_union_min(pa, pa_i);
+	}
+
+	isl_basic_set_list_free(list);
+	return pa;
+error:
+	isl_basic_set_list_free(list);
+	return NULL;
+}
+
+/* Can the lower bound (or upper bound if "upper" is set)
+ * of dimension "pos" of "set" be computed by plain_bound?
+ * That is, does "set" not involve any local variables and
+ * does each of its disjuncts have a constraint that bounds
+ * the dimension in the right direction?
+ */
+static isl_bool has_plain_bound(__isl_keep isl_set *set, int pos, int upper)
+{
+	isl_bool locals;
+	isl_size n;
+
+	n = isl_set_n_basic_set(set);
+	if (n < 0)
+		return isl_bool_error;
+	if (n == 0)
+		return isl_bool_false;
+	locals = isl_set_involves_locals(set);
+	if (locals < 0 || locals)
+		return isl_bool_not(locals);
+	if (upper)
+		return isl_set_dim_has_upper_bound(set, isl_dim_set, pos);
+	else
+		return isl_set_dim_has_lower_bound(set, isl_dim_set, pos);
+}
+
 /* Return the exact lower bound (or upper bound if "upper" is set)
  * of "domain" as a piecewise affine expression.
  *
@@ -477,27 +629,46 @@ static __isl_give isl_aff *lower_bound(__isl_keep isl_constraint *c,
  * where f is the offset and s is the stride.
  * We therefore need to include the stride constraint before computing
  * the minimum.
+ *
+ * If the resulting set does not involve any local variables,
+ * then the bound can be read off directly from the constraints
+ * by plain_bound.  Otherwise, a parametric integer programming problem
+ * needs to be solved.
  */
 static __isl_give isl_pw_aff *exact_bound(__isl_keep isl_set *domain,
 	__isl_keep isl_ast_build *build, int upper)
 {
+	isl_size depth;
+	isl_bool plain;
 	isl_set *stride;
 	isl_map *it_map;
 	isl_pw_aff *pa;
 	isl_pw_multi_aff *pma;
 
+	depth = isl_ast_build_get_depth(build);
+	if (depth < 0)
+		return NULL;
+
 	domain = isl_set_copy(domain);
 	if (!upper) {
 		stride = isl_ast_build_get_stride_constraint(build);
 		domain = isl_set_intersect(domain, stride);
 	}
-	it_map = isl_ast_build_map_to_iterator(build, domain);
-	if (upper)
-		pma = isl_map_lexmax_pw_multi_aff(it_map);
-	else
-		pma = isl_map_lexmin_pw_multi_aff(it_map);
-	pa = isl_pw_multi_aff_get_pw_aff(pma, 0);
-	isl_pw_multi_aff_free(pma);
+	plain = has_plain_bound(domain, depth, upper);
+	if (plain < 0) {
+		domain = isl_set_free(domain);
+		pa = NULL;
+	} else if (plain) {
+		pa = plain_bound(domain, depth, upper);
+	} else {
+		it_map = isl_ast_build_map_to_iterator(build, domain);
+		if (upper)
+			pma = isl_map_lexmax_pw_multi_aff(it_map);
+		else
+			pma = isl_map_lexmin_pw_multi_aff(it_map);
+		pa = isl_pw_multi_aff_get_pw_aff(pma, 0);
+		isl_pw_multi_aff_free(pma);
+	}
 	pa = isl_ast_build_compute_gist_pw_aff(build, pa);
 	pa = isl_pw_aff_coalesce(pa);
 
@@ -1586,26 +1757,26 @@ struct isl_check_scaled_data {
 /* If constraint "c" involves the input dimension data->depth,
  * then make sure that all the other coefficients are multiples of data->m,
  * reducing data->m if needed.
- * Break out of the iteration if data->m has become equal to "1".
+ * Break out of the iteration (by returning isl_bool_false)
+ * if data->m has become equal to "1".
  */
-static isl_stat constraint_check_scaled(__isl_take isl_constraint *c,
+static isl_bool constraint_check_scaled(__isl_keep isl_constraint *c,
 	void *user)
 {
 	struct isl_check_scaled_data *data = user;
 	int i, j;
 	isl_size n;
+	isl_bool one;
 	enum isl_dim_type t[] = { isl_dim_param, isl_dim_in, isl_dim_out,
 				    isl_dim_div };
 
-	if (!isl_constraint_involves_dims(c, isl_dim_in, data->depth, 1)) {
-		isl_constraint_free(c);
-		return isl_stat_ok;
-	}
+	if (!isl_constraint_involves_dims(c, isl_dim_in, data->depth, 1))
+		return isl_bool_true;
 
 	for (i = 0; i < 4; ++i) {
 		n = isl_constraint_dim(c, t[i]);
 		if (n < 0)
-			break;
+			return isl_bool_error;
 		for (j = 0; j < n; ++j) {
 			isl_val *d;
 
@@ -1615,16 +1786,13 @@ static isl_stat constraint_check_scaled(__isl_take isl_constraint *c,
 				continue;
 			d = isl_constraint_get_coefficient_val(c, t[i], j);
 			data->m = isl_val_gcd(data->m, d);
-			if (isl_val_is_one(data->m))
-				break;
+			one = isl_val_is_one(data->m);
+			if (one < 0 || one)
+				return isl_bool_not(one);
 		}
-		if (j < n)
-			break;
 	}
 
-	isl_constraint_free(c);
-
-	return i < 4 ? isl_stat_error : isl_stat_ok;
+	return isl_bool_true;
 }
 
 /* For each constraint of "bmap" that involves the input dimension data->depth,
@@ -1632,16 +1800,11 @@ static isl_stat constraint_check_scaled(__isl_take isl_constraint *c,
  * reducing data->m if needed.
  * Break out of the iteration if data->m has become equal to "1".
  */
-static isl_stat basic_map_check_scaled(__isl_take isl_basic_map *bmap,
+static isl_bool basic_map_check_scaled(__isl_keep isl_basic_map *bmap,
 	void *user)
 {
-	isl_stat r;
-
-	r = isl_basic_map_foreach_constraint(bmap,
+	return isl_basic_map_every_constraint(bmap,
 						&constraint_check_scaled, user);
-	isl_basic_map_free(bmap);
-
-	return r;
 }
 
 /* For each constraint of "map" that involves the input dimension data->depth,
@@ -1649,14 +1812,9 @@ static isl_stat basic_map_check_scaled(__isl_take isl_basic_map *bmap,
  * reducing data->m if needed.
  * Break out of the iteration if data->m has become equal to "1".
  */
-static isl_stat map_check_scaled(__isl_take isl_map *map, void *user)
+static isl_bool map_check_scaled(__isl_keep isl_map *map, void *user)
 {
-	isl_stat r;
-
-	r = isl_map_foreach_basic_map(map, &basic_map_check_scaled, user);
-	isl_map_free(map);
-
-	return r;
+	return isl_map_every_basic_map(map, &basic_map_check_scaled, user);
 }
 
 /* Create an AST node for the current dimension based on
@@ -1737,9 +1895,8 @@ static __isl_give isl_ast_graft *create_node(__isl_take isl_union_map *executed,
 	}
 
 	if (!isl_val_is_one(data.m)) {
-		if (isl_union_map_foreach_map(executed, &map_check_scaled,
-						&data) < 0 &&
-		    !isl_val_is_one(data.m))
+		if (isl_union_map_every_map(executed, &map_check_scaled,
+						&data) < 0)
 			executed = isl_union_map_free(executed);
 	}
 
@@ -2061,6 +2218,184 @@ error:
 	return isl_stat_error;
 }
 
+/* Internal data structure for fixed_at_depth.
+ *
+ * "depth" is the current depth.
+ * "value" is set to the affine expression found by fixed_at_depth, if any.
+ */
+struct isl_fixed_at_depth_data {
+	int depth;
+	isl_aff *value;
+};
+
+/* If "c" is an equality constraint that expresses dimension data->depth
+ * in terms of the parameters and the outer dimensions only,
+ * then store this expression in data->value and abort the iteration.
+ */
+static isl_stat extract_fixed_at_depth(__isl_take isl_constraint *c,
+	void *user)
+{
+	struct isl_fixed_at_depth_data *data = user;
+	isl_bool eq, involves, inner, local;
+	isl_size dim, n_div;
+	isl_aff *aff;
+
+	dim = isl_constraint_dim(c, isl_dim_set);
+	n_div = isl_constraint_dim(c, isl_dim_div);
+	if (dim < 0 || n_div < 0)
+		goto error;
+	eq = isl_constraint_is_equality(c);
+	involves = isl_constraint_involves_dims(c, isl_dim_set, data->depth, 1);
+	inner = isl_constraint_involves_dims(c, isl_dim_set,
+				data->depth + 1, dim - (data->depth + 1));
+	local = isl_constraint_involves_dims(c, isl_dim_div, 0, n_div);
+	if (eq < 0 || involves < 0 || inner < 0 || local < 0)
+		goto error;
+	if (!eq || !involves || inner || local) {
+		isl_constraint_free(c);
+		return isl_stat_ok;
+	}
+
+	aff = isl_constraint_get_bound(c, isl_dim_set, data->depth);
+	isl_constraint_free(c);
+	n_div = isl_aff_dim(aff, isl_dim_div);
+	if (n_div < 0)
+		aff = isl_aff_free(aff);
+	else
+		aff = isl_aff_drop_dims(aff, isl_dim_div, 0, n_div);
+	data->value = aff;
+	return isl_stat_error;
+error:
+	isl_constraint_free(c);
+	return isl_stat_error;
+}
+
+/* If "bset" has an equality constraint that fixes dimension "depth"
+ * to an affine expression of the parameters and the outer dimensions,
+ * then return this expression.
+ * Otherwise, return a NaN expression.
+ * The iteration over the constraints is aborted
+ * by extract_fixed_at_depth as soon as such an expression is found.
+ */
+static __isl_give isl_aff *fixed_at_depth(__isl_keep isl_basic_set *bset,
+	int depth)
+{
+	struct isl_fixed_at_depth_data data = { depth, NULL };
+
+	if (isl_basic_set_foreach_constraint(bset,
+				&extract_fixed_at_depth, &data) >= 0)
+		return isl_aff_nan_on_domain_space(isl_basic_set_get_space(bset));
+	return data.value;
+}
+
+/* An element of the array sorted by sort_on_fixed_offset.
+ *
+ * "pos" is the position of the basic set in the original list.
+ * "offset" is the value of the current dimension of the basic set
+ * minus that of the first basic set in the list.
+ */
+struct isl_fixed_offset {
+	int pos;
+	isl_val *offset;
+};
+
+/* Compare two elements of the array sorted by sort_on_fixed_offset
+ * based on their offsets.
+ */
+static int cmp_fixed_offset(const void *a, const void *b, void *user)
+{
+	const struct isl_fixed_offset *fa = a;
+	const struct isl_fixed_offset *fb = b;
+
+	if (isl_val_lt(fa->offset, fb->offset))
+		return -1;
+	if (isl_val_gt(fa->offset, fb->offset))
+		return 1;
+	return fa->pos - fb->pos;
+}
+
+/* Check whether the order at depth "depth" of the basic sets in "list"
+ * can be determined without any emptiness tests and, if so,
+ * return the positions of the basic sets in this order.
+ * Otherwise, return NULL with *found set to 0.
+ *
+ * This is the case if each basic set fixes the current dimension
+ * to an affine expression of the parameters and the outer dimensions
+ * and if each of these expressions differs from that of the first basic set
+ * by a distinct constant.  The basic sets then need to be executed
+ * in increasing order of these constants.
+ * Since no two basic sets can coincide in the current dimension
+ * for equal values of the outer dimensions, there are no cycles and
+ * each basic set forms a strongly connected component by itself.
+ * This typically holds for the iterations of an unrolled loop,
+ * where each iteration is a slice at a fixed offset from the lower bound.
+ */
+static int *sort_on_fixed_offset(__isl_keep isl_basic_set_list *list,
+	int depth, int *found)
+{
+	int i;
+	isl_size n;
+	isl_ctx *ctx;
+	isl_aff *first = NULL;
+	struct isl_fixed_offset *array;
+	int *order = NULL;
+	int ok = 1;
+
+	*found = 0;
+	n = isl_basic_set_list_n_basic_set(list);
+	if (n < 0)
+		return NULL;
+	ctx = isl_basic_set_list_get_ctx(list);
+	array = isl_calloc_array(ctx, struct isl_fixed_offset, n);
+	if (!array)
+		return NULL;
+
+	for (i = 0; ok && i < n; ++i) {
+		isl_basic_set *bset;
+		isl_aff *aff;
+		isl_bool nan, cst;
+
+		bset = isl_basic_set_list_get_basic_set(list, i);
+		aff = fixed_at_depth(bset, depth);
+		isl_basic_set_free(bset);
+		nan = isl_aff_is_nan(aff);
+		if (nan < 0 || nan) {
+			isl_aff_free(aff);
+			ok = 0;
+			break;
+		}
+		if (i == 0)
+			first = isl_aff_copy(aff);
+		aff = isl_aff_sub(aff, isl_aff_copy(first));
+		cst = isl_aff_is_cst(aff);
+		if (cst >= 0 && cst)
+			array[i].offset = isl_aff_get_constant_val(aff);
+		isl_aff_free(aff);
+		array[i].pos = i;
+		if (cst < 0 || !cst || !array[i].offset)
+			ok = 0;
+	}
+	isl_aff_free(first);
+
+	if (ok && isl_sort(array, n, sizeof(array[0]),
+			    &cmp_fixed_offset, NULL) < 0)
+		ok = 0;
+	for (i = 1; ok && i < n; ++i)
+		if (isl_val_eq(array[i - 1].offset, array[i].offset))
+			ok = 0;
+	if (ok)
+		order = isl_alloc_array(ctx, int, n);
+	for (i = 0; order && i < n; ++i)
+		order[i] = array[i].pos;
+	if (order)
+		*found = 1;
+
+	for (i = 0; i < n; ++i)
+		isl_val_free(array[i].offset);
+	free(array);
+	return order;
+}
+
 /* Sort the domains in "domain_list" according to the execution order
  * at the current depth (for equal values of the outer dimensions),
  * generate code for each of them, collecting the results in a list.
@@ -2073,11 +2408,20 @@ error:
  * dimensions and the other way for some other value of the outer dimensions.
  * We therefore play safe and look for strongly connected components.
  * The function add_nodes takes care of handling non-trivial components.
+ *
+ * Looking for strongly connected components requires an emptiness test
+ * for each pair of basic sets, which is prohibitively expensive
+ * for the many iterations of a loop that is being unrolled.
+ * If sort_on_fixed_offset can determine the order directly,
+ * then code is generated for each basic set in this order instead.
  */
 static __isl_give isl_ast_graft_list *generate_sorted_domains(
 	__isl_keep isl_basic_set_list *domain_list,
 	__isl_keep isl_union_map *executed, __isl_keep isl_ast_build *build)
 {
+	int i;
+	int found;
+	int *order;
 	isl_ctx *ctx;
 	struct isl_add_nodes_data data;
 	isl_size depth;
@@ -2097,9 +2441,23 @@ static __isl_give isl_ast_graft_list *generate_sorted_domains(
 			isl_ast_build_copy(build));
 
 	depth = isl_ast_build_get_depth(build);
+	if (depth < 0)
+		return isl_ast_graft_list_free(data.list);
+	order = sort_on_fixed_offset(domain_list, depth, &found);
+	if (found) {
+		for (i = 0; i < n; ++i)
+			data.list = add_node(data.list,
+			    isl_union_map_copy(executed),
+			    isl_basic_set_list_get_basic_set(domain_list,
+								order[i]),
+			    isl_ast_build_copy(build));
+		free(order);
+		return data.list;
+	}
+
 	data.executed = executed;
 	data.build = build;
-	if (depth < 0 || isl_basic_set_list_foreach_scc(domain_list,
+	if (isl_basic_set_list_foreach_scc(domain_list,
 					&domain_follows_at_depth, &depth,
 					&add_nodes, &data) < 0)
 		data.list = isl_ast_graft_list_free(data.list);
@@ -2546,16 +2904,16 @@ static isl_stat update_unrolling_lower_bound(struct isl_find_unroll_data *data,
 /* Check if we can use "c" as a lower bound and if it is better than
  * any previously found lower bound.
  */
-static isl_stat constraint_find_unroll(__isl_take isl_constraint *c, void *user)
+static isl_bool constraint_find_unroll(__isl_keep isl_constraint *c,
+	void *user)
 {
 	struct isl_find_unroll_data *data;
-	isl_stat r;
 
 	data = (struct isl_find_unroll_data *) user;
-	r = update_unrolling_lower_bound(data, c);
-	isl_constraint_free(c);
+	if (update_unrolling_lower_bound(data, c) < 0)
+		return isl_bool_error;
 
-	return r;
+	return isl_bool_true;
 }
 
 /* Look for a lower bound l(i) on the dimension at "depth"
@@ -2592,7 +2950,7 @@ static __isl_give isl_aff *find_unroll_lower_bound(
 
 	hull = isl_set_simple_hull(isl_set_copy(domain));
 
-	if (isl_basic_set_foreach_constraint(hull,
+	if (isl_basic_set_every_constraint(hull,
 					    &constraint_find_unroll, &data) < 0)
 		goto error;
 
@@ -2784,6 +3142,9 @@ static int do_unroll_iteration(__isl_take isl_basic_set *bset, void *user)
  * in do_unroll_iteration we collect the individual basic sets in
  * domains->list and their union in data->unroll_domain, which is then
  * used to update the class domain.
+ * The union is coalesced first since the slices can typically
+ * be combined into a few basic sets, while the cost of subtracting
+ * the individual slices grows quadratically in their number.
  */
 static __isl_give isl_set *do_unroll(struct isl_codegen_domains *domains,
 	__isl_take isl_set *domain, __isl_take isl_set *class_domain)
@@ -2803,6 +3164,7 @@ static __isl_give isl_set *do_unroll(struct isl_codegen_domains *domains,
 				&do_unroll_iteration, &data) < 0)
 		data.unroll_domain = isl_set_free(data.unroll_domain);
 
+	data.unroll_domain = isl_set_coalesce(data.unroll_domain);
 	class_domain = isl_set_subtract(class_domain, data.unroll_domain);
 
 	return class_domain;
@@ -3332,6 +3694,55 @@ static isl_bool has_pure_outer_disjunction(__isl_keep isl_set *domain,
 	return equal;
 }
 
+/* Generate code for a single component, after shifting (if any)
+ * has been applied, with schedule domain "domain", in case
+ * the schedule domain is simply combined into a single basic set
+ * (if "atomic" is set) or split into disjoint basic sets.
+ *
+ * Inner dimensions and divs involving the current dimensions
+ * are eliminated first.
+ * Finally an AST is generated for each basic set and the results are
+ * concatenated.
+ *
+ * If the schedule domain involves a disjunction that is purely based on
+ * constraints involving only outer dimension, then it is treated as
+ * if "atomic" was set.  This ensures that only a single loop
+ * is generated instead of a sequence of identical loops with
+ * different guards.
+ */
+static __isl_give isl_ast_graft_list *generate_shifted_component_default(
+	__isl_take isl_union_map *executed, __isl_take isl_set *domain,
+	__isl_take isl_ast_build *build, int atomic)
+{
+	isl_bool outer_disjunction;
+	isl_basic_set_list *domain_list;
+	isl_ast_graft_list *list;
+
+	domain = isl_ast_build_eliminate(build, domain);
+	domain = isl_set_coalesce_preserve(domain);
+
+	outer_disjunction = has_pure_outer_disjunction(domain, build);
+	if (outer_disjunction < 0)
+		domain = isl_set_free(domain);
+
+	if (outer_disjunction || atomic) {
+		isl_basic_set *hull;
+		hull = isl_set_unshifted_simple_hull(domain);
+		domain_list = isl_basic_set_list_from_basic_set(hull);
+	} else {
+		domain = isl_set_make_disjoint(domain);
+		domain_list = isl_basic_set_list_from_set(domain);
+	}
+
+	list = generate_parallel_domains(domain_list, executed, build);
+
+	isl_basic_set_list_free(domain_list);
+	isl_union_map_free(executed);
+	isl_ast_build_free(build);
+
+	return list;
+}
+
 /* Generate code for a single component, after shifting (if any)
  * has been applied, in case the schedule was specified as a schedule tree.
  * In particular, handle the base case where there is either no isolated
@@ -3351,28 +3762,15 @@ static isl_bool has_pure_outer_disjunction(__isl_keep isl_set *domain,
  * generate_shifted_component_tree_unroll which needs the actual
  * schedule domain (with divs that may refer to the current dimension)
  * so that stride detection can be performed.
- * In the atomic or unspecified case, inner dimensions and divs involving
- * the current dimensions should be eliminated.
- * The result is then either combined into a single basic set or
- * split up into disjoint basic sets.
- * Finally an AST is generated for each basic set and the results are
- * concatenated.
- *
- * If the schedule domain involves a disjunction that is purely based on
- * constraints involving only outer dimension, then it is treated as
- * if atomic was specified.  This ensures that only a single loop
- * is generated instead of a sequence of identical loops with
- * different guards.
+ * In the atomic or unspecified case, the AST generation is handled
+ * by generate_shifted_component_default.
  */
 static __isl_give isl_ast_graft_list *generate_shifted_component_tree_base(
 	__isl_take isl_union_map *executed, __isl_take isl_ast_build *build,
 	int isolated)
 {
-	isl_bool outer_disjunction;
 	isl_union_set *schedule_domain;
 	isl_set *domain;
-	isl_basic_set_list *domain_list;
-	isl_ast_graft_list *list;
 	enum isl_ast_loop_type type;
 
 	type = isl_ast_build_get_loop_type(build, isolated);
@@ -3390,29 +3788,8 @@ static __isl_give isl_ast_graft_list *generate_shifted_component_tree_base(
 		return generate_shifted_component_tree_unroll(executed, domain,
 								build);
 
-	domain = isl_ast_build_eliminate(build, domain);
-	domain = isl_set_coalesce_preserve(domain);
-
-	outer_disjunction = has_pure_outer_disjunction(domain, build);
-	if (outer_disjunction < 0)
-		domain = isl_set_free(domain);
-
-	if (outer_disjunction || type == isl_ast_loop_atomic) {
-		isl_basic_set *hull;
-		hull = isl_set_unshifted_simple_hull(domain);
-		domain_list = isl_basic_set_list_from_basic_set(hull);
-	} else {
-		domain = isl_set_make_disjoint(domain);
-		domain_list = isl_basic_set_list_from_set(domain);
-	}
-
-	list = generate_parallel_domains(domain_list, executed, build);
-
-	isl_basic_set_list_free(domain_list);
-	isl_union_map_free(executed);
-	isl_ast_build_free(build);
-
-	return list;
+	return generate_shifted_component_default(executed, domain, build,
+					type == isl_ast_loop_atomic);
 error:
 	isl_union_map_free(executed);
 	isl_ast_build_free(build);
@@ -3700,19 +4077,129 @@ error:
 }
 
 /* Generate code for a single component, after shifting (if any)
- * has been applied.
- *
- * Call generate_shifted_component_tree or generate_shifted_component_flat
- * depending on whether the schedule was specified as a schedule tree.
- */
-static __isl_give isl_ast_graft_list *generate_shifted_component(
-	__isl_take isl_union_map *executed, __isl_take isl_ast_build *build)
+ * has been applied, at quality "quality".
+ *
+ * At full quality, call generate_shifted_component_tree or
+ * generate_shifted_component_flat depending on whether the schedule
+ * was specified as a schedule tree, such that all AST generation options
+ * are taken into account.
+ * At lower qualities, the schedule domain is either split up
+ * into disjoint basic sets, without any further separation,
+ * or combined into a single basic set, as if the atomic option
+ * had been specified.  The latter is also used at limited quality
+ * if the atomic option was specified in the schedule tree
+ * (without considering any isolated part).
+ */
+static __isl_give isl_ast_graft_list *generate_shifted_component_quality(
+	__isl_take isl_union_map *executed, __isl_take isl_ast_build *build,
+	int quality)
 {
-	if (isl_ast_build_has_schedule_node(build))
-		return generate_shifted_component_tree(executed, build);
-	else
-		return generate_shifted_component_flat(executed, build);
-}
+	isl_union_set *schedule_domain;
+	isl_set *domain;
+	int atomic;
+
+	if (quality == ISL_AST_BUILD_QUALITY_FULL) {
+		if (isl_ast_build_has_schedule_node(build))
+			return generate_shifted_component_tree(executed, build);
+		else
+			return generate_shifted_component_flat(executed, build);
+	}
+
+	atomic = quality == ISL_AST_BUILD_QUALITY_ATOMIC;
+	if (!atomic && isl_ast_build_has_schedule_node(build)) {
+		enum isl_ast_loop_type type;
+
+		type = isl_ast_build_get_loop_type(build, 0);
+		if (type < 0)
+			build = isl_ast_build_free(build);
+		atomic = type == isl_ast_loop_atomic;
+	}
+
+	schedule_domain = isl_union_map_domain(isl_union_map_copy(executed));
+	domain = isl_set_from_union_set(schedule_domain);
+	return generate_shifted_component_default(executed, domain, build,
+						atomic);
+}
+
+/* Generate code for a single component, after shifting (if any)
+ * has been applied, starting at quality "quality" and
+ * using at most "budget" operations at any quality
+ * other than ISL_AST_BUILD_QUALITY_ATOMIC.
+ *
+ * Each attempt is performed in a separate budget scope.
+ * If the budget is exceeded, then the (partial) result is discarded and
+ * the component is generated again at the next lower quality.
+ * Errors are not reported during an attempt since
+ * an exceeded budget is not considered to be an error.
+ * Other errors are passed on to the caller.
+ * The final attempt at ISL_AST_BUILD_QUALITY_ATOMIC is not bounded
+ * (by this function), such that a result is always produced
+ * if there are no other errors.
+ * Note that any user callbacks may therefore be called several times
+ * on the same (parts of the) component.
+ */
+static __isl_give isl_ast_graft_list *generate_shifted_component_budget(
+	__isl_take isl_union_map *executed, __isl_take isl_ast_build *build,
+	int quality, int budget)
+{
+	isl_ctx *ctx;
+
+	ctx = isl_ast_build_get_ctx(build);
+	for (; quality < ISL_AST_BUILD_QUALITY_ATOMIC; ++quality) {
+		isl_ast_graft_list *list;
+		int on_error;
+
+		on_error = isl_options_get_on_error(ctx);
+		isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+		if (isl_ctx_push_budget(ctx, "ast_build_component", budget) < 0)
+			list = NULL;
+		else {
+			list = generate_shifted_component_quality(
+					isl_union_map_copy(executed),
+					isl_ast_build_copy(build), quality);
+			if (isl_ctx_pop_budget(ctx) < 0)
+				list = isl_ast_graft_list_free(list);
+		}
+		isl_options_set_on_error(ctx, on_error);
+		if (list || isl_ctx_last_error(ctx) != isl_error_quota) {
+			isl_union_map_free(executed);
+			isl_ast_build_free(build);
+			return list;
+		}
+		isl_ctx_reset_error(ctx);
+	}
+
+	return generate_shifted_component_quality(executed, build, quality);
+}
+
+/* Generate code for a single component, after shifting (if any)
+ * has been applied.
+ *
+ * The component is generated at the quality specified
+ * by the ast_build_quality option.  If the ast_build_component_budget
+ * option is set, then lower qualities are tried if generating
+ * the component takes more operations than allowed by this option.
+ */
+static __isl_give isl_ast_graft_list *generate_shifted_component(
+	__isl_take isl_union_map *executed, __isl_take isl_ast_build *build)
+{
+	isl_ctx *ctx;
+	int quality, budget;
+
+	if (!build)
+		goto error;
+
+	ctx = isl_ast_build_get_ctx(build);
+	quality = isl_options_get_ast_build_quality(ctx);
+	budget = isl_options_get_ast_build_component_budget(ctx);
+	if (budget > 0)
+		return generate_shifted_component_budget(executed, build,
+							quality, budget);
+	return generate_shifted_component_quality(executed, build, quality);
+error:
+	isl_union_map_free(executed);
+	return NULL;
+}
 
 struct isl_set_map_pair {
 	isl_set *set;
@@ -4323,7 +4810,8 @@ static isl_bool after_in_child(__isl_keep isl_union_map *umap,
 
 /* Is any domain element of "umap" scheduled after any of
  * the corresponding image elements by the tree rooted at
- * the band node "node"?
+ * the band node "node", with (non-empty) partial schedule "partial"
+ * living in the space "space"?
  *
  * We first check if any domain element is scheduled after any
  * of the corresponding image elements by the band node itself.
@@ -4333,45 +4821,33 @@ static isl_bool after_in_child(__isl_keep isl_union_map *umap,
  * If there are no such pairs then the map passed to after_in_child
  * will be empty causing it to return 0.
  */
-static isl_bool after_in_band(__isl_keep isl_union_map *umap,
-	__isl_keep isl_schedule_node *node)
+static isl_bool after_in_band_partial(__isl_keep isl_union_map *umap,
+	__isl_keep isl_schedule_node *node, __isl_keep isl_union_map *partial,
+	__isl_keep isl_space *space)
 {
-	isl_multi_union_pw_aff *mupa;
-	isl_union_map *partial, *test, *gt, *universe, *umap1, *umap2;
+	isl_union_map *test, *gt, *universe, *umap1, *umap2;
 	isl_union_set *domain, *range;
-	isl_space *space;
 	isl_bool empty;
 	isl_bool after;
-	isl_size n;
 
-	n = isl_schedule_node_band_n_member(node);
-	if (n < 0)
-		return isl_bool_error;
-	if (n == 0)
-		return after_in_child(umap, node);
-
-	mupa = isl_schedule_node_band_get_partial_schedule(node);
-	space = isl_multi_union_pw_aff_get_space(mupa);
-	partial = isl_union_map_from_multi_union_pw_aff(mupa);
 	test = isl_union_map_copy(umap);
 	test = isl_union_map_apply_domain(test, isl_union_map_copy(partial));
 	test = isl_union_map_apply_range(test, isl_union_map_copy(partial));
-	gt = isl_union_map_from_map(isl_map_lex_gt(space));
+	gt = isl_union_map_from_map(isl_map_lex_gt(isl_space_copy(space)));
 	test = isl_union_map_intersect(test, gt);
 	empty = isl_union_map_is_empty(test);
 	isl_union_map_free(test);
 
-	if (empty < 0 || !empty) {
-		isl_union_map_free(partial);
+	if (empty < 0 || !empty)
 		return isl_bool_not(empty);
-	}
 
 	universe = isl_union_map_universe(isl_union_map_copy(umap));
 	domain = isl_union_map_domain(isl_union_map_copy(universe));
 	range = isl_union_map_range(universe);
 	umap1 = isl_union_map_copy(partial);
 	umap1 = isl_union_map_intersect_domain(umap1, domain);
-	umap2 = isl_union_map_intersect_domain(partial, range);
+	umap2 = isl_union_map_copy(partial);
+	umap2 = isl_union_map_intersect_domain(umap2, range);
 	test = isl_union_map_apply_range(umap1, isl_union_map_reverse(umap2));
 	test = isl_union_map_intersect(test, isl_union_map_copy(umap));
 	after = after_in_child(test, node);
@@ -4379,6 +4855,37 @@ static isl_bool after_in_band(__isl_keep isl_union_map *umap,
 	return after;
 }
 
+/* Is any domain element of "umap" scheduled after any of
+ * the corresponding image elements by the tree rooted at
+ * the band node "node"?
+ *
+ * If the band has any members, then compute its partial schedule
+ * and let after_in_band_partial perform the actual test.
+ */
+static isl_bool after_in_band(__isl_keep isl_union_map *umap,
+	__isl_keep isl_schedule_node *node)
+{
+	isl_multi_union_pw_aff *mupa;
+	isl_union_map *partial;
+	isl_space *space;
+	isl_bool after;
+	isl_size n;
+
+	n = isl_schedule_node_band_n_member(node);
+	if (n < 0)
+		return isl_bool_error;
+	if (n == 0)
+		return after_in_child(umap, node);
+
+	mupa = isl_schedule_node_band_get_partial_schedule(node);
+	space = isl_multi_union_pw_aff_get_space(mupa);
+	partial = isl_union_map_from_multi_union_pw_aff(mupa);
+	after = after_in_band_partial(umap, node, partial, space);
+	isl_union_map_free(partial);
+	isl_space_free(space);
+	return after;
+}
+
 /* Is any domain element of "umap" scheduled after any of
  * the corresponding image elements by the tree rooted at
  * the context node "node"?
@@ -4651,60 +5158,126 @@ static isl_bool after_in_tree(__isl_keep isl_union_map *umap,
 	return isl_bool_true;
 }
 
+/* Internal data for any_scheduled_after.
+ *
+ * "build" is the build in which the AST is constructed.
+ * "depth" is the number of loops that have already been generated
+ * "group_coscheduled" is a local copy of options->ast_build_group_coscheduled
+ * "domain" is an array of set-map pairs corresponding to the different
+ * iteration domains.  The set is the schedule domain, i.e., the domain
+ * of the inverse schedule, while the map is the inverse schedule itself.
+ * "node" is the child of the current band node, if any,
+ * or NULL if there is no such child or if it is a leaf.
+ * If "node" is a band node with at least one member, then
+ * "partial" is its partial schedule and "space" the space of
+ * this partial schedule.  Otherwise, they are NULL.
+ * These are extracted once, in init_subtree, since they are the same
+ * for every pair of domains.
+ */
+struct isl_any_scheduled_after_data {
+	isl_ast_build *build;
+	int depth;
+	int group_coscheduled;
+	struct isl_set_map_pair *domain;
+	isl_schedule_node *node;
+	isl_union_map *partial;
+	isl_space *space;
+};
+
+/* Extract the node underneath the current band node of data->build, if any,
+ * and, if it is a non-trivial band node, its partial schedule.
+ * If the child is a leaf, then no element can be scheduled after
+ * any other element by the subtree, so data->node is left NULL.
+ */
+static isl_stat init_subtree(struct isl_any_scheduled_after_data *data)
+{
+	isl_schedule_node *node;
+	isl_multi_union_pw_aff *mupa;
+	isl_size n;
+
+	data->node = NULL;
+	data->partial = NULL;
+	data->space = NULL;
+	if (!isl_ast_build_has_schedule_node(data->build))
+		return isl_stat_ok;
+
+	node = isl_ast_build_get_schedule_node(data->build);
+	node = isl_schedule_node_child(node, 0);
+	if (!node)
+		return isl_stat_error;
+	if (isl_schedule_node_get_type(node) == isl_schedule_node_leaf) {
+		isl_schedule_node_free(node);
+		return isl_stat_ok;
+	}
+	data->node = node;
+	if (isl_schedule_node_get_type(node) != isl_schedule_node_band)
+		return isl_stat_ok;
+	n = isl_schedule_node_band_n_member(node);
+	if (n < 0)
+		return isl_stat_error;
+	if (n == 0)
+		return isl_stat_ok;
+
+	mupa = isl_schedule_node_band_get_partial_schedule(node);
+	data->space = isl_multi_union_pw_aff_get_space(mupa);
+	data->partial = isl_union_map_from_multi_union_pw_aff(mupa);
+	if (!data->space || !data->partial)
+		return isl_stat_error;
+
+	return isl_stat_ok;
+}
+
+/* Free the data extracted by init_subtree.
+ */
+static void clear_subtree(struct isl_any_scheduled_after_data *data)
+{
+	isl_schedule_node_free(data->node);
+	isl_union_map_free(data->partial);
+	isl_space_free(data->space);
+}
+
 /* Is any domain element of "map1" scheduled after any domain
  * element of "map2" by the subtree underneath the current band node,
  * while at the same time being scheduled together by the current
  * band node, i.e., by "map1" and "map2?
  *
- * If the child of the current band node is a leaf, then
+ * If there is no such subtree or if it is a leaf, then
  * no element can be scheduled after any other element.
  *
  * Otherwise, we construct a relation between domain elements
  * of "map1" and domain elements of "map2" that are scheduled
  * together and then check if the subtree underneath the current
  * band node determines their relative order.
+ * If the root of this subtree is a non-trivial band node,
+ * then its partial schedule has been precomputed by init_subtree.
  */
-static isl_bool after_in_subtree(__isl_keep isl_ast_build *build,
+static isl_bool after_in_subtree(struct isl_any_scheduled_after_data *data,
 	__isl_keep isl_map *map1, __isl_keep isl_map *map2)
 {
-	isl_schedule_node *node;
 	isl_map *map;
 	isl_union_map *umap;
-	isl_bool after;
+	isl_bool empty, after;
 
-	node = isl_ast_build_get_schedule_node(build);
-	if (!node)
-		return isl_bool_error;
-	node = isl_schedule_node_child(node, 0);
-	if (isl_schedule_node_get_type(node) == isl_schedule_node_leaf) {
-		isl_schedule_node_free(node);
+	if (!data->node)
 		return isl_bool_false;
-	}
 	map = isl_map_copy(map2);
 	map = isl_map_apply_domain(map, isl_map_copy(map1));
 	umap = isl_union_map_from_map(map);
-	after = after_in_tree(umap, node);
+	if (!data->partial) {
+		after = after_in_tree(umap, data->node);
+		isl_union_map_free(umap);
+		return after;
+	}
+	empty = isl_union_map_is_empty(umap);
+	if (empty < 0 || empty)
+		after = isl_bool_not(empty);
+	else
+		after = after_in_band_partial(umap, data->node,
+						data->partial, data->space);
 	isl_union_map_free(umap);
-	isl_schedule_node_free(node);
 	return after;
 }
 
-/* Internal data for any_scheduled_after.
- *
- * "build" is the build in which the AST is constructed.
- * "depth" is the number of loops that have already been generated
- * "group_coscheduled" is a local copy of options->ast_build_group_coscheduled
- * "domain" is an array of set-map pairs corresponding to the different
- * iteration domains.  The set is the schedule domain, i.e., the domain
- * of the inverse schedule, while the map is the inverse schedule itself.
- */
-struct isl_any_scheduled_after_data {
-	isl_ast_build *build;
-	int depth;
-	int group_coscheduled;
-	struct isl_set_map_pair *domain;
-};
-
 /* Is any element of domain "i" scheduled after any element of domain "j"
  * (for a common iteration of the first data->depth loops)?
  *
@@ -4745,7 +5318,7 @@ static isl_bool any_scheduled_after(int i, int j, void *user)
 	if (isl_ast_build_has_schedule_node(data->build)) {
 		isl_bool after;
 
-		after = after_in_subtree(data->build, data->domain[i].map,
+		after = after_in_subtree(data, data->domain[i].map,
 					    data->domain[j].map);
 		if (after < 0 || after)
 			return after;
@@ -4773,6 +5346,9 @@ static isl_bool any_scheduled_after(int i, int j, void *user)
  * Since the test is performed on the domain of the inverse schedules of
  * the different domains, we precompute these domains and store
  * them in data.domain.
+ * Similarly, the subtree underneath the current band node
+ * (along with its partial schedule) is only extracted once
+ * by init_subtree rather than for every pair of domains.
  */
 static __isl_give isl_ast_graft_list *generate_components(
 	__isl_take isl_union_map *executed, __isl_take isl_ast_build *build)
@@ -4788,6 +5364,9 @@ static __isl_give isl_ast_graft_list *generate_components(
 	int n_domain = 0;
 
 	data.domain = NULL;
+	data.build = build;
+	if (init_subtree(&data) < 0)
+		goto error;
 	if (n < 0)
 		goto error;
 	data.domain = isl_calloc_array(ctx, struct isl_set_map_pair, n);
@@ -4802,7 +5381,6 @@ static __isl_give isl_ast_graft_list *generate_components(
 	depth = isl_ast_build_get_depth(build);
 	if (depth < 0)
 		goto error;
-	data.build = build;
 	data.depth = depth;
 	data.group_coscheduled = isl_options_get_ast_build_group_coscheduled(ctx);
 	g = isl_tarjan_graph_init(ctx, n, &any_scheduled_after, &data);
@@ -4835,6 +5413,7 @@ static __isl_give isl_ast_graft_list *generate_components(
 	if (0)
 error:		list = isl_ast_graft_list_free(list);
 	isl_tarjan_graph_free(g);
+	clear_subtree(&data);
 	for (i = 0; i < n_domain; ++i) {
 		isl_map_free(data.domain[i].map);
 		isl_set_free(data.domain[i].set);
@@ -5509,26 +6088,64 @@ static __isl_give isl_ast_graft_list *build_ast_from_extension(
 	return build_ast_from_child(build, node, executed);
 }
 
+/* Generate an AST that visits the elements in the domain of "executed"
+ * in the relative order specified by the child of the filter node "node"
+ * and its descendants, where the filter has already been applied
+ * to "executed".
+ *
+ * If reuse of subtrees has been enabled, then first check
+ * if an AST has been generated for the same subtree, inverse schedule
+ * and build in a previous AST generation and, if so, return a copy.
+ * Otherwise, record the generated AST for later reuse.
+ */
+static __isl_give isl_ast_graft_list *build_ast_from_filter_child(
+	__isl_take isl_ast_build *build, __isl_take isl_schedule_node *node,
+	__isl_take isl_union_map *executed)
+{
+	isl_ast_graft_list *list;
+
+	list = isl_ast_build_find_subtree(build, node, executed);
+	if (!list) {
+		list = build_ast_from_child(isl_ast_build_copy(build),
+				isl_schedule_node_copy(node),
+				isl_union_map_copy(executed));
+		if (list &&
+		    isl_ast_build_add_subtree(build, node, executed, list) < 0)
+			list = isl_ast_graft_list_free(list);
+	}
+
+	isl_ast_build_free(build);
+	isl_schedule_node_free(node);
+	isl_union_map_free(executed);
+
+	return list;
+}
+
 /* Generate an AST that visits the elements in the domain of "executed"
  * in the relative order specified by the filter node "node" and
- * its descendants.
+ * its descendants, where "part" contains (at least) those maps
+ * of "executed" that may have a non-empty intersection with the filter.
+ * "complete" is set if "part" is equal to "executed".
  *
  * The relation "executed" maps the outer generated loop iterators
  * to the domain elements executed by those iterations.
  *
- * We simply intersect the iteration domain (i.e., the range of "executed")
+ * We simply intersect the iteration domain (i.e., the range of "part")
  * with the filter and continue with the descendants of the node,
  * unless the resulting inverse schedule is empty, in which
  * case we return an empty list.
+ * Since any map of "executed" that does not appear in "part"
+ * has an empty intersection with the filter, this produces the same
+ * result as intersecting the range of "executed" itself.
  *
  * If the result of the intersection is equal to the original "executed"
  * relation, then keep the original representation since the intersection
  * may have unnecessarily broken up the relation into a greater number
- * of disjuncts.
+ * of disjuncts.  This can only happen if "part" is equal to "executed".
  */
-static __isl_give isl_ast_graft_list *build_ast_from_filter(
+static __isl_give isl_ast_graft_list *build_ast_from_filter_part(
 	__isl_take isl_ast_build *build, __isl_take isl_schedule_node *node,
-	__isl_take isl_union_map *executed)
+	__isl_take isl_union_map *part, int complete)
 {
 	isl_ctx *ctx;
 	isl_union_set *filter;
@@ -5538,16 +6155,16 @@ static __isl_give isl_ast_graft_list *build_ast_from_filter(
 	isl_bool unchanged;
 	isl_size n1, n2;
 
-	orig = isl_union_map_copy(executed);
-	if (!build || !node || !executed)
+	orig = isl_union_map_copy(part);
+	if (!build || !node || !part)
 		goto error;
 
 	filter = isl_schedule_node_filter_get_filter(node);
 	filter = isl_union_set_align_params(filter,
-				isl_union_map_get_space(executed));
-	n1 = isl_union_map_dim(executed, isl_dim_param);
-	executed = isl_union_map_intersect_range(executed, filter);
-	n2 = isl_union_map_dim(executed, isl_dim_param);
+				isl_union_map_get_space(part));
+	n1 = isl_union_map_dim(part, isl_dim_param);
+	part = isl_union_map_intersect_range(part, filter);
+	n2 = isl_union_map_dim(part, isl_dim_param);
 	if (n1 < 0 || n2 < 0)
 		goto error;
 	if (n2 > n1)
@@ -5555,32 +6172,48 @@ static __isl_give isl_ast_graft_list *build_ast_from_filter(
 			"filter node is not allowed to introduce "
 			"new parameters", goto error);
 
-	unchanged = isl_union_map_is_subset(orig, executed);
-	empty = isl_union_map_is_empty(executed);
+	unchanged = isl_bool_false;
+	if (complete)
+		unchanged = isl_union_map_is_subset(orig, part);
+	empty = isl_union_map_is_empty(part);
 	if (unchanged < 0 || empty < 0)
 		goto error;
 	if (unchanged) {
-		isl_union_map_free(executed);
-		return build_ast_from_child(build, node, orig);
+		isl_union_map_free(part);
+		return build_ast_from_filter_child(build, node, orig);
 	}
 	isl_union_map_free(orig);
 	if (!empty)
-		return build_ast_from_child(build, node, executed);
+		return build_ast_from_filter_child(build, node, part);
 
 	ctx = isl_ast_build_get_ctx(build);
 	list = isl_ast_graft_list_alloc(ctx, 0);
 	isl_ast_build_free(build);
 	isl_schedule_node_free(node);
-	isl_union_map_free(executed);
+	isl_union_map_free(part);
 	return list;
 error:
 	isl_ast_build_free(build);
 	isl_schedule_node_free(node);
-	isl_union_map_free(executed);
+	isl_union_map_free(part);
 	isl_union_map_free(orig);
 	return NULL;
 }
 
+/* Generate an AST that visits the elements in the domain of "executed"
+ * in the relative order specified by the filter node "node" and
+ * its descendants.
+ *
+ * The relation "executed" maps the outer generated loop iterators
+ * to the domain elements executed by those iterations.
+ */
+static __isl_give isl_ast_graft_list *build_ast_from_filter(
+	__isl_take isl_ast_build *build, __isl_take isl_schedule_node *node,
+	__isl_take isl_union_map *executed)
+{
+	return build_ast_from_filter_part(build, node, executed, 1);
+}
+
 /* Generate an AST that visits the elements in the domain of "executed"
  * in the relative order specified by the guard node "node" and
  * its descendants.
@@ -5735,6 +6368,111 @@ static __isl_give isl_ast_graft_list *build_ast_from_schedule_node(
 	__isl_take isl_ast_build *build, __isl_take isl_schedule_node *node,
 	__isl_take isl_union_map *executed);
 
+/* Collect the filters of the children of the sequence (or set) node
+ * "node", which are all filter nodes.
+ */
+static __isl_give isl_union_set_list *collect_filters(
+	__isl_keep isl_schedule_node *node, int n)
+{
+	int i;
+	isl_ctx *ctx;
+	isl_union_set_list *filters;
+
+	ctx = isl_schedule_node_get_ctx(node);
+	filters = isl_union_set_list_alloc(ctx, n);
+	for (i = 0; i < n; ++i) {
+		isl_schedule_node *child;
+		isl_union_set *filter;
+
+		child = isl_schedule_node_get_child(node, i);
+		filter = isl_schedule_node_filter_get_filter(child);
+		isl_schedule_node_free(child);
+		filters = isl_union_set_list_add(filters, filter);
+	}
+
+	return filters;
+}
+
+/* Generate an AST that visits the elements in the domain of "executed"
+ * in the relative order specified by the sequence (or set) node "node"
+ * with "n" children, all of which are filter nodes.
+ *
+ * The relation "executed" maps the outer generated loop iterators
+ * to the domain elements executed by those iterations.
+ *
+ * Each child only needs to consider those maps of "executed"
+ * with range tuples that appear in its filter.
+ * Split up "executed" accordingly for all children at once,
+ * rather than intersecting the whole of "executed" with the filter
+ * of each child, which takes time proportional to the number
+ * of children multiplied by the number of maps in "executed".
+ */
+static __isl_give isl_ast_graft_list *build_ast_from_filters(
+	__isl_take isl_ast_build *build, __isl_take isl_schedule_node *node,
+	__isl_take isl_union_map *executed, int n)
+{
+	int i;
+	isl_size n_map;
+	isl_ctx *ctx;
+	isl_union_set_list *filters;
+	isl_union_map_list *parts;
+	isl_ast_graft_list *list;
+
+	ctx = isl_ast_build_get_ctx(build);
+	list = isl_ast_graft_list_alloc(ctx, 0);
+
+	filters = collect_filters(node, n);
+	parts = isl_union_map_range_tuples_list(executed, filters);
+	isl_union_set_list_free(filters);
+	n_map = isl_union_map_n_map(executed);
+	if (!parts || n_map < 0)
+		list = isl_ast_graft_list_free(list);
+	for (i = 0; list && i < n; ++i) {
+		isl_schedule_node *child;
+		isl_union_map *part;
+		isl_ast_graft_list *list_i;
+		isl_size n_part;
+		int complete;
+
+		child = isl_schedule_node_get_child(node, i);
+		part = isl_union_map_list_get_at(parts, i);
+		n_part = isl_union_map_n_map(part);
+		complete = n_part == n_map;
+		list_i = build_ast_from_filter_part(isl_ast_build_copy(build),
+					child, part, complete);
+		list = isl_ast_graft_list_concat(list, list_i);
+	}
+	isl_union_map_list_free(parts);
+	isl_ast_build_free(build);
+	isl_schedule_node_free(node);
+	isl_union_map_free(executed);
+
+	return list;
+}
+
+/* Are all children of "node" filter nodes?
+ */
+static isl_bool all_children_are_filters(__isl_keep isl_schedule_node *node,
+	int n)
+{
+	int i;
+
+	for (i = 0; i < n; ++i) {
+		isl_schedule_node *child;
+		enum isl_schedule_node_type type;
+
+		child = isl_schedule_node_get_child(node, i);
+		type = isl_schedule_node_get_type(child);
+		isl_schedule_node_free(child);
+		if (type < 0)
+			return isl_bool_error;
+		if (type != isl_schedule_node_filter)
+			return isl_bool_false;
+	}
+
+	return isl_bool_true;
+}
+
 /* Generate an AST that visits the elements in the domain of "executed"
  * in the relative order specified by the sequence (or set) node "node" and
  * its descendants.
@@ -5744,6 +6482,9 @@ static __isl_give isl_ast_graft_list *build_ast_from_schedule_node(
  *
  * We simply generate an AST for each of the children and concatenate
  * the results.
+ * If all children are filter nodes, which is the common case,
+ * then "executed" is split up over the children first
+ * in build_ast_from_filters.
  */
 static __isl_give isl_ast_graft_list *build_ast_from_sequence(
 	__isl_take isl_ast_build *build, __isl_take isl_schedule_node *node,
@@ -5751,16 +6492,21 @@ static __isl_give isl_ast_graft_list *build_ast_from_sequence(
 {
 	int i;
 	isl_size n;
+	isl_bool filters;
 	isl_ctx *ctx;
 	isl_ast_graft_list *list;
 
+	n = isl_schedule_node_n_children(node);
+	filters = n < 0 ? isl_bool_error : all_children_are_filters(node, n);
+	if (filters == isl_bool_true && n > 1)
+		return build_ast_from_filters(build, node, executed, n);
+
 	ctx = isl_ast_build_get_ctx(build);
 	list = isl_ast_graft_list_alloc(ctx, 0);
 
-	n = isl_schedule_node_n_children(node);
-	if (n < 0)
+	if (n < 0 || filters < 0)
 		list = isl_ast_graft_list_free(list);
-	for (i = 0; i < n; ++i) {
+	for (i = 0; list && i < n; ++i) {
 		isl_schedule_node *child;
 		isl_ast_graft_list *list_i;
 
@@ -5922,12 +6668,19 @@ error:
  *
  * The construction starts at the root node of the schedule,
  * which is assumed to be a domain node.
+ * The AST generation is registered with the subtree cache of "build" (if any)
+ * such that ASTs of subtrees that no longer appear in "schedule"
+ * are removed from the cache afterwards.
+ * The generation is performed in an operation scope
+ * such that it can be attributed by external profilers.
  */
 __isl_give isl_ast_node *isl_ast_build_node_from_schedule(
 	__isl_keep isl_ast_build *build, __isl_take isl_schedule *schedule)
 {
 	isl_ctx *ctx;
 	isl_schedule_node *node;
+	isl_ast_build *copy;
+	isl_ast_node *tree;
 
 	if (!build || !schedule)
 		goto error;
@@ -5939,14 +6692,93 @@ __isl_give isl_ast_node *isl_ast_build_node_from_schedule(
 		goto error;
 	isl_schedule_free(schedule);
 
-	build = isl_ast_build_copy(build);
-	build = isl_ast_build_set_single_valued(build, 0);
+	isl_ctx_scope_enter(ctx, "isl_ast_build_node_from_schedule");
+	isl_ast_build_subtree_cache_enter(build);
+	copy = isl_ast_build_copy(build);
+	copy = isl_ast_build_set_single_valued(copy, 0);
 	if (isl_schedule_node_get_type(node) != isl_schedule_node_domain)
 		isl_die(ctx, isl_error_unsupported,
 			"expecting root domain node",
-			build = isl_ast_build_free(build));
-	return build_ast_from_domain(build, node);
+			copy = isl_ast_build_free(copy));
+	tree = build_ast_from_domain(copy, node);
+	isl_ast_build_subtree_cache_leave(build);
+	isl_ctx_scope_leave(ctx);
+	return tree;
 error:
 	isl_schedule_free(schedule);
 	return NULL;
 }
+
+/* Generate an AST that visits the domain elements that reach "node"
+ * in the relative order specified by "node" and its descendants,
+ * in the context of "build".
+ *
+ * "build" is an isl_ast_build that was passed to one of the callbacks
+ * during the generation of an AST from a schedule tree
+ * with the same outer structure as the schedule tree containing "node".
+ * In particular, the prefix schedule of "node" is expected to live
+ * in the same space as the (input) schedule of "build".
+ * This allows the state of the AST generation for a shared prefix
+ * (the generated constraints, the detected strides and so on)
+ * to be reused for generating ASTs for several subtrees.
+ *
+ * The inverse schedule is obtained from the prefix schedule of "node"
+ * in the same way as in build_ast_from_extension.
+ * That is, it is first transformed to refer to the internal schedule and
+ * then restricted to the current set of generated constraints.
+ * If any part of the prefix schedule does not live in the expected space,
+ * then it would be dropped by this transformation.
+ * This is considered to be an error.
+ */
+__isl_give isl_ast_node *isl_ast_build_node_from_schedule_subtree(
+	__isl_keep isl_ast_build *build, __isl_take isl_schedule_node *node)
+{
+	isl_ctx *ctx;
+	isl_union_set *schedule_domain;
+	isl_union_map *executed;
+	isl_ast_graft_list *list;
+	isl_ast_node *ast;
+	isl_set *set;
+	isl_size n1, n2;
+
+	if (!build || !node)
+		goto error;
+
+	ctx = isl_ast_build_get_ctx(build);
+	if (!build->internal2input)
+		isl_die(ctx, isl_error_invalid,
+			"build does not refer to a schedule tree", goto error);
+
+	executed = isl_schedule_node_get_prefix_schedule_relation(node);
+	executed = isl_union_map_reverse(executed);
+	n1 = isl_union_map_n_map(executed);
+	executed = isl_union_map_preimage_domain_multi_aff(executed,
+			isl_multi_aff_copy(build->internal2input));
+	n2 = isl_union_map_n_map(executed);
+	if (n1 < 0 || n2 < 0)
+		executed = isl_union_map_free(executed);
+	else if (n1 != n2)
+		isl_die(ctx, isl_error_invalid,
+			"prefix schedule does not match that of build",
+			executed = isl_union_map_free(executed));
+
+	set = isl_ast_build_get_generated(build);
+	set = isl_set_from_basic_set(isl_set_simple_hull(set));
+	schedule_domain = isl_union_set_from_set(set);
+	executed = isl_union_map_intersect_domain(executed, schedule_domain);
+	executed = isl_ast_build_substitute_values_union_map_domain(build,
+								    executed);
+
+	isl_ctx_scope_enter(ctx, "isl_ast_build_node_from_schedule_subtree");
+	isl_ast_build_subtree_cache_enter(build);
+	list = build_ast_from_schedule_node(isl_ast_build_copy(build),
+						node, executed);
+	ast = isl_ast_node_from_graft_list(list, build);
+	isl_ast_build_subtree_cache_leave(build);
+	isl_ctx_scope_leave(ctx);
+
+	return ast;
+error:
+	isl_schedule_node_free(node);
+	return NULL;
+}
@@ -14,6 +14,7 @@
 
 #include <isl/id.h>
 #include <isl/space.h>
+#include <isl/hash.h>
 #include <isl_ast_private.h>
 #include <isl_ast_build_expr.h>
 #include <isl_ast_build_private.h>
@@ -178,6 +179,48 @@ static __isl_give isl_set *hoist_guard(__isl_take isl_set *guard,
 	return guard;
 }
 
+/* isl_hash_table_find callback for checking whether the graft
+ * in the table has the same guard and enforced constraints
+ * as the graft "val".
+ */
+static isl_bool has_same_guard_and_enforced(const void *entry,
+	const void *val)
+{
+	const isl_ast_graft *graft1 = entry;
+	const isl_ast_graft *graft2 = val;
+	isl_bool equal;
+
+	equal = isl_set_plain_is_equal(graft1->guard, graft2->guard);
+	if (equal < 0 || !equal)
+		return equal;
+	return isl_basic_set_plain_is_equal(graft1->enforced,
+					    graft2->enforced);
+}
+
+/* Has a graft with the same guard and enforced constraints as "graft"
+ * already been added to "table"?
+ * If not, then add "graft" to "table".
+ * The table does not hold any references to the grafts.
+ */
+static isl_bool seen_guard_and_enforced(isl_ctx *ctx,
+	struct isl_hash_table *table, __isl_keep isl_ast_graft *graft)
+{
+	uint32_t hash;
+	struct isl_hash_table_entry *entry;
+
+	if (!graft)
+		return isl_bool_error;
+	hash = isl_set_get_hash(graft->guard);
+	entry = isl_hash_table_find(ctx, table, hash,
+				    &has_same_guard_and_enforced, graft, 1);
+	if (!entry)
+		return isl_bool_error;
+	if (entry->data)
+		return isl_bool_true;
+	entry->data = graft;
+	return isl_bool_false;
+}
+
 /* Extract a common guard from the grafts in "list" that can be hoisted
  * out of the current level.  If no such guard can be found, then return
  * a universal set.
@@ -200,6 +243,10 @@ static __isl_give isl_set *hoist_guard(__isl_take isl_set *guard,
  * allows us to hoist guards that are only explicit is some of
  * the grafts and implicit in the others.
  *
+ * Grafts with the same guard and enforced constraints as an earlier
+ * graft in the list do not contribute anything new and are skipped.
+ * In wide sequences, many grafts typically share the same guard.
+ *
  * The special case for equal guards is needed in case those guards
  * are non-convex.  Taking the simple hull would remove information
  * and would not allow for these guards to be hoisted completely.
@@ -214,6 +261,7 @@ __isl_give isl_set *isl_ast_graft_list_extract_hoistable_guard(
 	isl_set *guard;
 	isl_set_list *set_list;
 	isl_basic_set *hull;
+	struct isl_hash_table seen;
 
 	if (!list || !build)
 		return NULL;
@@ -242,14 +290,24 @@ __isl_give isl_set *isl_ast_graft_list_extract_hoistable_guard(
 	}
 
 	ctx = isl_ast_build_get_ctx(build);
+	if (isl_hash_table_init(ctx, &seen, n) < 0)
+		return NULL;
 	set_list = isl_set_list_alloc(ctx, n);
 	guard = isl_set_empty(isl_ast_build_get_space(build, 1));
 	for (i = 0; i < n; ++i) {
 		isl_ast_graft *graft;
 		isl_basic_set *enforced;
 		isl_set *guard_i;
+		isl_bool dup;
 
 		graft = isl_ast_graft_list_get_ast_graft(list, i);
+		dup = seen_guard_and_enforced(ctx, &seen, graft);
+		if (dup < 0 || dup) {
+			isl_ast_graft_free(graft);
+			if (dup < 0)
+				guard = isl_set_free(guard);
+			continue;
+		}
 		enforced = isl_ast_graft_get_enforced(graft);
 		guard_i = isl_set_copy(graft->guard);
 		isl_ast_graft_free(graft);
@@ -260,11 +318,23 @@ __isl_give isl_set *isl_ast_graft_list_extract_hoistable_guard(
 					    isl_ast_build_get_domain(build));
 		guard = isl_set_union(guard, guard_i);
 	}
+	isl_hash_table_clear(&seen);
 	hull = isl_set_unshifted_simple_hull_from_set_list(guard, set_list);
 	guard = isl_set_from_basic_set(hull);
 	return hoist_guard(guard, build);
 }
 
+/* Call the after_each_if callback on the if node "node",
+ * if requested by the user.
+ */
+static __isl_give isl_ast_node *after_each_if(__isl_take isl_ast_node *node,
+	__isl_keep isl_ast_build *build)
+{
+	if (!node || !build || !build->after_each_if)
+		return node;
+	return build->after_each_if(node, build, build->after_each_if_user);
+}
+
 /* Internal data structure used inside insert_if.
  *
  * list is the list of guarded nodes created by each call to insert_if.
@@ -307,7 +377,8 @@ static __isl_give isl_ast_node *ast_node_insert_if(
 		expr = isl_ast_build_expr_from_set_internal(build, guard);
 
 		if_node = isl_ast_node_alloc_if(expr);
-		return isl_ast_node_if_set_then(if_node, node);
+		if_node = isl_ast_node_if_set_then(if_node, node);
+		return after_each_if(if_node, build);
 	}
 
 	guard = isl_set_make_disjoint(guard);
@@ -564,6 +635,10 @@ static int clear_if_nodes(struct isl_if_node *if_node, int first, int n)
  * The guard of the node is then simplified based on the conditions
  * enforced at that then or else branch.
  * Otherwise, the current graft is appended to the list.
+ * Since consecutive grafts often have the same guard, it is first
+ * checked whether the guard is obviously equal to that of an if node,
+ * in which case no subset test is needed and the simplified guard
+ * is simply the universe.
  *
  * We only construct else branches if allowed by the user.
  */
@@ -599,12 +674,14 @@ static __isl_give isl_ast_graft_list *insert_pending_guard_nodes(
 		isl_set *guard;
 		isl_ast_graft *graft;
 		int subset, found_then, found_else;
+		isl_bool same;
 		isl_ast_node *node;
 
 		graft = isl_ast_graft_list_get_ast_graft(list, i);
 		if (!graft)
 			break;
 		subset = 0;
+		same = isl_bool_false;
 		found_then = found_else = -1;
 		if (n_if > 0) {
 			isl_set *test;
@@ -612,7 +689,12 @@ static __isl_give isl_ast_graft_list *insert_pending_guard_nodes(
 			test = isl_set_intersect(test,
 						isl_set_copy(build->domain));
 			for (j = n_if - 1; j >= 0; --j) {
-				subset = isl_set_is_subset(test,
+				same = isl_set_plain_is_equal(graft->guard,
+							if_node[j].guard);
+				if (same < 0 || same)
+					subset = same;
+				else
+					subset = isl_set_is_subset(test,
 							if_node[j].guard);
 				if (subset < 0 || subset) {
 					found_then = j;
@@ -636,7 +718,10 @@ static __isl_give isl_ast_graft_list *insert_pending_guard_nodes(
 		}
 
 		guard = isl_set_copy(graft->guard);
-		if (found_then >= 0)
+		if (found_then >= 0 && same)
+			graft->guard = isl_set_universe(
+					isl_set_get_space(graft->guard));
+		else if (found_then >= 0)
 			graft->guard = isl_set_gist(graft->guard,
 				isl_set_copy(if_node[found_then].guard));
 		else if (found_else >= 0)
@@ -822,6 +907,8 @@ error:
 
 /* For each graft in "list", replace its guard with the gist with
  * respect to "context".
+ * Guards that are obviously universal are left untouched
+ * since their gist is also universal.
  */
 static __isl_give isl_ast_graft_list *gist_guards(
 	__isl_take isl_ast_graft_list *list, __isl_keep isl_set *context)
@@ -835,10 +922,20 @@ static __isl_give isl_ast_graft_list *gist_guards(
 
 	for (i = 0; i < n; ++i) {
 		isl_ast_graft *graft;
+		isl_bool universe;
 
 		graft = isl_ast_graft_list_get_ast_graft(list, i);
 		if (!graft)
 			break;
+		universe = isl_set_plain_is_universe(graft->guard);
+		if (universe < 0) {
+			isl_ast_graft_free(graft);
+			break;
+		}
+		if (universe) {
+			isl_ast_graft_free(graft);
+			continue;
+		}
 		graft->guard = isl_set_gist(graft->guard,
 						isl_set_copy(context));
 		if (!graft->guard)
@@ -1044,6 +1141,63 @@ __isl_null isl_ast_graft *isl_ast_graft_free(__isl_take isl_ast_graft *graft)
 	return NULL;
 }
 
+/* Return a fresh copy of "graft" that does not share
+ * the isl_ast_graft structure itself with "graft".
+ * The components are shared.
+ */
+static __isl_give isl_ast_graft *isl_ast_graft_dup(
+	__isl_keep isl_ast_graft *graft)
+{
+	isl_ctx *ctx;
+	isl_ast_graft *dup;
+
+	if (!graft)
+		return NULL;
+
+	ctx = isl_ast_node_get_ctx(graft->node);
+	dup = isl_calloc_type(ctx, isl_ast_graft);
+	if (!dup)
+		return NULL;
+
+	dup->ref = 1;
+	dup->node = isl_ast_node_copy(graft->node);
+	dup->guard = isl_set_copy(graft->guard);
+	dup->enforced = isl_basic_set_copy(graft->enforced);
+
+	if (!dup->node || !dup->guard || !dup->enforced)
+		return isl_ast_graft_free(dup);
+
+	return dup;
+}
+
+/* Return a copy of "list" with fresh copies of the grafts in "list".
+ * Grafts are modified in place by several operations,
+ * even if they are shared, so this is needed to keep
+ * the grafts in "list" intact while the copy is being processed.
+ */
+__isl_give isl_ast_graft_list *isl_ast_graft_list_dup_grafts(
+	__isl_keep isl_ast_graft_list *list)
+{
+	int i;
+	isl_size n;
+	isl_ast_graft_list *dup;
+
+	n = isl_ast_graft_list_n_ast_graft(list);
+	if (n < 0)
+		return NULL;
+
+	dup = isl_ast_graft_list_alloc(isl_ast_graft_list_get_ctx(list), n);
+	for (i = 0; i < n; ++i) {
+		isl_ast_graft *graft;
+
+		graft = isl_ast_graft_list_get_ast_graft(list, i);
+		dup = isl_ast_graft_list_add(dup, isl_ast_graft_dup(graft));
+		isl_ast_graft_free(graft);
+	}
+
+	return dup;
+}
+
 /* Record that the grafted tree enforces
  * "enforced" by intersecting graft->enforced with "enforced".
  */
@@ -24,6 +24,7 @@
 #include <isl_options_private.h>
 #include <isl_vec_private.h>
 #include <isl_bernstein.h>
+#include "isl_task.h"
 
 struct bernstein_data {
 	enum isl_fold type;
@@ -155,6 +156,8 @@ static isl_stat add_fold(__isl_take isl_qpolynomial *b, __isl_keep isl_set *dom,
  *
  * c[i] contains the coefficient of the selected powers of the first i+1 vars.
  * multinom[i] contains the partial multinomial coefficient.
+ * fact[j] contains j!, which is used to divide out the factorial
+ * of the power of the last variable.
  */
 static isl_stat extract_coefficients(isl_qpolynomial *poly,
 	__isl_keep isl_set *dom, struct bernstein_data *data)
@@ -167,6 +170,7 @@ static isl_stat extract_coefficients(isl_qpolynomial *poly,
 	int *k = NULL;
 	int *left = NULL;
 	isl_vec *multinom = NULL;
+	isl_vec *fact = NULL;
 
 	n = isl_qpolynomial_dim(poly, isl_dim_in);
 	if (n < 0)
@@ -180,9 +184,13 @@ static isl_stat extract_coefficients(isl_qpolynomial *poly,
 	k = isl_alloc_array(ctx, int, n);
 	left = isl_alloc_array(ctx, int, n);
 	multinom = isl_vec_alloc(ctx, n);
-	if (!c || !k || !left || !multinom)
+	fact = isl_vec_alloc(ctx, 1 + d);
+	if (!c || !k || !left || !multinom || !fact)
 		goto error;
 
+	isl_int_set_si(fact->el[0], 1);
+	for (i = 1; i <= d; ++i)
+		isl_int_mul_ui(fact->el[i], fact->el[i - 1], i);
 	isl_int_set_si(multinom->el[0], 1);
 	for (k[0] = d; k[0] >= 0; --k[0]) {
 		int i = 1;
@@ -193,13 +201,11 @@ static isl_stat extract_coefficients(isl_qpolynomial *poly,
 		isl_int_set(multinom->el[1], multinom->el[0]);
 		while (i > 0) {
 			if (i == n - 1) {
-				int j;
 				isl_space *space;
 				isl_qpolynomial *b;
 				isl_qpolynomial *f;
-				for (j = 2; j <= left[i - 1]; ++j)
-					isl_int_divexact_ui(multinom->el[i],
-						multinom->el[i], j);
+				isl_int_divexact(multinom->el[i],
+					multinom->el[i], fact->el[left[i - 1]]);
 				b = isl_qpolynomial_coeff(c[i - 1], isl_dim_in,
 					n - 1 - i, left[i - 1]);
 				b = isl_qpolynomial_project_domain_on_params(b);
@@ -235,12 +241,14 @@ static isl_stat extract_coefficients(isl_qpolynomial *poly,
 	for (i = 0; i < n; ++i)
 		isl_qpolynomial_free(c[i]);
 
+	isl_vec_free(fact);
 	isl_vec_free(multinom);
 	free(left);
 	free(k);
 	free(c);
 	return isl_stat_ok;
 error:
+	isl_vec_free(fact);
 	isl_vec_free(multinom);
 	free(left);
 	free(k);
@@ -354,6 +362,193 @@ error:
 	return isl_stat_error;
 }
 
+/* The bounds computed over a single cell.
+ */
+struct isl_bernstein_result {
+	isl_pw_qpolynomial_fold *pwf;
+	isl_pw_qpolynomial_fold *pwf_tight;
+};
+
+/* Perform bernstein expansion of "poly" on the parametric vertices
+ * that are active on "cell" and store the bounds in "res".
+ * "cell" and "poly" belong to the same context, which may be
+ * a child context of the context of data->poly.
+ * "space" is the space of the bounds in that context.
+ * Only data->type and data->check_tight are used from "data".
+ */
+static isl_stat bernstein_coefficients_cell_bound(__isl_take isl_cell *cell,
+	__isl_keep isl_qpolynomial *poly, __isl_keep isl_space *space,
+	struct bernstein_data *data, struct isl_bernstein_result *res)
+{
+	struct bernstein_data local;
+	isl_stat r;
+
+	res->pwf = NULL;
+	res->pwf_tight = NULL;
+	if (!cell)
+		return isl_stat_error;
+
+	local.type = data->type;
+	local.check_tight = data->check_tight;
+	local.poly = poly;
+	local.pwf = isl_pw_qpolynomial_fold_zero(isl_space_copy(space),
+						local.type);
+	local.pwf_tight = isl_pw_qpolynomial_fold_zero(isl_space_copy(space),
+						local.type);
+	r = bernstein_coefficients_cell(cell, &local);
+	if (r < 0 || !local.pwf || !local.pwf_tight) {
+		isl_pw_qpolynomial_fold_free(local.pwf);
+		isl_pw_qpolynomial_fold_free(local.pwf_tight);
+		return isl_stat_error;
+	}
+	res->pwf = local.pwf;
+	res->pwf_tight = local.pwf_tight;
+	return isl_stat_ok;
+}
+
+/* A list of the cells of a chamber decomposition.
+ */
+struct isl_bernstein_cells {
+	int n;
+	int size;
+	isl_cell **cell;
+};
+
+/* Append "cell" to the list of cells "user".
+ */
+static isl_stat collect_cell(__isl_take isl_cell *cell, void *user)
+{
+	struct isl_bernstein_cells *cells = user;
+
+	if (cells->n >= cells->size) {
+		int size = 2 * cells->size + 4;
+		isl_cell **list;
+
+		list = isl_realloc_array(isl_cell_get_ctx(cell), cells->cell,
+					isl_cell *, size);
+		if (!list) {
+			isl_cell_free(cell);
+			return isl_stat_error;
+		}
+		cells->cell = list;
+		cells->size = size;
+	}
+	cells->cell[cells->n++] = cell;
+
+	return isl_stat_ok;
+}
+
+/* Data used by bernstein_coefficients_cells.
+ * Task "k" performs bernstein expansion on cell "k" of "cells",
+ * which refers to "vertices", and stores the bounds in "res[k]".
+ * "space" is the space of the bounds.
+ */
+struct isl_bernstein_tasks {
+	struct bernstein_data *data;
+	isl_space *space;
+	isl_vertices *vertices;
+	struct isl_bernstein_cells *cells;
+	struct isl_bernstein_result *res;
+};
+
+/* Perform the bernstein expansion of task "k"
+ * on copies of the inputs in "ctx".
+ */
+static isl_stat bernstein_task_run(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_bernstein_tasks *tasks = user;
+	isl_vertices *vertices;
+	isl_qpolynomial *poly;
+	isl_space *space;
+	isl_cell *cell;
+	isl_stat r;
+
+	vertices = isl_vertices_copy_to_ctx(tasks->vertices, ctx);
+	cell = isl_cell_copy_to_vertices(tasks->cells->cell[k], vertices);
+	poly = isl_qpolynomial_copy_to_ctx(tasks->data->poly, ctx);
+	space = isl_space_copy_to_ctx(tasks->space, ctx);
+	if (!poly || !space)
+		cell = isl_cell_free(cell);
+	r = bernstein_coefficients_cell_bound(cell, poly, space,
+					tasks->data, &tasks->res[k]);
+	isl_space_free(space);
+	isl_qpolynomial_free(poly);
+
+	return r;
+}
+
+/* Copy the bounds computed by task "k" to "ctx" and
+ * add them to data->pwf and data->pwf_tight.
+ */
+static isl_stat bernstein_task_merge(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_bernstein_tasks *tasks = user;
+	struct bernstein_data *data = tasks->data;
+	struct isl_bernstein_result child = tasks->res[k];
+	isl_pw_qpolynomial_fold *pwf, *pwf_tight;
+
+	pwf = isl_pw_qpolynomial_fold_copy_to_ctx(child.pwf, ctx);
+	pwf_tight = isl_pw_qpolynomial_fold_copy_to_ctx(child.pwf_tight, ctx);
+	isl_pw_qpolynomial_fold_free(child.pwf);
+	isl_pw_qpolynomial_fold_free(child.pwf_tight);
+
+	data->pwf = isl_pw_qpolynomial_fold_fold(data->pwf, pwf);
+	data->pwf_tight = isl_pw_qpolynomial_fold_fold(data->pwf_tight,
+							pwf_tight);
+	if (!data->pwf || !data->pwf_tight)
+		return isl_stat_error;
+	return isl_stat_ok;
+}
+
+/* Perform bernstein expansion on the disjoint cells of "vertices"
+ * and add the results to data->pwf and data->pwf_tight.
+ *
+ * If the bernstein_threads option is set to a value greater than one
+ * and there is more than one cell, then the cells are first collected
+ * and the expansions on the individual cells are performed
+ * independently of each other, each in a task of isl_ctx_run_tasks
+ * using up to that number of threads.
+ * The results are then added to data->pwf and data->pwf_tight
+ * in the order of the cells, such that the result does not depend
+ * on the number of threads.
+ */
+static isl_stat bernstein_coefficients_cells(__isl_keep isl_vertices *vertices,
+	struct bernstein_data *data)
+{
+	int k;
+	int n_thread;
+	isl_ctx *ctx;
+	struct isl_bernstein_cells cells = { 0 };
+	struct isl_bernstein_tasks tasks = { data, NULL, vertices, &cells };
+	isl_stat r;
+
+	if (!vertices)
+		return isl_stat_error;
+	ctx = isl_vertices_get_ctx(vertices);
+	n_thread = ctx->opt->bernstein_threads;
+	if (n_thread < 2 || vertices->n_chambers < 2)
+		return isl_vertices_foreach_disjoint_cell(vertices,
+					&bernstein_coefficients_cell, data);
+
+	r = isl_vertices_foreach_disjoint_cell(vertices, &collect_cell, &cells);
+	tasks.space = isl_pw_qpolynomial_fold_get_space(data->pwf);
+	tasks.res = isl_calloc_array(ctx, struct isl_bernstein_result,
+					cells.n);
+	if (!tasks.space || (cells.n && !tasks.res))
+		r = isl_stat_error;
+	if (r >= 0)
+		r = isl_ctx_run_tasks(ctx, cells.n, n_thread,
+				&bernstein_task_run, &bernstein_task_merge,
+				&tasks);
+	for (k = 0; k < cells.n; ++k)
+		isl_cell_free(cells.cell[k]);
+	free(tasks.res);
+	free(cells.cell);
+	isl_space_free(tasks.space);
+
+	return r;
+}
+
 /* Base case of applying bernstein expansion.
  *
  * We compute the chamber decomposition of the parametric polytope "bset"
@@ -397,8 +592,7 @@ static __isl_give isl_pw_qpolynomial_fold *bernstein_coefficients_base(
 	data->pwf_tight = isl_pw_qpolynomial_fold_zero(space, data->type);
 	data->poly = isl_qpolynomial_homogenize(isl_qpolynomial_copy(poly));
 	vertices = isl_basic_set_compute_vertices(bset);
-	if (isl_vertices_foreach_disjoint_cell(vertices,
-					&bernstein_coefficients_cell, data) < 0)
+	if (bernstein_coefficients_cells(vertices, data) < 0)
 		data->pwf = isl_pw_qpolynomial_fold_free(data->pwf);
 	isl_vertices_free(vertices);
 	isl_qpolynomial_free(data->poly);
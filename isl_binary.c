@@ -0,0 +1,2260 @@
+/*
+ * Use of this software is governed by the MIT license
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <isl_ctx_private.h>
+#include <isl_map_private.h>
+#include <isl_space_private.h>
+#include <isl_local_space_private.h>
+#include <isl_mat_private.h>
+#include <isl_vec_private.h>
+#include <isl_aff_private.h>
+#include <isl/id.h>
+#include <isl/set.h>
+#include <isl/union_set.h>
+#include <isl/union_map.h>
+#include <isl/aff.h>
+#include <isl/schedule.h>
+#include <isl_schedule_private.h>
+#include <isl_schedule_tree.h>
+#include <isl_schedule_band.h>
+#include <isl_schedule_constraints.h>
+#include <isl_binary_private.h>
+
+#include <bset_from_bmap.c>
+#include <set_to_map.c>
+#include <set_from_map.c>
+#include <uset_to_umap.c>
+#include <uset_from_umap.c>
+
+/* The binary format starts with the magic "ISLB",
+ * followed by the version of the format and the kind of object
+ * that is stored.
+ * Readers reject data with a higher version than ISL_BINARY_VERSION.
+ *
+ * All further data consists of (possibly negative) integers,
+ * encoded as a sequence of bytes.
+ * Non-negative integers are split into groups of bits,
+ * with the most significant group first.
+ * Each group except the last contains seven bits and is stored
+ * with the most significant bit of the byte set.
+ * The last group contains six bits and is stored with the second
+ * most significant bit set instead.
+ * Signed integers are first mapped to non-negative integers
+ * by mapping non-negative x to 2 x and negative x to -2 x - 1.
+ * In particular, the encoding never contains a zero byte,
+ * so that the result can be stored in a string.
+ *
+ * Identifiers and strings are stored as their length,
+ * followed by the bytes of the string.
+ */
+#define ISL_BINARY_VERSION	1
+
+/* The kinds of objects that can be stored in the binary format.
+ * Sets are stored in the same way as the corresponding maps.
+ */
+enum isl_binary_kind {
+	isl_binary_basic_map = 1,
+	isl_binary_map,
+	isl_binary_union_map,
+	isl_binary_schedule,
+	isl_binary_schedule_constraints
+};
+
+/* The flags of basic maps and maps that are preserved by the binary format.
+ */
+#define ISL_BINARY_BASIC_MAP_FLAGS	((1 << 10) - 1)
+#define ISL_BINARY_MAP_FLAGS		(ISL_MAP_DISJOINT | ISL_MAP_NORMALIZED)
+
+/* Internal data structure for writing the binary format to "p".
+ *
+ * "buf" contains "n" bytes that have not been printed yet.
+ * "group" is used for encoding integers that do not fit in a long and
+ * has room for "group_size" groups of bits.
+ * "u", "q" and "r" are temporary integers for encoding such integers.
+ */
+struct isl_binary_writer {
+	isl_printer *p;
+
+	int n;
+	char buf[257];
+
+	int group_size;
+	char *group;
+
+	isl_int u;
+	isl_int q;
+	isl_int r;
+};
+
+/* Initialize "w" for writing to "p".
+ */
+static void writer_init(struct isl_binary_writer *w, __isl_take isl_printer *p)
+{
+	w->p = p;
+	w->n = 0;
+	w->group_size = 0;
+	w->group = NULL;
+	isl_int_init(w->u);
+	isl_int_init(w->q);
+	isl_int_init(w->r);
+}
+
+/* Print the pending bytes of "w".
+ */
+static void writer_flush(struct isl_binary_writer *w)
+{
+	if (w->n == 0)
+		return;
+	w->buf[w->n] = '\0';
+	w->p = isl_printer_print_str(w->p, w->buf);
+	w->n = 0;
+}
+
+/* Print the pending bytes of "w", free all memory allocated by "w" and
+ * return the printer, or NULL if "status" indicates an error.
+ */
+static __isl_give isl_printer *writer_finish(struct isl_binary_writer *w,
+	isl_stat status)
+{
+	writer_flush(w);
+	free(w->group);
+	isl_int_clear(w->u);
+	isl_int_clear(w->q);
+	isl_int_clear(w->r);
+	if (status < 0)
+		return isl_printer_free(w->p);
+	return w->p;
+}
+
+/* Append the byte "c" to the output of "w".
+ */
+static void put_byte(struct isl_binary_writer *w, unsigned char c)
+{
+	if (w->n + 1 >= sizeof(w->buf))
+		writer_flush(w);
+	w->buf[w->n++] = c;
+}
+
+/* Append the non-negative integer "u" to the output of "w".
+ */
+static isl_stat put_uint(struct isl_binary_writer *w, unsigned long u)
+{
+	char group[sizeof(unsigned long) * CHAR_BIT / 7 + 1];
+	int k = 0;
+	unsigned char last;
+
+	last = u & 63;
+	u >>= 6;
+	while (u) {
+		group[k++] = 0x80 | (u & 127);
+		u >>= 7;
+	}
+	while (k > 0)
+		put_byte(w, group[--k]);
+	put_byte(w, 0x40 | last);
+
+	return w->p ? isl_stat_ok : isl_stat_error;
+}
+
+/* Append the non-negative isl_int w->u to the output of "w".
+ *
+ * The groups of bits are collected in w->group, starting
+ * from the least significant group, such that they can
+ * then be output in reverse order.
+ */
+static isl_stat put_big_uint(struct isl_binary_writer *w)
+{
+	int k = 0;
+	unsigned char last;
+
+	isl_int_fdiv_q_ui(w->q, w->u, 64);
+	isl_int_mul_ui(w->r, w->q, 64);
+	isl_int_sub(w->r, w->u, w->r);
+	last = isl_int_get_ui(w->r);
+	while (!isl_int_is_zero(w->q)) {
+		if (k >= w->group_size) {
+			int size = 2 * w->group_size + 16;
+			char *group;
+
+			group = isl_realloc_array(isl_printer_get_ctx(w->p),
+						w->group, char, size);
+			if (!group)
+				return isl_stat_error;
+			w->group = group;
+			w->group_size = size;
+		}
+		isl_int_fdiv_q_ui(w->u, w->q, 128);
+		isl_int_mul_ui(w->r, w->u, 128);
+		isl_int_sub(w->r, w->q, w->r);
+		w->group[k++] = 0x80 | isl_int_get_ui(w->r);
+		isl_int_swap(w->q, w->u);
+	}
+	while (k > 0)
+		put_byte(w, w->group[--k]);
+	put_byte(w, 0x40 | last);
+
+	return w->p ? isl_stat_ok : isl_stat_error;
+}
+
+/* Append the integer "v" to the output of "w".
+ */
+static isl_stat put_int(struct isl_binary_writer *w, isl_int v)
+{
+	if (isl_int_fits_slong(v)) {
+		long s = isl_int_get_si(v);
+
+		if (s >= 0)
+			return put_uint(w, 2 * (unsigned long) s);
+		return put_uint(w, 2 * (unsigned long) (-(s + 1)) + 1);
+	}
+
+	isl_int_abs(w->u, v);
+	isl_int_mul_ui(w->u, w->u, 2);
+	if (isl_int_is_neg(v))
+		isl_int_sub_ui(w->u, w->u, 1);
+	return put_big_uint(w);
+}
+
+/* Append the "n" integers starting at "p" to the output of "w".
+ */
+static isl_stat put_seq(struct isl_binary_writer *w, isl_int *p, int n)
+{
+	int i;
+
+	for (i = 0; i < n; ++i)
+		if (put_int(w, p[i]) < 0)
+			return isl_stat_error;
+
+	return isl_stat_ok;
+}
+
+/* Append the (optional) identifier "id" to the output of "w".
+ * A missing identifier is encoded as 0, an identifier without name as 1 and
+ * any other identifier as 2 plus the length of the name,
+ * followed by the name.
+ * The user pointers of identifiers are not preserved.
+ */
+static isl_stat put_id(struct isl_binary_writer *w, __isl_keep isl_id *id)
+{
+	const char *name;
+	size_t i, len;
+
+	if (!id)
+		return put_uint(w, 0);
+	name = isl_id_get_name(id);
+	if (!name)
+		return put_uint(w, 1);
+	len = strlen(name);
+	if (put_uint(w, 2 + len) < 0)
+		return isl_stat_error;
+	for (i = 0; i < len; ++i)
+		put_byte(w, name[i]);
+
+	return w->p ? isl_stat_ok : isl_stat_error;
+}
+
+/* Append the identifier of dimension "pos" of type "type" of "space"
+ * (or 0 if there is no such identifier) to the output of "w".
+ */
+static isl_stat put_dim_id(struct isl_binary_writer *w,
+	__isl_keep isl_space *space, enum isl_dim_type type, int pos)
+{
+	isl_bool has_id;
+	isl_id *id;
+	isl_stat r;
+
+	has_id = isl_space_has_dim_id(space, type, pos);
+	if (has_id < 0)
+		return isl_stat_error;
+	if (!has_id)
+		return put_uint(w, 0);
+	id = isl_space_get_dim_id(space, type, pos);
+	r = put_id(w, id);
+	isl_id_free(id);
+
+	return r;
+}
+
+/* Append the tuple of the set space "space" to the output of "w".
+ *
+ * The (optional) tuple identifier is followed by 1 if the space
+ * wraps a map space and 0 otherwise.
+ * In the first case, this is followed by the domain and range tuples
+ * of the wrapped space.  In the second case, this is followed
+ * by the number of dimensions and their (optional) identifiers.
+ */
+static isl_stat put_tuple(struct isl_binary_writer *w,
+	__isl_keep isl_space *space)
+{
+	int i;
+	isl_bool has_id, wrapping;
+	isl_size n;
+	isl_stat r;
+
+	has_id = isl_space_has_tuple_id(space, isl_dim_set);
+	if (has_id < 0)
+		return isl_stat_error;
+	if (!has_id) {
+		r = put_uint(w, 0);
+	} else {
+		isl_id *id = isl_space_get_tuple_id(space, isl_dim_set);
+		r = put_id(w, id);
+		isl_id_free(id);
+	}
+	if (r < 0)
+		return isl_stat_error;
+
+	wrapping = isl_space_is_wrapping(space);
+	if (wrapping < 0)
+		return isl_stat_error;
+	if (wrapping) {
+		isl_space *map, *factor;
+
+		if (put_uint(w, 1) < 0)
+			return isl_stat_error;
+		map = isl_space_unwrap(isl_space_copy(space));
+		factor = isl_space_domain(isl_space_copy(map));
+		r = put_tuple(w, factor);
+		isl_space_free(factor);
+		factor = isl_space_range(map);
+		if (r >= 0)
+			r = put_tuple(w, factor);
+		isl_space_free(factor);
+		return r;
+	}
+
+	n = isl_space_dim(space, isl_dim_set);
+	if (n < 0 || put_uint(w, 0) < 0 || put_uint(w, n) < 0)
+		return isl_stat_error;
+	for (i = 0; i < n; ++i)
+		if (put_dim_id(w, space, isl_dim_set, i) < 0)
+			return isl_stat_error;
+
+	return isl_stat_ok;
+}
+
+/* Append "space" to the output of "w".
+ *
+ * The space starts with its kind (0 for a parameter space,
+ * 1 for a set space and 2 for a map space), followed by
+ * the number of parameters and their identifiers and
+ * then by the tuples of the space.
+ */
+static isl_stat put_space(struct isl_binary_writer *w,
+	__isl_keep isl_space *space)
+{
+	int i;
+	isl_size nparam;
+	isl_space *factor;
+	isl_stat r;
+
+	nparam = isl_space_dim(space, isl_dim_param);
+	if (nparam < 0)
+		return isl_stat_error;
+	if (isl_space_is_params(space)) {
+		r = put_uint(w, 0);
+	} else if (isl_space_is_set(space)) {
+		r = put_uint(w, 1);
+	} else {
+		r = put_uint(w, 2);
+	}
+	if (r < 0 || put_uint(w, nparam) < 0)
+		return isl_stat_error;
+	for (i = 0; i < nparam; ++i)
+		if (put_dim_id(w, space, isl_dim_param, i) < 0)
+			return isl_stat_error;
+
+	if (isl_space_is_params(space))
+		return isl_stat_ok;
+	if (isl_space_is_set(space))
+		return put_tuple(w, space);
+
+	factor = isl_space_domain(isl_space_copy(space));
+	r = put_tuple(w, factor);
+	isl_space_free(factor);
+	if (r < 0)
+		return isl_stat_error;
+	factor = isl_space_range(isl_space_copy(space));
+	r = put_tuple(w, factor);
+	isl_space_free(factor);
+
+	return r;
+}
+
+/* Append the flags, the number of divs, equalities and inequalities of
+ * "bmap" to the output of "w", followed by the rows of these
+ * divs, equalities and inequalities.
+ * The space of "bmap" is not written.
+ */
+static isl_stat put_basic_map_body(struct isl_binary_writer *w,
+	__isl_keep isl_basic_map *bmap)
+{
+	int i;
+	isl_size total;
+
+	total = isl_basic_map_dim(bmap, isl_dim_all);
+	if (total < 0)
+		return isl_stat_error;
+	if (put_uint(w, bmap->flags & ISL_BINARY_BASIC_MAP_FLAGS) < 0 ||
+	    put_uint(w, bmap->n_div) < 0 ||
+	    put_uint(w, bmap->n_eq) < 0 ||
+	    put_uint(w, bmap->n_ineq) < 0)
+		return isl_stat_error;
+	for (i = 0; i < bmap->n_div; ++i)
+		if (put_seq(w, bmap->div[i], 2 + total) < 0)
+			return isl_stat_error;
+	for (i = 0; i < bmap->n_eq; ++i)
+		if (put_seq(w, bmap->eq[i], 1 + total) < 0)
+			return isl_stat_error;
+	for (i = 0; i < bmap->n_ineq; ++i)
+		if (put_seq(w, bmap->ineq[i], 1 + total) < 0)
+			return isl_stat_error;
+
+	return isl_stat_ok;
+}
+
+/* Append the flags and the number of basic maps of "map"
+ * to the output of "w", followed by the basic maps.
+ * The space of "map" is not written.
+ */
+static isl_stat put_map_body(struct isl_binary_writer *w,
+	__isl_keep isl_map *map)
+{
+	int i;
+
+	if (!map)
+		return isl_stat_error;
+	if (put_uint(w, map->flags & ISL_BINARY_MAP_FLAGS) < 0 ||
+	    put_uint(w, map->n) < 0)
+		return isl_stat_error;
+	for (i = 0; i < map->n; ++i)
+		if (put_basic_map_body(w, map->p[i]) < 0)
+			return isl_stat_error;
+
+	return isl_stat_ok;
+}
+
+/* isl_union_map_foreach_map callback for appending "map",
+ * along with its space, to the output of the isl_binary_writer "user".
+ */
+static isl_stat put_map_entry(__isl_take isl_map *map, void *user)
+{
+	struct isl_binary_writer *w = user;
+	isl_stat r;
+
+	r = put_space(w, isl_map_peek_space(map));
+	if (r >= 0)
+		r = put_map_body(w, map);
+	isl_map_free(map);
+
+	return r;
+}
+
+/* Append the parameter space of "umap" to the output of "w",
+ * followed by the number of maps in "umap" and the maps themselves.
+ */
+static isl_stat put_union_map(struct isl_binary_writer *w,
+	__isl_keep isl_union_map *umap)
+{
+	isl_size n;
+	isl_space *space;
+	isl_stat r;
+
+	n = isl_union_map_n_map(umap);
+	if (n < 0)
+		return isl_stat_error;
+	space = isl_union_map_get_space(umap);
+	r = put_space(w, space);
+	isl_space_free(space);
+	if (r < 0 || put_uint(w, n) < 0)
+		return isl_stat_error;
+
+	return isl_union_map_foreach_map(umap, &put_map_entry, w);
+}
+
+/* Append the local variables of "aff", followed by its coefficients,
+ * to the output of "w".
+ * The domain space of "aff" is not written.
+ */
+static isl_stat put_aff_body(struct isl_binary_writer *w,
+	__isl_keep isl_aff *aff)
+{
+	int i;
+	isl_mat *div;
+
+	if (!aff)
+		return isl_stat_error;
+	div = aff->ls->div;
+	if (put_uint(w, div->n_row) < 0)
+		return isl_stat_error;
+	for (i = 0; i < div->n_row; ++i)
+		if (put_seq(w, div->row[i], div->n_col) < 0)
+			return isl_stat_error;
+
+	return put_seq(w, aff->v->el, aff->v->size);
+}
+
+/* Append the affine expressions of "ma" to the output of "w".
+ * The space of "ma" is not written.
+ */
+static isl_stat put_multi_aff_body(struct isl_binary_writer *w,
+	__isl_keep isl_multi_aff *ma)
+{
+	int i;
+
+	if (!ma)
+		return isl_stat_error;
+	for (i = 0; i < ma->n; ++i)
+		if (put_aff_body(w, ma->u.p[i]) < 0)
+			return isl_stat_error;
+
+	return isl_stat_ok;
+}
+
+/* Append the number of pieces of "pa" to the output of "w",
+ * followed by the domain and the affine expression of each piece.
+ * The space of "pa" is not written.
+ */
+static isl_stat put_pw_aff_body(struct isl_binary_writer *w,
+	__isl_keep isl_pw_aff *pa)
+{
+	int i;
+
+	if (!pa)
+		return isl_stat_error;
+	if (put_uint(w, pa->n) < 0)
+		return isl_stat_error;
+	for (i = 0; i < pa->n; ++i) {
+		if (put_map_body(w, set_to_map(pa->p[i].set)) < 0)
+			return isl_stat_error;
+		if (put_aff_body(w, pa->p[i].aff) < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Append the number of pieces of "pma" to the output of "w",
+ * followed by the domain and the affine expressions of each piece.
+ * The space of "pma" is not written.
+ */
+static isl_stat put_pw_multi_aff_body(struct isl_binary_writer *w,
+	__isl_keep isl_pw_multi_aff *pma)
+{
+	int i;
+
+	if (!pma)
+		return isl_stat_error;
+	if (put_uint(w, pma->n) < 0)
+		return isl_stat_error;
+	for (i = 0; i < pma->n; ++i) {
+		if (put_map_body(w, set_to_map(pma->p[i].set)) < 0)
+			return isl_stat_error;
+		if (put_multi_aff_body(w, pma->p[i].maff) < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* isl_union_pw_aff_foreach_pw_aff callback for appending "pa",
+ * along with its space, to the output of the isl_binary_writer "user".
+ */
+static isl_stat put_pw_aff_entry(__isl_take isl_pw_aff *pa, void *user)
+{
+	struct isl_binary_writer *w = user;
+	isl_stat r;
+
+	r = put_space(w, isl_pw_aff_peek_space(pa));
+	if (r >= 0)
+		r = put_pw_aff_body(w, pa);
+	isl_pw_aff_free(pa);
+
+	return r;
+}
+
+/* Append the parameter space of "upa" to the output of "w",
+ * followed by the number of piecewise affine expressions in "upa" and
+ * the expressions themselves.
+ */
+static isl_stat put_union_pw_aff(struct isl_binary_writer *w,
+	__isl_keep isl_union_pw_aff *upa)
+{
+	isl_size n;
+	isl_space *space;
+	isl_stat r;
+
+	n = isl_union_pw_aff_n_pw_aff(upa);
+	if (n < 0)
+		return isl_stat_error;
+	space = isl_union_pw_aff_get_space(upa);
+	r = put_space(w, space);
+	isl_space_free(space);
+	if (r < 0 || put_uint(w, n) < 0)
+		return isl_stat_error;
+
+	return isl_union_pw_aff_foreach_pw_aff(upa, &put_pw_aff_entry, w);
+}
+
+/* isl_union_pw_multi_aff_foreach_pw_multi_aff callback for appending "pma",
+ * along with its space, to the output of the isl_binary_writer "user".
+ */
+static isl_stat put_pw_multi_aff_entry(__isl_take isl_pw_multi_aff *pma,
+	void *user)
+{
+	struct isl_binary_writer *w = user;
+	isl_stat r;
+
+	r = put_space(w, isl_pw_multi_aff_peek_space(pma));
+	if (r >= 0)
+		r = put_pw_multi_aff_body(w, pma);
+	isl_pw_multi_aff_free(pma);
+
+	return r;
+}
+
+/* Append the parameter space of "upma" to the output of "w",
+ * followed by the number of piecewise multi-affine expressions in "upma"
+ * and the expressions themselves.
+ */
+static isl_stat put_union_pw_multi_aff(struct isl_binary_writer *w,
+	__isl_keep isl_union_pw_multi_aff *upma)
+{
+	isl_size n;
+	isl_space *space;
+	isl_stat r;
+
+	n = isl_union_pw_multi_aff_n_pw_multi_aff(upma);
+	if (n < 0)
+		return isl_stat_error;
+	space = isl_union_pw_multi_aff_get_space(upma);
+	r = put_space(w, space);
+	isl_space_free(space);
+	if (r < 0 || put_uint(w, n) < 0)
+		return isl_stat_error;
+
+	return isl_union_pw_multi_aff_foreach_pw_multi_aff(upma,
+						&put_pw_multi_aff_entry, w);
+}
+
+/* Append the space of "mupa" to the output of "w",
+ * followed by its elements.
+ * If "mupa" has no elements, then its explicit domain is appended instead.
+ */
+static isl_stat put_multi_union_pw_aff(struct isl_binary_writer *w,
+	__isl_keep isl_multi_union_pw_aff *mupa)
+{
+	int i;
+	isl_size n;
+	isl_space *space;
+	isl_union_set *dom;
+	isl_stat r;
+
+	n = isl_multi_union_pw_aff_size(mupa);
+	if (n < 0)
+		return isl_stat_error;
+	space = isl_multi_union_pw_aff_get_space(mupa);
+	r = put_space(w, space);
+	isl_space_free(space);
+	if (r < 0)
+		return isl_stat_error;
+	for (i = 0; i < n; ++i) {
+		isl_union_pw_aff *upa;
+
+		upa = isl_multi_union_pw_aff_get_at(mupa, i);
+		r = put_union_pw_aff(w, upa);
+		isl_union_pw_aff_free(upa);
+		if (r < 0)
+			return isl_stat_error;
+	}
+	if (n > 0)
+		return isl_stat_ok;
+
+	dom = isl_multi_union_pw_aff_domain(
+				isl_multi_union_pw_aff_copy(mupa));
+	r = put_union_map(w, uset_to_umap(dom));
+	isl_union_set_free(dom);
+
+	return r;
+}
+
+/* Append the band node at the root of "tree" to the output of "w".
+ * That is, append its partial schedule, its permutable property,
+ * the coincident properties of its members and its AST build options.
+ */
+static isl_stat put_band(struct isl_binary_writer *w,
+	__isl_keep isl_schedule_tree *tree)
+{
+	int i;
+	isl_size n;
+	isl_bool permutable;
+	isl_multi_union_pw_aff *mupa;
+	isl_union_set *options;
+	isl_stat r;
+
+	mupa = isl_schedule_tree_band_get_partial_schedule(tree);
+	r = put_multi_union_pw_aff(w, mupa);
+	isl_multi_union_pw_aff_free(mupa);
+	if (r < 0)
+		return isl_stat_error;
+
+	permutable = isl_schedule_tree_band_get_permutable(tree);
+	if (permutable < 0 || put_uint(w, permutable) < 0)
+		return isl_stat_error;
+	n = isl_schedule_tree_band_n_member(tree);
+	if (n < 0)
+		return isl_stat_error;
+	for (i = 0; i < n; ++i) {
+		isl_bool coincident;
+
+		coincident = isl_schedule_tree_band_member_get_coincident(tree,
+									i);
+		if (coincident < 0 || put_uint(w, coincident) < 0)
+			return isl_stat_error;
+	}
+
+	options = isl_schedule_tree_band_get_ast_build_options(tree);
+	r = put_union_map(w, uset_to_umap(options));
+	isl_union_set_free(options);
+
+	return r;
+}
+
+/* Append the data associated to the root node of "tree"
+ * (other than its children) to the output of "w".
+ */
+static isl_stat put_node(struct isl_binary_writer *w,
+	__isl_keep isl_schedule_tree *tree)
+{
+	isl_set *set;
+	isl_union_set *uset;
+	isl_union_map *umap;
+	isl_union_pw_multi_aff *upma;
+	isl_id *id;
+	isl_stat r = isl_stat_ok;
+
+	switch (isl_schedule_tree_get_type(tree)) {
+	case isl_schedule_node_error:
+		return isl_stat_error;
+	case isl_schedule_node_leaf:
+	case isl_schedule_node_sequence:
+	case isl_schedule_node_set:
+		break;
+	case isl_schedule_node_band:
+		r = put_band(w, tree);
+		break;
+	case isl_schedule_node_context:
+		set = isl_schedule_tree_context_get_context(tree);
+		r = put_space(w, isl_set_peek_space(set));
+		if (r >= 0)
+			r = put_map_body(w, set_to_map(set));
+		isl_set_free(set);
+		break;
+	case isl_schedule_node_domain:
+		uset = isl_schedule_tree_domain_get_domain(tree);
+		r = put_union_map(w, uset_to_umap(uset));
+		isl_union_set_free(uset);
+		break;
+	case isl_schedule_node_expansion:
+		upma = isl_schedule_tree_expansion_get_contraction(tree);
+		r = put_union_pw_multi_aff(w, upma);
+		isl_union_pw_multi_aff_free(upma);
+		if (r < 0)
+			break;
+		umap = isl_schedule_tree_expansion_get_expansion(tree);
+		r = put_union_map(w, umap);
+		isl_union_map_free(umap);
+		break;
+	case isl_schedule_node_extension:
+		umap = isl_schedule_tree_extension_get_extension(tree);
+		r = put_union_map(w, umap);
+		isl_union_map_free(umap);
+		break;
+	case isl_schedule_node_filter:
+		uset = isl_schedule_tree_filter_get_filter(tree);
+		r = put_union_map(w, uset_to_umap(uset));
+		isl_union_set_free(uset);
+		break;
+	case isl_schedule_node_guard:
+		set = isl_schedule_tree_guard_get_guard(tree);
+		r = put_space(w, isl_set_peek_space(set));
+		if (r >= 0)
+			r = put_map_body(w, set_to_map(set));
+		isl_set_free(set);
+		break;
+	case isl_schedule_node_mark:
+		id = isl_schedule_tree_mark_get_id(tree);
+		r = put_id(w, id);
+		isl_id_free(id);
+		break;
+	}
+
+	return r;
+}
+
+/* Append the schedule tree "tree" to the output of "w".
+ * That is, append the type of the root node, the data associated
+ * to this node, the number of children and the children themselves.
+ * A node other than a sequence or set node without any children
+ * has an implicit leaf child.
+ */
+static isl_stat put_schedule_tree(struct isl_binary_writer *w,
+	__isl_keep isl_schedule_tree *tree)
+{
+	int i;
+	isl_size n;
+	enum isl_schedule_node_type type;
+
+	type = isl_schedule_tree_get_type(tree);
+	if (type == isl_schedule_node_error)
+		return isl_stat_error;
+	if (put_uint(w, type) < 0 || put_node(w, tree) < 0)
+		return isl_stat_error;
+	n = isl_schedule_tree_n_children(tree);
+	if (n < 0 || put_uint(w, n) < 0)
+		return isl_stat_error;
+	for (i = 0; i < n; ++i) {
+		isl_schedule_tree *child;
+		isl_stat r;
+
+		child = isl_schedule_tree_get_child(tree, i);
+		r = put_schedule_tree(w, child);
+		isl_schedule_tree_free(child);
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Append the header of the binary format for an object of type "kind"
+ * to the output of "w".
+ */
+static isl_stat put_header(struct isl_binary_writer *w,
+	enum isl_binary_kind kind)
+{
+	put_byte(w, 'I');
+	put_byte(w, 'S');
+	put_byte(w, 'L');
+	put_byte(w, 'B');
+	if (put_uint(w, ISL_BINARY_VERSION) < 0)
+		return isl_stat_error;
+	return put_uint(w, kind);
+}
+
+/* Print "bmap" to "p" in binary format.
+ */
+__isl_give isl_printer *isl_printer_print_basic_map_binary(
+	__isl_take isl_printer *p, __isl_keep isl_basic_map *bmap)
+{
+	struct isl_binary_writer w;
+	isl_stat r;
+
+	writer_init(&w, p);
+	r = put_header(&w, isl_binary_basic_map);
+	if (r >= 0)
+		r = put_space(&w, isl_basic_map_peek_space(bmap));
+	if (r >= 0)
+		r = put_basic_map_body(&w, bmap);
+	return writer_finish(&w, r);
+}
+
+/* Print "map" to "p" in binary format.
+ */
+__isl_give isl_printer *isl_printer_print_map_binary(
+	__isl_take isl_printer *p, __isl_keep isl_map *map)
+{
+	struct isl_binary_writer w;
+	isl_stat r;
+
+	writer_init(&w, p);
+	r = put_header(&w, isl_binary_map);
+	if (r >= 0)
+		r = put_space(&w, isl_map_peek_space(map));
+	if (r >= 0)
+		r = put_map_body(&w, map);
+	return writer_finish(&w, r);
+}
+
+/* Print "umap" to "p" in binary format.
+ */
+__isl_give isl_printer *isl_printer_print_union_map_binary(
+	__isl_take isl_printer *p, __isl_keep isl_union_map *umap)
+{
+	struct isl_binary_writer w;
+	isl_stat r;
+
+	writer_init(&w, p);
+	r = put_header(&w, isl_binary_union_map);
+	if (r >= 0)
+		r = put_union_map(&w, umap);
+	return writer_finish(&w, r);
+}
+
+/* Print "schedule" to "p" in binary format.
+ */
+__isl_give isl_printer *isl_printer_print_schedule_binary(
+	__isl_take isl_printer *p, __isl_keep isl_schedule *schedule)
+{
+	struct isl_binary_writer w;
+	isl_stat r;
+
+	writer_init(&w, p);
+	r = put_header(&w, isl_binary_schedule);
+	if (r >= 0 && !schedule)
+		r = isl_stat_error;
+	if (r >= 0)
+		r = put_schedule_tree(&w, schedule->root);
+	return writer_finish(&w, r);
+}
+
+/* Append the domain and the context of "sc" to the output of "w",
+ * followed by the constraints of each type, in the order
+ * of the isl_edge_type enumeration.
+ */
+static isl_stat put_schedule_constraints(struct isl_binary_writer *w,
+	__isl_keep isl_schedule_constraints *sc)
+{
+	enum isl_edge_type i;
+	isl_union_set *domain;
+	isl_set *context;
+	isl_stat r;
+
+	domain = isl_schedule_constraints_get_domain(sc);
+	r = put_union_map(w, uset_to_umap(domain));
+	isl_union_set_free(domain);
+	if (r < 0)
+		return isl_stat_error;
+	context = isl_schedule_constraints_get_context(sc);
+	r = put_space(w, isl_set_peek_space(context));
+	if (r >= 0)
+		r = put_map_body(w, set_to_map(context));
+	isl_set_free(context);
+	for (i = isl_edge_first; r >= 0 && i <= isl_edge_last; ++i) {
+		isl_union_map *c;
+
+		c = isl_schedule_constraints_get(sc, i);
+		r = put_union_map(w, c);
+		isl_union_map_free(c);
+	}
+
+	return r;
+}
+
+/* Print "sc" to "p" in binary format.
+ */
+__isl_give isl_printer *isl_printer_print_schedule_constraints_binary(
+	__isl_take isl_printer *p, __isl_keep isl_schedule_constraints *sc)
+{
+	struct isl_binary_writer w;
+	isl_stat r;
+
+	writer_init(&w, p);
+	r = put_header(&w, isl_binary_schedule_constraints);
+	if (r >= 0)
+		r = put_schedule_constraints(&w, sc);
+	return writer_finish(&w, r);
+}
+
+/* Internal data structure for reading the binary format
+ * from either a file or a string.
+ *
+ * If "file" is not NULL, then the data is read from "file".
+ * Otherwise, it is read from "str".
+ */
+struct isl_binary_reader {
+	isl_ctx *ctx;
+	FILE *file;
+	const unsigned char *str;
+	const unsigned char *end;
+};
+
+/* Initialize "r" for reading from "file".
+ */
+static void reader_init_file(struct isl_binary_reader *r, isl_ctx *ctx,
+	FILE *file)
+{
+	r->ctx = ctx;
+	r->file = file;
+	r->str = NULL;
+	r->end = NULL;
+}
+
+/* Initialize "r" for reading from "str".
+ */
+static void reader_init_str(struct isl_binary_reader *r, isl_ctx *ctx,
+	const char *str)
+{
+	r->ctx = ctx;
+	r->file = NULL;
+	r->str = (const unsigned char *) str;
+	r->end = NULL;
+}
+
+/* Initialize "r" for reading from the "size" bytes starting at "buf",
+ * skipping the first "*pos" bytes if "pos" is not NULL.
+ */
+static isl_stat reader_init_mem(struct isl_binary_reader *r, isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos)
+{
+	size_t start = pos ? *pos : 0;
+
+	if (!buf || start > size)
+		isl_die(ctx, isl_error_invalid, "position outside buffer",
+			return isl_stat_error);
+	r->ctx = ctx;
+	r->file = NULL;
+	r->str = (const unsigned char *) buf + start;
+	r->end = (const unsigned char *) buf + size;
+	return isl_stat_ok;
+}
+
+/* Record the position of "r" in the buffer "buf" in "pos",
+ * if "pos" is not NULL.
+ */
+static void reader_update_pos(struct isl_binary_reader *r, const char *buf,
+	size_t *pos)
+{
+	if (pos)
+		*pos = r->str - (const unsigned char *) buf;
+}
+
+/* Read a byte from "r".
+ * Return -1 (after reporting an error) if there is no more input.
+ * If "r" reads from a buffer of a given size, then the input
+ * ends at the end of that buffer.  Otherwise, a string input
+ * ends at the terminating NUL byte.
+ */
+static int get_byte(struct isl_binary_reader *r)
+{
+	int c;
+
+	if (r->file) {
+		c = fgetc(r->file);
+	} else if (!r->str || (r->end ? r->str >= r->end : !*r->str)) {
+		c = EOF;
+	} else {
+		c = *r->str++;
+	}
+	if (c == EOF)
+		isl_die(r->ctx, isl_error_invalid, "unexpected end of input",
+			return -1);
+	return c;
+}
+
+/* Report that the input of "r" does not represent valid binary data.
+ */
+static isl_stat invalid(struct isl_binary_reader *r)
+{
+	isl_die(r->ctx, isl_error_invalid, "invalid binary data",
+		return isl_stat_error);
+}
+
+/* Read a non-negative integer from "r" and store it in "u".
+ */
+static isl_stat get_uint(struct isl_binary_reader *r, unsigned long *u)
+{
+	unsigned long v = 0;
+
+	for (;;) {
+		int c = get_byte(r);
+
+		if (c < 0)
+			return isl_stat_error;
+		if (c & 0x80) {
+			if (v > (ULONG_MAX >> 7))
+				return invalid(r);
+			v = (v << 7) | (c & 127);
+		} else if (c & 0x40) {
+			if (v > (ULONG_MAX >> 6))
+				return invalid(r);
+			*u = (v << 6) | (c & 63);
+			return isl_stat_ok;
+		} else {
+			return invalid(r);
+		}
+	}
+}
+
+/* Read a non-negative integer from "r" that fits in an int and
+ * store it in "n".
+ */
+static isl_stat get_size(struct isl_binary_reader *r, int *n)
+{
+	unsigned long u;
+
+	if (get_uint(r, &u) < 0)
+		return isl_stat_error;
+	if (u > INT_MAX)
+		return invalid(r);
+	*n = u;
+	return isl_stat_ok;
+}
+
+/* Read a (possibly negative) integer from "r" and store it in "v".
+ *
+ * The encoded non-negative integer is accumulated in an unsigned long
+ * as long as it fits and in "v" otherwise.
+ * The least significant bit of the encoded integer is the least
+ * significant bit of the last group.
+ */
+static isl_stat get_int(struct isl_binary_reader *r, isl_int v)
+{
+	unsigned long acc = 0;
+	int big = 0;
+	int last;
+
+	do {
+		int c = get_byte(r);
+		int shift;
+		unsigned long group;
+
+		if (c < 0)
+			return isl_stat_error;
+		last = !(c & 0x80);
+		if (!last) {
+			shift = 7;
+			group = c & 127;
+		} else if (c & 0x40) {
+			shift = 6;
+			group = c & 63;
+		} else {
+			return invalid(r);
+		}
+		if (!big && acc <= (ULONG_MAX >> shift)) {
+			acc = (acc << shift) | group;
+		} else {
+			if (!big)
+				isl_int_set_ui(v, acc);
+			big = 1;
+			isl_int_mul_ui(v, v, 1ul << shift);
+			isl_int_add_ui(v, v, group);
+		}
+		if (last)
+			last = 1 + (group & 1);
+	} while (!last);
+
+	if (!big) {
+		if (acc & 1)
+			isl_int_set_si(v, -(long) (acc >> 1) - 1);
+		else
+			isl_int_set_ui(v, acc >> 1);
+		return isl_stat_ok;
+	}
+
+	isl_int_fdiv_q_ui(v, v, 2);
+	if (last == 2) {
+		isl_int_neg(v, v);
+		isl_int_sub_ui(v, v, 1);
+	}
+	return isl_stat_ok;
+}
+
+/* Read "n" integers from "r" and store them starting at "p".
+ */
+static isl_stat get_seq(struct isl_binary_reader *r, isl_int *p, int n)
+{
+	int i;
+
+	for (i = 0; i < n; ++i)
+		if (get_int(r, p[i]) < 0)
+			return isl_stat_error;
+
+	return isl_stat_ok;
+}
+
+/* Is there input for at least "n" more bytes in "r"?
+ * This can only be determined without consuming the input
+ * if "r" reads from a buffer or a string.
+ * When reading from a file, the input is assumed to be long enough.
+ */
+static isl_bool has_bytes(struct isl_binary_reader *r, size_t n)
+{
+	size_t i;
+
+	if (r->file)
+		return isl_bool_true;
+	if (!r->str)
+		return isl_bool_false;
+	if (r->end)
+		return isl_bool_ok((size_t) (r->end - r->str) >= n);
+	for (i = 0; i < n; ++i)
+		if (!r->str[i])
+			return isl_bool_false;
+	return isl_bool_true;
+}
+
+/* Check that the remaining input of "r" can hold "n" sequences
+ * of "len" integers each, given that each integer is encoded
+ * in at least one byte.
+ * This prevents a huge number of integers from being allocated
+ * on truncated or corrupted input.
+ */
+static isl_stat check_seqs(struct isl_binary_reader *r, size_t n, size_t len)
+{
+	isl_bool ok;
+
+	if (len != 0 && n > (size_t) -1 / len)
+		return invalid(r);
+	ok = has_bytes(r, n * len);
+	if (ok < 0)
+		return isl_stat_error;
+	if (!ok)
+		return invalid(r);
+	return isl_stat_ok;
+}
+
+/* Read an optional identifier from "r" and store it in "id".
+ * "id" is set to NULL if there is no identifier.
+ */
+static isl_stat get_id(struct isl_binary_reader *r, isl_id **id)
+{
+	unsigned long u;
+	size_t i, len;
+	char *name;
+
+	*id = NULL;
+	if (get_uint(r, &u) < 0)
+		return isl_stat_error;
+	if (u == 0)
+		return isl_stat_ok;
+	if (u == 1) {
+		*id = isl_id_alloc(r->ctx, NULL, NULL);
+		return *id ? isl_stat_ok : isl_stat_error;
+	}
+	len = u - 2;
+	if (len > INT_MAX)
+		return invalid(r);
+	name = isl_alloc_array(r->ctx, char, len + 1);
+	if (!name)
+		return isl_stat_error;
+	for (i = 0; i < len; ++i) {
+		int c = get_byte(r);
+
+		if (c <= 0) {
+			free(name);
+			return c < 0 ? isl_stat_error : invalid(r);
+		}
+		name[i] = c;
+	}
+	name[len] = '\0';
+	*id = isl_id_alloc(r->ctx, name, NULL);
+	free(name);
+
+	return *id ? isl_stat_ok : isl_stat_error;
+}
+
+/* Read an optional identifier from "r" and, if there is one,
+ * assign it to dimension "pos" of type "type" of "space".
+ */
+static __isl_give isl_space *get_dim_id(struct isl_binary_reader *r,
+	__isl_take isl_space *space, enum isl_dim_type type, int pos)
+{
+	isl_id *id;
+
+	if (get_id(r, &id) < 0)
+		return isl_space_free(space);
+	if (!id)
+		return space;
+	return isl_space_set_dim_id(space, type, pos, id);
+}
+
+/* Read a tuple written by put_tuple from "r" and
+ * return the corresponding set space with parameters "params".
+ */
+static __isl_give isl_space *get_tuple(struct isl_binary_reader *r,
+	__isl_keep isl_space *params)
+{
+	int i, n;
+	unsigned long nested;
+	isl_id *id;
+	isl_space *space;
+
+	if (get_id(r, &id) < 0)
+		return NULL;
+	if (get_uint(r, &nested) < 0)
+		goto error;
+	if (nested > 1) {
+		invalid(r);
+		goto error;
+	}
+	if (nested) {
+		isl_space *dom, *ran;
+
+		dom = get_tuple(r, params);
+		ran = dom ? get_tuple(r, params) : NULL;
+		space = isl_space_map_from_domain_and_range(dom, ran);
+		space = isl_space_wrap(space);
+	} else {
+		if (get_size(r, &n) < 0)
+			goto error;
+		space = isl_space_set_from_params(isl_space_copy(params));
+		space = isl_space_add_dims(space, isl_dim_set, n);
+		for (i = 0; space && i < n; ++i)
+			space = get_dim_id(r, space, isl_dim_set, i);
+	}
+	if (id)
+		space = isl_space_set_tuple_id(space, isl_dim_set, id);
+
+	return space;
+error:
+	isl_id_free(id);
+	return NULL;
+}
+
+/* Read a space written by put_space from "r".
+ */
+static __isl_give isl_space *get_space(struct isl_binary_reader *r)
+{
+	int i, nparam;
+	unsigned long kind;
+	isl_space *params, *space, *dom, *ran;
+
+	if (get_uint(r, &kind) < 0 || get_size(r, &nparam) < 0)
+		return NULL;
+	if (kind > 2) {
+		invalid(r);
+		return NULL;
+	}
+	params = isl_space_params_alloc(r->ctx, nparam);
+	for (i = 0; params && i < nparam; ++i) {
+		isl_id *id;
+
+		if (get_id(r, &id) < 0)
+			return isl_space_free(params);
+		if (!id) {
+			invalid(r);
+			return isl_space_free(params);
+		}
+		params = isl_space_set_dim_id(params, isl_dim_param, i, id);
+	}
+	if (!params || kind == 0)
+		return params;
+
+	if (kind == 1) {
+		space = get_tuple(r, params);
+		isl_space_free(params);
+		return space;
+	}
+
+	dom = get_tuple(r, params);
+	ran = dom ? get_tuple(r, params) : NULL;
+	isl_space_free(params);
+	return isl_space_map_from_domain_and_range(dom, ran);
+}
+
+/* Read a basic map written by put_basic_map_body from "r",
+ * given its space "space".
+ *
+ * The constraints are copied directly into the basic map
+ * and the flags are restored, so that no further simplification
+ * is performed.
+ * The numbers of divs and constraints are checked against
+ * the remaining input before the basic map is allocated.
+ */
+static __isl_give isl_basic_map *get_basic_map_body(
+	struct isl_binary_reader *r, __isl_take isl_space *space)
+{
+	int i, k;
+	int n_div, n_eq, n_ineq;
+	unsigned long flags;
+	isl_size dim;
+	isl_basic_map *bmap;
+
+	dim = isl_space_dim(space, isl_dim_all);
+	if (dim < 0 || get_uint(r, &flags) < 0 ||
+	    get_size(r, &n_div) < 0 || get_size(r, &n_eq) < 0 ||
+	    get_size(r, &n_ineq) < 0)
+		goto error;
+	if (n_div > INT_MAX - 2 - dim) {
+		invalid(r);
+		goto error;
+	}
+	if (check_seqs(r, n_div, 2 + dim + n_div) < 0 ||
+	    check_seqs(r, (size_t) n_eq + n_ineq, 1 + dim + n_div) < 0)
+		goto error;
+	bmap = isl_basic_map_alloc_space(space, n_div, n_eq, n_ineq);
+	if (!bmap)
+		return NULL;
+	for (i = 0; i < n_div; ++i) {
+		k = isl_basic_map_alloc_div(bmap);
+		if (k < 0 || get_seq(r, bmap->div[k], 2 + dim + n_div) < 0)
+			return isl_basic_map_free(bmap);
+	}
+	for (i = 0; i < n_eq; ++i) {
+		k = isl_basic_map_alloc_equality(bmap);
+		if (k < 0 || get_seq(r, bmap->eq[k], 1 + dim + n_div) < 0)
+			return isl_basic_map_free(bmap);
+	}
+	for (i = 0; i < n_ineq; ++i) {
+		k = isl_basic_map_alloc_inequality(bmap);
+		if (k < 0 || get_seq(r, bmap->ineq[k], 1 + dim + n_div) < 0)
+			return isl_basic_map_free(bmap);
+	}
+	bmap->flags = flags & ISL_BINARY_BASIC_MAP_FLAGS;
+
+	return bmap;
+error:
+	isl_space_free(space);
+	return NULL;
+}
+
+/* Read a map written by put_map_body from "r", given its space "space".
+ */
+static __isl_give isl_map *get_map_body(struct isl_binary_reader *r,
+	__isl_take isl_space *space)
+{
+	int i, n;
+	unsigned long flags;
+	isl_map *map;
+
+	if (!space || get_uint(r, &flags) < 0 || get_size(r, &n) < 0)
+		goto error;
+	map = isl_map_alloc_space(isl_space_copy(space), n,
+				flags & ISL_BINARY_MAP_FLAGS);
+	for (i = 0; map && i < n; ++i) {
+		isl_basic_map *bmap;
+
+		bmap = get_basic_map_body(r, isl_space_copy(space));
+		if (!bmap)
+			map = isl_map_free(map);
+		else
+			map->p[map->n++] = bmap;
+	}
+	isl_space_free(space);
+
+	return map;
+error:
+	isl_space_free(space);
+	return NULL;
+}
+
+/* Read a union map written by put_union_map from "r".
+ * If "set" is set, then the result is required to be a union set,
+ * i.e., each of its elements needs to live in a set or parameter space.
+ */
+static __isl_give isl_union_map *get_union_map_body(
+	struct isl_binary_reader *r, int set)
+{
+	int i, n;
+	isl_space *space;
+	isl_union_map *umap;
+
+	space = get_space(r);
+	if (!space)
+		return NULL;
+	if (!isl_space_is_params(space)) {
+		isl_space_free(space);
+		invalid(r);
+		return NULL;
+	}
+	if (get_size(r, &n) < 0) {
+		isl_space_free(space);
+		return NULL;
+	}
+	umap = isl_union_map_empty(space);
+	for (i = 0; umap && i < n; ++i) {
+		isl_map *map;
+
+		space = get_space(r);
+		if (set && space &&
+		    !isl_space_is_set(space) && !isl_space_is_params(space)) {
+			invalid(r);
+			space = isl_space_free(space);
+		}
+		map = get_map_body(r, space);
+		umap = isl_union_map_add_map(umap, map);
+	}
+
+	return umap;
+}
+
+/* Read a union map written by put_union_map from "r".
+ */
+static __isl_give isl_union_map *get_union_map(struct isl_binary_reader *r)
+{
+	return get_union_map_body(r, 0);
+}
+
+/* Read a union set written by put_union_map from "r".
+ */
+static __isl_give isl_union_set *get_union_set(struct isl_binary_reader *r)
+{
+	return uset_from_umap(get_union_map_body(r, 1));
+}
+
+/* Read an affine expression written by put_aff_body from "r",
+ * given its domain space "space".
+ */
+static __isl_give isl_aff *get_aff_body(struct isl_binary_reader *r,
+	__isl_keep isl_space *space)
+{
+	int i, n_div;
+	isl_size dim;
+	isl_mat *div;
+	isl_vec *v;
+	isl_local_space *ls;
+
+	dim = isl_space_dim(space, isl_dim_all);
+	if (dim < 0 || get_size(r, &n_div) < 0)
+		return NULL;
+	div = isl_mat_alloc(r->ctx, n_div, 2 + dim + n_div);
+	for (i = 0; div && i < n_div; ++i)
+		if (get_seq(r, div->row[i], 2 + dim + n_div) < 0)
+			div = isl_mat_free(div);
+	ls = isl_local_space_alloc_div(isl_space_copy(space), div);
+	v = isl_vec_alloc(r->ctx, 2 + dim + n_div);
+	if (ls && v && get_seq(r, v->el, v->size) < 0)
+		v = isl_vec_free(v);
+	if (!v)
+		ls = isl_local_space_free(ls);
+	return isl_aff_alloc_vec(ls, v);
+}
+
+/* Read a multi-affine expression written by put_multi_aff_body from "r",
+ * given its space "space".
+ */
+static __isl_give isl_multi_aff *get_multi_aff_body(
+	struct isl_binary_reader *r, __isl_take isl_space *space)
+{
+	int i;
+	isl_size n;
+	isl_space *dom;
+	isl_aff_list *list;
+
+	n = isl_space_dim(space, isl_dim_out);
+	if (n < 0)
+		goto error;
+	dom = isl_space_domain(isl_space_copy(space));
+	list = isl_aff_list_alloc(r->ctx, n);
+	for (i = 0; list && i < n; ++i)
+		list = isl_aff_list_add(list, get_aff_body(r, dom));
+	isl_space_free(dom);
+
+	return isl_multi_aff_from_aff_list(space, list);
+error:
+	isl_space_free(space);
+	return NULL;
+}
+
+/* Read a piecewise affine expression written by put_pw_aff_body from "r",
+ * given its space "space".
+ */
+static __isl_give isl_pw_aff *get_pw_aff_body(struct isl_binary_reader *r,
+	__isl_take isl_space *space)
+{
+	int i, n;
+	isl_space *dom;
+	isl_pw_aff *pa;
+
+	if (!space || get_size(r, &n) < 0)
+		goto error;
+	dom = isl_space_domain(isl_space_copy(space));
+	pa = isl_pw_aff_alloc_size(space, n);
+	for (i = 0; pa && i < n; ++i) {
+		isl_set *set;
+		isl_aff *aff;
+
+		set = set_from_map(get_map_body(r, isl_space_copy(dom)));
+		aff = set ? get_aff_body(r, dom) : NULL;
+		pa = isl_pw_aff_add_piece(pa, set, aff);
+	}
+	isl_space_free(dom);
+
+	return pa;
+error:
+	isl_space_free(space);
+	return NULL;
+}
+
+/* Read a piecewise multi-affine expression written
+ * by put_pw_multi_aff_body from "r", given its space "space".
+ */
+static __isl_give isl_pw_multi_aff *get_pw_multi_aff_body(
+	struct isl_binary_reader *r, __isl_take isl_space *space)
+{
+	int i, n;
+	isl_space *dom;
+	isl_pw_multi_aff *pma;
+
+	if (!space || get_size(r, &n) < 0)
+		goto error;
+	dom = isl_space_domain(isl_space_copy(space));
+	pma = isl_pw_multi_aff_alloc_size(isl_space_copy(space), n);
+	for (i = 0; pma && i < n; ++i) {
+		isl_set *set;
+		isl_multi_aff *ma;
+
+		set = set_from_map(get_map_body(r, isl_space_copy(dom)));
+		ma = set ? get_multi_aff_body(r, isl_space_copy(space)) : NULL;
+		pma = isl_pw_multi_aff_add_piece(pma, set, ma);
+	}
+	isl_space_free(dom);
+	isl_space_free(space);
+
+	return pma;
+error:
+	isl_space_free(space);
+	return NULL;
+}
+
+/* Read the parameter space of a union expression from "r",
+ * along with the number of elements, which is stored in "n".
+ */
+static __isl_give isl_space *get_union_space(struct isl_binary_reader *r,
+	int *n)
+{
+	isl_space *space;
+
+	space = get_space(r);
+	if (!space)
+		return NULL;
+	if (!isl_space_is_params(space)) {
+		invalid(r);
+		return isl_space_free(space);
+	}
+	if (get_size(r, n) < 0)
+		return isl_space_free(space);
+	return space;
+}
+
+/* Read a union piecewise affine expression written
+ * by put_union_pw_aff from "r".
+ */
+static __isl_give isl_union_pw_aff *get_union_pw_aff(
+	struct isl_binary_reader *r)
+{
+	int i, n;
+	isl_space *space;
+	isl_union_pw_aff *upa;
+
+	space = get_union_space(r, &n);
+	if (!space)
+		return NULL;
+	upa = isl_union_pw_aff_empty(space);
+	for (i = 0; upa && i < n; ++i) {
+		isl_pw_aff *pa;
+
+		pa = get_pw_aff_body(r, get_space(r));
+		upa = isl_union_pw_aff_add_pw_aff(upa, pa);
+	}
+
+	return upa;
+}
+
+/* Read a union piecewise multi-affine expression written
+ * by put_union_pw_multi_aff from "r".
+ */
+static __isl_give isl_union_pw_multi_aff *get_union_pw_multi_aff(
+	struct isl_binary_reader *r)
+{
+	int i, n;
+	isl_space *space;
+	isl_union_pw_multi_aff *upma;
+
+	space = get_union_space(r, &n);
+	if (!space)
+		return NULL;
+	upma = isl_union_pw_multi_aff_empty(space);
+	for (i = 0; upma && i < n; ++i) {
+		isl_pw_multi_aff *pma;
+
+		pma = get_pw_multi_aff_body(r, get_space(r));
+		upma = isl_union_pw_multi_aff_add_pw_multi_aff(upma, pma);
+	}
+
+	return upma;
+}
+
+/* Read a multi union piecewise affine expression written
+ * by put_multi_union_pw_aff from "r".
+ */
+static __isl_give isl_multi_union_pw_aff *get_multi_union_pw_aff(
+	struct isl_binary_reader *r)
+{
+	int i;
+	isl_size n;
+	isl_space *space;
+	isl_union_pw_aff_list *list;
+	isl_multi_union_pw_aff *mupa;
+
+	space = get_space(r);
+	n = isl_space_dim(space, isl_dim_out);
+	if (n < 0)
+		goto error;
+	list = isl_union_pw_aff_list_alloc(r->ctx, n);
+	for (i = 0; list && i < n; ++i)
+		list = isl_union_pw_aff_list_add(list, get_union_pw_aff(r));
+	mupa = isl_multi_union_pw_aff_from_union_pw_aff_list(space, list);
+	if (mupa && n == 0)
+		mupa = isl_multi_union_pw_aff_intersect_domain(mupa,
+							get_union_set(r));
+
+	return mupa;
+error:
+	isl_space_free(space);
+	return NULL;
+}
+
+/* Read a set written by put_space and put_map_body from "r".
+ */
+static __isl_give isl_set *get_set(struct isl_binary_reader *r)
+{
+	isl_space *space;
+
+	space = get_space(r);
+	if (space && !isl_space_is_set(space)) {
+		invalid(r);
+		space = isl_space_free(space);
+	}
+	return set_from_map(get_map_body(r, space));
+}
+
+/* Read the band node data written by put_band from "r".
+ */
+static __isl_give isl_schedule_band *get_band(struct isl_binary_reader *r)
+{
+	int i;
+	isl_size n;
+	unsigned long permutable;
+	isl_multi_union_pw_aff *mupa;
+	isl_schedule_band *band;
+
+	mupa = get_multi_union_pw_aff(r);
+	n = isl_multi_union_pw_aff_size(mupa);
+	band = isl_schedule_band_from_multi_union_pw_aff(mupa);
+	if (n < 0 || !band || get_uint(r, &permutable) < 0)
+		return isl_schedule_band_free(band);
+	band = isl_schedule_band_set_permutable(band, permutable != 0);
+	for (i = 0; band && i < n; ++i) {
+		unsigned long coincident;
+
+		if (get_uint(r, &coincident) < 0)
+			return isl_schedule_band_free(band);
+		band = isl_schedule_band_member_set_coincident(band, i,
+							coincident != 0);
+	}
+	return isl_schedule_band_set_ast_build_options(band, get_union_set(r));
+}
+
+/* Read a schedule tree written by put_schedule_tree from "r".
+ *
+ * The children are read first, such that the root node
+ * can be inserted on top of its (single) child.
+ * If a node other than a sequence or set node has no children,
+ * then it is inserted on top of a leaf.
+ */
+static __isl_give isl_schedule_tree *get_schedule_tree(
+	struct isl_binary_reader *r)
+{
+	int i, n;
+	unsigned long type;
+	isl_schedule_tree *tree = NULL;
+	isl_schedule_band *band = NULL;
+	isl_set *set = NULL;
+	isl_union_set *uset = NULL;
+	isl_union_map *umap = NULL;
+	isl_union_pw_multi_aff *upma = NULL;
+	isl_id *id = NULL;
+	isl_schedule_tree_list *list;
+
+	if (get_uint(r, &type) < 0)
+		return NULL;
+	switch (type) {
+	case isl_schedule_node_band:
+		band = get_band(r);
+		if (!band)
+			return NULL;
+		break;
+	case isl_schedule_node_context:
+	case isl_schedule_node_guard:
+		set = get_set(r);
+		if (!set)
+			return NULL;
+		break;
+	case isl_schedule_node_domain:
+	case isl_schedule_node_filter:
+		uset = get_union_set(r);
+		if (!uset)
+			return NULL;
+		break;
+	case isl_schedule_node_expansion:
+		upma = get_union_pw_multi_aff(r);
+		umap = upma ? get_union_map(r) : NULL;
+		if (!umap) {
+			isl_union_pw_multi_aff_free(upma);
+			return NULL;
+		}
+		break;
+	case isl_schedule_node_extension:
+		umap = get_union_map(r);
+		if (!umap)
+			return NULL;
+		break;
+	case isl_schedule_node_mark:
+		if (get_id(r, &id) < 0)
+			return NULL;
+		if (!id) {
+			invalid(r);
+			return NULL;
+		}
+		break;
+	case isl_schedule_node_leaf:
+	case isl_schedule_node_sequence:
+	case isl_schedule_node_set:
+		break;
+	default:
+		invalid(r);
+		return NULL;
+	}
+
+	if (get_size(r, &n) < 0)
+		goto error;
+	if (type == isl_schedule_node_sequence ||
+	    type == isl_schedule_node_set) {
+		list = isl_schedule_tree_list_alloc(r->ctx, n);
+		for (i = 0; list && i < n; ++i)
+			list = isl_schedule_tree_list_add(list,
+							get_schedule_tree(r));
+		return isl_schedule_tree_from_children(type, list);
+	}
+	if (n > 1 || (n > 0 && type == isl_schedule_node_leaf)) {
+		invalid(r);
+		goto error;
+	}
+	if (n == 1)
+		tree = get_schedule_tree(r);
+	else
+		tree = isl_schedule_tree_leaf(r->ctx);
+
+	switch (type) {
+	case isl_schedule_node_band:
+		return isl_schedule_tree_insert_band(tree, band);
+	case isl_schedule_node_context:
+		return isl_schedule_tree_insert_context(tree, set);
+	case isl_schedule_node_guard:
+		return isl_schedule_tree_insert_guard(tree, set);
+	case isl_schedule_node_domain:
+		return isl_schedule_tree_insert_domain(tree, uset);
+	case isl_schedule_node_filter:
+		return isl_schedule_tree_insert_filter(tree, uset);
+	case isl_schedule_node_expansion:
+		return isl_schedule_tree_insert_expansion(tree, upma, umap);
+	case isl_schedule_node_extension:
+		return isl_schedule_tree_insert_extension(tree, umap);
+	case isl_schedule_node_mark:
+		return isl_schedule_tree_insert_mark(tree, id);
+	default:
+		return tree;
+	}
+error:
+	isl_schedule_band_free(band);
+	isl_set_free(set);
+	isl_union_set_free(uset);
+	isl_union_map_free(umap);
+	isl_union_pw_multi_aff_free(upma);
+	isl_id_free(id);
+	return NULL;
+}
+
+/* Read the header of the binary format from "r" and
+ * check that it describes an object of type "kind".
+ */
+static isl_stat get_header(struct isl_binary_reader *r,
+	enum isl_binary_kind kind)
+{
+	const char *magic = "ISLB";
+	unsigned long version, stored_kind;
+	int i;
+
+	for (i = 0; magic[i]; ++i) {
+		int c = get_byte(r);
+
+		if (c < 0)
+			return isl_stat_error;
+		if (c != magic[i])
+			isl_die(r->ctx, isl_error_invalid,
+				"not in binary format", return isl_stat_error);
+	}
+	if (get_uint(r, &version) < 0)
+		return isl_stat_error;
+	if (version > ISL_BINARY_VERSION)
+		isl_die(r->ctx, isl_error_unsupported,
+			"unsupported binary format version",
+			return isl_stat_error);
+	if (get_uint(r, &stored_kind) < 0)
+		return isl_stat_error;
+	if (stored_kind != kind)
+		isl_die(r->ctx, isl_error_invalid,
+			"binary data describes a different type of object",
+			return isl_stat_error);
+	return isl_stat_ok;
+}
+
+/* Read a basic map in binary format from "r".
+ */
+static __isl_give isl_basic_map *read_basic_map(struct isl_binary_reader *r)
+{
+	if (get_header(r, isl_binary_basic_map) < 0)
+		return NULL;
+	return get_basic_map_body(r, get_space(r));
+}
+
+/* Read a basic set in binary format from "r".
+ */
+static __isl_give isl_basic_set *read_basic_set(struct isl_binary_reader *r)
+{
+	isl_space *space;
+
+	if (get_header(r, isl_binary_basic_map) < 0)
+		return NULL;
+	space = get_space(r);
+	if (space && !isl_space_is_set(space)) {
+		invalid(r);
+		space = isl_space_free(space);
+	}
+	return bset_from_bmap(get_basic_map_body(r, space));
+}
+
+/* Read a map in binary format from "r".
+ */
+static __isl_give isl_map *read_map(struct isl_binary_reader *r)
+{
+	if (get_header(r, isl_binary_map) < 0)
+		return NULL;
+	return get_map_body(r, get_space(r));
+}
+
+/* Read a set in binary format from "r".
+ */
+static __isl_give isl_set *read_set(struct isl_binary_reader *r)
+{
+	if (get_header(r, isl_binary_map) < 0)
+		return NULL;
+	return get_set(r);
+}
+
+/* Read a union map in binary format from "r".
+ */
+static __isl_give isl_union_map *read_union_map(struct isl_binary_reader *r)
+{
+	if (get_header(r, isl_binary_union_map) < 0)
+		return NULL;
+	return get_union_map(r);
+}
+
+/* Read a union set in binary format from "r".
+ */
+static __isl_give isl_union_set *read_union_set(struct isl_binary_reader *r)
+{
+	if (get_header(r, isl_binary_union_map) < 0)
+		return NULL;
+	return get_union_set(r);
+}
+
+/* Read a schedule in binary format from "r".
+ */
+static __isl_give isl_schedule *read_schedule(struct isl_binary_reader *r)
+{
+	isl_schedule_tree *tree;
+
+	if (get_header(r, isl_binary_schedule) < 0)
+		return NULL;
+	tree = get_schedule_tree(r);
+	return isl_schedule_from_schedule_tree(r->ctx, tree);
+}
+
+/* Read schedule constraints in binary format from "r".
+ * The constraints of each type replace the initially empty
+ * constraints of schedule constraints on the domain that was read,
+ * such that they are not modified in any way.
+ */
+static __isl_give isl_schedule_constraints *read_schedule_constraints(
+	struct isl_binary_reader *r)
+{
+	isl_union_map *c[isl_edge_last + 1];
+	isl_schedule_constraints *sc;
+	isl_union_set *domain;
+	isl_set *context;
+	enum isl_edge_type i;
+	int ok;
+
+	if (get_header(r, isl_binary_schedule_constraints) < 0)
+		return NULL;
+	domain = get_union_set(r);
+	context = domain ? get_set(r) : NULL;
+	ok = context != NULL;
+	for (i = isl_edge_first; i <= isl_edge_last; ++i) {
+		c[i] = ok ? get_union_map(r) : NULL;
+		ok = c[i] != NULL;
+	}
+
+	sc = isl_schedule_constraints_on_domain(domain);
+	sc = isl_schedule_constraints_set_context(sc, context);
+	for (i = isl_edge_first; i <= isl_edge_last; ++i) {
+		if (!c[i])
+			return isl_schedule_constraints_free(sc);
+		sc = isl_schedule_constraints_replace(sc, i, c[i]);
+	}
+
+	return sc;
+}
+
+__isl_give isl_basic_map *isl_basic_map_read_from_binary_file(isl_ctx *ctx,
+	FILE *input)
+{
+	struct isl_binary_reader r;
+
+	reader_init_file(&r, ctx, input);
+	return read_basic_map(&r);
+}
+
+__isl_give isl_basic_map *isl_basic_map_read_from_binary_str(isl_ctx *ctx,
+	const char *str)
+{
+	struct isl_binary_reader r;
+
+	reader_init_str(&r, ctx, str);
+	return read_basic_map(&r);
+}
+
+__isl_give isl_basic_map *isl_basic_map_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos)
+{
+	struct isl_binary_reader r;
+	isl_basic_map *bmap;
+
+	if (reader_init_mem(&r, ctx, buf, size, pos) < 0)
+		return NULL;
+	bmap = read_basic_map(&r);
+	if (bmap)
+		reader_update_pos(&r, buf, pos);
+	return bmap;
+}
+
+__isl_give isl_basic_set *isl_basic_set_read_from_binary_file(isl_ctx *ctx,
+	FILE *input)
+{
+	struct isl_binary_reader r;
+
+	reader_init_file(&r, ctx, input);
+	return read_basic_set(&r);
+}
+
+__isl_give isl_basic_set *isl_basic_set_read_from_binary_str(isl_ctx *ctx,
+	const char *str)
+{
+	struct isl_binary_reader r;
+
+	reader_init_str(&r, ctx, str);
+	return read_basic_set(&r);
+}
+
+__isl_give isl_basic_set *isl_basic_set_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos)
+{
+	struct isl_binary_reader r;
+	isl_basic_set *bset;
+
+	if (reader_init_mem(&r, ctx, buf, size, pos) < 0)
+		return NULL;
+	bset = read_basic_set(&r);
+	if (bset)
+		reader_update_pos(&r, buf, pos);
+	return bset;
+}
+
+__isl_give isl_map *isl_map_read_from_binary_file(isl_ctx *ctx, FILE *input)
+{
+	struct isl_binary_reader r;
+
+	reader_init_file(&r, ctx, input);
+	return read_map(&r);
+}
+
+__isl_give isl_map *isl_map_read_from_binary_str(isl_ctx *ctx,
+	const char *str)
+{
+	struct isl_binary_reader r;
+
+	reader_init_str(&r, ctx, str);
+	return read_map(&r);
+}
+
+__isl_give isl_map *isl_map_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos)
+{
+	struct isl_binary_reader r;
+	isl_map *map;
+
+	if (reader_init_mem(&r, ctx, buf, size, pos) < 0)
+		return NULL;
+	map = read_map(&r);
+	if (map)
+		reader_update_pos(&r, buf, pos);
+	return map;
+}
+
+__isl_give isl_set *isl_set_read_from_binary_file(isl_ctx *ctx, FILE *input)
+{
+	struct isl_binary_reader r;
+
+	reader_init_file(&r, ctx, input);
+	return read_set(&r);
+}
+
+__isl_give isl_set *isl_set_read_from_binary_str(isl_ctx *ctx,
+	const char *str)
+{
+	struct isl_binary_reader r;
+
+	reader_init_str(&r, ctx, str);
+	return read_set(&r);
+}
+
+__isl_give isl_set *isl_set_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos)
+{
+	struct isl_binary_reader r;
+	isl_set *set;
+
+	if (reader_init_mem(&r, ctx, buf, size, pos) < 0)
+		return NULL;
+	set = read_set(&r);
+	if (set)
+		reader_update_pos(&r, buf, pos);
+	return set;
+}
+
+__isl_give isl_union_map *isl_union_map_read_from_binary_file(isl_ctx *ctx,
+	FILE *input)
+{
+	struct isl_binary_reader r;
+
+	reader_init_file(&r, ctx, input);
+	return read_union_map(&r);
+}
+
+__isl_give isl_union_map *isl_union_map_read_from_binary_str(isl_ctx *ctx,
+	const char *str)
+{
+	struct isl_binary_reader r;
+
+	reader_init_str(&r, ctx, str);
+	return read_union_map(&r);
+}
+
+__isl_give isl_union_map *isl_union_map_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos)
+{
+	struct isl_binary_reader r;
+	isl_union_map *umap;
+
+	if (reader_init_mem(&r, ctx, buf, size, pos) < 0)
+		return NULL;
+	umap = read_union_map(&r);
+	if (umap)
+		reader_update_pos(&r, buf, pos);
+	return umap;
+}
+
+__isl_give isl_union_set *isl_union_set_read_from_binary_file(isl_ctx *ctx,
+	FILE *input)
+{
+	struct isl_binary_reader r;
+
+	reader_init_file(&r, ctx, input);
+	return read_union_set(&r);
+}
+
+__isl_give isl_union_set *isl_union_set_read_from_binary_str(isl_ctx *ctx,
+	const char *str)
+{
+	struct isl_binary_reader r;
+
+	reader_init_str(&r, ctx, str);
+	return read_union_set(&r);
+}
+
+__isl_give isl_union_set *isl_union_set_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos)
+{
+	struct isl_binary_reader r;
+	isl_union_set *uset;
+
+	if (reader_init_mem(&r, ctx, buf, size, pos) < 0)
+		return NULL;
+	uset = read_union_set(&r);
+	if (uset)
+		reader_update_pos(&r, buf, pos);
+	return uset;
+}
+
+__isl_give isl_schedule *isl_schedule_read_from_binary_file(isl_ctx *ctx,
+	FILE *input)
+{
+	struct isl_binary_reader r;
+
+	reader_init_file(&r, ctx, input);
+	return read_schedule(&r);
+}
+
+__isl_give isl_schedule *isl_schedule_read_from_binary_str(isl_ctx *ctx,
+	const char *str)
+{
+	struct isl_binary_reader r;
+
+	reader_init_str(&r, ctx, str);
+	return read_schedule(&r);
+}
+
+__isl_give isl_schedule *isl_schedule_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos)
+{
+	struct isl_binary_reader r;
+	isl_schedule *schedule;
+
+	if (reader_init_mem(&r, ctx, buf, size, pos) < 0)
+		return NULL;
+	schedule = read_schedule(&r);
+	if (schedule)
+		reader_update_pos(&r, buf, pos);
+	return schedule;
+}
+
+__isl_give isl_schedule_constraints *
+isl_schedule_constraints_read_from_binary_file(isl_ctx *ctx, FILE *input)
+{
+	struct isl_binary_reader r;
+
+	reader_init_file(&r, ctx, input);
+	return read_schedule_constraints(&r);
+}
+
+__isl_give isl_schedule_constraints *
+isl_schedule_constraints_read_from_binary_str(isl_ctx *ctx, const char *str)
+{
+	struct isl_binary_reader r;
+
+	reader_init_str(&r, ctx, str);
+	return read_schedule_constraints(&r);
+}
+
+__isl_give isl_schedule_constraints *
+isl_schedule_constraints_read_from_binary_mem(isl_ctx *ctx,
+	const char *buf, size_t size, size_t *pos)
+{
+	struct isl_binary_reader r;
+	isl_schedule_constraints *sc;
+
+	if (reader_init_mem(&r, ctx, buf, size, pos) < 0)
+		return NULL;
+	sc = read_schedule_constraints(&r);
+	if (sc)
+		reader_update_pos(&r, buf, pos);
+	return sc;
+}
@@ -0,0 +1,21 @@
+#ifndef ISL_BINARY_PRIVATE_H
+#define ISL_BINARY_PRIVATE_H
+
+#include <isl/printer.h>
+#include <isl/map_type.h>
+#include <isl/union_map_type.h>
+#include <isl/schedule_type.h>
+#include <isl/schedule.h>
+
+__isl_give isl_printer *isl_printer_print_basic_map_binary(
+	__isl_take isl_printer *p, __isl_keep isl_basic_map *bmap);
+__isl_give isl_printer *isl_printer_print_map_binary(
+	__isl_take isl_printer *p, __isl_keep isl_map *map);
+__isl_give isl_printer *isl_printer_print_union_map_binary(
+	__isl_take isl_printer *p, __isl_keep isl_union_map *umap);
+__isl_give isl_printer *isl_printer_print_schedule_binary(
+	__isl_take isl_printer *p, __isl_keep isl_schedule *schedule);
+__isl_give isl_printer *isl_printer_print_schedule_constraints_binary(
+	__isl_take isl_printer *p, __isl_keep isl_schedule_constraints *sc);
+
+#endif
@@ -9,9 +9,7 @@
 
 #include <isl_blk.h>
 #include <isl_ctx_private.h>
-
-/* The maximal number of cache misses before first element is evicted */
-#define ISL_BLK_MAX_MISS	100
+#include <isl_options_private.h>
 
 struct isl_blk isl_blk_empty()
 {
@@ -71,35 +69,126 @@ static struct isl_blk extend(struct isl_ctx *ctx, struct isl_blk block,
 	return block;
 }
 
-struct isl_blk isl_blk_alloc(struct isl_ctx *ctx, size_t n)
+/* Return the size class of a block of size "n", with "n" positive.
+ * Size class "c" contains the blocks with a size
+ * in the range [2^c, 2^(c+1)), except for the final size class,
+ * which contains all blocks of size greater than or equal to 2^c.
+ */
+static int size_class(size_t n)
+{
+	int c = 0;
+
+	while (n >>= 1)
+		if (++c == ISL_BLK_N_CLASS - 1)
+			break;
+
+	return c;
+}
+
+/* Return the position of a cached block in size class "c"
+ * with a size of at least "n", or -1 if there is no such block.
+ */
+static int find_cached(struct isl_ctx *ctx, int c, size_t n)
 {
 	int i;
+
+	for (i = ctx->n_cached[c] - 1; i >= 0; --i)
+		if (ctx->cache[c][i].size >= n)
+			return i;
+
+	return -1;
+}
+
+/* Remove the cached block at position "pos" of size class "c"
+ * from the cache and return it.
+ */
+static struct isl_blk take_cached(struct isl_ctx *ctx, int c, int pos)
+{
+	struct isl_blk block;
+
+	block = ctx->cache[c][pos];
+	if (--ctx->n_cached[c] != pos)
+		ctx->cache[c][pos] = ctx->cache[c][ctx->n_cached[c]];
+
+	return block;
+}
+
+/* Return the position of a block in size class "c" of the arena
+ * with a size of at least "n", or -1 if there is no such block.
+ * Only the most recently added blocks are considered
+ * in order to bound the time spent looking for a block.
+ */
+static int find_arena(struct isl_ctx *ctx, int c, size_t n)
+{
+	int i, min;
+
+	min = ctx->n_arena[c] - ISL_BLK_CLASS_CACHE_SIZE;
+	if (min < 0)
+		min = 0;
+	for (i = ctx->n_arena[c] - 1; i >= min; --i)
+		if (ctx->arena[c][i].size >= n)
+			return i;
+
+	return -1;
+}
+
+/* Remove the block at position "pos" of size class "c"
+ * from the arena and return it.
+ */
+static struct isl_blk take_arena(struct isl_ctx *ctx, int c, int pos)
+{
+	struct isl_blk block;
+
+	block = ctx->arena[c][pos];
+	if (--ctx->n_arena[c] != pos)
+		ctx->arena[c][pos] = ctx->arena[c][ctx->n_arena[c]];
+
+	return block;
+}
+
+/* Try and remove a block of at least "n" elements from size class "c"
+ * of the cache or the arena.
+ * Return an empty block if no such block can be found.
+ */
+static struct isl_blk take_reusable(struct isl_ctx *ctx, int c, size_t n)
+{
+	int pos;
+
+	pos = find_cached(ctx, c, n);
+	if (pos >= 0)
+		return take_cached(ctx, c, pos);
+	pos = find_arena(ctx, c, n);
+	if (pos >= 0)
+		return take_arena(ctx, c, pos);
+	return isl_blk_empty();
+}
+
+/* Allocate a block of "n" isl_int values.
+ *
+ * First try to reuse a cached block of at least "n" elements,
+ * either from the cache or from the arena.
+ * Such a block is looked for in the size class of "n" and,
+ * if none can be found there, in the next size class,
+ * such that the reused block is at most four times as large as required.
+ * Only if no such block can be found, a fresh block is allocated.
+ */
+struct isl_blk isl_blk_alloc(struct isl_ctx *ctx, size_t n)
+{
+	int c;
 	struct isl_blk block;
 
 	block = isl_blk_empty();
-	if (n && ctx->n_cached) {
-		int best = 0;
-		for (i = 1; ctx->cache[best].size != n && i < ctx->n_cached; ++i) {
-			if (ctx->cache[best].size < n) {
-				if (ctx->cache[i].size > ctx->cache[best].size)
-					best = i;
-			} else if (ctx->cache[i].size >= n &&
-				   ctx->cache[i].size < ctx->cache[best].size)
-					best = i;
-		}
-		if (ctx->cache[best].size < 2 * n + 100) {
-			block = ctx->cache[best];
-			if (--ctx->n_cached != best)
-				ctx->cache[best] = ctx->cache[ctx->n_cached];
-			if (best == 0)
-				ctx->n_miss = 0;
-		} else if (ctx->n_miss++ >= ISL_BLK_MAX_MISS) {
-			isl_blk_free_force(ctx, ctx->cache[0]);
-			if (--ctx->n_cached != 0)
-				ctx->cache[0] = ctx->cache[ctx->n_cached];
-			ctx->n_miss = 0;
-		}
-	}
+	if (n == 0)
+		return block;
+
+	c = size_class(n);
+	block = take_reusable(ctx, c, n);
+	if (isl_blk_is_empty(block) && c + 1 < ISL_BLK_N_CLASS)
+		block = take_reusable(ctx, c + 1, n);
+	if (isl_blk_is_empty(block))
+		ctx->n_miss++;
+	else
+		ctx->n_hit++;
 
 	return extend(ctx, block, n);
 }
@@ -113,22 +202,76 @@ struct isl_blk isl_blk_extend(struct isl_ctx *ctx, struct isl_blk block,
 	return extend(ctx, block, new_n);
 }
 
+/* Add "block" to size class "c" of the arena.
+ * If the arena cannot be extended, then simply free "block".
+ */
+static void add_arena(struct isl_ctx *ctx, int c, struct isl_blk block)
+{
+	if (ctx->n_arena[c] >= ctx->size_arena[c]) {
+		int size;
+		struct isl_blk *arena;
+
+		size = 2 * ctx->size_arena[c] + ISL_BLK_CLASS_CACHE_SIZE;
+		arena = isl_realloc_array(ctx, ctx->arena[c],
+					struct isl_blk, size);
+		if (!arena) {
+			isl_blk_free_force(ctx, block);
+			return;
+		}
+		ctx->arena[c] = arena;
+		ctx->size_arena[c] = size;
+	}
+
+	ctx->arena[c][ctx->n_arena[c]++] = block;
+}
+
+/* Free "block", keeping it in the cache of its size class
+ * for later reuse if this size class is not full yet.
+ * Otherwise, if some isl_ctx_push_arena scope is active,
+ * then keep the block in the arena until the outermost scope is popped.
+ */
 void isl_blk_free(struct isl_ctx *ctx, struct isl_blk block)
 {
+	int c;
+
 	if (isl_blk_is_empty(block) || isl_blk_is_error(block))
 		return;
 
-	if (ctx->n_cached < ISL_BLK_CACHE_SIZE)
-		ctx->cache[ctx->n_cached++] = block;
+	c = size_class(block.size);
+	if (ctx->opt->memory_lean && ctx->arena_depth == 0)
+		isl_blk_free_force(ctx, block);
+	else if (ctx->n_cached[c] < ISL_BLK_CLASS_CACHE_SIZE)
+		ctx->cache[c][ctx->n_cached[c]++] = block;
+	else if (ctx->arena_depth > 0)
+		add_arena(ctx, c, block);
 	else
 		isl_blk_free_force(ctx, block);
 }
 
+/* Free all blocks in the arena, along with the arena itself.
+ */
+void isl_blk_clear_arena(struct isl_ctx *ctx)
+{
+	int c, i;
+
+	for (c = 0; c < ISL_BLK_N_CLASS; ++c) {
+		for (i = 0; i < ctx->n_arena[c]; ++i)
+			isl_blk_free_force(ctx, ctx->arena[c][i]);
+		free(ctx->arena[c]);
+		ctx->arena[c] = NULL;
+		ctx->n_arena[c] = 0;
+		ctx->size_arena[c] = 0;
+	}
+}
+
 void isl_blk_clear_cache(struct isl_ctx *ctx)
 {
-	int i;
+	int c, i;
 
-	for (i = 0; i < ctx->n_cached; ++i)
-		isl_blk_free_force(ctx, ctx->cache[i]);
-	ctx->n_cached = 0;
+	for (c = 0; c < ISL_BLK_N_CLASS; ++c) {
+		for (i = 0; i < ctx->n_cached[c]; ++i)
+			isl_blk_free_force(ctx, ctx->cache[c][i]);
+		ctx->n_cached[c] = 0;
+	}
+	isl_blk_clear_arena(ctx);
 }
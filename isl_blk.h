@@ -21,7 +21,11 @@ struct isl_blk {
 	isl_int *data;
 };
 
-#define ISL_BLK_CACHE_SIZE	20
+/* The number of size classes of cached blocks and
+ * the maximal number of cached blocks in each size class.
+ */
+#define ISL_BLK_N_CLASS		24
+#define ISL_BLK_CLASS_CACHE_SIZE	8
 
 struct isl_ctx;
 
@@ -32,6 +36,7 @@ struct isl_blk isl_blk_extend(struct isl_ctx *ctx, struct isl_blk block,
 				size_t new_n);
 void isl_blk_free(struct isl_ctx *ctx, struct isl_blk block);
 void isl_blk_clear_cache(struct isl_ctx *ctx);
+void isl_blk_clear_arena(struct isl_ctx *ctx);
 
 #if defined(__cplusplus)
 }
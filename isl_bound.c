@@ -15,6 +15,8 @@
 #include <isl_range.h>
 #include <isl_polynomial_private.h>
 #include <isl_options_private.h>
+#include <isl/options.h>
+#include "isl_task.h"
 
 /* Given a polynomial "poly" that is constant in terms
  * of the domain variables, construct a polynomial reduction
@@ -269,20 +271,151 @@ static isl_stat basic_guarded_fold(__isl_take isl_basic_set *bset, void *user)
 	return r;
 }
 
+/* The bounds computed over a single basic set.
+ */
+struct isl_bound_result {
+	isl_pw_qpolynomial_fold *pwf;
+	isl_pw_qpolynomial_fold *pwf_tight;
+};
+
+/* Compute a bound of type bound->type on bound->fold over "bset",
+ * starting from an empty bound, and store the results in "res".
+ * The computation is performed in "ctx", which may be different
+ * from the context of "bound" and "bset".  In this case,
+ * "bound" and "bset" are copied to "ctx" without being modified.
+ * On error, the fields of "res" are set to NULL.
+ */
+static isl_stat bound_basic_set(isl_ctx *ctx, struct isl_bound *bound,
+	__isl_keep isl_basic_set *bset, struct isl_bound_result *res)
+{
+	struct isl_bound local;
+	isl_stat r;
+
+	local.check_tight = bound->check_tight;
+	local.wrapping = bound->wrapping;
+	local.type = bound->type;
+	local.dim = isl_space_copy_to_ctx(bound->dim, ctx);
+	local.fold = isl_qpolynomial_fold_copy_to_ctx(bound->fold, ctx);
+	local.pwf = isl_pw_qpolynomial_fold_zero(isl_space_copy(local.dim),
+						local.type);
+	local.pwf_tight = isl_pw_qpolynomial_fold_zero(
+				isl_space_copy(local.dim), local.type);
+
+	r = basic_guarded_fold(isl_basic_set_copy_to_ctx(bset, ctx), &local);
+
+	isl_space_free(local.dim);
+	isl_qpolynomial_fold_free(local.fold);
+	if (r < 0 || !local.pwf || !local.pwf_tight) {
+		isl_pw_qpolynomial_fold_free(local.pwf);
+		isl_pw_qpolynomial_fold_free(local.pwf_tight);
+		res->pwf = NULL;
+		res->pwf_tight = NULL;
+		return isl_stat_error;
+	}
+	res->pwf = local.pwf;
+	res->pwf_tight = local.pwf_tight;
+	return isl_stat_ok;
+}
+
+/* Data used by bound_basic_sets.
+ * "res[k]" stores the bounds computed over basic set "k" of "set".
+ */
+struct isl_bound_tasks {
+	isl_set *set;
+	struct isl_bound *bound;
+	struct isl_bound_result *res;
+};
+
+/* Compute the bounds over basic set "k" in "ctx".
+ */
+static isl_stat bound_task_run(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_bound_tasks *data = user;
+
+	return bound_basic_set(ctx, data->bound, data->set->p[k],
+				&data->res[k]);
+}
+
+/* Copy the bounds computed over basic set "k" to "ctx"
+ * and add them to data->bound.
+ */
+static isl_stat bound_task_merge(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_bound_tasks *data = user;
+	struct isl_bound_result child = data->res[k];
+	isl_pw_qpolynomial_fold *pwf, *pwf_tight;
+	isl_stat r;
+
+	pwf = isl_pw_qpolynomial_fold_copy_to_ctx(child.pwf, ctx);
+	pwf_tight = isl_pw_qpolynomial_fold_copy_to_ctx(child.pwf_tight, ctx);
+	isl_pw_qpolynomial_fold_free(child.pwf);
+	isl_pw_qpolynomial_fold_free(child.pwf_tight);
+
+	r = isl_bound_add(data->bound, pwf);
+	if (r >= 0)
+		r = isl_bound_add_tight(data->bound, pwf_tight);
+	else
+		isl_pw_qpolynomial_fold_free(pwf_tight);
+
+	return r;
+}
+
+/* Update bound->pwf and bound->pwf_tight with bounds over
+ * the basic sets of "set", computed using up to "n_thread" threads.
+ * The bounds over the individual basic sets are computed independently
+ * of each other, each in a task of isl_ctx_run_tasks,
+ * and then added to "bound" in the order of the basic sets,
+ * such that the result does not depend on the number of threads.
+ */
+static isl_stat bound_basic_sets(__isl_keep isl_set *set,
+	struct isl_bound *bound, int n_thread)
+{
+	isl_ctx *ctx = isl_set_get_ctx(set);
+	struct isl_bound_tasks data = { set, bound };
+	isl_stat r;
+
+	data.res = isl_calloc_array(ctx, struct isl_bound_result, set->n);
+	if (set->n && !data.res)
+		return isl_stat_error;
+	r = isl_ctx_run_tasks(ctx, set->n, n_thread,
+			    &bound_task_run, &bound_task_merge, &data);
+	free(data.res);
+
+	return r;
+}
+
+/* Update bound->pwf and bound->pwf_tight with a bound
+ * on "fold" over "set".
+ *
+ * The set is first split into disjoint basic sets.
+ * If the bound_threads option (or the threads option if the former
+ * is not set) is set to a value greater than one and
+ * there is more than one basic set, then the bounds over the basic sets
+ * are computed in parallel.
+ */
 static isl_stat guarded_fold(__isl_take isl_set *set,
 	__isl_take isl_qpolynomial_fold *fold, void *user)
 {
 	struct isl_bound *bound = (struct isl_bound *)user;
+	int n_thread;
 
 	if (!set || !fold)
 		goto error;
 
 	set = isl_set_make_disjoint(set);
+	if (!set)
+		goto error;
 
 	bound->fold = fold;
 	bound->type = isl_qpolynomial_fold_get_type(fold);
 
-	if (isl_set_foreach_basic_set(set, &basic_guarded_fold, bound) < 0)
+	n_thread = isl_options_get_bound_threads(isl_set_get_ctx(set));
+	n_thread = isl_ctx_get_n_thread(isl_set_get_ctx(set), n_thread);
+	if (n_thread > 1 && set->n > 1) {
+		if (bound_basic_sets(set, bound, n_thread) < 0)
+			goto error;
+	} else if (isl_set_foreach_basic_set(set, &basic_guarded_fold,
+					    bound) < 0)
 		goto error;
 
 	isl_set_free(set);
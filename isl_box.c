@@ -12,11 +12,15 @@
 
 #include <isl/val.h>
 #include <isl/space.h>
+#include <isl/union_map.h>
 #include <isl_map_private.h>
 #include <isl_aff_private.h>
+#include <isl_val_private.h>
 #include <isl/constraint.h>
 #include <isl/ilp.h>
 #include <isl/fixed_box.h>
+#include <isl/options.h>
+#include "isl_task.h"
 
 /* Representation of a box of fixed size containing the elements
  * [offset, offset + size).
@@ -30,6 +34,11 @@ struct isl_fixed_box {
 	isl_multi_val *size;
 };
 
+#undef EL
+#define EL isl_fixed_box
+
+#include <isl_list_templ.h>
+
 /* Free "box" and return NULL.
  */
 __isl_null isl_fixed_box *isl_fixed_box_free(__isl_take isl_fixed_box *box)
@@ -93,6 +102,38 @@ __isl_give isl_fixed_box *isl_fixed_box_copy(__isl_keep isl_fixed_box *box)
 	return isl_fixed_box_alloc(offset, size);
 }
 
+/* Return a copy of "box" in "ctx".
+ *
+ * The size is copied element by element since the elements
+ * may be infinite in case of an invalid box.
+ */
+static __isl_give isl_fixed_box *isl_fixed_box_copy_to_ctx(
+	__isl_keep isl_fixed_box *box, isl_ctx *ctx)
+{
+	int i;
+	isl_size n;
+	isl_space *space;
+	isl_multi_aff *offset;
+	isl_multi_val *size;
+
+	if (!box)
+		return NULL;
+	n = isl_multi_val_size(box->size);
+	if (n < 0)
+		return NULL;
+	offset = isl_multi_aff_copy_to_ctx(box->offset, ctx);
+	space = isl_multi_val_peek_space(box->size);
+	size = isl_multi_val_zero(isl_space_copy_to_ctx(space, ctx));
+	for (i = 0; i < n; ++i) {
+		isl_val *v;
+
+		v = box->size->u.p[i];
+		v = isl_val_rat_from_isl_int(ctx, v->n, v->d);
+		size = isl_multi_val_set_at(size, i, v);
+	}
+	return isl_fixed_box_alloc(offset, size);
+}
+
 /* Replace the offset and size in direction "pos" by "offset" and "size"
  * (without checking whether "box" is a valid box).
  */
@@ -442,6 +483,114 @@ __isl_give isl_fixed_box *isl_set_get_simple_fixed_box_hull(
 	return fixed_box_as_map(set, &isl_map_get_range_simple_fixed_box_hull);
 }
 
+/* Data used for computing fixed boxes for several maps at once.
+ *
+ * "map" contains the "n" maps for which a box should be computed.
+ * "box" collects the corresponding boxes.
+ */
+struct isl_fixed_box_par {
+	int n;
+	isl_map **map;
+	isl_fixed_box **box;
+};
+
+/* Compute a fixed box for map "k" of "par" in "ctx".
+ * The map is first copied to "ctx" in case "ctx" is different
+ * from the context in which the map lives.
+ */
+static __isl_give isl_fixed_box *par_fixed_box(struct isl_fixed_box_par *par,
+	int k, isl_ctx *ctx)
+{
+	isl_map *map;
+	isl_fixed_box *box;
+
+	map = isl_map_copy_to_ctx(par->map[k], ctx);
+	box = isl_map_get_range_simple_fixed_box_hull(map);
+	isl_map_free(map);
+
+	return box;
+}
+
+/* Compute the box of map "k" of the isl_fixed_box_par passed as "user"
+ * in "ctx".
+ */
+static isl_stat fixed_box_task_run(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_fixed_box_par *par = user;
+
+	par->box[k] = par_fixed_box(par, k, ctx);
+	return par->box[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* Copy the box computed by task "k" of the isl_fixed_box_par
+ * passed as "user" to "ctx".
+ */
+static isl_stat fixed_box_task_merge(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_fixed_box_par *par = user;
+	isl_fixed_box *child = par->box[k];
+
+	par->box[k] = isl_fixed_box_copy_to_ctx(child, ctx);
+	isl_fixed_box_free(child);
+	return par->box[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* Try and construct a fixed-size rectangular box for the range
+ * of each of the maps in "umap", as in
+ * isl_map_get_range_simple_fixed_box_hull, and
+ * return the results in a list, in the same order as
+ * the maps in the result of isl_union_map_get_map_list.
+ *
+ * The maps of a union map share the same parameters,
+ * so no parameter alignment is needed and
+ * the maps can be handled independently.
+ * Each box is computed in a task of isl_ctx_run_tasks,
+ * using up to as many threads as specified
+ * by the union_map_threads option.
+ * If any box could not be computed, then all boxes are freed and
+ * isl_fixed_box_list_from_array returns NULL.
+ */
+__isl_give isl_fixed_box_list *
+isl_union_map_get_range_simple_fixed_box_hull_list(
+	__isl_keep isl_union_map *umap)
+{
+	int k;
+	int n_thread;
+	isl_ctx *ctx;
+	isl_size n;
+	isl_map_list *list;
+	struct isl_fixed_box_par par = { 0 };
+	isl_fixed_box_list *res = NULL;
+
+	list = isl_union_map_get_map_list(umap);
+	n = isl_map_list_size(list);
+	if (n < 0)
+		goto done;
+	ctx = isl_map_list_get_ctx(list);
+	par.n = n;
+	par.map = isl_calloc_array(ctx, isl_map *, n);
+	par.box = isl_calloc_array(ctx, isl_fixed_box *, n);
+	if (n && (!par.map || !par.box))
+		goto done;
+	for (k = 0; k < n; ++k)
+		par.map[k] = isl_map_list_get_at(list, k);
+
+	n_thread = isl_options_get_union_map_threads(ctx);
+	if (isl_ctx_run_tasks(ctx, n, n_thread, &fixed_box_task_run,
+				&fixed_box_task_merge, &par) < 0)
+		for (k = 0; k < n; ++k)
+			par.box[k] = isl_fixed_box_free(par.box[k]);
+	res = isl_fixed_box_list_from_array(ctx, n, par.box);
+done:
+	if (par.map)
+		for (k = 0; k < par.n; ++k)
+			isl_map_free(par.map[k]);
+	free(par.box);
+	free(par.map);
+	isl_map_list_free(list);
+	return res;
+}
+
 /* Check whether the output elements lie on a rectangular lattice,
  * possibly depending on the parameters and the input dimensions.
  * Return a tile in this lattice.
@@ -526,3 +675,8 @@ __isl_give isl_printer *isl_printer_print_fixed_box(
 #undef BASE
 #define BASE fixed_box
 #include <print_templ_yaml.c>
+
+#undef EL_BASE
+#define EL_BASE fixed_box
+
+#include <isl_list_templ.c>
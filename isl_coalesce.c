@@ -21,6 +21,7 @@
  */
 
 #include <isl_ctx_private.h>
+#include <isl_options_private.h>
 #include "isl_map_private.h"
 #include <isl_seq.h>
 #include <isl/options.h>
@@ -32,6 +33,9 @@
 #include <isl_aff_private.h>
 #include <isl_equalities.h>
 #include <isl_constraint_private.h>
+#include <isl_binary_private.h>
+#include <isl_config.h>
+#include "isl_task.h"
 
 #include <set_to_map.c>
 #include <set_from_map.c>
@@ -193,6 +197,16 @@ static int all(int *con, unsigned len, int status)
  * the other basic map.  The number of elements in the "eq" array
  * is twice the number of equalities in the "bmap", corresponding
  * to the two inequalities that make up each equality.
+ *
+ * "bound" and "bound_con" are only set if "bmap" has no integer divisions.
+ * They contain the constant lower and upper bounds on the variables
+ * that appear directly in the constraints of "bmap".
+ * The lower bound on variable k is stored at position 2 * k of
+ * "bound" and the upper bound at position 2 * k + 1.
+ * The corresponding element of "bound_con" is the position
+ * of the inequality constraint from which the bound was obtained,
+ * BOUND_EQ if it was obtained from an equality constraint or
+ * BOUND_NONE if there is no such bound.
  */
 struct isl_coalesce_info {
 	isl_basic_map *bmap;
@@ -203,8 +217,13 @@ struct isl_coalesce_info {
 	int simplify;
 	int *eq;
 	int *ineq;
+	isl_vec *bound;
+	int *bound_con;
 };
 
+#define BOUND_NONE	-2
+#define BOUND_EQ	-1
+
 /* Is there any (half of an) equality constraint in the description
  * of the basic map represented by "info" that
  * has position "status" with respect to the other basic map?
@@ -346,11 +365,22 @@ static void clear_coalesce_info(int n, struct isl_coalesce_info *info)
 	for (i = 0; i < n; ++i) {
 		isl_basic_map_free(info[i].bmap);
 		isl_tab_free(info[i].tab);
+		isl_vec_free(info[i].bound);
+		free(info[i].bound_con);
 	}
 
 	free(info);
 }
 
+/* Clear the bounds stored in "info".
+ */
+static void clear_bounds(struct isl_coalesce_info *info)
+{
+	info->bound = isl_vec_free(info->bound);
+	free(info->bound_con);
+	info->bound_con = NULL;
+}
+
 /* Clear the memory associated to "info".
  */
 static void clear(struct isl_coalesce_info *info)
@@ -358,6 +388,189 @@ static void clear(struct isl_coalesce_info *info)
 	info->bmap = isl_basic_map_free(info->bmap);
 	isl_tab_free(info->tab);
 	info->tab = NULL;
+	clear_bounds(info);
+}
+
+/* Update the bound on variable "pos" at position "k" of info->bound
+ * (with k = 2 * pos for a lower bound and k = 2 * pos + 1
+ * for an upper bound) to "v", obtained from constraint "con",
+ * if it is tighter than the current bound.
+ */
+static void update_bound(struct isl_coalesce_info *info, int k, isl_int v,
+	int con)
+{
+	int upper = k % 2;
+
+	if (info->bound_con[k] != BOUND_NONE) {
+		if (!upper && isl_int_le(v, info->bound->el[k]))
+			return;
+		if (upper && isl_int_ge(v, info->bound->el[k]))
+			return;
+	}
+	isl_int_set(info->bound->el[k], v);
+	info->bound_con[k] = con;
+}
+
+/* If "c" is a constraint of info->bmap that involves
+ * a single variable with a unit coefficient, then return
+ * the position of this variable.  Otherwise, return -1.
+ */
+static int single_unit_var(isl_int *c, unsigned total)
+{
+	int pos;
+
+	pos = isl_seq_first_non_zero(c + 1, total);
+	if (pos < 0 || (!isl_int_is_one(c[1 + pos]) &&
+			!isl_int_is_negone(c[1 + pos])))
+		return -1;
+	if (isl_seq_first_non_zero(c + 1 + pos + 1, total - pos - 1) >= 0)
+		return -1;
+	return pos;
+}
+
+/* Collect the constant bounds on the variables of info->bmap
+ * that appear directly in its constraints,
+ * provided info->bmap has no integer divisions.
+ * Only constraints with a unit coefficient are considered.
+ * Since the constraints have been normalized,
+ * other constraints on a single variable are fairly rare.
+ */
+static isl_stat coalesce_info_set_bounds(struct isl_coalesce_info *info)
+{
+	int i, pos;
+	isl_size total;
+	isl_int v;
+
+	clear_bounds(info);
+	if (info->bmap->n_div != 0)
+		return isl_stat_ok;
+	total = isl_basic_map_dim(info->bmap, isl_dim_all);
+	if (total < 0)
+		return isl_stat_error;
+
+	info->bound = isl_vec_alloc(info->bmap->ctx, 2 * total);
+	info->bound_con = isl_alloc_array(info->bmap->ctx, int, 2 * total);
+	if (!info->bound || (total && !info->bound_con))
+		return isl_stat_error;
+	for (i = 0; i < 2 * total; ++i)
+		info->bound_con[i] = BOUND_NONE;
+
+	isl_int_init(v);
+	for (i = 0; i < info->bmap->n_eq; ++i) {
+		isl_int *eq = info->bmap->eq[i];
+
+		pos = single_unit_var(eq, total);
+		if (pos < 0)
+			continue;
+		if (isl_int_is_one(eq[1 + pos]))
+			isl_int_neg(v, eq[0]);
+		else
+			isl_int_set(v, eq[0]);
+		update_bound(info, 2 * pos, v, BOUND_EQ);
+		update_bound(info, 2 * pos + 1, v, BOUND_EQ);
+	}
+	for (i = 0; i < info->bmap->n_ineq; ++i) {
+		isl_int *ineq = info->bmap->ineq[i];
+
+		pos = single_unit_var(ineq, total);
+		if (pos < 0)
+			continue;
+		if (isl_int_is_one(ineq[1 + pos])) {
+			isl_int_neg(v, ineq[0]);
+			update_bound(info, 2 * pos, v, i);
+		} else {
+			update_bound(info, 2 * pos + 1, ineq[0], i);
+		}
+	}
+	isl_int_clear(v);
+
+	return isl_stat_ok;
+}
+
+/* Is the upper (if "upper" is set) or lower bound on variable "pos"
+ * of the basic map represented by "info_i" obtained from
+ * an inequality constraint that is violated by at least two
+ * by all elements of the basic map represented by "info_j"?
+ *
+ * If so, coalesce_local_pair finds that this constraint separates
+ * the two basic maps, provided the constraint has not been found
+ * to be redundant.
+ * If the tableau has not been constructed yet, then the basic map
+ * is known not to have any redundant constraints.
+ * This is the case if the lower bound on the variable
+ * in the basic map represented by "info_j" is at least two more
+ * than the upper bound in "info_i" or the other way around.
+ */
+static isl_bool bound_separates(struct isl_coalesce_info *info_i,
+	struct isl_coalesce_info *info_j, int pos, int upper)
+{
+	int k_i = 2 * pos + upper;
+	int k_j = 2 * pos + 1 - upper;
+	int con;
+	int red;
+	isl_int d;
+	isl_bool separate;
+
+	con = info_i->bound_con[k_i];
+	if (con < 0 || info_j->bound_con[k_j] == BOUND_NONE)
+		return isl_bool_false;
+	if (!info_i->tab)
+		red = 0;
+	else
+		red = isl_tab_is_redundant(info_i->tab,
+					    info_i->bmap->n_eq + con);
+	if (red < 0)
+		return isl_bool_error;
+	if (red)
+		return isl_bool_false;
+
+	isl_int_init(d);
+	if (upper)
+		isl_int_sub(d, info_j->bound->el[k_j], info_i->bound->el[k_i]);
+	else
+		isl_int_sub(d, info_i->bound->el[k_i], info_j->bound->el[k_j]);
+	separate = isl_int_cmp_si(d, 2) >= 0;
+	isl_int_clear(d);
+
+	return separate;
+}
+
+/* Is it clear from the bounds on the variables of the basic maps
+ * represented by "info_i" and "info_j" that coalesce_pair
+ * would not be able to coalesce them?
+ * That is, are they both without integer divisions and
+ * is there an inequality constraint in the bounds of one of them that
+ * would be found to separate the two basic maps?
+ * In this case, coalesce_pair only performs a call
+ * to coalesce_local_pair, which returns isl_change_none as soon
+ * as it finds such a separating constraint.
+ */
+static isl_bool bounds_separate(struct isl_coalesce_info *info_i,
+	struct isl_coalesce_info *info_j)
+{
+	int pos, upper;
+	isl_size total;
+
+	if (!info_i->bound || !info_j->bound)
+		return isl_bool_false;
+	if (info_i->bmap->n_div != 0 || info_j->bmap->n_div != 0)
+		return isl_bool_false;
+
+	total = info_i->bound->size / 2;
+	for (pos = 0; pos < total; ++pos) {
+		for (upper = 0; upper <= 1; ++upper) {
+			isl_bool separate;
+
+			separate = bound_separates(info_i, info_j, pos, upper);
+			if (separate < 0 || separate)
+				return separate;
+			separate = bound_separates(info_j, info_i, pos, upper);
+			if (separate < 0 || separate)
+				return separate;
+		}
+	}
+
+	return isl_bool_false;
 }
 
 /* Drop the basic map represented by "info".
@@ -2632,9 +2845,16 @@ error:
 static enum isl_change coalesce_local_pair(int i, int j,
 	struct isl_coalesce_info *info)
 {
+	isl_ctx *ctx = isl_basic_map_get_ctx(info[i].bmap);
+	clock_t start;
+	enum isl_change change;
+
+	start = isl_ctx_stats_enter(ctx, &ctx->stats->coalesce_pair_tests);
 	init_status(&info[i]);
 	init_status(&info[j]);
-	return coalesce_local_pair_reuse(i, j, info);
+	change = coalesce_local_pair_reuse(i, j, info);
+	isl_ctx_stats_leave(&ctx->stats->coalesce_pair_time, start);
+	return change;
 }
 
 /* Shift the integer division at position "div" of the basic map
@@ -4030,6 +4250,32 @@ static enum isl_change coalesce_pair(int i, int j,
 	return check_coalesce_eq(i, j, info);
 }
 
+/* Construct the tableau of the basic map represented by "info"
+ * if this was postponed by coalesce_info_init_lazy.
+ * If the basic map turns out to be empty, then drop it.
+ */
+static isl_stat coalesce_info_ensure_tab(struct isl_coalesce_info *info)
+{
+	if (info->removed || info->tab)
+		return isl_stat_ok;
+	info->tab = isl_tab_from_basic_map(info->bmap, 0);
+	if (!info->tab)
+		return isl_stat_error;
+	if (info->tab->empty)
+		drop(info);
+	return isl_stat_ok;
+}
+
+/* Recompute the bounds of the basic map represented by "info"
+ * after it may have been modified, unless it has been removed.
+ */
+static isl_stat update_bounds(struct isl_coalesce_info *info)
+{
+	if (info->removed)
+		return isl_stat_ok;
+	return coalesce_info_set_bounds(info);
+}
+
 /* Return the maximum of "a" and "b".
  */
 static int isl_max(int a, int b)
@@ -4037,6 +4283,168 @@ static int isl_max(int a, int b)
 	return a > b ? a : b;
 }
 
+#ifdef HAVE_PTHREAD
+
+#define MIN_PAIRS_PER_THREAD	8
+
+/* Data used by speculate.
+ * "info" is the complete array of basic maps, which is only read
+ * while the tasks are running.
+ * Task "k" compares basic map "i" to basic map "j[k]" and
+ * stores the result in "none[j[k]]".
+ */
+struct isl_coalesce_tasks {
+	struct isl_coalesce_info *info;
+	int i;
+	int *j;
+	int *none;
+};
+
+/* Copy the basic map represented by "info" and its tableau to "ctx".
+ * The status arrays are not copied since they are only used
+ * within coalesce_pair and neither are the bounds since they
+ * are only used by coalesce_range.
+ */
+static isl_stat copy_info_to_ctx(struct isl_coalesce_info *dst,
+	struct isl_coalesce_info *src, isl_ctx *ctx)
+{
+	*dst = *src;
+	dst->eq = NULL;
+	dst->ineq = NULL;
+	dst->bound = NULL;
+	dst->bound_con = NULL;
+	dst->bmap = isl_basic_map_copy_to_ctx(src->bmap, ctx);
+	dst->tab = isl_tab_copy_to_ctx(src->tab, ctx);
+	if (!dst->bmap || !dst->tab)
+		return isl_stat_error;
+	return isl_stat_ok;
+}
+
+/* Check if basic map "j[k]" can be coalesced with basic map "i",
+ * working on fresh copies in "ctx" such that the outcome
+ * does not depend on the other pairs handled in the same context.
+ * A pair is only marked as not combinable if this is
+ * what coalesce_pair determines.  If anything goes wrong,
+ * then the pair is left for the main computation to handle.
+ * The task is therefore always considered to have been executed
+ * successfully.
+ */
+static isl_stat coalesce_task_run(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_coalesce_tasks *data = user;
+	struct isl_coalesce_info pair[2] = { { NULL } };
+	int j = data->j[k];
+	enum isl_change change = isl_change_error;
+
+	if (copy_info_to_ctx(&pair[0], &data->info[data->i], ctx) >= 0 &&
+	    copy_info_to_ctx(&pair[1], &data->info[j], ctx) >= 0)
+		change = coalesce_pair(0, 1, pair);
+	data->none[j] = change == isl_change_none;
+	clear(&pair[0]);
+	clear(&pair[1]);
+
+	return isl_stat_ok;
+}
+
+/* The result of task "k" has already been stored in "none"
+ * by coalesce_task_run, so there is nothing left to combine.
+ */
+static isl_stat coalesce_task_merge(isl_ctx *ctx, int k, void *user)
+{
+	return isl_stat_ok;
+}
+
+/* Speculatively check which of the basic maps in the range [start, end[
+ * of "info" cannot be coalesced with basic map "i", using
+ * up to "n_thread" threads, and mark those in "none".
+ * Only basic maps without integer divisions are considered since
+ * coalesce_pair may modify the integer divisions of the pair
+ * even if they cannot be coalesced.
+ *
+ * Each thread is assigned at least MIN_PAIRS_PER_THREAD pairs
+ * since starting a thread and copying the basic maps is only
+ * worthwhile if there is enough work to be performed.
+ *
+ * Each pair is examined in a separate task of isl_ctx_run_tasks.
+ * The tableaus of the basic maps that are examined are constructed
+ * beforehand, if needed, since the elements of "info"
+ * are only read while the tasks are running.
+ */
+static isl_stat speculate(isl_ctx *ctx, struct isl_coalesce_info *info,
+	int i, int start, int end, int *none, int n_thread)
+{
+	int k, n;
+	int *j;
+	struct isl_coalesce_tasks data;
+	isl_stat r;
+
+	for (k = start; k < end; ++k)
+		none[k] = 0;
+	if (info[i].bmap->n_div != 0)
+		return isl_stat_ok;
+
+	j = isl_alloc_array(ctx, int, end - start);
+	if (end > start && !j)
+		return isl_stat_error;
+	n = 0;
+	for (k = start; k < end; ++k) {
+		isl_bool separate;
+
+		if (info[k].removed || info[k].bmap->n_div != 0)
+			continue;
+		separate = bounds_separate(&info[i], &info[k]);
+		if (separate < 0) {
+			free(j);
+			return isl_stat_error;
+		}
+		if (separate) {
+			none[k] = 1;
+			continue;
+		}
+		if (coalesce_info_ensure_tab(&info[k]) < 0) {
+			free(j);
+			return isl_stat_error;
+		}
+		if (!info[k].removed)
+			j[n++] = k;
+	}
+	if (n_thread > n / MIN_PAIRS_PER_THREAD)
+		n_thread = n / MIN_PAIRS_PER_THREAD;
+	if (n_thread < 2) {
+		free(j);
+		return isl_stat_ok;
+	}
+
+	data.info = info;
+	data.i = i;
+	data.j = j;
+	data.none = none;
+	r = isl_ctx_run_tasks(ctx, n, n_thread, &coalesce_task_run,
+				&coalesce_task_merge, &data);
+
+	free(j);
+	return r;
+}
+
+#else
+
+/* Without support for threads, isl_ctx_run_tasks would simply
+ * perform the speculative checks one after the other,
+ * duplicating the work of the main computation.
+ * Do not mark any basic map instead.
+ */
+static isl_stat speculate(isl_ctx *ctx, struct isl_coalesce_info *info,
+	int i, int start, int end, int *none, int n_thread)
+{
+	int k;
+
+	for (k = start; k < end; ++k)
+		none[k] = 0;
+	return isl_stat_ok;
+}
+
+#endif
+
 /* Pairwise coalesce the basic maps in the range [start1, end1[ of "info"
  * with those in the range [start2, end2[, skipping basic maps
  * that have been removed (either before or within this function).
@@ -4050,17 +4458,44 @@ static int isl_max(int a, int b)
  * If the two basic maps got fused, then we recheck the fused basic map
  * against the previously considered basic maps, starting at i + 1
  * (even if start2 is greater than i + 1).
+ *
+ * Pairs that can be seen not to be combinable from the bounds
+ * on the variables are skipped without further checks.
+ * After a change, the bounds of the pair are recomputed.
+ *
+ * If "none" is not NULL, then the remaining basic maps j are first
+ * examined speculatively using "n_thread" threads and those that
+ * are found not to be combinable with basic map i are skipped.
+ * The speculative checks are performed on copies of the current
+ * basic maps i and j, so they produce the same outcome as
+ * the corresponding call to coalesce_pair in the serial computation,
+ * as long as neither of them has changed in the meantime.
+ * A call to coalesce_pair that finds that a pair cannot be combined
+ * only changes the order of the pivots in the tableaus of the pair,
+ * which does not affect the outcome of any later call,
+ * so skipping such a call does not affect the final result.
+ * Basic map i is also left untouched if basic map j gets dropped,
+ * while the other basic maps only change when they are combined
+ * with basic map i.  The speculative results therefore
+ * only need to be recomputed after basic map i has changed,
+ * i.e., after a fusion, in which case the remaining basic maps j
+ * get rechecked against the fused basic map anyway.
+ * This ensures that each pair is examined at most once speculatively
+ * for each version of basic map i.
  */
 static int coalesce_range(isl_ctx *ctx, struct isl_coalesce_info *info,
-	int start1, int end1, int start2, int end2)
+	int start1, int end1, int start2, int end2, int *none, int n_thread)
 {
 	int i, j;
 
 	for (i = end1 - 1; i >= start1; --i) {
+		int speculated = 0;
+
 		if (info[i].removed)
 			continue;
 		for (j = isl_max(i + 1, start2); j < end2; ++j) {
 			enum isl_change changed;
+			isl_bool separate;
 
 			if (info[j].removed)
 				continue;
@@ -4068,7 +4503,31 @@ static int coalesce_range(isl_ctx *ctx, struct isl_coalesce_info *info,
 				isl_die(ctx, isl_error_internal,
 					"basic map unexpectedly removed",
 					return -1);
+			separate = bounds_separate(&info[i], &info[j]);
+			if (separate < 0)
+				return -1;
+			if (separate)
+				continue;
+			if (none && !speculated) {
+				if (speculate(ctx, info, i, j, end2, none,
+						n_thread) < 0)
+					return -1;
+				speculated = 1;
+			}
+			if (speculated && none[j])
+				continue;
+			if (coalesce_info_ensure_tab(&info[j]) < 0)
+				return -1;
+			if (info[j].removed)
+				continue;
 			changed = coalesce_pair(i, j, info);
+			if (changed == isl_change_fuse)
+				speculated = 0;
+			if (changed != isl_change_none) {
+				if (update_bounds(&info[i]) < 0 ||
+				    update_bounds(&info[j]) < 0)
+					return -1;
+			}
 			switch (changed) {
 			case isl_change_error:
 				return -1;
@@ -4095,23 +4554,57 @@ static int coalesce_range(isl_ctx *ctx, struct isl_coalesce_info *info,
  * coalesce the elements in the group with elements of previously
  * considered groups.  If a fuse happens during the second phase,
  * then we also reconsider the elements within the group.
+ *
+ * If only the first "n_new" basic maps may be combined with any
+ * of the other basic maps (because the others have already been
+ * coalesced with each other), then first coalesce the new basic maps
+ * with each other and then with the old basic maps.
+ *
+ * If the coalesce_threads option is set to a value greater than one,
+ * then allocate an array for keeping track of the speculative results
+ * of coalesce_range.
  */
-static int coalesce(isl_ctx *ctx, int n, struct isl_coalesce_info *info)
+static int coalesce(isl_ctx *ctx, int n, struct isl_coalesce_info *info,
+	int n_new)
 {
 	int start, end;
+	int n_thread;
+	int *none = NULL;
+	int r = 0;
+
+	n_thread = isl_options_get_coalesce_threads(ctx);
+	if (n_thread > 1) {
+		none = isl_calloc_array(ctx, int, n);
+		if (!none)
+			return -1;
+	}
+
+	if (n_new < n) {
+		if (coalesce_range(ctx, info, 0, n_new, 0, n_new,
+				    none, n_thread) < 0 ||
+		    coalesce_range(ctx, info, 0, n_new, n_new, n,
+				    none, n_thread) < 0)
+			r = -1;
+		free(none);
+		return r;
+	}
 
 	for (end = n; end > 0; end = start) {
 		start = end - 1;
 		while (start >= 1 &&
 		    info[start - 1].hull_hash == info[start].hull_hash)
 			start--;
-		if (coalesce_range(ctx, info, start, end, start, end) < 0)
-			return -1;
-		if (coalesce_range(ctx, info, start, end, end, n) < 0)
-			return -1;
+		if (coalesce_range(ctx, info, start, end, start, end,
+				    none, n_thread) < 0 ||
+		    coalesce_range(ctx, info, start, end, end, n,
+				    none, n_thread) < 0) {
+			r = -1;
+			break;
+		}
 	}
 
-	return 0;
+	free(none);
+	return r;
 }
 
 /* Update the basic maps in "map" based on the information in "info".
@@ -4121,6 +4614,7 @@ static int coalesce(isl_ctx *ctx, int n, struct isl_coalesce_info *info)
  * isl_basic_map_gauss, we need to do it now.
  * Also call isl_basic_map_simplify if we may have lost the definition
  * of one or more integer divisions.
+ * Basic maps for which no tableau was constructed have not been modified.
  * If a basic map is still equal to the one from which the corresponding "info"
  * entry was created, then redundant constraint and
  * implicit equality constraint detection have been performed
@@ -4142,6 +4636,10 @@ static __isl_give isl_map *update_basic_maps(__isl_take isl_map *map,
 			map->n--;
 			continue;
 		}
+		if (!info[i].tab) {
+			info[i].bmap = isl_basic_map_free(info[i].bmap);
+			continue;
+		}
 
 		info[i].bmap = isl_basic_map_update_from_tab(info[i].bmap,
 							info[i].tab);
@@ -4163,39 +4661,85 @@ static __isl_give isl_map *update_basic_maps(__isl_take isl_map *map,
 	return map;
 }
 
-/* For each pair of basic maps in the map, check if the union of the two
- * can be represented by a single basic map.
- * If so, replace the pair by the single basic map and start over.
- *
- * We factor out any (hidden) common factor from the constraint
- * coefficients to improve the detection of adjacent constraints.
- * Note that this function does not call isl_basic_map_gauss,
- * but it does make sure that only a single copy of the basic map
- * is affected.  This means that isl_basic_map_gauss may have
- * to be called at the end of the computation (in update_basic_maps)
- * on this single copy to ensure that
- * the basic maps are not left in an unexpected state.
- *
- * Since we are constructing the tableaus of the basic maps anyway,
- * we exploit them to detect implicit equalities and redundant constraints.
- * This also helps the coalescing as it can ignore the redundant constraints.
- * In order to avoid confusion, we make all implicit equalities explicit
- * in the basic maps.  If the basic map only has a single reference
- * (this happens in particular if it was modified by
- * isl_basic_map_reduce_coefficients), then isl_basic_map_gauss
- * does not get called on the result.  The call to
- * isl_basic_map_gauss in update_basic_maps resolves this as well.
- * For each basic map, we also compute the hash of the apparent affine hull
- * for use in coalesce.
+/* Initialize "info" for coalescing basic map "bmap" of "map",
+ * with "bmap" stored at position "i" in "map".
  */
-__isl_give isl_map *isl_map_coalesce(__isl_take isl_map *map)
+static isl_stat coalesce_info_init(struct isl_coalesce_info *info,
+	__isl_keep isl_map *map, int i)
+{
+	map->p[i] = isl_basic_map_reduce_coefficients(map->p[i]);
+	if (!map->p[i])
+		return isl_stat_error;
+	info->bmap = isl_basic_map_copy(map->p[i]);
+	info->tab = isl_tab_from_basic_map(info->bmap, 0);
+	if (!info->tab)
+		return isl_stat_error;
+	if (!ISL_F_ISSET(info->bmap, ISL_BASIC_MAP_NO_IMPLICIT))
+		if (isl_tab_detect_implicit_equalities(info->tab) < 0)
+			return isl_stat_error;
+	info->bmap = isl_tab_make_equalities_explicit(info->tab, info->bmap);
+	if (!info->bmap)
+		return isl_stat_error;
+	if (!ISL_F_ISSET(info->bmap, ISL_BASIC_MAP_NO_REDUNDANT))
+		if (isl_tab_detect_redundant(info->tab) < 0)
+			return isl_stat_error;
+	if (coalesce_info_set_hull_hash(info) < 0)
+		return isl_stat_error;
+	if (coalesce_info_set_bounds(info) < 0)
+		return isl_stat_error;
+	return isl_stat_ok;
+}
+
+/* Is the basic map at position "i" of "map" one for which
+ * the tableau can be constructed lazily?
+ * That is, is it known to be free of implicit equalities and
+ * redundant constraints such that constructing the tableau
+ * would not result in any changes and such that
+ * coalesce_info_set_bounds can be called before the tableau is available?
+ */
+static int allow_lazy_tab(__isl_keep isl_map *map, int i)
+{
+	return ISL_F_ISSET(map->p[i], ISL_BASIC_MAP_NO_IMPLICIT) &&
+	    ISL_F_ISSET(map->p[i], ISL_BASIC_MAP_NO_REDUNDANT);
+}
+
+/* Initialize "info" for coalescing basic map "bmap" of "map",
+ * with "bmap" stored at position "i" in "map",
+ * without constructing the tableau if possible.
+ */
+static isl_stat coalesce_info_init_lazy(struct isl_coalesce_info *info,
+	__isl_keep isl_map *map, int i)
+{
+	if (!allow_lazy_tab(map, i))
+		return coalesce_info_init(info, map, i);
+
+	info->bmap = isl_basic_map_copy(map->p[i]);
+	if (coalesce_info_set_hull_hash(info) < 0)
+		return isl_stat_error;
+	if (coalesce_info_set_bounds(info) < 0)
+		return isl_stat_error;
+	return isl_stat_ok;
+}
+
+/* Coalesce the basic maps in "map", assuming that the last
+ * map->n - n_new of them have already been coalesced with each other.
+ * If "n_new" is equal to the number of basic maps in "map",
+ * then this is the same as isl_map_coalesce.
+ *
+ * The tableaus of the basic maps that have already been coalesced
+ * are only constructed when they are first needed,
+ * if this can be done without changing the basic maps.
+ * Those that are never compared to any other basic map
+ * (because they can be seen to be separated from the new basic maps
+ * by their bounds) are left untouched.
+ */
+static __isl_give isl_map *map_coalesce(__isl_take isl_map *map, int n_new)
 {
 	int i;
 	unsigned n;
 	isl_ctx *ctx;
 	struct isl_coalesce_info *info = NULL;
 
-	map = isl_map_remove_empty_parts(map);
 	if (!map)
 		return NULL;
 
@@ -4216,31 +4760,20 @@ __isl_give isl_map *isl_map_coalesce(__isl_take isl_map *map)
 		goto error;
 
 	for (i = 0; i < map->n; ++i) {
-		map->p[i] = isl_basic_map_reduce_coefficients(map->p[i]);
-		if (!map->p[i])
-			goto error;
-		info[i].bmap = isl_basic_map_copy(map->p[i]);
-		info[i].tab = isl_tab_from_basic_map(info[i].bmap, 0);
-		if (!info[i].tab)
-			goto error;
-		if (!ISL_F_ISSET(info[i].bmap, ISL_BASIC_MAP_NO_IMPLICIT))
-			if (isl_tab_detect_implicit_equalities(info[i].tab) < 0)
-				goto error;
-		info[i].bmap = isl_tab_make_equalities_explicit(info[i].tab,
-								info[i].bmap);
-		if (!info[i].bmap)
-			goto error;
-		if (!ISL_F_ISSET(info[i].bmap, ISL_BASIC_MAP_NO_REDUNDANT))
-			if (isl_tab_detect_redundant(info[i].tab) < 0)
-				goto error;
-		if (coalesce_info_set_hull_hash(&info[i]) < 0)
+		isl_stat r;
+
+		if (i < n_new)
+			r = coalesce_info_init(&info[i], map, i);
+		else
+			r = coalesce_info_init_lazy(&info[i], map, i);
+		if (r < 0)
 			goto error;
 	}
 	for (i = map->n - 1; i >= 0; --i)
-		if (info[i].tab->empty)
+		if (info[i].tab && info[i].tab->empty)
 			drop(&info[i]);
 
-	if (coalesce(ctx, n, info) < 0)
+	if (coalesce(ctx, n, info, n_new) < 0)
 		goto error;
 
 	map = update_basic_maps(map, n, info);
@@ -4254,6 +4787,127 @@ error:
 	return NULL;
 }
 
+/* Coalesce "map" as in isl_map_coalesce and record the cost
+ * of the computation, along with the input in binary format,
+ * in the isl_ctx such that the most expensive inputs
+ * can be extracted and replayed later.
+ * The input is printed before the computation since
+ * the basic maps of "map" may get modified in place.
+ */
+static __isl_give isl_map *map_coalesce_recorded(__isl_take isl_map *map)
+{
+	isl_ctx *ctx;
+	isl_printer *p;
+	char *input;
+	unsigned long operations;
+	clock_t start;
+	double time;
+
+	ctx = isl_map_get_ctx(map);
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_print_map_binary(p, map);
+	input = isl_printer_get_str(p);
+	isl_printer_free(p);
+	if (!input)
+		return isl_map_free(map);
+
+	operations = ctx->operations;
+	start = clock();
+	isl_ctx_scope_enter(ctx, "isl_map_coalesce");
+	map = map_coalesce(map, map->n);
+	isl_ctx_scope_leave(ctx);
+	time = (double) (clock() - start) / CLOCKS_PER_SEC;
+	isl_ctx_record_coalesce(ctx, input, time,
+				ctx->operations - operations);
+
+	return map;
+}
+
+/* For each pair of basic maps in the map, check if the union of the two
+ * can be represented by a single basic map.
+ * If so, replace the pair by the single basic map and start over.
+ *
+ * We factor out any (hidden) common factor from the constraint
+ * coefficients to improve the detection of adjacent constraints.
+ * Note that this function does not call isl_basic_map_gauss,
+ * but it does make sure that only a single copy of the basic map
+ * is affected.  This means that isl_basic_map_gauss may have
+ * to be called at the end of the computation (in update_basic_maps)
+ * on this single copy to ensure that
+ * the basic maps are not left in an unexpected state.
+ *
+ * Since we are constructing the tableaus of the basic maps anyway,
+ * we exploit them to detect implicit equalities and redundant constraints.
+ * This also helps the coalescing as it can ignore the redundant constraints.
+ * In order to avoid confusion, we make all implicit equalities explicit
+ * in the basic maps.  If the basic map only has a single reference
+ * (this happens in particular if it was modified by
+ * isl_basic_map_reduce_coefficients), then isl_basic_map_gauss
+ * does not get called on the result.  The call to
+ * isl_basic_map_gauss in update_basic_maps resolves this as well.
+ * For each basic map, we also compute the hash of the apparent affine hull
+ * for use in coalesce, as well as the bounds on the variables
+ * for use in coalesce_range.
+ *
+ * The computation is performed in an operation scope
+ * such that it can be attributed by external profilers.
+ * If the "stats_top_coalesce" option is set, then the cost
+ * of the computation is recorded in the isl_ctx.
+ */
+__isl_give isl_map *isl_map_coalesce(__isl_take isl_map *map)
+{
+	isl_ctx *ctx;
+
+	map = isl_map_remove_empty_parts(map);
+	if (!map)
+		return NULL;
+
+	ctx = isl_map_get_ctx(map);
+	if (ctx->opt->stats_top_coalesce > 0)
+		return map_coalesce_recorded(map);
+	isl_ctx_scope_enter(ctx, "isl_map_coalesce");
+	map = map_coalesce(map, map->n);
+	isl_ctx_scope_leave(ctx);
+
+	return map;
+}
+
+/* Compute the union of "map1" and "map2" and coalesce the result,
+ * assuming that "map1" has already been coalesced.
+ * That is, only pairs of basic maps involving at least
+ * one basic map of "map2" are considered.
+ *
+ * The basic maps of "map2" are placed in front of those of "map1"
+ * such that map_coalesce can tell them apart.
+ * The result of isl_map_union may consist of only
+ * one of its arguments.  If this is "map1", then either "map2" is empty
+ * or "map1" consists of a single basic map, so it is safe
+ * to cap "n_new" to the total number of basic maps.
+ */
+__isl_give isl_map *isl_map_union_coalesce(__isl_take isl_map *map1,
+	__isl_take isl_map *map2)
+{
+	isl_size n_new;
+	isl_map *map;
+
+	map1 = isl_map_remove_empty_parts(map1);
+	map2 = isl_map_remove_empty_parts(map2);
+	n_new = isl_map_n_basic_map(map2);
+	if (n_new < 0)
+		goto error;
+
+	map = isl_map_union(map2, map1);
+	if (!map)
+		return NULL;
+	if (n_new > map->n)
+		n_new = map->n;
+	return map_coalesce(map, n_new);
+error:
+	isl_map_free(map1);
+	isl_map_free(map2);
+	return NULL;
+}
+
 /* For each pair of basic sets in the set, check if the union of the two
  * can be represented by a single basic set.
  * If so, replace the pair by the single basic set and start over.
@@ -4262,3 +4916,13 @@ __isl_give isl_set *isl_set_coalesce(__isl_take isl_set *set)
 {
 	return set_from_map(isl_map_coalesce(set_to_map(set)));
 }
+
+/* Compute the union of "set1" and "set2" and coalesce the result,
+ * assuming that "set1" has already been coalesced.
+ */
+__isl_give isl_set *isl_set_union_coalesce(__isl_take isl_set *set1,
+	__isl_take isl_set *set2)
+{
+	return set_from_map(isl_map_union_coalesce(set_to_map(set1),
+						    set_to_map(set2)));
+}
@@ -242,6 +242,63 @@ isl_stat isl_basic_set_foreach_constraint(__isl_keep isl_basic_set *bset,
 	return isl_basic_map_foreach_constraint(bset_to_bmap(bset), fn, user);
 }
 
+/* Does "test" succeed on every constraint of "bmap"?
+ * The constraints are visited in the same order as
+ * by isl_basic_map_foreach_constraint.
+ *
+ * The constraints are passed to "test" through a single isl_constraint
+ * that is overwritten for each constraint, such that the local space
+ * of "bmap" is only extracted once and no memory is allocated
+ * for each constraint.
+ * If "test" keeps a reference to this constraint or to its coefficients,
+ * then a fresh constraint is constructed for the next call instead.
+ */
+isl_bool isl_basic_map_every_constraint(__isl_keep isl_basic_map *bmap,
+	isl_bool (*test)(__isl_keep isl_constraint *c, void *user), void *user)
+{
+	int i;
+	isl_constraint *c = NULL;
+	isl_bool r = isl_bool_true;
+
+	if (!bmap)
+		return isl_bool_error;
+
+	isl_assert(bmap->ctx, ISL_F_ISSET(bmap, ISL_BASIC_MAP_FINAL),
+			return isl_bool_error);
+
+	for (i = 0; r == isl_bool_true && i < bmap->n_eq + bmap->n_ineq; ++i) {
+		isl_int **line;
+
+		if (i < bmap->n_eq)
+			line = &bmap->eq[i];
+		else
+			line = &bmap->ineq[i - bmap->n_eq];
+		if (c && (c->ref != 1 || c->v->ref != 1))
+			c = isl_constraint_free(c);
+		if (!c) {
+			c = isl_basic_map_constraint(isl_basic_map_copy(bmap),
+							line);
+			if (!c)
+				return isl_bool_error;
+		} else {
+			c->eq = i < bmap->n_eq;
+			isl_seq_cpy(c->v->el, line[0], c->v->size);
+		}
+		r = test(c, user);
+	}
+
+	isl_constraint_free(c);
+	return r;
+}
+
+/* Does "test" succeed on every constraint of "bset"?
+ */
+isl_bool isl_basic_set_every_constraint(__isl_keep isl_basic_set *bset,
+	isl_bool (*test)(__isl_keep isl_constraint *c, void *user), void *user)
+{
+	return isl_basic_map_every_constraint(bset_to_bmap(bset), test, user);
+}
+
 /* Add the constraint to the list that "user" points to, if it is not
  * a div constraint.
  */
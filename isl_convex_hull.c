@@ -22,6 +22,7 @@
 #include "isl_equalities.h"
 #include "isl_tab.h"
 #include <isl_sort.h>
+#include "isl_task.h"
 
 #include <bset_to_bmap.c>
 #include <bset_from_bmap.c>
@@ -57,6 +58,8 @@ __isl_give isl_basic_map *isl_basic_map_remove_redundancies(
 		return NULL;
 
 	bmap = isl_basic_map_gauss(bmap, NULL);
+	if (!bmap)
+		return NULL;
 	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY))
 		return bmap;
 	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_NO_REDUNDANT))
@@ -515,18 +518,245 @@ error:
 	return NULL;
 }
 
-/* Given an initial facet constraint, compute the remaining facets.
- * We do this by running through all facets found so far and computing
- * the adjacent facets through wrapping, adding those facets that we
- * hadn't already found before.
+/* Compute the constraints of the facets of the convex hull of "set"
+ * that are adjacent to the facet with constraint "c" and
+ * that are not already present in the current approximation "hull"
+ * of the convex hull.
  *
- * For each facet we have found so far, we first compute its facets
- * in the resulting convex hull.  That is, we compute the ridges
- * of the resulting convex hull contained in the facet.
+ * We first compute the facets of the facet in the resulting convex hull.
+ * That is, we compute the ridges of the resulting convex hull contained
+ * in the facet.
  * We also compute the corresponding facet in the current approximation
  * of the convex hull.  There is no need to wrap around the ridges
  * in this facet since that would result in a facet that is already
  * present in the current approximation.
+ * The facets obtained by wrapping around the other ridges
+ * are returned as the rows of a matrix.
+ *
+ * "hull" and "set" are only read, such that this function
+ * can be called on several facets concurrently.
+ */
+static __isl_give isl_mat *adjacent_facets(__isl_keep isl_basic_set *hull,
+	__isl_keep isl_set *set, isl_int *c)
+{
+	int j, f, n;
+	isl_size dim;
+	struct isl_basic_set *facet = NULL;
+	struct isl_basic_set *hull_facet = NULL;
+	isl_mat *adj = NULL;
+
+	dim = isl_set_dim(set, isl_dim_set);
+	if (dim < 0)
+		return NULL;
+
+	facet = compute_facet(set, c);
+	facet = isl_basic_set_add_eq(facet, c);
+	facet = isl_basic_set_gauss(facet, NULL);
+	facet = isl_basic_set_normalize_constraints(facet);
+	hull_facet = isl_basic_set_copy(hull);
+	hull_facet = isl_basic_set_add_eq(hull_facet, c);
+	hull_facet = isl_basic_set_gauss(hull_facet, NULL);
+	hull_facet = isl_basic_set_normalize_constraints(hull_facet);
+	if (!facet || !hull_facet)
+		goto error;
+	adj = isl_mat_alloc(set->ctx, facet->n_ineq, 1 + dim);
+	if (!adj)
+		goto error;
+	n = 0;
+	for (j = 0; j < facet->n_ineq; ++j) {
+		for (f = 0; f < hull_facet->n_ineq; ++f)
+			if (isl_seq_eq(facet->ineq[j],
+					hull_facet->ineq[f], 1 + dim))
+				break;
+		if (f < hull_facet->n_ineq)
+			continue;
+		isl_seq_cpy(adj->row[n], c, 1 + dim);
+		if (!isl_set_wrap_facet(set, adj->row[n], facet->ineq[j]))
+			goto error;
+		++n;
+	}
+	adj = isl_mat_drop_rows(adj, n, adj->n_row - n);
+	isl_basic_set_free(hull_facet);
+	isl_basic_set_free(facet);
+
+	return adj;
+error:
+	isl_mat_free(adj);
+	isl_basic_set_free(hull_facet);
+	isl_basic_set_free(facet);
+	return NULL;
+}
+
+/* Is the constraint stored in the isl_vec "entry"
+ * equal to the constraint "val"?
+ */
+static isl_bool facet_has_constraint(const void *entry, const void *val)
+{
+	const isl_vec *facet = entry;
+	isl_int *c = (isl_int *) val;
+
+	return isl_bool_ok(isl_seq_eq(facet->el, c, facet->size));
+}
+
+/* Add the constraint "c" of length "len" to "table",
+ * the table of facet constraints that have been found so far,
+ * and return whether it was not already present.
+ */
+static isl_bool add_found_facet(isl_ctx *ctx, struct isl_hash_table *table,
+	isl_int *c, unsigned len)
+{
+	struct isl_hash_table_entry *entry;
+	uint32_t hash;
+	isl_vec *facet;
+
+	hash = isl_seq_get_hash(c, len);
+	entry = isl_hash_table_find(ctx, table, hash, &facet_has_constraint,
+					c, 1);
+	if (!entry)
+		return isl_bool_error;
+	if (entry->data)
+		return isl_bool_false;
+	facet = isl_vec_alloc(ctx, len);
+	if (!facet) {
+		isl_hash_table_remove(ctx, table, entry);
+		return isl_bool_error;
+	}
+	isl_seq_cpy(facet->el, c, len);
+	entry->data = facet;
+	return isl_bool_true;
+}
+
+/* Free the isl_vec stored in "entry".
+ */
+static isl_stat free_found_facet(void **entry, void *user)
+{
+	isl_vec_free(*entry);
+	return isl_stat_ok;
+}
+
+/* Free the table of facet constraints found so far.
+ */
+static void free_found_facets(isl_ctx *ctx, struct isl_hash_table *table)
+{
+	if (!table)
+		return;
+	isl_hash_table_foreach(ctx, table, &free_found_facet, NULL);
+	isl_hash_table_free(ctx, table);
+}
+
+/* Add the constraints in the rows of "adj" to "hull",
+ * skipping those that appear in the table "table"
+ * of facet constraints found so far, and add them to this table.
+ * If "max_facets" is positive, then stop adding constraints
+ * as soon as "hull" has "max_facets" constraints.
+ */
+static __isl_give isl_basic_set *add_facets(__isl_take isl_basic_set *hull,
+	__isl_keep isl_mat *adj, struct isl_hash_table *table, int max_facets)
+{
+	int j, k;
+
+	hull = isl_basic_set_cow(hull);
+	hull = isl_basic_set_extend(hull, 0, 0, adj->n_row);
+	if (!hull)
+		return NULL;
+	for (j = 0; j < adj->n_row; ++j) {
+		isl_bool is_new;
+
+		if (max_facets > 0 && hull->n_ineq >= max_facets)
+			break;
+		is_new = add_found_facet(hull->ctx, table,
+					adj->row[j], adj->n_col);
+		if (is_new < 0)
+			return isl_basic_set_free(hull);
+		if (!is_new)
+			continue;
+		k = isl_basic_set_alloc_inequality(hull);
+		if (k < 0)
+			return isl_basic_set_free(hull);
+		isl_seq_cpy(hull->ineq[k], adj->row[j], adj->n_col);
+	}
+
+	return hull;
+}
+
+/* Data used by compute_adjacent_facets.
+ * Task "k" computes the facets adjacent to facet "start" + "k" of "hull"
+ * and stores them in "adj[k]".
+ */
+struct isl_convex_hull_tasks {
+	isl_basic_set *hull;
+	isl_set *set;
+	int start;
+	isl_mat **adj;
+};
+
+/* Compute the adjacent facets of task "k"
+ * on copies of "hull" and "set" in "ctx".
+ */
+static isl_stat convex_hull_task_run(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_convex_hull_tasks *data = user;
+	isl_basic_set *hull;
+	isl_set *set;
+
+	hull = isl_basic_set_copy_to_ctx(data->hull, ctx);
+	set = isl_set_copy_to_ctx(data->set, ctx);
+	if (hull && set)
+		data->adj[k] = adjacent_facets(hull, set,
+						hull->ineq[data->start + k]);
+	isl_basic_set_free(hull);
+	isl_set_free(set);
+
+	return data->adj[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* Copy the adjacent facets computed by task "k" to "ctx".
+ */
+static isl_stat convex_hull_task_merge(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_convex_hull_tasks *data = user;
+	isl_mat *child = data->adj[k];
+
+	data->adj[k] = isl_mat_copy_to_ctx(child, ctx);
+	isl_mat_free(child);
+	return data->adj[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* Compute the facets adjacent to the facets in the range [start, end[
+ * of "hull" using up to "n_thread" threads, each of them
+ * in a task of isl_ctx_run_tasks, and store them in "adj".
+ */
+static isl_stat compute_adjacent_facets(__isl_keep isl_basic_set *hull,
+	__isl_keep isl_set *set, int start, int end, isl_mat **adj,
+	int n_thread)
+{
+	struct isl_convex_hull_tasks data = { hull, set, start, adj };
+
+	return isl_ctx_run_tasks(isl_set_get_ctx(set), end - start, n_thread,
+			    &convex_hull_task_run, &convex_hull_task_merge, &data);
+}
+
+/* Given an initial facet constraint, compute the remaining facets.
+ * We do this by running through all facets found so far and computing
+ * the adjacent facets through wrapping, adding those facets that we
+ * hadn't already found before.
+ * The facets that have been found are kept in a hash table
+ * such that each of them is only added (and processed) once.
+ *
+ * Without threads, the facets are processed one at a time,
+ * such that the adjacent facets of a facet are computed
+ * with respect to all facets found before.
+ * With "n_thread" set to a value greater than one,
+ * the frontier of all facets that have been found but not yet processed
+ * is processed as a whole, using up to "n_thread" threads.
+ * The adjacent facets are then only compared to the facets
+ * found before the frontier, possibly resulting in some extra wrapping,
+ * but the facets obtained from the frontier are added to "hull"
+ * in the same order as without threads.
+ *
+ * If "max_facets" is positive, then the computation stops
+ * as soon as "max_facets" facets have been found.
+ * The result is then a superset of the convex hull.
  *
  * This function can still be significantly optimized by checking which of
  * the facets of the basic sets are also facets of the convex hull and
@@ -537,58 +767,59 @@ error:
  * "Extended Convex Hull" by Fukuda et al.
  */
 static __isl_give isl_basic_set *extend(__isl_take isl_basic_set *hull,
-	__isl_keep isl_set *set)
+	__isl_keep isl_set *set, int n_thread, int max_facets)
 {
-	int i, j, f;
-	int k;
-	struct isl_basic_set *facet = NULL;
-	struct isl_basic_set *hull_facet = NULL;
+	int i, start, end;
+	isl_ctx *ctx;
 	isl_size dim;
+	struct isl_hash_table *table;
+	isl_mat **adj = NULL;
 
 	dim = isl_set_dim(set, isl_dim_set);
 	if (dim < 0 || !hull)
 		return isl_basic_set_free(hull);
 
-	isl_assert(set->ctx, set->n > 0, goto error);
+	ctx = isl_set_get_ctx(set);
+	isl_assert(ctx, set->n > 0, return isl_basic_set_free(hull));
 
-	for (i = 0; i < hull->n_ineq; ++i) {
-		facet = compute_facet(set, hull->ineq[i]);
-		facet = isl_basic_set_add_eq(facet, hull->ineq[i]);
-		facet = isl_basic_set_gauss(facet, NULL);
-		facet = isl_basic_set_normalize_constraints(facet);
-		hull_facet = isl_basic_set_copy(hull);
-		hull_facet = isl_basic_set_add_eq(hull_facet, hull->ineq[i]);
-		hull_facet = isl_basic_set_gauss(hull_facet, NULL);
-		hull_facet = isl_basic_set_normalize_constraints(hull_facet);
-		if (!facet || !hull_facet)
+	table = isl_hash_table_alloc(ctx, hull->n_ineq);
+	if (!table)
+		return isl_basic_set_free(hull);
+	for (i = 0; i < hull->n_ineq; ++i)
+		if (add_found_facet(ctx, table, hull->ineq[i], 1 + dim) < 0)
+			goto error;
+
+	for (start = 0; start < hull->n_ineq; start = end) {
+		if (max_facets > 0 && hull->n_ineq >= max_facets)
+			break;
+		end = n_thread > 1 ? hull->n_ineq : start + 1;
+		adj = isl_calloc_array(ctx, isl_mat *, end - start);
+		if (!adj)
 			goto error;
-		hull = isl_basic_set_cow(hull);
-		hull = isl_basic_set_extend(hull, 0, 0, facet->n_ineq);
+		if (compute_adjacent_facets(hull, set, start, end, adj,
+					    n_thread) < 0)
+			goto error;
+		for (i = start; hull && i < end; ++i)
+			hull = add_facets(hull, adj[i - start], table,
+					max_facets);
+		for (i = start; i < end; ++i)
+			isl_mat_free(adj[i - start]);
+		free(adj);
+		adj = NULL;
 		if (!hull)
 			goto error;
-		for (j = 0; j < facet->n_ineq; ++j) {
-			for (f = 0; f < hull_facet->n_ineq; ++f)
-				if (isl_seq_eq(facet->ineq[j],
-						hull_facet->ineq[f], 1 + dim))
-					break;
-			if (f < hull_facet->n_ineq)
-				continue;
-			k = isl_basic_set_alloc_inequality(hull);
-			if (k < 0)
-				goto error;
-			isl_seq_cpy(hull->ineq[k], hull->ineq[i], 1+dim);
-			if (!isl_set_wrap_facet(set, hull->ineq[k], facet->ineq[j]))
-				goto error;
-		}
-		isl_basic_set_free(hull_facet);
-		isl_basic_set_free(facet);
 	}
+
+	free_found_facets(ctx, table);
 	hull = isl_basic_set_simplify(hull);
 	hull = isl_basic_set_finalize(hull);
 	return hull;
 error:
-	isl_basic_set_free(hull_facet);
-	isl_basic_set_free(facet);
+	if (adj)
+		for (i = start; i < end; ++i)
+			isl_mat_free(adj[i - start]);
+	free(adj);
+	free_found_facets(ctx, table);
 	isl_basic_set_free(hull);
 	return NULL;
 }
@@ -1262,7 +1493,8 @@ error:
 	return NULL;
 }
 
-static __isl_give isl_basic_set *uset_convex_hull_wrap(__isl_take isl_set *set);
+static __isl_give isl_basic_set *uset_convex_hull_wrap(__isl_take isl_set *set,
+	int n_thread, int max_facets);
 static __isl_give isl_basic_set *modulo_affine_hull(
 	__isl_take isl_set *set, __isl_take isl_basic_set *affine_hull);
 
@@ -1304,7 +1536,8 @@ static __isl_give isl_basic_set *convex_hull_pair(
 		goto error;
 
 	if (bounded1 && bounded2)
-		return uset_convex_hull_wrap(isl_basic_set_union(bset1, bset2));
+		return uset_convex_hull_wrap(isl_basic_set_union(bset1, bset2),
+						0, 0);
 
 	if (bounded1 || bounded2)
 		return convex_hull_pair_pointed(bset1, bset2);
@@ -1767,7 +2000,13 @@ static __isl_give isl_basic_set *proto_hull(__isl_keep isl_set *set,
 	return common_constraints(hull, set, is_hull);
 }
 
-static __isl_give isl_basic_set *uset_convex_hull_wrap(__isl_take isl_set *set)
+/* Compute the convex hull of the bounded set "set" using wrapping,
+ * processing the frontier of facets using up to "n_thread" threads and
+ * stopping as soon as "max_facets" facets have been found
+ * if "max_facets" is positive.
+ */
+static __isl_give isl_basic_set *uset_convex_hull_wrap(__isl_take isl_set *set,
+	int n_thread, int max_facets)
 {
 	struct isl_basic_set *hull;
 	int is_hull;
@@ -1776,7 +2015,7 @@ static __isl_give isl_basic_set *uset_convex_hull_wrap(__isl_take isl_set *set)
 	if (hull && !is_hull) {
 		if (hull->n_ineq == 0)
 			hull = initial_hull(hull, set);
-		hull = extend(hull, set);
+		hull = extend(hull, set, n_thread, max_facets);
 	}
 	isl_set_free(set);
 
@@ -1788,6 +2027,9 @@ static __isl_give isl_basic_set *uset_convex_hull_wrap(__isl_take isl_set *set)
  * we pass control to the wrapping based convex hull or
  * the Fourier-Motzkin elimination based convex hull.
  * We also handle a few special cases before checking the boundedness.
+ * The options convex_hull_threads and convex_hull_max_facets
+ * only apply to the outermost wrapping based computation
+ * and not to the computations of the facets of facets.
  */
 static __isl_give isl_basic_set *uset_convex_hull(__isl_take isl_set *set)
 {
@@ -1819,7 +2061,9 @@ static __isl_give isl_basic_set *uset_convex_hull(__isl_take isl_set *set)
 	if (bounded < 0)
 		goto error;
 	if (bounded && set->ctx->opt->convex == ISL_CONVEX_HULL_WRAP)
-		return uset_convex_hull_wrap(set);
+		return uset_convex_hull_wrap(set,
+				set->ctx->opt->convex_hull_threads,
+				set->ctx->opt->convex_hull_max_facets);
 
 	lin = isl_set_combined_lineality_space(isl_set_copy(set));
 	if (!lin)
@@ -1873,7 +2117,7 @@ static __isl_give isl_basic_set *uset_convex_hull_wrap_bounded(
 	if (dim == 1)
 		return convex_hull_1d(set);
 
-	return uset_convex_hull_wrap(set);
+	return uset_convex_hull_wrap(set, 0, 0);
 error:
 	isl_set_free(set);
 	return NULL;
@@ -2416,11 +2660,16 @@ static __isl_give isl_basic_map *cached_simple_hull(__isl_take isl_map *map,
  *
  * The result of the computation is stored in map->cached_simple_hull[shift]
  * such that it can be reused in subsequent calls.  The cache is cleared
- * whenever the map is modified (in isl_map_cow).
+ * whenever the map is modified (in isl_map_cow), except by operations
+ * that transform the simple hull in a known way
+ * (e.g., isl_map_reset_space, isl_map_move_dims and isl_map_realign),
+ * which transform the cached simple hull along with the map.
  * Note that the results need to be stored in the input map for there
  * to be any chance that they may get reused.  In particular, they
  * are stored in a copy of the input map that is saved before
  * the integer division alignment.
+ * If the memory_lean option is set, then the result is not stored
+ * such that it does not stay alive as long as the input map.
  */
 static __isl_give isl_basic_map *map_simple_hull(__isl_take isl_map *map,
 	int shift)
@@ -2435,8 +2684,11 @@ static __isl_give isl_basic_map *map_simple_hull(__isl_take isl_map *map,
 	if (!map || map->n <= 1)
 		return map_simple_hull_trivial(map);
 
-	if (map->cached_simple_hull[shift])
+	if (map->cached_simple_hull[shift]) {
+		map->ctx->stats->simple_hull_cache_hits++;
 		return cached_simple_hull(map, shift);
+	}
+	map->ctx->stats->simple_hull_cache_misses++;
 
 	map = isl_map_detect_equalities(map);
 	if (!map || map->n <= 1)
@@ -2461,7 +2713,7 @@ static __isl_give isl_basic_map *map_simple_hull(__isl_take isl_map *map,
 	}
 
 	hull = isl_basic_map_finalize(hull);
-	if (input)
+	if (input && !input->ctx->opt->memory_lean)
 		input->cached_simple_hull[shift] = isl_basic_map_copy(hull);
 	isl_map_free(input);
 
@@ -7,13 +7,20 @@
  * Computerwetenschappen, Celestijnenlaan 200A, B-3001 Leuven, Belgium
  */
 
+#include <stddef.h>
+#include <string.h>
 #include <isl_ctx_private.h>
 #include <isl/vec.h>
+#include <isl/map.h>
+#include <isl/printer.h>
+#include <isl_sample.h>
 #include <isl_options_private.h>
 
 #define __isl_calloc(type,size)		((type *)calloc(1, size))
 #define __isl_calloc_type(type)		__isl_calloc(type,sizeof(type))
 
+#define ARRAY_SIZE(array) (sizeof(array)/sizeof(*array))
+
 /* Construct an isl_stat indicating whether "obj" is non-NULL.
  *
  * That is, return isl_stat_ok if "obj" is non_NULL and
@@ -66,10 +73,14 @@ static void *check_non_null(isl_ctx *ctx, void *p, size_t size)
  * return -1 if we should abort the computation.
  *
  * In particular, we should stop if the user has explicitly aborted
- * the computation or if the maximal number of operations has been exceeded.
+ * the computation or if the maximal number of operations has been exceeded,
+ * either globally or in any of the active budget scopes.
+ * The operation is charged to all active budget scopes.
  */
 int isl_ctx_next_operation(isl_ctx *ctx)
 {
+	struct isl_budget *budget;
+
 	if (!ctx)
 		return -1;
 	if (ctx->abort) {
@@ -79,38 +90,136 @@ int isl_ctx_next_operation(isl_ctx *ctx)
 	if (ctx->max_operations && ctx->operations >= ctx->max_operations)
 		isl_die(ctx, isl_error_quota,
 			"maximal number of operations exceeded", return -1);
+	for (budget = ctx->budget; budget; budget = budget->outer)
+		if (budget->max_operations &&
+		    budget->operations >= budget->max_operations)
+			isl_die(ctx, isl_error_quota,
+				"operation budget exceeded", return -1);
 	ctx->operations++;
+	for (budget = ctx->budget; budget; budget = budget->outer)
+		budget->operations++;
+	return 0;
+}
+
+/* Prepare for performing an allocation of "size" bytes in "ctx",
+ * which is a reallocation if "re" is set.
+ * Return 0 if the allocation is allowed and -1 otherwise.
+ *
+ * Besides being counted as an operation, the allocation
+ * is recorded in ctx->memory and it is checked that it does
+ * not bring the total number of requested bytes
+ * over ctx->max_allocated_bytes.
+ * Since memory is released by calling free directly,
+ * the requested bytes are never subtracted again.
+ * The bound is therefore a budget on the cumulative size
+ * of all allocations since the last call to isl_ctx_reset_memory,
+ * rather than a bound on the amount of memory in use.
+ */
+static int next_allocation(isl_ctx *ctx, size_t size, int re)
+{
+	size_t max;
+
+	if (isl_ctx_next_operation(ctx) < 0)
+		return -1;
+
+	max = ctx->max_allocated_bytes;
+	if (max && (ctx->memory.bytes > max ||
+		    size > max - ctx->memory.bytes))
+		isl_die(ctx, isl_error_quota,
+			"maximal amount of memory exceeded", return -1);
+	if (re)
+		ctx->memory.n_realloc++;
+	else
+		ctx->memory.n_alloc++;
+	ctx->memory.bytes += size;
+	if (size > ctx->memory.max_request)
+		ctx->memory.max_request = size;
 	return 0;
 }
 
-/* Call malloc and complain if it fails.
+/* Call malloc, or the malloc function set by isl_ctx_set_allocator,
+ * and complain if it fails.
  * If ctx is NULL, then return NULL.
  */
 void *isl_malloc_or_die(isl_ctx *ctx, size_t size)
 {
-	if (isl_ctx_next_operation(ctx) < 0)
+	void *p;
+
+	if (next_allocation(ctx, size, 0) < 0)
 		return NULL;
-	return ctx ? check_non_null(ctx, malloc(size), size) : NULL;
+	if (ctx->alloc_malloc)
+		p = ctx->alloc_malloc(size, ctx->alloc_user);
+	else
+		p = malloc(size);
+	return check_non_null(ctx, p, size);
 }
 
-/* Call calloc and complain if it fails.
+/* Call calloc, or the calloc function set by isl_ctx_set_allocator,
+ * and complain if it fails.
  * If ctx is NULL, then return NULL.
  */
 void *isl_calloc_or_die(isl_ctx *ctx, size_t nmemb, size_t size)
 {
-	if (isl_ctx_next_operation(ctx) < 0)
+	void *p;
+
+	if (!ctx)
+		return NULL;
+	if (size && nmemb > (size_t) -1 / size)
+		isl_die(ctx, isl_error_alloc, "allocation too large",
+			return NULL);
+	if (next_allocation(ctx, nmemb * size, 0) < 0)
 		return NULL;
-	return ctx ? check_non_null(ctx, calloc(nmemb, size), nmemb) : NULL;
+	if (ctx->alloc_calloc)
+		p = ctx->alloc_calloc(nmemb, size, ctx->alloc_user);
+	else
+		p = calloc(nmemb, size);
+	return check_non_null(ctx, p, nmemb);
 }
 
-/* Call realloc and complain if it fails.
+/* Call realloc, or the realloc function set by isl_ctx_set_allocator,
+ * and complain if it fails.
  * If ctx is NULL, then return NULL.
  */
 void *isl_realloc_or_die(isl_ctx *ctx, void *ptr, size_t size)
 {
-	if (isl_ctx_next_operation(ctx) < 0)
+	void *p;
+
+	if (next_allocation(ctx, size, 1) < 0)
 		return NULL;
-	return ctx ? check_non_null(ctx, realloc(ptr, size), size) : NULL;
+	if (ctx->alloc_realloc)
+		p = ctx->alloc_realloc(ptr, size, ctx->alloc_user);
+	else
+		p = realloc(ptr, size);
+	return check_non_null(ctx, p, size);
+}
+
+/* Set the functions that are used to allocate memory in "ctx"
+ * to "malloc_fn", "calloc_fn" and "realloc_fn".
+ * Each of them is called with "user" as last argument.
+ * If any of them is NULL, then the corresponding function
+ * of the C library is used instead.
+ *
+ * isl releases memory by calling the free function of the C library,
+ * so the memory returned by these functions needs to be compatible
+ * with that function.  This is the case, for example, for allocators
+ * that replace the C library allocator and that allow the allocation
+ * to be performed in a specific arena or on a specific NUMA node.
+ *
+ * Child contexts allocated after this call inherit these functions.
+ */
+isl_stat isl_ctx_set_allocator(isl_ctx *ctx,
+	void *(*malloc_fn)(size_t size, void *user),
+	void *(*calloc_fn)(size_t nmemb, size_t size, void *user),
+	void *(*realloc_fn)(void *ptr, size_t size, void *user),
+	void *user)
+{
+	if (!ctx)
+		return isl_stat_error;
+	ctx->alloc_malloc = malloc_fn;
+	ctx->alloc_calloc = calloc_fn;
+	ctx->alloc_realloc = realloc_fn;
+	ctx->alloc_user = user;
+	return isl_stat_ok;
 }
 
 /* Keep track of all information about the current error ("error", "msg",
@@ -135,6 +244,8 @@ void isl_handle_error(isl_ctx *ctx, enum isl_error error, const char *msg,
 
 	isl_ctx_set_full_error(ctx, error, msg, file, line);
 
+	if (ctx->quiet)
+		return;
 	switch (ctx->opt->on_error) {
 	case ISL_ON_ERROR_WARN:
 		fprintf(stderr, "%s:%d: %s\n", file, line, msg);
@@ -190,40 +301,31 @@ void *isl_ctx_peek_options(isl_ctx *ctx, struct isl_args *args)
 		return NULL;
 	if (args == &isl_options_args)
 		return ctx->opt;
+	if (ctx->parent)
+		return isl_ctx_peek_options(ctx->parent, args);
 	return find_nested_options(ctx->user_args, ctx->user_opt, args);
 }
 
-isl_ctx *isl_ctx_alloc_with_options(struct isl_args *args, void *user_opt)
+/* Allocate an isl_ctx that uses the options "opt".
+ * The caller is responsible for recording who owns these options.
+ */
+static isl_ctx *isl_ctx_alloc_base(struct isl_options *opt)
 {
-	struct isl_ctx *ctx = NULL;
-	struct isl_options *opt = NULL;
-	int opt_allocated = 0;
-
-	if (!user_opt)
-		return NULL;
-
-	opt = find_nested_isl_options(args, user_opt);
-	if (!opt) {
-		opt = isl_options_new_with_defaults();
-		if (!opt)
-			goto error;
-		opt_allocated = 1;
-	}
+	struct isl_ctx *ctx;
 
 	ctx = __isl_calloc_type(struct isl_ctx);
 	if (!ctx)
-		goto error;
+		return NULL;
 
 	if (isl_hash_table_init(ctx, &ctx->id_table, 0))
 		goto error;
+	if (isl_hash_table_init(ctx, &ctx->space_table, 0))
+		goto error;
 
 	ctx->stats = isl_calloc_type(ctx, struct isl_stats);
 	if (!ctx->stats)
 		goto error;
 
-	ctx->user_args = args;
-	ctx->user_opt = user_opt;
-	ctx->opt_allocated = opt_allocated;
 	ctx->opt = opt;
 	ctx->ref = 0;
 
@@ -241,23 +343,91 @@ isl_ctx *isl_ctx_alloc_with_options(struct isl_args *args, void *user_opt)
 
 	isl_int_init(ctx->normalize_gcd);
 
-	ctx->n_cached = 0;
+	ctx->n_hit = 0;
 	ctx->n_miss = 0;
+	ctx->n_val_cached = 0;
+	ctx->n_val_hit = 0;
+	ctx->n_val_miss = 0;
 
 	isl_ctx_reset_error(ctx);
 
 	ctx->operations = 0;
 	isl_ctx_set_max_operations(ctx, ctx->opt->max_operations);
+	isl_ctx_set_max_allocated_bytes(ctx, ctx->opt->max_allocated_bytes);
+
+	return ctx;
+error:
+	free(ctx);
+	return NULL;
+}
+
+isl_ctx *isl_ctx_alloc_with_options(struct isl_args *args, void *user_opt)
+{
+	struct isl_ctx *ctx = NULL;
+	struct isl_options *opt = NULL;
+	int opt_allocated = 0;
+
+	if (!user_opt)
+		return NULL;
+
+	opt = find_nested_isl_options(args, user_opt);
+	if (!opt) {
+		opt = isl_options_new_with_defaults();
+		if (!opt)
+			goto error;
+		opt_allocated = 1;
+	}
+
+	ctx = isl_ctx_alloc_base(opt);
+	if (!ctx)
+		goto error;
+
+	ctx->user_args = args;
+	ctx->user_opt = user_opt;
+	ctx->opt_allocated = opt_allocated;
 
 	return ctx;
 error:
 	isl_args_free(args, user_opt);
 	if (opt_allocated)
 		isl_options_free(opt);
-	free(ctx);
 	return NULL;
 }
 
+/* Allocate a child context of "parent".
+ *
+ * The child shares the options of "parent", including any user options,
+ * rather than making a copy.  It keeps a reference to "parent"
+ * such that "parent" cannot be freed before the child.
+ * It also uses the same allocation functions as "parent".
+ * All other state, including the identifiers, is private to the child.
+ */
+isl_ctx *isl_ctx_alloc_child(isl_ctx *parent)
+{
+	isl_ctx *ctx;
+
+	if (!parent)
+		return NULL;
+
+	ctx = isl_ctx_alloc_base(parent->opt);
+	if (!ctx)
+		return NULL;
+
+	ctx->parent = parent;
+	isl_ctx_ref(parent);
+	isl_ctx_set_allocator(ctx, parent->alloc_malloc, parent->alloc_calloc,
+				parent->alloc_realloc, parent->alloc_user);
+
+	return ctx;
+}
+
+/* Return the parent of "ctx", or NULL if "ctx" is not a child context.
+ */
+isl_ctx *isl_ctx_get_parent(isl_ctx *ctx)
+{
+	return ctx ? ctx->parent : NULL;
+}
+
 struct isl_ctx *isl_ctx_alloc()
 {
 	struct isl_options *opt;
@@ -278,17 +448,601 @@ void isl_ctx_deref(struct isl_ctx *ctx)
 	ctx->ref--;
 }
 
+/* Free the record of the operations performed in budget scopes
+ * that have been left.
+ */
+static void clear_budget_usage(isl_ctx *ctx)
+{
+	struct isl_budget_usage *usage, *next;
+
+	for (usage = ctx->budget_usage; usage; usage = next) {
+		next = usage->next;
+		free(usage->name);
+		free(usage);
+	}
+	ctx->budget_usage = NULL;
+}
+
 /* Print statistics on usage.
  */
 static void print_stats(isl_ctx *ctx)
 {
+	struct isl_stats *stats = ctx->stats;
+	struct isl_budget_usage *usage;
+
 	fprintf(stderr, "operations: %lu\n", ctx->operations);
+	fprintf(stderr, "allocations: %lu\n", ctx->memory.n_alloc);
+	fprintf(stderr, "reallocations: %lu\n", ctx->memory.n_realloc);
+	fprintf(stderr, "bytes allocated: %lu\n",
+		(unsigned long) ctx->memory.bytes);
+	fprintf(stderr, "largest allocation: %lu\n",
+		(unsigned long) ctx->memory.max_request);
+	fprintf(stderr, "block cache hits: %lu\n", ctx->n_hit);
+	fprintf(stderr, "block cache misses: %lu\n", ctx->n_miss);
+	fprintf(stderr, "val cache hits: %lu\n", ctx->n_val_hit);
+	fprintf(stderr, "val cache misses: %lu\n", ctx->n_val_miss);
+	fprintf(stderr, "gbr solved lps: %ld\n", stats->gbr_solved_lps);
+	fprintf(stderr, "tableau pivots: %ld\n", stats->tab_pivots);
+	fprintf(stderr, "pip solves: %ld (%.3fs)\n",
+		stats->pip_solves, stats->pip_time);
+	fprintf(stderr, "coalesce pair tests: %ld (%.3fs)\n",
+		stats->coalesce_pair_tests, stats->coalesce_pair_time);
+	fprintf(stderr, "gist calls: %ld (%.3fs)\n",
+		stats->gist_calls, stats->gist_time);
+	fprintf(stderr, "gist decided: plain %ld, bounds %ld, tableau %ld\n",
+		stats->gist_plain_decided, stats->gist_bounds_decided,
+		stats->gist_tab_decided);
+	fprintf(stderr, "emptiness decided: plain %ld, bounds %ld, "
+		"point %ld, sample %ld\n",
+		stats->empty_plain_decided, stats->empty_bounds_decided,
+		stats->empty_point_decided, stats->empty_sample_decided);
+	fprintf(stderr, "schedule lp solves: %ld (%.3fs)\n",
+		stats->schedule_lp_solves, stats->schedule_lp_time);
+	fprintf(stderr, "flow computations: %ld (%.3fs)\n",
+		stats->flow_computations, stats->flow_time);
+	fprintf(stderr, "sample cache hits: %ld\n", stats->sample_cache_hits);
+	fprintf(stderr, "sample cache misses: %ld\n",
+		stats->sample_cache_misses);
+	fprintf(stderr, "flow cache hits: %ld\n", stats->flow_cache_hits);
+	fprintf(stderr, "flow cache misses: %ld\n", stats->flow_cache_misses);
+	fprintf(stderr, "lexopt cache hits: %ld\n", stats->lexopt_cache_hits);
+	fprintf(stderr, "lexopt cache misses: %ld\n",
+		stats->lexopt_cache_misses);
+	fprintf(stderr, "ast expression cache hits: %ld\n",
+		stats->ast_expr_cache_hits);
+	fprintf(stderr, "ast expression cache misses: %ld\n",
+		stats->ast_expr_cache_misses);
+	fprintf(stderr, "ast subtree reuses: %ld\n", stats->ast_subtree_reuses);
+	fprintf(stderr, "schedule component reuses: %ld\n",
+		stats->schedule_component_reuses);
+	fprintf(stderr, "schedule coefficient cache hits: %ld\n",
+		stats->schedule_coef_cache_hits);
+	fprintf(stderr, "schedule coefficient cache misses: %ld\n",
+		stats->schedule_coef_cache_misses);
+	fprintf(stderr, "schedule LP backend accepts: %ld\n",
+		stats->schedule_lp_backend_accepts);
+	fprintf(stderr, "schedule LP backend rejects: %ld\n",
+		stats->schedule_lp_backend_rejects);
+	fprintf(stderr, "schedule offload accepts: %ld\n",
+		stats->schedule_offload_accepts);
+	fprintf(stderr, "schedule offload rejects: %ld\n",
+		stats->schedule_offload_rejects);
+	fprintf(stderr, "simple hull cache hits: %ld\n",
+		stats->simple_hull_cache_hits);
+	fprintf(stderr, "simple hull cache misses: %ld\n",
+		stats->simple_hull_cache_misses);
+	fprintf(stderr, "ast stride cache hits: %ld\n",
+		stats->ast_stride_cache_hits);
+	fprintf(stderr, "ast stride cache misses: %ld\n",
+		stats->ast_stride_cache_misses);
+	fprintf(stderr, "project out fm: %ld\n", stats->project_out_fm);
+	fprintf(stderr, "compute divs pip: %ld\n", stats->compute_divs_pip);
+	for (usage = ctx->budget_usage; usage; usage = usage->next)
+		fprintf(stderr, "budget %s operations: %lu\n",
+			usage->name, usage->operations);
+}
+
+/* Free the records of the most expensive calls to isl_map_coalesce.
+ */
+static void clear_coalesce_records(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ctx->n_top_coalesce; ++i)
+		free(ctx->top_coalesce[i].input);
+	free(ctx->top_coalesce);
+	ctx->top_coalesce = NULL;
+	ctx->n_top_coalesce = 0;
+	ctx->size_top_coalesce = 0;
+}
+
+/* Is the call to isl_map_coalesce recorded in "a" more expensive
+ * than one that took "time" seconds and performed "operations" operations?
+ * The number of operations is only used to break ties
+ * since the processor time is only measured with a limited resolution.
+ */
+static int more_expensive(struct isl_coalesce_record *a, double time,
+	unsigned long operations)
+{
+	if (a->time != time)
+		return a->time > time;
+	return a->operations > operations;
+}
+
+/* Record a call to isl_map_coalesce on the input "input"
+ * (in binary format) that took "time" seconds and performed
+ * "operations" operations, if it is among the "stats_top_coalesce"
+ * most expensive calls in "ctx" so far.
+ * The records are kept in decreasing order of cost.
+ * "input" is freed if it is not kept.
+ */
+void isl_ctx_record_coalesce(isl_ctx *ctx, char *input, double time,
+	unsigned long operations)
+{
+	int i, size;
+
+	size = ctx->opt->stats_top_coalesce;
+	if (size != ctx->size_top_coalesce) {
+		clear_coalesce_records(ctx);
+		ctx->top_coalesce = isl_calloc_array(ctx,
+				struct isl_coalesce_record, size);
+		if (!ctx->top_coalesce) {
+			free(input);
+			return;
+		}
+		ctx->size_top_coalesce = size;
+	}
+
+	for (i = ctx->n_top_coalesce; i > 0; --i)
+		if (more_expensive(&ctx->top_coalesce[i - 1], time, operations))
+			break;
+	if (i >= size) {
+		free(input);
+		return;
+	}
+	if (ctx->n_top_coalesce == size)
+		free(ctx->top_coalesce[--ctx->n_top_coalesce].input);
+	memmove(ctx->top_coalesce + i + 1, ctx->top_coalesce + i,
+		(ctx->n_top_coalesce - i) * sizeof(*ctx->top_coalesce));
+	ctx->top_coalesce[i].time = time;
+	ctx->top_coalesce[i].operations = operations;
+	ctx->top_coalesce[i].input = input;
+	ctx->n_top_coalesce++;
+}
+
+/* The fields of struct isl_stats that count events,
+ * along with their offsets.
+ */
+#define ISL_STATS_FIELD(field)	{ #field, offsetof(struct isl_stats, field) }
+static struct {
+	const char *name;
+	size_t offset;
+} stats_counters[] = {
+	ISL_STATS_FIELD(gbr_solved_lps),
+	ISL_STATS_FIELD(tab_pivots),
+	ISL_STATS_FIELD(pip_solves),
+	ISL_STATS_FIELD(coalesce_pair_tests),
+	ISL_STATS_FIELD(gist_calls),
+	ISL_STATS_FIELD(gist_plain_decided),
+	ISL_STATS_FIELD(gist_bounds_decided),
+	ISL_STATS_FIELD(gist_tab_decided),
+	ISL_STATS_FIELD(empty_plain_decided),
+	ISL_STATS_FIELD(empty_bounds_decided),
+	ISL_STATS_FIELD(empty_point_decided),
+	ISL_STATS_FIELD(empty_sample_decided),
+	ISL_STATS_FIELD(schedule_lp_solves),
+	ISL_STATS_FIELD(flow_computations),
+	ISL_STATS_FIELD(ast_subtree_reuses),
+	ISL_STATS_FIELD(schedule_component_reuses),
+	ISL_STATS_FIELD(schedule_lp_backend_accepts),
+	ISL_STATS_FIELD(schedule_lp_backend_rejects),
+	ISL_STATS_FIELD(schedule_offload_accepts),
+	ISL_STATS_FIELD(schedule_offload_rejects),
+	ISL_STATS_FIELD(project_out_fm),
+	ISL_STATS_FIELD(compute_divs_pip),
+};
+
+/* The fields of struct isl_stats that accumulate processor time,
+ * along with their offsets.
+ */
+static struct {
+	const char *name;
+	size_t offset;
+} stats_timers[] = {
+	ISL_STATS_FIELD(pip_time),
+	ISL_STATS_FIELD(coalesce_pair_time),
+	ISL_STATS_FIELD(gist_time),
+	ISL_STATS_FIELD(schedule_lp_time),
+	ISL_STATS_FIELD(flow_time),
+};
+
+/* The caches for which struct isl_stats counts hits and misses,
+ * along with the offsets of the corresponding fields.
+ */
+#define ISL_STATS_CACHE(name, prefix)					\
+	{ name, offsetof(struct isl_stats, prefix ## _hits),		\
+		offsetof(struct isl_stats, prefix ## _misses) }
+static struct {
+	const char *name;
+	size_t hits;
+	size_t misses;
+} stats_caches[] = {
+	ISL_STATS_CACHE("sample", sample_cache),
+	ISL_STATS_CACHE("flow", flow_cache),
+	ISL_STATS_CACHE("lexopt", lexopt_cache),
+	ISL_STATS_CACHE("ast_expr", ast_expr_cache),
+	ISL_STATS_CACHE("schedule_coef", schedule_coef_cache),
+	ISL_STATS_CACHE("simple_hull", simple_hull_cache),
+	ISL_STATS_CACHE("ast_stride", ast_stride_cache),
+};
+
+/* Add the statistics collected in "child" to those of "ctx".
+ * This is used to account for the work performed in a child context
+ * before it is freed.
+ */
+void isl_ctx_add_stats(isl_ctx *ctx, isl_ctx *child)
+{
+	int i;
+	char *dst, *src;
+
+	if (!ctx || !child)
+		return;
+
+	dst = (char *) ctx->stats;
+	src = (char *) child->stats;
+	for (i = 0; i < ARRAY_SIZE(stats_counters); ++i)
+		*(long *) (dst + stats_counters[i].offset) +=
+			*(long *) (src + stats_counters[i].offset);
+	for (i = 0; i < ARRAY_SIZE(stats_caches); ++i) {
+		*(long *) (dst + stats_caches[i].hits) +=
+			*(long *) (src + stats_caches[i].hits);
+		*(long *) (dst + stats_caches[i].misses) +=
+			*(long *) (src + stats_caches[i].misses);
+	}
+	for (i = 0; i < ARRAY_SIZE(stats_timers); ++i)
+		*(double *) (dst + stats_timers[i].offset) +=
+			*(double *) (src + stats_timers[i].offset);
+}
+
+/* A snapshot of the statistics of an isl_ctx.
+ * The snapshot is taken before the statistics are printed
+ * such that the printing itself does not affect them.
+ */
+struct isl_stats_snapshot {
+	unsigned long operations;
+	struct isl_memory_stats memory;
+	unsigned long n_hit;
+	unsigned long n_miss;
+	unsigned long n_val_hit;
+	unsigned long n_val_miss;
+	struct isl_stats stats;
+};
+
+/* Store a snapshot of the statistics of "ctx" in "snapshot".
+ */
+static void take_snapshot(isl_ctx *ctx, struct isl_stats_snapshot *snapshot)
+{
+	snapshot->operations = ctx->operations;
+	snapshot->memory = ctx->memory;
+	snapshot->n_hit = ctx->n_hit;
+	snapshot->n_miss = ctx->n_miss;
+	snapshot->n_val_hit = ctx->n_val_hit;
+	snapshot->n_val_miss = ctx->n_val_miss;
+	snapshot->stats = *ctx->stats;
+}
+
+/* Print "s" to "p" as a JSON string.
+ */
+static __isl_give isl_printer *print_json_str(__isl_take isl_printer *p,
+	const char *s)
+{
+	char buf[8];
+
+	p = isl_printer_print_str(p, "\"");
+	for (; *s; ++s) {
+		unsigned char c = *s;
+
+		if (c == '"' || c == '\\')
+			snprintf(buf, sizeof(buf), "\\%c", c);
+		else if (c < 0x20)
+			snprintf(buf, sizeof(buf), "\\u%04x", c);
+		else
+			snprintf(buf, sizeof(buf), "%c", c);
+		p = isl_printer_print_str(p, buf);
+	}
+	return isl_printer_print_str(p, "\"");
+}
+
+/* Print the key "key" of a JSON object to "p",
+ * preceded by a comma if "first" is not set.
+ */
+static __isl_give isl_printer *print_json_key(__isl_take isl_printer *p,
+	const char *key, int first)
+{
+	if (!first)
+		p = isl_printer_print_str(p, ", ");
+	p = print_json_str(p, key);
+	return isl_printer_print_str(p, ": ");
+}
+
+/* Print the key "key" with value "val" of a JSON object to "p",
+ * preceded by a comma if "first" is not set.
+ */
+static __isl_give isl_printer *print_json_ulong(__isl_take isl_printer *p,
+	const char *key, unsigned long val, int first)
+{
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "%lu", val);
+	p = print_json_key(p, key, first);
+	return isl_printer_print_str(p, buf);
+}
+
+/* Print the number of hits and misses of a cache to "p"
+ * as a JSON object, along with the hit rate, if it is defined.
+ */
+static __isl_give isl_printer *print_json_cache(__isl_take isl_printer *p,
+	const char *name, unsigned long hits, unsigned long misses, int first)
+{
+	p = print_json_key(p, name, first);
+	p = isl_printer_print_str(p, "{ ");
+	p = print_json_ulong(p, "hits", hits, 1);
+	p = print_json_ulong(p, "misses", misses, 0);
+	p = print_json_key(p, "hit_rate", 0);
+	if (hits + misses == 0)
+		p = isl_printer_print_str(p, "null");
+	else
+		p = isl_printer_print_double(p,
+					(double) hits / (hits + misses));
+	return isl_printer_print_str(p, " }");
+}
+
+/* Print "input" to "p" in hexadecimal notation as a JSON string.
+ */
+static __isl_give isl_printer *print_json_hex(__isl_take isl_printer *p,
+	const char *input)
+{
+	char buf[3];
+
+	p = isl_printer_print_str(p, "\"");
+	for (; *input; ++input) {
+		snprintf(buf, sizeof(buf), "%02x", (unsigned char) *input);
+		p = isl_printer_print_str(p, buf);
+	}
+	return isl_printer_print_str(p, "\"");
+}
+
+/* Print the record "record" of a call to isl_map_coalesce to "p"
+ * as a JSON object.
+ * The input is printed both in textual form and
+ * in binary format (in hexadecimal notation).
+ * The latter preserves the exact representation of the input
+ * and is therefore more suitable for replaying the call.
+ * The textual form is printed as null if the input
+ * cannot be read back.
+ */
+static __isl_give isl_printer *print_json_coalesce_record(
+	__isl_take isl_printer *p, struct isl_coalesce_record *record)
+{
+	isl_ctx *ctx = isl_printer_get_ctx(p);
+	isl_map *map;
+	char *text;
+
+	map = isl_map_read_from_binary_str(ctx, record->input);
+	text = isl_map_to_str(map);
+	isl_map_free(map);
+
+	p = isl_printer_print_str(p, "{ ");
+	p = print_json_key(p, "time", 1);
+	p = isl_printer_print_double(p, record->time);
+	p = print_json_ulong(p, "operations", record->operations, 0);
+	p = print_json_key(p, "input", 0);
+	if (text)
+		p = print_json_str(p, text);
+	else
+		p = isl_printer_print_str(p, "null");
+	p = print_json_key(p, "binary", 0);
+	p = print_json_hex(p, record->input);
+	p = isl_printer_print_str(p, " }");
+	free(text);
+
+	return p;
+}
+
+/* Print the statistics in "snapshot", along with the budget usage and
+ * the records of the most expensive calls to isl_map_coalesce in "ctx",
+ * to "p" as a single-line JSON object.
+ */
+static __isl_give isl_printer *print_stats_json(__isl_take isl_printer *p,
+	isl_ctx *ctx, struct isl_stats_snapshot *snapshot)
+{
+	struct isl_memory_stats *memory = &snapshot->memory;
+	char *stats = (char *) &snapshot->stats;
+	struct isl_budget_usage *usage;
+	int i;
+
+	p = isl_printer_print_str(p, "{ ");
+	p = print_json_ulong(p, "operations", snapshot->operations, 1);
+
+	p = print_json_key(p, "memory", 0);
+	p = isl_printer_print_str(p, "{ ");
+	p = print_json_ulong(p, "allocations", memory->n_alloc, 1);
+	p = print_json_ulong(p, "reallocations", memory->n_realloc, 0);
+	p = print_json_ulong(p, "bytes", memory->bytes, 0);
+	p = print_json_ulong(p, "largest_allocation",
+				memory->max_request, 0);
+	p = isl_printer_print_str(p, " }");
+
+	p = print_json_key(p, "counters", 0);
+	p = isl_printer_print_str(p, "{ ");
+	for (i = 0; i < ARRAY_SIZE(stats_counters); ++i)
+		p = print_json_ulong(p, stats_counters[i].name,
+			*(long *) (stats + stats_counters[i].offset), i == 0);
+	p = isl_printer_print_str(p, " }");
+
+	p = print_json_key(p, "timers", 0);
+	p = isl_printer_print_str(p, "{ ");
+	for (i = 0; i < ARRAY_SIZE(stats_timers); ++i) {
+		p = print_json_key(p, stats_timers[i].name, i == 0);
+		p = isl_printer_print_double(p,
+			*(double *) (stats + stats_timers[i].offset));
+	}
+	p = isl_printer_print_str(p, " }");
+
+	p = print_json_key(p, "caches", 0);
+	p = isl_printer_print_str(p, "{ ");
+	p = print_json_cache(p, "block", snapshot->n_hit, snapshot->n_miss, 1);
+	p = print_json_cache(p, "val", snapshot->n_val_hit,
+				snapshot->n_val_miss, 0);
+	for (i = 0; i < ARRAY_SIZE(stats_caches); ++i)
+		p = print_json_cache(p, stats_caches[i].name,
+			*(long *) (stats + stats_caches[i].hits),
+			*(long *) (stats + stats_caches[i].misses), 0);
+	p = isl_printer_print_str(p, " }");
+
+	p = print_json_key(p, "budgets", 0);
+	p = isl_printer_print_str(p, "{ ");
+	for (usage = ctx->budget_usage; usage; usage = usage->next)
+		p = print_json_ulong(p, usage->name, usage->operations,
+					usage == ctx->budget_usage);
+	p = isl_printer_print_str(p, " }");
+
+	p = print_json_key(p, "top_coalesce", 0);
+	p = isl_printer_print_str(p, "[ ");
+	for (i = 0; i < ctx->n_top_coalesce; ++i) {
+		if (i)
+			p = isl_printer_print_str(p, ", ");
+		p = print_json_coalesce_record(p, &ctx->top_coalesce[i]);
+	}
+	p = isl_printer_print_str(p, " ]");
+
+	return isl_printer_print_str(p, " }");
+}
+
+/* Return the statistics of "ctx" as a single-line JSON object.
+ * The statistics that are only collected if the "time_stats" option
+ * is set are reported as zero if this option is not set.
+ * Similarly, the list of most expensive calls to isl_map_coalesce
+ * is empty unless the "stats_top_coalesce" option is set.
+ */
+__isl_give char *isl_ctx_stats_to_json_str(isl_ctx *ctx)
+{
+	struct isl_stats_snapshot snapshot;
+	isl_printer *p;
+	char *s;
+
+	if (!ctx)
+		return NULL;
+
+	take_snapshot(ctx, &snapshot);
+	p = isl_printer_to_str(ctx);
+	p = print_stats_json(p, ctx, &snapshot);
+	s = isl_printer_get_str(p);
+	isl_printer_free(p);
+
+	return s;
+}
+
+/* Print the statistics of "ctx" to "out" as a single-line JSON object,
+ * followed by a newline.
+ */
+isl_stat isl_ctx_print_stats_json(isl_ctx *ctx, FILE *out)
+{
+	struct isl_stats_snapshot snapshot;
+	isl_printer *p;
+	isl_stat r;
+
+	if (!ctx)
+		return isl_stat_error;
+
+	take_snapshot(ctx, &snapshot);
+	p = isl_printer_to_file(ctx, out);
+	p = print_stats_json(p, ctx, &snapshot);
+	p = isl_printer_print_str(p, "\n");
+	r = isl_stat_non_null(p);
+	isl_printer_free(p);
+
+	return r;
+}
+
+/* Append the statistics of "ctx" in JSON format to the file
+ * specified by the "stats_json" option, where "-" refers
+ * to the standard error stream.
+ */
+static void export_stats_json(isl_ctx *ctx)
+{
+	const char *name = ctx->opt->stats_json;
+	FILE *out;
+
+	if (!strcmp(name, "-")) {
+		isl_ctx_print_stats_json(ctx, stderr);
+		return;
+	}
+	out = fopen(name, "a");
+	if (!out)
+		isl_die(ctx, isl_error_unknown,
+			"unable to open statistics file", return);
+	isl_ctx_print_stats_json(ctx, out);
+	fclose(out);
+}
+
+/* Store a snapshot of the statistics of "ctx" in "stats".
+ */
+isl_stat isl_ctx_get_stats(isl_ctx *ctx, struct isl_stats *stats)
+{
+	if (!ctx)
+		return isl_stat_error;
+	if (!stats)
+		isl_die(ctx, isl_error_invalid, "no statistics buffer",
+			return isl_stat_error);
+	*stats = *ctx->stats;
+	return isl_stat_ok;
+}
+
+/* Reset all statistics of "ctx" to zero.
+ */
+void isl_ctx_reset_stats(isl_ctx *ctx)
+{
+	if (!ctx)
+		return;
+	memset(ctx->stats, 0, sizeof(*ctx->stats));
+	clear_coalesce_records(ctx);
+}
+
+/* Record the start of an instrumented operation in "ctx".
+ * That is, increment "counter" and, if the "time_stats" option is set,
+ * return the current processor time.
+ * Otherwise, return (clock_t) -1.
+ */
+clock_t isl_ctx_stats_enter(isl_ctx *ctx, long *counter)
+{
+	(*counter)++;
+	if (!ctx->opt->time_stats)
+		return (clock_t) -1;
+	return clock();
+}
+
+/* Record the end of an instrumented operation that was started
+ * at processor time "start" by adding the elapsed time (in seconds)
+ * to "timer".
+ * If "start" is (clock_t) -1, then no time was recorded
+ * at the start of the operation.
+ */
+void isl_ctx_stats_leave(double *timer, clock_t start)
+{
+	if (start == (clock_t) -1)
+		return;
+	*timer += (double) (clock() - start) / CLOCKS_PER_SEC;
 }
 
 void isl_ctx_free(struct isl_ctx *ctx)
 {
 	if (!ctx)
 		return;
+	isl_ctx_clear_sample_cache(ctx);
+	isl_ctx_clear_flow_cache(ctx);
+	isl_ctx_clear_lexopt_cache(ctx);
+	isl_ctx_clear_canonical_params(ctx);
 	if (ctx->ref != 0)
 		isl_die(ctx, isl_error_invalid,
 			"isl_ctx not freed as some objects still reference it",
@@ -296,9 +1050,18 @@ void isl_ctx_free(struct isl_ctx *ctx)
 
 	if (ctx->opt->print_stats)
 		print_stats(ctx);
+	if (ctx->opt->stats_json)
+		export_stats_json(ctx);
+	clear_coalesce_records(ctx);
+
+	while (ctx->budget)
+		isl_ctx_pop_budget(ctx);
+	clear_budget_usage(ctx);
 
 	isl_hash_table_clear(&ctx->id_table);
+	isl_hash_table_clear(&ctx->space_table);
 	isl_blk_clear_cache(ctx);
+	isl_val_clear_cache(ctx);
 	isl_int_clear(ctx->zero);
 	isl_int_clear(ctx->one);
 	isl_int_clear(ctx->two);
@@ -307,6 +1070,8 @@ void isl_ctx_free(struct isl_ctx *ctx)
 	isl_args_free(ctx->user_args, ctx->user_opt);
 	if (ctx->opt_allocated)
 		isl_options_free(ctx->opt);
+	if (ctx->parent)
+		isl_ctx_deref(ctx->parent);
 	free(ctx->stats);
 	free(ctx);
 }
@@ -380,6 +1145,10 @@ int isl_ctx_parse_options(isl_ctx *ctx, int argc, char **argv, unsigned flags)
 {
 	if (!ctx)
 		return -1;
+	if (ctx->parent)
+		isl_die(ctx, isl_error_invalid,
+			"options of child context cannot be parsed",
+			return -1);
 	return isl_args_parse(ctx->user_args, argc, argv, ctx->user_opt, flags);
 }
 
@@ -399,11 +1168,333 @@ unsigned long isl_ctx_get_max_operations(isl_ctx *ctx)
 	return ctx ? ctx->max_operations : 0;
 }
 
-/* Reset the number of operations performed by "ctx".
+/* Return the number of operations performed by "ctx"
+ * since it was created or since the last call
+ * to isl_ctx_reset_operations.
+ */
+unsigned long isl_ctx_get_operations(isl_ctx *ctx)
+{
+	return ctx ? ctx->operations : 0;
+}
+
+/* Enter a scope in which the isl_int blocks that get freed
+ * are kept around for reuse by later allocations within the scope,
+ * irrespective of the size limits of the block cache.
+ * Scopes may be nested.
+ */
+isl_stat isl_ctx_push_arena(isl_ctx *ctx)
+{
+	if (!ctx)
+		return isl_stat_error;
+	ctx->arena_depth++;
+	return isl_stat_ok;
+}
+
+/* Leave the innermost scope entered by isl_ctx_push_arena.
+ * If this was the outermost scope, then release all blocks
+ * that were kept around because of the scopes in one go.
+ * Objects that are still alive are not affected.
+ */
+isl_stat isl_ctx_pop_arena(isl_ctx *ctx)
+{
+	if (!ctx)
+		return isl_stat_error;
+	if (ctx->arena_depth <= 0)
+		isl_die(ctx, isl_error_invalid, "no arena scope to pop",
+			return isl_stat_error);
+	if (--ctx->arena_depth == 0)
+		isl_blk_clear_arena(ctx);
+	return isl_stat_ok;
+}
+
+/* Release the memory that "ctx" keeps around for later reuse or
+ * for speeding up later computations, without affecting
+ * the objects that are still alive.
+ * In particular, clear the sample, dataflow analysis and
+ * lexicographic optimization caches, free the blocks of integers and
+ * the isl_val objects that are kept around for reuse,
+ * including those kept around because of an active arena scope, and
+ * shrink the tables of identifiers and interned spaces
+ * to fit their current contents.
+ */
+isl_stat isl_ctx_trim_memory(isl_ctx *ctx)
+{
+	if (!ctx)
+		return isl_stat_error;
+
+	isl_ctx_clear_sample_cache(ctx);
+	isl_ctx_clear_flow_cache(ctx);
+	isl_ctx_clear_lexopt_cache(ctx);
+	isl_blk_clear_cache(ctx);
+	isl_val_clear_cache(ctx);
+	if (isl_hash_table_shrink(ctx, &ctx->id_table) < 0 ||
+	    isl_hash_table_shrink(ctx, &ctx->space_table) < 0)
+		return isl_stat_error;
+
+	return isl_stat_ok;
+}
+
+/* Set the functions that are called whenever an operation scope
+ * is entered or left in "ctx" to "enter" and "leave".
+ * Each of them is called with the name of the scope and "user".
+ * Either function may be NULL.
+ * This allows external profilers to attribute the time spent
+ * in isl to the high-level operation that is being performed.
+ */
+isl_stat isl_ctx_set_scope_hooks(isl_ctx *ctx,
+	void (*enter)(isl_ctx *ctx, const char *name, void *user),
+	void (*leave)(isl_ctx *ctx, const char *name, void *user),
+	void *user)
+{
+	if (!ctx)
+		return isl_stat_error;
+	ctx->scope_enter = enter;
+	ctx->scope_leave = leave;
+	ctx->scope_user = user;
+	return isl_stat_ok;
+}
+
+/* Return the number of operation scopes that are currently active in "ctx".
+ */
+int isl_ctx_get_scope_depth(isl_ctx *ctx)
+{
+	return ctx ? ctx->scope_depth : -1;
+}
+
+/* Return the name of the active operation scope at nesting level "pos"
+ * in "ctx", where level 0 is the outermost scope.
+ * Return NULL if there is no such scope or if its name is not kept
+ * because it is nested too deeply.
+ */
+const char *isl_ctx_get_scope_name(isl_ctx *ctx, int pos)
+{
+	if (!ctx)
+		return NULL;
+	if (pos < 0 || pos >= ctx->scope_depth || pos >= ISL_SCOPE_MAX_DEPTH)
+		return NULL;
+	return ctx->scope[pos];
+}
+
+/* Stop reporting errors in "ctx", independently of the on_error option,
+ * until the matching call to isl_ctx_quiet_leave.
+ * The errors are still recorded in "ctx".
+ * Since this only affects "ctx" itself, it may be used
+ * in a child context while other child contexts of the same parent
+ * are being used in other threads.
+ */
+void isl_ctx_quiet_enter(isl_ctx *ctx)
+{
+	if (!ctx)
+		return;
+	ctx->quiet++;
+}
+
+/* Undo the effect of the matching call to isl_ctx_quiet_enter.
+ */
+void isl_ctx_quiet_leave(isl_ctx *ctx)
+{
+	if (!ctx || ctx->quiet <= 0)
+		return;
+	ctx->quiet--;
+}
+
+/* Enter an operation scope called "name" in "ctx".
+ * "name" is assumed to be a statically allocated string.
+ * Every call needs to be matched by a call to isl_ctx_scope_leave.
+ */
+void isl_ctx_scope_enter(isl_ctx *ctx, const char *name)
+{
+	if (!ctx)
+		return;
+	if (ctx->scope_depth < ISL_SCOPE_MAX_DEPTH)
+		ctx->scope[ctx->scope_depth] = name;
+	ctx->scope_depth++;
+	if (ctx->scope_enter)
+		ctx->scope_enter(ctx, name, ctx->scope_user);
+}
+
+/* Leave the innermost operation scope of "ctx".
+ * The name passed to the "scope_leave" hook is NULL
+ * if the scope was nested too deeply for its name to be kept.
+ */
+void isl_ctx_scope_leave(isl_ctx *ctx)
+{
+	const char *name = NULL;
+
+	if (!ctx || ctx->scope_depth <= 0)
+		return;
+	ctx->scope_depth--;
+	if (ctx->scope_depth < ISL_SCOPE_MAX_DEPTH)
+		name = ctx->scope[ctx->scope_depth];
+	if (ctx->scope_leave)
+		ctx->scope_leave(ctx, name, ctx->scope_user);
+}
+
+/* Enter a budget scope called "name" that allows at most "max_operations"
+ * operations to be performed before it is left again.
+ * A bound of zero means that no bound is imposed,
+ * but the operations are still recorded.
+ * Scopes may be nested.  The operations performed inside a nested scope
+ * are also charged to the enclosing scopes.
+ */
+isl_stat isl_ctx_push_budget(isl_ctx *ctx, const char *name,
+	unsigned long max_operations)
+{
+	struct isl_budget *budget;
+
+	if (!ctx)
+		return isl_stat_error;
+	if (!name)
+		isl_die(ctx, isl_error_invalid, "budget scope needs a name",
+			return isl_stat_error);
+	budget = isl_calloc_type(ctx, struct isl_budget);
+	if (!budget)
+		return isl_stat_error;
+	budget->name = strdup(name);
+	if (!budget->name) {
+		free(budget);
+		isl_die(ctx, isl_error_alloc, "allocation failure",
+			return isl_stat_error);
+	}
+	budget->max_operations = max_operations;
+	budget->outer = ctx->budget;
+	ctx->budget = budget;
+	return isl_stat_ok;
+}
+
+/* Add "operations" to the number of operations recorded
+ * for the budget scopes called "name" that have been left.
+ */
+static isl_stat add_budget_usage(isl_ctx *ctx, const char *name,
+	unsigned long operations)
+{
+	struct isl_budget_usage *usage;
+
+	for (usage = ctx->budget_usage; usage; usage = usage->next) {
+		if (strcmp(usage->name, name))
+			continue;
+		usage->operations += operations;
+		return isl_stat_ok;
+	}
+
+	usage = isl_calloc_type(ctx, struct isl_budget_usage);
+	if (!usage)
+		return isl_stat_error;
+	usage->name = strdup(name);
+	if (!usage->name) {
+		free(usage);
+		isl_die(ctx, isl_error_alloc, "allocation failure",
+			return isl_stat_error);
+	}
+	usage->operations = operations;
+	usage->next = ctx->budget_usage;
+	ctx->budget_usage = usage;
+	return isl_stat_ok;
+}
+
+/* Leave the innermost budget scope entered by isl_ctx_push_budget,
+ * recording the number of operations that were performed inside the scope.
+ * The budget of the scope no longer applies after it has been left,
+ * so the enclosing computation can continue, even if
+ * the budget of the scope was exhausted.
+ */
+isl_stat isl_ctx_pop_budget(isl_ctx *ctx)
+{
+	struct isl_budget *budget;
+	isl_stat r;
+
+	if (!ctx)
+		return isl_stat_error;
+	budget = ctx->budget;
+	if (!budget)
+		isl_die(ctx, isl_error_invalid, "no budget scope to pop",
+			return isl_stat_error);
+	ctx->budget = budget->outer;
+	r = add_budget_usage(ctx, budget->name, budget->operations);
+	free(budget->name);
+	free(budget);
+	return r;
+}
+
+/* Return the number of operations performed in budget scopes
+ * called "name", including those that are still active.
+ */
+unsigned long isl_ctx_get_budget_operations(isl_ctx *ctx, const char *name)
+{
+	struct isl_budget *budget;
+	struct isl_budget_usage *usage;
+	unsigned long operations = 0;
+
+	if (!ctx || !name)
+		return 0;
+	for (usage = ctx->budget_usage; usage; usage = usage->next)
+		if (!strcmp(usage->name, name))
+			operations += usage->operations;
+	for (budget = ctx->budget; budget; budget = budget->outer)
+		if (!strcmp(budget->name, name))
+			operations += budget->operations;
+	return operations;
+}
+
+/* Reset the number of operations performed by "ctx",
+ * including the number of operations recorded for the budget scopes.
  */
 void isl_ctx_reset_operations(isl_ctx *ctx)
 {
+	struct isl_budget *budget;
+
 	if (!ctx)
 		return;
 	ctx->operations = 0;
+	for (budget = ctx->budget; budget; budget = budget->outer)
+		budget->operations = 0;
+	clear_budget_usage(ctx);
+}
+
+/* Store a snapshot of the memory statistics of "ctx" in "stats".
+ */
+isl_stat isl_ctx_get_memory_stats(isl_ctx *ctx,
+	struct isl_memory_stats *stats)
+{
+	if (!ctx)
+		return isl_stat_error;
+	if (!stats)
+		isl_die(ctx, isl_error_invalid, "no statistics to fill in",
+			return isl_stat_error);
+	*stats = ctx->memory;
+	return isl_stat_ok;
+}
+
+/* Set the maximal total number of bytes that may be requested
+ * through "ctx", until the next call to isl_ctx_reset_memory,
+ * to "max_allocated_bytes".
+ * This includes the bytes of allocations that have been freed again.
+ * A value of zero means that no bound is imposed.
+ */
+void isl_ctx_set_max_allocated_bytes(isl_ctx *ctx,
+	size_t max_allocated_bytes)
+{
+	if (!ctx)
+		return;
+	ctx->max_allocated_bytes = max_allocated_bytes;
+}
+
+/* Return the maximal total number of bytes that may be requested
+ * through "ctx".
+ */
+size_t isl_ctx_get_max_allocated_bytes(isl_ctx *ctx)
+{
+	return ctx ? ctx->max_allocated_bytes : 0;
+}
+
+/* Reset the memory statistics of "ctx".
+ * Since the bound on the amount of memory applies to the number
+ * of bytes requested since the last reset, this also allows
+ * further allocations after the bound has been reached.
+ */
+void isl_ctx_reset_memory(isl_ctx *ctx)
+{
+	if (!ctx)
+		return;
+	memset(&ctx->memory, 0, sizeof(ctx->memory));
 }
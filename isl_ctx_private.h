@@ -1,8 +1,95 @@
+#include <time.h>
 #include <isl/ctx.h>
 #include <isl_blk.h>
 
-/* "error" stores the last error that has occurred.
+/* The maximal number of freed isl_val objects that are kept for reuse.
+ */
+#define ISL_VAL_CACHE_SIZE	64
+
+/* The maximal number of nested operation scopes for which
+ * the names are kept.
+ */
+#define ISL_SCOPE_MAX_DEPTH	16
+
+/* A named budget scope "name" that allows at most "max_operations"
+ * operations (or any number of operations if "max_operations" is zero),
+ * "operations" of which have been performed so far.
+ * "outer" is the enclosing budget scope, if any.
+ */
+struct isl_budget {
+	char			*name;
+	unsigned long		operations;
+	unsigned long		max_operations;
+	struct isl_budget	*outer;
+};
+
+/* The total number of operations "operations" performed
+ * in the budget scopes called "name" that have been left.
+ */
+struct isl_budget_usage {
+	char			*name;
+	unsigned long		operations;
+	struct isl_budget_usage	*next;
+};
+
+/* A record of a call to isl_map_coalesce that took "time" seconds
+ * of processor time and performed "operations" operations.
+ * "input" is the input of the call in binary format.
+ */
+struct isl_coalesce_record {
+	double			time;
+	unsigned long		operations;
+	char			*input;
+};
+
+/* "parent" is the context whose options are shared by this context
+ * if it was allocated using isl_ctx_alloc_child and NULL otherwise.
+ *
+ * "cache" keeps track of blocks of isl_int values that have been freed
+ * and that may be reused by a subsequent allocation.
+ * The cached blocks are grouped in size classes (see isl_blk.c).
+ * "n_cached" contains the number of cached blocks in each size class.
+ * "n_hit" and "n_miss" count the number of allocations that
+ * could and could not be served from the cache.
+ * "arena_depth" is the number of active isl_ctx_push_arena scopes.
+ * While it is positive, blocks that do not fit in "cache" are kept
+ * in the dynamically sized "arena" instead of being freed.
+ * "n_arena" and "size_arena" contain the number of blocks in "arena"
+ * and the number of allocated elements in each size class.
+ *
+ * "val_cache" keeps track of "n_val_cached" isl_val objects
+ * that have been freed and that may be reused by a subsequent allocation.
+ * Their numerators and denominators remain initialized.
+ * "n_val_hit" and "n_val_miss" count the number of isl_val allocations
+ * that could and could not be served from the cache.
+ *
+ * "memory" keeps track of the memory requested through
+ * isl_malloc_or_die, isl_calloc_or_die and isl_realloc_or_die.
+ * "max_allocated_bytes" is the maximal number of bytes that may be requested
+ * in total since the last reset of "memory", including those of allocations
+ * that have been freed again (or zero if there is no such bound).
+ * If set, "alloc_malloc", "alloc_calloc" and "alloc_realloc" are called
+ * with argument "alloc_user" by these functions instead of
+ * the corresponding functions of the C library.
+ *
+ * "scope_depth" is the number of operation scopes that are currently
+ * active and "scope" contains the names of the outermost
+ * ISL_SCOPE_MAX_DEPTH of them.
+ * "scope_enter" and "scope_leave" are called with argument "scope_user"
+ * whenever a scope is entered or left, if they are set.
+ *
+ * "top_coalesce" contains the "n_top_coalesce" most expensive calls
+ * to isl_map_coalesce, in decreasing order of cost,
+ * as requested by the "stats_top_coalesce" option.
+ * It has room for "size_top_coalesce" records.
+ *
+ * "error" stores the last error that has occurred.
  * It is reset to isl_error_none by isl_ctx_reset_error.
+ * "quiet" is the number of active calls to isl_ctx_quiet_enter
+ * that have not been matched by a call to isl_ctx_quiet_leave yet.
+ * As long as it is positive, errors are only recorded in "ctx",
+ * independently of the on_error option.  Unlike this option,
+ * which is shared by all child contexts, "quiet" is specific to "ctx".
  * "error_msg" stores the error message of the last error,
  * while "error_file" and "error_line" specify where the last error occurred.
  * "error_msg" and "error_file" always point to statically allocated
@@ -11,6 +98,8 @@
 struct isl_ctx {
 	int			ref;
 
+	struct isl_ctx		*parent;
+
 	struct isl_stats	*stats;
 
 	int			 opt_allocated;
@@ -25,10 +114,20 @@ struct isl_ctx {
 
 	isl_int			normalize_gcd;
 
-	int			n_cached;
-	int			n_miss;
-	struct isl_blk		cache[ISL_BLK_CACHE_SIZE];
+	int			n_cached[ISL_BLK_N_CLASS];
+	unsigned long		n_hit;
+	unsigned long		n_miss;
+	struct isl_blk		cache[ISL_BLK_N_CLASS][ISL_BLK_CLASS_CACHE_SIZE];
+	int			arena_depth;
+	int			n_arena[ISL_BLK_N_CLASS];
+	int			size_arena[ISL_BLK_N_CLASS];
+	struct isl_blk		*arena[ISL_BLK_N_CLASS];
+	int			n_val_cached;
+	unsigned long		n_val_hit;
+	unsigned long		n_val_miss;
+	struct isl_val		*val_cache[ISL_VAL_CACHE_SIZE];
 	struct isl_hash_table	id_table;
+	struct isl_hash_table	space_table;
 
 	enum isl_error		error;
 	const char		*error_msg;
@@ -36,12 +135,61 @@ struct isl_ctx {
 	int			error_line;
 
 	int			abort;
+	int			quiet;
 
 	unsigned long		operations;
 	unsigned long		max_operations;
+
+	struct isl_memory_stats	memory;
+	size_t			max_allocated_bytes;
+	void			*(*alloc_malloc)(size_t size, void *user);
+	void			*(*alloc_calloc)(size_t nmemb, size_t size,
+					void *user);
+	void			*(*alloc_realloc)(void *ptr, size_t size,
+					void *user);
+	void			*alloc_user;
+
+	struct isl_budget	*budget;
+	struct isl_budget_usage	*budget_usage;
+
+	int			n_top_coalesce;
+	int			size_top_coalesce;
+	struct isl_coalesce_record	*top_coalesce;
+
+	int			scope_depth;
+	const char		*scope[ISL_SCOPE_MAX_DEPTH];
+	void			(*scope_enter)(isl_ctx *ctx, const char *name,
+					void *user);
+	void			(*scope_leave)(isl_ctx *ctx, const char *name,
+					void *user);
+	void			*scope_user;
+
+	struct isl_sample_cache	*sample_cache;
+	struct isl_flow_cache	*flow_cache;
+	struct isl_lexopt_cache	*lexopt_cache;
+
+	struct isl_space	*canonical_params;
 };
 
+void isl_ctx_clear_flow_cache(isl_ctx *ctx);
+void isl_ctx_clear_lexopt_cache(isl_ctx *ctx);
+void isl_ctx_clear_canonical_params(isl_ctx *ctx);
+void isl_val_clear_cache(isl_ctx *ctx);
+
 int isl_ctx_next_operation(isl_ctx *ctx);
 
+clock_t isl_ctx_stats_enter(isl_ctx *ctx, long *counter);
+void isl_ctx_add_stats(isl_ctx *ctx, isl_ctx *child);
+void isl_ctx_stats_leave(double *timer, clock_t start);
+
+void isl_ctx_record_coalesce(isl_ctx *ctx, char *input, double time,
+	unsigned long operations);
+
+void isl_ctx_scope_enter(isl_ctx *ctx, const char *name);
+void isl_ctx_scope_leave(isl_ctx *ctx);
+
+void isl_ctx_quiet_enter(isl_ctx *ctx);
+void isl_ctx_quiet_leave(isl_ctx *ctx);
+
 void isl_ctx_set_full_error(isl_ctx *ctx, enum isl_error error, const char *msg,
 	const char *file, int line);
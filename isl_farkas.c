@@ -221,6 +221,84 @@ static __isl_give isl_basic_set *rational_universe(__isl_take isl_space *space)
 	return bset;
 }
 
+/* Return the number of constraints that would be added
+ * by eliminating variable "pos" of "bset" using Fourier-Motzkin
+ * minus the number of constraints that would be removed.
+ * If the variable appears in an equality, then no constraints
+ * are added and the variable can be eliminated using that equality.
+ * Set *involved to whether the variable appears in any constraint.
+ */
+static int elimination_cost(__isl_keep isl_basic_set *bset, int pos,
+	int *involved)
+{
+	int i;
+	int n_lower = 0, n_upper = 0;
+
+	*involved = 1;
+	for (i = 0; i < bset->n_eq; ++i)
+		if (!isl_int_is_zero(bset->eq[i][1 + pos]))
+			return -bset->n_ineq - 1;
+	for (i = 0; i < bset->n_ineq; ++i) {
+		if (isl_int_is_pos(bset->ineq[i][1 + pos]))
+			n_lower++;
+		else if (isl_int_is_neg(bset->ineq[i][1 + pos]))
+			n_upper++;
+	}
+	*involved = n_lower + n_upper > 0;
+
+	return n_lower * n_upper - n_lower - n_upper;
+}
+
+/* Eliminate the local variables of "bset", which are assumed
+ * not to have an explicit representation, using Fourier-Motzkin
+ * and then remove them.
+ *
+ * isl_basic_set_remove_divs eliminates the local variables
+ * in a fixed order.  For the large number of multipliers introduced
+ * by farkas, this order may result in a blow-up of the number
+ * of intermediate constraints, even though redundant constraints
+ * are removed after each elimination step.
+ * Instead, eliminate the local variables one by one,
+ * each time picking one that appears in an equality, if any,
+ * and otherwise one that results in the smallest number
+ * of additional constraints.
+ * The local variables that have been eliminated no longer appear
+ * in any constraint, so isl_basic_set_remove_divs only needs
+ * to remove them.
+ */
+static __isl_give isl_basic_set *eliminate_multipliers(
+	__isl_take isl_basic_set *bset)
+{
+	isl_size v_div;
+
+	v_div = isl_basic_set_var_offset(bset, isl_dim_div);
+	if (v_div < 0)
+		return isl_basic_set_free(bset);
+
+	while (bset && !ISL_F_ISSET(bset, ISL_BASIC_SET_EMPTY)) {
+		int i;
+		int best = -1;
+		int best_cost = 0;
+
+		for (i = 0; i < bset->n_div; ++i) {
+			int cost, involved;
+
+			cost = elimination_cost(bset, v_div + i, &involved);
+			if (!involved)
+				continue;
+			if (best >= 0 && cost >= best_cost)
+				continue;
+			best = i;
+			best_cost = cost;
+		}
+		if (best < 0)
+			break;
+		bset = isl_basic_set_eliminate_vars(bset, v_div + best, 1);
+	}
+
+	return isl_basic_set_remove_divs(bset);
+}
+
 /* Compute the dual of "bset" by applying Farkas' lemma.
  * As explained above, we add an extra dimension to represent
  * the coefficient of the constant term when going from solutions
@@ -302,7 +380,7 @@ static __isl_give isl_basic_set *farkas(__isl_take isl_basic_set *bset,
 				    bset->ineq[j][0]);
 	}
 
-	dual = isl_basic_set_remove_divs(dual);
+	dual = eliminate_multipliers(dual);
 	dual = isl_basic_set_simplify(dual);
 	dual = isl_basic_set_finalize(dual);
 
@@ -16,6 +16,7 @@
  * and Ecole Normale Superieure, 45 rue d'Ulm, 75230 Paris, France
  */
 
+#include <isl_ctx_private.h>
 #include <isl/val.h>
 #include <isl/space.h>
 #include <isl/set.h>
@@ -23,9 +24,12 @@
 #include <isl/union_set.h>
 #include <isl/union_map.h>
 #include <isl/flow.h>
+#include <isl/options.h>
+#include <isl/hash.h>
 #include <isl/schedule_node.h>
 #include <isl_sort.h>
 #include <isl/stream.h>
+#include "isl_task.h"
 
 enum isl_restriction_type {
 	isl_restriction_type_empty,
@@ -1321,8 +1325,7 @@ error:
  * space.  However, these extra dimensions are not projected out again.
  * It is up to the caller to decide whether these dimensions should be kept.
  */
-static __isl_give isl_flow *access_info_compute_flow_core(
-	__isl_take isl_access_info *acc)
+static __isl_give isl_flow *compute_flow_core(__isl_take isl_access_info *acc)
 {
 	struct isl_flow *res = NULL;
 
@@ -1351,6 +1354,28 @@ error:
 	return NULL;
 }
 
+/* Perform the dataflow analysis of compute_flow_core on "acc",
+ * keeping track of the number of calls and the time spent
+ * in the statistics of the isl_ctx.
+ */
+static __isl_give isl_flow *access_info_compute_flow_core(
+	__isl_take isl_access_info *acc)
+{
+	isl_ctx *ctx;
+	clock_t start;
+	isl_flow *res;
+
+	if (!acc)
+		return NULL;
+
+	ctx = isl_map_get_ctx(acc->sink.map);
+	start = isl_ctx_stats_enter(ctx, &ctx->stats->flow_computations);
+	res = compute_flow_core(acc);
+	isl_ctx_stats_leave(&ctx->stats->flow_time, start);
+
+	return res;
+}
+
 /* Given a "sink" access, a list of n "source" accesses,
  * compute for each iteration of the sink access
  * and for each element accessed by that iteration,
@@ -1499,12 +1524,17 @@ enum isl_access_type {
  *
  * After a call to isl_union_access_info_introduce_schedule,
  * the "schedule_map" field no longer contains useful information.
+ *
+ * If "approximate" is set, then only memory based dependences
+ * are computed (see isl_union_access_info_set_approximate).
  */
 struct isl_union_access_info {
 	isl_union_map *access[isl_access_end];
 
 	isl_schedule *schedule;
 	isl_union_map *schedule_map;
+
+	int approximate;
 };
 
 /* Free "access" and return NULL.
@@ -1742,6 +1772,27 @@ error:
 	return NULL;
 }
 
+/* Set whether only an approximation of the dataflow should be computed
+ * for "access".
+ * In particular, if "approximate" is set, then all sources are
+ * treated as may-sources and the kills are ignored.
+ * This means that only memory based dependences are computed,
+ * which is much cheaper than computing the last (definite) source
+ * of each sink.  The resulting may-dependences are a superset of
+ * those that would be computed in exact mode, while there are
+ * no must-dependences.
+ */
+__isl_give isl_union_access_info *isl_union_access_info_set_approximate(
+	__isl_take isl_union_access_info *access, int approximate)
+{
+	if (!access)
+		return NULL;
+
+	access->approximate = approximate;
+
+	return access;
+}
+
 __isl_give isl_union_access_info *isl_union_access_info_copy(
 	__isl_keep isl_union_access_info *access)
 {
@@ -1761,6 +1812,8 @@ __isl_give isl_union_access_info *isl_union_access_info_copy(
 	else
 		copy = isl_union_access_info_set_schedule_map(copy,
 				isl_union_map_copy(access->schedule_map));
+	copy = isl_union_access_info_set_approximate(copy,
+						access->approximate);
 
 	return copy;
 }
@@ -2284,6 +2337,66 @@ __isl_give isl_union_flow *isl_union_flow_copy(__isl_keep isl_union_flow *flow)
 	return copy;
 }
 
+/* Return a copy of "flow" in "ctx", which may be different
+ * from the isl_ctx of "flow".
+ * "flow" itself is only read.
+ */
+static __isl_give isl_union_flow *isl_union_flow_copy_to_ctx(
+	__isl_keep isl_union_flow *flow, isl_ctx *ctx)
+{
+	isl_union_flow *copy;
+
+	if (!flow)
+		return NULL;
+
+	copy = isl_alloc_type(ctx, isl_union_flow);
+	if (!copy)
+		return NULL;
+
+	copy->must_dep = isl_union_map_copy_to_ctx(flow->must_dep, ctx);
+	copy->may_dep = isl_union_map_copy_to_ctx(flow->may_dep, ctx);
+	copy->must_no_source = isl_union_map_copy_to_ctx(flow->must_no_source,
+							ctx);
+	copy->may_no_source = isl_union_map_copy_to_ctx(flow->may_no_source,
+							ctx);
+
+	if (!copy->must_dep || !copy->may_dep ||
+	    !copy->must_no_source || !copy->may_no_source)
+		return isl_union_flow_free(copy);
+
+	return copy;
+}
+
+/* Add the dependence relations and sink subsets of "part" to
+ * those of "flow".
+ */
+static __isl_give isl_union_flow *isl_union_flow_add(
+	__isl_take isl_union_flow *flow, __isl_take isl_union_flow *part)
+{
+	if (!flow || !part)
+		goto error;
+
+	flow->must_dep = isl_union_map_union(flow->must_dep,
+		isl_union_map_copy(part->must_dep));
+	flow->may_dep = isl_union_map_union(flow->may_dep,
+		isl_union_map_copy(part->may_dep));
+	flow->must_no_source = isl_union_map_union(flow->must_no_source,
+		isl_union_map_copy(part->must_no_source));
+	flow->may_no_source = isl_union_map_union(flow->may_no_source,
+		isl_union_map_copy(part->may_no_source));
+	isl_union_flow_free(part);
+
+	if (!flow->must_dep || !flow->may_dep ||
+	    !flow->must_no_source || !flow->may_no_source)
+		return isl_union_flow_free(flow);
+
+	return flow;
+error:
+	isl_union_flow_free(flow);
+	isl_union_flow_free(part);
+	return NULL;
+}
+
 /* Drop the schedule dimensions from the iteration domains in "flow".
  * In particular, the schedule dimensions have been prepended
  * to the iteration domains prior to the dependence analysis by
@@ -2640,6 +2753,27 @@ error:
 	return NULL;
 }
 
+/* Prepare "access" for the computation of memory based dependences
+ * only.  That is, add the must-sources to the may-sources and
+ * drop all must-sources and kills.
+ */
+static __isl_give isl_union_access_info *isl_union_access_info_approximate(
+	__isl_take isl_union_access_info *access)
+{
+	isl_union_map *may, *must, *empty;
+
+	must = isl_union_access_info_get_must_source(access);
+	may = isl_union_access_info_get_may_source(access);
+	may = isl_union_map_union(may, must);
+	empty = isl_union_map_empty(isl_union_map_get_space(may));
+	access = isl_union_access_info_set_may_source(access, may);
+	access = isl_union_access_info_set_must_source(access,
+						isl_union_map_copy(empty));
+	access = isl_union_access_info_set_kill(access, empty);
+
+	return access;
+}
+
 /* Remove the must accesses from the may accesses.
  *
  * A must access always trumps a may access, so there is no need
@@ -2661,6 +2795,248 @@ static __isl_give isl_union_access_info *isl_union_access_info_normalize(
 	return access;
 }
 
+/* Data used by compute_sink_flows.
+ * Task "k" computes the dataflow analysis results for sink "k"
+ * described by "user" by calling "compute" and
+ * stores the result in "res[k]".
+ * "flow" collects the results.
+ */
+struct isl_flow_tasks {
+	__isl_give isl_union_flow *(*compute)(isl_ctx *ctx, int k, void *user);
+	void *user;
+	isl_union_flow **res;
+	isl_union_flow *flow;
+};
+
+/* Compute the dataflow analysis results of task "k" in "ctx".
+ */
+static isl_stat flow_task_run(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_flow_tasks *data = user;
+
+	data->res[k] = data->compute(ctx, k, data->user);
+	return data->res[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* Copy the dataflow analysis results computed by task "k" to "ctx" and
+ * add them to data->flow.
+ */
+static isl_stat flow_task_merge(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_flow_tasks *data = user;
+	isl_union_flow *child = data->res[k];
+	isl_union_flow *res;
+
+	res = isl_union_flow_copy_to_ctx(child, ctx);
+	isl_union_flow_free(child);
+	data->flow = isl_union_flow_add(data->flow, res);
+	return data->flow ? isl_stat_ok : isl_stat_error;
+}
+
+/* Compute the dataflow analysis results for the "n" sinks
+ * described by "user" by calling "compute" on each of them,
+ * using up to "n_thread" threads, and add them to "flow".
+ * Each result is computed in a task of isl_ctx_run_tasks.
+ * The results are added in the order of the sinks,
+ * independently of the number of threads.
+ */
+static __isl_give isl_union_flow *compute_sink_flows(
+	__isl_take isl_union_flow *flow, int n,
+	__isl_give isl_union_flow *(*compute)(isl_ctx *ctx, int k, void *user),
+	void *user, int n_thread)
+{
+	isl_ctx *ctx;
+	struct isl_flow_tasks data = { compute, user, NULL, flow };
+
+	if (!flow)
+		return NULL;
+
+	ctx = isl_union_flow_get_ctx(flow);
+	data.res = isl_calloc_array(ctx, isl_union_flow *, n);
+	if (n && !data.res)
+		return isl_union_flow_free(flow);
+	if (isl_ctx_run_tasks(ctx, n, n_thread, &flow_task_run,
+				&flow_task_merge, &data) < 0)
+		data.flow = isl_union_flow_free(data.flow);
+	free(data.res);
+
+	return data.flow;
+}
+
+/* Data used in add_matching_range.
+ *
+ * "space" is the space of the accessed array.
+ * "res" collects the access relations that access this array.
+ */
+struct isl_matching_range_data {
+	isl_space *space;
+	isl_union_map *res;
+};
+
+/* Add "map" to data->res if it accesses the array data->space.
+ */
+static isl_stat add_matching_range(__isl_take isl_map *map, void *user)
+{
+	struct isl_matching_range_data *data = user;
+	isl_space *space;
+	isl_bool eq;
+
+	space = isl_space_range(isl_map_get_space(map));
+	eq = isl_space_is_equal(space, data->space);
+	isl_space_free(space);
+
+	if (eq < 0 || !eq) {
+		isl_map_free(map);
+		return eq < 0 ? isl_stat_error : isl_stat_ok;
+	}
+
+	data->res = isl_union_map_add_map(data->res, map);
+	return isl_stat_non_null(data->res);
+}
+
+/* Return the access relations in "umap" that access the array "space".
+ */
+static __isl_give isl_union_map *matching_range(__isl_keep isl_union_map *umap,
+	__isl_keep isl_space *space)
+{
+	struct isl_matching_range_data data = { space };
+
+	data.res = isl_union_map_empty(isl_union_map_get_space(umap));
+	if (isl_union_map_foreach_map(umap, &add_matching_range, &data) < 0)
+		data.res = isl_union_map_free(data.res);
+
+	return data.res;
+}
+
+/* The sink accesses for which dataflow analysis is performed
+ * by compute_flow_sink, each in isolation.
+ *
+ * "n" is the number of sink accesses.
+ * "sink" contains the (scheduled) sink access relations.
+ * "must_source" and "may_source" contain, for each of these
+ * sink accesses, the (scheduled) must-sources and may-sources
+ * that access the same array.
+ */
+struct isl_compute_flow_sink_data {
+	int n;
+	isl_map **sink;
+	isl_union_map **must_source;
+	isl_union_map **may_source;
+};
+
+/* Free all the memory referenced from "data".
+ * Do not free "data" itself as it may be allocated on the stack.
+ */
+static void isl_compute_flow_sink_data_clear(
+	struct isl_compute_flow_sink_data *data)
+{
+	int k;
+
+	for (k = 0; k < data->n; ++k) {
+		if (data->sink)
+			isl_map_free(data->sink[k]);
+		if (data->must_source)
+			isl_union_map_free(data->must_source[k]);
+		if (data->may_source)
+			isl_union_map_free(data->may_source[k]);
+	}
+	free(data->sink);
+	free(data->must_source);
+	free(data->may_source);
+}
+
+/* Add "map" to the sinks in "user".
+ */
+static isl_stat collect_sink(__isl_take isl_map *map, void *user)
+{
+	struct isl_compute_flow_sink_data *data = user;
+
+	data->sink[data->n++] = map;
+
+	return isl_stat_ok;
+}
+
+/* Compute the dataflow analysis result for the sink with index "k"
+ * in the isl_compute_flow_sink_data "user" in "ctx".
+ * The inputs are copied to "ctx" and are otherwise only read.
+ */
+static __isl_give isl_union_flow *compute_flow_sink(isl_ctx *ctx, int k,
+	void *user)
+{
+	struct isl_compute_flow_sink_data *sinks = user;
+	struct isl_compute_flow_data data;
+	isl_map *map;
+
+	map = isl_map_copy_to_ctx(sinks->sink[k], ctx);
+	data.must_source = isl_union_map_copy_to_ctx(sinks->must_source[k],
+							ctx);
+	data.may_source = isl_union_map_copy_to_ctx(sinks->may_source[k], ctx);
+	data.flow = isl_union_flow_alloc(isl_space_params(
+						isl_map_get_space(map)));
+
+	if (!map || !data.must_source || !data.may_source || !data.flow)
+		data.flow = isl_union_flow_free(data.flow);
+	if (data.flow && compute_flow(map, &data) < 0)
+		data.flow = isl_union_flow_free(data.flow);
+	else if (!data.flow)
+		isl_map_free(map);
+
+	isl_union_map_free(data.must_source);
+	isl_union_map_free(data.may_source);
+	return data.flow;
+}
+
+/* Perform dataflow analysis for each of the sinks in "sink"
+ * with respect to the sources in "must_source" and "may_source"
+ * using up to "n_thread" threads and add the results to "flow".
+ *
+ * The sources accessing the same array as a sink are
+ * collected for each sink up front, such that each thread
+ * only needs to copy the relevant access relations.
+ */
+static __isl_give isl_union_flow *compute_flow_union_map_threads(
+	__isl_take isl_union_flow *flow, __isl_keep isl_union_map *sink,
+	__isl_keep isl_union_map *must_source,
+	__isl_keep isl_union_map *may_source, int n_thread)
+{
+	struct isl_compute_flow_sink_data data = { 0 };
+	isl_ctx *ctx;
+	isl_size n;
+	int k;
+
+	n = isl_union_map_n_map(sink);
+	if (!flow || n < 0)
+		return isl_union_flow_free(flow);
+
+	ctx = isl_union_flow_get_ctx(flow);
+	data.sink = isl_calloc_array(ctx, isl_map *, n);
+	data.must_source = isl_calloc_array(ctx, isl_union_map *, n);
+	data.may_source = isl_calloc_array(ctx, isl_union_map *, n);
+	if (n && (!data.sink || !data.must_source || !data.may_source))
+		goto error;
+	if (isl_union_map_foreach_map(sink, &collect_sink, &data) < 0)
+		goto error;
+	for (k = 0; k < data.n; ++k) {
+		isl_space *space;
+
+		space = isl_space_range(isl_map_get_space(data.sink[k]));
+		data.must_source[k] = matching_range(must_source, space);
+		data.may_source[k] = matching_range(may_source, space);
+		isl_space_free(space);
+		if (!data.must_source[k] || !data.may_source[k])
+			goto error;
+	}
+
+	flow = compute_sink_flows(flow, data.n, &compute_flow_sink, &data,
+				n_thread);
+
+	isl_compute_flow_sink_data_clear(&data);
+	return flow;
+error:
+	isl_compute_flow_sink_data_clear(&data);
+	return isl_union_flow_free(flow);
+}
+
 /* Given a description of the "sink" accesses, the "source" accesses and
  * a schedule, compute for each instance of a sink access
  * and for each element accessed by that instance,
@@ -2678,13 +3054,15 @@ static __isl_give isl_union_access_info *isl_union_access_info_normalize(
  *
  * We first prepend the schedule dimensions to the domain
  * of the accesses so that we can easily compare their relative order.
- * Then we consider each sink access individually in compute_flow.
+ * Then we consider each sink access individually in compute_flow,
+ * possibly in parallel if the flow_threads option is set.
  */
 static __isl_give isl_union_flow *compute_flow_union_map(
 	__isl_take isl_union_access_info *access)
 {
 	struct isl_compute_flow_data data;
 	isl_union_map *sink;
+	int n_thread;
 
 	access = isl_union_access_info_align_params(access);
 	access = isl_union_access_info_introduce_schedule(access);
@@ -2697,7 +3075,14 @@ static __isl_give isl_union_flow *compute_flow_union_map(
 	sink = access->access[isl_access_sink];
 	data.flow = isl_union_flow_alloc(isl_union_map_get_space(sink));
 
-	if (isl_union_map_foreach_map(sink, &compute_flow, &data) < 0)
+	n_thread = isl_options_get_flow_threads(
+					isl_union_access_info_get_ctx(access));
+	if (n_thread > 1) {
+		data.flow = compute_flow_union_map_threads(data.flow, sink,
+				data.must_source, data.may_source, n_thread);
+		if (!data.flow)
+			goto error;
+	} else if (isl_union_map_foreach_map(sink, &compute_flow, &data) < 0)
 		goto error;
 
 	data.flow = isl_union_flow_drop_schedule(data.flow);
@@ -2713,14 +3098,49 @@ error:
 /* A schedule access relation.
  *
  * The access relation "access" is of the form [S -> D] -> A,
- * where S corresponds to the prefix schedule at "node".
+ * where S corresponds to the prefix schedule at the leaf
+ * where the access takes place.
  * "must" is only relevant for source accesses and indicates
  * whether the access is a must source or a may source.
+ * "leaf" is the index of this leaf among the leaves of the schedule tree
+ * that were visited by collect_sink_source.
  */
 struct isl_scheduled_access {
 	isl_map *access;
 	int must;
-	isl_schedule_node *node;
+	int leaf;
+};
+
+/* An ancestor of a leaf of the schedule tree.
+ *
+ * "pos" is the position of the child of the ancestor
+ * that leads to the leaf.
+ * "depth" is the schedule depth of the ancestor.
+ * "sequence" is set if the ancestor is a sequence node.
+ */
+struct isl_flow_ancestor {
+	int pos;
+	int depth;
+	int sequence;
+};
+
+/* The position of a leaf of the schedule tree,
+ * used as a token in the dataflow analysis of a single sink.
+ *
+ * "n" is the number of ancestors of the leaf.
+ * "ancestor" describes these ancestors, starting from the root.
+ * "depth" is the schedule depth of the leaf itself.
+ *
+ * This information is extracted once for each leaf such that
+ * the relative order of two leaves can be determined
+ * without any schedule tree operations and
+ * without accessing the schedule tree, which is shared
+ * with the calling thread, from different threads.
+ */
+struct isl_flow_leaf {
+	int n;
+	struct isl_flow_ancestor *ancestor;
+	int depth;
 };
 
 /* Data structure for keeping track of individual scheduled sink and source
@@ -2728,23 +3148,25 @@ struct isl_scheduled_access {
  *
  * "n_sink" is the number of used entries in "sink"
  * "n_source" is the number of used entries in "source"
+ * "n_leaf" is the number of leaves visited by collect_sink_source
+ * "leaf" describes the positions of these leaves
  *
- * "set_sink", "must" and "node" are only used inside collect_sink_source,
- * to keep track of the current node and
- * of what extract_sink_source needs to do.
+ * "set_sink" and "must" are only used inside collect_sink_source,
+ * to keep track of what extract_sink_source needs to do.
  */
 struct isl_compute_flow_schedule_data {
 	isl_union_access_info *access;
 
 	int n_sink;
 	int n_source;
+	int n_leaf;
 
 	struct isl_scheduled_access *sink;
 	struct isl_scheduled_access *source;
+	struct isl_flow_leaf *leaf;
 
 	int set_sink;
 	int must;
-	isl_schedule_node *node;
 };
 
 /* Align the parameters of all sinks with all sources.
@@ -2789,18 +3211,20 @@ static void isl_compute_flow_schedule_data_clear(
 {
 	int i;
 
+	if (data->leaf) {
+		for (i = 0; i < data->n_leaf; ++i)
+			free(data->leaf[i].ancestor);
+		free(data->leaf);
+	}
+
 	if (!data->sink)
 		return;
 
-	for (i = 0; i < data->n_sink; ++i) {
+	for (i = 0; i < data->n_sink; ++i)
 		isl_map_free(data->sink[i].access);
-		isl_schedule_node_free(data->sink[i].node);
-	}
 
-	for (i = 0; i < data->n_source; ++i) {
+	for (i = 0; i < data->n_source; ++i)
 		isl_map_free(data->source[i].access);
-		isl_schedule_node_free(data->source[i].node);
-	}
 
 	free(data->sink);
 }
@@ -2813,6 +3237,7 @@ static void isl_compute_flow_schedule_data_clear(
  * Otherwise we increment data->n_sink and data->n_source with
  * the number of spaces in the sink and source access domains
  * that reach this node.
+ * The number of leaves is also counted in data->n_leaf.
  */
 static isl_bool count_sink_source(__isl_keep isl_schedule_node *node,
 	void *user)
@@ -2826,6 +3251,7 @@ static isl_bool count_sink_source(__isl_keep isl_schedule_node *node,
 	if (isl_schedule_node_get_type(node) != isl_schedule_node_leaf)
 		return isl_bool_true;
 
+	data->n_leaf++;
 	domain = isl_schedule_node_get_universe_domain(node);
 
 	umap = isl_union_map_copy(data->access->access[isl_access_sink]);
@@ -2856,7 +3282,7 @@ static isl_bool count_sink_source(__isl_keep isl_schedule_node *node,
 
 /* Add a single scheduled sink or source (depending on data->set_sink)
  * with scheduled access relation "map", must property data->must and
- * schedule node data->node to the list of sinks or sources.
+ * leaf data->n_leaf to the list of sinks or sources.
  */
 static isl_stat extract_sink_source(__isl_take isl_map *map, void *user)
 {
@@ -2870,11 +3296,57 @@ static isl_stat extract_sink_source(__isl_take isl_map *map, void *user)
 
 	access->access = map;
 	access->must = data->must;
-	access->node = isl_schedule_node_copy(data->node);
+	access->leaf = data->n_leaf;
 
 	return isl_stat_ok;
 }
 
+/* Extract the position of the leaf "node" in the schedule tree
+ * and store it in "leaf".
+ */
+static isl_stat extract_leaf(struct isl_flow_leaf *leaf,
+	__isl_keep isl_schedule_node *node)
+{
+	isl_ctx *ctx;
+	isl_size n, depth;
+	int d;
+
+	n = isl_schedule_node_get_tree_depth(node);
+	depth = isl_schedule_node_get_schedule_depth(node);
+	if (n < 0 || depth < 0)
+		return isl_stat_error;
+	ctx = isl_schedule_node_get_ctx(node);
+	leaf->ancestor = isl_alloc_array(ctx, struct isl_flow_ancestor, n);
+	if (n && !leaf->ancestor)
+		return isl_stat_error;
+	leaf->n = n;
+	leaf->depth = depth;
+
+	node = isl_schedule_node_copy(node);
+	for (d = n - 1; d >= 0; --d) {
+		struct isl_flow_ancestor *ancestor = &leaf->ancestor[d];
+		isl_size pos;
+		enum isl_schedule_node_type type;
+
+		pos = isl_schedule_node_get_child_position(node);
+		node = isl_schedule_node_parent(node);
+		depth = isl_schedule_node_get_schedule_depth(node);
+		type = isl_schedule_node_get_type(node);
+		if (pos < 0 || depth < 0 || type < 0)
+			break;
+		ancestor->pos = pos;
+		ancestor->depth = depth;
+		ancestor->sequence = type == isl_schedule_node_sequence;
+	}
+	isl_schedule_node_free(node);
+
+	if (d < 0)
+		return isl_stat_ok;
+	free(leaf->ancestor);
+	leaf->ancestor = NULL;
+	return isl_stat_error;
+}
+
 /* isl_schedule_foreach_schedule_node_top_down callback for collecting
  * individual scheduled source and sink accesses (taking into account
  * the domain of the schedule).
@@ -2898,6 +3370,8 @@ static isl_stat extract_sink_source(__isl_take isl_map *map, void *user)
  *
  * Note that S consists of a single space such that introducing S
  * in the access relations does not increase the number of spaces.
+ *
+ * The position of the leaf is stored in data->leaf.
  */
 static isl_bool collect_sink_source(__isl_keep isl_schedule_node *node,
 	void *user)
@@ -2910,7 +3384,8 @@ static isl_bool collect_sink_source(__isl_keep isl_schedule_node *node,
 	if (isl_schedule_node_get_type(node) != isl_schedule_node_leaf)
 		return isl_bool_true;
 
-	data->node = node;
+	if (extract_leaf(&data->leaf[data->n_leaf], node) < 0)
+		return isl_bool_error;
 
 	prefix = isl_schedule_node_get_prefix_schedule_relation(node);
 	prefix = isl_union_map_reverse(prefix);
@@ -2941,6 +3416,8 @@ static isl_bool collect_sink_source(__isl_keep isl_schedule_node *node,
 
 	isl_union_map_free(prefix);
 
+	data->n_leaf++;
+
 	return r;
 }
 
@@ -2957,41 +3434,31 @@ static isl_bool collect_sink_source(__isl_keep isl_schedule_node *node,
  *
  * The innermost shared ancestor may be the leaves themselves
  * if the accesses take place in the same leaf.  Otherwise,
- * it is either a set node or a sequence node.  Only in the case
- * of a sequence node do we consider one access to precede the other.
+ * it is the ancestor at which the paths from the root
+ * to the two leaves diverge, which is either a set node or
+ * a sequence node.  Only in the case of a sequence node do we consider
+ * one access to precede the other.
  */
-static int before_node(void *first, void *second)
+static int before_leaf(void *first, void *second)
 {
-	isl_schedule_node *node1 = first;
-	isl_schedule_node *node2 = second;
-	isl_schedule_node *shared;
-	isl_size depth;
-	int before = 0;
+	struct isl_flow_leaf *leaf1 = first;
+	struct isl_flow_leaf *leaf2 = second;
+	struct isl_flow_ancestor *ancestor1, *ancestor2;
+	int d;
 
-	shared = isl_schedule_node_get_shared_ancestor(node1, node2);
-	depth = isl_schedule_node_get_schedule_depth(shared);
-	if (depth < 0) {
-		isl_schedule_node_free(shared);
-		return -1;
-	}
+	if (leaf1 == leaf2)
+		return 2 * leaf1->depth;
 
-	if (isl_schedule_node_get_type(shared) == isl_schedule_node_sequence) {
-		isl_size pos1, pos2;
-
-		pos1 = isl_schedule_node_get_ancestor_child_position(node1,
-								    shared);
-		pos2 = isl_schedule_node_get_ancestor_child_position(node2,
-								    shared);
-		if (pos1 < 0 || pos2 < 0) {
-			isl_schedule_node_free(shared);
-			return -1;
-		}
-		before = pos1 < pos2;
-	}
-
-	isl_schedule_node_free(shared);
+	for (d = 0; d < leaf1->n && d < leaf2->n; ++d)
+		if (leaf1->ancestor[d].pos != leaf2->ancestor[d].pos)
+			break;
+	if (d >= leaf1->n || d >= leaf2->n)
+		return -1;
 
-	return 2 * depth + before;
+	ancestor1 = &leaf1->ancestor[d];
+	ancestor2 = &leaf2->ancestor[d];
+	return 2 * ancestor1->depth +
+		(ancestor1->sequence && ancestor1->pos < ancestor2->pos);
 }
 
 /* Check if the given two accesses may be coscheduled.
@@ -2999,56 +3466,77 @@ static int before_node(void *first, void *second)
  *
  * Two accesses may only be coscheduled if they appear in the same leaf.
  */
-static isl_bool coscheduled_node(void *first, void *second)
+static isl_bool coscheduled_leaf(void *first, void *second)
 {
-	isl_schedule_node *node1 = first;
-	isl_schedule_node *node2 = second;
+	return isl_bool_ok(first == second);
+}
 
-	return isl_bool_ok(node1 == node2);
+/* Is "source" relevant for the dataflow analysis of "sink"?
+ * That is, does it access the same data space and
+ * can it be executed before "sink" or together with "sink"?
+ * The latter can only be the case if both take place in the same leaf
+ * or if the source precedes the sink at some level according to
+ * before_leaf.
+ * Sources that are always executed after the sink cannot be
+ * the source of the sink nor an intermediate source and
+ * are therefore pruned before any relation arithmetic is performed.
+ */
+static isl_bool is_matching_source(struct isl_compute_flow_schedule_data *data,
+	struct isl_scheduled_access *sink, struct isl_scheduled_access *source)
+{
+	isl_space *space, *source_space;
+	isl_bool eq;
+
+	if (source->leaf != sink->leaf) {
+		int level;
+
+		level = before_leaf(&data->leaf[source->leaf],
+				    &data->leaf[sink->leaf]);
+		if (level < 0)
+			return isl_bool_error;
+		if (level == 0)
+			return isl_bool_false;
+	}
+
+	space = isl_space_range(isl_map_get_space(sink->access));
+	source_space = isl_space_range(isl_map_get_space(source->access));
+	eq = isl_space_is_equal(space, source_space);
+	isl_space_free(space);
+	isl_space_free(source_space);
+
+	return eq;
 }
 
-/* Add the scheduled sources from "data" that access
- * the same data space as "sink" to "access".
+/* Add the scheduled sources from "data" that are relevant
+ * for "sink" according to is_matching_source to "access".
  */
 static __isl_give isl_access_info *add_matching_sources(
 	__isl_take isl_access_info *access, struct isl_scheduled_access *sink,
 	struct isl_compute_flow_schedule_data *data)
 {
 	int i;
-	isl_space *space;
 
-	space = isl_space_range(isl_map_get_space(sink->access));
 	for (i = 0; i < data->n_source; ++i) {
 		struct isl_scheduled_access *source;
-		isl_space *source_space;
-		int eq;
+		isl_bool match;
 
 		source = &data->source[i];
-		source_space = isl_map_get_space(source->access);
-		source_space = isl_space_range(source_space);
-		eq = isl_space_is_equal(space, source_space);
-		isl_space_free(source_space);
-
-		if (!eq)
+		match = is_matching_source(data, sink, source);
+		if (match < 0)
+			return isl_access_info_free(access);
+		if (!match)
 			continue;
-		if (eq < 0)
-			goto error;
 
 		access = isl_access_info_add_source(access,
-		    isl_map_copy(source->access), source->must, source->node);
+		    isl_map_copy(source->access), source->must,
+		    &data->leaf[source->leaf]);
 	}
 
-	isl_space_free(space);
 	return access;
-error:
-	isl_space_free(space);
-	isl_access_info_free(access);
-	return NULL;
 }
 
-/* Given a scheduled sink access relation "sink", compute the corresponding
- * dependences on the sources in "data" and add the computed dependences
- * to "uf".
+/* Add the dependences "flow" computed by access_info_compute_flow_core
+ * for a scheduled sink access relation to "uf".
  *
  * The dependences computed by access_info_compute_flow_core are of the form
  *
@@ -3063,27 +3551,18 @@ error:
  *
  *	I -> [I' -> A]
  */
-static __isl_give isl_union_flow *compute_single_flow(
-	__isl_take isl_union_flow *uf, struct isl_scheduled_access *sink,
-	struct isl_compute_flow_schedule_data *data)
+static __isl_give isl_union_flow *add_scheduled_flow(
+	__isl_take isl_union_flow *uf, __isl_take isl_flow *flow)
 {
 	int i;
-	isl_access_info *access;
-	isl_flow *flow;
 	isl_map *map;
 
-	if (!uf)
-		return NULL;
-
-	access = isl_access_info_alloc(isl_map_copy(sink->access), sink->node,
-					&before_node, data->n_source);
-	if (access)
-		access->coscheduled = &coscheduled_node;
-	access = add_matching_sources(access, sink, data);
-
-	flow = access_info_compute_flow_core(access);
 	if (!flow)
 		return isl_union_flow_free(uf);
+	if (!uf) {
+		isl_flow_free(flow);
+		return NULL;
+	}
 
 	map = isl_map_domain_factor_range(isl_flow_get_no_source(flow, 1));
 	uf->must_no_source = isl_union_map_union(uf->must_no_source,
@@ -3109,6 +3588,134 @@ static __isl_give isl_union_flow *compute_single_flow(
 	return uf;
 }
 
+/* Given a scheduled sink access relation "sink", compute the corresponding
+ * dependences on the sources in "data" and add the computed dependences
+ * to "uf".
+ */
+static __isl_give isl_union_flow *compute_single_flow(
+	__isl_take isl_union_flow *uf, struct isl_scheduled_access *sink,
+	struct isl_compute_flow_schedule_data *data)
+{
+	isl_access_info *access;
+
+	if (!uf)
+		return NULL;
+
+	access = isl_access_info_alloc(isl_map_copy(sink->access),
+			&data->leaf[sink->leaf], &before_leaf, data->n_source);
+	if (access)
+		access->coscheduled = &coscheduled_leaf;
+	access = add_matching_sources(access, sink, data);
+
+	return add_scheduled_flow(uf, access_info_compute_flow_core(access));
+}
+
+/* Data used by compute_single_flow_leaf for computing
+ * the dependences of the sinks in "data" in isolation.
+ *
+ * "space" is the parameter space of the result.
+ * "match" contains the indices of the sources in "data"
+ * that are relevant for the sinks,
+ * with those for sink "k" stored from position "match_pos[k]" up to
+ * position "match_pos[k + 1]".
+ */
+struct isl_compute_flow_leaf_data {
+	struct isl_compute_flow_schedule_data *data;
+	isl_space *space;
+	int *match;
+	int *match_pos;
+};
+
+/* Compute the dependences of the scheduled sink with index "k"
+ * in the isl_compute_flow_leaf_data "user" in "ctx".
+ * The access relations are copied to "ctx" and are otherwise only read.
+ * The schedule tree is not accessed at all since the positions
+ * of the leaves have been extracted by collect_sink_source.
+ */
+static __isl_give isl_union_flow *compute_single_flow_leaf(isl_ctx *ctx,
+	int k, void *user)
+{
+	struct isl_compute_flow_leaf_data *leaf_data = user;
+	struct isl_compute_flow_schedule_data *data = leaf_data->data;
+	struct isl_scheduled_access *sink = &data->sink[k];
+	isl_access_info *access;
+	isl_union_flow *uf;
+	int i, n;
+
+	uf = isl_union_flow_alloc(isl_space_copy_to_ctx(leaf_data->space, ctx));
+	n = leaf_data->match_pos[k + 1] - leaf_data->match_pos[k];
+	access = isl_access_info_alloc(isl_map_copy_to_ctx(sink->access, ctx),
+			&data->leaf[sink->leaf], &before_leaf, n);
+	if (access)
+		access->coscheduled = &coscheduled_leaf;
+	for (i = leaf_data->match_pos[k]; i < leaf_data->match_pos[k + 1]; ++i) {
+		struct isl_scheduled_access *source;
+
+		source = &data->source[leaf_data->match[i]];
+		access = isl_access_info_add_source(access,
+			isl_map_copy_to_ctx(source->access, ctx), source->must,
+			&data->leaf[source->leaf]);
+	}
+
+	return add_scheduled_flow(uf, access_info_compute_flow_core(access));
+}
+
+/* Compute dependences for each scheduled sink in "data"
+ * using up to "n_thread" threads and add them to "flow".
+ *
+ * The threads cannot access the schedule tree, since this is
+ * shared with the calling thread, so the sources that are relevant
+ * for each sink are computed up front.
+ * The threads then use the positions of the leaves as tokens.
+ */
+static __isl_give isl_union_flow *compute_flow_schedule_threads(
+	__isl_take isl_union_flow *flow,
+	struct isl_compute_flow_schedule_data *data, int n_thread)
+{
+	struct isl_compute_flow_leaf_data leaf_data = { data };
+	isl_ctx *ctx;
+	int i, k, pos;
+
+	if (!flow)
+		return NULL;
+
+	ctx = isl_union_flow_get_ctx(flow);
+	leaf_data.space = isl_union_map_get_space(flow->must_dep);
+	leaf_data.match = isl_alloc_array(ctx, int,
+					    data->n_sink * data->n_source);
+	leaf_data.match_pos = isl_alloc_array(ctx, int, data->n_sink + 1);
+	if (!leaf_data.space || !leaf_data.match_pos ||
+	    (data->n_sink > 0 && data->n_source > 0 && !leaf_data.match))
+		goto error;
+
+	pos = 0;
+	for (k = 0; k < data->n_sink; ++k) {
+		leaf_data.match_pos[k] = pos;
+		for (i = 0; i < data->n_source; ++i) {
+			isl_bool match;
+
+			match = is_matching_source(data, &data->sink[k],
+						    &data->source[i]);
+			if (match < 0)
+				goto error;
+			if (match)
+				leaf_data.match[pos++] = i;
+		}
+	}
+	leaf_data.match_pos[data->n_sink] = pos;
+
+	flow = compute_sink_flows(flow, data->n_sink, &compute_single_flow_leaf,
+				&leaf_data, n_thread);
+
+	if (0)
+error:
+		flow = isl_union_flow_free(flow);
+	isl_space_free(leaf_data.space);
+	free(leaf_data.match);
+	free(leaf_data.match_pos);
+	return flow;
+}
+
 /* Given a description of the "sink" accesses, the "source" accesses and
  * a schedule, compute for each instance of a sink access
  * and for each element accessed by that instance,
@@ -3128,13 +3735,14 @@ static __isl_give isl_union_flow *compute_single_flow(
  *
  * We extract the individual scheduled source and sink access relations
  * (taking into account the domain of the schedule) and
- * then compute dependences for each scheduled sink individually.
+ * then compute dependences for each scheduled sink individually,
+ * possibly in parallel if the flow_threads option is set.
  */
 static __isl_give isl_union_flow *compute_flow_schedule(
 	__isl_take isl_union_access_info *access)
 {
 	struct isl_compute_flow_schedule_data data = { access };
-	int i, n;
+	int i, n, n_thread;
 	isl_ctx *ctx;
 	isl_space *space;
 	isl_union_flow *flow;
@@ -3143,6 +3751,7 @@ static __isl_give isl_union_flow *compute_flow_schedule(
 
 	data.n_sink = 0;
 	data.n_source = 0;
+	data.n_leaf = 0;
 	if (isl_schedule_foreach_schedule_node_top_down(access->schedule,
 						&count_sink_source, &data) < 0)
 		goto error;
@@ -3152,9 +3761,13 @@ static __isl_give isl_union_flow *compute_flow_schedule(
 	if (n && !data.sink)
 		goto error;
 	data.source = data.sink + data.n_sink;
+	data.leaf = isl_calloc_array(ctx, struct isl_flow_leaf, data.n_leaf);
+	if (data.n_leaf && !data.leaf)
+		goto error;
 
 	data.n_sink = 0;
 	data.n_source = 0;
+	data.n_leaf = 0;
 	if (isl_schedule_foreach_schedule_node_top_down(access->schedule,
 					    &collect_sink_source, &data) < 0)
 		goto error;
@@ -3164,8 +3777,12 @@ static __isl_give isl_union_flow *compute_flow_schedule(
 
 	isl_compute_flow_schedule_data_align_params(&data);
 
-	for (i = 0; i < data.n_sink; ++i)
-		flow = compute_single_flow(flow, &data.sink[i], &data);
+	n_thread = isl_options_get_flow_threads(ctx);
+	if (n_thread > 1 && data.n_sink > 1)
+		flow = compute_flow_schedule_threads(flow, &data, n_thread);
+	else
+		for (i = 0; i < data.n_sink; ++i)
+			flow = compute_single_flow(flow, &data.sink[i], &data);
 
 	isl_compute_flow_schedule_data_clear(&data);
 
@@ -3193,17 +3810,23 @@ error:
  * must-sources internally.  Any dependence that purely derives
  * from an original kill is removed from the output.
  *
+ * If only an approximation was requested, then the must-sources
+ * are turned into may-sources and the kills are dropped,
+ * such that only memory based dependences get computed.
+ *
  * We check whether the schedule is available as a schedule tree
  * or a schedule map and call the corresponding function to perform
  * the analysis.
  */
-__isl_give isl_union_flow *isl_union_access_info_compute_flow(
+static __isl_give isl_union_flow *compute_flow_uncached(
 	__isl_take isl_union_access_info *access)
 {
 	isl_bool has_kill;
 	isl_union_map *must = NULL, *may = NULL;
 	isl_union_flow *flow;
 
+	if (access && access->approximate)
+		access = isl_union_access_info_approximate(access);
 	has_kill = isl_union_access_has_kill(access);
 	if (has_kill < 0)
 		goto error;
@@ -3229,6 +3852,313 @@ error:
 	return NULL;
 }
 
+/* An entry in the dataflow analysis cache of an isl_ctx.
+ * "access" is the input of a dataflow analysis,
+ * "hash" is its fingerprint (see access_info_get_hash) and
+ * "flow" is the result of the analysis.
+ */
+struct isl_flow_cache_entry {
+	uint32_t		hash;
+	isl_union_access_info	*access;
+	isl_union_flow		*flow;
+};
+
+/* A size-bounded cache of the results of dataflow analyses.
+ * "size" is the number of entries in "entry".
+ * The cache is direct-mapped: an input with fingerprint "hash"
+ * can only be stored in entry "hash % size", replacing
+ * the input that was stored there before.
+ */
+struct isl_flow_cache {
+	int				size;
+	struct isl_flow_cache_entry	*entry;
+};
+
+/* Free the dataflow analysis cache of "ctx", if any.
+ * The cached objects keep a reference to "ctx", so this function
+ * needs to be called before checking whether "ctx" can be freed.
+ */
+void isl_ctx_clear_flow_cache(isl_ctx *ctx)
+{
+	int i;
+	struct isl_flow_cache *cache;
+
+	if (!ctx || !ctx->flow_cache)
+		return;
+	cache = ctx->flow_cache;
+	ctx->flow_cache = NULL;
+	for (i = 0; i < cache->size; ++i) {
+		isl_union_access_info_free(cache->entry[i].access);
+		isl_union_flow_free(cache->entry[i].flow);
+	}
+	free(cache->entry);
+	free(cache);
+}
+
+/* Return the dataflow analysis cache of "ctx", allocating it if needed.
+ * The size of the cache is determined by the flow_cache_size option.
+ * If this option has changed since the cache was allocated,
+ * then the cache is reallocated.
+ */
+static struct isl_flow_cache *get_flow_cache(isl_ctx *ctx)
+{
+	int size = isl_options_get_flow_cache_size(ctx);
+	struct isl_flow_cache *cache;
+
+	if (ctx->flow_cache && ctx->flow_cache->size == size)
+		return ctx->flow_cache;
+	isl_ctx_clear_flow_cache(ctx);
+	cache = isl_calloc_type(ctx, struct isl_flow_cache);
+	if (!cache)
+		return NULL;
+	cache->entry = isl_calloc_array(ctx, struct isl_flow_cache_entry,
+					size);
+	if (!cache->entry) {
+		free(cache);
+		return NULL;
+	}
+	cache->size = size;
+	ctx->flow_cache = cache;
+	return cache;
+}
+
+/* Return a fingerprint of "access", combining the hash values
+ * of the access relations and of the schedule.
+ * Only the domain of a schedule tree is taken into account.
+ */
+static uint32_t access_info_get_hash(__isl_keep isl_union_access_info *access)
+{
+	enum isl_access_type i;
+	uint32_t hash = isl_hash_init();
+	uint32_t umap_hash;
+
+	for (i = isl_access_sink; i < isl_access_end; ++i) {
+		umap_hash = isl_union_map_get_hash(access->access[i]);
+		isl_hash_hash(hash, umap_hash);
+	}
+	if (access->schedule) {
+		isl_union_set *domain;
+
+		domain = isl_schedule_get_domain(access->schedule);
+		umap_hash = isl_union_set_get_hash(domain);
+		isl_union_set_free(domain);
+	} else {
+		umap_hash = isl_union_map_get_hash(access->schedule_map);
+	}
+	isl_hash_hash(hash, umap_hash);
+	isl_hash_byte(hash, access->approximate & 0xFF);
+
+	return hash;
+}
+
+/* Are "umap1" and "umap2" obviously equal, where either may be NULL?
+ */
+static isl_bool union_map_plain_is_equal_or_null(
+	__isl_keep isl_union_map *umap1, __isl_keep isl_union_map *umap2)
+{
+	if (!umap1 || !umap2)
+		return isl_bool_ok(umap1 == umap2);
+	return isl_union_map_plain_is_equal(umap1, umap2);
+}
+
+/* Are "access1" and "access2" obviously equal?
+ * That is, were they both constructed for the same mode and
+ * do they have obviously equal access relations and
+ * either obviously equal schedule trees or
+ * obviously equal schedule maps?
+ */
+static isl_bool access_info_plain_is_equal(
+	__isl_keep isl_union_access_info *access1,
+	__isl_keep isl_union_access_info *access2)
+{
+	enum isl_access_type i;
+	isl_bool equal;
+
+	if (access1->approximate != access2->approximate)
+		return isl_bool_false;
+	for (i = isl_access_sink; i < isl_access_end; ++i) {
+		equal = union_map_plain_is_equal_or_null(access1->access[i],
+							access2->access[i]);
+		if (equal < 0 || !equal)
+			return equal;
+	}
+	if (!access1->schedule != !access2->schedule)
+		return isl_bool_false;
+	if (access1->schedule)
+		return isl_schedule_plain_is_equal(access1->schedule,
+						access2->schedule);
+	return union_map_plain_is_equal_or_null(access1->schedule_map,
+						access2->schedule_map);
+}
+
+/* Perform dataflow analysis on "access" as in compute_flow_uncached,
+ * but first look for an obviously equal input in the dataflow analysis
+ * cache of the isl_ctx.
+ * If there is one, then return a copy of its result.
+ * Otherwise, perform the analysis and store the result in the cache.
+ */
+static __isl_give isl_union_flow *cached_compute_flow(
+	__isl_take isl_union_access_info *access)
+{
+	isl_ctx *ctx = isl_union_access_info_get_ctx(access);
+	struct isl_flow_cache *cache;
+	struct isl_flow_cache_entry *entry;
+	isl_union_access_info *key;
+	isl_union_flow *flow;
+	uint32_t hash;
+	isl_bool equal = isl_bool_false;
+
+	cache = get_flow_cache(ctx);
+	if (!cache)
+		goto error;
+	hash = access_info_get_hash(access);
+	entry = &cache->entry[hash % cache->size];
+	if (entry->access && entry->hash == hash)
+		equal = access_info_plain_is_equal(entry->access, access);
+	if (equal < 0)
+		goto error;
+	if (equal) {
+		ctx->stats->flow_cache_hits++;
+		isl_union_access_info_free(access);
+		return isl_union_flow_copy(entry->flow);
+	}
+
+	ctx->stats->flow_cache_misses++;
+	key = isl_union_access_info_copy(access);
+	flow = compute_flow_uncached(access);
+	if (!key || !flow) {
+		isl_union_access_info_free(key);
+		return flow;
+	}
+	isl_union_access_info_free(entry->access);
+	isl_union_flow_free(entry->flow);
+	entry->hash = hash;
+	entry->access = key;
+	entry->flow = isl_union_flow_copy(flow);
+	return flow;
+error:
+	isl_union_access_info_free(access);
+	return NULL;
+}
+
+/* Given a description of the "sink" accesses, the "source" accesses and
+ * a schedule, compute for each instance of a sink access
+ * and for each element accessed by that instance,
+ * the possible or definite source accesses that last accessed the
+ * element accessed by the sink access before this sink access
+ * in the sense that there is no intermediate definite source access.
+ *
+ * If the flow_cache_size option is set, then the result is
+ * looked up in or added to the dataflow analysis cache of the isl_ctx.
+ * The analysis is performed in an operation scope
+ * such that it can be attributed by external profilers.
+ */
+__isl_give isl_union_flow *isl_union_access_info_compute_flow(
+	__isl_take isl_union_access_info *access)
+{
+	isl_ctx *ctx;
+	isl_union_flow *flow;
+
+	if (!access)
+		return NULL;
+	ctx = isl_union_access_info_get_ctx(access);
+	isl_ctx_scope_enter(ctx, "isl_union_access_info_compute_flow");
+	if (isl_options_get_flow_cache_size(ctx) > 0)
+		flow = cached_compute_flow(access);
+	else
+		flow = compute_flow_uncached(access);
+	isl_ctx_scope_leave(ctx);
+
+	return flow;
+}
+
+/* Remove the parts of "flow" that involve accesses to elements of "data".
+ * In particular, remove the dependences of the form
+ *
+ *	Source -> [Sink -> Data]
+ *
+ * with Data in "data" and the sink accesses without source
+ * that access elements of "data".
+ */
+static __isl_give isl_union_flow *isl_union_flow_subtract_data(
+	__isl_take isl_union_flow *flow, __isl_take isl_union_set *data)
+{
+	isl_union_map *dep, *filter;
+
+	if (!flow || !data)
+		goto error;
+
+	dep = isl_union_map_union(isl_union_map_copy(flow->must_dep),
+				isl_union_map_copy(flow->may_dep));
+	filter = isl_union_map_from_domain_and_range(isl_union_map_domain(dep),
+				isl_union_set_copy(data));
+	dep = isl_union_map_intersect_range_factor_range(
+				isl_union_map_copy(flow->must_dep),
+				isl_union_map_copy(filter));
+	flow->must_dep = isl_union_map_subtract(flow->must_dep, dep);
+	dep = isl_union_map_intersect_range_factor_range(
+				isl_union_map_copy(flow->may_dep), filter);
+	flow->may_dep = isl_union_map_subtract(flow->may_dep, dep);
+	flow->must_no_source = isl_union_map_subtract_range(
+			    flow->must_no_source, isl_union_set_copy(data));
+	flow->may_no_source = isl_union_map_subtract_range(
+			    flow->may_no_source, data);
+
+	if (!flow->must_dep || !flow->may_dep ||
+	    !flow->must_no_source || !flow->may_no_source)
+		return isl_union_flow_free(flow);
+
+	return flow;
+error:
+	isl_union_flow_free(flow);
+	isl_union_set_free(data);
+	return NULL;
+}
+
+/* Update the result "flow" of an earlier dataflow analysis
+ * to the input "access", where the earlier input only differs
+ * from "access" in the accesses to the elements in "data".
+ * That is, accesses may have been added to or removed from
+ * these elements and statements performing such accesses
+ * may have been added to or removed from the schedule,
+ * but the accesses to other elements and the relative execution order
+ * of the statement instances performing those accesses
+ * are the same.
+ *
+ * Since the sources of the sink accesses to a given element
+ * only depend on the accesses to that element,
+ * the result only needs to be recomputed for the elements in "data".
+ * The parts of "flow" involving these elements are removed and
+ * replaced by the result of a dataflow analysis on "access"
+ * with all access relations restricted to "data".
+ */
+__isl_give isl_union_flow *isl_union_access_info_update_flow(
+	__isl_take isl_union_access_info *access,
+	__isl_take isl_union_flow *flow, __isl_take isl_union_set *data)
+{
+	enum isl_access_type i;
+	isl_union_flow *part;
+
+	if (!access || !data)
+		goto error;
+
+	for (i = isl_access_sink; i < isl_access_end; ++i) {
+		access->access[i] = isl_union_map_intersect_range(
+				access->access[i], isl_union_set_copy(data));
+		if (!access->access[i])
+			goto error;
+	}
+
+	part = isl_union_access_info_compute_flow(access);
+	flow = isl_union_flow_subtract_data(flow, data);
+	return isl_union_flow_add(flow, part);
+error:
+	isl_union_access_info_free(access);
+	isl_union_flow_free(flow);
+	isl_union_set_free(data);
+	return NULL;
+}
+
 /* Print the information contained in "flow" to "p".
  * The information is printed as a YAML document.
  */
@@ -473,6 +473,7 @@ static int isl_qpolynomial_aff_sign(__isl_keep isl_set *set,
 {
 	enum isl_lp_result res;
 	isl_vec *aff;
+	isl_lp_solver *lp;
 	isl_int opt;
 	int sgn = 0;
 
@@ -482,7 +483,8 @@ static int isl_qpolynomial_aff_sign(__isl_keep isl_set *set,
 
 	isl_int_init(opt);
 
-	res = isl_set_solve_lp(set, 0, aff->el + 1, aff->el[0],
+	lp = isl_set_lp_solver_alloc(set);
+	res = isl_lp_solver_solve(lp, 0, aff->el + 1, aff->el[0],
 				&opt, NULL, NULL);
 	if (res == isl_lp_error)
 		goto done;
@@ -492,12 +494,13 @@ static int isl_qpolynomial_aff_sign(__isl_keep isl_set *set,
 		goto done;
 	}
 
-	res = isl_set_solve_lp(set, 1, aff->el + 1, aff->el[0],
+	res = isl_lp_solver_solve(lp, 1, aff->el + 1, aff->el[0],
 				&opt, NULL, NULL);
 	if (res == isl_lp_ok && !isl_int_is_pos(opt))
 		sgn = -1;
 
 done:
+	isl_lp_solver_free(lp);
 	isl_int_clear(opt);
 	isl_vec_free(aff);
 	return sgn;
@@ -618,6 +621,256 @@ static int isl_qpolynomial_sign(__isl_keep isl_set *set,
 	return sgn;
 }
 
+/* An interval [lo, hi] of rational values,
+ * where "lo" may be negative infinity and "hi" may be infinity.
+ */
+struct isl_fold_interval {
+	isl_val *lo;
+	isl_val *hi;
+};
+
+/* A box of "n" intervals, one for each variable of some set.
+ * "empty" is set if the set is known to be empty.
+ */
+struct isl_fold_box {
+	int empty;
+	int n;
+	struct isl_fold_interval *v;
+};
+
+static void isl_fold_interval_clear(struct isl_fold_interval *in)
+{
+	in->lo = isl_val_free(in->lo);
+	in->hi = isl_val_free(in->hi);
+}
+
+static void isl_fold_box_free(struct isl_fold_box *box)
+{
+	int i;
+
+	if (!box)
+		return;
+	for (i = 0; i < box->n; ++i)
+		isl_fold_interval_clear(&box->v[i]);
+	free(box->v);
+	free(box);
+}
+
+/* Return the product of the interval bounds "v1" and "v2".
+ * Since the values in the intervals are finite,
+ * the product of zero and an infinite bound is zero.
+ */
+static __isl_give isl_val *interval_bound_mul(__isl_keep isl_val *v1,
+	__isl_keep isl_val *v2)
+{
+	if (!v1 || !v2)
+		return NULL;
+	if (isl_val_is_zero(v1) || isl_val_is_zero(v2))
+		return isl_val_zero(isl_val_get_ctx(v1));
+	return isl_val_mul(isl_val_copy(v1), isl_val_copy(v2));
+}
+
+/* Replace "in" by an interval containing the products of
+ * the elements of "in" and those of "factor".
+ */
+static isl_stat interval_mul(struct isl_fold_interval *in,
+	struct isl_fold_interval *factor)
+{
+	isl_val *lo, *hi, *v;
+
+	lo = interval_bound_mul(in->lo, factor->lo);
+	hi = isl_val_copy(lo);
+	v = interval_bound_mul(in->lo, factor->hi);
+	lo = isl_val_min(lo, isl_val_copy(v));
+	hi = isl_val_max(hi, v);
+	v = interval_bound_mul(in->hi, factor->lo);
+	lo = isl_val_min(lo, isl_val_copy(v));
+	hi = isl_val_max(hi, v);
+	v = interval_bound_mul(in->hi, factor->hi);
+	lo = isl_val_min(lo, isl_val_copy(v));
+	hi = isl_val_max(hi, v);
+
+	isl_fold_interval_clear(in);
+	in->lo = lo;
+	in->hi = hi;
+
+	return lo && hi ? isl_stat_ok : isl_stat_error;
+}
+
+/* Compute in "res" an interval containing the values of "poly"
+ * for values of the variables in the corresponding intervals of "box".
+ * The interval is computed by evaluating "poly" in Horner form
+ * using interval arithmetic.
+ * Return isl_bool_false if "poly" involves NaN or infinity
+ * and isl_bool_true if the interval was computed.
+ */
+static isl_bool poly_interval(__isl_keep isl_poly *poly,
+	struct isl_fold_box *box, struct isl_fold_interval *res)
+{
+	int i;
+	isl_bool ok;
+	isl_poly_rec *rec;
+
+	res->lo = res->hi = NULL;
+	if (!poly)
+		return isl_bool_error;
+	if (poly->var < 0) {
+		isl_poly_cst *cst = (isl_poly_cst *) poly;
+
+		if (isl_int_is_zero(cst->d))
+			return isl_bool_false;
+		res->lo = isl_val_rat_from_isl_int(poly->ctx, cst->n, cst->d);
+		res->hi = isl_val_copy(res->lo);
+		return res->hi ? isl_bool_true : isl_bool_error;
+	}
+	if (poly->var >= box->n)
+		return isl_bool_false;
+
+	rec = (isl_poly_rec *) poly;
+	ok = poly_interval(rec->p[rec->n - 1], box, res);
+	for (i = rec->n - 2; ok == isl_bool_true && i >= 0; --i) {
+		struct isl_fold_interval term;
+
+		if (interval_mul(res, &box->v[poly->var]) < 0)
+			ok = isl_bool_error;
+		if (ok == isl_bool_true)
+			ok = poly_interval(rec->p[i], box, &term);
+		if (ok == isl_bool_true) {
+			res->lo = isl_val_add(res->lo, isl_val_copy(term.lo));
+			res->hi = isl_val_add(res->hi, isl_val_copy(term.hi));
+			if (!res->lo || !res->hi)
+				ok = isl_bool_error;
+		}
+		isl_fold_interval_clear(&term);
+	}
+	if (ok != isl_bool_true)
+		isl_fold_interval_clear(res);
+
+	return ok;
+}
+
+/* Return the minimal (or maximal if "max" is set) value of "f"
+ * over the set of "lp", with infinite values for unbounded problems.
+ * Set *empty if the set is empty.
+ */
+static __isl_give isl_val *lp_opt(isl_ctx *ctx, isl_lp_solver *lp, int max,
+	isl_int *f, isl_int one, int *empty)
+{
+	enum isl_lp_result res;
+	isl_val *v;
+
+	v = isl_val_alloc(ctx);
+	if (!v)
+		return NULL;
+	res = isl_lp_solver_solve(lp, max, f, one, &v->n, &v->d, NULL);
+	if (res == isl_lp_ok)
+		return isl_val_normalize(v);
+	isl_val_free(v);
+	if (res == isl_lp_empty)
+		*empty = 1;
+	if (res != isl_lp_unbounded)
+		return NULL;
+	return max ? isl_val_infty(ctx) : isl_val_neginfty(ctx);
+}
+
+/* Compute a box containing the elements of "set",
+ * with an interval for each parameter and each set variable.
+ * The bounds of the intervals are computed using a single LP solver,
+ * such that each LP starts from the optimal basis of the previous one.
+ * Set box->empty if "set" turns out to be empty.
+ */
+static struct isl_fold_box *set_box(__isl_keep isl_set *set)
+{
+	int k;
+	isl_ctx *ctx;
+	isl_size n_var;
+	isl_vec *f;
+	isl_lp_solver *lp;
+	struct isl_fold_box *box;
+
+	n_var = isl_set_dim(set, isl_dim_all);
+	if (n_var < 0)
+		return NULL;
+
+	ctx = isl_set_get_ctx(set);
+	box = isl_calloc_type(ctx, struct isl_fold_box);
+	if (!box)
+		return NULL;
+	box->v = isl_calloc_array(ctx, struct isl_fold_interval, n_var);
+	if (n_var && !box->v)
+		goto error;
+	box->n = n_var;
+
+	f = isl_vec_alloc(ctx, 2 + n_var);
+	lp = isl_set_lp_solver_alloc(set);
+	if (!f || !lp)
+		goto error_lp;
+	isl_seq_clr(f->el, f->size);
+	isl_int_set_si(f->el[0], 1);
+	for (k = 0; !box->empty && k < n_var; ++k) {
+		struct isl_fold_interval *in = &box->v[k];
+
+		isl_int_set_si(f->el[2 + k], 1);
+		in->lo = lp_opt(ctx, lp, 0, f->el + 1, f->el[0], &box->empty);
+		if (!box->empty)
+			in->hi = lp_opt(ctx, lp, 1, f->el + 1, f->el[0],
+					&box->empty);
+		isl_int_set_si(f->el[2 + k], 0);
+		if (!box->empty && (!in->lo || !in->hi))
+			goto error_lp;
+	}
+	isl_lp_solver_free(lp);
+	isl_vec_free(f);
+
+	return box;
+error_lp:
+	isl_lp_solver_free(lp);
+	isl_vec_free(f);
+error:
+	isl_fold_box_free(box);
+	return NULL;
+}
+
+/* Determine, if possible, the sign of the quasipolynomial "qp"
+ * on a set contained in "box", without solving any LP problems.
+ * In particular, check whether the interval of values of "qp"
+ * obtained through interval arithmetic on "box" has a known sign.
+ * If the set is empty, then any sign is valid and 1 is returned,
+ * as in isl_qpolynomial_sign.
+ * Otherwise, this test is only performed on quasipolynomials
+ * without integer divisions.
+ *
+ * Return
+ *	-1 if qp <= 0
+ *	 1 if qp >= 0
+ *	 0 if unknown
+ */
+static int isl_qpolynomial_box_sign(__isl_keep isl_qpolynomial *qp,
+	struct isl_fold_box *box)
+{
+	struct isl_fold_interval in;
+	isl_bool ok;
+	int sgn = 0;
+
+	if (!box || !qp)
+		return 0;
+	if (box->empty)
+		return 1;
+	if (qp->div->n_row > 0)
+		return 0;
+
+	ok = poly_interval(qp->poly, box, &in);
+	if (ok == isl_bool_true) {
+		if (isl_val_is_nonneg(in.lo) == isl_bool_true)
+			sgn = 1;
+		else if (isl_val_is_nonpos(in.hi) == isl_bool_true)
+			sgn = -1;
+	}
+	isl_fold_interval_clear(&in);
+
+	return sgn;
+}
+
 /* Check that "fold1" and "fold2" have the same type.
  */
 static isl_stat isl_qpolynomial_fold_check_equal_type(
@@ -662,6 +915,13 @@ static isl_stat isl_qpolynomial_fold_check_equal_space(
  *
  * "better" is the sign that the difference qp1 - qp2 needs to have for qp1
  * to be covered by qp2.
+ *
+ * The sign of the difference is first determined using the cheap
+ * isl_qpolynomial_box_sign on a box containing "set",
+ * which is only computed when it is first needed and
+ * then reused for all pairs.
+ * Only if this fails is isl_qpolynomial_sign called,
+ * which needs to solve LP problems for each pair.
  */
 static __isl_give isl_qpolynomial_list *merge_lists(__isl_keep isl_set *set,
 	__isl_take isl_qpolynomial_list *list1,
@@ -669,6 +929,8 @@ static __isl_give isl_qpolynomial_list *merge_lists(__isl_keep isl_set *set,
 {
 	int i, j;
 	isl_size n1, n2;
+	int has_box = 0;
+	struct isl_fold_box *box = NULL;
 
 	n1 = isl_qpolynomial_list_size(list1);
 	n2 = isl_qpolynomial_list_size(list2);
@@ -691,7 +953,13 @@ static __isl_give isl_qpolynomial_list *merge_lists(__isl_keep isl_set *set,
 			d = isl_qpolynomial_sub(
 				isl_qpolynomial_copy(qp1),
 				isl_qpolynomial_copy(qp2));
-			sgn = isl_qpolynomial_sign(set, d);
+			if (!has_box) {
+				box = set_box(set);
+				has_box = 1;
+			}
+			sgn = isl_qpolynomial_box_sign(d, box);
+			if (sgn == 0)
+				sgn = isl_qpolynomial_sign(set, d);
 			isl_qpolynomial_free(d);
 			if (sgn == 0)
 				continue;
@@ -706,8 +974,10 @@ static __isl_give isl_qpolynomial_list *merge_lists(__isl_keep isl_set *set,
 		n2--;
 	}
 
+	isl_fold_box_free(box);
 	return isl_qpolynomial_list_concat(list1, list2);
 error:
+	isl_fold_box_free(box);
 	isl_qpolynomial_list_free(list1);
 	isl_qpolynomial_list_free(list2);
 	return NULL;
@@ -958,6 +1228,35 @@ static __isl_give isl_qpolynomial_fold *isl_qpolynomial_fold_zero_in_space(
 #include <isl_pw_move_dims_templ.c>
 #include <isl_pw_opt_templ.c>
 
+/* Return a copy of "pwf" in "ctx".
+ * Unless "pwf" already belongs to "ctx", "pwf" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_pw_qpolynomial_fold *isl_pw_qpolynomial_fold_copy_to_ctx(
+	__isl_keep isl_pw_qpolynomial_fold *pwf, isl_ctx *ctx)
+{
+	int i;
+	isl_space *space;
+	isl_pw_qpolynomial_fold *dup;
+
+	if (!pwf)
+		return NULL;
+	if (isl_pw_qpolynomial_fold_get_ctx(pwf) == ctx)
+		return isl_pw_qpolynomial_fold_copy(pwf);
+
+	space = isl_space_copy_to_ctx(pwf->dim, ctx);
+	dup = isl_pw_qpolynomial_fold_alloc_size(space, pwf->type, pwf->n);
+	for (i = 0; i < pwf->n; ++i) {
+		isl_set *set;
+		isl_qpolynomial_fold *fold;
+
+		set = isl_set_copy_to_ctx(pwf->p[i].set, ctx);
+		fold = isl_qpolynomial_fold_copy_to_ctx(pwf->p[i].fold, ctx);
+		dup = isl_pw_qpolynomial_fold_add_piece(dup, set, fold);
+	}
+	return dup;
+}
+
 #undef BASE
 #define BASE pw_qpolynomial_fold
 
@@ -1019,6 +1318,37 @@ __isl_give isl_qpolynomial_fold *isl_qpolynomial_fold_dup(
 	return qpolynomial_fold_alloc(type, space, list);
 }
 
+/* Return a copy of "fold" in "ctx".
+ * Unless "fold" already belongs to "ctx", "fold" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_qpolynomial_fold *isl_qpolynomial_fold_copy_to_ctx(
+	__isl_keep isl_qpolynomial_fold *fold, isl_ctx *ctx)
+{
+	int i;
+	isl_size n;
+	isl_space *space;
+	isl_qpolynomial_list *list;
+
+	if (!fold)
+		return NULL;
+	if (isl_qpolynomial_fold_get_ctx(fold) == ctx)
+		return isl_qpolynomial_fold_copy(fold);
+
+	n = isl_qpolynomial_list_size(fold->list);
+	if (n < 0)
+		return NULL;
+	space = isl_space_copy_to_ctx(fold->dim, ctx);
+	list = isl_qpolynomial_list_alloc(ctx, n);
+	for (i = 0; i < n; ++i) {
+		isl_qpolynomial *qp;
+
+		qp = isl_qpolynomial_copy_to_ctx(fold->list->p[i], ctx);
+		list = isl_qpolynomial_list_add(list, qp);
+	}
+	return qpolynomial_fold_alloc(fold->type, space, list);
+}
+
 __isl_give isl_qpolynomial_fold *isl_qpolynomial_fold_cow(
 	__isl_take isl_qpolynomial_fold *fold)
 {
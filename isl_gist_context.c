@@ -0,0 +1,119 @@
+/*
+ * Use of this software is governed by the MIT license
+ */
+
+#include <isl_ctx_private.h>
+#include <isl_map_private.h>
+#include <isl_gist_context_private.h>
+
+#include <set_to_map.c>
+
+/* Return the isl_ctx to which "context" belongs.
+ */
+isl_ctx *isl_gist_context_get_ctx(__isl_keep isl_gist_context *context)
+{
+	return context ? isl_map_get_ctx(context->map) : NULL;
+}
+
+/* Preprocess "map" for use as the context of isl_*_gist_prepared.
+ *
+ * The work that isl_map_gist and isl_pw_aff_gist perform
+ * on the context only is performed here once.
+ * In particular, the local variables of "map" are computed and
+ * the simple hull is constructed.  Since the simple hull would
+ * be stripped of its redundant constraints and have its implicit
+ * equalities detected in every call, these steps are performed
+ * here as well.  The corresponding flags on the result ensure
+ * that they are not repeated on copies of the hull.
+ */
+__isl_give isl_gist_context *isl_gist_context_from_map(
+	__isl_take isl_map *map)
+{
+	isl_ctx *ctx;
+	isl_gist_context *context;
+	isl_bool universe;
+	isl_size n;
+
+	map = isl_map_compute_divs(map);
+	if (!map)
+		return NULL;
+
+	ctx = isl_map_get_ctx(map);
+	context = isl_calloc_type(ctx, struct isl_gist_context);
+	if (!context)
+		goto error;
+
+	context->ref = 1;
+	context->map = map;
+	universe = isl_map_plain_is_universe(map);
+	n = isl_map_n_basic_map(map);
+	if (universe < 0 || n < 0)
+		return isl_gist_context_free(context);
+	context->universe = universe;
+	context->single = n == 1;
+	context->hull = isl_map_simple_hull(isl_map_copy(map));
+	context->hull = isl_basic_map_remove_redundancies(context->hull);
+	context->hull = isl_basic_map_detect_equalities(context->hull);
+	if (!context->hull)
+		return isl_gist_context_free(context);
+
+	return context;
+error:
+	isl_map_free(map);
+	return NULL;
+}
+
+/* Preprocess "set" for use as the context of isl_*_gist_prepared.
+ */
+__isl_give isl_gist_context *isl_gist_context_from_set(
+	__isl_take isl_set *set)
+{
+	return isl_gist_context_from_map(set_to_map(set));
+}
+
+/* Return a new reference to "context".
+ */
+__isl_give isl_gist_context *isl_gist_context_copy(
+	__isl_keep isl_gist_context *context)
+{
+	if (!context)
+		return NULL;
+
+	context->ref++;
+	return context;
+}
+
+/* Free a reference to "context" and return NULL.
+ */
+__isl_null isl_gist_context *isl_gist_context_free(
+	__isl_take isl_gist_context *context)
+{
+	if (!context)
+		return NULL;
+
+	if (--context->ref > 0)
+		return NULL;
+
+	isl_map_free(context->map);
+	isl_basic_map_free(context->hull);
+	isl_basic_map_free(context->aff_hull);
+	free(context);
+
+	return NULL;
+}
+
+/* Return the affine hull of "context", computing it
+ * the first time it is requested.
+ */
+__isl_give isl_basic_map *isl_gist_context_get_affine_hull(
+	__isl_keep isl_gist_context *context)
+{
+	if (!context)
+		return NULL;
+
+	if (!context->aff_hull)
+		context->aff_hull =
+		    isl_map_affine_hull(isl_map_copy(context->map));
+
+	return isl_basic_map_copy(context->aff_hull);
+}
@@ -0,0 +1,31 @@
+#ifndef ISL_GIST_CONTEXT_PRIVATE_H
+#define ISL_GIST_CONTEXT_PRIVATE_H
+
+#include <isl/map_type.h>
+#include <isl/gist_context.h>
+
+/* A context for isl_*_gist_prepared that has been preprocessed
+ * such that it can be used to simplify many objects.
+ *
+ * "map" is the original context, with its local variables computed.
+ * "universe" is set if "map" is obviously the universe.
+ * "single" is set if "map" consists of a single disjunct.
+ * "hull" is the simple hull of "map", with redundant constraints
+ * removed and implicit equalities detected.
+ * "aff_hull" is the affine hull of "map", if it has been computed already.
+ * It is only computed when it is needed by isl_aff_gist_prepared.
+ */
+struct isl_gist_context {
+	int ref;
+
+	isl_map *map;
+	int universe;
+	int single;
+	isl_basic_map *hull;
+	isl_basic_map *aff_hull;
+};
+
+__isl_give isl_basic_map *isl_gist_context_get_affine_hull(
+	__isl_keep isl_gist_context *context);
+
+#endif
@@ -61,65 +61,104 @@ int isl_hash_table_init(struct isl_ctx *ctx, struct isl_hash_table *table,
 	return 0;
 }
 
-/* Dummy comparison function that always returns false.
- */
-static isl_bool no(const void *entry, const void *val)
-{
-	return isl_bool_false;
-}
-
-/* Extend "table" to twice its size.
+/* Extend "table" such that it has (1 << "bits") entries.
  * Return 0 on success and -1 on error.
  *
- * We reuse isl_hash_table_find to create entries in the extended table.
+ * The entries of the original table are moved to the first free position
+ * of their probe sequence in the extended table.
  * Since all entries in the original table are assumed to be different,
  * there is no need to compare them against each other.
  */
-static int grow_table(struct isl_ctx *ctx, struct isl_hash_table *table)
+static int resize_table(struct isl_ctx *ctx, struct isl_hash_table *table,
+	int bits)
 {
-	int n;
 	size_t old_size, size;
 	struct isl_hash_table_entry *entries;
 	uint32_t h;
 
-	entries = table->entries;
-	old_size = 1 << table->bits;
-	size = 2 * old_size;
-	table->entries = isl_calloc_array(ctx, struct isl_hash_table_entry,
-					  size);
-	if (!table->entries) {
-		table->entries = entries;
+	entries = isl_calloc_array(ctx, struct isl_hash_table_entry,
+					  (size_t) 1 << bits);
+	if (!entries)
 		return -1;
-	}
-
-	n = table->n;
-	table->n = 0;
-	table->bits++;
 
+	old_size = (size_t) 1 << table->bits;
+	size = (size_t) 1 << bits;
 	for (h = 0; h < old_size; ++h) {
-		struct isl_hash_table_entry *entry;
+		uint32_t h2;
 
-		if (!entries[h].data)
+		if (!table->entries[h].data)
 			continue;
 
-		entry = isl_hash_table_find(ctx, table, entries[h].hash,
-					    &no, NULL, 1);
-		if (!entry) {
-			table->bits--;
-			free(table->entries);
-			table->entries = entries;
-			table->n = n;
-			return -1;
-		}
-
-		*entry = entries[h];
+		h2 = isl_hash_bits(table->entries[h].hash, bits);
+		while (entries[h2].data)
+			h2 = (h2 + 1) & (size - 1);
+		entries[h2] = table->entries[h];
 	}
 
-	free(entries);
+	free(table->entries);
+	table->entries = entries;
+	table->bits = bits;
 
 	return 0;
 }
 
+/* Extend "table" to twice its size.
+ * Return 0 on success and -1 on error.
+ */
+static int grow_table(struct isl_ctx *ctx, struct isl_hash_table *table)
+{
+	return resize_table(ctx, table, table->bits + 1);
+}
+
+/* Make sure that "table" can hold at least "n" entries
+ * without having to be extended.
+ *
+ * The table is extended as soon as it is three quarters full,
+ * so make sure it has more than 4 * n / 3 entries.
+ */
+isl_stat isl_hash_table_reserve(struct isl_ctx *ctx,
+	struct isl_hash_table *table, int n)
+{
+	int bits;
+
+	if (!table)
+		return isl_stat_error;
+
+	bits = table->bits;
+	while (bits < 30 && 4 * (size_t) n >= 3 * ((size_t) 1 << bits))
+		bits++;
+	if (bits == table->bits)
+		return isl_stat_ok;
+
+	if (resize_table(ctx, table, bits) < 0)
+		return isl_stat_error;
+	return isl_stat_ok;
+}
+
+/* Shrink "table" to the smallest size that can hold its current entries
+ * without having to be extended, but not below the minimal size
+ * of a table allocated by isl_hash_table_init.
+ */
+isl_stat isl_hash_table_shrink(struct isl_ctx *ctx,
+	struct isl_hash_table *table)
+{
+	int bits;
+
+	if (!table)
+		return isl_stat_error;
+
+	bits = 2;
+	while (bits < table->bits &&
+	       4 * (size_t) table->n >= 3 * ((size_t) 1 << bits))
+		bits++;
+	if (bits >= table->bits)
+		return isl_stat_ok;
+
+	if (resize_table(ctx, table, bits) < 0)
+		return isl_stat_error;
+	return isl_stat_ok;
+}
+
 struct isl_hash_table *isl_hash_table_alloc(struct isl_ctx *ctx, int min_size)
 {
 	struct isl_hash_table *table = NULL;
@@ -165,7 +204,7 @@ struct isl_hash_table_entry *isl_hash_table_find(struct isl_ctx *ctx,
 
 	key_bits = isl_hash_bits(key_hash, table->bits);
 	size = 1 << table->bits;
-	for (h = key_bits; table->entries[h].data; h = (h+1) % size) {
+	for (h = key_bits; table->entries[h].data; h = (h + 1) & (size - 1)) {
 		isl_bool equal;
 
 		if (table->entries[h].hash != key_hash)
@@ -43,7 +43,26 @@ const char *isl_id_get_name(__isl_keep isl_id *id)
 	return id ? id->name : NULL;
 }
 
-static __isl_give isl_id *id_alloc(isl_ctx *ctx, const char *name, void *user)
+/* Return the hash value of an isl_id with the given name and user pointer.
+ */
+static uint32_t id_hash(const char *name, void *user)
+{
+	uint32_t hash;
+
+	hash = isl_hash_init();
+	if (name)
+		hash = isl_hash_string(hash, name);
+	else
+		hash = isl_hash_builtin(hash, user);
+
+	return hash;
+}
+
+/* Allocate a fresh isl_id with the given name, user pointer and
+ * hash value, where "hash" is equal to id_hash(name, user).
+ */
+static __isl_give isl_id *id_alloc(isl_ctx *ctx, const char *name, void *user,
+	uint32_t hash)
 {
 	const char *copy = name ? strdup(name) : NULL;
 	isl_id *id;
@@ -59,12 +78,7 @@ static __isl_give isl_id *id_alloc(isl_ctx *ctx, const char *name, void *user)
 	id->ref = 1;
 	id->name = copy;
 	id->user = user;
-
-	id->hash = isl_hash_init();
-	if (name)
-		id->hash = isl_hash_string(id->hash, name);
-	else
-		id->hash = isl_hash_builtin(id->hash, user);
+	id->hash = hash;
 
 	return id;
 error:
@@ -97,32 +111,36 @@ static isl_bool isl_id_has_name_and_user(const void *entry, const void *val)
 	return isl_bool_ok(!strcmp(id->name, nu->name));
 }
 
-__isl_give isl_id *isl_id_alloc(isl_ctx *ctx, const char *name, void *user)
+/* Return the isl_id in "ctx" with the given name and user pointer,
+ * creating it if it does not exist yet.
+ * "hash" is equal to id_hash(name, user).
+ */
+static __isl_give isl_id *id_intern(isl_ctx *ctx, const char *name,
+	void *user, uint32_t hash)
 {
 	struct isl_hash_table_entry *entry;
-	uint32_t id_hash;
 	struct isl_name_and_user nu = { name, user };
 
 	if (!ctx)
 		return NULL;
 
-	id_hash = isl_hash_init();
-	if (name)
-		id_hash = isl_hash_string(id_hash, name);
-	else
-		id_hash = isl_hash_builtin(id_hash, user);
-	entry = isl_hash_table_find(ctx, &ctx->id_table, id_hash,
+	entry = isl_hash_table_find(ctx, &ctx->id_table, hash,
 					isl_id_has_name_and_user, &nu, 1);
 	if (!entry)
 		return NULL;
 	if (entry->data)
 		return isl_id_copy(entry->data);
-	entry->data = id_alloc(ctx, name, user);
+	entry->data = id_alloc(ctx, name, user, hash);
 	if (!entry->data)
 		ctx->id_table.n--;
 	return entry->data;
 }
 
+__isl_give isl_id *isl_id_alloc(isl_ctx *ctx, const char *name, void *user)
+{
+	return id_intern(ctx, name, user, id_hash(name, user));
+}
+
 /* If the id has a negative refcount, then it is a static isl_id
  * which should not be changed.
  */
@@ -138,6 +156,28 @@ __isl_give isl_id *isl_id_copy(isl_id *id)
 	return id;
 }
 
+/* Return an isl_id in "ctx" with the same name and user pointer as "id".
+ * The free_user callback of "id" is not transferred since "id"
+ * remains responsible for freeing the user pointer.
+ * Static isl_ids (with a negative reference count) are shared
+ * by all contexts.
+ * Unless "id" already belongs to "ctx", "id" itself is not modified,
+ * not even its reference count.
+ *
+ * This is called on every identifier of every space of objects
+ * that are handed to or returned from a child context.
+ * Since the hash value of "id" only depends on its name and
+ * user pointer, it is reused rather than recomputed from the name.
+ */
+__isl_give isl_id *isl_id_copy_to_ctx(__isl_keep isl_id *id, isl_ctx *ctx)
+{
+	if (!id)
+		return NULL;
+	if (id->ref < 0 || id->ctx == ctx)
+		return isl_id_copy(id);
+	return id_intern(ctx, id->name, id->user, id->hash);
+}
+
 /* Compare two isl_ids.
  *
  * The order is fairly arbitrary.  We do keep the comparison of
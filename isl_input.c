@@ -33,16 +33,33 @@
 #include <isl/list.h>
 #include <isl_val_private.h>
 
+/* A variable that has been introduced while parsing.
+ * "hash" is the hash value of "name".
+ * "shadow" is the most recently introduced variable with the same name
+ * that was still available when this variable was introduced or
+ * NULL if there is no such variable.
+ * "next" is the variable that was introduced before this one.
+ */
 struct variable {
 	char    	    	*name;
 	int	     		 pos;
+	uint32_t		 hash;
+	struct variable		*shadow;
 	struct variable		*next;
 };
 
+/* The variables that have been introduced while parsing,
+ * with "v" the most recently introduced variable.
+ * "n" is the number of variables.
+ * "table" maps the name of a variable to the most recently introduced
+ * variable with that name, such that identifiers can be looked up
+ * without traversing the entire list of variables.
+ */
 struct vars {
 	struct isl_ctx	*ctx;
 	int		 n;
 	struct variable	*v;
+	struct isl_hash_table	*table;
 };
 
 static struct vars *vars_new(struct isl_ctx *ctx)
@@ -54,6 +71,11 @@ static struct vars *vars_new(struct isl_ctx *ctx)
 	v->ctx = ctx;
 	v->n = 0;
 	v->v = NULL;
+	v->table = isl_hash_table_alloc(ctx, 16);
+	if (!v->table) {
+		free(v);
+		return NULL;
+	}
 	return v;
 }
 
@@ -72,9 +94,46 @@ static void vars_free(struct vars *v)
 	if (!v)
 		return;
 	variable_free(v->v);
+	isl_hash_table_free(v->ctx, v->table);
 	free(v);
 }
 
+/* The name of a variable, along with its length,
+ * for use in has_name.
+ */
+struct vars_name {
+	const char *s;
+	int len;
+};
+
+/* Is the name of the variable "entry" equal to "val"?
+ */
+static isl_bool has_name(const void *entry, const void *val)
+{
+	const struct variable *var = entry;
+	const struct vars_name *name = val;
+
+	return isl_bool_ok(strncmp(var->name, name->s, name->len) == 0 &&
+			    var->name[name->len] == '\0');
+}
+
+/* Look up the entry in v->table for the name "s" of length "len"
+ * with hash value "hash", creating an empty entry if "reserve" is set
+ * and there is no such entry yet.
+ */
+static struct isl_hash_table_entry *vars_find(struct vars *v,
+	const char *s, int len, uint32_t hash, int reserve)
+{
+	struct vars_name name = { s, len };
+
+	return isl_hash_table_find(v->ctx, v->table, hash, &has_name, &name,
+					reserve);
+}
+
+/* Remove the "n" most recently introduced variables from "v".
+ * Any variable that was shadowed by one of these variables
+ * becomes available again.
+ */
 static void vars_drop(struct vars *v, int n)
 {
 	struct variable *var;
@@ -87,6 +146,15 @@ static void vars_drop(struct vars *v, int n)
 	var = v->v;
 	while (--n >= 0) {
 		struct variable *next = var->next;
+		struct isl_hash_table_entry *entry;
+
+		entry = vars_find(v, var->name, strlen(var->name), var->hash, 0);
+		if (entry && entry != isl_hash_table_entry_none) {
+			if (var->shadow)
+				entry->data = var->shadow;
+			else
+				isl_hash_table_remove(v->ctx, v->table, entry);
+		}
 		free(var->name);
 		free(var);
 		var = next;
@@ -94,39 +162,63 @@ static void vars_drop(struct vars *v, int n)
 	v->v = var;
 }
 
+/* Create a new variable with name "name" of length "len" and
+ * position "pos" and add it in front of the variables in "v".
+ * If there already is a variable with this name, then the new variable
+ * shadows the old one until it is removed again.
+ * "hash" is the hash value of the name.
+ * Return the new list of variables or NULL on error,
+ * in which case all variables are removed from "v".
+ */
 static struct variable *variable_new(struct vars *v, const char *name, int len,
-				int pos)
+				int pos, uint32_t hash)
 {
 	struct variable *var;
+	struct isl_hash_table_entry *entry;
+
 	var = isl_calloc_type(v->ctx, struct variable);
 	if (!var)
 		goto error;
-	var->name = strdup(name);
+	var->name = isl_alloc_array(v->ctx, char, len + 1);
+	if (!var->name)
+		goto error;
+	memcpy(var->name, name, len);
 	var->name[len] = '\0';
 	var->pos = pos;
+	var->hash = hash;
 	var->next = v->v;
+	entry = vars_find(v, name, len, hash, 1);
+	if (!entry)
+		goto error;
+	var->shadow = entry->data;
+	entry->data = var;
 	return var;
 error:
-	variable_free(v->v);
+	if (var)
+		free(var->name);
+	free(var);
+	vars_drop(v, v->n);
 	return NULL;
 }
 
 static int vars_pos(struct vars *v, const char *s, int len)
 {
 	int pos;
-	struct variable *q;
+	uint32_t hash;
+	struct isl_hash_table_entry *entry;
 
 	if (len == -1)
 		len = strlen(s);
-	for (q = v->v; q; q = q->next) {
-		if (strncmp(q->name, s, len) == 0 && q->name[len] == '\0')
-			break;
-	}
-	if (q)
+	hash = isl_hash_mem(isl_hash_init(), s, len);
+	entry = vars_find(v, s, len, hash, 0);
+	if (!entry)
+		return -1;
+	if (entry != isl_hash_table_entry_none) {
+		struct variable *q = entry->data;
 		pos = q->pos;
-	else {
+	} else {
 		pos = v->n;
-		v->v = variable_new(v, s, len, v->n);
+		v->v = variable_new(v, s, len, v->n, hash);
 		if (!v->v)
 			return -1;
 		v->n++;
@@ -136,7 +228,9 @@ static int vars_pos(struct vars *v, const char *s, int len)
 
 static int vars_add_anon(struct vars *v)
 {
-	v->v = variable_new(v, "", 0, v->n);
+	uint32_t hash = isl_hash_mem(isl_hash_init(), "", 0);
+
+	v->v = variable_new(v, "", 0, v->n, hash);
 
 	if (!v->v)
 		return -1;
@@ -2897,6 +2991,82 @@ static struct isl_obj obj_read_disjuncts(__isl_keep isl_stream *s,
 	return obj;
 }
 
+/* Read the part of an object in isl format up to and including
+ * the opening brace, where "tok" is the first token of the object.
+ * That is, read the optional parameter declaration,
+ * the opening brace and an optional declaration of symbolic constants.
+ * "v" contains a description of the identifiers parsed so far and
+ * "map" is the universe of the initial parameter space.
+ * Return a map that contains information about the parameters.
+ */
+static __isl_give isl_map *read_obj_prefix(__isl_keep isl_stream *s,
+	struct isl_token *tok, __isl_take isl_map *map, struct vars *v)
+{
+	if (tok->type == '[') {
+		isl_stream_push_token(s, tok);
+		map = read_map_tuple(s, map, isl_dim_param, v, 0, 0);
+		if (!map)
+			return NULL;
+		tok = isl_stream_next_token(s);
+		if (!tok || tok->type != ISL_TOKEN_TO) {
+			isl_stream_error(s, tok, "expecting '->'");
+			if (tok)
+				isl_stream_push_token(s, tok);
+			return isl_map_free(map);
+		}
+		isl_token_free(tok);
+		tok = isl_stream_next_token(s);
+	}
+	if (!tok || tok->type != '{') {
+		isl_stream_error(s, tok, "expecting '{'");
+		if (tok)
+			isl_stream_push_token(s, tok);
+		return isl_map_free(map);
+	}
+	isl_token_free(tok);
+
+	tok = isl_stream_next_token(s);
+	if (!tok)
+		;
+	else if (tok->type == ISL_TOKEN_IDENT && !strcmp(tok->u.s, "Sym")) {
+		isl_token_free(tok);
+		if (isl_stream_eat(s, '='))
+			return isl_map_free(map);
+		map = read_map_tuple(s, map, isl_dim_param, v, 0, 1);
+	} else
+		isl_stream_push_token(s, tok);
+
+	return map;
+}
+
+/* Align the parameters of "obj" to the canonical parameters
+ * of the isl_ctx of "s", if any, such that all objects read
+ * in this isl_ctx have the same (leading) parameters in the same order.
+ * This is only performed for sets, maps and their unions.
+ */
+static struct isl_obj obj_align_canonical_params(__isl_keep isl_stream *s,
+	struct isl_obj obj)
+{
+	isl_space *space;
+
+	if (!obj.v || !s->ctx->canonical_params)
+		return obj;
+
+	space = isl_ctx_get_canonical_params(s->ctx);
+	if (obj.type == isl_obj_set)
+		obj.v = isl_set_align_params(obj.v, space);
+	else if (obj.type == isl_obj_map)
+		obj.v = isl_map_align_params(obj.v, space);
+	else if (obj.type == isl_obj_union_set)
+		obj.v = isl_union_set_align_params(obj.v, space);
+	else if (obj.type == isl_obj_union_map)
+		obj.v = isl_union_map_align_params(obj.v, space);
+	else
+		isl_space_free(space);
+
+	return obj;
+}
+
 static struct isl_obj obj_read(__isl_keep isl_stream *s)
 {
 	isl_map *map = NULL;
@@ -2945,41 +3115,9 @@ static struct isl_obj obj_read(__isl_keep isl_stream *s)
 		goto error;
 	}
 	map = isl_map_universe(isl_space_params_alloc(s->ctx, 0));
-	if (tok->type == '[') {
-		isl_stream_push_token(s, tok);
-		map = read_map_tuple(s, map, isl_dim_param, v, 0, 0);
-		if (!map)
-			goto error;
-		tok = isl_stream_next_token(s);
-		if (!tok || tok->type != ISL_TOKEN_TO) {
-			isl_stream_error(s, tok, "expecting '->'");
-			if (tok)
-				isl_stream_push_token(s, tok);
-			goto error;
-		}
-		isl_token_free(tok);
-		tok = isl_stream_next_token(s);
-	}
-	if (!tok || tok->type != '{') {
-		isl_stream_error(s, tok, "expecting '{'");
-		if (tok)
-			isl_stream_push_token(s, tok);
+	map = read_obj_prefix(s, tok, map, v);
+	if (!map)
 		goto error;
-	}
-	isl_token_free(tok);
-
-	tok = isl_stream_next_token(s);
-	if (!tok)
-		;
-	else if (tok->type == ISL_TOKEN_IDENT && !strcmp(tok->u.s, "Sym")) {
-		isl_token_free(tok);
-		if (isl_stream_eat(s, '='))
-			goto error;
-		map = read_map_tuple(s, map, isl_dim_param, v, 0, 1);
-		if (!map)
-			goto error;
-	} else
-		isl_stream_push_token(s, tok);
 
 	obj = obj_read_disjuncts(s, v, map);
 	if (obj.type == isl_obj_none || !obj.v)
@@ -2998,7 +3136,7 @@ static struct isl_obj obj_read(__isl_keep isl_stream *s)
 	vars_free(v);
 	isl_map_free(map);
 
-	return obj;
+	return obj_align_canonical_params(s, obj);
 error:
 	isl_map_free(map);
 	obj.type->free(obj.v);
@@ -3075,6 +3213,83 @@ error:
 	return NULL;
 }
 
+/* Read a union map in isl format from "s" and call "fn"
+ * on each of the maps it consists of as soon as it has been read,
+ * without constructing the union map itself.
+ *
+ * Consecutive disjuncts that live in the same space are combined
+ * into a single map before it is passed to "fn".
+ * If the input contains several groups of disjuncts in the same space
+ * that are separated by disjuncts in other spaces, then "fn"
+ * is called on each of these groups separately.
+ * The memory requirements are therefore proportional to the size
+ * of the largest such group rather than to the size
+ * of the entire union map.
+ */
+isl_stat isl_stream_read_union_map_foreach(__isl_keep isl_stream *s,
+	isl_stat (*fn)(__isl_take isl_map *map, void *user), void *user)
+{
+	struct isl_token *tok;
+	struct vars *v;
+	isl_map *params, *map = NULL;
+
+	tok = next_token(s);
+	if (!tok) {
+		isl_stream_error(s, NULL, "unexpected EOF");
+		return isl_stat_error;
+	}
+	v = vars_new(s->ctx);
+	if (!v) {
+		isl_stream_push_token(s, tok);
+		return isl_stat_error;
+	}
+	params = isl_map_universe(isl_space_params_alloc(s->ctx, 0));
+	params = read_obj_prefix(s, tok, params, v);
+	if (!params)
+		goto error;
+
+	while (!isl_stream_next_token_is(s, '}')) {
+		struct isl_obj obj;
+
+		obj = obj_read_body(s, isl_map_copy(params), v);
+		if (obj.type == isl_obj_none || !obj.v)
+			goto error;
+		if (obj.type != isl_obj_map) {
+			obj.type->free(obj.v);
+			isl_die(s->ctx, isl_error_invalid, "expecting map",
+				goto error);
+		}
+		if (map && isl_map_has_equal_space(map, obj.v)) {
+			map = isl_map_union(map, obj.v);
+		} else {
+			if (map && fn(map, user) < 0) {
+				map = obj.v;
+				goto error;
+			}
+			map = obj.v;
+		}
+		if (!map)
+			goto error;
+		if (!isl_stream_eat_if_available(s, ';'))
+			break;
+	}
+
+	if (isl_stream_eat(s, '}'))
+		goto error;
+
+	vars_free(v);
+	isl_map_free(params);
+
+	if (map && fn(map, user) < 0)
+		return isl_stat_error;
+	return isl_stat_ok;
+error:
+	isl_map_free(map);
+	isl_map_free(params);
+	vars_free(v);
+	return isl_stat_error;
+}
+
 /* Extract an isl_union_set from "obj".
  * This only works if the object was detected as either a set
  * (in which case it is converted to a union set) or a union set.
@@ -3583,6 +3798,9 @@ __isl_give isl_pw_aff *isl_stream_read_pw_aff(__isl_keep isl_stream *s)
 
 	vars_free(v);
 	isl_set_free(dom);
+	if (s->ctx->canonical_params)
+		pa = isl_pw_aff_align_params(pa,
+				isl_ctx_get_canonical_params(s->ctx));
 	return pa;
 error:
 	vars_free(v);
@@ -3772,6 +3990,9 @@ __isl_give isl_union_pw_multi_aff *isl_stream_read_union_pw_multi_aff(
 
 	isl_set_free(dom);
 	vars_free(v);
+	if (s->ctx->canonical_params)
+		upma = isl_union_pw_multi_aff_align_params(upma,
+				isl_ctx_get_canonical_params(s->ctx));
 	return upma;
 error:
 	isl_union_pw_multi_aff_free(upma);
@@ -3958,6 +4179,9 @@ __isl_give isl_multi_aff *isl_stream_read_multi_aff(__isl_keep isl_stream *s)
 	isl_multi_pw_aff_free(tuple);
 	vars_free(v);
 	isl_set_free(dom);
+	if (s->ctx->canonical_params)
+		ma = isl_multi_aff_align_params(ma,
+				isl_ctx_get_canonical_params(s->ctx));
 	return ma;
 error:
 	isl_multi_pw_aff_free(tuple);
@@ -4047,6 +4271,9 @@ __isl_give isl_multi_pw_aff *isl_stream_read_multi_pw_aff(
 	isl_multi_pw_aff_free(tuple);
 	vars_free(v);
 	mpa = isl_multi_pw_aff_intersect_domain(mpa, dom);
+	if (s->ctx->canonical_params)
+		mpa = isl_multi_pw_aff_align_params(mpa,
+				isl_ctx_get_canonical_params(s->ctx));
 	return mpa;
 error:
 	isl_multi_pw_aff_free(tuple);
@@ -4137,6 +4364,9 @@ __isl_give isl_union_pw_aff *isl_stream_read_union_pw_aff(
 
 	vars_free(v);
 	isl_set_free(dom);
+	if (s->ctx->canonical_params)
+		upa = isl_union_pw_aff_align_params(upa,
+				isl_ctx_get_canonical_params(s->ctx));
 	return upa;
 error:
 	vars_free(v);
@@ -4427,20 +4657,25 @@ __isl_give isl_multi_union_pw_aff *isl_stream_read_multi_union_pw_aff(
 {
 	isl_multi_union_pw_aff *mupa;
 
-	if (!isl_stream_next_token_is(s, '('))
-		return read_multi_union_pw_aff_core(s);
-
-	if (isl_stream_eat(s, '(') < 0)
-		return NULL;
-	mupa = read_multi_union_pw_aff_core(s);
-	if (isl_stream_eat_if_available(s, ':')) {
-		isl_union_set *dom;
+	if (!isl_stream_next_token_is(s, '(')) {
+		mupa = read_multi_union_pw_aff_core(s);
+	} else {
+		if (isl_stream_eat(s, '(') < 0)
+			return NULL;
+		mupa = read_multi_union_pw_aff_core(s);
+		if (isl_stream_eat_if_available(s, ':')) {
+			isl_union_set *dom;
 
-		dom = isl_stream_read_union_set(s);
-		mupa = isl_multi_union_pw_aff_intersect_domain(mupa, dom);
+			dom = isl_stream_read_union_set(s);
+			mupa = isl_multi_union_pw_aff_intersect_domain(mupa,
+									dom);
+		}
+		if (isl_stream_eat(s, ')') < 0)
+			return isl_multi_union_pw_aff_free(mupa);
 	}
-	if (isl_stream_eat(s, ')') < 0)
-		return isl_multi_union_pw_aff_free(mupa);
+	if (s->ctx->canonical_params)
+		mupa = isl_multi_union_pw_aff_align_params(mupa,
+				isl_ctx_get_canonical_params(s->ctx));
 	return mupa;
 }
 
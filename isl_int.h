@@ -16,17 +16,17 @@
 #include <string.h>
 #include <isl_config.h>
 
+#ifdef USE_SMALL_INT_OPT
+#include <isl_int_sioimath.h>
+#else /* USE_SMALL_INT_OPT */
 #ifdef USE_GMP_FOR_MP
 #include <isl_int_gmp.h>
 #endif
 
 #ifdef USE_IMATH_FOR_MP
-#ifdef USE_SMALL_INT_OPT
-#include <isl_int_sioimath.h>
-#else /* USE_SMALL_INT_OPT */
 #include <isl_int_imath.h>
-#endif /* USE_SMALL_INT_OPT */
 #endif /* USE_IMATH_FOR_MP */
+#endif /* USE_SMALL_INT_OPT */
 
 #define isl_int_is_zero(i)	(isl_int_sgn(i) == 0)
 #define isl_int_is_one(i)	(isl_int_cmp_si(i,1) == 0)
@@ -48,5 +48,7 @@
 
 __isl_give isl_printer *isl_printer_print_isl_int(__isl_take isl_printer *p,
 	isl_int i);
+void isl_int_gcdext(isl_int *g, isl_int *x, isl_int *y,
+	isl_int a, isl_int b);
 
 #endif /* ISL_INT_H */
@@ -3,17 +3,23 @@
 
 #include <isl_int.h>
 
-extern int isl_sioimath_decode(isl_sioimath val, int32_t *small, mp_int *big);
+extern int isl_sioimath_decode(isl_sioimath val, int64_t *small, mp_int *big);
 extern int isl_sioimath_decode_big(isl_sioimath val, mp_int *big);
-extern int isl_sioimath_decode_small(isl_sioimath val, int32_t *small);
+extern int isl_sioimath_decode_small(isl_sioimath val, int64_t *small);
 
-extern isl_sioimath isl_sioimath_encode_small(int32_t val);
+extern isl_sioimath isl_sioimath_encode_small(int64_t val);
 extern isl_sioimath isl_sioimath_encode_big(mp_int val);
 extern int isl_sioimath_is_small(isl_sioimath val);
 extern int isl_sioimath_is_big(isl_sioimath val);
-extern int32_t isl_sioimath_get_small(isl_sioimath val);
+extern int64_t isl_sioimath_get_small(isl_sioimath val);
 extern mp_int isl_sioimath_get_big(isl_sioimath val);
 
+extern int64_t isl_sioimath_abs64(int64_t val);
+extern int isl_sioimath_mul_int64_overflow(int64_t lhs, int64_t rhs,
+	int64_t *res);
+extern int isl_sioimath_add_int64_overflow(int64_t lhs, int64_t rhs,
+	int64_t *res);
+
 extern void isl_siomath_uint32_to_digits(uint32_t num, mp_digit *digits,
 	mp_size *used);
 extern void isl_siomath_ulong_to_digits(unsigned long num, mp_digit *digits,
@@ -21,6 +27,8 @@ extern void isl_siomath_ulong_to_digits(unsigned long num, mp_digit *digits,
 extern void isl_siomath_uint64_to_digits(uint64_t num, mp_digit *digits,
 	mp_size *used);
 
+extern mp_int isl_sioimath_scratch_big(isl_sioimath_scratchspace_t *scratch,
+	int neg, mp_size used);
 extern mp_int isl_sioimath_bigarg_src(isl_sioimath arg,
 	isl_sioimath_scratchspace_t *scratch);
 extern mp_int isl_sioimath_siarg_src(signed long arg,
@@ -30,7 +38,7 @@ extern mp_int isl_sioimath_si64arg_src(int64_t arg,
 extern mp_int isl_sioimath_uiarg_src(unsigned long arg,
 	isl_sioimath_scratchspace_t *scratch);
 extern mp_int isl_sioimath_reinit_big(isl_sioimath_ptr ptr);
-extern void isl_sioimath_set_small(isl_sioimath_ptr ptr, int32_t val);
+extern void isl_sioimath_set_small(isl_sioimath_ptr ptr, int64_t val);
 extern void isl_sioimath_set_int32(isl_sioimath_ptr ptr, int32_t val);
 extern void isl_sioimath_set_int64(isl_sioimath_ptr ptr, int64_t val);
 extern void isl_sioimath_promote(isl_sioimath_ptr dst);
@@ -69,6 +77,8 @@ extern void isl_sioimath_mul_ui(isl_sioimath_ptr dst, isl_sioimath lhs,
 	unsigned long rhs);
 extern void isl_sioimath_pow_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	unsigned long rhs);
+extern int isl_sioimath_small_addmul(isl_sioimath_src dst,
+	isl_sioimath_src lhs, isl_sioimath_src rhs, int64_t *res);
 extern void isl_sioimath_addmul(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs);
 extern void isl_sioimath_addmul_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
@@ -81,12 +91,12 @@ extern void isl_sioimath_submul_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 /* Implements the Euclidean algorithm to compute the greatest common divisor of
  * two values in small representation.
  */
-static uint32_t isl_sioimath_smallgcd(int32_t lhs, int32_t rhs)
+static uint64_t isl_sioimath_smallgcd(int64_t lhs, int64_t rhs)
 {
-	uint32_t dividend, divisor, remainder;
+	uint64_t dividend, divisor, remainder;
 
-	dividend = labs(lhs);
-	divisor = labs(rhs);
+	dividend = isl_sioimath_abs64(lhs);
+	divisor = isl_sioimath_abs64(rhs);
 	while (divisor) {
 		remainder = dividend % divisor;
 		dividend = divisor;
@@ -103,8 +113,8 @@ static uint32_t isl_sioimath_smallgcd(int32_t lhs, int32_t rhs)
 void isl_sioimath_gcd(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
-	int32_t lhssmall, rhssmall;
-	uint32_t smallgcd;
+	int64_t lhssmall, rhssmall;
+	uint64_t smallgcd;
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
@@ -121,13 +131,16 @@ void isl_sioimath_gcd(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 }
 
 /* Compute the lowest common multiple of two numbers.
+ *
+ * If both numbers are in small representation, then the result
+ * is computed in int64_t arithmetic, unless it overflows.
  */
 void isl_sioimath_lcm(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
-	int32_t lhssmall, rhssmall;
-	uint32_t smallgcd;
-	uint64_t multiple;
+	int64_t lhssmall, rhssmall;
+	int64_t smallgcd;
+	int64_t multiple;
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
@@ -137,9 +150,12 @@ void isl_sioimath_lcm(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 			return;
 		}
 		smallgcd = isl_sioimath_smallgcd(lhssmall, rhssmall);
-		multiple = (uint64_t) abs(lhssmall) * (uint64_t) abs(rhssmall);
-		isl_sioimath_set_int64(dst, multiple / smallgcd);
-		return;
+		if (!isl_sioimath_mul_int64_overflow(
+			    isl_sioimath_abs64(lhssmall) / smallgcd,
+			    isl_sioimath_abs64(rhssmall), &multiple)) {
+			isl_sioimath_set_int64(dst, multiple);
+			return;
+		}
 	}
 
 	impz_lcm(isl_sioimath_reinit_big(dst),
@@ -148,6 +164,168 @@ void isl_sioimath_lcm(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_try_demote(dst);
 }
 
+/* Return the largest absolute value of the "len" elements of "p"
+ * if they are all in small representation and -1 otherwise.
+ *
+ * The loop does not exit early and does not branch on the representation
+ * of the elements such that it can be vectorized.  The absolute value
+ * computed for an element in big representation is meaningless,
+ * but it is only used if all elements turn out to be small.
+ */
+static int64_t isl_sioimath_seq_small_abs_max(isl_sioimath *p, unsigned len)
+{
+	unsigned i;
+	isl_sioimath tag = 1;
+	uint64_t max = 0;
+
+	for (i = 0; i < len; ++i) {
+		int64_t small = isl_sioimath_get_small(p[i]);
+		uint64_t abs = small < 0 ? -(uint64_t) small : small;
+
+		tag &= p[i];
+		max = abs > max ? abs : max;
+	}
+
+	if (!isl_sioimath_is_small(tag))
+		return -1;
+	return max;
+}
+
+/* Compute dst = m1 * src1 + m2 * src2 for rows of length "len"
+ * with all elements of "dst", "src1" and "src2" in small representation,
+ * provided the results can be shown to fit in small representation.
+ * Return 1 if the result was computed and 0 otherwise.
+ *
+ * A single bound |m1| * max |src1| + |m2| * max |src2| is checked
+ * for the entire row, such that the main loop does not need
+ * any overflow checks.  "dst" may be equal to "src1" or "src2".
+ */
+static int isl_sioimath_seq_combine_int64(isl_sioimath *dst, int64_t m1,
+	isl_sioimath *src1, int64_t m2, isl_sioimath *src2, unsigned len)
+{
+	unsigned i;
+	int64_t max1, max2, bound1, bound2, bound;
+
+	max1 = isl_sioimath_seq_small_abs_max(src1, len);
+	max2 = isl_sioimath_seq_small_abs_max(src2, len);
+	if (max1 < 0 || max2 < 0)
+		return 0;
+	if (dst != src1 && dst != src2 &&
+	    isl_sioimath_seq_small_abs_max(dst, len) < 0)
+		return 0;
+	if (isl_sioimath_mul_int64_overflow(isl_sioimath_abs64(m1), max1,
+					    &bound1) ||
+	    isl_sioimath_mul_int64_overflow(isl_sioimath_abs64(m2), max2,
+					    &bound2) ||
+	    isl_sioimath_add_int64_overflow(bound1, bound2, &bound) ||
+	    bound > ISL_SIOIMATH_SMALL_MAX)
+		return 0;
+
+	for (i = 0; i < len; ++i)
+		dst[i] = isl_sioimath_encode_small(
+			    m1 * isl_sioimath_get_small(src1[i]) +
+			    m2 * isl_sioimath_get_small(src2[i]));
+
+	return 1;
+}
+
+/* Compute dst = m1 * src1 + m2 * src2 if all inputs are
+ * in small representation and the result is known to fit.
+ * Return 1 if the result was computed and 0 otherwise,
+ * in which case "dst" has not been modified.
+ */
+int isl_sioimath_seq_combine_small(isl_sioimath *dst, isl_sioimath_src m1,
+	isl_sioimath *src1, isl_sioimath_src m2, isl_sioimath *src2,
+	unsigned len)
+{
+	int64_t small1, small2;
+
+	if (!isl_sioimath_decode_small(m1, &small1) ||
+	    !isl_sioimath_decode_small(m2, &small2))
+		return 0;
+	return isl_sioimath_seq_combine_int64(dst, small1, src1,
+						small2, src2, len);
+}
+
+/* Compute dst += f * src if all inputs are in small representation
+ * and the result is known to fit.
+ * Return 1 if the result was computed and 0 otherwise.
+ */
+int isl_sioimath_seq_addmul_small(isl_sioimath *dst, isl_sioimath_src f,
+	isl_sioimath *src, unsigned len)
+{
+	int64_t small;
+
+	if (!isl_sioimath_decode_small(f, &small))
+		return 0;
+	return isl_sioimath_seq_combine_int64(dst, 1, dst, small, src, len);
+}
+
+/* Compute dst -= f * src if all inputs are in small representation
+ * and the result is known to fit.
+ * Return 1 if the result was computed and 0 otherwise.
+ */
+int isl_sioimath_seq_submul_small(isl_sioimath *dst, isl_sioimath_src f,
+	isl_sioimath *src, unsigned len)
+{
+	int64_t small;
+
+	if (!isl_sioimath_decode_small(f, &small))
+		return 0;
+	return isl_sioimath_seq_combine_int64(dst, 1, dst, -small, src, len);
+}
+
+/* Compute the inner product of "p1" and "p2" in "prod"
+ * if all elements are in small representation and
+ * len * max |p1| * max |p2| fits in small representation.
+ * Return 1 if the result was computed and 0 otherwise.
+ */
+int isl_sioimath_seq_inner_product_small(isl_sioimath *p1, isl_sioimath *p2,
+	unsigned len, isl_sioimath_ptr prod)
+{
+	unsigned i;
+	int64_t max1, max2, bound;
+	int64_t sum = 0;
+
+	max1 = isl_sioimath_seq_small_abs_max(p1, len);
+	max2 = isl_sioimath_seq_small_abs_max(p2, len);
+	if (max1 < 0 || max2 < 0)
+		return 0;
+	if (isl_sioimath_mul_int64_overflow(max1, max2, &bound) ||
+	    isl_sioimath_mul_int64_overflow(bound, len, &bound) ||
+	    bound > ISL_SIOIMATH_SMALL_MAX)
+		return 0;
+
+	for (i = 0; i < len; ++i)
+		sum += isl_sioimath_get_small(p1[i]) *
+			isl_sioimath_get_small(p2[i]);
+
+	isl_sioimath_set_small(prod, sum);
+	return 1;
+}
+
+/* Compute the greatest common divisor of the "len" elements of "p"
+ * in "gcd" if they are all in small representation.
+ * Return 1 if the result was computed and 0 otherwise.
+ *
+ * The computation stops as soon as the greatest common divisor is one.
+ */
+int isl_sioimath_seq_gcd_small(isl_sioimath *p, unsigned len,
+	isl_sioimath_ptr gcd)
+{
+	unsigned i;
+	uint64_t g = 0;
+
+	if (isl_sioimath_seq_small_abs_max(p, len) < 0)
+		return 0;
+
+	for (i = 0; g != 1 && i < len; ++i)
+		g = isl_sioimath_smallgcd(g, isl_sioimath_get_small(p[i]));
+
+	isl_sioimath_set_small(gcd, g);
+	return 1;
+}
+
 extern void isl_sioimath_tdiv_q(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs);
 extern void isl_sioimath_tdiv_q_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
@@ -164,15 +342,16 @@ extern void isl_sioimath_fdiv_r(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs);
 
 /* Parse a number from a string.
- * If it has less than 10 characters then it will fit into the small
- * representation (i.e. strlen("2147483647")). Otherwise, let IMath parse it.
+ * If it has less than 19 characters then it will fit into the small
+ * representation (i.e. strlen("4611686018427387903")).
+ * Otherwise, let IMath parse it.
  */
 void isl_sioimath_read(isl_sioimath_ptr dst, const char *str)
 {
-	int32_t small;
+	int64_t small;
 
-	if (strlen(str) < 10) {
-		small = strtol(str, NULL, 10);
+	if (strlen(str) < 19) {
+		small = strtoll(str, NULL, 10);
 		isl_sioimath_set_small(dst, small);
 		return;
 	}
@@ -198,12 +377,12 @@ extern void isl_sioimath_print(FILE *out, isl_sioimath_src i, int width);
 void isl_sioimath_print(FILE *out, isl_sioimath_src i, int width)
 {
 	size_t len;
-	int32_t small;
+	int64_t small;
 	mp_int big;
 	char *buf;
 
 	if (isl_sioimath_decode_small(i, &small)) {
-		fprintf(out, "%*" PRIi32, width, small);
+		fprintf(out, "%*" PRIi64, width, small);
 		return;
 	}
 
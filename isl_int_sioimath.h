@@ -15,7 +15,11 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#ifdef USE_GMP_FOR_MP
+#include <isl_sioimath_gmp.h>
+#else
 #include <isl_imath.h>
+#endif
 #include <isl/hash.h>
 
 #define ARRAY_SIZE(array) (sizeof(array)/sizeof(*array))
@@ -29,11 +33,11 @@
 #endif
 
 /* The type to represent integers optimized for small values. It is either a
- * pointer to an mp_int ( = mpz_t*; big representation) or an int32_t (small
- * represenation) with a discriminator at the least significant bit. In big
- * representation it will be always zero because of heap alignment. It is set
- * to 1 for small representation and use the 32 most significant bits for the
- * int32_t.
+ * pointer to an mp_int ( = mpz_t*; big representation) or a 63-bit integer
+ * (small represenation) with a discriminator at the least significant bit.
+ * In big representation it will be always zero because of heap alignment.
+ * It is set to 1 for small representation and use the 63 most significant bits
+ * for the two's complement representation of the integer.
  *
  * Structure on 64 bit machines, with 8-byte aligment (3 bits):
  *
@@ -44,30 +48,38 @@
  * |                           != NULL                            |
  *
  * Small representation:
- * MSB                           32                             LSB
- * |------------------------------|00000000000000000000000000000001
- * |          int32_t             |
- * |  2147483647 ... -2147483647  |
+ * MSB                                                          LSB
+ * |--------------------------------------------------------------1
+ * |                       63-bit integer                       |
+ * |      4611686018427387903 ... -4611686018427387903          |
  *                                                                ^
  *                                                                |
  *                                                        discriminator bit
  *
  * On 32 bit machines isl_sioimath type is blown up to 8 bytes, i.e.
  * isl_sioimath is guaranteed to be at least 8 bytes. This is to ensure the
- * int32_t can be hidden in that type without data loss. In the future we might
- * optimize this to use 31 hidden bits in a 32 bit pointer. We may also use 63
- * bits on 64 bit machines, but this comes with the cost of additional overflow
- * checks because there is no standardized 128 bit integer we could expand to.
+ * 63-bit integer can be hidden in that type without data loss.
+ * Since the sum of two numbers in small representation always fits
+ * in an int64_t, additions and subtractions can be performed on int64_t
+ * without overflow checks.  Products and other operations that may
+ * overflow an int64_t are checked using isl_sioimath_mul_int64_overflow and
+ * isl_sioimath_add_int64_overflow, which use the compiler builtins
+ * when available.
  *
  * We use native integer types and avoid union structures to avoid assumptions
  * on the machine's endianness.
  *
  * This implementation makes the following assumptions:
- * - long can represent any int32_t
+ * - int64_t can represent any long
+ * - right shifts of negative signed integers are arithmetic shifts
  * - mp_small is signed long
  * - mp_usmall is unsigned long
  * - adresses returned by malloc are aligned to 2-byte boundaries (leastmost
  *   bit is zero)
+ *
+ * The big representation is normally an IMath value, but it is a GMP value
+ * if USE_GMP_FOR_MP is defined.  In the latter case, isl_sioimath_gmp.h
+ * provides the subset of the IMath interface used below on top of GMP.
  */
 #if UINT64_MAX > UINTPTR_MAX
 typedef uint64_t isl_sioimath;
@@ -75,21 +87,21 @@ typedef uint64_t isl_sioimath;
 typedef uintptr_t isl_sioimath;
 #endif
 
-/* The negation of the smallest possible number in int32_t, INT32_MIN
- * (0x80000000u, -2147483648), cannot be represented in an int32_t, therefore
+/* The negation of the smallest possible number in a 63-bit integer,
+ * -2^62, cannot be represented in a 63-bit integer, therefore
  * every operation that may produce this value needs to special-case it.
  * The operations are:
- * abs(INT32_MIN)
- * -INT32_MIN   (negation)
- * -1 * INT32_MIN (multiplication)
- * INT32_MIN/-1 (any division: divexact, fdiv, cdiv, tdiv)
- * To avoid checking these cases, we exclude INT32_MIN from small
+ * abs(-2^62)
+ * -(-2^62)   (negation)
+ * -1 * -2^62 (multiplication)
+ * -2^62/-1 (any division: divexact, fdiv, cdiv, tdiv)
+ * To avoid checking these cases, we exclude -2^62 from small
  * representation.
  */
-#define ISL_SIOIMATH_SMALL_MIN (-INT32_MAX)
+#define ISL_SIOIMATH_SMALL_MIN (-ISL_SIOIMATH_SMALL_MAX)
 
 /* Largest possible number in small representation */
-#define ISL_SIOIMATH_SMALL_MAX INT32_MAX
+#define ISL_SIOIMATH_SMALL_MAX (INT64_MAX >> 1)
 
 /* Used for function parameters the function modifies. */
 typedef isl_sioimath *isl_sioimath_ptr;
@@ -114,9 +126,9 @@ inline int isl_sioimath_is_big(isl_sioimath val)
 /* Get the number of an isl_int in small representation. Result is undefined if
  * val is not stored in that format.
  */
-inline int32_t isl_sioimath_get_small(isl_sioimath val)
+inline int64_t isl_sioimath_get_small(isl_sioimath val)
 {
-	return val >> 32;
+	return ((int64_t) val) >> 1;
 }
 
 /* Get the number of an in isl_int in big representation. Result is undefined if
@@ -133,7 +145,7 @@ inline mp_int isl_sioimath_get_big(isl_sioimath val)
  * representation. If there is no such branch, then a single shift is still
  * cheaper than introducing branching code.
  */
-inline int isl_sioimath_decode_small(isl_sioimath val, int32_t *small)
+inline int isl_sioimath_decode_small(isl_sioimath val, int64_t *small)
 {
 	*small = isl_sioimath_get_small(val);
 	return isl_sioimath_is_small(val);
@@ -149,9 +161,9 @@ inline int isl_sioimath_decode_big(isl_sioimath val, mp_int *big)
 
 /* Encode a small representation into an isl_int.
  */
-inline isl_sioimath isl_sioimath_encode_small(int32_t val)
+inline isl_sioimath isl_sioimath_encode_small(int64_t val)
 {
-	return ((isl_sioimath) val) << 32 | 0x00000001;
+	return ((isl_sioimath) val) << 1 | 0x00000001;
 }
 
 /* Encode a big representation.
@@ -161,6 +173,60 @@ inline isl_sioimath isl_sioimath_encode_big(mp_int val)
 	return (isl_sioimath)(uintptr_t) val;
 }
 
+/* Return the absolute value of "val", which is assumed to be
+ * in the range of the small representation.
+ */
+inline int64_t isl_sioimath_abs64(int64_t val)
+{
+	return val < 0 ? -val : val;
+}
+
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+/* Store the product of "lhs" and "rhs" in "res" and
+ * return whether this product overflows an int64_t.
+ */
+inline int isl_sioimath_mul_int64_overflow(int64_t lhs, int64_t rhs,
+	int64_t *res)
+{
+	return __builtin_mul_overflow(lhs, rhs, res);
+}
+
+/* Store the sum of "lhs" and "rhs" in "res" and
+ * return whether this sum overflows an int64_t.
+ */
+inline int isl_sioimath_add_int64_overflow(int64_t lhs, int64_t rhs,
+	int64_t *res)
+{
+	return __builtin_add_overflow(lhs, rhs, res);
+}
+#else
+/* Store the product of "lhs" and "rhs" in "res" and
+ * return whether this product overflows an int64_t.
+ * Neither "lhs" nor "rhs" is allowed to be equal to INT64_MIN.
+ */
+inline int isl_sioimath_mul_int64_overflow(int64_t lhs, int64_t rhs,
+	int64_t *res)
+{
+	if (lhs != 0 &&
+	    isl_sioimath_abs64(rhs) > INT64_MAX / isl_sioimath_abs64(lhs))
+		return 1;
+	*res = lhs * rhs;
+	return 0;
+}
+
+/* Store the sum of "lhs" and "rhs" in "res" and
+ * return whether this sum overflows an int64_t.
+ */
+inline int isl_sioimath_add_int64_overflow(int64_t lhs, int64_t rhs,
+	int64_t *res)
+{
+	if (rhs > 0 ? lhs > INT64_MAX - rhs : lhs < INT64_MIN - rhs)
+		return 1;
+	*res = lhs + rhs;
+	return 0;
+}
+#endif
+
 /* A common situation is to call an IMath function with at least one argument
  * that is currently in small representation or an integer parameter, i.e. a big
  * representation of the same number is required. Promoting the original
@@ -235,6 +301,31 @@ inline void isl_siomath_uint64_to_digits(uint64_t num, mp_digit *digits,
 	ISL_SIOIMATH_TO_DIGITS(num, digits, *used);
 }
 
+/* Set up the big representation in "scratch" of a number
+ * with the "used" digits stored in scratch->digits and sign "neg".
+ *
+ * With GMP, the number of digits is stored in the size field,
+ * with the sign of the number, and zero is represented by a size of zero.
+ */
+inline mp_int isl_sioimath_scratch_big(isl_sioimath_scratchspace_t *scratch,
+	int neg, mp_size used)
+{
+#ifdef USE_GMP_FOR_MP
+	if (used == 1 && scratch->digits[0] == 0)
+		used = 0;
+	scratch->big->_mp_d = scratch->digits;
+	scratch->big->_mp_alloc = ARRAY_SIZE(scratch->digits);
+	scratch->big->_mp_size = neg ? -used : used;
+	return scratch->big;
+#else
+	scratch->big.digits = scratch->digits;
+	scratch->big.alloc = ARRAY_SIZE(scratch->digits);
+	scratch->big.sign = neg ? MP_NEG : MP_ZPOS;
+	scratch->big.used = used;
+	return &scratch->big;
+#endif
+}
+
 /* Get the IMath representation of an isl_int without modifying it.
  * For the case it is not in big representation yet, pass some scratch space we
  * can use to store the big representation in.
@@ -248,25 +339,18 @@ inline mp_int isl_sioimath_bigarg_src(isl_sioimath arg,
 	isl_sioimath_scratchspace_t *scratch)
 {
 	mp_int big;
-	int32_t small;
-	uint32_t num;
+	int64_t small;
+	uint64_t num;
+	mp_size used;
 
 	if (isl_sioimath_decode_big(arg, &big))
 		return big;
 
 	small = isl_sioimath_get_small(arg);
-	scratch->big.digits = scratch->digits;
-	scratch->big.alloc = ARRAY_SIZE(scratch->digits);
-	if (small >= 0) {
-		scratch->big.sign = MP_ZPOS;
-		num = small;
-	} else {
-		scratch->big.sign = MP_NEG;
-		num = -small;
-	}
+	num = small >= 0 ? small : -small;
 
-	isl_siomath_uint32_to_digits(num, scratch->digits, &scratch->big.used);
-	return &scratch->big;
+	isl_siomath_uint64_to_digits(num, scratch->digits, &used);
+	return isl_sioimath_scratch_big(scratch, small < 0, used);
 }
 
 /* Create a temporary IMath mp_int for a signed long.
@@ -275,19 +359,15 @@ inline mp_int isl_sioimath_siarg_src(signed long arg,
 	isl_sioimath_scratchspace_t *scratch)
 {
 	unsigned long num;
+	mp_size used;
 
-	scratch->big.digits = scratch->digits;
-	scratch->big.alloc = ARRAY_SIZE(scratch->digits);
-	if (arg >= 0) {
-		scratch->big.sign = MP_ZPOS;
+	if (arg >= 0)
 		num = arg;
-	} else {
-		scratch->big.sign = MP_NEG;
+	else
 		num = (arg == LONG_MIN) ? ((unsigned long) LONG_MAX) + 1 : -arg;
-	}
 
-	isl_siomath_ulong_to_digits(num, scratch->digits, &scratch->big.used);
-	return &scratch->big;
+	isl_siomath_ulong_to_digits(num, scratch->digits, &used);
+	return isl_sioimath_scratch_big(scratch, arg < 0, used);
 }
 
 /* Create a temporary IMath mp_int for an int64_t.
@@ -296,19 +376,15 @@ inline mp_int isl_sioimath_si64arg_src(int64_t arg,
 	isl_sioimath_scratchspace_t *scratch)
 {
 	uint64_t num;
+	mp_size used;
 
-	scratch->big.digits = scratch->digits;
-	scratch->big.alloc = ARRAY_SIZE(scratch->digits);
-	if (arg >= 0) {
-		scratch->big.sign = MP_ZPOS;
+	if (arg >= 0)
 		num = arg;
-	} else {
-		scratch->big.sign = MP_NEG;
+	else
 		num = (arg == INT64_MIN) ? ((uint64_t) INT64_MAX) + 1 : -arg;
-	}
 
-	isl_siomath_uint64_to_digits(num, scratch->digits, &scratch->big.used);
-	return &scratch->big;
+	isl_siomath_uint64_to_digits(num, scratch->digits, &used);
+	return isl_sioimath_scratch_big(scratch, arg < 0, used);
 }
 
 /* Create a temporary IMath mp_int for an unsigned long.
@@ -316,12 +392,10 @@ inline mp_int isl_sioimath_si64arg_src(int64_t arg,
 inline mp_int isl_sioimath_uiarg_src(unsigned long arg,
 	isl_sioimath_scratchspace_t *scratch)
 {
-	scratch->big.digits = scratch->digits;
-	scratch->big.alloc = ARRAY_SIZE(scratch->digits);
-	scratch->big.sign = MP_ZPOS;
+	mp_size used;
 
-	isl_siomath_ulong_to_digits(arg, scratch->digits, &scratch->big.used);
-	return &scratch->big;
+	isl_siomath_ulong_to_digits(arg, scratch->digits, &used);
+	return isl_sioimath_scratch_big(scratch, 0, used);
 }
 
 /* Ensure big representation. Does not preserve the current number.
@@ -337,23 +411,18 @@ inline mp_int isl_sioimath_reinit_big(isl_sioimath_ptr ptr)
 
 /* Set ptr to a number in small representation.
  */
-inline void isl_sioimath_set_small(isl_sioimath_ptr ptr, int32_t val)
+inline void isl_sioimath_set_small(isl_sioimath_ptr ptr, int64_t val)
 {
 	if (isl_sioimath_is_big(*ptr))
 		mp_int_free(isl_sioimath_get_big(*ptr));
 	*ptr = isl_sioimath_encode_small(val);
 }
 
-/* Set ptr to val, choosing small representation if possible.
+/* Set ptr to val, which always fits in small representation.
  */
 inline void isl_sioimath_set_int32(isl_sioimath_ptr ptr, int32_t val)
 {
-	if (ISL_SIOIMATH_SMALL_MIN <= val && val <= ISL_SIOIMATH_SMALL_MAX) {
-		isl_sioimath_set_small(ptr, val);
-		return;
-	}
-
-	mp_int_init_value(isl_sioimath_reinit_big(ptr), val);
+	isl_sioimath_set_small(ptr, val);
 }
 
 /* Assign an int64_t number using small representation if possible.
@@ -374,13 +443,15 @@ inline void isl_sioimath_set_int64(isl_sioimath_ptr ptr, int64_t val)
  */
 inline void isl_sioimath_promote(isl_sioimath_ptr dst)
 {
-	int32_t small;
+	int64_t small;
+	isl_sioimath_scratchspace_t scratch;
 
 	if (isl_sioimath_is_big(*dst))
 		return;
 
 	small = isl_sioimath_get_small(*dst);
-	mp_int_set_value(isl_sioimath_reinit_big(dst), small);
+	mp_int_copy(isl_sioimath_si64arg_src(small, &scratch),
+	    isl_sioimath_reinit_big(dst));
 }
 
 /* Convert to small representation while preserving the current number. Does
@@ -445,7 +516,7 @@ inline void isl_sioimath_set_si(isl_sioimath_ptr dst, long val)
  */
 inline void isl_sioimath_set_ui(isl_sioimath_ptr dst, unsigned long val)
 {
-	if (val <= ISL_SIOIMATH_SMALL_MAX) {
+	if ((uint64_t) val <= (uint64_t) ISL_SIOIMATH_SMALL_MAX) {
 		isl_sioimath_set_small(dst, val);
 		return;
 	}
@@ -458,9 +529,10 @@ inline void isl_sioimath_set_ui(isl_sioimath_ptr dst, unsigned long val)
 inline int isl_sioimath_fits_slong(isl_sioimath_src val)
 {
 	mp_small dummy;
+	int64_t small;
 
-	if (isl_sioimath_is_small(val))
-		return 1;
+	if (isl_sioimath_decode_small(val, &small))
+		return LONG_MIN <= small && small <= LONG_MAX;
 
 	return mp_int_to_int(isl_sioimath_get_big(val), &dummy) == MP_OK;
 }
@@ -484,9 +556,10 @@ inline long isl_sioimath_get_si(isl_sioimath_src val)
 inline int isl_sioimath_fits_ulong(isl_sioimath_src val)
 {
 	mp_usmall dummy;
+	int64_t small;
 
-	if (isl_sioimath_is_small(val))
-		return isl_sioimath_get_small(val) >= 0;
+	if (isl_sioimath_decode_small(val, &small))
+		return small >= 0 && (uint64_t) small <= ULONG_MAX;
 
 	return mp_int_to_uint(isl_sioimath_get_big(val), &dummy) == MP_OK;
 }
@@ -510,13 +583,18 @@ inline unsigned long isl_sioimath_get_ui(isl_sioimath_src val)
 inline double isl_sioimath_get_d(isl_sioimath_src val)
 {
 	mp_int big;
+#ifndef USE_GMP_FOR_MP
 	double result = 0;
 	int i;
+#endif
 
 	if (isl_sioimath_is_small(val))
 		return isl_sioimath_get_small(val);
 
 	big = isl_sioimath_get_big(val);
+#ifdef USE_GMP_FOR_MP
+	return mpz_get_d(big);
+#else
 	for (i = 0; i < big->used; ++i)
 		result = result * (double) ((uintmax_t) MP_DIGIT_MAX + 1) +
 		         (double) big->digits[i];
@@ -525,20 +603,21 @@ inline double isl_sioimath_get_d(isl_sioimath_src val)
 		result = -result;
 
 	return result;
+#endif
 }
 
 /* Format a number as decimal string.
  *
- * The largest possible string from small representation is 12 characters
- * ("-2147483647").
+ * The largest possible string from small representation is 21 characters
+ * ("-4611686018427387903").
  */
 inline char *isl_sioimath_get_str(isl_sioimath_src val)
 {
 	char *result;
 
 	if (isl_sioimath_is_small(val)) {
-		result = malloc(12);
-		snprintf(result, 12, "%" PRIi32, isl_sioimath_get_small(val));
+		result = malloc(21);
+		snprintf(result, 21, "%" PRIi64, isl_sioimath_get_small(val));
 		return result;
 	}
 
@@ -550,7 +629,8 @@ inline char *isl_sioimath_get_str(isl_sioimath_src val)
 inline void isl_sioimath_abs(isl_sioimath_ptr dst, isl_sioimath_src arg)
 {
 	if (isl_sioimath_is_small(arg)) {
-		isl_sioimath_set_small(dst, labs(isl_sioimath_get_small(arg)));
+		isl_sioimath_set_small(dst,
+		    isl_sioimath_abs64(isl_sioimath_get_small(arg)));
 		return;
 	}
 
@@ -589,7 +669,7 @@ inline void isl_sioimath_swap(isl_sioimath_ptr lhs, isl_sioimath_ptr rhs)
 inline void isl_sioimath_add_ui(isl_sioimath_ptr dst, isl_sioimath lhs,
 	unsigned long rhs)
 {
-	int32_t smalllhs;
+	int64_t smalllhs;
 	isl_sioimath_scratchspace_t lhsscratch;
 
 	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
@@ -612,11 +692,11 @@ inline void isl_sioimath_add_ui(isl_sioimath_ptr dst, isl_sioimath lhs,
 inline void isl_sioimath_sub_ui(isl_sioimath_ptr dst, isl_sioimath lhs,
 				unsigned long rhs)
 {
-	int32_t smalllhs;
+	int64_t smalllhs;
 	isl_sioimath_scratchspace_t lhsscratch;
 
 	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
-	    (rhs < (uint64_t) INT64_MIN - (uint64_t) ISL_SIOIMATH_SMALL_MIN)) {
+	    (rhs <= (uint64_t) ISL_SIOIMATH_SMALL_MIN - (uint64_t) INT64_MIN)) {
 		isl_sioimath_set_int64(dst, (int64_t) smalllhs - rhs);
 		return;
 	}
@@ -632,12 +712,11 @@ inline void isl_sioimath_add(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
-	int32_t smalllhs, smallrhs;
+	int64_t smalllhs, smallrhs;
 
 	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
 	    isl_sioimath_decode_small(rhs, &smallrhs)) {
-		isl_sioimath_set_int64(
-		    dst, (int64_t) smalllhs + (int64_t) smallrhs);
+		isl_sioimath_set_int64(dst, smalllhs + smallrhs);
 		return;
 	}
 
@@ -653,12 +732,11 @@ inline void isl_sioimath_sub(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
-	int32_t smalllhs, smallrhs;
+	int64_t smalllhs, smallrhs;
 
 	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
 	    isl_sioimath_decode_small(rhs, &smallrhs)) {
-		isl_sioimath_set_int64(
-		    dst, (int64_t) smalllhs - (int64_t) smallrhs);
+		isl_sioimath_set_int64(dst, smalllhs - smallrhs);
 		return;
 	}
 
@@ -674,12 +752,12 @@ inline void isl_sioimath_mul(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
-	int32_t smalllhs, smallrhs;
+	int64_t smalllhs, smallrhs, product;
 
 	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
-	    isl_sioimath_decode_small(rhs, &smallrhs)) {
-		isl_sioimath_set_int64(
-		    dst, (int64_t) smalllhs * (int64_t) smallrhs);
+	    isl_sioimath_decode_small(rhs, &smallrhs) &&
+	    !isl_sioimath_mul_int64_overflow(smalllhs, smallrhs, &product)) {
+		isl_sioimath_set_int64(dst, product);
 		return;
 	}
 
@@ -696,10 +774,11 @@ inline void isl_sioimath_mul_2exp(isl_sioimath_ptr dst, isl_sioimath lhs,
 	unsigned long rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs;
-	int32_t smalllhs;
+	int64_t smalllhs;
 
-	if (isl_sioimath_decode_small(lhs, &smalllhs) && (rhs <= 32ul)) {
-		isl_sioimath_set_int64(dst, ((int64_t) smalllhs) << rhs);
+	if (isl_sioimath_decode_small(lhs, &smalllhs) && (rhs < 63ul) &&
+	    isl_sioimath_abs64(smalllhs) <= (INT64_MAX >> rhs)) {
+		isl_sioimath_set_int64(dst, smalllhs * ((int64_t) 1 << rhs));
 		return;
 	}
 
@@ -713,11 +792,11 @@ inline void isl_sioimath_mul_si(isl_sioimath_ptr dst, isl_sioimath lhs,
 	signed long rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
-	int32_t smalllhs;
+	int64_t smalllhs, product;
 
 	if (isl_sioimath_decode_small(lhs, &smalllhs) && (rhs > LONG_MIN) &&
-	    (labs(rhs) <= UINT32_MAX)) {
-		isl_sioimath_set_int64(dst, (int64_t) smalllhs * (int64_t) rhs);
+	    !isl_sioimath_mul_int64_overflow(smalllhs, rhs, &product)) {
+		isl_sioimath_set_int64(dst, product);
 		return;
 	}
 
@@ -733,10 +812,12 @@ inline void isl_sioimath_mul_ui(isl_sioimath_ptr dst, isl_sioimath lhs,
 	unsigned long rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
-	int32_t smalllhs;
+	int64_t smalllhs, product;
 
-	if (isl_sioimath_decode_small(lhs, &smalllhs) && (rhs <= UINT32_MAX)) {
-		isl_sioimath_set_int64(dst, (int64_t) smalllhs * (int64_t) rhs);
+	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
+	    ((uint64_t) rhs <= (uint64_t) INT64_MAX) &&
+	    !isl_sioimath_mul_int64_overflow(smalllhs, rhs, &product)) {
+		isl_sioimath_set_int64(dst, product);
 		return;
 	}
 
@@ -755,7 +836,7 @@ inline void isl_sioimath_pow_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	unsigned long rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
-	int32_t smalllhs;
+	int64_t smalllhs;
 
 	switch (rhs) {
 	case 0:
@@ -782,7 +863,9 @@ inline void isl_sioimath_pow_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 			isl_sioimath_mul_2exp(dst, *dst, rhs);
 			return;
 		default:
-			if ((MP_SMALL_MIN <= rhs) && (rhs <= MP_SMALL_MAX)) {
+			if ((MP_SMALL_MIN <= smalllhs) &&
+			    (smalllhs <= MP_SMALL_MAX) &&
+			    (rhs <= MP_SMALL_MAX)) {
 				mp_int_expt_value(smalllhs, rhs,
 				    isl_sioimath_reinit_big(dst));
 				isl_sioimath_try_demote(dst);
@@ -797,12 +880,41 @@ inline void isl_sioimath_pow_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_try_demote(dst);
 }
 
+/* Compute dst + lhs * rhs in int64_t arithmetic and store the result in "res"
+ * if all arguments are in small representation and
+ * if the computation does not overflow.
+ * Return whether the result was computed.
+ */
+inline int isl_sioimath_small_addmul(isl_sioimath_src dst,
+	isl_sioimath_src lhs, isl_sioimath_src rhs, int64_t *res)
+{
+	int64_t smalldst, smalllhs, smallrhs, product;
+
+	if (!isl_sioimath_decode_small(dst, &smalldst) ||
+	    !isl_sioimath_decode_small(lhs, &smalllhs) ||
+	    !isl_sioimath_decode_small(rhs, &smallrhs))
+		return 0;
+	if (isl_sioimath_mul_int64_overflow(smalllhs, smallrhs, &product))
+		return 0;
+	return !isl_sioimath_add_int64_overflow(smalldst, product, res);
+}
+
 /* Fused multiply-add.
+ *
+ * If everything fits in small representation, then avoid
+ * the temporary isl_sioimath.
  */
 inline void isl_sioimath_addmul(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath tmp;
+	int64_t res;
+
+	if (isl_sioimath_small_addmul(*dst, lhs, rhs, &res)) {
+		isl_sioimath_set_int64(dst, res);
+		return;
+	}
+
 	isl_sioimath_init(&tmp);
 	isl_sioimath_mul(&tmp, lhs, rhs);
 	isl_sioimath_add(dst, *dst, tmp);
@@ -822,11 +934,26 @@ inline void isl_sioimath_addmul_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 }
 
 /* Fused multiply-subtract.
+ *
+ * If everything fits in small representation, then avoid
+ * the temporary isl_sioimath.
+ * Note that negating a number in small representation
+ * keeps it in small representation.
  */
 inline void isl_sioimath_submul(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath tmp;
+	int64_t res;
+
+	if (isl_sioimath_is_small(rhs) &&
+	    isl_sioimath_small_addmul(*dst, lhs,
+		isl_sioimath_encode_small(-isl_sioimath_get_small(rhs)),
+		&res)) {
+		isl_sioimath_set_int64(dst, res);
+		return;
+	}
+
 	isl_sioimath_init(&tmp);
 	isl_sioimath_mul(&tmp, lhs, rhs);
 	isl_sioimath_sub(dst, *dst, tmp);
@@ -850,13 +977,25 @@ void isl_sioimath_gcd(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 void isl_sioimath_lcm(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 		      isl_sioimath_src rhs);
 
+int isl_sioimath_seq_combine_small(isl_sioimath *dst, isl_sioimath_src m1,
+	isl_sioimath *src1, isl_sioimath_src m2, isl_sioimath *src2,
+	unsigned len);
+int isl_sioimath_seq_addmul_small(isl_sioimath *dst, isl_sioimath_src f,
+	isl_sioimath *src, unsigned len);
+int isl_sioimath_seq_submul_small(isl_sioimath *dst, isl_sioimath_src f,
+	isl_sioimath *src, unsigned len);
+int isl_sioimath_seq_inner_product_small(isl_sioimath *p1, isl_sioimath *p2,
+	unsigned len, isl_sioimath_ptr prod);
+int isl_sioimath_seq_gcd_small(isl_sioimath *p, unsigned len,
+	isl_sioimath_ptr gcd);
+
 /* Divide lhs by rhs, rounding to zero (Truncate).
  */
 inline void isl_sioimath_tdiv_q(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, rhssmall;
+	int64_t lhssmall, rhssmall;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
 	    isl_sioimath_decode_small(rhs, &rhssmall)) {
@@ -877,11 +1016,12 @@ inline void isl_sioimath_tdiv_q_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	unsigned long rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall;
+	int64_t lhssmall;
 
-	if (isl_sioimath_is_small(lhs) && (rhs <= (unsigned long) INT32_MAX)) {
+	if (isl_sioimath_is_small(lhs) &&
+	    ((uint64_t) rhs <= (uint64_t) INT64_MAX)) {
 		lhssmall = isl_sioimath_get_small(lhs);
-		isl_sioimath_set_small(dst, lhssmall / (int32_t) rhs);
+		isl_sioimath_set_small(dst, lhssmall / (int64_t) rhs);
 		return;
 	}
 
@@ -903,18 +1043,16 @@ inline void isl_sioimath_tdiv_q_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 inline void isl_sioimath_cdiv_q(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
-	int32_t lhssmall, rhssmall;
+	int64_t lhssmall, rhssmall;
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t q;
+	int64_t q;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
 	    isl_sioimath_decode_small(rhs, &rhssmall)) {
 		if ((lhssmall >= 0) && (rhssmall >= 0))
-			q = ((int64_t) lhssmall + (int64_t) rhssmall - 1) /
-			    rhssmall;
+			q = (lhssmall + rhssmall - 1) / rhssmall;
 		else if ((lhssmall < 0) && (rhssmall < 0))
-			q = ((int64_t) lhssmall + (int64_t) rhssmall + 1) /
-			    rhssmall;
+			q = (lhssmall + rhssmall + 1) / rhssmall;
 		else
 			q = lhssmall / rhssmall;
 		isl_sioimath_set_small(dst, q);
@@ -934,14 +1072,14 @@ inline void isl_sioimath_cdiv_q_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	unsigned long rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, q;
+	int64_t lhssmall, q;
 
-	if (isl_sioimath_decode_small(lhs, &lhssmall) && (rhs <= INT32_MAX)) {
+	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
+	    ((uint64_t) rhs <= (uint64_t) ISL_SIOIMATH_SMALL_MAX)) {
 		if (lhssmall >= 0)
-			q = ((int64_t) lhssmall + ((int64_t) rhs - 1)) /
-			    (int64_t) rhs;
+			q = (lhssmall + ((int64_t) rhs - 1)) / (int64_t) rhs;
 		else
-			q = lhssmall / (int32_t) rhs;
+			q = lhssmall / (int64_t) rhs;
 		isl_sioimath_set_small(dst, q);
 		return;
 	}
@@ -958,17 +1096,15 @@ inline void isl_sioimath_fdiv_q(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, rhssmall;
-	int32_t q;
+	int64_t lhssmall, rhssmall;
+	int64_t q;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
 	    isl_sioimath_decode_small(rhs, &rhssmall)) {
 		if ((lhssmall < 0) && (rhssmall >= 0))
-			q = ((int64_t) lhssmall - ((int64_t) rhssmall - 1)) /
-			    rhssmall;
+			q = (lhssmall - (rhssmall - 1)) / rhssmall;
 		else if ((lhssmall >= 0) && (rhssmall < 0))
-			q = ((int64_t) lhssmall - ((int64_t) rhssmall + 1)) /
-			    rhssmall;
+			q = (lhssmall - (rhssmall + 1)) / rhssmall;
 		else
 			q = lhssmall / rhssmall;
 		isl_sioimath_set_small(dst, q);
@@ -988,14 +1124,14 @@ inline void isl_sioimath_fdiv_q_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	unsigned long rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, q;
+	int64_t lhssmall, q;
 
-	if (isl_sioimath_decode_small(lhs, &lhssmall) && (rhs <= INT32_MAX)) {
+	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
+	    ((uint64_t) rhs <= (uint64_t) ISL_SIOIMATH_SMALL_MAX)) {
 		if (lhssmall >= 0)
-			q = (uint32_t) lhssmall / rhs;
+			q = (uint64_t) lhssmall / rhs;
 		else
-			q = ((int64_t) lhssmall - ((int64_t) rhs - 1)) /
-			    (int64_t) rhs;
+			q = (lhssmall - ((int64_t) rhs - 1)) / (int64_t) rhs;
 		isl_sioimath_set_small(dst, q);
 		return;
 	}
@@ -1014,7 +1150,7 @@ inline void isl_sioimath_fdiv_r(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
 	int64_t lhssmall, rhssmall;
-	int32_t r;
+	int64_t r;
 
 	if (isl_sioimath_is_small(lhs) && isl_sioimath_is_small(rhs)) {
 		lhssmall = isl_sioimath_get_small(lhs);
@@ -1039,7 +1175,7 @@ void isl_sioimath_read(isl_sioimath_ptr dst, const char *str);
  */
 inline int isl_sioimath_sgn(isl_sioimath_src arg)
 {
-	int32_t small;
+	int64_t small;
 
 	if (isl_sioimath_decode_small(arg, &small))
 		return (small > 0) - (small < 0);
@@ -1055,29 +1191,21 @@ inline int isl_sioimath_sgn(isl_sioimath_src arg)
 inline int isl_sioimath_cmp(isl_sioimath_src lhs, isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, rhssmall;
+	int64_t lhssmall, rhssmall;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
 	    isl_sioimath_decode_small(rhs, &rhssmall))
 		return (lhssmall > rhssmall) - (lhssmall < rhssmall);
 
-	if (isl_sioimath_decode_small(rhs, &rhssmall))
-		return mp_int_compare_value(
-		    isl_sioimath_bigarg_src(lhs, &lhsscratch), rhssmall);
-
-	if (isl_sioimath_decode_small(lhs, &lhssmall))
-		return -mp_int_compare_value(
-		           isl_sioimath_bigarg_src(rhs, &rhsscratch), lhssmall);
-
-	return mp_int_compare(
-	    isl_sioimath_get_big(lhs), isl_sioimath_get_big(rhs));
+	return mp_int_compare(isl_sioimath_bigarg_src(lhs, &lhsscratch),
+	    isl_sioimath_bigarg_src(rhs, &rhsscratch));
 }
 
 /* As isl_sioimath_cmp, but with signed long rhs.
  */
 inline int isl_sioimath_cmp_si(isl_sioimath_src lhs, signed long rhs)
 {
-	int32_t lhssmall;
+	int64_t lhssmall;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall))
 		return (lhssmall > rhs) - (lhssmall < rhs);
@@ -1093,12 +1221,12 @@ inline int isl_sioimath_cmp_si(isl_sioimath_src lhs, signed long rhs)
 inline int isl_sioimath_abs_cmp(isl_sioimath_src lhs, isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, rhssmall;
+	int64_t lhssmall, rhssmall;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
 	    isl_sioimath_decode_small(rhs, &rhssmall)) {
-		lhssmall = labs(lhssmall);
-		rhssmall = labs(rhssmall);
+		lhssmall = isl_sioimath_abs64(lhssmall);
+		rhssmall = isl_sioimath_abs64(rhssmall);
 		return (lhssmall > rhssmall) - (lhssmall < rhssmall);
 	}
 
@@ -1115,8 +1243,8 @@ inline int isl_sioimath_is_divisible_by(isl_sioimath_src lhs,
 					isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, rhssmall;
-	mpz_t rem;
+	int64_t lhssmall, rhssmall;
+	mp_int rem;
 	int cmp;
 
 	if (isl_sioimath_sgn(rhs) == 0)
@@ -1126,15 +1254,16 @@ inline int isl_sioimath_is_divisible_by(isl_sioimath_src lhs,
 	    isl_sioimath_decode_small(rhs, &rhssmall))
 		return lhssmall % rhssmall == 0;
 
-	if (isl_sioimath_decode_small(rhs, &rhssmall))
+	if (isl_sioimath_decode_small(rhs, &rhssmall) &&
+	    MP_SMALL_MIN <= rhssmall && rhssmall <= MP_SMALL_MAX)
 		return mp_int_divisible_value(
 		    isl_sioimath_bigarg_src(lhs, &lhsscratch), rhssmall);
 
-	mp_int_init(&rem);
+	rem = mp_int_alloc();
 	mp_int_div(isl_sioimath_bigarg_src(lhs, &lhsscratch),
-	    isl_sioimath_bigarg_src(rhs, &rhsscratch), NULL, &rem);
-	cmp = mp_int_compare_zero(&rem);
-	mp_int_clear(&rem);
+	    isl_sioimath_bigarg_src(rhs, &rhsscratch), NULL, rem);
+	cmp = mp_int_compare_zero(rem);
+	mp_int_free(rem);
 	return cmp == 0;
 }
 
@@ -1144,10 +1273,10 @@ inline int isl_sioimath_is_divisible_by(isl_sioimath_src lhs,
  */
 inline uint32_t isl_sioimath_hash(isl_sioimath_src arg, uint32_t hash)
 {
-	int32_t small;
+	int64_t small;
 	int i;
-	uint32_t num;
-	mp_digit digits[(sizeof(uint32_t) + sizeof(mp_digit) - 1) /
+	uint64_t num;
+	mp_digit digits[(sizeof(uint64_t) + sizeof(mp_digit) - 1) /
 	                sizeof(mp_digit)];
 	mp_size used;
 	const unsigned char *digitdata = (const unsigned char *) &digits;
@@ -1155,9 +1284,9 @@ inline uint32_t isl_sioimath_hash(isl_sioimath_src arg, uint32_t hash)
 	if (isl_sioimath_decode_small(arg, &small)) {
 		if (small < 0)
 			isl_hash_byte(hash, 0xFF);
-		num = labs(small);
+		num = isl_sioimath_abs64(small);
 
-		isl_siomath_uint32_to_digits(num, digits, &used);
+		isl_siomath_uint64_to_digits(num, digits, &used);
 		for (i = 0; i < used * sizeof(mp_digit); i += 1)
 			isl_hash_byte(hash, digitdata[i]);
 		return hash;
@@ -1175,10 +1304,10 @@ inline uint32_t isl_sioimath_hash(isl_sioimath_src arg, uint32_t hash)
  */
 inline size_t isl_sioimath_sizeinbase(isl_sioimath_src arg, int base)
 {
-	int32_t small;
+	int64_t small;
 
 	if (isl_sioimath_decode_small(arg, &small))
-		return sizeof(int32_t) * CHAR_BIT - 1;
+		return sizeof(int64_t) * CHAR_BIT - 2;
 
 	return impz_sizeinbase(isl_sioimath_get_big(arg), base);
 }
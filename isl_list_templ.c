@@ -126,6 +126,53 @@ static __isl_give LIST(EL) *FN(LIST(EL),grow)(__isl_take LIST(EL) *list, int n)
 	return res;
 }
 
+/* Make sure "list" has room for at least "n" more elements,
+ * such that they can be added without any further reallocation.
+ * Always return a list with a single reference.
+ */
+__isl_give LIST(EL) *FN(LIST(EL),reserve)(__isl_take LIST(EL) *list, int n)
+{
+	if (!list)
+		return NULL;
+	if (n < 0)
+		isl_die(FN(LIST(EL),get_ctx)(list), isl_error_invalid,
+			"cannot reserve negative number of elements",
+			return FN(LIST(EL),free)(list));
+	return FN(LIST(EL),grow)(list, n);
+}
+
+/* Construct a list from the "n" elements in "array".
+ * The elements are taken over by the list (or freed in case of error),
+ * but "array" itself remains owned by the caller.
+ * Since the list is allocated with the exact size,
+ * the elements are simply moved into the list.
+ */
+__isl_give LIST(EL) *FN(LIST(EL),from_array)(isl_ctx *ctx, int n,
+	__isl_take EL **array)
+{
+	int i;
+	LIST(EL) *list;
+
+	list = FN(LIST(EL),alloc)(ctx, n);
+	if (!list)
+		goto error;
+	for (i = 0; i < n; ++i) {
+		if (!array[i])
+			goto error;
+		list->p[i] = array[i];
+		array[i] = NULL;
+		list->n++;
+	}
+
+	return list;
+error:
+	for (i = 0; i < n; ++i)
+		if (array[i])
+			FN(EL,free)(array[i]);
+	FN(LIST(EL),free)(list);
+	return NULL;
+}
+
 /* Check that "index" is a valid position in "list".
  */
 static isl_stat FN(LIST(EL),check_index)(__isl_keep LIST(EL) *list, int index)
@@ -154,6 +201,9 @@ error:
 }
 
 /* Remove the "n" elements starting at "first" from "list".
+ *
+ * If "list" is shared, then only the remaining elements
+ * are copied to the result.
  */
 __isl_give LIST(EL) *FN(LIST(EL),drop)(__isl_take LIST(EL) *list,
 	unsigned first, unsigned n)
@@ -167,9 +217,18 @@ __isl_give LIST(EL) *FN(LIST(EL),drop)(__isl_take LIST(EL) *list,
 			"index out of bounds", return FN(LIST(EL),free)(list));
 	if (n == 0)
 		return list;
-	list = FN(LIST(EL),cow)(list);
-	if (!list)
-		return NULL;
+	if (list->ref != 1) {
+		LIST(EL) *res;
+
+		res = FN(LIST(EL),alloc)(list->ctx, list->n - n);
+		for (i = 0; i < list->n; ++i) {
+			if (i >= first && i < first + n)
+				continue;
+			res = FN(LIST(EL),add)(res, FN(EL,copy)(list->p[i]));
+		}
+		FN(LIST(EL),free)(list);
+		return res;
+	}
 	for (i = 0; i < n; ++i)
 		FN(EL,free)(list->p[first + i]);
 	for (i = first; i + n < list->n; ++i)
@@ -189,8 +248,9 @@ __isl_give LIST(EL) *FN(LIST(EL),clear)(__isl_take LIST(EL) *list)
 
 /* Insert "el" at position "pos" in "list".
  *
- * If there is only one reference to "list" and if it already has space
- * for one extra element, we insert it directly into "list".
+ * If there is only one reference to "list", we insert "el" directly
+ * into "list", after extending it if it does not have space
+ * for one extra element.
  * Otherwise, we create a new list consisting of "el" and copied
  * elements from "list".
  */
@@ -208,7 +268,10 @@ __isl_give LIST(EL) *FN(LIST(EL),insert)(__isl_take LIST(EL) *list,
 		isl_die(ctx, isl_error_invalid,
 			"index out of bounds", goto error);
 
-	if (list->ref == 1 && list->size > list->n) {
+	if (list->ref == 1) {
+		list = FN(LIST(EL),grow)(list, 1);
+		if (!list)
+			goto error;
 		for (i = list->n; i > pos; --i)
 			list->p[i] = list->p[i - 1];
 		list->n++;
@@ -617,21 +680,31 @@ __isl_give LIST(EL) *FN(EL,to_list)(__isl_take EL *el)
 /* Append the elements of "list2" to "list1", where "list1" is known
  * to have only a single reference and enough room to hold
  * the extra elements.
+ * If "list2" has only a single reference as well, then its elements
+ * are moved to "list1" rather than copied.
  */
 static __isl_give LIST(EL) *FN(LIST(EL),concat_inplace)(
 	__isl_take LIST(EL) *list1, __isl_take LIST(EL) *list2)
 {
 	int i;
 
-	for (i = 0; i < list2->n; ++i)
-		list1 = FN(LIST(EL),add)(list1, FN(EL,copy)(list2->p[i]));
+	if (list2->ref == 1) {
+		for (i = 0; i < list2->n; ++i)
+			list1->p[list1->n + i] = list2->p[i];
+		list1->n += list2->n;
+		list2->n = 0;
+	} else {
+		for (i = 0; i < list2->n; ++i)
+			list1 = FN(LIST(EL),add)(list1,
+						FN(EL,copy)(list2->p[i]));
+	}
 	FN(LIST(EL),free)(list2);
 	return list1;
 }
 
 /* Concatenate "list1" and "list2".
- * If "list1" has only one reference and has enough room
- * for the elements of "list2", the add the elements to "list1" itself.
+ * If "list1" has only one reference, then add the elements of "list2"
+ * to "list1" itself, after extending it if it does not have enough room.
  * Otherwise, create a new list to store the result.
  */
 __isl_give LIST(EL) *FN(LIST(EL),concat)(__isl_take LIST(EL) *list1,
@@ -644,8 +717,12 @@ __isl_give LIST(EL) *FN(LIST(EL),concat)(__isl_take LIST(EL) *list1,
 	if (!list1 || !list2)
 		goto error;
 
-	if (list1->ref == 1 && list1->n + list2->n <= list1->size)
+	if (list1->ref == 1) {
+		list1 = FN(LIST(EL),grow)(list1, list2->n);
+		if (!list1)
+			goto error;
 		return FN(LIST(EL),concat_inplace)(list1, list2);
+	}
 
 	ctx = FN(LIST(EL),get_ctx)(list1);
 	res = FN(LIST(EL),alloc)(ctx, list1->n + list2->n);
@@ -105,6 +105,22 @@ __isl_give isl_local_space *isl_local_space_copy(__isl_keep isl_local_space *ls)
 	return ls;
 }
 
+/* Return a copy of "ls" in "ctx".
+ * Unless "ls" already belongs to "ctx", "ls" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_local_space *isl_local_space_copy_to_ctx(
+	__isl_keep isl_local_space *ls, isl_ctx *ctx)
+{
+	if (!ls)
+		return NULL;
+	if (isl_local_space_get_ctx(ls) == ctx)
+		return isl_local_space_copy(ls);
+
+	return isl_local_space_alloc_div(isl_space_copy_to_ctx(ls->dim, ctx),
+					 isl_mat_copy_to_ctx(ls->div, ctx));
+}
+
 __isl_give isl_local_space *isl_local_space_dup(__isl_keep isl_local_space *ls)
 {
 	if (!ls)
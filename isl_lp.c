@@ -10,6 +10,7 @@
 #include <isl_ctx_private.h>
 #include <isl_map_private.h>
 #include <isl/lp.h>
+#include <isl_lp_private.h>
 #include <isl_seq.h>
 #include "isl_tab.h"
 #include <isl_options_private.h>
@@ -22,28 +23,28 @@
 #include <bset_to_bmap.c>
 #include <set_to_map.c>
 
-static enum isl_lp_result isl_tab_solve_lp(__isl_keep isl_basic_map *bmap,
+/* Compute the minimal (or maximal if "maximize" is set) value
+ * of the affine expression "f" with denominator "denom"
+ * over the tableau "tab" with "dim" variables, as in isl_basic_map_solve_lp.
+ *
+ * The tableau is left in the optimal basis of the LP, such that
+ * a later LP on the same tableau can start from this basis.
+ */
+static enum isl_lp_result tab_solve_lp(struct isl_tab *tab, isl_size dim,
 	int maximize, isl_int *f, isl_int denom, isl_int *opt,
 	isl_int *opt_denom, __isl_give isl_vec **sol)
 {
-	struct isl_tab *tab;
 	enum isl_lp_result res;
-	isl_size dim = isl_basic_map_dim(bmap, isl_dim_all);
 
-	if (dim < 0)
-		return isl_lp_error;
 	if (maximize)
 		isl_seq_neg(f, f, 1 + dim);
 
-	bmap = isl_basic_map_gauss(bmap, NULL);
-	tab = isl_tab_from_basic_map(bmap, 0);
 	res = isl_tab_min(tab, f, denom, opt, opt_denom, 0);
 	if (res == isl_lp_ok && sol) {
 		*sol = isl_tab_get_sample_value(tab);
 		if (!*sol)
 			res = isl_lp_error;
 	}
-	isl_tab_free(tab);
 
 	if (maximize)
 		isl_seq_neg(f, f, 1 + dim);
@@ -53,6 +54,25 @@ static enum isl_lp_result isl_tab_solve_lp(__isl_keep isl_basic_map *bmap,
 	return res;
 }
 
+static enum isl_lp_result isl_tab_solve_lp(__isl_keep isl_basic_map *bmap,
+	int maximize, isl_int *f, isl_int denom, isl_int *opt,
+	isl_int *opt_denom, __isl_give isl_vec **sol)
+{
+	struct isl_tab *tab;
+	enum isl_lp_result res;
+	isl_size dim = isl_basic_map_dim(bmap, isl_dim_all);
+
+	if (dim < 0)
+		return isl_lp_error;
+
+	bmap = isl_basic_map_gauss(bmap, NULL);
+	tab = isl_tab_from_basic_map(bmap, 0);
+	res = tab_solve_lp(tab, dim, maximize, f, denom, opt, opt_denom, sol);
+	isl_tab_free(tab);
+
+	return res;
+}
+
 /* Given a basic map "bmap" and an affine combination of the variables "f"
  * with denominator "denom", set *opt / *opt_denom to the minimal
  * (or maximal if "maximize" is true) value attained by f/d over "bmap",
@@ -84,10 +104,36 @@ enum isl_lp_result isl_basic_set_solve_lp(__isl_keep isl_basic_set *bset,
 					f, d, opt, opt_denom, sol);
 }
 
-enum isl_lp_result isl_map_solve_lp(__isl_keep isl_map *map, int max,
-				      isl_int *f, isl_int d, isl_int *opt,
-				      isl_int *opt_denom,
-				      __isl_give isl_vec **sol)
+/* Solve the LP of isl_map_solve_lp on basic map "i" of "map".
+ * If "tab" is not NULL, then it contains a tableau for each basic map
+ * of "map" and the LP is solved on the corresponding tableau.
+ */
+static enum isl_lp_result map_solve_lp_i(__isl_keep isl_map *map,
+	struct isl_tab **tab, int i, int max, isl_int *f, isl_int d,
+	isl_int *opt, isl_int *opt_denom, __isl_give isl_vec **sol)
+{
+	isl_size dim;
+
+	if (!tab)
+		return isl_basic_map_solve_lp(map->p[i], max, f, d,
+						opt, opt_denom, sol);
+
+	if (sol)
+		*sol = NULL;
+	dim = isl_basic_map_dim(map->p[i], isl_dim_all);
+	if (dim < 0)
+		return isl_lp_error;
+	return tab_solve_lp(tab[i], dim, max, f, d, opt, opt_denom, sol);
+}
+
+/* Compute the optimum of "f" / "d" over "map",
+ * as described in isl_map_solve_lp.
+ * If "tab" is not NULL, then it contains a tableau for each basic map
+ * of "map", which is used to solve the LP on that basic map.
+ */
+static enum isl_lp_result map_solve_lp(__isl_keep isl_map *map,
+	struct isl_tab **tab, int max, isl_int *f, isl_int d, isl_int *opt,
+	isl_int *opt_denom, __isl_give isl_vec **sol)
 {
 	int i;
 	isl_int o;
@@ -130,8 +176,7 @@ enum isl_lp_result isl_map_solve_lp(__isl_keep isl_map *map, int max,
 		isl_int_init(t);
 	}
 
-	res = isl_basic_map_solve_lp(map->p[0], max, f, d,
-					opt, opt_denom, sol);
+	res = map_solve_lp_i(map, tab, 0, max, f, d, opt, opt_denom, sol);
 	if (res == isl_lp_error || res == isl_lp_unbounded)
 		goto done;
 
@@ -143,10 +188,9 @@ enum isl_lp_result isl_map_solve_lp(__isl_keep isl_map *map, int max,
 		enum isl_lp_result res_i;
 		int better;
 
-		res_i = isl_basic_map_solve_lp(map->p[i], max, f, d,
-					    &opt_i,
-					    opt_denom ? &opt_denom_i : NULL,
-					    sol ? &sol_i : NULL);
+		res_i = map_solve_lp_i(map, tab, i, max, f, d, &opt_i,
+					opt_denom ? &opt_denom_i : NULL,
+					sol ? &sol_i : NULL);
 		if (res_i == isl_lp_error || res_i == isl_lp_unbounded) {
 			res = res_i;
 			goto done;
@@ -195,6 +239,19 @@ done:
 	return res;
 }
 
+/* Given a map "map" and an affine combination of the variables "f"
+ * with denominator "d", set *opt / *opt_denom to the minimal
+ * (or maximal if "max" is true) value attained by f/d over "map",
+ * as in isl_basic_map_solve_lp, but over all basic maps of "map".
+ */
+enum isl_lp_result isl_map_solve_lp(__isl_keep isl_map *map, int max,
+				      isl_int *f, isl_int d, isl_int *opt,
+				      isl_int *opt_denom,
+				      __isl_give isl_vec **sol)
+{
+	return map_solve_lp(map, NULL, max, f, d, opt, opt_denom, sol);
+}
+
 enum isl_lp_result isl_set_solve_lp(__isl_keep isl_set *set, int max,
 				      isl_int *f, isl_int d, isl_int *opt,
 				      isl_int *opt_denom,
@@ -204,6 +261,92 @@ enum isl_lp_result isl_set_solve_lp(__isl_keep isl_set *set, int max,
 					f, d, opt, opt_denom, sol);
 }
 
+/* A solver for a sequence of LPs over the same map "map".
+ * "tab" contains a tableau for each basic map of "map".
+ * Each tableau is kept in the optimal basis of the previous LP
+ * on the corresponding basic map, such that the next LP,
+ * typically with a similar objective function,
+ * can start from this basis rather than from scratch.
+ */
+struct isl_lp_solver {
+	isl_map *map;
+	struct isl_tab **tab;
+};
+
+/* Free "solver" and return NULL.
+ */
+__isl_null isl_lp_solver *isl_lp_solver_free(__isl_take isl_lp_solver *solver)
+{
+	int i;
+
+	if (!solver)
+		return NULL;
+
+	for (i = 0; solver->tab && i < solver->map->n; ++i)
+		isl_tab_free(solver->tab[i]);
+	free(solver->tab);
+	isl_map_free(solver->map);
+	free(solver);
+
+	return NULL;
+}
+
+/* Construct a solver for a sequence of LPs over "map".
+ */
+__isl_give isl_lp_solver *isl_map_lp_solver_alloc(__isl_keep isl_map *map)
+{
+	int i;
+	isl_ctx *ctx;
+	isl_lp_solver *solver;
+
+	if (!map)
+		return NULL;
+
+	ctx = isl_map_get_ctx(map);
+	solver = isl_calloc_type(ctx, isl_lp_solver);
+	if (!solver)
+		return NULL;
+	solver->map = isl_map_copy(map);
+	if (map->n == 0)
+		return solver;
+	solver->tab = isl_calloc_array(ctx, struct isl_tab *, map->n);
+	if (!solver->tab)
+		return isl_lp_solver_free(solver);
+	for (i = 0; i < map->n; ++i) {
+		isl_basic_map *bmap;
+
+		bmap = isl_basic_map_copy(map->p[i]);
+		bmap = isl_basic_map_gauss(bmap, NULL);
+		solver->tab[i] = isl_tab_from_basic_map(bmap, 0);
+		isl_basic_map_free(bmap);
+		if (!solver->tab[i])
+			return isl_lp_solver_free(solver);
+	}
+
+	return solver;
+}
+
+/* Construct a solver for a sequence of LPs over "set".
+ */
+__isl_give isl_lp_solver *isl_set_lp_solver_alloc(__isl_keep isl_set *set)
+{
+	return isl_map_lp_solver_alloc(set_to_map(set));
+}
+
+/* Compute the minimal (or maximal if "max" is set) value
+ * of "f" / "d" over the map of "solver", as in isl_map_solve_lp,
+ * starting from the optimal bases of the previous LP solved by "solver".
+ */
+enum isl_lp_result isl_lp_solver_solve(__isl_keep isl_lp_solver *solver,
+	int max, isl_int *f, isl_int d, isl_int *opt, isl_int *opt_denom,
+	__isl_give isl_vec **sol)
+{
+	if (!solver)
+		return isl_lp_error;
+	return map_solve_lp(solver->map, solver->tab, max, f, d,
+				opt, opt_denom, sol);
+}
+
 /* Return the optimal (rational) value of "obj" over "bset", assuming
  * that "obj" and "bset" have aligned parameters and divs.
  * If "max" is set, then the maximal value is computed.
@@ -18,4 +18,14 @@ enum isl_lp_result isl_set_solve_lp(__isl_keep isl_set *set, int max,
 	isl_int *f, isl_int denom, isl_int *opt, isl_int *opt_denom,
 	__isl_give isl_vec **sol);
 
+struct isl_lp_solver;
+typedef struct isl_lp_solver isl_lp_solver;
+
+__isl_give isl_lp_solver *isl_map_lp_solver_alloc(__isl_keep isl_map *map);
+__isl_give isl_lp_solver *isl_set_lp_solver_alloc(__isl_keep isl_set *set);
+__isl_null isl_lp_solver *isl_lp_solver_free(__isl_take isl_lp_solver *solver);
+enum isl_lp_result isl_lp_solver_solve(__isl_keep isl_lp_solver *solver,
+	int max, isl_int *f, isl_int denom, isl_int *opt, isl_int *opt_denom,
+	__isl_give isl_vec **sol);
+
 #endif
@@ -21,6 +21,7 @@
  * and Cerebras Systems, 175 S San Antonio Rd, Los Altos, CA, USA
  */
 
+#include <limits.h>
 #include <string.h>
 #include <isl_ctx_private.h>
 #include <isl_map_private.h>
@@ -450,10 +451,13 @@ static __isl_give isl_space *isl_basic_map_take_space(
  * due to a preceding call to isl_basic_map_take_space.
  * However, in this case, "bmap" only has a single reference and
  * then the call to isl_basic_map_cow has no effect.
+ * If the "intern_spaces" option is set, then "space" is first
+ * replaced by its interned version.
  */
 static __isl_give isl_basic_map *isl_basic_map_restore_space(
 	__isl_take isl_basic_map *bmap, __isl_take isl_space *space)
 {
+	space = isl_space_intern(space);
 	if (!bmap || !space)
 		goto error;
 
@@ -544,8 +548,8 @@ static __isl_give isl_basic_map *add_known_div_constraints(
 		return isl_basic_map_free(bmap);
 	if (n_div == 0)
 		return bmap;
-	bmap = isl_basic_map_cow(bmap);
 	bmap = isl_basic_map_extend_constraints(bmap, 0, 2 * n_div);
+	bmap = isl_basic_map_cow(bmap);
 	if (!bmap)
 		return NULL;
 	for (i = 0; i < n_div; ++i) {
@@ -633,10 +637,13 @@ static __isl_give isl_space *isl_map_take_space(__isl_keep isl_map *map)
  * due to a preceding call to isl_map_take_space.
  * However, in this case, "map" only has a single reference and
  * then the call to isl_map_cow has no effect.
+ * If the "intern_spaces" option is set, then "space" is first
+ * replaced by its interned version.
  */
 static __isl_give isl_map *isl_map_restore_space(__isl_take isl_map *map,
 	__isl_take isl_space *space)
 {
+	space = isl_space_intern(space);
 	if (!map || !space)
 		goto error;
 
@@ -682,15 +689,81 @@ const char *isl_basic_map_get_tuple_name(__isl_keep isl_basic_map *bmap,
 	return bmap ? isl_space_get_tuple_name(bmap->dim, type) : NULL;
 }
 
+/* Store copies of the simple hulls cached inside "map" in "hull"
+ * such that they can be transformed along with "map" and
+ * put back in the result (using restore_cached_simple_hulls).
+ * This is only valid for operations on "map" that transform
+ * its simple hulls in the same way.
+ */
+static void get_cached_simple_hulls(__isl_keep isl_map *map,
+	isl_basic_map *hull[2])
+{
+	int i;
+
+	for (i = 0; i < 2; ++i)
+		hull[i] = map ? isl_basic_map_copy(map->cached_simple_hull[i])
+			      : NULL;
+}
+
+/* Free the simple hulls in "hull".
+ */
+static void free_cached_simple_hulls(isl_basic_map *hull[2])
+{
+	isl_basic_map_free(hull[0]);
+	isl_basic_map_free(hull[1]);
+}
+
+/* Store the (transformed) simple hulls "hull" in "map",
+ * which is assumed to have a single reference.
+ */
+static __isl_give isl_map *restore_cached_simple_hulls(__isl_take isl_map *map,
+	isl_basic_map *hull[2])
+{
+	int i;
+
+	if (!map) {
+		free_cached_simple_hulls(hull);
+		return NULL;
+	}
+
+	for (i = 0; i < 2; ++i) {
+		isl_basic_map_free(map->cached_simple_hull[i]);
+		map->cached_simple_hull[i] = hull[i];
+	}
+
+	return map;
+}
+
+/* Store the simple hulls "hull" that were cached inside
+ * a map that differs from "map" only in its space in "map",
+ * after replacing their spaces by that of "map".
+ */
+static __isl_give isl_map *restore_reset_cached_simple_hulls(
+	__isl_take isl_map *map, isl_basic_map *hull[2])
+{
+	int i;
+
+	for (i = 0; map && i < 2; ++i)
+		if (hull[i])
+			hull[i] = isl_basic_map_reset_space(hull[i],
+							isl_map_get_space(map));
+	return restore_cached_simple_hulls(map, hull);
+}
+
+/* Replace the name of the tuple of "map" of type "type" by "s",
+ * preserving any cached simple hulls.
+ */
 __isl_give isl_map *isl_map_set_tuple_name(__isl_take isl_map *map,
 	enum isl_dim_type type, const char *s)
 {
 	int i;
 	isl_space *space;
+	isl_basic_map *hull[2];
 
+	get_cached_simple_hulls(map, hull);
 	map = isl_map_cow(map);
 	if (!map)
-		return NULL;
+		goto error;
 
 	for (i = 0; i < map->n; ++i) {
 		map->p[i] = isl_basic_map_set_tuple_name(map->p[i], type, s);
@@ -702,8 +775,9 @@ __isl_give isl_map *isl_map_set_tuple_name(__isl_take isl_map *map,
 	space = isl_space_set_tuple_name(space, type, s);
 	map = isl_map_restore_space(map, space);
 
-	return map;
+	return restore_reset_cached_simple_hulls(map, hull);
 error:
+	free_cached_simple_hulls(hull);
 	isl_map_free(map);
 	return NULL;
 }
@@ -751,16 +825,23 @@ __isl_give isl_set *isl_set_set_tuple_name(__isl_take isl_set *set,
 						isl_dim_set, s));
 }
 
+/* Replace the identifier of the tuple of "map" of type "type" by "id",
+ * preserving any cached simple hulls.
+ */
 __isl_give isl_map *isl_map_set_tuple_id(__isl_take isl_map *map,
 	enum isl_dim_type type, __isl_take isl_id *id)
 {
 	isl_space *space;
+	isl_basic_map *hull[2];
 
+	get_cached_simple_hulls(map, hull);
 	space = isl_map_take_space(map);
 	space = isl_space_set_tuple_id(space, type, id);
 	map = isl_map_restore_space(map, space);
 
-	return isl_map_reset_space(map, isl_map_get_space(map));
+	map = isl_map_reset_space(map, isl_map_get_space(map));
+
+	return restore_reset_cached_simple_hulls(map, hull);
 }
 
 /* Replace the identifier of the domain tuple of "map" by "id".
@@ -785,16 +866,23 @@ __isl_give isl_set *isl_set_set_tuple_id(__isl_take isl_set *set,
 	return isl_map_set_tuple_id(set, isl_dim_set, id);
 }
 
+/* Remove the identifier of the tuple of "map" of type "type",
+ * preserving any cached simple hulls.
+ */
 __isl_give isl_map *isl_map_reset_tuple_id(__isl_take isl_map *map,
 	enum isl_dim_type type)
 {
 	isl_space *space;
+	isl_basic_map *hull[2];
 
+	get_cached_simple_hulls(map, hull);
 	space = isl_map_take_space(map);
 	space = isl_space_reset_tuple_id(space, type);
 	map = isl_map_restore_space(map, space);
 
-	return isl_map_reset_space(map, isl_map_get_space(map));
+	map = isl_map_reset_space(map, isl_map_get_space(map));
+
+	return restore_reset_cached_simple_hulls(map, hull);
 }
 
 __isl_give isl_set *isl_set_reset_tuple_id(__isl_take isl_set *set)
@@ -927,15 +1015,20 @@ __isl_give isl_basic_map *isl_basic_map_set_dim_name(
 	return isl_basic_map_finalize(bmap);
 }
 
+/* Replace the name of dimension "pos" of type "type" of "map" by "s",
+ * preserving any cached simple hulls.
+ */
 __isl_give isl_map *isl_map_set_dim_name(__isl_take isl_map *map,
 	enum isl_dim_type type, unsigned pos, const char *s)
 {
 	int i;
 	isl_space *space;
+	isl_basic_map *hull[2];
 
+	get_cached_simple_hulls(map, hull);
 	map = isl_map_cow(map);
 	if (!map)
-		return NULL;
+		goto error;
 
 	for (i = 0; i < map->n; ++i) {
 		map->p[i] = isl_basic_map_set_dim_name(map->p[i], type, pos, s);
@@ -947,8 +1040,9 @@ __isl_give isl_map *isl_map_set_dim_name(__isl_take isl_map *map,
 	space = isl_space_set_dim_name(space, type, pos, s);
 	map = isl_map_restore_space(map, space);
 
-	return map;
+	return restore_reset_cached_simple_hulls(map, hull);
 error:
+	free_cached_simple_hulls(hull);
 	isl_map_free(map);
 	return NULL;
 }
@@ -1006,16 +1100,23 @@ __isl_give isl_id *isl_set_get_dim_id(__isl_keep isl_set *set,
 	return isl_map_get_dim_id(set, type, pos);
 }
 
+/* Replace the identifier of dimension "pos" of type "type" of "map"
+ * by "id", preserving any cached simple hulls.
+ */
 __isl_give isl_map *isl_map_set_dim_id(__isl_take isl_map *map,
 	enum isl_dim_type type, unsigned pos, __isl_take isl_id *id)
 {
 	isl_space *space;
+	isl_basic_map *hull[2];
 
+	get_cached_simple_hulls(map, hull);
 	space = isl_map_take_space(map);
 	space = isl_space_set_dim_id(space, type, pos, id);
 	map = isl_map_restore_space(map, space);
 
-	return isl_map_reset_space(map, isl_map_get_space(map));
+	map = isl_map_reset_space(map, isl_map_get_space(map));
+
+	return restore_reset_cached_simple_hulls(map, hull);
 }
 
 __isl_give isl_set *isl_set_set_dim_id(__isl_take isl_set *set,
@@ -1377,6 +1478,7 @@ __isl_give isl_basic_map *isl_basic_map_alloc_space(__isl_take isl_space *space,
 {
 	struct isl_basic_map *bmap;
 
+	space = isl_space_intern(space);
 	if (!space)
 		return NULL;
 	bmap = isl_calloc_type(space->ctx, struct isl_basic_map);
@@ -1454,6 +1556,39 @@ __isl_give isl_basic_map *isl_basic_map_dup(__isl_keep isl_basic_map *bmap)
 	return dup;
 }
 
+/* Return a copy of "bmap" in "ctx".
+ * The sample point of "bmap", if any, is not copied.
+ * Unless "bmap" already belongs to "ctx", "bmap" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_basic_map *isl_basic_map_copy_to_ctx(
+	__isl_keep isl_basic_map *bmap, isl_ctx *ctx)
+{
+	isl_space *space;
+	isl_basic_map *dup;
+
+	if (!bmap)
+		return NULL;
+	if (bmap->ctx == ctx)
+		return isl_basic_map_copy(bmap);
+
+	space = isl_space_copy_to_ctx(isl_basic_map_peek_space(bmap), ctx);
+	dup = isl_basic_map_alloc_space(space,
+			bmap->n_div, bmap->n_eq, bmap->n_ineq);
+	dup = dup_constraints(dup, bmap);
+	if (!dup)
+		return NULL;
+	dup->flags = bmap->flags;
+	return dup;
+}
+
+__isl_give isl_basic_set *isl_basic_set_copy_to_ctx(
+	__isl_keep isl_basic_set *bset, isl_ctx *ctx)
+{
+	return bset_from_bmap(isl_basic_map_copy_to_ctx(bset_to_bmap(bset),
+							ctx));
+}
+
 __isl_give isl_basic_set *isl_basic_set_dup(__isl_keep isl_basic_set *bset)
 {
 	struct isl_basic_map *dup;
@@ -1644,6 +1779,7 @@ int isl_basic_map_alloc_equality(__isl_keep isl_basic_map *bmap)
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_IMPLICIT);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_ALL_EQUALITIES);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_NORMALIZED_DIVS);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	if ((bmap->eq - bmap->ineq) + bmap->n_eq == bmap->c_size) {
 		isl_int *t;
 		int j = isl_basic_map_alloc_inequality(bmap);
@@ -1678,6 +1814,7 @@ __isl_give isl_basic_map *isl_basic_map_free_equality(
 			"invalid number of equalities",
 			isl_basic_map_free(bmap));
 	bmap->n_eq -= n;
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	return bmap;
 }
 
@@ -1705,6 +1842,7 @@ int isl_basic_map_drop_equality(__isl_keep isl_basic_map *bmap, unsigned pos)
 	for (r = pos; r < bmap->n_eq; ++r)
 		bmap->eq[r] = bmap->eq[r + 1];
 	bmap->eq[bmap->n_eq] = t;
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 
 	return 0;
 }
@@ -1730,8 +1868,10 @@ void isl_basic_map_inequality_to_equality(
 	bmap->eq--;
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_REDUNDANT);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_SORTED);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_NORMALIZED_DIVS);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_ALL_EQUALITIES);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 }
 
 static int room_for_ineq(__isl_keep isl_basic_map *bmap, unsigned n)
@@ -1752,7 +1892,9 @@ int isl_basic_map_alloc_inequality(__isl_keep isl_basic_map *bmap)
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_IMPLICIT);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_REDUNDANT);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_SORTED);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_ALL_EQUALITIES);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	isl_seq_clr(bmap->ineq[bmap->n_ineq] + 1 + total,
 		      bmap->extra - bmap->n_div);
 	return bmap->n_ineq++;
@@ -1773,6 +1915,7 @@ __isl_give isl_basic_map *isl_basic_map_free_inequality(
 			"invalid number of inequalities",
 			return isl_basic_map_free(bmap));
 	bmap->n_ineq -= n;
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	return bmap;
 }
 
@@ -1795,8 +1938,10 @@ int isl_basic_map_drop_inequality(__isl_keep isl_basic_map *bmap, unsigned pos)
 		bmap->ineq[pos] = bmap->ineq[bmap->n_ineq - 1];
 		bmap->ineq[bmap->n_ineq - 1] = t;
 		ISL_F_CLR(bmap, ISL_BASIC_MAP_SORTED);
+		ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
 	}
 	bmap->n_ineq--;
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	return 0;
 }
 
@@ -1818,8 +1963,8 @@ __isl_give isl_basic_map *isl_basic_map_add_eq(__isl_take isl_basic_map *bmap,
 	if (empty)
 		return bmap;
 
-	bmap = isl_basic_map_cow(bmap);
 	bmap = isl_basic_map_extend_constraints(bmap, 1, 0);
+	bmap = isl_basic_map_cow(bmap);
 	total = isl_basic_map_dim(bmap, isl_dim_all);
 	if (total < 0)
 		return isl_basic_map_free(bmap);
@@ -1845,8 +1990,8 @@ __isl_give isl_basic_map *isl_basic_map_add_ineq(__isl_take isl_basic_map *bmap,
 	isl_size total;
 	int k;
 
-	bmap = isl_basic_map_cow(bmap);
 	bmap = isl_basic_map_extend_constraints(bmap, 0, 1);
+	bmap = isl_basic_map_cow(bmap);
 	total = isl_basic_map_dim(bmap, isl_dim_all);
 	if (total < 0)
 		return isl_basic_map_free(bmap);
@@ -1877,6 +2022,7 @@ int isl_basic_map_alloc_div(__isl_keep isl_basic_map *bmap)
 	isl_seq_clr(bmap->div[bmap->n_div] + 1 + 1 + total,
 		      bmap->extra - bmap->n_div);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_NORMALIZED_DIVS);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	return bmap->n_div++;
 }
 
@@ -1941,6 +2087,7 @@ isl_stat isl_basic_map_free_div(__isl_keep isl_basic_map *bmap, unsigned n)
 		return isl_stat_error;
 	isl_assert(bmap->ctx, n <= bmap->n_div, return isl_stat_error);
 	bmap->n_div -= n;
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	return isl_stat_ok;
 }
 
@@ -1981,6 +2128,110 @@ error:
 	return NULL;
 }
 
+/* Increase the room for constraints in "bmap", which is not shared
+ * with anyone else, such that it can hold at least "n_eq" equality
+ * constraints and "n_ineq" inequality constraints, without changing
+ * the number of local variables that can be stored in "bmap".
+ *
+ * Rather than allocating a fresh basic map and copying over
+ * all constraints, the block holding the constraints is extended
+ * in place and the pointers to the constraints are updated
+ * to point into the extended block.
+ * The rows in use keep their relative order in bmap->ineq,
+ * with the inequality constraints at the start and
+ * the equality constraints at the end.
+ * The rows that are not in use, followed by the newly added rows,
+ * fill up the remaining positions.
+ * "offset" keeps track of the offset in the block of the row
+ * for each position in the new bmap->ineq.
+ * Since the rows of "bmap" may have been reinterpreted
+ * (see, e.g., insert_div_rows), the new rows are simply appended
+ * to the block, with a size that is large enough for
+ * the current number of variables and local variables.
+ */
+static __isl_give isl_basic_map *grow_constraints(
+	__isl_take isl_basic_map *bmap, unsigned n_eq, unsigned n_ineq)
+{
+	int i, j;
+	isl_size total;
+	size_t row_size, size;
+	unsigned c_size, eq_pos, old_eq_pos;
+	struct isl_blk block;
+	isl_int **ineq = NULL;
+	size_t *offset = NULL;
+
+	total = isl_basic_map_dim(bmap, isl_dim_all);
+	if (total < 0)
+		return isl_basic_map_free(bmap);
+	row_size = 1 + total - bmap->n_div + bmap->extra;
+	c_size = n_eq + n_ineq;
+	if (c_size < bmap->c_size)
+		c_size = bmap->c_size;
+	eq_pos = c_size - n_eq;
+	old_eq_pos = bmap->eq - bmap->ineq;
+
+	ineq = isl_alloc_array(bmap->ctx, isl_int *, c_size);
+	offset = isl_alloc_array(bmap->ctx, size_t, c_size);
+	if (c_size && (!ineq || !offset))
+		goto error;
+
+	block = bmap->block;
+	for (i = 0; i < bmap->n_ineq; ++i)
+		offset[i] = bmap->ineq[i] - block.data;
+	for (i = 0; i < bmap->n_eq; ++i)
+		offset[eq_pos + i] = bmap->eq[i] - block.data;
+	j = bmap->n_ineq;
+	for (i = bmap->n_ineq; i < bmap->c_size; ++i) {
+		if (i >= old_eq_pos && i < old_eq_pos + bmap->n_eq)
+			continue;
+		if (j == eq_pos)
+			j += bmap->n_eq;
+		offset[j++] = bmap->ineq[i] - block.data;
+	}
+	size = block.size;
+	for (; j < c_size; ++j) {
+		if (j == eq_pos)
+			j += bmap->n_eq;
+		if (j >= c_size)
+			break;
+		offset[j] = size;
+		size += row_size;
+	}
+
+	block = isl_blk_extend(bmap->ctx, block, size);
+	bmap->block = block;
+	if (isl_blk_is_error(block))
+		goto error;
+
+	for (i = 0; i < c_size; ++i)
+		ineq[i] = block.data + offset[i];
+
+	free(offset);
+	free(bmap->ineq);
+	bmap->ineq = ineq;
+	bmap->eq = ineq + eq_pos;
+	bmap->c_size = c_size;
+	ISL_F_CLR(bmap, ISL_BASIC_SET_FINAL);
+	return bmap;
+error:
+	free(offset);
+	free(ineq);
+	return isl_basic_map_free(bmap);
+}
+
+/* Return a basic map that is equal to "base" and that has room
+ * for at least "extra" more local variables, "n_eq" more equality
+ * constraints and "n_ineq" more inequality constraints.
+ * Since the caller is going to modify the result,
+ * it is not shared with anyone else, unless no room was requested.
+ *
+ * If "base" is shared, then a single copy is made that has
+ * the required room, such that a subsequent isl_basic_map_cow
+ * does not need to copy the constraints a second time.
+ * If "base" is not shared and no room for extra local variables
+ * is required, then the constraints are kept in place
+ * and the room is increased using grow_constraints.
+ */
 __isl_give isl_basic_map *isl_basic_map_extend(__isl_take isl_basic_map *base,
 	unsigned extra, unsigned n_eq, unsigned n_ineq)
 {
@@ -1995,9 +2246,14 @@ __isl_give isl_basic_map *isl_basic_map_extend(__isl_take isl_basic_map *base,
 	dims_ok = base->extra >= base->n_div + extra;
 
 	if (dims_ok && room_for_con(base, n_eq + n_ineq) &&
-		       room_for_ineq(base, n_ineq))
+	    room_for_ineq(base, n_ineq) &&
+	    (base->ref == 1 || extra + n_eq + n_ineq == 0))
 		return base;
 
+	if (dims_ok && base->ref == 1)
+		return grow_constraints(base, base->n_eq + n_eq,
+					base->n_ineq + n_ineq);
+
 	extra += base->extra;
 	n_eq += base->n_eq;
 	n_ineq += base->n_ineq;
@@ -2014,6 +2270,7 @@ __isl_give isl_basic_map *isl_basic_map_extend(__isl_take isl_basic_map *base,
 	if (ext) {
 		ext->flags = flags;
 		ISL_F_CLR(ext, ISL_BASIC_SET_FINAL);
+		ISL_F_CLR(ext, ISL_BASIC_SET_SIMPLIFIED);
 	}
 
 	return ext;
@@ -2061,6 +2318,8 @@ __isl_give isl_basic_map *isl_basic_map_cow(__isl_take isl_basic_map *bmap)
 	if (bmap) {
 		ISL_F_CLR(bmap, ISL_BASIC_SET_FINAL);
 		ISL_F_CLR(bmap, ISL_BASIC_MAP_REDUCED_COEFFICIENTS);
+		ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
+		ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	}
 	return bmap;
 }
@@ -2076,6 +2335,10 @@ static __isl_give isl_map *clear_caches(__isl_take isl_map *map)
 	isl_basic_map_free(map->cached_simple_hull[1]);
 	map->cached_simple_hull[0] = NULL;
 	map->cached_simple_hull[1] = NULL;
+	map->cached_divs = isl_map_free(map->cached_divs);
+	free(map->cached_hash);
+	map->cached_hash = NULL;
+	map->n_cached_hash = 0;
 	return map;
 }
 
@@ -2148,6 +2411,7 @@ static __isl_give isl_basic_map *isl_basic_map_swap_vars(
 	isl_blk_free(bmap->ctx, blk);
 
 	ISL_F_CLR(bmap, ISL_BASIC_SET_SORTED);
+	ISL_F_CLR(bmap, ISL_BASIC_SET_SIMPLIFIED);
 	bmap = isl_basic_map_gauss(bmap, NULL);
 	return isl_basic_map_finalize(bmap);
 error:
@@ -2311,6 +2575,8 @@ __isl_give isl_basic_map *isl_basic_map_swap_div(__isl_take isl_basic_map *bmap,
 	for (i = 0; i < bmap->n_div; ++i)
 		isl_int_swap(bmap->div[i][1+1+off+a], bmap->div[i][1+1+off+b]);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_SORTED);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 
 	return bmap;
 }
@@ -2424,6 +2690,8 @@ __isl_give isl_basic_map *isl_basic_map_drop_core(
 
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_REDUNDANT);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_SORTED);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	return bmap;
 }
 
@@ -2466,6 +2734,9 @@ static __isl_give isl_map *isl_map_unmark_normalized(__isl_take isl_map *map)
 	if (!map)
 		return NULL;
 	ISL_F_CLR(map, ISL_MAP_NORMALIZED);
+	free(map->cached_hash);
+	map->cached_hash = NULL;
+	map->n_cached_hash = 0;
 	return map;
 }
 
@@ -2733,8 +3004,8 @@ static __isl_give isl_basic_map *insert_bounds_on_div_from_ineq(
 	if (!lb && !ub)
 		return bmap;
 
-	bmap = isl_basic_map_cow(bmap);
 	bmap = isl_basic_map_extend_constraints(bmap, 0, lb + ub);
+	bmap = isl_basic_map_cow(bmap);
 	if (lb) {
 		int k = isl_basic_map_alloc_inequality(bmap);
 		if (k < 0)
@@ -3019,6 +3290,111 @@ isl_bool isl_set_involves_locals(__isl_keep isl_set *set)
 	return isl_bool_not(no_locals);
 }
 
+/* Free "index" and return NULL.
+ */
+struct isl_basic_map_var_index *isl_basic_map_var_index_free(
+	struct isl_basic_map_var_index *index)
+{
+	if (!index)
+		return NULL;
+	free(index->eq_start);
+	free(index->eq);
+	free(index->ineq_start);
+	free(index->ineq);
+	free(index->div_start);
+	free(index->div);
+	free(index);
+	return NULL;
+}
+
+/* Fill in "start" and "list" with the transposed sparse index
+ * of the "n_row" rows "row" with respect to the "n" variables
+ * with coefficients starting at position "pos" in the rows.
+ * If "known" is set, then the rows are explicit representations
+ * of local variables and only those rows with a non-zero denominator
+ * (in the first position) are taken into account.
+ * "start" has been allocated to hold n + 1 elements.
+ *
+ * The rows are traversed twice in order, looking only
+ * at the relevant coefficients, once to count the number of rows
+ * involving each of the variables and once to record the rows.
+ * During the second traversal, start[i + 1] keeps track
+ * of the next position to fill in for variable i.
+ */
+static isl_stat fill_var_index(isl_ctx *ctx, int n_row, isl_int **row,
+	int known, unsigned pos, unsigned n, int *start, int **list)
+{
+	int i, j;
+
+	for (j = 0; j <= n; ++j)
+		start[j] = 0;
+	for (i = 0; i < n_row; ++i) {
+		if (known && isl_int_is_zero(row[i][0]))
+			continue;
+		for (j = 0; j < n; ++j)
+			if (!isl_int_is_zero(row[i][pos + j]))
+				start[1 + j]++;
+	}
+	for (j = 0; j < n; ++j)
+		start[1 + j] += start[j];
+
+	*list = isl_alloc_array(ctx, int, start[n]);
+	if (start[n] && !*list)
+		return isl_stat_error;
+
+	for (j = n; j > 0; --j)
+		start[j] = start[j - 1];
+	for (i = 0; i < n_row; ++i) {
+		if (known && isl_int_is_zero(row[i][0]))
+			continue;
+		for (j = 0; j < n; ++j)
+			if (!isl_int_is_zero(row[i][pos + j]))
+				(*list)[start[1 + j]++] = i;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Construct a transposed sparse index of the constraints of "bmap"
+ * and of the explicit representations of its local variables
+ * with respect to the "n" variables starting at position "first"
+ * (not counting the constant term).
+ * Queries about a single variable that would otherwise need
+ * to look at the corresponding coefficient of every constraint
+ * can use this index to look at only the constraints
+ * that involve the variable.
+ */
+struct isl_basic_map_var_index *isl_basic_map_var_index_alloc(
+	__isl_keep isl_basic_map *bmap, unsigned first, unsigned n)
+{
+	isl_ctx *ctx;
+	struct isl_basic_map_var_index *index;
+
+	if (isl_basic_map_check_range(bmap, isl_dim_all, first, n) < 0)
+		return NULL;
+
+	ctx = isl_basic_map_get_ctx(bmap);
+	index = isl_calloc_type(ctx, struct isl_basic_map_var_index);
+	if (!index)
+		return NULL;
+	index->first = first;
+	index->n = n;
+	index->eq_start = isl_alloc_array(ctx, int, n + 1);
+	index->ineq_start = isl_alloc_array(ctx, int, n + 1);
+	index->div_start = isl_alloc_array(ctx, int, n + 1);
+	if (!index->eq_start || !index->ineq_start || !index->div_start)
+		return isl_basic_map_var_index_free(index);
+	if (fill_var_index(ctx, bmap->n_eq, bmap->eq, 0, 1 + first, n,
+			    index->eq_start, &index->eq) < 0 ||
+	    fill_var_index(ctx, bmap->n_ineq, bmap->ineq, 0, 1 + first, n,
+			    index->ineq_start, &index->ineq) < 0 ||
+	    fill_var_index(ctx, bmap->n_div, bmap->div, 1, 2 + first, n,
+			    index->div_start, &index->div) < 0)
+		return isl_basic_map_var_index_free(index);
+
+	return index;
+}
+
 /* Drop all constraints in bmap that involve any of the dimensions
  * first to first+n-1.
  * This function only performs the actual removal of constraints.
@@ -3429,6 +3805,8 @@ __isl_give isl_basic_map *isl_inequality_negate(__isl_take isl_basic_map *bmap,
 	isl_int_sub_ui(bmap->ineq[pos][0], bmap->ineq[pos][0], 1);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_REDUNDANT);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_SORTED);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	return bmap;
 }
 
@@ -3743,11 +4121,11 @@ __isl_give isl_basic_map *isl_basic_map_intersect(
 	    isl_basic_map_contains(bmap2, bmap2->sample) > 0)
 		sample = isl_vec_copy(bmap2->sample);
 
+	bmap1 = isl_basic_map_extend(bmap1,
+			bmap2->n_div, bmap2->n_eq, bmap2->n_ineq);
 	bmap1 = isl_basic_map_cow(bmap1);
 	if (!bmap1)
 		goto error;
-	bmap1 = isl_basic_map_extend(bmap1,
-			bmap2->n_div, bmap2->n_eq, bmap2->n_ineq);
 	bmap1 = add_constraints(bmap1, bmap2, 0, 0);
 
 	if (!bmap1)
@@ -3863,37 +4241,230 @@ error:
 	return NULL;
 }
 
+/* Constant lower and upper bounds on the variables
+ * (excluding local variables) of the basic maps of a map.
+ * Row 2 * i of "bound" contains the lower bounds for basic map i and
+ * row 2 * i + 1 contains the upper bounds.
+ * "known" has the same layout (with "n_var" elements per row) and
+ * records which of the bounds are available.
+ */
+struct isl_map_constant_bounds {
+	isl_mat *bound;
+	char *known;
+	int n_var;
+};
+
+/* Free "bounds" and return NULL.
+ */
+static struct isl_map_constant_bounds *isl_map_constant_bounds_free(
+	struct isl_map_constant_bounds *bounds)
+{
+	if (!bounds)
+		return NULL;
+	isl_mat_free(bounds->bound);
+	free(bounds->known);
+	free(bounds);
+	return NULL;
+}
+
+/* Update the bounds of basic map "i" in "bounds"
+ * with the constraint "sign" * "c" >= 0, where "c" involves
+ * only the variable at position "pos" (and a constant term) and
+ * where "sign" is either 1 or -1.
+ * "v" and "d" are temporary variables.
+ */
+static void update_constant_bound(struct isl_map_constant_bounds *bounds,
+	int i, int pos, isl_int *c, int sign, isl_int *v, isl_int *d)
+{
+	int lower;
+	int row;
+	int k;
+
+	if (sign > 0)
+		lower = isl_int_is_pos(c[1 + pos]);
+	else
+		lower = isl_int_is_neg(c[1 + pos]);
+	row = lower ? 2 * i : 2 * i + 1;
+	isl_int_abs(*d, c[1 + pos]);
+	if (lower == (sign > 0))
+		isl_int_neg(*v, c[0]);
+	else
+		isl_int_set(*v, c[0]);
+	if (lower)
+		isl_int_cdiv_q(*v, *v, *d);
+	else
+		isl_int_fdiv_q(*v, *v, *d);
+	k = row * bounds->n_var + pos;
+	if (bounds->known[k]) {
+		if (lower && isl_int_le(*v, bounds->bound->row[row][pos]))
+			return;
+		if (!lower && isl_int_ge(*v, bounds->bound->row[row][pos]))
+			return;
+	}
+	bounds->known[k] = 1;
+	isl_int_set(bounds->bound->row[row][pos], *v);
+}
+
+/* Is "c" a constraint that only involves the variable at some position
+ * (and a constant term)?  If so, return this position.
+ * Otherwise, return -1.
+ * "n_var" is the number of variables, excluding the "n_div"
+ * local variables.
+ */
+static int single_var_constraint(isl_int *c, int n_var, int n_div)
+{
+	int pos;
+
+	if (isl_seq_first_non_zero(c + 1 + n_var, n_div) != -1)
+		return -1;
+	pos = isl_seq_first_non_zero(c + 1, n_var);
+	if (pos < 0)
+		return -1;
+	if (isl_seq_first_non_zero(c + 1 + pos + 1, n_var - pos - 1) != -1)
+		return -1;
+	return pos;
+}
+
+/* Collect the constant bounds on the variables of the basic maps
+ * of "map" that are directly available as constraints
+ * involving a single variable.
+ * The bounds are rounded to integer values, so no bounds
+ * are collected for rational basic maps.
+ */
+static struct isl_map_constant_bounds *isl_map_get_constant_bounds(
+	__isl_keep isl_map *map)
+{
+	int i, j;
+	isl_size n_var;
+	isl_int v, d;
+	struct isl_map_constant_bounds *bounds;
+
+	n_var = isl_map_dim(map, isl_dim_all);
+	if (n_var < 0)
+		return NULL;
+	bounds = isl_calloc_type(map->ctx, struct isl_map_constant_bounds);
+	if (!bounds)
+		return NULL;
+	bounds->n_var = n_var;
+	bounds->bound = isl_mat_alloc(map->ctx, 2 * map->n, n_var);
+	bounds->known = isl_calloc_array(map->ctx, char, 2 * map->n * n_var);
+	if (!bounds->bound || (map->n > 0 && n_var > 0 && !bounds->known))
+		return isl_map_constant_bounds_free(bounds);
+
+	isl_int_init(v);
+	isl_int_init(d);
+	for (i = 0; i < map->n; ++i) {
+		isl_basic_map *bmap = map->p[i];
+
+		if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_RATIONAL))
+			continue;
+		for (j = 0; j < bmap->n_eq; ++j) {
+			int pos;
+
+			pos = single_var_constraint(bmap->eq[j], n_var,
+						    bmap->n_div);
+			if (pos < 0)
+				continue;
+			update_constant_bound(bounds, i, pos, bmap->eq[j],
+					      1, &v, &d);
+			update_constant_bound(bounds, i, pos, bmap->eq[j],
+					      -1, &v, &d);
+		}
+		for (j = 0; j < bmap->n_ineq; ++j) {
+			int pos;
+
+			pos = single_var_constraint(bmap->ineq[j], n_var,
+						    bmap->n_div);
+			if (pos < 0)
+				continue;
+			update_constant_bound(bounds, i, pos, bmap->ineq[j],
+					      1, &v, &d);
+		}
+	}
+	isl_int_clear(d);
+	isl_int_clear(v);
+
+	return bounds;
+}
+
+/* Do the constant bounds of basic map "i" in "bounds1" and
+ * those of basic map "j" in "bounds2" exclude any overlap?
+ */
+static int constant_bounds_disjoint(struct isl_map_constant_bounds *bounds1,
+	int i, struct isl_map_constant_bounds *bounds2, int j)
+{
+	int k;
+	int n_var = bounds1->n_var;
+	char *lower1 = bounds1->known + 2 * i * n_var;
+	char *upper1 = lower1 + n_var;
+	char *lower2 = bounds2->known + 2 * j * n_var;
+	char *upper2 = lower2 + n_var;
+	isl_int **b1 = bounds1->bound->row + 2 * i;
+	isl_int **b2 = bounds2->bound->row + 2 * j;
+
+	for (k = 0; k < n_var; ++k) {
+		if (lower1[k] && upper2[k] && isl_int_gt(b1[0][k], b2[1][k]))
+			return 1;
+		if (lower2[k] && upper1[k] && isl_int_gt(b2[0][k], b1[1][k]))
+			return 1;
+	}
+
+	return 0;
+}
+
+/* Is it obvious that the intersection of basic map "i" of "map1" and
+ * basic map "j" of "map2" is empty?
+ * "bounds1" and "bounds2" contain the constant bounds
+ * of the basic maps of "map1" and "map2".
+ * If they are not available, then nothing is obvious.
+ */
+static isl_bool intersection_is_obviously_empty(__isl_keep isl_map *map1,
+	int i, struct isl_map_constant_bounds *bounds1,
+	__isl_keep isl_map *map2, int j,
+	struct isl_map_constant_bounds *bounds2)
+{
+	if (!bounds1 || !bounds2)
+		return isl_bool_false;
+	if (constant_bounds_disjoint(bounds1, i, bounds2, j))
+		return isl_bool_true;
+	return isl_basic_map_plain_is_disjoint(map1->p[i], map2->p[j]);
+}
+
 /* map2 may be either a parameter domain or a map living in the same
  * space as map1.
+ *
+ * Whether the two spaces are equal is only determined once
+ * since this function is called on many small inputs.
  */
 static __isl_give isl_map *map_intersect_internal(__isl_take isl_map *map1,
 	__isl_take isl_map *map2)
 {
 	unsigned flags = 0;
-	isl_bool equal;
+	isl_bool equal, equal_space;
 	isl_map *result;
 	int i, j;
 	isl_size dim2, nparam2;
+	struct isl_map_constant_bounds *bounds1 = NULL, *bounds2 = NULL;
 
 	if (!map1 || !map2)
 		goto error;
 
+	equal_space = isl_space_is_equal(map1->dim, map2->dim);
+	if (equal_space < 0)
+		goto error;
 	if ((isl_map_plain_is_empty(map1) ||
-	     isl_map_plain_is_universe(map2)) &&
-	    isl_space_is_equal(map1->dim, map2->dim)) {
+	     isl_map_plain_is_universe(map2)) && equal_space) {
 		isl_map_free(map2);
 		return map1;
 	}
 	if ((isl_map_plain_is_empty(map2) ||
-	     isl_map_plain_is_universe(map1)) &&
-	    isl_space_is_equal(map1->dim, map2->dim)) {
+	     isl_map_plain_is_universe(map1)) && equal_space) {
 		isl_map_free(map1);
 		return map2;
 	}
 
 	if (is_convex_no_locals(map1) == isl_bool_true &&
-	    is_convex_no_locals(map2) == isl_bool_true &&
-	    isl_space_is_equal(map1->dim, map2->dim) &&
+	    is_convex_no_locals(map2) == isl_bool_true && equal_space &&
 	    (map1->p[0]->n_eq + map1->p[0]->n_ineq == 1 ||
 	     map2->p[0]->n_eq + map2->p[0]->n_ineq == 1))
 		return map_intersect_add_constraint(map1, map2);
@@ -3911,13 +4482,19 @@ static __isl_give isl_map *map_intersect_internal(__isl_take isl_map *map1,
 	if (dim2 < 0 || nparam2 < 0)
 		goto error;
 	if (dim2 != nparam2)
-		isl_assert(map1->ctx,
-			    isl_space_is_equal(map1->dim, map2->dim), goto error);
+		isl_assert(map1->ctx, equal_space, goto error);
 
 	if (ISL_F_ISSET(map1, ISL_MAP_DISJOINT) &&
 	    ISL_F_ISSET(map2, ISL_MAP_DISJOINT))
 		ISL_FL_SET(flags, ISL_MAP_DISJOINT);
 
+	if (equal_space && map1->n * map2->n > 1) {
+		bounds1 = isl_map_get_constant_bounds(map1);
+		bounds2 = isl_map_get_constant_bounds(map2);
+		if (!bounds1 || !bounds2)
+			goto error;
+	}
+
 	result = isl_map_alloc_space(isl_space_copy(map1->dim),
 				map1->n * map2->n, flags);
 	if (!result)
@@ -3925,6 +4502,14 @@ static __isl_give isl_map *map_intersect_internal(__isl_take isl_map *map1,
 	for (i = 0; i < map1->n; ++i)
 		for (j = 0; j < map2->n; ++j) {
 			struct isl_basic_map *part;
+			isl_bool empty;
+
+			empty = intersection_is_obviously_empty(map1, i,
+						bounds1, map2, j, bounds2);
+			if (empty < 0)
+				goto error_result;
+			if (empty)
+				continue;
 			part = isl_basic_map_intersect(
 				    isl_basic_map_copy(map1->p[i]),
 				    isl_basic_map_copy(map2->p[j]));
@@ -3934,10 +4519,16 @@ static __isl_give isl_map *map_intersect_internal(__isl_take isl_map *map1,
 			if (!result)
 				goto error;
 		}
+	isl_map_constant_bounds_free(bounds1);
+	isl_map_constant_bounds_free(bounds2);
 	isl_map_free(map1);
 	isl_map_free(map2);
 	return result;
+error_result:
+	isl_map_free(result);
 error:
+	isl_map_constant_bounds_free(bounds1);
+	isl_map_constant_bounds_free(bounds2);
 	isl_map_free(map1);
 	isl_map_free(map2);
 	return NULL;
@@ -4049,48 +4640,39 @@ static __isl_give isl_basic_map *basic_map_space_reset(
 	return bmap;
 }
 
-__isl_give isl_basic_map *isl_basic_map_insert_dims(
-	__isl_take isl_basic_map *bmap, enum isl_dim_type type,
+/* Construct an isl_dim_map for inserting "n" dimensions of type "type"
+ * at position "pos" in a basic map with space "space",
+ * resulting in a basic map with space "res_space".
+ * The local variables are not included since their number
+ * may be different for different basic maps in the same space.
+ * They can be added using isl_dim_map_extend.
+ */
+static __isl_give isl_dim_map *insert_dims_dim_map(__isl_keep isl_space *space,
+	__isl_keep isl_space *res_space, enum isl_dim_type type,
 	unsigned pos, unsigned n)
 {
-	isl_bool rational, is_empty;
-	isl_space *res_space;
-	struct isl_basic_map *res;
-	struct isl_dim_map *dim_map;
+	isl_dim_map *dim_map;
 	isl_size total;
 	unsigned off;
 	enum isl_dim_type t;
 
-	if (n == 0)
-		return basic_map_space_reset(bmap, type);
-
-	is_empty = isl_basic_map_plain_is_empty(bmap);
-	total = isl_basic_map_dim(bmap, isl_dim_all);
-	if (is_empty < 0 || total < 0)
-		return isl_basic_map_free(bmap);
-	res_space = isl_space_insert_dims(isl_basic_map_get_space(bmap),
-					type, pos, n);
-	if (!res_space)
-		return isl_basic_map_free(bmap);
-	if (is_empty) {
-		isl_basic_map_free(bmap);
-		return isl_basic_map_empty(res_space);
-	}
-
-	dim_map = isl_dim_map_alloc(bmap->ctx, total + n);
+	total = isl_space_dim(res_space, isl_dim_all);
+	if (total < 0)
+		return NULL;
+	dim_map = isl_dim_map_alloc(isl_space_get_ctx(space), total);
 	off = 0;
 	for (t = isl_dim_param; t <= isl_dim_out; ++t) {
 		isl_size dim;
 
 		if (t != type) {
-			isl_dim_map_dim(dim_map, bmap->dim, t, off);
+			isl_dim_map_dim(dim_map, space, t, off);
 		} else {
-			isl_size size = isl_basic_map_dim(bmap, t);
+			isl_size size = isl_space_dim(space, t);
 			if (size < 0)
 				dim_map = isl_dim_map_free(dim_map);
-			isl_dim_map_dim_range(dim_map, bmap->dim, t,
+			isl_dim_map_dim_range(dim_map, space, t,
 						0, pos, off);
-			isl_dim_map_dim_range(dim_map, bmap->dim, t,
+			isl_dim_map_dim_range(dim_map, space, t,
 						pos, size - pos, off + pos + n);
 		}
 		dim = isl_space_dim(res_space, t);
@@ -4098,7 +4680,28 @@ __isl_give isl_basic_map *isl_basic_map_insert_dims(
 			dim_map = isl_dim_map_free(dim_map);
 		off += dim;
 	}
-	isl_dim_map_div(dim_map, bmap, off);
+
+	return dim_map;
+}
+
+/* Insert dimensions in "bmap", resulting in a basic map with space
+ * "res_space", where "dim_map" is the corresponding isl_dim_map
+ * constructed by insert_dims_dim_map.
+ */
+static __isl_give isl_basic_map *basic_map_insert_dims(
+	__isl_take isl_basic_map *bmap, __isl_take isl_space *res_space,
+	__isl_keep isl_dim_map *dim_map)
+{
+	isl_bool rational, is_empty;
+	isl_basic_map *res;
+
+	is_empty = isl_basic_map_plain_is_empty(bmap);
+	if (is_empty < 0 || !res_space)
+		goto error;
+	if (is_empty) {
+		isl_basic_map_free(bmap);
+		return isl_basic_map_empty(res_space);
+	}
 
 	res = isl_basic_map_alloc_space(res_space,
 			bmap->n_div, bmap->n_eq, bmap->n_ineq);
@@ -4107,8 +4710,33 @@ __isl_give isl_basic_map *isl_basic_map_insert_dims(
 		res = isl_basic_map_free(res);
 	if (rational)
 		res = isl_basic_map_set_rational(res);
-	res = isl_basic_map_add_constraints_dim_map(res, bmap, dim_map);
+	res = isl_basic_map_add_constraints_dim_map(res, bmap,
+					isl_dim_map_extend(dim_map, bmap));
 	return isl_basic_map_finalize(res);
+error:
+	isl_space_free(res_space);
+	return isl_basic_map_free(bmap);
+}
+
+__isl_give isl_basic_map *isl_basic_map_insert_dims(
+	__isl_take isl_basic_map *bmap, enum isl_dim_type type,
+	unsigned pos, unsigned n)
+{
+	isl_space *res_space;
+	isl_dim_map *dim_map;
+
+	if (n == 0)
+		return basic_map_space_reset(bmap, type);
+
+	if (!bmap)
+		return NULL;
+	res_space = isl_space_insert_dims(isl_basic_map_get_space(bmap),
+					type, pos, n);
+	dim_map = insert_dims_dim_map(bmap->dim, res_space, type, pos, n);
+	bmap = basic_map_insert_dims(bmap, res_space, dim_map);
+	isl_dim_map_free(dim_map);
+
+	return bmap;
 }
 
 __isl_give isl_basic_set *isl_basic_set_insert_dims(
@@ -4155,11 +4783,18 @@ static __isl_give isl_map *map_space_reset(__isl_take isl_map *map,
 	return map;
 }
 
+/* Insert "n" dimensions of type "type" at position "pos" in "map".
+ *
+ * The result space and the corresponding isl_dim_map only depend
+ * on the space of "map", so they are computed only once and
+ * then applied to each basic map.
+ */
 __isl_give isl_map *isl_map_insert_dims(__isl_take isl_map *map,
 		enum isl_dim_type type, unsigned pos, unsigned n)
 {
 	int i;
 	isl_space *space;
+	isl_dim_map *dim_map;
 
 	if (n == 0)
 		return map_space_reset(map, type);
@@ -4168,18 +4803,25 @@ __isl_give isl_map *isl_map_insert_dims(__isl_take isl_map *map,
 	if (!map)
 		return NULL;
 
+	space = isl_space_insert_dims(isl_map_get_space(map), type, pos, n);
+	dim_map = insert_dims_dim_map(map->dim, space, type, pos, n);
+	if (!dim_map)
+		goto error;
 	for (i = 0; i < map->n; ++i) {
-		map->p[i] = isl_basic_map_insert_dims(map->p[i], type, pos, n);
+		map->p[i] = basic_map_insert_dims(map->p[i],
+					isl_space_copy(space), dim_map);
 		if (!map->p[i])
 			goto error;
 	}
+	isl_dim_map_free(dim_map);
 
-	space = isl_map_take_space(map);
-	space = isl_space_insert_dims(space, type, pos, n);
+	isl_space_free(isl_map_take_space(map));
 	map = isl_map_restore_space(map, space);
 
 	return map;
 error:
+	isl_dim_map_free(dim_map);
+	isl_space_free(space);
 	isl_map_free(map);
 	return NULL;
 }
@@ -4213,53 +4855,41 @@ error:
 	return NULL;
 }
 
-__isl_give isl_basic_map *isl_basic_map_move_dims(
-	__isl_take isl_basic_map *bmap,
+/* Is moving the "n" dimensions of type "src_type" starting at "src_pos"
+ * to dimensions of type "dst_type" at "dst_pos" in an object
+ * with space "space" a mere reinterpretation of these dimensions,
+ * i.e., do they already appear in the right position?
+ */
+static int move_dims_is_trivial(__isl_keep isl_space *space,
 	enum isl_dim_type dst_type, unsigned dst_pos,
 	enum isl_dim_type src_type, unsigned src_pos, unsigned n)
 {
-	isl_space *space;
-	struct isl_dim_map *dim_map;
-	struct isl_basic_map *res;
+	return pos(space, dst_type) + dst_pos ==
+	    pos(space, src_type) + src_pos + ((src_type < dst_type) ? n : 0);
+}
+
+/* Construct an isl_dim_map for moving the "n" dimensions of type "src_type"
+ * starting at "src_pos" to dimensions of type "dst_type" at "dst_pos"
+ * in a basic map with space "space".
+ * The local variables are not included since their number
+ * may be different for different basic maps in the same space.
+ * They can be added using isl_dim_map_extend.
+ */
+static __isl_give isl_dim_map *move_dims_dim_map(__isl_keep isl_space *space,
+	enum isl_dim_type dst_type, unsigned dst_pos,
+	enum isl_dim_type src_type, unsigned src_pos, unsigned n)
+{
+	isl_dim_map *dim_map;
 	enum isl_dim_type t;
 	isl_size total;
 	unsigned off;
 
-	if (!bmap)
-		return NULL;
-	if (n == 0) {
-		bmap = isl_basic_map_reset(bmap, src_type);
-		bmap = isl_basic_map_reset(bmap, dst_type);
-		return bmap;
-	}
-
-	if (isl_basic_map_check_range(bmap, src_type, src_pos, n) < 0)
-		return isl_basic_map_free(bmap);
-
-	if (dst_type == src_type && dst_pos == src_pos)
-		return bmap;
-
-	isl_assert(bmap->ctx, dst_type != src_type, goto error);
-
-	if (pos(bmap->dim, dst_type) + dst_pos ==
-	    pos(bmap->dim, src_type) + src_pos +
-					    ((src_type < dst_type) ? n : 0)) {
-		space = isl_basic_map_take_space(bmap);
-		space = isl_space_move_dims(space, dst_type, dst_pos,
-						src_type, src_pos, n);
-		bmap = isl_basic_map_restore_space(bmap, space);
-		bmap = isl_basic_map_finalize(bmap);
-
-		return bmap;
-	}
-
-	total = isl_basic_map_dim(bmap, isl_dim_all);
+	total = isl_space_dim(space, isl_dim_all);
 	if (total < 0)
-		return isl_basic_map_free(bmap);
-	dim_map = isl_dim_map_alloc(bmap->ctx, total);
+		return NULL;
+	dim_map = isl_dim_map_alloc(isl_space_get_ctx(space), total);
 
 	off = 0;
-	space = isl_basic_map_peek_space(bmap);
 	for (t = isl_dim_param; t <= isl_dim_out; ++t) {
 		isl_size size = isl_space_dim(space, t);
 		if (size < 0)
@@ -4286,22 +4916,88 @@ __isl_give isl_basic_map *isl_basic_map_move_dims(
 			off += size;
 		}
 	}
-	isl_dim_map_div(dim_map, bmap, off);
+
+	return dim_map;
+}
+
+/* Move dimensions in "bmap", resulting in a basic map with space
+ * "res_space", where "dim_map" is the corresponding isl_dim_map
+ * constructed by move_dims_dim_map, or NULL if the dimensions
+ * already appear in the right position (see move_dims_is_trivial).
+ */
+static __isl_give isl_basic_map *basic_map_move_dims(
+	__isl_take isl_basic_map *bmap, __isl_take isl_space *res_space,
+	__isl_keep isl_dim_map *dim_map)
+{
+	isl_basic_map *res;
+
+	if (!bmap)
+		goto error;
+
+	if (!dim_map) {
+		isl_space_free(isl_basic_map_take_space(bmap));
+		bmap = isl_basic_map_restore_space(bmap, res_space);
+		return isl_basic_map_finalize(bmap);
+	}
 
 	res = isl_basic_map_alloc_space(isl_basic_map_get_space(bmap),
 			bmap->n_div, bmap->n_eq, bmap->n_ineq);
-	bmap = isl_basic_map_add_constraints_dim_map(res, bmap, dim_map);
-	space = isl_basic_map_take_space(bmap);
-	space = isl_space_move_dims(space, dst_type, dst_pos,
-					src_type, src_pos, n);
-	bmap = isl_basic_map_restore_space(bmap, space);
+	bmap = isl_basic_map_add_constraints_dim_map(res, bmap,
+					isl_dim_map_extend(dim_map, bmap));
+	isl_space_free(isl_basic_map_take_space(bmap));
+	bmap = isl_basic_map_restore_space(bmap, res_space);
 	if (!bmap)
-		goto error;
+		return NULL;
 
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_SORTED);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	bmap = isl_basic_map_gauss(bmap, NULL);
 	bmap = isl_basic_map_finalize(bmap);
 
+	return bmap;
+error:
+	isl_space_free(res_space);
+	return isl_basic_map_free(bmap);
+}
+
+__isl_give isl_basic_map *isl_basic_map_move_dims(
+	__isl_take isl_basic_map *bmap,
+	enum isl_dim_type dst_type, unsigned dst_pos,
+	enum isl_dim_type src_type, unsigned src_pos, unsigned n)
+{
+	isl_space *space;
+	isl_dim_map *dim_map = NULL;
+
+	if (!bmap)
+		return NULL;
+	if (n == 0) {
+		bmap = isl_basic_map_reset(bmap, src_type);
+		bmap = isl_basic_map_reset(bmap, dst_type);
+		return bmap;
+	}
+
+	if (isl_basic_map_check_range(bmap, src_type, src_pos, n) < 0)
+		return isl_basic_map_free(bmap);
+
+	if (dst_type == src_type && dst_pos == src_pos)
+		return bmap;
+
+	isl_assert(bmap->ctx, dst_type != src_type, goto error);
+
+	space = isl_basic_map_peek_space(bmap);
+	if (!move_dims_is_trivial(space, dst_type, dst_pos,
+				    src_type, src_pos, n)) {
+		dim_map = move_dims_dim_map(space, dst_type, dst_pos,
+					    src_type, src_pos, n);
+		if (!dim_map)
+			goto error;
+	}
+	space = isl_space_move_dims(isl_space_copy(space), dst_type, dst_pos,
+					src_type, src_pos, n);
+	bmap = basic_map_move_dims(bmap, space, dim_map);
+	isl_dim_map_free(dim_map);
+
 	return bmap;
 error:
 	isl_basic_map_free(bmap);
@@ -4332,12 +5028,22 @@ error:
 	return NULL;
 }
 
+/* Move the "n" dimensions of "map" of type "src_type" starting at "src_pos"
+ * to dimensions of type "dst_type" at "dst_pos".
+ *
+ * The result space and the corresponding isl_dim_map only depend
+ * on the space of "map", so they are computed only once and
+ * then applied to each basic map.
+ * Any cached simple hulls are moved along.
+ */
 __isl_give isl_map *isl_map_move_dims(__isl_take isl_map *map,
 	enum isl_dim_type dst_type, unsigned dst_pos,
 	enum isl_dim_type src_type, unsigned src_pos, unsigned n)
 {
 	int i;
-	isl_space *space;
+	isl_space *map_space, *space = NULL;
+	isl_dim_map *dim_map = NULL;
+	isl_basic_map *hull[2] = { NULL, NULL };
 
 	if (n == 0) {
 		map = isl_map_reset(map, src_type);
@@ -4353,25 +5059,44 @@ __isl_give isl_map *isl_map_move_dims(__isl_take isl_map *map,
 
 	isl_assert(map->ctx, dst_type != src_type, goto error);
 
+	get_cached_simple_hulls(map, hull);
 	map = isl_map_cow(map);
 	if (!map)
-		return NULL;
+		goto error;
+
+	map_space = isl_map_peek_space(map);
+	if (!move_dims_is_trivial(map_space, dst_type, dst_pos,
+				    src_type, src_pos, n)) {
+		dim_map = move_dims_dim_map(map_space, dst_type, dst_pos,
+					    src_type, src_pos, n);
+		if (!dim_map)
+			goto error;
+	}
+	space = isl_space_move_dims(isl_space_copy(map_space),
+				    dst_type, dst_pos, src_type, src_pos, n);
+	if (!space)
+		goto error;
 
 	for (i = 0; i < map->n; ++i) {
-		map->p[i] = isl_basic_map_move_dims(map->p[i],
-						dst_type, dst_pos,
-						src_type, src_pos, n);
+		map->p[i] = basic_map_move_dims(map->p[i],
+					isl_space_copy(space), dim_map);
 		if (!map->p[i])
 			goto error;
 	}
+	for (i = 0; i < 2; ++i)
+		if (hull[i])
+			hull[i] = basic_map_move_dims(hull[i],
+					isl_space_copy(space), dim_map);
+	isl_dim_map_free(dim_map);
 
-	space = isl_map_take_space(map);
-	space = isl_space_move_dims(space, dst_type, dst_pos,
-					    src_type, src_pos, n);
+	isl_space_free(isl_map_take_space(map));
 	map = isl_map_restore_space(map, space);
 
-	return map;
+	return restore_cached_simple_hulls(map, hull);
 error:
+	isl_space_free(space);
+	isl_dim_map_free(dim_map);
+	free_cached_simple_hulls(hull);
 	isl_map_free(map);
 	return NULL;
 }
@@ -4513,12 +5238,118 @@ static __isl_give isl_basic_map *drop_irrelevant_constraints(
 	return bmap;
 }
 
+/* Can the variable at position "pos" of "bmap" (in the constraint
+ * coefficients) be eliminated exactly using Fourier-Motzkin elimination
+ * and should it be eliminated in this way according to "method"?
+ *
+ * The variable should not appear in any equality constraint
+ * (those are more efficiently exploited by isl_basic_map_simplify) or
+ * in the explicit representation of any local variable.
+ * Fourier-Motzkin elimination of an integer variable is exact
+ * if all its lower bounds or all its upper bounds have a unit
+ * coefficient.  In the first case, for example, the greatest lower
+ * bound is integral for any integer value of the other variables
+ * and it satisfies all upper bounds whenever the result
+ * of the elimination is satisfied.
+ *
+ * If "method" is ISL_PROJECT_OUT_AUTO, then the variable is only
+ * eliminated if this does not increase the number of constraints,
+ * i.e., if the number of combinations of a lower and an upper bound
+ * does not exceed the number of bounds.  Otherwise, keeping
+ * the variable as an existentially quantified variable is
+ * considered to be cheaper than dealing with the extra constraints.
+ */
+static isl_bool can_eliminate_var_exactly(__isl_keep isl_basic_map *bmap,
+	int pos, int method)
+{
+	int i;
+	int n_lower = 0, n_upper = 0;
+	int unit_lower = 1, unit_upper = 1;
+
+	for (i = 0; i < bmap->n_eq; ++i)
+		if (!isl_int_is_zero(bmap->eq[i][pos]))
+			return isl_bool_false;
+	for (i = 0; i < bmap->n_div; ++i) {
+		if (isl_int_is_zero(bmap->div[i][0]))
+			continue;
+		if (!isl_int_is_zero(bmap->div[i][1 + pos]))
+			return isl_bool_false;
+	}
+	for (i = 0; i < bmap->n_ineq; ++i) {
+		if (isl_int_is_pos(bmap->ineq[i][pos])) {
+			n_lower++;
+			if (!isl_int_is_one(bmap->ineq[i][pos]))
+				unit_lower = 0;
+		} else if (isl_int_is_neg(bmap->ineq[i][pos])) {
+			n_upper++;
+			if (!isl_int_is_negone(bmap->ineq[i][pos]))
+				unit_upper = 0;
+		}
+	}
+
+	if (!unit_lower && !unit_upper)
+		return isl_bool_false;
+	if (method == ISL_PROJECT_OUT_FM)
+		return isl_bool_true;
+	return isl_bool_ok(n_lower * n_upper <= n_lower + n_upper);
+}
+
+/* Eliminate those of the "n" variables of type "type", starting at "first",
+ * that can be eliminated exactly using Fourier-Motzkin elimination,
+ * as determined by can_eliminate_var_exactly depending on
+ * the project_out option.
+ * The eliminated variables are not removed from "bmap".
+ * Since they no longer appear in any constraint, they are removed
+ * without further analysis by isl_basic_map_drop_redundant_divs
+ * once they have been turned into existentially quantified variables.
+ * The number of eliminated variables is recorded in the statistics.
+ */
+static __isl_give isl_basic_map *eliminate_vars_exactly(
+	__isl_take isl_basic_map *bmap, enum isl_dim_type type,
+	unsigned first, unsigned n)
+{
+	int i;
+	int method;
+	isl_ctx *ctx;
+	isl_size offset;
+
+	offset = isl_basic_map_var_offset(bmap, type);
+	if (offset < 0)
+		return isl_basic_map_free(bmap);
+	ctx = isl_basic_map_get_ctx(bmap);
+	method = ctx->opt->project_out;
+	if (method == ISL_PROJECT_OUT_DIV)
+		return bmap;
+
+	for (i = n - 1; i >= 0; --i) {
+		isl_bool eliminate;
+
+		eliminate = can_eliminate_var_exactly(bmap,
+						1 + offset + first + i, method);
+		if (eliminate < 0)
+			return isl_basic_map_free(bmap);
+		if (!eliminate)
+			continue;
+		bmap = isl_basic_map_eliminate_vars(bmap,
+						    offset + first + i, 1);
+		if (!bmap)
+			return NULL;
+		ctx->stats->project_out_fm++;
+	}
+
+	return bmap;
+}
+
 /* Turn the n dimensions of type type, starting at first
  * into existentially quantified variables.
  *
  * If a subset of the projected out variables are unrelated
  * to any of the variables that remain, then the constraints
  * involving this subset are simply dropped first.
+ * Variables that can be eliminated exactly using Fourier-Motzkin
+ * elimination (depending on the project_out option) are
+ * eliminated directly, such that only the remaining variables
+ * need to be analyzed as existentially quantified variables.
  */
 __isl_give isl_basic_map *isl_basic_map_project_out(
 		__isl_take isl_basic_map *bmap,
@@ -4550,6 +5381,7 @@ __isl_give isl_basic_map *isl_basic_map_project_out(
 	if (isl_basic_map_check_range(bmap, type, first, n) < 0)
 		return isl_basic_map_free(bmap);
 
+	bmap = eliminate_vars_exactly(bmap, type, first, n);
 	bmap = move_last(bmap, type, first, n);
 	bmap = isl_basic_map_cow(bmap);
 	bmap = insert_div_rows(bmap, n);
@@ -5870,11 +6702,19 @@ static isl_stat check_map_space_equal_total_dim(__isl_keep isl_map *map,
 		"total dimensions do not match", return isl_stat_error);
 }
 
+/* Replace the space of "map" by "space".
+ *
+ * Since this does not affect the constraints,
+ * any cached simple hulls are preserved (with their space replaced
+ * as well).
+ */
 __isl_give isl_map *isl_map_reset_space(__isl_take isl_map *map,
 	__isl_take isl_space *space)
 {
 	int i;
+	isl_basic_map *hull[2];
 
+	get_cached_simple_hulls(map, hull);
 	map = isl_map_cow(map);
 	if (!map || !space)
 		goto error;
@@ -5885,11 +6725,16 @@ __isl_give isl_map *isl_map_reset_space(__isl_take isl_map *map,
 		if (!map->p[i])
 			goto error;
 	}
+	for (i = 0; i < 2; ++i)
+		if (hull[i])
+			hull[i] = isl_basic_map_reset_space(hull[i],
+						    isl_space_copy(space));
 	isl_space_free(isl_map_take_space(map));
 	map = isl_map_restore_space(map, space);
 
-	return map;
+	return restore_cached_simple_hulls(map, hull);
 error:
+	free_cached_simple_hulls(hull);
 	isl_map_free(map);
 	isl_space_free(space);
 	return NULL;
@@ -6265,6 +7110,7 @@ __isl_give isl_map *isl_map_alloc_space(__isl_take isl_space *space, int n,
 {
 	struct isl_map *map;
 
+	space = isl_space_intern(space);
 	if (!space)
 		return NULL;
 	if (n < 0)
@@ -6419,6 +7265,34 @@ __isl_give isl_map *isl_map_dup(__isl_keep isl_map *map)
 	return dup;
 }
 
+/* Return a copy of "map" in "ctx".
+ * Unless "map" already belongs to "ctx", "map" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_map *isl_map_copy_to_ctx(__isl_keep isl_map *map, isl_ctx *ctx)
+{
+	int i;
+	isl_space *space;
+	isl_map *dup;
+
+	if (!map)
+		return NULL;
+	if (map->ctx == ctx)
+		return isl_map_copy(map);
+
+	space = isl_space_copy_to_ctx(isl_map_peek_space(map), ctx);
+	dup = isl_map_alloc_space(space, map->n, map->flags);
+	for (i = 0; i < map->n; ++i)
+		dup = isl_map_add_basic_map(dup,
+			    isl_basic_map_copy_to_ctx(map->p[i], ctx));
+	return dup;
+}
+
+__isl_give isl_set *isl_set_copy_to_ctx(__isl_keep isl_set *set, isl_ctx *ctx)
+{
+	return set_from_map(isl_map_copy_to_ctx(set_to_map(set), ctx));
+}
+
 __isl_give isl_map *isl_map_add_basic_map(__isl_take isl_map *map,
 						__isl_take isl_basic_map *bmap)
 {
@@ -6473,8 +7347,8 @@ static __isl_give isl_basic_map *isl_basic_map_fix_pos_si(
 	if (total < 0)
 		return isl_basic_map_free(bmap);
 
-	bmap = isl_basic_map_cow(bmap);
 	bmap = isl_basic_map_extend_constraints(bmap, 1, 0);
+	bmap = isl_basic_map_cow(bmap);
 	j = isl_basic_map_alloc_equality(bmap);
 	if (j < 0)
 		goto error;
@@ -6498,8 +7372,8 @@ static __isl_give isl_basic_map *isl_basic_map_fix_pos(
 	if (total < 0)
 		return isl_basic_map_free(bmap);
 
-	bmap = isl_basic_map_cow(bmap);
 	bmap = isl_basic_map_extend_constraints(bmap, 1, 0);
+	bmap = isl_basic_map_cow(bmap);
 	j = isl_basic_map_alloc_equality(bmap);
 	if (j < 0)
 		goto error;
@@ -6756,8 +7630,8 @@ static __isl_give isl_basic_map *basic_map_bound_si(
 	if (total < 0)
 		return isl_basic_map_free(bmap);
 	pos += isl_basic_map_offset(bmap, type);
-	bmap = isl_basic_map_cow(bmap);
 	bmap = isl_basic_map_extend_constraints(bmap, 0, 1);
+	bmap = isl_basic_map_cow(bmap);
 	j = isl_basic_map_alloc_inequality(bmap);
 	if (j < 0)
 		goto error;
@@ -6854,8 +7728,8 @@ static __isl_give isl_basic_map *basic_map_bound(
 	if (total < 0)
 		return isl_basic_map_free(bmap);
 	pos += isl_basic_map_offset(bmap, type);
-	bmap = isl_basic_map_cow(bmap);
 	bmap = isl_basic_map_extend_constraints(bmap, 0, 1);
+	bmap = isl_basic_map_cow(bmap);
 	j = isl_basic_map_alloc_inequality(bmap);
 	if (j < 0)
 		goto error;
@@ -7567,10 +8441,13 @@ static __isl_give isl_basic_set *basic_set_parameter_preimage(
 	bset->dim->nparam = 0;
 	bset->dim->n_out = nparam;
 	bset = isl_basic_set_preimage(bset, mat);
-	if (bset) {
-		bset->dim->nparam = bset->dim->n_out;
-		bset->dim->n_out = 0;
-	}
+	if (!bset)
+		return NULL;
+	bset->dim = isl_space_cow(bset->dim);
+	if (!bset->dim)
+		return isl_basic_set_free(bset);
+	bset->dim->nparam = bset->dim->n_out;
+	bset->dim->n_out = 0;
 	return bset;
 error:
 	isl_mat_free(mat);
@@ -8081,6 +8958,8 @@ isl_bool isl_map_divs_known(__isl_keep isl_map *map)
  * expressions for them.  However, this computation may be
  * quite expensive, so first try to remove divs that aren't
  * strictly needed.
+ * The number of parametric integer programming based computations
+ * of explicit expressions is recorded in the statistics.
  */
 __isl_give isl_map *isl_basic_map_compute_divs(__isl_take isl_basic_map *bmap)
 {
@@ -8101,6 +8980,7 @@ __isl_give isl_map *isl_basic_map_compute_divs(__isl_take isl_basic_map *bmap)
 	if (known)
 		return isl_map_from_basic_map(bmap);
 
+	bmap->ctx->stats->compute_divs_pip++;
 	map = compute_divs(bmap);
 	return map;
 error:
@@ -8108,6 +8988,14 @@ error:
 	return NULL;
 }
 
+/* Compute explicit expressions for all unknown divs in "map".
+ *
+ * Since this computation may be quite expensive, it is only performed
+ * when an operation actually requires explicit expressions and
+ * the result is stored in map->cached_divs such that it can be
+ * reused by subsequent calls on the same (shared) map.
+ * The cache is cleared whenever the map is modified (in isl_map_cow).
+ */
 __isl_give isl_map *isl_map_compute_divs(__isl_take isl_map *map)
 {
 	int i;
@@ -8127,6 +9015,12 @@ __isl_give isl_map *isl_map_compute_divs(__isl_take isl_map *map)
 	if (known)
 		return map;
 
+	if (map->cached_divs) {
+		res = isl_map_copy(map->cached_divs);
+		isl_map_free(map);
+		return res;
+	}
+
 	res = isl_basic_map_compute_divs(isl_basic_map_copy(map->p[0]));
 	for (i = 1 ; i < map->n; ++i) {
 		struct isl_map *r2;
@@ -8136,6 +9030,8 @@ __isl_give isl_map *isl_map_compute_divs(__isl_take isl_map *map)
 		else
 			res = isl_map_union(res, r2);
 	}
+	if (res && map->ref > 1)
+		map->cached_divs = isl_map_copy(res);
 	isl_map_free(map);
 
 	return res;
@@ -8698,48 +9594,63 @@ static isl_stat isl_basic_map_check_transformation(
 	return isl_stat_ok;
 }
 
+/* Replace the "n" variables at position "in" in the "n_row" rows of "row"
+ * by the sum of themselves and the "n" variables at position "out".
+ * That is, given constraints c_in in + c_out out, replace them
+ * by (c_in + c_out) in + c_out d, where out = in + d and
+ * where the variables d take the place of the variables out.
+ */
+static void add_out_to_in(isl_int **row, int n_row, unsigned in, unsigned out,
+	unsigned n)
+{
+	int i, j;
+
+	for (i = 0; i < n_row; ++i)
+		for (j = 0; j < n; ++j)
+			isl_int_add(row[i][in + j], row[i][in + j],
+				    row[i][out + j]);
+}
+
 /*
  * returns range - domain
+ *
+ * Rather than constructing a product with an extra copy
+ * of the domain and projecting out both the domain and the range,
+ * perform the change of variables out = in + d on "bmap" directly,
+ * with d taking the place of the output variables, and
+ * project out the input variables.
+ * This change of variables is unimodular, so it preserves
+ * everything but the order of the local variables and
+ * the (lack of) duplicate constraints.
  */
 __isl_give isl_basic_set *isl_basic_map_deltas(__isl_take isl_basic_map *bmap)
 {
 	isl_space *target_space;
-	struct isl_basic_set *bset;
 	isl_size dim;
-	isl_size nparam;
-	isl_size total;
-	int i;
+	unsigned in, out;
 
 	if (isl_basic_map_check_transformation(bmap) < 0)
 		return isl_basic_map_free(bmap);
 	dim = isl_basic_map_dim(bmap, isl_dim_in);
-	nparam = isl_basic_map_dim(bmap, isl_dim_param);
-	if (dim < 0 || nparam < 0)
-		goto error;
+	if (dim < 0)
+		return isl_basic_map_free(bmap);
+	bmap = isl_basic_map_cow(bmap);
+	if (!bmap)
+		return NULL;
+	in = isl_basic_map_offset(bmap, isl_dim_in);
+	out = isl_basic_map_offset(bmap, isl_dim_out);
+	add_out_to_in(bmap->eq, bmap->n_eq, in, out, dim);
+	add_out_to_in(bmap->ineq, bmap->n_ineq, in, out, dim);
+	add_out_to_in(bmap->div, bmap->n_div, 1 + in, 1 + out, dim);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SORTED);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_NORMALIZED_DIVS);
+
 	target_space = isl_space_domain(isl_basic_map_get_space(bmap));
-	bmap = isl_basic_map_from_range(isl_basic_map_wrap(bmap));
-	bmap = isl_basic_map_add_dims(bmap, isl_dim_in, dim);
-	total = isl_basic_map_dim(bmap, isl_dim_all);
-	if (total < 0)
-		bmap = isl_basic_map_free(bmap);
-	bmap = isl_basic_map_extend_constraints(bmap, dim, 0);
-	for (i = 0; i < dim; ++i) {
-		int j = isl_basic_map_alloc_equality(bmap);
-		if (j < 0) {
-			bmap = isl_basic_map_free(bmap);
-			break;
-		}
-		isl_seq_clr(bmap->eq[j], 1 + total);
-		isl_int_set_si(bmap->eq[j][1+nparam+i], 1);
-		isl_int_set_si(bmap->eq[j][1+nparam+dim+i], 1);
-		isl_int_set_si(bmap->eq[j][1+nparam+2*dim+i], -1);
-	}
-	bset = isl_basic_map_domain(bmap);
-	bset = isl_basic_set_reset_space(bset, target_space);
-	return bset;
-error:
-	isl_basic_map_free(bmap);
-	return NULL;
+	bmap = isl_basic_map_project_out(bmap, isl_dim_in, 0, dim);
+	return isl_basic_set_reset_space(isl_basic_map_range(bmap),
+					target_space);
 }
 
 /* Is the tuple of type "type1" of "map" the same as
@@ -8822,9 +9733,102 @@ error:
 	return NULL;
 }
 
-/*
- * returns [domain -> range] -> range - domain
- */
+/* Return the sign of the minimal (or maximal if "max" is set)
+ * rational value of each of the differences between
+ * the image elements and the corresponding domain elements in "map",
+ * i.e., of each of the elements of isl_map_deltas(map),
+ * without constructing the set of differences.
+ *
+ * The optimal values are computed using an isl_lp_solver such that
+ * each LP can start from the optimal basis of the previous one.
+ * An unbounded minimum (maximum) results in a sign of -1 (1).
+ * If "map" is empty, then all elements are NaN.
+ * Since the optimum is computed over the rationals,
+ * the sign is only an approximation, in the sense that
+ * an integer difference may be zero, while the sign of
+ * the rational optimum is negative (or positive).
+ */
+static __isl_give isl_multi_val *isl_map_get_deltas_sign(
+	__isl_keep isl_map *map, int max)
+{
+	int i;
+	isl_ctx *ctx;
+	isl_size nparam, dim, total;
+	unsigned in, out;
+	isl_space *space;
+	isl_multi_val *mv;
+	isl_lp_solver *solver;
+	isl_vec *f;
+	isl_int opt;
+
+	if (isl_map_check_transformation(map) < 0)
+		return NULL;
+	nparam = isl_map_dim(map, isl_dim_param);
+	dim = isl_map_dim(map, isl_dim_in);
+	total = isl_map_dim(map, isl_dim_all);
+	if (nparam < 0 || dim < 0 || total < 0)
+		return NULL;
+
+	ctx = isl_map_get_ctx(map);
+	space = isl_space_domain(isl_map_get_space(map));
+	mv = isl_multi_val_zero(isl_space_drop_all_params(space));
+	solver = isl_map_lp_solver_alloc(map);
+	f = isl_vec_alloc(ctx, 1 + total);
+	if (!solver || !f)
+		mv = isl_multi_val_free(mv);
+	in = 1 + nparam;
+	out = in + dim;
+
+	isl_int_init(opt);
+	for (i = 0; mv && i < dim; ++i) {
+		enum isl_lp_result res;
+		isl_val *v;
+
+		isl_seq_clr(f->el, 1 + total);
+		isl_int_set_si(f->el[in + i], -1);
+		isl_int_set_si(f->el[out + i], 1);
+		res = isl_lp_solver_solve(solver, max, f->el, ctx->one,
+					&opt, NULL, NULL);
+		if (res == isl_lp_error)
+			v = NULL;
+		else if (res == isl_lp_empty)
+			v = isl_val_nan(ctx);
+		else if (res == isl_lp_unbounded)
+			v = isl_val_int_from_si(ctx, max ? 1 : -1);
+		else
+			v = isl_val_int_from_si(ctx, isl_int_sgn(opt));
+		mv = isl_multi_val_set_val(mv, i, v);
+	}
+	isl_int_clear(opt);
+
+	isl_vec_free(f);
+	isl_lp_solver_free(solver);
+	return mv;
+}
+
+/* Return the sign of the minimal rational value of each of
+ * the differences between the image elements and
+ * the corresponding domain elements in "map".
+ */
+__isl_give isl_multi_val *isl_map_get_deltas_min_sign(
+	__isl_keep isl_map *map)
+{
+	return isl_map_get_deltas_sign(map, 0);
+}
+
+/* Return the sign of the maximal rational value of each of
+ * the differences between the image elements and
+ * the corresponding domain elements in "map".
+ */
+__isl_give isl_multi_val *isl_map_get_deltas_max_sign(
+	__isl_keep isl_map *map)
+{
+	return isl_map_get_deltas_sign(map, 1);
+}
+
+/*
+ * returns [domain -> range] -> range - domain
+ */
 __isl_give isl_basic_map *isl_basic_map_deltas_map(
 	__isl_take isl_basic_map *bmap)
 {
@@ -9207,6 +10211,263 @@ isl_stat isl_basic_set_check_equal_space(__isl_keep isl_basic_set *bset1,
 						bset_to_bmap(bset1));
 }
 
+/* A row of length "len" that is being looked up in a hash table
+ * of constraints.
+ */
+struct isl_plain_row {
+	isl_int *row;
+	unsigned len;
+};
+
+/* Is the constraint stored in "entry" equal to the row "val"?
+ */
+static isl_bool has_row(const void *entry, const void *val)
+{
+	const struct isl_plain_row *r = val;
+
+	return isl_bool_ok(isl_seq_eq((isl_int *) entry, r->row, r->len));
+}
+
+/* Hash tables of the equalities and of the inequalities of a basic map,
+ * along with a temporary row for holding negated constraints.
+ * "len" is the length of the constraints (without divs definitions).
+ */
+struct isl_plain_constraints {
+	isl_ctx *ctx;
+	unsigned len;
+	struct isl_hash_table *eq;
+	struct isl_hash_table *ineq;
+	isl_vec *neg;
+};
+
+/* Free the memory allocated by plain_constraints_init.
+ */
+static void plain_constraints_clear(struct isl_plain_constraints *pc)
+{
+	isl_hash_table_free(pc->ctx, pc->eq);
+	isl_hash_table_free(pc->ctx, pc->ineq);
+	isl_vec_free(pc->neg);
+}
+
+/* Add the "n" constraints in "row" to "table".
+ */
+static isl_stat add_rows(struct isl_plain_constraints *pc,
+	struct isl_hash_table *table, isl_int **row, int n)
+{
+	int i;
+
+	for (i = 0; i < n; ++i) {
+		struct isl_hash_table_entry *entry;
+		struct isl_plain_row r = { row[i], pc->len };
+		uint32_t hash;
+
+		hash = isl_seq_get_hash(row[i], pc->len);
+		entry = isl_hash_table_find(pc->ctx, table, hash,
+					    &has_row, &r, 1);
+		if (!entry)
+			return isl_stat_error;
+		entry->data = row[i];
+	}
+
+	return isl_stat_ok;
+}
+
+/* Collect the constraints of "bmap" in "pc".
+ */
+static isl_stat plain_constraints_init(struct isl_plain_constraints *pc,
+	__isl_keep isl_basic_map *bmap)
+{
+	isl_size total;
+
+	pc->ctx = isl_basic_map_get_ctx(bmap);
+	total = isl_basic_map_dim(bmap, isl_dim_all);
+	if (total < 0)
+		return isl_stat_error;
+	pc->len = 1 + total;
+	pc->eq = isl_hash_table_alloc(pc->ctx, bmap->n_eq);
+	pc->ineq = isl_hash_table_alloc(pc->ctx, bmap->n_ineq);
+	pc->neg = isl_vec_alloc(pc->ctx, pc->len);
+	if (!pc->eq || !pc->ineq || !pc->neg)
+		goto error;
+	if (add_rows(pc, pc->eq, bmap->eq, bmap->n_eq) < 0 ||
+	    add_rows(pc, pc->ineq, bmap->ineq, bmap->n_ineq) < 0)
+		goto error;
+	return isl_stat_ok;
+error:
+	plain_constraints_clear(pc);
+	return isl_stat_error;
+}
+
+/* Does "table" contain "row"?
+ */
+static isl_bool table_has_row(struct isl_plain_constraints *pc,
+	struct isl_hash_table *table, isl_int *row)
+{
+	struct isl_hash_table_entry *entry;
+	struct isl_plain_row r = { row, pc->len };
+	uint32_t hash;
+
+	hash = isl_seq_get_hash(row, pc->len);
+	entry = isl_hash_table_find(pc->ctx, table, hash, &has_row, &r, 0);
+	if (!entry)
+		return isl_bool_error;
+	return isl_bool_ok(entry != isl_hash_table_entry_none);
+}
+
+/* Does "pc" contain an equality that is equal to "row",
+ * up to a change of sign?
+ */
+static isl_bool has_equality(struct isl_plain_constraints *pc, isl_int *row)
+{
+	isl_bool found;
+
+	found = table_has_row(pc, pc->eq, row);
+	if (found < 0 || found)
+		return found;
+	isl_seq_neg(pc->neg->el, row, pc->len);
+	return table_has_row(pc, pc->eq, pc->neg->el);
+}
+
+/* Does "pc" contain a constraint that implies the inequality "row",
+ * i.e., the same inequality or an equality that is equal to "row",
+ * up to a change of sign?
+ */
+static isl_bool has_inequality(struct isl_plain_constraints *pc, isl_int *row)
+{
+	isl_bool found;
+
+	found = table_has_row(pc, pc->ineq, row);
+	if (found < 0 || found)
+		return found;
+	return has_equality(pc, row);
+}
+
+/* Are the local variables of "bmap2" compatible with those of "bmap1"
+ * for the purpose of a syntactic subset check?
+ * That is, do they have the same number of local variables and
+ * does every local variable of "bmap2" with a known expression
+ * have the same known expression in "bmap1"?
+ * Local variables of "bmap2" without a known expression
+ * are existentially quantified and can therefore take on any value,
+ * in particular the value they have in "bmap1".
+ */
+static isl_bool plain_compatible_divs(__isl_keep isl_basic_map *bmap1,
+	__isl_keep isl_basic_map *bmap2, unsigned len)
+{
+	int i;
+
+	if (bmap1->n_div != bmap2->n_div)
+		return isl_bool_false;
+	for (i = 0; i < bmap2->n_div; ++i) {
+		if (isl_int_is_zero(bmap2->div[i][0]))
+			continue;
+		if (!isl_seq_eq(bmap1->div[i], bmap2->div[i], 1 + len))
+			return isl_bool_false;
+	}
+
+	return isl_bool_true;
+}
+
+/* Is every constraint of "bmap2" also a constraint
+ * of the basic map that was used to construct "pc", "bmap1"?
+ * If so, "bmap1" is a subset of "bmap2".
+ */
+static isl_bool plain_constraints_contain(struct isl_plain_constraints *pc,
+	__isl_keep isl_basic_map *bmap1, __isl_keep isl_basic_map *bmap2)
+{
+	int i;
+	isl_bool ok;
+
+	if (ISL_F_ISSET(bmap1, ISL_BASIC_MAP_RATIONAL) &&
+	    !ISL_F_ISSET(bmap2, ISL_BASIC_MAP_RATIONAL))
+		return isl_bool_false;
+	ok = plain_compatible_divs(bmap1, bmap2, pc->len);
+	for (i = 0; ok == isl_bool_true && i < bmap2->n_eq; ++i)
+		ok = has_equality(pc, bmap2->eq[i]);
+	for (i = 0; ok == isl_bool_true && i < bmap2->n_ineq; ++i)
+		ok = has_inequality(pc, bmap2->ineq[i]);
+
+	return ok;
+}
+
+/* Is "bmap1" obviously a subset of "bmap2"?
+ * That is, is "bmap1" marked empty or is every constraint of "bmap2"
+ * syntactically also a constraint of "bmap1"?
+ * A false result does not mean that "bmap1" is not a subset of "bmap2".
+ */
+isl_bool isl_basic_map_plain_is_subset(__isl_keep isl_basic_map *bmap1,
+	__isl_keep isl_basic_map *bmap2)
+{
+	struct isl_plain_constraints pc;
+	isl_bool is_subset;
+
+	if (!bmap1 || !bmap2)
+		return isl_bool_error;
+	is_subset = isl_basic_map_has_equal_space(bmap1, bmap2);
+	if (is_subset < 0 || !is_subset)
+		return is_subset;
+	if (ISL_F_ISSET(bmap1, ISL_BASIC_MAP_EMPTY))
+		return isl_bool_true;
+	if (plain_constraints_init(&pc, bmap1) < 0)
+		return isl_bool_error;
+	is_subset = plain_constraints_contain(&pc, bmap1, bmap2);
+	plain_constraints_clear(&pc);
+
+	return is_subset;
+}
+
+isl_bool isl_basic_set_plain_is_subset(__isl_keep isl_basic_set *bset1,
+	__isl_keep isl_basic_set *bset2)
+{
+	return isl_basic_map_plain_is_subset(bset_to_bmap(bset1),
+					    bset_to_bmap(bset2));
+}
+
+/* Is "map1" obviously a subset of "map2"?
+ * That is, is every basic map of "map1" obviously a subset
+ * of some basic map of "map2"?
+ * The constraints of each basic map of "map1" are only collected once
+ * and then compared against the constraints of every basic map of "map2".
+ * A false result does not mean that "map1" is not a subset of "map2".
+ */
+isl_bool isl_map_plain_is_subset(__isl_keep isl_map *map1,
+	__isl_keep isl_map *map2)
+{
+	int i, j;
+	isl_bool is_subset;
+
+	if (!map1 || !map2)
+		return isl_bool_error;
+	is_subset = isl_map_has_equal_space(map1, map2);
+	if (is_subset < 0 || !is_subset)
+		return is_subset;
+
+	for (i = 0; i < map1->n; ++i) {
+		struct isl_plain_constraints pc;
+		isl_basic_map *bmap1 = map1->p[i];
+
+		if (ISL_F_ISSET(bmap1, ISL_BASIC_MAP_EMPTY))
+			continue;
+		if (plain_constraints_init(&pc, bmap1) < 0)
+			return isl_bool_error;
+		is_subset = isl_bool_false;
+		for (j = 0; !is_subset && j < map2->n; ++j)
+			is_subset = plain_constraints_contain(&pc, bmap1,
+							map2->p[j]);
+		plain_constraints_clear(&pc);
+		if (is_subset < 0 || !is_subset)
+			return is_subset;
+	}
+
+	return isl_bool_true;
+}
+
+isl_bool isl_set_plain_is_subset(__isl_keep isl_set *set1,
+	__isl_keep isl_set *set2)
+{
+	return isl_map_plain_is_subset(set_to_map(set1), set_to_map(set2));
+}
+
 #undef TYPE
 #define TYPE	isl_map
 
@@ -9401,8 +10662,236 @@ isl_bool isl_set_plain_is_universe(__isl_keep isl_set *set)
 	return isl_map_plain_is_universe(set_to_map(set));
 }
 
+/* Integer bounds on the variables of a basic map,
+ * including the local variables.
+ * If "has_lower"[i] is set, then "lower"->el[i] is a lower bound
+ * on variable i.  Similarly for "has_upper" and "upper".
+ */
+struct isl_var_bounds {
+	isl_size total;
+	isl_vec *lower;
+	isl_vec *upper;
+	char *has_lower;
+	char *has_upper;
+};
+
+/* Free all memory allocated for "bounds".
+ */
+static void isl_var_bounds_clear(struct isl_var_bounds *bounds)
+{
+	isl_vec_free(bounds->lower);
+	isl_vec_free(bounds->upper);
+	free(bounds->has_lower);
+	free(bounds->has_upper);
+}
+
+/* Tighten the bounds in "bounds" using constraint "c",
+ * which is an equality constraint if "eq" is set.
+ * Only constraints that involve at most a single variable are used.
+ * Since all variables are integer, the bounds are rounded inward.
+ * Return isl_bool_true if a contradiction was found.
+ */
+static isl_bool isl_var_bounds_add(struct isl_var_bounds *bounds,
+	isl_int *c, int eq)
+{
+	int pos;
+	isl_bool empty = isl_bool_false;
+	isl_int a, q;
+
+	pos = isl_seq_first_non_zero(c + 1, bounds->total);
+	if (pos < 0) {
+		if (eq)
+			return isl_bool_ok(!isl_int_is_zero(c[0]));
+		return isl_bool_ok(isl_int_is_neg(c[0]));
+	}
+	if (isl_seq_first_non_zero(c + 1 + pos + 1,
+				    bounds->total - pos - 1) != -1)
+		return isl_bool_false;
+
+	isl_int_init(a);
+	isl_int_init(q);
+	isl_int_abs(a, c[1 + pos]);
+	if (eq && !isl_int_is_divisible_by(c[0], a)) {
+		empty = isl_bool_true;
+	} else {
+		isl_int_fdiv_q(q, c[0], a);
+		if (eq || isl_int_is_pos(c[1 + pos])) {
+			if (isl_int_is_pos(c[1 + pos]))
+				isl_int_neg(q, q);
+			if (!bounds->has_lower[pos] ||
+			    isl_int_gt(q, bounds->lower->el[pos]))
+				isl_int_set(bounds->lower->el[pos], q);
+			bounds->has_lower[pos] = 1;
+		}
+		if (eq || isl_int_is_neg(c[1 + pos])) {
+			if (!bounds->has_upper[pos] ||
+			    isl_int_lt(q, bounds->upper->el[pos]))
+				isl_int_set(bounds->upper->el[pos], q);
+			bounds->has_upper[pos] = 1;
+		}
+		if (bounds->has_lower[pos] && bounds->has_upper[pos] &&
+		    isl_int_gt(bounds->lower->el[pos], bounds->upper->el[pos]))
+			empty = isl_bool_true;
+	}
+	isl_int_clear(q);
+	isl_int_clear(a);
+
+	return empty;
+}
+
+/* Is "c" obviously violated by any element in the box described
+ * by "bounds"?
+ * That is, is the maximal value of the affine expression "c"
+ * over the box negative or, in case of an equality constraint ("eq" set),
+ * is its minimal value positive?
+ * If any required bound is missing, then the corresponding
+ * extremal value is considered to be unbounded.
+ */
+static int isl_var_bounds_violates(struct isl_var_bounds *bounds,
+	isl_int *c, int eq)
+{
+	int i;
+	int has_sup = 1, has_inf = eq;
+	int violated;
+	isl_int sup, inf;
+
+	isl_int_init(sup);
+	isl_int_init(inf);
+	isl_int_set(sup, c[0]);
+	isl_int_set(inf, c[0]);
+	for (i = 0; i < bounds->total && (has_sup || has_inf); ++i) {
+		int pos = isl_int_is_pos(c[1 + i]);
+
+		if (isl_int_is_zero(c[1 + i]))
+			continue;
+		if (has_sup && (pos ? bounds->has_upper[i] :
+					bounds->has_lower[i]))
+			isl_int_addmul(sup, c[1 + i], pos ?
+				bounds->upper->el[i] : bounds->lower->el[i]);
+		else
+			has_sup = 0;
+		if (has_inf && (pos ? bounds->has_lower[i] :
+					bounds->has_upper[i]))
+			isl_int_addmul(inf, c[1 + i], pos ?
+				bounds->lower->el[i] : bounds->upper->el[i]);
+		else
+			has_inf = 0;
+	}
+	violated = (has_sup && isl_int_is_neg(sup)) ||
+		    (has_inf && isl_int_is_pos(inf));
+	isl_int_clear(inf);
+	isl_int_clear(sup);
+
+	return violated;
+}
+
+/* Construct a candidate element of the box described by "bounds"
+ * by taking the value closest to zero for each variable.
+ */
+static __isl_give isl_vec *isl_var_bounds_candidate(isl_ctx *ctx,
+	struct isl_var_bounds *bounds)
+{
+	int i;
+	isl_vec *v;
+
+	v = isl_vec_alloc(ctx, 1 + bounds->total);
+	if (!v)
+		return NULL;
+	isl_int_set_si(v->el[0], 1);
+	for (i = 0; i < bounds->total; ++i) {
+		isl_int_set_si(v->el[1 + i], 0);
+		if (bounds->has_lower[i] && isl_int_is_pos(bounds->lower->el[i]))
+			isl_int_set(v->el[1 + i], bounds->lower->el[i]);
+		if (bounds->has_upper[i] && isl_int_is_neg(bounds->upper->el[i]))
+			isl_int_set(v->el[1 + i], bounds->upper->el[i]);
+	}
+
+	return v;
+}
+
+/* Try and decide whether the integer basic map "bmap" is empty
+ * without constructing a tableau.
+ *
+ * First collect the bounds on individual variables,
+ * looking for constraints that are violated by themselves or
+ * pairs of bounds on the same variable that contradict each other.
+ * Then look for pairs of opposite inequality constraints
+ * that contradict each other and for constraints that are violated
+ * by every element of the box formed by the bounds on
+ * individual variables.
+ * If no contradiction is found, then check whether the element
+ * of this box that is closest to the origin satisfies all constraints.
+ *
+ * Return isl_bool_true if "bmap" was found to be empty.
+ * If an element of "bmap" was found, then return isl_bool_false
+ * and store this element in *sample.
+ * Otherwise, return isl_bool_false and leave *sample NULL.
+ */
+static isl_bool basic_map_is_empty_by_bounds(__isl_keep isl_basic_map *bmap,
+	__isl_give isl_vec **sample)
+{
+	int i;
+	isl_ctx *ctx;
+	isl_bool empty = isl_bool_false;
+	isl_bool contains;
+	struct isl_var_bounds bounds;
+
+	*sample = NULL;
+	bounds.total = isl_basic_map_dim(bmap, isl_dim_all);
+	if (bounds.total < 0)
+		return isl_bool_error;
+	ctx = isl_basic_map_get_ctx(bmap);
+	bounds.lower = isl_vec_alloc(ctx, bounds.total);
+	bounds.upper = isl_vec_alloc(ctx, bounds.total);
+	bounds.has_lower = isl_calloc_array(ctx, char, bounds.total);
+	bounds.has_upper = isl_calloc_array(ctx, char, bounds.total);
+	if (!bounds.lower || !bounds.upper ||
+	    (bounds.total && (!bounds.has_lower || !bounds.has_upper))) {
+		isl_var_bounds_clear(&bounds);
+		return isl_bool_error;
+	}
+
+	for (i = 0; !empty && i < bmap->n_eq; ++i)
+		empty = isl_var_bounds_add(&bounds, bmap->eq[i], 1);
+	for (i = 0; !empty && i < bmap->n_ineq; ++i)
+		empty = isl_var_bounds_add(&bounds, bmap->ineq[i], 0);
+	if (!empty)
+		empty = isl_basic_map_plain_has_contradictory_pair(bmap);
+	for (i = 0; !empty && i < bmap->n_eq; ++i)
+		empty = isl_bool_ok(isl_var_bounds_violates(&bounds,
+							bmap->eq[i], 1));
+	for (i = 0; !empty && i < bmap->n_ineq; ++i)
+		empty = isl_bool_ok(isl_var_bounds_violates(&bounds,
+							bmap->ineq[i], 0));
+	if (!empty) {
+		*sample = isl_var_bounds_candidate(ctx, &bounds);
+		contains = isl_basic_map_contains(bmap, *sample);
+		if (contains < 0)
+			empty = isl_bool_error;
+		if (contains != isl_bool_true)
+			*sample = isl_vec_free(*sample);
+	}
+
+	isl_var_bounds_clear(&bounds);
+	return empty;
+}
+
+/* Is "bmap" empty?
+ *
+ * The emptiness check proceeds in stages of increasing cost.
+ * First check if the answer is known without looking
+ * at the constraints in detail.
+ * For integer basic maps, then try to decide emptiness
+ * using bounds on individual variables, which may also
+ * produce an element of "bmap".
+ * Only if this fails, look for an integer point using a tableau.
+ * The number of calls that are decided by each of these
+ * stages is kept track of in the statistics of the isl_ctx.
+ * Any element of "bmap" that is found is cached in bmap->sample.
+ */
 isl_bool isl_basic_map_is_empty(__isl_keep isl_basic_map *bmap)
 {
+	isl_ctx *ctx;
 	struct isl_basic_set *bset = NULL;
 	struct isl_vec *sample = NULL;
 	isl_bool empty, non_empty;
@@ -9410,14 +10899,20 @@ isl_bool isl_basic_map_is_empty(__isl_keep isl_basic_map *bmap)
 	if (!bmap)
 		return isl_bool_error;
 
-	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY))
+	ctx = isl_basic_map_get_ctx(bmap);
+	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY)) {
+		ctx->stats->empty_plain_decided++;
 		return isl_bool_true;
+	}
 
-	if (isl_basic_map_plain_is_universe(bmap))
+	if (isl_basic_map_plain_is_universe(bmap)) {
+		ctx->stats->empty_plain_decided++;
 		return isl_bool_false;
+	}
 
 	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_RATIONAL)) {
 		struct isl_basic_map *copy = isl_basic_map_copy(bmap);
+		ctx->stats->empty_sample_decided++;
 		copy = isl_basic_map_remove_redundancies(copy);
 		empty = isl_basic_map_plain_is_empty(copy);
 		isl_basic_map_free(copy);
@@ -9427,8 +10922,25 @@ isl_bool isl_basic_map_is_empty(__isl_keep isl_basic_map *bmap)
 	non_empty = isl_basic_map_plain_is_non_empty(bmap);
 	if (non_empty < 0)
 		return isl_bool_error;
-	if (non_empty)
+	if (non_empty) {
+		ctx->stats->empty_plain_decided++;
 		return isl_bool_false;
+	}
+	empty = basic_map_is_empty_by_bounds(bmap, &sample);
+	if (empty < 0)
+		return isl_bool_error;
+	if (empty || sample) {
+		if (empty)
+			ctx->stats->empty_bounds_decided++;
+		else
+			ctx->stats->empty_point_decided++;
+		isl_vec_free(bmap->sample);
+		bmap->sample = sample;
+		if (empty)
+			ISL_F_SET(bmap, ISL_BASIC_MAP_EMPTY);
+		return empty;
+	}
+	ctx->stats->empty_sample_decided++;
 	isl_vec_free(bmap->sample);
 	bmap->sample = NULL;
 	bset = isl_basic_map_underlying_set(isl_basic_map_copy(bmap));
@@ -9641,6 +11153,19 @@ __isl_give isl_basic_set *isl_basic_set_expand_divs(
 	return isl_basic_map_expand_divs(bset, div, exp);
 }
 
+/* Is the div at position "pos" in "dst" equal to the div "div" in "src",
+ * given that "dst" has "n_div" divs and that the divs before "div"
+ * in "src" and "dst" are the same?
+ * "v_div" is the position of the first div in both.
+ */
+static int div_matches(__isl_keep isl_basic_map *dst, int pos,
+	__isl_keep isl_basic_map *src, unsigned div, unsigned v_div, int n_div)
+{
+	return isl_seq_eq(dst->div[pos], src->div[div], 1 + 1 + v_div + div) &&
+	    isl_seq_first_non_zero(dst->div[pos] + 1 + 1 + v_div + div,
+				    n_div - div) == -1;
+}
+
 /* Look for a div in dst that corresponds to the div "div" in src.
  * The divs before "div" in src and dst are assumed to be the same.
  * 
@@ -9661,13 +11186,155 @@ static int find_div(__isl_keep isl_basic_map *dst,
 		return -1;
 	isl_assert(dst->ctx, div <= n_div, return -1);
 	for (i = div; i < n_div; ++i)
-		if (isl_seq_eq(dst->div[i], src->div[div], 1+1+v_div+div) &&
-		    isl_seq_first_non_zero(dst->div[i] + 1 + 1 + v_div + div,
-						n_div - div) == -1)
+		if (div_matches(dst, i, src, div, v_div, n_div))
 			return i;
 	return n_div;
 }
 
+/* The minimal number of divs in both the source and the destination
+ * of isl_basic_map_align_divs for the divs of the destination
+ * to be looked up through a hash table rather than
+ * by comparing them to each of the divs of the source in turn.
+ */
+#define ISL_ALIGN_DIVS_HASH_MIN	8
+
+/* Data structure for looking up divs of "dst" in isl_basic_map_align_divs
+ * through a hash table.
+ *
+ * "table" contains the divs of "dst" that were present originally,
+ * hashed on the part of their explicit representation that does not
+ * involve any divs, which is not affected by reordering the divs.
+ * Each entry refers to the original position of the div in "id".
+ * "pos" maps the original position of each div to its current position and
+ * "orig" maps the current position of each div to its original position,
+ * or -1 for divs that were added by isl_basic_map_align_divs.
+ *
+ * "src" and "div" are the div that is being looked up and
+ * "n_div" is the current number of divs in "dst".
+ */
+struct isl_align_divs_data {
+	isl_basic_map *dst;
+	isl_basic_map *src;
+	unsigned v_div;
+	int div;
+	int n_div;
+
+	struct isl_hash_table *table;
+	int *id;
+	int *pos;
+	int *orig;
+};
+
+/* Free the memory allocated by align_divs_data_init.
+ */
+static void align_divs_data_clear(isl_ctx *ctx,
+	struct isl_align_divs_data *data)
+{
+	isl_hash_table_free(ctx, data->table);
+	free(data->id);
+	free(data->pos);
+	free(data->orig);
+}
+
+/* isl_hash_table_find callback that never reports a match,
+ * used to insert each div into the hash table, even if
+ * it has the same explicit representation as a previous div.
+ */
+static isl_bool never_equal(const void *entry, const void *val)
+{
+	return isl_bool_false;
+}
+
+/* Initialize "data" for looking up the "n_div" divs of "dst",
+ * which may be extended with up to "extra" additional divs,
+ * with "v_div" the position of the first div.
+ */
+static isl_stat align_divs_data_init(isl_ctx *ctx,
+	struct isl_align_divs_data *data, __isl_keep isl_basic_map *dst,
+	__isl_keep isl_basic_map *src, unsigned v_div, int n_div, int extra)
+{
+	int i;
+
+	data->src = src;
+	data->v_div = v_div;
+	data->table = isl_hash_table_alloc(ctx, n_div);
+	data->id = isl_alloc_array(ctx, int, n_div);
+	data->pos = isl_alloc_array(ctx, int, n_div);
+	data->orig = isl_alloc_array(ctx, int, n_div + extra);
+	if (!data->table || !data->id || !data->pos || !data->orig)
+		return isl_stat_error;
+
+	for (i = 0; i < n_div; ++i) {
+		struct isl_hash_table_entry *entry;
+		uint32_t hash;
+
+		data->id[i] = data->pos[i] = data->orig[i] = i;
+		hash = isl_seq_get_hash(dst->div[i], 1 + 1 + v_div);
+		entry = isl_hash_table_find(ctx, data->table, hash,
+					    &never_equal, NULL, 1);
+		if (!entry)
+			return isl_stat_error;
+		entry->data = &data->id[i];
+	}
+
+	return isl_stat_ok;
+}
+
+/* isl_hash_table_find callback that checks whether the div
+ * at original position "entry" in data->dst is still available,
+ * i.e., has not been aligned to an earlier div of data->src,
+ * and whether it is equal to div data->div in data->src.
+ */
+static isl_bool has_div(const void *entry, const void *val)
+{
+	const int *id = entry;
+	const struct isl_align_divs_data *data = val;
+	int pos = data->pos[*id];
+
+	if (pos < data->div)
+		return isl_bool_false;
+	return isl_bool_ok(div_matches(data->dst, pos, data->src, data->div,
+					data->v_div, data->n_div));
+}
+
+/* Look for a div in data->dst that corresponds to the div "div"
+ * in data->src, using the hash table in "data".
+ * The divs before "div" in src and dst are assumed to be the same.
+ *
+ * Return the position of the corresponding div in dst
+ * if there is one.  Otherwise, return a position beyond the integer divisions.
+ */
+static int find_div_hashed(isl_ctx *ctx, struct isl_align_divs_data *data,
+	int div)
+{
+	struct isl_hash_table_entry *entry;
+	uint32_t hash;
+
+	data->div = div;
+	hash = isl_seq_get_hash(data->src->div[div], 1 + 1 + data->v_div);
+	entry = isl_hash_table_find(ctx, data->table, hash, &has_div, data, 0);
+	if (entry == isl_hash_table_entry_none)
+		return data->n_div;
+	return data->pos[*(int *) entry->data];
+}
+
+/* Record in "data" that the divs at positions "a" and "b"
+ * of the destination have been swapped.
+ */
+static void align_divs_data_swap(struct isl_align_divs_data *data,
+	int a, int b)
+{
+	int t;
+
+	t = data->orig[a];
+	data->orig[a] = data->orig[b];
+	data->orig[b] = t;
+	if (data->orig[a] >= 0)
+		data->pos[data->orig[a]] = a;
+	if (data->orig[b] >= 0)
+		data->pos[data->orig[b]] = b;
+}
+
 /* Align the divs of "dst" to those of "src", adding divs from "src"
  * if needed.  That is, make sure that the first src->n_div divs
  * of the result are equal to those of src.
@@ -9684,6 +11351,10 @@ static int find_div(__isl_keep isl_basic_map *dst,
  *
  * The result is not finalized as by design it will have redundant
  * divs if any divs from "src" were copied.
+ *
+ * If both "src" and "dst" have many divs, then the divs of "dst"
+ * are looked up through a hash table instead of comparing each
+ * of the divs of "src" to all remaining divs of "dst".
  */
 __isl_give isl_basic_map *isl_basic_map_align_divs(
 	__isl_take isl_basic_map *dst, __isl_keep isl_basic_map *src)
@@ -9691,8 +11362,11 @@ __isl_give isl_basic_map *isl_basic_map_align_divs(
 	int i;
 	isl_bool known;
 	int extended;
+	int hashed;
 	isl_size v_div;
 	isl_size dst_n_div;
+	isl_ctx *ctx;
+	struct isl_align_divs_data data = { NULL };
 
 	if (!dst || !src)
 		return isl_basic_map_free(dst);
@@ -9715,37 +11389,62 @@ __isl_give isl_basic_map *isl_basic_map_align_divs(
 	extended = 0;
 	dst_n_div = isl_basic_map_dim(dst, isl_dim_div);
 	if (dst_n_div < 0)
-		dst = isl_basic_map_free(dst);
+		return isl_basic_map_free(dst);
+	ctx = isl_basic_map_get_ctx(dst);
+	hashed = src->n_div >= ISL_ALIGN_DIVS_HASH_MIN &&
+		 dst_n_div >= ISL_ALIGN_DIVS_HASH_MIN;
+	if (hashed && align_divs_data_init(ctx, &data, dst, src, v_div,
+					dst_n_div, src->n_div) < 0)
+		goto error;
 	for (i = 0; i < src->n_div; ++i) {
-		int j = find_div(dst, src, i);
+		int j;
+
+		if (hashed) {
+			data.dst = dst;
+			data.n_div = dst_n_div;
+			j = find_div_hashed(ctx, &data, i);
+		} else {
+			j = find_div(dst, src, i);
+		}
 		if (j < 0)
-			dst = isl_basic_map_free(dst);
+			goto error;
 		if (j == dst_n_div) {
 			if (!extended) {
 				int extra = src->n_div - i;
 				dst = isl_basic_map_cow(dst);
-				if (!dst)
-					return isl_basic_map_free(dst);
 				dst = isl_basic_map_extend(dst,
 						extra, 0, 2 * extra);
+				if (!dst)
+					goto error;
 				extended = 1;
 			}
 			j = isl_basic_map_alloc_div(dst);
 			if (j < 0)
-				return isl_basic_map_free(dst);
+				goto error;
 			isl_seq_cpy(dst->div[j], src->div[i], 1+1+v_div+i);
 			isl_seq_clr(dst->div[j]+1+1+v_div+i, dst->n_div - i);
+			if (hashed)
+				data.orig[j] = -1;
 			dst_n_div++;
 			dst = isl_basic_map_add_div_constraints(dst, j);
 			if (!dst)
-				return isl_basic_map_free(dst);
+				goto error;
 		}
-		if (j != i)
+		if (j != i) {
 			dst = isl_basic_map_swap_div(dst, i, j);
+			if (hashed)
+				align_divs_data_swap(&data, i, j);
+		}
 		if (!dst)
-			return isl_basic_map_free(dst);
+			goto error;
 	}
+	if (hashed)
+		align_divs_data_clear(ctx, &data);
 	return isl_basic_map_order_divs(dst);
+error:
+	if (hashed)
+		align_divs_data_clear(ctx, &data);
+	return isl_basic_map_free(dst);
 }
 
 __isl_give isl_map *isl_map_align_divs_internal(__isl_take isl_map *map)
@@ -10347,23 +12046,17 @@ __isl_give isl_basic_map *isl_basic_map_normalize(
 	bmap = isl_basic_map_sort_constraints(bmap);
 	return bmap;
 }
-int isl_basic_map_plain_cmp(__isl_keep isl_basic_map *bmap1,
-	__isl_keep isl_basic_map *bmap2)
+/* Compare "bmap1" and "bmap2", which are known to live in the same space
+ * of dimension "dim", in the same way as isl_basic_map_plain_cmp.
+ */
+static int basic_map_plain_cmp_same_space(__isl_keep isl_basic_map *bmap1,
+	__isl_keep isl_basic_map *bmap2, unsigned dim)
 {
 	int i, cmp;
-	isl_size total;
-	isl_space *space1, *space2;
-
-	if (!bmap1 || !bmap2)
-		return -1;
+	unsigned total;
 
 	if (bmap1 == bmap2)
 		return 0;
-	space1 = isl_basic_map_peek_space(bmap1);
-	space2 = isl_basic_map_peek_space(bmap2);
-	cmp = isl_space_cmp(space1, space2);
-	if (cmp)
-		return cmp;
 	if (ISL_F_ISSET(bmap1, ISL_BASIC_MAP_RATIONAL) !=
 	    ISL_F_ISSET(bmap2, ISL_BASIC_MAP_RATIONAL))
 		return ISL_F_ISSET(bmap1, ISL_BASIC_MAP_RATIONAL) ? -1 : 1;
@@ -10380,9 +12073,7 @@ int isl_basic_map_plain_cmp(__isl_keep isl_basic_map *bmap1,
 		return bmap1->n_ineq - bmap2->n_ineq;
 	if (bmap1->n_div != bmap2->n_div)
 		return bmap1->n_div - bmap2->n_div;
-	total = isl_basic_map_dim(bmap1, isl_dim_all);
-	if (total < 0)
-		return -1;
+	total = dim + bmap1->n_div;
 	for (i = 0; i < bmap1->n_eq; ++i) {
 		cmp = isl_seq_cmp(bmap1->eq[i], bmap2->eq[i], 1+total);
 		if (cmp)
@@ -10413,6 +12104,29 @@ int isl_basic_map_plain_cmp(__isl_keep isl_basic_map *bmap1,
 	return 0;
 }
 
+int isl_basic_map_plain_cmp(__isl_keep isl_basic_map *bmap1,
+	__isl_keep isl_basic_map *bmap2)
+{
+	int cmp;
+	isl_size dim;
+	isl_space *space1, *space2;
+
+	if (!bmap1 || !bmap2)
+		return -1;
+
+	if (bmap1 == bmap2)
+		return 0;
+	space1 = isl_basic_map_peek_space(bmap1);
+	space2 = isl_basic_map_peek_space(bmap2);
+	cmp = isl_space_cmp(space1, space2);
+	if (cmp)
+		return cmp;
+	dim = isl_space_dim(space1, isl_dim_all);
+	if (dim < 0)
+		return -1;
+	return basic_map_plain_cmp_same_space(bmap1, bmap2, dim);
+}
+
 int isl_basic_set_plain_cmp(__isl_keep isl_basic_set *bset1,
 	__isl_keep isl_basic_set *bset2)
 {
@@ -10452,37 +12166,148 @@ isl_bool isl_basic_set_plain_is_equal(__isl_keep isl_basic_set *bset1,
 					    bset_to_bmap(bset2));
 }
 
-static int qsort_bmap_cmp(const void *p1, const void *p2)
+/* Compare the basic maps pointed to by "p1" and "p2",
+ * which are basic maps of the same map, such that they live
+ * in the same space, the dimension of which is pointed to by "user".
+ */
+static int sort_bmap_cmp(const void *p1, const void *p2, void *user)
 {
 	isl_basic_map *bmap1 = *(isl_basic_map **) p1;
 	isl_basic_map *bmap2 = *(isl_basic_map **) p2;
+	unsigned *dim = user;
+
+	return basic_map_plain_cmp_same_space(bmap1, bmap2, *dim);
+}
+
+/* Compute a hash value for "bmap" based on its constraints and
+ * its known integer divisions, as they appear in "bmap".
+ * That is, "bmap" is not normalized first.
+ * Basic maps that are considered equal by isl_basic_map_plain_cmp
+ * have the same hash value, unless they are marked empty.
+ */
+static uint32_t basic_map_plain_hash(__isl_keep isl_basic_map *bmap)
+{
+	int i;
+	uint32_t hash = isl_hash_init();
+	isl_size total;
+
+	total = isl_basic_map_dim(bmap, isl_dim_all);
+	if (total < 0)
+		return 0;
+	isl_hash_byte(hash, bmap->n_eq & 0xFF);
+	for (i = 0; i < bmap->n_eq; ++i) {
+		uint32_t c_hash;
+		c_hash = isl_seq_get_hash(bmap->eq[i], 1 + total);
+		isl_hash_hash(hash, c_hash);
+	}
+	isl_hash_byte(hash, bmap->n_ineq & 0xFF);
+	for (i = 0; i < bmap->n_ineq; ++i) {
+		uint32_t c_hash;
+		c_hash = isl_seq_get_hash(bmap->ineq[i], 1 + total);
+		isl_hash_hash(hash, c_hash);
+	}
+	isl_hash_byte(hash, bmap->n_div & 0xFF);
+	for (i = 0; i < bmap->n_div; ++i) {
+		uint32_t c_hash;
+		if (isl_int_is_zero(bmap->div[i][0]))
+			continue;
+		isl_hash_byte(hash, i & 0xFF);
+		c_hash = isl_seq_get_hash(bmap->div[i], 1 + 1 + total);
+		isl_hash_hash(hash, c_hash);
+	}
+	return hash;
+}
+
+/* Compute the plain hash values of the basic maps of "map".
+ */
+static uint32_t *map_plain_hash(__isl_keep isl_map *map)
+{
+	int i;
+	uint32_t *hash;
 
-	return isl_basic_map_plain_cmp(bmap1, bmap2);
+	hash = isl_alloc_array(map->ctx, uint32_t, map->n);
+	if (map->n && !hash)
+		return NULL;
+	for (i = 0; i < map->n; ++i)
+		hash[i] = basic_map_plain_hash(map->p[i]);
+	return hash;
+}
+
+/* Return the hash values of the basic maps of the normalized map "map",
+ * computing them first if they are not available in the cache.
+ * The result is owned by "map" and remains valid as long as
+ * "map" is not modified.
+ */
+static uint32_t *map_get_cached_hash(__isl_keep isl_map *map)
+{
+	if (!map)
+		return NULL;
+	if (map->cached_hash && map->n <= map->n_cached_hash)
+		return map->cached_hash;
+	free(map->cached_hash);
+	map->cached_hash = map_plain_hash(map);
+	map->n_cached_hash = map->cached_hash ? map->n : 0;
+	if (map->n && !map->cached_hash)
+		return NULL;
+	return map->cached_hash;
 }
 
 /* Sort the basic maps of "map" and remove duplicate basic maps.
+ * If "hash" is not NULL, then *hash is set to the plain hash values
+ * of the remaining basic maps.
  *
- * While removing basic maps, we make sure that the basic maps remain
- * sorted because isl_map_normalize expects the basic maps of the result
- * to be sorted.
- */
-static __isl_give isl_map *sort_and_remove_duplicates(__isl_take isl_map *map)
-{
-	int i, j;
+ * The basic maps are sorted in the same order as isl_basic_map_plain_cmp,
+ * but since they all live in the same space, their spaces
+ * are not compared and the dimension of the space is only computed once.
+ * After sorting, duplicate basic maps are adjacent.
+ * Each basic map is only compared in full to the last basic map
+ * that has been kept if their hash values are the same,
+ * unless one of them is marked empty, in which case
+ * the hash values need not be the same.
+ * The remaining basic maps are moved to the front in a single pass,
+ * such that they remain sorted because isl_map_normalize
+ * expects the basic maps of the result to be sorted.
+ */
+static __isl_give isl_map *sort_and_remove_duplicates(__isl_take isl_map *map,
+	uint32_t **hash)
+{
+	int i, n;
+	uint32_t *h;
+	isl_size total;
+	unsigned dim;
 
 	map = isl_map_remove_empty_parts(map);
-	if (!map)
-		return NULL;
-	qsort(map->p, map->n, sizeof(struct isl_basic_map *), qsort_bmap_cmp);
-	for (i = map->n - 1; i >= 1; --i) {
-		if (!isl_basic_map_plain_is_equal(map->p[i - 1], map->p[i]))
+	total = isl_space_dim(isl_map_peek_space(map), isl_dim_all);
+	if (total < 0)
+		return isl_map_free(map);
+	dim = total;
+	if (isl_sort(map->p, map->n, sizeof(struct isl_basic_map *),
+			&sort_bmap_cmp, &dim) < 0)
+		return isl_map_free(map);
+	h = map_plain_hash(map);
+	if (map->n && !h)
+		return isl_map_free(map);
+	n = map->n ? 1 : 0;
+	for (i = 1; i < map->n; ++i) {
+		isl_basic_map *prev = map->p[n - 1];
+
+		if ((h[i] == h[n - 1] ||
+		     ISL_F_ISSET(prev, ISL_BASIC_MAP_EMPTY) ||
+		     ISL_F_ISSET(map->p[i], ISL_BASIC_MAP_EMPTY)) &&
+		    isl_basic_map_plain_is_equal(prev, map->p[i])) {
+			isl_basic_map_free(map->p[i]);
 			continue;
-		isl_basic_map_free(map->p[i-1]);
-		for (j = i; j < map->n; ++j)
-			map->p[j - 1] = map->p[j];
-		map->n--;
+		}
+		map->p[n] = map->p[i];
+		h[n] = h[i];
+		n++;
 	}
+	map->n = n;
 
+	if (hash)
+		*hash = h;
+	else
+		free(h);
 	return map;
 }
 
@@ -10516,7 +12341,7 @@ __isl_give isl_map *isl_map_remove_obvious_duplicates(__isl_take isl_map *map)
 		map->p[i] = bmap;
 	}
 
-	map = sort_and_remove_duplicates(map);
+	map = sort_and_remove_duplicates(map, NULL);
 	return map;
 }
 
@@ -10528,6 +12353,7 @@ __isl_give isl_map *isl_map_normalize(__isl_take isl_map *map)
 {
 	int i;
 	struct isl_basic_map *bmap;
+	uint32_t *hash;
 
 	if (!map)
 		return NULL;
@@ -10541,9 +12367,13 @@ __isl_give isl_map *isl_map_normalize(__isl_take isl_map *map)
 		map->p[i] = bmap;
 	}
 
-	map = sort_and_remove_duplicates(map);
-	if (map)
-		ISL_F_SET(map, ISL_MAP_NORMALIZED);
+	map = sort_and_remove_duplicates(map, &hash);
+	if (!map)
+		return NULL;
+	ISL_F_SET(map, ISL_MAP_NORMALIZED);
+	free(map->cached_hash);
+	map->cached_hash = hash;
+	map->n_cached_hash = map->n;
 	return map;
 error:
 	isl_map_free(map);
@@ -10560,6 +12390,7 @@ isl_bool isl_map_plain_is_equal(__isl_keep isl_map *map1,
 {
 	int i;
 	isl_bool equal;
+	uint32_t *hash1 = NULL, *hash2 = NULL;
 
 	if (!map1 || !map2)
 		return isl_bool_error;
@@ -10577,7 +12408,19 @@ isl_bool isl_map_plain_is_equal(__isl_keep isl_map *map1,
 	if (!map1 || !map2)
 		goto error;
 	equal = map1->n == map2->n;
+	if (equal) {
+		hash1 = map_get_cached_hash(map1);
+		hash2 = map_get_cached_hash(map2);
+		if (map1->n && (!hash1 || !hash2))
+			goto error;
+	}
 	for (i = 0; equal && i < map1->n; ++i) {
+		if (hash1[i] != hash2[i] &&
+		    !ISL_F_ISSET(map1->p[i], ISL_BASIC_MAP_EMPTY) &&
+		    !ISL_F_ISSET(map2->p[i], ISL_BASIC_MAP_EMPTY)) {
+			equal = isl_bool_false;
+			break;
+		}
 		equal = isl_basic_map_plain_is_equal(map1->p[i], map2->p[i]);
 		if (equal < 0)
 			goto error;
@@ -11202,38 +13045,13 @@ __isl_give isl_map *isl_map_flat_range_product(__isl_take isl_map *map1,
 
 uint32_t isl_basic_map_get_hash(__isl_keep isl_basic_map *bmap)
 {
-	int i;
-	uint32_t hash = isl_hash_init();
-	isl_size total;
+	uint32_t hash;
 
 	if (!bmap)
 		return 0;
 	bmap = isl_basic_map_copy(bmap);
 	bmap = isl_basic_map_normalize(bmap);
-	total = isl_basic_map_dim(bmap, isl_dim_all);
-	if (total < 0)
-		return 0;
-	isl_hash_byte(hash, bmap->n_eq & 0xFF);
-	for (i = 0; i < bmap->n_eq; ++i) {
-		uint32_t c_hash;
-		c_hash = isl_seq_get_hash(bmap->eq[i], 1 + total);
-		isl_hash_hash(hash, c_hash);
-	}
-	isl_hash_byte(hash, bmap->n_ineq & 0xFF);
-	for (i = 0; i < bmap->n_ineq; ++i) {
-		uint32_t c_hash;
-		c_hash = isl_seq_get_hash(bmap->ineq[i], 1 + total);
-		isl_hash_hash(hash, c_hash);
-	}
-	isl_hash_byte(hash, bmap->n_div & 0xFF);
-	for (i = 0; i < bmap->n_div; ++i) {
-		uint32_t c_hash;
-		if (isl_int_is_zero(bmap->div[i][0]))
-			continue;
-		isl_hash_byte(hash, i & 0xFF);
-		c_hash = isl_seq_get_hash(bmap->div[i], 1 + 1 + total);
-		isl_hash_hash(hash, c_hash);
-	}
+	hash = basic_map_plain_hash(bmap);
 	isl_basic_map_free(bmap);
 	return hash;
 }
@@ -11243,25 +13061,30 @@ uint32_t isl_basic_set_get_hash(__isl_keep isl_basic_set *bset)
 	return isl_basic_map_get_hash(bset_to_bmap(bset));
 }
 
+/* Compute a hash value for "map".
+ * The hash values of the basic maps of the normalized map
+ * are kept in the cache of that map.
+ */
 uint32_t isl_map_get_hash(__isl_keep isl_map *map)
 {
 	int i;
 	uint32_t hash;
+	uint32_t *bmap_hash;
 
 	if (!map)
 		return 0;
 	map = isl_map_copy(map);
 	map = isl_map_normalize(map);
-	if (!map)
+	bmap_hash = map_get_cached_hash(map);
+	if (!bmap_hash) {
+		isl_map_free(map);
 		return 0;
+	}
 
 	hash = isl_hash_init();
-	for (i = 0; i < map->n; ++i) {
-		uint32_t bmap_hash;
-		bmap_hash = isl_basic_map_get_hash(map->p[i]);
-		isl_hash_hash(hash, bmap_hash);
-	}
-		
+	for (i = 0; i < map->n; ++i)
+		isl_hash_hash(hash, bmap_hash[i]);
+
 	isl_map_free(map);
 
 	return hash;
@@ -11314,6 +13137,28 @@ isl_stat isl_set_foreach_basic_set(__isl_keep isl_set *set,
 	return isl_stat_ok;
 }
 
+/* Does "test" succeed on every basic map in "map"?
+ */
+isl_bool isl_map_every_basic_map(__isl_keep isl_map *map,
+	isl_bool (*test)(__isl_keep isl_basic_map *bmap, void *user),
+	void *user)
+{
+	int i;
+
+	if (!map)
+		return isl_bool_error;
+
+	for (i = 0; i < map->n; ++i) {
+		isl_bool r;
+
+		r = test(map->p[i], user);
+		if (r < 0 || !r)
+			return r;
+	}
+
+	return isl_bool_true;
+}
+
 /* Does "test" succeed on every basic set in "set"?
  */
 isl_bool isl_set_every_basic_set(__isl_keep isl_set *set,
@@ -11450,6 +13295,122 @@ int isl_set_size(__isl_keep isl_set *set)
 	return size;
 }
 
+/* Return the number of machine words needed to represent
+ * the largest (absolute value of a) coefficient in the constraints
+ * and integer division expressions of "bmap",
+ * which is assumed to have "total" variables.
+ */
+static int basic_map_coefficient_words(__isl_keep isl_basic_map *bmap,
+	unsigned total)
+{
+	int i;
+	int words = 1;
+	double d;
+	isl_int max, t;
+
+	isl_int_init(max);
+	isl_int_init(t);
+	isl_int_set_si(max, 0);
+	for (i = 0; i < bmap->n_eq; ++i) {
+		isl_seq_abs_max(bmap->eq[i], 1 + total, &t);
+		if (isl_int_gt(t, max))
+			isl_int_set(max, t);
+	}
+	for (i = 0; i < bmap->n_ineq; ++i) {
+		isl_seq_abs_max(bmap->ineq[i], 1 + total, &t);
+		if (isl_int_gt(t, max))
+			isl_int_set(max, t);
+	}
+	for (i = 0; i < bmap->n_div; ++i) {
+		isl_seq_abs_max(bmap->div[i], 2 + total, &t);
+		if (isl_int_gt(t, max))
+			isl_int_set(max, t);
+	}
+	if (!isl_int_fits_slong(max)) {
+		d = isl_int_get_d(max);
+		while (d >= 9223372036854775808.0) {
+			d /= 18446744073709551616.0;
+			++words;
+		}
+	}
+	isl_int_clear(max);
+	isl_int_clear(t);
+
+	return words;
+}
+
+/* Return a cheap estimate of the cost of operating on "bmap",
+ * based only on its shape, or a negative value on error.
+ *
+ * The estimate is the size of the constraint matrix (including
+ * the integer division expressions), measured in machine words,
+ * multiplied by one more than the number of integer divisions,
+ * since each of them may need to be eliminated by some operations.
+ * The estimate is doubled if "bmap" is not known to be free
+ * of redundant constraints and implicit equalities,
+ * since many operations start by simplifying their inputs.
+ */
+double isl_basic_map_estimate_cost(__isl_keep isl_basic_map *bmap)
+{
+	isl_size total;
+	double cost;
+
+	total = isl_basic_map_dim(bmap, isl_dim_all);
+	if (total < 0)
+		return -1;
+
+	cost = bmap->n_eq + bmap->n_ineq + bmap->n_div;
+	cost *= 1 + total;
+	cost *= basic_map_coefficient_words(bmap, total);
+	cost *= 1 + bmap->n_div;
+	if (!ISL_F_ISSET(bmap, ISL_BASIC_MAP_NO_REDUNDANT) ||
+	    !ISL_F_ISSET(bmap, ISL_BASIC_MAP_NO_IMPLICIT))
+		cost *= 2;
+
+	return cost;
+}
+
+/* Return a cheap estimate of the cost of operating on "bset".
+ */
+double isl_basic_set_estimate_cost(__isl_keep isl_basic_set *bset)
+{
+	return isl_basic_map_estimate_cost(bset_to_bmap(bset));
+}
+
+/* Return a cheap estimate of the cost of operating on "map",
+ * based only on its shape, or a negative value on error.
+ *
+ * The estimate is the sum of the estimates of the basic maps,
+ * multiplied by the number of basic maps since many operations,
+ * including coalescing and subtraction, consider pairs of basic maps.
+ */
+double isl_map_estimate_cost(__isl_keep isl_map *map)
+{
+	int i;
+	double cost = 0;
+
+	if (!map)
+		return -1;
+
+	for (i = 0; i < map->n; ++i) {
+		double c;
+
+		c = isl_basic_map_estimate_cost(map->p[i]);
+		if (c < 0)
+			return -1;
+		cost += c;
+	}
+
+	return cost * map->n;
+}
+
+/* Return a cheap estimate of the cost of operating on "set".
+ */
+double isl_set_estimate_cost(__isl_keep isl_set *set)
+{
+	return isl_map_estimate_cost(set_to_map(set));
+}
+
 /* Check if there is any lower bound (if lower == 0) and/or upper
  * bound (if upper == 0) on the specified dim.
  */
@@ -12436,6 +14397,7 @@ __isl_give isl_basic_map *isl_basic_map_realign(__isl_take isl_basic_map *bmap,
 	ISL_FL_CLR(flags, ISL_BASIC_MAP_FINAL);
 	ISL_FL_CLR(flags, ISL_BASIC_MAP_SORTED);
 	ISL_FL_CLR(flags, ISL_BASIC_MAP_NORMALIZED_DIVS);
+	ISL_FL_CLR(flags, ISL_BASIC_MAP_SIMPLIFIED);
 	res = isl_basic_map_alloc_space(space, n_div, bmap->n_eq, bmap->n_ineq);
 	res = isl_basic_map_add_constraints_dim_map(res, bmap, dim_map);
 	if (res)
@@ -12451,13 +14413,17 @@ error:
 }
 
 /* Reorder the dimensions of "map" according to given reordering.
+ *
+ * Any cached simple hulls are reordered in the same way.
  */
 __isl_give isl_map *isl_map_realign(__isl_take isl_map *map,
 	__isl_take isl_reordering *r)
 {
 	int i;
 	struct isl_dim_map *dim_map;
+	isl_basic_map *hull[2];
 
+	get_cached_simple_hulls(map, hull);
 	map = isl_map_cow(map);
 	dim_map = isl_dim_map_from_reordering(r);
 	if (!map || !r || !dim_map)
@@ -12475,14 +14441,26 @@ __isl_give isl_map *isl_map_realign(__isl_take isl_map *map,
 		if (!map->p[i])
 			goto error;
 	}
+	for (i = 0; i < 2; ++i) {
+		struct isl_dim_map *dim_map_i;
+		isl_space *space;
+
+		if (!hull[i])
+			continue;
+		dim_map_i = isl_dim_map_extend(dim_map, hull[i]);
+		space = isl_reordering_get_space(r);
+		hull[i] = isl_basic_map_realign(hull[i], space, dim_map_i);
+	}
 
 	map = isl_map_reset_space(map, isl_reordering_get_space(r));
 	map = isl_map_unmark_normalized(map);
+	map = restore_cached_simple_hulls(map, hull);
 
 	isl_reordering_free(r);
 	isl_dim_map_free(dim_map);
 	return map;
 error:
+	free_cached_simple_hulls(hull);
 	isl_dim_map_free(dim_map);
 	isl_map_free(map);
 	isl_reordering_free(r);
@@ -13061,6 +15039,95 @@ error:
 	return NULL;
 }
 
+/* Set "v" to "x".
+ * isl_int_set_si only accepts a long, which may be smaller than int64_t,
+ * so values that do not fit are constructed from two 32-bit halves.
+ */
+static void int_set_int64(isl_int v, int64_t x)
+{
+	uint64_t u;
+
+	if (x >= LONG_MIN && x <= LONG_MAX) {
+		isl_int_set_si(v, (long) x);
+		return;
+	}
+	u = x < 0 ? -(uint64_t) x : (uint64_t) x;
+	isl_int_set_ui(v, (unsigned long) (u >> 32));
+	isl_int_mul_2exp(v, v, 32);
+	isl_int_add_ui(v, v, (unsigned long) (u & 0xffffffffUL));
+	if (x < 0)
+		isl_int_neg(v, v);
+}
+
+/* Copy the "n" rows of "src", each consisting of "len" coefficients,
+ * to the rows "dst" starting at position "pos".
+ */
+static void copy_int64_rows(isl_int **dst, int pos, const int64_t *src,
+	unsigned n, unsigned len)
+{
+	int i, j;
+
+	for (i = 0; i < n; ++i)
+		for (j = 0; j < len; ++j)
+			int_set_int64(dst[pos + i][j], src[i * len + j]);
+}
+
+/* Construct a basic map in space "space" from "n_eq" equalities and
+ * "n_ineq" inequalities, stored in row-major order in "eq" and "ineq".
+ * Each row consists of 1 + d + "n_exist" coefficients,
+ * with d the total number of variables in "space",
+ * in the order in which isl stores them internally, i.e.,
+ * the constant term, the parameters, the input variables,
+ * the output variables and finally "n_exist" existentially
+ * quantified variables.
+ *
+ * Unlike isl_basic_map_from_constraint_matrices, the input rows
+ * are copied directly into the result, without going through
+ * an intermediate isl_mat, and the result is only simplified
+ * once all constraints have been added.
+ */
+__isl_give isl_basic_map *isl_basic_map_from_int64_constraints(
+	__isl_take isl_space *space, unsigned n_exist,
+	unsigned n_eq, const int64_t *eq, unsigned n_ineq, const int64_t *ineq)
+{
+	isl_basic_map *bmap;
+	isl_size dim;
+	unsigned len;
+	int i, k;
+
+	dim = isl_space_dim(space, isl_dim_all);
+	if (dim < 0)
+		goto error;
+	if ((n_eq && !eq) || (n_ineq && !ineq))
+		isl_die(isl_space_get_ctx(space), isl_error_invalid,
+			"missing constraint coefficients", goto error);
+
+	len = 1 + dim + n_exist;
+	bmap = isl_basic_map_alloc_space(space, n_exist, n_eq, n_ineq);
+	if (!bmap)
+		return NULL;
+	for (i = 0; i < n_exist; ++i) {
+		k = isl_basic_map_alloc_div(bmap);
+		if (k < 0)
+			return isl_basic_map_free(bmap);
+		isl_int_set_si(bmap->div[k][0], 0);
+	}
+	for (i = 0; i < n_eq; ++i)
+		if (isl_basic_map_alloc_equality(bmap) < 0)
+			return isl_basic_map_free(bmap);
+	for (i = 0; i < n_ineq; ++i)
+		if (isl_basic_map_alloc_inequality(bmap) < 0)
+			return isl_basic_map_free(bmap);
+	copy_int64_rows(bmap->eq, 0, eq, n_eq, len);
+	copy_int64_rows(bmap->ineq, 0, ineq, n_ineq, len);
+
+	bmap = isl_basic_map_simplify(bmap);
+	return isl_basic_map_finalize(bmap);
+error:
+	isl_space_free(space);
+	return NULL;
+}
+
 __isl_give isl_mat *isl_basic_set_equalities_matrix(
 	__isl_keep isl_basic_set *bset, enum isl_dim_type c1,
 	enum isl_dim_type c2, enum isl_dim_type c3, enum isl_dim_type c4)
@@ -13088,6 +15155,17 @@ __isl_give isl_basic_set *isl_basic_set_from_constraint_matrices(
 	return bset_from_bmap(bmap);
 }
 
+__isl_give isl_basic_set *isl_basic_set_from_int64_constraints(
+	__isl_take isl_space *space, unsigned n_exist,
+	unsigned n_eq, const int64_t *eq, unsigned n_ineq, const int64_t *ineq)
+{
+	isl_basic_map *bmap;
+
+	bmap = isl_basic_map_from_int64_constraints(space, n_exist,
+						n_eq, eq, n_ineq, ineq);
+	return bset_from_bmap(bmap);
+}
+
 isl_bool isl_basic_map_can_zip(__isl_keep isl_basic_map *bmap)
 {
 	if (!bmap)
@@ -13772,6 +15850,106 @@ static __isl_give isl_space *isl_space_set(__isl_take isl_space *space,
 	return space;
 }
 
+/* Is each affine expression in "ma" equal to a single domain variable,
+ * with each domain variable appearing at most once?
+ * That is, is "ma" a permutation, a projection or an identity
+ * of the domain variables?
+ * If so, then store the position of the domain variable
+ * corresponding to output i in pos[i].
+ * The array "pos" is assumed to have room for the number of outputs of "ma".
+ */
+static isl_bool isl_multi_aff_is_var_selection(__isl_keep isl_multi_aff *ma,
+	int *pos)
+{
+	int i;
+	isl_ctx *ctx;
+	isl_size n_param, n_in;
+	int *used;
+	isl_bool selection = isl_bool_true;
+
+	n_param = isl_multi_aff_dim(ma, isl_dim_param);
+	n_in = isl_multi_aff_dim(ma, isl_dim_in);
+	if (n_param < 0 || n_in < 0)
+		return isl_bool_error;
+
+	ctx = isl_multi_aff_get_ctx(ma);
+	used = isl_calloc_array(ctx, int, n_in);
+	if (n_in && !used)
+		return isl_bool_error;
+	for (i = 0; selection && i < ma->n; ++i) {
+		isl_aff *aff = ma->u.p[i];
+		int len = aff->v->size - 1;
+		int first, last;
+
+		first = isl_seq_first_non_zero(aff->v->el + 1, len);
+		last = isl_seq_last_non_zero(aff->v->el + 1, len);
+		if (!isl_int_is_one(aff->v->el[0]) || first != last ||
+		    first < 1 + n_param || first >= 1 + n_param + n_in ||
+		    !isl_int_is_one(aff->v->el[1 + first])) {
+			selection = isl_bool_false;
+			break;
+		}
+		pos[i] = first - (1 + n_param);
+		if (used[pos[i]])
+			selection = isl_bool_false;
+		used[pos[i]] = 1;
+	}
+	free(used);
+
+	return selection;
+}
+
+/* Compute the preimage of the domain or range (depending on "type")
+ * of "bmap" under the function represented by "ma",
+ * where output i of "ma" is equal to the domain variable at position pos[i]
+ * and where no domain variable appears more than once.
+ * "space" is the space of the result.
+ *
+ * The preimage is then simply a reordering of the variables of "bmap",
+ * with the domain variables of "ma" that do not appear
+ * in any of its outputs remaining unconstrained.
+ */
+static __isl_give isl_basic_map *isl_basic_map_preimage_var_selection(
+	__isl_take isl_basic_map *bmap, enum isl_dim_type type,
+	__isl_take isl_space *space, int *pos)
+{
+	int i;
+	isl_space *bmap_space;
+	isl_dim_map *dim_map;
+	isl_size n_param, n_in, n, total, n_div;
+	unsigned dst_offset;
+
+	n_param = isl_basic_map_dim(bmap, isl_dim_param);
+	n = isl_basic_map_dim(bmap, type);
+	n_in = isl_space_dim(space, isl_dim_in);
+	total = isl_space_dim(space, isl_dim_all);
+	n_div = isl_basic_map_dim(bmap, isl_dim_div);
+	if (n_param < 0 || n < 0 || n_in < 0 || total < 0 || n_div < 0)
+		goto error;
+
+	bmap_space = isl_basic_map_peek_space(bmap);
+	dim_map = isl_dim_map_alloc(isl_basic_map_get_ctx(bmap),
+					total + n_div);
+	isl_dim_map_dim(dim_map, bmap_space, isl_dim_param, 0);
+	if (type == isl_dim_in) {
+		isl_dim_map_dim(dim_map, bmap_space, isl_dim_out,
+				n_param + n_in);
+		dst_offset = n_param;
+	} else {
+		isl_dim_map_dim(dim_map, bmap_space, isl_dim_in, n_param);
+		dst_offset = n_param + n_in;
+	}
+	for (i = 0; i < n; ++i)
+		isl_dim_map_dim_range(dim_map, bmap_space, type, i, 1,
+					dst_offset + pos[i]);
+	isl_dim_map_div(dim_map, bmap, total);
+
+	return isl_basic_map_realign(bmap, space, dim_map);
+error:
+	isl_space_free(space);
+	return isl_basic_map_free(bmap);
+}
+
 /* Compute the preimage of the domain or range (depending on "type")
  * of "bmap" under the function represented by "ma".
  * In other words, plug in "ma" in the domain or range of "bmap".
@@ -13818,7 +15996,7 @@ static __isl_give isl_space *isl_space_set(__isl_take isl_space *space,
  * Then we add the modified constraints and divs from "bmap".
  * Finally, we add the stride constraints, if needed.
  */
-__isl_give isl_basic_map *isl_basic_map_preimage_multi_aff(
+static __isl_give isl_basic_map *isl_basic_map_preimage_multi_aff_general(
 	__isl_take isl_basic_map *bmap, enum isl_dim_type type,
 	__isl_take isl_multi_aff *ma)
 {
@@ -13855,6 +16033,7 @@ __isl_give isl_basic_map *isl_basic_map_preimage_multi_aff(
 
 	space = isl_multi_aff_get_domain_space(ma);
 	space = isl_space_set(isl_basic_map_get_space(bmap), type, space);
+
 	rational = isl_basic_map_is_rational(bmap);
 	strides = rational ? 0 : multi_aff_strides(ma);
 	res = isl_basic_map_alloc_space(space, n_div_ma + n_div_bmap + strides,
@@ -13923,6 +16102,51 @@ error:
 	return NULL;
 }
 
+/* Compute the preimage of the domain or range (depending on "type")
+ * of "bmap" under the function represented by "ma".
+ *
+ * If "ma" simply selects some of its domain variables
+ * (see isl_multi_aff_is_var_selection), then the preimage
+ * is computed by a reordering of the variables of "bmap".
+ * Otherwise, the general substitution is performed.
+ */
+__isl_give isl_basic_map *isl_basic_map_preimage_multi_aff(
+	__isl_take isl_basic_map *bmap, enum isl_dim_type type,
+	__isl_take isl_multi_aff *ma)
+{
+	isl_space *space;
+	isl_bool selection;
+	int *pos;
+
+	if (!bmap || !ma)
+		goto error;
+	if (check_basic_map_compatible_range_multi_aff(bmap, type, ma) < 0)
+		goto error;
+
+	pos = isl_alloc_array(isl_basic_map_get_ctx(bmap), int, ma->n);
+	if (ma->n && !pos)
+		goto error;
+	selection = isl_multi_aff_is_var_selection(ma, pos);
+	if (selection < 0 || !selection) {
+		free(pos);
+		if (selection < 0)
+			goto error;
+		return isl_basic_map_preimage_multi_aff_general(bmap, type, ma);
+	}
+
+	space = isl_multi_aff_get_domain_space(ma);
+	space = isl_space_set(isl_basic_map_get_space(bmap), type, space);
+	isl_multi_aff_free(ma);
+	bmap = isl_basic_map_preimage_var_selection(bmap, type, space, pos);
+	free(pos);
+
+	return bmap;
+error:
+	isl_basic_map_free(bmap);
+	isl_multi_aff_free(ma);
+	return NULL;
+}
+
 /* Compute the preimage of "bset" under the function represented by "ma".
  * In other words, plug in "ma" in "bset".  The result is a basic set
  * that lives in the domain space of "ma".
@@ -14365,6 +16589,7 @@ __isl_give isl_basic_map *isl_basic_map_set_div_expr_constant_num_si_inplace(
 		return isl_basic_map_free(bmap);
 
 	isl_int_set_si(bmap->div[div][1], value);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 
 	return bmap;
 }
@@ -14472,6 +16697,8 @@ __isl_give isl_basic_map *isl_basic_map_transform_dims(
 		goto error;
 
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_SORTED);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_NORMALIZED_DIVS);
 
 	isl_mat_free(trans);
@@ -199,13 +199,24 @@ error:
 
 /* Compute the lexicographic minimum (or maximum if "flags" includes
  * ISL_OPT_MAX) of "map" over its domain.
+ * The computation is performed in an operation scope
+ * such that it can be attributed by external profilers.
  */
 __isl_give TYPE *SF(isl_map_lexopt,SUFFIX)(__isl_take isl_map *map,
 	unsigned flags)
 {
+	isl_ctx *ctx;
+	TYPE *res;
+
+	ctx = isl_map_get_ctx(map);
+	isl_ctx_scope_enter(ctx, ISL_FL_ISSET(flags, ISL_OPT_MAX) ?
+					"isl_map_lexmax" : "isl_map_lexmin");
 	ISL_FL_SET(flags, ISL_OPT_FULL);
-	return SF(isl_map_partial_lexopt_aligned,SUFFIX)(map, NULL, NULL,
+	res = SF(isl_map_partial_lexopt_aligned,SUFFIX)(map, NULL, NULL,
 							flags);
+	isl_ctx_scope_leave(ctx);
+
+	return res;
 }
 
 __isl_give TYPE *SF(isl_map_lexmin,SUFFIX)(__isl_take isl_map *map)
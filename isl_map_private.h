@@ -44,6 +44,8 @@ struct isl_basic_map {
 #define ISL_BASIC_MAP_NORMALIZED_DIVS	(1 << 6)
 #define ISL_BASIC_MAP_ALL_EQUALITIES	(1 << 7)
 #define ISL_BASIC_MAP_REDUCED_COEFFICIENTS	(1 << 8)
+#define ISL_BASIC_MAP_NO_DUPLICATES	(1 << 9)
+#define ISL_BASIC_MAP_SIMPLIFIED	(1 << 10)
 #define ISL_BASIC_SET_FINAL		(1 << 0)
 #define ISL_BASIC_SET_EMPTY		(1 << 1)
 #define ISL_BASIC_SET_NO_IMPLICIT	(1 << 2)
@@ -53,6 +55,8 @@ struct isl_basic_map {
 #define ISL_BASIC_SET_NORMALIZED_DIVS	(1 << 6)
 #define ISL_BASIC_SET_ALL_EQUALITIES	(1 << 7)
 #define ISL_BASIC_SET_REDUCED_COEFFICIENTS	(1 << 8)
+#define ISL_BASIC_SET_NO_DUPLICATES	(1 << 9)
+#define ISL_BASIC_SET_SIMPLIFIED	(1 << 10)
 	unsigned flags;
 
 	struct isl_ctx *ctx;
@@ -92,6 +96,10 @@ struct isl_basic_map {
  * "cached_simple_hull" contains copies of the unshifted and shifted
  * simple hulls, if they have already been computed.  Otherwise,
  * the entries are NULL.
+ *
+ * "cached_hash" contains the hash values of the first "n_cached_hash"
+ * basic maps, if they have already been computed.  These values
+ * are only kept while the map is marked normalized.
  */
 struct isl_map {
 	int ref;
@@ -101,6 +109,9 @@ struct isl_map {
 #define ISL_SET_NORMALIZED		(1 << 1)
 	unsigned flags;
 	isl_basic_map *cached_simple_hull[2];
+	struct isl_map *cached_divs;
+	uint32_t *cached_hash;
+	int n_cached_hash;
 
 	struct isl_ctx *ctx;
 
@@ -304,12 +315,16 @@ int isl_basic_map_plain_cmp(__isl_keep isl_basic_map *bmap1,
 	__isl_keep isl_basic_map *bmap2);
 isl_bool isl_basic_map_plain_is_equal(__isl_keep isl_basic_map *bmap1,
 	__isl_keep isl_basic_map *bmap2);
+isl_bool isl_basic_map_plain_is_disjoint(__isl_keep isl_basic_map *bmap1,
+	__isl_keep isl_basic_map *bmap2);
 __isl_give isl_basic_map *isl_basic_map_normalize_constraints(
 	__isl_take isl_basic_map *bmap);
 __isl_give isl_basic_set *isl_basic_set_normalize_constraints(
 	__isl_take isl_basic_set *bset);
 __isl_give isl_basic_map *isl_basic_map_implicit_equalities(
 	__isl_take isl_basic_map *bmap);
+__isl_give isl_basic_set *isl_basic_set_implicit_equalities(
+	__isl_take isl_basic_set *bset);
 __isl_give isl_basic_set *isl_basic_map_underlying_set(
 	__isl_take isl_basic_map *bmap);
 __isl_give isl_basic_set *isl_basic_set_underlying_set(
@@ -325,6 +340,34 @@ __isl_give isl_basic_map *isl_basic_map_drop_constraints_involving_unknown_divs(
 	__isl_take isl_basic_map *bmap);
 __isl_give isl_map *isl_map_drop_constraints_involving_unknown_divs(
 	__isl_take isl_map *map);
+/* A transposed sparse index of the constraints of a basic map
+ * with respect to the "n" variables starting at position "first"
+ * (not counting the constant term).
+ * The positions of the equality constraints that involve variable
+ * "first" + i are stored in "eq", from position eq_start[i]
+ * up to (but not including) position eq_start[i + 1].
+ * Similarly, "ineq_start" and "ineq" refer to the inequality constraints
+ * and "div_start" and "div" refer to the local variables
+ * with an explicit representation that involves the variable.
+ * The positions are stored in increasing order.
+ * The index is not updated when the basic map is modified.
+ */
+struct isl_basic_map_var_index {
+	unsigned first;
+	unsigned n;
+	int *eq_start;
+	int *eq;
+	int *ineq_start;
+	int *ineq;
+	int *div_start;
+	int *div;
+};
+
+struct isl_basic_map_var_index *isl_basic_map_var_index_alloc(
+	__isl_keep isl_basic_map *bmap, unsigned first, unsigned n);
+struct isl_basic_map_var_index *isl_basic_map_var_index_free(
+	struct isl_basic_map_var_index *index);
+
 __isl_give isl_basic_map *isl_basic_map_drop_constraints_involving(
 	__isl_take isl_basic_map *bmap, unsigned first, unsigned n);
 __isl_give isl_basic_set *isl_basic_set_drop_constraints_involving(
@@ -346,6 +389,8 @@ __isl_give isl_basic_map *isl_basic_map_eliminate_pure_unit_divs(
 	__isl_take isl_basic_map *bmap);
 __isl_give isl_basic_map *isl_basic_map_remove_duplicate_constraints(
 	__isl_take isl_basic_map *bmap, int *progress, int detect_divs);
+isl_bool isl_basic_map_plain_has_contradictory_pair(
+	__isl_keep isl_basic_map *bmap);
 __isl_give isl_basic_map *isl_basic_map_detect_inequality_pairs(
 	__isl_take isl_basic_map *bmap, int *progress);
 
@@ -408,6 +453,9 @@ __isl_give isl_map *isl_map_from_pw_multi_aff_internal(
 
 struct isl_mat;
 
+__isl_give isl_basic_map *isl_basic_map_detect_equalities_with_samples(
+	__isl_take isl_basic_map *bmap, __isl_keep isl_mat *samples);
+
 __isl_give isl_basic_set *isl_basic_set_preimage(
 	__isl_take isl_basic_set *bset, __isl_take isl_mat *mat);
 __isl_give isl_set *isl_set_preimage(
@@ -465,9 +513,6 @@ isl_bool isl_map_divs_known(__isl_keep isl_map *map);
 __isl_give isl_mat *isl_basic_set_get_divs(__isl_keep isl_basic_set *bset);
 __isl_give isl_mat *isl_basic_map_get_divs(__isl_keep isl_basic_map *bmap);
 
-isl_bool isl_set_every_basic_set(__isl_keep isl_set *set,
-	isl_bool (*test)(__isl_keep isl_basic_set *bset, void *user),
-	void *user);
 __isl_give isl_map *isl_map_inline_foreach_basic_map(__isl_take isl_map *map,
 	__isl_give isl_basic_map *(*fn)(__isl_take isl_basic_map *bmap));
 
@@ -15,6 +15,7 @@
 
 #include <isl_ctx_private.h>
 #include <isl_map_private.h>
+#include <isl_gist_context_private.h>
 #include "isl_equalities.h"
 #include <isl/map.h>
 #include <isl_seq.h>
@@ -94,6 +95,8 @@ __isl_give isl_basic_map *isl_basic_map_normalize_constraints(
 			continue;
 		isl_int_fdiv_q(bmap->ineq[i][0], bmap->ineq[i][0], gcd);
 		isl_seq_scale_down(bmap->ineq[i]+1, bmap->ineq[i]+1, gcd, total);
+		ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
+		ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	}
 	isl_int_clear(gcd);
 
@@ -263,6 +266,7 @@ static __isl_give isl_basic_map *normalize_div_expression(
 			ctx->normalize_gcd);
 	isl_seq_scale_down(bmap->div[div] + 2, bmap->div[div] + 2,
 			ctx->normalize_gcd, total);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 
 	return bmap;
 }
@@ -296,21 +300,85 @@ static __isl_give isl_basic_map *normalize_div_expressions(
 	return bmap;
 }
 
+/* The minimal number of variables of a basic map for which
+ * the sparsity pattern of an equality constraint is computed
+ * before using it to eliminate a variable from the other constraints.
+ */
+#define ISL_SPARSE_MIN_TOTAL	32
+
+/* Eliminate the variable at position "pos" from the constraint "c"
+ * using the equality constraint "eq".
+ * If "nz" is not NULL, then it contains the "n_nz" positions
+ * of the non-zero elements of "eq", to be used by isl_seq_elim_sparse.
+ */
+static void elim(isl_int *c, isl_int *eq, unsigned pos, unsigned len,
+	int *nz, int n_nz, isl_int *m)
+{
+	if (nz)
+		isl_seq_elim_sparse(c, eq, pos, len, nz, n_nz, m);
+	else
+		isl_seq_elim(c, eq, pos, len, m);
+}
+
+/* Compute the sparsity pattern of the equality constraint "eq"
+ * of length 1 + "total" in "bmap", if it is worth computing.
+ * Return the number of non-zero elements and set *nz to the array
+ * of positions of these elements, to be freed by the caller.
+ * *nz is set to NULL if the sparsity pattern is not worth using.
+ *
+ * For basic maps with many variables, the equality constraint
+ * typically only involves a few of them.  In this case,
+ * the sparsity pattern of "eq" is computed once such that
+ * the eliminations only need to look at the non-zero elements of "eq".
+ * The sparsity pattern is only used if "eq" involves at most
+ * a quarter of the variables.
+ */
+static int equality_sparsity(__isl_keep isl_basic_map *bmap, isl_int *eq,
+	unsigned total, int **nz)
+{
+	int n_nz;
+
+	*nz = NULL;
+	if (total < ISL_SPARSE_MIN_TOTAL)
+		return 0;
+	*nz = isl_alloc_array(bmap->ctx, int, 1 + total);
+	if (!*nz)
+		return -1;
+	n_nz = isl_seq_non_zero_pos(eq, 1 + total, *nz);
+	if (4 * n_nz > 1 + total) {
+		free(*nz);
+		*nz = NULL;
+	}
+	return n_nz;
+}
+
 /* Assumes divs have been ordered if keep_divs is set.
+ *
+ * Eliminate the variable at position "pos" from the constraints
+ * and the local variable definitions of "bmap" using
+ * the equality constraint "eq".
+ * If "ineq" is not set, then the inequality constraints
+ * are left untouched.  The caller is then responsible
+ * for eliminating the variable from the inequality constraints.
  */
 static __isl_give isl_basic_map *eliminate_var_using_equality(
 	__isl_take isl_basic_map *bmap,
-	unsigned pos, isl_int *eq, int keep_divs, int *progress)
+	unsigned pos, isl_int *eq, int keep_divs, int ineq, int *progress)
 {
 	isl_size total;
 	isl_size v_div;
 	int k;
 	int last_div;
+	int *nz;
+	int n_nz;
 
 	total = isl_basic_map_dim(bmap, isl_dim_all);
 	v_div = isl_basic_map_var_offset(bmap, isl_dim_div);
 	if (total < 0 || v_div < 0)
 		return isl_basic_map_free(bmap);
+	n_nz = equality_sparsity(bmap, eq, total, &nz);
+	if (n_nz < 0)
+		return isl_basic_map_free(bmap);
 	last_div = isl_seq_last_non_zero(eq + 1 + v_div, bmap->n_div);
 	for (k = 0; k < bmap->n_eq; ++k) {
 		if (bmap->eq[k] == eq)
@@ -319,19 +387,21 @@ static __isl_give isl_basic_map *eliminate_var_using_equality(
 			continue;
 		if (progress)
 			*progress = 1;
-		isl_seq_elim(bmap->eq[k], eq, 1+pos, 1+total, NULL);
+		elim(bmap->eq[k], eq, 1 + pos, 1 + total, nz, n_nz, NULL);
 		isl_seq_normalize(bmap->ctx, bmap->eq[k], 1 + total);
 	}
 
-	for (k = 0; k < bmap->n_ineq; ++k) {
+	for (k = 0; ineq && k < bmap->n_ineq; ++k) {
 		if (isl_int_is_zero(bmap->ineq[k][1+pos]))
 			continue;
 		if (progress)
 			*progress = 1;
-		isl_seq_elim(bmap->ineq[k], eq, 1+pos, 1+total, NULL);
+		elim(bmap->ineq[k], eq, 1 + pos, 1 + total, nz, n_nz, NULL);
 		isl_seq_normalize(bmap->ctx, bmap->ineq[k], 1 + total);
 		ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_REDUNDANT);
 		ISL_F_CLR(bmap, ISL_BASIC_MAP_SORTED);
+		ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
+		ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	}
 
 	for (k = 0; k < bmap->n_div; ++k) {
@@ -349,15 +419,89 @@ static __isl_give isl_basic_map *eliminate_var_using_equality(
 		 * is still ordered.
 		 */
 		if (last_div == -1 || (keep_divs && last_div < k)) {
-			isl_seq_elim(bmap->div[k]+1, eq,
-					1+pos, 1+total, &bmap->div[k][0]);
+			elim(bmap->div[k] + 1, eq, 1 + pos, 1 + total,
+				nz, n_nz, &bmap->div[k][0]);
 			bmap = normalize_div_expression(bmap, k);
 			if (!bmap)
-				return NULL;
+				break;
 		} else
 			isl_seq_clr(bmap->div[k], 1 + total);
 	}
 
+	free(nz);
+	return bmap;
+}
+
+/* Eliminate the pivots of the first "n" equality constraints of "bmap"
+ * from the inequality constraints, where the pivot of an equality
+ * constraint is the last variable that appears in the constraint.
+ * Set *progress if anything is changed.
+ *
+ * The equality constraints are assumed to be in reduced row-echelon form,
+ * i.e., the pivot of an equality constraint does not appear
+ * in any of the other equality constraints.
+ * Eliminating a variable using one of these equality constraints
+ * therefore does not reintroduce any of the other variables and
+ * the eliminations can be performed in a single pass
+ * over the equality constraints.
+ * Each elimination only multiplies an inequality constraint
+ * by a positive factor and adds a multiple of an equality constraint.
+ * The inequality constraints are therefore only normalized
+ * at the end, with the same result as normalizing them
+ * after each elimination, but without computing the greatest
+ * common divisor of each of them for each elimination.
+ */
+static __isl_give isl_basic_map *eliminate_vars_from_ineqs(
+	__isl_take isl_basic_map *bmap, int n, int *progress)
+{
+	isl_size total;
+	int i, k;
+	int *touched;
+
+	total = isl_basic_map_dim(bmap, isl_dim_all);
+	if (total < 0)
+		return isl_basic_map_free(bmap);
+	if (n == 0 || bmap->n_ineq == 0)
+		return bmap;
+
+	touched = isl_calloc_array(bmap->ctx, int, bmap->n_ineq);
+	if (!touched)
+		return isl_basic_map_free(bmap);
+
+	for (i = 0; i < n; ++i) {
+		int *nz;
+		int n_nz;
+		int pivot;
+
+		pivot = isl_seq_last_non_zero(bmap->eq[i] + 1, total);
+		n_nz = equality_sparsity(bmap, bmap->eq[i], total, &nz);
+		if (n_nz < 0)
+			break;
+		for (k = 0; k < bmap->n_ineq; ++k) {
+			if (isl_int_is_zero(bmap->ineq[k][1 + pivot]))
+				continue;
+			elim(bmap->ineq[k], bmap->eq[i], 1 + pivot,
+				1 + total, nz, n_nz, NULL);
+			touched[k] = 1;
+		}
+		free(nz);
+	}
+
+	for (k = 0; k < bmap->n_ineq; ++k) {
+		if (!touched[k])
+			continue;
+		if (progress)
+			*progress = 1;
+		isl_seq_normalize(bmap->ctx, bmap->ineq[k], 1 + total);
+		ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_REDUNDANT);
+		ISL_F_CLR(bmap, ISL_BASIC_MAP_SORTED);
+		ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
+		ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
+	}
+
+	free(touched);
+	if (i < n)
+		return isl_basic_map_free(bmap);
 	return bmap;
 }
 
@@ -373,7 +517,7 @@ static __isl_give isl_basic_map *eliminate_div(__isl_take isl_basic_map *bmap,
 	if (v_div < 0)
 		return isl_basic_map_free(bmap);
 	pos = v_div + div;
-	bmap = eliminate_var_using_equality(bmap, pos, eq, keep_divs, NULL);
+	bmap = eliminate_var_using_equality(bmap, pos, eq, keep_divs, 1, NULL);
 
 	bmap = isl_basic_map_drop_div(bmap, div);
 
@@ -382,43 +526,48 @@ static __isl_give isl_basic_map *eliminate_div(__isl_take isl_basic_map *bmap,
 
 /* Check if elimination of div "div" using equality "eq" would not
  * result in a div depending on a later div.
+ * "index" is a transposed sparse index of "bmap" with respect
+ * to (at least) the first div + 1 local variables and is used
+ * to only look at the explicit representations that involve the div.
  */
 static isl_bool ok_to_eliminate_div(__isl_keep isl_basic_map *bmap, isl_int *eq,
-	unsigned div)
+	unsigned div, struct isl_basic_map_var_index *index)
 {
 	int k;
 	int last_div;
 	isl_size v_div;
-	unsigned pos;
 
 	v_div = isl_basic_map_var_offset(bmap, isl_dim_div);
 	if (v_div < 0)
 		return isl_bool_error;
-	pos = v_div + div;
 
 	last_div = isl_seq_last_non_zero(eq + 1 + v_div, bmap->n_div);
 	if (last_div < 0 || last_div <= div)
 		return isl_bool_true;
 
-	for (k = 0; k <= last_div; ++k) {
-		if (isl_int_is_zero(bmap->div[k][0]))
-			continue;
-		if (!isl_int_is_zero(bmap->div[k][1 + 1 + pos]))
+	for (k = index->div_start[div]; k < index->div_start[div + 1]; ++k)
+		if (index->div[k] <= last_div)
 			return isl_bool_false;
-	}
 
 	return isl_bool_true;
 }
 
 /* Eliminate divs based on equalities
+ *
+ * The equality constraints involving each of the divs are looked up
+ * in a transposed sparse index, which is (re)computed
+ * when it is needed, i.e., initially and after a div has been eliminated.
+ * Since the divs are considered from last to first,
+ * the index only needs to cover the divs up to the current one.
  */
 static __isl_give isl_basic_map *eliminate_divs_eq(
 	__isl_take isl_basic_map *bmap, int *progress)
 {
 	int d;
-	int i;
+	int i, k;
 	int modified = 0;
 	unsigned off;
+	struct isl_basic_map_var_index *index = NULL;
 
 	bmap = isl_basic_map_order_divs(bmap);
 
@@ -428,39 +577,57 @@ static __isl_give isl_basic_map *eliminate_divs_eq(
 	off = isl_basic_map_offset(bmap, isl_dim_div);
 
 	for (d = bmap->n_div - 1; d >= 0 ; --d) {
-		for (i = 0; i < bmap->n_eq; ++i) {
+		if (!index)
+			index = isl_basic_map_var_index_alloc(bmap, off - 1,
+								d + 1);
+		if (!index)
+			return isl_basic_map_free(bmap);
+		for (k = index->eq_start[d]; k < index->eq_start[d + 1]; ++k) {
 			isl_bool ok;
 
+			i = index->eq[k];
 			if (!isl_int_is_one(bmap->eq[i][off + d]) &&
 			    !isl_int_is_negone(bmap->eq[i][off + d]))
 				continue;
-			ok = ok_to_eliminate_div(bmap, bmap->eq[i], d);
+			ok = ok_to_eliminate_div(bmap, bmap->eq[i], d, index);
 			if (ok < 0)
-				return isl_basic_map_free(bmap);
+				goto error;
 			if (!ok)
 				continue;
 			modified = 1;
 			*progress = 1;
+			index = isl_basic_map_var_index_free(index);
 			bmap = eliminate_div(bmap, bmap->eq[i], d, 1);
 			if (isl_basic_map_drop_equality(bmap, i) < 0)
 				return isl_basic_map_free(bmap);
 			break;
 		}
 	}
+	isl_basic_map_var_index_free(index);
 	if (modified)
 		return eliminate_divs_eq(bmap, progress);
 	return bmap;
+error:
+	isl_basic_map_var_index_free(index);
+	return isl_basic_map_free(bmap);
 }
 
 /* Eliminate divs based on inequalities
+ *
+ * The constraints involving each of the divs are looked up
+ * in a transposed sparse index, which is (re)computed
+ * when it is needed, i.e., initially and after a div has been eliminated.
+ * Since the divs are considered from last to first,
+ * the index only needs to cover the divs up to the current one.
  */
 static __isl_give isl_basic_map *eliminate_divs_ineq(
 	__isl_take isl_basic_map *bmap, int *progress)
 {
 	int d;
-	int i;
+	int k;
 	unsigned off;
 	struct isl_ctx *ctx;
+	struct isl_basic_map_var_index *index = NULL;
 
 	if (!bmap)
 		return NULL;
@@ -469,16 +636,21 @@ static __isl_give isl_basic_map *eliminate_divs_ineq(
 	off = isl_basic_map_offset(bmap, isl_dim_div);
 
 	for (d = bmap->n_div - 1; d >= 0 ; --d) {
-		for (i = 0; i < bmap->n_eq; ++i)
-			if (!isl_int_is_zero(bmap->eq[i][off + d]))
-				break;
-		if (i < bmap->n_eq)
+		if (!index)
+			index = isl_basic_map_var_index_alloc(bmap, off - 1,
+								d + 1);
+		if (!index)
+			return isl_basic_map_free(bmap);
+		if (index->eq_start[d + 1] > index->eq_start[d])
 			continue;
-		for (i = 0; i < bmap->n_ineq; ++i)
-			if (isl_int_abs_gt(bmap->ineq[i][off + d], ctx->one))
+		for (k = index->ineq_start[d]; k < index->ineq_start[d + 1];
+		     ++k)
+			if (isl_int_abs_gt(bmap->ineq[index->ineq[k]][off + d],
+					    ctx->one))
 				break;
-		if (i < bmap->n_ineq)
+		if (k < index->ineq_start[d + 1])
 			continue;
+		index = isl_basic_map_var_index_free(index);
 		*progress = 1;
 		bmap = isl_basic_map_eliminate_vars(bmap, (off-1)+d, 1);
 		if (!bmap || ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY))
@@ -487,6 +659,7 @@ static __isl_give isl_basic_map *eliminate_divs_ineq(
 		if (!bmap)
 			break;
 	}
+	isl_basic_map_var_index_free(index);
 	return bmap;
 }
 
@@ -568,6 +741,7 @@ static __isl_give isl_basic_map *set_div_from_eq(__isl_take isl_basic_map *bmap,
 	isl_seq_neg(bmap->div[div] + 1, bmap->eq[eq], 1 + total);
 	isl_int_set_si(bmap->div[div][1 + o_div + div], 0);
 	isl_int_set(bmap->div[div][0], bmap->eq[eq][o_div + div]);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	if (progress)
 		*progress = 1;
 
@@ -579,6 +753,8 @@ static __isl_give isl_basic_map *set_div_from_eq(__isl_take isl_basic_map *bmap,
  * That is, put them into row-echelon form, starting from the last column
  * backward and use them to eliminate the corresponding coefficients
  * from all constraints.
+ * The coefficients are eliminated from the inequality constraints
+ * in a single pass at the end, using the final equality constraints.
  *
  * If "progress" is not NULL, then it gets set if the elimination
  * results in any changes.
@@ -634,7 +810,7 @@ __isl_give isl_basic_map *isl_basic_map_gauss5(__isl_take isl_basic_map *bmap,
 			isl_seq_neg(bmap->eq[done], bmap->eq[done], 1+total);
 
 		bmap = eliminate_var_using_equality(bmap, last_var,
-						bmap->eq[done], 1, progress);
+						bmap->eq[done], 1, 0, progress);
 
 		if (last_var >= total_var)
 			bmap = set_div_from_eq(bmap, last_var - total_var,
@@ -642,6 +818,9 @@ __isl_give isl_basic_map *isl_basic_map_gauss5(__isl_take isl_basic_map *bmap,
 		if (!bmap)
 			return NULL;
 	}
+	bmap = eliminate_vars_from_ineqs(bmap, done, progress);
+	if (!bmap)
+		return NULL;
 	if (done == bmap->n_eq)
 		return bmap;
 	for (k = done; k < bmap->n_eq; ++k) {
@@ -1124,6 +1303,7 @@ static __isl_give isl_basic_map *set_div_from_lower_bound(
 	isl_int_add(bmap->div[div][1], bmap->div[div][1], bmap->div[div][0]);
 	isl_int_sub_ui(bmap->div[div][1], bmap->div[div][1], 1);
 	isl_int_set_si(bmap->div[div][1 + total + div], 0);
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 
 	return bmap;
 }
@@ -1236,16 +1416,34 @@ static __isl_give isl_basic_map *check_for_div_constraints(
 	return bmap;
 }
 
+/* Remove duplicate inequality constraints from "bmap" and
+ * look for pairs of opposite inequality constraints.
+ * If such a pair forms an equality, then it is replaced by that equality.
+ * If it is contradictory, then "bmap" is marked empty.
+ * If "detect_divs" is set, then other pairs are used to look
+ * for integer division expressions.
+ *
+ * If a previous call found nothing to change and "bmap"
+ * has not been modified since, then ISL_BASIC_MAP_NO_DUPLICATES is set
+ * and the constraint index does not need to be recomputed.
+ * The flag is only set by a call that would also have looked
+ * for integer division expressions, or that did not encounter
+ * any pair that could have been used for that purpose.
+ */
 __isl_give isl_basic_map *isl_basic_map_remove_duplicate_constraints(
 	__isl_take isl_basic_map *bmap, int *progress, int detect_divs)
 {
 	struct isl_constraint_index ci;
 	int k, l, h;
+	int changed = 0;
+	int skipped = 0;
 	isl_size total = isl_basic_map_dim(bmap, isl_dim_all);
 	isl_int sum;
 
 	if (total < 0 || bmap->n_ineq <= 1)
 		return bmap;
+	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_NO_DUPLICATES))
+		return bmap;
 
 	if (create_constraint_index(&ci, bmap) < 0)
 		return bmap;
@@ -1258,8 +1456,7 @@ __isl_give isl_basic_map *isl_basic_map_remove_duplicate_constraints(
 			ci.index[h] = &bmap->ineq[k];
 			continue;
 		}
-		if (progress)
-			*progress = 1;
+		changed = 1;
 		l = ci.index[h] - &bmap->ineq[0];
 		if (isl_int_lt(bmap->ineq[k][0], bmap->ineq[l][0]))
 			swap_inequality(bmap, k, l);
@@ -1278,7 +1475,9 @@ __isl_give isl_basic_map *isl_basic_map_remove_duplicate_constraints(
 		if (isl_int_is_pos(sum)) {
 			if (detect_divs)
 				bmap = check_for_div_constraints(bmap, k, l,
-								 sum, progress);
+								 sum, &changed);
+			else
+				skipped = 1;
 			continue;
 		}
 		if (isl_int_is_zero(sum)) {
@@ -1287,8 +1486,7 @@ __isl_give isl_basic_map *isl_basic_map_remove_duplicate_constraints(
 			 * will no longer be valid.
 			 * Plus, we probably we want to regauss first.
 			 */
-			if (progress)
-				*progress = 1;
+			changed = 1;
 			isl_basic_map_drop_inequality(bmap, l);
 			isl_basic_map_inequality_to_equality(bmap, k);
 		} else
@@ -1298,9 +1496,72 @@ __isl_give isl_basic_map *isl_basic_map_remove_duplicate_constraints(
 	isl_int_clear(sum);
 
 	constraint_index_free(&ci);
+	if (changed && progress)
+		*progress = 1;
+	if (bmap && !changed && !skipped &&
+	    !ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY))
+		ISL_F_SET(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
 	return bmap;
 }
 
+/* Does "bmap" have a pair of inequality constraints with opposite
+ * coefficients such that the sum of their constant terms is negative?
+ * If so, "bmap" is obviously empty.
+ *
+ * Of the inequalities with the same coefficients, only the one
+ * with the smallest constant term is kept in the index.
+ * Each inequality is then compared against the kept opposite inequality.
+ * The coefficients are negated in place to look up the opposite
+ * inequality and then restored.  This does not modify "bmap"
+ * in any observable way.
+ */
+isl_bool isl_basic_map_plain_has_contradictory_pair(
+	__isl_keep isl_basic_map *bmap)
+{
+	struct isl_constraint_index ci;
+	int k, l, h;
+	isl_size total;
+	isl_bool contradictory = isl_bool_false;
+	isl_int sum;
+
+	total = isl_basic_map_dim(bmap, isl_dim_all);
+	if (total < 0)
+		return isl_bool_error;
+	if (bmap->n_ineq <= 1)
+		return isl_bool_false;
+
+	if (create_constraint_index(&ci, bmap) < 0)
+		return isl_bool_error;
+
+	for (k = 0; k < bmap->n_ineq; ++k) {
+		h = hash_index(&ci, bmap, k);
+		if (ci.index[h]) {
+			l = ci.index[h] - &bmap->ineq[0];
+			if (isl_int_ge(bmap->ineq[k][0], bmap->ineq[l][0]))
+				continue;
+		}
+		ci.index[h] = &bmap->ineq[k];
+	}
+	isl_int_init(sum);
+	for (k = 0; k < bmap->n_ineq; ++k) {
+		isl_seq_neg(bmap->ineq[k] + 1, bmap->ineq[k] + 1, total);
+		h = hash_index(&ci, bmap, k);
+		isl_seq_neg(bmap->ineq[k] + 1, bmap->ineq[k] + 1, total);
+		if (!ci.index[h])
+			continue;
+		l = ci.index[h] - &bmap->ineq[0];
+		isl_int_add(sum, bmap->ineq[k][0], bmap->ineq[l][0]);
+		if (isl_int_is_neg(sum)) {
+			contradictory = isl_bool_true;
+			break;
+		}
+	}
+	isl_int_clear(sum);
+
+	constraint_index_free(&ci);
+	return contradictory;
+}
+
 /* Detect all pairs of inequalities that form an equality.
  *
  * isl_basic_map_remove_duplicate_constraints detects at most one such pair.
@@ -1325,8 +1586,12 @@ __isl_give isl_basic_map *isl_basic_map_detect_inequality_pairs(
 /* Given a known integer division "div" that is not integral
  * (with denominator 1), eliminate it from the constraints in "bmap"
  * where it appears with a (positive or negative) unit coefficient.
- * If "progress" is not NULL, then it gets set if the elimination
- * results in any changes.
+ * "index" is a transposed sparse index of the constraints of "bmap"
+ * with respect to its local variables and is used to only look
+ * at the constraints that involve the div.
+ * "modified" is set if the elimination results in any changes.
+ * Since the constraints that get added do not involve the div
+ * with a unit coefficient, they do not need to be considered.
  *
  * That is, replace
  *
@@ -1358,9 +1623,10 @@ __isl_give isl_basic_map *isl_basic_map_detect_inequality_pairs(
  * sure we do not lose any information.
  */
 static __isl_give isl_basic_map *eliminate_unit_div(
-	__isl_take isl_basic_map *bmap, int div, int *progress)
+	__isl_take isl_basic_map *bmap, int div,
+	struct isl_basic_map_var_index *index, int *modified)
 {
-	int j;
+	int k;
 	isl_size v_div, dim;
 	isl_ctx *ctx;
 
@@ -1371,15 +1637,15 @@ static __isl_give isl_basic_map *eliminate_unit_div(
 
 	ctx = isl_basic_map_get_ctx(bmap);
 
-	for (j = 0; j < bmap->n_ineq; ++j) {
+	for (k = index->ineq_start[div]; k < index->ineq_start[div + 1]; ++k) {
+		int j = index->ineq[k];
 		int s;
 
 		if (!isl_int_is_one(bmap->ineq[j][1 + v_div + div]) &&
 		    !isl_int_is_negone(bmap->ineq[j][1 + v_div + div]))
 			continue;
 
-		if (progress)
-			*progress = 1;
+		*modified = 1;
 
 		s = isl_int_sgn(bmap->ineq[j][1 + v_div + div]);
 		isl_int_set_si(bmap->ineq[j][1 + v_div + div], 0);
@@ -1418,41 +1684,72 @@ static __isl_give isl_basic_map *eliminate_unit_div(
  * to handle those divs here anyway since the div constraints will turn
  * out to form an equality and this equality can then be used to eliminate
  * the div from all constraints.
+ *
+ * The constraints involving each of the divs are looked up
+ * in a transposed sparse index of the constraints, which is computed
+ * when it is first needed.
+ * Eliminating a div only changes the coefficients of the divs
+ * that appear in its explicit representation and the constraints
+ * that are added back only involve those divs and the div itself.
+ * The index therefore remains valid for the later divs, unless
+ * the explicit representation involves any of those later divs.
  */
 static __isl_give isl_basic_map *eliminate_selected_unit_divs(
 	__isl_take isl_basic_map *bmap,
-	isl_bool (*select)(__isl_keep isl_basic_map *bmap, int div),
+	isl_bool (*select)(__isl_keep isl_basic_map *bmap, int div,
+		struct isl_basic_map_var_index *index),
 	int *progress)
 {
 	int i;
+	isl_size v_div;
+	struct isl_basic_map_var_index *index = NULL;
 
-	if (!bmap)
-		return NULL;
+	v_div = isl_basic_map_var_offset(bmap, isl_dim_div);
+	if (v_div < 0)
+		return isl_basic_map_free(bmap);
 
 	for (i = 0; i < bmap->n_div; ++i) {
 		isl_bool selected;
+		int modified = 0;
 
 		if (isl_int_is_zero(bmap->div[i][0]))
 			continue;
 		if (isl_int_is_one(bmap->div[i][0]))
 			continue;
-		selected = select(bmap, i);
-		if (selected < 0)
+		if (!index)
+			index = isl_basic_map_var_index_alloc(bmap, v_div,
+								bmap->n_div);
+		if (!index)
 			return isl_basic_map_free(bmap);
+		selected = select(bmap, i, index);
+		if (selected < 0)
+			goto error;
 		if (!selected)
 			continue;
-		bmap = eliminate_unit_div(bmap, i, progress);
+		bmap = eliminate_unit_div(bmap, i, index, &modified);
 		if (!bmap)
-			return NULL;
+			goto error;
+		if (!modified)
+			continue;
+		if (progress)
+			*progress = 1;
+		if (isl_seq_first_non_zero(bmap->div[i] + 1 + 1 + v_div + i + 1,
+					    bmap->n_div - (i + 1)) != -1)
+			index = isl_basic_map_var_index_free(index);
 	}
 
+	isl_basic_map_var_index_free(index);
 	return bmap;
+error:
+	isl_basic_map_var_index_free(index);
+	return isl_basic_map_free(bmap);
 }
 
 /* eliminate_selected_unit_divs callback that selects every
  * integer division.
  */
-static isl_bool is_any_div(__isl_keep isl_basic_map *bmap, int div)
+static isl_bool is_any_div(__isl_keep isl_basic_map *bmap, int div,
+	struct isl_basic_map_var_index *index)
 {
 	return isl_bool_true;
 }
@@ -1472,22 +1769,23 @@ static __isl_give isl_basic_map *eliminate_unit_divs(
  * integer divisions that only appear with
  * a (positive or negative) unit coefficient
  * (outside their div constraints).
+ * Only the inequality constraints listed in "index"
+ * for the integer division need to be considered.
  */
-static isl_bool is_pure_unit_div(__isl_keep isl_basic_map *bmap, int div)
+static isl_bool is_pure_unit_div(__isl_keep isl_basic_map *bmap, int div,
+	struct isl_basic_map_var_index *index)
 {
-	int i;
-	isl_size v_div, n_ineq;
+	int k;
+	isl_size v_div;
 
 	v_div = isl_basic_map_var_offset(bmap, isl_dim_div);
-	n_ineq = isl_basic_map_n_inequality(bmap);
-	if (v_div < 0 || n_ineq < 0)
+	if (v_div < 0)
 		return isl_bool_error;
 
-	for (i = 0; i < n_ineq; ++i) {
+	for (k = index->ineq_start[div]; k < index->ineq_start[div + 1]; ++k) {
+		int i = index->ineq[k];
 		isl_bool skip;
 
-		if (isl_int_is_zero(bmap->ineq[i][1 + v_div + div]))
-			continue;
 		skip = isl_basic_map_is_div_constraint(bmap,
 							bmap->ineq[i], div);
 		if (skip < 0)
@@ -1513,11 +1811,23 @@ __isl_give isl_basic_map *isl_basic_map_eliminate_pure_unit_divs(
 	return eliminate_selected_unit_divs(bmap, &is_pure_unit_div, NULL);
 }
 
+/* Simplify "bmap" by repeatedly applying a number of cheap
+ * simplification steps until none of them makes any more progress.
+ *
+ * Since this process is idempotent, there is no need to perform it
+ * again on a basic map that has already been simplified and
+ * that has not been modified since.
+ * This is recorded in ISL_BASIC_MAP_SIMPLIFIED, which is cleared
+ * by isl_basic_map_cow and by the functions that add, drop or modify
+ * constraints or integer divisions of a basic map in place.
+ */
 __isl_give isl_basic_map *isl_basic_map_simplify(__isl_take isl_basic_map *bmap)
 {
 	int progress = 1;
 	if (!bmap)
 		return NULL;
+	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_SIMPLIFIED))
+		return bmap;
 	while (progress) {
 		isl_bool empty;
 
@@ -1539,9 +1849,13 @@ __isl_give isl_basic_map *isl_basic_map_simplify(__isl_take isl_basic_map *bmap)
 		bmap = normalize_divs(bmap, &progress);
 		bmap = isl_basic_map_remove_duplicate_constraints(bmap,
 								&progress, 1);
-		if (bmap && progress)
+		if (!bmap)
+			return NULL;
+		if (progress)
 			ISL_F_CLR(bmap, ISL_BASIC_MAP_REDUCED_COEFFICIENTS);
+		ISL_F_CLR(bmap, ISL_BASIC_MAP_NO_DUPLICATES);
 	}
+	ISL_F_SET(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 	return bmap;
 }
 
@@ -1595,37 +1909,30 @@ isl_bool isl_basic_map_is_div_constraint(__isl_keep isl_basic_map *bmap,
  *	-(f - (m - 1)) + m d >= 0
  *
  * then it can safely be removed.
+ *
+ * "index" is a transposed sparse index of the constraints of "bmap"
+ * with respect to its local variables and is used to only look
+ * at the constraints and explicit representations that involve the div.
  */
-static isl_bool div_is_redundant(__isl_keep isl_basic_map *bmap, int div)
+static isl_bool div_is_redundant(__isl_keep isl_basic_map *bmap, int div,
+	struct isl_basic_map_var_index *index)
 {
 	int i;
-	isl_size v_div = isl_basic_map_var_offset(bmap, isl_dim_div);
-	unsigned pos = 1 + v_div + div;
 
-	if (v_div < 0)
-		return isl_bool_error;
-
-	for (i = 0; i < bmap->n_eq; ++i)
-		if (!isl_int_is_zero(bmap->eq[i][pos]))
-			return isl_bool_false;
+	if (index->eq_start[div + 1] > index->eq_start[div])
+		return isl_bool_false;
+	if (index->div_start[div + 1] > index->div_start[div])
+		return isl_bool_false;
 
-	for (i = 0; i < bmap->n_ineq; ++i) {
+	for (i = index->ineq_start[div]; i < index->ineq_start[div + 1]; ++i) {
 		isl_bool red;
 
-		if (isl_int_is_zero(bmap->ineq[i][pos]))
-			continue;
-		red = isl_basic_map_is_div_constraint(bmap, bmap->ineq[i], div);
+		red = isl_basic_map_is_div_constraint(bmap,
+					bmap->ineq[index->ineq[i]], div);
 		if (red < 0 || !red)
 			return red;
 	}
 
-	for (i = 0; i < bmap->n_div; ++i) {
-		if (isl_int_is_zero(bmap->div[i][0]))
-			continue;
-		if (!isl_int_is_zero(bmap->div[i][1+pos]))
-			return isl_bool_false;
-	}
-
 	return isl_bool_true;
 }
 
@@ -1634,12 +1941,18 @@ static isl_bool div_is_redundant(__isl_keep isl_basic_map *bmap, int div)
  * These can arise when dropping constraints from a basic map or
  * when the divs of a basic map have been temporarily aligned
  * with the divs of another basic map.
+ *
+ * The constraints involving each of the divs are looked up
+ * in a transposed sparse index of the constraints.
+ * This index is only (re)computed when it is needed,
+ * i.e., initially and after constraints have been removed.
  */
 static __isl_give isl_basic_map *remove_redundant_divs(
 	__isl_take isl_basic_map *bmap)
 {
 	int i;
 	isl_size v_div;
+	struct isl_basic_map_var_index *index = NULL;
 
 	v_div = isl_basic_map_var_offset(bmap, isl_dim_div);
 	if (v_div < 0)
@@ -1648,15 +1961,23 @@ static __isl_give isl_basic_map *remove_redundant_divs(
 	for (i = bmap->n_div-1; i >= 0; --i) {
 		isl_bool redundant;
 
-		redundant = div_is_redundant(bmap, i);
-		if (redundant < 0)
+		if (!index)
+			index = isl_basic_map_var_index_alloc(bmap, v_div, i + 1);
+		if (!index)
+			return isl_basic_map_free(bmap);
+		redundant = div_is_redundant(bmap, i, index);
+		if (redundant < 0) {
+			isl_basic_map_var_index_free(index);
 			return isl_basic_map_free(bmap);
+		}
 		if (!redundant)
 			continue;
+		index = isl_basic_map_var_index_free(index);
 		bmap = isl_basic_map_drop_constraints_involving(bmap,
 								v_div + i, 1);
 		bmap = isl_basic_map_drop_div(bmap, i);
 	}
+	isl_basic_map_var_index_free(index);
 	return bmap;
 }
 
@@ -1746,7 +2067,7 @@ __isl_give isl_basic_map *isl_basic_map_eliminate_vars(
 			if (isl_int_is_zero(bmap->eq[i][1+d]))
 				continue;
 			bmap = eliminate_var_using_equality(bmap, d,
-							bmap->eq[i], 0, NULL);
+							bmap->eq[i], 0, 1, NULL);
 			if (isl_basic_map_drop_equality(bmap, i) < 0)
 				return isl_basic_map_free(bmap);
 			need_gauss = 1;
@@ -2095,6 +2416,162 @@ error:
 	return isl_stat_error;
 }
 
+/* Given the constraint "c" of "context", which is known to involve
+ * a single variable at position "pos" with coefficient "a",
+ * update the known bounds on that variable in "lo" and "up".
+ * "has_lo" and "has_up" keep track of which bounds are known.
+ * An equality constraint is passed in as "c" for the lower bound and
+ * with "eq" set.
+ */
+static void update_bound(isl_int *c, int pos, int eq,
+	isl_int *lo, isl_int *up, int *has_lo, int *has_up, isl_int *tmp)
+{
+	isl_int *a = &c[1 + pos];
+
+	if (eq) {
+		if (!isl_int_is_divisible_by(c[0], *a))
+			return;
+		isl_int_divexact(*tmp, c[0], *a);
+		isl_int_neg(*tmp, *tmp);
+		if (!has_lo[pos] || isl_int_gt(*tmp, lo[pos]))
+			isl_int_set(lo[pos], *tmp);
+		if (!has_up[pos] || isl_int_lt(*tmp, up[pos]))
+			isl_int_set(up[pos], *tmp);
+		has_lo[pos] = has_up[pos] = 1;
+	} else if (isl_int_is_pos(*a)) {
+		isl_int_neg(*tmp, c[0]);
+		isl_int_cdiv_q(*tmp, *tmp, *a);
+		if (!has_lo[pos] || isl_int_gt(*tmp, lo[pos]))
+			isl_int_set(lo[pos], *tmp);
+		has_lo[pos] = 1;
+	} else {
+		isl_int_neg(*tmp, *a);
+		isl_int_fdiv_q(*tmp, c[0], *tmp);
+		if (!has_up[pos] || isl_int_lt(*tmp, up[pos]))
+			isl_int_set(up[pos], *tmp);
+		has_up[pos] = 1;
+	}
+}
+
+/* For each inequality in "ineq" that has not been marked yet in "row"
+ * and that is implied by the bounds on individual variables
+ * that appear explicitly in "context", mark the corresponding entry
+ * in "row" with -1.
+ *
+ * That is, collect the lower and upper bounds on each variable
+ * from the constraints of "context" that involve only that variable and
+ * check whether the minimal value of each remaining inequality
+ * over the resulting box is non-negative.
+ * Since the bounds are rounded to integer values, this check
+ * is only performed if "context" is not rational.
+ * This check is much cheaper than constructing a tableau and
+ * captures the common case of a context that consists of simple
+ * parameter or loop bounds.
+ */
+static isl_stat mark_bounded_constraints(__isl_keep isl_mat *ineq,
+	__isl_keep isl_basic_set *context, int *row)
+{
+	isl_ctx *ctx;
+	isl_size n_ineq, cols, dim;
+	unsigned total;
+	int i, k;
+	int n_bound = 0;
+	int *has_lo = NULL, *has_up = NULL;
+	isl_int *lo = NULL, *up = NULL;
+	isl_int tmp, min;
+
+	n_ineq = isl_mat_rows(ineq);
+	cols = isl_mat_cols(ineq);
+	dim = isl_basic_set_dim(context, isl_dim_all);
+	if (n_ineq < 0 || cols < 0 || dim < 0)
+		return isl_stat_error;
+	if (ISL_F_ISSET(context, ISL_BASIC_SET_RATIONAL))
+		return isl_stat_ok;
+	total = cols - 1;
+	if (total == 0 || dim != total)
+		return isl_stat_ok;
+
+	for (i = 0; i < context->n_eq + context->n_ineq; ++i) {
+		isl_int *c = i < context->n_eq ? context->eq[i] :
+					context->ineq[i - context->n_eq];
+		int pos = isl_seq_first_non_zero(c + 1, total);
+		if (pos >= 0 &&
+		    isl_seq_first_non_zero(c + 1 + pos + 1,
+					    total - pos - 1) == -1)
+			n_bound++;
+	}
+	if (n_bound == 0)
+		return isl_stat_ok;
+
+	ctx = isl_basic_set_get_ctx(context);
+	has_lo = isl_calloc_array(ctx, int, total);
+	has_up = isl_calloc_array(ctx, int, total);
+	lo = isl_alloc_array(ctx, isl_int, total);
+	up = isl_alloc_array(ctx, isl_int, total);
+	if (!has_lo || !has_up || !lo || !up) {
+		free(has_lo);
+		free(has_up);
+		free(lo);
+		free(up);
+		return isl_stat_error;
+	}
+	for (i = 0; i < total; ++i) {
+		isl_int_init(lo[i]);
+		isl_int_init(up[i]);
+	}
+	isl_int_init(tmp);
+	isl_int_init(min);
+
+	for (i = 0; i < context->n_eq + context->n_ineq; ++i) {
+		int eq = i < context->n_eq;
+		isl_int *c = eq ? context->eq[i] :
+				context->ineq[i - context->n_eq];
+		int pos = isl_seq_first_non_zero(c + 1, total);
+		if (pos < 0 ||
+		    isl_seq_first_non_zero(c + 1 + pos + 1,
+					    total - pos - 1) != -1)
+			continue;
+		update_bound(c, pos, eq, lo, up, has_lo, has_up, &tmp);
+	}
+
+	for (k = 0; k < n_ineq; ++k) {
+		isl_int *c = ineq->row[k];
+
+		if (row[k] < 0)
+			continue;
+		isl_int_set(min, c[0]);
+		for (i = 0; i < total; ++i) {
+			if (isl_int_is_zero(c[1 + i]))
+				continue;
+			if (isl_int_is_pos(c[1 + i])) {
+				if (!has_lo[i])
+					break;
+				isl_int_addmul(min, c[1 + i], lo[i]);
+			} else {
+				if (!has_up[i])
+					break;
+				isl_int_addmul(min, c[1 + i], up[i]);
+			}
+		}
+		if (i < total)
+			continue;
+		if (isl_int_is_nonneg(min))
+			row[k] = -1;
+	}
+
+	isl_int_clear(tmp);
+	isl_int_clear(min);
+	for (i = 0; i < total; ++i) {
+		isl_int_clear(lo[i]);
+		isl_int_clear(up[i]);
+	}
+	free(has_lo);
+	free(has_up);
+	free(lo);
+	free(up);
+	return isl_stat_ok;
+}
+
 static __isl_give isl_basic_set *remove_shifted_constraints(
 	__isl_take isl_basic_set *bset, __isl_keep isl_basic_set *context)
 {
@@ -2516,6 +2993,12 @@ static __isl_give isl_basic_set *update_ineq_free(
  * a factorization because factors in "bset" may still be connected
  * to each other through constraints in "context".
  *
+ * Similarly, inequalities that are implied by the bounds
+ * on individual variables in "context" are marked redundant
+ * without constructing a tableau.
+ * The number of calls that are completely decided by each of these
+ * steps is kept track of in the statistics of the isl_ctx.
+ *
  * If there are any inequalities left, we construct a tableau for
  * the context and then add the inequalities of "bset".
  * Before adding these inequalities, we freeze all constraints such that
@@ -2553,14 +3036,26 @@ static __isl_give isl_basic_set *uset_gist_full(__isl_take isl_basic_set *bset,
 
 	if (mark_shifted_constraints(ineq, context, row) < 0)
 		goto error;
-	if (all_neg(row, bset->n_ineq))
+	if (all_neg(row, bset->n_ineq)) {
+		ctx->stats->gist_plain_decided++;
 		return update_ineq_free(bset, ineq, context, row, NULL);
+	}
+	if (mark_bounded_constraints(ineq, context, row) < 0)
+		goto error;
+	if (all_neg(row, bset->n_ineq)) {
+		ctx->stats->gist_bounds_decided++;
+		return update_ineq_free(bset, ineq, context, row, NULL);
+	}
 
 	context = drop_irrelevant_constraints_marked(context, ineq, row);
 	if (!context)
 		goto error;
-	if (isl_basic_set_plain_is_universe(context))
+	if (isl_basic_set_plain_is_universe(context)) {
+		ctx->stats->gist_plain_decided++;
 		return update_ineq_free(bset, ineq, context, row, NULL);
+	}
+
+	ctx->stats->gist_tab_decided++;
 
 	n_eq = context->n_eq;
 	context_ineq = context->n_ineq;
@@ -3257,7 +3752,7 @@ static __isl_give isl_basic_map *gist_strides(__isl_take isl_basic_map *bmap,
  * also simplified with respecting to the other equality constraints
  * in "bmap" and with respect to all equality constraints in "context".
  */
-__isl_give isl_basic_map *isl_basic_map_gist(__isl_take isl_basic_map *bmap,
+static __isl_give isl_basic_map *basic_map_gist(__isl_take isl_basic_map *bmap,
 	__isl_take isl_basic_map *context)
 {
 	isl_basic_set *bset, *eq;
@@ -3328,6 +3823,29 @@ error:
 	return NULL;
 }
 
+/* Simplify "bmap" with respect to "context" as in basic_map_gist,
+ * keeping track of the number of calls and the time spent
+ * in the statistics of the isl_ctx.
+ */
+__isl_give isl_basic_map *isl_basic_map_gist(__isl_take isl_basic_map *bmap,
+	__isl_take isl_basic_map *context)
+{
+	isl_ctx *ctx;
+	clock_t start;
+
+	ctx = isl_basic_map_get_ctx(bmap);
+	if (!ctx) {
+		isl_basic_map_free(context);
+		return NULL;
+	}
+
+	start = isl_ctx_stats_enter(ctx, &ctx->stats->gist_calls);
+	bmap = basic_map_gist(bmap, context);
+	isl_ctx_stats_leave(&ctx->stats->gist_time, start);
+
+	return bmap;
+}
+
 /*
  * Assumes context has no implicit divs.
  */
@@ -3669,7 +4187,7 @@ static __isl_give isl_map *replace_by_universe(__isl_take isl_map *map,
  * for the context.  These can then be used to simplify away
  * the corresponding constraints in "map".
  */
-__isl_give isl_map *isl_map_gist(__isl_take isl_map *map,
+static __isl_give isl_map *map_gist(__isl_take isl_map *map,
 	__isl_take isl_map *context)
 {
 	int equal;
@@ -3730,6 +4248,85 @@ error:
 	return NULL;
 }
 
+/* Simplify "map" with respect to "context" as in map_gist,
+ * in an operation scope such that the computation
+ * can be attributed by external profilers.
+ */
+__isl_give isl_map *isl_map_gist(__isl_take isl_map *map,
+	__isl_take isl_map *context)
+{
+	isl_ctx *ctx;
+
+	ctx = isl_map_get_ctx(map);
+	isl_ctx_scope_enter(ctx, "isl_map_gist");
+	map = map_gist(map, context);
+	isl_ctx_scope_leave(ctx);
+
+	return map;
+}
+
+/* Return a map that has the same intersection with the context
+ * represented by "context" as "map" and that is as "simple" as possible.
+ *
+ * This performs the same computation as isl_map_gist,
+ * except that the hull of the context has been computed
+ * by isl_gist_context_from_map.
+ * If the context consists of several disjuncts, then isl_map_gist
+ * uses a hull that also depends on "map", so in this case, as well as
+ * in case the parameters of "map" and the context are not aligned,
+ * simply call isl_map_gist on the (preprocessed) context.
+ */
+__isl_give isl_map *isl_map_gist_prepared(__isl_take isl_map *map,
+	__isl_keep isl_gist_context *context)
+{
+	isl_ctx *ctx;
+	isl_bool equal;
+	isl_bool is_universe;
+	isl_bool subset;
+
+	if (!map || !context)
+		return isl_map_free(map);
+	if (context->universe)
+		return map;
+	equal = isl_map_has_equal_params(map, context->map);
+	if (equal < 0)
+		return isl_map_free(map);
+	if (!equal || !context->single)
+		return isl_map_gist(map, isl_map_copy(context->map));
+
+	is_universe = isl_map_plain_is_universe(map);
+	if (is_universe < 0)
+		return isl_map_free(map);
+	if (is_universe)
+		return map;
+	equal = isl_map_plain_is_equal(map, context->map);
+	if (equal < 0)
+		return isl_map_free(map);
+	if (equal)
+		return replace_by_universe(map, isl_map_copy(context->map));
+	if (map->n != 1) {
+		subset = isl_map_is_subset(context->map, map);
+		if (subset < 0)
+			return isl_map_free(map);
+		if (subset)
+			return replace_by_universe(map,
+						isl_map_copy(context->map));
+	}
+
+	ctx = isl_map_get_ctx(map);
+	isl_ctx_scope_enter(ctx, "isl_map_gist_prepared");
+	map = isl_map_gist_basic_map(map, isl_basic_map_copy(context->hull));
+	isl_ctx_scope_leave(ctx);
+
+	return map;
+}
+
+__isl_give isl_set *isl_set_gist_prepared(__isl_take isl_set *set,
+	__isl_keep isl_gist_context *context)
+{
+	return set_from_map(isl_map_gist_prepared(set_to_map(set), context));
+}
+
 __isl_give isl_basic_set *isl_basic_set_gist(__isl_take isl_basic_set *bset,
 	__isl_take isl_basic_set *context)
 {
@@ -4087,6 +4684,257 @@ isl_bool isl_set_is_disjoint(__isl_keep isl_set *set1, __isl_keep isl_set *set2)
 	return isl_map_is_disjoint(set1, set2);
 }
 
+/* Can the tableau based tests below be applied to "bset"?
+ * That is, is "bset" integral and does it have no local variables?
+ */
+static isl_bool tab_testable(__isl_keep isl_basic_set *bset)
+{
+	isl_size n_div;
+
+	n_div = isl_basic_set_dim(bset, isl_dim_div);
+	if (n_div < 0)
+		return isl_bool_error;
+	if (n_div != 0)
+		return isl_bool_false;
+	return isl_bool_not(isl_basic_map_is_rational(bset));
+}
+
+/* Is the intersection of "bset" and "context" empty,
+ * given a tableau "tab" representing "context" or NULL
+ * if "context" cannot be represented by a tableau?
+ *
+ * If possible, the constraints of "bset" are added to "tab" and
+ * the tableau is rolled back to its original state afterwards.
+ * If the result is rationally empty, then the intersection is empty.
+ * If the sample value of the tableau is integral, then it is not.
+ * Otherwise, or if the tableau cannot be used,
+ * fall back to isl_basic_set_is_disjoint.
+ */
+static isl_bool tab_intersect_is_empty(struct isl_tab *tab,
+	__isl_keep isl_basic_set *bset, __isl_keep isl_basic_set *context)
+{
+	int i;
+	isl_size total;
+	isl_bool testable, empty, equal;
+	int integer = 0;
+	struct isl_tab_undo *snap;
+
+	testable = tab ? tab_testable(bset) : isl_bool_false;
+	if (testable >= 0 && testable)
+		testable = isl_space_is_equal(bset->dim, context->dim);
+	if (testable < 0)
+		return isl_bool_error;
+	if (!testable)
+		return isl_basic_set_is_disjoint(bset, context);
+	if (tab->empty)
+		return isl_bool_true;
+
+	total = isl_basic_set_dim(bset, isl_dim_all);
+	if (total < 0)
+		return isl_bool_error;
+	snap = isl_tab_snap(tab);
+	if (isl_tab_extend_cons(tab, 2 * bset->n_eq + bset->n_ineq) < 0)
+		return isl_bool_error;
+	for (i = 0; !tab->empty && i < bset->n_eq; ++i) {
+		if (isl_tab_add_ineq(tab, bset->eq[i]) < 0)
+			return isl_bool_error;
+		isl_seq_neg(bset->eq[i], bset->eq[i], 1 + total);
+		equal = isl_bool_ok(isl_tab_add_ineq(tab, bset->eq[i]) >= 0);
+		isl_seq_neg(bset->eq[i], bset->eq[i], 1 + total);
+		if (!equal)
+			return isl_bool_error;
+	}
+	for (i = 0; !tab->empty && i < bset->n_ineq; ++i)
+		if (isl_tab_add_ineq(tab, bset->ineq[i]) < 0)
+			return isl_bool_error;
+	empty = isl_bool_ok(tab->empty);
+	if (!empty)
+		integer = isl_tab_sample_is_integer(tab);
+	if (isl_tab_rollback(tab, snap) < 0 || integer < 0)
+		return isl_bool_error;
+	if (empty)
+		return isl_bool_true;
+	if (integer)
+		return isl_bool_false;
+	return isl_basic_set_is_disjoint(bset, context);
+}
+
+/* Is the intersection of each element of "list" with "context" empty?
+ *
+ * This is equivalent to checking whether each element is disjoint
+ * from "context", but a tableau is constructed only once
+ * for each basic set in "context" and reused for all elements of "list".
+ * Basic sets in "context" that cannot be represented
+ * by a tableau are handled by isl_basic_set_is_disjoint.
+ * Elements of "list" that live in a different space than "context"
+ * are handled by isl_set_is_disjoint.
+ */
+isl_bool isl_set_list_intersect_is_empty(__isl_keep isl_set_list *list,
+	__isl_keep isl_set *context)
+{
+	int i, j, k;
+	isl_size n;
+
+	n = isl_set_list_n_set(list);
+	if (n < 0 || !context)
+		return isl_bool_error;
+
+	for (j = 0; j < context->n; ++j) {
+		isl_basic_set *bset = context->p[j];
+		struct isl_tab *tab = NULL;
+		isl_bool testable, empty = isl_bool_true;
+
+		testable = tab_testable(bset);
+		if (testable < 0)
+			return isl_bool_error;
+		if (testable) {
+			tab = isl_tab_from_basic_set(bset, 0);
+			if (!tab)
+				return isl_bool_error;
+		}
+		for (i = 0; empty == isl_bool_true && i < n; ++i) {
+			isl_set *set = isl_set_list_get_set(list, i);
+			isl_bool equal;
+
+			equal = isl_set_has_equal_space(set, context);
+			if (equal < 0)
+				empty = isl_bool_error;
+			else if (!equal && j == 0)
+				empty = isl_set_is_disjoint(set, context);
+			for (k = 0; equal == isl_bool_true &&
+				    empty == isl_bool_true && k < set->n; ++k)
+				empty = tab_intersect_is_empty(tab,
+							set->p[k], bset);
+			isl_set_free(set);
+		}
+		isl_tab_free(tab);
+		if (empty != isl_bool_true)
+			return empty;
+	}
+
+	return isl_bool_true;
+}
+
+/* Is "bset" a subset of "set", given that "set" consists
+ * of the single basic set "context" without redundant constraints?
+ *
+ * If possible, construct a tableau for "bset" and check
+ * whether all constraints of "context" are valid for "bset".
+ * If so, "bset" is a subset of "set".
+ * Otherwise, fall back to isl_set_is_subset.
+ */
+static isl_bool basic_set_is_subset_of_single(__isl_keep isl_basic_set *bset,
+	__isl_keep isl_basic_set *context, __isl_keep isl_set *set)
+{
+	int i;
+	isl_size total;
+	isl_bool testable, subset;
+	struct isl_tab *tab;
+	isl_set *set1;
+
+	testable = tab_testable(bset);
+	if (testable >= 0 && testable)
+		testable = isl_space_is_equal(bset->dim, context->dim);
+	if (testable < 0)
+		return isl_bool_error;
+	total = isl_basic_set_dim(bset, isl_dim_all);
+	if (total < 0)
+		return isl_bool_error;
+
+	subset = isl_bool_false;
+	if (testable) {
+		tab = isl_tab_from_basic_set(bset, 0);
+		if (!tab)
+			return isl_bool_error;
+		subset = isl_bool_ok(tab->empty);
+		for (i = 0; !subset && i < 2 * context->n_eq + context->n_ineq;
+		     ++i) {
+			isl_int *c;
+			enum isl_ineq_type type;
+
+			if (i >= 2 * context->n_eq)
+				c = context->ineq[i - 2 * context->n_eq];
+			else
+				c = context->eq[i / 2];
+			if (i < 2 * context->n_eq && i % 2 == 1)
+				isl_seq_neg(c, c, 1 + total);
+			type = isl_tab_ineq_type(tab, c);
+			if (i < 2 * context->n_eq && i % 2 == 1)
+				isl_seq_neg(c, c, 1 + total);
+			if (type == isl_ineq_error) {
+				isl_tab_free(tab);
+				return isl_bool_error;
+			}
+			if (type != isl_ineq_redundant)
+				break;
+		}
+		if (i >= 2 * context->n_eq + context->n_ineq)
+			subset = isl_bool_true;
+		isl_tab_free(tab);
+	}
+	if (subset)
+		return subset;
+
+	set1 = isl_set_from_basic_set(isl_basic_set_copy(bset));
+	subset = isl_set_is_subset(set1, set);
+	isl_set_free(set1);
+	return subset;
+}
+
+/* Is each element of "list" a subset of "set"?
+ *
+ * This is equivalent to checking whether each element
+ * is a subset of "set", except that "set" is prepared only once.
+ * In particular, if "set" consists of a single basic set
+ * without local variables, then its redundant constraints are removed
+ * and each element is checked against the remaining constraints
+ * using a tableau for the element.
+ */
+isl_bool isl_basic_set_list_is_subset_of_set(
+	__isl_keep isl_basic_set_list *list, __isl_keep isl_set *set)
+{
+	int i;
+	isl_size n;
+	isl_bool single;
+	isl_basic_set *context = NULL;
+	isl_bool subset = isl_bool_true;
+
+	n = isl_basic_set_list_n_basic_set(list);
+	if (n < 0 || !set)
+		return isl_bool_error;
+
+	single = isl_bool_ok(set->n == 1);
+	if (single)
+		single = tab_testable(set->p[0]);
+	if (single < 0)
+		return isl_bool_error;
+	if (single) {
+		context = isl_basic_set_copy(set->p[0]);
+		context = isl_basic_set_remove_redundancies(context);
+		if (!context)
+			return isl_bool_error;
+	}
+
+	for (i = 0; subset == isl_bool_true && i < n; ++i) {
+		isl_basic_set *bset;
+		isl_set *set1;
+
+		bset = isl_basic_set_list_get_basic_set(list, i);
+		if (context && bset) {
+			subset = basic_set_is_subset_of_single(bset,
+							context, set);
+			isl_basic_set_free(bset);
+			continue;
+		}
+		set1 = isl_set_from_basic_set(bset);
+		subset = isl_set_is_subset(set1, set);
+		isl_set_free(set1);
+	}
+
+	isl_basic_set_free(context);
+	return subset;
+}
+
 /* Is "v" equal to 0, 1 or -1?
  */
 static int is_zero_or_one(isl_int v)
@@ -4930,34 +5778,23 @@ static __isl_give isl_basic_map *fix_cst_lower(__isl_take isl_basic_map *bmap,
 	return isl_basic_map_drop_redundant_divs(bmap);
 }
 
-/* Do any of the integer divisions of "bmap" involve integer division "div"?
+/* Do any of the integer divisions of the basic map with
+ * transposed sparse index "index" with respect to its local variables
+ * involve integer division "div"?
  *
  * The integer division "div" could only ever appear in any later
  * integer division (with an explicit representation).
+ * Since the integer divisions involving "div"
+ * are listed in increasing order, it suffices to look at the last one.
  */
-static isl_bool any_div_involves_div(__isl_keep isl_basic_map *bmap, int div)
+static isl_bool any_div_involves_div(struct isl_basic_map_var_index *index,
+	int div)
 {
-	int i;
-	isl_size v_div, n_div;
-
-	v_div = isl_basic_map_var_offset(bmap, isl_dim_div);
-	n_div = isl_basic_map_dim(bmap, isl_dim_div);
-	if (v_div < 0 || n_div < 0)
-		return isl_bool_error;
-
-	for (i = div + 1; i < n_div; ++i) {
-		isl_bool unknown;
+	int end = index->div_start[div + 1];
 
-		unknown = isl_basic_map_div_is_marked_unknown(bmap, i);
-		if (unknown < 0)
-			return isl_bool_error;
-		if (unknown)
-			continue;
-		if (!isl_int_is_zero(bmap->div[i][1 + 1 + v_div + div]))
-			return isl_bool_true;
-	}
-
-	return isl_bool_false;
+	if (end == index->div_start[div])
+		return isl_bool_false;
+	return isl_bool_ok(index->div[end - 1] > div);
 }
 
 /* Remove divs that are not strictly needed based on the inequality
@@ -5001,6 +5838,11 @@ static isl_bool any_div_involves_div(__isl_keep isl_basic_map *bmap, int div)
  *
  * If any divs are left after these simple checks then we move on
  * to more complicated cases in drop_more_redundant_divs.
+ *
+ * The constraints involving a given div are looked up
+ * in a transposed sparse index of the constraints with respect
+ * to the divs.  Since "bmap" is only modified right before returning,
+ * this index only needs to be computed once.
  */
 static __isl_give isl_basic_map *isl_basic_map_drop_redundant_divs_ineq(
 	__isl_take isl_basic_map *bmap)
@@ -5010,6 +5852,7 @@ static __isl_give isl_basic_map *isl_basic_map_drop_redundant_divs_ineq(
 	int *pairs = NULL;
 	int n = 0;
 	isl_size n_ineq;
+	struct isl_basic_map_var_index *index;
 
 	if (!bmap)
 		goto error;
@@ -5026,6 +5869,9 @@ static __isl_give isl_basic_map *isl_basic_map_drop_redundant_divs_ineq(
 	n_ineq = isl_basic_map_n_inequality(bmap);
 	if (n_ineq < 0)
 		goto error;
+	index = isl_basic_map_var_index_alloc(bmap, off, bmap->n_div);
+	if (!index)
+		goto error;
 	for (i = 0; i < bmap->n_div; ++i) {
 		int pos, neg;
 		int last_pos, last_neg;
@@ -5034,33 +5880,34 @@ static __isl_give isl_basic_map *isl_basic_map_drop_redundant_divs_ineq(
 		isl_bool involves, opp, set_div;
 
 		defined = !isl_int_is_zero(bmap->div[i][0]);
-		involves = any_div_involves_div(bmap, i);
+		involves = any_div_involves_div(index, i);
 		if (involves < 0)
-			goto error;
+			goto error_index;
 		if (involves)
 			continue;
-		for (j = 0; j < bmap->n_eq; ++j)
-			if (!isl_int_is_zero(bmap->eq[j][1 + off + i]))
-				break;
-		if (j < bmap->n_eq)
+		if (index->eq_start[i + 1] > index->eq_start[i])
 			continue;
 		++n;
 		pos = neg = 0;
-		for (j = 0; j < bmap->n_ineq; ++j) {
-			if (isl_int_is_pos(bmap->ineq[j][1 + off + i])) {
-				last_pos = j;
+		for (j = index->ineq_start[i]; j < index->ineq_start[i + 1];
+		     ++j) {
+			int k = index->ineq[j];
+
+			if (isl_int_is_pos(bmap->ineq[k][1 + off + i])) {
+				last_pos = k;
 				++pos;
-			}
-			if (isl_int_is_neg(bmap->ineq[j][1 + off + i])) {
-				last_neg = j;
+			} else {
+				last_neg = k;
 				++neg;
 			}
 		}
 		pairs[i] = pos * neg;
 		if (pairs[i] == 0) {
-			for (j = bmap->n_ineq - 1; j >= 0; --j)
-				if (!isl_int_is_zero(bmap->ineq[j][1+off+i]))
-					isl_basic_map_drop_inequality(bmap, j);
+			for (j = index->ineq_start[i + 1] - 1;
+			     j >= index->ineq_start[i]; --j)
+				isl_basic_map_drop_inequality(bmap,
+							    index->ineq[j]);
+			isl_basic_map_var_index_free(index);
 			bmap = isl_basic_map_drop_div(bmap, i);
 			return drop_redundant_divs_again(bmap, pairs, 0);
 		}
@@ -5069,7 +5916,7 @@ static __isl_give isl_basic_map *isl_basic_map_drop_redundant_divs_ineq(
 		else
 			opp = is_opposite(bmap, last_pos, last_neg);
 		if (opp < 0)
-			goto error;
+			goto error_index;
 		if (!opp) {
 			int lower;
 			isl_bool single, one;
@@ -5078,21 +5925,25 @@ static __isl_give isl_basic_map *isl_basic_map_drop_redundant_divs_ineq(
 				continue;
 			single = single_unknown(bmap, last_pos, i);
 			if (single < 0)
-				goto error;
+				goto error_index;
 			if (!single)
 				continue;
 			one = has_coef_one(bmap, i, last_pos);
 			if (one < 0)
-				goto error;
-			if (one)
+				goto error_index;
+			if (one) {
+				isl_basic_map_var_index_free(index);
 				return set_eq_and_try_again(bmap, last_pos,
 							    pairs);
+			}
 			lower = lower_bound_is_cst(bmap, i, last_pos);
 			if (lower < 0)
-				goto error;
-			if (lower < n_ineq)
+				goto error_index;
+			if (lower < n_ineq) {
+				isl_basic_map_var_index_free(index);
 				return fix_cst_lower(bmap, i, last_pos, lower,
 						pairs);
+			}
 			continue;
 		}
 
@@ -5106,28 +5957,34 @@ static __isl_give isl_basic_map *isl_basic_map_drop_redundant_divs_ineq(
 			       bmap->ineq[last_pos][0], 1);
 		isl_int_sub(bmap->ineq[last_pos][0],
 			    bmap->ineq[last_pos][0], bmap->ineq[last_neg][0]);
-		if (redundant)
+		if (redundant) {
+			isl_basic_map_var_index_free(index);
 			return drop_div_and_try_again(bmap, i,
 						    last_pos, last_neg, pairs);
+		}
 		if (defined)
 			set_div = isl_bool_false;
 		else
 			set_div = ok_to_set_div_from_bound(bmap, i, last_pos);
 		if (set_div < 0)
-			return isl_basic_map_free(bmap);
+			goto error_index;
 		if (set_div) {
+			isl_basic_map_var_index_free(index);
 			bmap = set_div_from_lower_bound(bmap, i, last_pos);
 			return drop_redundant_divs_again(bmap, pairs, 1);
 		}
 		pairs[i] = 0;
 		--n;
 	}
+	isl_basic_map_var_index_free(index);
 
 	if (n > 0)
 		return coalesce_or_drop_more_redundant_divs(bmap, pairs, n);
 
 	free(pairs);
 	return bmap;
+error_index:
+	isl_basic_map_var_index_free(index);
 error:
 	free(pairs);
 	isl_basic_map_free(bmap);
@@ -5539,6 +6396,7 @@ __isl_give isl_basic_map *isl_basic_map_shift_div(
 		isl_int_submul(bmap->div[i][1 + pos],
 				shift, bmap->div[i][1 + 1 + total + div]);
 	}
+	ISL_F_CLR(bmap, ISL_BASIC_MAP_SIMPLIFIED);
 
 	return bmap;
 }
@@ -221,13 +221,13 @@ error:
 	return isl_stat_error;
 }
 
-/* Freeze all constraints of tableau tab.
+/* Freeze all constraints of tableau tab, starting at position "first".
  */
-static int tab_freeze_constraints(struct isl_tab *tab)
+static int tab_freeze_constraints(struct isl_tab *tab, int first)
 {
 	int i;
 
-	for (i = 0; i < tab->n_con; ++i)
+	for (i = first; i < tab->n_con; ++i)
 		if (isl_tab_freeze_constraint(tab, i) < 0)
 			return -1;
 
@@ -304,6 +304,16 @@ struct isl_diff_collector {
  * and if so, pass it along to dc->add.  As a special case, if nothing
  * has been removed when we end up in a leaf, we simply pass along
  * the original basic map.
+ *
+ * The constraints of the current piece need to be frozen before
+ * the non-redundant constraints of a basic map in "map" are determined.
+ * Most basic maps in "map" are typically disjoint from the current piece,
+ * so the constraints of the current piece are frozen before
+ * the snapshot that is restored when it turns out that a basic map
+ * does not intersect the current piece.
+ * This way, they do not need to be frozen again for every basic map
+ * and only the constraints added for the local variables of
+ * the basic map need to be frozen after the snapshot.
  */
 static isl_stat basic_map_collect_diff(__isl_take isl_basic_map *bmap,
 	__isl_take isl_map *map, struct isl_diff_collector *dc)
@@ -380,15 +390,18 @@ static isl_stat basic_map_collect_diff(__isl_take isl_basic_map *bmap,
 			continue;
 		}
 		if (init) {
-			int offset;
+			int offset, n_con;
 			struct isl_tab_undo *snap2;
+			if (tab_freeze_constraints(tab, 0) < 0)
+				goto error;
 			snap2 = isl_tab_snap(tab);
+			n_con = tab->n_con;
 			if (tab_add_divs(tab, map->p[level],
 					 &div_map[level]) < 0)
 				goto error;
 			offset = tab->n_con;
 			snap[level] = isl_tab_snap(tab);
-			if (tab_freeze_constraints(tab) < 0)
+			if (tab_freeze_constraints(tab, n_con) < 0)
 				goto error;
 			if (tab_add_constraints(tab, map->p[level],
 						div_map[level]) < 0)
@@ -859,6 +872,10 @@ static isl_bool map_is_subset(__isl_keep isl_map *map1,
 	if (isl_map_plain_is_universe(map2))
 		return isl_bool_true;
 
+	is_subset = isl_map_plain_is_subset(map1, map2);
+	if (is_subset < 0 || is_subset)
+		return is_subset;
+
 	single = isl_map_plain_is_singleton(map1);
 	if (single < 0)
 		return isl_bool_error;
@@ -885,9 +902,21 @@ isl_bool isl_set_is_subset(__isl_keep isl_set *set1, __isl_keep isl_set *set2)
 	return isl_map_is_subset(set_to_map(set1), set_to_map(set2));
 }
 
+/* Return a map that is equal to "map", but with disjoint basic maps.
+ *
+ * Each basic map is replaced by its difference with
+ * the previous basic maps.
+ * Note that the union of the previous basic maps is equal to
+ * the union of the pieces that have been collected so far,
+ * but the previous basic maps are typically much fewer
+ * in number than these pieces.  Subtracting them instead of
+ * the collected pieces therefore results in fewer cuts
+ * and in fewer pieces in the final result.
+ */
 __isl_give isl_map *isl_map_make_disjoint(__isl_take isl_map *map)
 {
 	int i;
+	isl_map *prefix;
 	struct isl_subtract_diff_collector sdc;
 	sdc.dc.add = &basic_map_subtract_add;
 
@@ -905,17 +934,24 @@ __isl_give isl_map *isl_map_make_disjoint(__isl_take isl_map *map)
 		return map;
 
 	sdc.diff = isl_map_from_basic_map(isl_basic_map_copy(map->p[0]));
+	prefix = isl_map_alloc_space(isl_map_get_space(map), map->n - 1, 0);
 
 	for (i = 1; i < map->n; ++i) {
 		struct isl_basic_map *bmap = isl_basic_map_copy(map->p[i]);
-		struct isl_map *copy = isl_map_copy(sdc.diff);
-		if (basic_map_collect_diff(bmap, copy, &sdc.dc) < 0) {
+		prefix = isl_map_add_basic_map(prefix,
+					isl_basic_map_copy(map->p[i - 1]));
+		if (!prefix ||
+		    basic_map_collect_diff(bmap, isl_map_copy(prefix),
+					    &sdc.dc) < 0) {
+			if (!prefix)
+				isl_basic_map_free(bmap);
 			isl_map_free(sdc.diff);
 			sdc.diff = NULL;
 			break;
 		}
 	}
 
+	isl_map_free(prefix);
 	isl_map_free(map);
 
 	return sdc.diff;
@@ -223,6 +223,27 @@ __isl_give isl_mat *isl_mat_dup(__isl_keep isl_mat *mat)
 	return mat2;
 }
 
+/* Return a copy of "mat" in "ctx".
+ * Unless "mat" already belongs to "ctx", "mat" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_mat *isl_mat_copy_to_ctx(__isl_keep isl_mat *mat, isl_ctx *ctx)
+{
+	int i;
+	struct isl_mat *mat2;
+
+	if (!mat)
+		return NULL;
+	if (mat->ctx == ctx)
+		return isl_mat_copy(mat);
+	mat2 = isl_mat_alloc(ctx, mat->n_row, mat->n_col);
+	if (!mat2)
+		return NULL;
+	for (i = 0; i < mat->n_row; ++i)
+		isl_seq_cpy(mat2->row[i], mat->row[i], mat->n_col);
+	return mat2;
+}
+
 __isl_give isl_mat *isl_mat_cow(__isl_take isl_mat *mat)
 {
 	struct isl_mat *mat2;
@@ -365,6 +386,57 @@ __isl_give isl_mat *isl_mat_set_element_si(__isl_take isl_mat *mat,
 	return mat;
 }
 
+/* Store the elements of "mat" in "data" in row-major order.
+ * "data" is assumed to have room for all elements of "mat".
+ * Return an error if any of the elements does not fit in a long.
+ */
+isl_stat isl_mat_get_elements_si(__isl_keep isl_mat *mat, long *data)
+{
+	int i, j;
+
+	if (!mat)
+		return isl_stat_error;
+	if (!data && mat->n_row * mat->n_col != 0)
+		isl_die(isl_mat_get_ctx(mat), isl_error_invalid,
+			"invalid buffer", return isl_stat_error);
+
+	for (i = 0; i < mat->n_row; ++i) {
+		for (j = 0; j < mat->n_col; ++j) {
+			if (!isl_int_fits_slong(mat->row[i][j]))
+				isl_die(isl_mat_get_ctx(mat), isl_error_invalid,
+					"element does not fit in a long",
+					return isl_stat_error);
+			*data++ = isl_int_get_si(mat->row[i][j]);
+		}
+	}
+
+	return isl_stat_ok;
+}
+
+/* Construct an "n_row" by "n_col" matrix with elements
+ * read from "data" in row-major order.
+ */
+__isl_give isl_mat *isl_mat_from_elements_si(isl_ctx *ctx,
+	unsigned n_row, unsigned n_col, const long *data)
+{
+	int i, j;
+	isl_mat *mat;
+
+	if (!data && n_row * n_col != 0)
+		isl_die(ctx, isl_error_invalid,
+			"invalid buffer", return NULL);
+
+	mat = isl_mat_alloc(ctx, n_row, n_col);
+	if (!mat)
+		return NULL;
+
+	for (i = 0; i < n_row; ++i)
+		for (j = 0; j < n_col; ++j)
+			isl_int_set_si(mat->row[i][j], *data++);
+
+	return mat;
+}
+
 /* Replace the element at row "row", column "col" of "mat" by "v".
  */
 __isl_give isl_mat *isl_mat_set_element_val(__isl_take isl_mat *mat,
@@ -626,6 +698,225 @@ static void oppose(__isl_keep isl_mat *M, __isl_keep isl_mat **U,
 		isl_seq_neg((*Q)->row[col], (*Q)->row[col], (*Q)->n_col);
 }
 
+/* The minimal number of rows of a matrix for which isl_mat_left_hermite
+ * computes the Hermite normal form using modular arithmetic
+ * if neither of the unimodular matrices is requested.
+ */
+#define ISL_MAT_MODULAR_HERMITE_MIN_ROWS	12
+
+/* Compute the absolute value of the determinant of a non-singular
+ * square submatrix of "M", consisting of M->n_row of its columns, in "det".
+ * Return isl_bool_false if there is no such submatrix,
+ * i.e., if "M" does not have full row rank.
+ *
+ * The determinant is computed using fraction-free (Bareiss) elimination
+ * on a copy of "M", with a column exchange whenever the pivot is zero.
+ * Every intermediate entry is a minor of "M", which limits
+ * the growth of the coefficients.
+ */
+static isl_bool full_row_rank_minor(__isl_keep isl_mat *M, isl_int *det)
+{
+	int i, j, k;
+	isl_mat *A;
+	isl_int prev, tmp;
+	isl_bool full = isl_bool_true;
+
+	A = isl_mat_dup(M);
+	if (!A)
+		return isl_bool_error;
+
+	isl_int_init(prev);
+	isl_int_init(tmp);
+	isl_int_set_si(prev, 1);
+	for (k = 0; k < A->n_row; ++k) {
+		int pivot;
+
+		pivot = isl_seq_first_non_zero(A->row[k] + k, A->n_col - k);
+		if (pivot < 0) {
+			full = isl_bool_false;
+			break;
+		}
+		pivot += k;
+		if (pivot != k)
+			for (i = k; i < A->n_row; ++i)
+				isl_int_swap(A->row[i][k], A->row[i][pivot]);
+		for (i = k + 1; i < A->n_row; ++i) {
+			for (j = k + 1; j < A->n_col; ++j) {
+				isl_int_mul(tmp, A->row[k][k], A->row[i][j]);
+				isl_int_submul(tmp, A->row[i][k], A->row[k][j]);
+				isl_int_divexact(A->row[i][j], tmp, prev);
+			}
+		}
+		isl_int_set(prev, A->row[k][k]);
+	}
+	if (full)
+		isl_int_abs(*det, prev);
+	isl_int_clear(tmp);
+	isl_int_clear(prev);
+
+	isl_mat_free(A);
+	return full;
+}
+
+/* Replace column "j" of "M" by "a" times column "j" plus "b" times
+ * column "k" and column "k" by "c" times column "j" plus "d" times
+ * column "k", in the rows starting at "row", with all entries
+ * taken modulo "R".
+ */
+static void col_transform_mod(__isl_keep isl_mat *M, int row, int j, int k,
+	isl_int a, isl_int b, isl_int c, isl_int d, isl_int R, isl_int tmp)
+{
+	int r;
+
+	for (r = row; r < M->n_row; ++r) {
+		isl_int_mul(tmp, c, M->row[r][j]);
+		isl_int_addmul(tmp, d, M->row[r][k]);
+		isl_int_mul(M->row[r][j], a, M->row[r][j]);
+		isl_int_addmul(M->row[r][j], b, M->row[r][k]);
+		isl_int_fdiv_r(M->row[r][j], M->row[r][j], R);
+		isl_int_fdiv_r(M->row[r][k], tmp, R);
+	}
+}
+
+/* Compute the Hermite normal form H of "M" as in isl_mat_left_hermite,
+ * without computing the unimodular matrices, provided "M"
+ * has full row rank.  Return isl_bool_false if it does not,
+ * in which case "M" is left untouched.
+ * "M" is assumed not to be shared.
+ *
+ * The columns of a matrix with full row rank generate a lattice
+ * that contains D Z^n, with n the number of rows and
+ * D the absolute value of the determinant of any non-singular
+ * square submatrix.  The Hermite normal form can then be computed
+ * with all entries reduced modulo (a divisor of) D,
+ * as described in Algorithm 2.4.8 of Henri Cohen,
+ * "A Course in Computational Algebraic Number Theory",
+ * adapted to the lower triangular form computed by isl_mat_left_hermite.
+ * This avoids the potentially exponential coefficient growth
+ * in the intermediate results of the exact computation.
+ *
+ * In particular, for each row "row", the entries in the columns
+ * after "row" are eliminated using extended gcd computations,
+ * keeping only the rows starting at "row" since the earlier rows
+ * of these columns are (congruent to) zero.
+ * The result column "row" is then obtained from the gcd of the entry
+ * in column "row" and the current modulus "R", after which
+ * the earlier result columns are reduced such that their entries
+ * on this row are non-negative (or non-positive if "neg" is set)
+ * and strictly smaller in absolute value than the diagonal entry.
+ * Finally, the modulus is divided by the diagonal entry.
+ * Since the Hermite normal form of a matrix with full row rank
+ * is unique, the result is the same as that of the exact computation.
+ */
+static isl_bool left_hermite_modular(__isl_keep isl_mat *M, int neg)
+{
+	int i, j, row;
+	isl_bool full;
+	isl_mat *W;
+	isl_int R, a, b, c, d, g, tmp;
+
+	if (M->n_row > M->n_col)
+		return isl_bool_false;
+
+	isl_int_init(R);
+	full = full_row_rank_minor(M, &R);
+	if (full < 0 || !full) {
+		isl_int_clear(R);
+		return full;
+	}
+
+	W = isl_mat_alloc(M->ctx, M->n_row, M->n_row);
+	if (!W) {
+		isl_int_clear(R);
+		return isl_bool_error;
+	}
+	isl_seq_clr(W->block.data, W->n_row * W->n_col);
+
+	isl_int_init(a);
+	isl_int_init(b);
+	isl_int_init(c);
+	isl_int_init(d);
+	isl_int_init(g);
+	isl_int_init(tmp);
+	for (i = 0; i < M->n_row; ++i)
+		for (j = 0; j < M->n_col; ++j)
+			isl_int_fdiv_r(M->row[i][j], M->row[i][j], R);
+
+	for (row = 0; row < M->n_row; ++row) {
+		if (isl_int_is_zero(M->row[row][row]))
+			isl_int_set(M->row[row][row], R);
+		for (j = row + 1; j < M->n_col; ++j) {
+			if (isl_int_is_zero(M->row[row][j]))
+				continue;
+			isl_int_gcdext(&g, &c, &d,
+					M->row[row][row], M->row[row][j]);
+			isl_int_divexact(a, M->row[row][row], g);
+			isl_int_divexact(b, M->row[row][j], g);
+			isl_int_neg(b, b);
+			col_transform_mod(M, row, j, row, a, b, d, c, R, tmp);
+		}
+		isl_int_gcdext(&g, &a, &b, M->row[row][row], R);
+		for (i = row; i < M->n_row; ++i) {
+			isl_int_mul(W->row[i][row], a, M->row[i][row]);
+			isl_int_fdiv_r(W->row[i][row], W->row[i][row], R);
+		}
+		if (isl_int_is_zero(W->row[row][row]))
+			isl_int_set(W->row[row][row], R);
+		for (j = 0; j < row; ++j) {
+			if (neg)
+				isl_int_cdiv_q(c, W->row[row][j],
+						W->row[row][row]);
+			else
+				isl_int_fdiv_q(c, W->row[row][j],
+						W->row[row][row]);
+			if (isl_int_is_zero(c))
+				continue;
+			isl_int_submul(W->row[row][j], c, W->row[row][row]);
+			for (i = row + 1; i < M->n_row; ++i) {
+				isl_int_submul(W->row[i][j], c, W->row[i][row]);
+				isl_int_fdiv_r(W->row[i][j], W->row[i][j], R);
+			}
+		}
+		isl_int_divexact(R, R, W->row[row][row]);
+	}
+
+	for (i = 0; i < M->n_row; ++i) {
+		isl_seq_cpy(M->row[i], W->row[i], W->n_col);
+		isl_seq_clr(M->row[i] + W->n_col, M->n_col - W->n_col);
+	}
+
+	isl_int_clear(tmp);
+	isl_int_clear(g);
+	isl_int_clear(d);
+	isl_int_clear(c);
+	isl_int_clear(b);
+	isl_int_clear(a);
+	isl_int_clear(R);
+	isl_mat_free(W);
+
+	return isl_bool_true;
+}
+
+/* Compute the Hermite normal form of "M" as in isl_mat_left_hermite,
+ * without computing the unimodular matrices,
+ * using modular arithmetic if "M" has full row rank.
+ */
+__isl_give isl_mat *isl_mat_left_hermite_modular(__isl_take isl_mat *M,
+	int neg)
+{
+	isl_bool done;
+
+	M = isl_mat_cow(M);
+	if (!M)
+		return NULL;
+	done = left_hermite_modular(M, neg);
+	if (done < 0)
+		return isl_mat_free(M);
+	if (done)
+		return M;
+	return isl_mat_left_hermite(M, neg, NULL, NULL);
+}
+
 /* Given matrix M, compute
  *
  *		M U = H
@@ -637,6 +928,8 @@ static void oppose(__isl_keep isl_mat *M, __isl_keep isl_mat **U,
  * and strictly smaller (in absolute value) than the entries in the echelon
  * column.
  * If U or Q are NULL, then these matrices are not computed.
+ * If neither of them is requested and "M" has sufficiently many rows,
+ * then H is computed using modular arithmetic if possible.
  */
 __isl_give isl_mat *isl_mat_left_hermite(__isl_take isl_mat *M, int neg,
 	__isl_give isl_mat **U, __isl_give isl_mat **Q)
@@ -668,6 +961,16 @@ __isl_give isl_mat *isl_mat_left_hermite(__isl_take isl_mat *M, int neg,
 	if (!M)
 		goto error;
 
+	if (!U && !Q && M->n_row >= ISL_MAT_MODULAR_HERMITE_MIN_ROWS) {
+		isl_bool done;
+
+		done = left_hermite_modular(M, neg);
+		if (done < 0)
+			goto error;
+		if (done)
+			return M;
+	}
+
 	col = 0;
 	isl_int_init(c);
 	for (row = 0; row < M->n_row; ++row) {
@@ -1399,6 +1702,7 @@ __isl_give isl_basic_set *isl_basic_set_preimage(
 	ISL_F_CLR(bset, ISL_BASIC_SET_NO_IMPLICIT);
 	ISL_F_CLR(bset, ISL_BASIC_SET_NO_REDUNDANT);
 	ISL_F_CLR(bset, ISL_BASIC_SET_SORTED);
+	ISL_F_CLR(bset, ISL_BASIC_SET_SIMPLIFIED);
 	ISL_F_CLR(bset, ISL_BASIC_SET_NORMALIZED_DIVS);
 	ISL_F_CLR(bset, ISL_BASIC_SET_ALL_EQUALITIES);
 
@@ -1802,6 +2106,8 @@ isl_bool isl_mat_is_equal(__isl_keep isl_mat *mat1, __isl_keep isl_mat *mat2)
 
 	if (!mat1 || !mat2)
 		return isl_bool_error;
+	if (mat1 == mat2)
+		return isl_bool_true;
 
 	if (mat1->n_row != mat2->n_row)
 		return isl_bool_false;
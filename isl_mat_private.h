@@ -27,6 +27,7 @@ uint32_t isl_mat_get_hash(__isl_keep isl_mat *mat);
 
 __isl_give isl_mat *isl_mat_zero(isl_ctx *ctx, unsigned n_row, unsigned n_col);
 __isl_give isl_mat *isl_mat_dup(__isl_keep isl_mat *mat);
+__isl_give isl_mat *isl_mat_copy_to_ctx(__isl_keep isl_mat *mat, isl_ctx *ctx);
 __isl_give isl_mat *isl_mat_cow(__isl_take isl_mat *mat);
 __isl_give isl_mat *isl_mat_sub_alloc(__isl_keep isl_mat *mat,
 	unsigned first_row, unsigned n_row, unsigned first_col, unsigned n_col);
@@ -40,6 +41,8 @@ isl_stat isl_mat_sub_transform(isl_int **row, unsigned n_row,
 	unsigned first_col, __isl_take isl_mat *mat);
 __isl_give isl_mat *isl_mat_diag(isl_ctx *ctx, unsigned n_row, isl_int d);
 
+__isl_give isl_mat *isl_mat_left_hermite_modular(__isl_take isl_mat *M,
+	int neg);
 __isl_give isl_mat *isl_mat_reverse_gauss(__isl_take isl_mat *mat);
 
 __isl_give isl_mat *isl_mat_scale(__isl_take isl_mat *mat, isl_int m);
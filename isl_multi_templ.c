@@ -76,6 +76,12 @@ error:
 	return NULL;
 }
 
+/* Return a copy of "multi" that has only a single reference.
+ *
+ * The base expressions of "multi" are known to be compatible
+ * with its space, so they are copied over directly,
+ * without going through isl_multi_*_set_at and its checks.
+ */
 __isl_give MULTI(BASE) *FN(MULTI(BASE),dup)(__isl_keep MULTI(BASE) *multi)
 {
 	int i;
@@ -88,9 +94,11 @@ __isl_give MULTI(BASE) *FN(MULTI(BASE),dup)(__isl_keep MULTI(BASE) *multi)
 	if (!dup)
 		return NULL;
 
-	for (i = 0; i < multi->n; ++i)
-		dup = FN(FN(MULTI(BASE),set),BASE)(dup, i,
-						    FN(EL,copy)(multi->u.p[i]));
+	for (i = 0; i < multi->n; ++i) {
+		dup->u.p[i] = FN(EL,copy)(multi->u.p[i]);
+		if (!dup->u.p[i])
+			return FN(MULTI(BASE),free)(dup);
+	}
 	if (FN(MULTI(BASE),has_explicit_domain)(multi))
 		dup = FN(MULTI(BASE),copy_explicit_domain)(dup, multi);
 
@@ -646,6 +654,12 @@ static
  *
  * If "multi1" and/or "multi2" has an explicit domain, then
  * intersect the domain of the result with these explicit domains.
+ *
+ * The parameters of the inputs have been aligned, so
+ * only the domains of the base expressions need to be checked
+ * against that of the result.  The base expressions are taken
+ * from the inputs such that they are not copied
+ * if the inputs have only a single reference.
  */
 __isl_give MULTI(BASE) *FN(MULTI(BASE),range_product)(
 	__isl_take MULTI(BASE) *multi1, __isl_take MULTI(BASE) *multi2)
@@ -667,13 +681,13 @@ __isl_give MULTI(BASE) *FN(MULTI(BASE),range_product)(
 	res = FN(MULTI(BASE),alloc)(space);
 
 	for (i = 0; i < n1; ++i) {
-		el = FN(FN(MULTI(BASE),get),BASE)(multi1, i);
-		res = FN(FN(MULTI(BASE),set),BASE)(res, i, el);
+		el = FN(MULTI(BASE),take_at)(multi1, i);
+		res = FN(MULTI(BASE),restore_check_space)(res, i, el);
 	}
 
 	for (i = 0; i < n2; ++i) {
-		el = FN(FN(MULTI(BASE),get),BASE)(multi2, i);
-		res = FN(FN(MULTI(BASE),set),BASE)(res, n1 + i, el);
+		el = FN(MULTI(BASE),take_at)(multi2, i);
+		res = FN(MULTI(BASE),restore_check_space)(res, n1 + i, el);
 	}
 
 	if (FN(MULTI(BASE),has_explicit_domain)(multi1))
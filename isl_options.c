@@ -102,6 +102,20 @@ static struct isl_arg_choice separation_bounds[] = {
 	{0}
 };
 
+static struct isl_arg_choice project_out[] = {
+	{"auto",	ISL_PROJECT_OUT_AUTO},
+	{"div",		ISL_PROJECT_OUT_DIV},
+	{"fm",		ISL_PROJECT_OUT_FM},
+	{0}
+};
+
+static struct isl_arg_choice ast_build_quality[] = {
+	{"full",	ISL_AST_BUILD_QUALITY_FULL},
+	{"limited",	ISL_AST_BUILD_QUALITY_LIMITED},
+	{"atomic",	ISL_AST_BUILD_QUALITY_ATOMIC},
+	{0}
+};
+
 static void print_version(void)
 {
 	printf("%s", isl_version());
@@ -117,10 +131,24 @@ ISL_ARG_CHOICE(struct isl_options, gbr, 0, "gbr", \
 ISL_ARG_CHOICE(struct isl_options, closure, 0, "closure", \
 	isl_closure_choice,	ISL_CLOSURE_ISL,
 	"closure operation to use")
+ISL_ARG_INT(struct isl_options, closure_budget, 0, "closure-budget",
+	"operations", 0,
+	"maximal number of operations for computing an exact transitive closure")
+ISL_ARG_INT(struct isl_options, closure_threads, 0, "closure-threads", "n", 0,
+	"maximal number of threads used for computing transitive closures")
 ISL_ARG_BOOL(struct isl_options, gbr_only_first, 0, "gbr-only-first", 0,
 	"only perform basis reduction in first direction")
+ISL_ARG_INT(struct isl_options, gbr_threads, 0, "gbr-threads", "n", 0,
+	"maximal number of threads used for basis reduction")
+ISL_ARG_INT(struct isl_options, threads, 0, "threads", "n", 0,
+	"maximal number of threads used by operations "
+	"without a specific thread option")
 ISL_ARG_CHOICE(struct isl_options, bound, 0, "bound", bound,
 	ISL_BOUND_BERNSTEIN, "algorithm to use for computing bounds")
+ISL_ARG_INT(struct isl_options, bound_threads, 0, "bound-threads", "n", 0,
+	"maximal number of threads used for computing bounds")
+ISL_ARG_INT(struct isl_options, scan_threads, 0, "scan-threads", "n", 0,
+	"maximal number of threads used for counting integer points")
 ISL_ARG_CHOICE(struct isl_options, on_error, 0, "on-error", on_error,
 	ISL_ON_ERROR_WARN, "how to react if an error is detected")
 ISL_ARG_FLAGS(struct isl_options, bernstein_recurse, 0,
@@ -128,15 +156,32 @@ ISL_ARG_FLAGS(struct isl_options, bernstein_recurse, 0,
 ISL_ARG_BOOL(struct isl_options, bernstein_triangulate, 0,
 	"bernstein-triangulate", 1,
 	"triangulate domains during Bernstein expansion")
+ISL_ARG_INT(struct isl_options, bernstein_threads, 0, "bernstein-threads",
+	"n", 0, "maximal number of threads used for bernstein expansion")
 ISL_ARG_BOOL(struct isl_options, pip_symmetry, 0, "pip-symmetry", 1,
 	"detect simple symmetries in PIP input")
+ISL_ARG_INT(struct isl_options, pip_threads, 0, "pip-threads", "n", 0,
+	"maximal number of threads used for solving a PIP problem")
 ISL_ARG_CHOICE(struct isl_options, convex, 0, "convex-hull", \
 	convex,	ISL_CONVEX_HULL_WRAP, "convex hull algorithm to use")
+ISL_ARG_INT(struct isl_options, convex_hull_threads, 0, "convex-hull-threads",
+	"n", 0, "maximal number of threads used for computing convex hulls")
+ISL_ARG_INT(struct isl_options, convex_hull_max_facets, 0,
+	"convex-hull-max-facets", "n", 0,
+	"stop computing a convex hull after finding this many facets")
 ISL_ARG_BOOL(struct isl_options, coalesce_bounded_wrapping, 0,
 	"coalesce-bounded-wrapping", 1, "bound wrapping during coalescing")
 ISL_ARG_BOOL(struct isl_options, coalesce_preserve_locals, 0,
 	"coalesce-preserve-locals", 0,
 	"preserve local variables during coalescing")
+ISL_ARG_INT(struct isl_options, coalesce_threads, 0, "coalesce-threads", "n",
+	0, "maximal number of threads used for coalescing")
+ISL_ARG_INT(struct isl_options, union_map_threads, 0, "union-map-threads",
+	"n", 0, "maximal number of threads used for operations on union maps")
+ISL_ARG_INT(struct isl_options, flow_threads, 0, "flow-threads",
+	"n", 0, "maximal number of threads used for dataflow analysis")
+ISL_ARG_INT(struct isl_options, flow_cache_size, 0, "flow-cache-size",
+	"size", 0, "number of dataflow analyses to remember per isl_ctx")
 ISL_ARG_INT(struct isl_options, schedule_max_coefficient, 0,
 	"schedule-max-coefficient", "limit", -1, "Only consider schedules "
 	"where the coefficients of the variable and parameter dimensions "
@@ -172,11 +217,24 @@ ISL_ARG_BOOL(struct isl_options, schedule_whole_component, 0,
 ISL_ARG_CHOICE(struct isl_options, schedule_algorithm, 0,
 	"schedule-algorithm", isl_schedule_algorithm_choice,
 	ISL_SCHEDULE_ALGORITHM_ISL, "scheduling algorithm to use")
+ISL_ARG_INT(struct isl_options, schedule_budget, 0,
+	"schedule-budget", "operations", 0,
+	"maximal number of operations spent on computing a schedule "
+	"before falling back to Feautrier's algorithm")
 ISL_ARG_BOOL(struct isl_options, schedule_carry_self_first, 0,
 	"schedule-carry-self-first", 1, "try and carry self-dependences first")
 ISL_ARG_BOOL(struct isl_options, schedule_serialize_sccs, 0,
 	"schedule-serialize-sccs", 0,
 	"serialize strongly connected components in dependence graph")
+ISL_ARG_INT(struct isl_options, schedule_threads, 0, "schedule-threads",
+	"n", 0, "maximal number of threads used for scheduling "
+	"weakly connected components")
+ISL_ARG_INT(struct isl_options, schedule_coefficients_threads, 0,
+	"schedule-coefficients-threads", "n", 0,
+	"maximal number of threads used for computing the coefficients "
+	"of valid constraints on dependence relations during scheduling")
+ISL_ARG_BOOL(struct isl_options, schedule_trace, 0, "schedule-trace", 0,
+	"print a trace of the phases of the scheduler")
 ISL_ARG_PHANTOM_USER_CHOICE_F(0, "schedule-fuse", fuse, &set_fuse,
 	ISL_SCHEDULE_FUSE_MAX, "level of fusion during scheduling",
 	ISL_ARG_HIDDEN)
@@ -217,10 +275,47 @@ ISL_ARG_BOOL(struct isl_options, ast_build_allow_else, 0,
 	"ast-build-allow-else", 1, "generate if statements with else branches")
 ISL_ARG_BOOL(struct isl_options, ast_build_allow_or, 0,
 	"ast-build-allow-or", 1, "generate if conditions with disjunctions")
+ISL_ARG_CHOICE(struct isl_options, ast_build_quality, 0,
+	"ast-build-quality", ast_build_quality, ISL_AST_BUILD_QUALITY_FULL,
+	"quality of the generated loops")
+ISL_ARG_INT(struct isl_options, ast_build_component_budget, 0,
+	"ast-build-component-budget", "operations", 0,
+	"maximal number of operations spent on a loop component "
+	"before falling back to a lower quality")
 ISL_ARG_BOOL(struct isl_options, print_stats, 0, "print-stats", 0,
 	"print statistics for every isl_ctx")
+ISL_ARG_BOOL(struct isl_options, time_stats, 0, "time-stats", 0,
+	"collect timing statistics for every isl_ctx")
+ISL_ARG_STR(struct isl_options, stats_json, 0, "stats-json", "file", NULL,
+	"append statistics in JSON format to \"file\" (\"-\" for stderr) "
+	"when an isl_ctx is freed")
+ISL_ARG_INT(struct isl_options, stats_top_coalesce, 0, "stats-top-coalesce",
+	"n", 0, "number of most expensive coalescing inputs to record "
+	"per isl_ctx")
 ISL_ARG_ULONG(struct isl_options, max_operations, 0,
 	"max-operations", 0, "default number of maximal operations per isl_ctx")
+ISL_ARG_ULONG(struct isl_options, max_allocated_bytes, 0,
+	"max-allocated-bytes", 0, "default total number of bytes that may be "
+	"requested per isl_ctx, including freed allocations")
+ISL_ARG_BOOL(struct isl_options, intern_spaces, 0, "intern-spaces", 0,
+	"share a single object between identical spaces")
+ISL_ARG_BOOL(struct isl_options, memory_lean, 0, "memory-lean", 0,
+	"do not keep derived data or freed memory around for later reuse")
+ISL_ARG_INT(struct isl_options, sample_cache_size, 0, "sample-cache-size",
+	"size", 0, "number of sample computations to remember per isl_ctx")
+ISL_ARG_INT(struct isl_options, lexopt_cache_size, 0, "lexopt-cache-size",
+	"size", 0,
+	"number of lexicographic optimizations to remember per isl_ctx")
+ISL_ARG_INT(struct isl_options, pw_coalesce_threshold, 0,
+	"pw-coalesce-threshold", "n", 0,
+	"coalesce the results of binary operations on piecewise expressions "
+	"with more than this number of pieces (0 means never)")
+ISL_ARG_CHOICE(struct isl_options, project_out, 0, "project-out",
+	project_out, ISL_PROJECT_OUT_AUTO,
+	"method for projecting out variables: eliminate using "
+	"Fourier-Motzkin when exact and not more expensive (auto), "
+	"always introduce existentially quantified variables (div) or "
+	"eliminate using Fourier-Motzkin whenever exact (fm)")
 ISL_ARG_VERSION(print_version)
 ISL_ARGS_END
 
@@ -228,9 +323,29 @@ ISL_ARG_DEF(isl_options, struct isl_options, isl_options_args)
 
 ISL_ARG_CTX_DEF(isl_options, struct isl_options, isl_options_args)
 
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	threads)
+
 ISL_CTX_SET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args, bound)
 ISL_CTX_GET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args, bound)
 
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	bound_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	bound_threads)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	bernstein_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	bernstein_threads)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	scan_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	scan_threads)
+
 ISL_CTX_SET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
 	on_error)
 ISL_CTX_GET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
@@ -241,6 +356,21 @@ ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	pip_symmetry)
 
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	pip_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	pip_threads)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	convex_hull_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	convex_hull_threads)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	convex_hull_max_facets)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	convex_hull_max_facets)
+
 ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	coalesce_bounded_wrapping)
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
@@ -251,10 +381,44 @@ ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	coalesce_preserve_locals)
 
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	coalesce_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	coalesce_threads)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	union_map_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	union_map_threads)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	flow_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	flow_threads)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	flow_cache_size)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	flow_cache_size)
+
 ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	gbr_only_first)
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	gbr_only_first)
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	gbr_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	gbr_threads)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	closure_budget)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	closure_budget)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	closure_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	closure_threads)
 
 ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
 	schedule_max_coefficient)
@@ -306,6 +470,11 @@ ISL_CTX_SET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
 ISL_CTX_GET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
 	schedule_algorithm)
 
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	schedule_budget)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	schedule_budget)
+
 ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	schedule_carry_self_first)
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
@@ -316,6 +485,61 @@ ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	schedule_serialize_sccs)
 
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	schedule_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	schedule_threads)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	schedule_coefficients_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	schedule_coefficients_threads)
+
+ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	schedule_trace)
+ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	schedule_trace)
+
+/* Set the external solver for the scheduler LPs to "fn" with
+ * user data "user".
+ * If "fn" is NULL, then the built-in solver is used exclusively.
+ */
+isl_stat isl_options_set_schedule_lp_backend(isl_ctx *ctx,
+	__isl_give isl_vec *(*fn)(__isl_keep isl_basic_set *lp, void *user),
+	void *user)
+{
+	struct isl_options *options;
+
+	options = isl_ctx_peek_isl_options(ctx);
+	if (!options)
+		isl_die(ctx, isl_error_invalid,
+			"isl_ctx does not reference isl_options",
+			return isl_stat_error);
+	options->schedule_lp_backend = fn;
+	options->schedule_lp_backend_user = user;
+	return isl_stat_ok;
+}
+
+/* Set the transport for offloading the computation of schedules
+ * of weakly connected components to "fn" with user data "user".
+ * If "fn" is NULL, then all schedules are computed locally.
+ */
+isl_stat isl_options_set_schedule_offload(isl_ctx *ctx,
+	__isl_give char *(*fn)(isl_ctx *ctx, const char *sc, void *user),
+	void *user)
+{
+	struct isl_options *options;
+
+	options = isl_ctx_peek_isl_options(ctx);
+	if (!options)
+		isl_die(ctx, isl_error_invalid,
+			"isl_ctx does not reference isl_options",
+			return isl_stat_error);
+	options->schedule_offload = fn;
+	options->schedule_offload_user = user;
+	return isl_stat_ok;
+}
+
 ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	tile_scale_tile_loops)
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
@@ -390,3 +614,58 @@ ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	ast_build_allow_or)
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	ast_build_allow_or)
+
+ISL_CTX_SET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
+	ast_build_quality)
+ISL_CTX_GET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
+	ast_build_quality)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	ast_build_component_budget)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	ast_build_component_budget)
+
+ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	intern_spaces)
+ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	intern_spaces)
+
+ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	memory_lean)
+ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	memory_lean)
+
+ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	time_stats)
+ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	time_stats)
+
+ISL_CTX_SET_STR_DEF(isl_options, struct isl_options, isl_options_args,
+	stats_json)
+ISL_CTX_GET_STR_DEF(isl_options, struct isl_options, isl_options_args,
+	stats_json)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	stats_top_coalesce)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	stats_top_coalesce)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	sample_cache_size)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	sample_cache_size)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	lexopt_cache_size)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	lexopt_cache_size)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	pw_coalesce_threshold)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	pw_coalesce_threshold)
+
+ISL_CTX_SET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
+	project_out)
+ISL_CTX_GET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
+	project_out)
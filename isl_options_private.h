@@ -2,6 +2,8 @@
 #define ISL_OPTIONS_PRIVATE_H
 
 #include <isl/options.h>
+#include <isl/set_type.h>
+#include <isl/vec.h>
 
 struct isl_options {
 	#define			ISL_CONTEXT_GBR		0
@@ -13,12 +15,19 @@ struct isl_options {
 	#define			ISL_GBR_ALWAYS	2
 	unsigned		gbr;
 	unsigned		gbr_only_first;
+	int			gbr_threads;
 
 	#define			ISL_CLOSURE_ISL		0
 	#define			ISL_CLOSURE_BOX		1
 	unsigned		closure;
+	int			closure_budget;
+	int			closure_threads;
+
+	int			threads;
 
 	int			bound;
+	int			bound_threads;
+	int			scan_threads;
 	unsigned		on_error;
 
 	#define			ISL_BERNSTEIN_FACTORS	1
@@ -26,15 +35,25 @@ struct isl_options {
 	int			bernstein_recurse;
 
 	int			bernstein_triangulate;
+	int			bernstein_threads;
 
 	int			pip_symmetry;
+	int			pip_threads;
 
 	#define			ISL_CONVEX_HULL_WRAP	0
 	#define			ISL_CONVEX_HULL_FM	1
 	int			convex;
+	int			convex_hull_threads;
+	int			convex_hull_max_facets;
 
 	int			coalesce_bounded_wrapping;
 	int			coalesce_preserve_locals;
+	int			coalesce_threads;
+
+	int			union_map_threads;
+
+	int			flow_threads;
+	int			flow_cache_size;
 
 	int			schedule_max_coefficient;
 	int			schedule_max_constant_term;
@@ -47,8 +66,26 @@ struct isl_options {
 	int			schedule_separate_components;
 	int			schedule_whole_component;
 	unsigned		schedule_algorithm;
+	int			schedule_budget;
 	int			schedule_carry_self_first;
 	int			schedule_serialize_sccs;
+	int			schedule_threads;
+	int			schedule_coefficients_threads;
+	int			schedule_trace;
+	/* An optional external solver for the scheduler LPs.
+	 * Not settable from the command line.
+	 */
+	__isl_give isl_vec	*(*schedule_lp_backend)(
+					__isl_keep isl_basic_set *lp,
+					void *user);
+	void			*schedule_lp_backend_user;
+	/* An optional transport for scheduling weakly connected
+	 * components elsewhere.
+	 * Not settable from the command line.
+	 */
+	__isl_give char		*(*schedule_offload)(isl_ctx *ctx,
+					const char *sc, void *user);
+	void			*schedule_offload_user;
 
 	int			tile_scale_tile_loops;
 	int			tile_shift_point_loops;
@@ -67,9 +104,22 @@ struct isl_options {
 	int			ast_build_scale_strides;
 	int			ast_build_allow_else;
 	int			ast_build_allow_or;
+	int			ast_build_quality;
+	int			ast_build_component_budget;
 
 	int			print_stats;
+	int			time_stats;
+	char			*stats_json;
+	int			stats_top_coalesce;
 	unsigned long		max_operations;
+	unsigned long		max_allocated_bytes;
+
+	int			intern_spaces;
+	int			memory_lean;
+	int			sample_cache_size;
+	int			lexopt_cache_size;
+	int			pw_coalesce_threshold;
+	int			project_out;
 };
 
 #endif
@@ -37,6 +37,7 @@
 #include <isl/ast_build.h>
 #include <isl_sort.h>
 #include <isl_output_private.h>
+#include <isl_binary_private.h>
 
 #include <bset_to_bmap.c>
 #include <set_to_map.c>
@@ -1541,6 +1542,8 @@ __isl_give isl_printer *isl_printer_print_basic_map(__isl_take isl_printer *p,
 		return isl_basic_map_print_isl(bmap, p, 0);
 	else if (p->output_format == ISL_FORMAT_OMEGA)
 		return basic_map_print_omega(bmap, p);
+	else if (p->output_format == ISL_FORMAT_BINARY)
+		return isl_printer_print_basic_map_binary(p, bmap);
 	isl_assert(bmap->ctx, 0, goto error);
 error:
 	isl_printer_free(p);
@@ -1563,6 +1566,9 @@ __isl_give isl_printer *isl_printer_print_basic_set(__isl_take isl_printer *p,
 		return bset_print_constraints_polylib(bset, p);
 	else if (p->output_format == ISL_FORMAT_OMEGA)
 		return basic_set_print_omega(bset, p);
+	else if (p->output_format == ISL_FORMAT_BINARY)
+		return isl_printer_print_basic_map_binary(p,
+							bset_to_bmap(bset));
 	isl_assert(p->ctx, 0, goto error);
 error:
 	isl_printer_free(p);
@@ -1584,6 +1590,8 @@ __isl_give isl_printer *isl_printer_print_set(__isl_take isl_printer *p,
 		return isl_set_print_omega(set, p);
 	else if (p->output_format == ISL_FORMAT_LATEX)
 		return isl_map_print_latex(set_to_map(set), p);
+	else if (p->output_format == ISL_FORMAT_BINARY)
+		return isl_printer_print_map_binary(p, set_to_map(set));
 	isl_assert(set->ctx, 0, goto error);
 error:
 	isl_printer_free(p);
@@ -1606,6 +1614,8 @@ __isl_give isl_printer *isl_printer_print_map(__isl_take isl_printer *p,
 		return isl_map_print_omega(map, p);
 	else if (p->output_format == ISL_FORMAT_LATEX)
 		return isl_map_print_latex(map, p);
+	else if (p->output_format == ISL_FORMAT_BINARY)
+		return isl_printer_print_map_binary(p, map);
 	isl_assert(map->ctx, 0, goto error);
 error:
 	isl_printer_free(p);
@@ -1709,6 +1719,8 @@ __isl_give isl_printer *isl_printer_print_union_map(__isl_take isl_printer *p,
 		return isl_union_map_print_isl(umap, p);
 	if (p->output_format == ISL_FORMAT_LATEX)
 		return isl_union_map_print_latex(umap, p);
+	if (p->output_format == ISL_FORMAT_BINARY)
+		return isl_printer_print_union_map_binary(p, umap);
 
 	isl_die(p->ctx, isl_error_invalid,
 		"invalid output format for isl_union_map", goto error);
@@ -1727,6 +1739,9 @@ __isl_give isl_printer *isl_printer_print_union_set(__isl_take isl_printer *p,
 		return isl_union_map_print_isl(uset_to_umap(uset), p);
 	if (p->output_format == ISL_FORMAT_LATEX)
 		return isl_union_map_print_latex(uset_to_umap(uset), p);
+	if (p->output_format == ISL_FORMAT_BINARY)
+		return isl_printer_print_union_map_binary(p,
+							uset_to_umap(uset));
 
 	isl_die(p->ctx, isl_error_invalid,
 		"invalid output format for isl_union_set", goto error);
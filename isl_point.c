@@ -548,6 +548,198 @@ error:
 	return isl_stat_error;
 }
 
+/* Data used by isl_set_foreach_point_block.
+ *
+ * "fn" and "user" are the arguments of isl_set_foreach_point_block.
+ * "coords" is the user-provided buffer for up to "size" points,
+ * each with "dim" coordinates.
+ * "n" is the number of points currently stored in "coords".
+ * "cur" and "step" are used by foreach_point_block_line
+ * to keep track of the current point and the step along a line.
+ */
+struct isl_foreach_point_block {
+	struct isl_scan_callback callback;
+	isl_stat (*fn)(long *coords, int n, void *user);
+	void *user;
+	long *coords;
+	int size;
+	int dim;
+	int n;
+	long *cur;
+	long *step;
+};
+
+/* Pass the points that are currently stored in fpb->coords
+ * to fpb->fn, if any.
+ */
+static isl_stat flush_point_block(struct isl_foreach_point_block *fpb)
+{
+	int n = fpb->n;
+
+	if (n == 0)
+		return isl_stat_ok;
+	fpb->n = 0;
+	return fpb->fn(fpb->coords, n, fpb->user);
+}
+
+/* Check that the first fpb->dim coordinates of "vec"
+ * can be represented as a long.
+ */
+static isl_stat check_point_block_fits(struct isl_foreach_point_block *fpb,
+	__isl_keep isl_vec *vec)
+{
+	int i;
+
+	for (i = 0; i < fpb->dim; ++i)
+		if (!isl_int_fits_slong(vec->el[1 + i]))
+			isl_die(isl_vec_get_ctx(vec), isl_error_invalid,
+				"coordinate does not fit in a long",
+				return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Add the single point "sample" to fpb->coords,
+ * passing the coordinates on to fpb->fn if the buffer is full.
+ */
+static isl_stat foreach_point_block(struct isl_scan_callback *cb,
+	__isl_take isl_vec *sample)
+{
+	struct isl_foreach_point_block *fpb;
+	long *coords;
+	int i;
+
+	fpb = (struct isl_foreach_point_block *) cb;
+	if (!sample || check_point_block_fits(fpb, sample) < 0)
+		goto error;
+
+	coords = fpb->coords + fpb->n * fpb->dim;
+	for (i = 0; i < fpb->dim; ++i)
+		coords[i] = isl_int_get_si(sample->el[1 + i]);
+	isl_vec_free(sample);
+
+	if (++fpb->n < fpb->size)
+		return isl_stat_ok;
+	return flush_point_block(fpb);
+error:
+	isl_vec_free(sample);
+	return isl_stat_error;
+}
+
+/* Add the "n" points "first" + k * "step" with k ranging from 0 to "n" - 1
+ * to fpb->coords, passing the coordinates on to fpb->fn
+ * whenever the buffer is full.
+ *
+ * The coordinates of the first and the last point and the step
+ * are checked to fit in a long.  Since the coordinates
+ * of the intermediate points lie in between those of the first and
+ * the last point, they can then be computed by adding the step
+ * to the previous point without overflow.
+ * The current point is kept in fpb->cur rather than in the buffer
+ * since "fn" may modify the contents of the buffer.
+ */
+static isl_stat foreach_point_block_line(struct isl_scan_callback *cb,
+	__isl_keep isl_vec *first, __isl_keep isl_vec *step, isl_int n)
+{
+	struct isl_foreach_point_block *fpb;
+	isl_vec *last;
+	long k, n_si;
+	int i;
+	isl_stat r;
+
+	fpb = (struct isl_foreach_point_block *) cb;
+	last = isl_vec_copy(first);
+	last = isl_vec_cow(last);
+	if (!last)
+		return isl_stat_error;
+	isl_int_sub_ui(n, n, 1);
+	for (i = 0; i < fpb->dim; ++i)
+		isl_int_addmul(last->el[1 + i], n, step->el[1 + i]);
+	isl_int_add_ui(n, n, 1);
+	r = check_point_block_fits(fpb, first);
+	if (r >= 0)
+		r = check_point_block_fits(fpb, last);
+	if (r >= 0)
+		r = check_point_block_fits(fpb, step);
+	isl_vec_free(last);
+	if (r < 0)
+		return isl_stat_error;
+	if (!isl_int_fits_slong(n))
+		isl_die(isl_vec_get_ctx(first), isl_error_invalid,
+			"too many points", return isl_stat_error);
+
+	for (i = 0; i < fpb->dim; ++i) {
+		fpb->cur[i] = isl_int_get_si(first->el[1 + i]);
+		fpb->step[i] = isl_int_get_si(step->el[1 + i]);
+	}
+	n_si = isl_int_get_si(n);
+	for (k = 0; k < n_si; ++k) {
+		long *coords = fpb->coords + fpb->n * fpb->dim;
+
+		if (k > 0)
+			for (i = 0; i < fpb->dim; ++i)
+				fpb->cur[i] += fpb->step[i];
+		for (i = 0; i < fpb->dim; ++i)
+			coords[i] = fpb->cur[i];
+		if (++fpb->n < fpb->size)
+			continue;
+		if (flush_point_block(fpb) < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Call "fn" on blocks of integer points in "set", which is assumed
+ * to be bounded, with as second argument the number of points
+ * in the block and as last argument "user".
+ * The coordinates of the points are stored in "coords",
+ * which is assumed to have room for "block_size" points.
+ * Each point is represented by the values of its parameters,
+ * followed by the values of its set dimensions.
+ * "fn" is called each time the buffer is full and
+ * a final time on the remaining points, if any.
+ * The points are produced in the same order as by isl_set_foreach_point,
+ * but without constructing an isl_point for each of them.
+ * In particular, the points along the innermost scanning direction
+ * are computed from the first point and a fixed step.
+ */
+isl_stat isl_set_foreach_point_block(__isl_keep isl_set *set,
+	long *coords, int block_size,
+	isl_stat (*fn)(long *coords, int n, void *user), void *user)
+{
+	struct isl_foreach_point_block fpb = {
+		{ &foreach_point_block, &foreach_point_block_line }, fn, user
+	};
+	isl_ctx *ctx;
+	isl_size dim;
+	isl_stat r;
+
+	dim = isl_set_dim(set, isl_dim_all);
+	if (dim < 0)
+		return isl_stat_error;
+	ctx = isl_set_get_ctx(set);
+	if (!coords || block_size <= 0)
+		isl_die(ctx, isl_error_invalid,
+			"invalid buffer", return isl_stat_error);
+
+	fpb.coords = coords;
+	fpb.size = block_size;
+	fpb.dim = dim;
+	fpb.cur = isl_alloc_array(ctx, long, dim);
+	fpb.step = isl_alloc_array(ctx, long, dim);
+	if (dim > 0 && (!fpb.cur || !fpb.step))
+		r = isl_stat_error;
+	else
+		r = isl_set_scan(isl_set_copy(set), &fpb.callback);
+	if (r >= 0)
+		r = flush_point_block(&fpb);
+	free(fpb.cur);
+	free(fpb.step);
+
+	return r;
+}
+
 /* Return 1 if "bmap" contains the point "point".
  * "bmap" is assumed to have known divs.
  * The point is first extended with the divs and then passed
@@ -9,6 +9,7 @@
  */
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <isl_ctx_private.h>
 #include <isl_map_private.h>
 #include <isl_factorization.h>
@@ -26,6 +27,7 @@
 #include <isl_local_space_private.h>
 #include <isl_aff_private.h>
 #include <isl_val_private.h>
+#include <isl_sort.h>
 #include <isl_config.h>
 
 #undef EL_BASE
@@ -1157,10 +1159,422 @@ error:
 	return NULL;
 }
 
+/* The minimal number of products of pairs of terms
+ * for which isl_poly_mul uses flat representations of its arguments.
+ */
+#define ISL_POLY_FLAT_MIN_PRODUCTS	64
+
+/* A flat representation of a polynomial as a sum of "n" terms,
+ * each of which is equal to coef[i] / "d" times a monomial.
+ * The exponents of the monomial are packed into key[i],
+ * with the exponent of variable "j" stored in the "bits" bits
+ * starting at bit j * bits.
+ * "size" is the number of terms for which room has been allocated.
+ * Comparing the keys of two terms corresponds to comparing their
+ * exponents lexicographically, starting from the last variable,
+ * which is the order of the terms in the recursive representation.
+ */
+struct isl_poly_flat {
+	isl_ctx *ctx;
+	int bits;
+	int n;
+	int size;
+	uint64_t *key;
+	isl_int *coef;
+	isl_int d;
+};
+
+/* Initialize "flat" as a polynomial without any terms
+ * with exponents packed using "bits" bits per variable.
+ */
+static void isl_poly_flat_init(struct isl_poly_flat *flat, isl_ctx *ctx,
+	int bits)
+{
+	flat->ctx = ctx;
+	flat->bits = bits;
+	flat->n = 0;
+	flat->size = 0;
+	flat->key = NULL;
+	flat->coef = NULL;
+	isl_int_init(flat->d);
+	isl_int_set_si(flat->d, 1);
+}
+
+/* Free all memory allocated by "flat".
+ */
+static void isl_poly_flat_clear(struct isl_poly_flat *flat)
+{
+	int i;
+
+	for (i = 0; i < flat->n; ++i)
+		isl_int_clear(flat->coef[i]);
+	free(flat->key);
+	free(flat->coef);
+	isl_int_clear(flat->d);
+}
+
+/* Append a term with packed exponents "key" to "flat" and
+ * return its position.  The coefficient is initialized to zero.
+ */
+static int isl_poly_flat_add_term(struct isl_poly_flat *flat, uint64_t key)
+{
+	if (flat->n >= flat->size) {
+		int size = 2 * flat->size + 16;
+		uint64_t *keys;
+		isl_int *coef;
+
+		keys = isl_realloc_array(flat->ctx, flat->key, uint64_t, size);
+		if (!keys)
+			return -1;
+		flat->key = keys;
+		coef = isl_realloc_array(flat->ctx, flat->coef, isl_int, size);
+		if (!coef)
+			return -1;
+		flat->coef = coef;
+		flat->size = size;
+	}
+	flat->key[flat->n] = key;
+	isl_int_init(flat->coef[flat->n]);
+	return flat->n++;
+}
+
+/* Return the number of non-zero constant terms in "poly",
+ * or some value greater than or equal to "max" if this number
+ * is greater than or equal to "max".
+ */
+static int isl_poly_count_terms(__isl_keep isl_poly *poly, int max)
+{
+	int i, n;
+	isl_poly_rec *rec;
+
+	if (poly->var < 0)
+		return !isl_int_is_zero(((isl_poly_cst *) poly)->n);
+
+	rec = (isl_poly_rec *) poly;
+	n = 0;
+	for (i = 0; i < rec->n && n < max; ++i)
+		n += isl_poly_count_terms(rec->p[i], max - n);
+
+	return n;
+}
+
+/* Update *max_exp to be at least the maximal exponent of any variable
+ * in "poly" and update "lcm" to be a multiple of all denominators
+ * in "poly".
+ * Return isl_bool_false if "poly" involves infinity or NaN.
+ */
+static isl_bool isl_poly_flat_prepare(__isl_keep isl_poly *poly, int *max_exp,
+	isl_int lcm)
+{
+	int i;
+	isl_poly_rec *rec;
+
+	if (poly->var < 0) {
+		isl_poly_cst *cst = (isl_poly_cst *) poly;
+
+		if (isl_int_is_zero(cst->d))
+			return isl_bool_false;
+		isl_int_lcm(lcm, lcm, cst->d);
+		return isl_bool_true;
+	}
+
+	rec = (isl_poly_rec *) poly;
+	if (rec->n - 1 > *max_exp)
+		*max_exp = rec->n - 1;
+	for (i = 0; i < rec->n; ++i) {
+		isl_bool ok;
+
+		ok = isl_poly_flat_prepare(rec->p[i], max_exp, lcm);
+		if (ok != isl_bool_true)
+			return ok;
+	}
+
+	return isl_bool_true;
+}
+
+/* Add the terms of "poly", multiplied by the monomial with
+ * packed exponents "key", to "flat".
+ * The coefficients are multiplied by flat->d, which is assumed
+ * to be a multiple of all denominators in "poly", such that
+ * they become integers.
+ */
+static isl_stat isl_poly_flat_add_poly(struct isl_poly_flat *flat,
+	__isl_keep isl_poly *poly, uint64_t key)
+{
+	int i;
+	isl_poly_rec *rec;
+
+	if (poly->var < 0) {
+		isl_poly_cst *cst = (isl_poly_cst *) poly;
+		int pos;
+
+		if (isl_int_is_zero(cst->n))
+			return isl_stat_ok;
+		pos = isl_poly_flat_add_term(flat, key);
+		if (pos < 0)
+			return isl_stat_error;
+		isl_int_divexact(flat->coef[pos], flat->d, cst->d);
+		isl_int_mul(flat->coef[pos], flat->coef[pos], cst->n);
+		return isl_stat_ok;
+	}
+
+	rec = (isl_poly_rec *) poly;
+	for (i = 0; i < rec->n; ++i) {
+		uint64_t shifted = (uint64_t) i << (poly->var * flat->bits);
+
+		if (isl_poly_flat_add_poly(flat, rec->p[i], key + shifted) < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Return the position in the hash table "table" of size "mask" + 1,
+ * mapping keys to positions in "flat", where the key "key"
+ * is stored or should be stored.
+ */
+static int isl_poly_flat_find(struct isl_poly_flat *flat, int *table,
+	int mask, uint64_t key)
+{
+	int h;
+
+	h = (int) ((key * UINT64_C(0x9E3779B97F4A7C15)) >> 33) & mask;
+	while (table[h] >= 0 && flat->key[table[h]] != key)
+		h = (h + 1) & mask;
+
+	return h;
+}
+
+/* Rebuild the hash table "table" of the terms of "flat"
+ * using a table of size "mask" + 1.
+ */
+static int *isl_poly_flat_rehash(struct isl_poly_flat *flat, int *table,
+	int mask)
+{
+	int i;
+
+	free(table);
+	table = isl_alloc_array(flat->ctx, int, mask + 1);
+	if (!table)
+		return NULL;
+	for (i = 0; i <= mask; ++i)
+		table[i] = -1;
+	for (i = 0; i < flat->n; ++i)
+		table[isl_poly_flat_find(flat, table, mask, flat->key[i])] = i;
+
+	return table;
+}
+
+/* Store the product of "flat1" and "flat2" in "res".
+ * Since the packed exponents have enough bits to represent
+ * the exponents of the product, the packed exponents of the product
+ * of two terms are the sum of those of the terms.
+ * The coefficients of the terms of the product with the same
+ * exponents are accumulated using a hash table on the keys.
+ */
+static isl_stat isl_poly_flat_mul(struct isl_poly_flat *res,
+	struct isl_poly_flat *flat1, struct isl_poly_flat *flat2)
+{
+	int i, j;
+	int mask = 255;
+	int *table;
+
+	isl_int_mul(res->d, flat1->d, flat2->d);
+	table = isl_poly_flat_rehash(res, NULL, mask);
+	if (!table)
+		return isl_stat_error;
+	for (i = 0; i < flat1->n; ++i) {
+		for (j = 0; j < flat2->n; ++j) {
+			uint64_t key = flat1->key[i] + flat2->key[j];
+			int h, pos;
+
+			h = isl_poly_flat_find(res, table, mask, key);
+			if (table[h] >= 0) {
+				isl_int_addmul(res->coef[table[h]],
+						flat1->coef[i], flat2->coef[j]);
+				continue;
+			}
+			pos = isl_poly_flat_add_term(res, key);
+			if (pos < 0)
+				break;
+			isl_int_mul(res->coef[pos],
+					flat1->coef[i], flat2->coef[j]);
+			table[h] = pos;
+			if (2 * res->n <= mask)
+				continue;
+			mask = 2 * mask + 1;
+			table = isl_poly_flat_rehash(res, table, mask);
+			if (!table)
+				break;
+		}
+		if (j < flat2->n)
+			break;
+	}
+	free(table);
+
+	return i < flat1->n ? isl_stat_error : isl_stat_ok;
+}
+
+/* Compare the keys of the terms at positions "a" and "b" in "user",
+ * an array of keys.
+ */
+static int isl_poly_flat_cmp(const void *a, const void *b, void *user)
+{
+	uint64_t *key = user;
+	uint64_t key_a = key[*(const int *) a];
+	uint64_t key_b = key[*(const int *) b];
+
+	return key_a < key_b ? -1 : key_a > key_b ? 1 : 0;
+}
+
+/* Return the exponent of variable "var" in the term of "flat"
+ * at position "pos".
+ */
+static int isl_poly_flat_exp(struct isl_poly_flat *flat, int pos, int var)
+{
+	uint64_t mask = (UINT64_C(1) << flat->bits) - 1;
+
+	return (int) ((flat->key[pos] >> (var * flat->bits)) & mask);
+}
+
+/* Construct the recursive representation of the sum of the terms
+ * of "flat" at positions pos[lo] to pos[hi - 1].
+ * These terms are sorted, have distinct non-zero coefficients and
+ * do not involve any variables beyond "var".
+ */
+static __isl_give isl_poly *isl_poly_flat_build(struct isl_poly_flat *flat,
+	int *pos, int lo, int hi, int var)
+{
+	int e, k, max;
+	isl_poly_rec *rec;
+
+	if (lo >= hi)
+		return isl_poly_zero(flat->ctx);
+	if (var < 0) {
+		isl_poly *poly;
+
+		poly = isl_poly_rat_cst(flat->ctx, flat->coef[pos[lo]],
+					flat->d);
+		if (poly)
+			isl_poly_cst_reduce((isl_poly_cst *) poly);
+		return poly;
+	}
+
+	max = isl_poly_flat_exp(flat, pos[hi - 1], var);
+	if (max == 0)
+		return isl_poly_flat_build(flat, pos, lo, hi, var - 1);
+
+	rec = isl_poly_alloc_rec(flat->ctx, var, max + 1);
+	if (!rec)
+		return NULL;
+	for (e = 0, k = lo; e <= max; ++e) {
+		int j;
+
+		for (j = k; j < hi; ++j)
+			if (isl_poly_flat_exp(flat, pos[j], var) != e)
+				break;
+		rec->p[e] = isl_poly_flat_build(flat, pos, k, j, var - 1);
+		if (!rec->p[e])
+			return isl_poly_free(&rec->poly);
+		rec->n++;
+		k = j;
+	}
+
+	return &rec->poly;
+}
+
+/* Construct the recursive representation of "flat",
+ * which involves no variables beyond "var".
+ */
+static __isl_give isl_poly *isl_poly_from_flat(struct isl_poly_flat *flat,
+	int var)
+{
+	int i, n;
+	int *pos;
+	isl_poly *poly;
+
+	pos = isl_alloc_array(flat->ctx, int, flat->n);
+	if (flat->n && !pos)
+		return NULL;
+	n = 0;
+	for (i = 0; i < flat->n; ++i)
+		if (!isl_int_is_zero(flat->coef[i]))
+			pos[n++] = i;
+	if (isl_sort(pos, n, sizeof(int), &isl_poly_flat_cmp, flat->key) < 0)
+		poly = NULL;
+	else
+		poly = isl_poly_flat_build(flat, pos, 0, n, var);
+	free(pos);
+
+	return poly;
+}
+
+/* Multiply "poly1" and "poly2" using flat representations
+ * and store the result in *res.
+ *
+ * The flat representations allow the product to be computed
+ * using integer arithmetic on contiguous arrays, without
+ * allocating any intermediate polynomials.
+ * This is only worthwhile if both polynomials are non-constant and
+ * there are enough pairs of terms.
+ * It is only possible if the polynomials do not involve infinity or NaN and
+ * if the exponents of the product can be packed into 63 bits.
+ * Return isl_bool_false, without touching *res, if any of these
+ * conditions is not satisfied.
+ */
+static isl_bool isl_poly_mul_flat(__isl_keep isl_poly *poly1,
+	__isl_keep isl_poly *poly2, isl_poly **res)
+{
+	isl_ctx *ctx = poly1->ctx;
+	int n1, n2, n_var, bits, max1, max2;
+	isl_bool ok;
+	isl_stat r;
+	struct isl_poly_flat flat1, flat2, prod;
+
+	if (poly1->var < 0 || poly2->var < 0)
+		return isl_bool_false;
+	n1 = isl_poly_count_terms(poly1, ISL_POLY_FLAT_MIN_PRODUCTS);
+	n2 = isl_poly_count_terms(poly2, ISL_POLY_FLAT_MIN_PRODUCTS);
+	if (n1 * n2 < ISL_POLY_FLAT_MIN_PRODUCTS)
+		return isl_bool_false;
+
+	isl_poly_flat_init(&flat1, ctx, 0);
+	isl_poly_flat_init(&flat2, ctx, 0);
+	max1 = max2 = 0;
+	ok = isl_poly_flat_prepare(poly1, &max1, flat1.d);
+	if (ok == isl_bool_true)
+		ok = isl_poly_flat_prepare(poly2, &max2, flat2.d);
+	n_var = 1 + (poly1->var > poly2->var ? poly1->var : poly2->var);
+	for (bits = 1; (max1 + max2) >> bits; ++bits)
+		;
+	if (ok == isl_bool_true && n_var * bits > 63)
+		ok = isl_bool_false;
+	if (ok != isl_bool_true) {
+		isl_poly_flat_clear(&flat1);
+		isl_poly_flat_clear(&flat2);
+		return ok;
+	}
+
+	flat1.bits = flat2.bits = bits;
+	isl_poly_flat_init(&prod, ctx, bits);
+	r = isl_poly_flat_add_poly(&flat1, poly1, 0);
+	if (r >= 0)
+		r = isl_poly_flat_add_poly(&flat2, poly2, 0);
+	if (r >= 0)
+		r = isl_poly_flat_mul(&prod, &flat1, &flat2);
+	*res = r < 0 ? NULL : isl_poly_from_flat(&prod, n_var - 1);
+	isl_poly_flat_clear(&flat1);
+	isl_poly_flat_clear(&flat2);
+	isl_poly_flat_clear(&prod);
+
+	return *res ? isl_bool_true : isl_bool_error;
+}
+
 __isl_give isl_poly *isl_poly_mul(__isl_take isl_poly *poly1,
 	__isl_take isl_poly *poly2)
 {
-	isl_bool is_zero, is_nan, is_one, is_cst;
+	isl_bool is_zero, is_nan, is_one, is_cst, flat;
+	isl_poly *res = NULL;
 
 	if (!poly1 || !poly2)
 		goto error;
@@ -1213,6 +1627,15 @@ __isl_give isl_poly *isl_poly_mul(__isl_take isl_poly *poly1,
 		return poly1;
 	}
 
+	flat = isl_poly_mul_flat(poly1, poly2, &res);
+	if (flat < 0)
+		goto error;
+	if (flat) {
+		isl_poly_free(poly1);
+		isl_poly_free(poly2);
+		return res;
+	}
+
 	if (poly1->var < poly2->var)
 		return isl_poly_mul(poly2, poly1);
 
@@ -1349,6 +1772,78 @@ error:
 	return NULL;
 }
 
+/* Return a copy of "poly" in "ctx".
+ * Unless "poly" already belongs to "ctx", "poly" itself
+ * is not modified, not even its reference count.
+ */
+static __isl_give isl_poly *isl_poly_copy_to_ctx(__isl_keep isl_poly *poly,
+	isl_ctx *ctx)
+{
+	int i;
+	isl_poly_rec *rec;
+	isl_poly_rec *dup;
+
+	if (!poly)
+		return NULL;
+	if (poly->ctx == ctx)
+		return isl_poly_copy(poly);
+
+	if (poly->var < 0) {
+		isl_poly_cst *cst = (isl_poly_cst *) poly;
+		isl_poly_cst *dup_cst;
+
+		dup_cst = isl_poly_as_cst(isl_poly_zero(ctx));
+		if (!dup_cst)
+			return NULL;
+		isl_int_set(dup_cst->n, cst->n);
+		isl_int_set(dup_cst->d, cst->d);
+		return &dup_cst->poly;
+	}
+
+	rec = (isl_poly_rec *) poly;
+	dup = isl_poly_alloc_rec(ctx, poly->var, rec->n);
+	if (!dup)
+		return NULL;
+	for (i = 0; i < rec->n; ++i) {
+		dup->p[i] = isl_poly_copy_to_ctx(rec->p[i], ctx);
+		if (!dup->p[i])
+			goto error;
+		dup->n++;
+	}
+
+	return &dup->poly;
+error:
+	isl_poly_free(&dup->poly);
+	return NULL;
+}
+
+/* Return a copy of "qp" in "ctx".
+ * Unless "qp" already belongs to "ctx", "qp" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_qpolynomial *isl_qpolynomial_copy_to_ctx(
+	__isl_keep isl_qpolynomial *qp, isl_ctx *ctx)
+{
+	struct isl_qpolynomial *dup;
+
+	if (!qp)
+		return NULL;
+	if (isl_qpolynomial_get_ctx(qp) == ctx)
+		return isl_qpolynomial_copy(qp);
+
+	dup = isl_qpolynomial_alloc(isl_space_copy_to_ctx(qp->dim, ctx),
+				    qp->div->n_row,
+				    isl_poly_copy_to_ctx(qp->poly, ctx));
+	if (!dup)
+		return NULL;
+	isl_mat_free(dup->div);
+	dup->div = isl_mat_copy_to_ctx(qp->div, ctx);
+	if (!dup->div)
+		return isl_qpolynomial_free(dup);
+
+	return dup;
+}
+
 __isl_give isl_qpolynomial *isl_qpolynomial_cow(__isl_take isl_qpolynomial *qp)
 {
 	if (!qp)
@@ -3118,6 +3613,35 @@ static __isl_give isl_qpolynomial *isl_qpolynomial_zero_in_space(
 #include <isl_pw_opt_templ.c>
 #include <isl_pw_sub_templ.c>
 
+/* Return a copy of "pwqp" in "ctx".
+ * Unless "pwqp" already belongs to "ctx", "pwqp" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_pw_qpolynomial *isl_pw_qpolynomial_copy_to_ctx(
+	__isl_keep isl_pw_qpolynomial *pwqp, isl_ctx *ctx)
+{
+	int i;
+	isl_space *space;
+	isl_pw_qpolynomial *dup;
+
+	if (!pwqp)
+		return NULL;
+	if (isl_pw_qpolynomial_get_ctx(pwqp) == ctx)
+		return isl_pw_qpolynomial_copy(pwqp);
+
+	space = isl_space_copy_to_ctx(pwqp->dim, ctx);
+	dup = isl_pw_qpolynomial_alloc_size(space, pwqp->n);
+	for (i = 0; i < pwqp->n; ++i) {
+		isl_set *set;
+		isl_qpolynomial *qp;
+
+		set = isl_set_copy_to_ctx(pwqp->p[i].set, ctx);
+		qp = isl_qpolynomial_copy_to_ctx(pwqp->p[i].qp, ctx);
+		dup = isl_pw_qpolynomial_add_piece(dup, set, qp);
+	}
+	return dup;
+}
+
 #undef BASE
 #define BASE pw_qpolynomial
 
@@ -4639,6 +5163,7 @@ static isl_stat split_periods(__isl_take isl_set *set,
 	int i;
 	isl_pw_qpolynomial *pwqp;
 	struct isl_split_periods_data *data;
+	isl_lp_solver *lp;
 	isl_int min, max;
 	isl_size div_pos;
 	isl_stat r = isl_stat_ok;
@@ -4660,6 +5185,7 @@ static isl_stat split_periods(__isl_take isl_set *set,
 
 	isl_int_init(min);
 	isl_int_init(max);
+	lp = isl_set_lp_solver_alloc(set);
 	for (i = 0; i < qp->div->n_row; ++i) {
 		enum isl_lp_result lp_res;
 
@@ -4667,7 +5193,7 @@ static isl_stat split_periods(__isl_take isl_set *set,
 						qp->div->n_row) != -1)
 			continue;
 
-		lp_res = isl_set_solve_lp(set, 0, qp->div->row[i] + 1,
+		lp_res = isl_lp_solver_solve(lp, 0, qp->div->row[i] + 1,
 					  set->ctx->one, &min, NULL, NULL);
 		if (lp_res == isl_lp_error)
 			goto error2;
@@ -4675,7 +5201,7 @@ static isl_stat split_periods(__isl_take isl_set *set,
 			continue;
 		isl_int_fdiv_q(min, min, qp->div->row[i][0]);
 
-		lp_res = isl_set_solve_lp(set, 1, qp->div->row[i] + 1,
+		lp_res = isl_lp_solver_solve(lp, 1, qp->div->row[i] + 1,
 					  set->ctx->one, &max, NULL, NULL);
 		if (lp_res == isl_lp_error)
 			goto error2;
@@ -4689,6 +5215,7 @@ static isl_stat split_periods(__isl_take isl_set *set,
 			break;
 		}
 	}
+	isl_lp_solver_free(lp);
 
 	if (i < qp->div->n_row) {
 		r = split_div(set, qp, i, min, max, data);
@@ -4702,6 +5229,7 @@ static isl_stat split_periods(__isl_take isl_set *set,
 
 	return r;
 error2:
+	isl_lp_solver_free(lp);
 	isl_int_clear(max);
 	isl_int_clear(min);
 error:
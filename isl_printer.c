@@ -1,5 +1,6 @@
 #include <string.h>
 #include <isl_int.h>
+#include <isl/hash.h>
 #include <isl/id.h>
 #include <isl/id_to_id.h>
 #include <isl_printer_private.h>
@@ -149,29 +150,68 @@ error:
 	return NULL;
 }
 
+/* The size of a buffer that can hold the decimal representation
+ * of any long integer.
+ */
+#define LONG_BUFFER_SIZE	(3 * sizeof(long) + 2)
+
+/* Write the decimal representation of "v" to the characters
+ * right before "end" and return a pointer to the first character.
+ * There are assumed to be at least LONG_BUFFER_SIZE characters
+ * available before "end".
+ */
+static char *format_long(char *end, long v)
+{
+	unsigned long u = v < 0 ? 0UL - (unsigned long) v : (unsigned long) v;
+
+	do {
+		*--end = '0' + u % 10;
+		u /= 10;
+	} while (u);
+	if (v < 0)
+		*--end = '-';
+	return end;
+}
+
+/* Print "v" to the string printer "p", right aligned in a field
+ * of width "width", without going through a temporary heap allocated
+ * string.
+ */
+static __isl_give isl_printer *str_print_long(__isl_take isl_printer *p,
+	long v, int width)
+{
+	char buffer[LONG_BUFFER_SIZE];
+	char *end = buffer + sizeof(buffer);
+	char *s;
+	int len;
+
+	s = format_long(end, v);
+	len = end - s;
+	if (len < width)
+		p = str_print_indent(p, width - len);
+	if (!p)
+		return NULL;
+	return str_print(p, s, len);
+}
+
 static __isl_give isl_printer *str_print_int(__isl_take isl_printer *p, int i)
 {
-	int left = p->buf_size - p->buf_n;
-	int need = snprintf(p->buf + p->buf_n, left, "%d", i);
-	if (need >= left) {
-		if (grow_buf(p, need))
-			goto error;
-		left = p->buf_size - p->buf_n;
-		need = snprintf(p->buf + p->buf_n, left, "%d", i);
-	}
-	p->buf_n += need;
-	return p;
-error:
-	isl_printer_free(p);
-	return NULL;
+	return str_print_long(p, i, 0);
 }
 
+/* Print "i" to the string printer "p".
+ * Values that fit in a long are printed directly,
+ * while other values are first converted to a string.
+ */
 static __isl_give isl_printer *str_print_isl_int(__isl_take isl_printer *p,
 	isl_int i)
 {
 	char *s;
 	int len;
 
+	if (isl_int_fits_slong(i))
+		return str_print_long(p, isl_int_get_si(i), p->width);
+
 	s = isl_int_get_str(i);
 	len = strlen(s);
 	if (len < p->width)
@@ -181,6 +221,69 @@ static __isl_give isl_printer *str_print_isl_int(__isl_take isl_printer *p,
 	return p;
 }
 
+/* The number of characters collected by a callback printer
+ * before they are passed to the callback.
+ */
+#define CALLBACK_CHUNK_SIZE	65536
+
+/* Pass the characters collected in the buffer of the callback printer "p"
+ * to the callback and clear the buffer.
+ */
+static __isl_give isl_printer *callback_flush(__isl_take isl_printer *p)
+{
+	if (!p)
+		return NULL;
+	if (p->buf_n > 0 && p->write(p->buf, p->buf_n, p->write_user) < 0)
+		return isl_printer_free(p);
+	p->buf_n = 0;
+	p->buf[p->buf_n] = '\0';
+	return p;
+}
+
+/* Pass the characters collected in the buffer of the callback printer "p"
+ * to the callback if there are enough of them.
+ */
+static __isl_give isl_printer *callback_check(__isl_take isl_printer *p)
+{
+	if (!p || p->buf_n < CALLBACK_CHUNK_SIZE)
+		return p;
+	return callback_flush(p);
+}
+
+static __isl_give isl_printer *callback_start_line(__isl_take isl_printer *p)
+{
+	return callback_check(str_start_line(p));
+}
+
+static __isl_give isl_printer *callback_end_line(__isl_take isl_printer *p)
+{
+	return callback_check(str_end_line(p));
+}
+
+static __isl_give isl_printer *callback_print_double(
+	__isl_take isl_printer *p, double d)
+{
+	return callback_check(str_print_double(p, d));
+}
+
+static __isl_give isl_printer *callback_print_int(__isl_take isl_printer *p,
+	int i)
+{
+	return callback_check(str_print_int(p, i));
+}
+
+static __isl_give isl_printer *callback_print_isl_int(
+	__isl_take isl_printer *p, isl_int i)
+{
+	return callback_check(str_print_isl_int(p, i));
+}
+
+static __isl_give isl_printer *callback_print_str(__isl_take isl_printer *p,
+	const char *s)
+{
+	return callback_check(str_print_str(p, s));
+}
+
 struct isl_printer_ops {
 	__isl_give isl_printer *(*start_line)(__isl_take isl_printer *p);
 	__isl_give isl_printer *(*end_line)(__isl_take isl_printer *p);
@@ -214,6 +317,16 @@ static struct isl_printer_ops str_ops = {
 	str_flush
 };
 
+static struct isl_printer_ops callback_ops = {
+	callback_start_line,
+	callback_end_line,
+	callback_print_double,
+	callback_print_int,
+	callback_print_isl_int,
+	callback_print_str,
+	callback_flush
+};
+
 __isl_give isl_printer *isl_printer_to_file(isl_ctx *ctx, FILE *file)
 {
 	struct isl_printer *p = isl_calloc_type(ctx, struct isl_printer);
@@ -266,15 +379,69 @@ error:
 	return NULL;
 }
 
+/* Create a printer that passes the printed characters to "write"
+ * in chunks of some bounded size.
+ * The characters are collected in a buffer, which is passed to "write"
+ * whenever it grows beyond CALLBACK_CHUNK_SIZE characters,
+ * when isl_printer_flush is called and when the printer is freed.
+ * The chunks are not null-terminated.
+ * If "write" returns isl_stat_error, then printing is aborted.
+ */
+__isl_give isl_printer *isl_printer_to_callback(isl_ctx *ctx,
+	isl_stat (*write)(const char *s, size_t len, void *user), void *user)
+{
+	isl_printer *p;
+
+	if (!write)
+		isl_die(ctx, isl_error_invalid, "no callback specified",
+			return NULL);
+	p = isl_printer_to_str(ctx);
+	if (!p)
+		return NULL;
+	p->ops = &callback_ops;
+	p->write = write;
+	p->write_user = user;
+
+	return p;
+}
+
+/* A string that has been printed as a YAML value by
+ * isl_printer_yaml_print_anchored_str, along with the sequence number
+ * of the anchor that was attached to it.
+ */
+struct isl_printer_yaml_anchor {
+	char	*str;
+	int	id;
+};
+
+/* Free the isl_printer_yaml_anchor pointed to by "entry".
+ */
+static isl_stat free_yaml_anchor(void **entry, void *user)
+{
+	struct isl_printer_yaml_anchor *anchor = *entry;
+
+	free(anchor->str);
+	free(anchor);
+
+	return isl_stat_ok;
+}
+
 __isl_null isl_printer *isl_printer_free(__isl_take isl_printer *p)
 {
 	if (!p)
 		return NULL;
+	if (p->ops == &callback_ops && p->buf_n > 0)
+		p->write(p->buf, p->buf_n, p->write_user);
 	free(p->buf);
 	free(p->indent_prefix);
 	free(p->prefix);
 	free(p->suffix);
 	free(p->yaml_state);
+	if (p->yaml_anchor) {
+		isl_hash_table_foreach(p->ctx, p->yaml_anchor,
+					&free_yaml_anchor, NULL);
+		isl_hash_table_free(p->ctx, p->yaml_anchor);
+	}
 	isl_id_to_id_free(p->notes);
 	isl_ctx_deref(p->ctx);
 	free(p);
@@ -481,6 +648,98 @@ int isl_printer_get_yaml_style(__isl_keep isl_printer *p)
 	return p->yaml_style;
 }
 
+/* Set whether repeated YAML string values printed by "p"
+ * should be replaced by aliases to their first occurrence and
+ * return the updated printer.
+ */
+__isl_give isl_printer *isl_printer_set_yaml_anchors(
+	__isl_take isl_printer *p, int anchors)
+{
+	if (!p)
+		return NULL;
+
+	p->yaml_anchors = anchors;
+
+	return p;
+}
+
+/* Return whether repeated YAML string values printed by "p"
+ * are replaced by aliases or -1 on error.
+ */
+int isl_printer_get_yaml_anchors(__isl_keep isl_printer *p)
+{
+	if (!p)
+		return -1;
+	return p->yaml_anchors;
+}
+
+/* Is the string of the isl_printer_yaml_anchor "entry" equal to "val"?
+ */
+static isl_bool has_str(const void *entry, const void *val)
+{
+	const struct isl_printer_yaml_anchor *anchor = entry;
+
+	return isl_bool_ok(!strcmp(anchor->str, val));
+}
+
+/* Print "str" as a (quoted) YAML string value to "p".
+ *
+ * If anchors are enabled on "p", then look for an earlier occurrence
+ * of the same string.  If there is one, then only print an alias
+ * to the anchor of that earlier occurrence.
+ * Otherwise, print the string with a fresh anchor attached to it.
+ * The anchors are called "a0", "a1", ... in order of creation.
+ */
+__isl_give isl_printer *isl_printer_yaml_print_anchored_str(
+	__isl_take isl_printer *p, const char *str)
+{
+	struct isl_hash_table_entry *entry;
+	struct isl_printer_yaml_anchor *anchor;
+	uint32_t hash;
+
+	if (!p || !str)
+		return isl_printer_free(p);
+	if (!p->yaml_anchors)
+		goto print;
+
+	if (!p->yaml_anchor) {
+		p->yaml_anchor = isl_hash_table_alloc(p->ctx, 10);
+		if (!p->yaml_anchor)
+			return isl_printer_free(p);
+	}
+	hash = isl_hash_string(isl_hash_init(), str);
+	entry = isl_hash_table_find(p->ctx, p->yaml_anchor, hash,
+					&has_str, str, 1);
+	if (!entry)
+		return isl_printer_free(p);
+	if (entry->data) {
+		anchor = entry->data;
+		p = isl_printer_print_str(p, "*a");
+		return isl_printer_print_int(p, anchor->id);
+	}
+
+	anchor = isl_calloc_type(p->ctx, struct isl_printer_yaml_anchor);
+	if (anchor)
+		anchor->str = strdup(str);
+	if (!anchor || !anchor->str) {
+		free(anchor);
+		isl_hash_table_remove(p->ctx, p->yaml_anchor, entry);
+		return isl_printer_free(p);
+	}
+	anchor->id = p->yaml_n_anchor++;
+	entry->data = anchor;
+
+	p = isl_printer_print_str(p, "&a");
+	p = isl_printer_print_int(p, anchor->id);
+	p = isl_printer_print_str(p, " ");
+print:
+	p = isl_printer_print_str(p, "\"");
+	p = isl_printer_print_str(p, str);
+	p = isl_printer_print_str(p, "\"");
+
+	return p;
+}
+
 /* Push "state" onto the stack of currently active YAML elements and
  * return the updated printer.
  */
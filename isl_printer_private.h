@@ -18,10 +18,21 @@ struct isl_printer_ops;
  * yaml_size is the size of this arrays, while yaml_depth
  * is the number of elements currently in use.
  * yaml_state may be NULL if no YAML printing is being performed.
+ * If yaml_anchors is set, then YAML string values that are printed
+ * through isl_printer_yaml_print_anchored_str are only printed in full
+ * the first time, with an anchor, and as an alias to this anchor
+ * on subsequent occurrences.
+ * yaml_anchor maps these previously printed strings to their anchors and
+ * yaml_n_anchor is the number of anchors that have been created.
+ * yaml_anchor may be NULL if no anchors have been created yet.
  *
  * notes keeps track of arbitrary notes as a mapping between
  * name identifiers and note identifiers.  It may be NULL
  * if there are no notes yet.
+ *
+ * For a printer created by isl_printer_to_callback,
+ * "write" is the callback to which the contents of the buffer
+ * are passed and "write_user" is its user argument.
  */
 struct isl_printer {
 	struct isl_ctx	*ctx;
@@ -42,11 +53,19 @@ struct isl_printer {
 	int			yaml_depth;
 	int			yaml_size;
 	enum isl_yaml_state	*yaml_state;
+	int			yaml_anchors;
+	int			yaml_n_anchor;
+	struct isl_hash_table	*yaml_anchor;
 
 	isl_id_to_id	*notes;
+
+	isl_stat	(*write)(const char *s, size_t len, void *user);
+	void		*write_user;
 };
 
 __isl_give isl_printer *isl_printer_set_dump(__isl_take isl_printer *p,
 	int dump);
+__isl_give isl_printer *isl_printer_yaml_print_anchored_str(
+	__isl_take isl_printer *p, const char *str);
 
 #endif
@@ -12,6 +12,7 @@
  */
 
 #include <isl/id.h>
+#include <isl/options.h>
 #include <isl/aff.h>
 #include <isl_sort.h>
 #include <isl_val_private.h>
@@ -672,6 +673,27 @@ static
 #include "isl_type_has_equal_space_bin_templ.c"
 #include "isl_type_check_equal_space_templ.c"
 
+/* Coalesce "pw" if it has more pieces than allowed by
+ * the pw_coalesce_threshold option.
+ * If the option is not set (i.e., it is zero), then "pw" is left untouched.
+ * This is called on the results of binary operations such that
+ * the number of pieces in a chain of such operations remains bounded,
+ * without paying for a coalescing after every operation.
+ */
+static __isl_give PW *FN(PW,auto_coalesce)(__isl_take PW *pw)
+{
+	isl_ctx *ctx;
+	int threshold;
+
+	if (!pw)
+		return NULL;
+	ctx = FN(PW,get_ctx)(pw);
+	threshold = isl_options_get_pw_coalesce_threshold(ctx);
+	if (threshold <= 0 || pw->n <= threshold)
+		return pw;
+	return FN(PW,coalesce)(pw);
+}
+
 /* Private version of "union_add".  For isl_pw_qpolynomial and
  * isl_pw_qpolynomial_fold, we prefer to simply call it "add".
  */
@@ -740,7 +762,7 @@ static __isl_give PW *FN(PW,union_add_)(__isl_take PW *pw1, __isl_take PW *pw2)
 	FN(PW,free)(pw1);
 	FN(PW,free)(pw2);
 
-	return res;
+	return FN(PW,auto_coalesce)(res);
 error:
 	FN(PW,free)(pw1);
 	FN(PW,free)(pw2);
@@ -837,12 +859,24 @@ static __isl_give PW *FN(PW,on_shared_domain_in)(__isl_take PW *pw1,
 
 /* Apply "fn" to pairs of elements from pw1 and pw2 on shared domains.
  * The result of "fn" (and therefore also of this function) lives in "space".
+ *
+ * Pairs of cells that are obviously disjoint are skipped
+ * without computing their intersection.
+ * If a pair of cells have (obviously) identical domains,
+ * then this domain is used directly as the shared domain.
+ * Since the cells of each input are disjoint from each other,
+ * neither of these cells can then intersect any other cell
+ * of the other input.  The remaining cells of "pw2" are therefore
+ * skipped for the cell of "pw1" and the cell of "pw2"
+ * is recorded in "done" such that it is skipped
+ * for the remaining cells of "pw1".
  */
 static __isl_give PW *FN(PW,on_shared_domain_in)(__isl_take PW *pw1,
 	__isl_take PW *pw2, __isl_take isl_space *space,
 	__isl_give EL *(*fn)(__isl_take EL *el1, __isl_take EL *el2))
 {
 	int i, j, n;
+	int *done = NULL;
 	PW *res = NULL;
 
 	if (!pw1 || !pw2)
@@ -850,16 +884,39 @@ static __isl_give PW *FN(PW,on_shared_domain_in)(__isl_take PW *pw1,
 
 	n = pw1->n * pw2->n;
 	res = FN(PW,alloc_size)(isl_space_copy(space) OPT_TYPE_ARG(pw1->), n);
+	if (pw2->n > 0) {
+		done = isl_calloc_array(FN(PW,get_ctx)(pw2), int, pw2->n);
+		if (!done)
+			goto error;
+	}
 
 	for (i = 0; i < pw1->n; ++i) {
 		for (j = 0; j < pw2->n; ++j) {
 			isl_set *common;
 			EL *res_ij;
+			isl_bool disjoint, equal;
 			int empty;
 
-			common = isl_set_intersect(
+			if (done[j])
+				continue;
+			disjoint = isl_set_plain_is_disjoint(pw1->p[i].set,
+							    pw2->p[j].set);
+			if (disjoint < 0)
+				goto error;
+			if (disjoint)
+				continue;
+			equal = isl_set_plain_is_equal(pw1->p[i].set,
+							pw2->p[j].set);
+			if (equal < 0)
+				goto error;
+			if (equal) {
+				done[j] = 1;
+				common = isl_set_copy(pw1->p[i].set);
+			} else {
+				common = isl_set_intersect(
 					isl_set_copy(pw1->p[i].set),
 					isl_set_copy(pw2->p[j].set));
+			}
 			empty = isl_set_plain_is_empty(common);
 			if (empty < 0 || empty) {
 				isl_set_free(common);
@@ -873,14 +930,18 @@ static __isl_give PW *FN(PW,on_shared_domain_in)(__isl_take PW *pw1,
 			res_ij = FN(EL,gist)(res_ij, isl_set_copy(common));
 
 			res = FN(PW,add_piece)(res, common, res_ij);
+			if (equal)
+				break;
 		}
 	}
 
+	free(done);
 	isl_space_free(space);
 	FN(PW,free)(pw1);
 	FN(PW,free)(pw2);
-	return res;
+	return FN(PW,auto_coalesce)(res);
 error:
+	free(done);
 	isl_space_free(space);
 	FN(PW,free)(pw1);
 	FN(PW,free)(pw2);
@@ -1199,6 +1260,10 @@ static __isl_give PW *FN(PW,gist_last)(__isl_take PW *pw,
 /* Compute the gist of "pw" with respect to the domain constraints
  * of "context".  Call "fn_el" to compute the gist of the elements
  * and "fn_dom" to compute the gist of the domains.
+ * If "hull" is not NULL, then it is the simple hull of "context",
+ * the local variables of "context" have been computed and
+ * the parameters of "pw" and "context" are known to be aligned.
+ * Otherwise, the hull is computed here.
  *
  * If the piecewise expression is empty or the context is the universe,
  * then nothing can be simplified.
@@ -1207,8 +1272,8 @@ static __isl_give PW *FN(PW,gist_last)(__isl_take PW *pw,
  * Combine duplicate function value expressions first
  * to increase the chance of "pw" having a single domain.
  */
-static __isl_give PW *FN(PW,gist_fn)(__isl_take PW *pw,
-	__isl_take isl_set *context,
+static __isl_give PW *FN(PW,gist_fn_hull)(__isl_take PW *pw,
+	__isl_take isl_set *context, __isl_take isl_basic_set *hull,
 	__isl_give EL *(*fn_el)(__isl_take EL *el,
 				    __isl_take isl_set *set),
 	__isl_give isl_set *(*fn_dom)(__isl_take isl_set *set,
@@ -1216,13 +1281,13 @@ static __isl_give PW *FN(PW,gist_fn)(__isl_take PW *pw,
 {
 	int i;
 	int is_universe;
-	isl_basic_set *hull = NULL;
 
 	pw = FN(PW,sort_unique)(pw);
 	if (!pw || !context)
 		goto error;
 
 	if (pw->n == 0) {
+		isl_basic_set_free(hull);
 		isl_set_free(context);
 		return pw;
 	}
@@ -1231,11 +1296,13 @@ static __isl_give PW *FN(PW,gist_fn)(__isl_take PW *pw,
 	if (is_universe < 0)
 		goto error;
 	if (is_universe) {
+		isl_basic_set_free(hull);
 		isl_set_free(context);
 		return pw;
 	}
 
-	FN(PW,align_params_set)(&pw, &context);
+	if (!hull)
+		FN(PW,align_params_set)(&pw, &context);
 
 	pw = FN(PW,cow)(pw);
 	if (!pw)
@@ -1247,12 +1314,16 @@ static __isl_give PW *FN(PW,gist_fn)(__isl_take PW *pw,
 		equal = isl_set_plain_is_equal(pw->p[0].set, context);
 		if (equal < 0)
 			goto error;
-		if (equal)
+		if (equal) {
+			isl_basic_set_free(hull);
 			return FN(PW,gist_last)(pw, context, fn_el);
+		}
 	}
 
-	context = isl_set_compute_divs(context);
-	hull = isl_set_simple_hull(isl_set_copy(context));
+	if (!hull) {
+		context = isl_set_compute_divs(context);
+		hull = isl_set_simple_hull(isl_set_copy(context));
+	}
 
 	for (i = pw->n - 1; i >= 0; --i) {
 		isl_set *set_i;
@@ -1300,6 +1371,20 @@ error:
 	return NULL;
 }
 
+/* Compute the gist of "pw" with respect to the domain constraints
+ * of "context" as in FN(PW,gist_fn_hull), computing the hull of "context"
+ * on the fly.
+ */
+static __isl_give PW *FN(PW,gist_fn)(__isl_take PW *pw,
+	__isl_take isl_set *context,
+	__isl_give EL *(*fn_el)(__isl_take EL *el,
+				    __isl_take isl_set *set),
+	__isl_give isl_set *(*fn_dom)(__isl_take isl_set *set,
+				    __isl_take isl_basic_set *bset))
+{
+	return FN(PW,gist_fn_hull)(pw, context, NULL, fn_el, fn_dom);
+}
+
 __isl_give PW *FN(PW,gist)(__isl_take PW *pw, __isl_take isl_set *context)
 {
 	return FN(PW,gist_fn)(pw, context, &FN(EL,gist),
@@ -106,15 +106,48 @@ __isl_give isl_space *isl_reordering_get_space(__isl_keep isl_reordering *r)
 	return isl_space_copy(isl_reordering_peek_space(r));
 }
 
+/* Return the position of the parameter with identifier "id" in "space",
+ * starting the search at position "start" and wrapping around.
+ * Return the number of parameters if there is no such parameter.
+ */
+static int find_param(__isl_keep isl_space *space, __isl_keep isl_id *id,
+	int start)
+{
+	int i, j;
+
+	if (start >= space->nparam)
+		start = 0;
+	for (i = 0; i < space->nparam; ++i) {
+		isl_id *id_j;
+
+		j = start + i;
+		if (j >= space->nparam)
+			j -= space->nparam;
+		id_j = isl_space_get_dim_id(space, isl_dim_param, j);
+		isl_id_free(id_j);
+		if (id == id_j)
+			return j;
+	}
+
+	return space->nparam;
+}
+
 /* Construct a reordering that maps the parameters of "alignee"
  * to the corresponding parameters in a new dimension specification
  * that has the parameters of "aligner" first, followed by
  * any remaining parameters of "alignee" that do not occur in "aligner".
+ *
+ * The search for each parameter of "alignee" in "aligner" starts
+ * right after the position of the previously found parameter.
+ * The parameters typically appear in the same order in both spaces,
+ * so that this search usually succeeds immediately,
+ * avoiding a quadratic number of comparisons.
  */
 __isl_give isl_reordering *isl_parameter_alignment_reordering(
 	__isl_keep isl_space *alignee, __isl_keep isl_space *aligner)
 {
 	int i, j;
+	int next = 0;
 	isl_reordering *exp;
 
 	if (!alignee || !aligner)
@@ -132,15 +165,10 @@ __isl_give isl_reordering *isl_parameter_alignment_reordering(
 		if (!id_i)
 			isl_die(alignee->ctx, isl_error_invalid,
 				"cannot align unnamed parameters", goto error);
-		for (j = 0; j < aligner->nparam; ++j) {
-			isl_id *id_j;
-			id_j = isl_space_get_dim_id(aligner, isl_dim_param, j);
-			isl_id_free(id_j);
-			if (id_i == id_j)
-				break;
-		}
+		j = find_param(aligner, id_i, next);
 		if (j < aligner->nparam) {
 			exp->pos[i] = j;
+			next = j + 1;
 			isl_id_free(id_i);
 		} else {
 			isl_size pos;
@@ -13,6 +13,7 @@
 #include <isl/vec.h>
 #include <isl/mat.h>
 #include <isl_seq.h>
+#include <isl/hash.h>
 #include "isl_equalities.h"
 #include "isl_tab.h"
 #include "isl_basis_reduction.h"
@@ -377,6 +378,9 @@ static int greedy_search(isl_ctx *ctx, struct isl_tab *tab,
  * When ctx->opt->gbr is set to ISL_GBR_ALWAYS, then we allow the basis
  * reduction computation to return early.  That is, as soon as it
  * finds a reasonable first direction.
+ *
+ * The options are only read and not temporarily modified
+ * since they may be shared with other threads through child contexts.
  */ 
 __isl_give isl_vec *isl_tab_sample(struct isl_tab *tab)
 {
@@ -464,17 +468,12 @@ __isl_give isl_vec *isl_tab_sample(struct isl_tab *tab)
 				if (g)
 					break;
 			}
-			if (!reduced && choice &&
-			    ctx->opt->gbr != ISL_GBR_NEVER) {
-				unsigned gbr_only_first;
-				if (ctx->opt->gbr == ISL_GBR_ONCE)
-					ctx->opt->gbr = ISL_GBR_NEVER;
+			if (!reduced && choice && gbr != ISL_GBR_NEVER) {
+				if (gbr == ISL_GBR_ONCE)
+					gbr = ISL_GBR_NEVER;
 				tab->n_zero = level;
-				gbr_only_first = ctx->opt->gbr_only_first;
-				ctx->opt->gbr_only_first =
-					ctx->opt->gbr == ISL_GBR_ALWAYS;
-				tab = isl_tab_compute_reduced_basis(tab);
-				ctx->opt->gbr_only_first = gbr_only_first;
+				tab = isl_tab_compute_reduced_basis_only_first(
+					    tab, gbr == ISL_GBR_ALWAYS);
 				if (!tab || !tab->basis)
 					goto error;
 				reduced = 1;
@@ -519,13 +518,11 @@ __isl_give isl_vec *isl_tab_sample(struct isl_tab *tab)
 	} else
 		sample = isl_vec_alloc(ctx, 0);
 
-	ctx->opt->gbr = gbr;
 	isl_vec_free(min);
 	isl_vec_free(max);
 	free(snap);
 	return sample;
 error:
-	ctx->opt->gbr = gbr;
 	isl_vec_free(min);
 	isl_vec_free(max);
 	free(snap);
@@ -1150,6 +1147,177 @@ error:
 	return NULL;
 }
 
+/* Compute a sample point of the "dim"-dimensional basic set "bset",
+ * which is known not to be obviously empty and
+ * which does not have a known sample point.
+ * If "bounded" is set, then the caller guarantees that "bset" is bounded.
+ */
+static __isl_give isl_vec *compute_sample(__isl_take isl_basic_set *bset,
+	isl_size dim, int bounded)
+{
+	if (bset->n_eq > 0)
+		return sample_eq(bset, bounded ? isl_basic_set_sample_bounded
+					       : isl_basic_set_sample_vec);
+	if (dim == 0)
+		return zero_sample(bset);
+	if (dim == 1)
+		return interval_sample(bset);
+
+	return bounded ? sample_bounded(bset) : gbr_sample(bset);
+}
+
+/* An entry in the sample cache of an isl_ctx.
+ * "bset" is a basic set with sorted inequality constraints,
+ * "hash" is the hash value of its constraints and
+ * "sample" is an integer point in "bset" or
+ * a zero-length vector if "bset" is empty.
+ */
+struct isl_sample_cache_entry {
+	uint32_t		hash;
+	isl_basic_set		*bset;
+	isl_vec			*sample;
+};
+
+/* A size-bounded cache of the results of sample computations.
+ * "size" is the number of entries in "entry".
+ * The cache is direct-mapped: a basic set with hash value "hash"
+ * can only be stored in entry "hash % size", replacing
+ * the basic set that was stored there before.
+ */
+struct isl_sample_cache {
+	int				size;
+	struct isl_sample_cache_entry	*entry;
+};
+
+/* Free the sample cache of "ctx", if any.
+ * The cached objects keep a reference to "ctx", so this function
+ * needs to be called before checking whether "ctx" can be freed.
+ */
+void isl_ctx_clear_sample_cache(isl_ctx *ctx)
+{
+	int i;
+	struct isl_sample_cache *cache;
+
+	if (!ctx || !ctx->sample_cache)
+		return;
+	cache = ctx->sample_cache;
+	ctx->sample_cache = NULL;
+	for (i = 0; i < cache->size; ++i) {
+		isl_basic_set_free(cache->entry[i].bset);
+		isl_vec_free(cache->entry[i].sample);
+	}
+	free(cache->entry);
+	free(cache);
+}
+
+/* Return the sample cache of "ctx", allocating it if needed.
+ * The size of the cache is determined by the sample_cache_size option.
+ * If this option has changed since the cache was allocated,
+ * then the cache is reallocated.
+ */
+static struct isl_sample_cache *get_sample_cache(isl_ctx *ctx)
+{
+	int size = ctx->opt->sample_cache_size;
+	struct isl_sample_cache *cache;
+
+	if (ctx->sample_cache && ctx->sample_cache->size == size)
+		return ctx->sample_cache;
+	isl_ctx_clear_sample_cache(ctx);
+	cache = isl_calloc_type(ctx, struct isl_sample_cache);
+	if (!cache)
+		return NULL;
+	cache->entry = isl_calloc_array(ctx, struct isl_sample_cache_entry,
+					size);
+	if (!cache->entry) {
+		free(cache);
+		return NULL;
+	}
+	cache->size = size;
+	ctx->sample_cache = cache;
+	return cache;
+}
+
+/* Return a hash value for the constraints of "bset",
+ * which is assumed not to have any local variables.
+ */
+static uint32_t constraints_get_hash(__isl_keep isl_basic_set *bset,
+	isl_size total)
+{
+	int i;
+	uint32_t hash = isl_hash_init();
+	uint32_t c_hash;
+
+	isl_hash_byte(hash, bset->n_eq & 0xFF);
+	for (i = 0; i < bset->n_eq; ++i) {
+		c_hash = isl_seq_get_hash(bset->eq[i], 1 + total);
+		isl_hash_hash(hash, c_hash);
+	}
+	isl_hash_byte(hash, bset->n_ineq & 0xFF);
+	for (i = 0; i < bset->n_ineq; ++i) {
+		c_hash = isl_seq_get_hash(bset->ineq[i], 1 + total);
+		isl_hash_hash(hash, c_hash);
+	}
+	return hash;
+}
+
+/* Compute a sample point of the "dim"-dimensional basic set "bset"
+ * as in compute_sample, but first look for a basic set
+ * with the same constraints in the sample cache of the isl_ctx.
+ * If there is one, then return a copy of its sample point.
+ * Otherwise, compute the sample point and store it in the cache.
+ *
+ * The inequality constraints are sorted on a copy of "bset"
+ * such that the order of the inequality constraints does not matter,
+ * while the constraints of "bset" itself are left untouched.
+ */
+static __isl_give isl_vec *cached_sample(__isl_take isl_basic_set *bset,
+	isl_size dim, int bounded)
+{
+	isl_ctx *ctx = isl_basic_set_get_ctx(bset);
+	struct isl_sample_cache *cache;
+	struct isl_sample_cache_entry *entry;
+	isl_basic_set *key = NULL;
+	isl_vec *sample;
+	uint32_t hash;
+	isl_bool equal = isl_bool_false;
+
+	cache = get_sample_cache(ctx);
+	if (!cache)
+		goto error;
+	key = isl_basic_set_sort_constraints(isl_basic_set_dup(bset));
+	if (!key)
+		goto error;
+	hash = constraints_get_hash(key, dim);
+	entry = &cache->entry[hash % cache->size];
+	if (entry->bset && entry->hash == hash)
+		equal = isl_basic_set_plain_is_equal(entry->bset, key);
+	if (equal < 0)
+		goto error;
+	if (equal) {
+		ctx->stats->sample_cache_hits++;
+		isl_basic_set_free(key);
+		isl_basic_set_free(bset);
+		return isl_vec_copy(entry->sample);
+	}
+
+	ctx->stats->sample_cache_misses++;
+	sample = compute_sample(bset, dim, bounded);
+	if (!sample) {
+		isl_basic_set_free(key);
+		return NULL;
+	}
+	isl_basic_set_free(entry->bset);
+	isl_vec_free(entry->sample);
+	entry->hash = hash;
+	entry->bset = key;
+	entry->sample = isl_vec_copy(sample);
+	return sample;
+error:
+	isl_basic_set_free(key);
+	isl_basic_set_free(bset);
+	return NULL;
+}
+
 static __isl_give isl_vec *basic_set_sample(__isl_take isl_basic_set *bset,
 	int bounded)
 {
@@ -1179,15 +1347,9 @@ static __isl_give isl_vec *basic_set_sample(__isl_take isl_basic_set *bset,
 	isl_vec_free(bset->sample);
 	bset->sample = NULL;
 
-	if (bset->n_eq > 0)
-		return sample_eq(bset, bounded ? isl_basic_set_sample_bounded
-					       : isl_basic_set_sample_vec);
-	if (dim == 0)
-		return zero_sample(bset);
-	if (dim == 1)
-		return interval_sample(bset);
-
-	return bounded ? sample_bounded(bset) : gbr_sample(bset);
+	if (dim >= 2 && bset->ctx->opt->sample_cache_size > 0)
+		return cached_sample(bset, dim, bounded);
+	return compute_sample(bset, dim, bounded);
 error:
 	isl_basic_set_free(bset);
 	return NULL;
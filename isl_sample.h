@@ -23,6 +23,8 @@ __isl_give isl_vec *isl_basic_set_sample_with_cone(
 
 __isl_give isl_basic_set *isl_basic_set_from_vec(__isl_take isl_vec *vec);
 
+void isl_ctx_clear_sample_cache(isl_ctx *ctx);
+
 int isl_tab_set_initial_basis_with_cone(struct isl_tab *tab,
 	struct isl_tab *tab_cone);
 __isl_give isl_vec *isl_tab_sample(struct isl_tab *tab);
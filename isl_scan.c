@@ -15,6 +15,9 @@
 #include "isl_tab.h"
 #include <isl_val_private.h>
 #include <isl_vec_private.h>
+#include <isl_options_private.h>
+#include <isl/options.h>
+#include "isl_task.h"
 
 struct isl_counter {
 	struct isl_scan_callback callback;
@@ -65,6 +68,70 @@ static int add_solution(struct isl_tab *tab, struct isl_scan_callback *callback)
 	return callback->add(callback, sample);
 }
 
+/* Return the unique point of "tab" that satisfies "row" = "v"
+ * and then roll back "tab" to "snap".
+ */
+static __isl_give isl_vec *sample_at(struct isl_tab *tab, isl_int *row,
+	isl_int v, struct isl_tab_undo *snap)
+{
+	isl_vec *sample;
+
+	isl_int_neg(row[0], v);
+	if (isl_tab_add_valid_eq(tab, row) < 0)
+		return NULL;
+	isl_int_set_si(row[0], 0);
+	sample = isl_tab_get_sample_value(tab);
+	if (isl_tab_rollback(tab, snap) < 0)
+		return isl_vec_free(sample);
+	return sample;
+}
+
+/* Call callback->add_line on the integer points of "tab" that
+ * satisfy "row" = v, with v ranging from "min" to "max".
+ * All other scanning directions have been fixed in "tab",
+ * so these points lie on a line and are obtained by repeatedly
+ * adding a fixed step to the point for v = "min".
+ * The step is computed from the points for v = "min" and v = "max".
+ * "snap" is a snapshot of "tab" before any constraint on v was added.
+ */
+static isl_stat add_line(struct isl_tab *tab, isl_int *row,
+	isl_int min, isl_int max, struct isl_tab_undo *snap,
+	struct isl_scan_callback *callback)
+{
+	int i;
+	isl_int n;
+	isl_vec *first, *step;
+	isl_stat r;
+
+	first = sample_at(tab, row, min, snap);
+	if (isl_int_eq(min, max))
+		step = isl_vec_copy(first);
+	else
+		step = sample_at(tab, row, max, snap);
+	step = isl_vec_cow(step);
+	if (!first || !step)
+		goto error;
+
+	isl_int_init(n);
+	isl_int_sub(n, max, min);
+	for (i = 1; i < step->size; ++i) {
+		isl_int_sub(step->el[i], step->el[i], first->el[i]);
+		if (!isl_int_is_zero(n))
+			isl_int_divexact(step->el[i], step->el[i], n);
+	}
+	isl_int_add_ui(n, n, 1);
+	r = callback->add_line(callback, first, step, n);
+	isl_int_clear(n);
+
+	isl_vec_free(first);
+	isl_vec_free(step);
+	return r;
+error:
+	isl_vec_free(first);
+	isl_vec_free(step);
+	return isl_stat_error;
+}
+
 static isl_stat scan_0D(__isl_take isl_basic_set *bset,
 	struct isl_scan_callback *callback)
 {
@@ -81,6 +148,222 @@ static isl_stat scan_0D(__isl_take isl_basic_set *bset,
 	return callback->add(callback, sample);
 }
 
+/* Return the level of constraint "c" of a basic set with "dim" variables,
+ * i.e., the position of its last variable with a non-zero coefficient,
+ * or -1 if it does not involve any variables.
+ * Return -2 if the coefficient of this last variable is not 1 or -1.
+ */
+static int constraint_level(isl_int *c, int dim)
+{
+	int pos;
+
+	pos = isl_seq_last_non_zero(c + 1, dim);
+	if (pos < 0)
+		return -1;
+	if (!isl_int_is_one(c[1 + pos]) && !isl_int_is_negone(c[1 + pos]))
+		return -2;
+	return pos;
+}
+
+/* Is "bset", with "dim" variables, in a form where
+ * the integer points can be enumerated without solving any LPs?
+ *
+ * That is, does each constraint have a coefficient 1 or -1
+ * on its last variable and does every variable have both
+ * a lower and an upper bound in terms of earlier variables?
+ * A variable with an equality constraint at its level
+ * has both a lower and an upper bound.
+ */
+static isl_bool is_triangular(__isl_keep isl_basic_set *bset, int dim)
+{
+	int i, level;
+	int *lower, *upper;
+	isl_bool triangular = isl_bool_true;
+
+	lower = isl_calloc_array(bset->ctx, int, dim);
+	upper = isl_calloc_array(bset->ctx, int, dim);
+	if (!lower || !upper)
+		triangular = isl_bool_error;
+
+	for (i = 0; triangular == isl_bool_true && i < bset->n_eq; ++i) {
+		level = constraint_level(bset->eq[i], dim);
+		if (level == -2)
+			triangular = isl_bool_false;
+		else if (level >= 0)
+			lower[level] = upper[level] = 1;
+	}
+	for (i = 0; triangular == isl_bool_true && i < bset->n_ineq; ++i) {
+		level = constraint_level(bset->ineq[i], dim);
+		if (level == -2)
+			triangular = isl_bool_false;
+		else if (level >= 0 && isl_int_is_pos(bset->ineq[i][1 + level]))
+			lower[level] = 1;
+		else if (level >= 0)
+			upper[level] = 1;
+	}
+	for (i = 0; triangular == isl_bool_true && i < dim; ++i)
+		if (!lower[i] || !upper[i])
+			triangular = isl_bool_false;
+
+	free(lower);
+	free(upper);
+	return triangular;
+}
+
+/* Compute the range ["min", "max"] of the variable at position "level"
+ * of "bset" given the values of the earlier variables in "sample".
+ * "levels" contains the levels of the equality constraints
+ * followed by those of the inequality constraints.
+ * Since the variable has both a lower and an upper bound,
+ * "min" and "max" are initialized by the first such bound.
+ * Return 1 if the range is empty and 0 otherwise.
+ */
+static int triangular_range(__isl_keep isl_basic_set *bset, int *levels,
+	int level, __isl_keep isl_vec *sample,
+	isl_int *min, isl_int *max, isl_int *t)
+{
+	int i;
+	int first_min = 1, first_max = 1;
+
+	for (i = 0; i < bset->n_eq + bset->n_ineq; ++i) {
+		isl_int *c;
+		int eq = i < bset->n_eq;
+		int pos;
+
+		if (levels[i] != level)
+			continue;
+		c = eq ? bset->eq[i] : bset->ineq[i - bset->n_eq];
+		pos = isl_int_is_pos(c[1 + level]);
+		isl_seq_inner_product(c, sample->el, 1 + level, t);
+		if (pos)
+			isl_int_neg(*t, *t);
+		if ((eq || pos) && (first_min || isl_int_gt(*t, *min))) {
+			isl_int_set(*min, *t);
+			first_min = 0;
+		}
+		if ((eq || !pos) && (first_max || isl_int_lt(*t, *max))) {
+			isl_int_set(*max, *t);
+			first_max = 0;
+		}
+	}
+
+	return isl_int_gt(*min, *max);
+}
+
+/* Look for all integer points in "bset", which is assumed
+ * to satisfy is_triangular, and call callback->add on each of them.
+ *
+ * The variables are scanned in order, with the range of each variable
+ * computed directly from the constraints at its level
+ * by plugging in the values of the earlier variables.
+ * A constraint that does not involve any variables is only
+ * evaluated once, up front.
+ * As in isl_basic_set_scan, all points in the range
+ * of the final variable are added at once if possible.
+ * Note that the range of an earlier variable may contain values
+ * for which the ranges of later variables are empty.
+ * Those values are simply skipped.
+ */
+static isl_stat scan_triangular(__isl_take isl_basic_set *bset, int dim,
+	struct isl_scan_callback *callback)
+{
+	int i;
+	int level, init;
+	int *levels;
+	isl_ctx *ctx;
+	isl_vec *sample, *step;
+	isl_vec *max;
+	isl_int t;
+	isl_stat r = isl_stat_ok;
+
+	ctx = isl_basic_set_get_ctx(bset);
+	levels = isl_alloc_array(ctx, int, bset->n_eq + bset->n_ineq);
+	sample = isl_vec_zero(ctx, 1 + dim);
+	step = isl_vec_zero(ctx, 1 + dim);
+	max = isl_vec_alloc(ctx, dim);
+	if ((bset->n_eq + bset->n_ineq && !levels) || !sample || !step || !max)
+		goto error;
+
+	for (i = 0; i < bset->n_eq; ++i) {
+		levels[i] = constraint_level(bset->eq[i], dim);
+		if (levels[i] < 0 && !isl_int_is_zero(bset->eq[i][0]))
+			goto empty;
+	}
+	for (i = 0; i < bset->n_ineq; ++i) {
+		levels[bset->n_eq + i] = constraint_level(bset->ineq[i], dim);
+		if (levels[bset->n_eq + i] < 0 &&
+		    isl_int_is_neg(bset->ineq[i][0]))
+			goto empty;
+	}
+
+	isl_int_init(t);
+	isl_int_set_si(sample->el[0], 1);
+	level = 0;
+	init = 1;
+	while (r >= 0 && level >= 0) {
+		int empty = 0;
+
+		if (init)
+			empty = triangular_range(bset, levels, level, sample,
+				    &sample->el[1 + level], &max->el[level], &t);
+		else
+			isl_int_add_ui(sample->el[1 + level],
+					sample->el[1 + level], 1);
+
+		if (empty ||
+		    isl_int_gt(sample->el[1 + level], max->el[level])) {
+			level--;
+			init = 0;
+			continue;
+		}
+		if (level < dim - 1) {
+			++level;
+			init = 1;
+			continue;
+		}
+		if (callback->add == increment_counter) {
+			if (increment_range(callback,
+				    sample->el[1 + level], max->el[level]))
+				r = isl_stat_error;
+			isl_int_set(sample->el[1 + level], max->el[level]);
+		} else if (callback->add_line) {
+			isl_int_set_si(step->el[1 + level], 1);
+			isl_int_sub(t, max->el[level], sample->el[1 + level]);
+			isl_int_add_ui(t, t, 1);
+			r = callback->add_line(callback, sample, step, t);
+			isl_int_set(sample->el[1 + level], max->el[level]);
+		} else {
+			r = callback->add(callback, isl_vec_copy(sample));
+			sample = isl_vec_cow(sample);
+			if (!sample)
+				r = isl_stat_error;
+		}
+		init = 0;
+	}
+	isl_int_clear(t);
+
+	free(levels);
+	isl_vec_free(sample);
+	isl_vec_free(step);
+	isl_vec_free(max);
+	isl_basic_set_free(bset);
+	return r;
+empty:
+	free(levels);
+	isl_vec_free(sample);
+	isl_vec_free(step);
+	isl_vec_free(max);
+	isl_basic_set_free(bset);
+	return isl_stat_ok;
+error:
+	free(levels);
+	isl_vec_free(sample);
+	isl_vec_free(step);
+	isl_vec_free(max);
+	isl_basic_set_free(bset);
+	return isl_stat_error;
+}
+
 /* Look for all integer points in "bset", which is assumed to be bounded,
  * and call callback->add on each of them.
  *
@@ -98,6 +381,12 @@ static isl_stat scan_0D(__isl_take isl_basic_set *bset,
  * level and false if we want the next value.
  * Solutions are added in the leaves of the search tree, i.e., after
  * we have fixed a value in each direction of the basis.
+ * If callback->add_line is set, then all solutions in the range
+ * of the final basis vector are added at once.
+ *
+ * If the bounds on each variable can be read off directly
+ * from the constraints, then the tableau and the reduced basis
+ * are not needed and the points are enumerated by scan_triangular.
  */
 isl_stat isl_basic_set_scan(__isl_take isl_basic_set *bset,
 	struct isl_scan_callback *callback)
@@ -110,6 +399,7 @@ isl_stat isl_basic_set_scan(__isl_take isl_basic_set *bset,
 	struct isl_tab_undo **snap;
 	int level;
 	int init;
+	isl_bool triangular;
 	enum isl_lp_result res;
 
 	dim = isl_basic_set_dim(bset, isl_dim_all);
@@ -121,6 +411,14 @@ isl_stat isl_basic_set_scan(__isl_take isl_basic_set *bset,
 	if (dim == 0)
 		return scan_0D(bset, callback);
 
+	triangular = is_triangular(bset, dim);
+	if (triangular < 0) {
+		isl_basic_set_free(bset);
+		return isl_stat_error;
+	}
+	if (triangular)
+		return scan_triangular(bset, dim, callback);
+
 	min = isl_vec_alloc(bset->ctx, dim);
 	max = isl_vec_alloc(bset->ctx, dim);
 	snap = isl_alloc_array(bset->ctx, struct isl_tab_undo *, dim);
@@ -189,6 +487,17 @@ isl_stat isl_basic_set_scan(__isl_take isl_basic_set *bset,
 					goto error;
 			continue;
 		}
+		if (level == dim - 1 && callback->add_line) {
+			if (add_line(tab, B->row[1 + level], min->el[level],
+				    max->el[level], snap[level], callback) < 0)
+				goto error;
+			level--;
+			init = 0;
+			if (level >= 0)
+				if (isl_tab_rollback(tab, snap[level]) < 0)
+					goto error;
+			continue;
+		}
 		isl_int_neg(B->row[1 + level][0], min->el[level]);
 		if (isl_tab_add_valid_eq(tab, B->row[1 + level]) < 0)
 			goto error;
@@ -275,13 +584,261 @@ error:
 	return -1;
 }
 
+/* A slab of a basic set, i.e., the part of the basic set
+ * where the first variable lies in a given range,
+ * along with the number of integer points in the slab.
+ */
+struct isl_scan_slab {
+	isl_basic_set *bset;
+	isl_int count;
+};
+
+/* Free the basic sets of the "n" slabs in "slabs" and "slabs" itself.
+ */
+static void free_slabs(struct isl_scan_slab *slabs, int n)
+{
+	int i;
+
+	if (!slabs)
+		return;
+	for (i = 0; i < n; ++i) {
+		isl_basic_set_free(slabs[i].bset);
+		isl_int_clear(slabs[i].count);
+	}
+	free(slabs);
+}
+
+/* Return a copy of "bset" with the first variable restricted
+ * to lie in the range ["lo", "hi"].
+ */
+static __isl_give isl_basic_set *slab(__isl_keep isl_basic_set *bset,
+	isl_int lo, isl_int hi)
+{
+	int k;
+	isl_size total;
+
+	total = isl_basic_set_dim(bset, isl_dim_all);
+	if (total < 0)
+		return NULL;
+	bset = isl_basic_set_copy(bset);
+	bset = isl_basic_set_cow(bset);
+	bset = isl_basic_set_extend_constraints(bset, 0, 2);
+	k = isl_basic_set_alloc_inequality(bset);
+	if (k < 0)
+		return isl_basic_set_free(bset);
+	isl_seq_clr(bset->ineq[k], 1 + total);
+	isl_int_neg(bset->ineq[k][0], lo);
+	isl_int_set_si(bset->ineq[k][1], 1);
+	k = isl_basic_set_alloc_inequality(bset);
+	if (k < 0)
+		return isl_basic_set_free(bset);
+	isl_seq_clr(bset->ineq[k], 1 + total);
+	isl_int_set(bset->ineq[k][0], hi);
+	isl_int_set_si(bset->ineq[k][1], -1);
+	return bset;
+}
+
+/* Compute the range ["lo", "hi"] of the first variable of "bset".
+ * Return 1 if "bset" is empty, 0 if it is not and -1 on error,
+ * including the case where the first variable is unbounded.
+ */
+static int first_var_range(__isl_keep isl_basic_set *bset,
+	isl_int *lo, isl_int *hi)
+{
+	isl_ctx *ctx;
+	isl_size total;
+	struct isl_tab *tab;
+	isl_vec *obj;
+	enum isl_lp_result res;
+
+	total = isl_basic_set_dim(bset, isl_dim_all);
+	if (total < 0)
+		return -1;
+	ctx = isl_basic_set_get_ctx(bset);
+	obj = isl_vec_zero(ctx, 1 + total);
+	tab = isl_tab_from_basic_set(bset, 0);
+	if (!obj || !tab)
+		goto error;
+	isl_int_set_si(obj->el[1], 1);
+	res = isl_tab_min(tab, obj->el, ctx->one, lo, NULL, 0);
+	if (res == isl_lp_ok) {
+		isl_int_set_si(obj->el[1], -1);
+		res = isl_tab_min(tab, obj->el, ctx->one, hi, NULL, 0);
+		isl_int_neg(*hi, *hi);
+	}
+	isl_tab_free(tab);
+	isl_vec_free(obj);
+	if (res == isl_lp_empty)
+		return 1;
+	if (res != isl_lp_ok)
+		return -1;
+	return 0;
+error:
+	isl_tab_free(tab);
+	isl_vec_free(obj);
+	return -1;
+}
+
+/* Split each basic set of "set" into up to "n_slab" slabs
+ * of (roughly) equal width in the first variable and
+ * return them in "*slabs", with the number of slabs stored in "*n".
+ * Empty basic sets do not contribute any slabs.
+ * The basic sets of "set" are assumed to be disjoint,
+ * such that the slabs are also disjoint.
+ */
+static isl_stat split_slabs(__isl_keep isl_set *set, int n_slab,
+	struct isl_scan_slab **slabs, int *n)
+{
+	int i, j;
+	isl_ctx *ctx = isl_set_get_ctx(set);
+	isl_int lo, hi, width, t;
+	isl_stat r = isl_stat_ok;
+
+	*n = 0;
+	*slabs = isl_calloc_array(ctx, struct isl_scan_slab, set->n * n_slab);
+	if (set->n && !*slabs)
+		return isl_stat_error;
+
+	isl_int_init(lo);
+	isl_int_init(hi);
+	isl_int_init(width);
+	isl_int_init(t);
+	for (i = 0; r >= 0 && i < set->n; ++i) {
+		int empty, m;
+
+		empty = first_var_range(set->p[i], &lo, &hi);
+		if (empty < 0)
+			r = isl_stat_error;
+		if (empty)
+			continue;
+		isl_int_sub(t, hi, lo);
+		isl_int_add_ui(t, t, 1);
+		m = n_slab;
+		if (isl_int_cmp_si(t, m) < 0)
+			m = isl_int_get_si(t);
+		isl_int_set_si(width, m);
+		isl_int_cdiv_q(width, t, width);
+		for (j = 0; j < m; ++j) {
+			struct isl_scan_slab *s = &(*slabs)[*n];
+
+			isl_int_add(t, lo, width);
+			isl_int_sub_ui(t, t, 1);
+			if (isl_int_gt(t, hi))
+				isl_int_set(t, hi);
+			isl_int_init(s->count);
+			s->bset = slab(set->p[i], lo, t);
+			(*n)++;
+			if (!s->bset) {
+				r = isl_stat_error;
+				break;
+			}
+			isl_int_add(lo, lo, width);
+		}
+	}
+	isl_int_clear(lo);
+	isl_int_clear(hi);
+	isl_int_clear(width);
+	isl_int_clear(t);
+
+	return r;
+}
+
+/* Data used by count_threads.
+ * "slabs" contains the slabs that need to be counted and
+ * "count" collects the total count.
+ */
+struct isl_scan_slabs {
+	struct isl_scan_slab *slabs;
+	isl_int *count;
+};
+
+/* Count the number of integer points in slab "k" in context "ctx".
+ * The count itself does not belong to any context.
+ */
+static isl_stat count_slab(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_scan_slabs *data = user;
+	struct isl_scan_slab *s = &data->slabs[k];
+	isl_basic_set *bset;
+	int r;
+
+	bset = isl_basic_set_copy_to_ctx(s->bset, ctx);
+	r = isl_basic_set_count_upto(bset, ctx->zero, &s->count);
+	isl_basic_set_free(bset);
+
+	return r < 0 ? isl_stat_error : isl_stat_ok;
+}
+
+/* Add the number of integer points in slab "k" to data->count.
+ */
+static isl_stat add_slab_count(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_scan_slabs *data = user;
+
+	isl_int_add(*data->count, *data->count, data->slabs[k].count);
+
+	return isl_stat_ok;
+}
+
+/* Count the number of integer points in "set" using up to "n_thread"
+ * threads and store the result in "count".
+ *
+ * The set is split into disjoint basic sets and each of those
+ * is split into up to "n_thread" slabs along the first variable.
+ * The slabs are counted independently of each other,
+ * each in a task of isl_ctx_run_tasks, and
+ * the counts are then added up by the calling thread.
+ */
+static int count_threads(__isl_keep isl_set *set, int n_thread,
+	isl_int *count)
+{
+	int n;
+	isl_ctx *ctx;
+	struct isl_scan_slabs data = { NULL, count };
+	isl_stat r;
+
+	set = isl_set_copy(set);
+	set = isl_set_make_disjoint(set);
+	set = isl_set_compute_divs(set);
+	if (!set)
+		return -1;
+	ctx = isl_set_get_ctx(set);
+
+	isl_int_set_si(*count, 0);
+	r = split_slabs(set, n_thread, &data.slabs, &n);
+	if (r >= 0)
+		r = isl_ctx_run_tasks(ctx, n, n_thread,
+				    &count_slab, &add_slab_count, &data);
+	free_slabs(data.slabs, n);
+	isl_set_free(set);
+
+	return r < 0 ? -1 : 0;
+}
+
+/* Count the number of integer points in "set", stopping
+ * as soon as the count reaches "max", unless "max" is zero.
+ * The result is stored in "count".
+ *
+ * If the scan_threads option (or the threads option if the former
+ * is not set) is set to a value greater than one,
+ * no upper bound on the count is imposed and
+ * the set has at least one variable, then the counting
+ * is distributed over multiple threads.
+ */
 int isl_set_count_upto(__isl_keep isl_set *set, isl_int max, isl_int *count)
 {
 	struct isl_counter cnt = { { &increment_counter } };
+	int n_thread;
 
 	if (!set)
 		return -1;
 
+	n_thread = isl_options_get_scan_threads(isl_set_get_ctx(set));
+	n_thread = isl_ctx_get_n_thread(isl_set_get_ctx(set), n_thread);
+	if (n_thread > 1 && isl_int_is_zero(max) &&
+	    isl_set_dim(set, isl_dim_all) > 0)
+		return count_threads(set, n_thread, count);
+
 	isl_int_init(cnt.count);
 	isl_int_init(cnt.max);
 
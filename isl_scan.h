@@ -12,10 +12,18 @@
 
 #include <isl/set.h>
 #include <isl/vec.h>
+#include <isl_int.h>
 
+/* "add" is called on each integer point that is found.
+ * If "add_line" is set, then it is called instead on the "n"
+ * integer points "first" + k * "step", with k ranging from 0 to "n" - 1,
+ * that are found along the innermost scanning direction.
+ */
 struct isl_scan_callback {
 	isl_stat (*add)(struct isl_scan_callback *cb,
 		__isl_take isl_vec *sample);
+	isl_stat (*add_line)(struct isl_scan_callback *cb,
+		__isl_keep isl_vec *first, __isl_keep isl_vec *step, isl_int n);
 };
 
 isl_stat isl_basic_set_scan(__isl_take isl_basic_set *bset,
@@ -23,6 +23,7 @@
 #include <isl_schedule_private.h>
 #include <isl_schedule_tree.h>
 #include <isl_schedule_node_private.h>
+#include <isl_binary_private.h>
 
 /* Return a schedule encapsulating the given schedule tree.
  *
@@ -99,6 +100,25 @@ __isl_give isl_schedule *isl_schedule_copy(__isl_keep isl_schedule *sched)
 	return sched;
 }
 
+/* Return a copy of "schedule" in "ctx".
+ * Unless "schedule" already belongs to "ctx", "schedule" itself
+ * is not modified, not even its reference count.
+ * Copying schedules with expansion nodes is not supported.
+ */
+__isl_give isl_schedule *isl_schedule_copy_to_ctx(
+	__isl_keep isl_schedule *schedule, isl_ctx *ctx)
+{
+	isl_schedule_tree *tree;
+
+	if (!schedule)
+		return NULL;
+	if (isl_schedule_get_ctx(schedule) == ctx)
+		return isl_schedule_copy(schedule);
+
+	tree = isl_schedule_tree_copy_to_ctx(schedule->root, ctx);
+	return isl_schedule_from_schedule_tree(ctx, tree);
+}
+
 /* Return an isl_schedule that is equal to "schedule" and that has only
  * a single reference.
  */
@@ -676,6 +696,8 @@ __isl_give isl_printer *isl_printer_print_schedule(__isl_take isl_printer *p,
 	if (!schedule)
 		return isl_printer_free(p);
 
+	if (isl_printer_get_output_format(p) == ISL_FORMAT_BINARY)
+		return isl_printer_print_schedule_binary(p, schedule);
 	return isl_printer_print_schedule_tree(p, schedule->root);
 }
 
@@ -78,19 +78,19 @@ error:
 	return NULL;
 }
 
-/* Create a duplicate of the given isl_schedule_band.
+/* Create a duplicate of the given isl_schedule_band in "ctx".
+ * If "ctx" is not the context of "band", then "band" itself
+ * is not modified, not even its reference count.
  */
-__isl_give isl_schedule_band *isl_schedule_band_dup(
-	__isl_keep isl_schedule_band *band)
+static __isl_give isl_schedule_band *isl_schedule_band_dup_to_ctx(
+	__isl_keep isl_schedule_band *band, isl_ctx *ctx)
 {
 	int i;
-	isl_ctx *ctx;
 	isl_schedule_band *dup;
 
 	if (!band)
 		return NULL;
 
-	ctx = isl_schedule_band_get_ctx(band);
 	dup = isl_schedule_band_alloc(ctx);
 	if (!dup)
 		return NULL;
@@ -104,8 +104,9 @@ __isl_give isl_schedule_band *isl_schedule_band_dup(
 		dup->coincident[i] = band->coincident[i];
 	dup->permutable = band->permutable;
 
-	dup->mupa = isl_multi_union_pw_aff_copy(band->mupa);
-	dup->ast_build_options = isl_union_set_copy(band->ast_build_options);
+	dup->mupa = isl_multi_union_pw_aff_copy_to_ctx(band->mupa, ctx);
+	dup->ast_build_options =
+		isl_union_set_copy_to_ctx(band->ast_build_options, ctx);
 	if (!dup->mupa || !dup->ast_build_options)
 		return isl_schedule_band_free(dup);
 
@@ -129,6 +130,38 @@ __isl_give isl_schedule_band *isl_schedule_band_dup(
 	return dup;
 }
 
+/* Create a duplicate of the given isl_schedule_band.
+ */
+__isl_give isl_schedule_band *isl_schedule_band_dup(
+	__isl_keep isl_schedule_band *band)
+{
+	if (!band)
+		return NULL;
+
+	return isl_schedule_band_dup_to_ctx(band,
+					isl_schedule_band_get_ctx(band));
+}
+
+/* Return a copy of "band" in "ctx".
+ * Unless "band" already belongs to "ctx", "band" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_schedule_band *isl_schedule_band_copy_to_ctx(
+	__isl_keep isl_schedule_band *band, isl_ctx *ctx)
+{
+	isl_schedule_band *dup;
+
+	if (!band)
+		return NULL;
+	if (isl_schedule_band_get_ctx(band) == ctx)
+		return isl_schedule_band_copy(band);
+
+	dup = isl_schedule_band_dup_to_ctx(band, ctx);
+	if (dup)
+		dup->anchored = band->anchored;
+	return dup;
+}
+
 /* Return an isl_schedule_band that is equal to "band" and that has only
  * a single reference.
  */
@@ -46,6 +46,8 @@ __isl_give isl_schedule_band *isl_schedule_band_from_multi_union_pw_aff(
 	__isl_take isl_multi_union_pw_aff *mupa);
 __isl_give isl_schedule_band *isl_schedule_band_copy(
 	__isl_keep isl_schedule_band *band);
+__isl_give isl_schedule_band *isl_schedule_band_copy_to_ctx(
+	__isl_keep isl_schedule_band *band, isl_ctx *ctx);
 __isl_null isl_schedule_band *isl_schedule_band_free(
 	__isl_take isl_schedule_band *band);
 
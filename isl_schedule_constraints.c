@@ -16,6 +16,9 @@
 #include <isl/union_set.h>
 #include <isl/union_map.h>
 #include <isl/stream.h>
+#include <isl_binary_private.h>
+
+#include <uset_to_umap.c>
 
 /* The constraints that need to be satisfied by a schedule on "domain".
  *
@@ -71,6 +74,40 @@ __isl_give isl_schedule_constraints *isl_schedule_constraints_copy(
 	return sc_copy;
 }
 
+/* Return a copy of "sc" in "ctx".
+ * Unless "sc" already belongs to "ctx", "sc" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_schedule_constraints *isl_schedule_constraints_copy_to_ctx(
+	__isl_keep isl_schedule_constraints *sc, isl_ctx *ctx)
+{
+	isl_schedule_constraints *sc_copy;
+	enum isl_edge_type i;
+
+	if (!sc)
+		return NULL;
+	if (isl_schedule_constraints_get_ctx(sc) == ctx)
+		return isl_schedule_constraints_copy(sc);
+
+	sc_copy = isl_calloc_type(ctx, struct isl_schedule_constraints);
+	if (!sc_copy)
+		return NULL;
+
+	sc_copy->domain = isl_union_set_copy_to_ctx(sc->domain, ctx);
+	sc_copy->context = isl_set_copy_to_ctx(sc->context, ctx);
+	if (!sc_copy->domain || !sc_copy->context)
+		return isl_schedule_constraints_free(sc_copy);
+
+	for (i = isl_edge_first; i <= isl_edge_last; ++i) {
+		sc_copy->constraint[i] =
+			isl_union_map_copy_to_ctx(sc->constraint[i], ctx);
+		if (!sc_copy->constraint[i])
+			return isl_schedule_constraints_free(sc_copy);
+	}
+
+	return sc_copy;
+}
+
 /* Construct an empty (invalid) isl_schedule_constraints object.
  * The caller is responsible for setting the domain and initializing
  * all the other fields, e.g., by calling isl_schedule_constraints_init.
@@ -362,6 +399,26 @@ error:
 	return NULL;
 }
 
+/* Replace the constraints of type "type" in "sc" by "c",
+ * without modifying "c" in any way.
+ */
+__isl_give isl_schedule_constraints *isl_schedule_constraints_replace(
+	__isl_take isl_schedule_constraints *sc, enum isl_edge_type type,
+	__isl_take isl_union_map *c)
+{
+	if (!sc || !c)
+		goto error;
+
+	isl_union_map_free(sc->constraint[type]);
+	sc->constraint[type] = c;
+
+	return sc;
+error:
+	isl_schedule_constraints_free(sc);
+	isl_union_map_free(c);
+	return NULL;
+}
+
 /* Can a schedule constraint of type "type" be tagged?
  */
 static int may_be_tagged(enum isl_edge_type type)
@@ -455,6 +512,93 @@ error:
 	return NULL;
 }
 
+/* Intersect domain and range of "c" with "domain".
+ * If "tag" is set, then "c" may contain tags and then
+ * the domains of the wrapped relations inside the domain and range
+ * of "c" need to be intersected with "domain" as well.
+ */
+static __isl_give isl_union_map *intersect(__isl_take isl_union_map *c,
+	__isl_keep isl_union_set *domain, int tag)
+{
+	isl_union_map *t;
+
+	if (tag)
+		t = isl_union_map_copy(c);
+	c = isl_union_map_intersect_domain_union_set(c,
+						isl_union_set_copy(domain));
+	c = isl_union_map_intersect_range_union_set(c,
+						isl_union_set_copy(domain));
+	if (!tag)
+		return c;
+	t = isl_union_map_intersect_domain_wrapped_domain_union_set(t,
+						isl_union_set_copy(domain));
+	t = isl_union_map_intersect_range_wrapped_domain_union_set(t,
+						isl_union_set_copy(domain));
+	c = isl_union_map_union(c, t);
+	return c;
+}
+
+/* Restrict the domain of the schedule constraints "sc" to "domain".
+ *
+ * The schedule constraints are restricted to pairs of elements
+ * that both belong to "domain".
+ */
+__isl_give isl_schedule_constraints *isl_schedule_constraints_intersect_domain(
+	__isl_take isl_schedule_constraints *sc,
+	__isl_take isl_union_set *domain)
+{
+	enum isl_edge_type i;
+
+	if (!sc || !domain)
+		goto error;
+
+	for (i = isl_edge_first; i <= isl_edge_last; ++i) {
+		int tag = may_be_tagged(i);
+
+		sc->constraint[i] = intersect(sc->constraint[i], domain, tag);
+		if (!sc->constraint[i])
+			goto error;
+	}
+	sc->domain = isl_union_set_intersect(sc->domain, domain);
+	if (!sc->domain)
+		return isl_schedule_constraints_free(sc);
+
+	return sc;
+error:
+	isl_schedule_constraints_free(sc);
+	isl_union_set_free(domain);
+	return NULL;
+}
+
+/* Are "sc1" and "sc2" obviously equal?
+ * That is, do they have obviously equal domains, contexts and
+ * constraints of each type?
+ */
+isl_bool isl_schedule_constraints_plain_is_equal(
+	__isl_keep isl_schedule_constraints *sc1,
+	__isl_keep isl_schedule_constraints *sc2)
+{
+	enum isl_edge_type i;
+	isl_bool equal;
+
+	if (!sc1 || !sc2)
+		return isl_bool_error;
+	if (sc1 == sc2)
+		return isl_bool_true;
+
+	equal = isl_union_map_plain_is_equal(uset_to_umap(sc1->domain),
+					    uset_to_umap(sc2->domain));
+	if (equal < 0 || !equal)
+		return equal;
+	equal = isl_set_plain_is_equal(sc1->context, sc2->context);
+	for (i = isl_edge_first; equal == isl_bool_true && i <= isl_edge_last;
+	    ++i)
+		equal = isl_union_map_plain_is_equal(sc1->constraint[i],
+						    sc2->constraint[i]);
+
+	return equal;
+}
+
 /* An enumeration of the various keys that may appear in a YAML mapping
  * of an isl_schedule_constraints object.
  * The keys for the edge types are assumed to have the same values
@@ -520,7 +664,8 @@ static __isl_give isl_printer *print_constraint(__isl_take isl_printer *p,
 
 /* Print "sc" to "p"
  *
- * In particular, print the isl_schedule_constraints object as a YAML document.
+ * In particular, print the isl_schedule_constraints object as a YAML document,
+ * unless the binary format was requested.
  * Fields with values that are (obviously) equal to their default values
  * are not printed.
  */
@@ -532,6 +677,9 @@ __isl_give isl_printer *isl_printer_print_schedule_constraints(
 	if (!sc)
 		return isl_printer_free(p);
 
+	if (isl_printer_get_output_format(p) == ISL_FORMAT_BINARY)
+		return isl_printer_print_schedule_constraints_binary(p, sc);
+
 	p = isl_printer_yaml_start_mapping(p);
 	p = print_yaml_field_union_set(p, key_str[isl_sc_key_domain],
 					sc->domain);
@@ -14,14 +14,25 @@ enum isl_edge_type {
 	isl_edge_local
 };
 
+__isl_give isl_schedule_constraints *isl_schedule_constraints_copy_to_ctx(
+	__isl_keep isl_schedule_constraints *sc, isl_ctx *ctx);
 __isl_give isl_schedule_constraints *
 isl_schedule_constraints_align_params(__isl_take isl_schedule_constraints *sc);
+__isl_give isl_schedule_constraints *isl_schedule_constraints_intersect_domain(
+	__isl_take isl_schedule_constraints *sc,
+	__isl_take isl_union_set *domain);
+isl_bool isl_schedule_constraints_plain_is_equal(
+	__isl_keep isl_schedule_constraints *sc1,
+	__isl_keep isl_schedule_constraints *sc2);
 
 __isl_give isl_union_map *isl_schedule_constraints_get(
 	__isl_keep isl_schedule_constraints *sc, enum isl_edge_type type);
 __isl_give isl_schedule_constraints *isl_schedule_constraints_add(
 	__isl_take isl_schedule_constraints *sc, enum isl_edge_type type,
 	__isl_take isl_union_map *c);
+__isl_give isl_schedule_constraints *isl_schedule_constraints_replace(
+	__isl_take isl_schedule_constraints *sc, enum isl_edge_type type,
+	__isl_take isl_union_map *c);
 
 int isl_schedule_constraints_n_basic_map(
 	__isl_keep isl_schedule_constraints *sc);
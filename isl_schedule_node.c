@@ -48,6 +48,7 @@ __isl_give isl_schedule_node *isl_schedule_node_alloc(
 	node->child_pos = isl_alloc_array(ctx, int, n);
 	if (n && !node->child_pos)
 		return isl_schedule_node_free(node);
+	node->child_pos_size = n;
 	for (i = 0; i < n; ++i)
 		node->child_pos[i] = child_pos[i];
 
@@ -1164,16 +1165,45 @@ __isl_give isl_schedule_node *isl_schedule_node_root(
 	return isl_schedule_node_ancestor(node, n);
 }
 
+/* Make sure "node" has room for at least "n" child positions.
+ * The array is grown geometrically such that a sequence of moves
+ * down the tree only performs a logarithmic number of reallocations.
+ */
+static __isl_give isl_schedule_node *isl_schedule_node_reserve_child_pos(
+	__isl_take isl_schedule_node *node, int n)
+{
+	isl_ctx *ctx;
+	int *child_pos;
+	int size;
+
+	if (!node)
+		return NULL;
+	if (n <= node->child_pos_size)
+		return node;
+
+	ctx = isl_schedule_node_get_ctx(node);
+	size = (3 * n + 1) / 2;
+	child_pos = isl_realloc_array(ctx, node->child_pos, int, size);
+	if (!child_pos)
+		return isl_schedule_node_free(node);
+	node->child_pos = child_pos;
+	node->child_pos_size = size;
+
+	return node;
+}
+
 /* Move the "node" pointer to the child at position "pos" of the node
  * it currently points to.
+ *
+ * If "node" has only a single reference, then it is modified in place.
+ * In this case, the ancestor list and the child position array
+ * only need to be reallocated when they run out of space.
  */
 __isl_give isl_schedule_node *isl_schedule_node_child(
 	__isl_take isl_schedule_node *node, int pos)
 {
 	isl_size n;
-	isl_ctx *ctx;
 	isl_schedule_tree *tree;
-	int *child_pos;
 
 	node = isl_schedule_node_cow(node);
 	if (!node)
@@ -1183,14 +1213,12 @@ __isl_give isl_schedule_node *isl_schedule_node_child(
 			"node has no children",
 			return isl_schedule_node_free(node));
 
-	ctx = isl_schedule_node_get_ctx(node);
 	n = isl_schedule_tree_list_n_schedule_tree(node->ancestors);
 	if (n < 0)
 		return isl_schedule_node_free(node);
-	child_pos = isl_realloc_array(ctx, node->child_pos, int, n + 1);
-	if (!child_pos)
-		return isl_schedule_node_free(node);
-	node->child_pos = child_pos;
+	node = isl_schedule_node_reserve_child_pos(node, n + 1);
+	if (!node)
+		return NULL;
 	node->child_pos[n] = pos;
 
 	node->ancestors = isl_schedule_tree_list_add(node->ancestors,
@@ -2413,6 +2441,88 @@ __isl_give isl_schedule_node *isl_schedule_node_sequence_splice_children(
 	return node;
 }
 
+/* Can the "n" ancestors of "node" be updated in place
+ * by update_ancestors_inplace?
+ * That is, is "node" the only user of its schedule and its list
+ * of ancestors and is each ancestor only referenced from this list and
+ * from its parent in the schedule tree (or the schedule itself
+ * in case of the root), through a list of children that
+ * is not shared with any other tree?
+ * In this case, no other object can observe a modification
+ * of any of the ancestors, other than through "node" itself.
+ */
+static isl_bool can_update_ancestors_inplace(__isl_keep isl_schedule_node *node,
+	int n)
+{
+	int i;
+	isl_bool single;
+
+	if (n < 1 || node->ref != 1 || node->schedule->ref != 1)
+		return isl_bool_false;
+	single = isl_schedule_tree_list_has_single_reference(node->ancestors);
+	if (single < 0 || !single)
+		return single;
+
+	for (i = 0; i < n; ++i) {
+		isl_schedule_tree *tree, *parent;
+		isl_bool exclusive;
+
+		tree = isl_schedule_tree_list_peek(node->ancestors, i);
+		if (!tree)
+			return isl_bool_error;
+		if (tree->ref != 2)
+			return isl_bool_false;
+		if (i == 0) {
+			if (node->schedule->root != tree)
+				return isl_bool_false;
+			continue;
+		}
+		parent = isl_schedule_tree_list_peek(node->ancestors, i - 1);
+		exclusive = isl_schedule_tree_has_exclusive_child(parent,
+						node->child_pos[i - 1], tree);
+		if (exclusive < 0 || !exclusive)
+			return exclusive;
+	}
+
+	return isl_bool_true;
+}
+
+/* Update the "n" ancestors of "node" to point to the tree that "node"
+ * now points to, modifying the ancestors in place,
+ * where the caller has checked that this is allowed
+ * using can_update_ancestors_inplace.
+ *
+ * Only the parent of "node" needs to refer to a different child.
+ * The other ancestors keep referring to the same (modified) child, but
+ * their anchored fields may need to be updated.
+ */
+static __isl_give isl_schedule_node *update_ancestors_inplace(
+	__isl_take isl_schedule_node *node, int n)
+{
+	int i;
+	isl_schedule_tree *parent;
+
+	parent = isl_schedule_tree_list_peek(node->ancestors, n - 1);
+	if (isl_schedule_tree_replace_child_inplace(parent,
+			node->child_pos[n - 1],
+			isl_schedule_tree_copy(node->tree)) < 0)
+		return isl_schedule_node_free(node);
+	for (i = n - 2; i >= 0; --i) {
+		parent = isl_schedule_tree_list_peek(node->ancestors, i);
+		if (isl_schedule_tree_update_anchored_inplace(parent) < 0)
+			return isl_schedule_node_free(node);
+	}
+
+	if (isl_schedule_tree_is_leaf(node->tree)) {
+		isl_schedule_tree_free(node->tree);
+		node->tree = isl_schedule_node_get_leaf(node);
+		if (!node->tree)
+			return isl_schedule_node_free(node);
+	}
+
+	return node;
+}
+
 /* Update the ancestors of "node" to point to the tree that "node"
  * now points to.
  * That is, replace the child in the original parent that corresponds
@@ -2427,6 +2537,10 @@ __isl_give isl_schedule_node *isl_schedule_node_sequence_splice_children(
  *
  * If "node" originally points to a leaf of the schedule tree, then make sure
  * that in the end it points to a leaf in the updated schedule tree.
+ *
+ * If "fn" is NULL and "node" is the only user of the path
+ * from the root to "node", then the ancestors are modified in place
+ * instead of being copied.
  */
 static __isl_give isl_schedule_node *update_ancestors(
 	__isl_take isl_schedule_node *node,
@@ -2449,6 +2563,15 @@ static __isl_give isl_schedule_node *update_ancestors(
 	n = isl_schedule_tree_list_n_schedule_tree(node->ancestors);
 	if (n < 0)
 		return isl_schedule_node_free(pos);
+	if (!fn) {
+		isl_bool inplace;
+
+		inplace = can_update_ancestors_inplace(node, n);
+		if (inplace < 0)
+			return isl_schedule_node_free(node);
+		if (inplace)
+			return update_ancestors_inplace(node, n);
+	}
 	tree = isl_schedule_tree_copy(node->tree);
 
 	for (i = n - 1; i >= 0; --i) {
@@ -15,6 +15,9 @@
  * "child_pos" is an array of child positions of the same length as "ancestors",
  * where ancestor i (i > 0) appears in child_pos[i - 1] of ancestor i - 1 and
  * "tree" appears in child_pos[n - 1] of ancestor n - 1.
+ * "child_pos_size" is the number of elements allocated for "child_pos",
+ * which may be larger than n, such that moving back down the tree
+ * after moving up does not require a reallocation.
  * "tree" is the subtree at the specified location.
  *
  * Note that the same isl_schedule_tree object may appear several times
@@ -27,6 +30,7 @@ struct isl_schedule_node {
 	isl_schedule *schedule;
 	isl_schedule_tree_list *ancestors;
 	int *child_pos;
+	int child_pos_size;
 	isl_schedule_tree *tree;
 };
 
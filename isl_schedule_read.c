@@ -1,5 +1,6 @@
 #include <isl/id.h>
 #include <isl/val.h>
+#include <isl/space.h>
 #include <isl/schedule.h>
 #include <isl/stream.h>
 #include <isl_schedule_private.h>
@@ -58,19 +59,38 @@ static char *key_str[] = {
 #define KEY_END isl_schedule_key_end
 #include "extract_key.c"
 
+#undef BASE
+#define BASE set
+#include "isl_schedule_read_aligned_templ.c"
+
+#undef BASE
+#define BASE union_set
+#include "isl_schedule_read_aligned_templ.c"
+
+#undef BASE
+#define BASE union_map
+#include "isl_schedule_read_aligned_templ.c"
+
+#undef BASE
+#define BASE union_pw_multi_aff
+#include "isl_schedule_read_aligned_templ.c"
+
+#undef BASE
+#define BASE multi_union_pw_aff
+#include "isl_schedule_read_aligned_templ.c"
+
 static __isl_give isl_schedule_tree *isl_stream_read_schedule_tree(
-	__isl_keep isl_stream *s);
+	__isl_keep isl_stream *s, isl_space **params);
 
 /* Read a subtree with context root node from "s".
  */
-static __isl_give isl_schedule_tree *read_context(__isl_keep isl_stream *s)
+static __isl_give isl_schedule_tree *read_context(__isl_keep isl_stream *s,
+	isl_space **params)
 {
 	isl_set *context = NULL;
 	isl_schedule_tree *tree;
 	isl_ctx *ctx;
-	struct isl_token *tok;
 	enum isl_schedule_key key;
-	char *str;
 	int more;
 
 	ctx = isl_stream_get_ctx(s);
@@ -80,15 +100,9 @@ static __isl_give isl_schedule_tree *read_context(__isl_keep isl_stream *s)
 	if (isl_stream_yaml_next(s) < 0)
 		return NULL;
 
-	tok = isl_stream_next_token(s);
-	if (!tok) {
-		isl_stream_error(s, NULL, "unexpected EOF");
+	context = read_aligned_set(s, params);
+	if (!context)
 		return NULL;
-	}
-	str = isl_token_get_str(ctx, tok);
-	context = isl_set_read_from_str(ctx, str);
-	free(str);
-	isl_token_free(tok);
 
 	more = isl_stream_yaml_next(s);
 	if (more < 0)
@@ -102,7 +116,7 @@ static __isl_give isl_schedule_tree *read_context(__isl_keep isl_stream *s)
 				goto error);
 		if (isl_stream_yaml_next(s) < 0)
 			goto error;
-		tree = isl_stream_read_schedule_tree(s);
+		tree = isl_stream_read_schedule_tree(s, params);
 		tree = isl_schedule_tree_insert_context(tree, context);
 	}
 
@@ -114,14 +128,13 @@ error:
 
 /* Read a subtree with domain root node from "s".
  */
-static __isl_give isl_schedule_tree *read_domain(__isl_keep isl_stream *s)
+static __isl_give isl_schedule_tree *read_domain(__isl_keep isl_stream *s,
+	isl_space **params)
 {
 	isl_union_set *domain = NULL;
 	isl_schedule_tree *tree;
 	isl_ctx *ctx;
-	struct isl_token *tok;
 	enum isl_schedule_key key;
-	char *str;
 	int more;
 
 	ctx = isl_stream_get_ctx(s);
@@ -131,15 +144,9 @@ static __isl_give isl_schedule_tree *read_domain(__isl_keep isl_stream *s)
 	if (isl_stream_yaml_next(s) < 0)
 		return NULL;
 
-	tok = isl_stream_next_token(s);
-	if (!tok) {
-		isl_stream_error(s, NULL, "unexpected EOF");
+	domain = read_aligned_union_set(s, params);
+	if (!domain)
 		return NULL;
-	}
-	str = isl_token_get_str(ctx, tok);
-	domain = isl_union_set_read_from_str(ctx, str);
-	free(str);
-	isl_token_free(tok);
 
 	more = isl_stream_yaml_next(s);
 	if (more < 0)
@@ -153,7 +160,7 @@ static __isl_give isl_schedule_tree *read_domain(__isl_keep isl_stream *s)
 				goto error);
 		if (isl_stream_yaml_next(s) < 0)
 			goto error;
-		tree = isl_stream_read_schedule_tree(s);
+		tree = isl_stream_read_schedule_tree(s, params);
 		tree = isl_schedule_tree_insert_domain(tree, domain);
 	}
 
@@ -165,7 +172,8 @@ error:
 
 /* Read a subtree with expansion root node from "s".
  */
-static __isl_give isl_schedule_tree *read_expansion(isl_stream *s)
+static __isl_give isl_schedule_tree *read_expansion(isl_stream *s,
+	isl_space **params)
 {
 	isl_ctx *ctx;
 	isl_union_pw_multi_aff *contraction = NULL;
@@ -176,9 +184,7 @@ static __isl_give isl_schedule_tree *read_expansion(isl_stream *s)
 	ctx = isl_stream_get_ctx(s);
 
 	do {
-		struct isl_token *tok;
 		enum isl_schedule_key key;
-		char *str;
 
 		key = get_key(s);
 		if (isl_stream_yaml_next(s) < 0)
@@ -187,28 +193,20 @@ static __isl_give isl_schedule_tree *read_expansion(isl_stream *s)
 		switch (key) {
 		case isl_schedule_key_contraction:
 			isl_union_pw_multi_aff_free(contraction);
-			tok = isl_stream_next_token(s);
-			str = isl_token_get_str(ctx, tok);
-			contraction = isl_union_pw_multi_aff_read_from_str(ctx,
-									str);
-			free(str);
-			isl_token_free(tok);
+			contraction = read_aligned_union_pw_multi_aff(s,
+								params);
 			if (!contraction)
 				goto error;
 			break;
 		case isl_schedule_key_expansion:
 			isl_union_map_free(expansion);
-			tok = isl_stream_next_token(s);
-			str = isl_token_get_str(ctx, tok);
-			expansion = isl_union_map_read_from_str(ctx, str);
-			free(str);
-			isl_token_free(tok);
+			expansion = read_aligned_union_map(s, params);
 			if (!expansion)
 				goto error;
 			break;
 		case isl_schedule_key_child:
 			isl_schedule_tree_free(tree);
-			tree = isl_stream_read_schedule_tree(s);
+			tree = isl_stream_read_schedule_tree(s, params);
 			if (!tree)
 				goto error;
 			break;
@@ -240,14 +238,13 @@ error:
 
 /* Read a subtree with extension root node from "s".
  */
-static __isl_give isl_schedule_tree *read_extension(isl_stream *s)
+static __isl_give isl_schedule_tree *read_extension(isl_stream *s,
+	isl_space **params)
 {
 	isl_union_map *extension = NULL;
 	isl_schedule_tree *tree;
 	isl_ctx *ctx;
-	struct isl_token *tok;
 	enum isl_schedule_key key;
-	char *str;
 	int more;
 
 	ctx = isl_stream_get_ctx(s);
@@ -257,15 +254,9 @@ static __isl_give isl_schedule_tree *read_extension(isl_stream *s)
 	if (isl_stream_yaml_next(s) < 0)
 		return NULL;
 
-	tok = isl_stream_next_token(s);
-	if (!tok) {
-		isl_stream_error(s, NULL, "unexpected EOF");
+	extension = read_aligned_union_map(s, params);
+	if (!extension)
 		return NULL;
-	}
-	str = isl_token_get_str(ctx, tok);
-	extension = isl_union_map_read_from_str(ctx, str);
-	free(str);
-	isl_token_free(tok);
 
 	more = isl_stream_yaml_next(s);
 	if (more < 0)
@@ -279,7 +270,7 @@ static __isl_give isl_schedule_tree *read_extension(isl_stream *s)
 				goto error);
 		if (isl_stream_yaml_next(s) < 0)
 			goto error;
-		tree = isl_stream_read_schedule_tree(s);
+		tree = isl_stream_read_schedule_tree(s, params);
 		tree = isl_schedule_tree_insert_extension(tree, extension);
 	}
 
@@ -291,14 +282,13 @@ error:
 
 /* Read a subtree with filter root node from "s".
  */
-static __isl_give isl_schedule_tree *read_filter(__isl_keep isl_stream *s)
+static __isl_give isl_schedule_tree *read_filter(__isl_keep isl_stream *s,
+	isl_space **params)
 {
 	isl_union_set *filter = NULL;
 	isl_schedule_tree *tree;
 	isl_ctx *ctx;
-	struct isl_token *tok;
 	enum isl_schedule_key key;
-	char *str;
 	int more;
 
 	ctx = isl_stream_get_ctx(s);
@@ -308,15 +298,9 @@ static __isl_give isl_schedule_tree *read_filter(__isl_keep isl_stream *s)
 	if (isl_stream_yaml_next(s) < 0)
 		return NULL;
 
-	tok = isl_stream_next_token(s);
-	if (!tok) {
-		isl_stream_error(s, NULL, "unexpected EOF");
+	filter = read_aligned_union_set(s, params);
+	if (!filter)
 		return NULL;
-	}
-	str = isl_token_get_str(ctx, tok);
-	filter = isl_union_set_read_from_str(ctx, str);
-	free(str);
-	isl_token_free(tok);
 
 	more = isl_stream_yaml_next(s);
 	if (more < 0)
@@ -330,7 +314,7 @@ static __isl_give isl_schedule_tree *read_filter(__isl_keep isl_stream *s)
 				goto error);
 		if (isl_stream_yaml_next(s) < 0)
 			goto error;
-		tree = isl_stream_read_schedule_tree(s);
+		tree = isl_stream_read_schedule_tree(s, params);
 		tree = isl_schedule_tree_insert_filter(tree, filter);
 	}
 
@@ -342,14 +326,13 @@ error:
 
 /* Read a subtree with guard root node from "s".
  */
-static __isl_give isl_schedule_tree *read_guard(isl_stream *s)
+static __isl_give isl_schedule_tree *read_guard(isl_stream *s,
+	isl_space **params)
 {
 	isl_set *guard = NULL;
 	isl_schedule_tree *tree;
 	isl_ctx *ctx;
-	struct isl_token *tok;
 	enum isl_schedule_key key;
-	char *str;
 	int more;
 
 	ctx = isl_stream_get_ctx(s);
@@ -359,15 +342,9 @@ static __isl_give isl_schedule_tree *read_guard(isl_stream *s)
 	if (isl_stream_yaml_next(s) < 0)
 		return NULL;
 
-	tok = isl_stream_next_token(s);
-	if (!tok) {
-		isl_stream_error(s, NULL, "unexpected EOF");
+	guard = read_aligned_set(s, params);
+	if (!guard)
 		return NULL;
-	}
-	str = isl_token_get_str(ctx, tok);
-	guard = isl_set_read_from_str(ctx, str);
-	free(str);
-	isl_token_free(tok);
 
 	more = isl_stream_yaml_next(s);
 	if (more < 0)
@@ -381,7 +358,7 @@ static __isl_give isl_schedule_tree *read_guard(isl_stream *s)
 				goto error);
 		if (isl_stream_yaml_next(s) < 0)
 			goto error;
-		tree = isl_stream_read_schedule_tree(s);
+		tree = isl_stream_read_schedule_tree(s, params);
 		tree = isl_schedule_tree_insert_guard(tree, guard);
 	}
 
@@ -393,12 +370,12 @@ error:
 
 /* Read a subtree with mark root node from "s".
  */
-static __isl_give isl_schedule_tree *read_mark(isl_stream *s)
+static __isl_give isl_schedule_tree *read_mark(isl_stream *s,
+	isl_space **params)
 {
 	isl_id *mark;
 	isl_schedule_tree *tree;
 	isl_ctx *ctx;
-	struct isl_token *tok;
 	enum isl_schedule_key key;
 	char *str;
 	int more;
@@ -410,15 +387,11 @@ static __isl_give isl_schedule_tree *read_mark(isl_stream *s)
 	if (isl_stream_yaml_next(s) < 0)
 		return NULL;
 
-	tok = isl_stream_next_token(s);
-	if (!tok) {
-		isl_stream_error(s, NULL, "unexpected EOF");
+	str = isl_stream_yaml_read_str(s);
+	if (!str)
 		return NULL;
-	}
-	str = isl_token_get_str(ctx, tok);
 	mark = isl_id_alloc(ctx, str, NULL);
 	free(str);
-	isl_token_free(tok);
 
 	more = isl_stream_yaml_next(s);
 	if (more < 0)
@@ -433,7 +406,7 @@ static __isl_give isl_schedule_tree *read_mark(isl_stream *s)
 				goto error);
 		if (isl_stream_yaml_next(s) < 0)
 			goto error;
-		tree = isl_stream_read_schedule_tree(s);
+		tree = isl_stream_read_schedule_tree(s, params);
 		tree = isl_schedule_tree_insert_mark(tree, mark);
 	}
 
@@ -501,7 +474,8 @@ static __isl_give isl_schedule_band *set_coincident(
 
 /* Read a subtree with band root node from "s".
  */
-static __isl_give isl_schedule_tree *read_band(isl_stream *s)
+static __isl_give isl_schedule_tree *read_band(isl_stream *s,
+	isl_space **params)
 {
 	isl_multi_union_pw_aff *schedule = NULL;
 	isl_schedule_tree *tree = NULL;
@@ -515,9 +489,7 @@ static __isl_give isl_schedule_tree *read_band(isl_stream *s)
 	ctx = isl_stream_get_ctx(s);
 
 	do {
-		struct isl_token *tok;
 		enum isl_schedule_key key;
-		char *str;
 		isl_val *v;
 
 		key = get_key(s);
@@ -527,16 +499,8 @@ static __isl_give isl_schedule_tree *read_band(isl_stream *s)
 		switch (key) {
 		case isl_schedule_key_schedule:
 			schedule = isl_multi_union_pw_aff_free(schedule);
-			tok = isl_stream_next_token(s);
-			if (!tok) {
-				isl_stream_error(s, NULL, "unexpected EOF");
-				goto error;
-			}
-			str = isl_token_get_str(ctx, tok);
-			schedule = isl_multi_union_pw_aff_read_from_str(ctx,
-									str);
-			free(str);
-			isl_token_free(tok);
+			schedule = read_aligned_multi_union_pw_aff(s,
+								params);
 			if (!schedule)
 				goto error;
 			break;
@@ -552,17 +516,13 @@ static __isl_give isl_schedule_tree *read_band(isl_stream *s)
 			break;
 		case isl_schedule_key_options:
 			isl_union_set_free(options);
-			tok = isl_stream_next_token(s);
-			str = isl_token_get_str(ctx, tok);
-			options = isl_union_set_read_from_str(ctx, str);
-			free(str);
-			isl_token_free(tok);
+			options = read_aligned_union_set(s, params);
 			if (!options)
 				goto error;
 			break;
 		case isl_schedule_key_child:
 			isl_schedule_tree_free(tree);
-			tree = isl_stream_read_schedule_tree(s);
+			tree = isl_stream_read_schedule_tree(s, params);
 			if (!tree)
 				goto error;
 			break;
@@ -602,7 +562,7 @@ error:
  * The node is represented by a sequence of children.
  */
 static __isl_give isl_schedule_tree *read_children(isl_stream *s,
-	enum isl_schedule_node_type type)
+	isl_space **params, enum isl_schedule_node_type type)
 {
 	isl_ctx *ctx;
 	isl_schedule_tree_list *list;
@@ -622,7 +582,7 @@ static __isl_give isl_schedule_tree *read_children(isl_stream *s,
 	while ((more = isl_stream_yaml_next(s)) > 0) {
 		isl_schedule_tree *tree;
 
-		tree = isl_stream_read_schedule_tree(s);
+		tree = isl_stream_read_schedule_tree(s, params);
 		list = isl_schedule_tree_list_add(list, tree);
 	}
 
@@ -634,16 +594,18 @@ static __isl_give isl_schedule_tree *read_children(isl_stream *s,
 
 /* Read a subtree with sequence root node from "s".
  */
-static __isl_give isl_schedule_tree *read_sequence(isl_stream *s)
+static __isl_give isl_schedule_tree *read_sequence(isl_stream *s,
+	isl_space **params)
 {
-	return read_children(s, isl_schedule_node_sequence);
+	return read_children(s, params, isl_schedule_node_sequence);
 }
 
 /* Read a subtree with set root node from "s".
  */
-static __isl_give isl_schedule_tree *read_set(isl_stream *s)
+static __isl_give isl_schedule_tree *read_set(isl_stream *s,
+	isl_space **params)
 {
-	return read_children(s, isl_schedule_node_set);
+	return read_children(s, params, isl_schedule_node_set);
 }
 
 /* Read a schedule (sub)tree from "s".
@@ -653,7 +615,7 @@ static __isl_give isl_schedule_tree *read_set(isl_stream *s)
  * nodes of this type.
  */
 static __isl_give isl_schedule_tree *isl_stream_read_schedule_tree(
-	struct isl_stream *s)
+	struct isl_stream *s, isl_space **params)
 {
 	enum isl_schedule_key key;
 	struct isl_token *tok;
@@ -677,42 +639,42 @@ static __isl_give isl_schedule_tree *isl_stream_read_schedule_tree(
 		return NULL;
 	switch (key) {
 	case isl_schedule_key_context:
-		tree = read_context(s);
+		tree = read_context(s, params);
 		break;
 	case isl_schedule_key_domain:
-		tree = read_domain(s);
+		tree = read_domain(s, params);
 		break;
 	case isl_schedule_key_contraction:
 	case isl_schedule_key_expansion:
-		tree = read_expansion(s);
+		tree = read_expansion(s, params);
 		break;
 	case isl_schedule_key_extension:
-		tree = read_extension(s);
+		tree = read_extension(s, params);
 		break;
 	case isl_schedule_key_filter:
-		tree = read_filter(s);
+		tree = read_filter(s, params);
 		break;
 	case isl_schedule_key_guard:
-		tree = read_guard(s);
+		tree = read_guard(s, params);
 		break;
 	case isl_schedule_key_leaf:
 		isl_token_free(isl_stream_next_token(s));
 		tree = isl_schedule_tree_leaf(isl_stream_get_ctx(s));
 		break;
 	case isl_schedule_key_mark:
-		tree = read_mark(s);
+		tree = read_mark(s, params);
 		break;
 	case isl_schedule_key_sequence:
-		tree = read_sequence(s);
+		tree = read_sequence(s, params);
 		break;
 	case isl_schedule_key_set:
-		tree = read_set(s);
+		tree = read_set(s, params);
 		break;
 	case isl_schedule_key_schedule:
 	case isl_schedule_key_coincident:
 	case isl_schedule_key_options:
 	case isl_schedule_key_permutable:
-		tree = read_band(s);
+		tree = read_band(s, params);
 		break;
 	case isl_schedule_key_child:
 		isl_die(isl_stream_get_ctx(s), isl_error_unsupported,
@@ -735,13 +697,15 @@ static __isl_give isl_schedule_tree *isl_stream_read_schedule_tree(
 __isl_give isl_schedule *isl_stream_read_schedule(isl_stream *s)
 {
 	isl_ctx *ctx;
+	isl_space *params = NULL;
 	isl_schedule_tree *tree;
 
 	if (!s)
 		return NULL;
 
 	ctx = isl_stream_get_ctx(s);
-	tree = isl_stream_read_schedule_tree(s);
+	tree = isl_stream_read_schedule_tree(s, &params);
+	isl_space_free(params);
 	return isl_schedule_from_schedule_tree(ctx, tree);
 }
 
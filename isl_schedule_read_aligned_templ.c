@@ -0,0 +1,34 @@
+#define xCAT(A,B) A ## B
+#define CAT(A,B) xCAT(A,B)
+#undef TYPE
+#define TYPE CAT(isl_,BASE)
+#define xFN(TYPE,NAME) TYPE ## _ ## NAME
+#define FN(TYPE,NAME) xFN(TYPE,NAME)
+
+/* Read an object of type TYPE from the next (string) value of "s" and
+ * align its parameters to *params, if any.
+ * Update *params to the parameters of the result, which start
+ * with the original parameters in *params.
+ */
+static __isl_give TYPE *FN(read_aligned,BASE)(__isl_keep isl_stream *s,
+	isl_space **params)
+{
+	char *str;
+	TYPE *obj;
+
+	str = isl_stream_yaml_read_str(s);
+	if (!str)
+		return NULL;
+	obj = FN(TYPE,read_from_str)(isl_stream_get_ctx(s), str);
+	free(str);
+	if (*params)
+		obj = FN(TYPE,align_params)(obj, isl_space_copy(*params));
+	if (!obj)
+		return NULL;
+	isl_space_free(*params);
+	*params = isl_space_params(FN(TYPE,get_space)(obj));
+	if (!*params)
+		return FN(TYPE,free)(obj);
+
+	return obj;
+}
@@ -144,8 +144,113 @@ __isl_give isl_schedule_tree *isl_schedule_tree_dup(
 	return dup;
 }
 
+/* Return a copy of "tree" in "ctx".
+ * Unless "tree" already belongs to "ctx", "tree" itself
+ * is not modified, not even its reference count.
+ * The children are therefore accessed without taking
+ * an additional reference.
+ * Copying expansion nodes is not supported.
+ */
+__isl_give isl_schedule_tree *isl_schedule_tree_copy_to_ctx(
+	__isl_keep isl_schedule_tree *tree, isl_ctx *ctx)
+{
+	int i;
+	isl_schedule_tree *dup;
+
+	if (!tree)
+		return NULL;
+	if (tree->ctx == ctx)
+		return isl_schedule_tree_copy(tree);
+
+	dup = isl_schedule_tree_alloc(ctx, tree->type);
+	if (!dup)
+		return NULL;
+
+	switch (tree->type) {
+	case isl_schedule_node_error:
+		isl_die(ctx, isl_error_internal,
+			"allocation should have failed",
+			return isl_schedule_tree_free(dup));
+	case isl_schedule_node_band:
+		dup->band = isl_schedule_band_copy_to_ctx(tree->band, ctx);
+		if (!dup->band)
+			return isl_schedule_tree_free(dup);
+		break;
+	case isl_schedule_node_context:
+		dup->context = isl_set_copy_to_ctx(tree->context, ctx);
+		if (!dup->context)
+			return isl_schedule_tree_free(dup);
+		break;
+	case isl_schedule_node_domain:
+		dup->domain = isl_union_set_copy_to_ctx(tree->domain, ctx);
+		if (!dup->domain)
+			return isl_schedule_tree_free(dup);
+		break;
+	case isl_schedule_node_expansion:
+		isl_die(ctx, isl_error_unsupported,
+			"cannot copy expansion nodes to another context",
+			return isl_schedule_tree_free(dup));
+	case isl_schedule_node_extension:
+		dup->extension = isl_union_map_copy_to_ctx(tree->extension, ctx);
+		if (!dup->extension)
+			return isl_schedule_tree_free(dup);
+		break;
+	case isl_schedule_node_filter:
+		dup->filter = isl_union_set_copy_to_ctx(tree->filter, ctx);
+		if (!dup->filter)
+			return isl_schedule_tree_free(dup);
+		break;
+	case isl_schedule_node_guard:
+		dup->guard = isl_set_copy_to_ctx(tree->guard, ctx);
+		if (!dup->guard)
+			return isl_schedule_tree_free(dup);
+		break;
+	case isl_schedule_node_mark:
+		dup->mark = isl_id_copy_to_ctx(tree->mark, ctx);
+		if (!dup->mark)
+			return isl_schedule_tree_free(dup);
+		break;
+	case isl_schedule_node_leaf:
+	case isl_schedule_node_sequence:
+	case isl_schedule_node_set:
+		break;
+	}
+
+	if (tree->children) {
+		isl_size n;
+
+		n = isl_schedule_tree_list_size(tree->children);
+		if (n < 0)
+			return isl_schedule_tree_free(dup);
+		dup->children = isl_schedule_tree_list_alloc(ctx, n);
+		for (i = 0; i < n; ++i) {
+			isl_schedule_tree *child;
+
+			child = isl_schedule_tree_list_peek(tree->children, i);
+			child = isl_schedule_tree_copy_to_ctx(child, ctx);
+			dup->children = isl_schedule_tree_list_add(
+						dup->children, child);
+		}
+		if (!dup->children)
+			return isl_schedule_tree_free(dup);
+	}
+	dup->anchored = tree->anchored;
+
+	return dup;
+}
+
+/* Drop the cached subtree schedule of "tree", if any,
+ * because "tree" is about to be modified.
+ */
+static void clear_cache(__isl_keep isl_schedule_tree *tree)
+{
+	tree->subtree_schedule = isl_union_map_free(tree->subtree_schedule);
+}
+
 /* Return an isl_schedule_tree that is equal to "tree" and that has only
  * a single reference.
+ * Since the result is about to be modified, any cached information
+ * is dropped.  The cached information is not copied to a fresh copy.
  */
 __isl_give isl_schedule_tree *isl_schedule_tree_cow(
 	__isl_take isl_schedule_tree *tree)
@@ -153,8 +258,10 @@ __isl_give isl_schedule_tree *isl_schedule_tree_cow(
 	if (!tree)
 		return NULL;
 
-	if (tree->ref == 1)
+	if (tree->ref == 1) {
+		clear_cache(tree);
 		return tree;
+	}
 	tree->ref--;
 	return isl_schedule_tree_dup(tree);
 }
@@ -181,6 +288,7 @@ __isl_null isl_schedule_tree *isl_schedule_tree_free(
 	if (--tree->ref > 0)
 		return NULL;
 
+	clear_cache(tree);
 	switch (tree->type) {
 	case isl_schedule_node_band:
 		isl_schedule_band_free(tree->band);
@@ -478,14 +586,11 @@ int isl_schedule_tree_is_anchored(__isl_keep isl_schedule_tree *tree)
 		"unhandled case", return -1);
 }
 
-/* Update the anchored field of "tree" based on whether the root node
- * itself in anchored and the anchored fields of the children.
- *
- * This function should be called whenever the children of a tree node
- * are changed or the anchoredness of the tree root itself changes.
+/* Compute the value of the anchored field of "tree" based on
+ * whether the root node itself in anchored and the anchored fields
+ * of the children.
  */
-__isl_give isl_schedule_tree *isl_schedule_tree_update_anchored(
-	__isl_take isl_schedule_tree *tree)
+static int compute_anchored(__isl_keep isl_schedule_tree *tree)
 {
 	int i;
 	isl_size n;
@@ -494,18 +599,35 @@ __isl_give isl_schedule_tree *isl_schedule_tree_update_anchored(
 	anchored = isl_schedule_tree_is_anchored(tree);
 	n = isl_schedule_tree_n_children(tree);
 	if (anchored < 0 || n < 0)
-		return isl_schedule_tree_free(tree);
+		return -1;
 
 	for (i = 0; !anchored && i < n; ++i) {
 		isl_schedule_tree *child;
 
-		child = isl_schedule_tree_get_child(tree, i);
+		child = isl_schedule_tree_list_peek(tree->children, i);
 		if (!child)
-			return isl_schedule_tree_free(tree);
+			return -1;
 		anchored = child->anchored;
-		isl_schedule_tree_free(child);
 	}
 
+	return anchored;
+}
+
+/* Update the anchored field of "tree" based on whether the root node
+ * itself in anchored and the anchored fields of the children.
+ *
+ * This function should be called whenever the children of a tree node
+ * are changed or the anchoredness of the tree root itself changes.
+ */
+__isl_give isl_schedule_tree *isl_schedule_tree_update_anchored(
+	__isl_take isl_schedule_tree *tree)
+{
+	int anchored;
+
+	anchored = compute_anchored(tree);
+	if (anchored < 0)
+		return isl_schedule_tree_free(tree);
+
 	if (anchored == tree->anchored)
 		return tree;
 	tree = isl_schedule_tree_cow(tree);
@@ -515,6 +637,23 @@ __isl_give isl_schedule_tree *isl_schedule_tree_update_anchored(
 	return tree;
 }
 
+/* Update the anchored field of "tree" in place.
+ * The caller is responsible for ensuring that the modification
+ * does not affect any other users of "tree".
+ */
+isl_stat isl_schedule_tree_update_anchored_inplace(
+	__isl_keep isl_schedule_tree *tree)
+{
+	int anchored;
+
+	anchored = compute_anchored(tree);
+	if (anchored < 0)
+		return isl_stat_error;
+	clear_cache(tree);
+	tree->anchored = anchored;
+	return isl_stat_ok;
+}
+
 /* Create a new tree of the given type (isl_schedule_node_sequence or
  * isl_schedule_node_set) with the given children.
  */
@@ -798,7 +937,10 @@ __isl_give isl_schedule_tree *isl_schedule_tree_drop_child(
 	return tree;
 }
 
-/* Replace the child at position "pos" of "tree" by "child".
+/* Replace the child at position "pos" of "tree" by "child",
+ * modifying "tree" in place.
+ * The caller is responsible for ensuring that the modification
+ * does not affect any other users of "tree".
  *
  * If the new child is a leaf, then it is not explicitly
  * recorded in the list of children.  Instead, the list of children
@@ -806,29 +948,30 @@ __isl_give isl_schedule_tree *isl_schedule_tree_drop_child(
  * Note that the children of set and sequence nodes are always
  * filters, so they cannot be replaced by empty trees.
  */
-__isl_give isl_schedule_tree *isl_schedule_tree_replace_child(
-	__isl_take isl_schedule_tree *tree, int pos,
+isl_stat isl_schedule_tree_replace_child_inplace(
+	__isl_keep isl_schedule_tree *tree, int pos,
 	__isl_take isl_schedule_tree *child)
 {
-	tree = isl_schedule_tree_cow(tree);
 	if (!tree || !child)
 		goto error;
 
+	clear_cache(tree);
 	if (isl_schedule_tree_is_leaf(child)) {
 		isl_size n;
 
 		isl_schedule_tree_free(child);
 		if (!tree->children && pos == 0)
-			return tree;
+			return isl_stat_ok;
 		n = isl_schedule_tree_n_children(tree);
 		if (n < 0)
-			return isl_schedule_tree_free(tree);
+			return isl_stat_error;
 		if (n != 1)
 			isl_die(isl_schedule_tree_get_ctx(tree),
 				isl_error_internal,
 				"can only replace single child by leaf",
-				goto error);
-		return isl_schedule_tree_reset_children(tree);
+				return isl_stat_error);
+		tree->children = isl_schedule_tree_list_free(tree->children);
+		return isl_stat_ok;
 	}
 
 	if (!tree->children && pos == 0)
@@ -839,14 +982,49 @@ __isl_give isl_schedule_tree *isl_schedule_tree_replace_child(
 				tree->children, pos, child);
 
 	if (!tree->children)
-		return isl_schedule_tree_free(tree);
-	tree = isl_schedule_tree_update_anchored(tree);
-
-	return tree;
+		return isl_stat_error;
+	return isl_schedule_tree_update_anchored_inplace(tree);
 error:
-	isl_schedule_tree_free(tree);
 	isl_schedule_tree_free(child);
-	return NULL;
+	return isl_stat_error;
+}
+
+/* Replace the child at position "pos" of "tree" by "child".
+ */
+__isl_give isl_schedule_tree *isl_schedule_tree_replace_child(
+	__isl_take isl_schedule_tree *tree, int pos,
+	__isl_take isl_schedule_tree *child)
+{
+	tree = isl_schedule_tree_cow(tree);
+	if (isl_schedule_tree_replace_child_inplace(tree, pos, child) < 0)
+		return isl_schedule_tree_free(tree);
+	return tree;
+}
+
+/* Is "child" the child at position "pos" of "tree",
+ * stored in a list of children that is only referenced by "tree"?
+ */
+isl_bool isl_schedule_tree_has_exclusive_child(
+	__isl_keep isl_schedule_tree *tree, int pos,
+	__isl_keep isl_schedule_tree *child)
+{
+	if (!tree || !child)
+		return isl_bool_error;
+	if (!tree->children || tree->children->ref != 1)
+		return isl_bool_false;
+	if (pos < 0 || pos >= tree->children->n)
+		return isl_bool_false;
+	return isl_bool_ok(tree->children->p[pos] == child);
+}
+
+/* Does "list" have only a single reference?
+ */
+isl_bool isl_schedule_tree_list_has_single_reference(
+	__isl_keep isl_schedule_tree_list *list)
+{
+	if (!list)
+		return isl_bool_error;
+	return isl_bool_ok(list->ref == 1);
 }
 
 /* Replace the (explicit) children of "tree" by "children"?
@@ -2014,16 +2192,37 @@ static __isl_give isl_union_set *initial_domain(
  * We start with an initial zero-dimensional subtree schedule based
  * on the domain information in the root node and then extend it
  * based on the schedule information in the root node and its descendants.
+ *
+ * The result only depends on the tree itself and
+ * on the schedule_separate_components option, so it is cached
+ * in "tree" for as long as "tree" is not modified.
+ * Note that "tree" may be shared, but all users see the same subtree.
  */
 __isl_give isl_union_map *isl_schedule_tree_get_subtree_schedule_union_map(
 	__isl_keep isl_schedule_tree *tree)
 {
+	int separate;
 	isl_union_set *domain;
 	isl_union_map *umap;
 
+	if (!tree)
+		return NULL;
+
+	separate = isl_options_get_schedule_separate_components(tree->ctx);
+	if (tree->subtree_schedule &&
+	    tree->subtree_schedule_separate == separate)
+		return isl_union_map_copy(tree->subtree_schedule);
+
 	domain = initial_domain(tree);
 	umap = isl_union_map_from_domain(domain);
-	return subtree_schedule_extend(tree, umap);
+	umap = subtree_schedule_extend(tree, umap);
+	if (!umap)
+		return NULL;
+
+	isl_union_map_free(tree->subtree_schedule);
+	tree->subtree_schedule = isl_union_map_copy(umap);
+	tree->subtree_schedule_separate = separate;
+	return umap;
 }
 
 /* Multiply the partial schedule of the band root node of "tree"
@@ -2670,6 +2869,31 @@ static isl_bool any_coincident(__isl_keep isl_schedule_band *band)
 	return isl_bool_false;
 }
 
+#undef BASE
+#define BASE str
+#define isl_str const char
+#include "print_yaml_field_templ.c"
+
+#undef BASE
+#define BASE set
+#include "print_yaml_field_templ.c"
+
+#undef BASE
+#define BASE union_set
+#include "print_yaml_field_templ.c"
+
+#undef BASE
+#define BASE union_map
+#include "print_yaml_field_templ.c"
+
+#undef BASE
+#define BASE union_pw_multi_aff
+#include "print_yaml_field_templ.c"
+
+#undef BASE
+#define BASE multi_union_pw_aff
+#include "print_yaml_field_templ.c"
+
 /* Print the band node "band" to "p".
  *
  * The permutable and coincident properties are only printed if they
@@ -2683,16 +2907,12 @@ static __isl_give isl_printer *print_tree_band(__isl_take isl_printer *p,
 	isl_bool empty;
 	isl_bool coincident;
 
-	p = isl_printer_print_str(p, "schedule");
-	p = isl_printer_yaml_next(p);
-	p = isl_printer_print_str(p, "\"");
-	p = isl_printer_print_multi_union_pw_aff(p, band->mupa);
-	p = isl_printer_print_str(p, "\"");
+	p = print_yaml_field_multi_union_pw_aff(p, "schedule", band->mupa);
 	if (isl_schedule_band_get_permutable(band)) {
-		p = isl_printer_yaml_next(p);
 		p = isl_printer_print_str(p, "permutable");
 		p = isl_printer_yaml_next(p);
 		p = isl_printer_print_int(p, 1);
+		p = isl_printer_yaml_next(p);
 	}
 	coincident = any_coincident(band);
 	if (coincident < 0)
@@ -2702,7 +2922,6 @@ static __isl_give isl_printer *print_tree_band(__isl_take isl_printer *p,
 		isl_size n;
 		int style;
 
-		p = isl_printer_yaml_next(p);
 		p = isl_printer_print_str(p, "coincident");
 		p = isl_printer_yaml_next(p);
 		style = isl_printer_get_yaml_style(p);
@@ -2718,45 +2937,19 @@ static __isl_give isl_printer *print_tree_band(__isl_take isl_printer *p,
 		}
 		p = isl_printer_yaml_end_sequence(p);
 		p = isl_printer_set_yaml_style(p, style);
+		p = isl_printer_yaml_next(p);
 	}
 	options = isl_schedule_band_get_ast_build_options(band);
 	empty = isl_union_set_is_empty(options);
 	if (empty < 0)
 		p = isl_printer_free(p);
-	if (!empty) {
-		p = isl_printer_yaml_next(p);
-		p = isl_printer_print_str(p, "options");
-		p = isl_printer_yaml_next(p);
-		p = isl_printer_print_str(p, "\"");
-		p = isl_printer_print_union_set(p, options);
-		p = isl_printer_print_str(p, "\"");
-	}
+	if (!empty)
+		p = print_yaml_field_union_set(p, "options", options);
 	isl_union_set_free(options);
 
 	return p;
 }
 
-#undef BASE
-#define BASE str
-#define isl_str const char
-#include "print_yaml_field_templ.c"
-
-#undef BASE
-#define BASE set
-#include "print_yaml_field_templ.c"
-
-#undef BASE
-#define BASE union_set
-#include "print_yaml_field_templ.c"
-
-#undef BASE
-#define BASE union_map
-#include "print_yaml_field_templ.c"
-
-#undef BASE
-#define BASE union_pw_multi_aff
-#include "print_yaml_field_templ.c"
-
 /* Print "tree" to "p".
  *
  * If "n_ancestor" is non-negative, then "child_pos" contains the child
@@ -2830,7 +3023,6 @@ __isl_give isl_printer *isl_printer_print_schedule_tree_mark(
 		break;
 	case isl_schedule_node_band:
 		p = print_tree_band(p, tree->band);
-		p = isl_printer_yaml_next(p);
 		break;
 	}
 
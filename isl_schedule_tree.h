@@ -5,11 +5,13 @@
 #include <isl/schedule.h>
 #include <isl/set.h>
 #include <isl/union_set.h>
+#include <isl_list_private.h>
 
 struct isl_schedule_tree;
 typedef struct isl_schedule_tree isl_schedule_tree;
 
 ISL_DECLARE_LIST(schedule_tree)
+ISL_DECLARE_LIST_FN_PRIVATE(schedule_tree)
 
 /* A schedule (sub)tree.
  *
@@ -50,6 +52,12 @@ ISL_DECLARE_LIST(schedule_tree)
  *
  * anchored is set if the node or any of its descendants depends
  * on its position in the schedule tree.
+ *
+ * "subtree_schedule" caches the result of
+ * isl_schedule_tree_get_subtree_schedule_union_map, computed
+ * with the schedule_separate_components option set to
+ * "subtree_schedule_separate", if it has already been computed.
+ * It is dropped whenever the tree is (about to be) modified.
  */
 struct isl_schedule_tree {
 	int ref;
@@ -70,6 +78,9 @@ struct isl_schedule_tree {
 		isl_id *mark;
 	};
 	isl_schedule_tree_list *children;
+
+	isl_union_map *subtree_schedule;
+	int subtree_schedule_separate;
 };
 
 isl_ctx *isl_schedule_tree_get_ctx(__isl_keep isl_schedule_tree *tree);
@@ -84,6 +95,8 @@ isl_bool isl_schedule_tree_plain_is_equal(__isl_keep isl_schedule_tree *tree1,
 
 __isl_give isl_schedule_tree *isl_schedule_tree_copy(
 	__isl_keep isl_schedule_tree *tree);
+__isl_give isl_schedule_tree *isl_schedule_tree_copy_to_ctx(
+	__isl_keep isl_schedule_tree *tree, isl_ctx *ctx);
 __isl_null isl_schedule_tree *isl_schedule_tree_free(
 	__isl_take isl_schedule_tree *tree);
 
@@ -245,6 +258,16 @@ __isl_give isl_schedule_tree *isl_schedule_tree_drop_child(
 __isl_give isl_schedule_tree *isl_schedule_tree_replace_child(
 	__isl_take isl_schedule_tree *tree, int pos,
 	__isl_take isl_schedule_tree *new_child);
+isl_stat isl_schedule_tree_replace_child_inplace(
+	__isl_keep isl_schedule_tree *tree, int pos,
+	__isl_take isl_schedule_tree *child);
+isl_stat isl_schedule_tree_update_anchored_inplace(
+	__isl_keep isl_schedule_tree *tree);
+isl_bool isl_schedule_tree_has_exclusive_child(
+	__isl_keep isl_schedule_tree *tree, int pos,
+	__isl_keep isl_schedule_tree *child);
+isl_bool isl_schedule_tree_list_has_single_reference(
+	__isl_keep isl_schedule_tree_list *list);
 __isl_give isl_schedule_tree *isl_schedule_tree_sequence_splice(
 	__isl_take isl_schedule_tree *tree, int pos,
 	__isl_take isl_schedule_tree *child);
@@ -39,6 +39,9 @@
 #include <isl_morph.h>
 #include <isl/ilp.h>
 #include <isl_val_private.h>
+#include <isl_schedule_tree.h>
+#include <isl_schedule_node_private.h>
+#include "isl_task.h"
 
 /*
  * The scheduling algorithm implemented in this file was inspired by
@@ -57,7 +60,8 @@
  * sched is a matrix representation of the schedule being constructed
  *	for this node; if compressed is set, then this schedule is
  *	defined over the compressed domain space
- * sched_map is an isl_map representation of the same (partial) schedule
+ * sched_map is an isl_map representation of the rows of the same
+ *	(partial) schedule starting at row sched_map_start
  *	sched_map may be NULL; if compressed is set, then this map
  *	is defined over the uncompressed domain space
  * rank is the number of linearly independent rows in the linear part
@@ -109,6 +113,7 @@ struct isl_sched_node {
 	isl_pw_multi_aff *decompress;
 	isl_mat *sched;
 	isl_map *sched_map;
+	int	 sched_map_start;
 	int	 rank;
 	isl_mat *indep;
 	isl_mat *vmap;
@@ -315,6 +320,9 @@ static int is_multi_edge_type(struct isl_sched_edge *edge)
  * if compression is involved then the key for these maps
  * is the original, uncompressed dependence relation, while
  * the value is the dual of the compressed dependence relation.
+ * These caches are only allocated in the original dependence graph
+ * (see "root" below) and are shared by all graphs derived from it,
+ * since the nodes of those graphs are compressed in the same way.
  *
  * n is the number of nodes
  * node is the list of nodes
@@ -558,28 +566,6 @@ static struct isl_sched_edge *graph_find_edge(struct isl_sched_graph *graph,
 	return entry->data;
 }
 
-/* Check whether the dependence graph has an edge of the given type
- * between the given two nodes.
- */
-static isl_bool graph_has_edge(struct isl_sched_graph *graph,
-	enum isl_edge_type type,
-	struct isl_sched_node *src, struct isl_sched_node *dst)
-{
-	struct isl_sched_edge dummy;
-	struct isl_sched_edge *edge;
-	isl_bool empty;
-
-	edge = graph_find_edge(graph, type, src, dst, &dummy);
-	if (!edge)
-		return isl_bool_error;
-	if (edge == &dummy)
-		return isl_bool_false;
-
-	empty = isl_map_plain_is_empty(edge->map);
-
-	return isl_bool_not(empty);
-}
-
 /* Look for any edge with the same src, dst and map fields as "model".
  *
  * Return the matching edge if one can be found.
@@ -634,47 +620,6 @@ static isl_stat graph_remove_edge(struct isl_sched_graph *graph,
 	return isl_stat_ok;
 }
 
-/* Check whether the dependence graph has any edge
- * between the given two nodes.
- */
-static isl_bool graph_has_any_edge(struct isl_sched_graph *graph,
-	struct isl_sched_node *src, struct isl_sched_node *dst)
-{
-	enum isl_edge_type i;
-	isl_bool r;
-
-	for (i = isl_edge_first; i <= isl_edge_last; ++i) {
-		r = graph_has_edge(graph, i, src, dst);
-		if (r < 0 || r)
-			return r;
-	}
-
-	return r;
-}
-
-/* Check whether the dependence graph has a validity edge
- * between the given two nodes.
- *
- * Conditional validity edges are essentially validity edges that
- * can be ignored if the corresponding condition edges are iteration private.
- * Here, we are only checking for the presence of validity
- * edges, so we need to consider the conditional validity edges too.
- * In particular, this function is used during the detection
- * of strongly connected components and we cannot ignore
- * conditional validity edges during this detection.
- */
-static isl_bool graph_has_validity_edge(struct isl_sched_graph *graph,
-	struct isl_sched_node *src, struct isl_sched_node *dst)
-{
-	isl_bool r;
-
-	r = graph_has_edge(graph, isl_edge_validity, src, dst);
-	if (r < 0 || r)
-		return r;
-
-	return graph_has_edge(graph, isl_edge_conditional_validity, src, dst);
-}
-
 /* Perform all the required memory allocations for a schedule graph "graph"
  * with "n_node" nodes and "n_edge" edge and initialize the corresponding
  * fields.
@@ -693,10 +638,6 @@ static isl_stat graph_alloc(isl_ctx *ctx, struct isl_sched_graph *graph,
 	graph->edge = isl_calloc_array(ctx,
 					struct isl_sched_edge, graph->n_edge);
 
-	graph->intra_hmap = isl_map_to_basic_set_alloc(ctx, 2 * n_edge);
-	graph->intra_hmap_param = isl_map_to_basic_set_alloc(ctx, 2 * n_edge);
-	graph->inter_hmap = isl_map_to_basic_set_alloc(ctx, 2 * n_edge);
-
 	if (!graph->node || !graph->region || (graph->n_edge && !graph->edge) ||
 	    !graph->sorted)
 		return isl_stat_error;
@@ -1551,18 +1492,34 @@ error:
 	return isl_stat_error;
 }
 
+/* Compare the spaces of "set1" and "set2".
+ */
+static int cmp_set_space(__isl_keep isl_set *set1, __isl_keep isl_set *set2,
+	void *user)
+{
+	return isl_space_cmp(isl_set_peek_space(set1),
+			    isl_set_peek_space(set2));
+}
+
 /* Initialize the schedule graph "graph" from the schedule constraints "sc".
  *
  * The context is included in the domain before the nodes of
  * the graphs are extracted in order to be able to exploit
  * any possible additional equalities.
  * Note that this intersection is only performed locally here.
+ *
+ * The nodes are extracted in the order of their spaces
+ * such that this order does not depend on the way the domain
+ * happens to be stored.  In particular, the relative order of the nodes
+ * is the same whether or not the schedule constraints have first
+ * been restricted to a weakly connected component.
  */
 static isl_stat graph_init(struct isl_sched_graph *graph,
 	__isl_keep isl_schedule_constraints *sc)
 {
 	isl_ctx *ctx;
 	isl_union_set *domain;
+	isl_set_list *list;
 	isl_union_map *c;
 	struct isl_extract_edge_data data;
 	enum isl_edge_type i;
@@ -1588,12 +1545,21 @@ static isl_stat graph_init(struct isl_sched_graph *graph,
 	if (compute_max_row(graph, sc) < 0)
 		return isl_stat_error;
 	graph->root = graph;
+	graph->intra_hmap = isl_map_to_basic_set_alloc(ctx, 2 * n);
+	graph->intra_hmap_param = isl_map_to_basic_set_alloc(ctx, 2 * n);
+	graph->inter_hmap = isl_map_to_basic_set_alloc(ctx, 2 * n);
+	if (!graph->intra_hmap || !graph->intra_hmap_param ||
+	    !graph->inter_hmap)
+		return isl_stat_error;
 	graph->n = 0;
 	domain = isl_schedule_constraints_get_domain(sc);
 	domain = isl_union_set_intersect_params(domain,
 				    isl_schedule_constraints_get_context(sc));
-	r = isl_union_set_foreach_set(domain, &extract_node, graph);
+	list = isl_union_set_get_set_list(domain);
 	isl_union_set_free(domain);
+	list = isl_set_list_sort(list, &cmp_set_space, NULL);
+	r = isl_set_list_foreach(list, &extract_node, graph);
+	isl_set_list_free(list);
 	if (r < 0)
 		return isl_stat_error;
 	if (graph_init_table(ctx, graph) < 0)
@@ -1626,40 +1592,14 @@ static isl_stat graph_init(struct isl_sched_graph *graph,
 	return isl_stat_ok;
 }
 
-/* Check whether there is any dependence from node[j] to node[i]
- * or from node[i] to node[j].
- */
-static isl_bool node_follows_weak(int i, int j, void *user)
-{
-	isl_bool f;
-	struct isl_sched_graph *graph = user;
-
-	f = graph_has_any_edge(graph, &graph->node[j], &graph->node[i]);
-	if (f < 0 || f)
-		return f;
-	return graph_has_any_edge(graph, &graph->node[i], &graph->node[j]);
-}
-
-/* Check whether there is a (conditional) validity dependence from node[j]
- * to node[i], forcing node[i] to follow node[j].
- */
-static isl_bool node_follows_strong(int i, int j, void *user)
-{
-	struct isl_sched_graph *graph = user;
-
-	return graph_has_validity_edge(graph, &graph->node[j], &graph->node[i]);
-}
-
-/* Use Tarjan's algorithm for computing the strongly connected components
- * in the dependence graph only considering those edges defined by "follows".
+/* Set the scc field of the nodes of "graph" and graph->scc
+ * based on the components computed in "g" and free "g".
  */
-static isl_stat detect_ccs(isl_ctx *ctx, struct isl_sched_graph *graph,
-	isl_bool (*follows)(int i, int j, void *user))
+static isl_stat set_ccs(struct isl_sched_graph *graph,
+	struct isl_tarjan_graph *g)
 {
 	int i, n;
-	struct isl_tarjan_graph *g = NULL;
 
-	g = isl_tarjan_graph_init(ctx, graph->n, follows, graph);
 	if (!g)
 		return isl_stat_error;
 
@@ -1681,14 +1621,317 @@ static isl_stat detect_ccs(isl_ctx *ctx, struct isl_sched_graph *graph,
 	return isl_stat_ok;
 }
 
+/* A pair of node indices such that node "i" follows node "j".
+ */
+struct isl_sched_follows {
+	int i;
+	int j;
+};
+
+/* Internal data structure for collect_follows.
+ *
+ * "graph" is the dependence graph.
+ * If "weak" is set, then each edge is considered in both directions.
+ * "follows" collects the pairs of nodes, "n" of which are in use.
+ */
+struct isl_collect_follows_data {
+	struct isl_sched_graph *graph;
+	int weak;
+	struct isl_sched_follows *follows;
+	int n;
+};
+
+/* Add the pair of nodes connected by the edge in "entry"
+ * to data->follows, if the edge is not obviously empty.
+ * The destination follows the source.
+ * If data->weak is set, then also add the reverse pair.
+ */
+static isl_stat collect_follows(void **entry, void *user)
+{
+	struct isl_collect_follows_data *data = user;
+	struct isl_sched_edge *edge = *entry;
+	int src, dst;
+	isl_bool empty;
+
+	empty = isl_map_plain_is_empty(edge->map);
+	if (empty < 0)
+		return isl_stat_error;
+	if (empty)
+		return isl_stat_ok;
+
+	src = edge->src - data->graph->node;
+	dst = edge->dst - data->graph->node;
+	data->follows[data->n].i = dst;
+	data->follows[data->n].j = src;
+	data->n++;
+	if (data->weak) {
+		data->follows[data->n].i = src;
+		data->follows[data->n].j = dst;
+		data->n++;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Compare two pairs of nodes, ordering them by increasing "i" and
+ * then by decreasing "j".
+ */
+static int cmp_follows(const void *a, const void *b, void *user)
+{
+	const struct isl_sched_follows *f1 = a;
+	const struct isl_sched_follows *f2 = b;
+
+	if (f1->i != f2->i)
+		return f1->i - f2->i;
+	return f2->j - f1->j;
+}
+
+/* The nodes that are followed by each node in a dependence graph,
+ * in terms of the edges in the graph.
+ * The nodes followed by node "i" are list[pos[i]], ..., list[pos[i + 1] - 1],
+ * sorted in decreasing order.
+ */
+struct isl_sched_adjacency {
+	int *pos;
+	int *list;
+};
+
+/* Free the memory allocated for "adj".
+ */
+static void isl_sched_adjacency_clear(struct isl_sched_adjacency *adj)
+{
+	free(adj->pos);
+	free(adj->list);
+}
+
+/* Construct the nodes that are followed by each node in "graph" and
+ * store the result in "adj".
+ * Only consider the edges in the edge tables
+ * of the (conditional) validity dependences or, if "weak" is set,
+ * all edge tables, where the edges are then considered in both directions.
+ * An edge with an obviously empty map is ignored.
+ *
+ * The edges are collected directly from the edge tables,
+ * rather than by performing a quadratic number of edge table lookups.
+ */
+static isl_stat isl_sched_adjacency_init(isl_ctx *ctx,
+	struct isl_sched_adjacency *adj, struct isl_sched_graph *graph,
+	int weak)
+{
+	struct isl_collect_follows_data data = { graph, weak };
+	enum isl_edge_type t;
+	int i, size = 0;
+
+	for (t = isl_edge_first; t <= isl_edge_last; ++t)
+		size += graph->edge_table[t]->n;
+	if (weak)
+		size *= 2;
+	data.follows = isl_alloc_array(ctx, struct isl_sched_follows, size);
+	adj->pos = isl_calloc_array(ctx, int, graph->n + 1);
+	adj->list = isl_alloc_array(ctx, int, size);
+	if ((size && (!data.follows || !adj->list)) || !adj->pos)
+		goto error;
+	for (t = isl_edge_first; t <= isl_edge_last; ++t) {
+		if (!weak && t != isl_edge_validity &&
+		    t != isl_edge_conditional_validity)
+			continue;
+		if (isl_hash_table_foreach(ctx, graph->edge_table[t],
+					    &collect_follows, &data) < 0)
+			goto error;
+	}
+	if (isl_sort(data.follows, data.n, sizeof(data.follows[0]),
+		    &cmp_follows, NULL) < 0)
+		goto error;
+	for (i = 0; i < data.n; ++i) {
+		adj->pos[data.follows[i].i + 1]++;
+		adj->list[i] = data.follows[i].j;
+	}
+	for (i = 0; i < graph->n; ++i)
+		adj->pos[i + 1] += adj->pos[i];
+
+	free(data.follows);
+	return isl_stat_ok;
+error:
+	free(data.follows);
+	isl_sched_adjacency_clear(adj);
+	adj->pos = NULL;
+	adj->list = NULL;
+	return isl_stat_error;
+}
+
+/* Does node "i" follow node "j" according to "adj"?
+ */
+static int isl_sched_adjacency_follows(struct isl_sched_adjacency *adj,
+	int i, int j)
+{
+	int lo = adj->pos[i], hi = adj->pos[i + 1];
+
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (adj->list[mid] == j)
+			return 1;
+		if (adj->list[mid] > j)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return 0;
+}
+
+/* Use Tarjan's algorithm for computing the strongly connected components
+ * in the dependence graph only considering the (conditional)
+ * validity dependences or, if "weak" is set, all dependences
+ * in both directions.
+ *
+ * Note that the conditional validity edges cannot be ignored
+ * during this detection.
+ * The result is the same as calling isl_tarjan_graph_init with a callback
+ * that checks for the presence of such an edge between each pair of nodes,
+ * but the edges are extracted directly from the graph.
+ * The nodes followed by a given node are sorted such that
+ * they are considered in the same order by isl_tarjan_graph_init_lists
+ * as by isl_tarjan_graph_init.
+ */
+static isl_stat detect_ccs_from_edges(isl_ctx *ctx,
+	struct isl_sched_graph *graph, int weak)
+{
+	struct isl_sched_adjacency adj;
+	struct isl_tarjan_graph *g;
+
+	if (isl_sched_adjacency_init(ctx, &adj, graph, weak) < 0)
+		return isl_stat_error;
+	g = isl_tarjan_graph_init_lists(ctx, graph->n, adj.pos, adj.list);
+	isl_sched_adjacency_clear(&adj);
+	return set_ccs(graph, g);
+}
+
+/* Information about a phase of the scheduler that is being traced
+ * because the schedule_trace option is set.
+ *
+ * "start" is the processor time at the start of the phase.
+ * "pivots" is the number of pivots performed in the isl_ctx
+ * at the start of the phase.
+ */
+struct isl_sched_trace {
+	clock_t start;
+	long pivots;
+};
+
+/* Record the start of a phase of the scheduler in "trace",
+ * if the schedule_trace option is set.
+ */
+static void trace_start(isl_ctx *ctx, struct isl_sched_trace *trace)
+{
+	if (!ctx->opt->schedule_trace)
+		return;
+	trace->start = clock();
+	trace->pivots = ctx->stats->tab_pivots;
+}
+
+/* Print a key-value pair of a YAML mapping to "p",
+ * with key "name" and integer value "val".
+ */
+static __isl_give isl_printer *print_trace_int(__isl_take isl_printer *p,
+	const char *name, long val)
+{
+	char buffer[40];
+
+	snprintf(buffer, sizeof(buffer), "%ld", val);
+	p = isl_printer_print_str(p, name);
+	p = isl_printer_yaml_next(p);
+	p = isl_printer_print_str(p, buffer);
+	p = isl_printer_yaml_next(p);
+
+	return p;
+}
+
+/* Start printing a trace entry for the phase "event" of the scheduler
+ * that started at "trace", if the schedule_trace option is set.
+ * Return NULL if the option is not set.
+ *
+ * Each entry is printed as a separate YAML sequence with a single
+ * element on stderr such that the trace as a whole forms
+ * a single YAML sequence.  The element is a mapping that starts with
+ * the name of the phase, the processor time spent in the phase
+ * (in seconds) and the number of pivots performed in the phase.
+ * The caller can add further key-value pairs and
+ * should call trace_entry_end to complete the entry.
+ */
+static __isl_give isl_printer *trace_entry_start(isl_ctx *ctx,
+	struct isl_sched_trace *trace, const char *event)
+{
+	isl_printer *p;
+
+	if (!ctx->opt->schedule_trace)
+		return NULL;
+
+	p = isl_printer_to_file(ctx, stderr);
+	p = isl_printer_set_yaml_style(p, ISL_YAML_STYLE_BLOCK);
+	p = isl_printer_yaml_start_sequence(p);
+	p = isl_printer_yaml_start_mapping(p);
+	p = isl_printer_print_str(p, "event");
+	p = isl_printer_yaml_next(p);
+	p = isl_printer_print_str(p, event);
+	p = isl_printer_yaml_next(p);
+	p = isl_printer_print_str(p, "time");
+	p = isl_printer_yaml_next(p);
+	p = isl_printer_print_double(p,
+			(double) (clock() - trace->start) / CLOCKS_PER_SEC);
+	p = isl_printer_yaml_next(p);
+	p = print_trace_int(p, "pivots",
+			ctx->stats->tab_pivots - trace->pivots);
+
+	return p;
+}
+
+/* Complete the trace entry printed to "p" by trace_entry_start.
+ */
+static void trace_entry_end(__isl_take isl_printer *p)
+{
+	p = isl_printer_yaml_end_mapping(p);
+	p = isl_printer_yaml_end_sequence(p);
+	p = isl_printer_flush(p);
+	isl_printer_free(p);
+}
+
+/* Print a trace entry for the construction of "graph"
+ * that started at "trace", if the schedule_trace option is set.
+ */
+static void trace_graph(isl_ctx *ctx, struct isl_sched_trace *trace,
+	struct isl_sched_graph *graph)
+{
+	isl_printer *p;
+
+	p = trace_entry_start(ctx, trace, "graph");
+	if (!p)
+		return;
+	p = print_trace_int(p, "nodes", graph->n);
+	p = print_trace_int(p, "edges", graph->n_edge);
+	trace_entry_end(p);
+}
+
 /* Apply Tarjan's algorithm to detect the strongly connected components
  * in the dependence graph.
  * Only consider the (conditional) validity dependences and clear "weak".
  */
 static isl_stat detect_sccs(isl_ctx *ctx, struct isl_sched_graph *graph)
 {
+	isl_stat r;
+	struct isl_sched_trace trace;
+	isl_printer *p;
+
+	trace_start(ctx, &trace);
 	graph->weak = 0;
-	return detect_ccs(ctx, graph, &node_follows_strong);
+	r = detect_ccs_from_edges(ctx, graph, 0);
+	p = trace_entry_start(ctx, &trace, "sccs");
+	if (!p)
+		return r;
+	p = print_trace_int(p, "nodes", graph->n);
+	p = print_trace_int(p, "sccs", graph->scc);
+	trace_entry_end(p);
+	return r;
 }
 
 /* Apply Tarjan's algorithm to detect the (weakly) connected components
@@ -1698,7 +1941,7 @@ static isl_stat detect_sccs(isl_ctx *ctx, struct isl_sched_graph *graph)
 static isl_stat detect_wccs(isl_ctx *ctx, struct isl_sched_graph *graph)
 {
 	graph->weak = 1;
-	return detect_ccs(ctx, graph, &node_follows_weak);
+	return detect_ccs_from_edges(ctx, graph, 1);
 }
 
 static int cmp_scc(const void *a, const void *b, void *data)
@@ -1803,6 +2046,49 @@ static __isl_give isl_set *drop_coalescing_constraints(
 	return delta;
 }
 
+/* Return a pointer to the cache in the root of "graph"
+ * of the coefficients of dependence relations from a node to itself.
+ * "need_param" is set if the coefficients need to include
+ * coefficients for the parameters.
+ * Set "treat" to whether some constraints that could be exploited
+ * to construct coalescing schedules should be removed.
+ */
+static isl_map_to_basic_set **intra_hmap(isl_ctx *ctx,
+	struct isl_sched_graph *graph, int need_param, int *treat)
+{
+	*treat = !need_param && isl_options_get_schedule_treat_coalescing(ctx);
+	if (*treat)
+		return &graph->root->intra_hmap;
+	return &graph->root->intra_hmap_param;
+}
+
+/* Construct the set of which the dual is computed by intra_coefficients
+ * for the dependence relation "map" from "node" to itself.
+ * "treat" is set if some constraints that could be exploited
+ * to construct coalescing schedules should be removed.
+ */
+static __isl_give isl_set *intra_coefficients_domain(
+	struct isl_sched_node *node, __isl_take isl_map *map, int treat)
+{
+	isl_set *delta;
+
+	map = compress(map, node, node);
+	delta = isl_map_deltas(map);
+	if (treat)
+		delta = drop_coalescing_constraints(delta, node);
+	return isl_set_remove_divs(delta);
+}
+
+/* Construct the set of which the dual is computed by inter_coefficients
+ * for the dependence relation "map" of "edge".
+ */
+static __isl_give isl_set *inter_coefficients_domain(
+	struct isl_sched_edge *edge, __isl_take isl_map *map)
+{
+	map = compress(map, edge->src, edge->dst);
+	return isl_map_wrap(isl_map_remove_divs(map));
+}
+
 /* Given a dependence relation R from "node" to itself,
  * construct the set of coefficients of valid constraints for elements
  * in that dependence relation.
@@ -1843,28 +2129,25 @@ static __isl_give isl_basic_set *intra_coefficients(
 	isl_map *key;
 	isl_basic_set *coef;
 	isl_maybe_isl_basic_set m;
-	isl_map_to_basic_set **hmap = &graph->intra_hmap;
+	isl_map_to_basic_set **hmap;
 	int treat;
 
 	if (!map)
 		return NULL;
 
 	ctx = isl_map_get_ctx(map);
-	treat = !need_param && isl_options_get_schedule_treat_coalescing(ctx);
-	if (!treat)
-		hmap = &graph->intra_hmap_param;
+	hmap = intra_hmap(ctx, graph, need_param, &treat);
 	m = isl_map_to_basic_set_try_get(*hmap, map);
 	if (m.valid < 0 || m.valid) {
+		if (m.valid)
+			ctx->stats->schedule_coef_cache_hits++;
 		isl_map_free(map);
 		return m.value;
 	}
+	ctx->stats->schedule_coef_cache_misses++;
 
 	key = isl_map_copy(map);
-	map = compress(map, node, node);
-	delta = isl_map_deltas(map);
-	if (treat)
-		delta = drop_coalescing_constraints(delta, node);
-	delta = isl_set_remove_divs(delta);
+	delta = intra_coefficients_domain(node, map, treat);
 	coef = isl_set_coefficients(delta);
 	*hmap = isl_map_to_basic_set_set(*hmap, key, isl_basic_set_copy(coef));
 
@@ -1886,27 +2169,147 @@ static __isl_give isl_basic_set *inter_coefficients(
 	struct isl_sched_graph *graph, struct isl_sched_edge *edge,
 	__isl_take isl_map *map)
 {
+	isl_ctx *ctx;
 	isl_set *set;
 	isl_map *key;
 	isl_basic_set *coef;
 	isl_maybe_isl_basic_set m;
+	isl_map_to_basic_set **hmap = &graph->root->inter_hmap;
+
+	if (!map)
+		return NULL;
 
-	m = isl_map_to_basic_set_try_get(graph->inter_hmap, map);
+	ctx = isl_map_get_ctx(map);
+	m = isl_map_to_basic_set_try_get(*hmap, map);
 	if (m.valid < 0 || m.valid) {
+		if (m.valid)
+			ctx->stats->schedule_coef_cache_hits++;
 		isl_map_free(map);
 		return m.value;
 	}
+	ctx->stats->schedule_coef_cache_misses++;
 
 	key = isl_map_copy(map);
-	map = compress(map, edge->src, edge->dst);
-	set = isl_map_wrap(isl_map_remove_divs(map));
+	set = inter_coefficients_domain(edge, map);
 	coef = isl_set_coefficients(set);
-	graph->inter_hmap = isl_map_to_basic_set_set(graph->inter_hmap, key,
-					isl_basic_set_copy(coef));
+	*hmap = isl_map_to_basic_set_set(*hmap, key, isl_basic_set_copy(coef));
 
 	return coef;
 }
 
+/* Data used by compute_coefficients.
+ * Task "k" computes the set of coefficients of valid constraints
+ * for the elements of "set[k]" and stores the result in "coef[k]".
+ */
+struct isl_sched_coef_tasks {
+	isl_set **set;
+	isl_basic_set **coef;
+};
+
+/* Compute the set of coefficients of task "k" in "ctx".
+ */
+static isl_stat sched_coef_task_run(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_sched_coef_tasks *data = user;
+	isl_set *set;
+
+	set = isl_set_copy_to_ctx(data->set[k], ctx);
+	data->coef[k] = isl_set_coefficients(set);
+	return data->coef[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* Copy the set of coefficients computed by task "k" to "ctx".
+ */
+static isl_stat sched_coef_task_merge(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_sched_coef_tasks *data = user;
+	isl_basic_set *child = data->coef[k];
+
+	data->coef[k] = isl_basic_set_copy_to_ctx(child, ctx);
+	isl_basic_set_free(child);
+	return data->coef[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* Compute the sets of coefficients of valid constraints
+ * for the "n" sets in "set" and store the results in "coef",
+ * using up to "n_thread" threads, each computation being performed
+ * in a task of isl_ctx_run_tasks.
+ * If anything goes wrong, then the sets of coefficients that have been
+ * computed are freed.
+ */
+static isl_stat compute_coefficients(isl_ctx *ctx, isl_set **set, int n,
+	isl_basic_set **coef, int n_thread)
+{
+	int k;
+	struct isl_sched_coef_tasks data = { set, coef };
+
+	for (k = 0; k < n; ++k)
+		coef[k] = NULL;
+	if (isl_ctx_run_tasks(ctx, n, n_thread, &sched_coef_task_run,
+				&sched_coef_task_merge, &data) >= 0)
+		return isl_stat_ok;
+	for (k = 0; k < n; ++k)
+		coef[k] = isl_basic_set_free(coef[k]);
+	return isl_stat_error;
+}
+
+/* Replace the elements of "list" by their sets of coefficients
+ * of valid constraints, as computed by isl_basic_set_list_coefficients,
+ * using up to schedule_coefficients_threads threads.
+ */
+static __isl_give isl_basic_set_list *basic_set_list_coefficients(
+	__isl_take isl_basic_set_list *list)
+{
+	int k;
+	int n_thread;
+	isl_ctx *ctx;
+	isl_size n;
+	isl_set **set;
+	isl_basic_set **coef;
+	isl_basic_set_list *res;
+
+	n = isl_basic_set_list_n_basic_set(list);
+	if (n < 0)
+		return isl_basic_set_list_free(list);
+	ctx = isl_basic_set_list_get_ctx(list);
+	n_thread = isl_options_get_schedule_coefficients_threads(ctx);
+	if (n_thread < 2 || n < 2)
+		return isl_basic_set_list_coefficients(list);
+
+	set = isl_calloc_array(ctx, isl_set *, n);
+	coef = isl_calloc_array(ctx, isl_basic_set *, n);
+	if (!set || !coef)
+		goto error;
+	for (k = 0; k < n; ++k) {
+		isl_basic_set *bset;
+
+		bset = isl_basic_set_list_get_basic_set(list, k);
+		set[k] = isl_set_from_basic_set(bset);
+		if (!set[k])
+			goto error;
+	}
+	if (compute_coefficients(ctx, set, n, coef, n_thread) < 0)
+		goto error;
+	res = isl_basic_set_list_alloc(ctx, n);
+	for (k = 0; k < n; ++k)
+		res = isl_basic_set_list_add(res, coef[k]);
+
+	for (k = 0; k < n; ++k)
+		isl_set_free(set[k]);
+	free(set);
+	free(coef);
+	isl_basic_set_list_free(list);
+	return res;
+error:
+	if (set)
+		for (k = 0; k < n; ++k)
+			isl_set_free(set[k]);
+	free(set);
+	free(coef);
+	isl_basic_set_list_free(list);
+	return NULL;
+}
+
 /* Return the position of the coefficients of the variables in
  * the coefficients constraints "coef".
  *
@@ -2625,23 +3028,219 @@ error:
 	return isl_stat_error;
 }
 
-/* Count the number of equality and inequality constraints
- * that will be added to the main lp problem.
- * We count as follows
- * validity		-> 1 (>= 0)
- * validity+proximity	-> 2 (>= 0 and upper bound)
- * proximity		-> 2 (lower and upper bound)
- * local(+any)		-> 2 (>= 0 and <= 0)
+/* Internal data structure for prefetch_coefficients.
  *
- * If "use_coincidence" is set, then we treat coincidence edges as local edges.
- * Otherwise, we ignore them.
+ * "n" is the number of sets of coefficients that need to be computed.
+ * For each of them,
+ * "hmap" points to the cache in which the result should be stored,
+ * "key" is the dependence relation used as key in this cache and
+ * "set" is the set of which the dual needs to be computed.
  */
-static int count_constraints(struct isl_sched_graph *graph,
-	int *n_eq, int *n_ineq, int use_coincidence)
-{
-	int i;
+struct isl_sched_prefetch_data {
+	int n;
+	isl_map_to_basic_set ***hmap;
+	isl_map **key;
+	isl_set **set;
+};
 
-	*n_eq = *n_ineq = 0;
+/* Is there already a set of coefficients for "key" in "hmap"?
+ */
+static isl_bool is_cached(__isl_keep isl_map_to_basic_set *hmap,
+	__isl_keep isl_map *key)
+{
+	isl_maybe_isl_basic_set m;
+
+	m = isl_map_to_basic_set_try_get(hmap, key);
+	if (m.valid < 0)
+		return isl_bool_error;
+	isl_basic_set_free(m.value);
+	return isl_bool_ok(m.valid);
+}
+
+/* Has the computation of the set of coefficients for "key" in "hmap"
+ * already been scheduled in "data"?
+ * The keys are the dependence relations of the edges, which are
+ * not modified during the construction of the LP problem,
+ * so it is sufficient to compare the pointers.
+ */
+static int is_prefetched(struct isl_sched_prefetch_data *data,
+	isl_map_to_basic_set **hmap, __isl_keep isl_map *key)
+{
+	int i;
+
+	for (i = 0; i < data->n; ++i)
+		if (data->hmap[i] == hmap && data->key[i] == key)
+			return 1;
+	return 0;
+}
+
+/* Schedule the computation of the set of coefficients
+ * of the dependence relation of "edge" in "graph",
+ * as computed by intra_coefficients, if this set has not been
+ * computed or scheduled before.
+ */
+static isl_stat prefetch_intra(isl_ctx *ctx, struct isl_sched_graph *graph,
+	struct isl_sched_edge *edge, int need_param,
+	struct isl_sched_prefetch_data *data)
+{
+	isl_map_to_basic_set **hmap;
+	isl_bool cached;
+	int treat;
+
+	hmap = intra_hmap(ctx, graph, need_param, &treat);
+	cached = is_cached(*hmap, edge->map);
+	if (cached < 0)
+		return isl_stat_error;
+	if (cached || is_prefetched(data, hmap, edge->map))
+		return isl_stat_ok;
+
+	data->hmap[data->n] = hmap;
+	data->key[data->n] = edge->map;
+	data->set[data->n] = intra_coefficients_domain(edge->src,
+					isl_map_copy(edge->map), treat);
+	if (!data->set[data->n++])
+		return isl_stat_error;
+	return isl_stat_ok;
+}
+
+/* Schedule the computation of the set of coefficients
+ * of the dependence relation of "edge" in "graph",
+ * as computed by inter_coefficients, if this set has not been
+ * computed or scheduled before.
+ */
+static isl_stat prefetch_inter(struct isl_sched_graph *graph,
+	struct isl_sched_edge *edge, struct isl_sched_prefetch_data *data)
+{
+	isl_map_to_basic_set **hmap = &graph->root->inter_hmap;
+	isl_bool cached;
+
+	cached = is_cached(*hmap, edge->map);
+	if (cached < 0)
+		return isl_stat_error;
+	if (cached || is_prefetched(data, hmap, edge->map))
+		return isl_stat_ok;
+
+	data->hmap[data->n] = hmap;
+	data->key[data->n] = edge->map;
+	data->set[data->n] = inter_coefficients_domain(edge,
+						isl_map_copy(edge->map));
+	if (!data->set[data->n++])
+		return isl_stat_error;
+	return isl_stat_ok;
+}
+
+/* Free all the data stored in "data", apart from the keys,
+ * which are owned by the edges.
+ */
+static void isl_sched_prefetch_data_clear(struct isl_sched_prefetch_data *data)
+{
+	int i;
+
+	if (data->set)
+		for (i = 0; i < data->n; ++i)
+			isl_set_free(data->set[i]);
+	free(data->hmap);
+	free(data->key);
+	free(data->set);
+}
+
+/* If the schedule_coefficients_threads option is set to a value
+ * greater than one, then compute the sets of coefficients
+ * that will be needed by count_constraints (and later by
+ * add_all_validity_constraints and add_all_proximity_constraints)
+ * and that are not available in the caches yet
+ * using that many threads and store the results in the caches.
+ * The sets of coefficients of different edges are independent of
+ * each other, so they can be computed in parallel.
+ * The edges that need to be considered and the kind of coefficients
+ * are determined in the same way as in count_map_constraints.
+ *
+ * Only the computation of the duals is performed in parallel.
+ * The sets of which the duals are computed are constructed
+ * by the calling thread since they may depend on data
+ * that is computed on demand and cached in the nodes.
+ */
+static isl_stat prefetch_coefficients(isl_ctx *ctx,
+	struct isl_sched_graph *graph, int use_coincidence)
+{
+	int i;
+	int n_thread;
+	isl_stat r = isl_stat_ok;
+	isl_basic_set **coef = NULL;
+	struct isl_sched_prefetch_data data = { 0 };
+
+	n_thread = isl_options_get_schedule_coefficients_threads(ctx);
+	if (n_thread < 2 || graph->n_edge < 2)
+		return isl_stat_ok;
+
+	data.hmap = isl_calloc_array(ctx, isl_map_to_basic_set **,
+					2 * graph->n_edge);
+	data.key = isl_calloc_array(ctx, isl_map *, 2 * graph->n_edge);
+	data.set = isl_calloc_array(ctx, isl_set *, 2 * graph->n_edge);
+	if (!data.hmap || !data.key || !data.set)
+		r = isl_stat_error;
+
+	for (i = 0; r >= 0 && i < graph->n_edge; ++i) {
+		struct isl_sched_edge *edge = &graph->edge[i];
+		int f = edge_multiplicity(edge, use_coincidence);
+		int fp = parametric_intra_edge_multiplicity(edge,
+							use_coincidence);
+
+		if (f == 0)
+			continue;
+		if (edge->src != edge->dst) {
+			r = prefetch_inter(graph, edge, &data);
+			continue;
+		}
+		if (fp > 0)
+			r = prefetch_intra(ctx, graph, edge, 1, &data);
+		if (r >= 0 && f > fp)
+			r = prefetch_intra(ctx, graph, edge, 0, &data);
+	}
+
+	if (r >= 0 && data.n > 0) {
+		coef = isl_calloc_array(ctx, isl_basic_set *, data.n);
+		if (!coef)
+			r = isl_stat_error;
+	}
+	if (r >= 0 && data.n > 0)
+		r = compute_coefficients(ctx, data.set, data.n, coef, n_thread);
+	for (i = 0; coef && i < data.n; ++i) {
+		isl_map_to_basic_set **hmap = data.hmap[i];
+
+		if (r < 0) {
+			isl_basic_set_free(coef[i]);
+			continue;
+		}
+		ctx->stats->schedule_coef_cache_misses++;
+		*hmap = isl_map_to_basic_set_set(*hmap,
+					isl_map_copy(data.key[i]), coef[i]);
+		if (!*hmap)
+			r = isl_stat_error;
+	}
+
+	free(coef);
+	isl_sched_prefetch_data_clear(&data);
+	return r;
+}
+
+/* Count the number of equality and inequality constraints
+ * that will be added to the main lp problem.
+ * We count as follows
+ * validity		-> 1 (>= 0)
+ * validity+proximity	-> 2 (>= 0 and upper bound)
+ * proximity		-> 2 (lower and upper bound)
+ * local(+any)		-> 2 (>= 0 and <= 0)
+ *
+ * If "use_coincidence" is set, then we treat coincidence edges as local edges.
+ * Otherwise, we ignore them.
+ */
+static int count_constraints(struct isl_sched_graph *graph,
+	int *n_eq, int *n_ineq, int use_coincidence)
+{
+	int i;
+
+	*n_eq = *n_ineq = 0;
 	for (i = 0; i < graph->n_edge; ++i) {
 		struct isl_sched_edge *edge = &graph->edge[i];
 		isl_map *map = isl_map_copy(edge->map);
@@ -2985,6 +3584,8 @@ static isl_stat setup_lp(isl_ctx *ctx, struct isl_sched_graph *graph,
 		total += 1 + node->nparam + 2 * node->nvar;
 	}
 
+	if (prefetch_coefficients(ctx, graph, use_coincidence) < 0)
+		return isl_stat_error;
 	if (count_constraints(graph, &n_eq, &n_ineq, use_coincidence) < 0)
 		return isl_stat_error;
 	if (count_bound_constant_constraints(ctx, graph, &n_eq, &n_ineq) < 0)
@@ -3100,19 +3701,181 @@ static __isl_give isl_mat *construct_trivial(__isl_keep isl_mat *indep)
 	return mat;
 }
 
+/* Round the rational solution "sol" to the nearest integer point.
+ */
+static __isl_give isl_vec *round_solution(__isl_take isl_vec *sol)
+{
+	int i;
+	isl_int t, d2;
+
+	sol = isl_vec_cow(sol);
+	if (!sol)
+		return NULL;
+	if (isl_int_is_one(sol->el[0]))
+		return sol;
+
+	isl_int_init(t);
+	isl_int_init(d2);
+	isl_int_mul_ui(d2, sol->el[0], 2);
+	for (i = 1; i < sol->size; ++i) {
+		isl_int_mul_ui(t, sol->el[i], 2);
+		isl_int_add(t, t, sol->el[0]);
+		isl_int_fdiv_q(sol->el[i], t, d2);
+	}
+	isl_int_set_si(sol->el[0], 1);
+	isl_int_clear(d2);
+	isl_int_clear(t);
+
+	return sol;
+}
+
+/* Is the part of "sol" described by "region" trivial?
+ * That is, are all linear combinations in the rows of region->trivial
+ * of the variables starting at region->pos equal to zero?
+ * A region without any such linear combinations is never trivial.
+ */
+static isl_bool solution_region_is_trivial(__isl_keep isl_vec *sol,
+	struct isl_trivial_region *region)
+{
+	isl_size n, len;
+	isl_vec *v;
+	isl_bool is_trivial;
+
+	n = isl_mat_rows(region->trivial);
+	len = isl_mat_cols(region->trivial);
+	if (n < 0 || len < 0)
+		return isl_bool_error;
+	if (n == 0)
+		return isl_bool_false;
+
+	v = isl_vec_alloc(isl_vec_get_ctx(sol), len);
+	if (!v)
+		return isl_bool_error;
+	isl_seq_cpy(v->el, sol->el + 1 + region->pos, len);
+	v = isl_mat_vec_product(isl_mat_copy(region->trivial), v);
+	is_trivial = isl_vec_is_zero(v);
+	isl_vec_free(v);
+
+	return is_trivial;
+}
+
+/* Check that "sol" is a valid solution of the scheduler LP "lp"
+ * with non-triviality regions graph->region.
+ * That is, check that it satisfies all constraints of "lp" and
+ * that it is non-trivial in each of the regions.
+ */
+static isl_bool is_valid_solution(struct isl_sched_graph *graph,
+	__isl_keep isl_basic_set *lp, __isl_keep isl_vec *sol)
+{
+	int i;
+	isl_bool valid;
+
+	valid = isl_basic_set_contains(lp, sol);
+	for (i = 0; valid == isl_bool_true && i < graph->n; ++i) {
+		isl_bool trivial;
+
+		trivial = solution_region_is_trivial(sol, &graph->region[i]);
+		valid = isl_bool_not(trivial);
+	}
+
+	return valid;
+}
+
+/* Try and solve the LP problem "lp" constructed in setup_lp
+ * using the external LP solver set through
+ * isl_options_set_schedule_lp_backend, if any,
+ * with the non-triviality regions already set up in graph->region.
+ * The external solver is only expected to solve the LP relaxation
+ * (preferably minimizing the variables lexicographically).
+ * Its solution is rounded to the nearest integer point and
+ * then verified exactly.
+ * Store the verified integer solution in *sol, if any.
+ * If there is no external solver, if it does not return a solution or
+ * if the rounded solution is not valid, then set *sol to NULL
+ * such that the caller can use the built-in solver instead.
+ */
+static isl_stat solve_lp_backend(isl_ctx *ctx, struct isl_sched_graph *graph,
+	__isl_keep isl_basic_set *lp, __isl_give isl_vec **sol)
+{
+	isl_size dim;
+	isl_bool valid;
+
+	*sol = NULL;
+	if (!ctx->opt->schedule_lp_backend)
+		return isl_stat_ok;
+	dim = isl_basic_set_dim(lp, isl_dim_all);
+	if (dim < 0)
+		return isl_stat_error;
+	*sol = ctx->opt->schedule_lp_backend(lp,
+					ctx->opt->schedule_lp_backend_user);
+	if (*sol &&
+	    ((*sol)->size != 1 + dim || !isl_int_is_pos((*sol)->el[0])))
+		*sol = isl_vec_free(*sol);
+	if (!*sol) {
+		ctx->stats->schedule_lp_backend_rejects++;
+		return isl_stat_ok;
+	}
+	*sol = round_solution(*sol);
+	if (!*sol)
+		return isl_stat_error;
+	valid = is_valid_solution(graph, lp, *sol);
+	if (valid < 0 || !valid)
+		*sol = isl_vec_free(*sol);
+	if (valid < 0)
+		return isl_stat_error;
+	if (!valid)
+		ctx->stats->schedule_lp_backend_rejects++;
+	else
+		ctx->stats->schedule_lp_backend_accepts++;
+	return isl_stat_ok;
+}
+
+/* Print a trace entry for the phase "event" that solved "lp"
+ * (resulting in "sol") and that started at "trace",
+ * if the schedule_trace option is set.
+ * The size of the LP problem is described by the number of variables and
+ * the number of constraints.
+ */
+static void trace_lp(isl_ctx *ctx, struct isl_sched_trace *trace,
+	const char *event, struct isl_sched_graph *graph,
+	__isl_keep isl_basic_set *lp, __isl_keep isl_vec *sol)
+{
+	isl_printer *p;
+	isl_size dim;
+
+	p = trace_entry_start(ctx, trace, event);
+	if (!p)
+		return;
+	dim = isl_basic_set_dim(lp, isl_dim_all);
+	p = print_trace_int(p, "nodes", graph->n);
+	p = print_trace_int(p, "variables", dim);
+	if (lp)
+		p = print_trace_int(p, "constraints", lp->n_eq + lp->n_ineq);
+	p = print_trace_int(p, "solved", sol && sol->size > 0);
+	trace_entry_end(p);
+}
+
 /* Solve the ILP problem constructed in setup_lp.
  * For each node such that all the remaining rows of its schedule
  * need to be non-trivial, we construct a non-triviality region.
  * This region imposes that the next row is independent of previous rows.
  * In particular, the non-triviality region enforces that at least
  * one of the linear combinations in the rows of node->indep is non-zero.
+ *
+ * If an external LP solver has been set and it produces
+ * a valid solution, then use that solution.
+ * Otherwise, use the built-in solver.
  */
 static __isl_give isl_vec *solve_lp(isl_ctx *ctx, struct isl_sched_graph *graph)
 {
 	int i;
 	isl_vec *sol;
 	isl_basic_set *lp;
+	isl_stat r;
+	clock_t start;
+	struct isl_sched_trace trace;
 
+	trace_start(ctx, &trace);
 	for (i = 0; i < graph->n; ++i) {
 		struct isl_sched_node *node = &graph->node[i];
 		isl_mat *trivial;
@@ -3124,9 +3887,15 @@ static __isl_give isl_vec *solve_lp(isl_ctx *ctx, struct isl_sched_graph *graph)
 			trivial = isl_mat_zero(ctx, 0, 0);
 		graph->region[i].trivial = trivial;
 	}
-	lp = isl_basic_set_copy(graph->lp);
-	sol = isl_tab_basic_set_non_trivial_lexmin(lp, 2, graph->n,
+	start = isl_ctx_stats_enter(ctx, &ctx->stats->schedule_lp_solves);
+	r = solve_lp_backend(ctx, graph, graph->lp, &sol);
+	if (r >= 0 && !sol) {
+		lp = isl_basic_set_copy(graph->lp);
+		sol = isl_tab_basic_set_non_trivial_lexmin(lp, 2, graph->n,
 				       graph->region, &check_conflict, graph);
+	}
+	isl_ctx_stats_leave(&ctx->stats->schedule_lp_time, start);
+	trace_lp(ctx, &trace, "lp", graph, graph->lp, sol);
 	for (i = 0; i < graph->n; ++i)
 		isl_mat_free(graph->region[i].trivial);
 	return sol;
@@ -3308,54 +4077,67 @@ static __isl_give isl_multi_aff *node_extract_partial_schedule_multi_aff(
 	return ma;
 }
 
-/* Convert node->sched into a multi_aff and return this multi_aff.
- *
- * The result is defined over the uncompressed node domain.
- */
-static __isl_give isl_multi_aff *node_extract_schedule_multi_aff(
-	struct isl_sched_node *node)
-{
-	isl_size nrow;
-
-	nrow = isl_mat_rows(node->sched);
-	if (nrow < 0)
-		return NULL;
-	return node_extract_partial_schedule_multi_aff(node, 0, nrow);
-}
-
-/* Convert node->sched into a map and return this map.
+/* Convert the rows of node->sched starting at row "start"
+ * into a map and return this map.
  *
  * The result is cached in node->sched_map, which needs to be released
  * whenever node->sched is updated.
+ * The cached map is only reused if it was constructed
+ * from the same starting row.
  * It is defined over the uncompressed node domain.
  */
-static __isl_give isl_map *node_extract_schedule(struct isl_sched_node *node)
+static __isl_give isl_map *node_extract_schedule(struct isl_sched_node *node,
+	int start)
 {
+	if (node->sched_map && node->sched_map_start != start)
+		node->sched_map = isl_map_free(node->sched_map);
 	if (!node->sched_map) {
 		isl_multi_aff *ma;
+		isl_size nrow;
 
-		ma = node_extract_schedule_multi_aff(node);
+		nrow = isl_mat_rows(node->sched);
+		if (nrow < 0)
+			return NULL;
+		ma = node_extract_partial_schedule_multi_aff(node,
+							start, nrow - start);
 		node->sched_map = isl_map_from_multi_aff(ma);
+		node->sched_map_start = start;
 	}
 
 	return isl_map_copy(node->sched_map);
 }
 
+/* Convert the rows of the current band of node->sched into a map and
+ * return this map.
+ *
+ * The dependence relations of the edges in "graph" have been restricted
+ * to pairs of instances that are mapped to the same point by
+ * the rows before the current band (by update_edges) and
+ * the rows of the current band are therefore sufficient to determine
+ * which of those pairs are still mapped to the same point.
+ */
+static __isl_give isl_map *node_extract_band_schedule(
+	struct isl_sched_graph *graph, struct isl_sched_node *node)
+{
+	return node_extract_schedule(node, graph->band_start);
+}
+
 /* Construct a map that can be used to update a dependence relation
  * based on the current schedule.
  * That is, construct a map expressing that source and sink
  * are executed within the same iteration of the current schedule.
  * This map can then be intersected with the dependence relation.
- * This is not the most efficient way, but this shouldn't be a critical
- * operation.
+ * Since the dependence relation has already been updated
+ * based on the rows before the current band,
+ * only the rows of the current band need to be taken into account.
  */
-static __isl_give isl_map *specializer(struct isl_sched_node *src,
-	struct isl_sched_node *dst)
+static __isl_give isl_map *specializer(struct isl_sched_graph *graph,
+	struct isl_sched_node *src, struct isl_sched_node *dst)
 {
 	isl_map *src_sched, *dst_sched;
 
-	src_sched = node_extract_schedule(src);
-	dst_sched = node_extract_schedule(dst);
+	src_sched = node_extract_band_schedule(graph, src);
+	dst_sched = node_extract_band_schedule(graph, dst);
 	return isl_map_apply_range(src_sched, isl_map_reverse(dst_sched));
 }
 
@@ -3393,7 +4175,7 @@ static isl_stat update_edge(isl_ctx *ctx, struct isl_sched_graph *graph,
 	int empty;
 	isl_map *id;
 
-	id = specializer(edge->src, edge->dst);
+	id = specializer(graph, edge->src, edge->dst);
 	edge->map = isl_map_intersect(edge->map, isl_map_copy(id));
 	if (!edge->map)
 		goto error;
@@ -3459,15 +4241,20 @@ static int range_intersects(__isl_keep isl_union_map *umap,
 	return empty < 0 ? -1 : !empty;
 }
 
-/* Are the condition dependences of "edge" local with respect to
+/* Are the condition dependences of "edge" in "graph" local with respect to
  * the current schedule?
  *
  * That is, are domain and range of the condition dependences mapped
  * to the same point?
  *
  * In other words, is the condition false?
+ *
+ * Since the condition dependences have already been updated
+ * based on the rows before the current band,
+ * only the rows of the current band need to be taken into account.
  */
-static int is_condition_false(struct isl_sched_edge *edge)
+static int is_condition_false(struct isl_sched_graph *graph,
+	struct isl_sched_edge *edge)
 {
 	isl_union_map *umap;
 	isl_map *map, *sched, *test;
@@ -3482,9 +4269,9 @@ static int is_condition_false(struct isl_sched_edge *edge)
 	umap = isl_union_set_unwrap(isl_union_map_domain(umap));
 	map = isl_map_from_union_map(umap);
 
-	sched = node_extract_schedule(edge->src);
+	sched = node_extract_band_schedule(graph, edge->src);
 	map = isl_map_apply_domain(map, sched);
-	sched = node_extract_schedule(edge->dst);
+	sched = node_extract_band_schedule(graph, edge->dst);
 	map = isl_map_apply_range(map, sched);
 
 	test = isl_map_identity(isl_map_get_space(map));
@@ -3568,7 +4355,7 @@ static int update_edges(isl_ctx *ctx, struct isl_sched_graph *graph)
 			continue;
 		if (is_local(&graph->edge[i]))
 			continue;
-		local = is_condition_false(&graph->edge[i]);
+		local = is_condition_false(graph, &graph->edge[i]);
 		if (local < 0)
 			goto error;
 		if (local)
@@ -3707,6 +4494,7 @@ static isl_stat copy_nodes(struct isl_sched_graph *dst,
 		dst->node[j].nparam = src->node[i].nparam;
 		dst->node[j].sched = isl_mat_copy(src->node[i].sched);
 		dst->node[j].sched_map = isl_map_copy(src->node[i].sched_map);
+		dst->node[j].sched_map_start = src->node[i].sched_map_start;
 		dst->node[j].coincident = src->node[i].coincident;
 		dst->node[j].sizes = isl_multi_val_copy(src->node[i].sizes);
 		dst->node[j].bounds = isl_basic_set_copy(src->node[i].bounds);
@@ -5191,7 +5979,7 @@ static __isl_give isl_basic_set_list *collect_intra_validity(isl_ctx *ctx,
 	list = isl_union_set_get_basic_set_list(delta);
 	isl_union_set_free(delta);
 
-	return isl_basic_set_list_coefficients(list);
+	return basic_set_list_coefficients(list);
 }
 
 /* For each dependence relation on a (conditional) validity edge
@@ -5237,7 +6025,7 @@ static __isl_give isl_basic_set_list *collect_inter_validity(
 	wrap = isl_union_map_wrap(inter);
 	list = isl_union_set_get_basic_set_list(wrap);
 	isl_union_set_free(wrap);
-	return isl_basic_set_list_coefficients(list);
+	return basic_set_list_coefficients(list);
 }
 
 /* Construct an LP problem for finding schedule coefficients
@@ -5374,12 +6162,16 @@ static __isl_give isl_schedule_node *carry(__isl_take isl_schedule_node *node,
 	int trivial;
 	isl_ctx *ctx;
 	isl_vec *sol;
+	struct isl_sched_trace trace;
 
 	if (!node)
 		return NULL;
 
 	ctx = isl_schedule_node_get_ctx(node);
+	trace_start(ctx, &trace);
 	sol = compute_carrying_sol(ctx, graph, fallback, coincidence);
+	trace_lp(ctx, &trace, fallback ? "carry_fallback" : "feautrier",
+		graph, graph->lp, sol);
 	if (!sol)
 		return isl_schedule_node_free(node);
 	if (sol->size == 0) {
@@ -5674,7 +6466,7 @@ static int has_adjacent_true_conditions(struct isl_sched_graph *graph,
 
 		set_local(&graph->edge[i]);
 
-		local = is_condition_false(&graph->edge[i]);
+		local = is_condition_false(graph, &graph->edge[i]);
 		if (local < 0)
 			return -1;
 		if (!local)
@@ -5948,6 +6740,13 @@ static __isl_give isl_schedule_node *compute_schedule_wcc_whole(
  * "scc_node" is a temporary data structure used inside copy_partial.
  * For each SCC, it keeps track of the number of nodes in the SCC
  * that have already been copied.
+ *
+ * "heap" is a binary heap of "n_heap" indices of edges
+ * in the original dependence graph that can currently be used
+ * to merge two clusters, with the most appropriate edge
+ * (as determined by better_merge_edge) at the root.
+ * "heap_pos" maps each edge index to its position in "heap" or
+ * to -1 if the edge does not appear in "heap".
  */
 struct isl_clustering {
 	int n;
@@ -5956,6 +6755,9 @@ struct isl_clustering {
 	int *scc_cluster;
 	int *scc_node;
 	int *scc_in_merge;
+	int n_heap;
+	int *heap;
+	int *heap_pos;
 };
 
 /* Initialize the clustering data structure "c" from "graph".
@@ -5977,9 +6779,15 @@ static isl_stat clustering_init(isl_ctx *ctx, struct isl_clustering *c,
 	c->scc_cluster = isl_calloc_array(ctx, int, c->n);
 	c->scc_node = isl_calloc_array(ctx, int, c->n);
 	c->scc_in_merge = isl_calloc_array(ctx, int, c->n);
+	c->n_heap = 0;
+	c->heap = isl_alloc_array(ctx, int, graph->n_edge);
+	c->heap_pos = isl_alloc_array(ctx, int, graph->n_edge);
 	if (!c->scc || !c->cluster ||
-	    !c->scc_cluster || !c->scc_node || !c->scc_in_merge)
+	    !c->scc_cluster || !c->scc_node || !c->scc_in_merge ||
+	    (graph->n_edge && (!c->heap || !c->heap_pos)))
 		return isl_stat_error;
+	for (i = 0; i < graph->n_edge; ++i)
+		c->heap_pos[i] = -1;
 
 	for (i = 0; i < c->n; ++i) {
 		if (extract_sub_graph(ctx, graph, &node_scc_exactly,
@@ -6013,6 +6821,8 @@ static void clustering_free(isl_ctx *ctx, struct isl_clustering *c)
 	free(c->scc_cluster);
 	free(c->scc_node);
 	free(c->scc_in_merge);
+	free(c->heap);
+	free(c->heap_pos);
 }
 
 /* Should we refrain from merging the cluster in "graph" with
@@ -6034,127 +6844,284 @@ static isl_bool is_non_empty_proximity(struct isl_sched_edge *edge)
 	return isl_bool_not(isl_map_plain_is_empty(edge->map));
 }
 
-/* Return the index of an edge in "graph" that can be used to merge
- * two clusters in "c".
- * Return graph->n_edge if no such edge can be found.
- * Return -1 on error.
+/* Can the edge in "graph" with index "i" be used to merge
+ * two clusters in "c"?
  *
- * In particular, return a proximity edge between two clusters
+ * In particular, is it a proximity edge between two clusters
  * that is not marked "no_merge" and such that neither of the
- * two clusters has an incomplete, empty band.
- *
- * If there are multiple such edges, then try and find the most
- * appropriate edge to use for merging.  In particular, pick the edge
- * with the greatest weight.  If there are multiple of those,
- * then pick one with the shortest distance between
- * the two cluster representatives.
+ * two clusters has an incomplete, empty band?
  */
-static int find_proximity(struct isl_sched_graph *graph,
-	struct isl_clustering *c)
+static isl_bool is_merge_edge(struct isl_sched_graph *graph,
+	struct isl_clustering *c, int i)
 {
-	int i, best = graph->n_edge, best_dist, best_weight;
+	struct isl_sched_edge *edge = &graph->edge[i];
+	isl_bool prox;
 
-	for (i = 0; i < graph->n_edge; ++i) {
-		struct isl_sched_edge *edge = &graph->edge[i];
-		int dist, weight;
-		isl_bool prox;
+	prox = is_non_empty_proximity(edge);
+	if (prox < 0 || !prox)
+		return prox;
+	if (edge->no_merge)
+		return isl_bool_false;
+	if (bad_cluster(&c->scc[edge->src->scc]) ||
+	    bad_cluster(&c->scc[edge->dst->scc]))
+		return isl_bool_false;
+	if (c->scc_cluster[edge->dst->scc] == c->scc_cluster[edge->src->scc])
+		return isl_bool_false;
+	return isl_bool_true;
+}
 
-		prox = is_non_empty_proximity(edge);
-		if (prox < 0)
-			return -1;
-		if (!prox)
-			continue;
-		if (edge->no_merge)
-			continue;
-		if (bad_cluster(&c->scc[edge->src->scc]) ||
-		    bad_cluster(&c->scc[edge->dst->scc]))
-			continue;
-		dist = c->scc_cluster[edge->dst->scc] -
-			c->scc_cluster[edge->src->scc];
-		if (dist == 0)
-			continue;
-		weight = edge->weight;
-		if (best < graph->n_edge) {
-			if (best_weight > weight)
-				continue;
-			if (best_weight == weight && best_dist <= dist)
-				continue;
-		}
-		best = i;
-		best_dist = dist;
-		best_weight = weight;
-	}
+/* Return the distance between the representatives of the clusters
+ * in "c" connected by the edge in "graph" with index "i".
+ */
+static int merge_edge_dist(struct isl_sched_graph *graph,
+	struct isl_clustering *c, int i)
+{
+	struct isl_sched_edge *edge = &graph->edge[i];
 
-	return best;
+	return c->scc_cluster[edge->dst->scc] - c->scc_cluster[edge->src->scc];
 }
 
-/* Internal data structure used in mark_merge_sccs.
+/* Is the edge in "graph" with index "i" more appropriate
+ * for merging two clusters in "c" than the edge with index "j"?
  *
- * "graph" is the dependence graph in which a strongly connected
- * component is constructed.
- * "scc_cluster" maps each SCC index to the cluster to which it belongs.
- * "src" and "dst" are the indices of the nodes that are being merged.
- */
-struct isl_mark_merge_sccs_data {
-	struct isl_sched_graph *graph;
-	int *scc_cluster;
-	int src;
-	int dst;
-};
-
-/* Check whether the cluster containing node "i" depends on the cluster
- * containing node "j".  If "i" and "j" belong to the same cluster,
- * then they are taken to depend on each other to ensure that
- * the resulting strongly connected component consists of complete
- * clusters.  Furthermore, if "i" and "j" are the two nodes that
- * are being merged, then they are taken to depend on each other as well.
- * Otherwise, check if there is a (conditional) validity dependence
- * from node[j] to node[i], forcing node[i] to follow node[j].
+ * In particular, prefer the edge with the greatest weight.
+ * If they have the same weight, then prefer the one with
+ * the shortest distance between the two cluster representatives.
+ * If that is also the same, then prefer the one that appears first.
  */
-static isl_bool cluster_follows(int i, int j, void *user)
+static int better_merge_edge(struct isl_sched_graph *graph,
+	struct isl_clustering *c, int i, int j)
 {
-	struct isl_mark_merge_sccs_data *data = user;
-	struct isl_sched_graph *graph = data->graph;
-	int *scc_cluster = data->scc_cluster;
+	int dist_i, dist_j;
 
-	if (data->src == i && data->dst == j)
-		return isl_bool_true;
-	if (data->src == j && data->dst == i)
-		return isl_bool_true;
-	if (scc_cluster[graph->node[i].scc] == scc_cluster[graph->node[j].scc])
-		return isl_bool_true;
+	if (graph->edge[i].weight != graph->edge[j].weight)
+		return graph->edge[i].weight > graph->edge[j].weight;
+	dist_i = merge_edge_dist(graph, c, i);
+	dist_j = merge_edge_dist(graph, c, j);
+	if (dist_i != dist_j)
+		return dist_i < dist_j;
+	return i < j;
+}
 
-	return graph_has_validity_edge(graph, &graph->node[j], &graph->node[i]);
+/* Place edge "e" at position "pos" in c->heap.
+ */
+static void heap_set(struct isl_clustering *c, int pos, int e)
+{
+	c->heap[pos] = e;
+	c->heap_pos[e] = pos;
 }
 
-/* Mark all SCCs that belong to either of the two clusters in "c"
- * connected by the edge in "graph" with index "edge", or to any
- * of the intermediate clusters.
- * The marking is recorded in c->scc_in_merge.
- *
- * The given edge has been selected for merging two clusters,
- * meaning that there is at least a proximity edge between the two nodes.
- * However, there may also be (indirect) validity dependences
- * between the two nodes.  When merging the two clusters, all clusters
- * containing one or more of the intermediate nodes along the
- * indirect validity dependences need to be merged in as well.
- *
- * First collect all such nodes by computing the strongly connected
- * component (SCC) containing the two nodes connected by the edge, where
- * the two nodes are considered to depend on each other to make
- * sure they end up in the same SCC.  Similarly, each node is considered
- * to depend on every other node in the same cluster to ensure
- * that the SCC consists of complete clusters.
- *
- * Then the original SCCs that contain any of these nodes are marked
- * in c->scc_in_merge.
+/* Move the edge at position "pos" in c->heap up towards the root
+ * for as long as it is more appropriate than its parent.
  */
-static isl_stat mark_merge_sccs(isl_ctx *ctx, struct isl_sched_graph *graph,
-	int edge, struct isl_clustering *c)
+static void heap_sift_up(struct isl_sched_graph *graph,
+	struct isl_clustering *c, int pos)
 {
-	struct isl_mark_merge_sccs_data data;
-	struct isl_tarjan_graph *g;
-	int i;
+	int e = c->heap[pos];
+
+	while (pos > 0) {
+		int parent = (pos - 1) / 2;
+
+		if (!better_merge_edge(graph, c, e, c->heap[parent]))
+			break;
+		heap_set(c, pos, c->heap[parent]);
+		pos = parent;
+	}
+	heap_set(c, pos, e);
+}
+
+/* Move the edge at position "pos" in c->heap down towards the leaves
+ * for as long as one of its children is more appropriate.
+ */
+static void heap_sift_down(struct isl_sched_graph *graph,
+	struct isl_clustering *c, int pos)
+{
+	int e = c->heap[pos];
+
+	for (;;) {
+		int child = 2 * pos + 1;
+
+		if (child >= c->n_heap)
+			break;
+		if (child + 1 < c->n_heap &&
+		    better_merge_edge(graph, c, c->heap[child + 1],
+					c->heap[child]))
+			++child;
+		if (!better_merge_edge(graph, c, c->heap[child], e))
+			break;
+		heap_set(c, pos, c->heap[child]);
+		pos = child;
+	}
+	heap_set(c, pos, e);
+}
+
+/* Update the position of the edge in "graph" with index "i"
+ * in c->heap after its properties or those of the clusters
+ * it connects may have changed.
+ * That is, remove it from the heap if it can no longer be used
+ * for merging, add it if it can now be used for merging and
+ * otherwise restore the heap property.
+ */
+static isl_stat update_merge_edge(struct isl_sched_graph *graph,
+	struct isl_clustering *c, int i)
+{
+	isl_bool ok;
+	int pos;
+
+	ok = is_merge_edge(graph, c, i);
+	if (ok < 0)
+		return isl_stat_error;
+	pos = c->heap_pos[i];
+	if (!ok) {
+		int last;
+
+		if (pos < 0)
+			return isl_stat_ok;
+		c->heap_pos[i] = -1;
+		last = c->heap[--c->n_heap];
+		if (last == i)
+			return isl_stat_ok;
+		heap_set(c, pos, last);
+		heap_sift_up(graph, c, pos);
+		heap_sift_down(graph, c, c->heap_pos[last]);
+		return isl_stat_ok;
+	}
+	if (pos < 0) {
+		pos = c->n_heap++;
+		heap_set(c, pos, i);
+	}
+	heap_sift_up(graph, c, pos);
+	heap_sift_down(graph, c, c->heap_pos[i]);
+	return isl_stat_ok;
+}
+
+/* Insert all edges in "graph" that can be used to merge
+ * two clusters in "c" into c->heap.
+ * This needs to be called after the edge weights have been computed.
+ */
+static isl_stat init_merge_edges(struct isl_sched_graph *graph,
+	struct isl_clustering *c)
+{
+	int i;
+
+	for (i = 0; i < graph->n_edge; ++i)
+		if (update_merge_edge(graph, c, i) < 0)
+			return isl_stat_error;
+
+	return isl_stat_ok;
+}
+
+/* Update c->heap after an attempt at merging the clusters
+ * along the edge in "graph" with index "edge".
+ * The SCCs that were involved in the attempt are marked
+ * in c->scc_in_merge.
+ *
+ * Only the properties of the selected edge, those of the edges
+ * between SCCs involved in the attempt (through has_bounded_distances) and
+ * the cluster representatives and bands of the SCCs involved in the attempt
+ * may have changed, so only the edges that have at least one end
+ * in one of those SCCs need to be updated.
+ */
+static isl_stat update_merge_edges(struct isl_sched_graph *graph,
+	struct isl_clustering *c, int edge)
+{
+	int i;
+
+	for (i = 0; i < graph->n_edge; ++i) {
+		if (i != edge && !c->scc_in_merge[graph->edge[i].src->scc] &&
+		    !c->scc_in_merge[graph->edge[i].dst->scc])
+			continue;
+		if (update_merge_edge(graph, c, i) < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Return the index of an edge in "graph" that can be used to merge
+ * two clusters in "c".
+ * Return graph->n_edge if no such edge can be found.
+ *
+ * The candidate edges are kept in c->heap, with the most appropriate
+ * edge (see better_merge_edge) at the root.
+ */
+static int find_proximity(struct isl_sched_graph *graph,
+	struct isl_clustering *c)
+{
+	if (c->n_heap == 0)
+		return graph->n_edge;
+	return c->heap[0];
+}
+
+/* Internal data structure used in mark_merge_sccs.
+ *
+ * "graph" is the dependence graph in which a strongly connected
+ * component is constructed.
+ * "adj" contains the (conditional) validity dependences of "graph".
+ * "scc_cluster" maps each SCC index to the cluster to which it belongs.
+ * "src" and "dst" are the indices of the nodes that are being merged.
+ */
+struct isl_mark_merge_sccs_data {
+	struct isl_sched_graph *graph;
+	struct isl_sched_adjacency adj;
+	int *scc_cluster;
+	int src;
+	int dst;
+};
+
+/* Check whether the cluster containing node "i" depends on the cluster
+ * containing node "j".  If "i" and "j" belong to the same cluster,
+ * then they are taken to depend on each other to ensure that
+ * the resulting strongly connected component consists of complete
+ * clusters.  Furthermore, if "i" and "j" are the two nodes that
+ * are being merged, then they are taken to depend on each other as well.
+ * Otherwise, check if there is a (conditional) validity dependence
+ * from node[j] to node[i], forcing node[i] to follow node[j].
+ */
+static isl_bool cluster_follows(int i, int j, void *user)
+{
+	struct isl_mark_merge_sccs_data *data = user;
+	struct isl_sched_graph *graph = data->graph;
+	int *scc_cluster = data->scc_cluster;
+
+	if (data->src == i && data->dst == j)
+		return isl_bool_true;
+	if (data->src == j && data->dst == i)
+		return isl_bool_true;
+	if (scc_cluster[graph->node[i].scc] == scc_cluster[graph->node[j].scc])
+		return isl_bool_true;
+
+	return isl_bool_ok(isl_sched_adjacency_follows(&data->adj, i, j));
+}
+
+/* Mark all SCCs that belong to either of the two clusters in "c"
+ * connected by the edge in "graph" with index "edge", or to any
+ * of the intermediate clusters.
+ * The marking is recorded in c->scc_in_merge.
+ *
+ * The given edge has been selected for merging two clusters,
+ * meaning that there is at least a proximity edge between the two nodes.
+ * However, there may also be (indirect) validity dependences
+ * between the two nodes.  When merging the two clusters, all clusters
+ * containing one or more of the intermediate nodes along the
+ * indirect validity dependences need to be merged in as well.
+ *
+ * First collect all such nodes by computing the strongly connected
+ * component (SCC) containing the two nodes connected by the edge, where
+ * the two nodes are considered to depend on each other to make
+ * sure they end up in the same SCC.  Similarly, each node is considered
+ * to depend on every other node in the same cluster to ensure
+ * that the SCC consists of complete clusters.
+ *
+ * Then the original SCCs that contain any of these nodes are marked
+ * in c->scc_in_merge.
+ */
+static isl_stat mark_merge_sccs(isl_ctx *ctx, struct isl_sched_graph *graph,
+	int edge, struct isl_clustering *c)
+{
+	struct isl_mark_merge_sccs_data data;
+	struct isl_tarjan_graph *g;
+	int i;
 
 	for (i = 0; i < c->n; ++i)
 		c->scc_in_merge[i] = 0;
@@ -6164,8 +7131,11 @@ static isl_stat mark_merge_sccs(isl_ctx *ctx, struct isl_sched_graph *graph,
 	data.src = graph->edge[edge].src - graph->node;
 	data.dst = graph->edge[edge].dst - graph->node;
 
+	if (isl_sched_adjacency_init(ctx, &data.adj, graph, 0) < 0)
+		return isl_stat_error;
 	g = isl_tarjan_graph_component(ctx, graph->n, data.dst,
 					&cluster_follows, &data);
+	isl_sched_adjacency_clear(&data.adj);
 	if (!g)
 		goto error;
 
@@ -6253,41 +7223,67 @@ static __isl_give isl_union_set *collect_domain(isl_ctx *ctx,
 	return domain;
 }
 
+/* Free the array "cluster_map" of "n" maps constructed
+ * by collect_cluster_map and return NULL.
+ */
+static isl_map **free_cluster_map(isl_map **cluster_map, int n)
+{
+	int i;
+
+	if (!cluster_map)
+		return NULL;
+	for (i = 0; i < n; ++i)
+		isl_map_free(cluster_map[i]);
+	free(cluster_map);
+
+	return NULL;
+}
+
 /* Construct a map from the original instances to the corresponding
  * cluster instance in the current bands of the clusters in "c".
+ * The map is returned in pieces, one for each node in "graph",
+ * where the element at the position of a node is a map
+ * from the instances of that node to the cluster instances,
+ * or NULL if the node does not belong to an SCC marked for merging.
+ *
+ * Keeping the pieces separate allows collect_edge_constraints
+ * to only consider the pieces that are relevant for a given edge,
+ * rather than the entire map, the size of which is proportional
+ * to the number of nodes.
  */
-static __isl_give isl_union_map *collect_cluster_map(isl_ctx *ctx,
+static isl_map **collect_cluster_map(isl_ctx *ctx,
 	struct isl_sched_graph *graph, struct isl_clustering *c)
 {
-	int i, j;
-	isl_space *space;
-	isl_union_map *cluster_map;
+	int i;
+	isl_map **cluster_map;
 
-	space = isl_space_params_alloc(ctx, 0);
-	cluster_map = isl_union_map_empty(space);
-	for (i = 0; i < graph->scc; ++i) {
-		int start, n;
+	cluster_map = isl_calloc_array(ctx, isl_map *, graph->n);
+	if (graph->n && !cluster_map)
+		return NULL;
+	for (i = 0; i < graph->n; ++i) {
+		int scc, start, n;
 		isl_id *id;
+		isl_multi_aff *ma;
+		struct isl_sched_node *node;
 
-		if (!c->scc_in_merge[i])
+		scc = graph->node[i].scc;
+		if (!c->scc_in_merge[scc])
 			continue;
 
-		id = cluster_id(ctx, c->scc_cluster[i]);
-		start = c->scc[i].band_start;
-		n = c->scc[i].n_total_row - start;
-		for (j = 0; j < c->scc[i].n; ++j) {
-			isl_multi_aff *ma;
-			isl_map *map;
-			struct isl_sched_node *node = &c->scc[i].node[j];
-
-			ma = node_extract_partial_schedule_multi_aff(node,
-								    start, n);
-			ma = isl_multi_aff_set_tuple_id(ma, isl_dim_out,
-							    isl_id_copy(id));
-			map = isl_map_from_multi_aff(ma);
-			cluster_map = isl_union_map_add_map(cluster_map, map);
-		}
-		isl_id_free(id);
+		node = graph_find_node(ctx, &c->scc[scc], graph->node[i].space);
+		if (!node)
+			return free_cluster_map(cluster_map, graph->n);
+		if (!is_node(&c->scc[scc], node))
+			isl_die(ctx, isl_error_internal, "node not found",
+				return free_cluster_map(cluster_map, graph->n));
+		id = cluster_id(ctx, c->scc_cluster[scc]);
+		start = c->scc[scc].band_start;
+		n = c->scc[scc].n_total_row - start;
+		ma = node_extract_partial_schedule_multi_aff(node, start, n);
+		ma = isl_multi_aff_set_tuple_id(ma, isl_dim_out, id);
+		cluster_map[i] = isl_map_from_multi_aff(ma);
+		if (!cluster_map[i])
+			return free_cluster_map(cluster_map, graph->n);
 	}
 
 	return cluster_map;
@@ -6349,50 +7345,52 @@ static __isl_give isl_schedule_constraints *add_conditional_constraints(
 	return sc;
 }
 
-/* Given a mapping "cluster_map" from the original instances to
+/* Given mappings "src_map" and "dst_map" from the instances
+ * of the source and destination nodes of "edge" to
  * the cluster instances, add schedule constraints on the clusters
  * to "sc" corresponding to the original constraints represented by "edge".
  *
  * For non-tagged dependence constraints, the cluster constraints
- * are obtained by applying "cluster_map" to the edge->map.
+ * are obtained by applying "src_map" and "dst_map" to the domain and
+ * range of edge->map.  An empty result is not added.
  *
- * For tagged dependence constraints, "cluster_map" needs to be applied
+ * For tagged dependence constraints, the mappings need to be applied
  * to the domains of the wrapped relations in domain and range
- * of the tagged dependence constraints.  Pick out the mappings
- * from these domains from "cluster_map" and construct their product.
+ * of the tagged dependence constraints.  Construct the product
+ * of "src_map" and "dst_map".
  * This mapping can then be applied to the pair of domains.
  */
 static __isl_give isl_schedule_constraints *collect_edge_constraints(
-	struct isl_sched_edge *edge, __isl_keep isl_union_map *cluster_map,
-	__isl_take isl_schedule_constraints *sc)
+	struct isl_sched_edge *edge, __isl_keep isl_map *src_map,
+	__isl_keep isl_map *dst_map, __isl_take isl_schedule_constraints *sc)
 {
+	isl_map *map;
 	isl_union_map *umap;
-	isl_space *space;
-	isl_union_set *uset;
 	isl_union_map *umap1, *umap2;
+	isl_bool empty;
 
 	if (!sc)
 		return NULL;
 
-	umap = isl_union_map_from_map(isl_map_copy(edge->map));
-	umap = isl_union_map_apply_domain(umap,
-				isl_union_map_copy(cluster_map));
-	umap = isl_union_map_apply_range(umap,
-				isl_union_map_copy(cluster_map));
+	map = isl_map_copy(edge->map);
+	map = isl_map_apply_domain(map, isl_map_copy(src_map));
+	map = isl_map_apply_range(map, isl_map_copy(dst_map));
+	empty = isl_map_is_empty(map);
+	if (empty < 0)
+		map = isl_map_free(map);
+	if (empty >= 0 && empty)
+		umap = isl_union_map_empty(isl_map_get_space(map));
+	else
+		umap = isl_union_map_from_map(isl_map_copy(map));
+	isl_map_free(map);
 	sc = add_non_conditional_constraints(edge, umap, sc);
 	isl_union_map_free(umap);
 
 	if (!sc || (!is_condition(edge) && !is_conditional_validity(edge)))
 		return sc;
 
-	space = isl_space_domain(isl_map_get_space(edge->map));
-	uset = isl_union_set_from_set(isl_set_universe(space));
-	umap1 = isl_union_map_copy(cluster_map);
-	umap1 = isl_union_map_intersect_domain(umap1, uset);
-	space = isl_space_range(isl_map_get_space(edge->map));
-	uset = isl_union_set_from_set(isl_set_universe(space));
-	umap2 = isl_union_map_copy(cluster_map);
-	umap2 = isl_union_map_intersect_domain(umap2, uset);
+	umap1 = isl_union_map_from_map(isl_map_copy(src_map));
+	umap2 = isl_union_map_from_map(isl_map_copy(dst_map));
 	umap = isl_union_map_product(umap1, umap2);
 
 	sc = add_conditional_constraints(edge, umap, sc);
@@ -6402,25 +7400,31 @@ static __isl_give isl_schedule_constraints *collect_edge_constraints(
 }
 
 /* Given a mapping "cluster_map" from the original instances to
- * the cluster instances, add schedule constraints on the clusters
+ * the cluster instances, in pieces as constructed by collect_cluster_map,
+ * add schedule constraints on the clusters
  * to "sc" corresponding to all edges in "graph" between nodes that
  * belong to SCCs that are marked for merging in "scc_in_merge".
  */
 static __isl_give isl_schedule_constraints *collect_constraints(
 	struct isl_sched_graph *graph, int *scc_in_merge,
-	__isl_keep isl_union_map *cluster_map,
-	__isl_take isl_schedule_constraints *sc)
+	isl_map **cluster_map, __isl_take isl_schedule_constraints *sc)
 {
 	int i;
 
+	if (graph->n_edge > 0 && !cluster_map)
+		return isl_schedule_constraints_free(sc);
+
 	for (i = 0; i < graph->n_edge; ++i) {
 		struct isl_sched_edge *edge = &graph->edge[i];
+		isl_map *src_map, *dst_map;
 
 		if (!scc_in_merge[edge->src->scc])
 			continue;
 		if (!scc_in_merge[edge->dst->scc])
 			continue;
-		sc = collect_edge_constraints(edge, cluster_map, sc);
+		src_map = cluster_map[edge->src - graph->node];
+		dst_map = cluster_map[edge->dst - graph->node];
+		sc = collect_edge_constraints(edge, src_map, dst_map, sc);
 	}
 
 	return sc;
@@ -6441,7 +7445,7 @@ static isl_stat init_merge_graph(isl_ctx *ctx, struct isl_sched_graph *graph,
 	struct isl_clustering *c, struct isl_sched_graph *merge_graph)
 {
 	isl_union_set *domain;
-	isl_union_map *cluster_map;
+	isl_map **cluster_map;
 	isl_schedule_constraints *sc;
 	isl_stat r;
 
@@ -6451,7 +7455,7 @@ static isl_stat init_merge_graph(isl_ctx *ctx, struct isl_sched_graph *graph,
 		return isl_stat_error;
 	cluster_map = collect_cluster_map(ctx, graph, c);
 	sc = collect_constraints(graph, c->scc_in_merge, cluster_map, sc);
-	isl_union_map_free(cluster_map);
+	free_cluster_map(cluster_map, graph->n);
 
 	r = graph_init(merge_graph, sc);
 
@@ -7121,6 +8125,31 @@ static int any_no_merge(struct isl_sched_graph *graph, int *scc_in_merge,
 	return 0;
 }
 
+/* Print a trace entry for an attempt at merging the clusters in "c"
+ * along the edge with index "edge" that started at "trace",
+ * if the schedule_trace option is set.
+ * "merged" is the result of the attempt.
+ * The number of SCCs involved in the attempt is also printed.
+ */
+static void trace_merge(isl_ctx *ctx, struct isl_sched_trace *trace,
+	struct isl_clustering *c, int edge, int merged)
+{
+	int i, n;
+	isl_printer *p;
+
+	p = trace_entry_start(ctx, trace, "merge");
+	if (!p)
+		return;
+	n = 0;
+	for (i = 0; i < c->n; ++i)
+		if (c->scc_in_merge[i])
+			n++;
+	p = print_trace_int(p, "edge", edge);
+	p = print_trace_int(p, "sccs", n);
+	p = print_trace_int(p, "merged", merged);
+	trace_entry_end(p);
+}
+
 /* Merge the two clusters in "c" connected by the edge in "graph"
  * with index "edge" into a single cluster.
  * If it turns out to be impossible to merge these two clusters,
@@ -7144,7 +8173,9 @@ static isl_stat merge_clusters_along_edge(isl_ctx *ctx,
 {
 	isl_bool merged;
 	int edge_weight = graph->edge[edge].weight;
+	struct isl_sched_trace trace;
 
+	trace_start(ctx, &trace);
 	if (mark_merge_sccs(ctx, graph, edge, c) < 0)
 		return isl_stat_error;
 
@@ -7154,6 +8185,7 @@ static isl_stat merge_clusters_along_edge(isl_ctx *ctx,
 		merged = try_merge(ctx, graph, c);
 	if (merged < 0)
 		return isl_stat_error;
+	trace_merge(ctx, &trace, c, edge, merged);
 	if (!merged && edge_weight == graph->edge[edge].weight)
 		graph->edge[edge].no_merge = 1;
 
@@ -7185,6 +8217,7 @@ static void swap_sched(struct isl_sched_node *node1,
 {
 	isl_mat *sched;
 	isl_map *sched_map;
+	int sched_map_start;
 
 	sched = node1->sched;
 	node1->sched = node2->sched;
@@ -7193,6 +8226,9 @@ static void swap_sched(struct isl_sched_node *node1,
 	sched_map = node1->sched_map;
 	node1->sched_map = node2->sched_map;
 	node2->sched_map = sched_map;
+	sched_map_start = node1->sched_map_start;
+	node1->sched_map_start = node2->sched_map_start;
+	node2->sched_map_start = sched_map_start;
 }
 
 /* Copy the current band schedule from the SCCs that form the cluster
@@ -7232,17 +8268,46 @@ static isl_stat copy_partial(struct isl_sched_graph *graph,
 	return isl_stat_ok;
 }
 
+/* Internal data structure for node_follows_strong_or_same_cluster.
+ *
+ * "graph" is the dependence graph.
+ * "adj" contains the (conditional) validity dependences of "graph".
+ */
+struct isl_follows_same_cluster_data {
+	struct isl_sched_graph *graph;
+	struct isl_sched_adjacency adj;
+};
+
 /* Is there a (conditional) validity dependence from node[j] to node[i],
  * forcing node[i] to follow node[j] or do the nodes belong to the same
  * cluster?
  */
 static isl_bool node_follows_strong_or_same_cluster(int i, int j, void *user)
 {
-	struct isl_sched_graph *graph = user;
+	struct isl_follows_same_cluster_data *data = user;
+	struct isl_sched_graph *graph = data->graph;
 
 	if (graph->node[i].cluster == graph->node[j].cluster)
 		return isl_bool_true;
-	return graph_has_validity_edge(graph, &graph->node[j], &graph->node[i]);
+	return isl_bool_ok(isl_sched_adjacency_follows(&data->adj, i, j));
+}
+
+/* Use Tarjan's algorithm for computing the strongly connected components
+ * in "graph", where nodes that belong to the same cluster
+ * are considered to depend on each other.
+ */
+static isl_stat detect_cluster_sccs(isl_ctx *ctx,
+	struct isl_sched_graph *graph)
+{
+	struct isl_follows_same_cluster_data data = { graph };
+	struct isl_tarjan_graph *g;
+
+	if (isl_sched_adjacency_init(ctx, &data.adj, graph, 0) < 0)
+		return isl_stat_error;
+	g = isl_tarjan_graph_init(ctx, graph->n,
+				&node_follows_strong_or_same_cluster, &data);
+	isl_sched_adjacency_clear(&data.adj);
+	return set_ccs(graph, g);
 }
 
 /* Extract the merged clusters of SCCs in "graph", sort them, and
@@ -7280,7 +8345,7 @@ static isl_stat extract_clusters(isl_ctx *ctx, struct isl_sched_graph *graph,
 			return isl_stat_error;
 	}
 
-	if (detect_ccs(ctx, graph, &node_follows_strong_or_same_cluster) < 0)
+	if (detect_cluster_sccs(ctx, graph) < 0)
 		return isl_stat_error;
 	for (i = 0; i < graph->n; ++i)
 		c->scc_cluster[graph->node[i].scc] = graph->node[i].cluster;
@@ -7429,15 +8494,17 @@ static __isl_give isl_schedule_node *compute_schedule_wcc_clustering(
 
 	if (compute_weights(graph, &c) < 0)
 		goto error;
+	if (init_merge_edges(graph, &c) < 0)
+		goto error;
 
 	for (;;) {
 		i = find_proximity(graph, &c);
-		if (i < 0)
-			goto error;
 		if (i >= graph->n_edge)
 			break;
 		if (merge_clusters_along_edge(ctx, graph, i, &c) < 0)
 			goto error;
+		if (update_merge_edges(graph, &c, i) < 0)
+			goto error;
 	}
 
 	if (extract_clusters(ctx, graph, &c) < 0)
@@ -7578,6 +8645,463 @@ static __isl_give isl_schedule_node *compute_schedule(isl_schedule_node *node,
 	return compute_schedule_wcc(node, graph);
 }
 
+/* Return the schedule tree below the root domain node of "schedule".
+ */
+static __isl_give isl_schedule_tree *extract_component_tree(
+	__isl_take isl_schedule *schedule)
+{
+	isl_schedule_node *node;
+	isl_schedule_tree *tree;
+
+	node = isl_schedule_get_root(schedule);
+	isl_schedule_free(schedule);
+	node = isl_schedule_node_child(node, 0);
+	tree = isl_schedule_node_get_tree(node);
+	isl_schedule_node_free(node);
+
+	return tree;
+}
+
+/* Parse "reply" as a schedule in binary format and check
+ * that it is a schedule on the domain of "sc".
+ * Return the schedule if so and NULL otherwise.
+ *
+ * Errors are not reported during the parsing since an invalid reply
+ * is not considered to be an error.
+ * This function may be called from several threads, each with
+ * their own child context, so the on_error option, which is shared
+ * by all these contexts, cannot be changed here.
+ * Instead, the errors are suppressed in "ctx" only.
+ */
+static __isl_give isl_schedule *parse_offload_reply(
+	__isl_keep isl_schedule_constraints *sc, const char *reply)
+{
+	isl_ctx *ctx = isl_schedule_constraints_get_ctx(sc);
+	isl_schedule *schedule;
+	isl_union_set *domain, *sc_domain;
+	isl_bool equal;
+
+	isl_ctx_quiet_enter(ctx);
+	schedule = isl_schedule_read_from_binary_str(ctx, reply);
+	isl_ctx_quiet_leave(ctx);
+	if (!schedule) {
+		isl_ctx_reset_error(ctx);
+		return NULL;
+	}
+
+	domain = isl_schedule_get_domain(schedule);
+	sc_domain = isl_schedule_constraints_get_domain(sc);
+	equal = isl_union_set_is_equal(domain, sc_domain);
+	isl_union_set_free(domain);
+	isl_union_set_free(sc_domain);
+	if (equal < 0 || !equal)
+		return isl_schedule_free(schedule);
+
+	return schedule;
+}
+
+/* Try and obtain a schedule for the schedule constraints "sc"
+ * of a weakly connected component from the transport set through
+ * isl_options_set_schedule_offload, if any, and
+ * return the schedule tree below its root domain node.
+ * Return NULL if the schedule should be computed locally instead.
+ *
+ * The schedule constraints are passed to the transport in binary format
+ * and the transport is expected to return a schedule in binary format
+ * or NULL if it is unable to compute the schedule.
+ * Apart from checking that the returned schedule is a schedule
+ * on the domain of "sc", the result is taken as is.
+ * If there is no transport, if it does not return a schedule or
+ * if the schedule is rejected, then NULL is returned
+ * such that the caller can compute the schedule itself.
+ */
+static __isl_give isl_schedule_tree *offload_component_tree(
+	__isl_keep isl_schedule_constraints *sc)
+{
+	isl_ctx *ctx;
+	isl_printer *p;
+	isl_schedule *schedule;
+	char *request, *reply;
+
+	ctx = isl_schedule_constraints_get_ctx(sc);
+	if (!ctx || !ctx->opt->schedule_offload)
+		return NULL;
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_set_output_format(p, ISL_FORMAT_BINARY);
+	p = isl_printer_print_schedule_constraints(p, sc);
+	request = isl_printer_get_str(p);
+	isl_printer_free(p);
+	if (!request)
+		return NULL;
+
+	reply = ctx->opt->schedule_offload(ctx, request,
+					ctx->opt->schedule_offload_user);
+	free(request);
+	schedule = reply ? parse_offload_reply(sc, reply) : NULL;
+	free(reply);
+	if (!schedule) {
+		ctx->stats->schedule_offload_rejects++;
+		return NULL;
+	}
+	ctx->stats->schedule_offload_accepts++;
+
+	return extract_component_tree(schedule);
+}
+
+/* Compute a schedule for the schedule constraints "sc" in "ctx" and
+ * return the schedule tree below its root domain node.
+ * "sc" itself is only read.
+ *
+ * The schedule is only computed locally if it could not be obtained
+ * from the transport set through isl_options_set_schedule_offload.
+ */
+static __isl_give isl_schedule_tree *compute_component_tree(
+	__isl_keep isl_schedule_constraints *sc, isl_ctx *ctx)
+{
+	isl_schedule *schedule;
+	isl_schedule_tree *tree;
+
+	sc = isl_schedule_constraints_copy_to_ctx(sc, ctx);
+	tree = offload_component_tree(sc);
+	if (tree) {
+		isl_schedule_constraints_free(sc);
+		return tree;
+	}
+	schedule = isl_schedule_constraints_compute_schedule(sc);
+	return extract_component_tree(schedule);
+}
+
+/* Data used by compute_component_trees.
+ * Task "k" computes the schedule tree for the schedule constraints "sc[k]"
+ * and stores the result in "res[k]".
+ */
+struct isl_sched_tasks {
+	isl_schedule_constraints **sc;
+	isl_schedule_tree **res;
+};
+
+/* Compute the schedule tree of task "k" in "ctx".
+ */
+static isl_stat sched_task_run(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_sched_tasks *data = user;
+
+	data->res[k] = compute_component_tree(data->sc[k], ctx);
+	return data->res[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* Copy the schedule tree computed by task "k" to "ctx".
+ */
+static isl_stat sched_task_merge(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_sched_tasks *data = user;
+	isl_schedule_tree *child = data->res[k];
+
+	data->res[k] = isl_schedule_tree_copy_to_ctx(child, ctx);
+	isl_schedule_tree_free(child);
+	return data->res[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* Compute the schedule trees for the "n" schedule constraints in "sc"
+ * and store the results in "res", using up to "n_thread" threads,
+ * each tree being computed in a task of isl_ctx_run_tasks.
+ * If anything goes wrong, then the trees that have been
+ * computed are freed.
+ */
+static isl_stat compute_component_trees(isl_ctx *ctx,
+	isl_schedule_constraints **sc, int n, isl_schedule_tree **res,
+	int n_thread)
+{
+	int k;
+	struct isl_sched_tasks data = { sc, res };
+
+	for (k = 0; k < n; ++k)
+		res[k] = NULL;
+	if (isl_ctx_run_tasks(ctx, n, n_thread, &sched_task_run,
+				&sched_task_merge, &data) >= 0)
+		return isl_stat_ok;
+	for (k = 0; k < n; ++k)
+		res[k] = isl_schedule_tree_free(res[k]);
+	return isl_stat_error;
+}
+
+/* A previously computed schedule that may be reused
+ * by isl_schedule_constraints_recompute_schedule.
+ * "sc" are the schedule constraints for which the schedule was computed.
+ * "tree" is the schedule tree below the root domain node of the schedule.
+ */
+struct isl_sched_reuse {
+	isl_schedule_constraints *sc;
+	isl_schedule_tree *tree;
+};
+
+/* Is "tree" a filter node with a filter equal to "filter"?
+ */
+static isl_bool is_filter(__isl_keep isl_schedule_tree *tree,
+	__isl_keep isl_union_set *filter)
+{
+	isl_union_set *tree_filter;
+	isl_bool equal;
+
+	if (isl_schedule_tree_get_type(tree) != isl_schedule_node_filter)
+		return isl_bool_false;
+	tree_filter = isl_schedule_tree_filter_get_filter(tree);
+	equal = isl_union_set_is_equal(tree_filter, filter);
+	isl_union_set_free(tree_filter);
+
+	return equal;
+}
+
+/* Look for a schedule tree for the schedule constraints "sc"
+ * in the previously computed schedule "reuse", if any, and
+ * store a copy in "tree", or NULL if no such tree could be found.
+ * If "filter" is not NULL, then "sc" are the schedule constraints
+ * of the component of the dependence graph with domain "filter".
+ *
+ * If the previous schedule constraints are obviously equal to "sc",
+ * then the entire previous schedule tree can be reused.
+ * Otherwise, if the previous schedule tree is a set or sequence node
+ * with a child filtering out exactly the instances of "filter" and
+ * if the previous schedule constraints restricted to "filter"
+ * are obviously equal to "sc", then the subtree of that child
+ * can be reused.  Since the dependence graph has no edges
+ * between "filter" and the other instances, the subtree
+ * was computed independently of those instances.
+ */
+static isl_stat find_reusable_tree(struct isl_sched_reuse *reuse,
+	__isl_keep isl_schedule_constraints *sc,
+	__isl_keep isl_union_set *filter, isl_schedule_tree **tree)
+{
+	int i;
+	isl_size n;
+	isl_bool equal;
+	enum isl_schedule_node_type type;
+	isl_schedule_constraints *prev;
+	isl_schedule_tree *child;
+
+	*tree = NULL;
+	if (!reuse)
+		return isl_stat_ok;
+
+	equal = isl_schedule_constraints_plain_is_equal(reuse->sc, sc);
+	if (equal < 0)
+		return isl_stat_error;
+	if (equal) {
+		*tree = isl_schedule_tree_copy(reuse->tree);
+		return isl_stat_non_null(*tree);
+	}
+	if (!filter)
+		return isl_stat_ok;
+
+	type = isl_schedule_tree_get_type(reuse->tree);
+	if (type != isl_schedule_node_set && type != isl_schedule_node_sequence)
+		return isl_stat_ok;
+	n = isl_schedule_tree_n_children(reuse->tree);
+	if (n < 0)
+		return isl_stat_error;
+	for (i = 0; i < n; ++i) {
+		child = isl_schedule_tree_get_child(reuse->tree, i);
+		equal = is_filter(child, filter);
+		if (equal < 0 || equal)
+			break;
+		isl_schedule_tree_free(child);
+	}
+	if (equal < 0)
+		goto error;
+	if (i >= n)
+		return isl_stat_ok;
+
+	prev = isl_schedule_constraints_copy(reuse->sc);
+	prev = isl_schedule_constraints_intersect_domain(prev,
+						isl_union_set_copy(filter));
+	equal = isl_schedule_constraints_plain_is_equal(prev, sc);
+	isl_schedule_constraints_free(prev);
+	if (equal < 0)
+		goto error;
+	if (!equal) {
+		isl_schedule_tree_free(child);
+		return isl_stat_ok;
+	}
+
+	if (isl_schedule_tree_has_children(child))
+		*tree = isl_schedule_tree_get_child(child, 0);
+	else
+		*tree = isl_schedule_tree_leaf(isl_schedule_tree_get_ctx(child));
+	isl_schedule_tree_free(child);
+	return isl_stat_non_null(*tree);
+error:
+	isl_schedule_tree_free(child);
+	return isl_stat_error;
+}
+
+/* Compute a schedule for each weakly connected component of "graph",
+ * identified by node->scc, separately, using up to "n_thread" threads,
+ * and combine them in a set node (or a sequence node
+ * if graph->weak is not set) inserted at position "node"
+ * of the schedule tree.
+ * "sc" are the schedule constraints from which "graph" was constructed.
+ * "reuse" is a previously computed schedule that may be reused
+ * for some of the components, or NULL if there is no such schedule.
+ * Return the updated schedule node.
+ *
+ * Since the components share nothing, a schedule for each of them
+ * can be computed from scratch from the schedule constraints
+ * restricted to the component.
+ * These restrictions are computed upfront by the calling thread,
+ * which also looks for a reusable tree for each of them.
+ * The remaining trees are computed in compute_component_trees,
+ * possibly by offloading them to the transport set through
+ * isl_options_set_schedule_offload.
+ * The resulting trees are grafted into the set (or sequence) node
+ * in the order of the components, so that the result
+ * does not depend on the number of threads.
+ *
+ * As in compute_component_schedule, no set node is introduced
+ * if the schedule is already complete.
+ */
+static __isl_give isl_schedule_node *compute_component_schedule_threads(
+	__isl_take isl_schedule_node *node, struct isl_sched_graph *graph,
+	__isl_keep isl_schedule_constraints *sc, int n_thread,
+	struct isl_sched_reuse *reuse)
+{
+	int k, n, n_todo;
+	isl_ctx *ctx;
+	isl_union_set_list *filters;
+	isl_schedule_constraints **sub = NULL;
+	isl_schedule_tree **trees = NULL;
+	isl_schedule_tree **todo_trees = NULL;
+	int *todo = NULL;
+
+	if (!node)
+		return NULL;
+
+	if (graph->weak && graph->scc == graph->n) {
+		if (compute_maxvar(graph) < 0)
+			return isl_schedule_node_free(node);
+		if (graph->n_row >= graph->maxvar)
+			return node;
+	}
+
+	ctx = isl_schedule_node_get_ctx(node);
+	n = graph->scc;
+	filters = extract_sccs(ctx, graph);
+	sub = isl_calloc_array(ctx, isl_schedule_constraints *, n);
+	trees = isl_calloc_array(ctx, isl_schedule_tree *, n);
+	todo_trees = isl_calloc_array(ctx, isl_schedule_tree *, n);
+	todo = isl_alloc_array(ctx, int, n);
+	if (!filters || !sub || !trees || !todo_trees || !todo)
+		goto error;
+	n_todo = 0;
+	for (k = 0; k < n; ++k) {
+		isl_union_set *filter;
+		isl_stat r;
+
+		filter = isl_union_set_list_get_union_set(filters, k);
+		sub[k] = isl_schedule_constraints_copy(sc);
+		sub[k] = isl_schedule_constraints_intersect_domain(sub[k],
+						isl_union_set_copy(filter));
+		r = find_reusable_tree(reuse, sub[k], filter, &trees[k]);
+		isl_union_set_free(filter);
+		if (!sub[k] || r < 0)
+			goto error;
+		if (trees[k]) {
+			ctx->stats->schedule_component_reuses++;
+			sub[k] = isl_schedule_constraints_free(sub[k]);
+			continue;
+		}
+		sub[n_todo] = sub[k];
+		if (n_todo != k)
+			sub[k] = NULL;
+		todo[n_todo++] = k;
+	}
+	if (compute_component_trees(ctx, sub, n_todo, todo_trees,
+					n_thread) < 0)
+		goto error;
+	for (k = 0; k < n_todo; ++k)
+		trees[todo[k]] = todo_trees[k];
+
+	if (graph->weak)
+		node = isl_schedule_node_insert_set(node, filters);
+	else
+		node = isl_schedule_node_insert_sequence(node, filters);
+	filters = NULL;
+
+	for (k = 0; k < n; ++k) {
+		node = isl_schedule_node_grandchild(node, k, 0);
+		node = isl_schedule_node_graft_tree(node, trees[k]);
+		trees[k] = NULL;
+		node = isl_schedule_node_grandparent(node);
+	}
+
+	for (k = 0; k < n; ++k)
+		isl_schedule_constraints_free(sub[k]);
+	free(sub);
+	free(trees);
+	free(todo_trees);
+	free(todo);
+	return node;
+error:
+	for (k = 0; sub && k < n; ++k)
+		isl_schedule_constraints_free(sub[k]);
+	for (k = 0; trees && k < n; ++k)
+		isl_schedule_tree_free(trees[k]);
+	free(sub);
+	free(trees);
+	free(todo_trees);
+	free(todo);
+	isl_union_set_list_free(filters);
+	return isl_schedule_node_free(node);
+}
+
+/* Compute a schedule for the dependence graph "graph" constructed
+ * from the schedule constraints "sc" and insert it at "node".
+ * "reuse" is a previously computed schedule that may be reused,
+ * or NULL if there is no such schedule.
+ * Return the updated schedule node.
+ *
+ * If the schedule_threads option is set to a value greater than one,
+ * if there is a previously computed schedule or
+ * if a transport has been set through isl_options_set_schedule_offload,
+ * then compute a schedule for each weakly connected component
+ * separately in compute_component_schedule_threads,
+ * reusing parts of the previously computed schedule, if possible.
+ * If there is only a single component, then the previously computed
+ * schedule can only be reused as a whole.
+ * Otherwise, or if the schedule_serialize_sccs option is set,
+ * simply call compute_schedule.
+ */
+static __isl_give isl_schedule_node *compute_schedule_root(
+	__isl_take isl_schedule_node *node, struct isl_sched_graph *graph,
+	__isl_keep isl_schedule_constraints *sc, struct isl_sched_reuse *reuse)
+{
+	isl_ctx *ctx;
+	int n_thread;
+	isl_schedule_tree *tree;
+
+	if (!node)
+		return NULL;
+
+	ctx = isl_schedule_node_get_ctx(node);
+	n_thread = isl_options_get_schedule_threads(ctx);
+	if ((n_thread <= 1 && !reuse && !ctx->opt->schedule_offload) ||
+	    isl_options_get_schedule_serialize_sccs(ctx))
+		return compute_schedule(node, graph);
+
+	if (detect_wccs(ctx, graph) < 0)
+		return isl_schedule_node_free(node);
+	if (graph->scc > 1)
+		return compute_component_schedule_threads(node, graph, sc,
+							n_thread, reuse);
+
+	if (find_reusable_tree(reuse, sc, NULL, &tree) < 0)
+		return isl_schedule_node_free(node);
+	if (!tree)
+		return compute_schedule_wcc(node, graph);
+	ctx->stats->schedule_component_reuses++;
+	return isl_schedule_node_graft_tree(node, tree);
+}
+
 /* Compute a schedule on sc->domain that respects the given schedule
  * constraints.
  *
@@ -7592,12 +9116,16 @@ static __isl_give isl_schedule_node *compute_schedule(isl_schedule_node *node,
  * then the conditional validity dependences may be violated inside
  * a tilable band, provided they have no adjacent non-local
  * condition dependences.
+ *
+ * If "reuse" is not NULL, then parts of this previously computed
+ * schedule are reused where possible.
  */
-__isl_give isl_schedule *isl_schedule_constraints_compute_schedule(
-	__isl_take isl_schedule_constraints *sc)
+static __isl_give isl_schedule *compute_schedule_reuse(
+	__isl_take isl_schedule_constraints *sc, struct isl_sched_reuse *reuse)
 {
 	isl_ctx *ctx = isl_schedule_constraints_get_ctx(sc);
 	struct isl_sched_graph graph = { 0 };
+	struct isl_sched_trace trace;
 	isl_schedule *sched;
 	isl_schedule_node *node;
 	isl_union_set *domain;
@@ -7612,13 +9140,17 @@ __isl_give isl_schedule *isl_schedule_constraints_compute_schedule(
 		return isl_schedule_from_domain(domain);
 	}
 
+	if (n > 0)
+		trace_start(ctx, &trace);
 	if (n < 0 || graph_init(&graph, sc) < 0)
 		domain = isl_union_set_free(domain);
+	else
+		trace_graph(ctx, &trace, &graph);
 
 	node = isl_schedule_node_from_domain(domain);
 	node = isl_schedule_node_child(node, 0);
 	if (graph.n > 0)
-		node = compute_schedule(node, &graph);
+		node = compute_schedule_root(node, &graph, sc, reuse);
 	sched = isl_schedule_node_get_schedule(node);
 	isl_schedule_node_free(node);
 
@@ -7628,6 +9160,142 @@ __isl_give isl_schedule *isl_schedule_constraints_compute_schedule(
 	return sched;
 }
 
+/* Compute a schedule on sc->domain that respects the given schedule
+ * constraints using at most "budget" operations, falling back
+ * to Feautrier's algorithm if this budget is exceeded.
+ * "reuse" is passed to compute_schedule_reuse.
+ *
+ * The first attempt is performed in a separate budget scope.
+ * Errors are not reported during this attempt since
+ * an exceeded budget is not considered to be an error.
+ * Other errors are passed on to the caller.
+ * Feautrier's algorithm only computes a single row per carried
+ * dependence and typically requires far fewer operations.
+ * The second attempt is not bounded (by this function),
+ * such that a result is always produced if there are no other errors.
+ */
+static __isl_give isl_schedule *compute_schedule_budget(
+	__isl_take isl_schedule_constraints *sc, struct isl_sched_reuse *reuse,
+	int budget)
+{
+	isl_ctx *ctx = isl_schedule_constraints_get_ctx(sc);
+	isl_schedule *sched;
+	int on_error;
+
+	on_error = isl_options_get_on_error(ctx);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+	if (isl_ctx_push_budget(ctx, "schedule", budget) < 0)
+		sched = NULL;
+	else {
+		sched = compute_schedule_reuse(
+				isl_schedule_constraints_copy(sc), reuse);
+		if (isl_ctx_pop_budget(ctx) < 0)
+			sched = isl_schedule_free(sched);
+	}
+	isl_options_set_on_error(ctx, on_error);
+	if (sched || isl_ctx_last_error(ctx) != isl_error_quota) {
+		isl_schedule_constraints_free(sc);
+		return sched;
+	}
+	isl_ctx_reset_error(ctx);
+
+	isl_options_set_schedule_algorithm(ctx,
+					ISL_SCHEDULE_ALGORITHM_FEAUTRIER);
+	sched = compute_schedule_reuse(sc, reuse);
+	isl_options_set_schedule_algorithm(ctx, ISL_SCHEDULE_ALGORITHM_ISL);
+
+	return sched;
+}
+
+/* Compute a schedule on sc->domain that respects the given schedule
+ * constraints, reusing parts of "reuse" if it is not NULL.
+ *
+ * If the schedule_budget option is set and the isl scheduling
+ * algorithm is used, then bound the number of operations
+ * spent on this algorithm.
+ */
+static __isl_give isl_schedule *compute_schedule_sc(
+	__isl_take isl_schedule_constraints *sc, struct isl_sched_reuse *reuse)
+{
+	isl_ctx *ctx = isl_schedule_constraints_get_ctx(sc);
+	int budget;
+
+	budget = isl_options_get_schedule_budget(ctx);
+	if (budget > 0 && isl_options_get_schedule_algorithm(ctx) ==
+						ISL_SCHEDULE_ALGORITHM_ISL)
+		return compute_schedule_budget(sc, reuse, budget);
+	return compute_schedule_reuse(sc, reuse);
+}
+
+/* Compute a schedule on sc->domain that respects the given schedule
+ * constraints.
+ * The computation is performed in an operation scope
+ * such that it can be attributed by external profilers.
+ */
+__isl_give isl_schedule *isl_schedule_constraints_compute_schedule(
+	__isl_take isl_schedule_constraints *sc)
+{
+	isl_ctx *ctx;
+	isl_schedule *sched;
+
+	ctx = isl_schedule_constraints_get_ctx(sc);
+	isl_ctx_scope_enter(ctx, "isl_schedule_constraints_compute_schedule");
+	sched = compute_schedule_sc(sc, NULL);
+	isl_ctx_scope_leave(ctx);
+
+	return sched;
+}
+
+/* Compute a schedule on sc->domain that respects the given schedule
+ * constraints, reusing parts of the schedule "prev" that was previously
+ * computed for the schedule constraints "prev_sc", if possible.
+ *
+ * In particular, the schedule of each weakly connected component
+ * of the dependence graph for which the schedule constraints
+ * are (obviously) the same as in "prev_sc" is taken from "prev".
+ * The schedules of the other components are computed as in
+ * isl_schedule_constraints_compute_schedule, with each component
+ * scheduled separately.
+ * The rows of a band are computed jointly for all nodes in a component,
+ * so changes inside a component require the entire component
+ * to be rescheduled.
+ *
+ * The previous schedule constraints are aligned in the same way
+ * as "sc" such that unchanged components can be detected.
+ * As in isl_schedule_constraints_compute_schedule,
+ * the computation is performed in an operation scope.
+ */
+__isl_give isl_schedule *isl_schedule_constraints_recompute_schedule(
+	__isl_take isl_schedule_constraints *sc,
+	__isl_take isl_schedule_constraints *prev_sc,
+	__isl_take isl_schedule *prev)
+{
+	isl_ctx *ctx;
+	struct isl_sched_reuse reuse;
+	isl_schedule_node *node;
+	isl_schedule *sched;
+
+	ctx = isl_schedule_constraints_get_ctx(sc);
+	prev_sc = isl_schedule_constraints_align_params(prev_sc);
+	node = isl_schedule_get_root(prev);
+	isl_schedule_free(prev);
+	node = isl_schedule_node_child(node, 0);
+	reuse.sc = prev_sc;
+	reuse.tree = isl_schedule_node_get_tree(node);
+	isl_schedule_node_free(node);
+	if (!reuse.sc || !reuse.tree)
+		sc = isl_schedule_constraints_free(sc);
+
+	isl_ctx_scope_enter(ctx, "isl_schedule_constraints_recompute_schedule");
+	sched = compute_schedule_sc(sc, &reuse);
+	isl_ctx_scope_leave(ctx);
+
+	isl_schedule_constraints_free(reuse.sc);
+	isl_schedule_tree_free(reuse.tree);
+
+	return sched;
+}
+
 /* Compute a schedule for the given union of domains that respects
  * all the validity dependences and minimizes
  * the dependence distances over the proximity dependences.
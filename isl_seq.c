@@ -8,9 +8,38 @@
  * Computerwetenschappen, Celestijnenlaan 200A, B-3001 Leuven, Belgium
  */
 
+#include <float.h>
 #include <isl_ctx_private.h>
 #include <isl_seq.h>
 
+/* Row kernels that operate directly on rows of small integers,
+ * without going through the generic element-wise isl_int operations.
+ * Each of them returns 1 if it was able to compute the result and
+ * 0 otherwise, in which case the generic implementation is used.
+ */
+#ifdef USE_SMALL_INT_OPT
+#define isl_seq_combine_small(dst, m1, src1, m2, src2, len)		\
+	isl_sioimath_seq_combine_small((isl_sioimath *) (dst), *(m1),	\
+	    (isl_sioimath *) (src1), *(m2), (isl_sioimath *) (src2), len)
+#define isl_seq_addmul_small(dst, f, src, len)				\
+	isl_sioimath_seq_addmul_small((isl_sioimath *) (dst), *(f),	\
+	    (isl_sioimath *) (src), len)
+#define isl_seq_submul_small(dst, f, src, len)				\
+	isl_sioimath_seq_submul_small((isl_sioimath *) (dst), *(f),	\
+	    (isl_sioimath *) (src), len)
+#define isl_seq_inner_product_small(p1, p2, len, prod)			\
+	isl_sioimath_seq_inner_product_small((isl_sioimath *) (p1),	\
+	    (isl_sioimath *) (p2), len, *(prod))
+#define isl_seq_gcd_small(p, len, gcd)					\
+	isl_sioimath_seq_gcd_small((isl_sioimath *) (p), len, *(gcd))
+#else /* USE_SMALL_INT_OPT */
+#define isl_seq_combine_small(dst, m1, src1, m2, src2, len)	0
+#define isl_seq_addmul_small(dst, f, src, len)			0
+#define isl_seq_submul_small(dst, f, src, len)			0
+#define isl_seq_inner_product_small(p1, p2, len, prod)		0
+#define isl_seq_gcd_small(p, len, gcd)				0
+#endif /* USE_SMALL_INT_OPT */
+
 void isl_seq_clr(isl_int *p, unsigned len)
 {
 	int i;
@@ -49,6 +78,9 @@ void isl_seq_cpy(isl_int *dst, isl_int *src, unsigned len)
 void isl_seq_submul(isl_int *dst, isl_int f, isl_int *src, unsigned len)
 {
 	int i;
+
+	if (isl_seq_submul_small(dst, f, src, len))
+		return;
 	for (i = 0; i < len; ++i)
 		isl_int_submul(dst[i], f, src[i]);
 }
@@ -56,6 +88,9 @@ void isl_seq_submul(isl_int *dst, isl_int f, isl_int *src, unsigned len)
 void isl_seq_addmul(isl_int *dst, isl_int f, isl_int *src, unsigned len)
 {
 	int i;
+
+	if (isl_seq_addmul_small(dst, f, src, len))
+		return;
 	for (i = 0; i < len; ++i)
 		isl_int_addmul(dst[i], f, src[i]);
 }
@@ -111,11 +146,16 @@ void isl_seq_combine(isl_int *dst, isl_int m1, isl_int *src1,
 	if (dst == src1 && isl_int_is_one(m1)) {
 		if (isl_int_is_zero(m2))
 			return;
+		if (isl_seq_addmul_small(dst, m2, src2, len))
+			return;
 		for (i = 0; i < len; ++i)
 			isl_int_addmul(src1[i], m2, src2[i]);
 		return;
 	}
 
+	if (isl_seq_combine_small(dst, m1, src1, m2, src2, len))
+		return;
+
 	isl_int_init(tmp);
 	for (i = 0; i < len; ++i) {
 		isl_int_mul(tmp, m1, src1[i]);
@@ -159,6 +199,78 @@ void isl_seq_elim(isl_int *dst, isl_int *src, unsigned pos, unsigned len,
 	isl_int_clear(b);
 }
 
+/* Store the positions of the non-zero elements of "p" of length "len"
+ * in increasing order in "pos", which needs to have room
+ * for "len" elements, and return the number of non-zero elements.
+ * The result can be passed to the *_sparse variants of
+ * the functions below as the sparsity pattern of "p".
+ */
+int isl_seq_non_zero_pos(isl_int *p, unsigned len, int *pos)
+{
+	int i, n = 0;
+
+	for (i = 0; i < len; ++i)
+		if (!isl_int_is_zero(p[i]))
+			pos[n++] = i;
+	return n;
+}
+
+/* Replace "dst" of length "len" by m1 * dst + m2 * src,
+ * where the "n_nz" positions in "nz" are those of
+ * the non-zero elements of "src".
+ *
+ * The elements of "src" are only accessed in the positions in "nz".
+ * The elements of "dst" only need to be considered in other positions
+ * if they are not zero and "m1" is not one.
+ */
+void isl_seq_combine_sparse(isl_int *dst, isl_int m1, isl_int m2,
+	isl_int *src, const int *nz, int n_nz, unsigned len)
+{
+	int i;
+
+	if (!isl_int_is_one(m1))
+		for (i = 0; i < len; ++i)
+			if (!isl_int_is_zero(dst[i]))
+				isl_int_mul(dst[i], dst[i], m1);
+	if (isl_int_is_zero(m2))
+		return;
+	for (i = 0; i < n_nz; ++i)
+		isl_int_addmul(dst[nz[i]], m2, src[nz[i]]);
+}
+
+/* Variant of isl_seq_elim where the "n_nz" positions in "nz"
+ * are those of the non-zero elements of "src".
+ * This is useful when the same "src" is used to eliminate
+ * an element from several sequences and when "src" only
+ * has a few non-zero elements.
+ */
+void isl_seq_elim_sparse(isl_int *dst, isl_int *src, unsigned pos,
+	unsigned len, const int *nz, int n_nz, isl_int *m)
+{
+	isl_int a;
+	isl_int b;
+
+	if (isl_int_is_zero(dst[pos]))
+		return;
+
+	isl_int_init(a);
+	isl_int_init(b);
+
+	isl_int_gcd(a, src[pos], dst[pos]);
+	isl_int_divexact(b, dst[pos], a);
+	if (isl_int_is_pos(src[pos]))
+		isl_int_neg(b, b);
+	isl_int_divexact(a, src[pos], a);
+	isl_int_abs(a, a);
+	isl_seq_combine_sparse(dst, a, b, src, nz, n_nz, len);
+
+	if (m)
+		isl_int_mul(*m, *m, a);
+
+	isl_int_clear(a);
+	isl_int_clear(b);
+}
+
 int isl_seq_eq(isl_int *p1, isl_int *p2, unsigned len)
 {
 	int i;
@@ -240,8 +352,12 @@ int isl_seq_abs_min_non_zero(isl_int *p, unsigned len)
 
 void isl_seq_gcd(isl_int *p, unsigned len, isl_int *gcd)
 {
-	int i, min = isl_seq_abs_min_non_zero(p, len);
+	int i, min;
+
+	if (isl_seq_gcd_small(p, len, gcd))
+		return;
 
+	min = isl_seq_abs_min_non_zero(p, len);
 	if (min < 0) {
 		isl_int_set_si(*gcd, 0);
 		return;
@@ -287,17 +403,119 @@ void isl_seq_inner_product(isl_int *p1, isl_int *p2, unsigned len,
 		isl_int_set_si(*prod, 0);
 		return;
 	}
+	if (isl_seq_inner_product_small(p1, p2, len, prod))
+		return;
 	isl_int_mul(*prod, p1[0], p2[0]);
 	for (i = 1; i < len; ++i)
 		isl_int_addmul(*prod, p1[i], p2[i]);
 }
 
+#ifdef USE_GMP_FOR_MP
+/* Return the sign of the inner product of "p1" and "p2" of length "len"
+ * if it can be determined from a floating point approximation and
+ * 2 otherwise.
+ *
+ * isl_int_get_d truncates its argument, introducing a relative error
+ * of less than DBL_EPSILON, while each product and sum introduces
+ * a further relative error of at most DBL_EPSILON / 2.
+ * The error on the approximate inner product is therefore bounded by
+ * (len + 3) * DBL_EPSILON times the sum of the absolute values
+ * of the products.  Twice this bound is used to also account
+ * for the rounding errors in computing the bound itself.
+ * If any of the values is too large to be represented,
+ * then the bound is infinite or NaN and the sign is not determined.
+ * If there are no non-zero products, then the inner product is zero.
+ */
+static int inner_product_sgn_d(isl_int *p1, isl_int *p2, unsigned len)
+{
+	int i;
+	double sum = 0, bound = 0;
+
+	for (i = 0; i < len; ++i) {
+		double prod;
+
+		if (isl_int_is_zero(p1[i]) || isl_int_is_zero(p2[i]))
+			continue;
+		prod = isl_int_get_d(p1[i]) * isl_int_get_d(p2[i]);
+		sum += prod;
+		bound += prod < 0 ? -prod : prod;
+	}
+	if (bound == 0)
+		return 0;
+	bound *= 2 * (len + 3) * DBL_EPSILON;
+	if (!(bound <= DBL_MAX))
+		return 2;
+	if (sum > bound)
+		return 1;
+	if (sum < -bound)
+		return -1;
+	return 2;
+}
+
+#define isl_seq_inner_product_sgn_d(p1, p2, len)				inner_product_sgn_d(p1, p2, len)
+#else /* USE_GMP_FOR_MP */
+#define isl_seq_inner_product_sgn_d(p1, p2, len)	2
+#endif /* USE_GMP_FOR_MP */
+
+/* Return the sign of the inner product of "p1" and "p2" of length "len",
+ * using "tmp" as temporary storage.
+ * If the sign can be determined from a floating point approximation,
+ * then the exact inner product is not computed.
+ * This is only done if isl_int_get_d is known to be accurate.
+ * When small integers are stored inline, the exact inner product
+ * of rows of small integers is cheap to compute anyway.
+ */
+int isl_seq_inner_product_sgn(isl_int *p1, isl_int *p2, unsigned len,
+	isl_int *tmp)
+{
+	int sgn;
+
+	sgn = isl_seq_inner_product_sgn_d(p1, p2, len);
+	if (sgn != 2)
+		return sgn;
+	isl_seq_inner_product(p1, p2, len, tmp);
+	return isl_int_sgn(*tmp);
+}
+
+/* Update "hash" with the element "v" at position "pos"
+ * of a sequence, where "v" fits in a long.
+ *
+ * The position is combined with "hash" in the upper half of a 64-bit word
+ * and the value is added to the word as a whole, after which
+ * the bits are mixed using two multiply-xorshift rounds.
+ * This is much cheaper than hashing the bytes of "v" one by one.
+ */
+static uint32_t hash_small(uint32_t hash, int pos, long v)
+{
+	uint64_t x;
+
+	x = ((uint64_t) (hash ^ pos) << 32 | (hash ^ pos)) + (uint64_t) v;
+	x ^= x >> 31;
+	x *= UINT64_C(0x9E3779B97F4A7C15);
+	x ^= x >> 29;
+	x *= UINT64_C(0xBF58476D1CE4E5B9);
+	x ^= x >> 32;
+	return (uint32_t) x;
+}
+
+/* Update "hash" with the non-zero elements of "p" of length "len".
+ *
+ * Elements that fit in a long, which is by far the most common case,
+ * are hashed word-wise by hash_small.  Larger elements
+ * are hashed byte-wise through isl_int_hash.
+ * Since the choice depends on the value and not on
+ * its representation, equal sequences have the same hash value.
+ */
 uint32_t isl_seq_hash(isl_int *p, unsigned len, uint32_t hash)
 {
 	int i;
 	for (i = 0; i < len; ++i) {
 		if (isl_int_is_zero(p[i]))
 			continue;
+		if (isl_int_fits_slong(p[i])) {
+			hash = hash_small(hash, i, isl_int_get_si(p[i]));
+			continue;
+		}
 		hash *= 16777619;
 		hash ^= (i & 0xFF);
 		hash = isl_int_hash(p[i], hash);
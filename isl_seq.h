@@ -37,12 +37,19 @@ void isl_seq_combine(isl_int *dst, isl_int m1, isl_int *src1,
 			isl_int m2, isl_int *src2, unsigned len);
 void isl_seq_elim(isl_int *dst, isl_int *src, unsigned pos, unsigned len,
 		  isl_int *m);
+int isl_seq_non_zero_pos(isl_int *p, unsigned len, int *pos);
+void isl_seq_combine_sparse(isl_int *dst, isl_int m1, isl_int m2,
+	isl_int *src, const int *nz, int n_nz, unsigned len);
+void isl_seq_elim_sparse(isl_int *dst, isl_int *src, unsigned pos,
+	unsigned len, const int *nz, int n_nz, isl_int *m);
 void isl_seq_abs_max(isl_int *p, unsigned len, isl_int *max);
 void isl_seq_gcd(isl_int *p, unsigned len, isl_int *gcd);
 void isl_seq_lcm(isl_int *p, unsigned len, isl_int *lcm);
 void isl_seq_normalize(struct isl_ctx *ctx, isl_int *p, unsigned len);
 void isl_seq_inner_product(isl_int *p1, isl_int *p2, unsigned len,
 			   isl_int *prod);
+int isl_seq_inner_product_sgn(isl_int *p1, isl_int *p2, unsigned len,
+	isl_int *tmp);
 int isl_seq_first_non_zero(isl_int *p, unsigned len);
 int isl_seq_last_non_zero(isl_int *p, unsigned len);
 int isl_seq_abs_min_non_zero(isl_int *p, unsigned len);
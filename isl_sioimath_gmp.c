@@ -0,0 +1,144 @@
+#include <stdlib.h>
+
+#include <isl_int.h>
+
+/* Allocate and initialize a GMP value for use
+ * as the big representation of an isl_sioimath.
+ */
+mp_int isl_sioimath_gmp_alloc(void)
+{
+	mp_int z;
+
+	z = malloc(sizeof(*z));
+	if (z)
+		mpz_init(z);
+	return z;
+}
+
+/* Free a GMP value allocated by isl_sioimath_gmp_alloc.
+ */
+void isl_sioimath_gmp_free(mp_int z)
+{
+	if (!z)
+		return;
+	mpz_clear(z);
+	free(z);
+}
+
+/* Store the value of "z" in "out" if it fits in a long.
+ * Return MP_OK if it does and MP_RANGE otherwise.
+ */
+mp_result isl_sioimath_gmp_to_int(mp_int z, mp_small *out)
+{
+	if (!mpz_fits_slong_p(z))
+		return MP_RANGE;
+	if (out)
+		*out = mpz_get_si(z);
+	return MP_OK;
+}
+
+/* Store the value of "z" in "out" if it fits in an unsigned long.
+ * Return MP_OK if it does and MP_RANGE otherwise.
+ */
+mp_result isl_sioimath_gmp_to_uint(mp_int z, mp_usmall *out)
+{
+	if (!mpz_fits_ulong_p(z))
+		return MP_RANGE;
+	if (out)
+		*out = mpz_get_ui(z);
+	return MP_OK;
+}
+
+/* Compute the quotient "q" and/or remainder "r" of "a" divided by "b",
+ * rounding towards zero.  Either of "q" or "r" may be NULL.
+ */
+void isl_sioimath_gmp_div(mp_int a, mp_int b, mp_int q, mp_int r)
+{
+	if (q && r)
+		mpz_tdiv_qr(q, r, a, b);
+	else if (q)
+		mpz_tdiv_q(q, a, b);
+	else if (r)
+		mpz_tdiv_r(r, a, b);
+}
+
+/* Compute the quotient "q" and/or remainder "r" of "a" divided by
+ * the non-zero "value", rounding towards zero.
+ * Either of "q" or "r" may be NULL.
+ */
+void isl_sioimath_gmp_div_value(mp_int a, mp_small value, mp_int q,
+	mp_small *r)
+{
+	mpz_t rem;
+	unsigned long abs_value;
+
+	abs_value = value < 0 ? -(unsigned long) value : value;
+	mpz_init(rem);
+	if (q)
+		mpz_tdiv_qr_ui(q, rem, a, abs_value);
+	else
+		mpz_tdiv_r_ui(rem, a, abs_value);
+	if (q && value < 0)
+		mpz_neg(q, q);
+	if (r)
+		*r = mpz_get_si(rem);
+	mpz_clear(rem);
+}
+
+/* Is "a" divisible by the non-zero "v"?
+ */
+int isl_sioimath_gmp_divisible_value(mp_int a, mp_small v)
+{
+	unsigned long abs_v;
+
+	abs_v = v < 0 ? -(unsigned long) v : v;
+	return mpz_divisible_ui_p(a, abs_v);
+}
+
+/* Compute "a" to the power of the non-negative "b" in "c".
+ */
+void isl_sioimath_gmp_expt_value(mp_small a, mp_small b, mp_int c)
+{
+	mpz_set_si(c, a);
+	mpz_pow_ui(c, c, b);
+}
+
+/* Return a representation of "z" in base "radix" in a string
+ * allocated using malloc, such that it can be freed using free.
+ * The string is written to "str" instead if it is not NULL.
+ */
+char *isl_sioimath_gmp_get_str(char *str, int radix, mp_int z)
+{
+	if (!str)
+		str = malloc(mpz_sizeinbase(z, radix) + 2);
+	if (!str)
+		return NULL;
+	return mpz_get_str(str, radix, z);
+}
+
+/* Return a hash code of "v" that is identical to the one
+ * computed by isl_sioimath_hash for the same value in small representation.
+ * In particular, a zero value is hashed as a single zero limb.
+ */
+uint32_t isl_sioimath_gmp_hash(mp_int v, uint32_t hash)
+{
+	mp_limb_t zero = 0;
+	int size = v->_mp_size;
+	int abs_size = size < 0 ? -size : size;
+	const unsigned char *data;
+	const unsigned char *end;
+
+	if (abs_size == 0) {
+		data = (const unsigned char *) &zero;
+		end = data + sizeof(zero);
+	} else {
+		data = (const unsigned char *) v->_mp_d;
+		end = data + abs_size * sizeof(v->_mp_d[0]);
+	}
+
+	if (size < 0)
+		isl_hash_byte(hash, 0xFF);
+	for (; data < end; ++data)
+		isl_hash_byte(hash, *data);
+	return hash;
+}
@@ -0,0 +1,86 @@
+#ifndef ISL_SIOIMATH_GMP_H
+#define ISL_SIOIMATH_GMP_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <gmp.h>
+
+/* The subset of the IMath interface (including its GMP compatibility
+ * layer) that is used by isl_int_sioimath.h, implemented on top of GMP.
+ * This allows the small integer optimization of isl_int_sioimath.h
+ * to be used with GMP values for the big representation.
+ *
+ * The arguments of the IMath functions are passed in the IMath order,
+ * i.e., with the result last, and are reordered for the corresponding
+ * GMP functions.
+ */
+typedef mpz_ptr mp_int;
+typedef mp_limb_t mp_digit;
+typedef int mp_size;
+typedef long mp_small;
+typedef unsigned long mp_usmall;
+typedef int mp_result;
+
+#define MP_OK		0
+#define MP_RANGE	-3
+
+#define MP_DIGIT_MAX	GMP_NUMB_MAX
+#define MP_SMALL_MIN	LONG_MIN
+#define MP_SMALL_MAX	LONG_MAX
+
+mp_int isl_sioimath_gmp_alloc(void);
+void isl_sioimath_gmp_free(mp_int z);
+mp_result isl_sioimath_gmp_to_int(mp_int z, mp_small *out);
+mp_result isl_sioimath_gmp_to_uint(mp_int z, mp_usmall *out);
+void isl_sioimath_gmp_div(mp_int a, mp_int b, mp_int q, mp_int r);
+void isl_sioimath_gmp_div_value(mp_int a, mp_small value, mp_int q,
+	mp_small *r);
+int isl_sioimath_gmp_divisible_value(mp_int a, mp_small v);
+void isl_sioimath_gmp_expt_value(mp_small a, mp_small b, mp_int c);
+char *isl_sioimath_gmp_get_str(char *str, int radix, mp_int z);
+uint32_t isl_sioimath_gmp_hash(mp_int v, uint32_t hash);
+
+#define mp_int_alloc()			isl_sioimath_gmp_alloc()
+#define mp_int_free(z)			isl_sioimath_gmp_free(z)
+#define mp_int_copy(a, c)		mpz_set(c, a)
+#define mp_int_set_value(c, v)		mpz_set_si(c, v)
+#define mp_int_set_uvalue(c, v)		mpz_set_ui(c, v)
+#define mp_int_to_int(z, out)		isl_sioimath_gmp_to_int(z, out)
+#define mp_int_to_uint(z, out)		isl_sioimath_gmp_to_uint(z, out)
+#define mp_int_abs(a, c)		mpz_abs(c, a)
+#define mp_int_neg(a, c)		mpz_neg(c, a)
+#define mp_int_add(a, b, c)		mpz_add(c, a, b)
+#define mp_int_sub(a, b, c)		mpz_sub(c, a, b)
+#define mp_int_mul(a, b, c)		mpz_mul(c, a, b)
+#define mp_int_mul_pow2(a, p2, c)	mpz_mul_2exp(c, a, p2)
+#define mp_int_div(a, b, q, r)		isl_sioimath_gmp_div(a, b, q, r)
+#define mp_int_div_value(a, v, q, r)	isl_sioimath_gmp_div_value(a, v, q, r)
+#define mp_int_divisible_value(a, v)	isl_sioimath_gmp_divisible_value(a, v)
+#define mp_int_expt_value(a, b, c)	isl_sioimath_gmp_expt_value(a, b, c)
+#define mp_int_expt_full(a, b, c)	mpz_pow_ui(c, a, mpz_get_ui(b))
+#define mp_int_compare(a, b)		mpz_cmp(a, b)
+#define mp_int_compare_unsigned(a, b)	mpz_cmpabs(a, b)
+#define mp_int_compare_value(z, v)	mpz_cmp_si(z, v)
+#define mp_int_compare_zero(z)		mpz_sgn(z)
+#define mp_int_read_string(z, radix, str)	mpz_set_str(z, str, radix)
+#define mp_int_string_len(z, radix)	(mpz_sizeinbase(z, radix) + 2)
+#define mp_int_to_string(z, radix, str, limit)	mpz_get_str(str, radix, z)
+
+#define impz_add_ui(rop, op1, op2)	mpz_add_ui(rop, op1, op2)
+#define impz_sub_ui(rop, op1, op2)	mpz_sub_ui(rop, op1, op2)
+#define impz_cdiv_q(q, n, d)		mpz_cdiv_q(q, n, d)
+#define impz_fdiv_q(q, n, d)		mpz_fdiv_q(q, n, d)
+#define impz_fdiv_r(r, n, d)		mpz_fdiv_r(r, n, d)
+#define impz_gcd(rop, op1, op2)		mpz_gcd(rop, op1, op2)
+#define impz_lcm(rop, op1, op2)		mpz_lcm(rop, op1, op2)
+#define impz_neg(rop, op)		mpz_neg(rop, op)
+#define impz_set(rop, op)		mpz_set(rop, op)
+#define impz_sizeinbase(op, base)	mpz_sizeinbase(op, base)
+#define impz_get_str(str, radix, op)	isl_sioimath_gmp_get_str(str, radix, op)
+#define impz_import			mpz_import
+#define impz_export			mpz_export
+
+#define isl_imath_hash(v, hash)		isl_sioimath_gmp_hash(v, hash)
+
+#endif
@@ -16,6 +16,8 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <isl_ctx_private.h>
+#include <isl_options_private.h>
 #include <isl_space_private.h>
 #include <isl_id_private.h>
 #include <isl_reordering.h>
@@ -50,6 +52,8 @@ __isl_give isl_space *isl_space_alloc(isl_ctx *ctx,
 	space->n_id = 0;
 	space->ids = NULL;
 
+	space->interned = 0;
+
 	return space;
 }
 
@@ -226,17 +230,21 @@ static isl_size global_pos(__isl_keep isl_space *space,
 	return isl_size_error;
 }
 
-/* Extend length of ids array to the total number of dimensions.
+/* Extend length of ids array to (at least) "dim".
+ *
+ * The ids array only needs to cover the dimensions up to
+ * the last one that has an identifier, so anonymous dimensions
+ * at the end (or all dimensions of a completely anonymous space)
+ * do not take up any room.
  */
-static __isl_give isl_space *extend_ids(__isl_take isl_space *space)
+static __isl_give isl_space *extend_ids(__isl_take isl_space *space,
+	unsigned dim)
 {
 	isl_id **ids;
 	int i;
-	isl_size dim;
 
-	dim = isl_space_dim(space, isl_dim_all);
-	if (dim < 0)
-		return isl_space_free(space);
+	if (!space)
+		return NULL;
 	if (dim <= space->n_id)
 		return space;
 
@@ -261,6 +269,25 @@ error:
 	return NULL;
 }
 
+/* Drop the anonymous dimensions at the end of the ids array of "space",
+ * freeing the array if all dimensions are anonymous.
+ * "space" is assumed not to be shared.
+ */
+static void trim_ids(__isl_keep isl_space *space)
+{
+	while (space->n_id > 0 && !space->ids[space->n_id - 1])
+		space->n_id--;
+	if (space->n_id == 0) {
+		free(space->ids);
+		space->ids = NULL;
+	}
+}
+
+/* Set the identifier of the dimension at position "pos" of type "type"
+ * of "space" to "id".
+ * If the ids array needs to be extended, then it is extended
+ * to cover all dimensions of type "type" at once.
+ */
 static __isl_give isl_space *set_id(__isl_take isl_space *space,
 	enum isl_dim_type type, unsigned pos, __isl_take isl_id *id)
 {
@@ -275,7 +302,8 @@ static __isl_give isl_space *set_id(__isl_take isl_space *space,
 	if (gpos >= space->n_id) {
 		if (!id)
 			return space;
-		space = extend_ids(space);
+		space = extend_ids(space,
+				gpos - pos + isl_space_dim(space, type));
 		if (!space)
 			goto error;
 	}
@@ -422,15 +450,72 @@ error:
 	return NULL;
 }
 
+/* Return a copy of "space" in "ctx".
+ * All identifiers are copied to "ctx" as well.
+ * Unless "space" already belongs to "ctx", "space" itself
+ * is not modified, not even its reference count, such that
+ * this function can be applied to the same space in several threads.
+ */
+__isl_give isl_space *isl_space_copy_to_ctx(__isl_keep isl_space *space,
+	isl_ctx *ctx)
+{
+	int i;
+	isl_space *dup;
+
+	if (!space)
+		return NULL;
+	if (space->ctx == ctx)
+		return isl_space_copy(space);
+
+	dup = isl_space_alloc(ctx, space->nparam, space->n_in, space->n_out);
+	if (!dup)
+		return NULL;
+	for (i = 0; i < 2; ++i) {
+		if (space->tuple_id[i] &&
+		    !(dup->tuple_id[i] =
+			    isl_id_copy_to_ctx(space->tuple_id[i], ctx)))
+			goto error;
+		if (space->nested[i] &&
+		    !(dup->nested[i] =
+			    isl_space_copy_to_ctx(space->nested[i], ctx)))
+			goto error;
+	}
+	if (space->n_id == 0)
+		return dup;
+	dup->ids = isl_calloc_array(ctx, isl_id *, space->n_id);
+	if (!dup->ids)
+		goto error;
+	dup->n_id = space->n_id;
+	for (i = 0; i < space->n_id; ++i) {
+		if (!space->ids[i])
+			continue;
+		dup->ids[i] = isl_id_copy_to_ctx(space->ids[i], ctx);
+		if (!dup->ids[i])
+			goto error;
+	}
+	return dup;
+error:
+	isl_space_free(dup);
+	return NULL;
+}
+
+/* Return a version of "space" that can be modified in place.
+ *
+ * An interned space may be shared by other users that
+ * only obtained it through the space_table, so it is always duplicated.
+ */
 __isl_give isl_space *isl_space_cow(__isl_take isl_space *space)
 {
+	isl_space *dup;
+
 	if (!space)
 		return NULL;
 
-	if (space->ref == 1)
+	if (space->ref == 1 && !space->interned)
 		return space;
-	space->ref--;
-	return isl_space_dup(space);
+	dup = isl_space_dup(space);
+	isl_space_free(space);
+	return dup;
 }
 
 __isl_give isl_space *isl_space_copy(__isl_keep isl_space *space)
@@ -442,6 +527,31 @@ __isl_give isl_space *isl_space_copy(__isl_keep isl_space *space)
 	return space;
 }
 
+/* isl_hash_table_find callback for looking up "val" itself
+ * in the space_table.
+ */
+static isl_bool is_same_space(const void *entry, const void *val)
+{
+	return isl_bool_ok(entry == val);
+}
+
+/* Remove "space", which is about to be freed, from the space_table.
+ */
+static void isl_space_unintern(__isl_keep isl_space *space)
+{
+	isl_ctx *ctx = space->ctx;
+	struct isl_hash_table_entry *entry;
+
+	entry = isl_hash_table_find(ctx, &ctx->space_table, space->hash,
+					&is_same_space, space, 0);
+	if (!entry)
+		return;
+	if (entry == isl_hash_table_entry_none)
+		isl_die(ctx, isl_error_internal,
+			"unable to find interned space", return);
+	isl_hash_table_remove(ctx, &ctx->space_table, entry);
+}
+
 __isl_null isl_space *isl_space_free(__isl_take isl_space *space)
 {
 	int i;
@@ -452,6 +562,9 @@ __isl_null isl_space *isl_space_free(__isl_take isl_space *space)
 	if (--space->ref > 0)
 		return NULL;
 
+	if (space->interned)
+		isl_space_unintern(space);
+
 	isl_id_free(space->tuple_id[0]);
 	isl_id_free(space->tuple_id[1]);
 
@@ -468,6 +581,64 @@ __isl_null isl_space *isl_space_free(__isl_take isl_space *space)
 	return NULL;
 }
 
+/* Set the canonical parameters of "ctx" to the parameters of "space".
+ * If "space" is NULL, then any previously set canonical parameters
+ * are removed.
+ *
+ * The objects read by the parser are aligned to these parameters,
+ * such that they all have these parameters in the same order,
+ * followed by any other parameters they may involve.
+ * Binary operations on such objects then do not need
+ * to perform any parameter alignment.
+ *
+ * The canonical parameters are dropped when "ctx" is freed,
+ * such that they do not keep "ctx" alive.
+ */
+isl_stat isl_ctx_set_canonical_params(isl_ctx *ctx,
+	__isl_take isl_space *space)
+{
+	if (!ctx)
+		goto error;
+	if (space && space->ctx != ctx)
+		isl_die(ctx, isl_error_invalid,
+			"space does not belong to context", goto error);
+	if (space && isl_space_check_named_params(space) < 0)
+		goto error;
+	space = isl_space_params(space);
+	isl_ctx_clear_canonical_params(ctx);
+	ctx->canonical_params = space;
+	return isl_stat_ok;
+error:
+	isl_space_free(space);
+	return isl_stat_error;
+}
+
+/* Return the canonical parameters of "ctx", as set by
+ * isl_ctx_set_canonical_params, or a space without parameters
+ * if no canonical parameters have been set.
+ */
+__isl_give isl_space *isl_ctx_get_canonical_params(isl_ctx *ctx)
+{
+	if (!ctx)
+		return NULL;
+	if (!ctx->canonical_params)
+		return isl_space_params_alloc(ctx, 0);
+	return isl_space_copy(ctx->canonical_params);
+}
+
+/* Drop the canonical parameters of "ctx", if any.
+ */
+void isl_ctx_clear_canonical_params(isl_ctx *ctx)
+{
+	isl_space *space;
+
+	if (!ctx)
+		return;
+	space = ctx->canonical_params;
+	ctx->canonical_params = NULL;
+	isl_space_free(space);
+}
+
 /* Check if "s" is a valid dimension or tuple name.
  * We currently only forbid names that look like a number.
  *
@@ -509,7 +680,7 @@ static __isl_give isl_space *isl_space_take_nested(__isl_keep isl_space *space,
 
 	if (!space)
 		return NULL;
-	if (space->ref != 1)
+	if (space->ref != 1 || space->interned)
 		return isl_space_get_nested(space, pos);
 	nested = space->nested[pos];
 	space->nested[pos] = NULL;
@@ -1000,6 +1171,9 @@ isl_bool isl_space_has_equal_tuples(__isl_keep isl_space *space1,
 		return isl_bool_error;
 	if (space1 == space2)
 		return isl_bool_true;
+	if (space1->interned && space2->interned &&
+	    space1->tuple_hash != space2->tuple_hash)
+		return isl_bool_false;
 	return isl_space_tuple_is_equal(space1, isl_dim_in,
 					space2, isl_dim_in) &&
 	       isl_space_tuple_is_equal(space1, isl_dim_out,
@@ -1208,6 +1382,7 @@ static __isl_give isl_space *space_extend(__isl_take isl_space *space,
 		free(space->ids);
 		space->ids = ids;
 		space->n_id = nparam + n_in + n_out;
+		trim_ids(space);
 	}
 	space->nparam = nparam;
 	space->n_in = n_in;
@@ -1360,6 +1535,7 @@ __isl_give isl_space *isl_space_insert_dims(__isl_take isl_space *space,
 		free(space->ids);
 		space->ids = ids;
 		space->n_id = space->nparam + space->n_in + space->n_out + n;
+		trim_ids(space);
 	}
 	switch (type) {
 	case isl_dim_param:	space->nparam += n; break;
@@ -1447,6 +1623,7 @@ __isl_give isl_space *isl_space_move_dims(__isl_take isl_space *space,
 		free(space->ids);
 		space->ids = ids;
 		space->n_id = space->nparam + space->n_in + space->n_out;
+		trim_ids(space);
 	}
 
 	switch (dst_type) {
@@ -2065,7 +2242,8 @@ __isl_give isl_space *isl_space_drop_dims(__isl_take isl_space *space,
 	if (!space)
 		goto error;
 	if (space->ids) {
-		space = extend_ids(space);
+		space = extend_ids(space,
+				space->nparam + space->n_in + space->n_out);
 		if (!space)
 			goto error;
 		for (i = 0; i < num; ++i)
@@ -2083,6 +2261,7 @@ __isl_give isl_space *isl_space_drop_dims(__isl_take isl_space *space,
 			;
 		}
 		space->n_id -= num;
+		trim_ids(space);
 	}
 	switch (type) {
 	case isl_dim_param:	space->nparam -= num; break;
@@ -2517,6 +2696,9 @@ isl_bool isl_space_is_equal(__isl_keep isl_space *space1,
 		return isl_bool_error;
 	if (space1 == space2)
 		return isl_bool_true;
+	if (space1->interned && space2->interned &&
+	    space1->full_hash != space2->full_hash)
+		return isl_bool_false;
 	equal = isl_space_has_equal_params(space1, space2);
 	if (equal < 0 || !equal)
 		return equal;
@@ -2672,7 +2854,8 @@ static uint32_t isl_hash_params(uint32_t hash, __isl_keep isl_space *space)
 }
 
 /* Update "hash" by hashing in the tuples of "space".
- * Changes in this function should be reflected in isl_hash_tuples_domain.
+ * Changes in this function should be reflected in isl_hash_tuples_domain
+ * and isl_hash_tuples_range.
  */
 static uint32_t isl_hash_tuples(uint32_t hash, __isl_keep isl_space *space)
 {
@@ -2719,10 +2902,36 @@ static uint32_t isl_hash_tuples_domain(uint32_t hash,
 	return hash;
 }
 
+/* Update "hash" by hashing in the range tuple of "space".
+ * The result of this function is equal to the result of applying
+ * isl_hash_tuples to the range of "space" and therefore also
+ * to the result of applying isl_hash_tuples_domain to any space
+ * with a domain tuple equal to this range tuple.
+ */
+static uint32_t isl_hash_tuples_range(uint32_t hash,
+	__isl_keep isl_space *space)
+{
+	isl_id *id;
+
+	if (!space)
+		return hash;
+
+	isl_hash_byte(hash, 0);
+	isl_hash_byte(hash, space->n_out % 256);
+
+	hash = isl_hash_id(hash, &isl_id_none);
+	id = tuple_id(space, isl_dim_out);
+	hash = isl_hash_id(hash, id);
+
+	hash = isl_hash_tuples(hash, space->nested[1]);
+
+	return hash;
+}
+
 /* Return a hash value that digests the tuples of "space",
  * i.e., that ignores the parameters.
  * Changes in this function should be reflected
- * in isl_space_get_tuple_domain_hash.
+ * in isl_space_get_tuple_domain_hash and isl_space_get_tuple_range_hash.
  */
 uint32_t isl_space_get_tuple_hash(__isl_keep isl_space *space)
 {
@@ -2730,6 +2939,8 @@ uint32_t isl_space_get_tuple_hash(__isl_keep isl_space *space)
 
 	if (!space)
 		return 0;
+	if (space->interned)
+		return space->tuple_hash;
 
 	hash = isl_hash_init();
 	hash = isl_hash_tuples(hash, space);
@@ -2745,6 +2956,8 @@ uint32_t isl_space_get_full_hash(__isl_keep isl_space *space)
 
 	if (!space)
 		return 0;
+	if (space->interned)
+		return space->full_hash;
 
 	hash = isl_hash_init();
 	hash = isl_hash_params(hash, space);
@@ -2753,6 +2966,102 @@ uint32_t isl_space_get_full_hash(__isl_keep isl_space *space)
 	return hash;
 }
 
+/* Update "hash" by hashing in the identifiers of the input and
+ * output dimensions of "space" and of its nested spaces.
+ */
+static uint32_t isl_hash_dim_ids(uint32_t hash, __isl_keep isl_space *space)
+{
+	int i;
+
+	if (!space)
+		return hash;
+
+	for (i = space->nparam; i < space->n_id; ++i) {
+		if (!space->ids[i])
+			continue;
+		isl_hash_byte(hash, i % 256);
+		hash = isl_hash_id(hash, space->ids[i]);
+	}
+
+	hash = isl_hash_dim_ids(hash, space->nested[0]);
+	hash = isl_hash_dim_ids(hash, space->nested[1]);
+
+	return hash;
+}
+
+/* Are "space1" and "space2" identical, including the identifiers
+ * of the input and output dimensions, both of the spaces themselves
+ * and of their nested spaces?
+ */
+static isl_bool isl_space_is_identical(__isl_keep isl_space *space1,
+	__isl_keep isl_space *space2)
+{
+	int i;
+	isl_bool equal;
+
+	equal = isl_space_is_equal(space1, space2);
+	if (equal >= 0 && equal)
+		equal = isl_space_has_equal_ids(space1, space2);
+	for (i = 0; equal > 0 && i < 2; ++i)
+		if (space1->nested[i])
+			equal = isl_space_is_identical(space1->nested[i],
+							space2->nested[i]);
+
+	return equal;
+}
+
+/* isl_hash_table_find callback for looking up a space
+ * in the space_table that is identical to "val".
+ */
+static isl_bool has_identical_space(const void *entry, const void *val)
+{
+	isl_space *space1 = (isl_space *) entry;
+	isl_space *space2 = (isl_space *) val;
+
+	return isl_space_is_identical(space1, space2);
+}
+
+/* Return the interned version of "space", i.e., the unique space
+ * stored in the space_table of the isl_ctx that is identical to "space".
+ * If there is no such space yet, then "space" itself is interned.
+ * If the "intern_spaces" option is not set, then "space" is
+ * returned unchanged.
+ *
+ * Identical interned spaces are represented by the same object,
+ * such that they can be compared by simply comparing pointers.
+ * Moreover, the hash values of interned spaces are computed only once.
+ */
+__isl_give isl_space *isl_space_intern(__isl_take isl_space *space)
+{
+	isl_ctx *ctx;
+	uint32_t hash;
+	struct isl_hash_table_entry *entry;
+
+	if (!space || space->interned)
+		return space;
+	ctx = space->ctx;
+	if (!ctx->opt->intern_spaces)
+		return space;
+
+	space->full_hash = isl_space_get_full_hash(space);
+	space->tuple_hash = isl_space_get_tuple_hash(space);
+	hash = isl_hash_dim_ids(space->full_hash, space);
+	entry = isl_hash_table_find(ctx, &ctx->space_table, hash,
+					&has_identical_space, space, 1);
+	if (!entry)
+		return isl_space_free(space);
+	if (entry->data) {
+		isl_space_free(space);
+		return isl_space_copy(entry->data);
+	}
+
+	entry->data = space;
+	space->interned = 1;
+	space->hash = hash;
+
+	return space;
+}
+
 /* Return the hash value of the domain tuple of "space".
  * That is, isl_space_get_tuple_domain_hash(space) is equal to
  * isl_space_get_tuple_hash(isl_space_domain(space)).
@@ -2770,6 +3079,25 @@ uint32_t isl_space_get_tuple_domain_hash(__isl_keep isl_space *space)
 	return hash;
 }
 
+/* Return the hash value of the range tuple of "space".
+ * That is, isl_space_get_tuple_range_hash(space) is equal to
+ * isl_space_get_tuple_hash(isl_space_range(space)).
+ * In particular, it is equal to isl_space_get_tuple_domain_hash
+ * of any space with a domain tuple equal to the range tuple of "space".
+ */
+uint32_t isl_space_get_tuple_range_hash(__isl_keep isl_space *space)
+{
+	uint32_t hash;
+
+	if (!space)
+		return 0;
+
+	hash = isl_hash_init();
+	hash = isl_hash_tuples_range(hash, space);
+
+	return hash;
+}
+
 /* Is "space" the space of a set wrapping a map space?
  */
 isl_bool isl_space_is_wrapping(__isl_keep isl_space *space)
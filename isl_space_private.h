@@ -6,6 +6,14 @@
 #include <isl/id_type.h>
 
 struct isl_name;
+
+/* If "interned" is set, then the space is stored in the space_table
+ * of "ctx" and is shared by all users of an identical space.
+ * Such a space is never modified in place.
+ * "hash" is the key under which it is stored in the table,
+ * while "full_hash" and "tuple_hash" cache the results of
+ * isl_space_get_full_hash and isl_space_get_tuple_hash.
+ */
 struct isl_space {
 	int ref;
 
@@ -20,15 +28,22 @@ struct isl_space {
 
 	unsigned n_id;
 	isl_id **ids;
+
+	int interned;
+	uint32_t hash;
+	uint32_t full_hash;
+	uint32_t tuple_hash;
 };
 
 __isl_give isl_space *isl_space_cow(__isl_take isl_space *space);
+__isl_give isl_space *isl_space_intern(__isl_take isl_space *space);
 
 __isl_give isl_space *isl_space_underlying(__isl_take isl_space *space,
 	unsigned n_div);
 
 uint32_t isl_space_get_tuple_hash(__isl_keep isl_space *space);
 uint32_t isl_space_get_tuple_domain_hash(__isl_keep isl_space *space);
+uint32_t isl_space_get_tuple_range_hash(__isl_keep isl_space *space);
 uint32_t isl_space_get_full_hash(__isl_keep isl_space *space);
 
 isl_bool isl_space_has_domain_tuples(__isl_keep isl_space *space1,
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+#
+# Summarize the statistics written by isl in JSON format
+# (see the --isl-stats-json option and isl_ctx_print_stats_json)
+# and extract the most expensive coalescing inputs recorded
+# through the --isl-stats-top-coalesce option such that
+# they can be replayed using "isl_bench --replay=file".
+#
+# The input contains one JSON object per freed isl_ctx.
+
+import argparse
+import json
+import os
+import sys
+
+def read_stats(file):
+	"""Read all JSON objects in "file"."""
+	decoder = json.JSONDecoder()
+	text = file.read()
+	stats = []
+	pos = 0
+	while True:
+		while pos < len(text) and text[pos].isspace():
+			pos += 1
+		if pos >= len(text):
+			return stats
+		obj, pos = decoder.raw_decode(text, pos)
+		stats.append(obj)
+
+def add_counts(total, counts):
+	"""Add the values in the dictionary "counts" to those in "total"."""
+	for key, value in counts.items():
+		total[key] = total.get(key, 0) + value
+
+def summarize(stats):
+	"""Print the statistics in "stats", accumulated over all contexts."""
+	operations = 0
+	memory = {}
+	counters = {}
+	timers = {}
+	caches = {}
+	budgets = {}
+	for ctx in stats:
+		operations += ctx["operations"]
+		add_counts(memory, ctx["memory"])
+		add_counts(counters, ctx["counters"])
+		add_counts(timers, ctx["timers"])
+		add_counts(budgets, ctx["budgets"])
+		for name, cache in ctx["caches"].items():
+			total = caches.setdefault(name, {})
+			add_counts(total, { "hits": cache["hits"],
+					    "misses": cache["misses"] })
+
+	print("contexts: %d" % len(stats))
+	print("operations: %d" % operations)
+	for key, value in memory.items():
+		print("memory %s: %d" % (key, value))
+	for key, value in counters.items():
+		if value:
+			print("%s: %d" % (key, value))
+	for key, value in timers.items():
+		if value:
+			print("%s: %.3fs" % (key, value))
+	for name, cache in caches.items():
+		total = cache["hits"] + cache["misses"]
+		if total:
+			print("%s cache hit rate: %.1f%% (%d/%d)" %
+			      (name, 100.0 * cache["hits"] / total,
+			       cache["hits"], total))
+	for key, value in budgets.items():
+		print("budget %s operations: %d" % (key, value))
+
+def top_coalesce(stats, n):
+	"""Return the "n" most expensive coalescing inputs in "stats"."""
+	records = []
+	for ctx in stats:
+		records.extend(ctx["top_coalesce"])
+	records.sort(key=lambda r: (r["time"], r["operations"]), reverse=True)
+	return records[:n]
+
+def dump(records, directory, binary):
+	"""Write the inputs of "records" to "directory"."""
+	os.makedirs(directory, exist_ok=True)
+	for i, record in enumerate(records):
+		if binary or record["input"] is None:
+			name = os.path.join(directory, "coalesce-%d.islb" % i)
+			with open(name, "wb") as file:
+				file.write(bytes.fromhex(record["binary"]))
+		else:
+			name = os.path.join(directory, "coalesce-%d.isl" % i)
+			with open(name, "w") as file:
+				file.write(record["input"] + "\n")
+		print("isl_bench --replay=%s" % name)
+
+def main():
+	parser = argparse.ArgumentParser(
+		description="Summarize isl statistics in JSON format")
+	parser.add_argument("file", nargs="?", default="-",
+			    help="file containing the statistics")
+	parser.add_argument("-n", type=int, default=5,
+			    help="number of coalescing inputs to show")
+	parser.add_argument("--dump", metavar="directory",
+			    help="write the coalescing inputs to directory")
+	parser.add_argument("--binary", action="store_true",
+			    help="write the inputs in binary format")
+	args = parser.parse_args()
+
+	if args.file == "-":
+		stats = read_stats(sys.stdin)
+	else:
+		with open(args.file) as file:
+			stats = read_stats(file)
+
+	summarize(stats)
+	records = top_coalesce(stats, args.n)
+	for i, record in enumerate(records):
+		print("coalesce %d: %gs, %d operations: %s" %
+		      (i, record["time"], record["operations"],
+		       record["input"]))
+	if args.dump:
+		dump(records, args.dump, args.binary)
+
+if __name__ == "__main__":
+	main()
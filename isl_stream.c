@@ -139,7 +139,7 @@ void isl_stream_error(__isl_keep isl_stream *s, struct isl_token *tok,
 	isl_ctx_set_full_error(s->ctx, isl_error_invalid, "syntax error",
 				__FILE__, __LINE__);
 
-	if (s->ctx->opt->on_error == ISL_ON_ERROR_CONTINUE)
+	if (s->ctx->quiet || s->ctx->opt->on_error == ISL_ON_ERROR_CONTINUE)
 		return;
 	fprintf(stderr, "syntax error (%d, %d): %s\n", line, col, msg);
 	if (tok) {
@@ -285,68 +285,157 @@ static int isl_stream_getc(__isl_keep isl_stream *s)
 	return '\\';
 }
 
+/* Make sure s->buffer has room for at least "n" more characters.
+ */
+static int isl_stream_reserve(__isl_keep isl_stream *s, size_t n)
+{
+	char *buffer;
+	size_t size;
+
+	if (s->len + n <= s->size)
+		return 0;
+	size = s->size;
+	while (s->len + n > size)
+		size = (3 * size) / 2;
+	buffer = isl_realloc_array(s->ctx, s->buffer, char, size);
+	if (!buffer)
+		return -1;
+	s->buffer = buffer;
+	s->size = size;
+	return 0;
+}
+
 static int isl_stream_push_char(__isl_keep isl_stream *s, int c)
 {
-	if (s->len >= s->size) {
-		char *buffer;
-		s->size = (3*s->size)/2;
-		buffer = isl_realloc_array(s->ctx, s->buffer, char, s->size);
-		if (!buffer)
-			return -1;
-		s->buffer = buffer;
-	}
+	if (isl_stream_reserve(s, 1) < 0)
+		return -1;
 	s->buffer[s->len++] = c;
 	return 0;
 }
 
+/* Is "c" a character that may appear inside an identifier?
+ */
+static int is_ident_char(int c)
+{
+	return isalnum(c) || c == '_';
+}
+
+/* If "s" reads from a string and there are no pushed back characters,
+ * then append the longest sequence of characters at the current position
+ * that are digits (if "ident" is not set) or that may appear
+ * inside an identifier (if "ident" is set) to s->buffer in one go.
+ * The caller is expected to continue reading character by character
+ * afterwards, which takes care of any special cases,
+ * including a pair of '\\' and '\n', which never appears
+ * in such a sequence.
+ */
+static int isl_stream_push_str_span(__isl_keep isl_stream *s, int ident)
+{
+	const char *end;
+	size_t n;
+
+	if (s->file || s->n_un || s->eof)
+		return 0;
+	end = s->str;
+	if (ident)
+		while (is_ident_char((unsigned char) *end))
+			++end;
+	else
+		while (isdigit((unsigned char) *end))
+			++end;
+	n = end - s->str;
+	if (n == 0)
+		return 0;
+	if (isl_stream_reserve(s, n) < 0)
+		return -1;
+	memcpy(s->buffer + s->len, s->str, n);
+	s->len += n;
+	s->col += n;
+	s->c = (unsigned char) end[-1];
+	s->str = end;
+	return 0;
+}
+
 void isl_stream_push_token(__isl_keep isl_stream *s, struct isl_token *tok)
 {
 	isl_assert(s->ctx, s->n_token < 5, return);
 	s->tokens[s->n_token++] = tok;
 }
 
-static enum isl_token_type check_keywords(__isl_keep isl_stream *s)
+/* The built-in keywords, stored at the position given
+ * by builtin_keyword_hash applied to their (lower case) names.
+ * The hash function and the size of the table have been chosen
+ * such that no two keywords are mapped to the same position.
+ */
+static const struct {
+	const char *name;
+	enum isl_token_type type;
+} builtin_keywords[32] = {
+	[0] = { "floord", ISL_TOKEN_FLOORD },
+	[1] = { "true", ISL_TOKEN_TRUE },
+	[3] = { "ceil", ISL_TOKEN_CEIL },
+	[4] = { "mod", ISL_TOKEN_MOD },
+	[5] = { "floor", ISL_TOKEN_FLOOR },
+	[8] = { "max", ISL_TOKEN_MAX },
+	[11] = { "or", ISL_TOKEN_OR },
+	[20] = { "false", ISL_TOKEN_FALSE },
+	[21] = { "not", ISL_TOKEN_NOT },
+	[22] = { "min", ISL_TOKEN_MIN },
+	[23] = { "nan", ISL_TOKEN_NAN },
+	[24] = { "and", ISL_TOKEN_AND },
+	[25] = { "rat", ISL_TOKEN_RAT },
+	[26] = { "exists", ISL_TOKEN_EXISTS },
+	[27] = { "infty", ISL_TOKEN_INFTY },
+	[28] = { "ceild", ISL_TOKEN_CEILD },
+	[30] = { "infinity", ISL_TOKEN_INFTY },
+	[31] = { "implies", ISL_TOKEN_IMPLIES },
+};
+
+/* Return the position in builtin_keywords of the keyword
+ * with name "name" of length "len", if it is a keyword at all.
+ * The comparison with keywords is case insensitive.
+ */
+static unsigned builtin_keyword_hash(const char *name, size_t len)
+{
+	unsigned first = tolower((unsigned char) name[0]);
+	unsigned last = tolower((unsigned char) name[len - 1]);
+
+	return (first + 21 * last + len) % 32;
+}
+
+/* Return the type of the built-in keyword "name" of length "len" or
+ * ISL_TOKEN_IDENT if "name" is not a built-in keyword.
+ */
+static enum isl_token_type builtin_keyword(const char *name, size_t len)
+{
+	unsigned h;
+
+	if (len == 0)
+		return ISL_TOKEN_IDENT;
+	h = builtin_keyword_hash(name, len);
+	if (!builtin_keywords[h].name ||
+	    strcasecmp(name, builtin_keywords[h].name))
+		return ISL_TOKEN_IDENT;
+	return builtin_keywords[h].type;
+}
+
+/* Return the type of the identifier in s->buffer, which has length "len",
+ * if it is a keyword, or ISL_TOKEN_IDENT if it is not.
+ * The built-in keywords are looked up in a fixed table,
+ * while the keywords registered through isl_stream_register_keyword
+ * are looked up in s->keywords.
+ */
+static enum isl_token_type check_keywords(__isl_keep isl_stream *s,
+	size_t len)
 {
 	struct isl_hash_table_entry *entry;
 	struct isl_keyword *keyword;
 	uint32_t name_hash;
+	enum isl_token_type type;
 
-	if (!strcasecmp(s->buffer, "exists"))
-		return ISL_TOKEN_EXISTS;
-	if (!strcasecmp(s->buffer, "and"))
-		return ISL_TOKEN_AND;
-	if (!strcasecmp(s->buffer, "or"))
-		return ISL_TOKEN_OR;
-	if (!strcasecmp(s->buffer, "implies"))
-		return ISL_TOKEN_IMPLIES;
-	if (!strcasecmp(s->buffer, "not"))
-		return ISL_TOKEN_NOT;
-	if (!strcasecmp(s->buffer, "infty"))
-		return ISL_TOKEN_INFTY;
-	if (!strcasecmp(s->buffer, "infinity"))
-		return ISL_TOKEN_INFTY;
-	if (!strcasecmp(s->buffer, "NaN"))
-		return ISL_TOKEN_NAN;
-	if (!strcasecmp(s->buffer, "min"))
-		return ISL_TOKEN_MIN;
-	if (!strcasecmp(s->buffer, "max"))
-		return ISL_TOKEN_MAX;
-	if (!strcasecmp(s->buffer, "rat"))
-		return ISL_TOKEN_RAT;
-	if (!strcasecmp(s->buffer, "true"))
-		return ISL_TOKEN_TRUE;
-	if (!strcasecmp(s->buffer, "false"))
-		return ISL_TOKEN_FALSE;
-	if (!strcasecmp(s->buffer, "ceild"))
-		return ISL_TOKEN_CEILD;
-	if (!strcasecmp(s->buffer, "floord"))
-		return ISL_TOKEN_FLOORD;
-	if (!strcasecmp(s->buffer, "mod"))
-		return ISL_TOKEN_MOD;
-	if (!strcasecmp(s->buffer, "ceil"))
-		return ISL_TOKEN_CEIL;
-	if (!strcasecmp(s->buffer, "floor"))
-		return ISL_TOKEN_FLOOR;
+	type = builtin_keyword(s->buffer, len);
+	if (type != ISL_TOKEN_IDENT)
+		return type;
 
 	if (!s->keywords)
 		return ISL_TOKEN_IDENT;
@@ -463,6 +552,8 @@ static struct isl_token *next_token(__isl_keep isl_stream *s, int same_line)
 		isl_int_init(tok->u.v);
 		if (isl_stream_push_char(s, c))
 			goto error;
+		if (isl_stream_push_str_span(s, 0) < 0)
+			goto error;
 		while ((c = isl_stream_getc(s)) != -1 && isdigit(c))
 			if (isl_stream_push_char(s, c))
 				goto error;
@@ -486,8 +577,9 @@ static struct isl_token *next_token(__isl_keep isl_stream *s, int same_line)
 		if (!tok)
 			return NULL;
 		isl_stream_push_char(s, c);
-		while ((c = isl_stream_getc(s)) != -1 &&
-				(isalnum(c) || c == '_'))
+		if (isl_stream_push_str_span(s, 1) < 0)
+			goto error;
+		while ((c = isl_stream_getc(s)) != -1 && is_ident_char(c))
 			isl_stream_push_char(s, c);
 		if (c != -1)
 			isl_stream_ungetc(s, c);
@@ -496,7 +588,7 @@ static struct isl_token *next_token(__isl_keep isl_stream *s, int same_line)
 		if (c != -1)
 			isl_stream_ungetc(s, c);
 		isl_stream_push_char(s, '\0');
-		tok->type = check_keywords(s);
+		tok->type = check_keywords(s, s->len - 1);
 		if (tok->type != ISL_TOKEN_IDENT)
 			tok->is_keyword = 1;
 		tok->u.s = strdup(s->buffer);
@@ -795,6 +887,33 @@ isl_ctx *isl_stream_get_ctx(__isl_keep isl_stream *s)
 	return s ? s->ctx : NULL;
 }
 
+/* A YAML anchor called "name" that refers to the string "str".
+ */
+struct isl_yaml_anchor {
+	char	*name;
+	char	*str;
+};
+
+/* Is the name of the isl_yaml_anchor "entry" equal to "val"?
+ */
+static isl_bool same_anchor_name(const void *entry, const void *val)
+{
+	const struct isl_yaml_anchor *anchor = entry;
+
+	return isl_bool_ok(!strcmp(anchor->name, val));
+}
+
+static isl_stat free_yaml_anchor(void **p, void *user)
+{
+	struct isl_yaml_anchor *anchor = *p;
+
+	free(anchor->name);
+	free(anchor->str);
+	free(anchor);
+
+	return isl_stat_ok;
+}
+
 void isl_stream_free(__isl_take isl_stream *s)
 {
 	if (!s)
@@ -809,6 +928,11 @@ void isl_stream_free(__isl_take isl_stream *s)
 		isl_hash_table_foreach(s->ctx, s->keywords, &free_keyword, NULL);
 		isl_hash_table_free(s->ctx, s->keywords);
 	}
+	if (s->yaml_anchor) {
+		isl_hash_table_foreach(s->ctx, s->yaml_anchor,
+					&free_yaml_anchor, NULL);
+		isl_hash_table_free(s->ctx, s->yaml_anchor);
+	}
 	free(s->yaml_state);
 	free(s->yaml_indent);
 	isl_ctx_deref(s->ctx);
@@ -1188,3 +1312,151 @@ int isl_stream_yaml_read_end_sequence(__isl_keep isl_stream *s)
 
 	return pop_state(s);
 }
+
+/* Read the name of a YAML anchor or alias from "s",
+ * i.e., the identifier following the "&" or "*".
+ */
+static char *read_yaml_anchor_name(__isl_keep isl_stream *s)
+{
+	char *name;
+
+	name = isl_stream_read_ident_if_available(s);
+	if (!name)
+		isl_stream_error(s, NULL, "expecting anchor name");
+	return name;
+}
+
+/* Look up the YAML anchor called "name" in "s".
+ * If "reserve" is set, then create an entry for the anchor
+ * if it does not exist yet.
+ */
+static struct isl_hash_table_entry *find_yaml_anchor(
+	__isl_keep isl_stream *s, const char *name, int reserve)
+{
+	uint32_t hash;
+
+	if (!s->yaml_anchor) {
+		if (!reserve)
+			return isl_hash_table_entry_none;
+		s->yaml_anchor = isl_hash_table_alloc(s->ctx, 10);
+		if (!s->yaml_anchor)
+			return NULL;
+	}
+	hash = isl_hash_string(isl_hash_init(), name);
+	return isl_hash_table_find(s->ctx, s->yaml_anchor, hash,
+					&same_anchor_name, name, reserve);
+}
+
+/* Record that the YAML anchor called "name" refers to "str".
+ * As in YAML, a later anchor with the same name replaces
+ * an earlier one.
+ */
+static isl_stat set_yaml_anchor(__isl_keep isl_stream *s, const char *name,
+	const char *str)
+{
+	struct isl_hash_table_entry *entry;
+	struct isl_yaml_anchor *anchor;
+	char *copy;
+
+	entry = find_yaml_anchor(s, name, 1);
+	if (!entry)
+		return isl_stat_error;
+	copy = strdup(str);
+	if (!copy)
+		return isl_stat_error;
+	if (entry->data) {
+		anchor = entry->data;
+		free(anchor->str);
+		anchor->str = copy;
+		return isl_stat_ok;
+	}
+	anchor = isl_calloc_type(s->ctx, struct isl_yaml_anchor);
+	if (anchor)
+		anchor->name = strdup(name);
+	if (!anchor || !anchor->name) {
+		free(anchor);
+		free(copy);
+		isl_hash_table_remove(s->ctx, s->yaml_anchor, entry);
+		return isl_stat_error;
+	}
+	anchor->str = copy;
+	entry->data = anchor;
+
+	return isl_stat_ok;
+}
+
+/* Return a copy of the string that the YAML anchor called "name"
+ * refers to.
+ */
+static char *get_yaml_anchor(__isl_keep isl_stream *s, const char *name)
+{
+	struct isl_hash_table_entry *entry;
+	struct isl_yaml_anchor *anchor;
+
+	entry = find_yaml_anchor(s, name, 0);
+	if (!entry)
+		return NULL;
+	if (entry == isl_hash_table_entry_none) {
+		isl_stream_error(s, NULL, "unknown alias");
+		return NULL;
+	}
+	anchor = entry->data;
+	return strdup(anchor->str);
+}
+
+/* Read a (string) value from "s" and return a copy.
+ *
+ * The value may be preceded by an anchor of the form "&name",
+ * in which case the anchor is recorded as referring to the value.
+ * Alternatively, the value may be an alias of the form "*name",
+ * referring to a value with an anchor of the same name
+ * that was read earlier.
+ */
+__isl_give char *isl_stream_yaml_read_str(__isl_keep isl_stream *s)
+{
+	struct isl_token *tok;
+	char *name;
+	char *str;
+
+	if (!s)
+		return NULL;
+	tok = isl_stream_next_token(s);
+	if (!tok) {
+		isl_stream_error(s, NULL, "unexpected EOF");
+		return NULL;
+	}
+	if (tok->type == '*') {
+		isl_token_free(tok);
+		name = read_yaml_anchor_name(s);
+		if (!name)
+			return NULL;
+		str = get_yaml_anchor(s, name);
+		free(name);
+		return str;
+	}
+	if (tok->type != ISL_TOKEN_AND || strcmp(tok->u.s, "&") != 0) {
+		str = isl_token_get_str(s->ctx, tok);
+		isl_token_free(tok);
+		return str;
+	}
+
+	isl_token_free(tok);
+	name = read_yaml_anchor_name(s);
+	if (!name)
+		return NULL;
+	tok = isl_stream_next_token(s);
+	if (!tok) {
+		free(name);
+		isl_stream_error(s, NULL, "unexpected EOF");
+		return NULL;
+	}
+	str = isl_token_get_str(s->ctx, tok);
+	isl_token_free(tok);
+	if (str && set_yaml_anchor(s, name, str) < 0) {
+		free(str);
+		str = NULL;
+	}
+	free(name);
+
+	return str;
+}
@@ -37,6 +37,10 @@ struct isl_token *isl_token_new(isl_ctx *ctx,
  * yaml_indent keeps track of the indentation at each level, with
  * ISL_YAML_INDENT_FLOW meaning that the element is in flow format
  * (such that the indentation is not relevant).
+ *
+ * yaml_anchor maps the names of the YAML anchors that have been read
+ * by isl_stream_yaml_read_str to the corresponding strings.
+ * It may be NULL if no anchors have been read yet.
  */
 struct isl_stream {
 	struct isl_ctx	*ctx;
@@ -66,4 +70,6 @@ struct isl_stream {
 	int			yaml_size;
 	enum isl_yaml_state	*yaml_state;
 	int			*yaml_indent;
+
+	struct isl_hash_table	*yaml_anchor;
 };
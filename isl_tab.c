@@ -24,6 +24,26 @@
 #include <bset_to_bmap.c>
 #include <bset_from_bmap.c>
 
+/* Row kernels that perform the row updates of a pivot directly
+ * on rows of small integers, in 64-bit arithmetic,
+ * without going through the generic element-wise isl_int operations.
+ * Each of them returns 1 if it was able to compute the result and
+ * 0 if some input is not small or the result may overflow,
+ * in which case the row has not been modified and
+ * the generic implementation is used.
+ */
+#ifdef USE_SMALL_INT_OPT
+#define isl_tab_row_combine_small(dst, m1, m2, src, len)		\
+	isl_sioimath_seq_combine_small((isl_sioimath *) (dst), *(m1),	\
+	    (isl_sioimath *) (dst), *(m2), (isl_sioimath *) (src), len)
+#define isl_tab_row_addmul_small(dst, f, src, len)			\
+	isl_sioimath_seq_addmul_small((isl_sioimath *) (dst), *(f),	\
+	    (isl_sioimath *) (src), len)
+#else /* USE_SMALL_INT_OPT */
+#define isl_tab_row_combine_small(dst, m1, m2, src, len)	0
+#define isl_tab_row_addmul_small(dst, f, src, len)		0
+#endif /* USE_SMALL_INT_OPT */
+
 /*
  * The implementation of tableaus in this file was inspired by Section 8
  * of David Detlefs, Greg Nelson and James B. Saxe, "Simplify: a theorem
@@ -86,6 +106,8 @@ struct isl_tab *isl_tab_alloc(struct isl_ctx *ctx,
 	tab->bottom.type = isl_tab_undo_bottom;
 	tab->bottom.next = NULL;
 	tab->top = &tab->bottom;
+	tab->unused_undo = NULL;
+	tab->undo_block = NULL;
 
 	tab->n_zero = 0;
 	tab->n_unbounded = 0;
@@ -179,7 +201,64 @@ int isl_tab_extend_vars(struct isl_tab *tab, unsigned n_new)
 	return 0;
 }
 
-static void free_undo_record(struct isl_tab_undo *undo)
+/* A block of "size" undo records, the first "n" of which
+ * have been handed out by alloc_undo_record.
+ * "next" is the previously allocated block.
+ */
+struct isl_tab_undo_block {
+	int size;
+	int n;
+	struct isl_tab_undo *undo;
+	struct isl_tab_undo_block *next;
+};
+
+/* Return a fresh undo record for "tab".
+ * Reuse a previously released record if there is one and
+ * otherwise take the next record from the current block,
+ * allocating a new, larger block if the current block is full.
+ * This ensures that the records remain at the same address
+ * while they are on the undo stack.
+ */
+static struct isl_tab_undo *alloc_undo_record(struct isl_tab *tab)
+{
+	struct isl_tab_undo *undo;
+	struct isl_tab_undo_block *block;
+
+	if (tab->unused_undo) {
+		undo = tab->unused_undo;
+		tab->unused_undo = undo->next;
+		return undo;
+	}
+
+	block = tab->undo_block;
+	if (!block || block->n >= block->size) {
+		int size = block ? 2 * block->size : 16;
+
+		if (size > 1024)
+			size = 1024;
+		block = isl_alloc_type(tab->mat->ctx,
+					struct isl_tab_undo_block);
+		if (!block)
+			return NULL;
+		block->undo = isl_alloc_array(tab->mat->ctx,
+					struct isl_tab_undo, size);
+		if (!block->undo) {
+			free(block);
+			return NULL;
+		}
+		block->size = size;
+		block->n = 0;
+		block->next = tab->undo_block;
+		tab->undo_block = block;
+	}
+
+	return &block->undo[block->n++];
+}
+
+/* Release the undo record "undo" of "tab" for later reuse,
+ * freeing any memory it may own.
+ */
+static void free_undo_record(struct isl_tab *tab, struct isl_tab_undo *undo)
 {
 	switch (undo->type) {
 	case isl_tab_undo_saved_basis:
@@ -187,7 +266,24 @@ static void free_undo_record(struct isl_tab_undo *undo)
 		break;
 	default:;
 	}
-	free(undo);
+	undo->next = tab->unused_undo;
+	tab->unused_undo = undo;
+}
+
+/* Free all blocks of undo records of "tab".
+ * The undo stack is assumed to have been cleared already.
+ */
+static void free_undo_blocks(struct isl_tab *tab)
+{
+	struct isl_tab_undo_block *block, *next;
+
+	for (block = tab->undo_block; block; block = next) {
+		next = block->next;
+		free(block->undo);
+		free(block);
+	}
+	tab->undo_block = NULL;
+	tab->unused_undo = NULL;
 }
 
 static void free_undo(struct isl_tab *tab)
@@ -196,7 +292,7 @@ static void free_undo(struct isl_tab *tab)
 
 	for (undo = tab->top; undo && undo != &tab->bottom; undo = next) {
 		next = undo->next;
-		free_undo_record(undo);
+		free_undo_record(tab, undo);
 	}
 	tab->top = undo;
 }
@@ -206,6 +302,7 @@ void isl_tab_free(struct isl_tab *tab)
 	if (!tab)
 		return;
 	free_undo(tab);
+	free_undo_blocks(tab);
 	isl_mat_free(tab->mat);
 	isl_vec_free(tab->dual);
 	isl_basic_map_free(tab->bmap);
@@ -220,7 +317,23 @@ void isl_tab_free(struct isl_tab *tab)
 	free(tab);
 }
 
-struct isl_tab *isl_tab_dup(struct isl_tab *tab)
+/* Return a fresh copy of "mat" in "ctx".
+ */
+static __isl_give isl_mat *mat_dup_to_ctx(__isl_keep isl_mat *mat,
+	isl_ctx *ctx)
+{
+	if (!mat)
+		return NULL;
+	if (isl_mat_get_ctx(mat) == ctx)
+		return isl_mat_dup(mat);
+	return isl_mat_copy_to_ctx(mat, ctx);
+}
+
+/* Return a duplicate of "tab" in "ctx".
+ * If "tab" does not belong to "ctx", then "tab" is only read.
+ * The undo records of "tab" are not copied.
+ */
+static struct isl_tab *tab_dup_to_ctx(struct isl_tab *tab, isl_ctx *ctx)
 {
 	int i;
 	struct isl_tab *dup;
@@ -230,34 +343,34 @@ struct isl_tab *isl_tab_dup(struct isl_tab *tab)
 		return NULL;
 
 	off = 2 + tab->M;
-	dup = isl_calloc_type(tab->mat->ctx, struct isl_tab);
+	dup = isl_calloc_type(ctx, struct isl_tab);
 	if (!dup)
 		return NULL;
-	dup->mat = isl_mat_dup(tab->mat);
+	dup->mat = mat_dup_to_ctx(tab->mat, ctx);
 	if (!dup->mat)
 		goto error;
-	dup->var = isl_alloc_array(tab->mat->ctx, struct isl_tab_var, tab->max_var);
+	dup->var = isl_alloc_array(ctx, struct isl_tab_var, tab->max_var);
 	if (tab->max_var && !dup->var)
 		goto error;
 	for (i = 0; i < tab->n_var; ++i)
 		dup->var[i] = tab->var[i];
-	dup->con = isl_alloc_array(tab->mat->ctx, struct isl_tab_var, tab->max_con);
+	dup->con = isl_alloc_array(ctx, struct isl_tab_var, tab->max_con);
 	if (tab->max_con && !dup->con)
 		goto error;
 	for (i = 0; i < tab->n_con; ++i)
 		dup->con[i] = tab->con[i];
-	dup->col_var = isl_alloc_array(tab->mat->ctx, int, tab->mat->n_col - off);
+	dup->col_var = isl_alloc_array(ctx, int, tab->mat->n_col - off);
 	if ((tab->mat->n_col - off) && !dup->col_var)
 		goto error;
 	for (i = 0; i < tab->n_col; ++i)
 		dup->col_var[i] = tab->col_var[i];
-	dup->row_var = isl_alloc_array(tab->mat->ctx, int, tab->mat->n_row);
+	dup->row_var = isl_alloc_array(ctx, int, tab->mat->n_row);
 	if (tab->mat->n_row && !dup->row_var)
 		goto error;
 	for (i = 0; i < tab->n_row; ++i)
 		dup->row_var[i] = tab->row_var[i];
 	if (tab->row_sign) {
-		dup->row_sign = isl_alloc_array(tab->mat->ctx, enum isl_tab_row_sign,
+		dup->row_sign = isl_alloc_array(ctx, enum isl_tab_row_sign,
 						tab->mat->n_row);
 		if (tab->mat->n_row && !dup->row_sign)
 			goto error;
@@ -265,10 +378,10 @@ struct isl_tab *isl_tab_dup(struct isl_tab *tab)
 			dup->row_sign[i] = tab->row_sign[i];
 	}
 	if (tab->samples) {
-		dup->samples = isl_mat_dup(tab->samples);
+		dup->samples = mat_dup_to_ctx(tab->samples, ctx);
 		if (!dup->samples)
 			goto error;
-		dup->sample_index = isl_alloc_array(tab->mat->ctx, int,
+		dup->sample_index = isl_alloc_array(ctx, int,
 							tab->samples->n_row);
 		if (tab->samples->n_row && !dup->sample_index)
 			goto error;
@@ -296,10 +409,12 @@ struct isl_tab *isl_tab_dup(struct isl_tab *tab)
 	dup->bottom.type = isl_tab_undo_bottom;
 	dup->bottom.next = NULL;
 	dup->top = &dup->bottom;
+	dup->unused_undo = NULL;
+	dup->undo_block = NULL;
 
 	dup->n_zero = tab->n_zero;
 	dup->n_unbounded = tab->n_unbounded;
-	dup->basis = isl_mat_dup(tab->basis);
+	dup->basis = mat_dup_to_ctx(tab->basis, ctx);
 
 	return dup;
 error:
@@ -307,6 +422,22 @@ error:
 	return NULL;
 }
 
+struct isl_tab *isl_tab_dup(struct isl_tab *tab)
+{
+	if (!tab)
+		return NULL;
+	return tab_dup_to_ctx(tab, tab->mat->ctx);
+}
+
+/* Return a copy of "tab" in "ctx".
+ * Unless "tab" already belongs to "ctx", "tab" itself
+ * is not modified.
+ */
+struct isl_tab *isl_tab_copy_to_ctx(struct isl_tab *tab, isl_ctx *ctx)
+{
+	return tab_dup_to_ctx(tab, ctx);
+}
+
 /* Construct the coefficient matrix of the product tableau
  * of two tableaus.
  * mat{1,2} is the coefficient matrix of tableau {1,2}
@@ -549,6 +680,8 @@ struct isl_tab *isl_tab_product(struct isl_tab *tab1, struct isl_tab *tab2)
 	prod->bottom.type = isl_tab_undo_bottom;
 	prod->bottom.next = NULL;
 	prod->top = &prod->bottom;
+	prod->unused_undo = NULL;
+	prod->undo_block = NULL;
 
 	prod->n_zero = 0;
 	prod->n_unbounded = 0;
@@ -806,7 +939,7 @@ static isl_stat push_union(struct isl_tab *tab,
 	if (!tab->need_undo)
 		return isl_stat_ok;
 
-	undo = isl_alloc_type(tab->mat->ctx, struct isl_tab_undo);
+	undo = alloc_undo_record(tab);
 	if (!undo)
 		goto error;
 	undo->type = type;
@@ -1072,6 +1205,96 @@ static void update_row_sign(struct isl_tab *tab, int row, int col, int row_sgn)
 	}
 }
 
+/* Update row "i" of "mat" during a pivot on row "row" and
+ * column "pos" (both counted from the start of the row)
+ * in the special case where the pivot row has a unit denominator
+ * after normalization, i.e., where |n_rc| = 1.
+ * The entries of row "i" then do not need to be scaled and
+ * only the entries corresponding to non-zero entries
+ * in the pivot row need to be updated.
+ * "n" is the number of entries after the denominator.
+ *
+ * Tableaus constructed from sparse constraints, such as those
+ * of the scheduler, typically have few non-zero entries per row,
+ * so skipping the zero entries avoids most of the work of a pivot.
+ *
+ * The entries before and after "pos" are updated separately,
+ * by update_row_unit_range on the entries from position "first"
+ * up to "end", such that the entry at "pos" itself is not touched.
+ * If all entries of such a range (and the multiplier) are small,
+ * then the range is updated in 64-bit arithmetic,
+ * falling back to arbitrary precision arithmetic
+ * only if the result may not fit.
+ */
+static void update_row_unit_range(struct isl_mat *mat, int i, int row,
+	int pos, int first, int end)
+{
+	int j;
+
+	if (first >= end)
+		return;
+	if (isl_tab_row_addmul_small(mat->row[i] + first, mat->row[i][pos],
+				    mat->row[row] + first, end - first))
+		return;
+	for (j = first; j < end; ++j) {
+		if (isl_int_is_zero(mat->row[row][j]))
+			continue;
+		isl_int_addmul(mat->row[i][j],
+			    mat->row[i][pos], mat->row[row][j]);
+	}
+}
+
+static void update_row_unit(struct isl_mat *mat, int i, int row,
+	int pos, int n)
+{
+	update_row_unit_range(mat, i, row, pos, 1, pos);
+	update_row_unit_range(mat, i, row, pos, pos + 1, n + 1);
+}
+
+/* Update row "i" of "mat" during a pivot on row "row" and
+ * column "pos" (both counted from the start of the row)
+ * in the general case where the pivot row has a non-unit denominator
+ * after normalization.
+ * Each entry n_ji of row "i" is replaced by n_ji |n_rc| + n_jc n'_ri,
+ * where n'_ri is the (already negated) entry of the pivot row.
+ * "n" is the number of entries after the denominator.
+ *
+ * The multiplication is skipped for zero entries of row "i" and
+ * the addition is skipped for zero entries of the pivot row.
+ * Tableau rows are typically sparse, so this avoids most of
+ * the arbitrary precision arithmetic that would otherwise be performed
+ * on every entry of the row.
+ * As in update_row_unit, ranges with only small entries
+ * are first updated in 64-bit arithmetic.
+ */
+static void update_row_range(struct isl_mat *mat, int i, int row,
+	int pos, int first, int end)
+{
+	int j;
+
+	if (first >= end)
+		return;
+	if (isl_tab_row_combine_small(mat->row[i] + first, mat->row[row][0],
+			    mat->row[i][pos], mat->row[row] + first,
+			    end - first))
+		return;
+	for (j = first; j < end; ++j) {
+		if (!isl_int_is_zero(mat->row[i][j]))
+			isl_int_mul(mat->row[i][j],
+				    mat->row[i][j], mat->row[row][0]);
+		if (isl_int_is_zero(mat->row[row][j]))
+			continue;
+		isl_int_addmul(mat->row[i][j],
+			    mat->row[i][pos], mat->row[row][j]);
+	}
+}
+
+static void update_row(struct isl_mat *mat, int i, int row, int pos, int n)
+{
+	update_row_range(mat, i, row, pos, 1, pos);
+	update_row_range(mat, i, row, pos, pos + 1, n + 1);
+}
+
 /* Given a row number "row" and a column number "col", pivot the tableau
  * such that the associated variables are interchanged.
  * The given row in the tableau expresses
@@ -1126,6 +1349,7 @@ int isl_tab_pivot(struct isl_tab *tab, int row, int col)
 {
 	int i, j;
 	int sgn;
+	int unit;
 	int t;
 	isl_ctx *ctx;
 	struct isl_mat *mat = tab->mat;
@@ -1133,6 +1357,7 @@ int isl_tab_pivot(struct isl_tab *tab, int row, int col)
 	unsigned off = 2 + tab->M;
 
 	ctx = isl_tab_get_ctx(tab);
+	ctx->stats->tab_pivots++;
 	if (isl_ctx_next_operation(ctx) < 0)
 		return -1;
 
@@ -1149,19 +1374,20 @@ int isl_tab_pivot(struct isl_tab *tab, int row, int col)
 		}
 	if (!isl_int_is_one(mat->row[row][0]))
 		isl_seq_normalize(mat->ctx, mat->row[row], off + tab->n_col);
+	unit = isl_int_is_one(mat->row[row][0]);
 	for (i = 0; i < tab->n_row; ++i) {
 		if (i == row)
 			continue;
 		if (isl_int_is_zero(mat->row[i][off + col]))
 			continue;
-		isl_int_mul(mat->row[i][0], mat->row[i][0], mat->row[row][0]);
-		for (j = 0; j < off - 1 + tab->n_col; ++j) {
-			if (j == off - 1 + col)
-				continue;
-			isl_int_mul(mat->row[i][1 + j],
-				    mat->row[i][1 + j], mat->row[row][0]);
-			isl_int_addmul(mat->row[i][1 + j],
-				    mat->row[i][off + col], mat->row[row][1 + j]);
+		if (unit) {
+			update_row_unit(mat, i, row, off + col,
+					off - 1 + tab->n_col);
+		} else {
+			isl_int_mul(mat->row[i][0], mat->row[i][0],
+				    mat->row[row][0]);
+			update_row(mat, i, row, off + col,
+					off - 1 + tab->n_col);
 		}
 		isl_int_mul(mat->row[i][off + col],
 			    mat->row[i][off + col], mat->row[row][off + col]);
@@ -2949,6 +3175,85 @@ static struct isl_tab_var *select_marked(struct isl_tab *tab)
 	return NULL;
 }
 
+/* Is it obvious from the current state of "tab" that the variable "var"
+ * can attain a value larger than zero (if "sgn" is positive) or
+ * smaller than zero (if "sgn" is negative) or, in case
+ * of an integer tableau, at least one or at most negative one?
+ * The non-negativity of "var" itself, if any, is ignored.
+ *
+ * In particular, check if moving a single column that can be used
+ * to move "var" in the desired direction, without performing any pivots,
+ * results in a value beyond the bound before any other non-negative row
+ * becomes negative.
+ * If "var" is a column variable, then the column is that of "var" itself.
+ * Otherwise, the column is the one that would be selected by find_pivot.
+ * The limit on the change x_c of the column is a_r0 / |a_rc|,
+ * with r the row returned by pivot_row, if any, while the value
+ * of the row variable "var" changes to (a_v0 + sgn |a_vc| x_c)/d_v.
+ * That is, the value reaches sgn * b, with b equal to 0 or 1,
+ * if |a_vc| a_r0 >= (b d_v - sgn a_v0) |a_rc|, where the inequality
+ * needs to be strict for b = 0.
+ * A column variable has value zero and changes by x_c.
+ *
+ * Tableaus with a big parameter are not handled.
+ */
+static int obviously_reaches(struct isl_tab *tab, struct isl_tab_var *var,
+	int sgn)
+{
+	int row, col;
+	int res;
+	isl_int *r, *v;
+	isl_int t, u, a;
+	unsigned off = 2 + tab->M;
+
+	if (tab->M)
+		return 0;
+	if (var->is_row) {
+		find_pivot(tab, var, var, sgn, &row, &col);
+		if (col < 0)
+			return 0;
+		if (row == var->index)
+			return 1;
+	} else {
+		col = var->index;
+		row = pivot_row(tab, NULL, sgn, col);
+		if (row < 0)
+			return 1;
+	}
+
+	r = tab->mat->row[row];
+	isl_int_init(t);
+	isl_int_init(u);
+	isl_int_init(a);
+	if (var->is_row) {
+		v = tab->mat->row[var->index];
+		isl_int_abs(t, v[off + col]);
+		isl_int_mul(t, t, r[1]);
+		if (tab->rational)
+			isl_int_set_si(u, 0);
+		else
+			isl_int_set(u, v[0]);
+		if (sgn > 0)
+			isl_int_sub(u, u, v[1]);
+		else
+			isl_int_add(u, u, v[1]);
+	} else {
+		isl_int_set(t, r[1]);
+		isl_int_set_si(u, tab->rational ? 0 : 1);
+	}
+	isl_int_abs(a, r[off + col]);
+	isl_int_mul(u, u, a);
+	if (tab->rational)
+		res = isl_int_gt(t, u);
+	else
+		res = isl_int_ge(t, u);
+	isl_int_clear(a);
+	isl_int_clear(u);
+	isl_int_clear(t);
+
+	return res;
+}
+
 /* Check for (near) equalities among the constraints.
  * A constraint is an equality if it is non-negative and if
  * its maximal value is either
@@ -2959,6 +3264,13 @@ static struct isl_tab_var *select_marked(struct isl_tab *tab)
  * are not frozen and not obviously not an equality.
  * Then we iterate over all marked variables if they can attain
  * any values larger than zero or at least one.
+ * This is first checked without pivoting (see obviously_reaches),
+ * such that only those variables that are tight at the current
+ * sample value in the direction in which they would be increased
+ * need to be maximized.
+ * This check is skipped for tableaus that track a basic map, since
+ * those are typically used to compute a sample point afterwards,
+ * starting from the sample value reached by the maximizations.
  * If the maximal value is zero, we mark any column variables
  * that appear in the row as being zero and mark the row as being redundant.
  * Otherwise, if the maximal value is strictly less than one (and the
@@ -3000,6 +3312,8 @@ int isl_tab_detect_implicit_equalities(struct isl_tab *tab)
 			break;
 		var->marked = 0;
 		n_marked--;
+		if (!tab->bmap && obviously_reaches(tab, var, 1))
+			continue;
 		sgn = sign_of_max(tab, var);
 		if (sgn < 0)
 			return -1;
@@ -3255,6 +3569,12 @@ static int con_is_redundant(struct isl_tab *tab, struct isl_tab_var *var)
  * are not frozen and not obviously negatively unbounded.
  * Then we iterate over all marked variables if they can attain
  * any values smaller than zero or at most negative one.
+ * This is first checked without pivoting (see obviously_reaches),
+ * except for tableaus that track a basic map (see
+ * isl_tab_detect_implicit_equalities).  In particular,
+ * a constraint is not redundant if it is violated by a point
+ * that satisfies all other constraints and that can be reached
+ * by moving a single column.
  * If not, we mark the row as being redundant (assuming it hasn't
  * been detected as being obviously redundant in the mean time).
  */
@@ -3292,6 +3612,8 @@ int isl_tab_detect_redundant(struct isl_tab *tab)
 			break;
 		var->marked = 0;
 		n_marked--;
+		if (!tab->bmap && obviously_reaches(tab, var, -1))
+			continue;
 		red = con_is_redundant(tab, var);
 		if (red < 0)
 			return -1;
@@ -4029,7 +4351,7 @@ isl_stat isl_tab_rollback(struct isl_tab *tab, struct isl_tab_undo *snap)
 			tab->in_undo = 0;
 			return isl_stat_error;
 		}
-		free_undo_record(undo);
+		free_undo_record(tab, undo);
 	}
 	tab->in_undo = 0;
 	tab->top = undo;
@@ -65,6 +65,8 @@ struct isl_tab_undo {
 	struct isl_tab_undo	*next;
 };
 
+struct isl_tab_undo_block;
+
 /* The tableau maintains equality relations.
  * Each column and each row is associated to a variable or a constraint.
  * The "value" of an inequality constraint is the value of the corresponding
@@ -125,6 +127,11 @@ struct isl_tab_undo {
  *
  * If "preserve" is set, then we want to keep all constraints in the
  * tableau, even if they turn out to be redundant.
+ *
+ * The undo records on the stack starting at "top" are carved out
+ * of the blocks in "undo_block".  Records that have been popped
+ * off the stack are kept in the "unused_undo" list for reuse,
+ * such that pushing a record does not usually require an allocation.
  */
 enum isl_tab_row_sign {
 	isl_tab_row_unknown = 0,
@@ -155,6 +162,8 @@ struct isl_tab {
 
 	struct isl_tab_undo bottom;
 	struct isl_tab_undo *top;
+	struct isl_tab_undo *unused_undo;
+	struct isl_tab_undo_block *undo_block;
 
 	struct isl_vec *dual;
 	struct isl_basic_map *bmap;
@@ -286,6 +295,8 @@ __isl_give isl_tab_lexmin *isl_tab_lexmin_add_eq(__isl_take isl_tab_lexmin *tl,
 	isl_int *eq);
 __isl_give isl_tab_lexmin *isl_tab_lexmin_cut_to_integer(
 	__isl_take isl_tab_lexmin *tl);
+__isl_give isl_tab_lexmin *isl_tab_lexmin_push(__isl_take isl_tab_lexmin *tl);
+__isl_give isl_tab_lexmin *isl_tab_lexmin_pop(__isl_take isl_tab_lexmin *tl);
 __isl_give isl_vec *isl_tab_lexmin_get_solution(__isl_keep isl_tab_lexmin *tl);
 __isl_null isl_tab_lexmin *isl_tab_lexmin_free(__isl_take isl_tab_lexmin *tl);
 
@@ -296,6 +307,7 @@ int isl_tab_mark_redundant(struct isl_tab *tab, int row) WARN_UNUSED;
 int isl_tab_mark_rational(struct isl_tab *tab) WARN_UNUSED;
 isl_stat isl_tab_mark_empty(struct isl_tab *tab) WARN_UNUSED;
 struct isl_tab *isl_tab_dup(struct isl_tab *tab);
+struct isl_tab *isl_tab_copy_to_ctx(struct isl_tab *tab, isl_ctx *ctx);
 struct isl_tab *isl_tab_product(struct isl_tab *tab1, struct isl_tab *tab2);
 int isl_tab_extend_cons(struct isl_tab *tab, unsigned n_new) WARN_UNUSED;
 int isl_tab_allocate_con(struct isl_tab *tab) WARN_UNUSED;
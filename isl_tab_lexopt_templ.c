@@ -137,10 +137,68 @@ error:
 	return NULL;
 }
 
+/* Compute the lexicographic optimum of "bmap" over "dom",
+ * given that the output variables before "pos" do not appear
+ * in any constraint together with the output variables from "pos" onwards,
+ * as determined by independent_output_split.
+ *
+ * The set of solutions for any given value of the parameters and
+ * the input variables is then the product of the sets of solutions
+ * for the two groups of output variables and the lexicographic optimum
+ * is the product of the lexicographic optima of these two sets.
+ * Compute these lexicographic optima separately (possibly splitting
+ * them further) and combine the results.
+ * The result is only defined where both optima are defined,
+ * so the part of "dom" without solutions is the union of the parts
+ * where either of the two groups has no solutions.
+ */
+static __isl_give TYPE *SF(basic_map_partial_lexopt_split,SUFFIX)(
+	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
+	__isl_give isl_set **empty, int max, int pos)
+{
+	isl_size n_out;
+	isl_space *space;
+	isl_basic_map *bmap1, *bmap2;
+	isl_set *empty1 = NULL, *empty2 = NULL;
+	TYPE *opt1, *opt2;
+
+	n_out = isl_basic_map_dim(bmap, isl_dim_out);
+	if (n_out < 0)
+		goto error;
+
+	space = isl_basic_map_get_space(bmap);
+	bmap1 = isl_basic_map_copy(bmap);
+	bmap1 = isl_basic_map_drop_constraints_involving_dims(bmap1,
+					isl_dim_out, pos, n_out - pos);
+	bmap1 = isl_basic_map_project_out(bmap1, isl_dim_out,
+					pos, n_out - pos);
+	bmap2 = isl_basic_map_drop_constraints_involving_dims(bmap,
+					isl_dim_out, 0, pos);
+	bmap2 = isl_basic_map_project_out(bmap2, isl_dim_out, 0, pos);
+
+	opt1 = SF(basic_map_partial_lexopt,SUFFIX)(bmap1,
+			isl_basic_set_copy(dom), empty ? &empty1 : NULL, max);
+	opt2 = SF(basic_map_partial_lexopt,SUFFIX)(bmap2,
+			dom, empty ? &empty2 : NULL, max);
+	if (empty)
+		*empty = isl_set_union(empty1, empty2);
+
+	opt1 = SF(TYPE,_flat_range_product)(opt1, opt2);
+	return SF(TYPE,_reset_space)(opt1, space);
+error:
+	isl_basic_set_free(dom);
+	isl_basic_map_free(bmap);
+	return NULL;
+}
+
 /* Recursive part of isl_tab_basic_map_partial_lexopt*, after detecting
  * equalities and removing redundant constraints.
  *
- * We first check if there are any parallel constraints (left).
+ * If the optimum can be read off directly from the constraints,
+ * then construct the result without setting up any tableau.
+ * If the output variables can be split into two independent groups,
+ * then handle these groups separately.
+ * Otherwise, we check if there are any parallel constraints (left).
  * If not, we are in the base case.
  * If there are parallel constraints, we replace them by a single
  * constraint in basic_map_partial_lexopt_symm_pma and then call
@@ -151,11 +209,28 @@ static __isl_give TYPE *SF(basic_map_partial_lexopt,SUFFIX)(
 	__isl_give isl_set **empty, int max)
 {
 	isl_bool par = isl_bool_false;
+	isl_bool triangular;
+	isl_multi_aff *ma;
 	int first, second;
+	int split;
 
 	if (!bmap)
 		goto error;
 
+	triangular = triangular_opt(bmap, dom, max, &ma);
+	if (triangular < 0)
+		goto error;
+	if (triangular)
+		return SF(basic_map_partial_lexopt_triangular,SUFFIX)(bmap, dom,
+								empty, ma);
+
+	split = independent_output_split(bmap);
+	if (split < 0)
+		goto error;
+	if (split > 0)
+		return SF(basic_map_partial_lexopt_split,SUFFIX)(bmap, dom,
+							empty, max, split);
+
 	if (bmap->ctx->opt->pip_symmetry)
 		par = parallel_constraints(bmap, &first, &second);
 	if (par < 0)
@@ -196,7 +271,7 @@ error:
  * If the domain was extracted from the basic map, then there is
  * no need to add back those constraints again.
  */
-__isl_give TYPE *SF(isl_tab_basic_map_partial_lexopt,SUFFIX)(
+static __isl_give TYPE *SF(basic_map_partial_lexopt_uncached,SUFFIX)(
 	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
 	__isl_give isl_set **empty, unsigned flags)
 {
@@ -233,3 +308,103 @@ error:
 	isl_basic_map_free(bmap);
 	return NULL;
 }
+
+/* Compute the lexicographic optimum of "bmap" over "dom"
+ * as in basic_map_partial_lexopt_uncached, but first look for
+ * obviously equal inputs in the lexicographic optimization cache
+ * of the isl_ctx.
+ * If there are any and if the corresponding result has been computed,
+ * along with the part of the domain without solutions
+ * in case "empty" is not NULL, then return a copy of this result.
+ * Otherwise, perform the computation and store the result in the cache.
+ * The cache entry is only looked up again after the computation
+ * since this computation may itself change the cache.
+ */
+static __isl_give TYPE *SF(basic_map_partial_lexopt_cached,SUFFIX)(
+	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
+	__isl_give isl_set **empty, unsigned flags)
+{
+	isl_ctx *ctx;
+	struct isl_lexopt_cache_entry *entry;
+	isl_basic_map *key;
+	isl_basic_set *key_dom = NULL;
+	isl_bool match;
+	uint32_t hash;
+	TYPE *res;
+
+	ctx = isl_basic_map_get_ctx(bmap);
+	key = lexopt_key(bmap);
+	if (dom)
+		key_dom = bset_from_bmap(lexopt_key(bset_to_bmap(dom)));
+	if (!key || (dom && !key_dom))
+		goto error;
+	hash = lexopt_key_get_hash(key, key_dom, flags);
+	entry = lexopt_cache_get_entry(ctx, key, key_dom, flags, hash, &match);
+	if (!entry || match < 0)
+		goto error;
+	if (match && entry->SF(res,SUFFIX) && (!empty || entry->empty)) {
+		ctx->stats->lexopt_cache_hits++;
+		if (empty)
+			*empty = isl_set_copy(entry->empty);
+		res = SF(TYPE,_copy)(entry->SF(res,SUFFIX));
+		isl_basic_map_free(key);
+		isl_basic_set_free(key_dom);
+		isl_basic_map_free(bmap);
+		isl_basic_set_free(dom);
+		return res;
+	}
+
+	ctx->stats->lexopt_cache_misses++;
+	res = SF(basic_map_partial_lexopt_uncached,SUFFIX)(bmap, dom,
+							    empty, flags);
+	if (res && (!empty || *empty))
+		entry = lexopt_cache_get_entry(ctx, key, key_dom, flags, hash,
+						&match);
+	else
+		entry = NULL;
+	if (!entry || match < 0) {
+		isl_basic_map_free(key);
+		isl_basic_set_free(key_dom);
+		return res;
+	}
+	if (match) {
+		isl_basic_map_free(key);
+		isl_basic_set_free(key_dom);
+	} else {
+		lexopt_cache_entry_set_key(entry, key, key_dom, flags, hash);
+	}
+	SF(TYPE,_free)(entry->SF(res,SUFFIX));
+	entry->SF(res,SUFFIX) = SF(TYPE,_copy)(res);
+	if (empty) {
+		isl_set_free(entry->empty);
+		entry->empty = isl_set_copy(*empty);
+	}
+	return res;
+error:
+	isl_basic_map_free(key);
+	isl_basic_set_free(key_dom);
+	isl_basic_map_free(bmap);
+	isl_basic_set_free(dom);
+	return NULL;
+}
+
+/* Compute the lexicographic minimum (or maximum if "flags" includes
+ * ISL_OPT_MAX) of "bmap" over the domain "dom" and return the result as
+ * either a map or a piecewise multi-affine expression depending on TYPE,
+ * as in basic_map_partial_lexopt_uncached.
+ * If the lexopt_cache_size option is set, then the result is
+ * looked up in or added to the lexicographic optimization cache
+ * of the isl_ctx.
+ */
+__isl_give TYPE *SF(isl_tab_basic_map_partial_lexopt,SUFFIX)(
+	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
+	__isl_give isl_set **empty, unsigned flags)
+{
+	if (empty)
+		*empty = NULL;
+	if (bmap && bmap->ctx->opt->lexopt_cache_size > 0)
+		return SF(basic_map_partial_lexopt_cached,SUFFIX)(bmap, dom,
+								empty, flags);
+	return SF(basic_map_partial_lexopt_uncached,SUFFIX)(bmap, dom,
+							    empty, flags);
+}
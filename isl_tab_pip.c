@@ -22,7 +22,9 @@
 #include <isl_constraint_private.h>
 #include <isl_options_private.h>
 #include <isl_config.h>
+#include "isl_task.h"
 
+#include <bset_from_bmap.c>
 #include <bset_to_bmap.c>
 
 /*
@@ -170,6 +172,10 @@ struct isl_sol_callback {
  * tableau have value "M - x" rather than "M + x".
  * "n_out" is the number of output dimensions in the input.
  * "space" is the space in which the solution (and also the input) lives.
+ * "add_sol" adds the solution accumulated in "other", which has the same type
+ * as "sol", but which may have been constructed in a different isl_ctx.
+ * If "pool" is not NULL, then it is used to solve the problem
+ * on some parts of the context separately, possibly in parallel.
  *
  * The context tableau is owned by isl_sol and is updated incrementally.
  *
@@ -191,15 +197,20 @@ struct isl_sol {
 	void (*add)(struct isl_sol *sol,
 		__isl_take isl_basic_set *dom, __isl_take isl_multi_aff *ma);
 	void (*add_empty)(struct isl_sol *sol, struct isl_basic_set *bset);
+	void (*add_sol)(struct isl_sol *sol, struct isl_sol *other);
 	void (*free)(struct isl_sol *sol);
 	struct isl_sol_callback	dec_level;
+	struct isl_pip_pool *pool;
 };
 
+static void pip_pool_free(struct isl_pip_pool *pool);
+
 static void sol_free(struct isl_sol *sol)
 {
 	struct isl_partial_sol *partial, *next;
 	if (!sol)
 		return;
+	pip_pool_free(sol->pool);
 	for (partial = sol->partial; partial; partial = next) {
 		next = partial->next;
 		isl_basic_set_free(partial->dom);
@@ -800,6 +811,34 @@ static void sol_map_add_empty_wrap(struct isl_sol *sol,
 	sol_map_add_empty((struct isl_sol_map *)sol, bset);
 }
 
+/* Add the solution accumulated in "other", which may have been
+ * constructed in a different isl_ctx, to "sol".
+ * The two solutions are defined on disjoint parts of the context.
+ */
+static void sol_map_add_sol(struct isl_sol_map *sol,
+	struct isl_sol_map *other)
+{
+	isl_ctx *ctx;
+
+	ctx = isl_space_get_ctx(sol->sol.space);
+	sol->map = isl_map_union_disjoint(sol->map,
+				isl_map_copy_to_ctx(other->map, ctx));
+	if (!sol->map)
+		sol->sol.error = 1;
+	if (!sol->sol.add_empty)
+		return;
+	sol->empty = isl_set_union_disjoint(sol->empty,
+				isl_set_copy_to_ctx(other->empty, ctx));
+	if (!sol->empty)
+		sol->sol.error = 1;
+}
+
+static void sol_map_add_sol_wrap(struct isl_sol *sol, struct isl_sol *other)
+{
+	sol_map_add_sol((struct isl_sol_map *) sol,
+			(struct isl_sol_map *) other);
+}
+
 /* Given a basic set "dom" that represents the context and a tuple of
  * affine expressions "ma" defined over this domain, construct a basic map
  * that expresses this function on the domain.
@@ -1929,9 +1968,8 @@ static struct isl_tab *check_samples(struct isl_tab *tab, isl_int *ineq, int eq)
 	isl_int_init(v);
 	for (i = tab->n_outside; i < tab->n_sample; ++i) {
 		int sgn;
-		isl_seq_inner_product(ineq, tab->samples->row[i],
-					1 + tab->n_var, &v);
-		sgn = isl_int_sgn(v);
+		sgn = isl_seq_inner_product_sgn(ineq, tab->samples->row[i],
+						1 + tab->n_var, &v);
 		if (eq ? (sgn == 0) : (sgn >= 0))
 			continue;
 		tab = isl_tab_drop_sample(tab, i);
@@ -2028,9 +2066,8 @@ static int tab_has_valid_sample(struct isl_tab *tab, isl_int *ineq, int eq)
 	isl_int_init(v);
 	for (i = tab->n_outside; i < tab->n_sample; ++i) {
 		int sgn;
-		isl_seq_inner_product(ineq, tab->samples->row[i],
-					1 + tab->n_var, &v);
-		sgn = isl_int_sgn(v);
+		sgn = isl_seq_inner_product_sgn(ineq, tab->samples->row[i],
+						1 + tab->n_var, &v);
 		if (eq ? (sgn == 0) : (sgn >= 0))
 			break;
 	}
@@ -2554,9 +2591,8 @@ static enum isl_tab_row_sign tab_ineq_sign(struct isl_tab *tab, isl_int *ineq,
 
 	isl_int_init(tmp);
 	for (i = tab->n_outside; i < tab->n_sample; ++i) {
-		isl_seq_inner_product(tab->samples->row[i], ineq,
-					1 + tab->n_var, &tmp);
-		sgn = isl_int_sgn(tmp);
+		sgn = isl_seq_inner_product_sgn(tab->samples->row[i], ineq,
+						1 + tab->n_var, &tmp);
 		if (sgn > 0 || (sgn == 0 && strict)) {
 			if (res == isl_tab_row_unknown)
 				res = isl_tab_row_pos;
@@ -3718,6 +3754,7 @@ static struct isl_sol *sol_map_init(__isl_keep isl_basic_map *bmap,
 		goto error;
 	sol_map->sol.add = &sol_map_add_wrap;
 	sol_map->sol.add_empty = track_empty ? &sol_map_add_empty_wrap : NULL;
+	sol_map->sol.add_sol = &sol_map_add_sol_wrap;
 	space = isl_space_copy(sol_map->sol.space);
 	sol_map->map = isl_map_alloc_space(space, 1, ISL_MAP_DISJOINT);
 	if (!sol_map->map)
@@ -3907,6 +3944,187 @@ error:
 	return isl_tab_row_unknown;
 }
 
+static struct isl_sol *basic_map_partial_lexopt_sol(
+	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
+	int track_empty, int max,
+	struct isl_sol *(*init)(__isl_keep isl_basic_map *bmap,
+		    __isl_take isl_basic_set *dom, int track_empty, int max),
+	int n_thread);
+
+/* A pool for solving parts of the context of the parametric integer
+ * programming problem "bmap" separately.
+ * "track_empty", "max" and "init" are the corresponding arguments
+ * of basic_map_partial_lexopt_sol, which are shared by all parts.
+ * "dom" contains the "n" parts of the context that have been set aside
+ * so far.  At most "size" parts are set aside.
+ * "res" holds the solutions computed on these parts.
+ */
+struct isl_pip_pool {
+	isl_basic_map *bmap;
+	int track_empty;
+	int max;
+	struct isl_sol *(*init)(__isl_keep isl_basic_map *bmap,
+		    __isl_take isl_basic_set *dom, int track_empty, int max);
+
+	int size;
+	int n;
+	isl_basic_set **dom;
+	struct isl_sol **res;
+};
+
+/* Free all parts of the context set aside in "pool"
+ * along with any solutions computed on them.
+ */
+static void pip_pool_free_parts(struct isl_pip_pool *pool)
+{
+	int k;
+
+	for (k = 0; k < pool->n; ++k) {
+		isl_basic_set_free(pool->dom[k]);
+		pool->dom[k] = NULL;
+		sol_free(pool->res[k]);
+		pool->res[k] = NULL;
+	}
+	pool->n = 0;
+}
+
+static void pip_pool_free(struct isl_pip_pool *pool)
+{
+	if (!pool)
+		return;
+	pip_pool_free_parts(pool);
+	isl_basic_map_free(pool->bmap);
+	free(pool->dom);
+	free(pool->res);
+	free(pool);
+}
+
+/* Set up a pool in "sol" for solving parts of the context
+ * of the problem "bmap", provided more than one thread may be used.
+ * At most "n_thread" parts are set aside, such that they can
+ * all be solved at the same time.
+ */
+static isl_stat sol_init_pool(struct isl_sol *sol,
+	__isl_keep isl_basic_map *bmap, int track_empty, int max,
+	struct isl_sol *(*init)(__isl_keep isl_basic_map *bmap,
+		    __isl_take isl_basic_set *dom, int track_empty, int max),
+	int n_thread)
+{
+	isl_ctx *ctx;
+	struct isl_pip_pool *pool;
+
+	if (n_thread <= 1)
+		return isl_stat_ok;
+
+	ctx = isl_basic_map_get_ctx(bmap);
+	pool = isl_calloc_type(ctx, struct isl_pip_pool);
+	if (!pool)
+		return isl_stat_error;
+	sol->pool = pool;
+	pool->dom = isl_calloc_array(ctx, isl_basic_set *, n_thread);
+	pool->res = isl_calloc_array(ctx, struct isl_sol *, n_thread);
+	if (!pool->dom || !pool->res)
+		return isl_stat_error;
+	pool->bmap = isl_basic_map_copy(bmap);
+	pool->track_empty = track_empty;
+	pool->max = max;
+	pool->init = init;
+	pool->size = n_thread;
+
+	return isl_stat_ok;
+}
+
+/* Try and set aside the part of the current context
+ * where the inequality "ineq" holds, such that it can be solved
+ * separately by sol_add_tasks.
+ * Return isl_bool_true if the part was set aside and isl_bool_false
+ * if the pool is full, in which case the caller needs
+ * to handle this part of the context itself.
+ */
+static isl_bool sol_spawn_in_pos(struct isl_sol *sol, isl_int *ineq)
+{
+	isl_basic_set *dom;
+	struct isl_pip_pool *pool = sol->pool;
+
+	if (!pool || pool->n >= pool->size)
+		return isl_bool_false;
+
+	dom = sol_domain(sol);
+	dom = isl_basic_set_add_ineq(dom, ineq);
+	if (!dom)
+		return isl_bool_error;
+	pool->dom[pool->n++] = dom;
+
+	return isl_bool_true;
+}
+
+/* Data used by sol_add_tasks.
+ */
+struct isl_pip_tasks {
+	struct isl_sol *sol;
+	struct isl_pip_pool *pool;
+};
+
+/* Solve the original problem from scratch in "ctx"
+ * on part "k" of the context set aside in data->pool.
+ * The problem is solved without setting aside any further parts.
+ */
+static isl_stat pip_task_run(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_pip_tasks *data = user;
+	struct isl_pip_pool *pool = data->pool;
+	isl_basic_map *bmap;
+	isl_basic_set *dom;
+
+	bmap = isl_basic_map_copy_to_ctx(pool->bmap, ctx);
+	dom = isl_basic_set_copy_to_ctx(pool->dom[k], ctx);
+	if (!bmap || !dom) {
+		isl_basic_map_free(bmap);
+		isl_basic_set_free(dom);
+		return isl_stat_error;
+	}
+	pool->res[k] = basic_map_partial_lexopt_sol(bmap, dom,
+				pool->track_empty, pool->max, pool->init, 0);
+	return pool->res[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* Add the solution computed by task "k", which may have been
+ * constructed in a different isl_ctx, to data->sol and free it.
+ */
+static isl_stat pip_task_merge(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_pip_tasks *data = user;
+	struct isl_pip_pool *pool = data->pool;
+
+	data->sol->add_sol(data->sol, pool->res[k]);
+	sol_free(pool->res[k]);
+	pool->res[k] = NULL;
+
+	return data->sol->error ? isl_stat_error : isl_stat_ok;
+}
+
+/* Solve the parts of the context that have been set aside
+ * in the pool of "sol", if any, in separate tasks and
+ * add the solutions they computed to "sol".
+ */
+static isl_stat sol_add_tasks(struct isl_sol *sol)
+{
+	isl_ctx *ctx;
+	struct isl_pip_pool *pool = sol->pool;
+	struct isl_pip_tasks data = { sol, pool };
+	isl_stat r;
+
+	if (!pool || pool->n == 0)
+		return isl_stat_ok;
+
+	ctx = isl_space_get_ctx(sol->space);
+	r = isl_ctx_run_tasks(ctx, pool->n, pool->size, &pip_task_run,
+				&pip_task_merge, &data);
+	pip_pool_free_parts(pool);
+
+	return r;
+}
+
 static void find_solutions(struct isl_sol *sol, struct isl_tab *tab);
 
 /* Find solutions for values of the parameters that satisfy the given
@@ -4031,7 +4249,8 @@ static void reset_any_to_unknown(struct isl_tab *tab)
  * (i.e., the row can attain both positive and negative signs), then we split
  * the context tableau into two parts, one where we force the sign to be
  * non-negative and one where we force is to be negative.
- * The non-negative part is handled by a recursive call (through find_in_pos).
+ * The non-negative part is handled by a recursive call (through find_in_pos),
+ * unless it can be handed off to a separate thread.
  * Upon returning from this call, we continue with the negative part and
  * perform the required pivot.
  *
@@ -4129,6 +4348,8 @@ static void find_solutions(struct isl_sol *sol, struct isl_tab *tab)
 			continue;
 		if (split != -1) {
 			struct isl_vec *ineq;
+			isl_bool spawned;
+
 			if (n_split != 1)
 				split = context->op->best_split(context, tab);
 			if (split < 0)
@@ -4140,7 +4361,11 @@ static void find_solutions(struct isl_sol *sol, struct isl_tab *tab)
 			reset_any_to_unknown(tab);
 			tab->row_sign[split] = isl_tab_row_pos;
 			sol_inc_level(sol);
-			find_in_pos(sol, tab, ineq->el);
+			spawned = sol_spawn_in_pos(sol, ineq->el);
+			if (spawned < 0)
+				sol->error = 1;
+			else if (!spawned)
+				find_in_pos(sol, tab, ineq->el);
 			tab->row_sign[split] = isl_tab_row_neg;
 			isl_seq_neg(ineq->el, ineq->el, ineq->size);
 			isl_int_sub_ui(ineq->el[0], ineq->el[0], 1);
@@ -4415,24 +4640,36 @@ error:
  * may depend on the known integer divisions, while anything that
  * depends on any variable starting from the first unknown integer
  * division is ignored in sol_pma_add.
+ *
+ * If "n_thread" is greater than one, then up to "n_thread" parts
+ * of the context are set aside during the main computation.
+ * The original problem "bmap" is then solved on these parts
+ * using up to "n_thread" threads and the results are added to "sol".
+ * "track_empty" is set if the parts of the context without solution
+ * need to be kept track of.
  */
-static struct isl_sol *basic_map_partial_lexopt_base_sol(
+static struct isl_sol *basic_map_partial_lexopt_sol(
 	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
-	__isl_give isl_set **empty, int max,
+	int track_empty, int max,
 	struct isl_sol *(*init)(__isl_keep isl_basic_map *bmap,
-		    __isl_take isl_basic_set *dom, int track_empty, int max))
+		    __isl_take isl_basic_set *dom, int track_empty, int max),
+	int n_thread)
 {
 	struct isl_tab *tab;
 	struct isl_sol *sol = NULL;
 	struct isl_context *context;
+	isl_basic_map *orig;
 
+	orig = isl_basic_map_copy(bmap);
 	if (dom->n_div) {
 		dom = isl_basic_set_sort_divs(dom);
 		bmap = align_context_divs(bmap, dom);
 	}
-	sol = init(bmap, dom, !!empty, max);
+	sol = init(bmap, dom, track_empty, max);
 	if (!sol)
 		goto error;
+	if (sol_init_pool(sol, orig, track_empty, max, init, n_thread) < 0)
+		goto error;
 
 	context = sol->context;
 	if (isl_basic_set_plain_is_empty(context->op->peek_basic_set(context)))
@@ -4442,22 +4679,56 @@ static struct isl_sol *basic_map_partial_lexopt_base_sol(
 			sol->add_empty(sol,
 		    isl_basic_set_copy(context->op->peek_basic_set(context)));
 	} else {
+		isl_ctx *ctx = isl_basic_map_get_ctx(bmap);
+		clock_t start;
+
 		tab = tab_for_lexmin(bmap,
 				    context->op->peek_basic_set(context), 1, max);
 		tab = context->op->detect_nonnegative_parameters(context, tab);
+		start = isl_ctx_stats_enter(ctx, &ctx->stats->pip_solves);
 		find_solutions_main(sol, tab);
+		if (!sol->error && sol_add_tasks(sol) < 0)
+			sol->error = 1;
+		isl_ctx_stats_leave(&ctx->stats->pip_time, start);
 	}
 	if (sol->error)
 		goto error;
 
+	isl_basic_map_free(orig);
 	isl_basic_map_free(bmap);
 	return sol;
 error:
 	sol_free(sol);
+	isl_basic_map_free(orig);
 	isl_basic_map_free(bmap);
 	return NULL;
 }
 
+/* Base case of isl_tab_basic_map_partial_lexopt, after removing
+ * some obvious symmetries.
+ *
+ * Call basic_map_partial_lexopt_sol with the number of threads
+ * specified by the pip_threads option.
+ */
+static struct isl_sol *basic_map_partial_lexopt_base_sol(
+	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
+	__isl_give isl_set **empty, int max,
+	struct isl_sol *(*init)(__isl_keep isl_basic_map *bmap,
+		    __isl_take isl_basic_set *dom, int track_empty, int max))
+{
+	isl_ctx *ctx;
+
+	if (!bmap || !dom)
+		goto error;
+	ctx = isl_basic_map_get_ctx(bmap);
+	return basic_map_partial_lexopt_sol(bmap, dom, !!empty, max, init,
+					    ctx->opt->pip_threads);
+error:
+	isl_basic_map_free(bmap);
+	isl_basic_set_free(dom);
+	return NULL;
+}
+
 /* Base case of isl_tab_basic_map_partial_lexopt, after removing
  * some obvious symmetries.
  *
@@ -4890,6 +5161,293 @@ static __isl_give isl_set *split(__isl_take isl_set *empty,
 	return empty;
 }
 
+/* Look for the constraint of "bmap" that bounds output variable "pos"
+ * from below (or from above if "max" is set) in a way that directly
+ * determines the lexicographic optimum, given the values of
+ * the earlier output variables.
+ * "n_in" is the number of parameters and input variables,
+ * "n_out" the number of output variables.
+ *
+ * Return the position of this inequality constraint,
+ * -1 if no such constraint could be found and
+ * -2 if "bmap" has any constraint involving "pos" as last output variable
+ * that prevents the lexicographic optimum from being determined directly.
+ *
+ * In particular, for a lexicographic minimum, there needs to be
+ * a single constraint of the form
+ *
+ *	x_pos + f(p, i) + sum_{k < pos} c_k x_k >= 0
+ *
+ * with all c_k non-positive and all other constraints
+ * with x_pos as last output variable need to be of the form
+ *
+ *	-a x_pos + g(p, i) >= 0
+ *
+ * with a positive.  The lexicographic optimum for x_pos is then
+ * -(f(p, i) + sum_{k < pos} c_k x_k), which is a non-decreasing function
+ * of the earlier output variables, while the constraints of the second
+ * form can only be violated by this choice if they are also violated
+ * by any other choice.  The conditions for a lexicographic maximum
+ * are obtained by negating x_pos and the earlier output variables.
+ */
+static int triangular_bound(__isl_keep isl_basic_map *bmap, int max,
+	unsigned n_in, unsigned n_out, int pos)
+{
+	int i, k;
+	int sign = max ? -1 : 1;
+	int bound = -1;
+
+	for (i = 0; i < bmap->n_ineq; ++i) {
+		isl_int *c = bmap->ineq[i] + 1 + n_in;
+
+		if (isl_seq_last_non_zero(c, n_out) != pos)
+			continue;
+		if (isl_int_sgn(c[pos]) != sign) {
+			if (isl_seq_first_non_zero(c, pos) >= 0)
+				return -2;
+			continue;
+		}
+		if (bound >= 0)
+			return -2;
+		if (!isl_int_is_one(c[pos]) && !isl_int_is_negone(c[pos]))
+			return -2;
+		for (k = 0; k < pos; ++k)
+			if (isl_int_sgn(c[k]) == sign)
+				return -2;
+		bound = i;
+	}
+
+	return bound;
+}
+
+/* Check whether the lexicographic minimum (or maximum if "max" is set)
+ * of "bmap" over "dom" can be read off directly from its constraints and,
+ * if so, set *ma to this optimum, expressed in terms of
+ * the parameters and the input variables.
+ *
+ * This is the case if "bmap" is integral, has no existentially
+ * quantified variables, has no equality constraints involving
+ * the output variables and if each output variable has a constraint
+ * as described in triangular_bound.  The optimal value of each output
+ * variable is then obtained from this constraint by plugging in
+ * the optimal values of the earlier output variables.
+ * Note that the coefficient of the output variable is one (or minus one),
+ * such that the optimal values are integral.
+ * These optimal values are only valid for those values of the parameters
+ * and the input variables where they satisfy the constraints of "bmap".
+ * See triangular_domain.
+ */
+static isl_bool triangular_opt(__isl_keep isl_basic_map *bmap,
+	__isl_keep isl_basic_set *dom, int max, __isl_give isl_multi_aff **ma)
+{
+	int i, j, k;
+	isl_ctx *ctx;
+	isl_size n_in, n_out, n_div;
+	isl_mat *mat;
+	isl_local_space *ls;
+	isl_int t;
+
+	*ma = NULL;
+	n_in = isl_basic_map_var_offset(bmap, isl_dim_out);
+	n_out = isl_basic_map_dim(bmap, isl_dim_out);
+	n_div = isl_basic_map_dim(bmap, isl_dim_div);
+	if (n_in < 0 || n_out < 0 || n_div < 0)
+		return isl_bool_error;
+	if (n_div != 0 || ISL_F_ISSET(bmap, ISL_BASIC_MAP_RATIONAL))
+		return isl_bool_false;
+	for (i = 0; i < bmap->n_eq; ++i)
+		if (isl_seq_first_non_zero(bmap->eq[i] + 1 + n_in, n_out) >= 0)
+			return isl_bool_false;
+
+	ctx = isl_basic_map_get_ctx(bmap);
+	mat = isl_mat_alloc(ctx, 1 + n_out, 1 + n_in);
+	if (!mat)
+		return isl_bool_error;
+	isl_int_set_si(mat->row[0][0], 1);
+	isl_seq_clr(mat->row[0] + 1, n_in);
+	isl_int_init(t);
+	for (j = 0; j < n_out; ++j) {
+		isl_int *c;
+		int bound;
+
+		bound = triangular_bound(bmap, max, n_in, n_out, j);
+		if (bound < 0)
+			break;
+		c = bmap->ineq[bound];
+		if (max)
+			isl_seq_cpy(mat->row[1 + j], c, 1 + n_in);
+		else
+			isl_seq_neg(mat->row[1 + j], c, 1 + n_in);
+		for (k = 0; k < j; ++k) {
+			if (isl_int_is_zero(c[1 + n_in + k]))
+				continue;
+			if (max)
+				isl_int_set(t, c[1 + n_in + k]);
+			else
+				isl_int_neg(t, c[1 + n_in + k]);
+			isl_seq_combine(mat->row[1 + j], ctx->one,
+				mat->row[1 + j], t, mat->row[1 + k], 1 + n_in);
+		}
+	}
+	isl_int_clear(t);
+	if (j < n_out) {
+		isl_mat_free(mat);
+		return isl_bool_false;
+	}
+
+	*ma = isl_multi_aff_alloc(isl_basic_map_get_space(bmap));
+	ls = isl_local_space_from_space(isl_basic_set_get_space(dom));
+	*ma = set_from_affine_matrix(*ma, ls, mat);
+	if (!*ma)
+		return isl_bool_error;
+	return isl_bool_true;
+}
+
+/* Given that "ma" is the lexicographic optimum of "bmap"
+ * as computed by triangular_opt, return the part of "dom"
+ * where this optimum is valid, i.e., where it satisfies
+ * the constraints of "bmap".
+ * If "empty" is not NULL, then set *empty to the remaining part of "dom",
+ * where "bmap" has no solution.
+ *
+ * The constraints of "bmap" are added to "dom" after plugging in "ma".
+ * "dom" may have existentially quantified variables,
+ * but these do not appear in "bmap" or "ma".
+ */
+static __isl_give isl_basic_set *triangular_domain(
+	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
+	__isl_keep isl_multi_aff *ma, __isl_give isl_set **empty)
+{
+	int i, j, k;
+	isl_size n_in, n_out, dom_n_div;
+	isl_basic_set *valid;
+
+	n_in = isl_basic_map_var_offset(bmap, isl_dim_out);
+	n_out = isl_basic_map_dim(bmap, isl_dim_out);
+	dom_n_div = isl_basic_set_dim(dom, isl_dim_div);
+	if (n_in < 0 || n_out < 0 || dom_n_div < 0 || !ma)
+		goto error;
+
+	valid = isl_basic_set_copy(dom);
+	valid = isl_basic_set_cow(valid);
+	valid = isl_basic_set_extend_constraints(valid,
+						bmap->n_eq, bmap->n_ineq);
+	for (i = 0; i < bmap->n_eq + bmap->n_ineq; ++i) {
+		int is_eq = i < bmap->n_eq;
+		isl_int *c;
+		isl_int *row;
+
+		c = is_eq ? bmap->eq[i] : bmap->ineq[i - bmap->n_eq];
+		k = is_eq ? isl_basic_set_alloc_equality(valid) :
+			    isl_basic_set_alloc_inequality(valid);
+		if (k < 0)
+			goto error_valid;
+		row = is_eq ? valid->eq[k] : valid->ineq[k];
+		isl_seq_cpy(row, c, 1 + n_in);
+		isl_seq_clr(row + 1 + n_in, dom_n_div);
+		for (j = 0; j < n_out; ++j) {
+			isl_aff *aff = ma->u.p[j];
+
+			if (isl_int_is_zero(c[1 + n_in + j]))
+				continue;
+			isl_seq_combine(row, aff->v->el[0], row,
+					c[1 + n_in + j], aff->v->el + 1,
+					1 + n_in);
+		}
+	}
+	valid = isl_basic_set_simplify(valid);
+	valid = isl_basic_set_finalize(valid);
+
+	if (empty)
+		*empty = isl_set_subtract(isl_set_from_basic_set(dom),
+				isl_set_from_basic_set(isl_basic_set_copy(valid)));
+	else
+		isl_basic_set_free(dom);
+	isl_basic_map_free(bmap);
+	return valid;
+error_valid:
+	isl_basic_set_free(valid);
+error:
+	isl_basic_set_free(dom);
+	isl_basic_map_free(bmap);
+	return NULL;
+}
+
+/* Look for a position "pos" such that none of the constraints of "bmap"
+ * involves both an output variable before "pos" and
+ * an output variable at or after "pos".
+ * Return the first such position, 0 if there is no such position or
+ * -1 on error.
+ *
+ * For each output variable, the last output variable is kept track of
+ * that appears in a constraint together with the output variable,
+ * where the output variable is the first output variable
+ * in that constraint.  A position "pos" is then suitable
+ * if none of these ranges of output variables crosses "pos".
+ * Existentially quantified variables may tie the output variables
+ * together in ways that are not visible in the constraints themselves,
+ * so no attempt is made to split "bmap" if it has any.
+ */
+static int independent_output_split(__isl_keep isl_basic_map *bmap)
+{
+	int i, j, end;
+	int *last;
+	isl_size n_in, n_out, n_div;
+
+	n_in = isl_basic_map_var_offset(bmap, isl_dim_out);
+	n_out = isl_basic_map_dim(bmap, isl_dim_out);
+	n_div = isl_basic_map_dim(bmap, isl_dim_div);
+	if (n_in < 0 || n_out < 0 || n_div < 0)
+		return -1;
+	if (n_div != 0 || n_out < 2)
+		return 0;
+
+	last = isl_alloc_array(isl_basic_map_get_ctx(bmap), int, n_out);
+	if (!last)
+		return -1;
+	for (j = 0; j < n_out; ++j)
+		last[j] = j;
+	for (i = 0; i < bmap->n_eq + bmap->n_ineq; ++i) {
+		isl_int *c;
+		int first, l;
+
+		c = i < bmap->n_eq ? bmap->eq[i] : bmap->ineq[i - bmap->n_eq];
+		c += 1 + n_in;
+		first = isl_seq_first_non_zero(c, n_out);
+		if (first < 0)
+			continue;
+		l = isl_seq_last_non_zero(c, n_out);
+		if (l > last[first])
+			last[first] = l;
+	}
+
+	end = 0;
+	for (j = 0; j + 1 < n_out; ++j) {
+		if (last[j] > end)
+			end = last[j];
+		if (end <= j)
+			break;
+	}
+	free(last);
+
+	return j + 1 < n_out ? j + 1 : 0;
+}
+
+/* Compute the lexicographic optimum of "bmap" over "dom",
+ * given that triangular_opt has determined it to be "ma".
+ */
+static __isl_give isl_map *basic_map_partial_lexopt_triangular(
+	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
+	__isl_give isl_set **empty, __isl_take isl_multi_aff *ma)
+{
+	isl_basic_map *opt;
+
+	dom = triangular_domain(bmap, dom, ma, empty);
+	opt = isl_basic_map_from_multi_aff2(ma, 0);
+	opt = isl_basic_map_intersect_domain(opt, dom);
+	return isl_map_from_basic_map(opt);
+}
+
 static __isl_give isl_map *basic_map_partial_lexopt(
 	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
 	__isl_give isl_set **empty, int max);
@@ -4969,6 +5527,195 @@ static __isl_give isl_basic_set *extract_domain(__isl_keep isl_basic_map *bmap,
 	return isl_basic_map_domain(bmap);
 }
 
+/* An entry in the lexicographic optimization cache of an isl_ctx.
+ * "bmap" and "dom" are copies of the inputs of a call to
+ * isl_tab_basic_map_partial_lexopt or
+ * isl_tab_basic_map_partial_lexopt_pw_multi_aff with sorted constraints,
+ * where "dom" is NULL if ISL_OPT_FULL is set in "flags", and
+ * "hash" is a hash value of these inputs.
+ * "res" and "res_pw_multi_aff" are the results of the respective
+ * functions, either of which may be NULL if it has not been computed.
+ * "empty" is the part of "dom" where there is no solution or
+ * NULL if this set has not been computed.
+ */
+struct isl_lexopt_cache_entry {
+	uint32_t		hash;
+	isl_basic_map		*bmap;
+	isl_basic_set		*dom;
+	unsigned		flags;
+	isl_map			*res;
+	isl_pw_multi_aff	*res_pw_multi_aff;
+	isl_set			*empty;
+};
+
+/* A size-bounded cache of the results of lexicographic optimizations.
+ * "size" is the number of entries in "entry".
+ * The cache is direct-mapped: an input with hash value "hash"
+ * can only be stored in entry "hash % size", replacing
+ * the input that was stored there before.
+ */
+struct isl_lexopt_cache {
+	int				size;
+	struct isl_lexopt_cache_entry	*entry;
+};
+
+/* Free the results stored in "entry", keeping the input.
+ */
+static void lexopt_cache_entry_clear_results(
+	struct isl_lexopt_cache_entry *entry)
+{
+	entry->res = isl_map_free(entry->res);
+	entry->res_pw_multi_aff =
+		isl_pw_multi_aff_free(entry->res_pw_multi_aff);
+	entry->empty = isl_set_free(entry->empty);
+}
+
+/* Free the lexicographic optimization cache of "ctx", if any.
+ * The cached objects keep a reference to "ctx", so this function
+ * needs to be called before checking whether "ctx" can be freed.
+ */
+void isl_ctx_clear_lexopt_cache(isl_ctx *ctx)
+{
+	int i;
+	struct isl_lexopt_cache *cache;
+
+	if (!ctx || !ctx->lexopt_cache)
+		return;
+	cache = ctx->lexopt_cache;
+	ctx->lexopt_cache = NULL;
+	for (i = 0; i < cache->size; ++i) {
+		isl_basic_map_free(cache->entry[i].bmap);
+		isl_basic_set_free(cache->entry[i].dom);
+		lexopt_cache_entry_clear_results(&cache->entry[i]);
+	}
+	free(cache->entry);
+	free(cache);
+}
+
+/* Return the lexicographic optimization cache of "ctx",
+ * allocating it if needed.
+ * The size of the cache is determined by the lexopt_cache_size option.
+ * If this option has changed since the cache was allocated,
+ * then the cache is reallocated.
+ */
+static struct isl_lexopt_cache *get_lexopt_cache(isl_ctx *ctx)
+{
+	int size = ctx->opt->lexopt_cache_size;
+	struct isl_lexopt_cache *cache;
+
+	if (ctx->lexopt_cache && ctx->lexopt_cache->size == size)
+		return ctx->lexopt_cache;
+	isl_ctx_clear_lexopt_cache(ctx);
+	cache = isl_calloc_type(ctx, struct isl_lexopt_cache);
+	if (!cache)
+		return NULL;
+	cache->entry = isl_calloc_array(ctx, struct isl_lexopt_cache_entry,
+					size);
+	if (!cache->entry) {
+		free(cache);
+		return NULL;
+	}
+	cache->size = size;
+	ctx->lexopt_cache = cache;
+	return cache;
+}
+
+/* Update "hash" with the constraints and local variables of "bmap".
+ */
+static uint32_t basic_map_update_hash(uint32_t hash,
+	__isl_keep isl_basic_map *bmap)
+{
+	int i;
+	isl_size total;
+	uint32_t c_hash;
+
+	total = isl_basic_map_dim(bmap, isl_dim_all);
+	if (total < 0)
+		return hash;
+	isl_hash_byte(hash, bmap->n_eq & 0xFF);
+	for (i = 0; i < bmap->n_eq; ++i) {
+		c_hash = isl_seq_get_hash(bmap->eq[i], 1 + total);
+		isl_hash_hash(hash, c_hash);
+	}
+	isl_hash_byte(hash, bmap->n_ineq & 0xFF);
+	for (i = 0; i < bmap->n_ineq; ++i) {
+		c_hash = isl_seq_get_hash(bmap->ineq[i], 1 + total);
+		isl_hash_hash(hash, c_hash);
+	}
+	isl_hash_byte(hash, bmap->n_div & 0xFF);
+	for (i = 0; i < bmap->n_div; ++i) {
+		c_hash = isl_seq_get_hash(bmap->div[i], 2 + total);
+		isl_hash_hash(hash, c_hash);
+	}
+	return hash;
+}
+
+/* Return a hash value for the inputs "bmap", "dom" and "flags"
+ * of a lexicographic optimization, where "dom" may be NULL.
+ */
+static uint32_t lexopt_key_get_hash(__isl_keep isl_basic_map *bmap,
+	__isl_keep isl_basic_set *dom, unsigned flags)
+{
+	uint32_t hash = isl_hash_init();
+
+	isl_hash_byte(hash, flags & 0xFF);
+	hash = basic_map_update_hash(hash, bmap);
+	if (dom)
+		hash = basic_map_update_hash(hash, bset_to_bmap(dom));
+	return hash;
+}
+
+/* Return a copy of "bmap" with sorted constraints
+ * for use as (part of) a key in the lexicographic optimization cache.
+ */
+static __isl_give isl_basic_map *lexopt_key(__isl_keep isl_basic_map *bmap)
+{
+	bmap = isl_basic_map_cow(isl_basic_map_copy(bmap));
+	return isl_basic_map_sort_constraints(bmap);
+}
+
+/* Return the entry of the lexicographic optimization cache of "ctx"
+ * where the inputs "bmap", "dom" and "flags" with hash value "hash"
+ * are or would be stored.  "bmap" and "dom" have sorted constraints.
+ * Set *match to whether these inputs are actually stored there.
+ */
+static struct isl_lexopt_cache_entry *lexopt_cache_get_entry(isl_ctx *ctx,
+	__isl_keep isl_basic_map *bmap, __isl_keep isl_basic_set *dom,
+	unsigned flags, uint32_t hash, isl_bool *match)
+{
+	struct isl_lexopt_cache *cache;
+	struct isl_lexopt_cache_entry *entry;
+
+	*match = isl_bool_false;
+	cache = get_lexopt_cache(ctx);
+	if (!cache)
+		return NULL;
+	entry = &cache->entry[hash % cache->size];
+	if (!entry->bmap || entry->hash != hash || entry->flags != flags ||
+	    !entry->dom != !dom)
+		return entry;
+	*match = isl_basic_map_plain_is_equal(entry->bmap, bmap);
+	if (*match >= 0 && *match && dom)
+		*match = isl_basic_set_plain_is_equal(entry->dom, dom);
+	return entry;
+}
+
+/* Store the inputs "bmap", "dom" and "flags" with hash value "hash"
+ * in "entry", replacing the inputs and results that were stored there.
+ */
+static void lexopt_cache_entry_set_key(struct isl_lexopt_cache_entry *entry,
+	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
+	unsigned flags, uint32_t hash)
+{
+	isl_basic_map_free(entry->bmap);
+	isl_basic_set_free(entry->dom);
+	lexopt_cache_entry_clear_results(entry);
+	entry->hash = hash;
+	entry->bmap = bmap;
+	entry->dom = dom;
+	entry->flags = flags;
+}
+
 #undef TYPE
 #define TYPE	isl_map
 #undef SUFFIX
@@ -5550,10 +6297,18 @@ error:
  * the lexicographically smallest rational point of a non-negative set.
  * This point is represented by the sample value of "tab",
  * unless "tab" is empty.
+ *
+ * "snap" is a stack of "n_snap" snapshots of "tab" (with room
+ * for "size_snap" elements), taken by isl_tab_lexmin_push
+ * and restored by isl_tab_lexmin_pop.
  */
 struct isl_tab_lexmin {
 	isl_ctx *ctx;
 	struct isl_tab *tab;
+
+	int n_snap;
+	int size_snap;
+	struct isl_tab_undo **snap;
 };
 
 /* Free "tl" and return NULL.
@@ -5564,6 +6319,7 @@ __isl_null isl_tab_lexmin *isl_tab_lexmin_free(__isl_take isl_tab_lexmin *tl)
 		return NULL;
 	isl_ctx_deref(tl->ctx);
 	isl_tab_free(tl->tab);
+	free(tl->snap);
 	free(tl);
 
 	return NULL;
@@ -5646,6 +6402,56 @@ __isl_give isl_tab_lexmin *isl_tab_lexmin_cut_to_integer(
 	return tl;
 }
 
+/* Save the current state of "tl" such that any constraints
+ * (including cuts) that are added afterwards can be removed again
+ * by a call to isl_tab_lexmin_pop.
+ * The current basis is saved as well, such that the current
+ * optimal solution is immediately available again after
+ * the call to isl_tab_lexmin_pop, without any re-optimization.
+ * Calls to isl_tab_lexmin_push and isl_tab_lexmin_pop may be nested.
+ */
+__isl_give isl_tab_lexmin *isl_tab_lexmin_push(__isl_take isl_tab_lexmin *tl)
+{
+	if (!tl)
+		return NULL;
+
+	if (tl->n_snap >= tl->size_snap) {
+		struct isl_tab_undo **snap;
+		int size = 2 * tl->size_snap + 4;
+
+		snap = isl_realloc_array(tl->ctx, tl->snap,
+					struct isl_tab_undo *, size);
+		if (!snap)
+			return isl_tab_lexmin_free(tl);
+		tl->snap = snap;
+		tl->size_snap = size;
+	}
+
+	tl->snap[tl->n_snap++] = isl_tab_snap(tl->tab);
+	if (isl_tab_push_basis(tl->tab) < 0)
+		return isl_tab_lexmin_free(tl);
+
+	return tl;
+}
+
+/* Restore "tl" to the state saved by the matching call
+ * to isl_tab_lexmin_push, removing all constraints that were
+ * added since then.
+ */
+__isl_give isl_tab_lexmin *isl_tab_lexmin_pop(__isl_take isl_tab_lexmin *tl)
+{
+	if (!tl)
+		return NULL;
+	if (tl->n_snap <= 0)
+		isl_die(tl->ctx, isl_error_internal,
+			"no saved state", return isl_tab_lexmin_free(tl));
+
+	if (isl_tab_rollback(tl->tab, tl->snap[--tl->n_snap]) < 0)
+		return isl_tab_lexmin_free(tl);
+
+	return tl;
+}
+
 /* Return the lexicographically smallest rational point in the basic set
  * from which "tl" was constructed.
  * If the original input was empty, then return a zero-length vector.
@@ -5725,6 +6531,34 @@ static void sol_pma_add_wrap(struct isl_sol *sol,
 	sol_pma_add((struct isl_sol_pma *)sol, dom, ma);
 }
 
+/* Add the solution accumulated in "other", which may have been
+ * constructed in a different isl_ctx, to "sol".
+ * The two solutions are defined on disjoint parts of the context.
+ */
+static void sol_pma_add_sol(struct isl_sol_pma *sol,
+	struct isl_sol_pma *other)
+{
+	isl_ctx *ctx;
+
+	ctx = isl_space_get_ctx(sol->sol.space);
+	sol->pma = isl_pw_multi_aff_add_disjoint(sol->pma,
+				isl_pw_multi_aff_copy_to_ctx(other->pma, ctx));
+	if (!sol->pma)
+		sol->sol.error = 1;
+	if (!sol->sol.add_empty)
+		return;
+	sol->empty = isl_set_union_disjoint(sol->empty,
+				isl_set_copy_to_ctx(other->empty, ctx));
+	if (!sol->empty)
+		sol->sol.error = 1;
+}
+
+static void sol_pma_add_sol_wrap(struct isl_sol *sol, struct isl_sol *other)
+{
+	sol_pma_add_sol((struct isl_sol_pma *) sol,
+			(struct isl_sol_pma *) other);
+}
+
 /* Construct an isl_sol_pma structure for accumulating the solution.
  * If track_empty is set, then we also keep track of the parts
  * of the context where there is no solution.
@@ -5750,6 +6584,7 @@ static struct isl_sol *sol_pma_init(__isl_keep isl_basic_map *bmap,
 		goto error;
 	sol_pma->sol.add = &sol_pma_add_wrap;
 	sol_pma->sol.add_empty = track_empty ? &sol_pma_add_empty_wrap : NULL;
+	sol_pma->sol.add_sol = &sol_pma_add_sol_wrap;
 	space = isl_space_copy(sol_pma->sol.space);
 	sol_pma->pma = isl_pw_multi_aff_empty(space);
 	if (!sol_pma->pma)
@@ -5796,6 +6631,18 @@ static __isl_give isl_pw_multi_aff *basic_map_partial_lexopt_base_pw_multi_aff(
 	return result;
 }
 
+/* Compute the lexicographic optimum of "bmap" over "dom",
+ * given that triangular_opt has determined it to be "ma".
+ */
+static __isl_give isl_pw_multi_aff *
+basic_map_partial_lexopt_triangular_pw_multi_aff(
+	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
+	__isl_give isl_set **empty, __isl_take isl_multi_aff *ma)
+{
+	dom = triangular_domain(bmap, dom, ma, empty);
+	return isl_pw_multi_aff_alloc(isl_set_from_basic_set(dom), ma);
+}
+
 /* Given that the last input variable of "maff" represents the minimum
  * of some bounds, check whether we need to plug in the expression
  * of the minimum.
@@ -56,6 +56,61 @@ error:
 	return NULL;
 }
 
+/* Start visiting node "i" in Tarjan's algorithm.
+ */
+static void isl_tarjan_start(struct isl_tarjan_graph *g, int i)
+{
+	g->node[i].index = g->index;
+	g->node[i].min_index = g->index;
+	g->node[i].on_stack = 1;
+	g->index++;
+	g->stack[g->sp++] = i;
+}
+
+/* Can the edge from node "i" to node "j" be skipped
+ * in Tarjan's algorithm?  That is, has "j" been visited already and
+ * can it not affect the min_index of "i"?
+ */
+static int isl_tarjan_skip(struct isl_tarjan_graph *g, int i, int j)
+{
+	return g->node[j].index >= 0 &&
+		(!g->node[j].on_stack ||
+		 g->node[j].index > g->node[i].min_index);
+}
+
+/* Update the min_index of node "i" based on that of node "j",
+ * which either has just been visited from "i" or
+ * is still on the stack.
+ */
+static void isl_tarjan_update(struct isl_tarjan_graph *g, int i, int j,
+	int visited)
+{
+	if (visited) {
+		if (g->node[j].min_index < g->node[i].min_index)
+			g->node[i].min_index = g->node[j].min_index;
+	} else if (g->node[j].index < g->node[i].min_index)
+		g->node[i].min_index = g->node[j].index;
+}
+
+/* Finish visiting node "i" in Tarjan's algorithm.
+ * If "i" is the root of a component, then pop the component
+ * off the stack and append it to g->order.
+ */
+static void isl_tarjan_finish(struct isl_tarjan_graph *g, int i)
+{
+	int j;
+
+	if (g->node[i].index != g->node[i].min_index)
+		return;
+
+	do {
+		j = g->stack[--g->sp];
+		g->node[j].on_stack = 0;
+		g->order[g->op++] = j;
+	} while (j != i);
+	g->order[g->op++] = -1;
+}
+
 /* Perform Tarjan's algorithm for computing the strongly connected components
  * in the graph with g->len nodes and with edges defined by "follows".
  */
@@ -64,20 +119,15 @@ static isl_stat isl_tarjan_components(struct isl_tarjan_graph *g, int i,
 {
 	int j;
 
-	g->node[i].index = g->index;
-	g->node[i].min_index = g->index;
-	g->node[i].on_stack = 1;
-	g->index++;
-	g->stack[g->sp++] = i;
+	isl_tarjan_start(g, i);
 
 	for (j = g->len - 1; j >= 0; --j) {
 		isl_bool f;
+		int visit;
 
 		if (j == i)
 			continue;
-		if (g->node[j].index >= 0 &&
-			(!g->node[j].on_stack ||
-			 g->node[j].index > g->node[i].min_index))
+		if (isl_tarjan_skip(g, i, j))
 			continue;
 
 		f = follows(i, j, user);
@@ -86,23 +136,45 @@ static isl_stat isl_tarjan_components(struct isl_tarjan_graph *g, int i,
 		if (!f)
 			continue;
 
-		if (g->node[j].index < 0) {
+		visit = g->node[j].index < 0;
+		if (visit)
 			isl_tarjan_components(g, j, follows, user);
-			if (g->node[j].min_index < g->node[i].min_index)
-				g->node[i].min_index = g->node[j].min_index;
-		} else if (g->node[j].index < g->node[i].min_index)
-			g->node[i].min_index = g->node[j].index;
+		isl_tarjan_update(g, i, j, visit);
 	}
 
-	if (g->node[i].index != g->node[i].min_index)
-		return isl_stat_ok;
+	isl_tarjan_finish(g, i);
 
-	do {
-		j = g->stack[--g->sp];
-		g->node[j].on_stack = 0;
-		g->order[g->op++] = j;
-	} while (j != i);
-	g->order[g->op++] = -1;
+	return isl_stat_ok;
+}
+
+/* Perform Tarjan's algorithm for computing the strongly connected components
+ * in the graph with g->len nodes and with edges defined by "pos" and "list",
+ * as described in isl_tarjan_graph_init_lists.
+ */
+static isl_stat isl_tarjan_components_lists(struct isl_tarjan_graph *g, int i,
+	const int *pos, const int *list)
+{
+	int k;
+
+	isl_tarjan_start(g, i);
+
+	for (k = pos[i]; k < pos[i + 1]; ++k) {
+		int j = list[k];
+		int visit;
+
+		if (j == i)
+			continue;
+		if (isl_tarjan_skip(g, i, j))
+			continue;
+
+		visit = g->node[j].index < 0;
+		if (visit &&
+		    isl_tarjan_components_lists(g, j, pos, list) < 0)
+			return isl_stat_error;
+		isl_tarjan_update(g, i, j, visit);
+	}
+
+	isl_tarjan_finish(g, i);
 
 	return isl_stat_ok;
 }
@@ -135,6 +207,35 @@ struct isl_tarjan_graph *isl_tarjan_graph_init(isl_ctx *ctx, int len,
 	return g;
 }
 
+/* Decompose the graph with "len" nodes and edges defined by "pos" and "list"
+ * into strongly connected components (SCCs).
+ * The nodes followed by node "i" are list[pos[i]], ..., list[pos[i + 1] - 1],
+ * sorted in decreasing order.
+ *
+ * The result is the same as that of isl_tarjan_graph_init
+ * with a "follows" callback that returns 1 on exactly these pairs,
+ * but the time required is linear in the number of edges rather than
+ * quadratic in the number of nodes.
+ */
+struct isl_tarjan_graph *isl_tarjan_graph_init_lists(isl_ctx *ctx, int len,
+	const int *pos, const int *list)
+{
+	int i;
+	struct isl_tarjan_graph *g = NULL;
+
+	g = isl_tarjan_graph_alloc(ctx, len);
+	if (!g)
+		return NULL;
+	for (i = len - 1; i >= 0; --i) {
+		if (g->node[i].index >= 0)
+			continue;
+		if (isl_tarjan_components_lists(g, i, pos, list) < 0)
+			return isl_tarjan_graph_free(g);
+	}
+
+	return g;
+}
+
 /* Decompose the graph with "len" nodes and edges defined by "follows"
  * into the strongly connected component (SCC) that contains "node"
  * as well as all SCCs that are followed by this SCC.
@@ -0,0 +1,228 @@
+/*
+ * Use of this software is governed by the MIT license
+ */
+
+#include <stdlib.h>
+#include <isl_ctx_private.h>
+#include <isl_options_private.h>
+#include <isl_config.h>
+#include "isl_task.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+/* Return the number of threads that should be used by an operation
+ * in "ctx" for which the operation specific option is set to "n_thread".
+ * If this option is not set (i.e., it is zero), then
+ * the threads option is used instead.
+ */
+int isl_ctx_get_n_thread(isl_ctx *ctx, int n_thread)
+{
+	if (!ctx)
+		return -1;
+	if (n_thread != 0)
+		return n_thread;
+	return ctx->opt->threads;
+}
+
+/* A pool of "n_task" tasks that are executed by calling "run"
+ * with argument "user".
+ * "done[k]" is set if task "k" has been executed successfully.
+ * "next" is the next task that has not been handed out yet.
+ * Access to "next" is protected by "lock".
+ */
+struct isl_task_pool {
+	int n_task;
+	isl_stat (*run)(isl_ctx *ctx, int task, void *user);
+	void *user;
+	char *done;
+
+	int next;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t lock;
+#endif
+};
+
+#ifdef HAVE_PTHREAD
+
+/* A worker thread executing tasks from "pool" in its own context "ctx",
+ * which is a child context of the context of the calling thread.
+ */
+struct isl_task_worker {
+	isl_ctx *ctx;
+	struct isl_task_pool *pool;
+
+	pthread_t thread;
+	int running;
+};
+
+/* Return the next task of "pool" that has not been handed out yet,
+ * or -1 if all tasks have been handed out.
+ */
+static int next_task(struct isl_task_pool *pool)
+{
+	int task = -1;
+
+	pthread_mutex_lock(&pool->lock);
+	if (pool->next < pool->n_task)
+		task = pool->next++;
+	pthread_mutex_unlock(&pool->lock);
+
+	return task;
+}
+
+/* Keep executing tasks from the pool of "worker" until
+ * all of them have been handed out.
+ * Since each task is handed out only once, the elements of pool->done
+ * are each written by at most one thread.
+ */
+static void *worker_run(void *user)
+{
+	struct isl_task_worker *worker = user;
+	struct isl_task_pool *pool = worker->pool;
+	int task;
+
+	while ((task = next_task(pool)) >= 0)
+		if (pool->run(worker->ctx, task, pool->user) >= 0)
+			pool->done[task] = 1;
+
+	return NULL;
+}
+
+/* Execute the tasks in "pool" using up to "n_thread" worker threads,
+ * each working in its own child context of "ctx".
+ * The workers are stored in "workers", which has room for "n_thread"
+ * elements, such that the child contexts can be freed by the caller
+ * after it has collected the results.
+ *
+ * The tasks are handed out one at a time to the first worker
+ * that asks for one, such that workers that finish their tasks
+ * early take over the remaining work.
+ * The child contexts are allocated by the calling thread
+ * since this updates the parent context.
+ * Any task that failed or that was never handed out because
+ * no thread could be started is left for the caller.
+ */
+static void run_threads(isl_ctx *ctx, struct isl_task_pool *pool,
+	struct isl_task_worker *workers, int n_thread)
+{
+	int k;
+
+	if (pthread_mutex_init(&pool->lock, NULL) != 0)
+		return;
+	for (k = 0; k < n_thread; ++k) {
+		struct isl_task_worker *worker = &workers[k];
+
+		worker->ctx = isl_ctx_alloc_child(ctx);
+		if (!worker->ctx)
+			continue;
+		worker->pool = pool;
+		if (pthread_create(&worker->thread, NULL,
+					&worker_run, worker) == 0)
+			worker->running = 1;
+	}
+	for (k = 0; k < n_thread; ++k)
+		if (workers[k].running)
+			pthread_join(workers[k].thread, NULL);
+	pthread_mutex_destroy(&pool->lock);
+}
+
+/* Free the child contexts of the "n_thread" workers in "workers"
+ * as well as "workers" itself.
+ * The statistics collected in the child contexts are first added
+ * to those of their parent "ctx" such that the work performed
+ * by the workers is accounted for in "ctx".
+ */
+static void free_workers(isl_ctx *ctx, struct isl_task_worker *workers,
+	int n_thread)
+{
+	int k;
+
+	if (!workers)
+		return;
+	for (k = 0; k < n_thread; ++k) {
+		isl_ctx_add_stats(ctx, workers[k].ctx);
+		isl_ctx_free(workers[k].ctx);
+	}
+	free(workers);
+}
+
+#else
+
+struct isl_task_worker;
+
+static void free_workers(isl_ctx *ctx, struct isl_task_worker *workers,
+	int n_thread)
+{
+}
+
+#endif
+
+/* Execute the "n_task" tasks, numbered from 0 to "n_task" - 1,
+ * by calling "run" on each of them, using up to "n_thread" threads and
+ * combine the results by calling "merge" on each of them
+ * in the calling thread, in order.
+ *
+ * If more than one thread is requested (and isl has been built
+ * with support for POSIX threads), then the tasks are distributed
+ * over a pool of worker threads, each working in its own child context
+ * of "ctx", which is passed to "run".
+ * "run" should store its result in a place that depends on the task,
+ * in the context that is passed to "run".
+ * Once all workers have finished, "merge" is called on each task,
+ * in order, while the child contexts are still alive,
+ * such that it can copy the results to "ctx" and release the originals.
+ * A task that was not executed successfully by any worker
+ * is executed by the calling thread in "ctx" right before
+ * "merge" is called on it.
+ * The result therefore does not depend on the number of threads,
+ * and if only a single thread is requested, then
+ * the tasks are simply executed and merged one after the other.
+ *
+ * If an error occurs, then the remaining tasks are not executed
+ * by the calling thread, but "merge" is still called
+ * on the tasks that were executed by the workers,
+ * such that their results can be released.
+ */
+isl_stat isl_ctx_run_tasks(isl_ctx *ctx, int n_task, int n_thread,
+	isl_stat (*run)(isl_ctx *ctx, int task, void *user),
+	isl_stat (*merge)(isl_ctx *ctx, int task, void *user), void *user)
+{
+	int k;
+	struct isl_task_pool pool = { n_task, run, user };
+	struct isl_task_worker *workers = NULL;
+	isl_stat r = isl_stat_ok;
+
+	if (!ctx)
+		return isl_stat_error;
+	if (n_thread > n_task)
+		n_thread = n_task;
+
+	pool.done = isl_calloc_array(ctx, char, n_task);
+	if (n_task && !pool.done)
+		return isl_stat_error;
+#ifdef HAVE_PTHREAD
+	if (n_thread > 1) {
+		workers = isl_calloc_array(ctx, struct isl_task_worker,
+					n_thread);
+		if (workers)
+			run_threads(ctx, &pool, workers, n_thread);
+	}
+#endif
+
+	for (k = 0; k < n_task; ++k) {
+		if (r >= 0 && !pool.done[k]) {
+			r = run(ctx, k, user);
+			if (r >= 0)
+				pool.done[k] = 1;
+		}
+		if (pool.done[k] && merge(ctx, k, user) < 0)
+			r = isl_stat_error;
+	}
+
+	free_workers(ctx, workers, n_thread);
+	free(pool.done);
+
+	return r;
+}
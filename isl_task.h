@@ -0,0 +1,12 @@
+#ifndef ISL_TASK_H
+#define ISL_TASK_H
+
+#include <isl/ctx.h>
+
+int isl_ctx_get_n_thread(isl_ctx *ctx, int n_thread);
+
+isl_stat isl_ctx_run_tasks(isl_ctx *ctx, int n_task, int n_thread,
+	isl_stat (*run)(isl_ctx *ctx, int task, void *user),
+	isl_stat (*merge)(isl_ctx *ctx, int task, void *user), void *user);
+
+#endif
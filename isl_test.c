@@ -18,20 +18,30 @@
 #include <assert.h>
 #include <stdio.h>
 #include <limits.h>
+#include <string.h>
+#include <unistd.h>
 #include <isl_ctx_private.h>
+#include <isl_seq.h>
 #include <isl_map_private.h>
+#include <isl_lp_private.h>
+#include <isl_vec_private.h>
 #include <isl_aff_private.h>
+#include <isl_mat_private.h>
 #include <isl_space_private.h>
 #include <isl/id.h>
+#include <isl/id_to_id.h>
 #include <isl/set.h>
 #include <isl/flow.h>
+#include <isl/gist_context.h>
 #include <isl_constraint_private.h>
 #include <isl/polynomial.h>
 #include <isl/union_set.h>
 #include <isl/union_map.h>
 #include <isl_factorization.h>
+#include <isl_sample.h>
 #include <isl/schedule.h>
 #include <isl/schedule_node.h>
+#include <isl/stream.h>
 #include <isl_options_private.h>
 #include <isl_vertices_private.h>
 #include <isl/ast_build.h>
@@ -442,8 +452,160 @@ struct {
 	  "{ [x, floor(x/4)] }" },
 	{ "{ [10//4] }",
 	  "{ [2] }" },
+	{ "{ [x] -> [y] : EXISTS (e : x = 2e) AND y = FLOOR(x/4) Or "
+	    "Not (x >= 0) AND y = x MOD 3 }",
+	  "{ [x] -> [y] : exists (e : x = 2e) and y = floor(x/4) or "
+	    "not (x >= 0) and y = x mod 3 }" },
+	{ "{ [ands, mi, floors, ceil_, nan2] : ands = mi and "
+	    "floors = ceil_ and nan2 = 0 }",
+	  "{ [a, b, c, d, 0] : a = b and c = d }" },
 };
 
+/* Inputs for test_parse_union_map_foreach,
+ * along with the number of maps that are expected to be passed
+ * to the callback.
+ */
+static struct {
+	const char *str;
+	int n;
+} parse_union_map_foreach_tests[] = {
+	{ "{ }", 0 },
+	{ "[n] -> { A[i] -> B[i] : i < n }", 1 },
+	{ "[n] -> { A[i] -> B[i] : i < n; A[i] -> B[i + 1] : i > n; "
+	    "C[] -> D[]; A[i] -> B[0] }", 3 },
+	{ "{ [i] -> [j] : j = i mod 2; [i] -> [j, k] : j = k; }", 2 },
+};
+
+/* Data used in collect_map.
+ * "umap" collects the maps that have been passed to the callback and
+ * "n" counts them.
+ */
+struct collect_map_data {
+	isl_union_map *umap;
+	int n;
+};
+
+/* Add "map" to data->umap.
+ */
+static isl_stat collect_map(__isl_take isl_map *map, void *user)
+{
+	struct collect_map_data *data = user;
+
+	data->n++;
+	data->umap = isl_union_map_union(data->umap,
+					isl_union_map_from_map(map));
+	return isl_stat_non_null(data->umap);
+}
+
+/* Check that isl_stream_read_union_map_foreach passes
+ * the expected number of maps to the callback and that
+ * these maps together form the same union map as the one
+ * returned by isl_union_map_read_from_str.
+ */
+static int test_parse_union_map_foreach(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(parse_union_map_foreach_tests); ++i) {
+		const char *str = parse_union_map_foreach_tests[i].str;
+		struct collect_map_data data;
+		isl_union_map *umap;
+		isl_stream *s;
+		isl_stat r;
+		isl_bool equal;
+
+		umap = isl_union_map_read_from_str(ctx, str);
+		data.umap = isl_union_map_empty(isl_union_map_get_space(umap));
+		data.n = 0;
+		s = isl_stream_new_str(ctx, str);
+		r = isl_stream_read_union_map_foreach(s, &collect_map, &data);
+		isl_stream_free(s);
+		equal = r < 0 ? isl_bool_error :
+				isl_union_map_is_equal(umap, data.umap);
+		isl_union_map_free(umap);
+		isl_union_map_free(data.umap);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"union maps not equal", return -1);
+		if (data.n != parse_union_map_foreach_tests[i].n)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected number of maps", return -1);
+	}
+
+	return 0;
+}
+
+/* Print a tuple with the "n" variables "prefix"0 up to "prefix"(n-1)
+ * to "p", in reverse order if "reverse" is set.
+ */
+static __isl_give isl_printer *print_named_tuple(__isl_take isl_printer *p,
+	const char *prefix, int n, int reverse)
+{
+	int i;
+
+	p = isl_printer_print_str(p, "[");
+	for (i = 0; i < n; ++i) {
+		if (i)
+			p = isl_printer_print_str(p, ", ");
+		p = isl_printer_print_str(p, prefix);
+		p = isl_printer_print_int(p, reverse ? n - 1 - i : i);
+	}
+	p = isl_printer_print_str(p, "]");
+	return p;
+}
+
+/* Print a disjunct mapping a tuple of "n" variables "prefix"i
+ * to the same variables in reverse order (if "reverse" is set)
+ * or in the same order (if "reverse" is not set) to "p".
+ */
+static __isl_give isl_printer *print_named_disjunct(__isl_take isl_printer *p,
+	const char *prefix, int n, int reverse)
+{
+	p = print_named_tuple(p, prefix, n, 0);
+	p = isl_printer_print_str(p, " -> ");
+	p = print_named_tuple(p, prefix, n, reverse);
+	return p;
+}
+
+/* Check that a map with many named variables is parsed correctly.
+ * The variables of the first disjunct are removed at the end
+ * of that disjunct, after which the same names are introduced again
+ * in the second disjunct.
+ */
+static int test_parse_many_names(isl_ctx *ctx)
+{
+	int n = 200;
+	isl_printer *p;
+	char *str1, *str2;
+	int r;
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_print_str(p, "{ ");
+	p = print_named_disjunct(p, "x", n, 1);
+	p = isl_printer_print_str(p, "; ");
+	p = print_named_disjunct(p, "x", n, 0);
+	p = isl_printer_print_str(p, " }");
+	str1 = isl_printer_get_str(p);
+	isl_printer_free(p);
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_print_str(p, "{ ");
+	p = print_named_disjunct(p, "a", n, 1);
+	p = isl_printer_print_str(p, "; ");
+	p = print_named_disjunct(p, "b", n, 0);
+	p = isl_printer_print_str(p, " }");
+	str2 = isl_printer_get_str(p);
+	isl_printer_free(p);
+
+	r = str1 && str2 ? test_parse_map_equal(ctx, str1, str2) : -1;
+	free(str1);
+	free(str2);
+
+	return r;
+}
+
 int test_parse(struct isl_ctx *ctx)
 {
 	int i;
@@ -462,6 +624,10 @@ int test_parse(struct isl_ctx *ctx)
 		return -1;
 	if (test_parse_upma(ctx) < 0)
 		return -1;
+	if (test_parse_union_map_foreach(ctx) < 0)
+		return -1;
+	if (test_parse_many_names(ctx) < 0)
+		return -1;
 
 	str = "{ [i] -> [-i] }";
 	map = isl_map_read_from_str(ctx, str);
@@ -545,6 +711,64 @@ static int test_read(isl_ctx *ctx)
 	return 0;
 }
 
+/* Pairs of sets, where the estimated cost of the first
+ * is expected to be smaller than that of the second.
+ */
+static struct {
+	const char *cheap;
+	const char *expensive;
+} estimate_cost_tests[] = {
+	{ "{ [i] : 0 <= i <= 10 }", "{ [i, j] : 0 <= i, j <= 10 }" },
+	{ "{ [i] : 0 <= i <= 10 }", "{ [i] : 0 <= i <= 10 or 20 <= i <= 30 }" },
+	{ "{ [i] : 0 <= i <= 10 }",
+	  "{ [i] : 0 <= i <= 100000000000000000000000 }" },
+	{ "{ [i] : 0 <= i <= 10 }", "{ [i] : 0 <= i <= 10 and i mod 3 = 0 }" },
+	{ "{ [i] : 0 <= i <= 10 or 20 <= i <= 30 }",
+	  "{ [i] : 0 <= i <= 10 or 20 <= i <= 30 or 40 <= i <= 50 }" },
+};
+
+/* Check that the estimated costs of the sets in estimate_cost_tests
+ * are ordered as expected and that the estimate of a union set
+ * is the sum of the estimates of its sets.
+ */
+static int test_estimate_cost(isl_ctx *ctx)
+{
+	int i;
+	double c1, c2;
+	isl_set *set1, *set2;
+	isl_union_set *uset;
+
+	for (i = 0; i < ARRAY_SIZE(estimate_cost_tests); ++i) {
+		set1 = isl_set_read_from_str(ctx, estimate_cost_tests[i].cheap);
+		set2 = isl_set_read_from_str(ctx,
+					estimate_cost_tests[i].expensive);
+		c1 = isl_set_estimate_cost(set1);
+		c2 = isl_set_estimate_cost(set2);
+		isl_set_free(set1);
+		isl_set_free(set2);
+		if (c1 < 0 || c2 < 0)
+			return -1;
+		if (c1 >= c2)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected cost estimate", return -1);
+	}
+
+	set1 = isl_set_read_from_str(ctx, "{ A[i] : 0 <= i <= 10 }");
+	set2 = isl_set_read_from_str(ctx, "{ B[i, j] : 0 <= i, j <= 10 }");
+	c1 = isl_set_estimate_cost(set1) + isl_set_estimate_cost(set2);
+	uset = isl_union_set_from_set(set1);
+	uset = isl_union_set_add_set(uset, set2);
+	c2 = isl_union_set_estimate_cost(uset);
+	isl_union_set_free(uset);
+	if (c1 < 0 || c2 < 0)
+		return -1;
+	if (c1 != c2)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected cost estimate", return -1);
+
+	return 0;
+}
+
 static int test_bounded(isl_ctx *ctx)
 {
 	isl_set *set;
@@ -692,6 +916,25 @@ static int test_dim(isl_ctx *ctx)
 	isl_map_free(map1);
 	isl_map_free(map2);
 
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result", return -1);
+
+	str = "[n] -> { [i, j] -> [k] : 0 <= i < n and k = 2j; "
+	    "[i, j] -> [k] : exists a : i = 3a and 0 <= j < k }";
+	map1 = isl_map_read_from_str(ctx, str);
+	map1 = isl_map_insert_dims(map1, isl_dim_in, 1, 2);
+	map1 = isl_map_move_dims(map1, isl_dim_out, 1, isl_dim_in, 0, 1);
+	map1 = isl_map_move_dims(map1, isl_dim_in, 0, isl_dim_param, 0, 1);
+	str = "{ [n, x, y, j] -> [k, i] : 0 <= i < n and k = 2j; "
+	    "[n, x, y, j] -> [k, i] : exists a : i = 3a and 0 <= j < k }";
+	map2 = isl_map_read_from_str(ctx, str);
+	equal = isl_map_is_equal(map1, map2);
+	isl_map_free(map1);
+	isl_map_free(map2);
+
 	if (equal < 0)
 		return -1;
 	if (!equal)
@@ -913,12 +1156,23 @@ struct {
 	{ "infty", 'M', "-infty", "infty" },
 };
 
+/* Is "v1" equal to "v2", treating NaN as being equal to itself?
+ */
+static isl_bool val_is_same(__isl_keep isl_val *v1, __isl_keep isl_val *v2)
+{
+	if (isl_val_is_nan(v2))
+		return isl_val_is_nan(v1);
+	return isl_val_eq(v1, v2);
+}
+
 /* Perform some basic tests of binary operations on isl_val objects.
+ * The first argument is also kept alive during the operation
+ * to check that a shared argument is not modified.
  */
 static int test_bin_val(isl_ctx *ctx)
 {
 	int i;
-	isl_val *v1, *v2, *res;
+	isl_val *v1, *v2, *res, *arg1;
 	__isl_give isl_val *(*fn)(__isl_take isl_val *v1,
 				__isl_take isl_val *v2);
 	int ok;
@@ -927,14 +1181,18 @@ static int test_bin_val(isl_ctx *ctx)
 		v1 = isl_val_read_from_str(ctx, val_bin_tests[i].arg1);
 		v2 = isl_val_read_from_str(ctx, val_bin_tests[i].arg2);
 		res = isl_val_read_from_str(ctx, val_bin_tests[i].res);
+		arg1 = isl_val_copy(v1);
 		fn = val_bin_op[val_bin_tests[i].op].fn;
 		v1 = fn(v1, v2);
-		if (isl_val_is_nan(res))
-			ok = isl_val_is_nan(v1);
-		else
-			ok = isl_val_eq(v1, res);
+		ok = val_is_same(v1, res);
 		isl_val_free(v1);
 		isl_val_free(res);
+		if (ok == isl_bool_true) {
+			v1 = isl_val_read_from_str(ctx, val_bin_tests[i].arg1);
+			ok = val_is_same(arg1, v1);
+			isl_val_free(v1);
+		}
+		isl_val_free(arg1);
 		if (ok < 0)
 			return -1;
 		if (!ok)
@@ -988,6 +1246,62 @@ static int test_elimination(isl_ctx *ctx)
 	return 0;
 }
 
+/* Check that the number of divs of "bset" is equal to *(isl_size *) user.
+ */
+static isl_stat check_n_div(__isl_take isl_basic_set *bset, void *user)
+{
+	isl_size *expected = user;
+	isl_ctx *ctx;
+	isl_size n;
+
+	ctx = isl_basic_set_get_ctx(bset);
+	n = isl_basic_set_dim(bset, isl_dim_div);
+	isl_basic_set_free(bset);
+	if (n < 0)
+		return isl_stat_error;
+	if (n != *expected)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected number of divs", return isl_stat_error);
+	return isl_stat_ok;
+}
+
+/* Check that aligning the divs of a set with disjuncts that share
+ * a large number of divs, but in different orders, recognizes
+ * all common divs, such that no extra divs get added and
+ * that the set itself is not modified.
+ */
+static isl_stat test_align_divs(isl_ctx *ctx)
+{
+	const char *str;
+	isl_set *set, *aligned;
+	isl_size n = 9;
+	isl_bool equal;
+
+	str = "{ [i] : 0 <= i <= 1000 and "
+		"2 * floor(i/2) + 3 * floor(i/3) + 4 * floor(i/4) + "
+		"5 * floor(i/5) + 6 * floor(i/6) + 7 * floor(i/7) + "
+		"8 * floor(i/8) + 9 * floor(i/9) + 10 * floor(i/10) >= i; "
+		"[i] : 2000 <= i <= 3000 and "
+		"10 * floor(i/10) + 9 * floor(i/9) + 8 * floor(i/8) + "
+		"7 * floor(i/7) + 6 * floor(i/6) + 5 * floor(i/5) + "
+		"4 * floor(i/4) + 3 * floor(i/3) + 2 * floor(i/2) <= 5i }";
+	set = isl_set_read_from_str(ctx, str);
+	aligned = isl_map_align_divs_internal(isl_set_copy(set));
+	if (isl_set_foreach_basic_set(aligned, &check_n_div, &n) < 0)
+		equal = isl_bool_error;
+	else
+		equal = isl_set_is_equal(set, aligned);
+	isl_set_free(set);
+	isl_set_free(aligned);
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"aligning divs changed set", return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
 static int test_div(isl_ctx *ctx)
 {
 	const char *str;
@@ -1243,6 +1557,9 @@ static int test_div(isl_ctx *ctx)
 	if (test_elimination(ctx) < 0)
 		return -1;
 
+	if (test_align_divs(ctx) < 0)
+		return -1;
+
 	str = "{ [i,j,k] : 3 + i + 2j >= 0 and 2 * [(i+2j)/4] <= k }";
 	set = isl_set_read_from_str(ctx, str);
 	set = isl_set_remove_divs_involving_dims(set, isl_dim_set, 0, 2);
@@ -1362,6 +1679,182 @@ static int test_recession_cone(struct isl_ctx *ctx)
 	return 0;
 }
 
+/* Basic maps with two variables, integer points (i, j)
+ * that are passed as samples to
+ * isl_basic_map_detect_equalities_with_samples and
+ * the expected affine hull.
+ * Some of the samples do not belong to the basic map.
+ */
+struct {
+	const char *map;
+	int n;
+	int sample[4][2];
+	const char *hull;
+} affine_hull_samples_tests[] = {
+	{ "{ [i] -> [j] : 0 <= i, j <= 10 }", 3,
+	  { { 0, 0 }, { 1, 0 }, { 0, 1 } }, "{ [i] -> [j] }" },
+	{ "{ [i] -> [j] : 0 <= i <= 10 and j = 2 }", 2,
+	  { { 3, 2 }, { 3, 3 } }, "{ [i] -> [2] }" },
+	{ "{ [i] -> [j] : 0 <= i <= 10 and i = j }", 4,
+	  { { 0, 0 }, { 5, 5 }, { 1, 0 }, { 11, 11 } }, "{ [i] -> [i] }" },
+	{ "{ [i] -> [j] : 0 <= i and 2i <= 1 and j >= 0 }", 2,
+	  { { 0, 7 }, { 1, 7 } }, "{ [0] -> [j] }" },
+	{ "{ [i] -> [j] : 0 <= i and i + j <= 0 and 3j >= -1 }", 1,
+	  { { 1, -1 } }, "{ [0] -> [0] }" },
+};
+
+/* Check that isl_basic_map_detect_equalities_with_samples
+ * produces the expected results, irrespective of whether
+ * the samples belong to the input.
+ */
+static isl_stat test_affine_hull_samples(isl_ctx *ctx)
+{
+	int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(affine_hull_samples_tests); ++i) {
+		isl_basic_map *bmap, *expected;
+		isl_mat *samples;
+		isl_bool equal;
+
+		samples = isl_mat_alloc(ctx, affine_hull_samples_tests[i].n, 3);
+		for (j = 0; j < affine_hull_samples_tests[i].n; ++j) {
+			samples = isl_mat_set_element_si(samples, j, 0, 1);
+			samples = isl_mat_set_element_si(samples, j, 1,
+				affine_hull_samples_tests[i].sample[j][0]);
+			samples = isl_mat_set_element_si(samples, j, 2,
+				affine_hull_samples_tests[i].sample[j][1]);
+		}
+		bmap = isl_basic_map_read_from_str(ctx,
+					affine_hull_samples_tests[i].map);
+		bmap = isl_basic_map_detect_equalities_with_samples(bmap,
+								    samples);
+		bmap = isl_basic_map_plain_affine_hull(bmap);
+		expected = isl_basic_map_read_from_str(ctx,
+					affine_hull_samples_tests[i].hull);
+		equal = isl_basic_map_is_equal(bmap, expected);
+		isl_basic_map_free(bmap);
+		isl_basic_map_free(expected);
+		isl_mat_free(samples);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown, "unexpected hull",
+				return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
+/* Basic sets and the number of equality constraints
+ * that isl_basic_set_implicit_equalities should detect in them.
+ */
+static struct {
+	const char *set;
+	int n_eq;
+} implicit_equalities_tests[] = {
+	{ "{ [x, y] : x >= 0 and y >= 1 and x + y <= 1 }", 2 },
+	{ "{ [x, y] : x >= 0 and y >= 0 and x <= 10 }", 0 },
+	{ "{ [x, y] : 0 <= x <= y and y <= x }", 1 },
+	{ "{ [x, y, z] : x >= 0 and y >= 0 and z >= 0 and x + y <= 0 }", 2 },
+	{ "{ [x, y] : x >= 0 and y >= 0 and 3x + 2y <= 1 }", 2 },
+	{ "{ rat: [x, y] : x >= 0 and y >= 0 and 3x + 2y <= 1 }", 0 },
+	{ "{ [x, y] : x >= 0 and y >= 0 and 3x + 2y <= 1 and y <= 5 }", 2 },
+	{ "{ [x, y, z] : x >= 0 and y >= 0 and z >= y and "
+			"x + y <= 2 and 2x + 3y <= 2 }", 1 },
+};
+
+/* Check that isl_basic_set_implicit_equalities detects
+ * the expected number of equality constraints in a few basic sets
+ * and that it does not change the sets.
+ */
+static int test_implicit_equalities(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(implicit_equalities_tests); ++i) {
+		const char *str;
+		isl_basic_set *bset, *res;
+		isl_size n_eq;
+		isl_bool equal;
+
+		str = implicit_equalities_tests[i].set;
+		bset = isl_basic_set_read_from_str(ctx, str);
+		res = isl_basic_set_implicit_equalities(
+						isl_basic_set_copy(bset));
+		n_eq = isl_basic_set_n_equality(res);
+		equal = isl_basic_set_is_equal(bset, res);
+		isl_basic_set_free(bset);
+		isl_basic_set_free(res);
+		if (n_eq < 0 || equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"set changed by equality detection",
+				return -1);
+		if (n_eq != implicit_equalities_tests[i].n_eq)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected number of equalities", return -1);
+	}
+
+	return 0;
+}
+
+/* Basic sets and the number of inequality constraints
+ * that remain after isl_basic_set_remove_redundancies.
+ */
+static struct {
+	const char *set;
+	int n_ineq;
+} redundancies_tests[] = {
+	{ "{ [x, y] : x >= 0 and y >= 0 and x + y >= 0 }", 2 },
+	{ "{ [x, y] : 0 <= x <= 10 and 0 <= y <= 10 and x + y <= 30 }", 4 },
+	{ "{ [x, y] : 0 <= x <= 10 and 0 <= y <= 10 and x + y <= 15 }", 5 },
+	{ "{ [x, y] : 0 <= x <= 10 and 0 <= y <= 10 and 2x + 3y <= 50 and "
+			"x - y <= 10 }", 4 },
+	{ "{ [x, y] : x >= 0 and y >= 0 and 2x + y >= 1 and x + 2y >= 1 and "
+			"3x + 3y >= 2 }", 3 },
+	{ "{ rat: [x, y] : x >= 0 and y >= 0 and 2x + y >= 1 and "
+			"x + 2y >= 1 and 3x + 3y >= 2 }", 4 },
+	{ "{ [x, y, z] : 0 <= x <= y <= z <= 10 and x <= z and z >= 0 }", 4 },
+};
+
+/* Check that isl_basic_set_remove_redundancies removes
+ * the expected number of inequality constraints from a few basic sets
+ * and that it does not change the sets.
+ */
+static int test_redundancies(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(redundancies_tests); ++i) {
+		const char *str;
+		isl_basic_set *bset, *res;
+		isl_size n_ineq;
+		isl_bool equal;
+
+		str = redundancies_tests[i].set;
+		bset = isl_basic_set_read_from_str(ctx, str);
+		res = isl_basic_set_remove_redundancies(
+						isl_basic_set_copy(bset));
+		n_ineq = isl_basic_set_n_inequality(res);
+		equal = isl_basic_set_is_equal(bset, res);
+		isl_basic_set_free(bset);
+		isl_basic_set_free(res);
+		if (n_ineq < 0 || equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"set changed by redundancy removal",
+				return -1);
+		if (n_ineq != redundancies_tests[i].n_ineq)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected number of inequalities",
+				return -1);
+	}
+
+	return 0;
+}
+
 int test_affine_hull(struct isl_ctx *ctx)
 {
 	const char *str;
@@ -1415,6 +1908,9 @@ int test_affine_hull(struct isl_ctx *ctx)
 		isl_die(ctx, isl_error_unknown, "not as accurate as expected",
 			return -1);
 
+	if (test_affine_hull_samples(ctx) < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -1500,6 +1996,102 @@ static int test_various_simple_hull(isl_ctx *ctx)
 	return 0;
 }
 
+/* Rename the range tuple of "map".
+ */
+static __isl_give isl_map *rename_range(__isl_take isl_map *map)
+{
+	return isl_map_set_tuple_name(map, isl_dim_out, "C");
+}
+
+/* Align the parameters of "map" to a space with an extra parameter.
+ */
+static __isl_give isl_map *align_extra_param(__isl_take isl_map *map)
+{
+	isl_space *space;
+
+	space = isl_space_params_alloc(isl_map_get_ctx(map), 2);
+	space = isl_space_set_dim_name(space, isl_dim_param, 0, "m");
+	space = isl_space_set_dim_name(space, isl_dim_param, 1, "n");
+	return isl_map_align_params(map, space);
+}
+
+/* Move the parameter of "map" to the domain.
+ */
+static __isl_give isl_map *move_param_to_domain(__isl_take isl_map *map)
+{
+	return isl_map_move_dims(map, isl_dim_in, 0, isl_dim_param, 0, 1);
+}
+
+/* Transformations that preserve the cached simple hulls of a map.
+ */
+static __isl_give isl_map *(*simple_hull_cache_tests[])(
+	__isl_take isl_map *map) = {
+	&rename_range,
+	&isl_map_reset_user,
+	&align_extra_param,
+	&move_param_to_domain,
+};
+
+/* Check that the simple hull of a map that is cached in the map
+ * is preserved by each transformation in simple_hull_cache_tests and
+ * that it is the same as the simple hull computed from scratch.
+ * The result computed from scratch is obtained
+ * from a copy of the transformed map that is read back from a string.
+ */
+static isl_stat test_simple_hull_cache(isl_ctx *ctx)
+{
+	int i;
+	const char *str;
+	isl_map *map;
+	isl_basic_map *hull;
+
+	str = "[n] -> { A[i] -> B[i + 1] : 0 <= i <= n; "
+			"A[i] -> B[i] : n <= i <= 2n }";
+	map = isl_map_read_from_str(ctx, str);
+	hull = isl_map_simple_hull(isl_map_copy(map));
+	isl_basic_map_free(hull);
+
+	for (i = 0; i < ARRAY_SIZE(simple_hull_cache_tests); ++i) {
+		struct isl_stats stats;
+		isl_basic_map *expected;
+		isl_map *copy;
+		isl_bool equal;
+		char *s;
+
+		map = simple_hull_cache_tests[i](map);
+		s = isl_map_to_str(map);
+		copy = isl_map_read_from_str(ctx, s);
+		free(s);
+		isl_ctx_reset_stats(ctx);
+		hull = isl_map_simple_hull(isl_map_copy(map));
+		if (isl_ctx_get_stats(ctx, &stats) < 0)
+			hull = isl_basic_map_free(hull);
+		expected = isl_map_simple_hull(copy);
+		equal = isl_basic_map_is_equal(hull, expected);
+		isl_basic_map_free(hull);
+		isl_basic_map_free(expected);
+		if (equal < 0) {
+			isl_map_free(map);
+			return isl_stat_error;
+		}
+		if (stats.simple_hull_cache_hits != 1) {
+			isl_map_free(map);
+			isl_die(ctx, isl_error_unknown,
+				"cached simple hull not reused",
+				return isl_stat_error);
+		}
+		if (!equal) {
+			isl_map_free(map);
+			isl_die(ctx, isl_error_unknown,
+				"unexpected cached simple hull",
+				return isl_stat_error);
+		}
+	}
+	isl_map_free(map);
+
+	return isl_stat_ok;
+}
+
 static int test_simple_hull(struct isl_ctx *ctx)
 {
 	const char *str;
@@ -1525,6 +2117,8 @@ static int test_simple_hull(struct isl_ctx *ctx)
 		return -1;
 	if (test_various_simple_hull(ctx) < 0)
 		return -1;
+	if (test_simple_hull_cache(ctx) < 0)
+		return -1;
 
 	return 0;
 }
@@ -1552,15 +2146,122 @@ static struct {
 	  "[N] -> { [N] }", "{ [9] }" },
 };
 
-/* Perform basic isl_set_get_simple_fixed_box_hull tests.
+/* Check that "box1" and "box2" are either both invalid or
+ * have the same offset and size.
  */
-static int test_box_hull(struct isl_ctx *ctx)
+static isl_stat check_box_equal(__isl_keep isl_fixed_box *box1,
+	__isl_keep isl_fixed_box *box2)
 {
-	int i;
+	isl_bool valid1, valid2, equal;
+	isl_multi_aff *offset1, *offset2;
+	isl_multi_val *size1, *size2;
 
-	for (i = 0; i < ARRAY_SIZE(box_hull_tests); ++i) {
-		const char *str;
-		isl_stat r;
+	valid1 = isl_fixed_box_is_valid(box1);
+	valid2 = isl_fixed_box_is_valid(box2);
+	if (valid1 < 0 || valid2 < 0)
+		return isl_stat_error;
+	if (valid1 != valid2)
+		isl_die(isl_fixed_box_get_ctx(box1), isl_error_unknown,
+			"boxes differ in validity", return isl_stat_error);
+	if (!valid1)
+		return isl_stat_ok;
+
+	offset1 = isl_fixed_box_get_offset(box1);
+	offset2 = isl_fixed_box_get_offset(box2);
+	equal = isl_multi_aff_plain_is_equal(offset1, offset2);
+	isl_multi_aff_free(offset1);
+	isl_multi_aff_free(offset2);
+	if (equal >= 0 && equal) {
+		size1 = isl_fixed_box_get_size(box1);
+		size2 = isl_fixed_box_get_size(box2);
+		equal = isl_multi_val_plain_is_equal(size1, size2);
+		isl_multi_val_free(size1);
+		isl_multi_val_free(size2);
+	}
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(isl_fixed_box_get_ctx(box1), isl_error_unknown,
+			"boxes not equal", return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Check that the boxes computed by
+ * isl_union_map_get_range_simple_fixed_box_hull_list on "umap"
+ * are the same as those computed on the individual maps,
+ * using "n_thread" as the value of the union_map_threads option.
+ */
+static isl_stat check_union_box_hull(__isl_keep isl_union_map *umap,
+	int n_thread)
+{
+	int i;
+	isl_ctx *ctx;
+	isl_size n;
+	isl_map_list *maps;
+	isl_fixed_box_list *boxes;
+	int saved;
+	isl_stat r = isl_stat_ok;
+
+	ctx = isl_union_map_get_ctx(umap);
+	saved = isl_options_get_union_map_threads(ctx);
+	isl_options_set_union_map_threads(ctx, n_thread);
+	boxes = isl_union_map_get_range_simple_fixed_box_hull_list(umap);
+	isl_options_set_union_map_threads(ctx, saved);
+	maps = isl_union_map_get_map_list(umap);
+	n = isl_map_list_size(maps);
+	if (n < 0 || isl_fixed_box_list_size(boxes) != n)
+		r = isl_stat_error;
+	for (i = 0; r >= 0 && i < n; ++i) {
+		isl_map *map;
+		isl_fixed_box *box1, *box2;
+
+		map = isl_map_list_get_at(maps, i);
+		box1 = isl_map_get_range_simple_fixed_box_hull(map);
+		box2 = isl_fixed_box_list_get_at(boxes, i);
+		r = check_box_equal(box1, box2);
+		isl_fixed_box_free(box1);
+		isl_fixed_box_free(box2);
+		isl_map_free(map);
+	}
+	isl_map_list_free(maps);
+	isl_fixed_box_list_free(boxes);
+
+	return r;
+}
+
+/* Perform some isl_union_map_get_range_simple_fixed_box_hull_list tests,
+ * both with and without threads.
+ * One of the maps does not have a fixed box hull.
+ */
+static isl_stat test_union_box_hull(isl_ctx *ctx)
+{
+	const char *str;
+	isl_union_map *umap;
+	isl_stat r;
+
+	str = "[N] -> { T[t] -> A[a] : 32t <= a < 32t + 32; "
+		"T[t] -> B[b, c] : 0 <= b - t < 4 and N <= c <= N + 7; "
+		"T[t] -> C[c] : 0 <= c <= t; "
+		"T[t] -> D[d] : exists (e: d = 2e and 0 <= d - 4t < 8) }";
+	umap = isl_union_map_read_from_str(ctx, str);
+	r = check_union_box_hull(umap, 0);
+	if (r >= 0)
+		r = check_union_box_hull(umap, 2);
+	isl_union_map_free(umap);
+
+	return r;
+}
+
+/* Perform basic isl_set_get_simple_fixed_box_hull tests.
+ */
+static int test_box_hull(struct isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(box_hull_tests); ++i) {
+		const char *str;
+		isl_stat r;
 		isl_set *set;
 		isl_multi_aff *offset;
 		isl_multi_val *size;
@@ -1583,6 +2284,9 @@ static int test_box_hull(struct isl_ctx *ctx)
 			return -1;
 	}
 
+	if (test_union_box_hull(ctx) < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -1687,12 +2391,71 @@ static int test_convex_hull_algo(isl_ctx *ctx, int convex)
 	return 0;
 }
 
+/* Check that the wrapping based convex hull computation
+ * produces the same results when using several threads.
+ */
+static int test_convex_hull_threads(isl_ctx *ctx)
+{
+	int threads;
+	int r;
+
+	threads = isl_options_get_convex_hull_threads(ctx);
+	isl_options_set_convex_hull_threads(ctx, 3);
+	r = test_convex_hull_algo(ctx, ISL_CONVEX_HULL_WRAP);
+	isl_options_set_convex_hull_threads(ctx, threads);
+
+	return r;
+}
+
+/* Check that setting the convex_hull_max_facets option
+ * results in a superset of the convex hull
+ * described by the requested number of facets.
+ * The convex hull of the input has six facets.
+ */
+static int test_convex_hull_max_facets(isl_ctx *ctx)
+{
+	const char *str;
+	int max_facets;
+	isl_size n;
+	isl_bool subset;
+	isl_set *set;
+	isl_basic_set *hull, *partial;
+
+	str = "{ [0, 0]; [4, 1]; [6, 4]; [5, 7]; [2, 8]; [-1, 5] }";
+	set = isl_set_read_from_str(ctx, str);
+	hull = isl_set_convex_hull(isl_set_copy(set));
+	max_facets = isl_options_get_convex_hull_max_facets(ctx);
+	isl_options_set_convex_hull_max_facets(ctx, 3);
+	partial = isl_set_convex_hull(set);
+	isl_options_set_convex_hull_max_facets(ctx, max_facets);
+
+	n = isl_basic_set_n_inequality(partial);
+	subset = isl_basic_set_is_subset(hull, partial);
+	isl_basic_set_free(hull);
+	isl_basic_set_free(partial);
+	if (n < 0 || subset < 0)
+		return -1;
+	if (n != 3)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected number of facets", return -1);
+	if (!subset)
+		isl_die(ctx, isl_error_unknown,
+			"partial convex hull does not contain convex hull",
+			return -1);
+
+	return 0;
+}
+
 static int test_convex_hull(isl_ctx *ctx)
 {
 	if (test_convex_hull_algo(ctx, ISL_CONVEX_HULL_FM) < 0)
 		return -1;
 	if (test_convex_hull_algo(ctx, ISL_CONVEX_HULL_WRAP) < 0)
 		return -1;
+	if (test_convex_hull_threads(ctx) < 0)
+		return -1;
+	if (test_convex_hull_max_facets(ctx) < 0)
+		return -1;
 	return 0;
 }
 
@@ -1917,8 +2680,128 @@ struct {
 	{ "{ [x,y] : x < 0 and 0 <= y <= 4 or x >= -2 and -x <= y <= 10 + x }",
 	  "{ [x,y] : 1 <= y <= 3 }",
 	  "{ [x,y] }" },
+	{ "{ [x,y] : x + y <= 20 and x >= y and 2x - 3y >= -15 }",
+	  "{ [x,y] : 0 <= x <= 5 and 0 <= y <= 5 }",
+	  "{ [x,y] : x >= y }" },
+	{ "[n] -> { [x] : x <= 2n + 7 and x >= 0 }",
+	  "[n] -> { [x] : 0 <= x <= 5 and n >= 0 }",
+	  "[n] -> { [x] }" },
+};
+
+/* Check that the inequalities in a gist with respect to a context
+ * consisting of bounds on individual variables are removed
+ * without constructing a tableau.
+ */
+static isl_stat test_gist_bounds_stats(isl_ctx *ctx)
+{
+	const char *str;
+	isl_set *set, *context;
+	struct isl_stats stats;
+	isl_bool universe;
+
+	isl_ctx_reset_stats(ctx);
+	str = "[n] -> { [x, y] : x + y <= 20 and x - y <= n + 5 }";
+	set = isl_set_read_from_str(ctx, str);
+	str = "[n] -> { [x, y] : 0 <= x <= 5 and 0 <= y <= 5 and n >= 0 }";
+	context = isl_set_read_from_str(ctx, str);
+	set = isl_set_gist(set, context);
+	universe = isl_set_plain_is_universe(set);
+	isl_set_free(set);
+	if (universe < 0 || isl_ctx_get_stats(ctx, &stats) < 0)
+		return isl_stat_error;
+	if (!universe)
+		isl_die(ctx, isl_error_unknown,
+			"expecting universe gist", return isl_stat_error);
+	if (stats.gist_bounds_decided <= 0 || stats.gist_tab_decided != 0)
+		isl_die(ctx, isl_error_unknown,
+			"expecting gist decided by bounds",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Inputs for isl_pw_aff_gist_prepared tests.
+ * "pa" is the piecewise affine expression and "context" the context.
+ */
+static struct {
+	const char *pa;
+	const char *context;
+} gist_prepared_pw_aff_tests[] = {
+	{ "[n] -> { [x] -> [(x + n)] }", "[n] -> { [x] : x = n }" },
+	{ "[n] -> { [x, y] -> [(x + y)] }", "[n] -> { [x, y] : y = 2x + n }" },
+	{ "{ [x] -> [(x)] : x >= 0; [x] -> [(-x)] : x < 0 }",
+	  "{ [x] : 0 <= x <= 10 }" },
+	{ "{ [x] -> [(floor(x/2))] }", "{ [x] : x = 2 }" },
+	{ "{ [x] -> [(x)] }", "{ [x] : 1 = 0 }" },
+	{ "{ [x] -> [(x)] }", "{ [x] : x = 1 or x = 3 }" },
+	{ "[n] -> { [x] -> [(x)] }", "{ [x] : x = 1 }" },
 };
 
+/* Check that the gist operations with respect to a prepared context
+ * produce the same results as the corresponding plain gist operations.
+ * The context of each of the tests in gist_tests is used
+ * to simplify both the set of the test and, as a second use of
+ * the same prepared context, the set again.
+ */
+static isl_stat test_gist_prepared(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(gist_tests); ++i) {
+		isl_set *set, *context, *expected;
+		isl_gist_context *gc;
+		isl_bool equal;
+		int j;
+
+		context = isl_set_read_from_str(ctx, gist_tests[i].context);
+		expected = isl_set_read_from_str(ctx, gist_tests[i].gist);
+		gc = isl_gist_context_from_set(context);
+		equal = isl_bool_true;
+		for (j = 0; equal == isl_bool_true && j < 2; ++j) {
+			set = isl_set_read_from_str(ctx, gist_tests[i].set);
+			set = isl_set_gist_prepared(set, gc);
+			equal = isl_set_is_equal(set, expected);
+			isl_set_free(set);
+		}
+		isl_gist_context_free(gc);
+		isl_set_free(expected);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"incorrect prepared gist result",
+				return isl_stat_error);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(gist_prepared_pw_aff_tests); ++i) {
+		const char *str;
+		isl_pw_aff *pa, *res;
+		isl_set *context;
+		isl_gist_context *gc;
+		isl_bool equal;
+
+		str = gist_prepared_pw_aff_tests[i].pa;
+		pa = isl_pw_aff_read_from_str(ctx, str);
+		str = gist_prepared_pw_aff_tests[i].context;
+		context = isl_set_read_from_str(ctx, str);
+		gc = isl_gist_context_from_set(isl_set_copy(context));
+		res = isl_pw_aff_gist_prepared(isl_pw_aff_copy(pa), gc);
+		pa = isl_pw_aff_gist(pa, context);
+		equal = isl_pw_aff_plain_is_equal(res, pa);
+		isl_pw_aff_free(res);
+		isl_pw_aff_free(pa);
+		isl_gist_context_free(gc);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"incorrect prepared gist result",
+				return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
 /* Check that isl_set_gist behaves as expected.
  *
  * For the test cases in gist_tests, besides checking that the result
@@ -1970,6 +2853,10 @@ static int test_gist(struct isl_ctx *ctx)
 
 	if (test_gist_fail(ctx) < 0)
 		return -1;
+	if (test_gist_bounds_stats(ctx) < 0)
+		return -1;
+	if (test_gist_prepared(ctx) < 0)
+		return -1;
 
 	str = "[p0, p2, p3, p5, p6, p10] -> { [] : "
 	    "exists (e0 = [(15 + p0 + 15p6 + 15p10)/16], e1 = [(p5)/8], "
@@ -2379,6 +3266,11 @@ struct {
 	{ 1, "{ [a] : (a = 0 or ((1 + a) mod 2 = 0 and 0 < a <= 15) or "
 		"((a) mod 2 = 0 and 0 < a <= 15)) }" },
 	{ 1, "{ rat: [0:2]; rat: [1:3] }" },
+	{ 1, "{ [x, y] : 0 <= x <= 2 and 0 <= y <= 3; "
+		"[x, y] : 5 <= x <= 6 and 0 <= y <= 3; "
+		"[x, y] : 3 <= x <= 4 and 0 <= y <= 3 }" },
+	{ 0, "{ [x, y] : 0 <= x <= 2 and 0 <= y <= 3; "
+		"[x, y] : 4 <= x <= 6 and 0 <= y <= 3 }" },
 };
 
 /* A specialized coalescing test case that would result
@@ -2621,6 +3513,174 @@ static isl_stat test_coalesce_special8(isl_ctx *ctx)
 	return test_coalesce_union(ctx, str1, str2);
 }
 
+/* Construct a union of 10 by 10 small boxes and coalesce it
+ * using "n_thread" threads.
+ * Boxes in the same row can be combined, while
+ * boxes in the same column cannot.
+ */
+/* Construct a union of 100 boxes, the positions of which
+ * are determined by "f" and "g", and coalesce it
+ * using "n_thread" threads.
+ */
+static __isl_give isl_set *coalesce_with_threads(isl_ctx *ctx,
+	int (*f)(int a, int b), int (*g)(int a, int b), int width, int height,
+	int n_thread)
+{
+	int a, b;
+	isl_set *set;
+
+	set = isl_set_read_from_str(ctx, "{ [i, j] : false }");
+	for (a = 0; a < 10; ++a) {
+		for (b = 0; b < 10; ++b) {
+			char str[100];
+
+			snprintf(str, sizeof(str),
+				"{ [i, j] : %d <= i <= %d and %d <= j <= %d }",
+				f(a, b), f(a, b) + width,
+				g(a, b), g(a, b) + height);
+			set = isl_set_union(set, isl_set_read_from_str(ctx, str));
+		}
+	}
+	isl_options_set_coalesce_threads(ctx, n_thread);
+	set = isl_set_coalesce(set);
+
+	return set;
+}
+
+/* Position of the boxes in a grid of disjoint rows of adjacent boxes.
+ */
+static int grid_i(int a, int b)
+{
+	return 4 * a;
+}
+
+static int grid_j(int a, int b)
+{
+	return b;
+}
+
+/* Position of the boxes in a scattered pattern of boxes,
+ * some of which overlap and get fused while others do not.
+ */
+static int scatter_i(int a, int b)
+{
+	return (7 * a + 3 * b) % 20;
+}
+
+static int scatter_j(int a, int b)
+{
+	return (3 * a + 5 * b) % 20;
+}
+
+/* Check that coalescing the union of boxes positioned by "f" and "g"
+ * produces exactly the same result with 0, 2 and 4 threads.
+ */
+static isl_stat check_coalesce_with_threads(isl_ctx *ctx,
+	int (*f)(int a, int b), int (*g)(int a, int b), int width, int height)
+{
+	isl_set *set1, *set2, *set3;
+	isl_bool equal2, equal3;
+
+	set1 = coalesce_with_threads(ctx, f, g, width, height, 0);
+	set2 = coalesce_with_threads(ctx, f, g, width, height, 2);
+	set3 = coalesce_with_threads(ctx, f, g, width, height, 4);
+	equal2 = isl_set_plain_is_equal(set1, set2);
+	equal3 = isl_set_plain_is_equal(set1, set3);
+	isl_set_free(set1);
+	isl_set_free(set2);
+	isl_set_free(set3);
+
+	if (equal2 < 0 || equal3 < 0)
+		return isl_stat_error;
+	if (!equal2 || !equal3)
+		isl_die(ctx, isl_error_unknown,
+			"threads produce different result",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Check that coalescing with threads produces correct results and
+ * that the result does not depend on the number of threads,
+ * both on an input where basic maps only get dropped and
+ * on an input where some of them get fused.
+ */
+static int test_coalesce_threads(isl_ctx *ctx)
+{
+	int i;
+	int threads;
+	int r = 0;
+
+	threads = isl_options_get_coalesce_threads(ctx);
+	isl_options_set_coalesce_threads(ctx, 4);
+
+	for (i = 0; i < ARRAY_SIZE(coalesce_tests); ++i) {
+		const char *str = coalesce_tests[i].str;
+		int check_one = coalesce_tests[i].single_disjunct;
+		if (test_coalesce_set(ctx, str, check_one) >= 0)
+			continue;
+		r = -1;
+		break;
+	}
+
+	if (r >= 0 &&
+	    check_coalesce_with_threads(ctx, &grid_i, &grid_j, 2, 0) < 0)
+		r = -1;
+	if (r >= 0 &&
+	    check_coalesce_with_threads(ctx, &scatter_i, &scatter_j, 3, 1) < 0)
+		r = -1;
+
+	isl_options_set_coalesce_threads(ctx, threads);
+
+	return r;
+}
+
+/* Construct a union of many small boxes by repeatedly adding a box
+ * using isl_set_union_coalesce and check that the result
+ * is equal to the union and that the boxes have been combined.
+ * The boxes in a row are added in an order that makes
+ * the coalesced union consist of several pieces at intermediate stages.
+ */
+static int test_union_coalesce(isl_ctx *ctx)
+{
+	int a, b;
+	isl_set *set, *expected;
+	isl_bool equal;
+	isl_size n;
+
+	set = isl_set_empty(isl_space_set_alloc(ctx, 0, 2));
+	for (b = 0; b < 10; ++b) {
+		for (a = 0; a < 10; ++a) {
+			char str[100];
+
+			snprintf(str, sizeof(str),
+				"{ [i, j] : %d <= i <= %d and %d <= j <= %d }",
+				3 * ((3 * a) % 10), 3 * ((3 * a) % 10) + 2,
+				3 * b, 3 * b + 1);
+			set = isl_set_union_coalesce(set,
+					isl_set_read_from_str(ctx, str));
+		}
+	}
+	expected = isl_set_read_from_str(ctx, "{ [i, j] : 0 <= i <= 29 and "
+				"exists (e : 3e <= j <= 3e + 1 and 0 <= e <= 9) }");
+	equal = isl_set_is_equal(set, expected);
+	n = isl_set_n_basic_set(set);
+	isl_set_free(set);
+	isl_set_free(expected);
+
+	if (equal < 0 || n < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"incrementally coalesced set not equal to union",
+			return -1);
+	if (n != 10)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected number of disjuncts", return -1);
+
+	return 0;
+}
+
 /* Test the functionality of isl_set_coalesce.
  * That is, check that the output is always equal to the input
  * and in some cases that the result consists of a single disjunct.
@@ -2638,6 +3698,10 @@ static int test_coalesce(struct isl_ctx *ctx)
 
 	if (test_coalesce_unbounded_wrapping(ctx) < 0)
 		return -1;
+	if (test_coalesce_threads(ctx) < 0)
+		return -1;
+	if (test_union_coalesce(ctx) < 0)
+		return -1;
 	if (test_coalesce_special(ctx) < 0)
 		return -1;
 	if (test_coalesce_special2(ctx) < 0)
@@ -2702,6 +3766,118 @@ static __isl_give isl_map *cocoa_fig_1_right_tc(isl_ctx *ctx)
 	return isl_set_unwrap(isl_map_range(cocoa_fig_1_right_power(ctx)));
 }
 
+/* Compute the transitive closure of "str" (both as an isl_map and
+ * as an isl_union_map) with the closure_budget option set to "budget" and
+ * check that the result is a superset of "tc" and that
+ * it is reported to be exact if and only if "exact" is set,
+ * in which case it should also be equal to "tc".
+ */
+static isl_stat check_closure_budget(isl_ctx *ctx, const char *str,
+	__isl_keep isl_map *tc, int budget, isl_bool exact)
+{
+	int orig;
+	isl_bool exact_map, exact_umap, subset, equal;
+	isl_map *map;
+	isl_union_map *umap;
+
+	orig = isl_options_get_closure_budget(ctx);
+	isl_options_set_closure_budget(ctx, budget);
+	map = isl_map_read_from_str(ctx, str);
+	map = isl_map_transitive_closure(map, &exact_map);
+	umap = isl_union_map_read_from_str(ctx, str);
+	umap = isl_union_map_transitive_closure(umap, &exact_umap);
+	isl_options_set_closure_budget(ctx, orig);
+
+	subset = isl_map_is_subset(tc, map);
+	equal = isl_map_is_equal(tc, map);
+	if (subset >= 0 && subset) {
+		isl_union_map *utc;
+
+		utc = isl_union_map_from_map(isl_map_copy(tc));
+		subset = isl_union_map_is_subset(utc, umap);
+		isl_union_map_free(utc);
+	}
+	isl_union_map_free(umap);
+	isl_map_free(map);
+	if (subset < 0 || equal < 0)
+		return isl_stat_error;
+	if (!subset)
+		isl_die(ctx, isl_error_unknown,
+			"closure does not contain exact result",
+			return isl_stat_error);
+	if (exact_map != exact || exact_umap != exact)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected exactness", return isl_stat_error);
+	if (exact && !equal)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected closure", return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Check that the transitive closure computation falls back
+ * to an overapproximation if the closure_budget option is set
+ * to a value that is too small and that it computes the exact result
+ * if the budget is large enough.
+ */
+static int test_closure_budget(isl_ctx *ctx)
+{
+	const char *str;
+	isl_map *tc;
+	isl_stat r;
+
+	str = "[n] -> { [i,j] -> [i2,j2] : i2 = i + 1 and j2 = j + 1 and "
+		"1 <= i and i < n and 1 <= j and j < n or "
+		"i2 = i + 1 and j2 = j - 1 and "
+		"1 <= i and i < n and 2 <= j and j <= n }";
+	tc = isl_map_transitive_closure(isl_map_read_from_str(ctx, str), NULL);
+	r = check_closure_budget(ctx, str, tc, 1, isl_bool_false);
+	if (r >= 0)
+		r = check_closure_budget(ctx, str, tc, 10000000, isl_bool_true);
+	isl_map_free(tc);
+
+	return r;
+}
+
+/* Check that computing the transitive closure of a union relation
+ * with several strongly connected components
+ * produces the same result with and without threads.
+ */
+static isl_stat test_closure_threads(isl_ctx *ctx)
+{
+	const char *str;
+	int orig;
+	isl_bool exact1, exact2, equal;
+	isl_union_map *umap1, *umap2;
+
+	str = "{ A[i] -> A[i + 1] : 0 <= i < 10; A[i] -> B[i] : 0 <= i <= 10; "
+		"B[i] -> B[i + 2] : 0 <= i < 20; B[i] -> C[i] : 0 <= i <= 21; "
+		"C[i] -> C[i + 1] : 0 <= i < 5; A[i] -> D[i, i] : 0 <= i < 3; "
+		"D[i, j] -> D[i + 1, j + 2] : 0 <= i, j < 7 }";
+	orig = isl_options_get_closure_threads(ctx);
+	umap1 = isl_union_map_read_from_str(ctx, str);
+	umap1 = isl_union_map_transitive_closure(umap1, &exact1);
+	isl_options_set_closure_threads(ctx, 4);
+	umap2 = isl_union_map_read_from_str(ctx, str);
+	umap2 = isl_union_map_transitive_closure(umap2, &exact2);
+	isl_options_set_closure_threads(ctx, orig);
+
+	equal = isl_union_map_is_equal(umap1, umap2);
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+	if (equal < 0 || exact1 < 0 || exact2 < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"closures with and without threads differ",
+			return isl_stat_error);
+	if (!exact1 || !exact2)
+		isl_die(ctx, isl_error_unknown,
+			"closure unexpectedly not exact", return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
 static int test_closure(isl_ctx *ctx)
 {
 	const char *str;
@@ -2937,6 +4113,11 @@ static int test_closure(isl_ctx *ctx)
 	assert(map);
 	isl_map_free(map);
 
+	if (test_closure_budget(ctx) < 0)
+		return -1;
+	if (test_closure_threads(ctx) < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -3049,7 +4230,153 @@ struct {
 	{ "{ rat: [i] : 21 <= 2i <= 29 or i = 5 }", "{ rat: [5] }" },
 };
 
-static int test_lexmin(struct isl_ctx *ctx)
+/* Inputs for test_lexopt_triangular.
+ * "max" is set if the lexicographic maximum should be computed.
+ * "map" is the input.
+ * "res" is the expected result.
+ * "direct" is set if the result can be read off directly
+ * from the constraints, without solving any parametric problem.
+ */
+static struct {
+	int max;
+	const char *map;
+	const char *res;
+	int direct;
+} lexopt_triangular_tests[] = {
+	{ 0, "[n] -> { [i] -> [j, k] : i <= j <= n and j <= k <= 10 }",
+	  "[n] -> { [i] -> [i, i] : i <= n and i <= 10 }", 1 },
+	{ 1, "{ [i] -> [j, k] : 0 <= j <= i and 0 <= k <= j + 2 }",
+	  "{ [i] -> [i, 2 + i] : i >= 0 }", 1 },
+	{ 0, "{ [i] -> [j] : j >= i and 2j <= 7 }",
+	  "{ [i] -> [i] : i <= 3 }", 1 },
+	{ 0, "{ [i] -> [j, k] : j >= 0 and k >= i - j and k <= 5 }",
+	  "{ [i] -> [-5 + i, 5] : i >= 6; [i] -> [0, i] : i <= 5 }", 0 },
+	{ 1, "[n] -> { [i] -> [j, k] : i <= j <= n and j <= k <= 10 }",
+	  "[n] -> { [i] -> [10, 10] : i <= 10 < n; "
+		"[i] -> [n, 10] : i <= n <= 10 }", 0 },
+	{ 0, "{ [i] -> [j, k] : j >= 0 and k >= 0 and k <= j - 5 }",
+	  "{ [i] -> [5, 0] }", 0 },
+};
+
+/* Check that the lexicographic optima of the inputs in
+ * lexopt_triangular_tests, both as an isl_map and
+ * as an isl_pw_multi_aff, are as expected and that
+ * the inputs that are marked "direct" do not require
+ * any parametric problem to be solved.
+ */
+static int test_lexopt_triangular(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(lexopt_triangular_tests); ++i) {
+		isl_map *map, *opt, *res;
+		isl_pw_multi_aff *pma;
+		struct isl_stats stats;
+		isl_bool equal;
+		int max;
+
+		max = lexopt_triangular_tests[i].max;
+		isl_ctx_reset_stats(ctx);
+		map = isl_map_read_from_str(ctx, lexopt_triangular_tests[i].map);
+		res = isl_map_read_from_str(ctx, lexopt_triangular_tests[i].res);
+		if (max) {
+			pma = isl_map_lexmax_pw_multi_aff(isl_map_copy(map));
+			opt = isl_map_lexmax(map);
+		} else {
+			pma = isl_map_lexmin_pw_multi_aff(isl_map_copy(map));
+			opt = isl_map_lexmin(map);
+		}
+		equal = isl_map_is_equal(opt, res);
+		isl_map_free(opt);
+		opt = isl_map_from_pw_multi_aff(pma);
+		if (equal >= 0 && equal)
+			equal = isl_map_is_equal(opt, res);
+		isl_map_free(opt);
+		isl_map_free(res);
+		if (equal < 0 || isl_ctx_get_stats(ctx, &stats) < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected lexicographic optimum", return -1);
+		if (lexopt_triangular_tests[i].direct && stats.pip_solves != 0)
+			isl_die(ctx, isl_error_unknown,
+				"parametric problem solved unexpectedly",
+				return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for test_lexopt_split.
+ * "map" is a map with independent groups of output variables.
+ * "coupled" is the same map with an extra output variable
+ * that is bounded from below by a combination of variables
+ * from different groups.
+ */
+static struct {
+	const char *map;
+	const char *coupled;
+} lexopt_split_tests[] = {
+	{ "[n] -> { [i] -> [a, b, c, d] : 2a >= i and 3a >= n and a <= 10 and "
+		"3b >= a + i and b >= 0 and 2c + d >= i and 3c >= d and "
+		"0 <= d <= n }",
+	  "[n] -> { [i] -> [a, b, c, d, e] : 2a >= i and 3a >= n and "
+		"a <= 10 and 3b >= a + i and b >= 0 and 2c + d >= i and "
+		"3c >= d and 0 <= d <= n and e >= a + c }" },
+	{ "{ [i, j] -> [a, b] : 2a >= i and 3a >= j and 3b >= i - j and "
+		"2b >= j and a + i <= 20 }",
+	  "{ [i, j] -> [a, b, e] : 2a >= i and 3a >= j and 3b >= i - j and "
+		"2b >= j and a + i <= 20 and e >= a + b }" },
+};
+
+/* Check that the partial lexicographic minimum of each map
+ * in lexopt_split_tests, which may be computed by handling
+ * the independent groups of output variables separately,
+ * is the same as that of the corresponding coupled map,
+ * after projecting out the extra output variable, and
+ * that the parts of the domain without solutions are the same.
+ */
+static int test_lexopt_split(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(lexopt_split_tests); ++i) {
+		isl_map *map, *coupled;
+		isl_set *dom, *empty, *empty_coupled;
+		isl_size n_out;
+		isl_bool equal;
+
+		map = isl_map_read_from_str(ctx, lexopt_split_tests[i].map);
+		coupled = isl_map_read_from_str(ctx,
+					lexopt_split_tests[i].coupled);
+		dom = isl_set_universe(isl_space_domain(isl_map_get_space(map)));
+		dom = isl_set_lower_bound_si(dom, isl_dim_set, 0, -10);
+		map = isl_map_partial_lexmin(map, isl_set_copy(dom), &empty);
+		coupled = isl_map_partial_lexmin(coupled, dom, &empty_coupled);
+		n_out = isl_map_dim(coupled, isl_dim_out);
+		if (n_out < 0)
+			coupled = isl_map_free(coupled);
+		else
+			coupled = isl_map_project_out(coupled, isl_dim_out,
+							n_out - 1, 1);
+		equal = isl_map_is_equal(map, coupled);
+		if (equal >= 0 && equal)
+			equal = isl_set_is_equal(empty, empty_coupled);
+		isl_map_free(map);
+		isl_map_free(coupled);
+		isl_set_free(empty);
+		isl_set_free(empty_coupled);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected lexicographic optimum", return -1);
+	}
+
+	return 0;
+}
+
+static int test_lexmin(struct isl_ctx *ctx)
 {
 	int i;
 	int equal;
@@ -3128,6 +4455,11 @@ static int test_lexmin(struct isl_ctx *ctx)
 			"unexpected difference between set and "
 			"piecewise affine expression", return -1);
 
+	if (test_lexopt_triangular(ctx) < 0)
+		return -1;
+	if (test_lexopt_split(ctx) < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -3642,6 +4974,350 @@ static int test_dep(struct isl_ctx *ctx)
 	return 0;
 }
 
+/* Return the union of all dependence relations and
+ * sink subsets of "flow", each tagged with the kind of result.
+ */
+static __isl_give isl_union_map *flow_to_union_map(isl_ctx *ctx,
+	__isl_take isl_union_flow *flow)
+{
+	isl_union_map *res, *umap;
+
+	res = isl_union_map_from_domain_and_range(
+		isl_union_set_read_from_str(ctx, "{ must[] }"),
+		isl_union_map_wrap(isl_union_flow_get_must_dependence(flow)));
+	umap = isl_union_map_from_domain_and_range(
+		isl_union_set_read_from_str(ctx, "{ may[] }"),
+		isl_union_map_wrap(isl_union_flow_get_may_dependence(flow)));
+	res = isl_union_map_union(res, umap);
+	umap = isl_union_map_from_domain_and_range(
+		isl_union_set_read_from_str(ctx, "{ must_no[] }"),
+		isl_union_map_wrap(isl_union_flow_get_must_no_source(flow)));
+	res = isl_union_map_union(res, umap);
+	umap = isl_union_map_from_domain_and_range(
+		isl_union_set_read_from_str(ctx, "{ may_no[] }"),
+		isl_union_map_wrap(isl_union_flow_get_may_no_source(flow)));
+	res = isl_union_map_union(res, umap);
+	isl_union_flow_free(flow);
+
+	return res;
+}
+
+/* Construct the input for the dataflow analysis of the reads "sink"
+ * on the writes "source" under the schedule tree "tree"
+ * (if "tree" is set) or the schedule map "schedule" (otherwise).
+ */
+static __isl_give isl_union_access_info *flow_access(isl_ctx *ctx,
+	const char *sink, const char *source, const char *tree,
+	const char *schedule)
+{
+	isl_union_access_info *access;
+
+	access = isl_union_access_info_from_sink(
+				isl_union_map_read_from_str(ctx, sink));
+	access = isl_union_access_info_set_must_source(access,
+				isl_union_map_read_from_str(ctx, source));
+	access = isl_union_access_info_set_may_source(access,
+				isl_union_map_read_from_str(ctx, source));
+	if (tree)
+		access = isl_union_access_info_set_schedule(access,
+				isl_schedule_read_from_str(ctx, tree));
+	else
+		access = isl_union_access_info_set_schedule_map(access,
+				isl_union_map_read_from_str(ctx, schedule));
+
+	return access;
+}
+
+/* Compute the dependences of the reads "sink" on the writes "source"
+ * under the schedule tree "tree" (if "tree" is set) or
+ * the schedule map "schedule" (otherwise),
+ * using up to "n_thread" threads.
+ * Return the union of all dependence relations and
+ * sink subsets of the result, each tagged with the kind of result.
+ */
+static __isl_give isl_union_map *flow_with_threads(isl_ctx *ctx,
+	const char *sink, const char *source, const char *tree,
+	const char *schedule, int n_thread)
+{
+	isl_union_access_info *access;
+	isl_union_flow *flow;
+
+	isl_options_set_flow_threads(ctx, n_thread);
+	access = flow_access(ctx, sink, source, tree, schedule);
+	flow = isl_union_access_info_compute_flow(access);
+
+	return flow_to_union_map(ctx, flow);
+}
+
+/* Inputs for test_flow_threads and test_flow_cache:
+ * the reads, the writes, and the same schedule
+ * in schedule tree and schedule map representation.
+ */
+static const char *flow_sink =
+	"[N] -> { S[i] -> A[i - 1] : 0 < i < N; S[i] -> B[i]; "
+	"T[i, j] -> A[j] : 0 <= i, j < N; "
+	"U[i] -> B[i - 2] : 2 <= i < N; U[i] -> A[N - 1 - i] }";
+static const char *flow_source = "[N] -> { S[i] -> A[i] : 0 <= i < N; "
+	"T[i, j] -> B[i + j] : 0 <= i, j < N; U[i] -> A[i] }";
+static const char *flow_tree = "domain: \"[N] -> { S[i] : 0 <= i < N; "
+	"T[i, j] : 0 <= i, j < N; U[i] : 0 <= i < N }\"\n"
+	"child:\n"
+	"  sequence:\n"
+	"  - filter: \"{ S[i] }\"\n"
+	"    child:\n"
+	"      schedule: \"[{ S[i] -> [(i)] }]\"\n"
+	"  - filter: \"{ T[i, j] }\"\n"
+	"    child:\n"
+	"      schedule: \"[{ T[i, j] -> [(i)] }, { T[i, j] -> [(j)] }]\"\n"
+	"  - filter: \"{ U[i] }\"\n"
+	"    child:\n"
+	"      schedule: \"[{ U[i] -> [(i)] }]\"\n";
+static const char *flow_schedule =
+	"[N] -> { S[i] -> [0, i, 0]; T[i, j] -> [1, i, j]; U[i] -> [2, i, 0] }";
+
+/* Check that dataflow analysis performed using threads
+ * produces the same results as that performed without threads,
+ * both for a schedule tree and for a schedule map.
+ */
+static isl_stat test_flow_threads(isl_ctx *ctx)
+{
+	int i;
+	int threads;
+	isl_bool equal = isl_bool_true;
+
+	threads = isl_options_get_flow_threads(ctx);
+	for (i = 0; equal == isl_bool_true && i < 2; ++i) {
+		const char *tree = i == 0 ? flow_tree : NULL;
+		isl_union_map *umap1, *umap2;
+
+		umap1 = flow_with_threads(ctx, flow_sink, flow_source, tree,
+					flow_schedule, 0);
+		umap2 = flow_with_threads(ctx, flow_sink, flow_source, tree,
+					flow_schedule, 3);
+		equal = isl_union_map_is_equal(umap1, umap2);
+		isl_union_map_free(umap1);
+		isl_union_map_free(umap2);
+	}
+	isl_options_set_flow_threads(ctx, threads);
+
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"threads produce different result",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Check that repeating a dataflow analysis on separately constructed,
+ * but identical inputs takes the result from the dataflow analysis cache
+ * and that this result is the same as that of the original analysis,
+ * both for a schedule tree and for a schedule map.
+ */
+static isl_stat test_flow_cache(isl_ctx *ctx)
+{
+	int i;
+	int size;
+	struct isl_stats stats;
+	isl_bool equal = isl_bool_true;
+
+	size = isl_options_get_flow_cache_size(ctx);
+	isl_options_set_flow_cache_size(ctx, 4);
+	for (i = 0; equal == isl_bool_true && i < 2; ++i) {
+		const char *tree = i == 0 ? flow_tree : NULL;
+		isl_union_map *umap1, *umap2;
+
+		isl_ctx_reset_stats(ctx);
+		umap1 = flow_with_threads(ctx, flow_sink, flow_source, tree,
+					flow_schedule, 0);
+		umap2 = flow_with_threads(ctx, flow_sink, flow_source, tree,
+					flow_schedule, 0);
+		equal = isl_union_map_is_equal(umap1, umap2);
+		isl_union_map_free(umap1);
+		isl_union_map_free(umap2);
+		if (equal < 0 || isl_ctx_get_stats(ctx, &stats) < 0)
+			equal = isl_bool_error;
+		else if (stats.flow_cache_hits != 1) {
+			isl_options_set_flow_cache_size(ctx, size);
+			isl_die(ctx, isl_error_unknown, "cache not used",
+				return isl_stat_error);
+		}
+	}
+	isl_options_set_flow_cache_size(ctx, size);
+
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"cache produces different result",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Compute the memory based dependences of the reads "sink"
+ * on the writes "source" under the schedule tree "tree" (if "tree" is set)
+ * or the schedule map "schedule" (otherwise), by performing
+ * an approximate dataflow analysis.
+ * Check that there are no must-dependences and
+ * return the may-dependences.
+ */
+static __isl_give isl_union_map *approximate_flow(isl_ctx *ctx,
+	const char *sink, const char *source, const char *tree,
+	const char *schedule)
+{
+	isl_union_access_info *access;
+	isl_union_flow *flow;
+	isl_union_map *must, *may;
+	isl_bool empty;
+
+	access = flow_access(ctx, sink, source, tree, schedule);
+	access = isl_union_access_info_set_approximate(access, 1);
+	flow = isl_union_access_info_compute_flow(access);
+	must = isl_union_flow_get_must_dependence(flow);
+	may = isl_union_flow_get_may_dependence(flow);
+	isl_union_flow_free(flow);
+
+	empty = isl_union_map_is_empty(must);
+	isl_union_map_free(must);
+	if (empty < 0)
+		return isl_union_map_free(may);
+	if (!empty)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected must-dependences",
+			return isl_union_map_free(may));
+
+	return may;
+}
+
+/* Return the memory based dependences of the reads "flow_sink"
+ * on the writes "flow_source", i.e., all pairs of writes and
+ * later reads of the same element, according to the schedule
+ * "flow_schedule".
+ * If "tree" is set, then only consider the statement instances
+ * in the domain of this schedule tree.
+ */
+static __isl_give isl_union_map *memory_based_flow(isl_ctx *ctx,
+	const char *tree)
+{
+	isl_union_map *sink, *source, *schedule, *dep;
+
+	sink = isl_union_map_read_from_str(ctx, flow_sink);
+	source = isl_union_map_read_from_str(ctx, flow_source);
+	schedule = isl_union_map_read_from_str(ctx, flow_schedule);
+	if (tree) {
+		isl_schedule *sched;
+
+		sched = isl_schedule_read_from_str(ctx, tree);
+		schedule = isl_union_map_intersect_domain(schedule,
+					isl_schedule_get_domain(sched));
+		isl_schedule_free(sched);
+	}
+	dep = isl_union_map_apply_range(source, isl_union_map_reverse(sink));
+	dep = isl_union_map_intersect(dep,
+		isl_union_map_lex_lt_union_map(isl_union_map_copy(schedule),
+					      schedule));
+	return dep;
+}
+
+/* Check that an approximate dataflow analysis produces
+ * the memory based dependences, both for a schedule tree and
+ * for a schedule map.
+ * The dataflow analysis cache is enabled to check that
+ * the result of an exact analysis on the same input
+ * is not mistaken for that of an approximate analysis.
+ */
+static isl_stat test_flow_approximate(isl_ctx *ctx)
+{
+	int i;
+	int size;
+	isl_bool equal = isl_bool_true;
+
+	size = isl_options_get_flow_cache_size(ctx);
+	isl_options_set_flow_cache_size(ctx, 4);
+	for (i = 0; equal == isl_bool_true && i < 2; ++i) {
+		const char *tree = i == 0 ? flow_tree : NULL;
+		isl_union_map *umap, *expected;
+
+		umap = flow_with_threads(ctx, flow_sink, flow_source, tree,
+					flow_schedule, 0);
+		isl_union_map_free(umap);
+		umap = approximate_flow(ctx, flow_sink, flow_source, tree,
+					flow_schedule);
+		expected = memory_based_flow(ctx, tree);
+		equal = isl_union_map_is_equal(umap, expected);
+		isl_union_map_free(umap);
+		isl_union_map_free(expected);
+	}
+	isl_options_set_flow_cache_size(ctx, size);
+
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected approximate dependences",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Inputs for test_flow_update: the reads, the writes and the schedule
+ * of flow_sink, flow_source and flow_schedule after the introduction
+ * of a statement V that copies the elements of B to C,
+ * with the reads from B in U replaced by reads from C.
+ */
+static const char *flow_update_sink =
+	"[N] -> { S[i] -> A[i - 1] : 0 < i < N; S[i] -> B[i]; "
+	"T[i, j] -> A[j] : 0 <= i, j < N; V[i] -> B[i] : 0 <= i < N; "
+	"U[i] -> C[i - 2] : 2 <= i < N; U[i] -> A[N - 1 - i] }";
+static const char *flow_update_source = "[N] -> { S[i] -> A[i] : 0 <= i < N; "
+	"T[i, j] -> B[i + j] : 0 <= i, j < N; V[i] -> C[i] : 0 <= i < N; "
+	"U[i] -> A[i] }";
+static const char *flow_update_schedule =
+	"[N] -> { S[i] -> [0, i, 0]; T[i, j] -> [1, i, j]; V[i] -> [1, N, i]; "
+	"U[i] -> [2, i, 0] }";
+
+/* Check that updating the result of a dataflow analysis
+ * after changing the accesses to some arrays
+ * produces the same result as performing the dataflow analysis
+ * on the changed input from scratch.
+ */
+static isl_stat test_flow_update(isl_ctx *ctx)
+{
+	isl_union_access_info *access;
+	isl_union_flow *flow;
+	isl_union_set *data;
+	isl_union_map *umap1, *umap2;
+	isl_bool equal;
+
+	access = flow_access(ctx, flow_update_sink, flow_update_source,
+				NULL, flow_update_schedule);
+	umap1 = flow_to_union_map(ctx,
+				isl_union_access_info_compute_flow(access));
+
+	access = flow_access(ctx, flow_sink, flow_source, NULL, flow_schedule);
+	flow = isl_union_access_info_compute_flow(access);
+	access = flow_access(ctx, flow_update_sink, flow_update_source,
+				NULL, flow_update_schedule);
+	data = isl_union_set_read_from_str(ctx, "{ B[i]; C[i] }");
+	flow = isl_union_access_info_update_flow(access, flow, data);
+	umap2 = flow_to_union_map(ctx, flow);
+
+	equal = isl_union_map_is_equal(umap1, umap2);
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"updated dataflow differs from recomputed dataflow",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
 /* Check that the dependence analysis proceeds without errors.
  * Earlier versions of isl would break down during the analysis
  * due to the use of the wrong spaces.
@@ -3665,8 +5341,19 @@ static int test_flow(isl_ctx *ctx)
 					&must_dep, &may_dep, NULL, NULL);
 	isl_union_map_free(may_dep);
 	isl_union_map_free(must_dep);
+	if (r < 0)
+		return -1;
 
-	return r;
+	if (test_flow_threads(ctx) < 0)
+		return -1;
+	if (test_flow_cache(ctx) < 0)
+		return -1;
+	if (test_flow_approximate(ctx) < 0)
+		return -1;
+	if (test_flow_update(ctx) < 0)
+		return -1;
+
+	return 0;
 }
 
 struct {
@@ -3822,6 +5509,61 @@ static isl_stat test_pwqp_max(isl_ctx *ctx)
 	return isl_stat_ok;
 }
 
+/* Inputs for isl_pw_qpolynomial_mul tests.
+ * "c" is equal to the product of "a" and "b".
+ * The powers of these quasi-polynomials have enough terms
+ * for their products to be computed using flat representations.
+ */
+struct {
+	const char *a;
+	const char *b;
+	const char *c;
+} pwqp_mul_tests[] = {
+	{ "{ [x, y] -> x + y }", "{ [x, y] -> x - y }",
+	  "{ [x, y] -> x^2 - y^2 }" },
+	{ "{ [x, y, z, w] -> 1/2 * x + 2y + 3/5 * z + w + 1 }",
+	  "{ [x, y, z, w] -> 2 }",
+	  "{ [x, y, z, w] -> x + 4y + 6/5 * z + 2w + 2 }" },
+	{ "[n] -> { [x, y] -> 1/3 * x + floor(n/2) - y }",
+	  "[n] -> { [x, y] -> 1/3 * x - floor(n/2) + y }",
+	  "[n] -> { [x, y] -> 1/9 * x^2 - (floor(n/2) - y)^2 }" },
+	{ "{ [x, y] -> x^5 + y^4 - 1/7 }", "{ [x, y] -> x^3 - 7 * y }",
+	  "{ [x, y] -> x^8 + y^4 * x^3 - 1/7 * x^3 - 7 * y * x^5 "
+		"- 7 * y^5 + y }" },
+};
+
+/* Check that the product of the 6th powers of "a" and "b"
+ * is equal to the 6th power of "c" for each of the tests
+ * in pwqp_mul_tests.
+ */
+static isl_stat test_pwqp_mul(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(pwqp_mul_tests); ++i) {
+		isl_pw_qpolynomial *a, *b, *c;
+		isl_bool zero;
+
+		a = isl_pw_qpolynomial_read_from_str(ctx, pwqp_mul_tests[i].a);
+		b = isl_pw_qpolynomial_read_from_str(ctx, pwqp_mul_tests[i].b);
+		c = isl_pw_qpolynomial_read_from_str(ctx, pwqp_mul_tests[i].c);
+		a = isl_pw_qpolynomial_pow(a, 6);
+		b = isl_pw_qpolynomial_pow(b, 6);
+		c = isl_pw_qpolynomial_pow(c, 6);
+		a = isl_pw_qpolynomial_mul(a, b);
+		a = isl_pw_qpolynomial_sub(a, c);
+		zero = isl_pw_qpolynomial_is_zero(a);
+		isl_pw_qpolynomial_free(a);
+		if (zero < 0)
+			return isl_stat_error;
+		if (!zero)
+			isl_die(ctx, isl_error_unknown, "unexpected product",
+				return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
 static int test_pwqp(struct isl_ctx *ctx)
 {
 	const char *str;
@@ -3846,6 +5588,8 @@ static int test_pwqp(struct isl_ctx *ctx)
 
 	if (test_pwqp_gist(ctx) < 0)
 		return -1;
+	if (test_pwqp_mul(ctx) < 0)
+		return -1;
 
 	str = "{ [i] -> ([([i/2] + [i/2])/5]) }";
 	pwqp1 = isl_pw_qpolynomial_read_from_str(ctx, str);
@@ -4024,53 +5768,247 @@ static isl_stat test_bound_space(isl_ctx *ctx)
 	return isl_stat_non_null(pwf);
 }
 
-/* Perform basic isl_pw_qpolynomial_bound tests.
+/* Inputs for test_bound_threads, each with a single parameter
+ * and a domain that consists of several disjoint basic sets.
  */
-static int test_bound(isl_ctx *ctx)
+static struct {
+	enum isl_fold type;
+	const char *poly;
+} bound_threads_tests[] = {
+	{ isl_fold_max, "[n] -> { [i] -> i : 0 <= i <= n or 2n <= i <= 3n }" },
+	{ isl_fold_max, "[n] -> { [i, j] -> i * j : 0 <= j <= i <= n or "
+				"(n < i <= 2n and 0 <= j <= n) }" },
+	{ isl_fold_min, "[n] -> { [i] -> i^2 - n * i : 0 <= i <= n or "
+				"n + 5 <= i <= 2n }" },
+	{ isl_fold_max, "[n] -> { [i] -> floor(i/2) : 0 <= i <= n or "
+				"(i >= 3n and i <= 4n and i mod 3 = 0) }" },
+};
+
+/* Inputs for test_bound_threads, each with a single parameter
+ * and a domain that is a single basic set with several chambers
+ * in its parametric vertex decomposition.
+ */
+static struct {
+	enum isl_fold type;
+	const char *poly;
+} bernstein_threads_tests[] = {
+	{ isl_fold_max, "[n] -> { [i] -> i^2 - 5i : 0 <= i <= n and i <= 10 }" },
+	{ isl_fold_min, "[n] -> { [i] -> i^2 - 5i : 0 <= i <= n and i <= 10 }" },
+	{ isl_fold_max, "[n] -> { [i, j] -> i * j - j : 0 <= i <= n and "
+				"0 <= j <= 6 and i + j <= 8 }" },
+};
+
+/* Compute the bound of the given type on "str"
+ * using "n_thread" threads, as set by "set_threads".
+ */
+static __isl_give isl_pw_qpolynomial_fold *bound_with_threads(isl_ctx *ctx,
+	const char *str, enum isl_fold type,
+	isl_stat (*set_threads)(isl_ctx *ctx, int val), int n_thread,
+	isl_bool *tight)
 {
-	int i;
+	isl_pw_qpolynomial *pwqp;
 
-	if (test_bound_space(ctx) < 0)
-		return -1;
+	set_threads(ctx, n_thread);
+	pwqp = isl_pw_qpolynomial_read_from_str(ctx, str);
+	return isl_pw_qpolynomial_bound(pwqp, type, tight);
+}
 
-	for (i = 0; i < ARRAY_SIZE(bound_tests); ++i) {
-		const char *str;
-		enum isl_fold type;
-		isl_bool equal, tight;
-		isl_pw_qpolynomial *pwqp;
-		isl_pw_qpolynomial_fold *pwf1, *pwf2;
+/* Check that "pwf1" and "pwf2", with a single parameter,
+ * take on the same values for small values of the parameter.
+ */
+static isl_stat check_same_bound(__isl_keep isl_pw_qpolynomial_fold *pwf1,
+	__isl_keep isl_pw_qpolynomial_fold *pwf2)
+{
+	int n;
+	isl_ctx *ctx = isl_pw_qpolynomial_fold_get_ctx(pwf1);
 
-		str = bound_tests[i].poly;
-		pwqp = isl_pw_qpolynomial_read_from_str(ctx, str);
-		type = bound_tests[i].type;
-		pwf1 = isl_pw_qpolynomial_bound(pwqp, type, &tight);
-		str = bound_tests[i].bound;
-		pwf2 = isl_pw_qpolynomial_fold_read_from_str(ctx, str);
-		equal = isl_pw_qpolynomial_fold_plain_is_equal(pwf1, pwf2);
-		isl_pw_qpolynomial_fold_free(pwf2);
-		isl_pw_qpolynomial_fold_free(pwf1);
+	for (n = -2; n <= 12; ++n) {
+		isl_point *pnt;
+		isl_val *v1, *v2;
+		isl_bool equal;
+
+		pnt = isl_point_zero(isl_pw_qpolynomial_fold_get_domain_space(
+									pwf1));
+		pnt = isl_point_set_coordinate_val(pnt, isl_dim_param, 0,
+						isl_val_int_from_si(ctx, n));
+		v1 = isl_pw_qpolynomial_fold_eval(
+			isl_pw_qpolynomial_fold_copy(pwf1), isl_point_copy(pnt));
+		v2 = isl_pw_qpolynomial_fold_eval(
+			isl_pw_qpolynomial_fold_copy(pwf2), pnt);
+		equal = isl_val_eq(v1, v2);
+		isl_val_free(v1);
+		isl_val_free(v2);
 		if (equal < 0)
-			return -1;
+			return isl_stat_error;
 		if (!equal)
 			isl_die(ctx, isl_error_unknown,
-				"incorrect bound result", return -1);
-		if (bound_tests[i].tight && !tight)
-			isl_die(ctx, isl_error_unknown,
-				"bound unexpectedly not tight", return -1);
+				"bounds computed with and without threads "
+				"differ", return isl_stat_error);
 	}
 
-	return 0;
+	return isl_stat_ok;
 }
 
-/* isl_set is defined to isl_map internally, so the corresponding elements
- * are isl_basic_map objects.
+/* Check that computing the bound of the given type on "str"
+ * using several threads, as set by "set_threads",
+ * produces the same result as computing it without threads,
+ * with the result being independent of the number of threads.
  */
-#undef EL_BASE
-#undef SET_BASE
-#define EL_BASE		basic_map
-#define SET_BASE	set
-#include "isl_test_list_templ.c"
-
+static isl_stat check_bound_threads(isl_ctx *ctx, const char *str,
+	enum isl_fold type, isl_stat (*set_threads)(isl_ctx *ctx, int val))
+{
+	isl_pw_qpolynomial_fold *pwf0, *pwf2, *pwf4;
+	isl_bool tight0, tight2, tight4;
+	isl_bool equal;
+	isl_stat r = isl_stat_ok;
+
+	pwf0 = bound_with_threads(ctx, str, type, set_threads, 0, &tight0);
+	pwf2 = bound_with_threads(ctx, str, type, set_threads, 2, &tight2);
+	pwf4 = bound_with_threads(ctx, str, type, set_threads, 4, &tight4);
+	equal = isl_pw_qpolynomial_fold_plain_is_equal(pwf2, pwf4);
+	if (equal < 0 || !pwf0)
+		r = isl_stat_error;
+	else if (!equal || tight0 != tight2 || tight2 != tight4)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result", r = isl_stat_error);
+	if (r >= 0)
+		r = check_same_bound(pwf0, pwf2);
+	isl_pw_qpolynomial_fold_free(pwf0);
+	isl_pw_qpolynomial_fold_free(pwf2);
+	isl_pw_qpolynomial_fold_free(pwf4);
+
+	return r;
+}
+
+/* Check that computing bounds using several threads,
+ * either over disjoint basic sets or over the chambers
+ * of a single basic set,
+ * produces the same results as computing them without threads,
+ * with the results being independent of the number of threads.
+ */
+static int test_bound_threads(isl_ctx *ctx)
+{
+	int i;
+	int bound_threads, bernstein_threads;
+	isl_stat r = isl_stat_ok;
+
+	bound_threads = isl_options_get_bound_threads(ctx);
+	bernstein_threads = isl_options_get_bernstein_threads(ctx);
+	for (i = 0; r >= 0 && i < ARRAY_SIZE(bound_threads_tests); ++i)
+		r = check_bound_threads(ctx, bound_threads_tests[i].poly,
+				bound_threads_tests[i].type,
+				&isl_options_set_bound_threads);
+	isl_options_set_bound_threads(ctx, bound_threads);
+	for (i = 0; r >= 0 && i < ARRAY_SIZE(bernstein_threads_tests); ++i)
+		r = check_bound_threads(ctx, bernstein_threads_tests[i].poly,
+				bernstein_threads_tests[i].type,
+				&isl_options_set_bernstein_threads);
+	isl_options_set_bernstein_threads(ctx, bernstein_threads);
+
+	return r;
+}
+
+/* Inputs for isl_pw_qpolynomial_fold_fold tests,
+ * consisting of two folds and the expected result
+ * after removal of the dominated elements.
+ */
+static struct {
+	const char *fold1;
+	const char *fold2;
+	const char *res;
+} fold_prune_tests[] = {
+	{ "[n] -> { [i] -> max(i, 20 - i) : 0 <= i <= 10 and i <= n }",
+	  "[n] -> { [i] -> max(i^2 - 100, 2i + 1) : 0 <= i <= 10 and i <= n }",
+	  "[n] -> { [i] -> max(20 - i, 2i + 1) : 0 <= i <= 10 and i <= n }" },
+	{ "{ [i, j] -> min(i * j, i + j) : 2 <= i <= 4 and 3 <= j <= 5 }",
+	  "{ [i, j] -> min(i * j + 1, 2 * i) : 2 <= i <= 4 and 3 <= j <= 5 }",
+	  "{ [i, j] -> min(i + j, 2 * i) : 2 <= i <= 4 and 3 <= j <= 5 }" },
+};
+
+/* Check that combining folds on the same domain
+ * removes the elements that are dominated by other elements.
+ */
+static int test_fold_prune(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(fold_prune_tests); ++i) {
+		const char *str;
+		isl_bool equal;
+		isl_pw_qpolynomial_fold *pwf1, *pwf2, *res;
+
+		str = fold_prune_tests[i].fold1;
+		pwf1 = isl_pw_qpolynomial_fold_read_from_str(ctx, str);
+		str = fold_prune_tests[i].fold2;
+		pwf2 = isl_pw_qpolynomial_fold_read_from_str(ctx, str);
+		pwf1 = isl_pw_qpolynomial_fold_fold(pwf1, pwf2);
+		str = fold_prune_tests[i].res;
+		res = isl_pw_qpolynomial_fold_read_from_str(ctx, str);
+		equal = isl_pw_qpolynomial_fold_plain_is_equal(pwf1, res);
+		isl_pw_qpolynomial_fold_free(pwf1);
+		isl_pw_qpolynomial_fold_free(res);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"dominated fold elements not removed",
+				return -1);
+	}
+
+	return 0;
+}
+
+/* Perform basic isl_pw_qpolynomial_bound tests.
+ */
+static int test_bound(isl_ctx *ctx)
+{
+	int i;
+
+	if (test_bound_space(ctx) < 0)
+		return -1;
+	if (test_bound_threads(ctx) < 0)
+		return -1;
+	if (test_fold_prune(ctx) < 0)
+		return -1;
+
+	for (i = 0; i < ARRAY_SIZE(bound_tests); ++i) {
+		const char *str;
+		enum isl_fold type;
+		isl_bool equal, tight;
+		isl_pw_qpolynomial *pwqp;
+		isl_pw_qpolynomial_fold *pwf1, *pwf2;
+
+		str = bound_tests[i].poly;
+		pwqp = isl_pw_qpolynomial_read_from_str(ctx, str);
+		type = bound_tests[i].type;
+		pwf1 = isl_pw_qpolynomial_bound(pwqp, type, &tight);
+		str = bound_tests[i].bound;
+		pwf2 = isl_pw_qpolynomial_fold_read_from_str(ctx, str);
+		equal = isl_pw_qpolynomial_fold_plain_is_equal(pwf1, pwf2);
+		isl_pw_qpolynomial_fold_free(pwf2);
+		isl_pw_qpolynomial_fold_free(pwf1);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"incorrect bound result", return -1);
+		if (bound_tests[i].tight && !tight)
+			isl_die(ctx, isl_error_unknown,
+				"bound unexpectedly not tight", return -1);
+	}
+
+	return 0;
+}
+
+/* isl_set is defined to isl_map internally, so the corresponding elements
+ * are isl_basic_map objects.
+ */
+#undef EL_BASE
+#undef SET_BASE
+#define EL_BASE		basic_map
+#define SET_BASE	set
+#include "isl_test_list_templ.c"
+
 #undef EL_BASE
 #undef SET_BASE
 #define EL_BASE		basic_set
@@ -4207,6 +6145,84 @@ struct {
 	{ "[a, b] -> { : a = 0 and b = -1 }", "[b, a] -> { : b >= -10 }", 1 },
 };
 
+/* Check that isl_basic_set_list_is_subset_of_set produces
+ * the same results as isl_set_is_subset on the disjuncts
+ * of the first sets in subset_tests.
+ */
+static isl_stat test_subset_list(isl_ctx *ctx)
+{
+	int i;
+	isl_set *set1, *set2;
+	isl_basic_set_list *list;
+	isl_bool subset;
+
+	for (i = 0; i < ARRAY_SIZE(subset_tests); ++i) {
+		set1 = isl_set_read_from_str(ctx, subset_tests[i].set1);
+		set2 = isl_set_read_from_str(ctx, subset_tests[i].set2);
+		list = isl_set_get_basic_set_list(set1);
+		subset = isl_basic_set_list_is_subset_of_set(list, set2);
+		isl_basic_set_list_free(list);
+		isl_set_free(set1);
+		isl_set_free(set2);
+		if (subset < 0)
+			return isl_stat_error;
+		if (subset != subset_tests[i].subset)
+			isl_die(ctx, isl_error_unknown,
+				"incorrect subset result",
+				return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for isl_set_plain_is_subset tests.
+ * "subset" is the expected result of the syntactic check.
+ */
+struct {
+	const char *set1;
+	const char *set2;
+	int subset;
+} plain_subset_tests[] = {
+	{ "{ [i, j] : 0 <= i <= 10 and j = i }",
+	  "{ [i, j] : i >= 0 and j = i }", 1 },
+	{ "{ [i, j] : 0 <= i <= 10 and j = i }",
+	  "{ [i, j] : i >= 0 and j >= i }", 1 },
+	{ "{ [i] : 0 <= i <= 5 or 10 <= i <= 20 }",
+	  "{ [i] : i <= 5 or i >= 10 }", 1 },
+	{ "{ [i] : exists (e : i = 2e and 0 <= i <= 10) }",
+	  "{ [i] : exists (e : i = 2e) }", 1 },
+	{ "{ [i] : 0 <= i <= 10 }", "{ [i] : i >= -1 }", 0 },
+	{ "{ [i] : 0 <= i <= 10 }", "{ [i] : i >= 0 and i <= 5 }", 0 },
+};
+
+/* Check that isl_set_plain_is_subset only detects syntactic
+ * subsets and that those are also detected by isl_set_is_subset.
+ */
+static isl_stat test_plain_subset(isl_ctx *ctx)
+{
+	int i;
+	isl_set *set1, *set2;
+	isl_bool plain, subset;
+
+	for (i = 0; i < ARRAY_SIZE(plain_subset_tests); ++i) {
+		set1 = isl_set_read_from_str(ctx, plain_subset_tests[i].set1);
+		set2 = isl_set_read_from_str(ctx, plain_subset_tests[i].set2);
+		plain = isl_set_plain_is_subset(set1, set2);
+		subset = isl_set_is_subset(set1, set2);
+		isl_set_free(set1);
+		isl_set_free(set2);
+		if (plain < 0 || subset < 0)
+			return isl_stat_error;
+		if (plain != plain_subset_tests[i].subset ||
+		    (plain && !subset))
+			isl_die(ctx, isl_error_unknown,
+				"incorrect plain subset result",
+				return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
 static int test_subset(isl_ctx *ctx)
 {
 	int i;
@@ -4229,6 +6245,11 @@ static int test_subset(isl_ctx *ctx)
 				"incorrect subset result", return -1);
 	}
 
+	if (test_subset_list(ctx) < 0)
+		return -1;
+	if (test_plain_subset(ctx) < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -4354,6 +6375,70 @@ static isl_stat test_intersect_2(isl_ctx *ctx)
 	return isl_stat_ok;
 }
 
+/* Inputs for intersection tests of sets with several disjuncts,
+ * where many pairs of disjuncts are disjoint,
+ * along with the expected result and the expected number of disjuncts.
+ */
+struct {
+	const char *set1;
+	const char *set2;
+	const char *res;
+	int n;
+} intersect_disjuncts_tests[] = {
+	{ "{ [x] : -3 <= -x <= -1 or x >= 7 }",
+	  "{ [x] : -x >= -1 or x = 8 }",
+	  "{ [x] : x = 1 or x = 8 }", 2 },
+	{ "{ [x, y] : 0 <= x <= 3 or 10 <= x <= 13 or x = 20 }",
+	  "{ [x, y] : 2 <= x <= 11 or 2x = 41 or y = 5 }",
+	  "{ [x, y] : 2 <= x <= 3 or 10 <= x <= 11 or "
+	    "(y = 5 and (0 <= x <= 3 or 10 <= x <= 13 or x = 20)) }", 5 },
+	{ "{ rat: [x] : 2x >= 1 or x >= 3 }",
+	  "{ rat: [x] : 2x <= 1 or x <= -3 }",
+	  "{ rat: [x] : 2x = 1 }", 1 },
+	{ "[N] -> { [x] : x = N or x = 5 }",
+	  "[N] -> { [x] : N = 3 or x = 7 }",
+	  "[N] -> { [x] : (N = 3 and (x = 3 or x = 5)) or x = N = 7 }", 3 },
+};
+
+/* Check that intersecting sets with several disjuncts,
+ * where many pairs of disjuncts are obviously disjoint,
+ * produces the expected result without any empty disjuncts.
+ */
+static isl_stat test_intersect_3(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(intersect_disjuncts_tests); ++i) {
+		isl_set *set1, *set2, *res;
+		isl_bool equal;
+		isl_size n;
+
+		set1 = isl_set_read_from_str(ctx,
+					intersect_disjuncts_tests[i].set1);
+		set2 = isl_set_read_from_str(ctx,
+					intersect_disjuncts_tests[i].set2);
+		res = isl_set_read_from_str(ctx,
+					intersect_disjuncts_tests[i].res);
+		set1 = isl_set_intersect(set1, set2);
+		equal = isl_set_is_equal(set1, res);
+		n = isl_set_n_basic_set(set1);
+		isl_set_free(set1);
+		isl_set_free(res);
+		if (equal < 0 || n < 0)
+			return isl_stat_error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected intersection",
+				return isl_stat_error);
+		if (n != intersect_disjuncts_tests[i].n)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected number of disjuncts",
+				return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
 /* Perform some intersection tests.
  */
 static int test_intersect(isl_ctx *ctx)
@@ -4362,6 +6447,8 @@ static int test_intersect(isl_ctx *ctx)
 		return -1;
 	if (test_intersect_2(ctx) < 0)
 		return -1;
+	if (test_intersect_3(ctx) < 0)
+		return -1;
 
 	return 0;
 }
@@ -5392,668 +7479,1364 @@ static int test_schedule_incremental(isl_ctx *ctx)
 	return r;
 }
 
-int test_plain_injective(isl_ctx *ctx, const char *str, int injective)
+/* Compute a schedule for the schedule constraints described by "str"
+ * using up to "n_thread" threads for scheduling
+ * the weakly connected components.
+ */
+static __isl_give isl_schedule *schedule_with_threads(isl_ctx *ctx,
+	const char *str, int n_thread)
 {
-	isl_union_map *umap;
-	int test;
+	isl_schedule_constraints *sc;
 
-	umap = isl_union_map_read_from_str(ctx, str);
-	test = isl_union_map_plain_is_injective(umap);
-	isl_union_map_free(umap);
-	if (test < 0)
-		return -1;
-	if (test == injective)
-		return 0;
-	if (injective)
-		isl_die(ctx, isl_error_unknown,
-			"map not detected as injective", return -1);
-	else
-		isl_die(ctx, isl_error_unknown,
-			"map detected as injective", return -1);
+	isl_options_set_schedule_threads(ctx, n_thread);
+	sc = isl_schedule_constraints_read_from_str(ctx, str);
+	return isl_schedule_constraints_compute_schedule(sc);
 }
 
-int test_injective(isl_ctx *ctx)
+/* Schedule constraints of a dependence graph with several
+ * weakly connected components, including proximity dependences
+ * between them and tagged conditional validity dependences inside them.
+ */
+static const char *schedule_components_str =
+	"{ domain: \"[N] -> { A[i] : 0 <= i < N; B[i] : 0 <= i < N; "
+	"C[i, j] : 0 <= i, j < N; D[i] : 0 <= i < N; E[] }\", "
+	"validity: \"{ A[i] -> A[i + 1]; C[i, j] -> C[i + 1, j]; "
+	"D[i] -> D[i + 1] }\", "
+	"proximity: \"{ A[i] -> B[i]; C[i, j] -> C[i, j + 1]; "
+	"A[i] -> D[i] }\", "
+	"condition: \"{ [C[i, j] -> t[]] -> [C[i, j + 1] -> t[]] }\", "
+	"conditional_validity: "
+	"\"{ [C[i, j] -> t[]] -> [C[i, j + 1] -> t[]] }\" }";
+
+/* Return the number of schedule LPs solved while computing
+ * a schedule for "str" using up to "n_thread" threads,
+ * or -1 if anything goes wrong.
+ */
+static long count_schedule_lp_solves(isl_ctx *ctx, const char *str,
+	int n_thread)
 {
-	const char *str;
+	isl_schedule *schedule;
+	struct isl_stats stats;
 
-	if (test_plain_injective(ctx, "{S[i,j] -> A[0]; T[i,j] -> B[1]}", 0))
-		return -1;
-	if (test_plain_injective(ctx, "{S[] -> A[0]; T[] -> B[0]}", 1))
-		return -1;
-	if (test_plain_injective(ctx, "{S[] -> A[0]; T[] -> A[1]}", 1))
-		return -1;
-	if (test_plain_injective(ctx, "{S[] -> A[0]; T[] -> A[0]}", 0))
-		return -1;
-	if (test_plain_injective(ctx, "{S[i] -> A[i,0]; T[i] -> A[i,1]}", 1))
-		return -1;
-	if (test_plain_injective(ctx, "{S[i] -> A[i]; T[i] -> A[i]}", 0))
-		return -1;
-	if (test_plain_injective(ctx, "{S[] -> A[0,0]; T[] -> A[0,1]}", 1))
+	isl_ctx_reset_stats(ctx);
+	schedule = schedule_with_threads(ctx, str, n_thread);
+	isl_schedule_free(schedule);
+	if (!schedule || isl_ctx_get_stats(ctx, &stats) < 0)
 		return -1;
-	if (test_plain_injective(ctx, "{S[] -> A[0,0]; T[] -> A[1,0]}", 1))
+	return stats.schedule_lp_solves;
+}
+
+/* Perform scheduling tests while scheduling the weakly connected
+ * components separately and check that the schedule computed
+ * for schedule_components_str does not depend on the number of threads.
+ * Also check that the schedule LPs solved by the worker threads
+ * are accounted for in the statistics of "ctx".
+ */
+static int test_schedule_threads(isl_ctx *ctx)
+{
+	int threads;
+	int r;
+	long n1, n4;
+	isl_schedule *s1, *s2;
+	isl_bool equal;
+
+	threads = isl_options_get_schedule_threads(ctx);
+	isl_options_set_schedule_threads(ctx, 2);
+	r = test_schedule(ctx);
+	isl_options_set_schedule_threads(ctx, threads);
+	if (r < 0)
 		return -1;
 
-	str = "{S[] -> A[0,0]; T[] -> A[0,1]; U[] -> A[1,0]}";
-	if (test_plain_injective(ctx, str, 1))
+	s1 = schedule_with_threads(ctx, schedule_components_str, 2);
+	s2 = schedule_with_threads(ctx, schedule_components_str, 4);
+	isl_options_set_schedule_threads(ctx, threads);
+
+	equal = isl_schedule_plain_is_equal(s1, s2);
+	isl_schedule_free(s1);
+	isl_schedule_free(s2);
+	if (equal < 0)
 		return -1;
-	str = "{S[] -> A[0,0]; T[] -> A[0,1]; U[] -> A[0,0]}";
-	if (test_plain_injective(ctx, str, 0))
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"threads produce different schedule", return -1);
+
+	n1 = count_schedule_lp_solves(ctx, schedule_components_str, 1);
+	n4 = count_schedule_lp_solves(ctx, schedule_components_str, 4);
+	isl_options_set_schedule_threads(ctx, threads);
+	if (n1 < 0 || n4 < 0)
 		return -1;
+	if (n1 != n4)
+		isl_die(ctx, isl_error_unknown,
+			"statistics of threads not accounted for", return -1);
 
 	return 0;
 }
 
-#undef BASE
-#define BASE	aff
-#include "isl_test_plain_equal_templ.c"
+/* Compute a schedule for the schedule constraints described by "str"
+ * using "n_thread" threads for computing the coefficients
+ * of valid constraints on the dependence relations and
+ * the given scheduling algorithm.
+ */
+static __isl_give isl_schedule *schedule_with_coefficients_threads(
+	isl_ctx *ctx, const char *str, int n_thread, int algorithm)
+{
+	isl_schedule_constraints *sc;
+	isl_schedule *schedule;
 
-#undef BASE
-#define BASE	pw_multi_aff
-#include "isl_test_plain_equal_templ.c"
+	isl_options_set_schedule_coefficients_threads(ctx, n_thread);
+	isl_options_set_schedule_algorithm(ctx, algorithm);
+	sc = isl_schedule_constraints_read_from_str(ctx, str);
+	schedule = isl_schedule_constraints_compute_schedule(sc);
+	isl_options_set_schedule_algorithm(ctx, ISL_SCHEDULE_ALGORITHM_ISL);
+	isl_options_set_schedule_coefficients_threads(ctx, 0);
 
-#undef BASE
-#define BASE	union_pw_aff
-#include "isl_test_plain_equal_templ.c"
+	return schedule;
+}
 
-/* Basic tests on isl_union_pw_aff.
- *
- * In particular, check that isl_union_pw_aff_aff_on_domain
- * aligns the parameters of the input objects and
- * that isl_union_pw_aff_param_on_domain_id properly
- * introduces the parameter.
+/* Check that the schedule computed for the schedule constraints
+ * described by "str" using the given scheduling algorithm
+ * does not depend on whether the coefficients of valid constraints
+ * on the dependence relations are computed on several threads.
  */
-static int test_upa(isl_ctx *ctx)
+static int test_schedule_coefficients_threads_str(isl_ctx *ctx,
+	const char *str, int algorithm)
 {
-	const char *str;
-	isl_id *id;
-	isl_aff *aff;
-	isl_union_set *domain;
-	isl_union_pw_aff *upa;
-	isl_stat ok;
+	isl_schedule *s1, *s2;
+	isl_bool equal;
 
-	aff = isl_aff_read_from_str(ctx, "[N] -> { [N] }");
-	str = "[M] -> { A[i] : 0 <= i < M; B[] }";
-	domain = isl_union_set_read_from_str(ctx, str);
-	upa = isl_union_pw_aff_aff_on_domain(domain, aff);
-	str = "[N, M] -> { A[i] -> [N] : 0 <= i < M; B[] -> [N] }";
-	ok = union_pw_aff_check_plain_equal(upa, str);
-	isl_union_pw_aff_free(upa);
-	if (ok < 0)
+	s1 = schedule_with_coefficients_threads(ctx, str, 0, algorithm);
+	s2 = schedule_with_coefficients_threads(ctx, str, 3, algorithm);
+	equal = isl_schedule_plain_is_equal(s1, s2);
+	isl_schedule_free(s1);
+	isl_schedule_free(s2);
+	if (equal < 0)
 		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"threads produce different schedule", return -1);
 
-	id = isl_id_alloc(ctx, "N", NULL);
-	str = "[M] -> { A[i] : 0 <= i < M; B[] }";
-	domain = isl_union_set_read_from_str(ctx, str);
-	upa = isl_union_pw_aff_param_on_domain_id(domain, id);
-	str = "[N, M] -> { A[i] -> [N] : 0 <= i < M; B[] -> [N] }";
-	ok = union_pw_aff_check_plain_equal(upa, str);
-	isl_union_pw_aff_free(upa);
-	if (ok < 0)
+	return 0;
+}
+
+/* Check that computing the coefficients of valid constraints
+ * on the dependence relations on several threads
+ * does not affect the computed schedules,
+ * both for the isl scheduling algorithm, which sets up LP problems
+ * from the individual edges, and for Feautrier's algorithm,
+ * which sets up LP problems for carrying dependences.
+ */
+static int test_schedule_coefficients_threads(isl_ctx *ctx)
+{
+	const char *str;
+
+	str = "{ domain: \"[N] -> { A[i, j] : 0 <= i, j < N; "
+		"B[i] : 0 <= i < N; C[i, j] : 0 <= i < N and 0 <= j < i }\", "
+		"validity: \"{ A[i, j] -> A[i + 1, j]; A[i, j] -> A[i, j + 1]; "
+		"A[i, j] -> B[i]; B[i] -> C[i, j]; C[i, j] -> C[i + 1, j] }\", "
+		"proximity: \"{ A[i, j] -> B[i]; C[i, j] -> C[i, j + 1] }\" }";
+	if (test_schedule_coefficients_threads_str(ctx, str,
+					ISL_SCHEDULE_ALGORITHM_ISL) < 0)
+		return -1;
+	if (test_schedule_coefficients_threads_str(ctx, str,
+					ISL_SCHEDULE_ALGORITHM_FEAUTRIER) < 0)
 		return -1;
 
 	return 0;
 }
 
-struct {
-	__isl_give isl_aff *(*fn)(__isl_take isl_aff *aff1,
-				__isl_take isl_aff *aff2);
-} aff_bin_op[] = {
-	['+'] = { &isl_aff_add },
-	['-'] = { &isl_aff_sub },
-	['*'] = { &isl_aff_mul },
-	['/'] = { &isl_aff_div },
-};
+/* Check that isl_schedule_constraints_recompute_schedule reuses
+ * the schedules of the unchanged weakly connected components
+ * after a statement has been added and that the result is the same
+ * as when scheduling the components separately from scratch.
+ */
+static int test_schedule_recompute(isl_ctx *ctx)
+{
+	const char *str1, *str2;
+	int threads;
+	isl_schedule_constraints *sc1, *sc2;
+	isl_schedule *s1, *s2, *s3;
+	struct isl_stats stats;
+	isl_bool equal;
 
-struct {
-	const char *arg1;
-	unsigned char op;
-	const char *arg2;
-	const char *res;
-} aff_bin_tests[] = {
-	{ "{ [i] -> [i] }", '+', "{ [i] -> [i] }",
-	  "{ [i] -> [2i] }" },
-	{ "{ [i] -> [i] }", '-', "{ [i] -> [i] }",
-	  "{ [i] -> [0] }" },
-	{ "{ [i] -> [i] }", '*', "{ [i] -> [2] }",
-	  "{ [i] -> [2i] }" },
-	{ "{ [i] -> [2] }", '*', "{ [i] -> [i] }",
-	  "{ [i] -> [2i] }" },
-	{ "{ [i] -> [i] }", '/', "{ [i] -> [2] }",
-	  "{ [i] -> [i/2] }" },
-	{ "{ [i] -> [2i] }", '/', "{ [i] -> [2] }",
-	  "{ [i] -> [i] }" },
-	{ "{ [i] -> [i] }", '+', "{ [i] -> [NaN] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [i] }", '-', "{ [i] -> [NaN] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [i] }", '*', "{ [i] -> [NaN] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [2] }", '*', "{ [i] -> [NaN] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [i] }", '/', "{ [i] -> [NaN] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [2] }", '/', "{ [i] -> [NaN] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [NaN] }", '+', "{ [i] -> [i] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [NaN] }", '-', "{ [i] -> [i] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [NaN] }", '*', "{ [i] -> [2] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [NaN] }", '*', "{ [i] -> [i] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [NaN] }", '/', "{ [i] -> [2] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [NaN] }", '/', "{ [i] -> [i] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [i] }", '/', "{ [i] -> [0] }",
-	  "{ [i] -> [NaN] }" },
-};
+	str1 = "{ domain: \"[N] -> { A[i] : 0 <= i < N; B[i] : 0 <= i < N; "
+		"C[i, j] : 0 <= i, j < N }\", "
+		"validity: \"{ A[i] -> A[i + 1]; C[i, j] -> C[i + 1, j] }\", "
+		"proximity: \"{ A[i] -> B[i] }\" }";
+	str2 = "{ domain: \"[N] -> { A[i] : 0 <= i < N; B[i] : 0 <= i < N; "
+		"C[i, j] : 0 <= i, j < N; F[i] : 0 <= i < N }\", "
+		"validity: \"{ A[i] -> A[i + 1]; C[i, j] -> C[i + 1, j]; "
+		"F[i] -> F[i + 1] }\", "
+		"proximity: \"{ A[i] -> B[i] }\" }";
+
+	threads = isl_options_get_schedule_threads(ctx);
+	s1 = schedule_with_threads(ctx, str1, 2);
+	s3 = schedule_with_threads(ctx, str2, 2);
+	isl_options_set_schedule_threads(ctx, threads);
+
+	sc1 = isl_schedule_constraints_read_from_str(ctx, str1);
+	sc2 = isl_schedule_constraints_read_from_str(ctx, str2);
+	isl_ctx_reset_stats(ctx);
+	s2 = isl_schedule_constraints_recompute_schedule(sc2, sc1, s1);
+	if (isl_ctx_get_stats(ctx, &stats) < 0)
+		s2 = isl_schedule_free(s2);
+
+	equal = isl_schedule_plain_is_equal(s2, s3);
+	isl_schedule_free(s2);
+	isl_schedule_free(s3);
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"recomputed schedule is not equal to fresh schedule",
+			return -1);
+	if (stats.schedule_component_reuses != 2)
+		isl_die(ctx, isl_error_unknown, "components not reused",
+			return -1);
 
-/* Perform some basic tests of binary operations on isl_aff objects.
+	return 0;
+}
+
+/* An external scheduler LP solver that returns a rational representation
+ * of an arbitrary point in "lp" with all variables taking distinct
+ * positive values, such that the corresponding schedule coefficients
+ * are non-zero.
+ * "user" points to the number of calls.
  */
-static int test_bin_aff(isl_ctx *ctx)
+static __isl_give isl_vec *distinct_lp_backend(__isl_keep isl_basic_set *lp,
+	void *user)
 {
 	int i;
-	isl_aff *aff1, *aff2, *res;
-	__isl_give isl_aff *(*fn)(__isl_take isl_aff *aff1,
-				__isl_take isl_aff *aff2);
-	int ok;
+	int *n_call = user;
+	isl_size dim;
+	isl_basic_set *bset;
+	isl_vec *sol;
 
-	for (i = 0; i < ARRAY_SIZE(aff_bin_tests); ++i) {
-		aff1 = isl_aff_read_from_str(ctx, aff_bin_tests[i].arg1);
-		aff2 = isl_aff_read_from_str(ctx, aff_bin_tests[i].arg2);
-		res = isl_aff_read_from_str(ctx, aff_bin_tests[i].res);
-		fn = aff_bin_op[aff_bin_tests[i].op].fn;
-		aff1 = fn(aff1, aff2);
-		if (isl_aff_is_nan(res))
-			ok = isl_aff_is_nan(aff1);
-		else
-			ok = isl_aff_plain_is_equal(aff1, res);
-		isl_aff_free(aff1);
-		isl_aff_free(res);
-		if (ok < 0)
-			return -1;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
+	++*n_call;
+	dim = isl_basic_set_dim(lp, isl_dim_set);
+	if (dim < 0)
+		return NULL;
+	bset = isl_basic_set_copy(lp);
+	for (i = 0; i < dim; ++i) {
+		isl_constraint *c;
+
+		c = isl_constraint_alloc_inequality(
+			isl_local_space_from_space(isl_basic_set_get_space(lp)));
+		c = isl_constraint_set_coefficient_si(c, isl_dim_set, i, 1);
+		c = isl_constraint_set_constant_si(c, -1 - i);
+		bset = isl_basic_set_add_constraint(bset, c);
 	}
-
-	return 0;
+	sol = isl_basic_set_sample_vec(bset);
+	if (!sol || sol->size == 0)
+		return sol;
+	isl_seq_scale(sol->el, sol->el, sol->ctx->two, sol->size);
+	return sol;
 }
 
-struct {
-	__isl_give isl_pw_aff *(*fn)(__isl_take isl_pw_aff *pa1,
-				     __isl_take isl_pw_aff *pa2);
-} pw_aff_bin_op[] = {
-	['m'] = { &isl_pw_aff_min },
-	['M'] = { &isl_pw_aff_max },
-};
-
-/* Inputs for binary isl_pw_aff operation tests.
- * "arg1" and "arg2" are the two arguments, "op" identifies the operation
- * defined by pw_aff_bin_op, and "res" is the expected result.
+/* An external scheduler LP solver that always returns the origin,
+ * which never satisfies the non-triviality constraints.
+ * "user" points to the number of calls.
  */
-struct {
-	const char *arg1;
-	unsigned char op;
-	const char *arg2;
-	const char *res;
-} pw_aff_bin_tests[] = {
-	{ "{ [i] -> [i] }", 'm', "{ [i] -> [i] }",
-	  "{ [i] -> [i] }" },
-	{ "{ [i] -> [i] }", 'M', "{ [i] -> [i] }",
-	  "{ [i] -> [i] }" },
-	{ "{ [i] -> [i] }", 'm', "{ [i] -> [0] }",
-	  "{ [i] -> [i] : i <= 0; [i] -> [0] : i > 0 }" },
-	{ "{ [i] -> [i] }", 'M', "{ [i] -> [0] }",
-	  "{ [i] -> [i] : i >= 0; [i] -> [0] : i < 0 }" },
-	{ "{ [i] -> [i] }", 'm', "{ [i] -> [NaN] }",
-	  "{ [i] -> [NaN] }" },
-	{ "{ [i] -> [NaN] }", 'm', "{ [i] -> [i] }",
-	  "{ [i] -> [NaN] }" },
-};
+static __isl_give isl_vec *zero_lp_backend(__isl_keep isl_basic_set *lp,
+	void *user)
+{
+	int *n_call = user;
+	isl_size dim;
 
-/* Perform some basic tests of binary operations on isl_pw_aff objects.
+	++*n_call;
+	dim = isl_basic_set_dim(lp, isl_dim_all);
+	if (dim < 0)
+		return NULL;
+	return isl_vec_set_si(isl_vec_alloc(isl_basic_set_get_ctx(lp),
+						1 + dim), 0);
+}
+
+/* Check that an external scheduler LP solver is used when it produces
+ * valid solutions and that the built-in solver is used
+ * when it does not.  In the latter case, the result should be
+ * the same as if no external solver had been set.
  */
-static int test_bin_pw_aff(isl_ctx *ctx)
+static int test_schedule_lp_backend(isl_ctx *ctx)
 {
-	int i;
-	isl_bool ok;
-	isl_pw_aff *pa1, *pa2, *res;
+	const char *str;
+	int n_call;
+	isl_schedule_constraints *sc;
+	isl_schedule *s1, *s2;
+	struct isl_stats stats;
+	isl_bool equal;
 
-	for (i = 0; i < ARRAY_SIZE(pw_aff_bin_tests); ++i) {
-		pa1 = isl_pw_aff_read_from_str(ctx, pw_aff_bin_tests[i].arg1);
-		pa2 = isl_pw_aff_read_from_str(ctx, pw_aff_bin_tests[i].arg2);
-		res = isl_pw_aff_read_from_str(ctx, pw_aff_bin_tests[i].res);
-		pa1 = pw_aff_bin_op[pw_aff_bin_tests[i].op].fn(pa1, pa2);
-		if (isl_pw_aff_involves_nan(res))
-			ok = isl_pw_aff_involves_nan(pa1);
-		else
-			ok = isl_pw_aff_plain_is_equal(pa1, res);
-		isl_pw_aff_free(pa1);
-		isl_pw_aff_free(res);
-		if (ok < 0)
-			return -1;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
-	}
+	str = "{ domain: \"[N] -> { A[i] : 0 <= i < N; B[i] : 0 <= i < N }\", "
+		"validity: \"{ A[i] -> A[i + 1]; A[i] -> B[i] }\" }";
+
+	n_call = 0;
+	isl_options_set_schedule_lp_backend(ctx, &distinct_lp_backend, &n_call);
+	sc = isl_schedule_constraints_read_from_str(ctx, str);
+	isl_ctx_reset_stats(ctx);
+	s1 = isl_schedule_constraints_compute_schedule(sc);
+	isl_options_set_schedule_lp_backend(ctx, NULL, NULL);
+	isl_schedule_free(s1);
+	if (!s1 || isl_ctx_get_stats(ctx, &stats) < 0)
+		return -1;
+	if (n_call == 0 || stats.schedule_lp_backend_accepts == 0)
+		isl_die(ctx, isl_error_unknown, "external LP solver not used",
+			return -1);
+
+	sc = isl_schedule_constraints_read_from_str(ctx, str);
+	s1 = isl_schedule_constraints_compute_schedule(sc);
+	n_call = 0;
+	isl_options_set_schedule_lp_backend(ctx, &zero_lp_backend, &n_call);
+	sc = isl_schedule_constraints_read_from_str(ctx, str);
+	isl_ctx_reset_stats(ctx);
+	s2 = isl_schedule_constraints_compute_schedule(sc);
+	isl_options_set_schedule_lp_backend(ctx, NULL, NULL);
+	if (isl_ctx_get_stats(ctx, &stats) < 0)
+		s2 = isl_schedule_free(s2);
+	equal = isl_schedule_plain_is_equal(s1, s2);
+	isl_schedule_free(s1);
+	isl_schedule_free(s2);
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"invalid external solution not rejected", return -1);
+	if (n_call == 0 ||
+	    stats.schedule_lp_backend_rejects != n_call ||
+	    stats.schedule_lp_backend_accepts != 0)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected external LP solver statistics", return -1);
 
 	return 0;
 }
 
-/* Inputs for basic tests of test operations on
- * isl_union_pw_multi_aff objects.
- * "fn" is the function that is being tested.
- * "arg" is a string description of the input.
- * "res" is the expected result.
+/* A transport for offloading the computation of schedules
+ * that computes the schedule for the schedule constraints "request"
+ * in a separate isl_ctx, as a remote worker would.
+ * "user" points to the number of calls.
  */
-static struct {
-	isl_bool (*fn)(__isl_keep isl_union_pw_multi_aff *upma1);
-	const char *arg;
-	isl_bool res;
-} upma_test_tests[] = {
-	{ &isl_union_pw_multi_aff_involves_nan, "{ A[] -> [0]; B[0] -> [1] }",
-	  isl_bool_false },
-	{ &isl_union_pw_multi_aff_involves_nan, "{ A[] -> [NaN]; B[0] -> [1] }",
-	  isl_bool_true },
-	{ &isl_union_pw_multi_aff_involves_nan, "{ A[] -> [0]; B[0] -> [NaN] }",
-	  isl_bool_true },
-	{ &isl_union_pw_multi_aff_involves_nan,
-	  "{ A[] -> [0]; B[0] -> [1, NaN, 5] }",
-	  isl_bool_true },
-	{ &isl_union_pw_multi_aff_involves_locals,
-	  "{ A[] -> [0]; B[0] -> [1] }",
-	  isl_bool_false },
-	{ &isl_union_pw_multi_aff_involves_locals,
-	  "{ A[] -> [0]; B[x] -> [1] : x mod 2 = 0 }",
-	  isl_bool_true },
-	{ &isl_union_pw_multi_aff_involves_locals,
-	  "{ A[] -> [0]; B[x] -> [x // 2] }",
-	  isl_bool_true },
-	{ &isl_union_pw_multi_aff_involves_locals,
-	  "{ A[i] -> [i // 2]; B[0] -> [1] }",
-	  isl_bool_true },
-};
+static __isl_give char *loopback_offload(isl_ctx *ctx, const char *request,
+	void *user)
+{
+	int *n_call = user;
+	isl_ctx *worker;
+	isl_schedule_constraints *sc;
+	isl_schedule *schedule;
+	isl_printer *p;
+	char *reply;
 
-/* Perform some basic tests of test operations on
- * isl_union_pw_multi_aff objects.
+	++*n_call;
+	worker = isl_ctx_alloc();
+	if (!worker)
+		return NULL;
+	sc = isl_schedule_constraints_read_from_binary_str(worker, request);
+	schedule = isl_schedule_constraints_compute_schedule(sc);
+	p = isl_printer_to_str(worker);
+	p = isl_printer_set_output_format(p, ISL_FORMAT_BINARY);
+	p = isl_printer_print_schedule(p, schedule);
+	reply = isl_printer_get_str(p);
+	isl_printer_free(p);
+	isl_schedule_free(schedule);
+	isl_ctx_free(worker);
+
+	return reply;
+}
+
+/* A transport for offloading the computation of schedules
+ * that returns a schedule on the wrong domain.
+ * "user" points to the number of calls.
  */
-static isl_stat test_upma_test(isl_ctx *ctx)
+static __isl_give char *wrong_offload(isl_ctx *ctx, const char *request,
+	void *user)
 {
-	int i;
-	isl_union_pw_multi_aff *upma;
-	isl_bool res;
+	int *n_call = user;
+	isl_schedule *schedule;
+	isl_printer *p;
+	char *reply;
 
-	for (i = 0; i < ARRAY_SIZE(upma_test_tests); ++i) {
-		const char *str;
+	++*n_call;
+	schedule = isl_schedule_read_from_str(ctx,
+					"{ domain: \"{ C[i] : 0 <= i < 10 }\" }");
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_set_output_format(p, ISL_FORMAT_BINARY);
+	p = isl_printer_print_schedule(p, schedule);
+	reply = isl_printer_get_str(p);
+	isl_printer_free(p);
+	isl_schedule_free(schedule);
 
-		str = upma_test_tests[i].arg;
-		upma = isl_union_pw_multi_aff_read_from_str(ctx, str);
-		res = upma_test_tests[i].fn(upma);
-		isl_union_pw_multi_aff_free(upma);
-		if (res < 0)
-			return isl_stat_error;
-		if (res != upma_test_tests[i].res)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return isl_stat_error);
-	}
+	return reply;
+}
 
-	return isl_stat_ok;
+/* A transport for offloading the computation of schedules
+ * that returns a reply that cannot be parsed.
+ * This transport may be called from several threads at the same time
+ * and therefore does not update "user".
+ */
+static __isl_give char *garbage_offload(isl_ctx *ctx, const char *request,
+	void *user)
+{
+	return strdup("garbage");
 }
 
-struct {
-	__isl_give isl_union_pw_multi_aff *(*fn)(
-		__isl_take isl_union_pw_multi_aff *upma1,
-		__isl_take isl_union_pw_multi_aff *upma2);
-	const char *arg1;
-	const char *arg2;
-	const char *res;
-} upma_bin_tests[] = {
-	{ &isl_union_pw_multi_aff_add, "{ A[] -> [0]; B[0] -> [1] }",
-	  "{ B[x] -> [2] : x >= 0 }", "{ B[0] -> [3] }" },
-	{ &isl_union_pw_multi_aff_union_add, "{ A[] -> [0]; B[0] -> [1] }",
-	  "{ B[x] -> [2] : x >= 0 }",
-	  "{ A[] -> [0]; B[0] -> [3]; B[x] -> [2] : x >= 1 }" },
-	{ &isl_union_pw_multi_aff_pullback_union_pw_multi_aff,
-	  "{ A[] -> B[0]; C[x] -> B[1] : x < 10; C[y] -> B[2] : y >= 10 }",
-	  "{ D[i] -> A[] : i < 0; D[i] -> C[i + 5] : i >= 0 }",
-	  "{ D[i] -> B[0] : i < 0; D[i] -> B[1] : 0 <= i < 5; "
-	    "D[i] -> B[2] : i >= 5 }" },
-	{ &isl_union_pw_multi_aff_union_add, "{ B[x] -> A[1] : x <= 0 }",
-	  "{ B[x] -> C[2] : x > 0 }",
-	  "{ B[x] -> A[1] : x <= 0; B[x] -> C[2] : x > 0 }" },
-	{ &isl_union_pw_multi_aff_union_add, "{ B[x] -> A[1] : x <= 0 }",
-	  "{ B[x] -> A[2] : x >= 0 }",
-	  "{ B[x] -> A[1] : x < 0; B[x] -> A[2] : x > 0; B[0] -> A[3] }" },
-	{
-  &isl_union_pw_multi_aff_preimage_domain_wrapped_domain_union_pw_multi_aff,
-	  "{ B[x] -> C[x + 2] }",
-	  "{ D[y] -> B[2y] }",
-	  "{ }" },
-	{
-  &isl_union_pw_multi_aff_preimage_domain_wrapped_domain_union_pw_multi_aff,
-	  "{ [A[x] -> B[x + 1]] -> C[x + 2] }",
-	  "{ D[y] -> B[2y] }",
-	  "{ }" },
-	{
-  &isl_union_pw_multi_aff_preimage_domain_wrapped_domain_union_pw_multi_aff,
-	  "{ [A[x] -> B[x + 1]] -> C[x + 2]; B[x] -> C[x + 2] }",
-	  "{ D[y] -> A[2y] }",
-	  "{ [D[y] -> B[2y + 1]] -> C[2y + 2] }" },
-	{
-  &isl_union_pw_multi_aff_preimage_domain_wrapped_domain_union_pw_multi_aff,
-	  "{ T[A[x] -> B[x + 1]] -> C[x + 2]; B[x] -> C[x + 2] }",
-	  "{ D[y] -> A[2y] }",
-	  "{ T[D[y] -> B[2y + 1]] -> C[2y + 2] }" },
-};
-
-/* Perform some basic tests of binary operations on
- * isl_union_pw_multi_aff objects.
+/* Compute a schedule for the schedule constraints described by "str"
+ * with the schedule_offload transport set to "fn" and
+ * store the statistics of "ctx" in "stats".
  */
-static int test_bin_upma(isl_ctx *ctx)
+static __isl_give isl_schedule *schedule_offload(isl_ctx *ctx,
+	const char *str,
+	__isl_give char *(*fn)(isl_ctx *ctx, const char *sc, void *user),
+	void *user, struct isl_stats *stats)
 {
-	int i;
-	isl_union_pw_multi_aff *upma1, *upma2, *res;
-	int ok;
+	isl_schedule_constraints *sc;
+	isl_schedule *schedule;
 
-	for (i = 0; i < ARRAY_SIZE(upma_bin_tests); ++i) {
-		upma1 = isl_union_pw_multi_aff_read_from_str(ctx,
-							upma_bin_tests[i].arg1);
-		upma2 = isl_union_pw_multi_aff_read_from_str(ctx,
-							upma_bin_tests[i].arg2);
-		res = isl_union_pw_multi_aff_read_from_str(ctx,
-							upma_bin_tests[i].res);
-		upma1 = upma_bin_tests[i].fn(upma1, upma2);
-		ok = isl_union_pw_multi_aff_plain_is_equal(upma1, res);
-		isl_union_pw_multi_aff_free(upma1);
-		isl_union_pw_multi_aff_free(res);
-		if (ok < 0)
-			return -1;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
-	}
+	isl_options_set_schedule_offload(ctx, fn, user);
+	sc = isl_schedule_constraints_read_from_str(ctx, str);
+	isl_ctx_reset_stats(ctx);
+	schedule = isl_schedule_constraints_compute_schedule(sc);
+	isl_options_set_schedule_offload(ctx, NULL, NULL);
+	if (isl_ctx_get_stats(ctx, stats) < 0)
+		schedule = isl_schedule_free(schedule);
 
-	return 0;
+	return schedule;
 }
 
-struct {
-	__isl_give isl_union_pw_multi_aff *(*fn)(
-		__isl_take isl_union_pw_multi_aff *upma1,
-		__isl_take isl_union_pw_multi_aff *upma2);
-	const char *arg1;
-	const char *arg2;
-} upma_bin_fail_tests[] = {
-	{ &isl_union_pw_multi_aff_union_add, "{ B[x] -> A[1] : x <= 0 }",
-	  "{ B[x] -> C[2] : x >= 0 }" },
-};
-
-/* Perform some basic tests of binary operations on
- * isl_union_pw_multi_aff objects that are expected to fail.
+/* Check that a reply of the transport that cannot be parsed
+ * is rejected without reporting an error, even if the components
+ * are scheduled in several threads and errors would otherwise abort,
+ * and that the rejections are accounted for in the statistics of "ctx".
+ * The schedule computed for "str" should be equal to "local".
  */
-static int test_bin_upma_fail(isl_ctx *ctx)
+static int test_schedule_offload_garbage(isl_ctx *ctx, const char *str,
+	__isl_keep isl_schedule *local)
 {
-	int i, n;
-	isl_union_pw_multi_aff *upma1, *upma2;
-	int on_error;
+	int threads, on_error;
+	isl_schedule *schedule;
+	struct isl_stats stats;
+	isl_bool equal;
 
+	threads = isl_options_get_schedule_threads(ctx);
 	on_error = isl_options_get_on_error(ctx);
-	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
-	n = ARRAY_SIZE(upma_bin_fail_tests);
-	for (i = 0; i < n; ++i) {
-		upma1 = isl_union_pw_multi_aff_read_from_str(ctx,
-						upma_bin_fail_tests[i].arg1);
-		upma2 = isl_union_pw_multi_aff_read_from_str(ctx,
-						upma_bin_fail_tests[i].arg2);
-		upma1 = upma_bin_fail_tests[i].fn(upma1, upma2);
-		isl_union_pw_multi_aff_free(upma1);
-		if (upma1)
-			break;
-	}
+	isl_options_set_schedule_threads(ctx, 2);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_ABORT);
+	schedule = schedule_offload(ctx, str, &garbage_offload, NULL, &stats);
 	isl_options_set_on_error(ctx, on_error);
-	if (i < n)
+	isl_options_set_schedule_threads(ctx, threads);
+	equal = isl_schedule_plain_is_equal(schedule, local);
+	isl_schedule_free(schedule);
+	if (equal < 0)
+		return -1;
+	if (!equal)
 		isl_die(ctx, isl_error_unknown,
-			"operation not expected to succeed", return -1);
+			"offloaded schedule differs from local schedule",
+			return -1);
+	if (stats.schedule_offload_accepts != 0 ||
+	    stats.schedule_offload_rejects != 2)
+		isl_die(ctx, isl_error_unknown,
+			"invalid offload reply not rejected", return -1);
 
 	return 0;
 }
 
-/* Inputs for basic tests of binary operations on
- * pairs of isl_union_pw_multi_aff and isl_union_set objects.
- * "fn" is the function that is being tested.
- * "arg1" and "arg2" are string descriptions of the inputs.
- * "res" is a string description of the expected result.
- */
-struct {
-	__isl_give isl_union_pw_multi_aff *(*fn)(
-		__isl_take isl_union_pw_multi_aff *upma,
-		__isl_take isl_union_set *uset);
-	const char *arg1;
-	const char *arg2;
-	const char *res;
-} upma_uset_tests[] = {
-	{ &isl_union_pw_multi_aff_intersect_domain_wrapped_range,
-	  "{ A[i] -> B[i] }", "{ B[0] }",
-	  "{ }" },
-	{ &isl_union_pw_multi_aff_intersect_domain_wrapped_domain,
-	  "{ [A[i] -> B[i]] -> C[i + 1] }", "{ A[1]; B[0] }",
-	  "{ [A[1] -> B[1]] -> C[2] }" },
-	{ &isl_union_pw_multi_aff_intersect_domain_wrapped_range,
-	  "{ [A[i] -> B[i]] -> C[i + 1] }", "{ A[1]; B[0] }",
-	  "{ [A[0] -> B[0]] -> C[1] }" },
-	{ &isl_union_pw_multi_aff_intersect_domain_wrapped_range,
-	  "{ [A[i] -> B[i]] -> C[i + 1] }", "[N] -> { B[N] }",
-	  "[N] -> { [A[N] -> B[N]] -> C[N + 1] }" },
-	{ &isl_union_pw_multi_aff_intersect_domain_wrapped_range,
-	  "[M] -> { [A[M] -> B[M]] -> C[M + 1] }", "[N] -> { B[N] }",
-	  "[N, M] -> { [A[N] -> B[N]] -> C[N + 1] : N = M }" },
-	{ &isl_union_pw_multi_aff_intersect_domain_wrapped_range,
-	  "{ [A[] -> B[]] -> C[]; N[A[] -> B[]] -> D[]; [B[] -> A[]] -> E[] }",
-	  "{ B[] }",
-	  "{ [A[] -> B[]] -> C[]; N[A[] -> B[]] -> D[] }" },
-};
-
-/* Perform some basic tests of binary operations on
- * pairs of isl_union_pw_multi_aff and isl_union_set objects.
+/* Check that the schedules of the weakly connected components
+ * are obtained from the transport set through
+ * isl_options_set_schedule_offload, if possible, and
+ * that the result is the same as when they are computed locally.
+ * In particular, a transport that fails to return a valid schedule
+ * should result in the schedules being computed locally.
  */
-static isl_stat test_upma_uset(isl_ctx *ctx)
+static int test_schedule_offload(isl_ctx *ctx)
 {
-	int i;
-	isl_bool ok;
-	isl_union_pw_multi_aff *upma, *res;
-	isl_union_set *uset;
+	const char *str;
+	int n_call, n_wrong;
+	isl_schedule *s1, *s2;
+	struct isl_stats stats1, stats2;
+	isl_bool equal;
+	int r;
 
-	for (i = 0; i < ARRAY_SIZE(upma_uset_tests); ++i) {
-		upma = isl_union_pw_multi_aff_read_from_str(ctx,
-						    upma_uset_tests[i].arg1);
-		uset = isl_union_set_read_from_str(ctx,
-						    upma_uset_tests[i].arg2);
-		res = isl_union_pw_multi_aff_read_from_str(ctx,
-						    upma_uset_tests[i].res);
-		upma = upma_uset_tests[i].fn(upma, uset);
-		ok = isl_union_pw_multi_aff_plain_is_equal(upma, res);
-		isl_union_pw_multi_aff_free(upma);
-		isl_union_pw_multi_aff_free(res);
-		if (ok < 0)
-			return isl_stat_error;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return isl_stat_error);
-	}
+	str = "{ domain: \"[N] -> { A[i] : 0 <= i < N; B[i] : 0 <= i < N; "
+		"C[i] : 0 <= i < N }\", "
+		"validity: \"{ A[i] -> A[i + 1]; A[i] -> B[i]; "
+		"C[i] -> C[i + 1] }\" }";
+
+	n_call = 0;
+	s1 = schedule_offload(ctx, str, &loopback_offload, &n_call, &stats1);
+	n_wrong = 0;
+	s2 = schedule_offload(ctx, str, &wrong_offload, &n_wrong, &stats2);
+	equal = isl_schedule_plain_is_equal(s1, s2);
+	r = equal < 0 ? -1 : test_schedule_offload_garbage(ctx, str, s2);
+	isl_schedule_free(s1);
+	isl_schedule_free(s2);
+	if (r < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"offloaded schedule differs from local schedule",
+			return -1);
+	if (n_call != 2 || stats1.schedule_offload_accepts != 2 ||
+	    stats1.schedule_offload_rejects != 0)
+		isl_die(ctx, isl_error_unknown,
+			"components not offloaded", return -1);
+	if (n_wrong != 2 || stats2.schedule_offload_accepts != 0 ||
+	    stats2.schedule_offload_rejects != 2)
+		isl_die(ctx, isl_error_unknown,
+			"invalid offloaded schedule not rejected", return -1);
 
-	return isl_stat_ok;
+	return 0;
 }
 
-/* Inputs for basic tests of unary operations on isl_multi_pw_aff objects.
- * "fn" is the function that is tested.
- * "arg" is a string description of the input.
- * "res" is a string description of the expected result.
- */
-struct {
-	__isl_give isl_multi_pw_aff *(*fn)(__isl_take isl_multi_pw_aff *mpa);
-	const char *arg;
-	const char *res;
-} mpa_un_tests[] = {
-	{ &isl_multi_pw_aff_range_factor_domain,
-	  "{ A[x] -> [B[(1 : x >= 5)] -> C[(2 : x <= 10)]] }",
-	  "{ A[x] -> B[(1 : x >= 5)] }" },
-	{ &isl_multi_pw_aff_range_factor_range,
-	  "{ A[x] -> [B[(1 : x >= 5)] -> C[(2 : x <= 10)]] }",
-	  "{ A[y] -> C[(2 : y <= 10)] }" },
-	{ &isl_multi_pw_aff_range_factor_domain,
-	  "{ A[x] -> [B[(1 : x >= 5)] -> C[]] }",
-	  "{ A[x] -> B[(1 : x >= 5)] }" },
-	{ &isl_multi_pw_aff_range_factor_range,
-	  "{ A[x] -> [B[(1 : x >= 5)] -> C[]] }",
-	  "{ A[y] -> C[] }" },
-	{ &isl_multi_pw_aff_range_factor_domain,
-	  "{ A[x] -> [B[] -> C[(2 : x <= 10)]] }",
-	  "{ A[x] -> B[] }" },
-	{ &isl_multi_pw_aff_range_factor_range,
-	  "{ A[x] -> [B[] -> C[(2 : x <= 10)]] }",
-	  "{ A[y] -> C[(2 : y <= 10)] }" },
-	{ &isl_multi_pw_aff_range_factor_domain,
-	  "{ A[x] -> [B[] -> C[]] }",
-	  "{ A[x] -> B[] }" },
-	{ &isl_multi_pw_aff_range_factor_range,
-	  "{ A[x] -> [B[] -> C[]] }",
-	  "{ A[y] -> C[] }" },
-	{ &isl_multi_pw_aff_factor_range,
-	  "{ [B[] -> C[]] }",
-	  "{ C[] }" },
-	{ &isl_multi_pw_aff_range_factor_domain,
-	  "{ A[x] -> [B[] -> C[]] : x >= 0 }",
-	  "{ A[x] -> B[] : x >= 0 }" },
-	{ &isl_multi_pw_aff_range_factor_range,
-	  "{ A[x] -> [B[] -> C[]] : x >= 0 }",
-	  "{ A[y] -> C[] : y >= 0 }" },
-	{ &isl_multi_pw_aff_factor_range,
-	  "[N] -> { [B[] -> C[]] : N >= 0 }",
-	  "[N] -> { C[] : N >= 0 }" },
-};
-
-/* Perform some basic tests of unary operations on isl_multi_pw_aff objects.
+/* Compute a schedule for the schedule constraints described by "str"
+ * using the given scheduling algorithm and schedule_budget option.
  */
-static int test_un_mpa(isl_ctx *ctx)
+static __isl_give isl_schedule *schedule_with_budget(isl_ctx *ctx,
+	const char *str, int algorithm, int budget)
 {
-	int i;
-	isl_bool ok;
-	isl_multi_pw_aff *mpa, *res;
+	isl_schedule_constraints *sc;
+	isl_schedule *schedule;
 
-	for (i = 0; i < ARRAY_SIZE(mpa_un_tests); ++i) {
-		mpa = isl_multi_pw_aff_read_from_str(ctx, mpa_un_tests[i].arg);
-		res = isl_multi_pw_aff_read_from_str(ctx, mpa_un_tests[i].res);
-		mpa = mpa_un_tests[i].fn(mpa);
-		ok = isl_multi_pw_aff_plain_is_equal(mpa, res);
-		isl_multi_pw_aff_free(mpa);
-		isl_multi_pw_aff_free(res);
-		if (ok < 0)
-			return -1;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
-	}
+	isl_options_set_schedule_algorithm(ctx, algorithm);
+	isl_options_set_schedule_budget(ctx, budget);
+	sc = isl_schedule_constraints_read_from_str(ctx, str);
+	schedule = isl_schedule_constraints_compute_schedule(sc);
+	isl_options_set_schedule_budget(ctx, 0);
+	isl_options_set_schedule_algorithm(ctx, ISL_SCHEDULE_ALGORITHM_ISL);
 
-	return 0;
+	return schedule;
 }
 
-/* Inputs for basic tests of binary operations on isl_multi_pw_aff objects.
- * "fn" is the function that is tested.
- * "arg1" and "arg2" are string descriptions of the inputs.
- * "res" is a string description of the expected result.
+/* Check that exceeding the schedule_budget option results
+ * in the schedule computed by Feautrier's algorithm and
+ * that a sufficiently large budget does not affect the result.
  */
-struct {
-	__isl_give isl_multi_pw_aff *(*fn)(
-		__isl_take isl_multi_pw_aff *mpa1,
-		__isl_take isl_multi_pw_aff *mpa2);
+static int test_schedule_budget(isl_ctx *ctx)
+{
+	const char *str;
+	isl_schedule *s1, *s2;
+	isl_bool equal;
+
+	str = "{ domain: \"[N] -> { A[i, j] : 0 <= i, j < N; "
+		"B[i] : 0 <= i < N }\", "
+		"validity: \"{ A[i, j] -> A[i + 1, j]; A[i, j] -> A[i, j + 1]; "
+		"A[i, j] -> B[i] }\", "
+		"proximity: \"{ A[i, j] -> A[i + 1, j]; A[i, j] -> B[i] }\" }";
+
+	s1 = schedule_with_budget(ctx, str, ISL_SCHEDULE_ALGORITHM_FEAUTRIER, 0);
+	s2 = schedule_with_budget(ctx, str, ISL_SCHEDULE_ALGORITHM_ISL, 1);
+	equal = isl_schedule_plain_is_equal(s1, s2);
+	isl_schedule_free(s1);
+	isl_schedule_free(s2);
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"exceeded budget does not result in fallback",
+			return -1);
+
+	s1 = schedule_with_budget(ctx, str, ISL_SCHEDULE_ALGORITHM_ISL, 0);
+	s2 = schedule_with_budget(ctx, str, ISL_SCHEDULE_ALGORITHM_ISL,
+				    1000000000);
+	equal = isl_schedule_plain_is_equal(s1, s2);
+	isl_schedule_free(s1);
+	isl_schedule_free(s2);
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"budget affects schedule", return -1);
+
+	return 0;
+}
+
+/* Compute a schedule for the schedule constraints described by "str"
+ * with the schedule_trace option set to "trace" and
+ * return everything that gets printed on stderr in the meantime.
+ * stderr is temporarily redirected to a temporary file for this purpose.
+ */
+static char *schedule_trace_output(isl_ctx *ctx, const char *str, int trace)
+{
+	FILE *file;
+	int fd;
+	int saved;
+	long size;
+	char *output;
+	isl_schedule_constraints *sc;
+	isl_schedule *schedule;
+
+	file = tmpfile();
+	if (!file)
+		isl_die(ctx, isl_error_unknown,
+			"unable to create temporary file", return NULL);
+	fflush(stderr);
+	fd = dup(fileno(stderr));
+	if (fd < 0 || dup2(fileno(file), fileno(stderr)) < 0) {
+		if (fd >= 0)
+			close(fd);
+		fclose(file);
+		isl_die(ctx, isl_error_unknown,
+			"unable to redirect stderr", return NULL);
+	}
+
+	saved = isl_options_get_schedule_trace(ctx);
+	isl_options_set_schedule_trace(ctx, trace);
+	sc = isl_schedule_constraints_read_from_str(ctx, str);
+	schedule = isl_schedule_constraints_compute_schedule(sc);
+	isl_options_set_schedule_trace(ctx, saved);
+
+	fflush(stderr);
+	dup2(fd, fileno(stderr));
+	close(fd);
+
+	isl_schedule_free(schedule);
+	size = ftell(file);
+	if (!schedule || size < 0) {
+		fclose(file);
+		return NULL;
+	}
+	output = isl_alloc_array(ctx, char, size + 1);
+	rewind(file);
+	if (output && fread(output, 1, size, file) != size) {
+		free(output);
+		output = NULL;
+	}
+	fclose(file);
+	if (output)
+		output[size] = '\0';
+
+	return output;
+}
+
+/* Count the number of occurrences of "needle" in "haystack".
+ */
+static int count_occurrences(const char *haystack, const char *needle)
+{
+	int n = 0;
+
+	while ((haystack = strstr(haystack, needle)) != NULL) {
+		n++;
+		haystack += strlen(needle);
+	}
+
+	return n;
+}
+
+/* Check that setting the schedule_trace option on a small instance
+ * results in a trace that starts with the construction
+ * of the dependence graph, followed by the detection
+ * of the strongly connected components and the computation
+ * of some schedule rows, and that each entry reports
+ * the processor time and the number of pivots.
+ * Also check that nothing is printed if the option is not set.
+ */
+static int test_schedule_trace(isl_ctx *ctx)
+{
+	const char *str;
+	char *output;
+	int n_event, ok;
+
+	str = "{ domain: \"{ A[i] : 0 <= i < 10; B[i] : 0 <= i < 10 }\", "
+		"validity: \"{ A[i] -> B[i]; A[i] -> A[i + 1] }\" }";
+
+	output = schedule_trace_output(ctx, str, 0);
+	if (!output)
+		return -1;
+	ok = output[0] == '\0';
+	free(output);
+	if (!ok)
+		isl_die(ctx, isl_error_unknown,
+			"trace printed while option not set", return -1);
+
+	output = schedule_trace_output(ctx, str, 1);
+	if (!output)
+		return -1;
+	n_event = count_occurrences(output, "- event: ");
+	ok = strstr(output, "- event: graph\n") == strchr(output, '-') &&
+		strstr(output, "  nodes: 2\n  edges: 2\n") &&
+		strstr(output, "- event: sccs\n") &&
+		strstr(output, "- event: lp\n") &&
+		n_event >= 3 &&
+		count_occurrences(output, "\n  time: ") == n_event &&
+		count_occurrences(output, "\n  pivots: ") == n_event;
+	free(output);
+	if (!ok)
+		isl_die(ctx, isl_error_unknown, "unexpected schedule trace",
+			return -1);
+
+	return 0;
+}
+
+int test_plain_injective(isl_ctx *ctx, const char *str, int injective)
+{
+	isl_union_map *umap;
+	int test;
+
+	umap = isl_union_map_read_from_str(ctx, str);
+	test = isl_union_map_plain_is_injective(umap);
+	isl_union_map_free(umap);
+	if (test < 0)
+		return -1;
+	if (test == injective)
+		return 0;
+	if (injective)
+		isl_die(ctx, isl_error_unknown,
+			"map not detected as injective", return -1);
+	else
+		isl_die(ctx, isl_error_unknown,
+			"map detected as injective", return -1);
+}
+
+int test_injective(isl_ctx *ctx)
+{
+	const char *str;
+
+	if (test_plain_injective(ctx, "{S[i,j] -> A[0]; T[i,j] -> B[1]}", 0))
+		return -1;
+	if (test_plain_injective(ctx, "{S[] -> A[0]; T[] -> B[0]}", 1))
+		return -1;
+	if (test_plain_injective(ctx, "{S[] -> A[0]; T[] -> A[1]}", 1))
+		return -1;
+	if (test_plain_injective(ctx, "{S[] -> A[0]; T[] -> A[0]}", 0))
+		return -1;
+	if (test_plain_injective(ctx, "{S[i] -> A[i,0]; T[i] -> A[i,1]}", 1))
+		return -1;
+	if (test_plain_injective(ctx, "{S[i] -> A[i]; T[i] -> A[i]}", 0))
+		return -1;
+	if (test_plain_injective(ctx, "{S[] -> A[0,0]; T[] -> A[0,1]}", 1))
+		return -1;
+	if (test_plain_injective(ctx, "{S[] -> A[0,0]; T[] -> A[1,0]}", 1))
+		return -1;
+
+	str = "{S[] -> A[0,0]; T[] -> A[0,1]; U[] -> A[1,0]}";
+	if (test_plain_injective(ctx, str, 1))
+		return -1;
+	str = "{S[] -> A[0,0]; T[] -> A[0,1]; U[] -> A[0,0]}";
+	if (test_plain_injective(ctx, str, 0))
+		return -1;
+
+	return 0;
+}
+
+#undef BASE
+#define BASE	aff
+#include "isl_test_plain_equal_templ.c"
+
+#undef BASE
+#define BASE	pw_multi_aff
+#include "isl_test_plain_equal_templ.c"
+
+#undef BASE
+#define BASE	union_pw_aff
+#include "isl_test_plain_equal_templ.c"
+
+/* Basic tests on isl_union_pw_aff.
+ *
+ * In particular, check that isl_union_pw_aff_aff_on_domain
+ * aligns the parameters of the input objects and
+ * that isl_union_pw_aff_param_on_domain_id properly
+ * introduces the parameter.
+ */
+static int test_upa(isl_ctx *ctx)
+{
+	const char *str;
+	isl_id *id;
+	isl_aff *aff;
+	isl_union_set *domain;
+	isl_union_pw_aff *upa;
+	isl_stat ok;
+
+	aff = isl_aff_read_from_str(ctx, "[N] -> { [N] }");
+	str = "[M] -> { A[i] : 0 <= i < M; B[] }";
+	domain = isl_union_set_read_from_str(ctx, str);
+	upa = isl_union_pw_aff_aff_on_domain(domain, aff);
+	str = "[N, M] -> { A[i] -> [N] : 0 <= i < M; B[] -> [N] }";
+	ok = union_pw_aff_check_plain_equal(upa, str);
+	isl_union_pw_aff_free(upa);
+	if (ok < 0)
+		return -1;
+
+	id = isl_id_alloc(ctx, "N", NULL);
+	str = "[M] -> { A[i] : 0 <= i < M; B[] }";
+	domain = isl_union_set_read_from_str(ctx, str);
+	upa = isl_union_pw_aff_param_on_domain_id(domain, id);
+	str = "[N, M] -> { A[i] -> [N] : 0 <= i < M; B[] -> [N] }";
+	ok = union_pw_aff_check_plain_equal(upa, str);
+	isl_union_pw_aff_free(upa);
+	if (ok < 0)
+		return -1;
+
+	return 0;
+}
+
+struct {
+	__isl_give isl_aff *(*fn)(__isl_take isl_aff *aff1,
+				__isl_take isl_aff *aff2);
+} aff_bin_op[] = {
+	['+'] = { &isl_aff_add },
+	['-'] = { &isl_aff_sub },
+	['*'] = { &isl_aff_mul },
+	['/'] = { &isl_aff_div },
+};
+
+struct {
 	const char *arg1;
+	unsigned char op;
 	const char *arg2;
 	const char *res;
-} mpa_bin_tests[] = {
-	{ &isl_multi_pw_aff_add, "{ A[] -> [1] }", "{ A[] -> [2] }",
-	  "{ A[] -> [3] }" },
-	{ &isl_multi_pw_aff_add, "{ A[x] -> [(1 : x >= 5)] }",
-	  "{ A[x] -> [(x : x <= 10)] }",
-	  "{ A[x] -> [(1 + x : 5 <= x <= 10)] }" },
-	{ &isl_multi_pw_aff_add, "{ A[x] -> [] : x >= 5 }",
-	  "{ A[x] -> [] : x <= 10 }",
-	  "{ A[x] -> [] : 5 <= x <= 10 }" },
-	{ &isl_multi_pw_aff_add, "{ A[x] -> [] : x >= 5 }",
-	  "[N] -> { A[x] -> [] : x <= N }",
-	  "[N] -> { A[x] -> [] : 5 <= x <= N }" },
-	{ &isl_multi_pw_aff_add,
-	  "[N] -> { A[x] -> [] : x <= N }",
-	  "{ A[x] -> [] : x >= 5 }",
-	  "[N] -> { A[x] -> [] : 5 <= x <= N }" },
-	{ &isl_multi_pw_aff_range_product, "{ A[x] -> B[(1 : x >= 5)] }",
-	  "{ A[y] -> C[(2 : y <= 10)] }",
-	  "{ A[x] -> [B[(1 : x >= 5)] -> C[(2 : x <= 10)]] }" },
-	{ &isl_multi_pw_aff_range_product, "{ A[x] -> B[1] : x >= 5 }",
-	  "{ A[y] -> C[2] : y <= 10 }",
-	  "{ A[x] -> [B[(1 : x >= 5)] -> C[(2 : x <= 10)]] }" },
-	{ &isl_multi_pw_aff_range_product, "{ A[x] -> B[1] : x >= 5 }",
-	  "[N] -> { A[y] -> C[2] : y <= N }",
-	  "[N] -> { A[x] -> [B[(1 : x >= 5)] -> C[(2 : x <= N)]] }" },
-	{ &isl_multi_pw_aff_range_product, "[N] -> { A[x] -> B[1] : x >= N }",
-	  "{ A[y] -> C[2] : y <= 10 }",
-	  "[N] -> { A[x] -> [B[(1 : x >= N)] -> C[(2 : x <= 10)]] }" },
-	{ &isl_multi_pw_aff_range_product, "{ A[] -> B[1] }", "{ A[] -> C[2] }",
-	  "{ A[] -> [B[1] -> C[2]] }" },
-	{ &isl_multi_pw_aff_range_product, "{ A[] -> B[] }", "{ A[] -> C[] }",
-	  "{ A[] -> [B[] -> C[]] }" },
-	{ &isl_multi_pw_aff_range_product, "{ A[x] -> B[(1 : x >= 5)] }",
-	  "{ A[y] -> C[] : y <= 10 }",
-	  "{ A[x] -> [B[(1 : x >= 5)] -> C[]] : x <= 10 }" },
-	{ &isl_multi_pw_aff_range_product, "{ A[y] -> C[] : y <= 10 }",
-	  "{ A[x] -> B[(1 : x >= 5)] }",
-	  "{ A[x] -> [C[] -> B[(1 : x >= 5)]] : x <= 10 }" },
-	{ &isl_multi_pw_aff_product, "{ A[x] -> B[(1 : x >= 5)] }",
-	  "{ A[y] -> C[(2 : y <= 10)] }",
-	  "{ [A[x] -> A[y]] -> [B[(1 : x >= 5)] -> C[(2 : y <= 10)]] }" },
-	{ &isl_multi_pw_aff_product, "{ A[x] -> B[(1 : x >= 5)] }",
-	  "{ A[y] -> C[] : y <= 10 }",
-	  "{ [A[x] -> A[y]] -> [B[(1 : x >= 5)] -> C[]] : y <= 10 }" },
-	{ &isl_multi_pw_aff_product, "{ A[y] -> C[] : y <= 10 }",
-	  "{ A[x] -> B[(1 : x >= 5)] }",
-	  "{ [A[y] -> A[x]] -> [C[] -> B[(1 : x >= 5)]] : y <= 10 }" },
-	{ &isl_multi_pw_aff_product, "{ A[x] -> B[(1 : x >= 5)] }",
-	  "[N] -> { A[y] -> C[] : y <= N }",
-	  "[N] -> { [A[x] -> A[y]] -> [B[(1 : x >= 5)] -> C[]] : y <= N }" },
-	{ &isl_multi_pw_aff_product, "[N] -> { A[y] -> C[] : y <= N }",
-	  "{ A[x] -> B[(1 : x >= 5)] }",
-	  "[N] -> { [A[y] -> A[x]] -> [C[] -> B[(1 : x >= 5)]] : y <= N }" },
-	{ &isl_multi_pw_aff_product, "{ A[x] -> B[] : x >= 5 }",
-	  "{ A[y] -> C[] : y <= 10 }",
-	  "{ [A[x] -> A[y]] -> [B[] -> C[]] : x >= 5 and y <= 10 }" },
-	{ &isl_multi_pw_aff_product, "{ A[] -> B[1] }", "{ A[] -> C[2] }",
-	  "{ [A[] -> A[]] -> [B[1] -> C[2]] }" },
-	{ &isl_multi_pw_aff_product, "{ A[] -> B[] }", "{ A[] -> C[] }",
-	  "{ [A[] -> A[]] -> [B[] -> C[]] }" },
-	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
-	  "{ B[i,j] -> C[i + 2j] }", "{ A[a,b] -> B[b,a] }",
-	  "{ A[a,b] -> C[b + 2a] }" },
-	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
-	  "{ B[i,j] -> C[i + 2j] }",
-	  "{ A[a,b] -> B[(b : b > a),(a : b > a)] }",
-	  "{ A[a,b] -> C[(b + 2a : b > a)] }" },
-	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
-	  "{ B[i,j] -> C[(i + 2j : j > 4)] }",
-	  "{ A[a,b] -> B[(b : b > a),(a : b > a)] }",
-	  "{ A[a,b] -> C[(b + 2a : b > a > 4)] }" },
-	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
-	  "{ B[i,j] -> C[] }",
-	  "{ A[a,b] -> B[(b : b > a),(a : b > a)] }",
-	  "{ A[a,b] -> C[] }" },
-	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
-	  "{ B[i,j] -> C[] : i > j }",
-	  "{ A[a,b] -> B[b,a] }",
-	  "{ A[a,b] -> C[] : b > a }" },
-	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
-	  "{ B[i,j] -> C[] : j > 5 }",
-	  "{ A[a,b] -> B[(b : b > a),(a : b > a)] }",
-	  "{ A[a,b] -> C[] : b > a > 5 }" },
+} aff_bin_tests[] = {
+	{ "{ [i] -> [i] }", '+', "{ [i] -> [i] }",
+	  "{ [i] -> [2i] }" },
+	{ "{ [i] -> [i] }", '-', "{ [i] -> [i] }",
+	  "{ [i] -> [0] }" },
+	{ "{ [i] -> [i] }", '*', "{ [i] -> [2] }",
+	  "{ [i] -> [2i] }" },
+	{ "{ [i] -> [2] }", '*', "{ [i] -> [i] }",
+	  "{ [i] -> [2i] }" },
+	{ "{ [i] -> [i] }", '/', "{ [i] -> [2] }",
+	  "{ [i] -> [i/2] }" },
+	{ "{ [i] -> [2i] }", '/', "{ [i] -> [2] }",
+	  "{ [i] -> [i] }" },
+	{ "{ [i] -> [i] }", '+', "{ [i] -> [NaN] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [i] }", '-', "{ [i] -> [NaN] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [i] }", '*', "{ [i] -> [NaN] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [2] }", '*', "{ [i] -> [NaN] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [i] }", '/', "{ [i] -> [NaN] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [2] }", '/', "{ [i] -> [NaN] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [NaN] }", '+', "{ [i] -> [i] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [NaN] }", '-', "{ [i] -> [i] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [NaN] }", '*', "{ [i] -> [2] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [NaN] }", '*', "{ [i] -> [i] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [NaN] }", '/', "{ [i] -> [2] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [NaN] }", '/', "{ [i] -> [i] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [i] }", '/', "{ [i] -> [0] }",
+	  "{ [i] -> [NaN] }" },
+};
+
+/* Perform some basic tests of binary operations on isl_aff objects.
+ */
+static int test_bin_aff(isl_ctx *ctx)
+{
+	int i;
+	isl_aff *aff1, *aff2, *res;
+	__isl_give isl_aff *(*fn)(__isl_take isl_aff *aff1,
+				__isl_take isl_aff *aff2);
+	int ok;
+
+	for (i = 0; i < ARRAY_SIZE(aff_bin_tests); ++i) {
+		aff1 = isl_aff_read_from_str(ctx, aff_bin_tests[i].arg1);
+		aff2 = isl_aff_read_from_str(ctx, aff_bin_tests[i].arg2);
+		res = isl_aff_read_from_str(ctx, aff_bin_tests[i].res);
+		fn = aff_bin_op[aff_bin_tests[i].op].fn;
+		aff1 = fn(aff1, aff2);
+		if (isl_aff_is_nan(res))
+			ok = isl_aff_is_nan(aff1);
+		else
+			ok = isl_aff_plain_is_equal(aff1, res);
+		isl_aff_free(aff1);
+		isl_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+struct {
+	__isl_give isl_pw_aff *(*fn)(__isl_take isl_pw_aff *pa1,
+				     __isl_take isl_pw_aff *pa2);
+} pw_aff_bin_op[] = {
+	['m'] = { &isl_pw_aff_min },
+	['M'] = { &isl_pw_aff_max },
+	['+'] = { &isl_pw_aff_add },
+};
+
+/* Inputs for binary isl_pw_aff operation tests.
+ * "arg1" and "arg2" are the two arguments, "op" identifies the operation
+ * defined by pw_aff_bin_op, and "res" is the expected result.
+ */
+struct {
+	const char *arg1;
+	unsigned char op;
+	const char *arg2;
+	const char *res;
+} pw_aff_bin_tests[] = {
+	{ "{ [i] -> [i] }", 'm', "{ [i] -> [i] }",
+	  "{ [i] -> [i] }" },
+	{ "{ [i] -> [i] }", 'M', "{ [i] -> [i] }",
+	  "{ [i] -> [i] }" },
+	{ "{ [i] -> [i] }", 'm', "{ [i] -> [0] }",
+	  "{ [i] -> [i] : i <= 0; [i] -> [0] : i > 0 }" },
+	{ "{ [i] -> [i] }", 'M', "{ [i] -> [0] }",
+	  "{ [i] -> [i] : i >= 0; [i] -> [0] : i < 0 }" },
+	{ "{ [i] -> [i] }", 'm', "{ [i] -> [NaN] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [NaN] }", 'm', "{ [i] -> [i] }",
+	  "{ [i] -> [NaN] }" },
+	{ "{ [i] -> [i] : i >= 0; [i] -> [-i] : i < 0 }", '+',
+	  "{ [i] -> [1] : i >= 0; [i] -> [2] : i < 0 }",
+	  "{ [i] -> [i + 1] : i >= 0; [i] -> [2 - i] : i < 0 }" },
+	{ "{ [i] -> [i] : i >= 0; [i] -> [-i] : i < 0 }", '+',
+	  "{ [i] -> [1] : i < 0; [i] -> [2] : i >= 0 }",
+	  "{ [i] -> [i + 2] : i >= 0; [i] -> [1 - i] : i < 0 }" },
+	{ "{ [i] -> [i] : 0 <= i <= 10; [i] -> [0] : 20 <= i <= 30 }", '+',
+	  "{ [i] -> [1] : 5 <= i <= 25 }",
+	  "{ [i] -> [i + 1] : 5 <= i <= 10; [i] -> [1] : 20 <= i <= 25 }" },
+	{ "{ [i] -> [i] : i >= 0; [i] -> [-i] : i < 0 }", 'm',
+	  "{ [i] -> [5] : i >= 0; [i] -> [3] : i < 0 }",
+	  "{ [i] -> [i] : 0 <= i <= 5; [i] -> [5] : i > 5; "
+	    "[i] -> [-i] : -3 <= i < 0; [i] -> [3] : i < -3 }" },
+};
+
+/* Perform some basic tests of binary operations on isl_pw_aff objects.
+ */
+static int test_bin_pw_aff(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_pw_aff *pa1, *pa2, *res;
+
+	for (i = 0; i < ARRAY_SIZE(pw_aff_bin_tests); ++i) {
+		pa1 = isl_pw_aff_read_from_str(ctx, pw_aff_bin_tests[i].arg1);
+		pa2 = isl_pw_aff_read_from_str(ctx, pw_aff_bin_tests[i].arg2);
+		res = isl_pw_aff_read_from_str(ctx, pw_aff_bin_tests[i].res);
+		pa1 = pw_aff_bin_op[pw_aff_bin_tests[i].op].fn(pa1, pa2);
+		if (isl_pw_aff_involves_nan(res))
+			ok = isl_pw_aff_involves_nan(pa1);
+		else
+			ok = isl_pw_aff_plain_is_equal(pa1, res);
+		isl_pw_aff_free(pa1);
+		isl_pw_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for basic tests of test operations on
+ * isl_union_pw_multi_aff objects.
+ * "fn" is the function that is being tested.
+ * "arg" is a string description of the input.
+ * "res" is the expected result.
+ */
+static struct {
+	isl_bool (*fn)(__isl_keep isl_union_pw_multi_aff *upma1);
+	const char *arg;
+	isl_bool res;
+} upma_test_tests[] = {
+	{ &isl_union_pw_multi_aff_involves_nan, "{ A[] -> [0]; B[0] -> [1] }",
+	  isl_bool_false },
+	{ &isl_union_pw_multi_aff_involves_nan, "{ A[] -> [NaN]; B[0] -> [1] }",
+	  isl_bool_true },
+	{ &isl_union_pw_multi_aff_involves_nan, "{ A[] -> [0]; B[0] -> [NaN] }",
+	  isl_bool_true },
+	{ &isl_union_pw_multi_aff_involves_nan,
+	  "{ A[] -> [0]; B[0] -> [1, NaN, 5] }",
+	  isl_bool_true },
+	{ &isl_union_pw_multi_aff_involves_locals,
+	  "{ A[] -> [0]; B[0] -> [1] }",
+	  isl_bool_false },
+	{ &isl_union_pw_multi_aff_involves_locals,
+	  "{ A[] -> [0]; B[x] -> [1] : x mod 2 = 0 }",
+	  isl_bool_true },
+	{ &isl_union_pw_multi_aff_involves_locals,
+	  "{ A[] -> [0]; B[x] -> [x // 2] }",
+	  isl_bool_true },
+	{ &isl_union_pw_multi_aff_involves_locals,
+	  "{ A[i] -> [i // 2]; B[0] -> [1] }",
+	  isl_bool_true },
+};
+
+/* Perform some basic tests of test operations on
+ * isl_union_pw_multi_aff objects.
+ */
+static isl_stat test_upma_test(isl_ctx *ctx)
+{
+	int i;
+	isl_union_pw_multi_aff *upma;
+	isl_bool res;
+
+	for (i = 0; i < ARRAY_SIZE(upma_test_tests); ++i) {
+		const char *str;
+
+		str = upma_test_tests[i].arg;
+		upma = isl_union_pw_multi_aff_read_from_str(ctx, str);
+		res = upma_test_tests[i].fn(upma);
+		isl_union_pw_multi_aff_free(upma);
+		if (res < 0)
+			return isl_stat_error;
+		if (res != upma_test_tests[i].res)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
+struct {
+	__isl_give isl_union_pw_multi_aff *(*fn)(
+		__isl_take isl_union_pw_multi_aff *upma1,
+		__isl_take isl_union_pw_multi_aff *upma2);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} upma_bin_tests[] = {
+	{ &isl_union_pw_multi_aff_add, "{ A[] -> [0]; B[0] -> [1] }",
+	  "{ B[x] -> [2] : x >= 0 }", "{ B[0] -> [3] }" },
+	{ &isl_union_pw_multi_aff_union_add, "{ A[] -> [0]; B[0] -> [1] }",
+	  "{ B[x] -> [2] : x >= 0 }",
+	  "{ A[] -> [0]; B[0] -> [3]; B[x] -> [2] : x >= 1 }" },
+	{ &isl_union_pw_multi_aff_pullback_union_pw_multi_aff,
+	  "{ A[] -> B[0]; C[x] -> B[1] : x < 10; C[y] -> B[2] : y >= 10 }",
+	  "{ D[i] -> A[] : i < 0; D[i] -> C[i + 5] : i >= 0 }",
+	  "{ D[i] -> B[0] : i < 0; D[i] -> B[1] : 0 <= i < 5; "
+	    "D[i] -> B[2] : i >= 5 }" },
+	{ &isl_union_pw_multi_aff_union_add, "{ B[x] -> A[1] : x <= 0 }",
+	  "{ B[x] -> C[2] : x > 0 }",
+	  "{ B[x] -> A[1] : x <= 0; B[x] -> C[2] : x > 0 }" },
+	{ &isl_union_pw_multi_aff_union_add, "{ B[x] -> A[1] : x <= 0 }",
+	  "{ B[x] -> A[2] : x >= 0 }",
+	  "{ B[x] -> A[1] : x < 0; B[x] -> A[2] : x > 0; B[0] -> A[3] }" },
+	{
+  &isl_union_pw_multi_aff_preimage_domain_wrapped_domain_union_pw_multi_aff,
+	  "{ B[x] -> C[x + 2] }",
+	  "{ D[y] -> B[2y] }",
+	  "{ }" },
+	{
+  &isl_union_pw_multi_aff_preimage_domain_wrapped_domain_union_pw_multi_aff,
+	  "{ [A[x] -> B[x + 1]] -> C[x + 2] }",
+	  "{ D[y] -> B[2y] }",
+	  "{ }" },
+	{
+  &isl_union_pw_multi_aff_preimage_domain_wrapped_domain_union_pw_multi_aff,
+	  "{ [A[x] -> B[x + 1]] -> C[x + 2]; B[x] -> C[x + 2] }",
+	  "{ D[y] -> A[2y] }",
+	  "{ [D[y] -> B[2y + 1]] -> C[2y + 2] }" },
+	{
+  &isl_union_pw_multi_aff_preimage_domain_wrapped_domain_union_pw_multi_aff,
+	  "{ T[A[x] -> B[x + 1]] -> C[x + 2]; B[x] -> C[x + 2] }",
+	  "{ D[y] -> A[2y] }",
+	  "{ T[D[y] -> B[2y + 1]] -> C[2y + 2] }" },
+};
+
+/* Perform some basic tests of binary operations on
+ * isl_union_pw_multi_aff objects.
+ */
+static int test_bin_upma(isl_ctx *ctx)
+{
+	int i;
+	isl_union_pw_multi_aff *upma1, *upma2, *res;
+	int ok;
+
+	for (i = 0; i < ARRAY_SIZE(upma_bin_tests); ++i) {
+		upma1 = isl_union_pw_multi_aff_read_from_str(ctx,
+							upma_bin_tests[i].arg1);
+		upma2 = isl_union_pw_multi_aff_read_from_str(ctx,
+							upma_bin_tests[i].arg2);
+		res = isl_union_pw_multi_aff_read_from_str(ctx,
+							upma_bin_tests[i].res);
+		upma1 = upma_bin_tests[i].fn(upma1, upma2);
+		ok = isl_union_pw_multi_aff_plain_is_equal(upma1, res);
+		isl_union_pw_multi_aff_free(upma1);
+		isl_union_pw_multi_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+struct {
+	__isl_give isl_union_pw_multi_aff *(*fn)(
+		__isl_take isl_union_pw_multi_aff *upma1,
+		__isl_take isl_union_pw_multi_aff *upma2);
+	const char *arg1;
+	const char *arg2;
+} upma_bin_fail_tests[] = {
+	{ &isl_union_pw_multi_aff_union_add, "{ B[x] -> A[1] : x <= 0 }",
+	  "{ B[x] -> C[2] : x >= 0 }" },
+};
+
+/* Perform some basic tests of binary operations on
+ * isl_union_pw_multi_aff objects that are expected to fail.
+ */
+static int test_bin_upma_fail(isl_ctx *ctx)
+{
+	int i, n;
+	isl_union_pw_multi_aff *upma1, *upma2;
+	int on_error;
+
+	on_error = isl_options_get_on_error(ctx);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+	n = ARRAY_SIZE(upma_bin_fail_tests);
+	for (i = 0; i < n; ++i) {
+		upma1 = isl_union_pw_multi_aff_read_from_str(ctx,
+						upma_bin_fail_tests[i].arg1);
+		upma2 = isl_union_pw_multi_aff_read_from_str(ctx,
+						upma_bin_fail_tests[i].arg2);
+		upma1 = upma_bin_fail_tests[i].fn(upma1, upma2);
+		isl_union_pw_multi_aff_free(upma1);
+		if (upma1)
+			break;
+	}
+	isl_options_set_on_error(ctx, on_error);
+	if (i < n)
+		isl_die(ctx, isl_error_unknown,
+			"operation not expected to succeed", return -1);
+
+	return 0;
+}
+
+/* Inputs for basic tests of binary operations on
+ * pairs of isl_union_pw_multi_aff and isl_union_set objects.
+ * "fn" is the function that is being tested.
+ * "arg1" and "arg2" are string descriptions of the inputs.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_union_pw_multi_aff *(*fn)(
+		__isl_take isl_union_pw_multi_aff *upma,
+		__isl_take isl_union_set *uset);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} upma_uset_tests[] = {
+	{ &isl_union_pw_multi_aff_intersect_domain_wrapped_range,
+	  "{ A[i] -> B[i] }", "{ B[0] }",
+	  "{ }" },
+	{ &isl_union_pw_multi_aff_intersect_domain_wrapped_domain,
+	  "{ [A[i] -> B[i]] -> C[i + 1] }", "{ A[1]; B[0] }",
+	  "{ [A[1] -> B[1]] -> C[2] }" },
+	{ &isl_union_pw_multi_aff_intersect_domain_wrapped_range,
+	  "{ [A[i] -> B[i]] -> C[i + 1] }", "{ A[1]; B[0] }",
+	  "{ [A[0] -> B[0]] -> C[1] }" },
+	{ &isl_union_pw_multi_aff_intersect_domain_wrapped_range,
+	  "{ [A[i] -> B[i]] -> C[i + 1] }", "[N] -> { B[N] }",
+	  "[N] -> { [A[N] -> B[N]] -> C[N + 1] }" },
+	{ &isl_union_pw_multi_aff_intersect_domain_wrapped_range,
+	  "[M] -> { [A[M] -> B[M]] -> C[M + 1] }", "[N] -> { B[N] }",
+	  "[N, M] -> { [A[N] -> B[N]] -> C[N + 1] : N = M }" },
+	{ &isl_union_pw_multi_aff_intersect_domain_wrapped_range,
+	  "{ [A[] -> B[]] -> C[]; N[A[] -> B[]] -> D[]; [B[] -> A[]] -> E[] }",
+	  "{ B[] }",
+	  "{ [A[] -> B[]] -> C[]; N[A[] -> B[]] -> D[] }" },
+};
+
+/* Perform some basic tests of binary operations on
+ * pairs of isl_union_pw_multi_aff and isl_union_set objects.
+ */
+static isl_stat test_upma_uset(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_union_pw_multi_aff *upma, *res;
+	isl_union_set *uset;
+
+	for (i = 0; i < ARRAY_SIZE(upma_uset_tests); ++i) {
+		upma = isl_union_pw_multi_aff_read_from_str(ctx,
+						    upma_uset_tests[i].arg1);
+		uset = isl_union_set_read_from_str(ctx,
+						    upma_uset_tests[i].arg2);
+		res = isl_union_pw_multi_aff_read_from_str(ctx,
+						    upma_uset_tests[i].res);
+		upma = upma_uset_tests[i].fn(upma, uset);
+		ok = isl_union_pw_multi_aff_plain_is_equal(upma, res);
+		isl_union_pw_multi_aff_free(upma);
+		isl_union_pw_multi_aff_free(res);
+		if (ok < 0)
+			return isl_stat_error;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for basic tests of unary operations on isl_multi_pw_aff objects.
+ * "fn" is the function that is tested.
+ * "arg" is a string description of the input.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_multi_pw_aff *(*fn)(__isl_take isl_multi_pw_aff *mpa);
+	const char *arg;
+	const char *res;
+} mpa_un_tests[] = {
+	{ &isl_multi_pw_aff_range_factor_domain,
+	  "{ A[x] -> [B[(1 : x >= 5)] -> C[(2 : x <= 10)]] }",
+	  "{ A[x] -> B[(1 : x >= 5)] }" },
+	{ &isl_multi_pw_aff_range_factor_range,
+	  "{ A[x] -> [B[(1 : x >= 5)] -> C[(2 : x <= 10)]] }",
+	  "{ A[y] -> C[(2 : y <= 10)] }" },
+	{ &isl_multi_pw_aff_range_factor_domain,
+	  "{ A[x] -> [B[(1 : x >= 5)] -> C[]] }",
+	  "{ A[x] -> B[(1 : x >= 5)] }" },
+	{ &isl_multi_pw_aff_range_factor_range,
+	  "{ A[x] -> [B[(1 : x >= 5)] -> C[]] }",
+	  "{ A[y] -> C[] }" },
+	{ &isl_multi_pw_aff_range_factor_domain,
+	  "{ A[x] -> [B[] -> C[(2 : x <= 10)]] }",
+	  "{ A[x] -> B[] }" },
+	{ &isl_multi_pw_aff_range_factor_range,
+	  "{ A[x] -> [B[] -> C[(2 : x <= 10)]] }",
+	  "{ A[y] -> C[(2 : y <= 10)] }" },
+	{ &isl_multi_pw_aff_range_factor_domain,
+	  "{ A[x] -> [B[] -> C[]] }",
+	  "{ A[x] -> B[] }" },
+	{ &isl_multi_pw_aff_range_factor_range,
+	  "{ A[x] -> [B[] -> C[]] }",
+	  "{ A[y] -> C[] }" },
+	{ &isl_multi_pw_aff_factor_range,
+	  "{ [B[] -> C[]] }",
+	  "{ C[] }" },
+	{ &isl_multi_pw_aff_range_factor_domain,
+	  "{ A[x] -> [B[] -> C[]] : x >= 0 }",
+	  "{ A[x] -> B[] : x >= 0 }" },
+	{ &isl_multi_pw_aff_range_factor_range,
+	  "{ A[x] -> [B[] -> C[]] : x >= 0 }",
+	  "{ A[y] -> C[] : y >= 0 }" },
+	{ &isl_multi_pw_aff_factor_range,
+	  "[N] -> { [B[] -> C[]] : N >= 0 }",
+	  "[N] -> { C[] : N >= 0 }" },
+};
+
+/* Perform some basic tests of unary operations on isl_multi_pw_aff objects.
+ */
+static int test_un_mpa(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_multi_pw_aff *mpa, *res;
+
+	for (i = 0; i < ARRAY_SIZE(mpa_un_tests); ++i) {
+		mpa = isl_multi_pw_aff_read_from_str(ctx, mpa_un_tests[i].arg);
+		res = isl_multi_pw_aff_read_from_str(ctx, mpa_un_tests[i].res);
+		mpa = mpa_un_tests[i].fn(mpa);
+		ok = isl_multi_pw_aff_plain_is_equal(mpa, res);
+		isl_multi_pw_aff_free(mpa);
+		isl_multi_pw_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for basic tests of binary operations on isl_multi_pw_aff objects.
+ * "fn" is the function that is tested.
+ * "arg1" and "arg2" are string descriptions of the inputs.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_multi_pw_aff *(*fn)(
+		__isl_take isl_multi_pw_aff *mpa1,
+		__isl_take isl_multi_pw_aff *mpa2);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} mpa_bin_tests[] = {
+	{ &isl_multi_pw_aff_add, "{ A[] -> [1] }", "{ A[] -> [2] }",
+	  "{ A[] -> [3] }" },
+	{ &isl_multi_pw_aff_add, "{ A[x] -> [(1 : x >= 5)] }",
+	  "{ A[x] -> [(x : x <= 10)] }",
+	  "{ A[x] -> [(1 + x : 5 <= x <= 10)] }" },
+	{ &isl_multi_pw_aff_add, "{ A[x] -> [] : x >= 5 }",
+	  "{ A[x] -> [] : x <= 10 }",
+	  "{ A[x] -> [] : 5 <= x <= 10 }" },
+	{ &isl_multi_pw_aff_add, "{ A[x] -> [] : x >= 5 }",
+	  "[N] -> { A[x] -> [] : x <= N }",
+	  "[N] -> { A[x] -> [] : 5 <= x <= N }" },
+	{ &isl_multi_pw_aff_add,
+	  "[N] -> { A[x] -> [] : x <= N }",
+	  "{ A[x] -> [] : x >= 5 }",
+	  "[N] -> { A[x] -> [] : 5 <= x <= N }" },
+	{ &isl_multi_pw_aff_range_product, "{ A[x] -> B[(1 : x >= 5)] }",
+	  "{ A[y] -> C[(2 : y <= 10)] }",
+	  "{ A[x] -> [B[(1 : x >= 5)] -> C[(2 : x <= 10)]] }" },
+	{ &isl_multi_pw_aff_range_product, "{ A[x] -> B[1] : x >= 5 }",
+	  "{ A[y] -> C[2] : y <= 10 }",
+	  "{ A[x] -> [B[(1 : x >= 5)] -> C[(2 : x <= 10)]] }" },
+	{ &isl_multi_pw_aff_range_product, "{ A[x] -> B[1] : x >= 5 }",
+	  "[N] -> { A[y] -> C[2] : y <= N }",
+	  "[N] -> { A[x] -> [B[(1 : x >= 5)] -> C[(2 : x <= N)]] }" },
+	{ &isl_multi_pw_aff_range_product, "[N] -> { A[x] -> B[1] : x >= N }",
+	  "{ A[y] -> C[2] : y <= 10 }",
+	  "[N] -> { A[x] -> [B[(1 : x >= N)] -> C[(2 : x <= 10)]] }" },
+	{ &isl_multi_pw_aff_range_product, "{ A[] -> B[1] }", "{ A[] -> C[2] }",
+	  "{ A[] -> [B[1] -> C[2]] }" },
+	{ &isl_multi_pw_aff_range_product, "{ A[] -> B[] }", "{ A[] -> C[] }",
+	  "{ A[] -> [B[] -> C[]] }" },
+	{ &isl_multi_pw_aff_range_product, "{ A[x] -> B[(1 : x >= 5)] }",
+	  "{ A[y] -> C[] : y <= 10 }",
+	  "{ A[x] -> [B[(1 : x >= 5)] -> C[]] : x <= 10 }" },
+	{ &isl_multi_pw_aff_range_product, "{ A[y] -> C[] : y <= 10 }",
+	  "{ A[x] -> B[(1 : x >= 5)] }",
+	  "{ A[x] -> [C[] -> B[(1 : x >= 5)]] : x <= 10 }" },
+	{ &isl_multi_pw_aff_product, "{ A[x] -> B[(1 : x >= 5)] }",
+	  "{ A[y] -> C[(2 : y <= 10)] }",
+	  "{ [A[x] -> A[y]] -> [B[(1 : x >= 5)] -> C[(2 : y <= 10)]] }" },
+	{ &isl_multi_pw_aff_product, "{ A[x] -> B[(1 : x >= 5)] }",
+	  "{ A[y] -> C[] : y <= 10 }",
+	  "{ [A[x] -> A[y]] -> [B[(1 : x >= 5)] -> C[]] : y <= 10 }" },
+	{ &isl_multi_pw_aff_product, "{ A[y] -> C[] : y <= 10 }",
+	  "{ A[x] -> B[(1 : x >= 5)] }",
+	  "{ [A[y] -> A[x]] -> [C[] -> B[(1 : x >= 5)]] : y <= 10 }" },
+	{ &isl_multi_pw_aff_product, "{ A[x] -> B[(1 : x >= 5)] }",
+	  "[N] -> { A[y] -> C[] : y <= N }",
+	  "[N] -> { [A[x] -> A[y]] -> [B[(1 : x >= 5)] -> C[]] : y <= N }" },
+	{ &isl_multi_pw_aff_product, "[N] -> { A[y] -> C[] : y <= N }",
+	  "{ A[x] -> B[(1 : x >= 5)] }",
+	  "[N] -> { [A[y] -> A[x]] -> [C[] -> B[(1 : x >= 5)]] : y <= N }" },
+	{ &isl_multi_pw_aff_product, "{ A[x] -> B[] : x >= 5 }",
+	  "{ A[y] -> C[] : y <= 10 }",
+	  "{ [A[x] -> A[y]] -> [B[] -> C[]] : x >= 5 and y <= 10 }" },
+	{ &isl_multi_pw_aff_product, "{ A[] -> B[1] }", "{ A[] -> C[2] }",
+	  "{ [A[] -> A[]] -> [B[1] -> C[2]] }" },
+	{ &isl_multi_pw_aff_product, "{ A[] -> B[] }", "{ A[] -> C[] }",
+	  "{ [A[] -> A[]] -> [B[] -> C[]] }" },
+	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
+	  "{ B[i,j] -> C[i + 2j] }", "{ A[a,b] -> B[b,a] }",
+	  "{ A[a,b] -> C[b + 2a] }" },
+	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
+	  "{ B[i,j] -> C[i + 2j] }",
+	  "{ A[a,b] -> B[(b : b > a),(a : b > a)] }",
+	  "{ A[a,b] -> C[(b + 2a : b > a)] }" },
+	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
+	  "{ B[i,j] -> C[(i + 2j : j > 4)] }",
+	  "{ A[a,b] -> B[(b : b > a),(a : b > a)] }",
+	  "{ A[a,b] -> C[(b + 2a : b > a > 4)] }" },
+	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
+	  "{ B[i,j] -> C[] }",
+	  "{ A[a,b] -> B[(b : b > a),(a : b > a)] }",
+	  "{ A[a,b] -> C[] }" },
+	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
+	  "{ B[i,j] -> C[] : i > j }",
+	  "{ A[a,b] -> B[b,a] }",
+	  "{ A[a,b] -> C[] : b > a }" },
+	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
+	  "{ B[i,j] -> C[] : j > 5 }",
+	  "{ A[a,b] -> B[(b : b > a),(a : b > a)] }",
+	  "{ A[a,b] -> C[] : b > a > 5 }" },
 	{ &isl_multi_pw_aff_pullback_multi_pw_aff,
 	  "[N] -> { B[i,j] -> C[] : j > N }",
 	  "{ A[a,b] -> B[(b : b > a),(a : b > a)] }",
@@ -6064,3015 +8847,7340 @@ struct {
 	  "[M,N] -> { A[] -> C[] : M > N > 5 }" },
 };
 
-/* Perform some basic tests of binary operations on isl_multi_pw_aff objects.
+/* Perform some basic tests of binary operations on isl_multi_pw_aff objects.
+ */
+static int test_bin_mpa(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_multi_pw_aff *mpa1, *mpa2, *res;
+
+	for (i = 0; i < ARRAY_SIZE(mpa_bin_tests); ++i) {
+		mpa1 = isl_multi_pw_aff_read_from_str(ctx,
+							mpa_bin_tests[i].arg1);
+		mpa2 = isl_multi_pw_aff_read_from_str(ctx,
+							mpa_bin_tests[i].arg2);
+		res = isl_multi_pw_aff_read_from_str(ctx,
+							mpa_bin_tests[i].res);
+		mpa1 = mpa_bin_tests[i].fn(mpa1, mpa2);
+		ok = isl_multi_pw_aff_plain_is_equal(mpa1, res);
+		isl_multi_pw_aff_free(mpa1);
+		isl_multi_pw_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for basic tests of unary operations on
+ * isl_multi_union_pw_aff objects.
+ * "fn" is the function that is tested.
+ * "arg" is a string description of the input.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_multi_union_pw_aff *(*fn)(
+		__isl_take isl_multi_union_pw_aff *mupa);
+	const char *arg;
+	const char *res;
+} mupa_un_tests[] = {
+	{ &isl_multi_union_pw_aff_factor_range,
+	  "[B[{ A[] -> [1] }] -> C[{ A[] -> [2] }]]",
+	  "C[{ A[] -> [2] }]" },
+	{ &isl_multi_union_pw_aff_factor_range,
+	  "[B[] -> C[{ A[] -> [2] }]]",
+	  "C[{ A[] -> [2] }]" },
+	{ &isl_multi_union_pw_aff_factor_range,
+	  "[B[{ A[] -> [1] }] -> C[]]",
+	  "C[]" },
+	{ &isl_multi_union_pw_aff_factor_range,
+	  "[B[] -> C[]]",
+	  "C[]" },
+	{ &isl_multi_union_pw_aff_factor_range,
+	  "([B[] -> C[]] : { A[x] : x >= 0 })",
+	  "(C[] : { A[x] : x >= 0 })" },
+	{ &isl_multi_union_pw_aff_factor_range,
+	  "[N] -> ([B[] -> C[]] : { A[x] : x <= N })",
+	  "[N] -> (C[] : { A[x] : x <= N })" },
+	{ &isl_multi_union_pw_aff_factor_range,
+	  "[N] -> ([B[] -> C[]] : { : N >= 0 })",
+	  "[N] -> (C[] : { : N >= 0 })" },
+};
+
+/* Perform some basic tests of unary operations on
+ * isl_multi_union_pw_aff objects.
+ */
+static int test_un_mupa(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_multi_union_pw_aff *mupa, *res;
+
+	for (i = 0; i < ARRAY_SIZE(mupa_un_tests); ++i) {
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
+							mupa_un_tests[i].arg);
+		res = isl_multi_union_pw_aff_read_from_str(ctx,
+							mupa_un_tests[i].res);
+		mupa = mupa_un_tests[i].fn(mupa);
+		ok = isl_multi_union_pw_aff_plain_is_equal(mupa, res);
+		isl_multi_union_pw_aff_free(mupa);
+		isl_multi_union_pw_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for basic tests of binary operations on
+ * isl_multi_union_pw_aff objects.
+ * "fn" is the function that is tested.
+ * "arg1" and "arg2" are string descriptions of the inputs.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_multi_union_pw_aff *(*fn)(
+		__isl_take isl_multi_union_pw_aff *mupa1,
+		__isl_take isl_multi_union_pw_aff *mupa2);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} mupa_bin_tests[] = {
+	{ &isl_multi_union_pw_aff_add, "[{ A[] -> [1] }]", "[{ A[] -> [2] }]",
+	  "[{ A[] -> [3] }]" },
+	{ &isl_multi_union_pw_aff_sub, "[{ A[] -> [1] }]", "[{ A[] -> [2] }]",
+	  "[{ A[] -> [-1] }]" },
+	{ &isl_multi_union_pw_aff_add,
+	  "[{ A[] -> [1]; B[] -> [4] }]",
+	  "[{ A[] -> [2]; C[] -> [5] }]",
+	  "[{ A[] -> [3] }]" },
+	{ &isl_multi_union_pw_aff_union_add,
+	  "[{ A[] -> [1]; B[] -> [4] }]",
+	  "[{ A[] -> [2]; C[] -> [5] }]",
+	  "[{ A[] -> [3]; B[] -> [4]; C[] -> [5] }]" },
+	{ &isl_multi_union_pw_aff_add, "[{ A[x] -> [(1)] : x >= 5 }]",
+	  "[{ A[x] -> [(x)] : x <= 10 }]",
+	  "[{ A[x] -> [(1 + x)] : 5 <= x <= 10 }]" },
+	{ &isl_multi_union_pw_aff_add, "([] : { A[x] : x >= 5 })",
+	  "([] : { A[x] : x <= 10 })",
+	  "([] : { A[x] : 5 <= x <= 10 })" },
+	{ &isl_multi_union_pw_aff_add, "([] : { A[x] : x >= 5 })",
+	  "[N] -> ([] : { A[x] : x <= N })",
+	  "[N] -> ([] : { A[x] : 5 <= x <= N })" },
+	{ &isl_multi_union_pw_aff_add, "[N] -> ([] : { A[x] : x >= N })",
+	  "([] : { A[x] : x <= 10 })",
+	  "[N] -> ([] : { A[x] : N <= x <= 10 })" },
+	{ &isl_multi_union_pw_aff_union_add, "[{ A[x] -> [(1)] : x >= 5 }]",
+	  "[{ A[x] -> [(x)] : x <= 10 }]",
+	  "[{ A[x] -> [(1 + x)] : 5 <= x <= 10; "
+	     "A[x] -> [(1)] : x > 10; A[x] -> [(x)] : x < 5 }]" },
+	{ &isl_multi_union_pw_aff_union_add, "([] : { A[x] : x >= 5 })",
+	  "([] : { A[x] : x <= 10 })",
+	  "([] : { A[x] })" },
+	{ &isl_multi_union_pw_aff_union_add, "([] : { A[x] : x >= 0 })",
+	  "[N] -> ([] : { A[x] : x >= N })",
+	  "[N] -> ([] : { A[x] : x >= 0 or x >= N })" },
+	{ &isl_multi_union_pw_aff_union_add,
+	  "[N] -> ([] : { A[] : N >= 0})",
+	  "[N] -> ([] : { A[] : N <= 0})",
+	  "[N] -> ([] : { A[] })" },
+	{ &isl_multi_union_pw_aff_union_add,
+	  "[N] -> ([] : { A[] })",
+	  "[N] -> ([] : { : })",
+	  "[N] -> ([] : { : })" },
+	{ &isl_multi_union_pw_aff_union_add,
+	  "[N] -> ([] : { : })",
+	  "[N] -> ([] : { A[] })",
+	  "[N] -> ([] : { : })" },
+	{ &isl_multi_union_pw_aff_union_add,
+	  "[N] -> ([] : { : N >= 0})",
+	  "[N] -> ([] : { : N <= 0})",
+	  "[N] -> ([] : { : })" },
+	{ &isl_multi_union_pw_aff_range_product,
+	  "B[{ A[] -> [1] }]",
+	  "C[{ A[] -> [2] }]",
+	  "[B[{ A[] -> [1] }] -> C[{ A[] -> [2] }]]" },
+	{ &isl_multi_union_pw_aff_range_product,
+	  "(B[] : { A[x] : x >= 5 })",
+	  "(C[] : { A[x] : x <= 10 })",
+	  "([B[] -> C[]] : { A[x] : 5 <= x <= 10 })" },
+	{ &isl_multi_union_pw_aff_range_product,
+	  "B[{ A[x] -> [x + 1] : x >= 5 }]",
+	  "(C[] : { A[x] : x <= 10 })",
+	  "[B[{ A[x] -> [x + 1] : 5 <= x <= 10 }] -> C[]]" },
+	{ &isl_multi_union_pw_aff_range_product,
+	  "(C[] : { A[x] : x <= 10 })",
+	  "B[{ A[x] -> [x + 1] : x >= 5 }]",
+	  "[C[] -> B[{ A[x] -> [x + 1] : 5 <= x <= 10 }]]" },
+	{ &isl_multi_union_pw_aff_range_product,
+	  "B[{ A[x] -> [x + 1] : x >= 5 }]",
+	  "[N] -> (C[] : { A[x] : x <= N })",
+	  "[N] -> [B[{ A[x] -> [x + 1] : 5 <= x <= N }] -> C[]]" },
+	{ &isl_multi_union_pw_aff_range_product,
+	  "[N] -> (C[] : { A[x] : x <= N })",
+	  "B[{ A[x] -> [x + 1] : x >= 5 }]",
+	  "[N] -> [C[] -> B[{ A[x] -> [x + 1] : 5 <= x <= N }]]" },
+	{ &isl_multi_union_pw_aff_range_product,
+	  "B[{ A[] -> [1]; D[] -> [3] }]",
+	  "C[{ A[] -> [2] }]",
+	  "[B[{ A[] -> [1]; D[] -> [3] }] -> C[{ A[] -> [2] }]]" },
+	{ &isl_multi_union_pw_aff_range_product,
+	  "B[] }]",
+	  "(C[] : { A[x] })",
+	  "([B[] -> C[]] : { A[x] })" },
+	{ &isl_multi_union_pw_aff_range_product,
+	  "(B[] : { A[x] })",
+	  "C[] }]",
+	  "([B[] -> C[]] : { A[x] })" },
+};
+
+/* Perform some basic tests of binary operations on
+ * isl_multi_union_pw_aff objects.
+ */
+static int test_bin_mupa(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_multi_union_pw_aff *mupa1, *mupa2, *res;
+
+	for (i = 0; i < ARRAY_SIZE(mupa_bin_tests); ++i) {
+		mupa1 = isl_multi_union_pw_aff_read_from_str(ctx,
+							mupa_bin_tests[i].arg1);
+		mupa2 = isl_multi_union_pw_aff_read_from_str(ctx,
+							mupa_bin_tests[i].arg2);
+		res = isl_multi_union_pw_aff_read_from_str(ctx,
+							mupa_bin_tests[i].res);
+		mupa1 = mupa_bin_tests[i].fn(mupa1, mupa2);
+		ok = isl_multi_union_pw_aff_plain_is_equal(mupa1, res);
+		isl_multi_union_pw_aff_free(mupa1);
+		isl_multi_union_pw_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for basic tests of binary operations on
+ * pairs of isl_multi_union_pw_aff and isl_set objects.
+ * "fn" is the function that is tested.
+ * "arg1" and "arg2" are string descriptions of the inputs.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_multi_union_pw_aff *(*fn)(
+		__isl_take isl_multi_union_pw_aff *mupa,
+		__isl_take isl_set *set);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} mupa_set_tests[] = {
+	{ &isl_multi_union_pw_aff_intersect_range,
+	  "C[{ B[i,j] -> [i + 2j] }]", "{ C[1] }",
+	  "C[{ B[i,j] -> [i + 2j] : i + 2j = 1 }]" },
+	{ &isl_multi_union_pw_aff_intersect_range,
+	  "C[{ B[i,j] -> [i + 2j] }]", "[N] -> { C[N] }",
+	  "[N] -> C[{ B[i,j] -> [i + 2j] : i + 2j = N }]" },
+	{ &isl_multi_union_pw_aff_intersect_range,
+	  "[N] -> C[{ B[i,j] -> [i + 2j + N] }]", "{ C[1] }",
+	  "[N] -> C[{ B[i,j] -> [i + 2j + N] : i + 2j + N = 1 }]" },
+	{ &isl_multi_union_pw_aff_intersect_range,
+	  "C[{ B[i,j] -> [i + 2j] }]", "[N] -> { C[x] : N >= 0 }",
+	  "[N] -> C[{ B[i,j] -> [i + 2j] : N >= 0 }]" },
+	{ &isl_multi_union_pw_aff_intersect_range,
+	  "C[]", "{ C[] }", "C[]" },
+	{ &isl_multi_union_pw_aff_intersect_range,
+	  "[N] -> (C[] : { : N >= 0 })",
+	  "{ C[] }",
+	  "[N] -> (C[] : { : N >= 0 })" },
+	{ &isl_multi_union_pw_aff_intersect_range,
+	  "(C[] : { A[a,b] })",
+	  "{ C[] }",
+	  "(C[] : { A[a,b] })" },
+	{ &isl_multi_union_pw_aff_intersect_range,
+	  "[N] -> (C[] : { A[a,b] : a,b <= N })",
+	  "{ C[] }",
+	  "[N] -> (C[] : { A[a,b] : a,b <= N })" },
+	{ &isl_multi_union_pw_aff_intersect_range,
+	  "C[]",
+	  "[N] -> { C[] : N >= 0 }",
+	  "[N] -> (C[] : { : N >= 0 })" },
+	{ &isl_multi_union_pw_aff_intersect_range,
+	  "(C[] : { A[a,b] })",
+	  "[N] -> { C[] : N >= 0 }",
+	  "[N] -> (C[] : { A[a,b] : N >= 0 })" },
+	{ &isl_multi_union_pw_aff_intersect_range,
+	  "[N] -> (C[] : { : N >= 0 })",
+	  "[N] -> { C[] : N < 1024 }",
+	  "[N] -> (C[] : { : 0 <= N < 1024 })" },
+	{ &isl_multi_union_pw_aff_intersect_params,
+	  "C[{ B[i,j] -> [i + 2j] }]", "[N] -> { : N >= 0 }",
+	  "[N] -> C[{ B[i,j] -> [i + 2j] : N >= 0}]" },
+	{ &isl_multi_union_pw_aff_intersect_params,
+	  "[N] -> C[{ B[i,j] -> [i + 2j] : N <= 256 }]", "[N] -> { : N >= 0 }",
+	  "[N] -> C[{ B[i,j] -> [i + 2j] : 0 <= N <= 256 }]" },
+	{ &isl_multi_union_pw_aff_intersect_params,
+	  "[N] -> C[{ B[i,j] -> [i + 2j] : N <= 256 }]", "{ : }",
+	  "[N] -> C[{ B[i,j] -> [i + 2j] : N <= 256 }]" },
+	{ &isl_multi_union_pw_aff_intersect_params,
+	  "C[]", "[N] -> { : N >= 0 }",
+	  "[N] -> (C[] : { : N >= 0 })" },
+	{ &isl_multi_union_pw_aff_intersect_params,
+	  "(C[] : { A[a,b] })", "[N] -> { : N >= 0 }",
+	  "[N] -> (C[] : { A[a,b] : N >= 0 })" },
+	{ &isl_multi_union_pw_aff_intersect_params,
+	  "[N] -> (C[] : { A[a,N] })", "{ : }",
+	  "[N] -> (C[] : { A[a,N] })" },
+	{ &isl_multi_union_pw_aff_intersect_params,
+	  "[N] -> (C[] : { A[a,b] : N <= 256 })", "[N] -> { : N >= 0 }",
+	  "[N] -> (C[] : { A[a,b] : 0 <= N <= 256 })" },
+};
+
+/* Perform some basic tests of binary operations on
+ * pairs of isl_multi_union_pw_aff and isl_set objects.
+ */
+static int test_mupa_set(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_multi_union_pw_aff *mupa, *res;
+	isl_set *set;
+
+	for (i = 0; i < ARRAY_SIZE(mupa_set_tests); ++i) {
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
+						    mupa_set_tests[i].arg1);
+		set = isl_set_read_from_str(ctx, mupa_set_tests[i].arg2);
+		res = isl_multi_union_pw_aff_read_from_str(ctx,
+						    mupa_set_tests[i].res);
+		mupa = mupa_set_tests[i].fn(mupa, set);
+		ok = isl_multi_union_pw_aff_plain_is_equal(mupa, res);
+		isl_multi_union_pw_aff_free(mupa);
+		isl_multi_union_pw_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for basic tests of binary operations on
+ * pairs of isl_multi_union_pw_aff and isl_union_set objects.
+ * "fn" is the function that is tested.
+ * "arg1" and "arg2" are string descriptions of the inputs.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_multi_union_pw_aff *(*fn)(
+		__isl_take isl_multi_union_pw_aff *mupa,
+		__isl_take isl_union_set *uset);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} mupa_uset_tests[] = {
+	{ &isl_multi_union_pw_aff_intersect_domain,
+	  "C[{ B[i,j] -> [i + 2j] }]", "{ B[i,i] }",
+	  "C[{ B[i,i] -> [3i] }]" },
+	{ &isl_multi_union_pw_aff_intersect_domain,
+	  "(C[] : { B[i,j] })", "{ B[i,i] }",
+	  "(C[] : { B[i,i] })" },
+	{ &isl_multi_union_pw_aff_intersect_domain,
+	  "(C[] : { B[i,j] })", "[N] -> { B[N,N] }",
+	  "[N] -> (C[] : { B[N,N] })" },
+	{ &isl_multi_union_pw_aff_intersect_domain,
+	  "C[]", "{ B[i,i] }",
+	  "(C[] : { B[i,i] })" },
+	{ &isl_multi_union_pw_aff_intersect_domain,
+	  "[N] -> (C[] : { : N >= 0 })", "{ B[i,i] }",
+	  "[N] -> (C[] : { B[i,i] : N >= 0 })" },
+};
+
+/* Perform some basic tests of binary operations on
+ * pairs of isl_multi_union_pw_aff and isl_union_set objects.
+ */
+static int test_mupa_uset(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_multi_union_pw_aff *mupa, *res;
+	isl_union_set *uset;
+
+	for (i = 0; i < ARRAY_SIZE(mupa_uset_tests); ++i) {
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
+						    mupa_uset_tests[i].arg1);
+		uset = isl_union_set_read_from_str(ctx,
+						    mupa_uset_tests[i].arg2);
+		res = isl_multi_union_pw_aff_read_from_str(ctx,
+						    mupa_uset_tests[i].res);
+		mupa = mupa_uset_tests[i].fn(mupa, uset);
+		ok = isl_multi_union_pw_aff_plain_is_equal(mupa, res);
+		isl_multi_union_pw_aff_free(mupa);
+		isl_multi_union_pw_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for basic tests of binary operations on
+ * pairs of isl_multi_union_pw_aff and isl_multi_aff objects.
+ * "fn" is the function that is tested.
+ * "arg1" and "arg2" are string descriptions of the inputs.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_multi_union_pw_aff *(*fn)(
+		__isl_take isl_multi_union_pw_aff *mupa,
+		__isl_take isl_multi_aff *ma);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} mupa_ma_tests[] = {
+	{ &isl_multi_union_pw_aff_apply_multi_aff,
+	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }, "
+	    "{ A[i,j] -> [j]; B[i,j] -> [i] }]",
+	  "{ C[a,b] -> D[b,a] }",
+	  "D[{ A[i,j] -> [j]; B[i,j] -> [i] }, "
+	    "{ A[i,j] -> [i]; B[i,j] -> [j] }]" },
+	{ &isl_multi_union_pw_aff_apply_multi_aff,
+	  "C[{ A[i,j] -> [i] : i >= 0; B[i,j] -> [j] }, "
+	    "{ A[i,j] -> [j]; B[i,j] -> [i] }]",
+	  "{ C[a,b] -> D[b,a] }",
+	  "D[{ A[i,j] -> [j] : i >= 0; B[i,j] -> [i] }, "
+	    "{ A[i,j] -> [i] : i >= 0; B[i,j] -> [j] }]" },
+	{ &isl_multi_union_pw_aff_apply_multi_aff,
+	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }]",
+	  "[N] -> { C[a] -> D[a + N] }",
+	  "[N] -> D[{ A[i,j] -> [i + N]; B[i,j] -> [j + N] }] " },
+	{ &isl_multi_union_pw_aff_apply_multi_aff,
+	  "C[]",
+	  "{ C[] -> D[] }",
+	  "D[]" },
+	{ &isl_multi_union_pw_aff_apply_multi_aff,
+	  "[N] -> (C[] : { : N >= 0 })",
+	  "{ C[] -> D[] }",
+	  "[N] -> (D[] : { : N >= 0 })" },
+	{ &isl_multi_union_pw_aff_apply_multi_aff,
+	  "C[]",
+	  "[N] -> { C[] -> D[N] }",
+	  "[N] -> D[{ [N] }]" },
+	{ &isl_multi_union_pw_aff_apply_multi_aff,
+	  "(C[] : { A[i,j] : i >= j })",
+	  "{ C[] -> D[] }",
+	  "(D[] : { A[i,j] : i >= j })" },
+	{ &isl_multi_union_pw_aff_apply_multi_aff,
+	  "[N] -> (C[] : { A[i,j] : N >= 0 })",
+	  "{ C[] -> D[] }",
+	  "[N] -> (D[] : { A[i,j] : N >= 0 })" },
+	{ &isl_multi_union_pw_aff_apply_multi_aff,
+	  "(C[] : { A[i,j] : i >= j })",
+	  "[N] -> { C[] -> D[N] }",
+	  "[N] -> (D[{ A[i,j] -> [N] : i >= j }])" },
+};
+
+/* Perform some basic tests of binary operations on
+ * pairs of isl_multi_union_pw_aff and isl_multi_aff objects.
+ */
+static int test_mupa_ma(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_multi_union_pw_aff *mupa, *res;
+	isl_multi_aff *ma;
+
+	for (i = 0; i < ARRAY_SIZE(mupa_ma_tests); ++i) {
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
+						    mupa_ma_tests[i].arg1);
+		ma = isl_multi_aff_read_from_str(ctx, mupa_ma_tests[i].arg2);
+		res = isl_multi_union_pw_aff_read_from_str(ctx,
+						    mupa_ma_tests[i].res);
+		mupa = mupa_ma_tests[i].fn(mupa, ma);
+		ok = isl_multi_union_pw_aff_plain_is_equal(mupa, res);
+		isl_multi_union_pw_aff_free(mupa);
+		isl_multi_union_pw_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for basic tests of binary operations on
+ * pairs of isl_multi_union_pw_aff and isl_pw_aff objects.
+ * "fn" is the function that is tested.
+ * "arg1" and "arg2" are string descriptions of the inputs.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_union_pw_aff *(*fn)(
+		__isl_take isl_multi_union_pw_aff *mupa,
+		__isl_take isl_pw_aff *pa);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} mupa_pa_tests[] = {
+	{ &isl_multi_union_pw_aff_apply_pw_aff,
+	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }]",
+	  "[N] -> { C[a] -> [a + N] }",
+	  "[N] -> { A[i,j] -> [i + N]; B[i,j] -> [j + N] }" },
+	{ &isl_multi_union_pw_aff_apply_pw_aff,
+	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }]",
+	  "{ C[a] -> [a] : a >= 0; C[a] -> [-a] : a < 0 }",
+	  "{ A[i,j] -> [i] : i >= 0; A[i,j] -> [-i] : i < 0; "
+	    "B[i,j] -> [j] : j >= 0; B[i,j] -> [-j] : j < 0 }" },
+	{ &isl_multi_union_pw_aff_apply_pw_aff,
+	  "C[]",
+	  "[N] -> { C[] -> [N] }",
+	  "[N] -> { [N] }" },
+	{ &isl_multi_union_pw_aff_apply_pw_aff,
+	  "C[]",
+	  "[N] -> { C[] -> [N] : N >= 0; C[] -> [-N] : N < 0 }",
+	  "[N] -> { [N] : N >= 0; [-N] : N < 0 }" },
+	{ &isl_multi_union_pw_aff_apply_pw_aff,
+	  "[N] -> (C[] : { : N >= 0 })",
+	  "[N] -> { C[] -> [N] }",
+	  "[N] -> { [N] : N >= 0 }" },
+	{ &isl_multi_union_pw_aff_apply_pw_aff,
+	  "[N] -> (C[] : { : N >= 0 })",
+	  "[N] -> { C[] -> [N] : N >= 0; C[] -> [-N] : N < 0 }",
+	  "[N] -> { [N] : N >= 0 }" },
+	{ &isl_multi_union_pw_aff_apply_pw_aff,
+	  "[N] -> (C[] : { : N >= 0 })",
+	  "{ C[] -> [0] }",
+	  "[N] -> { [0] : N >= 0 }" },
+	{ &isl_multi_union_pw_aff_apply_pw_aff,
+	  "(C[] : { A[i,j] : i >= j })",
+	  "[N] -> { C[] -> [N] }",
+	  "[N] -> { A[i,j] -> [N] : i >= j }" },
+	{ &isl_multi_union_pw_aff_apply_pw_aff,
+	  "(C[] : { A[i,j] : i >= j })",
+	  "[N] -> { C[] -> [N] : N >= 0 }",
+	  "[N] -> { A[i,j] -> [N] : i >= j and N >= 0 }" },
+};
+
+/* Perform some basic tests of binary operations on
+ * pairs of isl_multi_union_pw_aff and isl_pw_aff objects.
+ */
+static int test_mupa_pa(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_multi_union_pw_aff *mupa;
+	isl_union_pw_aff *upa, *res;
+	isl_pw_aff *pa;
+
+	for (i = 0; i < ARRAY_SIZE(mupa_pa_tests); ++i) {
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
+						    mupa_pa_tests[i].arg1);
+		pa = isl_pw_aff_read_from_str(ctx, mupa_pa_tests[i].arg2);
+		res = isl_union_pw_aff_read_from_str(ctx,
+						    mupa_pa_tests[i].res);
+		upa = mupa_pa_tests[i].fn(mupa, pa);
+		ok = isl_union_pw_aff_plain_is_equal(upa, res);
+		isl_union_pw_aff_free(upa);
+		isl_union_pw_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for basic tests of binary operations on
+ * pairs of isl_multi_union_pw_aff and isl_pw_multi_aff objects.
+ * "fn" is the function that is tested.
+ * "arg1" and "arg2" are string descriptions of the inputs.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_multi_union_pw_aff *(*fn)(
+		__isl_take isl_multi_union_pw_aff *mupa,
+		__isl_take isl_pw_multi_aff *pma);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} mupa_pma_tests[] = {
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }, "
+	    "{ A[i,j] -> [j]; B[i,j] -> [i] }]",
+	  "{ C[a,b] -> D[b,a] }",
+	  "D[{ A[i,j] -> [j]; B[i,j] -> [i] }, "
+	    "{ A[i,j] -> [i]; B[i,j] -> [j] }]" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "C[{ A[i,j] -> [i] : i >= 0; B[i,j] -> [j] }, "
+	    "{ A[i,j] -> [j]; B[i,j] -> [i] }]",
+	  "{ C[a,b] -> D[b,a] }",
+	  "D[{ A[i,j] -> [j] : i >= 0; B[i,j] -> [i] }, "
+	    "{ A[i,j] -> [i] : i >= 0; B[i,j] -> [j] }]" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }]",
+	  "[N] -> { C[a] -> D[a + N] }",
+	  "[N] -> D[{ A[i,j] -> [i + N]; B[i,j] -> [j + N] }]" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }]",
+	  "{ C[a] -> D[a] : a >= 0; C[a] -> D[-a] : a < 0 }",
+	  "D[{ A[i,j] -> [i] : i >= 0; A[i,j] -> [-i] : i < 0; "
+	      "B[i,j] -> [j] : j >= 0; B[i,j] -> [-j] : j < 0 }]" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }, "
+	    "{ A[i,j] -> [j]; B[i,j] -> [i] }]",
+	  "{ C[a,b] -> D[a,b] : a >= b; C[a,b] -> D[b,a] : a < b }",
+	  "D[{ A[i,j] -> [i] : i >= j; A[i,j] -> [j] : i < j; "
+	      "B[i,j] -> [j] : i <= j; B[i,j] -> [i] : i > j }, "
+	    "{ A[i,j] -> [j] : i >= j; A[i,j] -> [i] : i < j; "
+	      "B[i,j] -> [i] : i <= j; B[i,j] -> [j] : i > j }]" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "C[]",
+	  "{ C[] -> D[] }",
+	  "D[]" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "[N] -> (C[] : { : N >= 0 })",
+	  "{ C[] -> D[] }",
+	  "[N] -> (D[] : { : N >= 0 })" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "C[]",
+	  "[N] -> { C[] -> D[N] }",
+	  "[N] -> D[{ [N] }]" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "(C[] : { A[i,j] : i >= j })",
+	  "{ C[] -> D[] }",
+	  "(D[] : { A[i,j] : i >= j })" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "[N] -> (C[] : { A[i,j] : N >= 0 })",
+	  "{ C[] -> D[] }",
+	  "[N] -> (D[] : { A[i,j] : N >= 0 })" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "(C[] : { A[i,j] : i >= j })",
+	  "[N] -> { C[] -> D[N] }",
+	  "[N] -> (D[{ A[i,j] -> [N] : i >= j }])" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "C[]",
+	  "[N] -> { C[] -> D[N] : N >= 0; C[] -> D[-N] : N < 0 }",
+	  "[N] -> D[{ [N] : N >= 0; [-N] : N < 0 }]" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "[N] -> (C[] : { : N >= 0 })",
+	  "[N] -> { C[] -> D[N] }",
+	  "[N] -> D[{ [N] : N >= 0 }]" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "[N] -> (C[] : { : N >= 0 })",
+	  "[N] -> { C[] -> D[N] : N >= 0; C[] -> D[-N] : N < 0 }",
+	  "[N] -> D[{ [N] : N >= 0 }]" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "[N] -> (C[] : { : N >= 0 })",
+	  "{ C[] -> D[0] }",
+	  "[N] -> D[{ [0] : N >= 0 }]" },
+	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
+	  "(C[] : { A[i,j] : i >= j })",
+	  "[N] -> { C[] -> D[N] : N >= 0 }",
+	  "[N] -> D[{ A[i,j] -> [N] : i >= j and N >= 0 }]" },
+};
+
+/* Perform some basic tests of binary operations on
+ * pairs of isl_multi_union_pw_aff and isl_pw_multi_aff objects.
+ */
+static int test_mupa_pma(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_multi_union_pw_aff *mupa, *res;
+	isl_pw_multi_aff *pma;
+
+	for (i = 0; i < ARRAY_SIZE(mupa_pma_tests); ++i) {
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
+						    mupa_pma_tests[i].arg1);
+		pma = isl_pw_multi_aff_read_from_str(ctx,
+						    mupa_pma_tests[i].arg2);
+		res = isl_multi_union_pw_aff_read_from_str(ctx,
+						    mupa_pma_tests[i].res);
+		mupa = mupa_pma_tests[i].fn(mupa, pma);
+		ok = isl_multi_union_pw_aff_plain_is_equal(mupa, res);
+		isl_multi_union_pw_aff_free(mupa);
+		isl_multi_union_pw_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for basic tests of binary operations on
+ * pairs of isl_multi_union_pw_aff and isl_union_pw_multi_aff objects.
+ * "fn" is the function that is tested.
+ * "arg1" and "arg2" are string descriptions of the inputs.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_multi_union_pw_aff *(*fn)(
+		__isl_take isl_multi_union_pw_aff *mupa,
+		__isl_take isl_union_pw_multi_aff *upma);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} mupa_upma_tests[] = {
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "C[{ B[i,j] -> [i + 2j] }]", "{ A[a,b] -> B[b,a] }",
+	  "C[{ A[a,b] -> [b + 2a] }]" },
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "C[{ B[i,j] -> [i + 2j] }]",
+	  "{ A[a,b] -> B[b,a] : b > a }",
+	  "C[{ A[a,b] -> [b + 2a] : b > a }]" },
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "C[{ B[i,j] -> [i + 2j] : j > 4 }]",
+	  "{ A[a,b] -> B[b,a] : b > a }",
+	  "C[{ A[a,b] -> [b + 2a] : b > a > 4 }]" },
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "C[{ B[i,j] -> [i + 2j] }]",
+	  "{ A[a,b] -> B[b,a] : a > b; A[a,b] -> B[a,b] : a <= b }",
+	  "C[{ A[a,b] -> [b + 2a] : a > b; A[a,b] -> [a + 2b] : a <= b }]" },
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "(C[] : { B[a,b] })",
+	  "{ A[a,b] -> B[b,a] }",
+	  "(C[] : { A[a,b] })" },
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "(C[] : { B[a,b] })",
+	  "{ B[a,b] -> A[b,a] }",
+	  "(C[] : { })" },
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "(C[] : { B[a,b] })",
+	  "{ A[a,b] -> B[b,a] : a > b }",
+	  "(C[] : { A[a,b] : a > b })" },
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "(C[] : { B[a,b] : a > b })",
+	  "{ A[a,b] -> B[b,a] }",
+	  "(C[] : { A[a,b] : b > a })" },
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "[N] -> (C[] : { B[a,b] : a > N })",
+	  "{ A[a,b] -> B[b,a] : a > b }",
+	  "[N] -> (C[] : { A[a,b] : a > b > N })" },
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "(C[] : { B[a,b] : a > b })",
+	  "[N] -> { A[a,b] -> B[b,a] : a > N }",
+	  "[N] -> (C[] : { A[a,b] : b > a > N })" },
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "C[]",
+	  "{ A[a,b] -> B[b,a] }",
+	  "C[]" },
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "[N] -> (C[] : { : N >= 0 })",
+	  "{ A[a,b] -> B[b,a] }",
+	  "[N] -> (C[] : { : N >= 0 })" },
+	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
+	  "C[]",
+	  "[N] -> { A[a,b] -> B[b,a] : N >= 0 }",
+	  "[N] -> (C[] : { : N >= 0 })" },
+};
+
+/* Perform some basic tests of binary operations on
+ * pairs of isl_multi_union_pw_aff and isl_union_pw_multi_aff objects.
+ */
+static int test_mupa_upma(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_multi_union_pw_aff *mupa, *res;
+	isl_union_pw_multi_aff *upma;
+
+	for (i = 0; i < ARRAY_SIZE(mupa_upma_tests); ++i) {
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
+						    mupa_upma_tests[i].arg1);
+		upma = isl_union_pw_multi_aff_read_from_str(ctx,
+						    mupa_upma_tests[i].arg2);
+		res = isl_multi_union_pw_aff_read_from_str(ctx,
+						    mupa_upma_tests[i].res);
+		mupa = mupa_upma_tests[i].fn(mupa, upma);
+		ok = isl_multi_union_pw_aff_plain_is_equal(mupa, res);
+		isl_multi_union_pw_aff_free(mupa);
+		isl_multi_union_pw_aff_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Check that the input tuple of an isl_aff can be set properly.
+ */
+static isl_stat test_aff_set_tuple_id(isl_ctx *ctx)
+{
+	isl_id *id;
+	isl_aff *aff;
+	isl_stat equal;
+
+	aff = isl_aff_read_from_str(ctx, "{ [x] -> [x + 1] }");
+	id = isl_id_alloc(ctx, "A", NULL);
+	aff = isl_aff_set_tuple_id(aff, isl_dim_in, id);
+	equal = aff_check_plain_equal(aff, "{ A[x] -> [x + 1] }");
+	isl_aff_free(aff);
+	if (equal < 0)
+		return isl_stat_error;
+
+	return isl_stat_ok;
+}
+
+/* Check that affine expressions get normalized on addition/subtraction.
+ * In particular, check that (final) unused integer divisions get removed
+ * such that an expression derived from expressions with integer divisions
+ * is found to be obviously equal to one that is created directly.
+ */
+static isl_stat test_aff_normalize(isl_ctx *ctx)
+{
+	isl_aff *aff, *aff2;
+	isl_stat ok;
+
+	aff = isl_aff_read_from_str(ctx, "{ [x] -> [x//2] }");
+	aff2 = isl_aff_read_from_str(ctx, "{ [x] -> [1 + x//2] }");
+	aff = isl_aff_sub(aff2, aff);
+	ok = aff_check_plain_equal(aff, "{ [x] -> [1] }");
+	isl_aff_free(aff);
+
+	return ok;
+}
+
+/* Check that after aligning the divs of the elements of a multi affine
+ * expression, all elements share the same local space and
+ * that the aligned expression is still equal to the original.
+ */
+static isl_stat test_multi_aff_align_divs(isl_ctx *ctx)
+{
+	const char *str;
+	isl_multi_aff *ma, *aligned;
+	isl_map *map1, *map2;
+	isl_aff *aff0 = NULL, *aff;
+	isl_size n;
+	isl_bool equal;
+	int i;
+
+	str = "{ [x, y] -> [floor(x/2), floor(y/3), floor(x/2) + floor(y/3), x] }";
+	ma = isl_multi_aff_read_from_str(ctx, str);
+	aligned = isl_multi_aff_align_divs(isl_multi_aff_copy(ma));
+	map1 = isl_map_from_multi_aff(ma);
+	map2 = isl_map_from_multi_aff(isl_multi_aff_copy(aligned));
+	equal = isl_map_is_equal(map1, map2);
+	isl_map_free(map1);
+	isl_map_free(map2);
+	n = isl_multi_aff_size(aligned);
+	if (equal < 0 || n < 0)
+		goto error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"aligning divs changed expression", goto error);
+
+	aff0 = isl_multi_aff_get_at(aligned, 0);
+	for (i = 1; i < n; ++i) {
+		int shared;
+
+		aff = isl_multi_aff_get_at(aligned, i);
+		if (!aff0 || !aff) {
+			isl_aff_free(aff);
+			goto error;
+		}
+		shared = aff->ls == aff0->ls;
+		isl_aff_free(aff);
+		if (!shared)
+			isl_die(ctx, isl_error_unknown,
+				"local space not shared", goto error);
+	}
+
+	isl_aff_free(aff0);
+	isl_multi_aff_free(aligned);
+	return isl_stat_ok;
+error:
+	isl_aff_free(aff0);
+	isl_multi_aff_free(aligned);
+	return isl_stat_error;
+}
+
+int test_aff(isl_ctx *ctx)
+{
+	const char *str;
+	isl_set *set;
+	isl_space *space;
+	isl_local_space *ls;
+	isl_aff *aff;
+	int zero;
+	isl_stat equal;
+
+	if (test_upa(ctx) < 0)
+		return -1;
+	if (test_bin_aff(ctx) < 0)
+		return -1;
+	if (test_bin_pw_aff(ctx) < 0)
+		return -1;
+	if (test_upma_test(ctx) < 0)
+		return -1;
+	if (test_bin_upma(ctx) < 0)
+		return -1;
+	if (test_bin_upma_fail(ctx) < 0)
+		return -1;
+	if (test_upma_uset(ctx) < 0)
+		return -1;
+	if (test_un_mpa(ctx) < 0)
+		return -1;
+	if (test_bin_mpa(ctx) < 0)
+		return -1;
+	if (test_un_mupa(ctx) < 0)
+		return -1;
+	if (test_bin_mupa(ctx) < 0)
+		return -1;
+	if (test_mupa_set(ctx) < 0)
+		return -1;
+	if (test_mupa_uset(ctx) < 0)
+		return -1;
+	if (test_mupa_ma(ctx) < 0)
+		return -1;
+	if (test_mupa_pa(ctx) < 0)
+		return -1;
+	if (test_mupa_pma(ctx) < 0)
+		return -1;
+	if (test_mupa_upma(ctx) < 0)
+		return -1;
+	if (test_multi_aff_align_divs(ctx) < 0)
+		return -1;
+
+	space = isl_space_set_alloc(ctx, 0, 1);
+	ls = isl_local_space_from_space(space);
+	aff = isl_aff_zero_on_domain(ls);
+
+	aff = isl_aff_add_coefficient_si(aff, isl_dim_in, 0, 1);
+	aff = isl_aff_scale_down_ui(aff, 3);
+	aff = isl_aff_floor(aff);
+	aff = isl_aff_add_coefficient_si(aff, isl_dim_in, 0, 1);
+	aff = isl_aff_scale_down_ui(aff, 2);
+	aff = isl_aff_floor(aff);
+	aff = isl_aff_add_coefficient_si(aff, isl_dim_in, 0, 1);
+
+	str = "{ [10] }";
+	set = isl_set_read_from_str(ctx, str);
+	aff = isl_aff_gist(aff, set);
+
+	aff = isl_aff_add_constant_si(aff, -16);
+	zero = isl_aff_plain_is_zero(aff);
+	isl_aff_free(aff);
+
+	if (zero < 0)
+		return -1;
+	if (!zero)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
+	aff = isl_aff_read_from_str(ctx, "{ [-1] }");
+	aff = isl_aff_scale_down_ui(aff, 64);
+	aff = isl_aff_floor(aff);
+	equal = aff_check_plain_equal(aff, "{ [-1] }");
+	isl_aff_free(aff);
+	if (equal < 0)
+		return -1;
+
+	if (test_aff_set_tuple_id(ctx) < 0)
+		return -1;
+	if (test_aff_normalize(ctx) < 0)
+		return -1;
+
+	return 0;
+}
+
+/* Inputs for isl_set_bind tests.
+ * "set" is the input set.
+ * "tuple" is the binding tuple.
+ * "res" is the expected result.
+ */
+static
+struct {
+	const char *set;
+	const char *tuple;
+	const char *res;
+} bind_set_tests[] = {
+	{ "{ A[M, N] : M mod 2 = 0 and N mod 8 = 3 }",
+	  "{ A[M, N] }",
+	  "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }" },
+	{ "{ B[N, M] : M mod 2 = 0 and N mod 8 = 3 }",
+	  "{ B[N, M] }",
+	  "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }" },
+	{ "[M] -> { C[N] : M mod 2 = 0 and N mod 8 = 3 }",
+	  "{ C[N] }",
+	  "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }" },
+	{ "[M] -> { D[x, N] : x mod 2 = 0 and N mod 8 = 3 and M >= 0 }",
+	  "{ D[M, N] }",
+	  "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 and M >= 0 }" },
+};
+
+/* Perform basic isl_set_bind tests.
+ */
+static isl_stat test_bind_set(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bind_set_tests); ++i) {
+		const char *str;
+		isl_set *set;
+		isl_multi_id *tuple;
+		isl_stat r;
+
+		set = isl_set_read_from_str(ctx, bind_set_tests[i].set);
+		str = bind_set_tests[i].tuple;
+		tuple = isl_multi_id_read_from_str(ctx, str);
+		set = isl_set_bind(set, tuple);
+		r = set_check_equal(set, bind_set_tests[i].res);
+		isl_set_free(set);
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for isl_map_bind_domain tests.
+ * "map" is the input map.
+ * "tuple" is the binding tuple.
+ * "res" is the expected result.
+ */
+struct {
+	const char *map;
+	const char *tuple;
+	const char *res;
+} bind_map_domain_tests[] = {
+	{ "{ A[M, N] -> [M + floor(N/2)] }",
+	  "{ A[M, N] }",
+	  "[M, N] -> { [M + floor(N/2)] }" },
+	{ "{ B[N, M] -> [M + floor(N/2)] }",
+	  "{ B[N, M] }",
+	  "[N, M] -> { [M + floor(N/2)] }" },
+	{ "[M] -> { C[N] -> [M + floor(N/2)] }",
+	  "{ C[N] }",
+	  "[M, N] -> { [M + floor(N/2)] }" },
+	{ "[M] -> { C[x, N] -> [x + floor(N/2)] }",
+	  "{ C[M, N] }",
+	  "[M, N] -> { [M + floor(N/2)] }" },
+	{ "[M] -> { C[x, N] -> [M + floor(N/2)] }",
+	  "{ C[M, N] }",
+	  "[M, N] -> { [M + floor(N/2)] }" },
+	{ "[A, M] -> { C[N, x] -> [x + floor(N/2)] }",
+	  "{ C[N, M] }",
+	  "[A, N, M] -> { [M + floor(N/2)] }" },
+};
+
+/* Perform basic isl_map_bind_domain tests.
+ */
+static isl_stat test_bind_map_domain(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bind_map_domain_tests); ++i) {
+		const char *str;
+		isl_map *map;
+		isl_set *set;
+		isl_multi_id *tuple;
+		isl_stat r;
+
+		str = bind_map_domain_tests[i].map;
+		map = isl_map_read_from_str(ctx, str);
+		str = bind_map_domain_tests[i].tuple;
+		tuple = isl_multi_id_read_from_str(ctx, str);
+		set = isl_map_bind_domain(map, tuple);
+		str = bind_map_domain_tests[i].res;
+		r = set_check_equal(set, str);
+		isl_set_free(set);
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for isl_union_map_bind_range tests.
+ * "map" is the input union map.
+ * "tuple" is the binding tuple.
+ * "res" is the expected result.
+ */
+struct {
+	const char *map;
+	const char *tuple;
+	const char *res;
+} bind_umap_range_tests[] = {
+	{ "{ B[N, M] -> A[M, N] : M mod 2 = 0 and N mod 8 = 3 }",
+	  "{ A[M, N] }",
+	  "[M, N] -> { B[N, M] : M mod 2 = 0 and N mod 8 = 3 }" },
+	{ "{ B[N, M] -> A[M, N] : M mod 2 = 0 and N mod 8 = 3 }",
+	  "{ B[M, N] }",
+	  "{ }" },
+	{ "{ A[] -> B[]; C[] -> D[]; E[] -> B[] }",
+	  "{ B[] }",
+	  "{ A[]; E[] }" },
+};
+
+/* Perform basic isl_union_map_bind_range tests.
+ */
+static isl_stat test_bind_umap_range(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bind_umap_range_tests); ++i) {
+		const char *str;
+		isl_union_map *umap;
+		isl_union_set *uset;
+		isl_multi_id *tuple;
+		isl_stat r;
+
+		str = bind_umap_range_tests[i].map;
+		umap = isl_union_map_read_from_str(ctx, str);
+		str = bind_umap_range_tests[i].tuple;
+		tuple = isl_multi_id_read_from_str(ctx, str);
+		uset = isl_union_map_bind_range(umap, tuple);
+		str = bind_umap_range_tests[i].res;
+		r = uset_check_equal(uset, str);
+		isl_union_set_free(uset);
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for isl_pw_multi_aff_bind_domain tests.
+ * "pma" is the input expression.
+ * "tuple" is the binding tuple.
+ * "res" is the expected result.
+ */
+struct {
+	const char *pma;
+	const char *tuple;
+	const char *res;
+} bind_pma_domain_tests[] = {
+	{ "{ A[M, N] -> [M + floor(N/2)] }",
+	  "{ A[M, N] }",
+	  "[M, N] -> { [M + floor(N/2)] }" },
+	{ "{ B[N, M] -> [M + floor(N/2)] }",
+	  "{ B[N, M] }",
+	  "[N, M] -> { [M + floor(N/2)] }" },
+	{ "[M] -> { C[N] -> [M + floor(N/2)] }",
+	  "{ C[N] }",
+	  "[M, N] -> { [M + floor(N/2)] }" },
+	{ "[M] -> { C[x, N] -> [x + floor(N/2)] }",
+	  "{ C[M, N] }",
+	  "[M, N] -> { [M + floor(N/2)] }" },
+	{ "[M] -> { C[x, N] -> [M + floor(N/2)] }",
+	  "{ C[M, N] }",
+	  "[M, N] -> { [M + floor(N/2)] }" },
+	{ "[A, M] -> { C[N, x] -> [x + floor(N/2)] }",
+	  "{ C[N, M] }",
+	  "[A, N, M] -> { [M + floor(N/2)] }" },
+};
+
+/* Perform basic isl_pw_multi_aff_bind_domain tests.
+ */
+static isl_stat test_bind_pma_domain(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bind_pma_domain_tests); ++i) {
+		const char *str;
+		isl_pw_multi_aff *pma;
+		isl_multi_id *tuple;
+		isl_stat r;
+
+		str = bind_pma_domain_tests[i].pma;
+		pma = isl_pw_multi_aff_read_from_str(ctx, str);
+		str = bind_pma_domain_tests[i].tuple;
+		tuple = isl_multi_id_read_from_str(ctx, str);
+		pma = isl_pw_multi_aff_bind_domain(pma, tuple);
+		str = bind_pma_domain_tests[i].res;
+		r = pw_multi_aff_check_plain_equal(pma, str);
+		isl_pw_multi_aff_free(pma);
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for isl_pw_multi_aff_bind_domain_wrapped_domain tests.
+ * "pma" is the input expression.
+ * "tuple" is the binding tuple.
+ * "res" is the expected result.
+ */
+struct {
+	const char *pma;
+	const char *tuple;
+	const char *res;
+} bind_pma_domain_wrapped_tests[] = {
+	{ "{ [A[M, N] -> B[]] -> [M + floor(N/2)] }",
+	  "{ A[M, N] }",
+	  "[M, N] -> { B[] -> [M + floor(N/2)] }" },
+	{ "{ [B[N, M] -> D[]] -> [M + floor(N/2)] }",
+	  "{ B[N, M] }",
+	  "[N, M] -> { D[] -> [M + floor(N/2)] }" },
+	{ "[M] -> { [C[N] -> B[x]] -> [x + M + floor(N/2)] }",
+	  "{ C[N] }",
+	  "[M, N] -> { B[x] -> [x + M + floor(N/2)] }" },
+	{ "[M] -> { [C[x, N] -> B[]] -> [x + floor(N/2)] }",
+	  "{ C[M, N] }",
+	  "[M, N] -> { B[] -> [M + floor(N/2)] }" },
+	{ "[M] -> { [C[x, N] -> B[]] -> [M + floor(N/2)] }",
+	  "{ C[M, N] }",
+	  "[M, N] -> { B[] -> [M + floor(N/2)] }" },
+	{ "[A, M] -> { [C[N, x] -> B[]] -> [x + floor(N/2)] }",
+	  "{ C[N, M] }",
+	  "[A, N, M] -> { B[] -> [M + floor(N/2)] }" },
+};
+
+/* Perform basic isl_pw_multi_aff_bind_domain_wrapped_domain tests.
+ */
+static isl_stat test_bind_pma_domain_wrapped(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bind_pma_domain_wrapped_tests); ++i) {
+		const char *str;
+		isl_pw_multi_aff *pma;
+		isl_multi_id *tuple;
+		isl_stat r;
+
+		str = bind_pma_domain_wrapped_tests[i].pma;
+		pma = isl_pw_multi_aff_read_from_str(ctx, str);
+		str = bind_pma_domain_wrapped_tests[i].tuple;
+		tuple = isl_multi_id_read_from_str(ctx, str);
+		pma = isl_pw_multi_aff_bind_domain_wrapped_domain(pma, tuple);
+		str = bind_pma_domain_wrapped_tests[i].res;
+		r = pw_multi_aff_check_plain_equal(pma, str);
+		isl_pw_multi_aff_free(pma);
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for isl_aff_bind_id tests.
+ * "aff" is the input expression.
+ * "id" is the binding id.
+ * "res" is the expected result.
+ */
+static
+struct {
+	const char *aff;
+	const char *id;
+	const char *res;
+} bind_aff_tests[] = {
+	{ "{ [4] }", "M", "[M = 4] -> { : }" },
+	{ "{ B[x] -> [floor(x/2)] }", "M", "[M] -> { B[x] : M = floor(x/2) }" },
+	{ "[M] -> { [4] }", "M", "[M = 4] -> { : }" },
+	{ "[M] -> { [floor(M/2)] }", "M", "[M] -> { : floor(M/2) = M }" },
+	{ "{ [NaN] }", "M", "{ : false }" },
+	{ "{ A[x] -> [NaN] }", "M", "{ A[x] : false }" },
+};
+
+/* Perform basic isl_aff_bind_id tests.
+ */
+static isl_stat test_bind_aff(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bind_aff_tests); ++i) {
+		isl_aff *aff;
+		isl_set *res;
+		isl_id *id;
+		isl_stat r;
+
+		aff = isl_aff_read_from_str(ctx, bind_aff_tests[i].aff);
+		id = isl_id_read_from_str(ctx, bind_aff_tests[i].id);
+		res = isl_set_from_basic_set(isl_aff_bind_id(aff, id));
+		r = set_check_equal(res, bind_aff_tests[i].res);
+		isl_set_free(res);
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for isl_pw_aff_bind_id tests.
+ * "pa" is the input expression.
+ * "id" is the binding id.
+ * "res" is the expected result.
+ */
+static
+struct {
+	const char *pa;
+	const char *id;
+	const char *res;
+} bind_pa_tests[] = {
+	{ "{ [4] }", "M", "[M = 4] -> { : }" },
+	{ "{ B[x] -> [floor(x/2)] }", "M", "[M] -> { B[x] : M = floor(x/2) }" },
+	{ "[M] -> { [4] }", "M", "[M = 4] -> { : }" },
+	{ "[M] -> { [floor(M/2)] }", "M", "[M] -> { : floor(M/2) = M }" },
+	{ "[M] -> { [M] : M >= 0; [-M] : M < 0 }", "M", "[M] -> { : M >= 0 }" },
+	{ "{ [NaN] }", "M", "{ : false }" },
+	{ "{ A[x] -> [NaN] }", "M", "{ A[x] : false }" },
+};
+
+/* Perform basic isl_pw_aff_bind_id tests.
+ */
+static isl_stat test_bind_pa(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bind_pa_tests); ++i) {
+		isl_pw_aff *pa;
+		isl_set *res;
+		isl_id *id;
+		isl_stat r;
+
+		pa = isl_pw_aff_read_from_str(ctx, bind_pa_tests[i].pa);
+		id = isl_id_read_from_str(ctx, bind_pa_tests[i].id);
+		res = isl_pw_aff_bind_id(pa, id);
+		r = set_check_equal(res, bind_pa_tests[i].res);
+		isl_set_free(res);
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for isl_multi_union_pw_aff_bind tests.
+ * "mupa" is the input expression.
+ * "tuple" is the binding tuple.
+ * "res" is the expected result.
+ */
+static
+struct {
+	const char *mupa;
+	const char *tuple;
+	const char *res;
+} bind_mupa_tests[] = {
+	{ "A[{ [4] }, { [5] }]",
+	  "{ A[M, N] }",
+	  "[M = 4, N = 5] -> { : }" },
+	{ "A[{ B[x] -> [floor(x/2)] }, { B[y] -> [y + 5] }]",
+	  "{ A[M, N] }",
+	  "[M, N] -> { B[x] : M = floor(x/2) and N = x + 5 }" },
+	{ "[M] -> A[{ [4] }, { [M + 1] }]",
+	  "{ A[M, N] }",
+	  "[M = 4, N = 5] -> { : }" },
+};
+
+/* Perform basic isl_multi_union_pw_aff_bind tests.
+ */
+static isl_stat test_bind_mupa(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bind_mupa_tests); ++i) {
+		const char *str;
+		isl_multi_union_pw_aff *mupa;
+		isl_union_set *res;
+		isl_multi_id *tuple;
+		isl_stat r;
+
+		str = bind_mupa_tests[i].mupa;
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
+		str = bind_mupa_tests[i].tuple;
+		tuple = isl_multi_id_read_from_str(ctx, str);
+		res = isl_multi_union_pw_aff_bind(mupa, tuple);
+		r = uset_check_equal(res, bind_mupa_tests[i].res);
+		isl_union_set_free(res);
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Perform tests that reinterpret dimensions as parameters.
+ */
+static int test_bind(isl_ctx *ctx)
+{
+	if (test_bind_set(ctx) < 0)
+		return -1;
+	if (test_bind_map_domain(ctx) < 0)
+		return -1;
+	if (test_bind_umap_range(ctx) < 0)
+		return -1;
+	if (test_bind_pma_domain(ctx) < 0)
+		return -1;
+	if (test_bind_pma_domain_wrapped(ctx) < 0)
+		return -1;
+	if (test_bind_aff(ctx) < 0)
+		return -1;
+	if (test_bind_pa(ctx) < 0)
+		return -1;
+	if (test_bind_mupa(ctx) < 0)
+		return -1;
+
+	return 0;
+}
+
+/* Inputs for isl_set_unbind_params tests.
+ * "set" is the input parameter domain.
+ * "tuple" is the tuple of the constructed set.
+ * "res" is the expected result.
+ */
+struct {
+	const char *set;
+	const char *tuple;
+	const char *res;
+} unbind_set_tests[] = {
+	{ "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }",
+	  "{ A[M, N] }",
+	  "{ A[M, N] : M mod 2 = 0 and N mod 8 = 3 }" },
+	{ "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }",
+	  "{ B[N, M] }",
+	  "{ B[N, M] : M mod 2 = 0 and N mod 8 = 3 }" },
+	{ "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }",
+	  "{ C[N] }",
+	  "[M] -> { C[N] : M mod 2 = 0 and N mod 8 = 3 }" },
+	{ "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }",
+	  "{ D[T, N] }",
+	  "[M] -> { D[x, N] : M mod 2 = 0 and N mod 8 = 3 }" },
+};
+
+/* Perform basic isl_set_unbind_params tests.
+ */
+static isl_stat test_unbind_set(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(unbind_set_tests); ++i) {
+		const char *str;
+		isl_set *set;
+		isl_multi_id *tuple;
+		isl_stat r;
+
+		set = isl_set_read_from_str(ctx, unbind_set_tests[i].set);
+		str = unbind_set_tests[i].tuple;
+		tuple = isl_multi_id_read_from_str(ctx, str);
+		set = isl_set_unbind_params(set, tuple);
+		r = set_check_equal(set, unbind_set_tests[i].res);
+		isl_set_free(set);
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for isl_aff_unbind_params_insert_domain tests.
+ * "aff" is the input affine expression defined over a parameter domain.
+ * "tuple" is the tuple of the domain that gets introduced.
+ * "res" is the expected result.
+ */
+struct {
+	const char *aff;
+	const char *tuple;
+	const char *res;
+} unbind_aff_tests[] = {
+	{ "[M, N] -> { [M + floor(N/2)] }",
+	  "{ A[M, N] }",
+	  "{ A[M, N] -> [M + floor(N/2)] }" },
+	{ "[M, N] -> { [M + floor(N/2)] }",
+	  "{ B[N, M] }",
+	  "{ B[N, M] -> [M + floor(N/2)] }" },
+	{ "[M, N] -> { [M + floor(N/2)] }",
+	  "{ C[N] }",
+	  "[M] -> { C[N] -> [M + floor(N/2)] }" },
+	{ "[M, N] -> { [M + floor(N/2)] }",
+	  "{ D[A, B, C, N, Z] }",
+	  "[M] -> { D[A, B, C, N, Z] -> [M + floor(N/2)] }" },
+};
+
+/* Perform basic isl_aff_unbind_params_insert_domain tests.
+ */
+static isl_stat test_unbind_aff(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(unbind_aff_tests); ++i) {
+		const char *str;
+		isl_aff *aff;
+		isl_multi_id *tuple;
+		isl_stat r;
+
+		aff = isl_aff_read_from_str(ctx, unbind_aff_tests[i].aff);
+		str = unbind_aff_tests[i].tuple;
+		tuple = isl_multi_id_read_from_str(ctx, str);
+		aff = isl_aff_unbind_params_insert_domain(aff, tuple);
+		r = aff_check_plain_equal(aff, unbind_aff_tests[i].res);
+		isl_aff_free(aff);
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for isl_multi_aff_unbind_params_insert_domain tests.
+ * "ma" is the input multi affine expression defined over a parameter domain.
+ * "tuple" is the tuple of the domain that gets introduced.
+ * "res" is the expected result.
+ */
+static struct {
+	const char *ma;
+	const char *tuple;
+	const char *res;
+} unbind_multi_aff_tests[] = {
+	{ "[M, N] -> { T[M + floor(N/2)] }",
+	  "{ A[M, N] }",
+	  "{ A[M, N] -> T[M + floor(N/2)] }" },
+	{ "[M, N] -> { [M + floor(N/2)] }",
+	  "{ B[N, M] }",
+	  "{ B[N, M] -> [M + floor(N/2)] }" },
+	{ "[M, N] -> { [M + floor(N/2)] }",
+	  "{ C[N] }",
+	  "[M] -> { C[N] -> [M + floor(N/2)] }" },
+	{ "[M, N] -> { [M + floor(N/2)] }",
+	  "{ D[A, B, C, N, Z] }",
+	  "[M] -> { D[A, B, C, N, Z] -> [M + floor(N/2)] }" },
+	{ "[M, N] -> { T[M + floor(N/2), N + floor(M/3)] }",
+	  "{ A[M, N] }",
+	  "{ A[M, N] -> T[M + floor(N/2), N + floor(M/3)] }" },
+};
+
+/* Perform basic isl_multi_aff_unbind_params_insert_domain tests.
+ */
+static isl_stat test_unbind_multi_aff(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(unbind_multi_aff_tests); ++i) {
+		const char *str;
+		isl_multi_aff *ma;
+		isl_multi_id *tuple;
+		isl_stat r;
+
+		str = unbind_multi_aff_tests[i].ma;
+		ma = isl_multi_aff_read_from_str(ctx, str);
+		str = unbind_multi_aff_tests[i].tuple;
+		tuple = isl_multi_id_read_from_str(ctx, str);
+		ma = isl_multi_aff_unbind_params_insert_domain(ma, tuple);
+		str = unbind_multi_aff_tests[i].res;
+		r = multi_aff_check_plain_equal(ma, str);
+		isl_multi_aff_free(ma);
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Perform tests that reinterpret parameters.
+ */
+static int test_unbind(isl_ctx *ctx)
+{
+	if (test_unbind_set(ctx) < 0)
+		return -1;
+	if (test_unbind_aff(ctx) < 0)
+		return -1;
+	if (test_unbind_multi_aff(ctx) < 0)
+		return -1;
+
+	return 0;
+}
+
+/* Check that "pa" consists of a single expression.
+ */
+static int check_single_piece(isl_ctx *ctx, __isl_take isl_pw_aff *pa)
+{
+	isl_size n;
+
+	n = isl_pw_aff_n_piece(pa);
+	isl_pw_aff_free(pa);
+
+	if (n < 0)
+		return -1;
+	if (n != 1)
+		isl_die(ctx, isl_error_unknown, "expecting single expression",
+			return -1);
+
+	return 0;
+}
+
+/* Check that the computation below results in a single expression.
+ * One or two expressions may result depending on which constraint
+ * ends up being considered as redundant with respect to the other
+ * constraints after the projection that is performed internally
+ * by isl_set_dim_min.
+ */
+static int test_dim_max_1(isl_ctx *ctx)
+{
+	const char *str;
+	isl_set *set;
+	isl_pw_aff *pa;
+
+	str = "[n] -> { [a, b] : n >= 0 and 4a >= -4 + n and b >= 0 and "
+				"-4a <= b <= 3 and b < n - 4a }";
+	set = isl_set_read_from_str(ctx, str);
+	pa = isl_set_dim_min(set, 0);
+	return check_single_piece(ctx, pa);
+}
+
+/* Check that the computation below results in a single expression.
+ * The PIP problem corresponding to these constraints has a row
+ * that causes a split of the solution domain.  The solver should
+ * first pick rows that split off empty parts such that the actual
+ * solution domain does not get split.
+ * Note that the description contains some redundant constraints.
+ * If these constraints get removed first, then the row mentioned
+ * above does not appear in the PIP problem.
+ */
+static int test_dim_max_2(isl_ctx *ctx)
+{
+	const char *str;
+	isl_set *set;
+	isl_pw_aff *pa;
+
+	str = "[P, N] -> { [a] : a < N and a >= 0 and N > P and a <= P and "
+				"N > 0 and P >= 0 }";
+	set = isl_set_read_from_str(ctx, str);
+	pa = isl_set_dim_max(set, 0);
+	return check_single_piece(ctx, pa);
+}
+
+int test_dim_max(isl_ctx *ctx)
+{
+	int equal;
+	const char *str;
+	isl_set *set1, *set2;
+	isl_set *set;
+	isl_map *map;
+	isl_pw_aff *pwaff;
+
+	if (test_dim_max_1(ctx) < 0)
+		return -1;
+	if (test_dim_max_2(ctx) < 0)
+		return -1;
+
+	str = "[N] -> { [i] : 0 <= i <= min(N,10) }";
+	set = isl_set_read_from_str(ctx, str);
+	pwaff = isl_set_dim_max(set, 0);
+	set1 = isl_set_from_pw_aff(pwaff);
+	str = "[N] -> { [10] : N >= 10; [N] : N <= 9 and N >= 0 }";
+	set2 = isl_set_read_from_str(ctx, str);
+	equal = isl_set_is_equal(set1, set2);
+	isl_set_free(set1);
+	isl_set_free(set2);
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
+	str = "[N] -> { [i] : 0 <= i <= max(2N,N+6) }";
+	set = isl_set_read_from_str(ctx, str);
+	pwaff = isl_set_dim_max(set, 0);
+	set1 = isl_set_from_pw_aff(pwaff);
+	str = "[N] -> { [6 + N] : -6 <= N <= 5; [2N] : N >= 6 }";
+	set2 = isl_set_read_from_str(ctx, str);
+	equal = isl_set_is_equal(set1, set2);
+	isl_set_free(set1);
+	isl_set_free(set2);
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
+	str = "[N] -> { [i] : 0 <= i <= 2N or 0 <= i <= N+6 }";
+	set = isl_set_read_from_str(ctx, str);
+	pwaff = isl_set_dim_max(set, 0);
+	set1 = isl_set_from_pw_aff(pwaff);
+	str = "[N] -> { [6 + N] : -6 <= N <= 5; [2N] : N >= 6 }";
+	set2 = isl_set_read_from_str(ctx, str);
+	equal = isl_set_is_equal(set1, set2);
+	isl_set_free(set1);
+	isl_set_free(set2);
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
+	str = "[N,M] -> { [i,j] -> [([i/16]), i%16, ([j/16]), j%16] : "
+			"0 <= i < N and 0 <= j < M }";
+	map = isl_map_read_from_str(ctx, str);
+	set = isl_map_range(map);
+
+	pwaff = isl_set_dim_max(isl_set_copy(set), 0);
+	set1 = isl_set_from_pw_aff(pwaff);
+	str = "[N,M] -> { [([(N-1)/16])] : M,N > 0 }";
+	set2 = isl_set_read_from_str(ctx, str);
+	equal = isl_set_is_equal(set1, set2);
+	isl_set_free(set1);
+	isl_set_free(set2);
+
+	pwaff = isl_set_dim_max(isl_set_copy(set), 3);
+	set1 = isl_set_from_pw_aff(pwaff);
+	str = "[N,M] -> { [t] : t = min(M-1,15) and M,N > 0 }";
+	set2 = isl_set_read_from_str(ctx, str);
+	if (equal >= 0 && equal)
+		equal = isl_set_is_equal(set1, set2);
+	isl_set_free(set1);
+	isl_set_free(set2);
+
+	isl_set_free(set);
+
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
+	/* Check that solutions are properly merged. */
+	str = "[n] -> { [a, b, c] : c >= -4a - 2b and "
+				"c <= -1 + n - 4a - 2b and c >= -2b and "
+				"4a >= -4 + n and c >= 0 }";
+	set = isl_set_read_from_str(ctx, str);
+	pwaff = isl_set_dim_min(set, 2);
+	set1 = isl_set_from_pw_aff(pwaff);
+	str = "[n] -> { [(0)] : n >= 1 }";
+	set2 = isl_set_read_from_str(ctx, str);
+	equal = isl_set_is_equal(set1, set2);
+	isl_set_free(set1);
+	isl_set_free(set2);
+
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
+	/* Check that empty solution lie in the right space. */
+	str = "[n] -> { [t,a] : 1 = 0 }";
+	set = isl_set_read_from_str(ctx, str);
+	pwaff = isl_set_dim_max(set, 0);
+	set1 = isl_set_from_pw_aff(pwaff);
+	str = "[n] -> { [t] : 1 = 0 }";
+	set2 = isl_set_read_from_str(ctx, str);
+	equal = isl_set_is_equal(set1, set2);
+	isl_set_free(set1);
+	isl_set_free(set2);
+
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
+	return 0;
+}
+
+/* Basic test for isl_pw_multi_aff_product.
+ *
+ * Check that multiple pieces are properly handled.
+ */
+static int test_product_pma(isl_ctx *ctx)
+{
+	isl_stat equal;
+	const char *str;
+	isl_pw_multi_aff *pma1, *pma2;
+
+	str = "{ A[i] -> B[1] : i < 0; A[i] -> B[2] : i >= 0 }";
+	pma1 = isl_pw_multi_aff_read_from_str(ctx, str);
+	str = "{ C[] -> D[] }";
+	pma2 = isl_pw_multi_aff_read_from_str(ctx, str);
+	pma1 = isl_pw_multi_aff_product(pma1, pma2);
+	str = "{ [A[i] -> C[]] -> [B[(1)] -> D[]] : i < 0;"
+		"[A[i] -> C[]] -> [B[(2)] -> D[]] : i >= 0 }";
+	equal = pw_multi_aff_check_plain_equal(pma1, str);
+	isl_pw_multi_aff_free(pma1);
+	if (equal < 0)
+		return -1;
+
+	return 0;
+}
+
+int test_product(isl_ctx *ctx)
+{
+	const char *str;
+	isl_set *set;
+	isl_union_set *uset1, *uset2;
+	int ok;
+
+	str = "{ A[i] }";
+	set = isl_set_read_from_str(ctx, str);
+	set = isl_set_product(set, isl_set_copy(set));
+	ok = isl_set_is_wrapping(set);
+	isl_set_free(set);
+	if (ok < 0)
+		return -1;
+	if (!ok)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
+	str = "{ [] }";
+	uset1 = isl_union_set_read_from_str(ctx, str);
+	uset1 = isl_union_set_product(uset1, isl_union_set_copy(uset1));
+	str = "{ [[] -> []] }";
+	uset2 = isl_union_set_read_from_str(ctx, str);
+	ok = isl_union_set_is_equal(uset1, uset2);
+	isl_union_set_free(uset1);
+	isl_union_set_free(uset2);
+	if (ok < 0)
+		return -1;
+	if (!ok)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
+	if (test_product_pma(ctx) < 0)
+		return -1;
+
+	return 0;
+}
+
+/* Inputs for isl_set_list_intersect_is_empty tests.
+ * "list" is a list of sets, "context" is the context and
+ * "empty" is the expected result.
+ */
+static struct {
+	const char *list;
+	const char *context;
+	int empty;
+} disjoint_list_tests[] = {
+	{ "({ [x, y] : x >= 10 }, { [x, y] : x >= 0 and y < 0 })",
+	  "{ [x, y] : 0 <= x <= 5 and y >= 0 }", 1 },
+	{ "({ [x, y] : x >= 10 }, { [x, y] : x >= 5 and y >= 3 })",
+	  "{ [x, y] : 0 <= x <= 5 and y >= 0 }", 0 },
+	{ "({ [x, y] : x >= 10 or x < 0 }, { [x, y] : y = 2x + 1 })",
+	  "{ [x, y] : 0 <= x <= 5 and y >= 0 and y mod 2 = 0 }", 1 },
+	{ "({ [x, y] : x >= 10 or x < 0 }, { [x, y] : y = 2x })",
+	  "{ [x, y] : 0 <= x <= 5 and y >= 0 and y mod 2 = 0 }", 0 },
+	{ "({ [x] : x >= 10 }, { [x, y] : x >= 10 })",
+	  "{ [x, y] : 0 <= x <= 5; [x, y] : x >= 20 and y = 0 }", 0 },
+	{ "({ [x] : x >= 10 }, { [x, y] : 6 <= x <= 19 })",
+	  "{ [x, y] : 0 <= x <= 5; [x, y] : x >= 20 and y = 0 }", 1 },
+	{ "()", "{ [x] }", 1 },
+};
+
+/* Check that isl_set_list_intersect_is_empty produces the expected results.
+ */
+static isl_stat test_disjoint_list(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(disjoint_list_tests); ++i) {
+		isl_set_list *list;
+		isl_set *context;
+		isl_bool empty;
+
+		list = isl_set_list_read_from_str(ctx,
+						disjoint_list_tests[i].list);
+		context = isl_set_read_from_str(ctx,
+						disjoint_list_tests[i].context);
+		empty = isl_set_list_intersect_is_empty(list, context);
+		isl_set_list_free(list);
+		isl_set_free(context);
+		if (empty < 0)
+			return isl_stat_error;
+		if (empty != disjoint_list_tests[i].empty)
+			isl_die(ctx, isl_error_unknown,
+				"incorrect result", return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for isl_set_make_disjoint tests.
+ */
+static const char *make_disjoint_tests[] = {
+	"{ [i, j] : 0 <= i, j <= 10; [i, j] : 5 <= i, j <= 15; "
+	  "[i, j] : 2 <= i <= 12 and 8 <= j <= 20; "
+	  "[i, j] : 7 <= i <= 30 and 0 <= j <= 3; "
+	  "[i, j] : i, j >= 0 and i + j <= 20 }",
+	"[n] -> { [i, j] : 0 <= i, j <= n; [i, j] : 0 <= i <= j <= 2n; "
+	  "[i, j] : i = j and 0 <= i <= 3n; [i, j] : n <= i, j <= 2n }",
+	"{ [i] : exists (e : i = 2e and 0 <= i <= 20); [i] : 5 <= i <= 15; "
+	  "[i] : exists (e : i = 3e and 0 <= i <= 30) }",
+};
+
+/* Check that isl_set_make_disjoint produces a set that is equal
+ * to the input and that consists of pairwise disjoint basic sets.
+ */
+static isl_stat test_make_disjoint(isl_ctx *ctx)
+{
+	int i, j, k;
+
+	for (i = 0; i < ARRAY_SIZE(make_disjoint_tests); ++i) {
+		isl_set *set, *disjoint;
+		isl_basic_set_list *list;
+		isl_size n;
+		isl_bool equal;
+
+		set = isl_set_read_from_str(ctx, make_disjoint_tests[i]);
+		disjoint = isl_set_make_disjoint(isl_set_copy(set));
+		equal = isl_set_is_equal(set, disjoint);
+		isl_set_free(set);
+		list = isl_set_get_basic_set_list(disjoint);
+		isl_set_free(disjoint);
+		n = isl_basic_set_list_n_basic_set(list);
+		if (equal < 0 || n < 0)
+			equal = isl_bool_error;
+		for (j = 0; equal > 0 && j < n; ++j) {
+			for (k = j + 1; equal > 0 && k < n; ++k) {
+				isl_basic_set *bset1, *bset2;
+				isl_bool empty;
+
+				bset1 = isl_basic_set_list_get_at(list, j);
+				bset2 = isl_basic_set_list_get_at(list, k);
+				bset1 = isl_basic_set_intersect(bset1, bset2);
+				empty = isl_basic_set_is_empty(bset1);
+				isl_basic_set_free(bset1);
+				if (empty < 0 || !empty)
+					equal = empty;
+			}
+		}
+		isl_basic_set_list_free(list);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"incorrect result", return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
+/* Check that two sets are not considered disjoint just because
+ * they have a different set of (named) parameters.
+ */
+static int test_disjoint(isl_ctx *ctx)
+{
+	const char *str;
+	isl_set *set, *set2;
+	int disjoint;
+
+	str = "[n] -> { [[]->[]] }";
+	set = isl_set_read_from_str(ctx, str);
+	str = "{ [[]->[]] }";
+	set2 = isl_set_read_from_str(ctx, str);
+	disjoint = isl_set_is_disjoint(set, set2);
+	isl_set_free(set);
+	isl_set_free(set2);
+	if (disjoint < 0)
+		return -1;
+	if (disjoint)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
+	if (test_disjoint_list(ctx) < 0)
+		return -1;
+	if (test_make_disjoint(ctx) < 0)
+		return -1;
+
+	return 0;
+}
+
+/* Inputs for isl_pw_multi_aff_is_equal tests.
+ * "f1" and "f2" are the two function that need to be compared.
+ * "equal" is the expected result.
+ */
+struct {
+	int equal;
+	const char *f1;
+	const char *f2;
+} pma_equal_tests[] = {
+	{ 1, "[N] -> { [floor(N/2)] : 0 <= N <= 1 }",
+	     "[N] -> { [0] : 0 <= N <= 1 }" },
+	{ 1, "[N] -> { [floor(N/2)] : 0 <= N <= 2 }",
+	     "[N] -> { [0] : 0 <= N <= 1; [1] : N = 2 }" },
+	{ 0, "[N] -> { [floor(N/2)] : 0 <= N <= 2 }",
+	     "[N] -> { [0] : 0 <= N <= 1 }" },
+	{ 0, "{ [NaN] }", "{ [NaN] }" },
+};
+
+int test_equal(isl_ctx *ctx)
+{
+	int i;
+	const char *str;
+	isl_set *set, *set2;
+	int equal;
+
+	str = "{ S_6[i] }";
+	set = isl_set_read_from_str(ctx, str);
+	str = "{ S_7[i] }";
+	set2 = isl_set_read_from_str(ctx, str);
+	equal = isl_set_is_equal(set, set2);
+	isl_set_free(set);
+	isl_set_free(set2);
+	if (equal < 0)
+		return -1;
+	if (equal)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
+	for (i = 0; i < ARRAY_SIZE(pma_equal_tests); ++i) {
+		int expected = pma_equal_tests[i].equal;
+		isl_pw_multi_aff *f1, *f2;
+
+		f1 = isl_pw_multi_aff_read_from_str(ctx, pma_equal_tests[i].f1);
+		f2 = isl_pw_multi_aff_read_from_str(ctx, pma_equal_tests[i].f2);
+		equal = isl_pw_multi_aff_is_equal(f1, f2);
+		isl_pw_multi_aff_free(f1);
+		isl_pw_multi_aff_free(f2);
+		if (equal < 0)
+			return -1;
+		if (equal != expected)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected equality result", return -1);
+	}
+
+	return 0;
+}
+
+static int test_plain_fixed(isl_ctx *ctx, __isl_take isl_map *map,
+	enum isl_dim_type type, unsigned pos, int fixed)
+{
+	isl_bool test;
+
+	test = isl_map_plain_is_fixed(map, type, pos, NULL);
+	isl_map_free(map);
+	if (test < 0)
+		return -1;
+	if (test == fixed)
+		return 0;
+	if (fixed)
+		isl_die(ctx, isl_error_unknown,
+			"map not detected as fixed", return -1);
+	else
+		isl_die(ctx, isl_error_unknown,
+			"map detected as fixed", return -1);
+}
+
+int test_fixed(isl_ctx *ctx)
+{
+	const char *str;
+	isl_map *map;
+
+	str = "{ [i] -> [i] }";
+	map = isl_map_read_from_str(ctx, str);
+	if (test_plain_fixed(ctx, map, isl_dim_out, 0, 0))
+		return -1;
+	str = "{ [i] -> [1] }";
+	map = isl_map_read_from_str(ctx, str);
+	if (test_plain_fixed(ctx, map, isl_dim_out, 0, 1))
+		return -1;
+	str = "{ S_1[p1] -> [o0] : o0 = -2 and p1 >= 1 and p1 <= 7 }";
+	map = isl_map_read_from_str(ctx, str);
+	if (test_plain_fixed(ctx, map, isl_dim_out, 0, 1))
+		return -1;
+	map = isl_map_read_from_str(ctx, str);
+	map = isl_map_neg(map);
+	if (test_plain_fixed(ctx, map, isl_dim_out, 0, 1))
+		return -1;
+
+	return 0;
+}
+
+struct isl_vertices_test_data {
+	const char *set;
+	int n;
+	const char *vertex[6];
+} vertices_tests[] = {
+	{ "{ A[t, i] : t = 12 and i >= 4 and i <= 12 }",
+	  2, { "{ A[12, 4] }", "{ A[12, 12] }" } },
+	{ "{ A[t, i] : t = 14 and i = 1 }",
+	  1, { "{ A[14, 1] }" } },
+	{ "[n, m] -> { [a, b, c] : b <= a and a <= n and b > 0 and c >= b and "
+				"c <= m and m <= n and m > 0 }",
+	  6, {
+		"[n, m] -> { [n, m, m] : 0 < m <= n }",
+		"[n, m] -> { [n, 1, m] : 0 < m <= n }",
+		"[n, m] -> { [n, 1, 1] : 0 < m <= n }",
+		"[n, m] -> { [m, m, m] : 0 < m <= n }",
+		"[n, m] -> { [1, 1, m] : 0 < m <= n }",
+		"[n, m] -> { [1, 1, 1] : 0 < m <= n }"
+	    } },
+	/* An input with implicit equality constraints among the parameters. */
+	{ "[N, M] -> { [a, b] : M >= 3 and 9 + 3M <= a <= 29 + 2N + 11M and "
+			    "2b >= M + a and 5 - 2N - M + a <= 2b <= 3 + a and "
+			    "3b >= 15 + a }",
+	  2, {
+		"[N, M] -> { [(21), (12)] : M = 3 and N >= 0 }",
+		"[N, M] -> { [(61 + 2N), (32 + N)] : M = 3 and N >= 0 }",
+	     }
+	},
+};
+
+/* Check that "vertex" corresponds to one of the vertices in data->vertex.
+ */
+static isl_stat find_vertex(__isl_take isl_vertex *vertex, void *user)
+{
+	struct isl_vertices_test_data *data = user;
+	isl_ctx *ctx;
+	isl_multi_aff *ma;
+	isl_basic_set *bset;
+	isl_pw_multi_aff *pma;
+	int i;
+	isl_bool equal;
+
+	ctx = isl_vertex_get_ctx(vertex);
+	bset = isl_vertex_get_domain(vertex);
+	ma = isl_vertex_get_expr(vertex);
+	pma = isl_pw_multi_aff_alloc(isl_set_from_basic_set(bset), ma);
+
+	for (i = 0; i < data->n; ++i) {
+		isl_pw_multi_aff *pma_i;
+
+		pma_i = isl_pw_multi_aff_read_from_str(ctx, data->vertex[i]);
+		equal = isl_pw_multi_aff_plain_is_equal(pma, pma_i);
+		isl_pw_multi_aff_free(pma_i);
+
+		if (equal < 0 || equal)
+			break;
+	}
+
+	isl_pw_multi_aff_free(pma);
+	isl_vertex_free(vertex);
+
+	if (equal < 0)
+		return isl_stat_error;
+
+	return equal ? isl_stat_ok : isl_stat_error;
+}
+
+/* Inputs for isl_vertices_intersect_params tests.
+ * "set" is the parametric polytope and
+ * "context" is the parameter domain with which it is intersected.
+ */
+static struct {
+	const char *set;
+	const char *context;
+} vertices_intersect_params_tests[] = {
+	{ "[n, m] -> { [a, b, c] : b <= a and a <= n and b > 0 and c >= b and "
+				"c <= m and m <= n and m > 0 }",
+	  "[n, m] -> { : m >= 5 }" },
+	{ "[n, m] -> { [i, j] : 0 <= i <= n and 0 <= j <= m and i + j <= 10 }",
+	  "[n, m] -> { : n + m >= 10 and n <= 10 }" },
+	{ "[n, m] -> { [i, j] : 0 <= i <= n and 0 <= j <= m and i + j <= 10 }",
+	  "[n, m] -> { : n >= 20 and m >= 20 }" },
+	/* An intersection that is not full-dimensional. */
+	{ "[n] -> { [i] : 0 <= i <= n and i <= 10 }",
+	  "[n] -> { : n <= 0 }" },
+};
+
+/* Data used by find_same_vertex and check_vertex_in.
+ * "dom" and "ma" describe the vertex that is being looked up.
+ * "found" is set if a vertex with the same description was found.
+ */
+struct isl_find_vertex_data {
+	isl_basic_set *dom;
+	isl_multi_aff *ma;
+	isl_bool found;
+};
+
+/* Update data->found if "vertex" has the same expression
+ * and activity domain as data->ma and data->dom.
+ */
+static isl_stat find_same_vertex(__isl_take isl_vertex *vertex, void *user)
+{
+	struct isl_find_vertex_data *data = user;
+	isl_basic_set *dom;
+	isl_multi_aff *ma;
+	isl_bool equal;
+
+	dom = isl_vertex_get_domain(vertex);
+	ma = isl_vertex_get_expr(vertex);
+	isl_vertex_free(vertex);
+	equal = isl_multi_aff_plain_is_equal(ma, data->ma);
+	if (equal == isl_bool_true)
+		equal = isl_basic_set_is_equal(dom, data->dom);
+	isl_basic_set_free(dom);
+	isl_multi_aff_free(ma);
+	if (equal < 0)
+		return isl_stat_error;
+	if (equal)
+		data->found = isl_bool_true;
+
+	return isl_stat_ok;
+}
+
+/* Check that "vertex" also appears in the isl_vertices object "user".
+ */
+static isl_stat check_vertex_in(__isl_take isl_vertex *vertex, void *user)
+{
+	isl_vertices *vertices = user;
+	struct isl_find_vertex_data data;
+	isl_stat r;
+
+	data.dom = isl_vertex_get_domain(vertex);
+	data.ma = isl_vertex_get_expr(vertex);
+	data.found = isl_bool_false;
+	isl_vertex_free(vertex);
+	r = isl_vertices_foreach_vertex(vertices, &find_same_vertex, &data);
+	isl_basic_set_free(data.dom);
+	isl_multi_aff_free(data.ma);
+	if (r < 0)
+		return isl_stat_error;
+	if (!data.found)
+		isl_die(isl_vertices_get_ctx(vertices), isl_error_unknown,
+			"vertex not found", return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Add the domain of "cell" to the set "user".
+ */
+static isl_stat add_cell_domain(__isl_take isl_cell *cell, void *user)
+{
+	isl_set **set = user;
+
+	*set = isl_set_union(*set,
+			isl_set_from_basic_set(isl_cell_get_domain(cell)));
+	isl_cell_free(cell);
+
+	return isl_stat_non_null(*set);
+}
+
+/* Check that "vertices1" and "vertices2" have the same vertices
+ * and that their chambers cover the same parameter values.
+ */
+static isl_stat check_same_vertices(__isl_keep isl_vertices *vertices1,
+	__isl_keep isl_vertices *vertices2)
+{
+	isl_ctx *ctx = isl_vertices_get_ctx(vertices1);
+	isl_size n1, n2;
+	isl_set *dom1, *dom2;
+	isl_bool equal;
+
+	n1 = isl_vertices_get_n_vertices(vertices1);
+	n2 = isl_vertices_get_n_vertices(vertices2);
+	if (n1 < 0 || n2 < 0)
+		return isl_stat_error;
+	if (n1 != n2)
+		isl_die(ctx, isl_error_unknown, "unexpected number of vertices",
+			return isl_stat_error);
+	if (isl_vertices_foreach_vertex(vertices1, &check_vertex_in,
+					vertices2) < 0)
+		return isl_stat_error;
+
+	dom1 = isl_set_empty(isl_space_params(
+				isl_basic_set_get_space(vertices1->bset)));
+	dom2 = isl_set_copy(dom1);
+	if (isl_vertices_foreach_cell(vertices1, &add_cell_domain, &dom1) < 0)
+		dom1 = isl_set_free(dom1);
+	if (isl_vertices_foreach_cell(vertices2, &add_cell_domain, &dom2) < 0)
+		dom2 = isl_set_free(dom2);
+	equal = isl_set_is_equal(dom1, dom2);
+	isl_set_free(dom1);
+	isl_set_free(dom2);
+
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected chambers",
+			return isl_stat_error);
+	return isl_stat_ok;
+}
+
+/* Check that isl_vertices_intersect_params produces the same vertices
+ * and covers the same parameter values as computing the vertices
+ * of the intersection from scratch.
+ */
+static isl_stat test_vertices_intersect_params(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(vertices_intersect_params_tests); ++i) {
+		const char *str;
+		isl_basic_set *bset, *context;
+		isl_vertices *vertices1, *vertices2;
+		isl_stat r;
+
+		str = vertices_intersect_params_tests[i].set;
+		bset = isl_basic_set_read_from_str(ctx, str);
+		str = vertices_intersect_params_tests[i].context;
+		context = isl_basic_set_read_from_str(ctx, str);
+		vertices1 = isl_basic_set_compute_vertices(bset);
+		vertices1 = isl_vertices_intersect_params(vertices1,
+					isl_basic_set_copy(context));
+		bset = isl_basic_set_intersect_params(bset, context);
+		vertices2 = isl_basic_set_compute_vertices(bset);
+		r = check_same_vertices(vertices1, vertices2);
+		isl_vertices_free(vertices1);
+		isl_vertices_free(vertices2);
+		isl_basic_set_free(bset);
+
+		if (r < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+int test_vertices(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(vertices_tests); ++i) {
+		isl_basic_set *bset;
+		isl_vertices *vertices;
+		int ok = 1;
+		isl_size n;
+
+		bset = isl_basic_set_read_from_str(ctx, vertices_tests[i].set);
+		vertices = isl_basic_set_compute_vertices(bset);
+		n = isl_vertices_get_n_vertices(vertices);
+		if (vertices_tests[i].n != n)
+			ok = 0;
+		if (isl_vertices_foreach_vertex(vertices, &find_vertex,
+						&vertices_tests[i]) < 0)
+			ok = 0;
+		isl_vertices_free(vertices);
+		isl_basic_set_free(bset);
+
+		if (n < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown, "unexpected vertices",
+				return -1);
+	}
+
+	if (test_vertices_intersect_params(ctx) < 0)
+		return -1;
+
+	return 0;
+}
+
+/* Inputs for basic tests of unary operations on isl_union_map.
+ * "fn" is the function that is being tested.
+ * "arg" is a string description of the input.
+ * "res" is a string description of the expected result.
+ */
+static struct {
+	__isl_give isl_union_map *(*fn)(__isl_take isl_union_map *umap);
+	const char *arg;
+	const char *res;
+} umap_un_tests[] = {
+	{ &isl_union_map_range_reverse,
+	  "{ A[] -> [B[] -> C[]]; A[] -> B[]; A[0] -> N[B[1] -> B[2]] }",
+	  "{ A[] -> [C[] -> B[]]; A[0] -> N[B[2] -> B[1]] }" },
+	{ &isl_union_map_range_reverse,
+	  "{ A[] -> N[B[] -> C[]] }",
+	  "{ A[] -> [C[] -> B[]] }" },
+	{ &isl_union_map_range_reverse,
+	  "{ A[] -> N[B[x] -> B[y]] }",
+	  "{ A[] -> N[B[*] -> B[*]] }" },
+};
+
+/* Perform basic tests of unary operations on isl_union_map.
+ */
+static isl_stat test_un_union_map(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(umap_un_tests); ++i) {
+		const char *str;
+		isl_union_map *umap, *res;
+		isl_bool equal;
+
+		str = umap_un_tests[i].arg;
+		umap = isl_union_map_read_from_str(ctx, str);
+		str = umap_un_tests[i].res;
+		res = isl_union_map_read_from_str(ctx, str);
+		umap = umap_un_tests[i].fn(umap);
+		equal = isl_union_map_is_equal(umap, res);
+		isl_union_map_free(umap);
+		isl_union_map_free(res);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
+/* Inputs for basic tests of binary operations on isl_union_map.
+ * "fn" is the function that is being tested.
+ * "arg1" and "arg2" are string descriptions of the inputs.
+ * "res" is a string description of the expected result.
+ */
+static struct {
+	__isl_give isl_union_map *(*fn)(__isl_take isl_union_map *umap1,
+				__isl_take isl_union_map *umap2);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} umap_bin_tests[] = {
+	{ &isl_union_map_intersect,
+	  "[n] -> { A[i] -> [] : 0 <= i <= n; B[] -> [] }",
+	  "[m] -> { A[i] -> [] : 0 <= i <= m; C[] -> [] }",
+	  "[m, n] -> { A[i] -> [] : 0 <= i <= n and i <= m }" },
+	{ &isl_union_map_intersect_domain_factor_domain,
+	  "{ [A[i] -> B[i + 1]] -> C[i + 2] }",
+	  "[N] -> { B[i] -> C[N] }",
+	  "{ }" },
+	{ &isl_union_map_intersect_domain_factor_domain,
+	  "{ [A[i] -> B[i + 1]] -> C[i + 2] }",
+	  "[N] -> { A[i] -> C[N] }",
+	  "[N] -> { [A[N - 2] -> B[N - 1]] -> C[N] }" },
+	{ &isl_union_map_intersect_domain_factor_domain,
+	  "{ T[A[i] -> B[i + 1]] -> C[i + 2] }",
+	  "[N] -> { A[i] -> C[N] }",
+	  "[N] -> { T[A[N - 2] -> B[N - 1]] -> C[N] }" },
+	{ &isl_union_map_intersect_domain_factor_range,
+	  "{ [A[i] -> B[i + 1]] -> C[i + 2] }",
+	  "[N] -> { B[i] -> C[N] }",
+	  "[N] -> { [A[N - 2] -> B[N - 1]] -> C[N] }" },
+	{ &isl_union_map_intersect_domain_factor_range,
+	  "{ T[A[i] -> B[i + 1]] -> C[i + 2] }",
+	  "[N] -> { B[i] -> C[N] }",
+	  "[N] -> { T[A[N - 2] -> B[N - 1]] -> C[N] }" },
+	{ &isl_union_map_intersect_domain_factor_range,
+	  "{ [A[i] -> B[i + 1]] -> C[i + 2] }",
+	  "[N] -> { A[i] -> C[N] }",
+	  "{ }" },
+	{ &isl_union_map_intersect_range_factor_domain,
+	  "{ A[i] -> [B[i + 1] -> C[i + 2]] }",
+	  "[N] -> { A[i] -> B[N] }",
+	  "[N] -> { A[N - 1] -> [B[N] -> C[N + 1]] }" },
+	{ &isl_union_map_intersect_range_factor_domain,
+	  "{ A[i] -> T[B[i + 1] -> C[i + 2]] }",
+	  "[N] -> { A[i] -> B[N] }",
+	  "[N] -> { A[N - 1] -> T[B[N] -> C[N + 1]] }" },
+	{ &isl_union_map_intersect_range_factor_domain,
+	  "{ A[i] -> [B[i + 1] -> C[i + 2]] }",
+	  "[N] -> { A[i] -> C[N] }",
+	  "{ }" },
+	{ &isl_union_map_intersect_range_factor_range,
+	  "{ A[i] -> [B[i + 1] -> C[i + 2]] }",
+	  "[N] -> { A[i] -> C[N] }",
+	  "[N] -> { A[N - 2] -> [B[N - 1] -> C[N]] }" },
+	{ &isl_union_map_intersect_range_factor_range,
+	  "{ A[i] -> T[B[i + 1] -> C[i + 2]] }",
+	  "[N] -> { A[i] -> C[N] }",
+	  "[N] -> { A[N - 2] -> T[B[N - 1] -> C[N]] }" },
+	{ &isl_union_map_intersect_range_factor_range,
+	  "{ A[i] -> [B[i + 1] -> C[i + 2]] }",
+	  "[N] -> { A[i] -> B[N] }",
+	  "{ }" },
+	{ &isl_union_map_apply_range,
+	  "{ A[i] -> B[i + 1]; A[i] -> C[i + 2]; D[i] -> B[2i] }",
+	  "[N] -> { B[i] -> E[i + N]; B[i] -> F[i]; C[i] -> E[i]; G[] -> E[0] }",
+	  "[N] -> { A[i] -> E[i + 1 + N]; A[i] -> F[i + 1]; A[i] -> E[i + 2]; "
+		"D[i] -> E[2i + N]; D[i] -> F[2i] }" },
+	{ &isl_union_map_apply_range,
+	  "{ A[i] -> [B[i] -> C[i]]; A[i] -> T[B[i] -> C[i]]; A[i] -> [i] }",
+	  "{ [B[i] -> C[j]] -> D[i + j]; T[B[i] -> C[j]] -> E[i - j]; "
+		"B[i] -> F[i]; [i] -> G[i] }",
+	  "{ A[i] -> D[2i]; A[i] -> E[0]; A[i] -> G[i] }" },
+	{ &isl_union_map_apply_range,
+	  "{ A[i] -> B[i]; A[i] -> B[i, i] }",
+	  "{ B[i, j] -> C[i + j]; B[i] -> C[i] : i < 0 }",
+	  "{ A[i] -> C[2i]; A[i] -> C[i] : i < 0 }" },
+};
+
+/* Perform basic tests of binary operations on isl_union_map.
+ */
+static isl_stat test_bin_union_map(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(umap_bin_tests); ++i) {
+		const char *str;
+		isl_union_map *umap1, *umap2, *res;
+		isl_bool equal;
+
+		str = umap_bin_tests[i].arg1;
+		umap1 = isl_union_map_read_from_str(ctx, str);
+		str = umap_bin_tests[i].arg2;
+		umap2 = isl_union_map_read_from_str(ctx, str);
+		str = umap_bin_tests[i].res;
+		res = isl_union_map_read_from_str(ctx, str);
+		umap1 = umap_bin_tests[i].fn(umap1, umap2);
+		equal = isl_union_map_is_equal(umap1, res);
+		isl_union_map_free(umap1);
+		isl_union_map_free(res);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
+/* Check that isl_union_set_contains finds space independently
+ * of the parameters.
+ */
+static isl_stat test_union_set_contains(isl_ctx *ctx)
+{
+	const char *str;
+	isl_bool ok;
+	isl_space *space;
+	isl_id *id;
+	isl_union_set *uset;
+
+	str = "[N] -> { A[0:N]; B[*,*] }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	space = isl_space_unit(ctx);
+	id = isl_id_alloc(ctx, "A", NULL);
+	space = isl_space_add_named_tuple_id_ui(space, id, 1);
+	ok = isl_union_set_contains(uset, space);
+	isl_space_free(space);
+	isl_union_set_free(uset);
+
+	if (ok < 0)
+		return isl_stat_error;
+	if (!ok)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result", return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Perform basic tests of operations on isl_union_map or isl_union_set.
+ */
+/* Construct a union map with "n" statements S_i, each of which
+ * is mapped to all statements T_j, followed by the union map
+ * that maps each T_j to U, and compose the two after coalescing
+ * the first, using up to "n_thread" threads for each union map operation.
+ */
+static __isl_give isl_union_map *union_map_with_threads(isl_ctx *ctx, int n,
+	int n_thread)
+{
+	int i, j;
+	isl_union_map *umap1, *umap2;
+
+	isl_options_set_union_map_threads(ctx, n_thread);
+	umap1 = isl_union_map_empty_ctx(ctx);
+	umap2 = isl_union_map_empty_ctx(ctx);
+	for (i = 0; i < n; ++i) {
+		for (j = 0; j < n; ++j) {
+			char str[200];
+
+			snprintf(str, sizeof(str),
+			    "[N] -> { S%d[x] -> T%d[y] : 0 <= x < N and "
+			    "%d <= y - x <= %d or x = %d and y = %d }",
+			    i, j, i, i + j, i + 1, j);
+			umap1 = isl_union_map_union(umap1,
+				    isl_union_map_read_from_str(ctx, str));
+		}
+	}
+	for (j = 0; j < n; ++j) {
+		char str[100];
+
+		snprintf(str, sizeof(str),
+			"{ T%d[y] -> U[z] : z = 2y + %d }", j, j);
+		umap2 = isl_union_map_union(umap2,
+				isl_union_map_read_from_str(ctx, str));
+	}
+	umap1 = isl_union_map_coalesce(umap1);
+	umap1 = isl_union_map_apply_range(umap1, umap2);
+	umap1 = isl_union_map_detect_equalities(umap1);
+
+	return umap1;
+}
+
+/* Construct a union set with one space containing "n" disjuncts
+ * and "n" spaces containing two disjuncts each and
+ * coalesce it using up to "n_thread" threads.
+ * The coalesced result should contain a single disjunct per space.
+ */
+static __isl_give isl_union_set *union_set_coalesce_with_threads(
+	isl_ctx *ctx, int n, int n_thread)
+{
+	int i;
+	isl_union_set *uset;
+
+	isl_options_set_union_map_threads(ctx, n_thread);
+	uset = isl_union_set_empty_ctx(ctx);
+	for (i = 0; i < n; ++i) {
+		char str[100];
+
+		snprintf(str, sizeof(str),
+			"{ A[x] : %d <= x <= %d; B%d[x] : 0 <= x <= %d or "
+			"%d < x <= 100 }", 2 * i, 2 * i + 2, i, i, i);
+		uset = isl_union_set_union(uset,
+				isl_union_set_read_from_str(ctx, str));
+	}
+	uset = isl_union_set_coalesce(uset);
+
+	return uset;
+}
+
+/* Does "set" consist of a single disjunct?
+ */
+static isl_bool has_single_disjunct(__isl_keep isl_set *set, void *user)
+{
+	isl_size n;
+
+	n = isl_set_n_basic_set(set);
+	if (n < 0)
+		return isl_bool_error;
+	return isl_bool_ok(n == 1);
+}
+
+/* Check that union map operations performed using threads
+ * produce the same results as those performed without threads.
+ * Also check that coalescing a union set with one space
+ * containing many more disjuncts than the others
+ * produces the same result with and without threads.
+ */
+static isl_stat test_union_map_threads(isl_ctx *ctx)
+{
+	int threads;
+	isl_union_map *umap1, *umap2;
+	isl_union_set *uset1, *uset2;
+	isl_bool equal, single;
+	isl_size n;
+
+	threads = isl_options_get_union_map_threads(ctx);
+	uset1 = union_set_coalesce_with_threads(ctx, 8, 0);
+	uset2 = union_set_coalesce_with_threads(ctx, 8, 4);
+	isl_options_set_union_map_threads(ctx, threads);
+
+	equal = isl_union_set_is_equal(uset1, uset2);
+	single = isl_union_set_every_set(uset2, &has_single_disjunct, NULL);
+	n = isl_union_set_n_set(uset2);
+	isl_union_set_free(uset1);
+	isl_union_set_free(uset2);
+	if (equal < 0 || single < 0 || n < 0)
+		return isl_stat_error;
+	if (!equal || !single || n != 9)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected coalesced result",
+			return isl_stat_error);
+
+	threads = isl_options_get_union_map_threads(ctx);
+	umap1 = union_map_with_threads(ctx, 6, 0);
+	umap2 = union_map_with_threads(ctx, 6, 4);
+	isl_options_set_union_map_threads(ctx, threads);
+
+	equal = isl_union_map_is_equal(umap1, umap2);
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"threads produce different result",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Check that isl_union_map_apply_range_domain and
+ * isl_union_map_apply_range_range produce the domain and range
+ * of the result of isl_union_map_apply_range,
+ * both with and without threads.
+ */
+static isl_stat test_apply_range_fused(isl_ctx *ctx)
+{
+	int i, threads;
+	const char *str1, *str2;
+	isl_union_map *umap1, *umap2, *comp;
+	isl_union_set *dom, *ran, *dom2, *ran2;
+	isl_bool equal, equal2;
+
+	str1 = "[N] -> { A[i] -> B[i + 1] : 0 <= i < N; "
+		"A[i] -> C[i, j] : 0 <= j <= i < N; C[i, j] -> C[j, i] }";
+	str2 = "[M] -> { B[i] -> D[2i] : i >= M; C[i, j] -> D[i + j] : i < j; "
+		"C[i, j] -> E[] : i = j; A[i] -> D[i] }";
+	threads = isl_options_get_union_map_threads(ctx);
+	equal = equal2 = isl_bool_true;
+	for (i = 0; i < 2 && equal == isl_bool_true &&
+			equal2 == isl_bool_true; ++i) {
+		isl_options_set_union_map_threads(ctx, i ? 4 : 0);
+		umap1 = isl_union_map_read_from_str(ctx, str1);
+		umap2 = isl_union_map_read_from_str(ctx, str2);
+		comp = isl_union_map_apply_range(isl_union_map_copy(umap1),
+						isl_union_map_copy(umap2));
+		dom = isl_union_map_apply_range_domain(
+				isl_union_map_copy(umap1),
+				isl_union_map_copy(umap2));
+		ran = isl_union_map_apply_range_range(umap1, umap2);
+		dom2 = isl_union_map_domain(isl_union_map_copy(comp));
+		ran2 = isl_union_map_range(comp);
+		equal = isl_union_set_is_equal(dom, dom2);
+		equal2 = isl_union_set_is_equal(ran, ran2);
+		isl_union_set_free(dom);
+		isl_union_set_free(ran);
+		isl_union_set_free(dom2);
+		isl_union_set_free(ran2);
+	}
+	isl_options_set_union_map_threads(ctx, threads);
+
+	if (equal < 0 || equal2 < 0)
+		return isl_stat_error;
+	if (!equal || !equal2)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result of fused composition",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Check that the hash value of a union map does not depend
+ * on the order in which its maps were added and that the cached
+ * hash value is updated when the union map is modified,
+ * either by adding a map or by an in-place operation.
+ */
+static isl_stat test_union_map_hash(isl_ctx *ctx)
+{
+	int i;
+	const char *str;
+	isl_map_list *list;
+	isl_union_map *umap1, *umap2, *umap3;
+	isl_size n;
+	isl_bool equal;
+	uint32_t hash1, hash2;
+
+	str = "[N] -> { A[i] -> B[i + 1]; B[i] -> C[i, j] : 0 <= j < i; "
+		"C[i, j] -> D[] : i < N; D[] -> E[0]; E[i] -> F[i] : i > 0; "
+		"F[i] -> G[2i]; G[i] -> A[i - 1]; H[i] -> H[i + 1] }";
+	umap1 = isl_union_map_read_from_str(ctx, str);
+	list = isl_union_map_get_map_list(umap1);
+	n = isl_map_list_size(list);
+	umap2 = isl_union_map_empty_ctx(ctx);
+	for (i = n - 1; i >= 0; --i)
+		umap2 = isl_union_map_add_map(umap2,
+					isl_map_list_get_at(list, i));
+	isl_map_list_free(list);
+	hash1 = isl_union_map_get_hash(umap1);
+	hash2 = isl_union_map_get_hash(umap2);
+	equal = isl_union_map_plain_is_equal(umap1, umap2);
+	if (n >= 0 && equal >= 0 && (!equal || hash1 != hash2))
+		isl_die(ctx, isl_error_unknown,
+			"hash depends on order of maps", equal = isl_bool_error);
+
+	umap2 = isl_union_map_add_map(umap2,
+			isl_map_read_from_str(ctx, "{ I[i] -> I[i - 1] }"));
+	umap3 = isl_union_map_union(isl_union_map_copy(umap1),
+			isl_union_map_read_from_str(ctx, "{ I[i] -> I[i - 1] }"));
+	hash1 = isl_union_map_get_hash(umap1);
+	hash2 = isl_union_map_get_hash(umap2);
+	if (equal >= 0 && (hash1 == hash2 ||
+	    hash2 != isl_union_map_get_hash(umap3) ||
+	    isl_union_map_plain_is_equal(umap1, umap2) != isl_bool_false))
+		isl_die(ctx, isl_error_unknown,
+			"hash not updated", equal = isl_bool_error);
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+	isl_union_map_free(umap3);
+	if (n < 0 || equal < 0)
+		return isl_stat_error;
+
+	umap1 = isl_union_map_read_from_str(ctx,
+			"{ A[i] -> B[] : 0 <= i < 5 or 5 <= i < 10 }");
+	umap2 = isl_union_map_read_from_str(ctx,
+			"{ A[i] -> B[] : 0 <= i < 10 }");
+	hash1 = isl_union_map_get_hash(umap1);
+	umap1 = isl_union_map_coalesce(umap1);
+	equal = isl_union_map_plain_is_equal(umap1, umap2);
+	if (equal >= 0 && (!equal ||
+	    isl_union_map_get_hash(umap1) != isl_union_map_get_hash(umap2)))
+		isl_die(ctx, isl_error_unknown,
+			"hash not updated by in-place operation",
+			equal = isl_bool_error);
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+
+	if (equal < 0)
+		return isl_stat_error;
+	return isl_stat_ok;
+}
+
+/* Check that reserving room in a union map that is shared
+ * does not affect the other copy and that maps can be added
+ * to the result as usual.
+ */
+static isl_stat test_union_map_reserve(isl_ctx *ctx)
+{
+	const char *str;
+	isl_union_map *umap1, *umap2, *umap3;
+	isl_bool equal;
+
+	str = "{ A[i] -> B[i + 1]; B[i] -> C[i] }";
+	umap1 = isl_union_map_read_from_str(ctx, str);
+	umap2 = isl_union_map_reserve(isl_union_map_copy(umap1), 100);
+	umap2 = isl_union_map_add_map(umap2,
+			isl_map_read_from_str(ctx, "{ C[i] -> D[i] }"));
+	umap3 = isl_union_map_read_from_str(ctx,
+			"{ A[i] -> B[i + 1]; B[i] -> C[i]; C[i] -> D[i] }");
+	equal = isl_union_map_is_equal(umap2, umap3);
+	if (equal >= 0 && equal)
+		equal = isl_bool_not(isl_union_map_is_equal(umap1, umap3));
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+	isl_union_map_free(umap3);
+
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result after reserve", return isl_stat_error);
+	return isl_stat_ok;
+}
+
+static int test_union_map(isl_ctx *ctx)
+{
+	if (test_un_union_map(ctx) < 0)
+		return -1;
+	if (test_bin_union_map(ctx) < 0)
+		return -1;
+	if (test_union_set_contains(ctx) < 0)
+		return -1;
+	if (test_union_map_threads(ctx) < 0)
+		return -1;
+	if (test_apply_range_fused(ctx) < 0)
+		return -1;
+	if (test_union_map_hash(ctx) < 0)
+		return -1;
+	if (test_union_map_reserve(ctx) < 0)
+		return -1;
+	return 0;
+}
+
+/* Check that "serial" and "parallel", the printed results
+ * of performing the operation described by "op" on "input"
+ * without and with threads, are identical.
+ * Both strings are freed.
+ */
+static isl_stat check_same_output(isl_ctx *ctx, const char *op,
+	const char *input, char *serial, char *parallel)
+{
+	int equal;
+
+	if (!serial || !parallel) {
+		free(serial);
+		free(parallel);
+		return isl_stat_error;
+	}
+	equal = !strcmp(serial, parallel);
+	if (!equal) {
+		fprintf(stderr, "%s of %s:\n", op, input);
+		fprintf(stderr, "without threads: %s\n", serial);
+		fprintf(stderr, "with threads: %s\n", parallel);
+	}
+	free(serial);
+	free(parallel);
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"threads produce different output",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Coalesce the set described by "str" using up to "n_thread" threads
+ * and return a printed version of the result.
+ */
+static char *coalesce_to_str(isl_ctx *ctx, const char *str, int n_thread)
+{
+	isl_set *set;
+	char *res;
+
+	isl_options_set_coalesce_threads(ctx, n_thread);
+	set = isl_set_read_from_str(ctx, str);
+	set = isl_set_coalesce(set);
+	res = isl_set_to_str(set);
+	isl_set_free(set);
+
+	return res;
+}
+
+/* Perform several union map operations on the union set described by "str"
+ * using up to "n_thread" threads and return a printed version of the result.
+ */
+static char *union_set_ops_to_str(isl_ctx *ctx, const char *str,
+	int n_thread)
+{
+	isl_union_set *uset;
+	char *res;
+
+	isl_options_set_union_map_threads(ctx, n_thread);
+	uset = isl_union_set_read_from_str(ctx, str);
+	uset = isl_union_set_compute_divs(uset);
+	uset = isl_union_set_detect_equalities(uset);
+	uset = isl_union_set_remove_redundancies(uset);
+	uset = isl_union_set_coalesce(uset);
+	uset = isl_union_set_apply(uset,
+			isl_union_set_identity(isl_union_set_copy(uset)));
+	res = isl_union_set_to_str(uset);
+	isl_union_set_free(uset);
+
+	return res;
+}
+
+/* Compute a schedule for the schedule constraints described by "str"
+ * using up to "n_thread" threads and return a printed version of the result.
+ */
+static char *schedule_to_str(isl_ctx *ctx, const char *str, int n_thread)
+{
+	isl_schedule *schedule;
+	char *res;
+
+	schedule = schedule_with_threads(ctx, str, n_thread);
+	res = isl_schedule_to_str(schedule);
+	isl_schedule_free(schedule);
+
+	return res;
+}
+
+/* Compute a schedule for the schedule constraints in the file "name"
+ * in the "schedule" subdirectory of the test inputs
+ * using up to "n_thread" threads and return a printed version of the result.
+ */
+static char *schedule_file_to_str(isl_ctx *ctx, const char *name,
+	int n_thread)
+{
+	char *filename;
+	FILE *input;
+	isl_schedule_constraints *sc;
+	isl_schedule *schedule;
+	char *res;
+
+	filename = get_filename(ctx, name, "sc");
+	if (!filename)
+		return NULL;
+	input = fopen(filename, "r");
+	free(filename);
+	if (!input)
+		return NULL;
+	isl_options_set_schedule_threads(ctx, n_thread);
+	sc = isl_schedule_constraints_read_from_file(ctx, input);
+	fclose(input);
+	schedule = isl_schedule_constraints_compute_schedule(sc);
+	res = isl_schedule_to_str(schedule);
+	isl_schedule_free(schedule);
+
+	return res;
+}
+
+/* Inputs in the "schedule" subdirectory of the test inputs
+ * for test_thread_equivalence.
+ */
+static const char *thread_equivalence_schedule_tests[] = {
+	"schedule/bounded_coefficients",
+	"schedule/disjunctive_domain",
+	"schedule/flat1",
+	"schedule/flat6",
+	"schedule/max_coincidence",
+	"schedule/niewang",
+	"schedule/poliwoda",
+};
+
+/* Check that the union map operations, coalescing and scheduling
+ * produce exactly the same output with and without threads
+ * on (some of) the inputs of the other tests.
+ * Each union set operation is applied to the union of
+ * all coalescing inputs, with each input placed in its own space.
+ */
+static int test_thread_equivalence(isl_ctx *ctx)
+{
+	int i;
+	int coalesce_threads, union_map_threads, schedule_threads;
+	isl_union_set *all;
+	char *str;
+	isl_stat r = isl_stat_ok;
+
+	coalesce_threads = isl_options_get_coalesce_threads(ctx);
+	union_map_threads = isl_options_get_union_map_threads(ctx);
+	schedule_threads = isl_options_get_schedule_threads(ctx);
+
+	all = isl_union_set_empty_ctx(ctx);
+	for (i = 0; r >= 0 && i < ARRAY_SIZE(coalesce_tests); ++i) {
+		const char *str = coalesce_tests[i].str;
+		char name[20];
+		isl_set *set;
+
+		r = check_same_output(ctx, "coalescing", str,
+				coalesce_to_str(ctx, str, 0),
+				coalesce_to_str(ctx, str, 4));
+		snprintf(name, sizeof(name), "S%d", i);
+		set = isl_set_read_from_str(ctx, str);
+		set = isl_set_set_tuple_name(set, name);
+		all = isl_union_set_add_set(all, set);
+	}
+	str = isl_union_set_to_str(all);
+	isl_union_set_free(all);
+	if (r >= 0 && str)
+		r = check_same_output(ctx, "union set operations", "inputs",
+				union_set_ops_to_str(ctx, str, 0),
+				union_set_ops_to_str(ctx, str, 4));
+	free(str);
+	if (r >= 0)
+		r = check_same_output(ctx, "scheduling", schedule_components_str,
+			schedule_to_str(ctx, schedule_components_str, 0),
+			schedule_to_str(ctx, schedule_components_str, 2));
+	for (i = 0; r >= 0 &&
+		    i < ARRAY_SIZE(thread_equivalence_schedule_tests); ++i) {
+		const char *name = thread_equivalence_schedule_tests[i];
+
+		r = check_same_output(ctx, "scheduling", name,
+				schedule_file_to_str(ctx, name, 0),
+				schedule_file_to_str(ctx, name, 2));
+	}
+
+	isl_options_set_coalesce_threads(ctx, coalesce_threads);
+	isl_options_set_union_map_threads(ctx, union_map_threads);
+	isl_options_set_schedule_threads(ctx, schedule_threads);
+
+	return r;
+}
+
+int test_union_pw(isl_ctx *ctx)
+{
+	int equal;
+	const char *str;
+	isl_union_set *uset;
+	isl_union_pw_qpolynomial *upwqp1, *upwqp2;
+
+	str = "{ [x] -> x^2 }";
+	upwqp1 = isl_union_pw_qpolynomial_read_from_str(ctx, str);
+	upwqp2 = isl_union_pw_qpolynomial_copy(upwqp1);
+	uset = isl_union_pw_qpolynomial_domain(upwqp1);
+	upwqp1 = isl_union_pw_qpolynomial_copy(upwqp2);
+	upwqp1 = isl_union_pw_qpolynomial_intersect_domain(upwqp1, uset);
+	equal = isl_union_pw_qpolynomial_plain_is_equal(upwqp1, upwqp2);
+	isl_union_pw_qpolynomial_free(upwqp1);
+	isl_union_pw_qpolynomial_free(upwqp2);
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
+	return 0;
+}
+
+/* Inputs for basic tests of functions that select
+ * subparts of the domain of an isl_multi_union_pw_aff.
+ * "fn" is the function that is tested.
+ * "arg" is a string description of the input.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_union_set *(*fn)(
+		__isl_take isl_multi_union_pw_aff *mupa);
+	const char *arg;
+	const char *res;
+} un_locus_tests[] = {
+	{ &isl_multi_union_pw_aff_zero_union_set,
+	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }]",
+	  "{ A[0,j]; B[0,j] }" },
+	{ &isl_multi_union_pw_aff_zero_union_set,
+	  "F[{ A[i,j] -> [i-j]; B[i,j] -> [i-j] : i >= 0 }]",
+	  "{ A[i,i]; B[i,i] : i >= 0 }" },
+	{ &isl_multi_union_pw_aff_zero_union_set,
+	  "(F[] : { A[i,j]; B[i,i] : i >= 0 })",
+	  "{ A[i,j]; B[i,i] : i >= 0 }" },
+};
+
+/* Perform some basic tests of functions that select
+ * subparts of the domain of an isl_multi_union_pw_aff.
+ */
+static int test_un_locus(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_union_set *uset, *res;
+	isl_multi_union_pw_aff *mupa;
+
+	for (i = 0; i < ARRAY_SIZE(un_locus_tests); ++i) {
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
+						    un_locus_tests[i].arg);
+		res = isl_union_set_read_from_str(ctx, un_locus_tests[i].res);
+		uset = un_locus_tests[i].fn(mupa);
+		ok = isl_union_set_is_equal(uset, res);
+		isl_union_set_free(uset);
+		isl_union_set_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for basic tests of functions that select
+ * subparts of an isl_union_map based on a relation
+ * specified by an isl_multi_union_pw_aff.
+ * "fn" is the function that is tested.
+ * "arg1" and "arg2" are string descriptions of the inputs.
+ * "res" is a string description of the expected result.
+ */
+struct {
+	__isl_give isl_union_map *(*fn)(
+		__isl_take isl_union_map *umap,
+		__isl_take isl_multi_union_pw_aff *mupa);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} bin_locus_tests[] = {
+	{ &isl_union_map_eq_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j'] }",
+	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }]",
+	  "{ A[i,j] -> B[i,j'] }" },
+	{ &isl_union_map_eq_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j'] }",
+	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }, "
+	    "{ A[i,j] -> [j]; B[i,j] -> [j] }]",
+	  "{ A[i,j] -> B[i,j] }" },
+	{ &isl_union_map_eq_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j']; A[i,j] -> C[i',j'] }",
+	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }]",
+	  "{ A[i,j] -> B[i,j'] }" },
+	{ &isl_union_map_eq_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j']; A[i,j] -> C[i',j'] }",
+	  "F[{ A[i,j] -> [i]; B[i,j] -> [i]; C[i,j] -> [0] }]",
+	  "{ A[i,j] -> B[i,j']; A[0,j] -> C[i',j'] }" },
+	{ &isl_union_map_eq_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j'] }",
+	  "F[{ A[i,j] -> [i] : i > j; B[i,j] -> [i] }]",
+	  "{ A[i,j] -> B[i,j'] : i > j }" },
+	{ &isl_union_map_lex_le_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j'] }",
+	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }, "
+	    "{ A[i,j] -> [j]; B[i,j] -> [j] }]",
+	  "{ A[i,j] -> B[i',j'] : i,j <<= i',j' }" },
+	{ &isl_union_map_lex_lt_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j'] }",
+	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }, "
+	    "{ A[i,j] -> [j]; B[i,j] -> [j] }]",
+	  "{ A[i,j] -> B[i',j'] : i,j << i',j' }" },
+	{ &isl_union_map_lex_ge_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j'] }",
+	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }, "
+	    "{ A[i,j] -> [j]; B[i,j] -> [j] }]",
+	  "{ A[i,j] -> B[i',j'] : i,j >>= i',j' }" },
+	{ &isl_union_map_lex_gt_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j'] }",
+	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }, "
+	    "{ A[i,j] -> [j]; B[i,j] -> [j] }]",
+	  "{ A[i,j] -> B[i',j'] : i,j >> i',j' }" },
+	{ &isl_union_map_eq_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j']; A[i,j] -> C[i',j'] }",
+	  "(F[] : { A[i,j]; B[i,j] })",
+	  "{ A[i,j] -> B[i',j'] }" },
+	{ &isl_union_map_eq_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j'] }",
+	  "(F[] : { A[i,j] : i > j; B[i,j] : i < j })",
+	  "{ A[i,j] -> B[i',j'] : i > j and i' < j' }" },
+	{ &isl_union_map_eq_at_multi_union_pw_aff,
+	  "[N] -> { A[i,j] -> B[i',j'] : i,i' <= N }",
+	  "(F[] : { A[i,j] : i > j; B[i,j] : i < j })",
+	  "[N] -> { A[i,j] -> B[i',j'] : i > j and i' < j' and i,i' <= N }" },
+	{ &isl_union_map_eq_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j'] }",
+	  "[N] -> (F[] : { A[i,j] : i < N; B[i,j] : i < N })",
+	  "[N] -> { A[i,j] -> B[i',j'] : i,i' < N }" },
+	{ &isl_union_map_eq_at_multi_union_pw_aff,
+	  "{ A[i,j] -> B[i',j'] }",
+	  "[N] -> (F[] : { : N >= 0 })",
+	  "[N] -> { A[i,j] -> B[i',j'] : N >= 0 }" },
+};
+
+/* Perform some basic tests of functions that select
+ * subparts of an isl_union_map based on a relation
+ * specified by an isl_multi_union_pw_aff.
+ */
+static int test_bin_locus(isl_ctx *ctx)
+{
+	int i;
+	isl_bool ok;
+	isl_union_map *umap, *res;
+	isl_multi_union_pw_aff *mupa;
+
+	for (i = 0; i < ARRAY_SIZE(bin_locus_tests); ++i) {
+		umap = isl_union_map_read_from_str(ctx,
+						    bin_locus_tests[i].arg1);
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
+						    bin_locus_tests[i].arg2);
+		res = isl_union_map_read_from_str(ctx, bin_locus_tests[i].res);
+		umap = bin_locus_tests[i].fn(umap, mupa);
+		ok = isl_union_map_is_equal(umap, res);
+		isl_union_map_free(umap);
+		isl_union_map_free(res);
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	return 0;
+}
+
+/* Inputs for basic tests of functions that determine
+ * the part of the domain where two isl_multi_aff objects
+ * related to each other in a specific way.
+ * "fn" is the function that is being tested.
+ * "arg1" and "arg2" are string descriptions of the inputs.
+ * "res" is a string description of the expected result.
+ */
+static struct {
+	__isl_give isl_set *(*fn)(__isl_take isl_multi_aff *ma1,
+		__isl_take isl_multi_aff *ma2);
+	const char *arg1;
+	const char *arg2;
+	const char *res;
+} bin_locus_ma_tests[] = {
+	{ &isl_multi_aff_lex_le_set, "{ [] }", "{ [] }", "{ : }" },
+	{ &isl_multi_aff_lex_lt_set, "{ [] }", "{ [] }", "{ : false }" },
+	{ &isl_multi_aff_lex_le_set,
+	  "{ A[i] -> [i] }", "{ A[i] -> [0] }",
+	  "{ A[i] : i <= 0 }" },
+	{ &isl_multi_aff_lex_lt_set,
+	  "{ A[i] -> [i] }", "{ A[i] -> [0] }",
+	  "{ A[i] : i < 0 }" },
+	{ &isl_multi_aff_lex_le_set,
+	  "{ A[i] -> [i, i] }", "{ A[i] -> [0, 0] }",
+	  "{ A[i] : i <= 0 }" },
+	{ &isl_multi_aff_lex_le_set,
+	  "{ A[i] -> [i, 0] }", "{ A[i] -> [0, 0] }",
+	  "{ A[i] : i <= 0 }" },
+	{ &isl_multi_aff_lex_le_set,
+	  "{ A[i] -> [i, 1] }", "{ A[i] -> [0, 0] }",
+	  "{ A[i] : i < 0 }" },
+};
+
+/* Perform some basic tests of functions that determine
+ * the part of the domain where two isl_multi_aff objects
+ * related to each other in a specific way.
+ */
+static isl_stat test_bin_locus_ma(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bin_locus_ma_tests); ++i) {
+		const char *str;
+		isl_bool ok;
+		isl_multi_aff *ma1, *ma2;
+		isl_set *set, *res;
+
+		str = bin_locus_ma_tests[i].arg1;
+		ma1 = isl_multi_aff_read_from_str(ctx, str);
+		str = bin_locus_ma_tests[i].arg2;
+		ma2 = isl_multi_aff_read_from_str(ctx, str);
+		res = isl_set_read_from_str(ctx, bin_locus_ma_tests[i].res);
+		set = bin_locus_ma_tests[i].fn(ma1, ma2);
+		ok = isl_set_is_equal(set, res);
+		isl_set_free(set);
+		isl_set_free(res);
+		if (ok < 0)
+			return isl_stat_error;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
+/* Perform basic locus tests.
+ */
+static int test_locus(isl_ctx *ctx)
+{
+	if (test_un_locus(ctx) < 0)
+		return -1;
+	if (test_bin_locus(ctx) < 0)
+		return -1;
+	if (test_bin_locus_ma(ctx) < 0)
+		return -1;
+	return 0;
+}
+
+/* Test that isl_union_pw_qpolynomial_eval picks up the function
+ * defined over the correct domain space.
+ */
+static int test_eval_1(isl_ctx *ctx)
+{
+	const char *str;
+	isl_point *pnt;
+	isl_set *set;
+	isl_union_pw_qpolynomial *upwqp;
+	isl_val *v;
+	int cmp;
+
+	str = "{ A[x] -> x^2; B[x] -> -x^2 }";
+	upwqp = isl_union_pw_qpolynomial_read_from_str(ctx, str);
+	str = "{ A[6] }";
+	set = isl_set_read_from_str(ctx, str);
+	pnt = isl_set_sample_point(set);
+	v = isl_union_pw_qpolynomial_eval(upwqp, pnt);
+	cmp = isl_val_cmp_si(v, 36);
+	isl_val_free(v);
+
+	if (!v)
+		return -1;
+	if (cmp != 0)
+		isl_die(ctx, isl_error_unknown, "unexpected value", return -1);
+
+	return 0;
+}
+
+/* Check that isl_qpolynomial_eval handles getting called on a void point.
+ */
+static int test_eval_2(isl_ctx *ctx)
+{
+	const char *str;
+	isl_point *pnt;
+	isl_set *set;
+	isl_qpolynomial *qp;
+	isl_val *v;
+	isl_bool ok;
+
+	str = "{ A[x] -> [x] }";
+	qp = isl_qpolynomial_from_aff(isl_aff_read_from_str(ctx, str));
+	str = "{ A[x] : false }";
+	set = isl_set_read_from_str(ctx, str);
+	pnt = isl_set_sample_point(set);
+	v = isl_qpolynomial_eval(qp, pnt);
+	ok = isl_val_is_nan(v);
+	isl_val_free(v);
+
+	if (ok < 0)
+		return -1;
+	if (!ok)
+		isl_die(ctx, isl_error_unknown, "expecting NaN", return -1);
+
+	return 0;
+}
+
+/* Check that a polynomial (without local variables) can be evaluated
+ * in a rational point.
+ */
+static isl_stat test_eval_3(isl_ctx *ctx)
+{
+	isl_pw_qpolynomial *pwqp;
+	isl_point *pnt;
+	isl_val *v;
+	isl_stat r;
+
+	pwqp = isl_pw_qpolynomial_read_from_str(ctx, "{ [x] -> x^2 }");
+	pnt = isl_point_zero(isl_pw_qpolynomial_get_domain_space(pwqp));
+	v = isl_val_read_from_str(ctx, "1/2");
+	pnt = isl_point_set_coordinate_val(pnt, isl_dim_set, 0, v);
+	v = isl_pw_qpolynomial_eval(pwqp, pnt);
+	r = val_check_equal(v, "1/4");
+	isl_val_free(v);
+
+	return r;
+}
+
+/* Inputs for isl_pw_aff_eval test.
+ * "f" is the affine function.
+ * "p" is the point where the function should be evaluated.
+ * "res" is the expected result.
+ */
+struct {
+	const char *f;
+	const char *p;
+	const char *res;
+} aff_eval_tests[] = {
+	{ "{ [i] -> [2 * i] }", "{ [4] }", "8" },
+	{ "{ [i] -> [2 * i] }", "{ [x] : false }", "NaN" },
+	{ "{ [i] -> [i + floor(i/2) + floor(i/3)] }", "{ [0] }", "0" },
+	{ "{ [i] -> [i + floor(i/2) + floor(i/3)] }", "{ [1] }", "1" },
+	{ "{ [i] -> [i + floor(i/2) + floor(i/3)] }", "{ [2] }", "3" },
+	{ "{ [i] -> [i + floor(i/2) + floor(i/3)] }", "{ [3] }", "5" },
+	{ "{ [i] -> [i + floor(i/2) + floor(i/3)] }", "{ [4] }", "7" },
+	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [0] }", "0" },
+	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [1] }", "0" },
+	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [2] }", "0" },
+	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [3] }", "0" },
+	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [4] }", "1" },
+	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [6] }", "1" },
+	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [8] }", "2" },
+	{ "{ [i] -> [i] : i > 0; [i] -> [-i] : i < 0 }", "{ [4] }", "4" },
+	{ "{ [i] -> [i] : i > 0; [i] -> [-i] : i < 0 }", "{ [-2] }", "2" },
+	{ "{ [i] -> [i] : i > 0; [i] -> [-i] : i < 0 }", "{ [0] }", "NaN" },
+	{ "[N] -> { [2 * N] }", "[N] -> { : N = 4 }", "8" },
+	{ "{ [i, j] -> [(i + j)/2] }", "{ [1, 1] }", "1" },
+	{ "{ [i, j] -> [(i + j)/2] }", "{ [1, 2] }", "3/2" },
+	{ "{ [i] -> [i] : i mod 2 = 0 }", "{ [4] }", "4" },
+	{ "{ [i] -> [i] : i mod 2 = 0 }", "{ [3] }", "NaN" },
+	{ "{ [i] -> [i] : i mod 2 = 0 }", "{ [x] : false }", "NaN" },
+};
+
+/* Perform basic isl_pw_aff_eval tests.
+ */
+static int test_eval_aff(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(aff_eval_tests); ++i) {
+		isl_stat r;
+		isl_pw_aff *pa;
+		isl_set *set;
+		isl_point *pnt;
+		isl_val *v;
+
+		pa = isl_pw_aff_read_from_str(ctx, aff_eval_tests[i].f);
+		set = isl_set_read_from_str(ctx, aff_eval_tests[i].p);
+		pnt = isl_set_sample_point(set);
+		v = isl_pw_aff_eval(pa, pnt);
+		r = val_check_equal(v, aff_eval_tests[i].res);
+		isl_val_free(v);
+		if (r < 0)
+			return -1;
+	}
+	return 0;
+}
+
+/* Piecewise multi-affine expressions used in test_eval_evaluator.
+ * "large" is set if the expression can also be evaluated on points
+ * with coordinates close to the limits of a long.
+ */
+static struct {
+	const char *pma;
+	int large;
+} evaluator_tests[] = {
+	{ "{ [i, j] -> [i + 2j, floor((i + j)/3)] : i >= 0; "
+		"[i, j] -> [-i, 7] : i < 0 }", 0 },
+	{ "[N] -> { [i] -> [N - i, floor(i/2) + floor(N/4)] : 0 <= i < N }",
+	  0 },
+	{ "{ [i] -> [floor((i + floor(i/3))/2)] : exists (e : i = 2e + 1) }",
+	  1 },
+	{ "{ [i, j] -> [(i + j)/2] : (i + j) mod 2 = 0 }", 0 },
+	{ "{ [i] -> [] : i mod 3 = 0 }", 1 },
+	{ "{ [i] -> [floor(i/2) - 5] : i >= 0 }", 1 },
+	{ "{ [i, j] -> [] : exists (e : i = 3e + j and 0 <= j < 3) or "
+		"(i >= 2 and j <= -i) }", 1 },
+};
+
+/* Evaluate "pma" at the point with coordinates "coords" using
+ * isl_pw_aff_eval on each of its output dimensions and
+ * compare the results to "res" and "defined".
+ */
+static isl_bool evaluator_check_point(__isl_keep isl_pw_multi_aff *pma,
+	const long *coords, const long *res, int defined)
+{
+	isl_ctx *ctx = isl_pw_multi_aff_get_ctx(pma);
+	isl_size nparam, n_in, n_out;
+	isl_point *pnt;
+	isl_bool ok = isl_bool_true;
+	int i;
+
+	nparam = isl_pw_multi_aff_dim(pma, isl_dim_param);
+	n_in = isl_pw_multi_aff_dim(pma, isl_dim_in);
+	n_out = isl_pw_multi_aff_dim(pma, isl_dim_out);
+	if (nparam < 0 || n_in < 0 || n_out < 0)
+		return isl_bool_error;
+	pnt = isl_point_zero(isl_pw_multi_aff_get_domain_space(pma));
+	for (i = 0; i < nparam + n_in; ++i) {
+		enum isl_dim_type type = i < nparam ? isl_dim_param : isl_dim_set;
+		int pos = i < nparam ? i : i - nparam;
+
+		pnt = isl_point_set_coordinate_val(pnt, type, pos,
+				isl_val_int_from_si(ctx, coords[i]));
+	}
+	if (n_out == 0) {
+		isl_set *set, *dom;
+
+		set = isl_set_from_point(pnt);
+		dom = isl_pw_multi_aff_domain(isl_pw_multi_aff_copy(pma));
+		ok = isl_set_is_subset(set, dom);
+		isl_set_free(set);
+		isl_set_free(dom);
+		if (ok < 0)
+			return isl_bool_error;
+		return isl_bool_ok(ok == defined);
+	}
+	for (i = 0; ok == isl_bool_true && i < n_out; ++i) {
+		isl_pw_aff *pa;
+		isl_val *v;
+
+		pa = isl_pw_multi_aff_get_at(pma, i);
+		v = isl_pw_aff_eval(pa, isl_point_copy(pnt));
+		if (!v)
+			ok = isl_bool_error;
+		else if (isl_val_is_nan(v))
+			ok = isl_bool_ok(!defined);
+		else
+			ok = isl_bool_ok(defined &&
+				isl_val_cmp_si(v, res[i]) == 0);
+		isl_val_free(v);
+	}
+	isl_point_free(pnt);
+
+	return ok;
+}
+
+/* Check that evaluating the expressions in evaluator_tests
+ * using an isl_pw_multi_aff_evaluator produces the same results
+ * as evaluating them one point at a time,
+ * for all points in a box around the origin and
+ * for some points with large coordinates.
+ * Also check that isl_pw_multi_aff_evaluator_domain_contains
+ * agrees with the computed "defined" values.
  */
-static int test_bin_mpa(isl_ctx *ctx)
+static int test_eval_evaluator(isl_ctx *ctx)
 {
-	int i;
-	isl_bool ok;
-	isl_multi_pw_aff *mpa1, *mpa2, *res;
+	int i, j, k;
 
-	for (i = 0; i < ARRAY_SIZE(mpa_bin_tests); ++i) {
-		mpa1 = isl_multi_pw_aff_read_from_str(ctx,
-							mpa_bin_tests[i].arg1);
-		mpa2 = isl_multi_pw_aff_read_from_str(ctx,
-							mpa_bin_tests[i].arg2);
-		res = isl_multi_pw_aff_read_from_str(ctx,
-							mpa_bin_tests[i].res);
-		mpa1 = mpa_bin_tests[i].fn(mpa1, mpa2);
-		ok = isl_multi_pw_aff_plain_is_equal(mpa1, res);
-		isl_multi_pw_aff_free(mpa1);
-		isl_multi_pw_aff_free(res);
-		if (ok < 0)
+	for (i = 0; i < ARRAY_SIZE(evaluator_tests); ++i) {
+		isl_pw_multi_aff *pma;
+		isl_pw_multi_aff_evaluator *ev;
+		isl_size nparam, n_in, n_out;
+		long coords[1000 * 3], res[1000 * 2];
+		int defined[1000];
+		int dim, n;
+		isl_stat r;
+
+		pma = isl_pw_multi_aff_read_from_str(ctx,
+						evaluator_tests[i].pma);
+		nparam = isl_pw_multi_aff_dim(pma, isl_dim_param);
+		n_in = isl_pw_multi_aff_dim(pma, isl_dim_in);
+		n_out = isl_pw_multi_aff_dim(pma, isl_dim_out);
+		if (nparam < 0 || n_in < 0 || n_out < 0) {
+			isl_pw_multi_aff_free(pma);
+			return -1;
+		}
+		dim = nparam + n_in;
+		n = 1;
+		for (j = 0; j < dim; ++j)
+			n *= 13;
+		for (k = 0; k < n; ++k) {
+			int v = k;
+
+			for (j = 0; j < dim; ++j) {
+				coords[k * dim + j] = v % 13 - 6;
+				v /= 13;
+			}
+		}
+		for (j = 0; evaluator_tests[i].large && j < dim; ++j) {
+			coords[n * dim + j] = LONG_MAX / 2 + 1;
+			coords[(n + 1) * dim + j] = LONG_MIN / 2 + 1;
+		}
+		if (evaluator_tests[i].large)
+			n += 2;
+
+		ev = isl_pw_multi_aff_evaluator_from_pw_multi_aff(
+					isl_pw_multi_aff_copy(pma));
+		r = isl_pw_multi_aff_evaluator_eval(ev, coords, n, res,
+							defined);
+		for (k = 0; r >= 0 && k < n; ++k) {
+			isl_bool ok, in;
+
+			ok = evaluator_check_point(pma, coords + k * dim,
+					res + k * n_out, defined[k]);
+			in = isl_pw_multi_aff_evaluator_domain_contains(ev,
+							coords + k * dim);
+			if (ok < 0 || in < 0)
+				r = isl_stat_error;
+			else if (!ok || in != defined[k]) {
+				isl_pw_multi_aff_evaluator_free(ev);
+				isl_pw_multi_aff_free(pma);
+				isl_die(ctx, isl_error_unknown,
+					"unexpected value", return -1);
+			}
+		}
+		isl_pw_multi_aff_evaluator_free(ev);
+		isl_pw_multi_aff_free(pma);
+		if (r < 0)
 			return -1;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
 	}
 
 	return 0;
 }
 
-/* Inputs for basic tests of unary operations on
- * isl_multi_union_pw_aff objects.
- * "fn" is the function that is tested.
- * "arg" is a string description of the input.
- * "res" is a string description of the expected result.
+/* Perform basic evaluation tests.
  */
-struct {
-	__isl_give isl_multi_union_pw_aff *(*fn)(
-		__isl_take isl_multi_union_pw_aff *mupa);
-	const char *arg;
-	const char *res;
-} mupa_un_tests[] = {
-	{ &isl_multi_union_pw_aff_factor_range,
-	  "[B[{ A[] -> [1] }] -> C[{ A[] -> [2] }]]",
-	  "C[{ A[] -> [2] }]" },
-	{ &isl_multi_union_pw_aff_factor_range,
-	  "[B[] -> C[{ A[] -> [2] }]]",
-	  "C[{ A[] -> [2] }]" },
-	{ &isl_multi_union_pw_aff_factor_range,
-	  "[B[{ A[] -> [1] }] -> C[]]",
-	  "C[]" },
-	{ &isl_multi_union_pw_aff_factor_range,
-	  "[B[] -> C[]]",
-	  "C[]" },
-	{ &isl_multi_union_pw_aff_factor_range,
-	  "([B[] -> C[]] : { A[x] : x >= 0 })",
-	  "(C[] : { A[x] : x >= 0 })" },
-	{ &isl_multi_union_pw_aff_factor_range,
-	  "[N] -> ([B[] -> C[]] : { A[x] : x <= N })",
-	  "[N] -> (C[] : { A[x] : x <= N })" },
-	{ &isl_multi_union_pw_aff_factor_range,
-	  "[N] -> ([B[] -> C[]] : { : N >= 0 })",
-	  "[N] -> (C[] : { : N >= 0 })" },
+static int test_eval(isl_ctx *ctx)
+{
+	if (test_eval_1(ctx) < 0)
+		return -1;
+	if (test_eval_2(ctx) < 0)
+		return -1;
+	if (test_eval_3(ctx) < 0)
+		return -1;
+	if (test_eval_aff(ctx) < 0)
+		return -1;
+	if (test_eval_evaluator(ctx) < 0)
+		return -1;
+	return 0;
+}
+
+/* Descriptions of sets that are tested for reparsing after printing.
+ */
+const char *output_tests[] = {
+	"{ [1, y] : 0 <= y <= 1; [x, -x] : 0 <= x <= 1 }",
+	"{ [x] : 1 = 0 }",
+	"{ [x] : false }",
+	"{ [x] : x mod 2 = 0 }",
+	"{ [x] : x mod 2 = 1 }",
+	"{ [x, y] : x mod 2 = 0 and 3*floor(y/2) < x }",
+	"{ [y, x] : x mod 2 = 0 and 3*floor(y/2) < x }",
+	"{ [x, y] : x mod 2 = 0 and 3*floor(y/2) = x + y }",
+	"{ [y, x] : x mod 2 = 0 and 3*floor(y/2) = x + y }",
+	"[n] -> { [y, x] : 2*((x + 2y) mod 3) = n }",
+	"{ [x, y] : (2*floor(x/3) + 3*floor(y/4)) mod 5 = x }",
 };
 
-/* Perform some basic tests of unary operations on
- * isl_multi_union_pw_aff objects.
+/* Check that printing a set and reparsing a set from the printed output
+ * results in the same set.
  */
-static int test_un_mupa(isl_ctx *ctx)
+static int test_output_set(isl_ctx *ctx)
 {
 	int i;
-	isl_bool ok;
-	isl_multi_union_pw_aff *mupa, *res;
+	char *str;
+	isl_set *set1, *set2;
+	isl_bool equal;
 
-	for (i = 0; i < ARRAY_SIZE(mupa_un_tests); ++i) {
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
-							mupa_un_tests[i].arg);
-		res = isl_multi_union_pw_aff_read_from_str(ctx,
-							mupa_un_tests[i].res);
-		mupa = mupa_un_tests[i].fn(mupa);
-		ok = isl_multi_union_pw_aff_plain_is_equal(mupa, res);
-		isl_multi_union_pw_aff_free(mupa);
-		isl_multi_union_pw_aff_free(res);
-		if (ok < 0)
+	for (i = 0; i < ARRAY_SIZE(output_tests); ++i) {
+		set1 = isl_set_read_from_str(ctx, output_tests[i]);
+		str = isl_set_to_str(set1);
+		set2 = isl_set_read_from_str(ctx, str);
+		free(str);
+		equal = isl_set_is_equal(set1, set2);
+		isl_set_free(set1);
+		isl_set_free(set2);
+		if (equal < 0)
 			return -1;
-		if (!ok)
+		if (!equal)
 			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
+				"parsed output not the same", return -1);
 	}
 
 	return 0;
 }
 
-/* Inputs for basic tests of binary operations on
- * isl_multi_union_pw_aff objects.
- * "fn" is the function that is tested.
- * "arg1" and "arg2" are string descriptions of the inputs.
- * "res" is a string description of the expected result.
+/* Check that an isl_multi_aff is printed using a consistent space.
  */
-struct {
-	__isl_give isl_multi_union_pw_aff *(*fn)(
-		__isl_take isl_multi_union_pw_aff *mupa1,
-		__isl_take isl_multi_union_pw_aff *mupa2);
-	const char *arg1;
-	const char *arg2;
-	const char *res;
-} mupa_bin_tests[] = {
-	{ &isl_multi_union_pw_aff_add, "[{ A[] -> [1] }]", "[{ A[] -> [2] }]",
-	  "[{ A[] -> [3] }]" },
-	{ &isl_multi_union_pw_aff_sub, "[{ A[] -> [1] }]", "[{ A[] -> [2] }]",
-	  "[{ A[] -> [-1] }]" },
-	{ &isl_multi_union_pw_aff_add,
-	  "[{ A[] -> [1]; B[] -> [4] }]",
-	  "[{ A[] -> [2]; C[] -> [5] }]",
-	  "[{ A[] -> [3] }]" },
-	{ &isl_multi_union_pw_aff_union_add,
-	  "[{ A[] -> [1]; B[] -> [4] }]",
-	  "[{ A[] -> [2]; C[] -> [5] }]",
-	  "[{ A[] -> [3]; B[] -> [4]; C[] -> [5] }]" },
-	{ &isl_multi_union_pw_aff_add, "[{ A[x] -> [(1)] : x >= 5 }]",
-	  "[{ A[x] -> [(x)] : x <= 10 }]",
-	  "[{ A[x] -> [(1 + x)] : 5 <= x <= 10 }]" },
-	{ &isl_multi_union_pw_aff_add, "([] : { A[x] : x >= 5 })",
-	  "([] : { A[x] : x <= 10 })",
-	  "([] : { A[x] : 5 <= x <= 10 })" },
-	{ &isl_multi_union_pw_aff_add, "([] : { A[x] : x >= 5 })",
-	  "[N] -> ([] : { A[x] : x <= N })",
-	  "[N] -> ([] : { A[x] : 5 <= x <= N })" },
-	{ &isl_multi_union_pw_aff_add, "[N] -> ([] : { A[x] : x >= N })",
-	  "([] : { A[x] : x <= 10 })",
-	  "[N] -> ([] : { A[x] : N <= x <= 10 })" },
-	{ &isl_multi_union_pw_aff_union_add, "[{ A[x] -> [(1)] : x >= 5 }]",
-	  "[{ A[x] -> [(x)] : x <= 10 }]",
-	  "[{ A[x] -> [(1 + x)] : 5 <= x <= 10; "
-	     "A[x] -> [(1)] : x > 10; A[x] -> [(x)] : x < 5 }]" },
-	{ &isl_multi_union_pw_aff_union_add, "([] : { A[x] : x >= 5 })",
-	  "([] : { A[x] : x <= 10 })",
-	  "([] : { A[x] })" },
-	{ &isl_multi_union_pw_aff_union_add, "([] : { A[x] : x >= 0 })",
-	  "[N] -> ([] : { A[x] : x >= N })",
-	  "[N] -> ([] : { A[x] : x >= 0 or x >= N })" },
-	{ &isl_multi_union_pw_aff_union_add,
-	  "[N] -> ([] : { A[] : N >= 0})",
-	  "[N] -> ([] : { A[] : N <= 0})",
-	  "[N] -> ([] : { A[] })" },
-	{ &isl_multi_union_pw_aff_union_add,
-	  "[N] -> ([] : { A[] })",
-	  "[N] -> ([] : { : })",
-	  "[N] -> ([] : { : })" },
-	{ &isl_multi_union_pw_aff_union_add,
-	  "[N] -> ([] : { : })",
-	  "[N] -> ([] : { A[] })",
-	  "[N] -> ([] : { : })" },
-	{ &isl_multi_union_pw_aff_union_add,
-	  "[N] -> ([] : { : N >= 0})",
-	  "[N] -> ([] : { : N <= 0})",
-	  "[N] -> ([] : { : })" },
-	{ &isl_multi_union_pw_aff_range_product,
-	  "B[{ A[] -> [1] }]",
-	  "C[{ A[] -> [2] }]",
-	  "[B[{ A[] -> [1] }] -> C[{ A[] -> [2] }]]" },
-	{ &isl_multi_union_pw_aff_range_product,
-	  "(B[] : { A[x] : x >= 5 })",
-	  "(C[] : { A[x] : x <= 10 })",
-	  "([B[] -> C[]] : { A[x] : 5 <= x <= 10 })" },
-	{ &isl_multi_union_pw_aff_range_product,
-	  "B[{ A[x] -> [x + 1] : x >= 5 }]",
-	  "(C[] : { A[x] : x <= 10 })",
-	  "[B[{ A[x] -> [x + 1] : 5 <= x <= 10 }] -> C[]]" },
-	{ &isl_multi_union_pw_aff_range_product,
-	  "(C[] : { A[x] : x <= 10 })",
-	  "B[{ A[x] -> [x + 1] : x >= 5 }]",
-	  "[C[] -> B[{ A[x] -> [x + 1] : 5 <= x <= 10 }]]" },
-	{ &isl_multi_union_pw_aff_range_product,
-	  "B[{ A[x] -> [x + 1] : x >= 5 }]",
-	  "[N] -> (C[] : { A[x] : x <= N })",
-	  "[N] -> [B[{ A[x] -> [x + 1] : 5 <= x <= N }] -> C[]]" },
-	{ &isl_multi_union_pw_aff_range_product,
-	  "[N] -> (C[] : { A[x] : x <= N })",
-	  "B[{ A[x] -> [x + 1] : x >= 5 }]",
-	  "[N] -> [C[] -> B[{ A[x] -> [x + 1] : 5 <= x <= N }]]" },
-	{ &isl_multi_union_pw_aff_range_product,
-	  "B[{ A[] -> [1]; D[] -> [3] }]",
-	  "C[{ A[] -> [2] }]",
-	  "[B[{ A[] -> [1]; D[] -> [3] }] -> C[{ A[] -> [2] }]]" },
-	{ &isl_multi_union_pw_aff_range_product,
-	  "B[] }]",
-	  "(C[] : { A[x] })",
-	  "([B[] -> C[]] : { A[x] })" },
-	{ &isl_multi_union_pw_aff_range_product,
-	  "(B[] : { A[x] })",
-	  "C[] }]",
-	  "([B[] -> C[]] : { A[x] })" },
+static isl_stat test_output_ma(isl_ctx *ctx)
+{
+	char *str;
+	isl_bool equal;
+	isl_aff *aff;
+	isl_multi_aff *ma, *ma2;
+
+	ma = isl_multi_aff_read_from_str(ctx, "{ [a, b] -> [a + b] }");
+	aff = isl_aff_read_from_str(ctx, "{ [c, d] -> [c + d] }");
+	ma = isl_multi_aff_set_aff(ma, 0, aff);
+	str = isl_multi_aff_to_str(ma);
+	ma2 = isl_multi_aff_read_from_str(ctx, str);
+	free(str);
+	equal = isl_multi_aff_plain_is_equal(ma, ma2);
+	isl_multi_aff_free(ma2);
+	isl_multi_aff_free(ma);
+
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "bad conversion",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Check that an isl_multi_pw_aff is printed using a consistent space.
+ */
+static isl_stat test_output_mpa(isl_ctx *ctx)
+{
+	char *str;
+	isl_bool equal;
+	isl_pw_aff *pa;
+	isl_multi_pw_aff *mpa, *mpa2;
+
+	mpa = isl_multi_pw_aff_read_from_str(ctx, "{ [a, b] -> [a + b] }");
+	pa = isl_pw_aff_read_from_str(ctx, "{ [c, d] -> [c + d] }");
+	mpa = isl_multi_pw_aff_set_pw_aff(mpa, 0, pa);
+	str = isl_multi_pw_aff_to_str(mpa);
+	mpa2 = isl_multi_pw_aff_read_from_str(ctx, str);
+	free(str);
+	equal = isl_multi_pw_aff_plain_is_equal(mpa, mpa2);
+	isl_multi_pw_aff_free(mpa2);
+	isl_multi_pw_aff_free(mpa);
+
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "bad conversion",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Sets with constants around the boundaries of the range of long,
+ * which are printed in test_output_int.
+ */
+static const char *output_int_tests[] = {
+	"{ [0]; [-1]; [7]; [-10] }",
+	"{ [x] : x = 9223372036854775807 or x = -9223372036854775807 }",
+	"{ [x] : x = 9223372036854775808 or x = -9223372036854775808 }",
+	"{ [x] : x = 18446744073709551616 or x = -18446744073709551617 }",
+	"{ [x, y] : 4294967296x = 2147483648y + 2147483647 }",
 };
 
-/* Perform some basic tests of binary operations on
- * isl_multi_union_pw_aff objects.
+/* Check that integers of different sizes are printed correctly
+ * by reparsing the printed versions of the sets in output_int_tests.
  */
-static int test_bin_mupa(isl_ctx *ctx)
+static isl_stat test_output_int(isl_ctx *ctx)
 {
 	int i;
-	isl_bool ok;
-	isl_multi_union_pw_aff *mupa1, *mupa2, *res;
 
-	for (i = 0; i < ARRAY_SIZE(mupa_bin_tests); ++i) {
-		mupa1 = isl_multi_union_pw_aff_read_from_str(ctx,
-							mupa_bin_tests[i].arg1);
-		mupa2 = isl_multi_union_pw_aff_read_from_str(ctx,
-							mupa_bin_tests[i].arg2);
-		res = isl_multi_union_pw_aff_read_from_str(ctx,
-							mupa_bin_tests[i].res);
-		mupa1 = mupa_bin_tests[i].fn(mupa1, mupa2);
-		ok = isl_multi_union_pw_aff_plain_is_equal(mupa1, res);
-		isl_multi_union_pw_aff_free(mupa1);
-		isl_multi_union_pw_aff_free(res);
-		if (ok < 0)
-			return -1;
-		if (!ok)
+	for (i = 0; i < ARRAY_SIZE(output_int_tests); ++i) {
+		isl_set *set, *set2;
+		char *str;
+		isl_bool equal;
+
+		set = isl_set_read_from_str(ctx, output_int_tests[i]);
+		str = isl_set_to_str(set);
+		set2 = isl_set_read_from_str(ctx, str);
+		free(str);
+		equal = isl_set_is_equal(set, set2);
+		isl_set_free(set);
+		isl_set_free(set2);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
 			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
+				"set not preserved by printing",
+				return isl_stat_error);
 	}
 
-	return 0;
+	return isl_stat_ok;
 }
 
-/* Inputs for basic tests of binary operations on
- * pairs of isl_multi_union_pw_aff and isl_set objects.
- * "fn" is the function that is tested.
- * "arg1" and "arg2" are string descriptions of the inputs.
- * "res" is a string description of the expected result.
+/* Maps that are printed in binary format and read back
+ * in test_output_binary_map.
  */
-struct {
-	__isl_give isl_multi_union_pw_aff *(*fn)(
-		__isl_take isl_multi_union_pw_aff *mupa,
-		__isl_take isl_set *set);
-	const char *arg1;
-	const char *arg2;
-	const char *res;
-} mupa_set_tests[] = {
-	{ &isl_multi_union_pw_aff_intersect_range,
-	  "C[{ B[i,j] -> [i + 2j] }]", "{ C[1] }",
-	  "C[{ B[i,j] -> [i + 2j] : i + 2j = 1 }]" },
-	{ &isl_multi_union_pw_aff_intersect_range,
-	  "C[{ B[i,j] -> [i + 2j] }]", "[N] -> { C[N] }",
-	  "[N] -> C[{ B[i,j] -> [i + 2j] : i + 2j = N }]" },
-	{ &isl_multi_union_pw_aff_intersect_range,
-	  "[N] -> C[{ B[i,j] -> [i + 2j + N] }]", "{ C[1] }",
-	  "[N] -> C[{ B[i,j] -> [i + 2j + N] : i + 2j + N = 1 }]" },
-	{ &isl_multi_union_pw_aff_intersect_range,
-	  "C[{ B[i,j] -> [i + 2j] }]", "[N] -> { C[x] : N >= 0 }",
-	  "[N] -> C[{ B[i,j] -> [i + 2j] : N >= 0 }]" },
-	{ &isl_multi_union_pw_aff_intersect_range,
-	  "C[]", "{ C[] }", "C[]" },
-	{ &isl_multi_union_pw_aff_intersect_range,
-	  "[N] -> (C[] : { : N >= 0 })",
-	  "{ C[] }",
-	  "[N] -> (C[] : { : N >= 0 })" },
-	{ &isl_multi_union_pw_aff_intersect_range,
-	  "(C[] : { A[a,b] })",
-	  "{ C[] }",
-	  "(C[] : { A[a,b] })" },
-	{ &isl_multi_union_pw_aff_intersect_range,
-	  "[N] -> (C[] : { A[a,b] : a,b <= N })",
-	  "{ C[] }",
-	  "[N] -> (C[] : { A[a,b] : a,b <= N })" },
-	{ &isl_multi_union_pw_aff_intersect_range,
-	  "C[]",
-	  "[N] -> { C[] : N >= 0 }",
-	  "[N] -> (C[] : { : N >= 0 })" },
-	{ &isl_multi_union_pw_aff_intersect_range,
-	  "(C[] : { A[a,b] })",
-	  "[N] -> { C[] : N >= 0 }",
-	  "[N] -> (C[] : { A[a,b] : N >= 0 })" },
-	{ &isl_multi_union_pw_aff_intersect_range,
-	  "[N] -> (C[] : { : N >= 0 })",
-	  "[N] -> { C[] : N < 1024 }",
-	  "[N] -> (C[] : { : 0 <= N < 1024 })" },
-	{ &isl_multi_union_pw_aff_intersect_params,
-	  "C[{ B[i,j] -> [i + 2j] }]", "[N] -> { : N >= 0 }",
-	  "[N] -> C[{ B[i,j] -> [i + 2j] : N >= 0}]" },
-	{ &isl_multi_union_pw_aff_intersect_params,
-	  "[N] -> C[{ B[i,j] -> [i + 2j] : N <= 256 }]", "[N] -> { : N >= 0 }",
-	  "[N] -> C[{ B[i,j] -> [i + 2j] : 0 <= N <= 256 }]" },
-	{ &isl_multi_union_pw_aff_intersect_params,
-	  "[N] -> C[{ B[i,j] -> [i + 2j] : N <= 256 }]", "{ : }",
-	  "[N] -> C[{ B[i,j] -> [i + 2j] : N <= 256 }]" },
-	{ &isl_multi_union_pw_aff_intersect_params,
-	  "C[]", "[N] -> { : N >= 0 }",
-	  "[N] -> (C[] : { : N >= 0 })" },
-	{ &isl_multi_union_pw_aff_intersect_params,
-	  "(C[] : { A[a,b] })", "[N] -> { : N >= 0 }",
-	  "[N] -> (C[] : { A[a,b] : N >= 0 })" },
-	{ &isl_multi_union_pw_aff_intersect_params,
-	  "[N] -> (C[] : { A[a,N] })", "{ : }",
-	  "[N] -> (C[] : { A[a,N] })" },
-	{ &isl_multi_union_pw_aff_intersect_params,
-	  "[N] -> (C[] : { A[a,b] : N <= 256 })", "[N] -> { : N >= 0 }",
-	  "[N] -> (C[] : { A[a,b] : 0 <= N <= 256 })" },
+static const char *binary_map_tests[] = {
+	"{ [] -> [] }",
+	"{ [i] -> [j] : false }",
+	"[n] -> { A[i] -> B[i + 1] : 0 <= i < n }",
+	"[n, m] -> { [i, j] -> [a = i, b] : exists (e : 3e = i + j) and b <= m }",
+	"{ [[A[i] -> B[j]] -> C[k]] -> D[x = 0 : i, y] : y = j - k }",
+	"{ [i] -> [j] : i = 1000000000000000000000000000000 and "
+		"j = -1000000000000000000000000000000 }",
+	"{ [i] -> [j] : 0 <= i <= 10 and (j = i or j = 2i + 7) }",
+	"{ rat: [i] -> [j] : 2j = i and 0 <= i <= 10 }",
+	"{ [i] -> [j] : j = i mod 13 or j = floor(i/1234567890123456789) }",
 };
 
-/* Perform some basic tests of binary operations on
- * pairs of isl_multi_union_pw_aff and isl_set objects.
+/* Union maps that are printed in binary format and read back
+ * in test_output_binary_union_map.
  */
-static int test_mupa_set(isl_ctx *ctx)
+static const char *binary_union_map_tests[] = {
+	"{ }",
+	"[n] -> { A[i] -> B[i] : 0 <= i < n; B[i] -> A[i + 1]; "
+		"C[] -> [[D[] -> E[a]] -> F[a, b]] : a > b }",
+};
+
+/* Union sets that are printed in binary format and read back
+ * in test_output_binary_union_map.
+ */
+static const char *binary_union_set_tests[] = {
+	"{ }",
+	"[n] -> { A[i] : 0 <= i < n; B[i, j] : i <= j; [C[] -> D[x]] : x > 0 }",
+};
+
+/* Schedules that are printed in binary format and read back
+ * in test_output_binary_schedule.
+ */
+static const char *binary_schedule_tests[] = {
+	"{ domain: \"{ A[i] : 0 <= i < 10 }\" }",
+	"{ domain: \"[n] -> { A[i] : 0 <= i < n; B[i] : 0 <= i < n }\", "
+	"child: { context: \"[n] -> { [] : n >= 0 }\", "
+	"child: { schedule: \"[n] -> [{ A[i] -> [(i)]; B[i] -> [(i)] }, "
+		"{ A[i] -> [(0)]; B[i] -> [(n - i)] }]\", "
+	"permutable: 1, coincident: [ 1, 0 ], "
+	"options: \"{ separate[0]; atomic[1] }\", "
+	"child: { sequence: [ "
+		"{ filter: \"{ A[i] }\", child: { mark: \"m\", "
+			"child: { schedule: \"[{ A[i] -> [(-i)] }]\" } } }, "
+		"{ filter: \"{ B[i] }\", "
+		"child: { guard: \"[n] -> { [] : n > 2 }\" } } ] } } } }",
+	"{ domain: \"{ A[i, j] : 0 <= i, j < 10 }\", "
+	"child: { contraction: \"{ A[i, j] -> B[i] }\", "
+	"expansion: \"{ B[i] -> A[i, j] }\", "
+	"child: { set: [ { filter: \"{ B[i] : i < 5 }\" }, "
+		"{ filter: \"{ B[i] : i >= 5 }\", "
+		"child: { extension: \"{ [] -> C[] }\", "
+		"child: { sequence: [ { filter: \"{ B[i] }\" }, "
+			"{ filter: \"{ C[] }\" } ] } } } ] } } }",
+};
+
+/* Print "map" in binary format and read the result back
+ * using "read", checking that this results in the same map.
+ * The result is compared through its textual representation
+ * since the binary format is expected to preserve the internal
+ * representation exactly.
+ */
+static isl_stat test_output_binary_map_str(isl_ctx *ctx, const char *str)
+{
+	isl_map *map, *map2;
+	isl_printer *p;
+	char *s, *s1, *s2;
+	isl_bool equal;
+
+	map = isl_map_read_from_str(ctx, str);
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_set_output_format(p, ISL_FORMAT_BINARY);
+	p = isl_printer_print_map(p, map);
+	s = isl_printer_get_str(p);
+	isl_printer_free(p);
+	map2 = s ? isl_map_read_from_binary_str(ctx, s) : NULL;
+	free(s);
+	equal = isl_map_plain_is_equal(map, map2);
+	s1 = isl_map_to_str(map);
+	s2 = isl_map_to_str(map2);
+	if (equal >= 0 && (!s1 || !s2))
+		equal = isl_bool_error;
+	if (equal == isl_bool_true && strcmp(s1, s2))
+		equal = isl_bool_false;
+	free(s1);
+	free(s2);
+	isl_map_free(map2);
+	isl_map_free(map);
+
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"map not preserved by binary format",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Check that basic maps, maps and sets are preserved
+ * when printed in binary format and read back.
+ * Also check that data of a different kind is rejected.
+ */
+static isl_stat test_output_binary_map(isl_ctx *ctx)
 {
 	int i;
-	isl_bool ok;
-	isl_multi_union_pw_aff *mupa, *res;
+	isl_basic_set *bset, *bset2;
 	isl_set *set;
+	isl_printer *p;
+	char *s;
+	isl_bool equal;
+	int on_error;
 
-	for (i = 0; i < ARRAY_SIZE(mupa_set_tests); ++i) {
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
-						    mupa_set_tests[i].arg1);
-		set = isl_set_read_from_str(ctx, mupa_set_tests[i].arg2);
-		res = isl_multi_union_pw_aff_read_from_str(ctx,
-						    mupa_set_tests[i].res);
-		mupa = mupa_set_tests[i].fn(mupa, set);
-		ok = isl_multi_union_pw_aff_plain_is_equal(mupa, res);
-		isl_multi_union_pw_aff_free(mupa);
-		isl_multi_union_pw_aff_free(res);
-		if (ok < 0)
-			return -1;
-		if (!ok)
+	for (i = 0; i < ARRAY_SIZE(binary_map_tests); ++i)
+		if (test_output_binary_map_str(ctx, binary_map_tests[i]) < 0)
+			return isl_stat_error;
+
+	bset = isl_basic_set_read_from_str(ctx,
+			"[n] -> { [i, j] : exists (e : i = 2e) and 0 <= j < n }");
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_set_output_format(p, ISL_FORMAT_BINARY);
+	p = isl_printer_print_basic_set(p, bset);
+	s = isl_printer_get_str(p);
+	isl_printer_free(p);
+	bset2 = s ? isl_basic_set_read_from_binary_str(ctx, s) : NULL;
+	equal = isl_basic_set_plain_is_equal(bset, bset2);
+	isl_basic_set_free(bset2);
+	isl_basic_set_free(bset);
+	if (equal < 0) {
+		free(s);
+		return isl_stat_error;
+	}
+	if (!equal) {
+		free(s);
+		isl_die(ctx, isl_error_unknown,
+			"basic set not preserved by binary format",
+			return isl_stat_error);
+	}
+
+	on_error = isl_options_get_on_error(ctx);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+	set = isl_set_read_from_binary_str(ctx, s);
+	isl_options_set_on_error(ctx, on_error);
+	free(s);
+	isl_set_free(set);
+	if (set)
+		isl_die(ctx, isl_error_unknown,
+			"binary basic set data accepted as set",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Check that union maps and union sets are preserved
+ * when printed in binary format and read back.
+ */
+static isl_stat test_output_binary_union_map(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(binary_union_map_tests); ++i) {
+		isl_union_map *umap, *umap2;
+		isl_printer *p;
+		char *s;
+		isl_bool equal;
+
+		umap = isl_union_map_read_from_str(ctx,
+						binary_union_map_tests[i]);
+		p = isl_printer_to_str(ctx);
+		p = isl_printer_set_output_format(p, ISL_FORMAT_BINARY);
+		p = isl_printer_print_union_map(p, umap);
+		s = isl_printer_get_str(p);
+		isl_printer_free(p);
+		umap2 = s ? isl_union_map_read_from_binary_str(ctx, s) : NULL;
+		free(s);
+		equal = isl_union_map_is_equal(umap, umap2);
+		isl_union_map_free(umap2);
+		isl_union_map_free(umap);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"union map not preserved by binary format",
+				return isl_stat_error);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(binary_union_set_tests); ++i) {
+		isl_union_set *uset, *uset2;
+		isl_printer *p;
+		char *s;
+		isl_bool equal;
+
+		uset = isl_union_set_read_from_str(ctx,
+						binary_union_set_tests[i]);
+		p = isl_printer_to_str(ctx);
+		p = isl_printer_set_output_format(p, ISL_FORMAT_BINARY);
+		p = isl_printer_print_union_set(p, uset);
+		s = isl_printer_get_str(p);
+		isl_printer_free(p);
+		uset2 = s ? isl_union_set_read_from_binary_str(ctx, s) : NULL;
+		free(s);
+		equal = isl_union_set_is_equal(uset, uset2);
+		isl_union_set_free(uset2);
+		isl_union_set_free(uset);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"union set not preserved by binary format",
+				return isl_stat_error);
+	}
+
+	return isl_stat_ok;
+}
+
+/* Check that schedules are preserved
+ * when printed in binary format and read back.
+ */
+static isl_stat test_output_binary_schedule(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(binary_schedule_tests); ++i) {
+		isl_schedule *schedule, *schedule2;
+		isl_printer *p;
+		char *s;
+		isl_bool equal;
+
+		schedule = isl_schedule_read_from_str(ctx,
+						binary_schedule_tests[i]);
+		p = isl_printer_to_str(ctx);
+		p = isl_printer_set_output_format(p, ISL_FORMAT_BINARY);
+		p = isl_printer_print_schedule(p, schedule);
+		s = isl_printer_get_str(p);
+		isl_printer_free(p);
+		schedule2 = s ? isl_schedule_read_from_binary_str(ctx, s) : NULL;
+		free(s);
+		equal = isl_schedule_plain_is_equal(schedule, schedule2);
+		isl_schedule_free(schedule2);
+		isl_schedule_free(schedule);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
 			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
+				"schedule not preserved by binary format",
+				return isl_stat_error);
 	}
 
-	return 0;
+	return isl_stat_ok;
 }
 
-/* Inputs for basic tests of binary operations on
- * pairs of isl_multi_union_pw_aff and isl_union_set objects.
- * "fn" is the function that is tested.
- * "arg1" and "arg2" are string descriptions of the inputs.
- * "res" is a string description of the expected result.
+/* Schedule constraints that are printed in binary format and read back
+ * in test_output_binary_schedule_constraints.
  */
-struct {
-	__isl_give isl_multi_union_pw_aff *(*fn)(
-		__isl_take isl_multi_union_pw_aff *mupa,
-		__isl_take isl_union_set *uset);
-	const char *arg1;
-	const char *arg2;
-	const char *res;
-} mupa_uset_tests[] = {
-	{ &isl_multi_union_pw_aff_intersect_domain,
-	  "C[{ B[i,j] -> [i + 2j] }]", "{ B[i,i] }",
-	  "C[{ B[i,i] -> [3i] }]" },
-	{ &isl_multi_union_pw_aff_intersect_domain,
-	  "(C[] : { B[i,j] })", "{ B[i,i] }",
-	  "(C[] : { B[i,i] })" },
-	{ &isl_multi_union_pw_aff_intersect_domain,
-	  "(C[] : { B[i,j] })", "[N] -> { B[N,N] }",
-	  "[N] -> (C[] : { B[N,N] })" },
-	{ &isl_multi_union_pw_aff_intersect_domain,
-	  "C[]", "{ B[i,i] }",
-	  "(C[] : { B[i,i] })" },
-	{ &isl_multi_union_pw_aff_intersect_domain,
-	  "[N] -> (C[] : { : N >= 0 })", "{ B[i,i] }",
-	  "[N] -> (C[] : { B[i,i] : N >= 0 })" },
+static const char *binary_schedule_constraints_tests[] = {
+	"{ domain: \"{ A[i] : 0 <= i < 10 }\" }",
+	"{ domain: \"[n] -> { A[i] : 0 <= i < n; B[i] : 0 <= i < n }\", "
+	"context: \"[n] -> { : n >= 2 }\", "
+	"validity: \"{ A[i] -> A[i + 1] }\", "
+	"coincidence: \"{ A[i] -> B[i] }\", "
+	"proximity: \"{ A[i] -> B[i]; B[i] -> B[i + 1] }\", "
+	"condition: \"{ [A[i] -> t[]] -> [A[i + 1] -> t[]] }\", "
+	"conditional_validity: \"{ [B[i] -> u[]] -> [B[i + 1] -> u[]] }\" }",
 };
 
-/* Perform some basic tests of binary operations on
- * pairs of isl_multi_union_pw_aff and isl_union_set objects.
+/* Check that schedule constraints are preserved
+ * when printed in binary format and read back.
+ * The result is compared through its textual representation
+ * since there is no public function for comparing schedule constraints.
  */
-static int test_mupa_uset(isl_ctx *ctx)
+static isl_stat test_output_binary_schedule_constraints(isl_ctx *ctx)
 {
 	int i;
-	isl_bool ok;
-	isl_multi_union_pw_aff *mupa, *res;
-	isl_union_set *uset;
 
-	for (i = 0; i < ARRAY_SIZE(mupa_uset_tests); ++i) {
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
-						    mupa_uset_tests[i].arg1);
-		uset = isl_union_set_read_from_str(ctx,
-						    mupa_uset_tests[i].arg2);
-		res = isl_multi_union_pw_aff_read_from_str(ctx,
-						    mupa_uset_tests[i].res);
-		mupa = mupa_uset_tests[i].fn(mupa, uset);
-		ok = isl_multi_union_pw_aff_plain_is_equal(mupa, res);
-		isl_multi_union_pw_aff_free(mupa);
-		isl_multi_union_pw_aff_free(res);
-		if (ok < 0)
-			return -1;
-		if (!ok)
+	for (i = 0; i < ARRAY_SIZE(binary_schedule_constraints_tests); ++i) {
+		isl_schedule_constraints *sc, *sc2;
+		isl_printer *p;
+		char *s, *s1, *s2;
+		int equal;
+
+		sc = isl_schedule_constraints_read_from_str(ctx,
+					binary_schedule_constraints_tests[i]);
+		p = isl_printer_to_str(ctx);
+		p = isl_printer_set_output_format(p, ISL_FORMAT_BINARY);
+		p = isl_printer_print_schedule_constraints(p, sc);
+		s = isl_printer_get_str(p);
+		isl_printer_free(p);
+		sc2 = s ? isl_schedule_constraints_read_from_binary_str(ctx, s) :
+			NULL;
+		free(s);
+		s1 = isl_schedule_constraints_to_str(sc);
+		s2 = isl_schedule_constraints_to_str(sc2);
+		equal = s1 && s2 ? !strcmp(s1, s2) : -1;
+		free(s1);
+		free(s2);
+		isl_schedule_constraints_free(sc2);
+		isl_schedule_constraints_free(sc);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
 			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
+				"schedule constraints not preserved "
+				"by binary format", return isl_stat_error);
 	}
 
-	return 0;
+	return isl_stat_ok;
 }
 
-/* Inputs for basic tests of binary operations on
- * pairs of isl_multi_union_pw_aff and isl_multi_aff objects.
- * "fn" is the function that is tested.
- * "arg1" and "arg2" are string descriptions of the inputs.
- * "res" is a string description of the expected result.
+/* Check that a sequence of objects printed in binary format
+ * to the same string can be read back one by one from memory,
+ * and that reading stops at the end of the buffer.
  */
-struct {
-	__isl_give isl_multi_union_pw_aff *(*fn)(
-		__isl_take isl_multi_union_pw_aff *mupa,
-		__isl_take isl_multi_aff *ma);
-	const char *arg1;
-	const char *arg2;
-	const char *res;
-} mupa_ma_tests[] = {
-	{ &isl_multi_union_pw_aff_apply_multi_aff,
-	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }, "
-	    "{ A[i,j] -> [j]; B[i,j] -> [i] }]",
-	  "{ C[a,b] -> D[b,a] }",
-	  "D[{ A[i,j] -> [j]; B[i,j] -> [i] }, "
-	    "{ A[i,j] -> [i]; B[i,j] -> [j] }]" },
-	{ &isl_multi_union_pw_aff_apply_multi_aff,
-	  "C[{ A[i,j] -> [i] : i >= 0; B[i,j] -> [j] }, "
-	    "{ A[i,j] -> [j]; B[i,j] -> [i] }]",
-	  "{ C[a,b] -> D[b,a] }",
-	  "D[{ A[i,j] -> [j] : i >= 0; B[i,j] -> [i] }, "
-	    "{ A[i,j] -> [i] : i >= 0; B[i,j] -> [j] }]" },
-	{ &isl_multi_union_pw_aff_apply_multi_aff,
-	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }]",
-	  "[N] -> { C[a] -> D[a + N] }",
-	  "[N] -> D[{ A[i,j] -> [i + N]; B[i,j] -> [j + N] }] " },
-	{ &isl_multi_union_pw_aff_apply_multi_aff,
-	  "C[]",
-	  "{ C[] -> D[] }",
-	  "D[]" },
-	{ &isl_multi_union_pw_aff_apply_multi_aff,
-	  "[N] -> (C[] : { : N >= 0 })",
-	  "{ C[] -> D[] }",
-	  "[N] -> (D[] : { : N >= 0 })" },
-	{ &isl_multi_union_pw_aff_apply_multi_aff,
-	  "C[]",
-	  "[N] -> { C[] -> D[N] }",
-	  "[N] -> D[{ [N] }]" },
-	{ &isl_multi_union_pw_aff_apply_multi_aff,
-	  "(C[] : { A[i,j] : i >= j })",
-	  "{ C[] -> D[] }",
-	  "(D[] : { A[i,j] : i >= j })" },
-	{ &isl_multi_union_pw_aff_apply_multi_aff,
-	  "[N] -> (C[] : { A[i,j] : N >= 0 })",
-	  "{ C[] -> D[] }",
-	  "[N] -> (D[] : { A[i,j] : N >= 0 })" },
-	{ &isl_multi_union_pw_aff_apply_multi_aff,
-	  "(C[] : { A[i,j] : i >= j })",
-	  "[N] -> { C[] -> D[N] }",
-	  "[N] -> (D[{ A[i,j] -> [N] : i >= j }])" },
-};
+static isl_stat test_output_binary_mem(isl_ctx *ctx)
+{
+	isl_basic_set *bset, *bset2;
+	isl_union_map *umap, *umap2;
+	isl_schedule *schedule, *schedule2;
+	isl_printer *p;
+	char *s;
+	size_t size, pos;
+	isl_bool equal;
+	int on_error;
 
-/* Perform some basic tests of binary operations on
- * pairs of isl_multi_union_pw_aff and isl_multi_aff objects.
+	bset = isl_basic_set_read_from_str(ctx, "[n] -> { [i] : 0 <= i < n }");
+	umap = isl_union_map_read_from_str(ctx, binary_union_map_tests[1]);
+	schedule = isl_schedule_read_from_str(ctx, binary_schedule_tests[1]);
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_set_output_format(p, ISL_FORMAT_BINARY);
+	p = isl_printer_print_basic_set(p, bset);
+	p = isl_printer_print_union_map(p, umap);
+	p = isl_printer_print_schedule(p, schedule);
+	s = isl_printer_get_str(p);
+	isl_printer_free(p);
+	size = s ? strlen(s) : 0;
+
+	pos = 0;
+	bset2 = isl_basic_set_read_from_binary_mem(ctx, s, size, &pos);
+	umap2 = isl_union_map_read_from_binary_mem(ctx, s, size, &pos);
+	equal = isl_basic_set_plain_is_equal(bset, bset2);
+	if (equal == isl_bool_true)
+		equal = isl_union_map_is_equal(umap, umap2);
+	isl_union_map_free(umap2);
+	isl_basic_set_free(bset2);
+
+	if (equal == isl_bool_true) {
+		on_error = isl_options_get_on_error(ctx);
+		isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+		schedule2 = isl_schedule_read_from_binary_mem(ctx, s, size - 1,
+								&pos);
+		isl_options_set_on_error(ctx, on_error);
+		if (schedule2)
+			equal = isl_bool_false;
+		isl_schedule_free(schedule2);
+	}
+	if (equal == isl_bool_true) {
+		schedule2 = isl_schedule_read_from_binary_mem(ctx, s, size,
+								&pos);
+		equal = isl_schedule_plain_is_equal(schedule, schedule2);
+		if (equal == isl_bool_true && pos != size)
+			equal = isl_bool_false;
+		isl_schedule_free(schedule2);
+	}
+
+	free(s);
+	isl_schedule_free(schedule);
+	isl_union_map_free(umap);
+	isl_basic_set_free(bset);
+
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"objects not preserved by binary format",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+/* Binary data of the basic set { [i] : i >= 0 }, with the number
+ * of inequality constraints replaced by 2^30.
  */
-static int test_mupa_ma(isl_ctx *ctx)
+static const char binary_huge_n_ineq[] =
+	"ISLBAAA@@@ACiA@@" "\x88\x80\x80\x80@" "@B";
+
+/* Check that binary data that claims to contain more constraints
+ * than fit in the remaining input is rejected,
+ * without first allocating room for all those constraints.
+ */
+static isl_stat test_output_binary_huge(isl_ctx *ctx)
 {
-	int i;
-	isl_bool ok;
-	isl_multi_union_pw_aff *mupa, *res;
-	isl_multi_aff *ma;
+	isl_basic_set *bset1, *bset2;
+	int on_error;
 
-	for (i = 0; i < ARRAY_SIZE(mupa_ma_tests); ++i) {
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
-						    mupa_ma_tests[i].arg1);
-		ma = isl_multi_aff_read_from_str(ctx, mupa_ma_tests[i].arg2);
-		res = isl_multi_union_pw_aff_read_from_str(ctx,
-						    mupa_ma_tests[i].res);
-		mupa = mupa_ma_tests[i].fn(mupa, ma);
-		ok = isl_multi_union_pw_aff_plain_is_equal(mupa, res);
-		isl_multi_union_pw_aff_free(mupa);
-		isl_multi_union_pw_aff_free(res);
-		if (ok < 0)
-			return -1;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
-	}
+	on_error = isl_options_get_on_error(ctx);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+	bset1 = isl_basic_set_read_from_binary_str(ctx, binary_huge_n_ineq);
+	bset2 = isl_basic_set_read_from_binary_mem(ctx, binary_huge_n_ineq,
+				sizeof(binary_huge_n_ineq) - 1, NULL);
+	isl_options_set_on_error(ctx, on_error);
+	isl_basic_set_free(bset1);
+	isl_basic_set_free(bset2);
+	if (bset1 || bset2)
+		isl_die(ctx, isl_error_unknown,
+			"truncated binary data accepted",
+			return isl_stat_error);
 
-	return 0;
+	return isl_stat_ok;
 }
 
-/* Inputs for basic tests of binary operations on
- * pairs of isl_multi_union_pw_aff and isl_pw_aff objects.
- * "fn" is the function that is tested.
- * "arg1" and "arg2" are string descriptions of the inputs.
- * "res" is a string description of the expected result.
+/* Check that objects are preserved when printed in binary format
+ * and read back.
  */
-struct {
-	__isl_give isl_union_pw_aff *(*fn)(
-		__isl_take isl_multi_union_pw_aff *mupa,
-		__isl_take isl_pw_aff *pa);
-	const char *arg1;
-	const char *arg2;
-	const char *res;
-} mupa_pa_tests[] = {
-	{ &isl_multi_union_pw_aff_apply_pw_aff,
-	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }]",
-	  "[N] -> { C[a] -> [a + N] }",
-	  "[N] -> { A[i,j] -> [i + N]; B[i,j] -> [j + N] }" },
-	{ &isl_multi_union_pw_aff_apply_pw_aff,
-	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }]",
-	  "{ C[a] -> [a] : a >= 0; C[a] -> [-a] : a < 0 }",
-	  "{ A[i,j] -> [i] : i >= 0; A[i,j] -> [-i] : i < 0; "
-	    "B[i,j] -> [j] : j >= 0; B[i,j] -> [-j] : j < 0 }" },
-	{ &isl_multi_union_pw_aff_apply_pw_aff,
-	  "C[]",
-	  "[N] -> { C[] -> [N] }",
-	  "[N] -> { [N] }" },
-	{ &isl_multi_union_pw_aff_apply_pw_aff,
-	  "C[]",
-	  "[N] -> { C[] -> [N] : N >= 0; C[] -> [-N] : N < 0 }",
-	  "[N] -> { [N] : N >= 0; [-N] : N < 0 }" },
-	{ &isl_multi_union_pw_aff_apply_pw_aff,
-	  "[N] -> (C[] : { : N >= 0 })",
-	  "[N] -> { C[] -> [N] }",
-	  "[N] -> { [N] : N >= 0 }" },
-	{ &isl_multi_union_pw_aff_apply_pw_aff,
-	  "[N] -> (C[] : { : N >= 0 })",
-	  "[N] -> { C[] -> [N] : N >= 0; C[] -> [-N] : N < 0 }",
-	  "[N] -> { [N] : N >= 0 }" },
-	{ &isl_multi_union_pw_aff_apply_pw_aff,
-	  "[N] -> (C[] : { : N >= 0 })",
-	  "{ C[] -> [0] }",
-	  "[N] -> { [0] : N >= 0 }" },
-	{ &isl_multi_union_pw_aff_apply_pw_aff,
-	  "(C[] : { A[i,j] : i >= j })",
-	  "[N] -> { C[] -> [N] }",
-	  "[N] -> { A[i,j] -> [N] : i >= j }" },
-	{ &isl_multi_union_pw_aff_apply_pw_aff,
-	  "(C[] : { A[i,j] : i >= j })",
-	  "[N] -> { C[] -> [N] : N >= 0 }",
-	  "[N] -> { A[i,j] -> [N] : i >= j and N >= 0 }" },
+static isl_stat test_output_binary(isl_ctx *ctx)
+{
+	if (test_output_binary_map(ctx) < 0)
+		return isl_stat_error;
+	if (test_output_binary_union_map(ctx) < 0)
+		return isl_stat_error;
+	if (test_output_binary_schedule(ctx) < 0)
+		return isl_stat_error;
+	if (test_output_binary_schedule_constraints(ctx) < 0)
+		return isl_stat_error;
+	if (test_output_binary_mem(ctx) < 0)
+		return isl_stat_error;
+	if (test_output_binary_huge(ctx) < 0)
+		return isl_stat_error;
+
+	return isl_stat_ok;
+}
+
+/* Data used in test_output_callback.
+ *
+ * "s" collects the chunks passed to collect_chunk.
+ * "n" is the number of characters in "s".
+ * "size" is the number of characters allocated for "s".
+ * "n_chunk" is the number of chunks.
+ */
+struct isl_test_output_callback_data {
+	char *s;
+	size_t n;
+	size_t size;
+	int n_chunk;
 };
 
-/* Perform some basic tests of binary operations on
- * pairs of isl_multi_union_pw_aff and isl_pw_aff objects.
+/* Append the chunk "s" of length "len" to data->s.
+ */
+static isl_stat collect_chunk(const char *s, size_t len, void *user)
+{
+	struct isl_test_output_callback_data *data = user;
+
+	if (data->n + len + 1 > data->size) {
+		char *t;
+
+		data->size = 2 * (data->n + len + 1);
+		t = realloc(data->s, data->size);
+		if (!t)
+			return isl_stat_error;
+		data->s = t;
+	}
+	memcpy(data->s + data->n, s, len);
+	data->n += len;
+	data->s[data->n] = '\0';
+	data->n_chunk++;
+
+	return isl_stat_ok;
+}
+
+/* Check that a printer created by isl_printer_to_callback
+ * produces the same output as a string printer,
+ * where the output is large enough to be split into several chunks.
  */
-static int test_mupa_pa(isl_ctx *ctx)
+static isl_stat test_output_callback(isl_ctx *ctx)
 {
-	int i;
-	isl_bool ok;
-	isl_multi_union_pw_aff *mupa;
-	isl_union_pw_aff *upa, *res;
+	struct isl_test_output_callback_data data = { NULL, 0, 0, 0 };
+	isl_printer *p_str, *p_cb;
+	char *s;
+	int i, equal;
+
+	p_str = isl_printer_to_str(ctx);
+	p_cb = isl_printer_to_callback(ctx, &collect_chunk, &data);
+	for (i = 0; i < 20000; ++i) {
+		p_str = isl_printer_print_str(p_str, "i = ");
+		p_str = isl_printer_print_int(p_str, i);
+		p_str = isl_printer_end_line(p_str);
+		p_cb = isl_printer_print_str(p_cb, "i = ");
+		p_cb = isl_printer_print_int(p_cb, i);
+		p_cb = isl_printer_end_line(p_cb);
+	}
+	s = isl_printer_get_str(p_str);
+	isl_printer_free(p_str);
+	isl_printer_free(p_cb);
+
+	equal = s && data.s && !strcmp(s, data.s);
+	free(s);
+	free(data.s);
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected output of callback printer",
+			return isl_stat_error);
+	if (data.n_chunk < 2)
+		isl_die(ctx, isl_error_unknown,
+			"expecting output in several chunks",
+			return isl_stat_error);
+
+	return isl_stat_ok;
+}
+
+int test_output(isl_ctx *ctx)
+{
+	char *s;
+	const char *str;
 	isl_pw_aff *pa;
+	isl_printer *p;
+	int equal;
 
-	for (i = 0; i < ARRAY_SIZE(mupa_pa_tests); ++i) {
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
-						    mupa_pa_tests[i].arg1);
-		pa = isl_pw_aff_read_from_str(ctx, mupa_pa_tests[i].arg2);
-		res = isl_union_pw_aff_read_from_str(ctx,
-						    mupa_pa_tests[i].res);
-		upa = mupa_pa_tests[i].fn(mupa, pa);
-		ok = isl_union_pw_aff_plain_is_equal(upa, res);
-		isl_union_pw_aff_free(upa);
-		isl_union_pw_aff_free(res);
-		if (ok < 0)
-			return -1;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
-	}
+	if (test_output_set(ctx) < 0)
+		return -1;
+	if (test_output_ma(ctx) < 0)
+		return -1;
+	if (test_output_mpa(ctx) < 0)
+		return -1;
+	if (test_output_int(ctx) < 0)
+		return -1;
+	if (test_output_binary(ctx) < 0)
+		return -1;
+	if (test_output_callback(ctx) < 0)
+		return -1;
+
+	str = "[x] -> { [1] : x % 4 <= 2; [2] : x = 3 }";
+	pa = isl_pw_aff_read_from_str(ctx, str);
+
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_set_output_format(p, ISL_FORMAT_C);
+	p = isl_printer_print_pw_aff(p, pa);
+	s = isl_printer_get_str(p);
+	isl_printer_free(p);
+	isl_pw_aff_free(pa);
+	if (!s)
+		equal = -1;
+	else
+		equal = !strcmp(s, "4 * floord(x, 4) + 2 >= x ? 1 : 2");
+	free(s);
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
 
 	return 0;
 }
 
-/* Inputs for basic tests of binary operations on
- * pairs of isl_multi_union_pw_aff and isl_pw_multi_aff objects.
- * "fn" is the function that is tested.
- * "arg1" and "arg2" are string descriptions of the inputs.
- * "res" is a string description of the expected result.
+/* Sets used in test_point_block.
  */
-struct {
-	__isl_give isl_multi_union_pw_aff *(*fn)(
-		__isl_take isl_multi_union_pw_aff *mupa,
-		__isl_take isl_pw_multi_aff *pma);
-	const char *arg1;
-	const char *arg2;
-	const char *res;
-} mupa_pma_tests[] = {
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }, "
-	    "{ A[i,j] -> [j]; B[i,j] -> [i] }]",
-	  "{ C[a,b] -> D[b,a] }",
-	  "D[{ A[i,j] -> [j]; B[i,j] -> [i] }, "
-	    "{ A[i,j] -> [i]; B[i,j] -> [j] }]" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "C[{ A[i,j] -> [i] : i >= 0; B[i,j] -> [j] }, "
-	    "{ A[i,j] -> [j]; B[i,j] -> [i] }]",
-	  "{ C[a,b] -> D[b,a] }",
-	  "D[{ A[i,j] -> [j] : i >= 0; B[i,j] -> [i] }, "
-	    "{ A[i,j] -> [i] : i >= 0; B[i,j] -> [j] }]" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }]",
-	  "[N] -> { C[a] -> D[a + N] }",
-	  "[N] -> D[{ A[i,j] -> [i + N]; B[i,j] -> [j + N] }]" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }]",
-	  "{ C[a] -> D[a] : a >= 0; C[a] -> D[-a] : a < 0 }",
-	  "D[{ A[i,j] -> [i] : i >= 0; A[i,j] -> [-i] : i < 0; "
-	      "B[i,j] -> [j] : j >= 0; B[i,j] -> [-j] : j < 0 }]" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "C[{ A[i,j] -> [i]; B[i,j] -> [j] }, "
-	    "{ A[i,j] -> [j]; B[i,j] -> [i] }]",
-	  "{ C[a,b] -> D[a,b] : a >= b; C[a,b] -> D[b,a] : a < b }",
-	  "D[{ A[i,j] -> [i] : i >= j; A[i,j] -> [j] : i < j; "
-	      "B[i,j] -> [j] : i <= j; B[i,j] -> [i] : i > j }, "
-	    "{ A[i,j] -> [j] : i >= j; A[i,j] -> [i] : i < j; "
-	      "B[i,j] -> [i] : i <= j; B[i,j] -> [j] : i > j }]" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "C[]",
-	  "{ C[] -> D[] }",
-	  "D[]" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "[N] -> (C[] : { : N >= 0 })",
-	  "{ C[] -> D[] }",
-	  "[N] -> (D[] : { : N >= 0 })" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "C[]",
-	  "[N] -> { C[] -> D[N] }",
-	  "[N] -> D[{ [N] }]" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "(C[] : { A[i,j] : i >= j })",
-	  "{ C[] -> D[] }",
-	  "(D[] : { A[i,j] : i >= j })" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "[N] -> (C[] : { A[i,j] : N >= 0 })",
-	  "{ C[] -> D[] }",
-	  "[N] -> (D[] : { A[i,j] : N >= 0 })" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "(C[] : { A[i,j] : i >= j })",
-	  "[N] -> { C[] -> D[N] }",
-	  "[N] -> (D[{ A[i,j] -> [N] : i >= j }])" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "C[]",
-	  "[N] -> { C[] -> D[N] : N >= 0; C[] -> D[-N] : N < 0 }",
-	  "[N] -> D[{ [N] : N >= 0; [-N] : N < 0 }]" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "[N] -> (C[] : { : N >= 0 })",
-	  "[N] -> { C[] -> D[N] }",
-	  "[N] -> D[{ [N] : N >= 0 }]" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "[N] -> (C[] : { : N >= 0 })",
-	  "[N] -> { C[] -> D[N] : N >= 0; C[] -> D[-N] : N < 0 }",
-	  "[N] -> D[{ [N] : N >= 0 }]" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "[N] -> (C[] : { : N >= 0 })",
-	  "{ C[] -> D[0] }",
-	  "[N] -> D[{ [0] : N >= 0 }]" },
-	{ &isl_multi_union_pw_aff_apply_pw_multi_aff,
-	  "(C[] : { A[i,j] : i >= j })",
-	  "[N] -> { C[] -> D[N] : N >= 0 }",
-	  "[N] -> D[{ A[i,j] -> [N] : i >= j and N >= 0 }]" },
+static const char *point_block_tests[] = {
+	"{ [x, y] : 0 <= x <= 10 and 0 <= y <= x }",
+	"{ [x, y, z] : 0 <= x, y <= 4 and x + y <= z <= 2x + 5 and "
+		"z = 2 * floor(z/2) }",
+	"{ [x, y] : 2x + 3y = 7 and 0 <= x <= 20 }",
+	"[N] -> { [x] : 0 <= N <= 3 and -N <= x <= N }",
+	"{ [x, y] : x = 3 and y = -7 }",
+	"{ [x] : false }",
+	"{ [] }",
 };
 
-/* Perform some basic tests of binary operations on
- * pairs of isl_multi_union_pw_aff and isl_pw_multi_aff objects.
+/* Data used by the callbacks of test_point_block.
+ * "coords" contains the coordinates of the "n" points collected so far,
+ * each consisting of "dim" coordinates, with room for "max" points.
  */
-static int test_mupa_pma(isl_ctx *ctx)
+struct isl_test_point_block_data {
+	int dim;
+	int n;
+	int max;
+	long *coords;
+};
+
+/* isl_set_foreach_point callback that appends the coordinates of "pnt"
+ * to data->coords.
+ */
+static isl_stat collect_point(__isl_take isl_point *pnt, void *user)
 {
+	struct isl_test_point_block_data *data = user;
+	isl_space *space;
+	isl_size nparam;
 	int i;
-	isl_bool ok;
-	isl_multi_union_pw_aff *mupa, *res;
-	isl_pw_multi_aff *pma;
-
-	for (i = 0; i < ARRAY_SIZE(mupa_pma_tests); ++i) {
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
-						    mupa_pma_tests[i].arg1);
-		pma = isl_pw_multi_aff_read_from_str(ctx,
-						    mupa_pma_tests[i].arg2);
-		res = isl_multi_union_pw_aff_read_from_str(ctx,
-						    mupa_pma_tests[i].res);
-		mupa = mupa_pma_tests[i].fn(mupa, pma);
-		ok = isl_multi_union_pw_aff_plain_is_equal(mupa, res);
-		isl_multi_union_pw_aff_free(mupa);
-		isl_multi_union_pw_aff_free(res);
-		if (ok < 0)
-			return -1;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
-	}
 
-	return 0;
-}
+	space = isl_point_get_space(pnt);
+	nparam = isl_space_dim(space, isl_dim_param);
+	isl_space_free(space);
+	if (nparam < 0 || data->n >= data->max)
+		goto error;
+	for (i = 0; i < data->dim; ++i) {
+		enum isl_dim_type type;
+		isl_val *v;
+		int pos;
 
-/* Inputs for basic tests of binary operations on
- * pairs of isl_multi_union_pw_aff and isl_union_pw_multi_aff objects.
- * "fn" is the function that is tested.
- * "arg1" and "arg2" are string descriptions of the inputs.
- * "res" is a string description of the expected result.
- */
-struct {
-	__isl_give isl_multi_union_pw_aff *(*fn)(
-		__isl_take isl_multi_union_pw_aff *mupa,
-		__isl_take isl_union_pw_multi_aff *upma);
-	const char *arg1;
-	const char *arg2;
-	const char *res;
-} mupa_upma_tests[] = {
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "C[{ B[i,j] -> [i + 2j] }]", "{ A[a,b] -> B[b,a] }",
-	  "C[{ A[a,b] -> [b + 2a] }]" },
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "C[{ B[i,j] -> [i + 2j] }]",
-	  "{ A[a,b] -> B[b,a] : b > a }",
-	  "C[{ A[a,b] -> [b + 2a] : b > a }]" },
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "C[{ B[i,j] -> [i + 2j] : j > 4 }]",
-	  "{ A[a,b] -> B[b,a] : b > a }",
-	  "C[{ A[a,b] -> [b + 2a] : b > a > 4 }]" },
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "C[{ B[i,j] -> [i + 2j] }]",
-	  "{ A[a,b] -> B[b,a] : a > b; A[a,b] -> B[a,b] : a <= b }",
-	  "C[{ A[a,b] -> [b + 2a] : a > b; A[a,b] -> [a + 2b] : a <= b }]" },
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "(C[] : { B[a,b] })",
-	  "{ A[a,b] -> B[b,a] }",
-	  "(C[] : { A[a,b] })" },
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "(C[] : { B[a,b] })",
-	  "{ B[a,b] -> A[b,a] }",
-	  "(C[] : { })" },
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "(C[] : { B[a,b] })",
-	  "{ A[a,b] -> B[b,a] : a > b }",
-	  "(C[] : { A[a,b] : a > b })" },
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "(C[] : { B[a,b] : a > b })",
-	  "{ A[a,b] -> B[b,a] }",
-	  "(C[] : { A[a,b] : b > a })" },
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "[N] -> (C[] : { B[a,b] : a > N })",
-	  "{ A[a,b] -> B[b,a] : a > b }",
-	  "[N] -> (C[] : { A[a,b] : a > b > N })" },
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "(C[] : { B[a,b] : a > b })",
-	  "[N] -> { A[a,b] -> B[b,a] : a > N }",
-	  "[N] -> (C[] : { A[a,b] : b > a > N })" },
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "C[]",
-	  "{ A[a,b] -> B[b,a] }",
-	  "C[]" },
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "[N] -> (C[] : { : N >= 0 })",
-	  "{ A[a,b] -> B[b,a] }",
-	  "[N] -> (C[] : { : N >= 0 })" },
-	{ &isl_multi_union_pw_aff_pullback_union_pw_multi_aff,
-	  "C[]",
-	  "[N] -> { A[a,b] -> B[b,a] : N >= 0 }",
-	  "[N] -> (C[] : { : N >= 0 })" },
-};
+		type = i < nparam ? isl_dim_param : isl_dim_set;
+		pos = i < nparam ? i : i - nparam;
+		v = isl_point_get_coordinate_val(pnt, type, pos);
+		if (!v)
+			goto error;
+		data->coords[data->n * data->dim + i] = isl_val_get_num_si(v);
+		isl_val_free(v);
+	}
+	data->n++;
+	isl_point_free(pnt);
+	return isl_stat_ok;
+error:
+	isl_point_free(pnt);
+	return isl_stat_error;
+}
 
-/* Perform some basic tests of binary operations on
- * pairs of isl_multi_union_pw_aff and isl_union_pw_multi_aff objects.
+/* isl_set_foreach_point_block callback that appends the "n" points
+ * in "coords" to data->coords.
  */
-static int test_mupa_upma(isl_ctx *ctx)
+static isl_stat collect_point_block(long *coords, int n, void *user)
 {
+	struct isl_test_point_block_data *data = user;
 	int i;
-	isl_bool ok;
-	isl_multi_union_pw_aff *mupa, *res;
-	isl_union_pw_multi_aff *upma;
 
-	for (i = 0; i < ARRAY_SIZE(mupa_upma_tests); ++i) {
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
-						    mupa_upma_tests[i].arg1);
-		upma = isl_union_pw_multi_aff_read_from_str(ctx,
-						    mupa_upma_tests[i].arg2);
-		res = isl_multi_union_pw_aff_read_from_str(ctx,
-						    mupa_upma_tests[i].res);
-		mupa = mupa_upma_tests[i].fn(mupa, upma);
-		ok = isl_multi_union_pw_aff_plain_is_equal(mupa, res);
-		isl_multi_union_pw_aff_free(mupa);
-		isl_multi_union_pw_aff_free(res);
-		if (ok < 0)
+	if (n <= 0 || data->n + n > data->max)
+		return isl_stat_error;
+	for (i = 0; i < n * data->dim; ++i)
+		data->coords[data->n * data->dim + i] = coords[i];
+	data->n += n;
+	return isl_stat_ok;
+}
+
+/* Check that isl_set_foreach_point_block produces the same points
+ * in the same order as isl_set_foreach_point,
+ * using a buffer that is smaller than the number of points.
+ */
+static int test_point_block(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(point_block_tests); ++i) {
+		struct isl_test_point_block_data data1, data2;
+		long buffer[3 * 4];
+		isl_set *set;
+		isl_size dim;
+		isl_stat r1, r2;
+		int equal;
+
+		set = isl_set_read_from_str(ctx, point_block_tests[i]);
+		dim = isl_set_dim(set, isl_dim_all);
+		if (dim < 0) {
+			isl_set_free(set);
 			return -1;
-		if (!ok)
+		}
+		data1.dim = data2.dim = dim;
+		data1.n = data2.n = 0;
+		data1.max = data2.max = 200;
+		data1.coords = isl_calloc_array(ctx, long, 200 * (dim + 1));
+		data2.coords = isl_calloc_array(ctx, long, 200 * (dim + 1));
+		r1 = isl_set_foreach_point(set, &collect_point, &data1);
+		r2 = isl_set_foreach_point_block(set, buffer, 3,
+						&collect_point_block, &data2);
+		isl_set_free(set);
+		equal = r1 >= 0 && r2 >= 0 && data1.n == data2.n &&
+			!memcmp(data1.coords, data2.coords,
+				data1.n * dim * sizeof(long));
+		free(data1.coords);
+		free(data2.coords);
+		if (r1 < 0 || r2 < 0)
+			return -1;
+		if (!equal)
 			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
+				"unexpected points", return -1);
 	}
 
 	return 0;
 }
 
-/* Check that the input tuple of an isl_aff can be set properly.
+/* Sets used in test_scan_threads.
  */
-static isl_stat test_aff_set_tuple_id(isl_ctx *ctx)
+static const char *scan_threads_tests[] = {
+	"{ [x, y] : 0 <= x <= 10 and 0 <= y <= x }",
+	"{ [x, y, z] : 0 <= x, y <= 4 and x + y <= z <= 2x + 5 and "
+		"z = 2 * floor(z/2) }",
+	"{ [x, y] : 0 <= x <= 2 and 0 <= y <= 100; "
+		"[x, y] : 50 <= x <= 60 and -x <= y <= x }",
+	"{ [x, y] : 2x + 3y = 7 and 0 <= x <= 20 }",
+	"[N] -> { [x] : 0 <= N <= 3 and -N <= x <= N }",
+	"{ [x] : x = 5 }",
+	"{ [x] : false }",
+	"{ [] }",
+};
+
+/* Check that counting the integer points in a set
+ * using several threads produces the same result
+ * as counting them without threads,
+ * independently of the number of threads.
+ * The number of threads is set through the scan_threads option
+ * or through the threads option with the scan_threads option unset.
+ */
+static int test_scan_threads(isl_ctx *ctx)
 {
-	isl_id *id;
-	isl_aff *aff;
-	isl_stat equal;
+	int i, j, k;
+	int scan_threads, threads;
+	int n_threads[] = { 2, 3, 7 };
+	isl_stat r = isl_stat_ok;
+
+	scan_threads = isl_options_get_scan_threads(ctx);
+	threads = isl_options_get_threads(ctx);
+	for (i = 0; r >= 0 && i < ARRAY_SIZE(scan_threads_tests); ++i) {
+		isl_set *set;
+		isl_val *ref;
+
+		set = isl_set_read_from_str(ctx, scan_threads_tests[i]);
+		isl_options_set_scan_threads(ctx, 0);
+		isl_options_set_threads(ctx, 0);
+		ref = isl_set_count_val(set);
+		if (!ref)
+			r = isl_stat_error;
+		for (j = 0; r >= 0 && j < 2 * ARRAY_SIZE(n_threads); ++j) {
+			isl_val *v;
+			isl_bool equal;
+
+			k = j % ARRAY_SIZE(n_threads);
+			if (j < ARRAY_SIZE(n_threads))
+				isl_options_set_scan_threads(ctx, n_threads[k]);
+			else
+				isl_options_set_scan_threads(ctx, 0);
+			if (j < ARRAY_SIZE(n_threads))
+				isl_options_set_threads(ctx, 0);
+			else
+				isl_options_set_threads(ctx, n_threads[k]);
+			v = isl_set_count_val(set);
+			equal = isl_val_eq(ref, v);
+			isl_val_free(v);
+			if (equal < 0)
+				r = isl_stat_error;
+			else if (!equal)
+				isl_die(ctx, isl_error_unknown,
+					"unexpected count", r = isl_stat_error);
+		}
+		isl_val_free(ref);
+		isl_set_free(set);
+	}
+	isl_options_set_scan_threads(ctx, scan_threads);
+	isl_options_set_threads(ctx, threads);
 
-	aff = isl_aff_read_from_str(ctx, "{ [x] -> [x + 1] }");
-	id = isl_id_alloc(ctx, "A", NULL);
-	aff = isl_aff_set_tuple_id(aff, isl_dim_in, id);
-	equal = aff_check_plain_equal(aff, "{ A[x] -> [x + 1] }");
-	isl_aff_free(aff);
-	if (equal < 0)
-		return isl_stat_error;
+	return r;
+}
+
+/* Sets used in test_scan_triangular, along with the number
+ * of integer points they contain.
+ * The bounds on each variable are given by constraints
+ * with a unit coefficient on that variable, such that
+ * the points can be enumerated without solving any LPs,
+ * except in the last two cases.
+ */
+static struct {
+	const char *set;
+	int count;
+} scan_triangular_tests[] = {
+	{ "{ [i, j] : 0 <= i <= 9 and 0 <= j <= i }", 55 },
+	{ "{ [i, j, k] : 0 <= i < 3 and 0 <= j < 4 and 0 <= k < 5 }", 60 },
+	{ "{ [i, j] : 0 <= i <= 10 and i - 5 <= j <= 5 - i }", 36 },
+	{ "{ [i, j] : 0 <= i <= 10 and j = 2i + 1 }", 11 },
+	{ "[N] -> { [i] : 0 <= N <= 3 and -N <= i <= N }", 16 },
+	{ "{ [i, j] : 0 <= i <= 10 and 0 <= j <= 10 and 1 = 0 }", 0 },
+	{ "{ [i, j] : 0 <= i <= 10 and 0 <= 2j <= i }", 36 },
+	{ "{ [i, j] : 0 <= i, j and i + j <= 10 and i = 2 * floor(i/2) }",
+	  36 },
+};
+
+/* isl_set_foreach_point callback that adds "pnt" to the set
+ * pointed to by "user".
+ */
+static isl_stat add_point_to_set(__isl_take isl_point *pnt, void *user)
+{
+	isl_set **set = user;
+
+	*set = isl_set_union(*set, isl_set_from_point(pnt));
 
 	return isl_stat_ok;
 }
 
-/* Check that affine expressions get normalized on addition/subtraction.
- * In particular, check that (final) unused integer divisions get removed
- * such that an expression derived from expressions with integer divisions
- * is found to be obviously equal to one that is created directly.
+/* Check that the integer points of the sets in scan_triangular_tests
+ * are enumerated correctly, by checking the number of points
+ * and by checking that the union of the enumerated points
+ * is equal to the original set.
  */
-static isl_stat test_aff_normalize(isl_ctx *ctx)
+static int test_scan_triangular(isl_ctx *ctx)
 {
-	isl_aff *aff, *aff2;
-	isl_stat ok;
+	int i;
 
-	aff = isl_aff_read_from_str(ctx, "{ [x] -> [x//2] }");
-	aff2 = isl_aff_read_from_str(ctx, "{ [x] -> [1 + x//2] }");
-	aff = isl_aff_sub(aff2, aff);
-	ok = aff_check_plain_equal(aff, "{ [x] -> [1] }");
-	isl_aff_free(aff);
+	for (i = 0; i < ARRAY_SIZE(scan_triangular_tests); ++i) {
+		isl_set *set, *points;
+		isl_val *count;
+		isl_stat r;
+		isl_bool equal;
+		int ok;
+
+		set = isl_set_read_from_str(ctx, scan_triangular_tests[i].set);
+		count = isl_set_count_val(set);
+		ok = isl_val_cmp_si(count, scan_triangular_tests[i].count) == 0;
+		isl_val_free(count);
+		points = isl_set_empty(isl_set_get_space(set));
+		r = isl_set_foreach_point(set, &add_point_to_set, &points);
+		equal = isl_set_is_equal(set, points);
+		isl_set_free(points);
+		isl_set_free(set);
+		if (r < 0 || equal < 0)
+			return -1;
+		if (!ok || !equal)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected points", return -1);
+	}
 
-	return ok;
+	return 0;
 }
 
-int test_aff(isl_ctx *ctx)
+/* Copy "mat" through an array of longs using isl_mat_get_elements_si and
+ * isl_mat_from_elements_si.
+ */
+static __isl_give isl_mat *copy_mat_elements(__isl_take isl_mat *mat)
+{
+	isl_ctx *ctx;
+	isl_size n_row, n_col;
+	long *data;
+	isl_mat *copy;
+
+	n_row = isl_mat_rows(mat);
+	n_col = isl_mat_cols(mat);
+	if (n_row < 0 || n_col < 0)
+		return isl_mat_free(mat);
+	ctx = isl_mat_get_ctx(mat);
+	data = isl_alloc_array(ctx, long, n_row * n_col + 1);
+	if (!data || isl_mat_get_elements_si(mat, data) < 0)
+		copy = NULL;
+	else
+		copy = isl_mat_from_elements_si(ctx, n_row, n_col, data);
+	free(data);
+	isl_mat_free(mat);
+	return copy;
+}
+
+/* Check that a basic set can be reconstructed from its constraints
+ * after passing them through arrays of longs.
+ * Also check that elements that do not fit in a long are rejected.
+ */
+static int test_mat_elements(isl_ctx *ctx)
 {
 	const char *str;
-	isl_set *set;
-	isl_space *space;
-	isl_local_space *ls;
-	isl_aff *aff;
-	int zero;
-	isl_stat equal;
+	isl_basic_set *bset, *bset2;
+	isl_mat *eq, *ineq;
+	long data[1];
+	int on_error;
+	isl_bool equal;
+	isl_stat r;
 
-	if (test_upa(ctx) < 0)
-		return -1;
-	if (test_bin_aff(ctx) < 0)
-		return -1;
-	if (test_bin_pw_aff(ctx) < 0)
-		return -1;
-	if (test_upma_test(ctx) < 0)
-		return -1;
-	if (test_bin_upma(ctx) < 0)
-		return -1;
-	if (test_bin_upma_fail(ctx) < 0)
-		return -1;
-	if (test_upma_uset(ctx) < 0)
-		return -1;
-	if (test_un_mpa(ctx) < 0)
-		return -1;
-	if (test_bin_mpa(ctx) < 0)
-		return -1;
-	if (test_un_mupa(ctx) < 0)
-		return -1;
-	if (test_bin_mupa(ctx) < 0)
-		return -1;
-	if (test_mupa_set(ctx) < 0)
-		return -1;
-	if (test_mupa_uset(ctx) < 0)
-		return -1;
-	if (test_mupa_ma(ctx) < 0)
-		return -1;
-	if (test_mupa_pa(ctx) < 0)
-		return -1;
-	if (test_mupa_pma(ctx) < 0)
+	str = "[n] -> { [i, j] : exists (e : i = 2j and j = 3e and "
+		"0 <= j <= n) }";
+	bset = isl_basic_set_read_from_str(ctx, str);
+	eq = isl_basic_set_equalities_matrix(bset, isl_dim_param,
+				isl_dim_set, isl_dim_div, isl_dim_cst);
+	ineq = isl_basic_set_inequalities_matrix(bset, isl_dim_param,
+				isl_dim_set, isl_dim_div, isl_dim_cst);
+	eq = copy_mat_elements(eq);
+	ineq = copy_mat_elements(ineq);
+	bset2 = isl_basic_set_from_constraint_matrices(
+				isl_basic_set_get_space(bset), eq, ineq,
+				isl_dim_param, isl_dim_set, isl_dim_div,
+				isl_dim_cst);
+	equal = isl_basic_set_is_equal(bset, bset2);
+	isl_basic_set_free(bset);
+	isl_basic_set_free(bset2);
+	if (equal < 0)
 		return -1;
-	if (test_mupa_upma(ctx) < 0)
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected constraints", return -1);
+
+	eq = isl_mat_alloc(ctx, 1, 1);
+	eq = isl_mat_set_element_val(eq, 0, 0,
+			isl_val_read_from_str(ctx, "100000000000000000000"));
+	if (!eq)
 		return -1;
+	on_error = isl_options_get_on_error(ctx);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+	r = isl_mat_get_elements_si(eq, data);
+	isl_ctx_reset_error(ctx);
+	isl_options_set_on_error(ctx, on_error);
+	isl_mat_free(eq);
+	if (r >= 0)
+		isl_die(ctx, isl_error_unknown,
+			"large element not rejected", return -1);
 
-	space = isl_space_set_alloc(ctx, 0, 1);
-	ls = isl_local_space_from_space(space);
-	aff = isl_aff_zero_on_domain(ls);
+	return 0;
+}
 
-	aff = isl_aff_add_coefficient_si(aff, isl_dim_in, 0, 1);
-	aff = isl_aff_scale_down_ui(aff, 3);
-	aff = isl_aff_floor(aff);
-	aff = isl_aff_add_coefficient_si(aff, isl_dim_in, 0, 1);
-	aff = isl_aff_scale_down_ui(aff, 2);
-	aff = isl_aff_floor(aff);
-	aff = isl_aff_add_coefficient_si(aff, isl_dim_in, 0, 1);
+/* Fill "mat" with pseudo-random small coefficients derived from "seed",
+ * about half of which are zero.
+ * If "dup" is set, then make the last row equal to the first,
+ * such that "mat" does not have full row rank.
+ */
+static __isl_give isl_mat *fill_hermite_mat(__isl_take isl_mat *mat,
+	unsigned *seed, int dup)
+{
+	int i, j;
+	isl_size n_row, n_col;
+
+	n_row = isl_mat_rows(mat);
+	n_col = isl_mat_cols(mat);
+	if (n_row < 0 || n_col < 0)
+		return isl_mat_free(mat);
+	for (i = 0; i < n_row; ++i) {
+		for (j = 0; j < n_col; ++j) {
+			int v;
+
+			*seed = *seed * 1103515245 + 12345;
+			v = (*seed >> 16) % 41 - 20;
+			if (dup && i == n_row - 1 && n_row > 1)
+				v = 0;
+			else if ((*seed >> 8) & 1)
+				v = 0;
+			mat = isl_mat_set_element_si(mat, i, j, v);
+		}
+	}
+	if (dup && n_row > 1)
+		for (j = 0; j < n_col; ++j) {
+			isl_val *v = isl_mat_get_element_val(mat, 0, j);
+			mat = isl_mat_set_element_val(mat, n_row - 1, j, v);
+		}
+	return mat;
+}
 
-	str = "{ [10] }";
-	set = isl_set_read_from_str(ctx, str);
-	aff = isl_aff_gist(aff, set);
+/* Check that computing the Hermite normal form using modular arithmetic
+ * produces the same result as the exact computation,
+ * which is performed here by also requesting the unimodular matrix.
+ * The matrices that do not have full row rank are handled
+ * by the exact computation.
+ */
+static int test_hermite_modular(isl_ctx *ctx)
+{
+	int n_row, extra, neg, dup;
+	unsigned seed = 1;
+
+	for (n_row = 1; n_row <= 9; ++n_row)
+	for (extra = 0; extra <= 3; ++extra)
+	for (neg = 0; neg <= 1; ++neg)
+	for (dup = 0; dup <= 1; ++dup) {
+		isl_mat *M, *H1, *H2, *U;
+		isl_bool equal;
 
-	aff = isl_aff_add_constant_si(aff, -16);
-	zero = isl_aff_plain_is_zero(aff);
-	isl_aff_free(aff);
+		M = isl_mat_alloc(ctx, n_row, n_row + extra);
+		M = fill_hermite_mat(M, &seed, dup);
+		H1 = isl_mat_left_hermite(isl_mat_copy(M), neg, &U, NULL);
+		isl_mat_free(U);
+		H2 = isl_mat_left_hermite_modular(M, neg);
+		equal = isl_mat_is_equal(H1, H2);
+		isl_mat_free(H1);
+		isl_mat_free(H2);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"modular Hermite normal form differs",
+				return -1);
+	}
 
-	if (zero < 0)
-		return -1;
-	if (!zero)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+	return 0;
+}
 
-	aff = isl_aff_read_from_str(ctx, "{ [-1] }");
-	aff = isl_aff_scale_down_ui(aff, 64);
-	aff = isl_aff_floor(aff);
-	equal = aff_check_plain_equal(aff, "{ [-1] }");
-	isl_aff_free(aff);
-	if (equal < 0)
-		return -1;
+/* Inputs for test_gbr_threads.
+ * "set" is a bounded basic set for which generalized basis reduction
+ * needs to choose between rounding down and rounding up.
+ * "empty" is set if "set" has no integer points.
+ */
+static struct {
+	const char *set;
+	int empty;
+} gbr_threads_tests[] = {
+	{ "{ [a, b, c, d] : 0 <= 7a - 11b + 3c <= 2 and "
+		"0 <= 5b - 13c + 2d <= 3 and 0 <= 3a + 4b - 9d <= 4 and "
+		"-100 <= a, b, c, d <= 100 }", 0 },
+	{ "{ [a, b, c, d] : 1 <= 6a - 9b + 3c <= 2 and "
+		"0 <= 5b - 13c + 2d <= 3 and 0 <= 3a + 4b - 9d <= 4 and "
+		"-100 <= a, b, c, d <= 100 }", 1 },
+	{ "{ [a, b, c, d, e] : 0 <= 17a - 23b <= 5 and "
+		"0 <= 19c - 7d + 5e <= 3 and 11 <= 13a + 29e <= 14 and "
+		"0 <= 2b + 3c - 31d <= 40 and -50 <= a, b, c, d, e <= 50 }", 0 },
+};
 
-	if (test_aff_set_tuple_id(ctx) < 0)
-		return -1;
-	if (test_aff_normalize(ctx) < 0)
+/* Check that computing sample points of the sets in gbr_threads_tests
+ * with the gbr_threads option set to two produces the expected results.
+ */
+static int test_gbr_threads(isl_ctx *ctx)
+{
+	int i;
+	int gbr_threads;
+
+	gbr_threads = isl_options_get_gbr_threads(ctx);
+	isl_options_set_gbr_threads(ctx, 2);
+	for (i = 0; i < ARRAY_SIZE(gbr_threads_tests); ++i) {
+		isl_basic_set *bset, *sample;
+		isl_point *pnt;
+		isl_bool empty, ok;
+
+		bset = isl_basic_set_read_from_str(ctx,
+						gbr_threads_tests[i].set);
+		pnt = isl_basic_set_sample_point(isl_basic_set_copy(bset));
+		empty = isl_point_is_void(pnt);
+		ok = isl_bool_true;
+		if (empty == isl_bool_false) {
+			sample = isl_basic_set_from_point(isl_point_copy(pnt));
+			ok = isl_basic_set_is_subset(sample, bset);
+			isl_basic_set_free(sample);
+		}
+		isl_point_free(pnt);
+		isl_basic_set_free(bset);
+		if (empty < 0 || ok < 0)
+			break;
+		if (empty != gbr_threads_tests[i].empty || !ok) {
+			isl_options_set_gbr_threads(ctx, gbr_threads);
+			isl_die(ctx, isl_error_unknown, "unexpected sample",
+				return -1);
+		}
+	}
+	isl_options_set_gbr_threads(ctx, gbr_threads);
+	if (i < ARRAY_SIZE(gbr_threads_tests))
 		return -1;
 
 	return 0;
 }
 
-/* Inputs for isl_set_bind tests.
- * "set" is the input set.
- * "tuple" is the binding tuple.
- * "res" is the expected result.
+/* Inputs for test_empty_stages.
+ * "set" is a basic set that is tested for emptiness,
+ * "empty" is the expected result and
+ * "stage" is the most expensive stage of the emptiness checks
+ * that is expected to be needed while reading and testing the set:
+ * 0 for bounds on individual variables,
+ * 1 for a candidate point and 2 for a full sample computation.
  */
-static
-struct {
+static struct {
 	const char *set;
-	const char *tuple;
-	const char *res;
-} bind_set_tests[] = {
-	{ "{ A[M, N] : M mod 2 = 0 and N mod 8 = 3 }",
-	  "{ A[M, N] }",
-	  "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }" },
-	{ "{ B[N, M] : M mod 2 = 0 and N mod 8 = 3 }",
-	  "{ B[N, M] }",
-	  "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }" },
-	{ "[M] -> { C[N] : M mod 2 = 0 and N mod 8 = 3 }",
-	  "{ C[N] }",
-	  "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }" },
-	{ "[M] -> { D[x, N] : x mod 2 = 0 and N mod 8 = 3 and M >= 0 }",
-	  "{ D[M, N] }",
-	  "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 and M >= 0 }" },
+	int empty;
+	int stage;
+} empty_stages_tests[] = {
+	{ "{ [x, y] : 0 <= x <= 3 and 0 <= y <= 3 and x + y >= 7 }", 1, 0 },
+	{ "{ [x, y] : 0 <= x <= 3 and 0 <= y <= 3 and x - y >= 4 }", 1, 0 },
+	{ "{ [x, y] : 0 <= x <= 3 and 0 <= y <= 3 and x + y <= 5 }", 0, 1 },
+	{ "{ [x, y] : 2 <= x <= 3 and y >= -5 and x - y >= 1 }", 0, 1 },
+	{ "{ [x, y, z] : 0 <= x, y, z <= 10 and x + y >= 5 and "
+		"x + y <= z - 8 }", 1, 2 },
 };
 
-/* Perform basic isl_set_bind tests.
+/* Check that the emptiness tests on the sets in empty_stages_tests
+ * produce the expected results and are decided by the expected stage.
+ * Emptiness tests performed while reading the set are taken
+ * into account as well.
+ * Since reading the set may already cache a sample point,
+ * the candidate point stage is not required to be reached.
+ */
+static int test_empty_stages(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(empty_stages_tests); ++i) {
+		isl_basic_set *bset;
+		isl_bool empty;
+		struct isl_stats stats;
+		long decided[3];
+
+		isl_ctx_reset_stats(ctx);
+		bset = isl_basic_set_read_from_str(ctx,
+						empty_stages_tests[i].set);
+		empty = isl_basic_set_is_empty(bset);
+		isl_basic_set_free(bset);
+		if (empty < 0 || isl_ctx_get_stats(ctx, &stats) < 0)
+			return -1;
+		if (empty != empty_stages_tests[i].empty)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected emptiness result", return -1);
+		decided[0] = stats.empty_bounds_decided;
+		decided[1] = stats.empty_point_decided;
+		decided[2] = stats.empty_sample_decided;
+		if ((empty_stages_tests[i].stage != 1 &&
+		     decided[empty_stages_tests[i].stage] <= 0) ||
+		    (empty_stages_tests[i].stage < 2 && decided[2] != 0))
+			isl_die(ctx, isl_error_unknown,
+				"emptiness decided by unexpected stage",
+				return -1);
+	}
+
+	return 0;
+}
+
+/* Check that the rows listed for variable "var" in "list"
+ * between "start" and "end" are exactly the "n_row" rows
+ * in "row" that involve variable "var", in increasing order.
+ * If "known" is set, then the rows are explicit representations
+ * of local variables, with the denominator in the first position, and
+ * only those with an explicit representation should be listed.
  */
-static isl_stat test_bind_set(isl_ctx *ctx)
+static int check_var_index_list(isl_ctx *ctx, int n_row, isl_int **row,
+	int known, int var, int *list, int start, int end)
 {
 	int i;
 
-	for (i = 0; i < ARRAY_SIZE(bind_set_tests); ++i) {
-		const char *str;
-		isl_set *set;
-		isl_multi_id *tuple;
-		isl_stat r;
+	for (i = 0; i < n_row; ++i) {
+		if (known && isl_int_is_zero(row[i][0]))
+			continue;
+		if (isl_int_is_zero(row[i][known + 1 + var]))
+			continue;
+		if (start >= end || list[start] != i)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected variable index", return -1);
+		++start;
+	}
+	if (start != end)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected variable index", return -1);
 
-		set = isl_set_read_from_str(ctx, bind_set_tests[i].set);
-		str = bind_set_tests[i].tuple;
-		tuple = isl_multi_id_read_from_str(ctx, str);
-		set = isl_set_bind(set, tuple);
-		r = set_check_equal(set, bind_set_tests[i].res);
-		isl_set_free(set);
-		if (r < 0)
-			return isl_stat_error;
+	return 0;
+}
+
+/* Check that the transposed sparse index of the constraints
+ * of a basic map lists the constraints and the explicit representations
+ * of local variables that involve each variable.
+ */
+static int test_var_index(isl_ctx *ctx)
+{
+	int i;
+	const char *str;
+	isl_size total;
+	isl_basic_map *bmap;
+	struct isl_basic_map_var_index *index;
+
+	str = "[n] -> { [x, y] -> [z] : exists (e = floor(x/3), "
+		"f = floor((e + z)/2): x + y >= n and z >= 2y + e and "
+		"y <= 5 and x - z >= -3 and f <= n) }";
+	bmap = isl_basic_map_read_from_str(ctx, str);
+	total = isl_basic_map_dim(bmap, isl_dim_all);
+	if (total < 0)
+		index = NULL;
+	else
+		index = isl_basic_map_var_index_alloc(bmap, 1, total - 1);
+	if (!index) {
+		isl_basic_map_free(bmap);
+		return -1;
+	}
+	for (i = 0; i < total - 1; ++i) {
+		if (check_var_index_list(ctx, bmap->n_eq, bmap->eq, 0, 1 + i,
+			    index->eq, index->eq_start[i],
+			    index->eq_start[i + 1]) < 0 ||
+		    check_var_index_list(ctx, bmap->n_ineq, bmap->ineq, 0,
+			    1 + i, index->ineq, index->ineq_start[i],
+			    index->ineq_start[i + 1]) < 0 ||
+		    check_var_index_list(ctx, bmap->n_div, bmap->div, 1,
+			    1 + i, index->div, index->div_start[i],
+			    index->div_start[i + 1]) < 0)
+			break;
 	}
+	isl_basic_map_var_index_free(index);
+	isl_basic_map_free(bmap);
 
-	return isl_stat_ok;
+	return i < total - 1 ? -1 : 0;
 }
 
-/* Inputs for isl_map_bind_domain tests.
- * "map" is the input map.
- * "tuple" is the binding tuple.
- * "res" is the expected result.
+/* Internal data structure for test_every_constraint.
+ * "ref" contains the constraints in the order in which they are expected
+ * to be visited and "n" is the number of constraints visited so far.
+ * "kept" collects references to every other constraint.
  */
-struct {
-	const char *map;
-	const char *tuple;
-	const char *res;
-} bind_map_domain_tests[] = {
-	{ "{ A[M, N] -> [M + floor(N/2)] }",
-	  "{ A[M, N] }",
-	  "[M, N] -> { [M + floor(N/2)] }" },
-	{ "{ B[N, M] -> [M + floor(N/2)] }",
-	  "{ B[N, M] }",
-	  "[N, M] -> { [M + floor(N/2)] }" },
-	{ "[M] -> { C[N] -> [M + floor(N/2)] }",
-	  "{ C[N] }",
-	  "[M, N] -> { [M + floor(N/2)] }" },
-	{ "[M] -> { C[x, N] -> [x + floor(N/2)] }",
-	  "{ C[M, N] }",
-	  "[M, N] -> { [M + floor(N/2)] }" },
-	{ "[M] -> { C[x, N] -> [M + floor(N/2)] }",
-	  "{ C[M, N] }",
-	  "[M, N] -> { [M + floor(N/2)] }" },
-	{ "[A, M] -> { C[N, x] -> [x + floor(N/2)] }",
-	  "{ C[N, M] }",
-	  "[A, N, M] -> { [M + floor(N/2)] }" },
+struct isl_test_every_data {
+	isl_constraint_list *ref;
+	int n;
+	isl_constraint_list *kept;
 };
 
-/* Perform basic isl_map_bind_domain tests.
+/* Are "c1" and "c2" the same constraint?
  */
-static isl_stat test_bind_map_domain(isl_ctx *ctx)
+static isl_bool constraint_is_equal(__isl_keep isl_constraint *c1,
+	__isl_keep isl_constraint *c2)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(bind_map_domain_tests); ++i) {
-		const char *str;
-		isl_map *map;
-		isl_set *set;
-		isl_multi_id *tuple;
-		isl_stat r;
+	isl_bool eq1, eq2, equal;
+	isl_aff *aff1, *aff2;
 
-		str = bind_map_domain_tests[i].map;
-		map = isl_map_read_from_str(ctx, str);
-		str = bind_map_domain_tests[i].tuple;
-		tuple = isl_multi_id_read_from_str(ctx, str);
-		set = isl_map_bind_domain(map, tuple);
-		str = bind_map_domain_tests[i].res;
-		r = set_check_equal(set, str);
-		isl_set_free(set);
-		if (r < 0)
-			return isl_stat_error;
-	}
+	eq1 = isl_constraint_is_equality(c1);
+	eq2 = isl_constraint_is_equality(c2);
+	if (eq1 < 0 || eq2 < 0)
+		return isl_bool_error;
+	if (eq1 != eq2)
+		return isl_bool_false;
+	aff1 = isl_constraint_get_aff(c1);
+	aff2 = isl_constraint_get_aff(c2);
+	equal = isl_aff_plain_is_equal(aff1, aff2);
+	isl_aff_free(aff1);
+	isl_aff_free(aff2);
 
-	return isl_stat_ok;
+	return equal;
 }
 
-/* Inputs for isl_union_map_bind_range tests.
- * "map" is the input union map.
- * "tuple" is the binding tuple.
- * "res" is the expected result.
+/* isl_basic_set_every_constraint callback that checks that "c"
+ * is the next expected constraint and that keeps a reference
+ * to every other constraint.
  */
-struct {
-	const char *map;
-	const char *tuple;
-	const char *res;
-} bind_umap_range_tests[] = {
-	{ "{ B[N, M] -> A[M, N] : M mod 2 = 0 and N mod 8 = 3 }",
-	  "{ A[M, N] }",
-	  "[M, N] -> { B[N, M] : M mod 2 = 0 and N mod 8 = 3 }" },
-	{ "{ B[N, M] -> A[M, N] : M mod 2 = 0 and N mod 8 = 3 }",
-	  "{ B[M, N] }",
-	  "{ }" },
-	{ "{ A[] -> B[]; C[] -> D[]; E[] -> B[] }",
-	  "{ B[] }",
-	  "{ A[]; E[] }" },
-};
+static isl_bool check_every_constraint(__isl_keep isl_constraint *c,
+	void *user)
+{
+	struct isl_test_every_data *data = user;
+	isl_constraint *ref;
+	isl_bool equal;
 
-/* Perform basic isl_union_map_bind_range tests.
+	ref = isl_constraint_list_get_at(data->ref, data->n);
+	equal = constraint_is_equal(c, ref);
+	isl_constraint_free(ref);
+	if (data->n++ % 2 == 0)
+		data->kept = isl_constraint_list_add(data->kept,
+						isl_constraint_copy(c));
+	if (!data->kept)
+		return isl_bool_error;
+
+	return equal;
+}
+
+/* isl_map_every_basic_map callback that only succeeds on
+ * the first basic map, counting the calls in "user".
  */
-static isl_stat test_bind_umap_range(isl_ctx *ctx)
+static isl_bool only_first(__isl_keep isl_basic_map *bmap, void *user)
 {
-	int i;
+	int *n = user;
 
-	for (i = 0; i < ARRAY_SIZE(bind_umap_range_tests); ++i) {
-		const char *str;
-		isl_union_map *umap;
-		isl_union_set *uset;
-		isl_multi_id *tuple;
-		isl_stat r;
+	return isl_bool_ok((*n)++ == 0);
+}
 
-		str = bind_umap_range_tests[i].map;
-		umap = isl_union_map_read_from_str(ctx, str);
-		str = bind_umap_range_tests[i].tuple;
-		tuple = isl_multi_id_read_from_str(ctx, str);
-		uset = isl_union_map_bind_range(umap, tuple);
-		str = bind_umap_range_tests[i].res;
-		r = uset_check_equal(uset, str);
-		isl_union_set_free(uset);
-		if (r < 0)
-			return isl_stat_error;
+/* Check that isl_basic_set_every_constraint visits the same constraints
+ * in the same order as isl_basic_set_foreach_constraint
+ * (through isl_basic_set_get_constraint_list), even if
+ * the callback keeps references to some of them, and that
+ * isl_map_every_basic_map stops as soon as the callback fails.
+ */
+static int test_every(isl_ctx *ctx)
+{
+	int i, n;
+	isl_size n_constraint;
+	isl_bool ok;
+	isl_basic_set *bset;
+	isl_map *map;
+	struct isl_test_every_data data = { NULL };
+
+	bset = isl_basic_set_read_from_str(ctx, "[N] -> { [i, j, k] : "
+		"0 <= i <= N and 0 <= j < i and k = i + j and "
+		"exists (e : 2e = i + N) }");
+	data.ref = isl_basic_set_get_constraint_list(bset);
+	data.kept = isl_constraint_list_alloc(ctx, 0);
+	ok = isl_basic_set_every_constraint(bset, &check_every_constraint,
+					&data);
+	n_constraint = isl_basic_set_n_constraint(bset);
+	isl_basic_set_free(bset);
+	if (ok >= 0 && n_constraint >= 0 &&
+	    (!ok || data.n != n_constraint))
+		isl_die(ctx, isl_error_unknown,
+			"unexpected constraints", ok = isl_bool_error);
+	for (i = 0; ok >= 0 && 2 * i < data.n; ++i) {
+		isl_constraint *c1, *c2;
+
+		c1 = isl_constraint_list_get_at(data.ref, 2 * i);
+		c2 = isl_constraint_list_get_at(data.kept, i);
+		ok = constraint_is_equal(c1, c2);
+		isl_constraint_free(c1);
+		isl_constraint_free(c2);
+		if (ok == isl_bool_false)
+			isl_die(ctx, isl_error_unknown,
+				"kept constraint modified", ok = isl_bool_error);
 	}
+	isl_constraint_list_free(data.ref);
+	isl_constraint_list_free(data.kept);
+	if (ok < 0 || n_constraint < 0)
+		return -1;
 
-	return isl_stat_ok;
+	map = isl_map_read_from_str(ctx, "{ [i] -> [j] : j = i or j = 2i or "
+		"j = 3i }");
+	n = 0;
+	ok = isl_map_every_basic_map(map, &only_first, &n);
+	isl_map_free(map);
+	if (ok < 0)
+		return -1;
+	if (ok || n != 2)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result of isl_map_every_basic_map",
+			return -1);
+
+	return 0;
 }
 
-/* Inputs for isl_pw_multi_aff_bind_domain tests.
- * "pma" is the input expression.
- * "tuple" is the binding tuple.
- * "res" is the expected result.
+/* Check that duplicate disjuncts are removed by isl_set_normalize and
+ * that the normalized sets are compared correctly
+ * by isl_set_plain_is_equal and isl_set_get_hash.
  */
-struct {
-	const char *pma;
-	const char *tuple;
-	const char *res;
-} bind_pma_domain_tests[] = {
-	{ "{ A[M, N] -> [M + floor(N/2)] }",
-	  "{ A[M, N] }",
-	  "[M, N] -> { [M + floor(N/2)] }" },
-	{ "{ B[N, M] -> [M + floor(N/2)] }",
-	  "{ B[N, M] }",
-	  "[N, M] -> { [M + floor(N/2)] }" },
-	{ "[M] -> { C[N] -> [M + floor(N/2)] }",
-	  "{ C[N] }",
-	  "[M, N] -> { [M + floor(N/2)] }" },
-	{ "[M] -> { C[x, N] -> [x + floor(N/2)] }",
-	  "{ C[M, N] }",
-	  "[M, N] -> { [M + floor(N/2)] }" },
-	{ "[M] -> { C[x, N] -> [M + floor(N/2)] }",
-	  "{ C[M, N] }",
-	  "[M, N] -> { [M + floor(N/2)] }" },
-	{ "[A, M] -> { C[N, x] -> [x + floor(N/2)] }",
-	  "{ C[N, M] }",
-	  "[A, N, M] -> { [M + floor(N/2)] }" },
-};
+static int test_normalize_duplicates(isl_ctx *ctx)
+{
+	int i;
+	isl_bool equal, equal2;
+	isl_size n;
+	isl_set *set, *set2, *set3;
+	const char *str[] = {
+		"{ [x, y] : 0 <= x <= 10 and y = 2x }",
+		"{ [x, y] : x >= 20 and y <= x }",
+		"{ [x, y] : x = 5 and 0 <= y <= 3 }",
+	};
+
+	set = isl_set_empty(isl_space_set_alloc(ctx, 0, 2));
+	for (i = 0; i < 9; ++i)
+		set = isl_set_union_disjoint(set,
+				isl_set_read_from_str(ctx, str[(i * 2) % 3]));
+	set2 = isl_set_empty(isl_space_set_alloc(ctx, 0, 2));
+	for (i = 2; i >= 0; --i)
+		set2 = isl_set_union_disjoint(set2,
+				isl_set_read_from_str(ctx, str[i]));
+	set3 = isl_set_copy(set2);
+	set3 = isl_set_union_disjoint(set3,
+		isl_set_read_from_str(ctx, "{ [x, y] : x = 5 and 0 <= y <= 4 }"));
+
+	set = isl_set_normalize(set);
+	n = isl_set_n_basic_set(set);
+	equal = isl_set_plain_is_equal(set, set2);
+	equal2 = isl_set_plain_is_equal(set2, set3);
+	if (n >= 0 && equal >= 0 && equal2 >= 0 &&
+	    (n != 3 || !equal || equal2 ||
+	     isl_set_get_hash(set) != isl_set_get_hash(set2)))
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result of normalization", n = isl_size_error);
+	isl_set_free(set);
+	isl_set_free(set2);
+	isl_set_free(set3);
+
+	if (n < 0 || equal < 0 || equal2 < 0)
+		return -1;
+	return 0;
+}
+
+/* Check that isl_basic_set_from_int64_constraints constructs
+ * the expected basic set, including for coefficients
+ * that do not fit in 32 bits.
+ */
+static int test_from_int64_constraints(isl_ctx *ctx)
+{
+	isl_bool equal;
+	isl_space *space;
+	isl_basic_set *bset1, *bset2;
+	const char *str;
+	int64_t eq[] = { 0, 0, 2, -1, 1 };
+	int64_t ineq[] = {
+		0, 0, 1, 0, 0,
+		INT64_C(8589934592), -1, -1, 0, 0,
+		-3, 0, 0, 1, 0,
+	};
+
+	str = "[n] -> { [x, y] : exists (e : y = 2x + e) and x >= 0 and "
+		"x <= 8589934592 - n and y >= 3 }";
+	bset2 = isl_basic_set_read_from_str(ctx, str);
+	space = isl_basic_set_get_space(bset2);
+	bset1 = isl_basic_set_from_int64_constraints(space, 1, 1, eq, 3, ineq);
+	equal = isl_basic_set_is_equal(bset1, bset2);
+	isl_basic_set_free(bset1);
+	isl_basic_set_free(bset2);
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result of construction", return -1);
+
+	return 0;
+}
+
+int test_sample(isl_ctx *ctx)
+{
+	const char *str;
+	isl_basic_set *bset1, *bset2;
+	int empty, subset;
+
+	str = "{ [a, b, c, d, e, f, g, h, i, j, k] : "
+	    "3i >= 1073741823b - c - 1073741823e + f and c >= 0 and "
+	    "3i >= -1 + 3221225466b + c + d - 3221225466e - f and "
+	    "2e >= a - b and 3e <= 2a and 3k <= -a and f <= -1 + a and "
+	    "3i <= 4 - a + 4b + 2c - e - 2f and 3k <= -a + c - f and "
+	    "3h >= -2 + a and 3g >= -3 - a and 3k >= -2 - a and "
+	    "3i >= -2 - a - 2c + 3e + 2f and 3h <= a + c - f and "
+	    "3h >= a + 2147483646b + 2c - 2147483646e - 2f and "
+	    "3g <= -1 - a and 3i <= 1 + c + d - f and a <= 1073741823 and "
+	    "f >= 1 - a + 1073741822b + c + d - 1073741822e and "
+	    "3i >= 1 + 2b - 2c + e + 2f + 3g and "
+	    "1073741822f <= 1073741822 - a + 1073741821b + 1073741822c +"
+		"d - 1073741821e and "
+	    "3j <= 3 - a + 3b and 3g <= -2 - 2b + c + d - e - f and "
+	    "3j >= 1 - a + b + 2e and "
+	    "3f >= -3 + a + 3221225462b + 3c + d - 3221225465e and "
+	    "3i <= 4 - a + 4b - e and "
+	    "f <= 1073741822 + 1073741822b - 1073741822e and 3h <= a and "
+	    "f >= 0 and 2e <= 4 - a + 5b - d and 2e <= a - b + d and "
+	    "c <= -1 + a and 3i >= -2 - a + 3e and "
+	    "1073741822e <= 1073741823 - a + 1073741822b + c and "
+	    "3g >= -4 + 3221225464b + 3c + d - 3221225467e - 3f and "
+	    "3i >= -1 + 3221225466b + 3c + d - 3221225466e - 3f and "
+	    "1073741823e >= 1 + 1073741823b - d and "
+	    "3i >= 1073741823b + c - 1073741823e - f and "
+	    "3i >= 1 + 2b + e + 3g }";
+	bset1 = isl_basic_set_read_from_str(ctx, str);
+	bset2 = isl_basic_set_sample(isl_basic_set_copy(bset1));
+	empty = isl_basic_set_is_empty(bset2);
+	subset = isl_basic_set_is_subset(bset2, bset1);
+	isl_basic_set_free(bset1);
+	isl_basic_set_free(bset2);
+	if (empty < 0 || subset < 0)
+		return -1;
+	if (empty)
+		isl_die(ctx, isl_error_unknown, "point not found", return -1);
+	if (!subset)
+		isl_die(ctx, isl_error_unknown, "bad point found", return -1);
 
-/* Perform basic isl_pw_multi_aff_bind_domain tests.
+	return 0;
+}
+
+/* Perform a projection on a basic set that is known to be empty
+ * but that has not been assigned a canonical representation.
+ * Earlier versions of isl would run into a stack overflow
+ * on this example.
  */
-static isl_stat test_bind_pma_domain(isl_ctx *ctx)
+static int test_empty_projection(isl_ctx *ctx)
 {
-	int i;
+	const char *str;
+	isl_bool empty;
+	isl_basic_set *bset;
 
-	for (i = 0; i < ARRAY_SIZE(bind_pma_domain_tests); ++i) {
-		const char *str;
-		isl_pw_multi_aff *pma;
-		isl_multi_id *tuple;
-		isl_stat r;
+	str = "{ [a, b, c, d, e, f, g, h] : 5f = 1 + 4a - b + 5c - d - 2e and "
+		"3h = 2 + b + c and 14c >= 9 - 3a + 25b and "
+		"4c <= 50 - 3a + 23b and 6b <= -39 + a and "
+		"9g >= -6 + 3a + b + c and e < a + b - 2d and "
+		"7d >= -5 + 2a + 2b and 5g >= -14 + a - 4b + d + 2e and "
+		"9g <= -28 - 5b - 2c + 3d + 6e }";
+	bset = isl_basic_set_read_from_str(ctx, str);
+	empty = isl_basic_set_is_empty(bset);
+	bset = isl_basic_set_params(bset);
+	isl_basic_set_free(bset);
 
-		str = bind_pma_domain_tests[i].pma;
-		pma = isl_pw_multi_aff_read_from_str(ctx, str);
-		str = bind_pma_domain_tests[i].tuple;
-		tuple = isl_multi_id_read_from_str(ctx, str);
-		pma = isl_pw_multi_aff_bind_domain(pma, tuple);
-		str = bind_pma_domain_tests[i].res;
-		r = pw_multi_aff_check_plain_equal(pma, str);
-		isl_pw_multi_aff_free(pma);
-		if (r < 0)
-			return isl_stat_error;
-	}
+	if (empty < 0)
+		return -1;
 
-	return isl_stat_ok;
+	return 0;
 }
 
-/* Inputs for isl_pw_multi_aff_bind_domain_wrapped_domain tests.
- * "pma" is the input expression.
- * "tuple" is the binding tuple.
- * "res" is the expected result.
- */
-struct {
-	const char *pma;
-	const char *tuple;
-	const char *res;
-} bind_pma_domain_wrapped_tests[] = {
-	{ "{ [A[M, N] -> B[]] -> [M + floor(N/2)] }",
-	  "{ A[M, N] }",
-	  "[M, N] -> { B[] -> [M + floor(N/2)] }" },
-	{ "{ [B[N, M] -> D[]] -> [M + floor(N/2)] }",
-	  "{ B[N, M] }",
-	  "[N, M] -> { D[] -> [M + floor(N/2)] }" },
-	{ "[M] -> { [C[N] -> B[x]] -> [x + M + floor(N/2)] }",
-	  "{ C[N] }",
-	  "[M, N] -> { B[x] -> [x + M + floor(N/2)] }" },
-	{ "[M] -> { [C[x, N] -> B[]] -> [x + floor(N/2)] }",
-	  "{ C[M, N] }",
-	  "[M, N] -> { B[] -> [M + floor(N/2)] }" },
-	{ "[M] -> { [C[x, N] -> B[]] -> [M + floor(N/2)] }",
-	  "{ C[M, N] }",
-	  "[M, N] -> { B[] -> [M + floor(N/2)] }" },
-	{ "[A, M] -> { [C[N, x] -> B[]] -> [x + floor(N/2)] }",
-	  "{ C[N, M] }",
-	  "[A, N, M] -> { B[] -> [M + floor(N/2)] }" },
-};
-
-/* Perform basic isl_pw_multi_aff_bind_domain_wrapped_domain tests.
- */
-static isl_stat test_bind_pma_domain_wrapped(isl_ctx *ctx)
+int test_fixed_power(isl_ctx *ctx)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(bind_pma_domain_wrapped_tests); ++i) {
-		const char *str;
-		isl_pw_multi_aff *pma;
-		isl_multi_id *tuple;
-		isl_stat r;
+	const char *str;
+	isl_map *map;
+	isl_val *exp;
+	int equal;
 
-		str = bind_pma_domain_wrapped_tests[i].pma;
-		pma = isl_pw_multi_aff_read_from_str(ctx, str);
-		str = bind_pma_domain_wrapped_tests[i].tuple;
-		tuple = isl_multi_id_read_from_str(ctx, str);
-		pma = isl_pw_multi_aff_bind_domain_wrapped_domain(pma, tuple);
-		str = bind_pma_domain_wrapped_tests[i].res;
-		r = pw_multi_aff_check_plain_equal(pma, str);
-		isl_pw_multi_aff_free(pma);
-		if (r < 0)
-			return isl_stat_error;
-	}
+	str = "{ [i] -> [i + 1] }";
+	map = isl_map_read_from_str(ctx, str);
+	exp = isl_val_int_from_si(ctx, 23);
+	map = isl_map_fixed_power_val(map, exp);
+	equal = map_check_equal(map, "{ [i] -> [i + 23] }");
+	isl_map_free(map);
+	if (equal < 0)
+		return -1;
 
-	return isl_stat_ok;
+	return 0;
 }
 
-/* Inputs for isl_aff_bind_id tests.
- * "aff" is the input expression.
- * "id" is the binding id.
- * "res" is the expected result.
- */
-static
-struct {
-	const char *aff;
-	const char *id;
-	const char *res;
-} bind_aff_tests[] = {
-	{ "{ [4] }", "M", "[M = 4] -> { : }" },
-	{ "{ B[x] -> [floor(x/2)] }", "M", "[M] -> { B[x] : M = floor(x/2) }" },
-	{ "[M] -> { [4] }", "M", "[M = 4] -> { : }" },
-	{ "[M] -> { [floor(M/2)] }", "M", "[M] -> { : floor(M/2) = M }" },
-	{ "{ [NaN] }", "M", "{ : false }" },
-	{ "{ A[x] -> [NaN] }", "M", "{ A[x] : false }" },
-};
-
-/* Perform basic isl_aff_bind_id tests.
- */
-static isl_stat test_bind_aff(isl_ctx *ctx)
+int test_slice(isl_ctx *ctx)
 {
-	int i;
+	const char *str;
+	isl_map *map;
+	int equal;
 
-	for (i = 0; i < ARRAY_SIZE(bind_aff_tests); ++i) {
-		isl_aff *aff;
-		isl_set *res;
-		isl_id *id;
-		isl_stat r;
+	str = "{ [i] -> [j] }";
+	map = isl_map_read_from_str(ctx, str);
+	map = isl_map_equate(map, isl_dim_in, 0, isl_dim_out, 0);
+	equal = map_check_equal(map, "{ [i] -> [i] }");
+	isl_map_free(map);
+	if (equal < 0)
+		return -1;
 
-		aff = isl_aff_read_from_str(ctx, bind_aff_tests[i].aff);
-		id = isl_id_read_from_str(ctx, bind_aff_tests[i].id);
-		res = isl_set_from_basic_set(isl_aff_bind_id(aff, id));
-		r = set_check_equal(res, bind_aff_tests[i].res);
-		isl_set_free(res);
-		if (r < 0)
-			return isl_stat_error;
-	}
+	str = "{ [i] -> [j] }";
+	map = isl_map_read_from_str(ctx, str);
+	map = isl_map_equate(map, isl_dim_in, 0, isl_dim_in, 0);
+	equal = map_check_equal(map, "{ [i] -> [j] }");
+	isl_map_free(map);
+	if (equal < 0)
+		return -1;
 
-	return isl_stat_ok;
+	str = "{ [i] -> [j] }";
+	map = isl_map_read_from_str(ctx, str);
+	map = isl_map_oppose(map, isl_dim_in, 0, isl_dim_out, 0);
+	equal = map_check_equal(map, "{ [i] -> [-i] }");
+	isl_map_free(map);
+	if (equal < 0)
+		return -1;
+
+	str = "{ [i] -> [j] }";
+	map = isl_map_read_from_str(ctx, str);
+	map = isl_map_oppose(map, isl_dim_in, 0, isl_dim_in, 0);
+	equal = map_check_equal(map, "{ [0] -> [j] }");
+	isl_map_free(map);
+	if (equal < 0)
+		return -1;
+
+	str = "{ [i] -> [j] }";
+	map = isl_map_read_from_str(ctx, str);
+	map = isl_map_order_gt(map, isl_dim_in, 0, isl_dim_out, 0);
+	equal = map_check_equal(map, "{ [i] -> [j] : i > j }");
+	isl_map_free(map);
+	if (equal < 0)
+		return -1;
+
+	str = "{ [i] -> [j] }";
+	map = isl_map_read_from_str(ctx, str);
+	map = isl_map_order_gt(map, isl_dim_in, 0, isl_dim_in, 0);
+	equal = map_check_equal(map, "{ [i] -> [j] : false }");
+	isl_map_free(map);
+	if (equal < 0)
+		return -1;
+
+	return 0;
 }
 
-/* Inputs for isl_pw_aff_bind_id tests.
- * "pa" is the input expression.
- * "id" is the binding id.
- * "res" is the expected result.
- */
-static
-struct {
-	const char *pa;
-	const char *id;
-	const char *res;
-} bind_pa_tests[] = {
-	{ "{ [4] }", "M", "[M = 4] -> { : }" },
-	{ "{ B[x] -> [floor(x/2)] }", "M", "[M] -> { B[x] : M = floor(x/2) }" },
-	{ "[M] -> { [4] }", "M", "[M = 4] -> { : }" },
-	{ "[M] -> { [floor(M/2)] }", "M", "[M] -> { : floor(M/2) = M }" },
-	{ "[M] -> { [M] : M >= 0; [-M] : M < 0 }", "M", "[M] -> { : M >= 0 }" },
-	{ "{ [NaN] }", "M", "{ : false }" },
-	{ "{ A[x] -> [NaN] }", "M", "{ A[x] : false }" },
-};
+int test_eliminate(isl_ctx *ctx)
+{
+	const char *str;
+	isl_map *map;
+	int equal;
 
-/* Perform basic isl_pw_aff_bind_id tests.
+	str = "{ [i] -> [j] : i = 2j }";
+	map = isl_map_read_from_str(ctx, str);
+	map = isl_map_eliminate(map, isl_dim_out, 0, 1);
+	equal = map_check_equal(map, "{ [i] -> [j] : exists a : i = 2a }");
+	isl_map_free(map);
+	if (equal < 0)
+		return -1;
+
+	return 0;
+}
+
+/* Check basic functionality of isl_map_deltas_map.
  */
-static isl_stat test_bind_pa(isl_ctx *ctx)
+static int test_deltas_map(isl_ctx *ctx)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(bind_pa_tests); ++i) {
-		isl_pw_aff *pa;
-		isl_set *res;
-		isl_id *id;
-		isl_stat r;
+	const char *str;
+	isl_map *map;
+	int equal;
 
-		pa = isl_pw_aff_read_from_str(ctx, bind_pa_tests[i].pa);
-		id = isl_id_read_from_str(ctx, bind_pa_tests[i].id);
-		res = isl_pw_aff_bind_id(pa, id);
-		r = set_check_equal(res, bind_pa_tests[i].res);
-		isl_set_free(res);
-		if (r < 0)
-			return isl_stat_error;
-	}
+	str = "{ A[i] -> A[i + 1] }";
+	map = isl_map_read_from_str(ctx, str);
+	map = isl_map_deltas_map(map);
+	equal = map_check_equal(map, "{ [A[i] -> A[i + 1]] -> A[1] }");
+	isl_map_free(map);
+	if (equal < 0)
+		return -1;
 
-	return isl_stat_ok;
+	return 0;
 }
 
-/* Inputs for isl_multi_union_pw_aff_bind tests.
- * "mupa" is the input expression.
- * "tuple" is the binding tuple.
- * "res" is the expected result.
+/* Inputs for isl_map_deltas and isl_map_get_deltas_{min,max}_sign tests.
+ * "map" is the input map.
+ * "deltas" is the expected result of isl_map_deltas.
+ * "min" and "max" are the expected results
+ * of isl_map_get_deltas_min_sign and isl_map_get_deltas_max_sign.
  */
-static
-struct {
-	const char *mupa;
-	const char *tuple;
-	const char *res;
-} bind_mupa_tests[] = {
-	{ "A[{ [4] }, { [5] }]",
-	  "{ A[M, N] }",
-	  "[M = 4, N = 5] -> { : }" },
-	{ "A[{ B[x] -> [floor(x/2)] }, { B[y] -> [y + 5] }]",
-	  "{ A[M, N] }",
-	  "[M, N] -> { B[x] : M = floor(x/2) and N = x + 5 }" },
-	{ "[M] -> A[{ [4] }, { [M + 1] }]",
-	  "{ A[M, N] }",
-	  "[M = 4, N = 5] -> { : }" },
+static struct {
+	const char *map;
+	const char *deltas;
+	const char *min;
+	const char *max;
+} deltas_tests[] = {
+	{ "[N] -> { A[i, j] -> A[i + 1, j - 1] : 0 <= i, j < N }",
+	  "[N] -> { A[1, -1] : N >= 1 }", "{ A[1, -1] }", "{ A[1, -1] }" },
+	{ "{ A[i, j] -> A[i', j'] : 0 <= i < i' < 10 and 0 <= j, j' < 10 }",
+	  "{ A[a, b] : 1 <= a <= 9 and -9 <= b <= 9 }",
+	  "{ A[1, -1] }", "{ A[1, 1] }" },
+	{ "[N] -> { A[i] -> A[j] : exists (e: i = 2e and i <= j <= i + N) }",
+	  "[N] -> { A[a] : 0 <= a <= N }", "{ A[0] }", "{ A[1] }" },
+	{ "{ A[i] -> A[2i] : i >= 0; A[i] -> A[i - 1] : i >= 1 }",
+	  "{ A[a] : a >= 0; A[-1] }", "{ A[-1] }", "{ A[1] }" },
+	{ "{ A[i] -> A[j] : j = [i/3] and 0 <= i < 10 }",
+	  "{ A[a] : exists (i: a = [i/3] - i and 0 <= i < 10) }",
+	  "{ A[-1] }", "{ A[0] }" },
 };
 
-/* Perform basic isl_multi_union_pw_aff_bind tests.
+/* Perform some isl_map_deltas and isl_map_get_deltas_{min,max}_sign tests,
+ * including a check that the signs of an empty map are NaN.
  */
-static isl_stat test_bind_mupa(isl_ctx *ctx)
+static int test_deltas(isl_ctx *ctx)
 {
 	int i;
+	isl_map *map;
+	isl_multi_val *min;
+	isl_bool nan;
 
-	for (i = 0; i < ARRAY_SIZE(bind_mupa_tests); ++i) {
-		const char *str;
-		isl_multi_union_pw_aff *mupa;
-		isl_union_set *res;
-		isl_multi_id *tuple;
+	for (i = 0; i < ARRAY_SIZE(deltas_tests); ++i) {
+		isl_set *deltas;
+		isl_multi_val *max;
 		isl_stat r;
 
-		str = bind_mupa_tests[i].mupa;
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
-		str = bind_mupa_tests[i].tuple;
-		tuple = isl_multi_id_read_from_str(ctx, str);
-		res = isl_multi_union_pw_aff_bind(mupa, tuple);
-		r = uset_check_equal(res, bind_mupa_tests[i].res);
-		isl_union_set_free(res);
+		map = isl_map_read_from_str(ctx, deltas_tests[i].map);
+		min = isl_map_get_deltas_min_sign(map);
+		max = isl_map_get_deltas_max_sign(map);
+		deltas = isl_map_deltas(map);
+		r = set_check_equal(deltas, deltas_tests[i].deltas);
+		if (r >= 0)
+			r = multi_val_check_plain_equal(min,
+							deltas_tests[i].min);
+		if (r >= 0)
+			r = multi_val_check_plain_equal(max,
+							deltas_tests[i].max);
+		isl_set_free(deltas);
+		isl_multi_val_free(min);
+		isl_multi_val_free(max);
 		if (r < 0)
-			return isl_stat_error;
+			return -1;
 	}
 
-	return isl_stat_ok;
+	map = isl_map_read_from_str(ctx, "{ A[i] -> A[i] : 1 = 0 }");
+	min = isl_map_get_deltas_min_sign(map);
+	nan = isl_multi_val_involves_nan(min);
+	isl_multi_val_free(min);
+	isl_map_free(map);
+	if (nan < 0)
+		return -1;
+	if (!nan)
+		isl_die(ctx, isl_error_unknown,
+			"expecting NaN sign for empty map", return -1);
+
+	return 0;
 }
 
-/* Perform tests that reinterpret dimensions as parameters.
+/* Check that isl_set_dim_residue_class detects that the values of j
+ * in the set below are all odd and that it does not detect any spurious
+ * strides.
  */
-static int test_bind(isl_ctx *ctx)
+static int test_residue_class(isl_ctx *ctx)
 {
-	if (test_bind_set(ctx) < 0)
-		return -1;
-	if (test_bind_map_domain(ctx) < 0)
-		return -1;
-	if (test_bind_umap_range(ctx) < 0)
-		return -1;
-	if (test_bind_pma_domain(ctx) < 0)
-		return -1;
-	if (test_bind_pma_domain_wrapped(ctx) < 0)
-		return -1;
-	if (test_bind_aff(ctx) < 0)
-		return -1;
-	if (test_bind_pa(ctx) < 0)
-		return -1;
-	if (test_bind_mupa(ctx) < 0)
+	const char *str;
+	isl_set *set;
+	isl_int m, r;
+	isl_stat res;
+
+	str = "{ [i,j] : j = 4 i + 1 and 0 <= i <= 100; "
+		"[i,j] : j = 4 i + 3 and 500 <= i <= 600 }";
+	set = isl_set_read_from_str(ctx, str);
+	isl_int_init(m);
+	isl_int_init(r);
+	res = isl_set_dim_residue_class(set, 1, &m, &r);
+	if (res >= 0 &&
+	    (isl_int_cmp_si(m, 2) != 0 || isl_int_cmp_si(r, 1) != 0))
+		isl_die(ctx, isl_error_unknown, "incorrect residue class",
+			res = isl_stat_error);
+	isl_int_clear(r);
+	isl_int_clear(m);
+	isl_set_free(set);
+
+	return res;
+}
+
+static int test_align_parameters_1(isl_ctx *ctx)
+{
+	const char *str;
+	isl_space *space;
+	isl_multi_aff *ma1, *ma2;
+	int equal;
+
+	str = "{ A[B[] -> C[]] -> D[E[] -> F[]] }";
+	ma1 = isl_multi_aff_read_from_str(ctx, str);
+
+	space = isl_space_params_alloc(ctx, 1);
+	space = isl_space_set_dim_name(space, isl_dim_param, 0, "N");
+	ma1 = isl_multi_aff_align_params(ma1, space);
+
+	str = "[N] -> { A[B[] -> C[]] -> D[E[] -> F[]] }";
+	ma2 = isl_multi_aff_read_from_str(ctx, str);
+
+	equal = isl_multi_aff_plain_is_equal(ma1, ma2);
+
+	isl_multi_aff_free(ma1);
+	isl_multi_aff_free(ma2);
+
+	if (equal < 0)
 		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"result not as expected", return -1);
 
 	return 0;
 }
 
-/* Inputs for isl_set_unbind_params tests.
- * "set" is the input parameter domain.
- * "tuple" is the tuple of the constructed set.
- * "res" is the expected result.
- */
-struct {
-	const char *set;
-	const char *tuple;
-	const char *res;
-} unbind_set_tests[] = {
-	{ "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }",
-	  "{ A[M, N] }",
-	  "{ A[M, N] : M mod 2 = 0 and N mod 8 = 3 }" },
-	{ "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }",
-	  "{ B[N, M] }",
-	  "{ B[N, M] : M mod 2 = 0 and N mod 8 = 3 }" },
-	{ "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }",
-	  "{ C[N] }",
-	  "[M] -> { C[N] : M mod 2 = 0 and N mod 8 = 3 }" },
-	{ "[M, N] -> { : M mod 2 = 0 and N mod 8 = 3 }",
-	  "{ D[T, N] }",
-	  "[M] -> { D[x, N] : M mod 2 = 0 and N mod 8 = 3 }" },
-};
-
-/* Perform basic isl_set_unbind_params tests.
+/* Check the isl_multi_*_from_*_list operation in case inputs
+ * have unaligned parameters.
+ * In particular, older versions of isl would simply fail
+ * (without printing any error message).
  */
-static isl_stat test_unbind_set(isl_ctx *ctx)
+static isl_stat test_align_parameters_2(isl_ctx *ctx)
 {
-	int i;
+	isl_space *space;
+	isl_map *map;
+	isl_aff *aff;
+	isl_multi_aff *ma;
 
-	for (i = 0; i < ARRAY_SIZE(unbind_set_tests); ++i) {
-		const char *str;
-		isl_set *set;
-		isl_multi_id *tuple;
-		isl_stat r;
+	map = isl_map_read_from_str(ctx, "{ A[] -> M[x] }");
+	space = isl_map_get_space(map);
+	isl_map_free(map);
 
-		set = isl_set_read_from_str(ctx, unbind_set_tests[i].set);
-		str = unbind_set_tests[i].tuple;
-		tuple = isl_multi_id_read_from_str(ctx, str);
-		set = isl_set_unbind_params(set, tuple);
-		r = set_check_equal(set, unbind_set_tests[i].res);
-		isl_set_free(set);
-		if (r < 0)
-			return isl_stat_error;
-	}
+	aff = isl_aff_read_from_str(ctx, "[N] -> { A[] -> [N] }");
+	ma = isl_multi_aff_from_aff_list(space, isl_aff_list_from_aff(aff));
+	isl_multi_aff_free(ma);
 
+	if (!ma)
+		return isl_stat_error;
 	return isl_stat_ok;
 }
 
-/* Inputs for isl_aff_unbind_params_insert_domain tests.
- * "aff" is the input affine expression defined over a parameter domain.
- * "tuple" is the tuple of the domain that gets introduced.
- * "res" is the expected result.
+/* Inputs for parameter alignment tests.
+ * "set" is the set that gets aligned to the parameters of "model".
+ * "res" is the expected result, which is also checked
+ * to have its parameters in the same order.
  */
-struct {
-	const char *aff;
-	const char *tuple;
+static struct {
+	const char *set;
+	const char *model;
 	const char *res;
-} unbind_aff_tests[] = {
-	{ "[M, N] -> { [M + floor(N/2)] }",
-	  "{ A[M, N] }",
-	  "{ A[M, N] -> [M + floor(N/2)] }" },
-	{ "[M, N] -> { [M + floor(N/2)] }",
-	  "{ B[N, M] }",
-	  "{ B[N, M] -> [M + floor(N/2)] }" },
-	{ "[M, N] -> { [M + floor(N/2)] }",
-	  "{ C[N] }",
-	  "[M] -> { C[N] -> [M + floor(N/2)] }" },
-	{ "[M, N] -> { [M + floor(N/2)] }",
-	  "{ D[A, B, C, N, Z] }",
-	  "[M] -> { D[A, B, C, N, Z] -> [M + floor(N/2)] }" },
+} align_parameters_tests[] = {
+	{ "[a, b, c] -> { [x] : x = a + 2b + 3c }",
+	  "[a, b, c, d] -> { : }",
+	  "[a, b, c, d] -> { [x] : x = a + 2b + 3c }" },
+	{ "[a, b, c] -> { [x] : x = a + 2b + 3c }",
+	  "[c, d, a] -> { : }",
+	  "[c, d, a, b] -> { [x] : x = a + 2b + 3c }" },
+	{ "[a, b, c] -> { [x] : x = a + 2b + 3c }",
+	  "[c, b, a] -> { : }",
+	  "[c, b, a] -> { [x] : x = a + 2b + 3c }" },
+	{ "[a, b, c] -> { [x] : x = a + 2b + 3c }",
+	  "[d, e] -> { : }",
+	  "[d, e, a, b, c] -> { [x] : x = a + 2b + 3c }" },
 };
 
-/* Perform basic isl_aff_unbind_params_insert_domain tests.
+/* Check that the parameters end up in the expected order
+ * after alignment and that the result is as expected.
  */
-static isl_stat test_unbind_aff(isl_ctx *ctx)
+static isl_stat test_align_parameters_3(isl_ctx *ctx)
 {
 	int i;
 
-	for (i = 0; i < ARRAY_SIZE(unbind_aff_tests); ++i) {
+	for (i = 0; i < ARRAY_SIZE(align_parameters_tests); ++i) {
 		const char *str;
-		isl_aff *aff;
-		isl_multi_id *tuple;
-		isl_stat r;
+		isl_set *set, *model, *res;
+		isl_bool equal;
 
-		aff = isl_aff_read_from_str(ctx, unbind_aff_tests[i].aff);
-		str = unbind_aff_tests[i].tuple;
-		tuple = isl_multi_id_read_from_str(ctx, str);
-		aff = isl_aff_unbind_params_insert_domain(aff, tuple);
-		r = aff_check_plain_equal(aff, unbind_aff_tests[i].res);
-		isl_aff_free(aff);
-		if (r < 0)
+		str = align_parameters_tests[i].set;
+		set = isl_set_read_from_str(ctx, str);
+		str = align_parameters_tests[i].model;
+		model = isl_set_read_from_str(ctx, str);
+		set = isl_set_align_params(set, isl_set_get_space(model));
+		isl_set_free(model);
+		str = align_parameters_tests[i].res;
+		res = isl_set_read_from_str(ctx, str);
+		equal = isl_space_is_equal(isl_set_peek_space(set),
+					    isl_set_peek_space(res));
+		if (equal >= 0 && equal)
+			equal = isl_set_is_equal(set, res);
+		isl_set_free(set);
+		isl_set_free(res);
+		if (equal < 0)
 			return isl_stat_error;
-	}
-
-	return isl_stat_ok;
-}
-
-/* Inputs for isl_multi_aff_unbind_params_insert_domain tests.
- * "ma" is the input multi affine expression defined over a parameter domain.
- * "tuple" is the tuple of the domain that gets introduced.
- * "res" is the expected result.
- */
-static struct {
-	const char *ma;
-	const char *tuple;
-	const char *res;
-} unbind_multi_aff_tests[] = {
-	{ "[M, N] -> { T[M + floor(N/2)] }",
-	  "{ A[M, N] }",
-	  "{ A[M, N] -> T[M + floor(N/2)] }" },
-	{ "[M, N] -> { [M + floor(N/2)] }",
-	  "{ B[N, M] }",
-	  "{ B[N, M] -> [M + floor(N/2)] }" },
-	{ "[M, N] -> { [M + floor(N/2)] }",
-	  "{ C[N] }",
-	  "[M] -> { C[N] -> [M + floor(N/2)] }" },
-	{ "[M, N] -> { [M + floor(N/2)] }",
-	  "{ D[A, B, C, N, Z] }",
-	  "[M] -> { D[A, B, C, N, Z] -> [M + floor(N/2)] }" },
-	{ "[M, N] -> { T[M + floor(N/2), N + floor(M/3)] }",
-	  "{ A[M, N] }",
-	  "{ A[M, N] -> T[M + floor(N/2), N + floor(M/3)] }" },
-};
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"result not as expected",
+				return isl_stat_error);
+	}
 
-/* Perform basic isl_multi_aff_unbind_params_insert_domain tests.
+	return isl_stat_ok;
+}
+
+/* Check that objects that are read after setting canonical parameters
+ * have the canonical parameters and that they are otherwise
+ * the same as when they are read without canonical parameters.
  */
-static isl_stat test_unbind_multi_aff(isl_ctx *ctx)
+static isl_stat test_canonical_params(isl_ctx *ctx)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(unbind_multi_aff_tests); ++i) {
-		const char *str;
-		isl_multi_aff *ma;
-		isl_multi_id *tuple;
-		isl_stat r;
-
-		str = unbind_multi_aff_tests[i].ma;
-		ma = isl_multi_aff_read_from_str(ctx, str);
-		str = unbind_multi_aff_tests[i].tuple;
-		tuple = isl_multi_id_read_from_str(ctx, str);
-		ma = isl_multi_aff_unbind_params_insert_domain(ma, tuple);
-		str = unbind_multi_aff_tests[i].res;
-		r = multi_aff_check_plain_equal(ma, str);
-		isl_multi_aff_free(ma);
-		if (r < 0)
-			return isl_stat_error;
+	const char *str_set = "[K, N] -> { [x] : 0 <= x <= N + K }";
+	const char *str_pa = "[M] -> { [x] -> [(x + M)] }";
+	isl_set *set1, *set2;
+	isl_pw_aff *pa1, *pa2;
+	isl_space *params;
+	isl_bool equal, equal_params;
+
+	set1 = isl_set_read_from_str(ctx, str_set);
+	pa1 = isl_pw_aff_read_from_str(ctx, str_pa);
+
+	params = isl_space_params_alloc(ctx, 3);
+	params = isl_space_set_dim_name(params, isl_dim_param, 0, "N");
+	params = isl_space_set_dim_name(params, isl_dim_param, 1, "M");
+	params = isl_space_set_dim_name(params, isl_dim_param, 2, "K");
+	if (isl_ctx_set_canonical_params(ctx, params) < 0)
+		goto error;
+	set2 = isl_set_read_from_str(ctx, str_set);
+	pa2 = isl_pw_aff_read_from_str(ctx, str_pa);
+	params = isl_ctx_get_canonical_params(ctx);
+	isl_ctx_set_canonical_params(ctx, NULL);
+
+	equal_params = isl_space_has_equal_params(params,
+						isl_set_peek_space(set2));
+	if (equal_params >= 0 && equal_params) {
+		isl_space *space = isl_pw_aff_get_space(pa2);
+		equal_params = isl_space_has_equal_params(params, space);
+		isl_space_free(space);
 	}
+	equal = isl_set_is_equal(set1, set2);
+	if (equal >= 0 && equal)
+		equal = isl_pw_aff_is_equal(pa1, pa2);
+	isl_space_free(params);
+	isl_set_free(set1);
+	isl_set_free(set2);
+	isl_pw_aff_free(pa1);
+	isl_pw_aff_free(pa2);
+	if (equal < 0 || equal_params < 0)
+		return isl_stat_error;
+	if (!equal_params)
+		isl_die(ctx, isl_error_unknown,
+			"parameters not canonical", return isl_stat_error);
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"result not as expected", return isl_stat_error);
 
 	return isl_stat_ok;
+error:
+	isl_set_free(set1);
+	isl_pw_aff_free(pa1);
+	return isl_stat_error;
 }
 
-/* Perform tests that reinterpret parameters.
+/* Perform basic parameter alignment tests.
  */
-static int test_unbind(isl_ctx *ctx)
+static int test_align_parameters(isl_ctx *ctx)
 {
-	if (test_unbind_set(ctx) < 0)
+	if (test_align_parameters_1(ctx) < 0)
 		return -1;
-	if (test_unbind_aff(ctx) < 0)
+	if (test_align_parameters_2(ctx) < 0)
 		return -1;
-	if (test_unbind_multi_aff(ctx) < 0)
+	if (test_align_parameters_3(ctx) < 0)
+		return -1;
+	if (test_canonical_params(ctx) < 0)
 		return -1;
 
 	return 0;
 }
 
-/* Check that "pa" consists of a single expression.
+/* Check that isl_*_drop_unused_params actually drops the unused parameters
+ * by comparing the result using isl_*_plain_is_equal.
+ * Note that this assumes that isl_*_plain_is_equal does not consider
+ * objects that only differ by unused parameters to be equal.
  */
-static int check_single_piece(isl_ctx *ctx, __isl_take isl_pw_aff *pa)
+int test_drop_unused_parameters(isl_ctx *ctx)
+{
+	const char *str_with, *str_without;
+	isl_basic_set *bset1, *bset2;
+	isl_set *set1, *set2;
+	isl_pw_aff *pwa1, *pwa2;
+	int equal;
+
+	str_with = "[n, m, o] -> { [m] }";
+	str_without = "[m] -> { [m] }";
+
+	bset1 = isl_basic_set_read_from_str(ctx, str_with);
+	bset2 = isl_basic_set_read_from_str(ctx, str_without);
+	bset1 = isl_basic_set_drop_unused_params(bset1);
+	equal = isl_basic_set_plain_is_equal(bset1, bset2);
+	isl_basic_set_free(bset1);
+	isl_basic_set_free(bset2);
+
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"result not as expected", return -1);
+
+	set1 = isl_set_read_from_str(ctx, str_with);
+	set2 = isl_set_read_from_str(ctx, str_without);
+	set1 = isl_set_drop_unused_params(set1);
+	equal = isl_set_plain_is_equal(set1, set2);
+	isl_set_free(set1);
+	isl_set_free(set2);
+
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"result not as expected", return -1);
+
+	pwa1 = isl_pw_aff_read_from_str(ctx, str_with);
+	pwa2 = isl_pw_aff_read_from_str(ctx, str_without);
+	pwa1 = isl_pw_aff_drop_unused_params(pwa1);
+	equal = isl_pw_aff_plain_is_equal(pwa1, pwa2);
+	isl_pw_aff_free(pwa1);
+	isl_pw_aff_free(pwa2);
+
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"result not as expected", return -1);
+
+	return 0;
+}
+
+static int test_list(isl_ctx *ctx)
 {
+	isl_id *a, *b, *c, *d, *id;
+	isl_id_list *list;
 	isl_size n;
+	int ok;
 
-	n = isl_pw_aff_n_piece(pa);
-	isl_pw_aff_free(pa);
+	a = isl_id_alloc(ctx, "a", NULL);
+	b = isl_id_alloc(ctx, "b", NULL);
+	c = isl_id_alloc(ctx, "c", NULL);
+	d = isl_id_alloc(ctx, "d", NULL);
+
+	list = isl_id_list_alloc(ctx, 4);
+	list = isl_id_list_add(list, b);
+	list = isl_id_list_insert(list, 0, a);
+	list = isl_id_list_add(list, c);
+	list = isl_id_list_add(list, d);
+	list = isl_id_list_drop(list, 1, 1);
 
+	n = isl_id_list_n_id(list);
 	if (n < 0)
 		return -1;
-	if (n != 1)
-		isl_die(ctx, isl_error_unknown, "expecting single expression",
-			return -1);
+	if (n != 3) {
+		isl_id_list_free(list);
+		isl_die(ctx, isl_error_unknown,
+			"unexpected number of elements in list", return -1);
+	}
+
+	id = isl_id_list_get_id(list, 0);
+	ok = id == a;
+	isl_id_free(id);
+	id = isl_id_list_get_id(list, 1);
+	ok = ok && id == c;
+	isl_id_free(id);
+	id = isl_id_list_get_id(list, 2);
+	ok = ok && id == d;
+	isl_id_free(id);
+
+	isl_id_list_free(list);
+
+	if (!ok)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected elements in list", return -1);
 
 	return 0;
 }
 
-/* Check that the computation below results in a single expression.
- * One or two expressions may result depending on which constraint
- * ends up being considered as redundant with respect to the other
- * constraints after the projection that is performed internally
- * by isl_set_dim_min.
+/* Check that "list" consists of the "n" elements of "expected".
  */
-static int test_dim_max_1(isl_ctx *ctx)
+static isl_stat check_id_list(isl_id_list *list, int n, isl_id **expected)
 {
-	const char *str;
-	isl_set *set;
-	isl_pw_aff *pa;
+	int i;
+	isl_size size;
 
-	str = "[n] -> { [a, b] : n >= 0 and 4a >= -4 + n and b >= 0 and "
-				"-4a <= b <= 3 and b < n - 4a }";
-	set = isl_set_read_from_str(ctx, str);
-	pa = isl_set_dim_min(set, 0);
-	return check_single_piece(ctx, pa);
+	size = isl_id_list_size(list);
+	if (size < 0)
+		return isl_stat_error;
+	if (size != n)
+		isl_die(isl_id_list_get_ctx(list), isl_error_unknown,
+			"unexpected number of elements in list",
+			return isl_stat_error);
+	for (i = 0; i < n; ++i) {
+		isl_id *id;
+
+		id = isl_id_list_get_at(list, i);
+		isl_id_free(id);
+		if (id != expected[i])
+			isl_die(isl_id_list_get_ctx(list), isl_error_unknown,
+				"unexpected elements in list",
+				return isl_stat_error);
+	}
+	return isl_stat_ok;
 }
 
-/* Check that the computation below results in a single expression.
- * The PIP problem corresponding to these constraints has a row
- * that causes a split of the solution domain.  The solver should
- * first pick rows that split off empty parts such that the actual
- * solution domain does not get split.
- * Note that the description contains some redundant constraints.
- * If these constraints get removed first, then the row mentioned
- * above does not appear in the PIP problem.
+/* Check isl_id_list_from_array and isl_id_list_reserve, as well as
+ * the in-place and copying variants of isl_id_list_concat,
+ * isl_id_list_drop and isl_id_list_insert.
  */
-static int test_dim_max_2(isl_ctx *ctx)
+static int test_list_bulk(isl_ctx *ctx)
 {
-	const char *str;
-	isl_set *set;
-	isl_pw_aff *pa;
+	isl_id *id[4];
+	isl_id *array[2];
+	isl_id *expected1[] = { NULL, NULL, NULL, NULL, NULL, NULL };
+	isl_id *expected2[] = { NULL, NULL, NULL };
+	isl_id_list *list1, *list2, *shared, *dropped;
+	isl_stat r;
 
-	str = "[P, N] -> { [a] : a < N and a >= 0 and N > P and a <= P and "
-				"N > 0 and P >= 0 }";
-	set = isl_set_read_from_str(ctx, str);
-	pa = isl_set_dim_max(set, 0);
-	return check_single_piece(ctx, pa);
+	id[0] = isl_id_alloc(ctx, "a", NULL);
+	id[1] = isl_id_alloc(ctx, "b", NULL);
+	id[2] = isl_id_alloc(ctx, "c", NULL);
+	id[3] = isl_id_alloc(ctx, "d", NULL);
+	expected1[0] = id[0];
+	expected1[1] = id[1];
+	expected1[2] = expected1[4] = id[2];
+	expected1[3] = expected1[5] = id[3];
+	expected2[0] = id[0];
+	expected2[1] = id[1];
+	expected2[2] = id[3];
+
+	array[0] = isl_id_copy(id[0]);
+	array[1] = isl_id_copy(id[1]);
+	list1 = isl_id_list_from_array(ctx, 2, array);
+	list1 = isl_id_list_reserve(list1, 2);
+	array[0] = isl_id_copy(id[2]);
+	array[1] = isl_id_copy(id[3]);
+	list2 = isl_id_list_from_array(ctx, 2, array);
+	shared = isl_id_list_copy(list2);
+	list1 = isl_id_list_concat(list1, list2);
+	list1 = isl_id_list_concat(list1, shared);
+	r = check_id_list(list1, 6, expected1);
+
+	dropped = isl_id_list_drop(isl_id_list_copy(list1), 1, 4);
+	dropped = isl_id_list_insert(dropped, 1, isl_id_copy(id[1]));
+	if (r >= 0)
+		r = check_id_list(list1, 6, expected1);
+	if (r >= 0)
+		r = check_id_list(dropped, 3, expected2);
+	isl_id_list_free(dropped);
+	isl_id_list_free(list1);
+
+	isl_id_free(id[0]);
+	isl_id_free(id[1]);
+	isl_id_free(id[2]);
+	isl_id_free(id[3]);
+
+	return r < 0 ? -1 : 0;
 }
 
-int test_dim_max(isl_ctx *ctx)
+/* Check the conversion from an isl_multi_aff to an isl_basic_set.
+ */
+static isl_stat test_ma_conversion(isl_ctx *ctx)
 {
-	int equal;
 	const char *str;
-	isl_set *set1, *set2;
-	isl_set *set;
-	isl_map *map;
-	isl_pw_aff *pwaff;
-
-	if (test_dim_max_1(ctx) < 0)
-		return -1;
-	if (test_dim_max_2(ctx) < 0)
-		return -1;
-
-	str = "[N] -> { [i] : 0 <= i <= min(N,10) }";
-	set = isl_set_read_from_str(ctx, str);
-	pwaff = isl_set_dim_max(set, 0);
-	set1 = isl_set_from_pw_aff(pwaff);
-	str = "[N] -> { [10] : N >= 10; [N] : N <= 9 and N >= 0 }";
-	set2 = isl_set_read_from_str(ctx, str);
-	equal = isl_set_is_equal(set1, set2);
-	isl_set_free(set1);
-	isl_set_free(set2);
-	if (equal < 0)
-		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
-
-	str = "[N] -> { [i] : 0 <= i <= max(2N,N+6) }";
-	set = isl_set_read_from_str(ctx, str);
-	pwaff = isl_set_dim_max(set, 0);
-	set1 = isl_set_from_pw_aff(pwaff);
-	str = "[N] -> { [6 + N] : -6 <= N <= 5; [2N] : N >= 6 }";
-	set2 = isl_set_read_from_str(ctx, str);
-	equal = isl_set_is_equal(set1, set2);
-	isl_set_free(set1);
-	isl_set_free(set2);
-	if (equal < 0)
-		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+	isl_bool equal;
+	isl_multi_aff *ma;
+	isl_basic_set *bset1, *bset2;
 
-	str = "[N] -> { [i] : 0 <= i <= 2N or 0 <= i <= N+6 }";
-	set = isl_set_read_from_str(ctx, str);
-	pwaff = isl_set_dim_max(set, 0);
-	set1 = isl_set_from_pw_aff(pwaff);
-	str = "[N] -> { [6 + N] : -6 <= N <= 5; [2N] : N >= 6 }";
-	set2 = isl_set_read_from_str(ctx, str);
-	equal = isl_set_is_equal(set1, set2);
-	isl_set_free(set1);
-	isl_set_free(set2);
+	str = "[N] -> { A[0, N + 1] }";
+	ma = isl_multi_aff_read_from_str(ctx, str);
+	bset1 = isl_basic_set_read_from_str(ctx, str);
+	bset2 = isl_basic_set_from_multi_aff(ma);
+	equal = isl_basic_set_is_equal(bset1, bset2);
+	isl_basic_set_free(bset1);
+	isl_basic_set_free(bset2);
 	if (equal < 0)
-		return -1;
+		return isl_stat_error;
 	if (!equal)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+		isl_die(ctx, isl_error_unknown, "bad conversion",
+			return isl_stat_error);
+	return isl_stat_ok;
+}
 
-	str = "[N,M] -> { [i,j] -> [([i/16]), i%16, ([j/16]), j%16] : "
-			"0 <= i < N and 0 <= j < M }";
-	map = isl_map_read_from_str(ctx, str);
-	set = isl_map_range(map);
+const char *set_conversion_tests[] = {
+	"[N] -> { [i] : N - 1 <= 2 i <= N }",
+	"[N] -> { [i] : exists a : i = 4 a and N - 1 <= i <= N }",
+	"[N] -> { [i,j] : exists a : i = 4 a and N - 1 <= i, 2j <= N }",
+	"[N] -> { [[i]->[j]] : exists a : i = 4 a and N - 1 <= i, 2j <= N }",
+	"[N] -> { [3*floor(N/2) + 5*floor(N/3)] }",
+	"[a, b] -> { [c, d] : (4*floor((-a + c)/4) = -a + c and "
+			"32*floor((-b + d)/32) = -b + d and 5 <= c <= 8 and "
+			"-3 + c <= d <= 28 + c) }",
+};
 
-	pwaff = isl_set_dim_max(isl_set_copy(set), 0);
-	set1 = isl_set_from_pw_aff(pwaff);
-	str = "[N,M] -> { [([(N-1)/16])] : M,N > 0 }";
-	set2 = isl_set_read_from_str(ctx, str);
-	equal = isl_set_is_equal(set1, set2);
-	isl_set_free(set1);
-	isl_set_free(set2);
+/* Check that converting from isl_set to isl_pw_multi_aff and back
+ * to isl_set produces the original isl_set.
+ */
+static int test_set_conversion(isl_ctx *ctx)
+{
+	int i;
+	const char *str;
+	isl_set *set1, *set2;
+	isl_pw_multi_aff *pma;
+	int equal;
 
-	pwaff = isl_set_dim_max(isl_set_copy(set), 3);
-	set1 = isl_set_from_pw_aff(pwaff);
-	str = "[N,M] -> { [t] : t = min(M-1,15) and M,N > 0 }";
-	set2 = isl_set_read_from_str(ctx, str);
-	if (equal >= 0 && equal)
+	for (i = 0; i < ARRAY_SIZE(set_conversion_tests); ++i) {
+		str = set_conversion_tests[i];
+		set1 = isl_set_read_from_str(ctx, str);
+		pma = isl_pw_multi_aff_from_set(isl_set_copy(set1));
+		set2 = isl_set_from_pw_multi_aff(pma);
 		equal = isl_set_is_equal(set1, set2);
-	isl_set_free(set1);
-	isl_set_free(set2);
+		isl_set_free(set1);
+		isl_set_free(set2);
 
-	isl_set_free(set);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown, "bad conversion",
+				return -1);
+	}
 
-	if (equal < 0)
-		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+	return 0;
+}
 
-	/* Check that solutions are properly merged. */
-	str = "[n] -> { [a, b, c] : c >= -4a - 2b and "
-				"c <= -1 + n - 4a - 2b and c >= -2b and "
-				"4a >= -4 + n and c >= 0 }";
-	set = isl_set_read_from_str(ctx, str);
-	pwaff = isl_set_dim_min(set, 2);
-	set1 = isl_set_from_pw_aff(pwaff);
-	str = "[n] -> { [(0)] : n >= 1 }";
-	set2 = isl_set_read_from_str(ctx, str);
-	equal = isl_set_is_equal(set1, set2);
-	isl_set_free(set1);
-	isl_set_free(set2);
+const char *conversion_tests[] = {
+	"{ [a, b, c, d] -> s0[a, b, e, f] : "
+	    "exists (e0 = [(a - 2c)/3], e1 = [(-4 + b - 5d)/9], "
+	    "e2 = [(-d + f)/9]: 3e0 = a - 2c and 9e1 = -4 + b - 5d and "
+	    "9e2 = -d + f and f >= 0 and f <= 8 and 9e >= -5 - 2a and "
+	    "9e <= -2 - 2a) }",
+	"{ [a, b] -> [c] : exists (e0 = floor((-a - b + c)/5): "
+	    "5e0 = -a - b + c and c >= -a and c <= 4 - a) }",
+	"{ [a, b] -> [c] : exists d : 18 * d = -3 - a + 2c and 1 <= c <= 3 }",
+	"{ [i] -> [i] : i < 0; [i] -> [0] : i >= 0 }",
+	"[n] -> { [i, j] -> [i + j, 2i] : i < j; [i, j] -> [j, n] : i >= j }",
+	"{ [i] -> [floor(i/2)] : i >= 0; [i] -> [-i] : i < 0 }",
+	"{ [i] -> [i] : 0 <= i <= 10 or 5 <= i <= 20 and i mod 3 = 0 }",
+};
 
-	if (equal < 0)
-		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+/* Check that converting from isl_map to isl_pw_multi_aff and back
+ * to isl_map produces the original isl_map.
+ */
+static int test_map_conversion(isl_ctx *ctx)
+{
+	int i;
+	isl_map *map1, *map2;
+	isl_pw_multi_aff *pma;
+	int equal;
 
-	/* Check that empty solution lie in the right space. */
-	str = "[n] -> { [t,a] : 1 = 0 }";
-	set = isl_set_read_from_str(ctx, str);
-	pwaff = isl_set_dim_max(set, 0);
-	set1 = isl_set_from_pw_aff(pwaff);
-	str = "[n] -> { [t] : 1 = 0 }";
-	set2 = isl_set_read_from_str(ctx, str);
-	equal = isl_set_is_equal(set1, set2);
-	isl_set_free(set1);
-	isl_set_free(set2);
+	for (i = 0; i < ARRAY_SIZE(conversion_tests); ++i) {
+		map1 = isl_map_read_from_str(ctx, conversion_tests[i]);
+		pma = isl_pw_multi_aff_from_map(isl_map_copy(map1));
+		map2 = isl_map_from_pw_multi_aff(pma);
+		equal = isl_map_is_equal(map1, map2);
+		isl_map_free(map1);
+		isl_map_free(map2);
 
-	if (equal < 0)
-		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown, "bad conversion",
+				return -1);
+	}
 
 	return 0;
 }
 
-/* Basic test for isl_pw_multi_aff_product.
- *
- * Check that multiple pieces are properly handled.
+/* Descriptions of isl_pw_multi_aff objects for testing conversion
+ * to isl_multi_pw_aff and back.
  */
-static int test_product_pma(isl_ctx *ctx)
+const char *mpa_conversion_tests[] = {
+	"{ [x] -> A[x] }",
+	"{ [x] -> A[x] : x >= 0 }",
+	"{ [x] -> A[x] : x >= 0; [x] -> A[-x] : x < 0 }",
+	"{ [x] -> A[x, x + 1] }",
+	"{ [x] -> A[] }",
+	"{ [x] -> A[] : x >= 0 }",
+};
+
+/* Check that conversion from isl_pw_multi_aff to isl_multi_pw_aff and
+ * back to isl_pw_multi_aff preserves the original meaning.
+ */
+static int test_mpa_conversion(isl_ctx *ctx)
 {
-	isl_stat equal;
-	const char *str;
+	int i;
 	isl_pw_multi_aff *pma1, *pma2;
+	isl_multi_pw_aff *mpa;
+	int equal;
 
-	str = "{ A[i] -> B[1] : i < 0; A[i] -> B[2] : i >= 0 }";
-	pma1 = isl_pw_multi_aff_read_from_str(ctx, str);
-	str = "{ C[] -> D[] }";
-	pma2 = isl_pw_multi_aff_read_from_str(ctx, str);
-	pma1 = isl_pw_multi_aff_product(pma1, pma2);
-	str = "{ [A[i] -> C[]] -> [B[(1)] -> D[]] : i < 0;"
-		"[A[i] -> C[]] -> [B[(2)] -> D[]] : i >= 0 }";
-	equal = pw_multi_aff_check_plain_equal(pma1, str);
-	isl_pw_multi_aff_free(pma1);
-	if (equal < 0)
-		return -1;
+	for (i = 0; i < ARRAY_SIZE(mpa_conversion_tests); ++i) {
+		const char *str;
+		str = mpa_conversion_tests[i];
+		pma1 = isl_pw_multi_aff_read_from_str(ctx, str);
+		pma2 = isl_pw_multi_aff_copy(pma1);
+		mpa = isl_multi_pw_aff_from_pw_multi_aff(pma1);
+		pma1 = isl_pw_multi_aff_from_multi_pw_aff(mpa);
+		equal = isl_pw_multi_aff_plain_is_equal(pma1, pma2);
+		isl_pw_multi_aff_free(pma1);
+		isl_pw_multi_aff_free(pma2);
+
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown, "bad conversion",
+				return -1);
+	}
 
 	return 0;
 }
 
-int test_product(isl_ctx *ctx)
+/* Descriptions of union maps that should be convertible
+ * to an isl_multi_union_pw_aff.
+ */
+const char *umap_mupa_conversion_tests[] = {
+	"{ [a, b, c, d] -> s0[a, b, e, f] : "
+	    "exists (e0 = [(a - 2c)/3], e1 = [(-4 + b - 5d)/9], "
+	    "e2 = [(-d + f)/9]: 3e0 = a - 2c and 9e1 = -4 + b - 5d and "
+	    "9e2 = -d + f and f >= 0 and f <= 8 and 9e >= -5 - 2a and "
+	    "9e <= -2 - 2a) }",
+	"{ [a, b] -> [c] : exists (e0 = floor((-a - b + c)/5): "
+	    "5e0 = -a - b + c and c >= -a and c <= 4 - a) }",
+	"{ [a, b] -> [c] : exists d : 18 * d = -3 - a + 2c and 1 <= c <= 3 }",
+	"{ A[] -> B[0]; C[] -> B[1] }",
+	"{ A[] -> B[]; C[] -> B[] }",
+};
+
+/* Check that converting from isl_union_map to isl_multi_union_pw_aff and back
+ * to isl_union_map produces the original isl_union_map.
+ */
+static int test_union_map_mupa_conversion(isl_ctx *ctx)
 {
-	const char *str;
-	isl_set *set;
-	isl_union_set *uset1, *uset2;
-	int ok;
+	int i;
+	isl_union_map *umap1, *umap2;
+	isl_multi_union_pw_aff *mupa;
+	int equal;
 
-	str = "{ A[i] }";
-	set = isl_set_read_from_str(ctx, str);
-	set = isl_set_product(set, isl_set_copy(set));
-	ok = isl_set_is_wrapping(set);
-	isl_set_free(set);
-	if (ok < 0)
-		return -1;
-	if (!ok)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+	for (i = 0; i < ARRAY_SIZE(umap_mupa_conversion_tests); ++i) {
+		const char *str;
+		str = umap_mupa_conversion_tests[i];
+		umap1 = isl_union_map_read_from_str(ctx, str);
+		umap2 = isl_union_map_copy(umap1);
+		mupa = isl_multi_union_pw_aff_from_union_map(umap2);
+		umap2 = isl_union_map_from_multi_union_pw_aff(mupa);
+		equal = isl_union_map_is_equal(umap1, umap2);
+		isl_union_map_free(umap1);
+		isl_union_map_free(umap2);
 
-	str = "{ [] }";
-	uset1 = isl_union_set_read_from_str(ctx, str);
-	uset1 = isl_union_set_product(uset1, isl_union_set_copy(uset1));
-	str = "{ [[] -> []] }";
-	uset2 = isl_union_set_read_from_str(ctx, str);
-	ok = isl_union_set_is_equal(uset1, uset2);
-	isl_union_set_free(uset1);
-	isl_union_set_free(uset2);
-	if (ok < 0)
-		return -1;
-	if (!ok)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown, "bad conversion",
+				return -1);
+	}
 
-	if (test_product_pma(ctx) < 0)
-		return -1;
+	return 0;
+}
 
+static int test_conversion(isl_ctx *ctx)
+{
+	if (test_ma_conversion(ctx) < 0)
+		return -1;
+	if (test_set_conversion(ctx) < 0)
+		return -1;
+	if (test_map_conversion(ctx) < 0)
+		return -1;
+	if (test_mpa_conversion(ctx) < 0)
+		return -1;
+	if (test_union_map_mupa_conversion(ctx) < 0)
+		return -1;
 	return 0;
 }
 
-/* Check that two sets are not considered disjoint just because
- * they have a different set of (named) parameters.
+/* Check that isl_basic_map_curry does not modify input.
  */
-static int test_disjoint(isl_ctx *ctx)
+static int test_curry(isl_ctx *ctx)
 {
 	const char *str;
-	isl_set *set, *set2;
-	int disjoint;
+	isl_basic_map *bmap1, *bmap2;
+	int equal;
 
-	str = "[n] -> { [[]->[]] }";
-	set = isl_set_read_from_str(ctx, str);
-	str = "{ [[]->[]] }";
-	set2 = isl_set_read_from_str(ctx, str);
-	disjoint = isl_set_is_disjoint(set, set2);
-	isl_set_free(set);
-	isl_set_free(set2);
-	if (disjoint < 0)
+	str = "{ [A[] -> B[]] -> C[] }";
+	bmap1 = isl_basic_map_read_from_str(ctx, str);
+	bmap2 = isl_basic_map_curry(isl_basic_map_copy(bmap1));
+	equal = isl_basic_map_is_equal(bmap1, bmap2);
+	isl_basic_map_free(bmap1);
+	isl_basic_map_free(bmap2);
+
+	if (equal < 0)
 		return -1;
-	if (disjoint)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+	if (equal)
+		isl_die(ctx, isl_error_unknown,
+			"curried map should not be equal to original",
+			return -1);
 
 	return 0;
 }
 
-/* Inputs for isl_pw_multi_aff_is_equal tests.
- * "f1" and "f2" are the two function that need to be compared.
- * "equal" is the expected result.
+struct {
+	const char *ma1;
+	const char *ma;
+	const char *res;
+} pullback_tests[] = {
+	{ "{ B[i,j] -> C[i + 2j] }" , "{ A[a,b] -> B[b,a] }",
+	  "{ A[a,b] -> C[b + 2a] }" },
+	{ "{ B[i] -> C[2i] }", "{ A[a] -> B[(a)/2] }", "{ A[a] -> C[a] }" },
+	{ "{ B[i] -> C[(i)/2] }", "{ A[a] -> B[2a] }", "{ A[a] -> C[a] }" },
+	{ "{ B[i] -> C[(i)/2] }", "{ A[a] -> B[(a)/3] }",
+	  "{ A[a] -> C[(a)/6] }" },
+	{ "{ B[i] -> C[2i] }", "{ A[a] -> B[5a] }", "{ A[a] -> C[10a] }" },
+	{ "{ B[i] -> C[2i] }", "{ A[a] -> B[(a)/3] }",
+	  "{ A[a] -> C[(2a)/3] }" },
+	{ "{ B[i,j] -> C[i + j] }", "{ A[a] -> B[a,a] }", "{ A[a] -> C[2a] }"},
+	{ "{ B[a] -> C[a,a] }", "{ A[i,j] -> B[i + j] }",
+	  "{ A[i,j] -> C[i + j, i + j] }"},
+	{ "{ B[i] -> C[([i/2])] }", "{ B[5] }", "{ C[2] }" },
+	{ "[n] -> { B[i,j] -> C[([i/2]) + 2j] }",
+	  "[n] -> { B[n,[n/3]] }", "[n] -> { C[([n/2]) + 2*[n/3]] }", },
+	{ "{ [i, j] -> [floor((i)/4) + floor((2*i+j)/5)] }",
+	  "{ [i, j] -> [floor((i)/3), j] }",
+	  "{ [i, j] -> [(floor((i)/12) + floor((j + 2*floor((i)/3))/5))] }" },
+};
+
+/* Inputs for preimage tests of maps under multi-affine expressions
+ * that simply select some of their domain variables, as well as
+ * one that does not.
+ * "type" is the tuple of "map" in which "ma" is plugged in,
+ * with isl_dim_out (or isl_dim_set) referring to the range (or set).
  */
 struct {
-	int equal;
-	const char *f1;
-	const char *f2;
-} pma_equal_tests[] = {
-	{ 1, "[N] -> { [floor(N/2)] : 0 <= N <= 1 }",
-	     "[N] -> { [0] : 0 <= N <= 1 }" },
-	{ 1, "[N] -> { [floor(N/2)] : 0 <= N <= 2 }",
-	     "[N] -> { [0] : 0 <= N <= 1; [1] : N = 2 }" },
-	{ 0, "[N] -> { [floor(N/2)] : 0 <= N <= 2 }",
-	     "[N] -> { [0] : 0 <= N <= 1 }" },
-	{ 0, "{ [NaN] }", "{ [NaN] }" },
+	const char *map;
+	enum isl_dim_type type;
+	const char *ma;
+	const char *res;
+} preimage_ma_tests[] = {
+	{ "{ A[i, j] : 0 <= i < j < 10 }", isl_dim_set,
+	  "{ B[a, b] -> A[b, a] }", "{ B[a, b] : 0 <= b < a < 10 }" },
+	{ "{ A[i] : i >= 0 }", isl_dim_set,
+	  "{ B[a, b] -> A[b] }", "{ B[a, b] : b >= 0 }" },
+	{ "{ A[i, j] : exists (e : j = 2e) and i >= j }", isl_dim_set,
+	  "[n] -> { B[x, y, z] -> A[z, x] }",
+	  "[n] -> { B[x, y, z] : exists (e : x = 2e) and z >= x }" },
+	{ "{ A[i, j] -> C[k] : k = i + 2j }", isl_dim_in,
+	  "{ B[a, b] -> A[b, a] }", "{ B[a, b] -> C[k] : k = b + 2a }" },
+	{ "{ C[k] -> A[i, j] : i + 2j = k }", isl_dim_out,
+	  "{ B[a, b, c] -> A[c, a] }",
+	  "{ C[k] -> B[a, b, c] : c + 2a = k }" },
+	{ "{ A[i, j] : i < j }", isl_dim_set,
+	  "{ B[a] -> A[a, a] }", "{ B[a] : false }" },
 };
 
-int test_equal(isl_ctx *ctx)
+/* Perform the preimage tests in preimage_ma_tests.
+ */
+static isl_stat test_preimage_multi_aff(isl_ctx *ctx)
 {
 	int i;
-	const char *str;
-	isl_set *set, *set2;
-	int equal;
 
-	str = "{ S_6[i] }";
-	set = isl_set_read_from_str(ctx, str);
-	str = "{ S_7[i] }";
-	set2 = isl_set_read_from_str(ctx, str);
-	equal = isl_set_is_equal(set, set2);
-	isl_set_free(set);
-	isl_set_free(set2);
-	if (equal < 0)
-		return -1;
-	if (equal)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+	for (i = 0; i < ARRAY_SIZE(preimage_ma_tests); ++i) {
+		isl_map *map, *res;
+		isl_multi_aff *ma;
+		isl_bool equal;
 
-	for (i = 0; i < ARRAY_SIZE(pma_equal_tests); ++i) {
-		int expected = pma_equal_tests[i].equal;
-		isl_pw_multi_aff *f1, *f2;
+		map = isl_map_read_from_str(ctx, preimage_ma_tests[i].map);
+		ma = isl_multi_aff_read_from_str(ctx, preimage_ma_tests[i].ma);
+		res = isl_map_read_from_str(ctx, preimage_ma_tests[i].res);
+		if (preimage_ma_tests[i].type == isl_dim_in)
+			map = isl_map_preimage_domain_multi_aff(map, ma);
+		else
+			map = isl_map_preimage_range_multi_aff(map, ma);
+		equal = isl_map_is_equal(map, res);
+		isl_map_free(map);
+		isl_map_free(res);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown, "bad preimage",
+				return isl_stat_error);
+	}
 
-		f1 = isl_pw_multi_aff_read_from_str(ctx, pma_equal_tests[i].f1);
-		f2 = isl_pw_multi_aff_read_from_str(ctx, pma_equal_tests[i].f2);
-		equal = isl_pw_multi_aff_is_equal(f1, f2);
-		isl_pw_multi_aff_free(f1);
-		isl_pw_multi_aff_free(f2);
+	return isl_stat_ok;
+}
+
+static int test_pullback(isl_ctx *ctx)
+{
+	int i;
+	isl_multi_aff *ma1, *ma2;
+	isl_multi_aff *ma;
+	int equal;
+
+	for (i = 0; i < ARRAY_SIZE(pullback_tests); ++i) {
+		ma1 = isl_multi_aff_read_from_str(ctx, pullback_tests[i].ma1);
+		ma = isl_multi_aff_read_from_str(ctx, pullback_tests[i].ma);
+		ma2 = isl_multi_aff_read_from_str(ctx, pullback_tests[i].res);
+		ma1 = isl_multi_aff_pullback_multi_aff(ma1, ma);
+		equal = isl_multi_aff_plain_is_equal(ma1, ma2);
+		isl_multi_aff_free(ma1);
+		isl_multi_aff_free(ma2);
 		if (equal < 0)
 			return -1;
-		if (equal != expected)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected equality result", return -1);
+		if (!equal)
+			isl_die(ctx, isl_error_unknown, "bad pullback",
+				return -1);
 	}
 
+	if (test_preimage_multi_aff(ctx) < 0)
+		return -1;
+
 	return 0;
 }
 
-static int test_plain_fixed(isl_ctx *ctx, __isl_take isl_map *map,
-	enum isl_dim_type type, unsigned pos, int fixed)
+/* Check that negation is printed correctly and that equal expressions
+ * are correctly identified.
+ */
+static int test_ast(isl_ctx *ctx)
 {
-	isl_bool test;
+	isl_ast_expr *expr, *expr1, *expr2, *expr3;
+	char *str;
+	int ok, equal;
 
-	test = isl_map_plain_is_fixed(map, type, pos, NULL);
-	isl_map_free(map);
-	if (test < 0)
+	expr1 = isl_ast_expr_from_id(isl_id_alloc(ctx, "A", NULL));
+	expr2 = isl_ast_expr_from_id(isl_id_alloc(ctx, "B", NULL));
+	expr = isl_ast_expr_add(expr1, expr2);
+	expr2 = isl_ast_expr_copy(expr);
+	expr = isl_ast_expr_neg(expr);
+	expr2 = isl_ast_expr_neg(expr2);
+	equal = isl_ast_expr_is_equal(expr, expr2);
+	str = isl_ast_expr_to_C_str(expr);
+	ok = str ? !strcmp(str, "-(A + B)") : -1;
+	free(str);
+	isl_ast_expr_free(expr);
+	isl_ast_expr_free(expr2);
+
+	if (ok < 0 || equal < 0)
 		return -1;
-	if (test == fixed)
-		return 0;
-	if (fixed)
+	if (!equal)
 		isl_die(ctx, isl_error_unknown,
-			"map not detected as fixed", return -1);
-	else
+			"equal expressions not considered equal", return -1);
+	if (!ok)
 		isl_die(ctx, isl_error_unknown,
-			"map detected as fixed", return -1);
+			"isl_ast_expr printed incorrectly", return -1);
+
+	expr1 = isl_ast_expr_from_id(isl_id_alloc(ctx, "A", NULL));
+	expr2 = isl_ast_expr_from_id(isl_id_alloc(ctx, "B", NULL));
+	expr = isl_ast_expr_add(expr1, expr2);
+	expr3 = isl_ast_expr_from_id(isl_id_alloc(ctx, "C", NULL));
+	expr = isl_ast_expr_sub(expr3, expr);
+	str = isl_ast_expr_to_C_str(expr);
+	ok = str ? !strcmp(str, "C - (A + B)") : -1;
+	free(str);
+	isl_ast_expr_free(expr);
+
+	if (ok < 0)
+		return -1;
+	if (!ok)
+		isl_die(ctx, isl_error_unknown,
+			"isl_ast_expr printed incorrectly", return -1);
+
+	return 0;
 }
 
-int test_fixed(isl_ctx *ctx)
+/* Check that isl_ast_build_expr_from_set returns a valid expression
+ * for an empty set.  Note that isl_ast_build_expr_from_set getting
+ * called on an empty set probably indicates a bug in the caller.
+ */
+static int test_ast_build(isl_ctx *ctx)
 {
-	const char *str;
-	isl_map *map;
+	isl_set *set;
+	isl_ast_build *build;
+	isl_ast_expr *expr;
 
-	str = "{ [i] -> [i] }";
-	map = isl_map_read_from_str(ctx, str);
-	if (test_plain_fixed(ctx, map, isl_dim_out, 0, 0))
-		return -1;
-	str = "{ [i] -> [1] }";
-	map = isl_map_read_from_str(ctx, str);
-	if (test_plain_fixed(ctx, map, isl_dim_out, 0, 1))
-		return -1;
-	str = "{ S_1[p1] -> [o0] : o0 = -2 and p1 >= 1 and p1 <= 7 }";
-	map = isl_map_read_from_str(ctx, str);
-	if (test_plain_fixed(ctx, map, isl_dim_out, 0, 1))
-		return -1;
-	map = isl_map_read_from_str(ctx, str);
-	map = isl_map_neg(map);
-	if (test_plain_fixed(ctx, map, isl_dim_out, 0, 1))
+	set = isl_set_universe(isl_space_params_alloc(ctx, 0));
+	build = isl_ast_build_from_context(set);
+
+	set = isl_set_empty(isl_space_params_alloc(ctx, 0));
+	expr = isl_ast_build_expr_from_set(build, set);
+
+	isl_ast_expr_free(expr);
+	isl_ast_build_free(build);
+
+	if (!expr)
 		return -1;
 
 	return 0;
 }
 
-struct isl_vertices_test_data {
-	const char *set;
-	int n;
-	const char *vertex[6];
-} vertices_tests[] = {
-	{ "{ A[t, i] : t = 12 and i >= 4 and i <= 12 }",
-	  2, { "{ A[12, 4] }", "{ A[12, 12] }" } },
-	{ "{ A[t, i] : t = 14 and i = 1 }",
-	  1, { "{ A[14, 1] }" } },
-	{ "[n, m] -> { [a, b, c] : b <= a and a <= n and b > 0 and c >= b and "
-				"c <= m and m <= n and m > 0 }",
-	  6, {
-		"[n, m] -> { [n, m, m] : 0 < m <= n }",
-		"[n, m] -> { [n, 1, m] : 0 < m <= n }",
-		"[n, m] -> { [n, 1, 1] : 0 < m <= n }",
-		"[n, m] -> { [m, m, m] : 0 < m <= n }",
-		"[n, m] -> { [1, 1, m] : 0 < m <= n }",
-		"[n, m] -> { [1, 1, 1] : 0 < m <= n }"
-	    } },
-	/* An input with implicit equality constraints among the parameters. */
-	{ "[N, M] -> { [a, b] : M >= 3 and 9 + 3M <= a <= 29 + 2N + 11M and "
-			    "2b >= M + a and 5 - 2N - M + a <= 2b <= 3 + a and "
-			    "3b >= 15 + a }",
-	  2, {
-		"[N, M] -> { [(21), (12)] : M = 3 and N >= 0 }",
-		"[N, M] -> { [(61 + 2N), (32 + N)] : M = 3 and N >= 0 }",
-	     }
-	},
+/* Internal data structure for before_for and after_for callbacks.
+ *
+ * depth is the current depth
+ * before is the number of times before_for has been called
+ * after is the number of times after_for has been called
+ */
+struct isl_test_codegen_data {
+	int depth;
+	int before;
+	int after;
 };
 
-/* Check that "vertex" corresponds to one of the vertices in data->vertex.
+/* This function is called before each for loop in the AST generated
+ * from test_ast_gen1.
+ *
+ * Increment the number of calls and the depth.
+ * Check that the space returned by isl_ast_build_get_schedule_space
+ * matches the target space of the schedule returned by
+ * isl_ast_build_get_schedule.
+ * Return an isl_id that is checked by the corresponding call
+ * to after_for.
  */
-static isl_stat find_vertex(__isl_take isl_vertex *vertex, void *user)
+static __isl_give isl_id *before_for(__isl_keep isl_ast_build *build,
+	void *user)
 {
-	struct isl_vertices_test_data *data = user;
+	struct isl_test_codegen_data *data = user;
 	isl_ctx *ctx;
-	isl_multi_aff *ma;
-	isl_basic_set *bset;
-	isl_pw_multi_aff *pma;
-	int i;
-	isl_bool equal;
+	isl_space *space;
+	isl_union_map *schedule;
+	isl_union_set *uset;
+	isl_set *set;
+	isl_bool empty;
+	isl_size n;
+	char name[] = "d0";
 
-	ctx = isl_vertex_get_ctx(vertex);
-	bset = isl_vertex_get_domain(vertex);
-	ma = isl_vertex_get_expr(vertex);
-	pma = isl_pw_multi_aff_alloc(isl_set_from_basic_set(bset), ma);
+	ctx = isl_ast_build_get_ctx(build);
 
-	for (i = 0; i < data->n; ++i) {
-		isl_pw_multi_aff *pma_i;
+	if (data->before >= 3)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected number of for nodes", return NULL);
+	if (data->depth < 0 || data->depth >= 2)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected depth", return NULL);
 
-		pma_i = isl_pw_multi_aff_read_from_str(ctx, data->vertex[i]);
-		equal = isl_pw_multi_aff_plain_is_equal(pma, pma_i);
-		isl_pw_multi_aff_free(pma_i);
+	snprintf(name, sizeof(name), "d%d", data->depth);
+	data->before++;
+	data->depth++;
 
-		if (equal < 0 || equal)
-			break;
+	schedule = isl_ast_build_get_schedule(build);
+	uset = isl_union_map_range(schedule);
+	n = isl_union_set_n_set(uset);
+	if (n != 1) {
+		isl_union_set_free(uset);
+		if (n < 0)
+			return NULL;
+		isl_die(ctx, isl_error_unknown,
+			"expecting single range space", return NULL);
 	}
 
-	isl_pw_multi_aff_free(pma);
-	isl_vertex_free(vertex);
+	space = isl_ast_build_get_schedule_space(build);
+	set = isl_union_set_extract_set(uset, space);
+	isl_union_set_free(uset);
+	empty = isl_set_is_empty(set);
+	isl_set_free(set);
 
-	if (equal < 0)
-		return isl_stat_error;
+	if (empty < 0)
+		return NULL;
+	if (empty)
+		isl_die(ctx, isl_error_unknown,
+			"spaces don't match", return NULL);
 
-	return equal ? isl_stat_ok : isl_stat_error;
+	return isl_id_alloc(ctx, name, NULL);
 }
 
-int test_vertices(isl_ctx *ctx)
+/* This function is called after each for loop in the AST generated
+ * from test_ast_gen1.
+ *
+ * Increment the number of calls and decrement the depth.
+ * Check that the annotation attached to the node matches
+ * the isl_id returned by the corresponding call to before_for.
+ */
+static __isl_give isl_ast_node *after_for(__isl_take isl_ast_node *node,
+	__isl_keep isl_ast_build *build, void *user)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(vertices_tests); ++i) {
-		isl_basic_set *bset;
-		isl_vertices *vertices;
-		int ok = 1;
-		isl_size n;
-
-		bset = isl_basic_set_read_from_str(ctx, vertices_tests[i].set);
-		vertices = isl_basic_set_compute_vertices(bset);
-		n = isl_vertices_get_n_vertices(vertices);
-		if (vertices_tests[i].n != n)
-			ok = 0;
-		if (isl_vertices_foreach_vertex(vertices, &find_vertex,
-						&vertices_tests[i]) < 0)
-			ok = 0;
-		isl_vertices_free(vertices);
-		isl_basic_set_free(bset);
-
-		if (n < 0)
-			return -1;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown, "unexpected vertices",
-				return -1);
-	}
+	struct isl_test_codegen_data *data = user;
+	isl_id *id;
+	const char *name;
+	int valid;
 
-	return 0;
-}
+	data->after++;
+	data->depth--;
 
-/* Inputs for basic tests of unary operations on isl_union_map.
- * "fn" is the function that is being tested.
- * "arg" is a string description of the input.
- * "res" is a string description of the expected result.
- */
-static struct {
-	__isl_give isl_union_map *(*fn)(__isl_take isl_union_map *umap);
-	const char *arg;
-	const char *res;
-} umap_un_tests[] = {
-	{ &isl_union_map_range_reverse,
-	  "{ A[] -> [B[] -> C[]]; A[] -> B[]; A[0] -> N[B[1] -> B[2]] }",
-	  "{ A[] -> [C[] -> B[]]; A[0] -> N[B[2] -> B[1]] }" },
-	{ &isl_union_map_range_reverse,
-	  "{ A[] -> N[B[] -> C[]] }",
-	  "{ A[] -> [C[] -> B[]] }" },
-	{ &isl_union_map_range_reverse,
-	  "{ A[] -> N[B[x] -> B[y]] }",
-	  "{ A[] -> N[B[*] -> B[*]] }" },
-};
+	if (data->after > data->before)
+		isl_die(isl_ast_node_get_ctx(node), isl_error_unknown,
+			"mismatch in number of for nodes",
+			return isl_ast_node_free(node));
 
-/* Perform basic tests of unary operations on isl_union_map.
- */
-static isl_stat test_un_union_map(isl_ctx *ctx)
-{
-	int i;
+	id = isl_ast_node_get_annotation(node);
+	if (!id)
+		isl_die(isl_ast_node_get_ctx(node), isl_error_unknown,
+			"missing annotation", return isl_ast_node_free(node));
 
-	for (i = 0; i < ARRAY_SIZE(umap_un_tests); ++i) {
-		const char *str;
-		isl_union_map *umap, *res;
-		isl_bool equal;
+	name = isl_id_get_name(id);
+	valid = name && atoi(name + 1) == data->depth;
+	isl_id_free(id);
 
-		str = umap_un_tests[i].arg;
-		umap = isl_union_map_read_from_str(ctx, str);
-		str = umap_un_tests[i].res;
-		res = isl_union_map_read_from_str(ctx, str);
-		umap = umap_un_tests[i].fn(umap);
-		equal = isl_union_map_is_equal(umap, res);
-		isl_union_map_free(umap);
-		isl_union_map_free(res);
-		if (equal < 0)
-			return isl_stat_error;
-		if (!equal)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return isl_stat_error);
-	}
+	if (!valid)
+		isl_die(isl_ast_node_get_ctx(node), isl_error_unknown,
+			"wrong annotation", return isl_ast_node_free(node));
 
-	return isl_stat_ok;
+	return node;
 }
 
-/* Inputs for basic tests of binary operations on isl_union_map.
- * "fn" is the function that is being tested.
- * "arg1" and "arg2" are string descriptions of the inputs.
- * "res" is a string description of the expected result.
+/* Check that the before_each_for and after_each_for callbacks
+ * are called for each for loop in the generated code,
+ * that they are called in the right order and that the isl_id
+ * returned from the before_each_for callback is attached to
+ * the isl_ast_node passed to the corresponding after_each_for call.
  */
-static struct {
-	__isl_give isl_union_map *(*fn)(__isl_take isl_union_map *umap1,
-				__isl_take isl_union_map *umap2);
-	const char *arg1;
-	const char *arg2;
-	const char *res;
-} umap_bin_tests[] = {
-	{ &isl_union_map_intersect,
-	  "[n] -> { A[i] -> [] : 0 <= i <= n; B[] -> [] }",
-	  "[m] -> { A[i] -> [] : 0 <= i <= m; C[] -> [] }",
-	  "[m, n] -> { A[i] -> [] : 0 <= i <= n and i <= m }" },
-	{ &isl_union_map_intersect_domain_factor_domain,
-	  "{ [A[i] -> B[i + 1]] -> C[i + 2] }",
-	  "[N] -> { B[i] -> C[N] }",
-	  "{ }" },
-	{ &isl_union_map_intersect_domain_factor_domain,
-	  "{ [A[i] -> B[i + 1]] -> C[i + 2] }",
-	  "[N] -> { A[i] -> C[N] }",
-	  "[N] -> { [A[N - 2] -> B[N - 1]] -> C[N] }" },
-	{ &isl_union_map_intersect_domain_factor_domain,
-	  "{ T[A[i] -> B[i + 1]] -> C[i + 2] }",
-	  "[N] -> { A[i] -> C[N] }",
-	  "[N] -> { T[A[N - 2] -> B[N - 1]] -> C[N] }" },
-	{ &isl_union_map_intersect_domain_factor_range,
-	  "{ [A[i] -> B[i + 1]] -> C[i + 2] }",
-	  "[N] -> { B[i] -> C[N] }",
-	  "[N] -> { [A[N - 2] -> B[N - 1]] -> C[N] }" },
-	{ &isl_union_map_intersect_domain_factor_range,
-	  "{ T[A[i] -> B[i + 1]] -> C[i + 2] }",
-	  "[N] -> { B[i] -> C[N] }",
-	  "[N] -> { T[A[N - 2] -> B[N - 1]] -> C[N] }" },
-	{ &isl_union_map_intersect_domain_factor_range,
-	  "{ [A[i] -> B[i + 1]] -> C[i + 2] }",
-	  "[N] -> { A[i] -> C[N] }",
-	  "{ }" },
-	{ &isl_union_map_intersect_range_factor_domain,
-	  "{ A[i] -> [B[i + 1] -> C[i + 2]] }",
-	  "[N] -> { A[i] -> B[N] }",
-	  "[N] -> { A[N - 1] -> [B[N] -> C[N + 1]] }" },
-	{ &isl_union_map_intersect_range_factor_domain,
-	  "{ A[i] -> T[B[i + 1] -> C[i + 2]] }",
-	  "[N] -> { A[i] -> B[N] }",
-	  "[N] -> { A[N - 1] -> T[B[N] -> C[N + 1]] }" },
-	{ &isl_union_map_intersect_range_factor_domain,
-	  "{ A[i] -> [B[i + 1] -> C[i + 2]] }",
-	  "[N] -> { A[i] -> C[N] }",
-	  "{ }" },
-	{ &isl_union_map_intersect_range_factor_range,
-	  "{ A[i] -> [B[i + 1] -> C[i + 2]] }",
-	  "[N] -> { A[i] -> C[N] }",
-	  "[N] -> { A[N - 2] -> [B[N - 1] -> C[N]] }" },
-	{ &isl_union_map_intersect_range_factor_range,
-	  "{ A[i] -> T[B[i + 1] -> C[i + 2]] }",
-	  "[N] -> { A[i] -> C[N] }",
-	  "[N] -> { A[N - 2] -> T[B[N - 1] -> C[N]] }" },
-	{ &isl_union_map_intersect_range_factor_range,
-	  "{ A[i] -> [B[i + 1] -> C[i + 2]] }",
-	  "[N] -> { A[i] -> B[N] }",
-	  "{ }" },
-};
+static int test_ast_gen1(isl_ctx *ctx)
+{
+	const char *str;
+	isl_set *set;
+	isl_union_map *schedule;
+	isl_ast_build *build;
+	isl_ast_node *tree;
+	struct isl_test_codegen_data data;
+
+	str = "[N] -> { : N >= 10 }";
+	set = isl_set_read_from_str(ctx, str);
+	str = "[N] -> { A[i,j] -> S[8,i,3,j] : 0 <= i,j <= N; "
+		    "B[i,j] -> S[8,j,9,i] : 0 <= i,j <= N }";
+	schedule = isl_union_map_read_from_str(ctx, str);
 
-/* Perform basic tests of binary operations on isl_union_map.
+	data.before = 0;
+	data.after = 0;
+	data.depth = 0;
+	build = isl_ast_build_from_context(set);
+	build = isl_ast_build_set_before_each_for(build,
+			&before_for, &data);
+	build = isl_ast_build_set_after_each_for(build,
+			&after_for, &data);
+	tree = isl_ast_build_node_from_schedule_map(build, schedule);
+	isl_ast_build_free(build);
+	if (!tree)
+		return -1;
+
+	isl_ast_node_free(tree);
+
+	if (data.before != 3 || data.after != 3)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected number of for nodes", return -1);
+
+	return 0;
+}
+
+/* Check that the AST generator handles domains that are integrally disjoint
+ * but not rationally disjoint.
  */
-static isl_stat test_bin_union_map(isl_ctx *ctx)
+static int test_ast_gen2(isl_ctx *ctx)
 {
-	int i;
+	const char *str;
+	isl_set *set;
+	isl_union_map *schedule;
+	isl_union_map *options;
+	isl_ast_build *build;
+	isl_ast_node *tree;
 
-	for (i = 0; i < ARRAY_SIZE(umap_bin_tests); ++i) {
-		const char *str;
-		isl_union_map *umap1, *umap2, *res;
-		isl_bool equal;
+	str = "{ A[i,j] -> [i,j] : 0 <= i,j <= 1 }";
+	schedule = isl_union_map_read_from_str(ctx, str);
+	set = isl_set_universe(isl_space_params_alloc(ctx, 0));
+	build = isl_ast_build_from_context(set);
 
-		str = umap_bin_tests[i].arg1;
-		umap1 = isl_union_map_read_from_str(ctx, str);
-		str = umap_bin_tests[i].arg2;
-		umap2 = isl_union_map_read_from_str(ctx, str);
-		str = umap_bin_tests[i].res;
-		res = isl_union_map_read_from_str(ctx, str);
-		umap1 = umap_bin_tests[i].fn(umap1, umap2);
-		equal = isl_union_map_is_equal(umap1, res);
-		isl_union_map_free(umap1);
-		isl_union_map_free(res);
-		if (equal < 0)
-			return isl_stat_error;
-		if (!equal)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return isl_stat_error);
-	}
+	str = "{ [i,j] -> atomic[1] : i + j = 1; [i,j] -> unroll[1] : i = j }";
+	options = isl_union_map_read_from_str(ctx, str);
+	build = isl_ast_build_set_options(build, options);
+	tree = isl_ast_build_node_from_schedule_map(build, schedule);
+	isl_ast_build_free(build);
+	if (!tree)
+		return -1;
+	isl_ast_node_free(tree);
 
-	return isl_stat_ok;
+	return 0;
 }
 
-/* Check that isl_union_set_contains finds space independently
- * of the parameters.
+/* Increment *user on each call.
  */
-static isl_stat test_union_set_contains(isl_ctx *ctx)
+static __isl_give isl_ast_node *count_domains(__isl_take isl_ast_node *node,
+	__isl_keep isl_ast_build *build, void *user)
+{
+	int *n = user;
+
+	(*n)++;
+
+	return node;
+}
+
+/* Test that unrolling tries to minimize the number of instances.
+ * In particular, for the schedule given below, make sure it generates
+ * 3 nodes (rather than 101).
+ */
+static int test_ast_gen3(isl_ctx *ctx)
 {
 	const char *str;
-	isl_bool ok;
-	isl_space *space;
-	isl_id *id;
-	isl_union_set *uset;
+	isl_set *set;
+	isl_union_map *schedule;
+	isl_union_map *options;
+	isl_ast_build *build;
+	isl_ast_node *tree;
+	int n_domain = 0;
 
-	str = "[N] -> { A[0:N]; B[*,*] }";
-	uset = isl_union_set_read_from_str(ctx, str);
-	space = isl_space_unit(ctx);
-	id = isl_id_alloc(ctx, "A", NULL);
-	space = isl_space_add_named_tuple_id_ui(space, id, 1);
-	ok = isl_union_set_contains(uset, space);
-	isl_space_free(space);
-	isl_union_set_free(uset);
+	str = "[n] -> { A[i] -> [i] : 0 <= i <= 100 and n <= i <= n + 2 }";
+	schedule = isl_union_map_read_from_str(ctx, str);
+	set = isl_set_universe(isl_space_params_alloc(ctx, 0));
 
-	if (ok < 0)
-		return isl_stat_error;
-	if (!ok)
+	str = "{ [i] -> unroll[0] }";
+	options = isl_union_map_read_from_str(ctx, str);
+
+	build = isl_ast_build_from_context(set);
+	build = isl_ast_build_set_options(build, options);
+	build = isl_ast_build_set_at_each_domain(build,
+			&count_domains, &n_domain);
+	tree = isl_ast_build_node_from_schedule_map(build, schedule);
+	isl_ast_build_free(build);
+	if (!tree)
+		return -1;
+
+	isl_ast_node_free(tree);
+
+	if (n_domain != 3)
 		isl_die(ctx, isl_error_unknown,
-			"unexpected result", return isl_stat_error);
+			"unexpected number of for nodes", return -1);
 
-	return isl_stat_ok;
+	return 0;
 }
 
-/* Perform basic tests of operations on isl_union_map or isl_union_set.
+/* Check that if the ast_build_exploit_nested_bounds options is set,
+ * we do not get an outer if node in the generated AST,
+ * while we do get such an outer if node if the options is not set.
  */
-static int test_union_map(isl_ctx *ctx)
+static int test_ast_gen4(isl_ctx *ctx)
 {
-	if (test_un_union_map(ctx) < 0)
-		return -1;
-	if (test_bin_union_map(ctx) < 0)
+	const char *str;
+	isl_set *set;
+	isl_union_map *schedule;
+	isl_ast_build *build;
+	isl_ast_node *tree;
+	enum isl_ast_node_type type;
+	int enb;
+
+	enb = isl_options_get_ast_build_exploit_nested_bounds(ctx);
+	str = "[N,M] -> { A[i,j] -> [i,j] : 0 <= i <= N and 0 <= j <= M }";
+
+	isl_options_set_ast_build_exploit_nested_bounds(ctx, 1);
+
+	schedule = isl_union_map_read_from_str(ctx, str);
+	set = isl_set_universe(isl_space_params_alloc(ctx, 0));
+	build = isl_ast_build_from_context(set);
+	tree = isl_ast_build_node_from_schedule_map(build, schedule);
+	isl_ast_build_free(build);
+	if (!tree)
 		return -1;
-	if (test_union_set_contains(ctx) < 0)
+
+	type = isl_ast_node_get_type(tree);
+	isl_ast_node_free(tree);
+
+	if (type == isl_ast_node_if)
+		isl_die(ctx, isl_error_unknown,
+			"not expecting if node", return -1);
+
+	isl_options_set_ast_build_exploit_nested_bounds(ctx, 0);
+
+	schedule = isl_union_map_read_from_str(ctx, str);
+	set = isl_set_universe(isl_space_params_alloc(ctx, 0));
+	build = isl_ast_build_from_context(set);
+	tree = isl_ast_build_node_from_schedule_map(build, schedule);
+	isl_ast_build_free(build);
+	if (!tree)
 		return -1;
+
+	type = isl_ast_node_get_type(tree);
+	isl_ast_node_free(tree);
+
+	if (type != isl_ast_node_if)
+		isl_die(ctx, isl_error_unknown,
+			"expecting if node", return -1);
+
+	isl_options_set_ast_build_exploit_nested_bounds(ctx, enb);
+
 	return 0;
 }
 
-int test_union_pw(isl_ctx *ctx)
+/* This function is called for each leaf in the AST generated
+ * from test_ast_gen5.
+ *
+ * We finalize the AST generation by extending the outer schedule
+ * with a zero-dimensional schedule.  If this results in any for loops,
+ * then this means that we did not pass along enough information
+ * about the outer schedule to the inner AST generation.
+ */
+static __isl_give isl_ast_node *create_leaf(__isl_take isl_ast_build *build,
+	void *user)
+{
+	isl_union_map *schedule, *extra;
+	isl_ast_node *tree;
+
+	schedule = isl_ast_build_get_schedule(build);
+	extra = isl_union_map_copy(schedule);
+	extra = isl_union_map_from_domain(isl_union_map_domain(extra));
+	schedule = isl_union_map_range_product(schedule, extra);
+	tree = isl_ast_build_node_from_schedule_map(build, schedule);
+	isl_ast_build_free(build);
+
+	if (!tree)
+		return NULL;
+
+	if (isl_ast_node_get_type(tree) == isl_ast_node_for)
+		isl_die(isl_ast_node_get_ctx(tree), isl_error_unknown,
+			"code should not contain any for loop",
+			return isl_ast_node_free(tree));
+
+	return tree;
+}
+
+/* Check that we do not lose any information when going back and
+ * forth between internal and external schedule.
+ *
+ * In particular, we create an AST where we unroll the only
+ * non-constant dimension in the schedule.  We therefore do
+ * not expect any for loops in the AST.  However, older versions
+ * of isl would not pass along enough information about the outer
+ * schedule when performing an inner code generation from a create_leaf
+ * callback, resulting in the inner code generation producing a for loop.
+ */
+static int test_ast_gen5(isl_ctx *ctx)
 {
-	int equal;
 	const char *str;
-	isl_union_set *uset;
-	isl_union_pw_qpolynomial *upwqp1, *upwqp2;
+	isl_set *set;
+	isl_union_map *schedule, *options;
+	isl_ast_build *build;
+	isl_ast_node *tree;
 
-	str = "{ [x] -> x^2 }";
-	upwqp1 = isl_union_pw_qpolynomial_read_from_str(ctx, str);
-	upwqp2 = isl_union_pw_qpolynomial_copy(upwqp1);
-	uset = isl_union_pw_qpolynomial_domain(upwqp1);
-	upwqp1 = isl_union_pw_qpolynomial_copy(upwqp2);
-	upwqp1 = isl_union_pw_qpolynomial_intersect_domain(upwqp1, uset);
-	equal = isl_union_pw_qpolynomial_plain_is_equal(upwqp1, upwqp2);
-	isl_union_pw_qpolynomial_free(upwqp1);
-	isl_union_pw_qpolynomial_free(upwqp2);
-	if (equal < 0)
+	str = "{ A[] -> [1, 1, 2]; B[i] -> [1, i, 0] : i >= 1 and i <= 2 }";
+	schedule = isl_union_map_read_from_str(ctx, str);
+
+	str = "{ [a, b, c] -> unroll[1] : exists (e0 = [(a)/4]: "
+				"4e0 >= -1 + a - b and 4e0 <= -2 + a + b) }";
+	options = isl_union_map_read_from_str(ctx, str);
+
+	set = isl_set_universe(isl_space_params_alloc(ctx, 0));
+	build = isl_ast_build_from_context(set);
+	build = isl_ast_build_set_options(build, options);
+        build = isl_ast_build_set_create_leaf(build, &create_leaf, NULL);
+	tree = isl_ast_build_node_from_schedule_map(build, schedule);
+	isl_ast_build_free(build);
+	isl_ast_node_free(tree);
+	if (!tree)
 		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
 
 	return 0;
 }
 
-/* Inputs for basic tests of functions that select
- * subparts of the domain of an isl_multi_union_pw_aff.
- * "fn" is the function that is tested.
- * "arg" is a string description of the input.
- * "res" is a string description of the expected result.
- */
-struct {
-	__isl_give isl_union_set *(*fn)(
-		__isl_take isl_multi_union_pw_aff *mupa);
-	const char *arg;
-	const char *res;
-} un_locus_tests[] = {
-	{ &isl_multi_union_pw_aff_zero_union_set,
-	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }]",
-	  "{ A[0,j]; B[0,j] }" },
-	{ &isl_multi_union_pw_aff_zero_union_set,
-	  "F[{ A[i,j] -> [i-j]; B[i,j] -> [i-j] : i >= 0 }]",
-	  "{ A[i,i]; B[i,i] : i >= 0 }" },
-	{ &isl_multi_union_pw_aff_zero_union_set,
-	  "(F[] : { A[i,j]; B[i,i] : i >= 0 })",
-	  "{ A[i,j]; B[i,i] : i >= 0 }" },
-};
-
-/* Perform some basic tests of functions that select
- * subparts of the domain of an isl_multi_union_pw_aff.
+/* Check that AST generation from a sequence node with filter children
+ * that select different statements, or different parts of the same
+ * statement, only generates code for the statement instances
+ * selected by each filter.
  */
-static int test_un_locus(isl_ctx *ctx)
+static int test_ast_gen6(isl_ctx *ctx)
 {
-	int i;
-	isl_bool ok;
-	isl_union_set *uset, *res;
-	isl_multi_union_pw_aff *mupa;
+	const char *str;
+	const char *expected;
+	isl_schedule *schedule;
+	isl_ast_build *build;
+	isl_ast_node *tree;
+	char *printed;
+	int equal;
 
-	for (i = 0; i < ARRAY_SIZE(un_locus_tests); ++i) {
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
-						    un_locus_tests[i].arg);
-		res = isl_union_set_read_from_str(ctx, un_locus_tests[i].res);
-		uset = un_locus_tests[i].fn(mupa);
-		ok = isl_union_set_is_equal(uset, res);
-		isl_union_set_free(uset);
-		isl_union_set_free(res);
-		if (ok < 0)
-			return -1;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
-	}
+	str = "{ domain: \"{ A[i] : 0 <= i < 10; B[]; C[i] : 0 <= i < 5 }\", "
+	    "child: { sequence: [ { filter: \"{ A[i] : i < 5 }\" }, "
+	    "{ filter: \"{ B[] }\" }, { filter: \"{ C[i]; A[i] : i >= 5 }\", "
+	    "child: { schedule: \"[{ A[i] -> [i]; C[i] -> [i] }]\" } }, "
+	    "{ filter: \"{ }\" } ] } }";
+	schedule = isl_schedule_read_from_str(ctx, str);
+	build = isl_ast_build_alloc(ctx);
+	tree = isl_ast_build_node_from_schedule(build, schedule);
+	isl_ast_build_free(build);
+	printed = isl_ast_node_to_C_str(tree);
+	isl_ast_node_free(tree);
+	if (!printed)
+		return -1;
+
+	expected =
+		"{\n"
+		"  for (int c0 = 0; c0 <= 4; c0 += 1)\n"
+		"    A(c0);\n"
+		"  B();\n"
+		"  for (int c0 = 0; c0 <= 4; c0 += 1)\n"
+		"    C(c0);\n"
+		"  for (int c0 = 5; c0 <= 9; c0 += 1)\n"
+		"    A(c0);\n"
+		"}\n";
+	equal = !strcmp(printed, expected);
+	if (!equal)
+		fprintf(stderr, "%s", printed);
+	free(printed);
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected AST", return -1);
 
 	return 0;
 }
 
-/* Inputs for basic tests of functions that select
- * subparts of an isl_union_map based on a relation
- * specified by an isl_multi_union_pw_aff.
- * "fn" is the function that is tested.
- * "arg1" and "arg2" are string descriptions of the inputs.
- * "res" is a string description of the expected result.
- */
-struct {
-	__isl_give isl_union_map *(*fn)(
-		__isl_take isl_union_map *umap,
-		__isl_take isl_multi_union_pw_aff *mupa);
-	const char *arg1;
-	const char *arg2;
-	const char *res;
-} bin_locus_tests[] = {
-	{ &isl_union_map_eq_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j'] }",
-	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }]",
-	  "{ A[i,j] -> B[i,j'] }" },
-	{ &isl_union_map_eq_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j'] }",
-	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }, "
-	    "{ A[i,j] -> [j]; B[i,j] -> [j] }]",
-	  "{ A[i,j] -> B[i,j] }" },
-	{ &isl_union_map_eq_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j']; A[i,j] -> C[i',j'] }",
-	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }]",
-	  "{ A[i,j] -> B[i,j'] }" },
-	{ &isl_union_map_eq_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j']; A[i,j] -> C[i',j'] }",
-	  "F[{ A[i,j] -> [i]; B[i,j] -> [i]; C[i,j] -> [0] }]",
-	  "{ A[i,j] -> B[i,j']; A[0,j] -> C[i',j'] }" },
-	{ &isl_union_map_eq_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j'] }",
-	  "F[{ A[i,j] -> [i] : i > j; B[i,j] -> [i] }]",
-	  "{ A[i,j] -> B[i,j'] : i > j }" },
-	{ &isl_union_map_lex_le_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j'] }",
-	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }, "
-	    "{ A[i,j] -> [j]; B[i,j] -> [j] }]",
-	  "{ A[i,j] -> B[i',j'] : i,j <<= i',j' }" },
-	{ &isl_union_map_lex_lt_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j'] }",
-	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }, "
-	    "{ A[i,j] -> [j]; B[i,j] -> [j] }]",
-	  "{ A[i,j] -> B[i',j'] : i,j << i',j' }" },
-	{ &isl_union_map_lex_ge_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j'] }",
-	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }, "
-	    "{ A[i,j] -> [j]; B[i,j] -> [j] }]",
-	  "{ A[i,j] -> B[i',j'] : i,j >>= i',j' }" },
-	{ &isl_union_map_lex_gt_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j'] }",
-	  "F[{ A[i,j] -> [i]; B[i,j] -> [i] }, "
-	    "{ A[i,j] -> [j]; B[i,j] -> [j] }]",
-	  "{ A[i,j] -> B[i',j'] : i,j >> i',j' }" },
-	{ &isl_union_map_eq_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j']; A[i,j] -> C[i',j'] }",
-	  "(F[] : { A[i,j]; B[i,j] })",
-	  "{ A[i,j] -> B[i',j'] }" },
-	{ &isl_union_map_eq_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j'] }",
-	  "(F[] : { A[i,j] : i > j; B[i,j] : i < j })",
-	  "{ A[i,j] -> B[i',j'] : i > j and i' < j' }" },
-	{ &isl_union_map_eq_at_multi_union_pw_aff,
-	  "[N] -> { A[i,j] -> B[i',j'] : i,i' <= N }",
-	  "(F[] : { A[i,j] : i > j; B[i,j] : i < j })",
-	  "[N] -> { A[i,j] -> B[i',j'] : i > j and i' < j' and i,i' <= N }" },
-	{ &isl_union_map_eq_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j'] }",
-	  "[N] -> (F[] : { A[i,j] : i < N; B[i,j] : i < N })",
-	  "[N] -> { A[i,j] -> B[i',j'] : i,i' < N }" },
-	{ &isl_union_map_eq_at_multi_union_pw_aff,
-	  "{ A[i,j] -> B[i',j'] }",
-	  "[N] -> (F[] : { : N >= 0 })",
-	  "[N] -> { A[i,j] -> B[i',j'] : N >= 0 }" },
-};
-
-/* Perform some basic tests of functions that select
- * subparts of an isl_union_map based on a relation
- * specified by an isl_multi_union_pw_aff.
+/* Generate an AST from the schedule tree "str" with
+ * the ast_build_quality option set to "quality" and
+ * the ast_build_component_budget option set to "budget" and
+ * return the result printed as C code.
  */
-static int test_bin_locus(isl_ctx *ctx)
+static char *ast_gen_quality(isl_ctx *ctx, const char *str, int quality,
+	int budget)
 {
-	int i;
-	isl_bool ok;
-	isl_union_map *umap, *res;
-	isl_multi_union_pw_aff *mupa;
+	int save_quality, save_budget;
+	isl_schedule *schedule;
+	isl_ast_build *build;
+	isl_ast_node *tree;
+	char *printed;
 
-	for (i = 0; i < ARRAY_SIZE(bin_locus_tests); ++i) {
-		umap = isl_union_map_read_from_str(ctx,
-						    bin_locus_tests[i].arg1);
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx,
-						    bin_locus_tests[i].arg2);
-		res = isl_union_map_read_from_str(ctx, bin_locus_tests[i].res);
-		umap = bin_locus_tests[i].fn(umap, mupa);
-		ok = isl_union_map_is_equal(umap, res);
-		isl_union_map_free(umap);
-		isl_union_map_free(res);
-		if (ok < 0)
-			return -1;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
-	}
+	save_quality = isl_options_get_ast_build_quality(ctx);
+	save_budget = isl_options_get_ast_build_component_budget(ctx);
+	isl_options_set_ast_build_quality(ctx, quality);
+	isl_options_set_ast_build_component_budget(ctx, budget);
+	schedule = isl_schedule_read_from_str(ctx, str);
+	build = isl_ast_build_alloc(ctx);
+	tree = isl_ast_build_node_from_schedule(build, schedule);
+	isl_ast_build_free(build);
+	printed = isl_ast_node_to_C_str(tree);
+	isl_ast_node_free(tree);
+	isl_options_set_ast_build_quality(ctx, save_quality);
+	isl_options_set_ast_build_component_budget(ctx, save_budget);
 
-	return 0;
+	return printed;
 }
 
-/* Inputs for basic tests of functions that determine
- * the part of the domain where two isl_multi_aff objects
- * related to each other in a specific way.
- * "fn" is the function that is being tested.
- * "arg1" and "arg2" are string descriptions of the inputs.
- * "res" is a string description of the expected result.
- */
-static struct {
-	__isl_give isl_set *(*fn)(__isl_take isl_multi_aff *ma1,
-		__isl_take isl_multi_aff *ma2);
-	const char *arg1;
-	const char *arg2;
-	const char *res;
-} bin_locus_ma_tests[] = {
-	{ &isl_multi_aff_lex_le_set, "{ [] }", "{ [] }", "{ : }" },
-	{ &isl_multi_aff_lex_lt_set, "{ [] }", "{ [] }", "{ : false }" },
-	{ &isl_multi_aff_lex_le_set,
-	  "{ A[i] -> [i] }", "{ A[i] -> [0] }",
-	  "{ A[i] : i <= 0 }" },
-	{ &isl_multi_aff_lex_lt_set,
-	  "{ A[i] -> [i] }", "{ A[i] -> [0] }",
-	  "{ A[i] : i < 0 }" },
-	{ &isl_multi_aff_lex_le_set,
-	  "{ A[i] -> [i, i] }", "{ A[i] -> [0, 0] }",
-	  "{ A[i] : i <= 0 }" },
-	{ &isl_multi_aff_lex_le_set,
-	  "{ A[i] -> [i, 0] }", "{ A[i] -> [0, 0] }",
-	  "{ A[i] : i <= 0 }" },
-	{ &isl_multi_aff_lex_le_set,
-	  "{ A[i] -> [i, 1] }", "{ A[i] -> [0, 0] }",
-	  "{ A[i] : i < 0 }" },
-};
-
-/* Perform some basic tests of functions that determine
- * the part of the domain where two isl_multi_aff objects
- * related to each other in a specific way.
+/* Increment *user for each if node.
  */
-static isl_stat test_bin_locus_ma(isl_ctx *ctx)
+static isl_bool count_if(__isl_keep isl_ast_node *node, void *user)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(bin_locus_ma_tests); ++i) {
-		const char *str;
-		isl_bool ok;
-		isl_multi_aff *ma1, *ma2;
-		isl_set *set, *res;
+	int *n = user;
 
-		str = bin_locus_ma_tests[i].arg1;
-		ma1 = isl_multi_aff_read_from_str(ctx, str);
-		str = bin_locus_ma_tests[i].arg2;
-		ma2 = isl_multi_aff_read_from_str(ctx, str);
-		res = isl_set_read_from_str(ctx, bin_locus_ma_tests[i].res);
-		set = bin_locus_ma_tests[i].fn(ma1, ma2);
-		ok = isl_set_is_equal(set, res);
-		isl_set_free(set);
-		isl_set_free(res);
-		if (ok < 0)
-			return isl_stat_error;
-		if (!ok)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return isl_stat_error);
-	}
+	if (isl_ast_node_get_type(node) == isl_ast_node_if)
+		(*n)++;
 
-	return isl_stat_ok;
+	return isl_bool_true;
 }
 
-/* Perform basic locus tests.
+/* Check that the after_each_if callback is called
+ * for each if node in the generated code.
  */
-static int test_locus(isl_ctx *ctx)
+static int test_ast_gen7(isl_ctx *ctx)
 {
-	if (test_un_locus(ctx) < 0)
-		return -1;
-	if (test_bin_locus(ctx) < 0)
-		return -1;
-	if (test_bin_locus_ma(ctx) < 0)
+	const char *str;
+	isl_union_map *schedule;
+	isl_ast_build *build;
+	isl_ast_node *tree;
+	int n_callback = 0, n_tree = 0;
+
+	str = "[N, M] -> { A[i] -> [i] : 0 <= i < 100 and N >= 5; "
+		"B[i] -> [i] : 0 <= i < 100 and M >= 5 }";
+	schedule = isl_union_map_read_from_str(ctx, str);
+	build = isl_ast_build_alloc(ctx);
+	build = isl_ast_build_set_after_each_if(build,
+			&count_domains, &n_callback);
+	tree = isl_ast_build_node_from_schedule_map(build, schedule);
+	isl_ast_build_free(build);
+	if (isl_ast_node_foreach_descendant_top_down(tree,
+						&count_if, &n_tree) < 0)
+		tree = isl_ast_node_free(tree);
+	if (!tree)
 		return -1;
+	isl_ast_node_free(tree);
+
+	if (n_tree == 0 || n_callback != n_tree)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected number of if nodes", return -1);
+
 	return 0;
 }
 
-/* Test that isl_union_pw_qpolynomial_eval picks up the function
- * defined over the correct domain space.
+/* Check that the ast_build_quality option determines whether
+ * the separate option is taken into account and that
+ * exceeding the ast_build_component_budget results in
+ * the same AST as requesting the lowest quality.
  */
-static int test_eval_1(isl_ctx *ctx)
+static int test_ast_gen_quality(isl_ctx *ctx)
 {
 	const char *str;
-	isl_point *pnt;
-	isl_set *set;
-	isl_union_pw_qpolynomial *upwqp;
-	isl_val *v;
-	int cmp;
-
-	str = "{ A[x] -> x^2; B[x] -> -x^2 }";
-	upwqp = isl_union_pw_qpolynomial_read_from_str(ctx, str);
-	str = "{ A[6] }";
-	set = isl_set_read_from_str(ctx, str);
-	pnt = isl_set_sample_point(set);
-	v = isl_union_pw_qpolynomial_eval(upwqp, pnt);
-	cmp = isl_val_cmp_si(v, 36);
-	isl_val_free(v);
+	char *full, *atomic, *fallback;
+	int ok;
 
-	if (!v)
-		return -1;
-	if (cmp != 0)
-		isl_die(ctx, isl_error_unknown, "unexpected value", return -1);
+	str = "{ domain: \"{ A[i] : 0 <= i < 10; B[i] : 5 <= i < 20 }\", "
+	    "child: { schedule: \"[{ A[i] -> [i]; B[i] -> [i] }]\", "
+	    "options: \"{ separate[x] }\" } }";
+	full = ast_gen_quality(ctx, str, ISL_AST_BUILD_QUALITY_FULL, 0);
+	atomic = ast_gen_quality(ctx, str, ISL_AST_BUILD_QUALITY_ATOMIC, 0);
+	fallback = ast_gen_quality(ctx, str, ISL_AST_BUILD_QUALITY_FULL, 1);
+	ok = full && atomic && fallback;
+	if (ok && !strcmp(full, atomic))
+		isl_die(ctx, isl_error_unknown,
+			"separate option not taken into account", ok = 0);
+	if (ok && strcmp(atomic, fallback))
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result after fallback", ok = 0);
+	free(full);
+	free(atomic);
+	free(fallback);
 
-	return 0;
+	return ok ? 0 : -1;
 }
 
-/* Check that isl_qpolynomial_eval handles getting called on a void point.
+/* Check that an AST generated from a schedule tree that is derived from
+ * a previously used schedule tree by modifying one of the children
+ * of a sequence node reuses the AST of the other child if
+ * isl_ast_build_set_reuse_subtrees has been called and
+ * that the result is the same as that of a fresh AST generation.
  */
-static int test_eval_2(isl_ctx *ctx)
+static int test_ast_gen_reuse(isl_ctx *ctx)
 {
 	const char *str;
-	isl_point *pnt;
-	isl_set *set;
-	isl_qpolynomial *qp;
-	isl_val *v;
-	isl_bool ok;
+	isl_schedule *schedule;
+	isl_schedule_node *node;
+	isl_ast_build *build;
+	isl_ast_node *tree;
+	struct isl_stats stats;
+	char *reused, *fresh;
+	int equal;
 
-	str = "{ A[x] -> [x] }";
-	qp = isl_qpolynomial_from_aff(isl_aff_read_from_str(ctx, str));
-	str = "{ A[x] : false }";
-	set = isl_set_read_from_str(ctx, str);
-	pnt = isl_set_sample_point(set);
-	v = isl_qpolynomial_eval(qp, pnt);
-	ok = isl_val_is_nan(v);
-	isl_val_free(v);
+	str = "{ domain: \"[n] -> { A[i] : 0 <= i < n; B[i] : 0 <= i < 8 }\", "
+	    "child: { sequence: [ "
+	    "{ filter: \"{ A[i] }\", child: { schedule: \"[{ A[i] -> [i] }]\" } }, "
+	    "{ filter: \"{ B[i] }\", child: { schedule: \"[{ B[i] -> [i] }]\" } } "
+	    "] } }";
+	schedule = isl_schedule_read_from_str(ctx, str);
+	build = isl_ast_build_alloc(ctx);
+	build = isl_ast_build_set_reuse_subtrees(build, 1);
+	tree = isl_ast_build_node_from_schedule(build,
+						isl_schedule_copy(schedule));
+	isl_ast_node_free(tree);
 
-	if (ok < 0)
-		return -1;
-	if (!ok)
-		isl_die(ctx, isl_error_unknown, "expecting NaN", return -1);
+	node = isl_schedule_get_root(schedule);
+	isl_schedule_free(schedule);
+	node = isl_schedule_node_child(node, 0);
+	node = isl_schedule_node_child(node, 1);
+	node = isl_schedule_node_child(node, 0);
+	node = isl_schedule_node_band_member_set_ast_loop_type(node, 0,
+							isl_ast_loop_unroll);
+	schedule = isl_schedule_node_get_schedule(node);
+	isl_schedule_node_free(node);
 
-	return 0;
-}
+	isl_ctx_reset_stats(ctx);
+	tree = isl_ast_build_node_from_schedule(build,
+						isl_schedule_copy(schedule));
+	isl_ast_build_free(build);
+	reused = isl_ast_node_to_C_str(tree);
+	isl_ast_node_free(tree);
+	if (isl_ctx_get_stats(ctx, &stats) < 0) {
+		free(reused);
+		reused = NULL;
+	}
 
-/* Check that a polynomial (without local variables) can be evaluated
- * in a rational point.
- */
-static isl_stat test_eval_3(isl_ctx *ctx)
-{
-	isl_pw_qpolynomial *pwqp;
-	isl_point *pnt;
-	isl_val *v;
-	isl_stat r;
+	build = isl_ast_build_alloc(ctx);
+	tree = isl_ast_build_node_from_schedule(build, schedule);
+	isl_ast_build_free(build);
+	fresh = isl_ast_node_to_C_str(tree);
+	isl_ast_node_free(tree);
 
-	pwqp = isl_pw_qpolynomial_read_from_str(ctx, "{ [x] -> x^2 }");
-	pnt = isl_point_zero(isl_pw_qpolynomial_get_domain_space(pwqp));
-	v = isl_val_read_from_str(ctx, "1/2");
-	pnt = isl_point_set_coordinate_val(pnt, isl_dim_set, 0, v);
-	v = isl_pw_qpolynomial_eval(pwqp, pnt);
-	r = val_check_equal(v, "1/4");
-	isl_val_free(v);
+	equal = reused && fresh && !strcmp(reused, fresh);
+	free(reused);
+	free(fresh);
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"reused AST is not equal to fresh AST", return -1);
+	if (stats.ast_subtree_reuses != 1)
+		isl_die(ctx, isl_error_unknown, "subtree not reused",
+			return -1);
 
-	return r;
+	return 0;
 }
 
-/* Inputs for isl_pw_aff_eval test.
- * "f" is the affine function.
- * "p" is the point where the function should be evaluated.
- * "res" is the expected result.
+/* Internal data structure for test_ast_gen_subtree.
+ * "build" is the isl_ast_build at the first mark that was encountered.
+ * "body" is the printed AST of the child of the last mark
+ * that was encountered.
  */
-struct {
-	const char *f;
-	const char *p;
-	const char *res;
-} aff_eval_tests[] = {
-	{ "{ [i] -> [2 * i] }", "{ [4] }", "8" },
-	{ "{ [i] -> [2 * i] }", "{ [x] : false }", "NaN" },
-	{ "{ [i] -> [i + floor(i/2) + floor(i/3)] }", "{ [0] }", "0" },
-	{ "{ [i] -> [i + floor(i/2) + floor(i/3)] }", "{ [1] }", "1" },
-	{ "{ [i] -> [i + floor(i/2) + floor(i/3)] }", "{ [2] }", "3" },
-	{ "{ [i] -> [i + floor(i/2) + floor(i/3)] }", "{ [3] }", "5" },
-	{ "{ [i] -> [i + floor(i/2) + floor(i/3)] }", "{ [4] }", "7" },
-	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [0] }", "0" },
-	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [1] }", "0" },
-	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [2] }", "0" },
-	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [3] }", "0" },
-	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [4] }", "1" },
-	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [6] }", "1" },
-	{ "{ [i] -> [floor((3 * floor(i/2))/5)] }", "{ [8] }", "2" },
-	{ "{ [i] -> [i] : i > 0; [i] -> [-i] : i < 0 }", "{ [4] }", "4" },
-	{ "{ [i] -> [i] : i > 0; [i] -> [-i] : i < 0 }", "{ [-2] }", "2" },
-	{ "{ [i] -> [i] : i > 0; [i] -> [-i] : i < 0 }", "{ [0] }", "NaN" },
-	{ "[N] -> { [2 * N] }", "[N] -> { : N = 4 }", "8" },
-	{ "{ [i, j] -> [(i + j)/2] }", "{ [1, 1] }", "1" },
-	{ "{ [i, j] -> [(i + j)/2] }", "{ [1, 2] }", "3/2" },
-	{ "{ [i] -> [i] : i mod 2 = 0 }", "{ [4] }", "4" },
-	{ "{ [i] -> [i] : i mod 2 = 0 }", "{ [3] }", "NaN" },
-	{ "{ [i] -> [i] : i mod 2 = 0 }", "{ [x] : false }", "NaN" },
+struct isl_test_ast_subtree_data {
+	isl_ast_build *build;
+	char *body;
 };
 
-/* Perform basic isl_pw_aff_eval tests.
+/* before_each_mark callback for test_ast_gen_subtree.
+ * Keep a copy of the first "build" in data->build.
  */
-static int test_eval_aff(isl_ctx *ctx)
+static isl_stat capture_mark_build(__isl_keep isl_id *mark,
+	__isl_keep isl_ast_build *build, void *user)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(aff_eval_tests); ++i) {
-		isl_stat r;
-		isl_pw_aff *pa;
-		isl_set *set;
-		isl_point *pnt;
-		isl_val *v;
+	struct isl_test_ast_subtree_data *data = user;
 
-		pa = isl_pw_aff_read_from_str(ctx, aff_eval_tests[i].f);
-		set = isl_set_read_from_str(ctx, aff_eval_tests[i].p);
-		pnt = isl_set_sample_point(set);
-		v = isl_pw_aff_eval(pa, pnt);
-		r = val_check_equal(v, aff_eval_tests[i].res);
-		isl_val_free(v);
-		if (r < 0)
-			return -1;
-	}
-	return 0;
+	if (!data->build)
+		data->build = isl_ast_build_copy(build);
+	return data->build ? isl_stat_ok : isl_stat_error;
 }
 
-/* Perform basic evaluation tests.
+/* after_each_mark callback for test_ast_gen_subtree.
+ * Store the printed AST of the child of the mark "node" in data->body.
  */
-static int test_eval(isl_ctx *ctx)
+static __isl_give isl_ast_node *capture_mark_body(
+	__isl_take isl_ast_node *node, __isl_keep isl_ast_build *build,
+	void *user)
 {
-	if (test_eval_1(ctx) < 0)
-		return -1;
-	if (test_eval_2(ctx) < 0)
-		return -1;
-	if (test_eval_3(ctx) < 0)
-		return -1;
-	if (test_eval_aff(ctx) < 0)
-		return -1;
-	return 0;
+	struct isl_test_ast_subtree_data *data = user;
+	isl_ast_node *body;
+
+	body = isl_ast_node_mark_get_node(node);
+	free(data->body);
+	data->body = isl_ast_node_to_C_str(body);
+	isl_ast_node_free(body);
+	if (!data->body)
+		return isl_ast_node_free(node);
+	return node;
 }
 
-/* Descriptions of sets that are tested for reparsing after printing.
+/* Schedule trees of two kernels that share the same outer band,
+ * followed by a mark, but that have a different subtree below the mark.
  */
-const char *output_tests[] = {
-	"{ [1, y] : 0 <= y <= 1; [x, -x] : 0 <= x <= 1 }",
-	"{ [x] : 1 = 0 }",
-	"{ [x] : false }",
-	"{ [x] : x mod 2 = 0 }",
-	"{ [x] : x mod 2 = 1 }",
-	"{ [x, y] : x mod 2 = 0 and 3*floor(y/2) < x }",
-	"{ [y, x] : x mod 2 = 0 and 3*floor(y/2) < x }",
-	"{ [x, y] : x mod 2 = 0 and 3*floor(y/2) = x + y }",
-	"{ [y, x] : x mod 2 = 0 and 3*floor(y/2) = x + y }",
-	"[n] -> { [y, x] : 2*((x + 2y) mod 3) = n }",
-	"{ [x, y] : (2*floor(x/3) + 3*floor(y/4)) mod 5 = x }",
+static const char *ast_subtree_kernels[] = {
+	"{ domain: \"[n] -> { S[i, j] : 0 <= i < n and 0 <= j < 8; "
+	    "T[i, j] : 0 <= i < n and 0 <= j < 8 }\", "
+	"child: { schedule: \"[{ S[i, j] -> [i]; T[i, j] -> [i] }]\", "
+	"child: { mark: \"kernel\", child: { sequence: [ "
+	"{ filter: \"{ S[i, j] }\", "
+	    "child: { schedule: \"[{ S[i, j] -> [j] }]\" } }, "
+	"{ filter: \"{ T[i, j] }\", "
+	    "child: { schedule: \"[{ T[i, j] -> [j] }]\" } } "
+	"] } } } }",
+	"{ domain: \"[n] -> { S[i, j] : 0 <= i < n and 0 <= j < 8; "
+	    "T[i, j] : 0 <= i < n and 0 <= j < 8 }\", "
+	"child: { schedule: \"[{ S[i, j] -> [i]; T[i, j] -> [i] }]\", "
+	"child: { mark: \"kernel\", child: "
+	    "{ schedule: \"[{ S[i, j] -> [7 - j]; T[i, j] -> [7 - j] }]\" "
+	"} } } }",
 };
 
-/* Check that printing a set and reparsing a set from the printed output
- * results in the same set.
+/* Return the child of the mark node in the schedule tree
+ * described by "str", which is assumed to be the grandchild of the root.
  */
-static int test_output_set(isl_ctx *ctx)
+static __isl_give isl_schedule_node *get_mark_child(isl_ctx *ctx,
+	const char *str)
 {
-	int i;
-	char *str;
-	isl_set *set1, *set2;
-	isl_bool equal;
+	isl_schedule *schedule;
+	isl_schedule_node *node;
 
-	for (i = 0; i < ARRAY_SIZE(output_tests); ++i) {
-		set1 = isl_set_read_from_str(ctx, output_tests[i]);
-		str = isl_set_to_str(set1);
-		set2 = isl_set_read_from_str(ctx, str);
-		free(str);
-		equal = isl_set_is_equal(set1, set2);
-		isl_set_free(set1);
-		isl_set_free(set2);
-		if (equal < 0)
-			return -1;
-		if (!equal)
-			isl_die(ctx, isl_error_unknown,
-				"parsed output not the same", return -1);
-	}
+	schedule = isl_schedule_read_from_str(ctx, str);
+	node = isl_schedule_get_root(schedule);
+	isl_schedule_free(schedule);
+	node = isl_schedule_node_child(node, 0);
+	node = isl_schedule_node_child(node, 0);
+	node = isl_schedule_node_child(node, 0);
 
-	return 0;
+	return node;
 }
 
-/* Check that an isl_multi_aff is printed using a consistent space.
+/* Check that the AST generated by
+ * isl_ast_build_node_from_schedule_subtree for the subtree below the mark
+ * of the second kernel, using the isl_ast_build captured at the mark
+ * of the first kernel, is the same as the AST generated
+ * below the mark during a fresh AST generation for the second kernel.
+ * Also check that the prefix schedule of the subtree
+ * needs to match that of the build.
  */
-static isl_stat test_output_ma(isl_ctx *ctx)
+static int test_ast_gen_subtree(isl_ctx *ctx)
 {
-	char *str;
-	isl_bool equal;
-	isl_aff *aff;
-	isl_multi_aff *ma, *ma2;
-
-	ma = isl_multi_aff_read_from_str(ctx, "{ [a, b] -> [a + b] }");
-	aff = isl_aff_read_from_str(ctx, "{ [c, d] -> [c + d] }");
-	ma = isl_multi_aff_set_aff(ma, 0, aff);
-	str = isl_multi_aff_to_str(ma);
-	ma2 = isl_multi_aff_read_from_str(ctx, str);
-	free(str);
-	equal = isl_multi_aff_plain_is_equal(ma, ma2);
-	isl_multi_aff_free(ma2);
-	isl_multi_aff_free(ma);
-
-	if (equal < 0)
-		return isl_stat_error;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown, "bad conversion",
-			return isl_stat_error);
+	struct isl_test_ast_subtree_data data = { NULL, NULL };
+	isl_schedule *schedule;
+	isl_schedule_node *node;
+	isl_ast_build *build;
+	isl_ast_node *tree;
+	char *subtree;
+	int equal;
+	int on_error;
 
-	return isl_stat_ok;
-}
+	build = isl_ast_build_alloc(ctx);
+	build = isl_ast_build_set_before_each_mark(build,
+						&capture_mark_build, &data);
+	schedule = isl_schedule_read_from_str(ctx, ast_subtree_kernels[0]);
+	tree = isl_ast_build_node_from_schedule(build, schedule);
+	isl_ast_build_free(build);
+	isl_ast_node_free(tree);
+	if (!tree)
+		goto error;
 
-/* Check that an isl_multi_pw_aff is printed using a consistent space.
- */
-static isl_stat test_output_mpa(isl_ctx *ctx)
-{
-	char *str;
-	isl_bool equal;
-	isl_pw_aff *pa;
-	isl_multi_pw_aff *mpa, *mpa2;
+	node = get_mark_child(ctx, ast_subtree_kernels[1]);
+	tree = isl_ast_build_node_from_schedule_subtree(data.build, node);
+	subtree = isl_ast_node_to_C_str(tree);
+	isl_ast_node_free(tree);
 
-	mpa = isl_multi_pw_aff_read_from_str(ctx, "{ [a, b] -> [a + b] }");
-	pa = isl_pw_aff_read_from_str(ctx, "{ [c, d] -> [c + d] }");
-	mpa = isl_multi_pw_aff_set_pw_aff(mpa, 0, pa);
-	str = isl_multi_pw_aff_to_str(mpa);
-	mpa2 = isl_multi_pw_aff_read_from_str(ctx, str);
-	free(str);
-	equal = isl_multi_pw_aff_plain_is_equal(mpa, mpa2);
-	isl_multi_pw_aff_free(mpa2);
-	isl_multi_pw_aff_free(mpa);
+	build = isl_ast_build_alloc(ctx);
+	build = isl_ast_build_set_after_each_mark(build,
+						&capture_mark_body, &data);
+	schedule = isl_schedule_read_from_str(ctx, ast_subtree_kernels[1]);
+	tree = isl_ast_build_node_from_schedule(build, schedule);
+	isl_ast_build_free(build);
+	isl_ast_node_free(tree);
 
-	if (equal < 0)
-		return isl_stat_error;
+	equal = subtree && data.body && !strcmp(subtree, data.body);
+	free(subtree);
 	if (!equal)
-		isl_die(ctx, isl_error_unknown, "bad conversion",
-			return isl_stat_error);
+		isl_die(ctx, isl_error_unknown,
+			"unexpected AST for subtree", goto error);
+
+	schedule = isl_schedule_read_from_str(ctx,
+				"{ domain: \"{ S[i, j] : 0 <= i, j < 8 }\" }");
+	node = isl_schedule_get_root(schedule);
+	isl_schedule_free(schedule);
+	node = isl_schedule_node_child(node, 0);
+	on_error = isl_options_get_on_error(ctx);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+	tree = isl_ast_build_node_from_schedule_subtree(data.build, node);
+	isl_options_set_on_error(ctx, on_error);
+	isl_ast_node_free(tree);
+	if (tree)
+		isl_die(ctx, isl_error_unknown,
+			"mismatching prefix schedule not detected",
+			goto error);
 
-	return isl_stat_ok;
+	isl_ast_build_free(data.build);
+	free(data.body);
+	return 0;
+error:
+	isl_ast_build_free(data.build);
+	free(data.body);
+	return -1;
 }
 
-int test_output(isl_ctx *ctx)
+/* Check that the expression
+ *
+ *	[n] -> { [n/2] : n <= 0 and n % 2 = 0; [0] : n > 0 }
+ *
+ * is not combined into
+ *
+ *	min(n/2, 0)
+ *
+ * as this would result in n/2 being evaluated in parts of
+ * the definition domain where n is not a multiple of 2.
+ */
+static int test_ast_expr(isl_ctx *ctx)
 {
-	char *s;
 	const char *str;
 	isl_pw_aff *pa;
-	isl_printer *p;
-	int equal;
+	isl_ast_build *build;
+	isl_ast_expr *expr;
+	int min_max;
+	int is_min;
 
-	if (test_output_set(ctx) < 0)
-		return -1;
-	if (test_output_ma(ctx) < 0)
-		return -1;
-	if (test_output_mpa(ctx) < 0)
-		return -1;
+	min_max = isl_options_get_ast_build_detect_min_max(ctx);
+	isl_options_set_ast_build_detect_min_max(ctx, 1);
 
-	str = "[x] -> { [1] : x % 4 <= 2; [2] : x = 3 }";
+	str = "[n] -> { [n/2] : n <= 0 and n % 2 = 0; [0] : n > 0 }";
 	pa = isl_pw_aff_read_from_str(ctx, str);
+	build = isl_ast_build_alloc(ctx);
+	expr = isl_ast_build_expr_from_pw_aff(build, pa);
+	is_min = isl_ast_expr_get_type(expr) == isl_ast_expr_op &&
+		 isl_ast_expr_get_op_type(expr) == isl_ast_expr_op_min;
+	isl_ast_build_free(build);
+	isl_ast_expr_free(expr);
 
-	p = isl_printer_to_str(ctx);
-	p = isl_printer_set_output_format(p, ISL_FORMAT_C);
-	p = isl_printer_print_pw_aff(p, pa);
-	s = isl_printer_get_str(p);
-	isl_printer_free(p);
-	isl_pw_aff_free(pa);
-	if (!s)
-		equal = -1;
-	else
-		equal = !strcmp(s, "4 * floord(x, 4) + 2 >= x ? 1 : 2");
-	free(s);
-	if (equal < 0)
+	isl_options_set_ast_build_detect_min_max(ctx, min_max);
+
+	if (!expr)
 		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+	if (is_min)
+		isl_die(ctx, isl_error_unknown,
+			"expressions should not be combined", return -1);
 
 	return 0;
 }
 
-int test_sample(isl_ctx *ctx)
+/* Check that constructing an expression for the same piecewise
+ * affine expression twice from the same isl_ast_build
+ * reuses the first result.
+ */
+static int test_ast_expr_cache(isl_ctx *ctx)
 {
 	const char *str;
-	isl_basic_set *bset1, *bset2;
-	int empty, subset;
+	isl_pw_aff *pa;
+	isl_ast_build *build;
+	isl_ast_expr *expr1, *expr2;
+	struct isl_stats stats;
+	isl_bool equal;
 
-	str = "{ [a, b, c, d, e, f, g, h, i, j, k] : "
-	    "3i >= 1073741823b - c - 1073741823e + f and c >= 0 and "
-	    "3i >= -1 + 3221225466b + c + d - 3221225466e - f and "
-	    "2e >= a - b and 3e <= 2a and 3k <= -a and f <= -1 + a and "
-	    "3i <= 4 - a + 4b + 2c - e - 2f and 3k <= -a + c - f and "
-	    "3h >= -2 + a and 3g >= -3 - a and 3k >= -2 - a and "
-	    "3i >= -2 - a - 2c + 3e + 2f and 3h <= a + c - f and "
-	    "3h >= a + 2147483646b + 2c - 2147483646e - 2f and "
-	    "3g <= -1 - a and 3i <= 1 + c + d - f and a <= 1073741823 and "
-	    "f >= 1 - a + 1073741822b + c + d - 1073741822e and "
-	    "3i >= 1 + 2b - 2c + e + 2f + 3g and "
-	    "1073741822f <= 1073741822 - a + 1073741821b + 1073741822c +"
-		"d - 1073741821e and "
-	    "3j <= 3 - a + 3b and 3g <= -2 - 2b + c + d - e - f and "
-	    "3j >= 1 - a + b + 2e and "
-	    "3f >= -3 + a + 3221225462b + 3c + d - 3221225465e and "
-	    "3i <= 4 - a + 4b - e and "
-	    "f <= 1073741822 + 1073741822b - 1073741822e and 3h <= a and "
-	    "f >= 0 and 2e <= 4 - a + 5b - d and 2e <= a - b + d and "
-	    "c <= -1 + a and 3i >= -2 - a + 3e and "
-	    "1073741822e <= 1073741823 - a + 1073741822b + c and "
-	    "3g >= -4 + 3221225464b + 3c + d - 3221225467e - 3f and "
-	    "3i >= -1 + 3221225466b + 3c + d - 3221225466e - 3f and "
-	    "1073741823e >= 1 + 1073741823b - d and "
-	    "3i >= 1073741823b + c - 1073741823e - f and "
-	    "3i >= 1 + 2b + e + 3g }";
-	bset1 = isl_basic_set_read_from_str(ctx, str);
-	bset2 = isl_basic_set_sample(isl_basic_set_copy(bset1));
-	empty = isl_basic_set_is_empty(bset2);
-	subset = isl_basic_set_is_subset(bset2, bset1);
-	isl_basic_set_free(bset1);
-	isl_basic_set_free(bset2);
-	if (empty < 0 || subset < 0)
+	str = "[n] -> { [n/2] : n <= 0 and n % 2 = 0; [0] : n > 0 }";
+	pa = isl_pw_aff_read_from_str(ctx, str);
+	build = isl_ast_build_alloc(ctx);
+	isl_ctx_reset_stats(ctx);
+	expr1 = isl_ast_build_expr_from_pw_aff(build, isl_pw_aff_copy(pa));
+	expr2 = isl_ast_build_expr_from_pw_aff(build, pa);
+	isl_ast_build_free(build);
+	equal = isl_ast_expr_is_equal(expr1, expr2);
+	isl_ast_expr_free(expr1);
+	isl_ast_expr_free(expr2);
+
+	if (equal < 0 || isl_ctx_get_stats(ctx, &stats) < 0)
 		return -1;
-	if (empty)
-		isl_die(ctx, isl_error_unknown, "point not found", return -1);
-	if (!subset)
-		isl_die(ctx, isl_error_unknown, "bad point found", return -1);
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"expressions should be equal", return -1);
+	if (stats.ast_expr_cache_hits != 1)
+		isl_die(ctx, isl_error_unknown, "cache not used", return -1);
 
 	return 0;
 }
 
-/* Perform a projection on a basic set that is known to be empty
- * but that has not been assigned a canonical representation.
- * Earlier versions of isl would run into a stack overflow
- * on this example.
+/* Check that generating an AST for the same schedule twice
+ * from the same isl_ast_build reuses the strides detected
+ * during the first generation and that the results are the same.
  */
-static int test_empty_projection(isl_ctx *ctx)
+static int test_ast_stride_cache(isl_ctx *ctx)
 {
 	const char *str;
-	isl_bool empty;
-	isl_basic_set *bset;
+	isl_union_map *schedule;
+	isl_ast_build *build;
+	isl_ast_node *node1, *node2;
+	struct isl_stats stats;
+	char *str1, *str2;
+	int equal;
 
-	str = "{ [a, b, c, d, e, f, g, h] : 5f = 1 + 4a - b + 5c - d - 2e and "
-		"3h = 2 + b + c and 14c >= 9 - 3a + 25b and "
-		"4c <= 50 - 3a + 23b and 6b <= -39 + a and "
-		"9g >= -6 + 3a + b + c and e < a + b - 2d and "
-		"7d >= -5 + 2a + 2b and 5g >= -14 + a - 4b + d + 2e and "
-		"9g <= -28 - 5b - 2c + 3d + 6e }";
-	bset = isl_basic_set_read_from_str(ctx, str);
-	empty = isl_basic_set_is_empty(bset);
-	bset = isl_basic_set_params(bset);
-	isl_basic_set_free(bset);
+	str = "[n] -> { A[i, j] -> [t, i, j] : 0 <= i, j < n and "
+	    "exists k : t = 4k and t <= i < t + 4 and j % 3 = 0 }";
+	schedule = isl_union_map_read_from_str(ctx, str);
+	build = isl_ast_build_alloc(ctx);
+	node1 = isl_ast_build_node_from_schedule_map(build,
+						isl_union_map_copy(schedule));
+	isl_ctx_reset_stats(ctx);
+	node2 = isl_ast_build_node_from_schedule_map(build, schedule);
+	isl_ast_build_free(build);
+	str1 = isl_ast_node_to_C_str(node1);
+	str2 = isl_ast_node_to_C_str(node2);
+	isl_ast_node_free(node1);
+	isl_ast_node_free(node2);
+	equal = str1 && str2 && !strcmp(str1, str2);
+	free(str1);
+	free(str2);
 
-	if (empty < 0)
+	if (isl_ctx_get_stats(ctx, &stats) < 0)
 		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"ASTs should be equal", return -1);
+	if (stats.ast_stride_cache_hits == 0 ||
+	    stats.ast_stride_cache_misses != 0)
+		isl_die(ctx, isl_error_unknown, "cache not used", return -1);
 
 	return 0;
 }
 
-int test_fixed_power(isl_ctx *ctx)
+static int test_ast_gen(isl_ctx *ctx)
+{
+	if (test_ast_gen1(ctx) < 0)
+		return -1;
+	if (test_ast_gen2(ctx) < 0)
+		return -1;
+	if (test_ast_gen3(ctx) < 0)
+		return -1;
+	if (test_ast_gen4(ctx) < 0)
+		return -1;
+	if (test_ast_gen5(ctx) < 0)
+		return -1;
+	if (test_ast_gen6(ctx) < 0)
+		return -1;
+	if (test_ast_gen7(ctx) < 0)
+		return -1;
+	if (test_ast_gen_quality(ctx) < 0)
+		return -1;
+	if (test_ast_gen_reuse(ctx) < 0)
+		return -1;
+	if (test_ast_gen_subtree(ctx) < 0)
+		return -1;
+	if (test_ast_expr(ctx) < 0)
+		return -1;
+	if (test_ast_expr_cache(ctx) < 0)
+		return -1;
+	if (test_ast_stride_cache(ctx) < 0)
+		return -1;
+	return 0;
+}
+
+/* Check if dropping output dimensions from an isl_pw_multi_aff
+ * works properly.
+ */
+static int test_pw_multi_aff(isl_ctx *ctx)
 {
 	const char *str;
-	isl_map *map;
-	isl_val *exp;
+	isl_pw_multi_aff *pma1, *pma2;
 	int equal;
 
-	str = "{ [i] -> [i + 1] }";
-	map = isl_map_read_from_str(ctx, str);
-	exp = isl_val_int_from_si(ctx, 23);
-	map = isl_map_fixed_power_val(map, exp);
-	equal = map_check_equal(map, "{ [i] -> [i + 23] }");
-	isl_map_free(map);
+	str = "{ [i,j] -> [i+j, 4i-j] }";
+	pma1 = isl_pw_multi_aff_read_from_str(ctx, str);
+	str = "{ [i,j] -> [4i-j] }";
+	pma2 = isl_pw_multi_aff_read_from_str(ctx, str);
+
+	pma1 = isl_pw_multi_aff_drop_dims(pma1, isl_dim_out, 0, 1);
+
+	equal = isl_pw_multi_aff_plain_is_equal(pma1, pma2);
+
+	isl_pw_multi_aff_free(pma1);
+	isl_pw_multi_aff_free(pma2);
 	if (equal < 0)
 		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"expressions not equal", return -1);
 
 	return 0;
 }
 
-int test_slice(isl_ctx *ctx)
+/* Check that we can properly parse multi piecewise affine expressions
+ * where the piecewise affine expressions have different domains.
+ */
+static int test_multi_pw_aff_1(isl_ctx *ctx)
 {
 	const char *str;
-	isl_map *map;
+	isl_set *dom, *dom2;
+	isl_multi_pw_aff *mpa1, *mpa2;
+	isl_pw_aff *pa;
 	int equal;
+	int equal_domain;
 
-	str = "{ [i] -> [j] }";
-	map = isl_map_read_from_str(ctx, str);
-	map = isl_map_equate(map, isl_dim_in, 0, isl_dim_out, 0);
-	equal = map_check_equal(map, "{ [i] -> [i] }");
-	isl_map_free(map);
-	if (equal < 0)
-		return -1;
-
-	str = "{ [i] -> [j] }";
-	map = isl_map_read_from_str(ctx, str);
-	map = isl_map_equate(map, isl_dim_in, 0, isl_dim_in, 0);
-	equal = map_check_equal(map, "{ [i] -> [j] }");
-	isl_map_free(map);
-	if (equal < 0)
-		return -1;
+	mpa1 = isl_multi_pw_aff_read_from_str(ctx, "{ [i] -> [i] }");
+	dom = isl_set_read_from_str(ctx, "{ [i] : i > 0 }");
+	mpa1 = isl_multi_pw_aff_intersect_domain(mpa1, dom);
+	mpa2 = isl_multi_pw_aff_read_from_str(ctx, "{ [i] -> [2i] }");
+	mpa2 = isl_multi_pw_aff_flat_range_product(mpa1, mpa2);
+	str = "{ [i] -> [(i : i > 0), 2i] }";
+	mpa1 = isl_multi_pw_aff_read_from_str(ctx, str);
 
-	str = "{ [i] -> [j] }";
-	map = isl_map_read_from_str(ctx, str);
-	map = isl_map_oppose(map, isl_dim_in, 0, isl_dim_out, 0);
-	equal = map_check_equal(map, "{ [i] -> [-i] }");
-	isl_map_free(map);
-	if (equal < 0)
-		return -1;
+	equal = isl_multi_pw_aff_plain_is_equal(mpa1, mpa2);
 
-	str = "{ [i] -> [j] }";
-	map = isl_map_read_from_str(ctx, str);
-	map = isl_map_oppose(map, isl_dim_in, 0, isl_dim_in, 0);
-	equal = map_check_equal(map, "{ [0] -> [j] }");
-	isl_map_free(map);
-	if (equal < 0)
-		return -1;
+	pa = isl_multi_pw_aff_get_pw_aff(mpa1, 0);
+	dom = isl_pw_aff_domain(pa);
+	pa = isl_multi_pw_aff_get_pw_aff(mpa1, 1);
+	dom2 = isl_pw_aff_domain(pa);
+	equal_domain = isl_set_is_equal(dom, dom2);
+
+	isl_set_free(dom);
+	isl_set_free(dom2);
+	isl_multi_pw_aff_free(mpa1);
+	isl_multi_pw_aff_free(mpa2);
 
-	str = "{ [i] -> [j] }";
-	map = isl_map_read_from_str(ctx, str);
-	map = isl_map_order_gt(map, isl_dim_in, 0, isl_dim_out, 0);
-	equal = map_check_equal(map, "{ [i] -> [j] : i > j }");
-	isl_map_free(map);
 	if (equal < 0)
 		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"expressions not equal", return -1);
 
-	str = "{ [i] -> [j] }";
-	map = isl_map_read_from_str(ctx, str);
-	map = isl_map_order_gt(map, isl_dim_in, 0, isl_dim_in, 0);
-	equal = map_check_equal(map, "{ [i] -> [j] : false }");
-	isl_map_free(map);
-	if (equal < 0)
+	if (equal_domain < 0)
 		return -1;
+	if (equal_domain)
+		isl_die(ctx, isl_error_unknown,
+			"domains unexpectedly equal", return -1);
 
 	return 0;
 }
 
-int test_eliminate(isl_ctx *ctx)
+/* Check that the dimensions in the explicit domain
+ * of a multi piecewise affine expression are properly
+ * taken into account.
+ */
+static int test_multi_pw_aff_2(isl_ctx *ctx)
 {
 	const char *str;
-	isl_map *map;
-	int equal;
+	isl_bool involves1, involves2, involves3, equal;
+	isl_multi_pw_aff *mpa, *mpa1, *mpa2;
 
-	str = "{ [i] -> [j] : i = 2j }";
-	map = isl_map_read_from_str(ctx, str);
-	map = isl_map_eliminate(map, isl_dim_out, 0, 1);
-	equal = map_check_equal(map, "{ [i] -> [j] : exists a : i = 2a }");
-	isl_map_free(map);
-	if (equal < 0)
-		return -1;
+	str = "{ A[x,y] -> B[] : x >= y }";
+	mpa = isl_multi_pw_aff_read_from_str(ctx, str);
+	involves1 = isl_multi_pw_aff_involves_dims(mpa, isl_dim_in, 0, 2);
+	mpa1 = isl_multi_pw_aff_copy(mpa);
 
-	return 0;
-}
+	mpa = isl_multi_pw_aff_insert_dims(mpa, isl_dim_in, 0, 1);
+	involves2 = isl_multi_pw_aff_involves_dims(mpa, isl_dim_in, 0, 1);
+	involves3 = isl_multi_pw_aff_involves_dims(mpa, isl_dim_in, 1, 2);
+	str = "{ [a,x,y] -> B[] : x >= y }";
+	mpa2 = isl_multi_pw_aff_read_from_str(ctx, str);
+	equal = isl_multi_pw_aff_plain_is_equal(mpa, mpa2);
+	isl_multi_pw_aff_free(mpa2);
 
-/* Check basic functionality of isl_map_deltas_map.
- */
-static int test_deltas_map(isl_ctx *ctx)
-{
-	const char *str;
-	isl_map *map;
-	int equal;
+	mpa = isl_multi_pw_aff_drop_dims(mpa, isl_dim_in, 0, 1);
+	mpa = isl_multi_pw_aff_set_tuple_name(mpa, isl_dim_in, "A");
+	if (equal >= 0 && equal)
+		equal = isl_multi_pw_aff_plain_is_equal(mpa, mpa1);
+	isl_multi_pw_aff_free(mpa1);
+	isl_multi_pw_aff_free(mpa);
 
-	str = "{ A[i] -> A[i + 1] }";
-	map = isl_map_read_from_str(ctx, str);
-	map = isl_map_deltas_map(map);
-	equal = map_check_equal(map, "{ [A[i] -> A[i + 1]] -> A[1] }");
-	isl_map_free(map);
-	if (equal < 0)
+	if (involves1 < 0 || involves2 < 0 || involves3 < 0 || equal < 0)
 		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"incorrect result of dimension insertion/removal",
+			return isl_stat_error);
+	if (!involves1 || involves2 || !involves3)
+		isl_die(ctx, isl_error_unknown,
+			"incorrect characterization of involved dimensions",
+			return isl_stat_error);
 
 	return 0;
 }
 
-/* Check that isl_set_dim_residue_class detects that the values of j
- * in the set below are all odd and that it does not detect any spurious
- * strides.
+/* Check that isl_multi_union_pw_aff_multi_val_on_domain
+ * sets the explicit domain of a zero-dimensional result,
+ * such that it can be converted to an isl_union_map.
  */
-static int test_residue_class(isl_ctx *ctx)
+static isl_stat test_multi_pw_aff_3(isl_ctx *ctx)
 {
-	const char *str;
-	isl_set *set;
-	isl_int m, r;
-	isl_stat res;
+	isl_space *space;
+	isl_union_set *dom;
+	isl_multi_val *mv;
+	isl_multi_union_pw_aff *mupa;
+	isl_union_map *umap;
 
-	str = "{ [i,j] : j = 4 i + 1 and 0 <= i <= 100; "
-		"[i,j] : j = 4 i + 3 and 500 <= i <= 600 }";
-	set = isl_set_read_from_str(ctx, str);
-	isl_int_init(m);
-	isl_int_init(r);
-	res = isl_set_dim_residue_class(set, 1, &m, &r);
-	if (res >= 0 &&
-	    (isl_int_cmp_si(m, 2) != 0 || isl_int_cmp_si(r, 1) != 0))
-		isl_die(ctx, isl_error_unknown, "incorrect residue class",
-			res = isl_stat_error);
-	isl_int_clear(r);
-	isl_int_clear(m);
-	isl_set_free(set);
+	dom = isl_union_set_read_from_str(ctx, "{ A[]; B[] }");
+	space = isl_union_set_get_space(dom);
+	mv = isl_multi_val_zero(isl_space_set_from_params(space));
+	mupa = isl_multi_union_pw_aff_multi_val_on_domain(dom, mv);
+	umap = isl_union_map_from_multi_union_pw_aff(mupa);
+	isl_union_map_free(umap);
+	if (!umap)
+		return isl_stat_error;
 
-	return res;
+	return isl_stat_ok;
 }
 
-static int test_align_parameters_1(isl_ctx *ctx)
-{
-	const char *str;
-	isl_space *space;
-	isl_multi_aff *ma1, *ma2;
-	int equal;
-
-	str = "{ A[B[] -> C[]] -> D[E[] -> F[]] }";
-	ma1 = isl_multi_aff_read_from_str(ctx, str);
+/* String descriptions of boxes that
+ * are used for reconstructing box maps from their lower and upper bounds.
+ */
+static const char *multi_pw_aff_box_tests[] = {
+	"{ A[x, y] -> [] : x + y >= 0 }",
+	"[N] -> { A[x, y] -> [x] : x + y <= N }",
+	"[N] -> { A[x, y] -> [x : y] : x + y <= N }",
+};
 
-	space = isl_space_params_alloc(ctx, 1);
-	space = isl_space_set_dim_name(space, isl_dim_param, 0, "N");
-	ma1 = isl_multi_aff_align_params(ma1, space);
+/* Check that map representations of boxes can be reconstructed
+ * from their lower and upper bounds.
+ */
+static isl_stat test_multi_pw_aff_box(isl_ctx *ctx)
+{
+	int i;
 
-	str = "[N] -> { A[B[] -> C[]] -> D[E[] -> F[]] }";
-	ma2 = isl_multi_aff_read_from_str(ctx, str);
+	for (i = 0; i < ARRAY_SIZE(multi_pw_aff_box_tests); ++i) {
+		const char *str;
+		isl_bool equal;
+		isl_map *map, *box;
+		isl_multi_pw_aff *min, *max;
 
-	equal = isl_multi_aff_plain_is_equal(ma1, ma2);
+		str = multi_pw_aff_box_tests[i];
+		map = isl_map_read_from_str(ctx, str);
+		min = isl_map_min_multi_pw_aff(isl_map_copy(map));
+		max = isl_map_max_multi_pw_aff(isl_map_copy(map));
+		box = isl_map_universe(isl_map_get_space(map));
+		box = isl_map_lower_bound_multi_pw_aff(box, min);
+		box = isl_map_upper_bound_multi_pw_aff(box, max);
+		equal = isl_map_is_equal(map, box);
+		isl_map_free(map);
+		isl_map_free(box);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return isl_stat_error);
+	}
 
-	isl_multi_aff_free(ma1);
-	isl_multi_aff_free(ma2);
+	return isl_stat_ok;
+}
 
-	if (equal < 0)
+/* Perform some tests on multi piecewise affine expressions.
+ */
+static int test_multi_pw_aff(isl_ctx *ctx)
+{
+	if (test_multi_pw_aff_1(ctx) < 0)
+		return -1;
+	if (test_multi_pw_aff_2(ctx) < 0)
+		return -1;
+	if (test_multi_pw_aff_3(ctx) < 0)
+		return -1;
+	if (test_multi_pw_aff_box(ctx) < 0)
 		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown,
-			"result not as expected", return -1);
-
 	return 0;
 }
 
-/* Check the isl_multi_*_from_*_list operation in case inputs
- * have unaligned parameters.
- * In particular, older versions of isl would simply fail
- * (without printing any error message).
+/* This is a regression test for a bug where isl_basic_map_simplify
+ * would end up in an infinite loop.  In particular, we construct
+ * an empty basic set that is not obviously empty.
+ * isl_basic_set_is_empty marks the basic set as empty.
+ * After projecting out i3, the variable can be dropped completely,
+ * but isl_basic_map_simplify refrains from doing so if the basic set
+ * is empty and would end up in an infinite loop if it didn't test
+ * explicitly for empty basic maps in the outer loop.
  */
-static isl_stat test_align_parameters_2(isl_ctx *ctx)
+static int test_simplify_1(isl_ctx *ctx)
 {
-	isl_space *space;
-	isl_map *map;
-	isl_aff *aff;
-	isl_multi_aff *ma;
-
-	map = isl_map_read_from_str(ctx, "{ A[] -> M[x] }");
-	space = isl_map_get_space(map);
-	isl_map_free(map);
+	const char *str;
+	isl_basic_set *bset;
+	int empty;
 
-	aff = isl_aff_read_from_str(ctx, "[N] -> { A[] -> [N] }");
-	ma = isl_multi_aff_from_aff_list(space, isl_aff_list_from_aff(aff));
-	isl_multi_aff_free(ma);
+	str = "{ [i0, i1, i2, i3] : i0 >= -2 and 6i2 <= 4 + i0 + 5i1 and "
+		"i2 <= 22 and 75i2 <= 111 + 13i0 + 60i1 and "
+		"25i2 >= 38 + 6i0 + 20i1 and i0 <= -1 and i2 >= 20 and "
+		"i3 >= i2 }";
+	bset = isl_basic_set_read_from_str(ctx, str);
+	empty = isl_basic_set_is_empty(bset);
+	bset = isl_basic_set_project_out(bset, isl_dim_set, 3, 1);
+	isl_basic_set_free(bset);
+	if (!bset)
+		return -1;
+	if (!empty)
+		isl_die(ctx, isl_error_unknown,
+			"basic set should be empty", return -1);
 
-	if (!ma)
-		return isl_stat_error;
-	return isl_stat_ok;
+	return 0;
 }
 
-/* Perform basic parameter alignment tests.
+/* Check that the equality in the set description below
+ * is simplified away.
  */
-static int test_align_parameters(isl_ctx *ctx)
+static int test_simplify_2(isl_ctx *ctx)
 {
-	if (test_align_parameters_1(ctx) < 0)
-		return -1;
-	if (test_align_parameters_2(ctx) < 0)
-		return -1;
+	const char *str;
+	isl_basic_set *bset;
+	isl_bool universe;
 
-	return 0;
-}
+	str = "{ [a] : exists e0, e1: 32e1 = 31 + 31a + 31e0 }";
+	bset = isl_basic_set_read_from_str(ctx, str);
+	universe = isl_basic_set_plain_is_universe(bset);
+	isl_basic_set_free(bset);
 
-/* Check that isl_*_drop_unused_params actually drops the unused parameters
- * by comparing the result using isl_*_plain_is_equal.
- * Note that this assumes that isl_*_plain_is_equal does not consider
- * objects that only differ by unused parameters to be equal.
+	if (universe < 0)
+		return -1;
+	if (!universe)
+		isl_die(ctx, isl_error_unknown,
+			"equality not simplified away", return -1);
+	return 0;
+}
+
+/* Check that the variables that get eliminated using several
+ * equality constraints are removed from the inequality constraints,
+ * even if some of these equality constraints still involve
+ * the variables that are eliminated using the other equality constraints
+ * in the input.
  */
-int test_drop_unused_parameters(isl_ctx *ctx)
+static int test_simplify_3(isl_ctx *ctx)
 {
-	const char *str_with, *str_without;
+	const char *str;
 	isl_basic_set *bset1, *bset2;
-	isl_set *set1, *set2;
-	isl_pw_aff *pwa1, *pwa2;
-	int equal;
-
-	str_with = "[n, m, o] -> { [m] }";
-	str_without = "[m] -> { [m] }";
+	isl_bool equal;
 
-	bset1 = isl_basic_set_read_from_str(ctx, str_with);
-	bset2 = isl_basic_set_read_from_str(ctx, str_without);
-	bset1 = isl_basic_set_drop_unused_params(bset1);
+	str = "{ [x, y, z] : x = 2y + z and y = z + 1 and x + y + z >= 5 and "
+		"2x - y <= 100 }";
+	bset1 = isl_basic_set_read_from_str(ctx, str);
+	str = "{ [x, y, z] : 3y = 1 + x and 3z = -2 + x and x >= 4 and "
+		"x <= 60 }";
+	bset2 = isl_basic_set_read_from_str(ctx, str);
 	equal = isl_basic_set_plain_is_equal(bset1, bset2);
 	isl_basic_set_free(bset1);
 	isl_basic_set_free(bset2);
@@ -9081,1745 +16189,2633 @@ int test_drop_unused_parameters(isl_ctx *ctx)
 		return -1;
 	if (!equal)
 		isl_die(ctx, isl_error_unknown,
-			"result not as expected", return -1);
-
-	set1 = isl_set_read_from_str(ctx, str_with);
-	set2 = isl_set_read_from_str(ctx, str_without);
-	set1 = isl_set_drop_unused_params(set1);
-	equal = isl_set_plain_is_equal(set1, set2);
-	isl_set_free(set1);
-	isl_set_free(set2);
+			"variables not eliminated", return -1);
+	return 0;
+}
 
-	if (equal < 0)
-		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown,
-			"result not as expected", return -1);
+/* Check that a basic map that has already been simplified
+ * is simplified again after its integer division has been shifted
+ * in place by isl_basic_map_shift_div, i.e., that the shift
+ * is undone by the simplification.
+ */
+static int test_simplify_4(isl_ctx *ctx)
+{
+	const char *str;
+	isl_basic_map *bmap1, *bmap2;
+	isl_int one;
+	isl_bool equal;
 
-	pwa1 = isl_pw_aff_read_from_str(ctx, str_with);
-	pwa2 = isl_pw_aff_read_from_str(ctx, str_without);
-	pwa1 = isl_pw_aff_drop_unused_params(pwa1);
-	equal = isl_pw_aff_plain_is_equal(pwa1, pwa2);
-	isl_pw_aff_free(pwa1);
-	isl_pw_aff_free(pwa2);
+	str = "[n] -> { [i] : exists (e = floor(n/4): 0 <= i <= n - 4e) }";
+	bmap1 = isl_basic_map_read_from_str(ctx, str);
+	bmap1 = isl_basic_map_simplify(bmap1);
+	bmap2 = isl_basic_map_read_from_str(ctx, str);
+	bmap2 = isl_basic_map_simplify(bmap2);
+	isl_int_init(one);
+	isl_int_set_si(one, 1);
+	bmap1 = isl_basic_map_shift_div(bmap1, 0, 0, one);
+	isl_int_clear(one);
+	bmap1 = isl_basic_map_simplify(bmap1);
+	equal = isl_basic_map_plain_is_equal(bmap1, bmap2);
+	isl_basic_map_free(bmap1);
+	isl_basic_map_free(bmap2);
 
 	if (equal < 0)
 		return -1;
 	if (!equal)
 		isl_die(ctx, isl_error_unknown,
-			"result not as expected", return -1);
-
+			"shifted integer division not simplified", return -1);
 	return 0;
 }
 
-static int test_list(isl_ctx *ctx)
+/* Some simplification tests.
+ */
+static int test_simplify(isl_ctx *ctx)
 {
-	isl_id *a, *b, *c, *d, *id;
-	isl_id_list *list;
-	isl_size n;
-	int ok;
-
-	a = isl_id_alloc(ctx, "a", NULL);
-	b = isl_id_alloc(ctx, "b", NULL);
-	c = isl_id_alloc(ctx, "c", NULL);
-	d = isl_id_alloc(ctx, "d", NULL);
-
-	list = isl_id_list_alloc(ctx, 4);
-	list = isl_id_list_add(list, b);
-	list = isl_id_list_insert(list, 0, a);
-	list = isl_id_list_add(list, c);
-	list = isl_id_list_add(list, d);
-	list = isl_id_list_drop(list, 1, 1);
-
-	n = isl_id_list_n_id(list);
-	if (n < 0)
+	if (test_simplify_1(ctx) < 0)
 		return -1;
-	if (n != 3) {
-		isl_id_list_free(list);
-		isl_die(ctx, isl_error_unknown,
-			"unexpected number of elements in list", return -1);
-	}
+	if (test_simplify_2(ctx) < 0)
+		return -1;
+	if (test_simplify_3(ctx) < 0)
+		return -1;
+	if (test_simplify_4(ctx) < 0)
+		return -1;
+	return 0;
+}
 
-	id = isl_id_list_get_id(list, 0);
-	ok = id == a;
-	isl_id_free(id);
-	id = isl_id_list_get_id(list, 1);
-	ok = ok && id == c;
-	isl_id_free(id);
-	id = isl_id_list_get_id(list, 2);
-	ok = ok && id == d;
-	isl_id_free(id);
+/* This is a regression test for a bug where isl_tab_basic_map_partial_lexopt
+ * with gbr context would fail to disable the use of the shifted tableau
+ * when transferring equalities for the input to the context, resulting
+ * in invalid sample values.
+ */
+static int test_partial_lexmin(isl_ctx *ctx)
+{
+	const char *str;
+	isl_basic_set *bset;
+	isl_basic_map *bmap;
+	isl_map *map;
 
-	isl_id_list_free(list);
+	str = "{ [1, b, c, 1 - c] -> [e] : 2e <= -c and 2e >= -3 + c }";
+	bmap = isl_basic_map_read_from_str(ctx, str);
+	str = "{ [a, b, c, d] : c <= 1 and 2d >= 6 - 4b - c }";
+	bset = isl_basic_set_read_from_str(ctx, str);
+	map = isl_basic_map_partial_lexmin(bmap, bset, NULL);
+	isl_map_free(map);
 
-	if (!ok)
-		isl_die(ctx, isl_error_unknown,
-			"unexpected elements in list", return -1);
+	if (!map)
+		return -1;
 
 	return 0;
 }
 
-/* Check the conversion from an isl_multi_aff to an isl_basic_set.
+/* Check that the explicit expressions computed by isl_set_compute_divs
+ * on a shared set are reused by subsequent calls on the same set,
+ * i.e., that no further tableau pivots are performed,
+ * and that the result is the same.
  */
-static isl_stat test_ma_conversion(isl_ctx *ctx)
+static isl_stat test_compute_divs_cached(isl_ctx *ctx)
 {
 	const char *str;
+	isl_set *set, *res1, *res2;
+	struct isl_stats stats;
+	long tab_pivots;
 	isl_bool equal;
-	isl_multi_aff *ma;
-	isl_basic_set *bset1, *bset2;
 
-	str = "[N] -> { A[0, N + 1] }";
-	ma = isl_multi_aff_read_from_str(ctx, str);
-	bset1 = isl_basic_set_read_from_str(ctx, str);
-	bset2 = isl_basic_set_from_multi_aff(ma);
-	equal = isl_basic_set_is_equal(bset1, bset2);
-	isl_basic_set_free(bset1);
-	isl_basic_set_free(bset2);
+	str = "{ [i] : exists (a, b : i = 3a + 5b and 0 <= a <= 10 and "
+		"0 <= b <= 10 and a <= 2b) }";
+	set = isl_set_read_from_str(ctx, str);
+	res1 = isl_set_compute_divs(isl_set_copy(set));
+	if (isl_ctx_get_stats(ctx, &stats) < 0)
+		res1 = isl_set_free(res1);
+	tab_pivots = stats.tab_pivots;
+	res2 = isl_set_compute_divs(isl_set_copy(set));
+	if (isl_ctx_get_stats(ctx, &stats) < 0)
+		res2 = isl_set_free(res2);
+	equal = isl_set_is_equal(res1, res2);
+	if (equal >= 0 && equal)
+		equal = isl_set_is_equal(res1, set);
+	isl_set_free(res1);
+	isl_set_free(res2);
+	isl_set_free(set);
+
 	if (equal < 0)
 		return isl_stat_error;
 	if (!equal)
-		isl_die(ctx, isl_error_unknown, "bad conversion",
+		isl_die(ctx, isl_error_unknown, "unexpected result",
 			return isl_stat_error);
+	if (stats.tab_pivots <= 0 || stats.tab_pivots != tab_pivots)
+		isl_die(ctx, isl_error_unknown,
+			"explicit divs not reused", return isl_stat_error);
+
 	return isl_stat_ok;
 }
 
-const char *set_conversion_tests[] = {
-	"[N] -> { [i] : N - 1 <= 2 i <= N }",
-	"[N] -> { [i] : exists a : i = 4 a and N - 1 <= i <= N }",
-	"[N] -> { [i,j] : exists a : i = 4 a and N - 1 <= i, 2j <= N }",
-	"[N] -> { [[i]->[j]] : exists a : i = 4 a and N - 1 <= i, 2j <= N }",
-	"[N] -> { [3*floor(N/2) + 5*floor(N/3)] }",
-	"[a, b] -> { [c, d] : (4*floor((-a + c)/4) = -a + c and "
-			"32*floor((-b + d)/32) = -b + d and 5 <= c <= 8 and "
-			"-3 + c <= d <= 28 + c) }",
+/* Project out the last variable of the set described by "str"
+ * using the method "method" of the project_out option and
+ * compute explicit representations for the remaining existentially
+ * quantified variables.  Check that the number of variables eliminated using
+ * Fourier-Motzkin elimination and the number of explicit representations
+ * computed using parametric integer programming are "n_fm" and "n_pip".
+ */
+static __isl_give isl_set *project_out_method(isl_ctx *ctx, const char *str,
+	int method, long n_fm, long n_pip)
+{
+	isl_size dim;
+	isl_set *set;
+	struct isl_stats stats;
+
+	if (isl_options_set_project_out(ctx, method) < 0)
+		return NULL;
+	set = isl_set_read_from_str(ctx, str);
+	dim = isl_set_dim(set, isl_dim_set);
+	if (dim < 0)
+		return isl_set_free(set);
+	isl_ctx_reset_stats(ctx);
+	set = isl_set_project_out(set, isl_dim_set, dim - 1, 1);
+	set = isl_set_compute_divs(set);
+	if (isl_ctx_get_stats(ctx, &stats) < 0)
+		return isl_set_free(set);
+	if (stats.project_out_fm != n_fm || stats.compute_divs_pip != n_pip)
+		isl_die(ctx, isl_error_unknown, "unexpected method used",
+			return isl_set_free(set));
+
+	return set;
+}
+
+/* Inputs for test_project_out_method, along with the number of
+ * variables that are expected to be eliminated using Fourier-Motzkin
+ * elimination for the "fm" and "auto" methods and
+ * the number of explicit representations that are expected
+ * to be computed using parametric integer programming.
+ * The variable that is projected out in the first input only has
+ * unit lower bounds, so it can be eliminated exactly.
+ * The one in the second input has no unit bounds and
+ * the one in the third input can be eliminated exactly, but
+ * this would increase the number of constraints.
+ */
+static struct {
+	const char *str;
+	long n_fm;
+	long n_auto;
+	long n_pip;
+} project_out_method_tests[] = {
+	{ "[n] -> { [i, a] : a >= 0 and a >= 2i - n and "
+		"3a <= n + i and 2a <= i + 7 }", 1, 1, 0 },
+	{ "{ [i, a] : 2a >= i and 3a <= i + 10 }", 0, 0, 1 },
+	{ "[n, m] -> { [i, a] : a >= 0 and a >= i and a >= n and "
+		"2a <= m and 3a <= i + m and 5a <= n + m }", 1, 0, 0 },
 };
 
-/* Check that converting from isl_set to isl_pw_multi_aff and back
- * to isl_set produces the original isl_set.
+/* Check that the project_out option selects the method used
+ * to project out variables and that the result
+ * does not depend on the method.
  */
-static int test_set_conversion(isl_ctx *ctx)
+static isl_stat test_project_out_method(isl_ctx *ctx)
 {
 	int i;
-	const char *str;
-	isl_set *set1, *set2;
-	isl_pw_multi_aff *pma;
-	int equal;
+	int method;
 
-	for (i = 0; i < ARRAY_SIZE(set_conversion_tests); ++i) {
-		str = set_conversion_tests[i];
-		set1 = isl_set_read_from_str(ctx, str);
-		pma = isl_pw_multi_aff_from_set(isl_set_copy(set1));
-		set2 = isl_set_from_pw_multi_aff(pma);
+	method = isl_options_get_project_out(ctx);
+	for (i = 0; i < ARRAY_SIZE(project_out_method_tests); ++i) {
+		const char *str;
+		isl_set *set1, *set2, *set3;
+		isl_bool equal;
+
+		str = project_out_method_tests[i].str;
+		set1 = project_out_method(ctx, str, ISL_PROJECT_OUT_DIV, 0,
+				project_out_method_tests[i].n_pip);
+		set2 = project_out_method(ctx, str, ISL_PROJECT_OUT_FM,
+				project_out_method_tests[i].n_fm,
+				project_out_method_tests[i].n_pip);
+		set3 = project_out_method(ctx, str, ISL_PROJECT_OUT_AUTO,
+				project_out_method_tests[i].n_auto,
+				project_out_method_tests[i].n_pip);
 		equal = isl_set_is_equal(set1, set2);
+		if (equal >= 0 && equal)
+			equal = isl_set_is_equal(set1, set3);
 		isl_set_free(set1);
 		isl_set_free(set2);
+		isl_set_free(set3);
 
-		if (equal < 0)
-			return -1;
-		if (!equal)
-			isl_die(ctx, isl_error_unknown, "bad conversion",
-				return -1);
+		if (equal < 0 || !equal)
+			break;
 	}
+	if (isl_options_set_project_out(ctx, method) < 0)
+		return isl_stat_error;
+	if (i < ARRAY_SIZE(project_out_method_tests))
+		isl_die(ctx, isl_error_unknown, "unexpected result",
+			return isl_stat_error);
 
-	return 0;
+	return isl_stat_ok;
 }
 
-const char *conversion_tests[] = {
-	"{ [a, b, c, d] -> s0[a, b, e, f] : "
-	    "exists (e0 = [(a - 2c)/3], e1 = [(-4 + b - 5d)/9], "
-	    "e2 = [(-d + f)/9]: 3e0 = a - 2c and 9e1 = -4 + b - 5d and "
-	    "9e2 = -d + f and f >= 0 and f <= 8 and 9e >= -5 - 2a and "
-	    "9e <= -2 - 2a) }",
-	"{ [a, b] -> [c] : exists (e0 = floor((-a - b + c)/5): "
-	    "5e0 = -a - b + c and c >= -a and c <= 4 - a) }",
-	"{ [a, b] -> [c] : exists d : 18 * d = -3 - a + 2c and 1 <= c <= 3 }",
-};
-
-/* Check that converting from isl_map to isl_pw_multi_aff and back
- * to isl_map produces the original isl_map.
+/* Check that the variable compression performed on the existentially
+ * quantified variables inside isl_basic_set_compute_divs is not confused
+ * by the implicit equalities among the parameters.
  */
-static int test_map_conversion(isl_ctx *ctx)
+static int test_compute_divs(isl_ctx *ctx)
 {
-	int i;
-	isl_map *map1, *map2;
-	isl_pw_multi_aff *pma;
-	int equal;
+	const char *str;
+	isl_basic_set *bset;
+	isl_set *set;
 
-	for (i = 0; i < ARRAY_SIZE(conversion_tests); ++i) {
-		map1 = isl_map_read_from_str(ctx, conversion_tests[i]);
-		pma = isl_pw_multi_aff_from_map(isl_map_copy(map1));
-		map2 = isl_map_from_pw_multi_aff(pma);
-		equal = isl_map_is_equal(map1, map2);
-		isl_map_free(map1);
-		isl_map_free(map2);
+	str = "[a, b, c, d, e] -> { [] : exists (e0: 2d = b and a <= 124 and "
+		"b <= 2046 and b >= 0 and b <= 60 + 64a and 2e >= b + 2c and "
+		"2e >= b and 2e <= 1 + b and 2e <= 1 + b + 2c and "
+		"32768e0 >= -124 + a and 2097152e0 <= 60 + 64a - b) }";
+	bset = isl_basic_set_read_from_str(ctx, str);
+	set = isl_basic_set_compute_divs(bset);
+	isl_set_free(set);
+	if (!set)
+		return -1;
 
-		if (equal < 0)
-			return -1;
-		if (!equal)
-			isl_die(ctx, isl_error_unknown, "bad conversion",
-				return -1);
-	}
+	if (test_compute_divs_cached(ctx) < 0)
+		return -1;
+	if (test_project_out_method(ctx) < 0)
+		return -1;
 
 	return 0;
 }
 
-/* Descriptions of isl_pw_multi_aff objects for testing conversion
- * to isl_multi_pw_aff and back.
+/* Check that the parameters of the filter of a schedule tree
+ * that is read from a string are aligned to those
+ * of the domain read before it.
  */
-const char *mpa_conversion_tests[] = {
-	"{ [x] -> A[x] }",
-	"{ [x] -> A[x] : x >= 0 }",
-	"{ [x] -> A[x] : x >= 0; [x] -> A[-x] : x < 0 }",
-	"{ [x] -> A[x, x + 1] }",
-	"{ [x] -> A[] }",
-	"{ [x] -> A[] : x >= 0 }",
-};
+static isl_stat test_schedule_read_params(isl_ctx *ctx)
+{
+	const char *str;
+	isl_schedule *schedule;
+	isl_schedule_node *node;
+	isl_union_set *filter;
+	isl_set *params;
+	isl_space *space, *expected;
+	isl_bool equal;
+
+	str = "{ domain: \"[n] -> { A[i] : 0 <= i < n }\", "
+	    "child: { filter: \"[m] -> { A[i] : i < m }\" } }";
+	schedule = isl_schedule_read_from_str(ctx, str);
+	node = isl_schedule_get_root(schedule);
+	isl_schedule_free(schedule);
+	node = isl_schedule_node_child(node, 0);
+	filter = isl_schedule_node_filter_get_filter(node);
+	isl_schedule_node_free(node);
+	space = isl_union_set_get_space(filter);
+	isl_union_set_free(filter);
+	params = isl_set_read_from_str(ctx, "[n, m] -> { : }");
+	expected = isl_set_get_space(params);
+	isl_set_free(params);
+	equal = isl_space_is_equal(space, expected);
+	isl_space_free(space);
+	isl_space_free(expected);
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"filter parameters not aligned", return isl_stat_error);
+
+	return isl_stat_ok;
+}
 
-/* Check that conversion from isl_pw_multi_aff to isl_multi_pw_aff and
- * back to isl_pw_multi_aff preserves the original meaning.
+/* Check that printing a schedule tree with YAML anchors enabled
+ * replaces repeated values by aliases and that the result
+ * can be read back.
  */
-static int test_mpa_conversion(isl_ctx *ctx)
+static isl_stat test_schedule_yaml_anchors(isl_ctx *ctx)
 {
-	int i;
-	isl_pw_multi_aff *pma1, *pma2;
-	isl_multi_pw_aff *mpa;
-	int equal;
-
-	for (i = 0; i < ARRAY_SIZE(mpa_conversion_tests); ++i) {
-		const char *str;
-		str = mpa_conversion_tests[i];
-		pma1 = isl_pw_multi_aff_read_from_str(ctx, str);
-		pma2 = isl_pw_multi_aff_copy(pma1);
-		mpa = isl_multi_pw_aff_from_pw_multi_aff(pma1);
-		pma1 = isl_pw_multi_aff_from_multi_pw_aff(mpa);
-		equal = isl_pw_multi_aff_plain_is_equal(pma1, pma2);
-		isl_pw_multi_aff_free(pma1);
-		isl_pw_multi_aff_free(pma2);
-
-		if (equal < 0)
-			return -1;
-		if (!equal)
-			isl_die(ctx, isl_error_unknown, "bad conversion",
-				return -1);
+	const char *str;
+	char *printed;
+	isl_printer *p;
+	isl_schedule *schedule, *schedule2;
+	isl_bool equal;
+	int aliased;
+
+	str = "{ domain: \"{ A[i] : 0 <= i < 10; B[i] : 0 <= i < 10 }\", "
+	    "child: { sequence: [ "
+	    "{ filter: \"{ A[i] }\", "
+	    "child: { schedule: \"[{ A[i] -> [i] }]\", "
+	    "child: { mark: \"m\", child: { filter: \"{ A[i] }\" } } } }, "
+	    "{ filter: \"{ B[i] }\", "
+	    "child: { schedule: \"[{ B[i] -> [i] }]\", "
+	    "child: { mark: \"m\", child: { filter: \"{ B[i] }\" } } } } "
+	    "] } }";
+	schedule = isl_schedule_read_from_str(ctx, str);
+	p = isl_printer_to_str(ctx);
+	p = isl_printer_set_yaml_style(p, ISL_YAML_STYLE_BLOCK);
+	p = isl_printer_set_yaml_anchors(p, 1);
+	p = isl_printer_print_schedule(p, schedule);
+	printed = isl_printer_get_str(p);
+	isl_printer_free(p);
+	if (!printed) {
+		isl_schedule_free(schedule);
+		return isl_stat_error;
 	}
+	aliased = strstr(printed, "*a") != NULL;
+	schedule2 = isl_schedule_read_from_str(ctx, printed);
+	free(printed);
+	equal = isl_schedule_plain_is_equal(schedule, schedule2);
+	isl_schedule_free(schedule);
+	isl_schedule_free(schedule2);
+	if (equal < 0)
+		return isl_stat_error;
+	if (!aliased)
+		isl_die(ctx, isl_error_unknown, "no aliases printed",
+			return isl_stat_error);
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "schedules not equal",
+			return isl_stat_error);
 
-	return 0;
+	return isl_stat_ok;
 }
 
-/* Descriptions of union maps that should be convertible
- * to an isl_multi_union_pw_aff.
- */
-const char *umap_mupa_conversion_tests[] = {
-	"{ [a, b, c, d] -> s0[a, b, e, f] : "
-	    "exists (e0 = [(a - 2c)/3], e1 = [(-4 + b - 5d)/9], "
-	    "e2 = [(-d + f)/9]: 3e0 = a - 2c and 9e1 = -4 + b - 5d and "
-	    "9e2 = -d + f and f >= 0 and f <= 8 and 9e >= -5 - 2a and "
-	    "9e <= -2 - 2a) }",
-	"{ [a, b] -> [c] : exists (e0 = floor((-a - b + c)/5): "
-	    "5e0 = -a - b + c and c >= -a and c <= 4 - a) }",
-	"{ [a, b] -> [c] : exists d : 18 * d = -3 - a + 2c and 1 <= c <= 3 }",
-	"{ A[] -> B[0]; C[] -> B[1] }",
-	"{ A[] -> B[]; C[] -> B[] }",
-};
-
-/* Check that converting from isl_union_map to isl_multi_union_pw_aff and back
- * to isl_union_map produces the original isl_union_map.
+/* Check that repeatedly moving a schedule node down to a leaf
+ * and back up to the root, which reuses the node in place,
+ * ends up at the root again and that a copy of the node
+ * taken at the leaf is not affected by the moves.
  */
-static int test_union_map_mupa_conversion(isl_ctx *ctx)
+static isl_stat test_schedule_node_navigation(isl_ctx *ctx)
 {
-	int i;
-	isl_union_map *umap1, *umap2;
-	isl_multi_union_pw_aff *mupa;
-	int equal;
+	int i, j;
+	isl_union_set *domain;
+	isl_schedule_node *node, *root, *leaf;
+	isl_bool equal;
+	isl_size depth;
 
-	for (i = 0; i < ARRAY_SIZE(umap_mupa_conversion_tests); ++i) {
-		const char *str;
-		str = umap_mupa_conversion_tests[i];
-		umap1 = isl_union_map_read_from_str(ctx, str);
-		umap2 = isl_union_map_copy(umap1);
-		mupa = isl_multi_union_pw_aff_from_union_map(umap2);
-		umap2 = isl_union_map_from_multi_union_pw_aff(mupa);
-		equal = isl_union_map_is_equal(umap1, umap2);
-		isl_union_map_free(umap1);
-		isl_union_map_free(umap2);
+	domain = isl_union_set_read_from_str(ctx, "{ A[i] : 0 <= i < 10 }");
+	node = isl_schedule_node_from_domain(domain);
+	node = isl_schedule_node_child(node, 0);
+	for (i = 0; i < 20; ++i) {
+		isl_id *id;
 
-		if (equal < 0)
-			return -1;
-		if (!equal)
-			isl_die(ctx, isl_error_unknown, "bad conversion",
-				return -1);
+		id = isl_id_alloc(ctx, "m", NULL);
+		node = isl_schedule_node_insert_mark(node, id);
 	}
+	node = isl_schedule_node_root(node);
+	root = isl_schedule_node_copy(node);
+	leaf = NULL;
+	for (i = 0; i < 3; ++i) {
+		for (j = 0; j < 21; ++j)
+			node = isl_schedule_node_child(node, 0);
+		if (!leaf)
+			leaf = isl_schedule_node_copy(node);
+		for (j = 0; j < 21; ++j)
+			node = isl_schedule_node_parent(node);
+	}
+	equal = isl_schedule_node_is_equal(node, root);
+	depth = isl_schedule_node_get_tree_depth(leaf);
+	isl_schedule_node_free(node);
+	isl_schedule_node_free(root);
+	isl_schedule_node_free(leaf);
+	if (equal < 0 || depth < 0)
+		return isl_stat_error;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "not back at root",
+			return isl_stat_error);
+	if (depth != 21)
+		isl_die(ctx, isl_error_unknown, "unexpected depth",
+			return isl_stat_error);
 
-	return 0;
+	return isl_stat_ok;
 }
 
-static int test_conversion(isl_ctx *ctx)
+/* Check that isl_schedule_get_map is not confused by a schedule tree
+ * with divergent filter node parameters, as can result from a call
+ * to isl_schedule_intersect_domain.
+ */
+static int test_schedule_tree(isl_ctx *ctx)
 {
-	if (test_ma_conversion(ctx) < 0)
-		return -1;
-	if (test_set_conversion(ctx) < 0)
+	const char *str;
+	isl_union_set *uset;
+	isl_schedule *sched1, *sched2;
+	isl_union_map *umap;
+
+	uset = isl_union_set_read_from_str(ctx, "{ A[i] }");
+	sched1 = isl_schedule_from_domain(uset);
+	uset = isl_union_set_read_from_str(ctx, "{ B[] }");
+	sched2 = isl_schedule_from_domain(uset);
+
+	sched1 = isl_schedule_sequence(sched1, sched2);
+	str = "[n] -> { A[i] : 0 <= i < n; B[] }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	sched1 = isl_schedule_intersect_domain(sched1, uset);
+	umap = isl_schedule_get_map(sched1);
+	isl_schedule_free(sched1);
+	isl_union_map_free(umap);
+	if (!umap)
 		return -1;
-	if (test_map_conversion(ctx) < 0)
+
+	if (test_schedule_read_params(ctx) < 0)
 		return -1;
-	if (test_mpa_conversion(ctx) < 0)
+	if (test_schedule_yaml_anchors(ctx) < 0)
 		return -1;
-	if (test_union_map_mupa_conversion(ctx) < 0)
+	if (test_schedule_node_navigation(ctx) < 0)
 		return -1;
+
 	return 0;
 }
 
-/* Check that isl_basic_map_curry does not modify input.
+/* Check that modifications of a schedule tree through a schedule node
+ * do not affect a copy of the schedule that was extracted earlier,
+ * while subsequent modifications through the same node
+ * (which may be performed in place) are all preserved.
  */
-static int test_curry(isl_ctx *ctx)
+static int test_schedule_tree_inplace(isl_ctx *ctx)
 {
 	const char *str;
-	isl_basic_map *bmap1, *bmap2;
-	int equal;
+	char *str1, *str2;
+	int ok;
+	enum isl_schedule_node_type type;
+	isl_union_set *uset;
+	isl_multi_union_pw_aff *mupa;
+	isl_schedule *snapshot, *schedule;
+	isl_schedule_node *node;
 
-	str = "{ [A[] -> B[]] -> C[] }";
-	bmap1 = isl_basic_map_read_from_str(ctx, str);
-	bmap2 = isl_basic_map_curry(isl_basic_map_copy(bmap1));
-	equal = isl_basic_map_is_equal(bmap1, bmap2);
-	isl_basic_map_free(bmap1);
-	isl_basic_map_free(bmap2);
+	str = "{ S[i, j] : 0 <= i, j < 10 }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	node = isl_schedule_node_from_domain(uset);
+	node = isl_schedule_node_child(node, 0);
+	str = "[{ S[i, j] -> [(i)] }]";
+	mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
+	node = isl_schedule_node_insert_partial_schedule(node, mupa);
+	snapshot = isl_schedule_node_get_schedule(node);
+	str1 = isl_schedule_to_str(snapshot);
+	node = isl_schedule_node_child(node, 0);
+	node = isl_schedule_node_insert_mark(node, isl_id_alloc(ctx, "a", NULL));
+	node = isl_schedule_node_child(node, 0);
+	node = isl_schedule_node_insert_mark(node, isl_id_alloc(ctx, "b", NULL));
+	str2 = isl_schedule_to_str(snapshot);
+	schedule = isl_schedule_node_get_schedule(node);
+	isl_schedule_node_free(node);
+	isl_schedule_free(snapshot);
 
-	if (equal < 0)
+	node = isl_schedule_get_root(schedule);
+	isl_schedule_free(schedule);
+	node = isl_schedule_node_child(node, 0);
+	node = isl_schedule_node_child(node, 0);
+	node = isl_schedule_node_child(node, 0);
+	type = isl_schedule_node_get_type(node);
+	isl_schedule_node_free(node);
+
+	ok = str1 && str2 && !strcmp(str1, str2);
+	free(str1);
+	free(str2);
+	if (type < 0)
 		return -1;
-	if (equal)
+	if (!ok || type != isl_schedule_node_mark)
 		isl_die(ctx, isl_error_unknown,
-			"curried map should not be equal to original",
-			return -1);
-
-	return 0;
-}
-
-struct {
-	const char *ma1;
-	const char *ma;
-	const char *res;
-} pullback_tests[] = {
-	{ "{ B[i,j] -> C[i + 2j] }" , "{ A[a,b] -> B[b,a] }",
-	  "{ A[a,b] -> C[b + 2a] }" },
-	{ "{ B[i] -> C[2i] }", "{ A[a] -> B[(a)/2] }", "{ A[a] -> C[a] }" },
-	{ "{ B[i] -> C[(i)/2] }", "{ A[a] -> B[2a] }", "{ A[a] -> C[a] }" },
-	{ "{ B[i] -> C[(i)/2] }", "{ A[a] -> B[(a)/3] }",
-	  "{ A[a] -> C[(a)/6] }" },
-	{ "{ B[i] -> C[2i] }", "{ A[a] -> B[5a] }", "{ A[a] -> C[10a] }" },
-	{ "{ B[i] -> C[2i] }", "{ A[a] -> B[(a)/3] }",
-	  "{ A[a] -> C[(2a)/3] }" },
-	{ "{ B[i,j] -> C[i + j] }", "{ A[a] -> B[a,a] }", "{ A[a] -> C[2a] }"},
-	{ "{ B[a] -> C[a,a] }", "{ A[i,j] -> B[i + j] }",
-	  "{ A[i,j] -> C[i + j, i + j] }"},
-	{ "{ B[i] -> C[([i/2])] }", "{ B[5] }", "{ C[2] }" },
-	{ "[n] -> { B[i,j] -> C[([i/2]) + 2j] }",
-	  "[n] -> { B[n,[n/3]] }", "[n] -> { C[([n/2]) + 2*[n/3]] }", },
-	{ "{ [i, j] -> [floor((i)/4) + floor((2*i+j)/5)] }",
-	  "{ [i, j] -> [floor((i)/3), j] }",
-	  "{ [i, j] -> [(floor((i)/12) + floor((j + 2*floor((i)/3))/5))] }" },
-};
-
-static int test_pullback(isl_ctx *ctx)
-{
-	int i;
-	isl_multi_aff *ma1, *ma2;
-	isl_multi_aff *ma;
-	int equal;
-
-	for (i = 0; i < ARRAY_SIZE(pullback_tests); ++i) {
-		ma1 = isl_multi_aff_read_from_str(ctx, pullback_tests[i].ma1);
-		ma = isl_multi_aff_read_from_str(ctx, pullback_tests[i].ma);
-		ma2 = isl_multi_aff_read_from_str(ctx, pullback_tests[i].res);
-		ma1 = isl_multi_aff_pullback_multi_aff(ma1, ma);
-		equal = isl_multi_aff_plain_is_equal(ma1, ma2);
-		isl_multi_aff_free(ma1);
-		isl_multi_aff_free(ma2);
-		if (equal < 0)
-			return -1;
-		if (!equal)
-			isl_die(ctx, isl_error_unknown, "bad pullback",
-				return -1);
-	}
+			"unexpected schedule tree", return -1);
 
 	return 0;
 }
 
-/* Check that negation is printed correctly and that equal expressions
- * are correctly identified.
+/* Check that the (cached) schedule map of a schedule is not affected
+ * by a modification of a schedule derived from it and that
+ * the schedule map of the derived schedule does reflect the modification.
  */
-static int test_ast(isl_ctx *ctx)
+static int test_schedule_tree_cached_map(isl_ctx *ctx)
 {
-	isl_ast_expr *expr, *expr1, *expr2, *expr3;
-	char *str;
-	int ok, equal;
-
-	expr1 = isl_ast_expr_from_id(isl_id_alloc(ctx, "A", NULL));
-	expr2 = isl_ast_expr_from_id(isl_id_alloc(ctx, "B", NULL));
-	expr = isl_ast_expr_add(expr1, expr2);
-	expr2 = isl_ast_expr_copy(expr);
-	expr = isl_ast_expr_neg(expr);
-	expr2 = isl_ast_expr_neg(expr2);
-	equal = isl_ast_expr_is_equal(expr, expr2);
-	str = isl_ast_expr_to_C_str(expr);
-	ok = str ? !strcmp(str, "-(A + B)") : -1;
-	free(str);
-	isl_ast_expr_free(expr);
-	isl_ast_expr_free(expr2);
+	const char *str;
+	isl_bool equal1, equal2, equal3;
+	isl_union_set *uset;
+	isl_multi_union_pw_aff *mupa;
+	isl_schedule *schedule, *schedule2;
+	isl_schedule_node *node;
+	isl_union_map *umap1, *umap2, *umap3, *expected;
 
-	if (ok < 0 || equal < 0)
-		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown,
-			"equal expressions not considered equal", return -1);
-	if (!ok)
-		isl_die(ctx, isl_error_unknown,
-			"isl_ast_expr printed incorrectly", return -1);
+	str = "{ S[i, j] : 0 <= i, j < 10; T[i] : 0 <= i < 10 }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	schedule = isl_schedule_from_domain(uset);
+	str = "[{ S[i, j] -> [(i)]; T[i] -> [(i)] }]";
+	mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
+	schedule = isl_schedule_insert_partial_schedule(schedule, mupa);
+	umap1 = isl_schedule_get_map(schedule);
 
-	expr1 = isl_ast_expr_from_id(isl_id_alloc(ctx, "A", NULL));
-	expr2 = isl_ast_expr_from_id(isl_id_alloc(ctx, "B", NULL));
-	expr = isl_ast_expr_add(expr1, expr2);
-	expr3 = isl_ast_expr_from_id(isl_id_alloc(ctx, "C", NULL));
-	expr = isl_ast_expr_sub(expr3, expr);
-	str = isl_ast_expr_to_C_str(expr);
-	ok = str ? !strcmp(str, "C - (A + B)") : -1;
-	free(str);
-	isl_ast_expr_free(expr);
+	node = isl_schedule_get_root(schedule);
+	node = isl_schedule_node_child(node, 0);
+	node = isl_schedule_node_child(node, 0);
+	str = "[{ S[i, j] -> [(j)]; T[i] -> [(0)] }]";
+	mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
+	node = isl_schedule_node_insert_partial_schedule(node, mupa);
+	schedule2 = isl_schedule_node_get_schedule(node);
+	isl_schedule_node_free(node);
 
-	if (ok < 0)
+	umap2 = isl_schedule_get_map(schedule);
+	umap3 = isl_schedule_get_map(schedule2);
+	str = "{ S[i, j] -> [i, j]; T[i] -> [i, 0] }";
+	expected = isl_union_map_read_from_str(ctx, str);
+	equal1 = isl_union_map_is_equal(umap1, umap2);
+	equal2 = isl_union_map_is_equal(umap3, expected);
+	umap2 = isl_union_map_intersect_domain(umap2,
+					isl_schedule_get_domain(schedule));
+	umap3 = isl_union_map_intersect_domain(umap3,
+					isl_schedule_get_domain(schedule2));
+	equal3 = isl_union_map_is_equal(umap2, umap3);
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+	isl_union_map_free(umap3);
+	isl_union_map_free(expected);
+	isl_schedule_free(schedule);
+	isl_schedule_free(schedule2);
+
+	if (equal1 < 0 || equal2 < 0 || equal3 < 0)
 		return -1;
-	if (!ok)
+	if (!equal1 || !equal2 || equal3)
 		isl_die(ctx, isl_error_unknown,
-			"isl_ast_expr printed incorrectly", return -1);
+			"unexpected schedule map", return -1);
 
 	return 0;
 }
 
-/* Check that isl_ast_build_expr_from_set returns a valid expression
- * for an empty set.  Note that isl_ast_build_expr_from_set getting
- * called on an empty set probably indicates a bug in the caller.
+/* Check that a zero-dimensional prefix schedule keeps track
+ * of the domain and outer filters.
  */
-static int test_ast_build(isl_ctx *ctx)
+static int test_schedule_tree_prefix(isl_ctx *ctx)
 {
-	isl_set *set;
-	isl_ast_build *build;
-	isl_ast_expr *expr;
+	const char *str;
+	isl_bool equal;
+	isl_union_set *uset;
+	isl_union_set_list *filters;
+	isl_multi_union_pw_aff *mupa, *mupa2;
+	isl_schedule_node *node;
 
-	set = isl_set_universe(isl_space_params_alloc(ctx, 0));
-	build = isl_ast_build_from_context(set);
+	str = "{ S1[i,j] : 0 <= i,j < 10; S2[i,j] : 0 <= i,j < 10 }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	node = isl_schedule_node_from_domain(uset);
+	node = isl_schedule_node_child(node, 0);
 
-	set = isl_set_empty(isl_space_params_alloc(ctx, 0));
-	expr = isl_ast_build_expr_from_set(build, set);
+	str = "{ S1[i,j] : i > j }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	filters = isl_union_set_list_from_union_set(uset);
+	str = "{ S1[i,j] : i <= j; S2[i,j] }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	filters = isl_union_set_list_add(filters, uset);
+	node = isl_schedule_node_insert_sequence(node, filters);
 
-	isl_ast_expr_free(expr);
-	isl_ast_build_free(build);
+	node = isl_schedule_node_grandchild(node, 0, 0);
+	mupa = isl_schedule_node_get_prefix_schedule_multi_union_pw_aff(node);
+	str = "([] : { S1[i,j] : i > j })";
+	mupa2 = isl_multi_union_pw_aff_read_from_str(ctx, str);
+	equal = isl_multi_union_pw_aff_plain_is_equal(mupa, mupa2);
+	isl_multi_union_pw_aff_free(mupa2);
+	isl_multi_union_pw_aff_free(mupa);
+	isl_schedule_node_free(node);
 
-	if (!expr)
+	if (equal < 0)
 		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected prefix schedule",
+			return -1);
 
 	return 0;
 }
 
-/* Internal data structure for before_for and after_for callbacks.
- *
- * depth is the current depth
- * before is the number of times before_for has been called
- * after is the number of times after_for has been called
- */
-struct isl_test_codegen_data {
-	int depth;
-	int before;
-	int after;
-};
-
-/* This function is called before each for loop in the AST generated
- * from test_ast_gen1.
- *
- * Increment the number of calls and the depth.
- * Check that the space returned by isl_ast_build_get_schedule_space
- * matches the target space of the schedule returned by
- * isl_ast_build_get_schedule.
- * Return an isl_id that is checked by the corresponding call
- * to after_for.
+/* Check that the reaching domain elements and the prefix schedule
+ * at a leaf node are the same before and after grouping.
  */
-static __isl_give isl_id *before_for(__isl_keep isl_ast_build *build,
-	void *user)
+static int test_schedule_tree_group_1(isl_ctx *ctx)
 {
-	struct isl_test_codegen_data *data = user;
-	isl_ctx *ctx;
-	isl_space *space;
-	isl_union_map *schedule;
+	int equal;
+	const char *str;
+	isl_id *id;
 	isl_union_set *uset;
-	isl_set *set;
-	isl_bool empty;
-	isl_size n;
-	char name[] = "d0";
-
-	ctx = isl_ast_build_get_ctx(build);
-
-	if (data->before >= 3)
-		isl_die(ctx, isl_error_unknown,
-			"unexpected number of for nodes", return NULL);
-	if (data->depth < 0 || data->depth >= 2)
-		isl_die(ctx, isl_error_unknown,
-			"unexpected depth", return NULL);
-
-	snprintf(name, sizeof(name), "d%d", data->depth);
-	data->before++;
-	data->depth++;
-
-	schedule = isl_ast_build_get_schedule(build);
-	uset = isl_union_map_range(schedule);
-	n = isl_union_set_n_set(uset);
-	if (n != 1) {
-		isl_union_set_free(uset);
-		if (n < 0)
-			return NULL;
-		isl_die(ctx, isl_error_unknown,
-			"expecting single range space", return NULL);
-	}
+	isl_multi_union_pw_aff *mupa;
+	isl_union_pw_multi_aff *upma1, *upma2;
+	isl_union_set *domain1, *domain2;
+	isl_union_map *umap1, *umap2;
+	isl_schedule_node *node;
 
-	space = isl_ast_build_get_schedule_space(build);
-	set = isl_union_set_extract_set(uset, space);
-	isl_union_set_free(uset);
-	empty = isl_set_is_empty(set);
-	isl_set_free(set);
+	str = "{ S1[i,j] : 0 <= i,j < 10; S2[i,j] : 0 <= i,j < 10 }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	node = isl_schedule_node_from_domain(uset);
+	node = isl_schedule_node_child(node, 0);
+	str = "[{ S1[i,j] -> [i]; S2[i,j] -> [9 - i] }]";
+	mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
+	node = isl_schedule_node_insert_partial_schedule(node, mupa);
+	node = isl_schedule_node_child(node, 0);
+	str = "[{ S1[i,j] -> [j]; S2[i,j] -> [j] }]";
+	mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
+	node = isl_schedule_node_insert_partial_schedule(node, mupa);
+	node = isl_schedule_node_child(node, 0);
+	umap1 = isl_schedule_node_get_prefix_schedule_union_map(node);
+	upma1 = isl_schedule_node_get_prefix_schedule_union_pw_multi_aff(node);
+	domain1 = isl_schedule_node_get_domain(node);
+	id = isl_id_alloc(ctx, "group", NULL);
+	node = isl_schedule_node_parent(node);
+	node = isl_schedule_node_group(node, id);
+	node = isl_schedule_node_child(node, 0);
+	umap2 = isl_schedule_node_get_prefix_schedule_union_map(node);
+	upma2 = isl_schedule_node_get_prefix_schedule_union_pw_multi_aff(node);
+	domain2 = isl_schedule_node_get_domain(node);
+	equal = isl_union_pw_multi_aff_plain_is_equal(upma1, upma2);
+	if (equal >= 0 && equal)
+		equal = isl_union_set_is_equal(domain1, domain2);
+	if (equal >= 0 && equal)
+		equal = isl_union_map_is_equal(umap1, umap2);
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+	isl_union_set_free(domain1);
+	isl_union_set_free(domain2);
+	isl_union_pw_multi_aff_free(upma1);
+	isl_union_pw_multi_aff_free(upma2);
+	isl_schedule_node_free(node);
 
-	if (empty < 0)
-		return NULL;
-	if (empty)
+	if (equal < 0)
+		return -1;
+	if (!equal)
 		isl_die(ctx, isl_error_unknown,
-			"spaces don't match", return NULL);
+			"expressions not equal", return -1);
 
-	return isl_id_alloc(ctx, name, NULL);
+	return 0;
 }
 
-/* This function is called after each for loop in the AST generated
- * from test_ast_gen1.
+/* Check that we can have nested groupings and that the union map
+ * schedule representation is the same before and after the grouping.
+ * Note that after the grouping, the union map representation contains
+ * the domain constraints from the ranges of the expansion nodes,
+ * while they are missing from the union map representation of
+ * the tree without expansion nodes.
  *
- * Increment the number of calls and decrement the depth.
- * Check that the annotation attached to the node matches
- * the isl_id returned by the corresponding call to before_for.
+ * Also check that the global expansion is as expected.
  */
-static __isl_give isl_ast_node *after_for(__isl_take isl_ast_node *node,
-	__isl_keep isl_ast_build *build, void *user)
+static int test_schedule_tree_group_2(isl_ctx *ctx)
 {
-	struct isl_test_codegen_data *data = user;
+	int equal, equal_expansion;
+	const char *str;
 	isl_id *id;
-	const char *name;
-	int valid;
+	isl_union_set *uset;
+	isl_union_map *umap1, *umap2;
+	isl_union_map *expansion1, *expansion2;
+	isl_union_set_list *filters;
+	isl_multi_union_pw_aff *mupa;
+	isl_schedule *schedule;
+	isl_schedule_node *node;
 
-	data->after++;
-	data->depth--;
+	str = "{ S1[i,j] : 0 <= i,j < 10; S2[i,j] : 0 <= i,j < 10; "
+		"S3[i,j] : 0 <= i,j < 10 }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	node = isl_schedule_node_from_domain(uset);
+	node = isl_schedule_node_child(node, 0);
+	str = "[{ S1[i,j] -> [i]; S2[i,j] -> [i]; S3[i,j] -> [i] }]";
+	mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
+	node = isl_schedule_node_insert_partial_schedule(node, mupa);
+	node = isl_schedule_node_child(node, 0);
+	str = "{ S1[i,j] }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	filters = isl_union_set_list_from_union_set(uset);
+	str = "{ S2[i,j]; S3[i,j] }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	filters = isl_union_set_list_add(filters, uset);
+	node = isl_schedule_node_insert_sequence(node, filters);
+	node = isl_schedule_node_grandchild(node, 1, 0);
+	str = "{ S2[i,j] }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	filters = isl_union_set_list_from_union_set(uset);
+	str = "{ S3[i,j] }";
+	uset = isl_union_set_read_from_str(ctx, str);
+	filters = isl_union_set_list_add(filters, uset);
+	node = isl_schedule_node_insert_sequence(node, filters);
 
-	if (data->after > data->before)
-		isl_die(isl_ast_node_get_ctx(node), isl_error_unknown,
-			"mismatch in number of for nodes",
-			return isl_ast_node_free(node));
+	schedule = isl_schedule_node_get_schedule(node);
+	umap1 = isl_schedule_get_map(schedule);
+	uset = isl_schedule_get_domain(schedule);
+	umap1 = isl_union_map_intersect_domain(umap1, uset);
+	isl_schedule_free(schedule);
 
-	id = isl_ast_node_get_annotation(node);
-	if (!id)
-		isl_die(isl_ast_node_get_ctx(node), isl_error_unknown,
-			"missing annotation", return isl_ast_node_free(node));
+	node = isl_schedule_node_grandparent(node);
+	id = isl_id_alloc(ctx, "group1", NULL);
+	node = isl_schedule_node_group(node, id);
+	node = isl_schedule_node_grandchild(node, 1, 0);
+	id = isl_id_alloc(ctx, "group2", NULL);
+	node = isl_schedule_node_group(node, id);
+
+	schedule = isl_schedule_node_get_schedule(node);
+	umap2 = isl_schedule_get_map(schedule);
+	isl_schedule_free(schedule);
+
+	node = isl_schedule_node_root(node);
+	node = isl_schedule_node_child(node, 0);
+	expansion1 = isl_schedule_node_get_subtree_expansion(node);
+	isl_schedule_node_free(node);
+
+	str = "{ group1[i] -> S1[i,j] : 0 <= i,j < 10; "
+		"group1[i] -> S2[i,j] : 0 <= i,j < 10; "
+		"group1[i] -> S3[i,j] : 0 <= i,j < 10 }";
+
+	expansion2 = isl_union_map_read_from_str(ctx, str);
 
-	name = isl_id_get_name(id);
-	valid = name && atoi(name + 1) == data->depth;
-	isl_id_free(id);
+	equal = isl_union_map_is_equal(umap1, umap2);
+	equal_expansion = isl_union_map_is_equal(expansion1, expansion2);
 
-	if (!valid)
-		isl_die(isl_ast_node_get_ctx(node), isl_error_unknown,
-			"wrong annotation", return isl_ast_node_free(node));
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+	isl_union_map_free(expansion1);
+	isl_union_map_free(expansion2);
 
-	return node;
+	if (equal < 0 || equal_expansion < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"expressions not equal", return -1);
+	if (!equal_expansion)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected expansion", return -1);
+
+	return 0;
 }
 
-/* Check that the before_each_for and after_each_for callbacks
- * are called for each for loop in the generated code,
- * that they are called in the right order and that the isl_id
- * returned from the before_each_for callback is attached to
- * the isl_ast_node passed to the corresponding after_each_for call.
+/* Some tests for the isl_schedule_node_group function.
  */
-static int test_ast_gen1(isl_ctx *ctx)
+static int test_schedule_tree_group(isl_ctx *ctx)
 {
-	const char *str;
-	isl_set *set;
-	isl_union_map *schedule;
-	isl_ast_build *build;
-	isl_ast_node *tree;
-	struct isl_test_codegen_data data;
+	if (test_schedule_tree_group_1(ctx) < 0)
+		return -1;
+	if (test_schedule_tree_group_2(ctx) < 0)
+		return -1;
+	return 0;
+}
 
-	str = "[N] -> { : N >= 10 }";
-	set = isl_set_read_from_str(ctx, str);
-	str = "[N] -> { A[i,j] -> S[8,i,3,j] : 0 <= i,j <= N; "
-		    "B[i,j] -> S[8,j,9,i] : 0 <= i,j <= N }";
-	schedule = isl_union_map_read_from_str(ctx, str);
+struct {
+	const char *set;
+	const char *dual;
+} coef_tests[] = {
+	{ "{ rat: [i] : 0 <= i <= 10 }",
+	  "{ rat: coefficients[[cst] -> [a]] : cst >= 0 and 10a + cst >= 0 }" },
+	{ "{ rat: [i] : FALSE }",
+	  "{ rat: coefficients[[cst] -> [a]] }" },
+	{ "{ rat: [i] : }",
+	  "{ rat: coefficients[[cst] -> [0]] : cst >= 0 }" },
+	{ "{ [0:,1,2:3] }",
+	  "{ rat: coefficients[[c_cst] -> [a, b, c]] : "
+		"a >= 0 and 2c >= -c_cst - b and 3c >= -c_cst - b }" },
+	{ "[M, N] -> { [x = (1 - N):-1, -4x:(M - 4x)] }",
+	  "{ rat: coefficients[[c_cst, c_M = 0:, c_N = 0:] -> [a, b = -c_M:]] :"
+		"4b >= -c_N + a and 4b >= -c_cst - 2c_N + a }" },
+	{ "{ rat : [x, y] : 1 <= 2x <= 9 and 2 <= 3y <= 16 }",
+	  "{ rat: coefficients[[c_cst] -> [c_x, c_y]] : "
+		"4c_y >= -6c_cst - 3c_x and 4c_y >= -6c_cst - 27c_x and "
+		"32c_y >= -6c_cst - 3c_x and 32c_y >= -6c_cst - 27c_x }" },
+	{ "{ [x, y, z] : 3y <= 2x - 2 and y >= -2 + 2x and 2y >= 2 - x }",
+	  "{ rat: coefficients[[cst] -> [a, b, c]] }" },
+};
 
-	data.before = 0;
-	data.after = 0;
-	data.depth = 0;
-	build = isl_ast_build_from_context(set);
-	build = isl_ast_build_set_before_each_for(build,
-			&before_for, &data);
-	build = isl_ast_build_set_after_each_for(build,
-			&after_for, &data);
-	tree = isl_ast_build_node_from_schedule_map(build, schedule);
-	isl_ast_build_free(build);
-	if (!tree)
-		return -1;
+struct {
+	const char *set;
+	const char *dual;
+} sol_tests[] = {
+	{ "{ rat: coefficients[[cst] -> [a]] : cst >= 0 and 10a + cst >= 0 }",
+	  "{ rat: [i] : 0 <= i <= 10 }" },
+	{ "{ rat: coefficients[[cst] -> [a]] : FALSE }",
+	  "{ rat: [i] }" },
+	{ "{ rat: coefficients[[cst] -> [a]] }",
+	  "{ rat: [i] : FALSE }" },
+};
 
-	isl_ast_node_free(tree);
+/* Rational sets for which the dual is computed
+ * by eliminating a larger number of Farkas multipliers.
+ */
+static const char *dual_round_trip_tests[] = {
+	"[N] -> { rat: [i, j, k, i2, j2, k2] : 0 <= i, j, k, i2, j2, k2 < N and "
+		"i + j <= k2 and i2 + j2 <= k and i - j <= i2 - j2 }",
+	"[N, M] -> { rat: [i, j, k, i2, j2, k2] : 0 <= i, j, k < N and "
+		"0 <= i2, j2, k2 < M and i2 + j2 >= i + j and k2 <= k + j and "
+		"i2 <= N + M - j and j2 <= i + k + k2 }",
+};
 
-	if (data.before != 3 || data.after != 3)
-		isl_die(ctx, isl_error_unknown,
-			"unexpected number of for nodes", return -1);
+/* Check that taking the solutions of the coefficients
+ * of the elements of dual_round_trip_tests produces
+ * the original sets.
+ */
+static isl_stat test_dual_round_trip(isl_ctx *ctx)
+{
+	int i;
 
-	return 0;
+	for (i = 0; i < ARRAY_SIZE(dual_round_trip_tests); ++i) {
+		isl_bool equal;
+		isl_basic_set *bset, *dual;
+
+		bset = isl_basic_set_read_from_str(ctx,
+						dual_round_trip_tests[i]);
+		dual = isl_basic_set_coefficients(isl_basic_set_copy(bset));
+		dual = isl_basic_set_solutions(dual);
+		equal = isl_basic_set_is_equal(bset, dual);
+		isl_basic_set_free(bset);
+		isl_basic_set_free(dual);
+		if (equal < 0)
+			return isl_stat_error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"incorrect dual", return isl_stat_error);
+	}
+
+	return isl_stat_ok;
 }
 
-/* Check that the AST generator handles domains that are integrally disjoint
- * but not rationally disjoint.
+/* Test the basic functionality of isl_basic_set_coefficients and
+ * isl_basic_set_solutions.
  */
-static int test_ast_gen2(isl_ctx *ctx)
+static int test_dual(isl_ctx *ctx)
 {
-	const char *str;
-	isl_set *set;
-	isl_union_map *schedule;
-	isl_union_map *options;
-	isl_ast_build *build;
-	isl_ast_node *tree;
+	int i;
 
-	str = "{ A[i,j] -> [i,j] : 0 <= i,j <= 1 }";
-	schedule = isl_union_map_read_from_str(ctx, str);
-	set = isl_set_universe(isl_space_params_alloc(ctx, 0));
-	build = isl_ast_build_from_context(set);
+	for (i = 0; i < ARRAY_SIZE(coef_tests); ++i) {
+		int equal;
+		isl_basic_set *bset1, *bset2;
 
-	str = "{ [i,j] -> atomic[1] : i + j = 1; [i,j] -> unroll[1] : i = j }";
-	options = isl_union_map_read_from_str(ctx, str);
-	build = isl_ast_build_set_options(build, options);
-	tree = isl_ast_build_node_from_schedule_map(build, schedule);
-	isl_ast_build_free(build);
-	if (!tree)
+		bset1 = isl_basic_set_read_from_str(ctx, coef_tests[i].set);
+		bset2 = isl_basic_set_read_from_str(ctx, coef_tests[i].dual);
+		bset1 = isl_basic_set_coefficients(bset1);
+		equal = isl_basic_set_is_equal(bset1, bset2);
+		isl_basic_set_free(bset1);
+		isl_basic_set_free(bset2);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"incorrect dual", return -1);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(sol_tests); ++i) {
+		int equal;
+		isl_basic_set *bset1, *bset2;
+
+		bset1 = isl_basic_set_read_from_str(ctx, sol_tests[i].set);
+		bset2 = isl_basic_set_read_from_str(ctx, sol_tests[i].dual);
+		bset1 = isl_basic_set_solutions(bset1);
+		equal = isl_basic_set_is_equal(bset1, bset2);
+		isl_basic_set_free(bset1);
+		isl_basic_set_free(bset2);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"incorrect dual", return -1);
+	}
+
+	if (test_dual_round_trip(ctx) < 0)
 		return -1;
-	isl_ast_node_free(tree);
 
 	return 0;
 }
 
-/* Increment *user on each call.
+struct {
+	int scale_tile;
+	int shift_point;
+	const char *domain;
+	const char *schedule;
+	const char *sizes;
+	const char *tile;
+	const char *point;
+} tile_tests[] = {
+	{ 0, 0, "[n] -> { S[i,j] : 0 <= i,j < n }",
+	  "[{ S[i,j] -> [i] }, { S[i,j] -> [j] }]",
+	  "{ [32,32] }",
+	  "[{ S[i,j] -> [floor(i/32)] }, { S[i,j] -> [floor(j/32)] }]",
+	  "[{ S[i,j] -> [i] }, { S[i,j] -> [j] }]",
+	},
+	{ 1, 0, "[n] -> { S[i,j] : 0 <= i,j < n }",
+	  "[{ S[i,j] -> [i] }, { S[i,j] -> [j] }]",
+	  "{ [32,32] }",
+	  "[{ S[i,j] -> [32*floor(i/32)] }, { S[i,j] -> [32*floor(j/32)] }]",
+	  "[{ S[i,j] -> [i] }, { S[i,j] -> [j] }]",
+	},
+	{ 0, 1, "[n] -> { S[i,j] : 0 <= i,j < n }",
+	  "[{ S[i,j] -> [i] }, { S[i,j] -> [j] }]",
+	  "{ [32,32] }",
+	  "[{ S[i,j] -> [floor(i/32)] }, { S[i,j] -> [floor(j/32)] }]",
+	  "[{ S[i,j] -> [i%32] }, { S[i,j] -> [j%32] }]",
+	},
+	{ 1, 1, "[n] -> { S[i,j] : 0 <= i,j < n }",
+	  "[{ S[i,j] -> [i] }, { S[i,j] -> [j] }]",
+	  "{ [32,32] }",
+	  "[{ S[i,j] -> [32*floor(i/32)] }, { S[i,j] -> [32*floor(j/32)] }]",
+	  "[{ S[i,j] -> [i%32] }, { S[i,j] -> [j%32] }]",
+	},
+};
+
+/* Basic tiling tests.  Create a schedule tree with a domain and a band node,
+ * tile the band and then check if the tile and point bands have the
+ * expected partial schedule.
  */
-static __isl_give isl_ast_node *count_domains(__isl_take isl_ast_node *node,
-	__isl_keep isl_ast_build *build, void *user)
+static int test_tile(isl_ctx *ctx)
 {
-	int *n = user;
+	int i;
+	int scale;
+	int shift;
 
-	(*n)++;
+	scale = isl_options_get_tile_scale_tile_loops(ctx);
+	shift = isl_options_get_tile_shift_point_loops(ctx);
 
-	return node;
-}
+	for (i = 0; i < ARRAY_SIZE(tile_tests); ++i) {
+		int opt;
+		int equal;
+		const char *str;
+		isl_union_set *domain;
+		isl_multi_union_pw_aff *mupa, *mupa2;
+		isl_schedule_node *node;
+		isl_multi_val *sizes;
 
-/* Test that unrolling tries to minimize the number of instances.
- * In particular, for the schedule given below, make sure it generates
- * 3 nodes (rather than 101).
- */
-static int test_ast_gen3(isl_ctx *ctx)
-{
-	const char *str;
-	isl_set *set;
-	isl_union_map *schedule;
-	isl_union_map *options;
-	isl_ast_build *build;
-	isl_ast_node *tree;
-	int n_domain = 0;
+		opt = tile_tests[i].scale_tile;
+		isl_options_set_tile_scale_tile_loops(ctx, opt);
+		opt = tile_tests[i].shift_point;
+		isl_options_set_tile_shift_point_loops(ctx, opt);
+
+		str = tile_tests[i].domain;
+		domain = isl_union_set_read_from_str(ctx, str);
+		node = isl_schedule_node_from_domain(domain);
+		node = isl_schedule_node_child(node, 0);
+		str = tile_tests[i].schedule;
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
+		node = isl_schedule_node_insert_partial_schedule(node, mupa);
+		str = tile_tests[i].sizes;
+		sizes = isl_multi_val_read_from_str(ctx, str);
+		node = isl_schedule_node_band_tile(node, sizes);
 
-	str = "[n] -> { A[i] -> [i] : 0 <= i <= 100 and n <= i <= n + 2 }";
-	schedule = isl_union_map_read_from_str(ctx, str);
-	set = isl_set_universe(isl_space_params_alloc(ctx, 0));
+		str = tile_tests[i].tile;
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
+		mupa2 = isl_schedule_node_band_get_partial_schedule(node);
+		equal = isl_multi_union_pw_aff_plain_is_equal(mupa, mupa2);
+		isl_multi_union_pw_aff_free(mupa);
+		isl_multi_union_pw_aff_free(mupa2);
 
-	str = "{ [i] -> unroll[0] }";
-	options = isl_union_map_read_from_str(ctx, str);
+		node = isl_schedule_node_child(node, 0);
 
-	build = isl_ast_build_from_context(set);
-	build = isl_ast_build_set_options(build, options);
-	build = isl_ast_build_set_at_each_domain(build,
-			&count_domains, &n_domain);
-	tree = isl_ast_build_node_from_schedule_map(build, schedule);
-	isl_ast_build_free(build);
-	if (!tree)
-		return -1;
+		str = tile_tests[i].point;
+		mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
+		mupa2 = isl_schedule_node_band_get_partial_schedule(node);
+		if (equal >= 0 && equal)
+			equal = isl_multi_union_pw_aff_plain_is_equal(mupa,
+									mupa2);
+		isl_multi_union_pw_aff_free(mupa);
+		isl_multi_union_pw_aff_free(mupa2);
 
-	isl_ast_node_free(tree);
+		isl_schedule_node_free(node);
 
-	if (n_domain != 3)
-		isl_die(ctx, isl_error_unknown,
-			"unexpected number of for nodes", return -1);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", return -1);
+	}
+
+	isl_options_set_tile_scale_tile_loops(ctx, scale);
+	isl_options_set_tile_shift_point_loops(ctx, shift);
 
 	return 0;
 }
 
-/* Check that if the ast_build_exploit_nested_bounds options is set,
- * we do not get an outer if node in the generated AST,
- * while we do get such an outer if node if the options is not set.
+/* Check that the domain hash of a space is equal to the hash
+ * of the domain of the space, both ignoring parameters.
  */
-static int test_ast_gen4(isl_ctx *ctx)
+static int test_domain_hash(isl_ctx *ctx)
 {
-	const char *str;
-	isl_set *set;
-	isl_union_map *schedule;
-	isl_ast_build *build;
-	isl_ast_node *tree;
-	enum isl_ast_node_type type;
-	int enb;
-
-	enb = isl_options_get_ast_build_exploit_nested_bounds(ctx);
-	str = "[N,M] -> { A[i,j] -> [i,j] : 0 <= i <= N and 0 <= j <= M }";
+	isl_map *map;
+	isl_space *space;
+	uint32_t hash1, hash2;
 
-	isl_options_set_ast_build_exploit_nested_bounds(ctx, 1);
+	map = isl_map_read_from_str(ctx, "[n] -> { A[B[x] -> C[]] -> D[] }");
+	space = isl_map_get_space(map);
+	isl_map_free(map);
+	hash1 = isl_space_get_tuple_domain_hash(space);
+	space = isl_space_domain(space);
+	hash2 = isl_space_get_tuple_hash(space);
+	isl_space_free(space);
 
-	schedule = isl_union_map_read_from_str(ctx, str);
-	set = isl_set_universe(isl_space_params_alloc(ctx, 0));
-	build = isl_ast_build_from_context(set);
-	tree = isl_ast_build_node_from_schedule_map(build, schedule);
-	isl_ast_build_free(build);
-	if (!tree)
+	if (!space)
 		return -1;
-
-	type = isl_ast_node_get_type(tree);
-	isl_ast_node_free(tree);
-
-	if (type == isl_ast_node_if)
+	if (hash1 != hash2)
 		isl_die(ctx, isl_error_unknown,
-			"not expecting if node", return -1);
+			"domain hash not equal to hash of domain", return -1);
 
-	isl_options_set_ast_build_exploit_nested_bounds(ctx, 0);
+	return 0;
+}
 
-	schedule = isl_union_map_read_from_str(ctx, str);
-	set = isl_set_universe(isl_space_params_alloc(ctx, 0));
-	build = isl_ast_build_from_context(set);
-	tree = isl_ast_build_node_from_schedule_map(build, schedule);
-	isl_ast_build_free(build);
-	if (!tree)
-		return -1;
+/* Check that a universe basic set that is not obviously equal to the universe
+ * is still recognized as being equal to the universe.
+ */
+static int test_universe(isl_ctx *ctx)
+{
+	const char *s;
+	isl_basic_set *bset;
+	isl_bool is_univ;
 
-	type = isl_ast_node_get_type(tree);
-	isl_ast_node_free(tree);
+	s = "{ [] : exists x, y : 3y <= 2x and y >= -3 + 2x and 2y >= 2 - x }";
+	bset = isl_basic_set_read_from_str(ctx, s);
+	is_univ = isl_basic_set_is_universe(bset);
+	isl_basic_set_free(bset);
 
-	if (type != isl_ast_node_if)
+	if (is_univ < 0)
+		return -1;
+	if (!is_univ)
 		isl_die(ctx, isl_error_unknown,
-			"expecting if node", return -1);
-
-	isl_options_set_ast_build_exploit_nested_bounds(ctx, enb);
+			"not recognized as universe set", return -1);
 
 	return 0;
 }
 
-/* This function is called for each leaf in the AST generated
- * from test_ast_gen5.
- *
- * We finalize the AST generation by extending the outer schedule
- * with a zero-dimensional schedule.  If this results in any for loops,
- * then this means that we did not pass along enough information
- * about the outer schedule to the inner AST generation.
+/* Sets for which chambers are computed and checked.
  */
-static __isl_give isl_ast_node *create_leaf(__isl_take isl_ast_build *build,
-	void *user)
-{
-	isl_union_map *schedule, *extra;
-	isl_ast_node *tree;
-
-	schedule = isl_ast_build_get_schedule(build);
-	extra = isl_union_map_copy(schedule);
-	extra = isl_union_map_from_domain(isl_union_map_domain(extra));
-	schedule = isl_union_map_range_product(schedule, extra);
-	tree = isl_ast_build_node_from_schedule_map(build, schedule);
-	isl_ast_build_free(build);
+const char *chambers_tests[] = {
+	"[A, B, C] -> { [x, y, z] : x >= 0 and y >= 0 and y <= A - x and "
+				"z >= 0 and z <= C - y and z <= B - x - y }",
+};
 
-	if (!tree)
-		return NULL;
+/* Add the domain of "cell" to "cells".
+ */
+static isl_stat add_cell(__isl_take isl_cell *cell, void *user)
+{
+	isl_basic_set_list **cells = user;
+	isl_basic_set *dom;
 
-	if (isl_ast_node_get_type(tree) == isl_ast_node_for)
-		isl_die(isl_ast_node_get_ctx(tree), isl_error_unknown,
-			"code should not contain any for loop",
-			return isl_ast_node_free(tree));
+	dom = isl_cell_get_domain(cell);
+	isl_cell_free(cell);
+	*cells = isl_basic_set_list_add(*cells, dom);
 
-	return tree;
+	return *cells ? isl_stat_ok : isl_stat_error;
 }
 
-/* Check that we do not lose any information when going back and
- * forth between internal and external schedule.
- *
- * In particular, we create an AST where we unroll the only
- * non-constant dimension in the schedule.  We therefore do
- * not expect any for loops in the AST.  However, older versions
- * of isl would not pass along enough information about the outer
- * schedule when performing an inner code generation from a create_leaf
- * callback, resulting in the inner code generation producing a for loop.
+/* Check that the elements of "list" are pairwise disjoint.
  */
-static int test_ast_gen5(isl_ctx *ctx)
+static isl_stat check_pairwise_disjoint(__isl_keep isl_basic_set_list *list)
 {
-	const char *str;
-	isl_set *set;
-	isl_union_map *schedule, *options;
-	isl_ast_build *build;
-	isl_ast_node *tree;
+	int i, j;
+	isl_size n;
 
-	str = "{ A[] -> [1, 1, 2]; B[i] -> [1, i, 0] : i >= 1 and i <= 2 }";
-	schedule = isl_union_map_read_from_str(ctx, str);
+	n = isl_basic_set_list_n_basic_set(list);
+	if (n < 0)
+		return isl_stat_error;
 
-	str = "{ [a, b, c] -> unroll[1] : exists (e0 = [(a)/4]: "
-				"4e0 >= -1 + a - b and 4e0 <= -2 + a + b) }";
-	options = isl_union_map_read_from_str(ctx, str);
+	for (i = 0; i < n; ++i) {
+		isl_basic_set *bset_i;
 
-	set = isl_set_universe(isl_space_params_alloc(ctx, 0));
-	build = isl_ast_build_from_context(set);
-	build = isl_ast_build_set_options(build, options);
-        build = isl_ast_build_set_create_leaf(build, &create_leaf, NULL);
-	tree = isl_ast_build_node_from_schedule_map(build, schedule);
-	isl_ast_build_free(build);
-	isl_ast_node_free(tree);
-	if (!tree)
-		return -1;
+		bset_i = isl_basic_set_list_get_basic_set(list, i);
+		for (j = i + 1; j < n; ++j) {
+			isl_basic_set *bset_j;
+			isl_bool disjoint;
 
-	return 0;
+			bset_j = isl_basic_set_list_get_basic_set(list, j);
+			disjoint = isl_basic_set_is_disjoint(bset_i, bset_j);
+			isl_basic_set_free(bset_j);
+			if (!disjoint)
+				isl_die(isl_basic_set_list_get_ctx(list),
+					isl_error_unknown, "not disjoint",
+					break);
+			if (disjoint < 0 || !disjoint)
+				break;
+		}
+		isl_basic_set_free(bset_i);
+		if (j < n)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
 }
 
-/* Check that the expression
- *
- *	[n] -> { [n/2] : n <= 0 and n % 2 = 0; [0] : n > 0 }
- *
- * is not combined into
- *
- *	min(n/2, 0)
- *
- * as this would result in n/2 being evaluated in parts of
- * the definition domain where n is not a multiple of 2.
+/* Check that the chambers computed by isl_vertices_foreach_disjoint_cell
+ * are pairwise disjoint.
  */
-static int test_ast_expr(isl_ctx *ctx)
+static int test_chambers(isl_ctx *ctx)
 {
-	const char *str;
-	isl_pw_aff *pa;
-	isl_ast_build *build;
-	isl_ast_expr *expr;
-	int min_max;
-	int is_min;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(chambers_tests); ++i) {
+		isl_basic_set *bset;
+		isl_vertices *vertices;
+		isl_basic_set_list *cells;
+		isl_stat ok;
+
+		bset = isl_basic_set_read_from_str(ctx, chambers_tests[i]);
+		vertices = isl_basic_set_compute_vertices(bset);
+		cells = isl_basic_set_list_alloc(ctx, 0);
+		if (isl_vertices_foreach_disjoint_cell(vertices, &add_cell,
+							&cells) < 0)
+			cells = isl_basic_set_list_free(cells);
+		ok = check_pairwise_disjoint(cells);
+		isl_basic_set_list_free(cells);
+		isl_vertices_free(vertices);
+		isl_basic_set_free(bset);
 
-	min_max = isl_options_get_ast_build_detect_min_max(ctx);
-	isl_options_set_ast_build_detect_min_max(ctx, 1);
+		if (ok < 0)
+			return -1;
+	}
 
-	str = "[n] -> { [n/2] : n <= 0 and n % 2 = 0; [0] : n > 0 }";
-	pa = isl_pw_aff_read_from_str(ctx, str);
-	build = isl_ast_build_alloc(ctx);
-	expr = isl_ast_build_expr_from_pw_aff(build, pa);
-	is_min = isl_ast_expr_get_type(expr) == isl_ast_expr_op &&
-		 isl_ast_expr_get_op_type(expr) == isl_ast_expr_op_min;
-	isl_ast_build_free(build);
-	isl_ast_expr_free(expr);
+	return 0;
+}
 
-	isl_options_set_ast_build_detect_min_max(ctx, min_max);
+/* Check that identical spaces are represented by the same object
+ * when the "intern_spaces" option is set, that spaces that only differ
+ * in the names of the set dimensions are not, and that
+ * operations on sets in interned spaces produce the expected results.
+ */
+static int test_intern_spaces(isl_ctx *ctx)
+{
+	int save;
+	isl_bool same, equal;
+	isl_set *set1, *set2, *set3;
+	isl_space *space1, *space2, *space3;
+
+	save = isl_options_get_intern_spaces(ctx);
+	isl_options_set_intern_spaces(ctx, 1);
+
+	set1 = isl_set_read_from_str(ctx,
+			"[n] -> { A[i, j] : 0 <= i, j < n }");
+	set2 = isl_set_read_from_str(ctx,
+			"[n] -> { A[i, j] : 0 <= i < n and j = i }");
+	set3 = isl_set_read_from_str(ctx,
+			"[n] -> { A[k, l] : 0 <= k < n and l = k }");
+	space1 = isl_set_get_space(set1);
+	space2 = isl_set_get_space(set2);
+	space3 = isl_set_get_space(set3);
+	same = isl_bool_ok(space1 == space2 && space1 != space3);
+	equal = isl_space_is_equal(space1, space3);
+	isl_space_free(space1);
+	isl_space_free(space2);
+	isl_space_free(space3);
+	isl_set_free(set3);
+
+	set1 = isl_set_subtract(set1, isl_set_copy(set2));
+	set1 = isl_set_union(set1, set2);
+	set2 = isl_set_read_from_str(ctx, "[n] -> { A[i, j] : 0 <= i, j < n }");
+	if (same >= 0 && same && equal >= 0 && equal)
+		equal = isl_set_is_equal(set1, set2);
+	isl_set_free(set1);
+	isl_set_free(set2);
 
-	if (!expr)
+	isl_options_set_intern_spaces(ctx, save);
+
+	if (same < 0 || equal < 0)
 		return -1;
-	if (is_min)
+	if (!same)
 		isl_die(ctx, isl_error_unknown,
-			"expressions should not be combined", return -1);
+			"identical spaces not shared", return -1);
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result", return -1);
 
 	return 0;
 }
 
-static int test_ast_gen(isl_ctx *ctx)
+/* Check that copying the identifier with name "name" and
+ * user pointer "user" from "ctx" to "child" results in the same
+ * identifier as creating it in "child" directly.
+ */
+static isl_stat check_id_copy_to_ctx(isl_ctx *ctx, isl_ctx *child,
+	const char *name, void *user)
 {
-	if (test_ast_gen1(ctx) < 0)
-		return -1;
-	if (test_ast_gen2(ctx) < 0)
-		return -1;
-	if (test_ast_gen3(ctx) < 0)
-		return -1;
-	if (test_ast_gen4(ctx) < 0)
-		return -1;
-	if (test_ast_gen5(ctx) < 0)
-		return -1;
-	if (test_ast_expr(ctx) < 0)
-		return -1;
-	return 0;
+	isl_id *id, *copy, *ref;
+	int same;
+
+	id = isl_id_alloc(ctx, name, user);
+	copy = isl_id_copy_to_ctx(id, child);
+	ref = isl_id_alloc(child, name, user);
+	same = copy && copy == ref;
+	isl_id_free(id);
+	isl_id_free(copy);
+	isl_id_free(ref);
+
+	if (!same)
+		isl_die(ctx, isl_error_unknown, "unexpected identifier",
+			return isl_stat_error);
+	return isl_stat_ok;
 }
 
-/* Check if dropping output dimensions from an isl_pw_multi_aff
- * works properly.
+/* Check that values, multi values, multi piecewise affine expressions,
+ * union piecewise multi affine expressions and schedules
+ * can be copied from "ctx" to "child" and that the copies are
+ * equal to the objects obtained by reading them directly in "child".
  */
-static int test_pw_multi_aff(isl_ctx *ctx)
+static isl_stat check_copy_to_ctx(isl_ctx *ctx, isl_ctx *child)
 {
-	const char *str;
-	isl_pw_multi_aff *pma1, *pma2;
-	int equal;
+	const char *str_v = "-7/3";
+	const char *str_mv = "{ A[2, 3/4] }";
+	const char *str_mpa = "[n] -> { A[] : n >= 0 }";
+	const char *str_mpa2 = "[n] -> { A[i] -> [(n), (2i)] : i >= 0 }";
+	const char *str_upma = "[n] -> { A[i] -> B[n - i]; C[] -> D[] }";
+	const char *str_sched = "domain: \"[n] -> { S[i] : 0 <= i < n }\"\n"
+		"child:\n"
+		"  schedule: \"[{ S[i] -> [(i)] }]\"\n";
+	isl_bool equal;
+	isl_val *v, *v_ref;
+	isl_multi_val *mv, *mv_ref;
+	isl_multi_pw_aff *mpa, *mpa_ref;
+	isl_union_pw_multi_aff *upma, *upma_ref;
+	isl_schedule *sched, *sched_ref;
+
+	v = isl_val_read_from_str(ctx, str_v);
+	v_ref = isl_val_copy_to_ctx(v, child);
+	isl_val_free(v);
+	v = isl_val_read_from_str(child, str_v);
+	equal = isl_val_eq(v, v_ref);
+	isl_val_free(v);
+	isl_val_free(v_ref);
 
-	str = "{ [i,j] -> [i+j, 4i-j] }";
-	pma1 = isl_pw_multi_aff_read_from_str(ctx, str);
-	str = "{ [i,j] -> [4i-j] }";
-	pma2 = isl_pw_multi_aff_read_from_str(ctx, str);
+	if (equal == isl_bool_true) {
+		mv = isl_multi_val_read_from_str(ctx, str_mv);
+		mv_ref = isl_multi_val_copy_to_ctx(mv, child);
+		isl_multi_val_free(mv);
+		mv = isl_multi_val_read_from_str(child, str_mv);
+		equal = isl_multi_val_plain_is_equal(mv, mv_ref);
+		isl_multi_val_free(mv);
+		isl_multi_val_free(mv_ref);
+	}
 
-	pma1 = isl_pw_multi_aff_drop_dims(pma1, isl_dim_out, 0, 1);
+	if (equal == isl_bool_true) {
+		mpa = isl_multi_pw_aff_read_from_str(ctx, str_mpa);
+		mpa_ref = isl_multi_pw_aff_copy_to_ctx(mpa, child);
+		isl_multi_pw_aff_free(mpa);
+		mpa = isl_multi_pw_aff_read_from_str(child, str_mpa);
+		equal = isl_multi_pw_aff_is_equal(mpa, mpa_ref);
+		isl_multi_pw_aff_free(mpa);
+		isl_multi_pw_aff_free(mpa_ref);
+	}
 
-	equal = isl_pw_multi_aff_plain_is_equal(pma1, pma2);
+	if (equal == isl_bool_true) {
+		mpa = isl_multi_pw_aff_read_from_str(ctx, str_mpa2);
+		mpa_ref = isl_multi_pw_aff_copy_to_ctx(mpa, child);
+		isl_multi_pw_aff_free(mpa);
+		mpa = isl_multi_pw_aff_read_from_str(child, str_mpa2);
+		equal = isl_multi_pw_aff_is_equal(mpa, mpa_ref);
+		isl_multi_pw_aff_free(mpa);
+		isl_multi_pw_aff_free(mpa_ref);
+	}
+
+	if (equal == isl_bool_true) {
+		upma = isl_union_pw_multi_aff_read_from_str(ctx, str_upma);
+		upma_ref = isl_union_pw_multi_aff_copy_to_ctx(upma, child);
+		isl_union_pw_multi_aff_free(upma);
+		upma = isl_union_pw_multi_aff_read_from_str(child, str_upma);
+		equal = isl_union_pw_multi_aff_plain_is_equal(upma, upma_ref);
+		isl_union_pw_multi_aff_free(upma);
+		isl_union_pw_multi_aff_free(upma_ref);
+	}
+
+	if (equal == isl_bool_true) {
+		sched = isl_schedule_read_from_str(ctx, str_sched);
+		sched_ref = isl_schedule_copy_to_ctx(sched, child);
+		isl_schedule_free(sched);
+		sched = isl_schedule_read_from_str(child, str_sched);
+		equal = isl_schedule_plain_is_equal(sched, sched_ref);
+		isl_schedule_free(sched);
+		isl_schedule_free(sched_ref);
+	}
 
-	isl_pw_multi_aff_free(pma1);
-	isl_pw_multi_aff_free(pma2);
 	if (equal < 0)
-		return -1;
+		return isl_stat_error;
 	if (!equal)
-		isl_die(ctx, isl_error_unknown,
-			"expressions not equal", return -1);
-
-	return 0;
+		isl_die(ctx, isl_error_unknown, "unexpected copy",
+			return isl_stat_error);
+	return isl_stat_ok;
 }
 
-/* Check that we can properly parse multi piecewise affine expressions
- * where the piecewise affine expressions have different domains.
+/* Check that sets and relations can be copied to a child context
+ * and that the copies can be used there.
+ * The identifiers of the copies should be the same as those
+ * that are obtained by reading the objects directly in the child context.
+ * Also check the copying of other types of objects.
  */
-static int test_multi_pw_aff_1(isl_ctx *ctx)
+static int test_ctx_child(isl_ctx *ctx)
 {
-	const char *str;
-	isl_set *dom, *dom2;
-	isl_multi_pw_aff *mpa1, *mpa2;
-	isl_pw_aff *pa;
-	int equal;
-	int equal_domain;
+	const char *str1 = "[n] -> { A[i] -> B[j] : 0 <= i < n and j = 2i }";
+	const char *str2 = "[n] -> { A[i] : 0 <= i < n }";
+	isl_ctx *child;
+	isl_map *map, *map_child, *map_ref;
+	isl_set *set;
+	isl_bool equal;
 
-	mpa1 = isl_multi_pw_aff_read_from_str(ctx, "{ [i] -> [i] }");
-	dom = isl_set_read_from_str(ctx, "{ [i] : i > 0 }");
-	mpa1 = isl_multi_pw_aff_intersect_domain(mpa1, dom);
-	mpa2 = isl_multi_pw_aff_read_from_str(ctx, "{ [i] -> [2i] }");
-	mpa2 = isl_multi_pw_aff_flat_range_product(mpa1, mpa2);
-	str = "{ [i] -> [(i : i > 0), 2i] }";
-	mpa1 = isl_multi_pw_aff_read_from_str(ctx, str);
+	child = isl_ctx_alloc_child(ctx);
+	if (!child)
+		return -1;
+	if (isl_ctx_get_parent(child) != ctx) {
+		isl_ctx_free(child);
+		isl_die(ctx, isl_error_unknown, "unexpected parent",
+			return -1);
+	}
 
-	equal = isl_multi_pw_aff_plain_is_equal(mpa1, mpa2);
+	map = isl_map_read_from_str(ctx, str1);
+	map_child = isl_map_copy_to_ctx(map, child);
+	isl_map_free(map);
+	set = isl_set_read_from_str(ctx, str2);
+	map_child = isl_map_intersect_domain(map_child,
+					    isl_set_copy_to_ctx(set, child));
+	isl_set_free(set);
+	map_ref = isl_map_read_from_str(child, str1);
+	equal = isl_map_is_equal(map_child, map_ref);
+	isl_map_free(map_child);
+	isl_map_free(map_ref);
 
-	pa = isl_multi_pw_aff_get_pw_aff(mpa1, 0);
-	dom = isl_pw_aff_domain(pa);
-	pa = isl_multi_pw_aff_get_pw_aff(mpa1, 1);
-	dom2 = isl_pw_aff_domain(pa);
-	equal_domain = isl_set_is_equal(dom, dom2);
+	if (equal >= 0 &&
+	    (check_id_copy_to_ctx(ctx, child, "S", NULL) < 0 ||
+	     check_id_copy_to_ctx(ctx, child, NULL, &child) < 0 ||
+	     check_id_copy_to_ctx(ctx, child, "S", &child) < 0 ||
+	     check_copy_to_ctx(ctx, child) < 0))
+		equal = isl_bool_error;
 
-	isl_set_free(dom);
-	isl_set_free(dom2);
-	isl_multi_pw_aff_free(mpa1);
-	isl_multi_pw_aff_free(mpa2);
+	isl_ctx_free(child);
 
 	if (equal < 0)
 		return -1;
 	if (!equal)
-		isl_die(ctx, isl_error_unknown,
-			"expressions not equal", return -1);
-
-	if (equal_domain < 0)
-		return -1;
-	if (equal_domain)
-		isl_die(ctx, isl_error_unknown,
-			"domains unexpectedly equal", return -1);
+		isl_die(ctx, isl_error_unknown, "unexpected result",
+			return -1);
 
 	return 0;
 }
 
-/* Check that the dimensions in the explicit domain
- * of a multi piecewise affine expression are properly
- * taken into account.
+/* Check that performing a coalescing, a gist and a lexmin operation
+ * increments the corresponding counters in the statistics and
+ * that isl_ctx_reset_stats resets them.
+ * The timers are only checked not to be negative since
+ * the operations may take less time than the resolution of clock().
  */
-static int test_multi_pw_aff_2(isl_ctx *ctx)
+static int test_stats(isl_ctx *ctx)
 {
-	const char *str;
-	isl_bool involves1, involves2, involves3, equal;
-	isl_multi_pw_aff *mpa, *mpa1, *mpa2;
-
-	str = "{ A[x,y] -> B[] : x >= y }";
-	mpa = isl_multi_pw_aff_read_from_str(ctx, str);
-	involves1 = isl_multi_pw_aff_involves_dims(mpa, isl_dim_in, 0, 2);
-	mpa1 = isl_multi_pw_aff_copy(mpa);
-
-	mpa = isl_multi_pw_aff_insert_dims(mpa, isl_dim_in, 0, 1);
-	involves2 = isl_multi_pw_aff_involves_dims(mpa, isl_dim_in, 0, 1);
-	involves3 = isl_multi_pw_aff_involves_dims(mpa, isl_dim_in, 1, 2);
-	str = "{ [a,x,y] -> B[] : x >= y }";
-	mpa2 = isl_multi_pw_aff_read_from_str(ctx, str);
-	equal = isl_multi_pw_aff_plain_is_equal(mpa, mpa2);
-	isl_multi_pw_aff_free(mpa2);
+	const char *str1 = "{ [x] : 0 <= x <= 10; [x] : 11 <= x <= 20 }";
+	const char *str2 = "[n] -> { [x] : 0 <= x <= n and x <= 5 and "
+				"2x >= n - 7 }";
+	const char *str3 = "[n] -> { [x] : n >= 0 }";
+	int time_stats;
+	isl_set *set, *context;
+	struct isl_stats stats;
+
+	time_stats = isl_options_get_time_stats(ctx);
+	isl_options_set_time_stats(ctx, 1);
+	isl_ctx_reset_stats(ctx);
+
+	set = isl_set_read_from_str(ctx, str1);
+	set = isl_set_coalesce(set);
+	isl_set_free(set);
+	set = isl_set_read_from_str(ctx, str2);
+	context = isl_set_read_from_str(ctx, str3);
+	set = isl_set_gist(set, context);
+	set = isl_set_lexmin(set);
+	isl_set_free(set);
 
-	mpa = isl_multi_pw_aff_drop_dims(mpa, isl_dim_in, 0, 1);
-	mpa = isl_multi_pw_aff_set_tuple_name(mpa, isl_dim_in, "A");
-	if (equal >= 0 && equal)
-		equal = isl_multi_pw_aff_plain_is_equal(mpa, mpa1);
-	isl_multi_pw_aff_free(mpa1);
-	isl_multi_pw_aff_free(mpa);
+	isl_options_set_time_stats(ctx, time_stats);
+	if (isl_ctx_get_stats(ctx, &stats) < 0)
+		return -1;
+	if (stats.coalesce_pair_tests <= 0 || stats.gist_calls <= 0 ||
+	    stats.pip_solves <= 0 || stats.tab_pivots <= 0)
+		isl_die(ctx, isl_error_unknown, "missing counts", return -1);
+	if (stats.coalesce_pair_time < 0 || stats.gist_time < 0 ||
+	    stats.pip_time < 0)
+		isl_die(ctx, isl_error_unknown, "negative time", return -1);
 
-	if (involves1 < 0 || involves2 < 0 || involves3 < 0 || equal < 0)
+	isl_ctx_reset_stats(ctx);
+	if (isl_ctx_get_stats(ctx, &stats) < 0)
 		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown,
-			"incorrect result of dimension insertion/removal",
-			return isl_stat_error);
-	if (!involves1 || involves2 || !involves3)
-		isl_die(ctx, isl_error_unknown,
-			"incorrect characterization of involved dimensions",
-			return isl_stat_error);
+	if (stats.coalesce_pair_tests != 0 || stats.gist_calls != 0 ||
+	    stats.pip_solves != 0 || stats.tab_pivots != 0 ||
+	    stats.pip_time != 0)
+		isl_die(ctx, isl_error_unknown, "statistics not reset",
+			return -1);
 
 	return 0;
 }
 
-/* Check that isl_multi_union_pw_aff_multi_val_on_domain
- * sets the explicit domain of a zero-dimensional result,
- * such that it can be converted to an isl_union_map.
+/* Check that an operation that exceeds the budget of a nested budget scope
+ * fails with an isl_error_quota error, that the computation can continue
+ * after the scope has been left and that the operations performed
+ * in both scopes are recorded.
  */
-static isl_stat test_multi_pw_aff_3(isl_ctx *ctx)
+static int test_budget(isl_ctx *ctx)
 {
-	isl_space *space;
-	isl_union_set *dom;
-	isl_multi_val *mv;
-	isl_multi_union_pw_aff *mupa;
-	isl_union_map *umap;
+	const char *str = "{ [x] : 0 <= x <= 10; [x] : 11 <= x <= 20 }";
+	int on_error;
+	isl_set *set, *coalesced;
+	enum isl_error error;
+	unsigned long inner, outer;
 
-	dom = isl_union_set_read_from_str(ctx, "{ A[]; B[] }");
-	space = isl_union_set_get_space(dom);
-	mv = isl_multi_val_zero(isl_space_set_from_params(space));
-	mupa = isl_multi_union_pw_aff_multi_val_on_domain(dom, mv);
-	umap = isl_union_map_from_multi_union_pw_aff(mupa);
-	isl_union_map_free(umap);
-	if (!umap)
-		return isl_stat_error;
+	isl_ctx_reset_operations(ctx);
+	set = isl_set_read_from_str(ctx, str);
+	on_error = isl_options_get_on_error(ctx);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+	isl_ctx_push_budget(ctx, "outer", 0);
+	isl_ctx_push_budget(ctx, "inner", 5);
+	coalesced = isl_set_coalesce(isl_set_copy(set));
+	error = isl_ctx_last_error(ctx);
+	isl_ctx_reset_error(ctx);
+	isl_ctx_pop_budget(ctx);
+	isl_set_free(coalesced);
+	coalesced = isl_set_coalesce(set);
+	isl_ctx_pop_budget(ctx);
+	isl_options_set_on_error(ctx, on_error);
+	isl_set_free(coalesced);
 
-	return isl_stat_ok;
+	if (!coalesced)
+		return -1;
+	if (error != isl_error_quota)
+		isl_die(ctx, isl_error_unknown, "budget not enforced",
+			return -1);
+	inner = isl_ctx_get_budget_operations(ctx, "inner");
+	outer = isl_ctx_get_budget_operations(ctx, "outer");
+	if (inner != 5 || outer <= inner)
+		isl_die(ctx, isl_error_unknown, "unexpected operation count",
+			return -1);
+	isl_ctx_reset_operations(ctx);
+	if (isl_ctx_get_budget_operations(ctx, "outer") != 0)
+		isl_die(ctx, isl_error_unknown, "operations not reset",
+			return -1);
+
+	return 0;
 }
 
-/* String descriptions of boxes that
- * are used for reconstructing box maps from their lower and upper bounds.
+/* Inputs for test_abort.
  */
-static const char *multi_pw_aff_box_tests[] = {
-	"{ A[x, y] -> [] : x + y >= 0 }",
-	"[N] -> { A[x, y] -> [x] : x + y <= N }",
-	"[N] -> { A[x, y] -> [x : y] : x + y <= N }",
+static const char *abort_tests[] = {
+	"{ [x, y, z] : x = 2y + 1 and z = floor(x/3) and 0 <= y <= 10 }",
+	"{ [x, y] : exists (a : x = 3a and y = x + a and 0 <= y <= 100) }",
+	"{ [x, y] : x >= 0 and y >= 0 and x + y <= 10 and x + y >= 10 }",
+	"{ [x, y] : exists (a, b : x = 3a + 2b and y = 5a - b and "
+		"0 <= a, b <= 10) }",
+	"{ [x, y] : x = 1 and x = 2 }",
 };
 
-/* Check that map representations of boxes can be reconstructed
- * from their lower and upper bounds.
+/* Operations on basic maps that are checked by test_abort.
  */
-static isl_stat test_multi_pw_aff_box(isl_ctx *ctx)
-{
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(multi_pw_aff_box_tests); ++i) {
-		const char *str;
-		isl_bool equal;
-		isl_map *map, *box;
-		isl_multi_pw_aff *min, *max;
+static struct {
+	const char *name;
+	__isl_give isl_basic_map *(*fn)(__isl_take isl_basic_map *bmap);
+} abort_fn_tests[] = {
+	{ "simplify", &isl_basic_map_simplify },
+	{ "remove redundancies", &isl_basic_map_remove_redundancies },
+	{ "implicit equalities", &isl_basic_map_implicit_equalities },
+};
 
-		str = multi_pw_aff_box_tests[i];
-		map = isl_map_read_from_str(ctx, str);
-		min = isl_map_min_multi_pw_aff(isl_map_copy(map));
-		max = isl_map_max_multi_pw_aff(isl_map_copy(map));
-		box = isl_map_universe(isl_map_get_space(map));
-		box = isl_map_lower_bound_multi_pw_aff(box, min);
-		box = isl_map_upper_bound_multi_pw_aff(box, max);
-		equal = isl_map_is_equal(map, box);
-		isl_map_free(map);
-		isl_map_free(box);
-		if (equal < 0)
-			return isl_stat_error;
-		if (!equal)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return isl_stat_error);
-	}
+/* Apply "fn" to the basic map described by "str" while allowing
+ * only "n" more operations to be performed in "ctx".
+ * Return isl_bool_true if "fn" completed without any error.
+ */
+static isl_bool run_with_max_operations(isl_ctx *ctx, const char *str,
+	__isl_give isl_basic_map *(*fn)(__isl_take isl_basic_map *bmap),
+	unsigned long n)
+{
+	isl_basic_map *bmap;
+	enum isl_error error;
+	unsigned long max;
 
-	return isl_stat_ok;
+	bmap = isl_basic_map_read_from_str(ctx, str);
+	if (!bmap)
+		return isl_bool_error;
+	max = isl_ctx_get_max_operations(ctx);
+	isl_ctx_set_max_operations(ctx, isl_ctx_get_operations(ctx) + n);
+	bmap = fn(bmap);
+	isl_ctx_set_max_operations(ctx, max);
+	error = isl_ctx_last_error(ctx);
+	isl_ctx_reset_error(ctx);
+	isl_basic_map_free(bmap);
+
+	return isl_bool_ok(error == isl_error_none);
 }
 
-/* Perform some tests on multi piecewise affine expressions.
+/* Check that the operations in abort_fn_tests can be aborted
+ * at any point on the inputs in abort_tests by reaching the maximal
+ * number of operations, without accessing the basic map
+ * after an intermediate step has failed and freed it.
+ * The number of allowed operations is increased one at a time,
+ * starting from zero, until the operation completes.
  */
-static int test_multi_pw_aff(isl_ctx *ctx)
+static int test_abort(isl_ctx *ctx)
 {
-	if (test_multi_pw_aff_1(ctx) < 0)
-		return -1;
-	if (test_multi_pw_aff_2(ctx) < 0)
-		return -1;
-	if (test_multi_pw_aff_3(ctx) < 0)
-		return -1;
-	if (test_multi_pw_aff_box(ctx) < 0)
+	int i, j;
+	int on_error;
+	isl_bool done = isl_bool_true;
+
+	on_error = isl_options_get_on_error(ctx);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+	for (i = 0; done >= 0 && i < ARRAY_SIZE(abort_fn_tests); ++i) {
+		for (j = 0; done >= 0 && j < ARRAY_SIZE(abort_tests); ++j) {
+			unsigned long n;
+
+			done = isl_bool_false;
+			for (n = 0; done == isl_bool_false; ++n)
+				done = run_with_max_operations(ctx,
+						abort_tests[j],
+						abort_fn_tests[i].fn, n);
+		}
+	}
+	isl_options_set_on_error(ctx, on_error);
+
+	if (done < 0)
 		return -1;
 	return 0;
 }
 
-/* This is a regression test for a bug where isl_basic_map_simplify
- * would end up in an infinite loop.  In particular, we construct
- * an empty basic set that is not obviously empty.
- * isl_basic_set_is_empty marks the basic set as empty.
- * After projecting out i3, the variable can be dropped completely,
- * but isl_basic_map_simplify refrains from doing so if the basic set
- * is empty and would end up in an infinite loop if it didn't test
- * explicitly for empty basic maps in the outer loop.
+/* Check that the bound on the number of allocated bytes is a budget
+ * on the total size of all allocations, including those that
+ * have been freed again, rather than a bound on the memory in use.
+ * In particular, repeatedly allocating and freeing a small vector
+ * should eventually fail, even though at most one such vector
+ * is alive at any given time.
  */
-static int test_simplify_1(isl_ctx *ctx)
+static int test_allocation_budget(isl_ctx *ctx)
 {
-	const char *str;
-	isl_basic_set *bset;
-	int empty;
+	int i;
+	int on_error;
+	isl_vec *vec = NULL;
+	enum isl_error error;
 
-	str = "{ [i0, i1, i2, i3] : i0 >= -2 and 6i2 <= 4 + i0 + 5i1 and "
-		"i2 <= 22 and 75i2 <= 111 + 13i0 + 60i1 and "
-		"25i2 >= 38 + 6i0 + 20i1 and i0 <= -1 and i2 >= 20 and "
-		"i3 >= i2 }";
-	bset = isl_basic_set_read_from_str(ctx, str);
-	empty = isl_basic_set_is_empty(bset);
-	bset = isl_basic_set_project_out(bset, isl_dim_set, 3, 1);
-	isl_basic_set_free(bset);
-	if (!bset)
-		return -1;
-	if (!empty)
+	isl_ctx_reset_memory(ctx);
+	isl_ctx_set_max_allocated_bytes(ctx, 1000);
+	on_error = isl_options_get_on_error(ctx);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+	for (i = 0; i < 1000; ++i) {
+		vec = isl_vec_alloc(ctx, 1);
+		if (!vec)
+			break;
+		isl_vec_free(vec);
+	}
+	error = isl_ctx_last_error(ctx);
+	isl_ctx_reset_error(ctx);
+	isl_options_set_on_error(ctx, on_error);
+	isl_ctx_set_max_allocated_bytes(ctx, 0);
+	isl_ctx_reset_memory(ctx);
+
+	if (vec || error != isl_error_quota)
 		isl_die(ctx, isl_error_unknown,
-			"basic set should be empty", return -1);
+			"freed allocations not counted against budget",
+			return -1);
 
 	return 0;
 }
 
-/* Check that the equality in the set description below
- * is simplified away.
+/* Check that allocations are recorded in the memory statistics and
+ * that a computation is aborted with an isl_error_quota error
+ * when the bound on the amount of memory is reached.
+ * Also check that an allocation without an isl_ctx simply fails.
  */
-static int test_simplify_2(isl_ctx *ctx)
+static int test_memory_stats(isl_ctx *ctx)
 {
-	const char *str;
-	isl_basic_set *bset;
-	isl_bool universe;
+	const char *str = "{ [x] : 0 <= x <= 10; [x] : 11 <= x <= 20 }";
+	int on_error;
+	isl_set *set;
+	enum isl_error error;
+	struct isl_memory_stats stats;
+	isl_mat *mat;
 
-	str = "{ [a] : exists e0, e1: 32e1 = 31 + 31a + 31e0 }";
-	bset = isl_basic_set_read_from_str(ctx, str);
-	universe = isl_basic_set_plain_is_universe(bset);
-	isl_basic_set_free(bset);
+	mat = isl_mat_alloc(NULL, 1, 1);
+	isl_mat_free(mat);
+	if (mat)
+		isl_die(ctx, isl_error_unknown,
+			"allocation without context succeeded", return -1);
 
-	if (universe < 0)
+	isl_ctx_reset_memory(ctx);
+	set = isl_set_read_from_str(ctx, str);
+	set = isl_set_coalesce(set);
+	isl_set_free(set);
+	if (!set)
 		return -1;
-	if (!universe)
-		isl_die(ctx, isl_error_unknown,
-			"equality not simplified away", return -1);
-	return 0;
+	if (isl_ctx_get_memory_stats(ctx, &stats) < 0)
+		return -1;
+	if (stats.n_alloc == 0 || stats.bytes == 0 ||
+	    stats.max_request == 0 || stats.max_request > stats.bytes)
+		isl_die(ctx, isl_error_unknown, "allocations not recorded",
+			return -1);
+
+	isl_ctx_reset_memory(ctx);
+	isl_ctx_set_max_allocated_bytes(ctx, 16);
+	on_error = isl_options_get_on_error(ctx);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+	set = isl_set_read_from_str(ctx, str);
+	error = isl_ctx_last_error(ctx);
+	isl_ctx_reset_error(ctx);
+	isl_options_set_on_error(ctx, on_error);
+	isl_ctx_set_max_allocated_bytes(ctx, 0);
+	isl_set_free(set);
+
+	if (set || error != isl_error_quota)
+		isl_die(ctx, isl_error_unknown, "memory bound not enforced",
+			return -1);
+	if (isl_ctx_get_memory_stats(ctx, &stats) < 0)
+		return -1;
+	if (stats.bytes > 16)
+		isl_die(ctx, isl_error_unknown, "memory bound exceeded",
+			return -1);
+
+	return test_allocation_budget(ctx);
 }
 
-/* Some simplification tests.
+/* Allocation functions for test_allocator that count
+ * the number of calls in the integer pointed to by "user".
  */
-static int test_simplify(isl_ctx *ctx)
+static void *counting_malloc(size_t size, void *user)
 {
-	if (test_simplify_1(ctx) < 0)
-		return -1;
-	if (test_simplify_2(ctx) < 0)
-		return -1;
-	return 0;
+	int *n = user;
+
+	(*n)++;
+	return malloc(size);
 }
 
-/* This is a regression test for a bug where isl_tab_basic_map_partial_lexopt
- * with gbr context would fail to disable the use of the shifted tableau
- * when transferring equalities for the input to the context, resulting
- * in invalid sample values.
- */
-static int test_partial_lexmin(isl_ctx *ctx)
+static void *counting_calloc(size_t nmemb, size_t size, void *user)
 {
-	const char *str;
-	isl_basic_set *bset;
-	isl_basic_map *bmap;
-	isl_map *map;
+	int *n = user;
 
-	str = "{ [1, b, c, 1 - c] -> [e] : 2e <= -c and 2e >= -3 + c }";
-	bmap = isl_basic_map_read_from_str(ctx, str);
-	str = "{ [a, b, c, d] : c <= 1 and 2d >= 6 - 4b - c }";
-	bset = isl_basic_set_read_from_str(ctx, str);
-	map = isl_basic_map_partial_lexmin(bmap, bset, NULL);
-	isl_map_free(map);
+	(*n)++;
+	return calloc(nmemb, size);
+}
 
-	if (!map)
-		return -1;
+static void *counting_realloc(void *ptr, size_t size, void *user)
+{
+	int *n = user;
 
-	return 0;
+	(*n)++;
+	return realloc(ptr, size);
 }
 
-/* Check that the variable compression performed on the existentially
- * quantified variables inside isl_basic_set_compute_divs is not confused
- * by the implicit equalities among the parameters.
+/* Check that the allocation functions set by isl_ctx_set_allocator
+ * are used by "ctx" and by its child contexts and
+ * that they are no longer used after they have been reset.
  */
-static int test_compute_divs(isl_ctx *ctx)
+static int test_allocator(isl_ctx *ctx)
 {
-	const char *str;
-	isl_basic_set *bset;
+	const char *str = "{ [x] : 0 <= x <= 10; [x] : 11 <= x <= 20 }";
+	int n = 0, n_child;
+	isl_ctx *child;
 	isl_set *set;
 
-	str = "[a, b, c, d, e] -> { [] : exists (e0: 2d = b and a <= 124 and "
-		"b <= 2046 and b >= 0 and b <= 60 + 64a and 2e >= b + 2c and "
-		"2e >= b and 2e <= 1 + b and 2e <= 1 + b + 2c and "
-		"32768e0 >= -124 + a and 2097152e0 <= 60 + 64a - b) }";
-	bset = isl_basic_set_read_from_str(ctx, str);
-	set = isl_basic_set_compute_divs(bset);
+	if (isl_ctx_set_allocator(ctx, &counting_malloc, &counting_calloc,
+				&counting_realloc, &n) < 0)
+		return -1;
+	set = isl_set_read_from_str(ctx, str);
+	set = isl_set_coalesce(set);
+	isl_set_free(set);
+
+	child = isl_ctx_alloc_child(ctx);
+	n_child = n;
+	set = isl_set_read_from_str(child, str);
+	set = isl_set_coalesce(set);
+	isl_set_free(set);
+	isl_ctx_free(child);
+	n_child = n - n_child;
+
+	isl_ctx_set_allocator(ctx, NULL, NULL, NULL, NULL);
+	if (n == 0 || n_child == 0)
+		isl_die(ctx, isl_error_unknown, "allocator not used",
+			return -1);
+
+	n = 0;
+	set = isl_set_read_from_str(ctx, str);
 	isl_set_free(set);
 	if (!set)
 		return -1;
+	if (n != 0)
+		isl_die(ctx, isl_error_unknown, "allocator not reset",
+			return -1);
 
 	return 0;
 }
 
-/* Check that isl_schedule_get_map is not confused by a schedule tree
- * with divergent filter node parameters, as can result from a call
- * to isl_schedule_intersect_domain.
+/* Data used by the operation scope hooks in test_scope.
+ * "n_enter" and "n_leave" count the number of times
+ * a scope called "isl_map_gist" is entered and left.
+ * "max_depth" is the maximal scope depth observed on entry.
+ * "error" is set if the hooks observe an inconsistent state.
  */
-static int test_schedule_tree(isl_ctx *ctx)
-{
-	const char *str;
-	isl_union_set *uset;
-	isl_schedule *sched1, *sched2;
-	isl_union_map *umap;
-
-	uset = isl_union_set_read_from_str(ctx, "{ A[i] }");
-	sched1 = isl_schedule_from_domain(uset);
-	uset = isl_union_set_read_from_str(ctx, "{ B[] }");
-	sched2 = isl_schedule_from_domain(uset);
-
-	sched1 = isl_schedule_sequence(sched1, sched2);
-	str = "[n] -> { A[i] : 0 <= i < n; B[] }";
-	uset = isl_union_set_read_from_str(ctx, str);
-	sched1 = isl_schedule_intersect_domain(sched1, uset);
-	umap = isl_schedule_get_map(sched1);
-	isl_schedule_free(sched1);
-	isl_union_map_free(umap);
-	if (!umap)
-		return -1;
+struct isl_test_scope_data {
+	int n_enter;
+	int n_leave;
+	int max_depth;
+	int error;
+};
 
-	return 0;
+/* Record the entry of a scope called "name" in "user",
+ * checking that "name" is reported as the innermost scope.
+ */
+static void scope_enter(isl_ctx *ctx, const char *name, void *user)
+{
+	struct isl_test_scope_data *data = user;
+	int depth;
+	const char *inner;
+
+	depth = isl_ctx_get_scope_depth(ctx);
+	inner = isl_ctx_get_scope_name(ctx, depth - 1);
+	if (!inner || strcmp(inner, name))
+		data->error = 1;
+	if (depth > data->max_depth)
+		data->max_depth = depth;
+	if (!strcmp(name, "isl_map_gist"))
+		data->n_enter++;
 }
 
-/* Check that a zero-dimensional prefix schedule keeps track
- * of the domain and outer filters.
+/* Record the exit of a scope called "name" in "user".
  */
-static int test_schedule_tree_prefix(isl_ctx *ctx)
+static void scope_leave(isl_ctx *ctx, const char *name, void *user)
 {
-	const char *str;
-	isl_bool equal;
-	isl_union_set *uset;
-	isl_union_set_list *filters;
-	isl_multi_union_pw_aff *mupa, *mupa2;
-	isl_schedule_node *node;
-
-	str = "{ S1[i,j] : 0 <= i,j < 10; S2[i,j] : 0 <= i,j < 10 }";
-	uset = isl_union_set_read_from_str(ctx, str);
-	node = isl_schedule_node_from_domain(uset);
-	node = isl_schedule_node_child(node, 0);
+	struct isl_test_scope_data *data = user;
 
-	str = "{ S1[i,j] : i > j }";
-	uset = isl_union_set_read_from_str(ctx, str);
-	filters = isl_union_set_list_from_union_set(uset);
-	str = "{ S1[i,j] : i <= j; S2[i,j] }";
-	uset = isl_union_set_read_from_str(ctx, str);
-	filters = isl_union_set_list_add(filters, uset);
-	node = isl_schedule_node_insert_sequence(node, filters);
+	if (!name)
+		data->error = 1;
+	else if (!strcmp(name, "isl_map_gist"))
+		data->n_leave++;
+}
 
-	node = isl_schedule_node_grandchild(node, 0, 0);
-	mupa = isl_schedule_node_get_prefix_schedule_multi_union_pw_aff(node);
-	str = "([] : { S1[i,j] : i > j })";
-	mupa2 = isl_multi_union_pw_aff_read_from_str(ctx, str);
-	equal = isl_multi_union_pw_aff_plain_is_equal(mupa, mupa2);
-	isl_multi_union_pw_aff_free(mupa2);
-	isl_multi_union_pw_aff_free(mupa);
-	isl_schedule_node_free(node);
+/* Check that the operation scope hooks are called
+ * when a high-level operation is performed and
+ * that the scope stack is consistent with the calls.
+ * isl_set_gist should enter the "isl_map_gist" scope exactly once,
+ * while isl_set_coalesce should not enter it at all.
+ */
+static int test_scope(isl_ctx *ctx)
+{
+	struct isl_test_scope_data data = { 0, 0, 0, 0 };
+	isl_set *set, *context;
+	isl_stat r;
 
-	if (equal < 0)
+	if (isl_ctx_set_scope_hooks(ctx, &scope_enter, &scope_leave,
+					&data) < 0)
 		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown, "unexpected prefix schedule",
+	set = isl_set_read_from_str(ctx,
+		"{ [x] : 0 <= x <= 10; [x] : 20 <= x <= 30 }");
+	context = isl_set_read_from_str(ctx, "{ [x] : x >= 0 }");
+	set = isl_set_gist(set, context);
+	set = isl_set_coalesce(set);
+	isl_set_free(set);
+	r = isl_ctx_set_scope_hooks(ctx, NULL, NULL, NULL);
+	if (!set || r < 0)
+		return -1;
+
+	if (data.error)
+		isl_die(ctx, isl_error_unknown, "inconsistent scope stack",
+			return -1);
+	if (data.n_enter != 1 || data.n_leave != 1)
+		isl_die(ctx, isl_error_unknown, "gist scope not recorded",
+			return -1);
+	if (data.max_depth < 1 || isl_ctx_get_scope_depth(ctx) != 0)
+		isl_die(ctx, isl_error_unknown, "unexpected scope depth",
 			return -1);
 
 	return 0;
 }
 
-/* Check that the reaching domain elements and the prefix schedule
- * at a leaf node are the same before and after grouping.
+/* Pairs of descriptions of the same basic set, with the constraints
+ * in a different order, along with whether this basic set is empty.
  */
-static int test_schedule_tree_group_1(isl_ctx *ctx)
-{
-	int equal;
-	const char *str;
-	isl_id *id;
-	isl_union_set *uset;
-	isl_multi_union_pw_aff *mupa;
-	isl_union_pw_multi_aff *upma1, *upma2;
-	isl_union_set *domain1, *domain2;
-	isl_union_map *umap1, *umap2;
-	isl_schedule_node *node;
+static struct {
+	const char *set1;
+	const char *set2;
+	int empty;
+} sample_cache_tests[] = {
+	{ "{ [x, y] : 0 <= x <= 10 and 0 <= y <= x and 3y >= x + 7 }",
+	  "{ [x, y] : 3y >= x + 7 and y <= x and x <= 10 and 0 <= y and "
+	    "0 <= x }", 0 },
+	{ "{ [x, y] : 0 <= x <= 10 and 3y >= 2x + 1 and 3y <= 2x + 2 and "
+	    "x = 3 * floor(x/3) }",
+	  "{ [x, y] : 3y <= 2x + 2 and 3y >= 2x + 1 and x <= 10 and x >= 0 and "
+	    "x = 3 * floor(x/3) }", 1 },
+};
 
-	str = "{ S1[i,j] : 0 <= i,j < 10; S2[i,j] : 0 <= i,j < 10 }";
-	uset = isl_union_set_read_from_str(ctx, str);
-	node = isl_schedule_node_from_domain(uset);
-	node = isl_schedule_node_child(node, 0);
-	str = "[{ S1[i,j] -> [i]; S2[i,j] -> [9 - i] }]";
-	mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
-	node = isl_schedule_node_insert_partial_schedule(node, mupa);
-	node = isl_schedule_node_child(node, 0);
-	str = "[{ S1[i,j] -> [j]; S2[i,j] -> [j] }]";
-	mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
-	node = isl_schedule_node_insert_partial_schedule(node, mupa);
-	node = isl_schedule_node_child(node, 0);
-	umap1 = isl_schedule_node_get_prefix_schedule_union_map(node);
-	upma1 = isl_schedule_node_get_prefix_schedule_union_pw_multi_aff(node);
-	domain1 = isl_schedule_node_get_domain(node);
-	id = isl_id_alloc(ctx, "group", NULL);
-	node = isl_schedule_node_parent(node);
-	node = isl_schedule_node_group(node, id);
-	node = isl_schedule_node_child(node, 0);
-	umap2 = isl_schedule_node_get_prefix_schedule_union_map(node);
-	upma2 = isl_schedule_node_get_prefix_schedule_union_pw_multi_aff(node);
-	domain2 = isl_schedule_node_get_domain(node);
-	equal = isl_union_pw_multi_aff_plain_is_equal(upma1, upma2);
-	if (equal >= 0 && equal)
-		equal = isl_union_set_is_equal(domain1, domain2);
-	if (equal >= 0 && equal)
-		equal = isl_union_map_is_equal(umap1, umap2);
-	isl_union_map_free(umap1);
-	isl_union_map_free(umap2);
-	isl_union_set_free(domain1);
-	isl_union_set_free(domain2);
-	isl_union_pw_multi_aff_free(upma1);
-	isl_union_pw_multi_aff_free(upma2);
-	isl_schedule_node_free(node);
+/* Check that the emptiness of the second basic set in each pair
+ * of sample_cache_tests is determined from the sample cache
+ * after the emptiness of the first basic set has been determined and
+ * that the result is correct.
+ */
+static int test_sample_cache(isl_ctx *ctx)
+{
+	int i;
+	int size;
+	struct isl_stats stats;
 
-	if (equal < 0)
+	size = isl_options_get_sample_cache_size(ctx);
+	isl_options_set_sample_cache_size(ctx, 16);
+	for (i = 0; i < ARRAY_SIZE(sample_cache_tests); ++i) {
+		isl_basic_set *bset1, *bset2;
+		isl_bool empty1, empty2;
+
+		isl_ctx_reset_stats(ctx);
+		bset1 = isl_basic_set_read_from_str(ctx,
+						sample_cache_tests[i].set1);
+		bset2 = isl_basic_set_read_from_str(ctx,
+						sample_cache_tests[i].set2);
+		empty1 = isl_basic_set_is_empty(bset1);
+		empty2 = isl_basic_set_is_empty(bset2);
+		isl_basic_set_free(bset1);
+		isl_basic_set_free(bset2);
+		if (empty1 < 0 || empty2 < 0 ||
+		    isl_ctx_get_stats(ctx, &stats) < 0)
+			break;
+		if (empty1 != sample_cache_tests[i].empty ||
+		    empty2 != sample_cache_tests[i].empty) {
+			isl_options_set_sample_cache_size(ctx, size);
+			isl_die(ctx, isl_error_unknown, "unexpected result",
+				return -1);
+		}
+		if (stats.sample_cache_hits < 1) {
+			isl_options_set_sample_cache_size(ctx, size);
+			isl_die(ctx, isl_error_unknown, "cache not used",
+				return -1);
+		}
+	}
+	isl_options_set_sample_cache_size(ctx, size);
+	if (i < ARRAY_SIZE(sample_cache_tests))
 		return -1;
-	if (!equal)
-		isl_die(ctx, isl_error_unknown,
-			"expressions not equal", return -1);
 
 	return 0;
 }
 
-/* Check that we can have nested groupings and that the union map
- * schedule representation is the same before and after the grouping.
- * Note that after the grouping, the union map representation contains
- * the domain constraints from the ranges of the expansion nodes,
- * while they are missing from the union map representation of
- * the tree without expansion nodes.
- *
- * Also check that the global expansion is as expected.
+/* Pairs of maps with the same constraints, possibly in a different order,
+ * used in test_lexopt_cache.
  */
-static int test_schedule_tree_group_2(isl_ctx *ctx)
+static const char *lexopt_cache_tests[][2] = {
+	{ "[n] -> { [i] -> [j] : i <= j <= n and j >= 0 }",
+	  "[n] -> { [i] -> [j] : j >= 0 and j <= n and i <= j }" },
+	{ "{ [i] -> [j, k] : 0 <= j <= i and j <= k <= 10 and i + k >= 3 }",
+	  "{ [i] -> [j, k] : i + k >= 3 and k <= 10 and j <= k and "
+	    "0 <= j and j <= i }" },
+};
+
+/* Check that the lexicographic minimum and maximum of the second map
+ * in each pair of lexopt_cache_tests are taken from the lexicographic
+ * optimization cache after those of the first map have been computed and
+ * that the results are the same as those computed without the cache.
+ */
+static int test_lexopt_cache(isl_ctx *ctx)
 {
-	int equal, equal_expansion;
-	const char *str;
-	isl_id *id;
-	isl_union_set *uset;
-	isl_union_map *umap1, *umap2;
-	isl_union_map *expansion1, *expansion2;
-	isl_union_set_list *filters;
-	isl_multi_union_pw_aff *mupa;
-	isl_schedule *schedule;
-	isl_schedule_node *node;
+	int i;
+	int size;
+	struct isl_stats stats;
 
-	str = "{ S1[i,j] : 0 <= i,j < 10; S2[i,j] : 0 <= i,j < 10; "
-		"S3[i,j] : 0 <= i,j < 10 }";
-	uset = isl_union_set_read_from_str(ctx, str);
-	node = isl_schedule_node_from_domain(uset);
-	node = isl_schedule_node_child(node, 0);
-	str = "[{ S1[i,j] -> [i]; S2[i,j] -> [i]; S3[i,j] -> [i] }]";
-	mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
-	node = isl_schedule_node_insert_partial_schedule(node, mupa);
-	node = isl_schedule_node_child(node, 0);
-	str = "{ S1[i,j] }";
-	uset = isl_union_set_read_from_str(ctx, str);
-	filters = isl_union_set_list_from_union_set(uset);
-	str = "{ S2[i,j]; S3[i,j] }";
-	uset = isl_union_set_read_from_str(ctx, str);
-	filters = isl_union_set_list_add(filters, uset);
-	node = isl_schedule_node_insert_sequence(node, filters);
-	node = isl_schedule_node_grandchild(node, 1, 0);
-	str = "{ S2[i,j] }";
-	uset = isl_union_set_read_from_str(ctx, str);
-	filters = isl_union_set_list_from_union_set(uset);
-	str = "{ S3[i,j] }";
-	uset = isl_union_set_read_from_str(ctx, str);
-	filters = isl_union_set_list_add(filters, uset);
-	node = isl_schedule_node_insert_sequence(node, filters);
+	size = isl_options_get_lexopt_cache_size(ctx);
+	for (i = 0; i < ARRAY_SIZE(lexopt_cache_tests); ++i) {
+		isl_map *map1, *map2, *ref, *min1, *min2, *max1, *max2;
+		isl_bool equal;
 
-	schedule = isl_schedule_node_get_schedule(node);
-	umap1 = isl_schedule_get_map(schedule);
-	uset = isl_schedule_get_domain(schedule);
-	umap1 = isl_union_map_intersect_domain(umap1, uset);
-	isl_schedule_free(schedule);
+		isl_options_set_lexopt_cache_size(ctx, 0);
+		map1 = isl_map_read_from_str(ctx, lexopt_cache_tests[i][0]);
+		map2 = isl_map_read_from_str(ctx, lexopt_cache_tests[i][1]);
+		ref = isl_map_lexmin(isl_map_copy(map1));
+		isl_options_set_lexopt_cache_size(ctx, 16);
+		isl_ctx_reset_stats(ctx);
+		min1 = isl_map_lexmin(isl_map_copy(map1));
+		max1 = isl_map_lexmax(map1);
+		min2 = isl_map_lexmin(isl_map_copy(map2));
+		max2 = isl_map_lexmax(map2);
+		equal = isl_map_is_equal(min1, ref);
+		if (equal >= 0 && equal)
+			equal = isl_map_is_equal(min1, min2);
+		if (equal >= 0 && equal)
+			equal = isl_map_is_equal(max1, max2);
+		isl_map_free(ref);
+		isl_map_free(min1);
+		isl_map_free(min2);
+		isl_map_free(max1);
+		isl_map_free(max2);
+		if (equal < 0 || isl_ctx_get_stats(ctx, &stats) < 0)
+			break;
+		if (!equal) {
+			isl_options_set_lexopt_cache_size(ctx, size);
+			isl_die(ctx, isl_error_unknown, "unexpected result",
+				return -1);
+		}
+		if (stats.lexopt_cache_hits < 2) {
+			isl_options_set_lexopt_cache_size(ctx, size);
+			isl_die(ctx, isl_error_unknown, "cache not used",
+				return -1);
+		}
+	}
+	isl_options_set_lexopt_cache_size(ctx, size);
+	if (i < ARRAY_SIZE(lexopt_cache_tests))
+		return -1;
 
-	node = isl_schedule_node_grandparent(node);
-	id = isl_id_alloc(ctx, "group1", NULL);
-	node = isl_schedule_node_group(node, id);
-	node = isl_schedule_node_grandchild(node, 1, 0);
-	id = isl_id_alloc(ctx, "group2", NULL);
-	node = isl_schedule_node_group(node, id);
+	return 0;
+}
 
-	schedule = isl_schedule_node_get_schedule(node);
-	umap2 = isl_schedule_get_map(schedule);
-	isl_schedule_free(schedule);
+/* Construct the union of the piecewise affine expressions
+ * { [i] -> [i mod 2] : i = k } for k ranging from 0 to n - 1
+ * through a chain of calls to isl_pw_aff_union_add.
+ */
+static __isl_give isl_pw_aff *pw_aff_union_chain(isl_ctx *ctx, int n)
+{
+	int k;
+	isl_pw_aff *pa;
 
-	node = isl_schedule_node_root(node);
-	node = isl_schedule_node_child(node, 0);
-	expansion1 = isl_schedule_node_get_subtree_expansion(node);
-	isl_schedule_node_free(node);
+	pa = isl_pw_aff_read_from_str(ctx, "{ [i] -> [(0)] : false }");
+	for (k = 0; k < n; ++k) {
+		char buf[60];
+		isl_pw_aff *pa_k;
 
-	str = "{ group1[i] -> S1[i,j] : 0 <= i,j < 10; "
-		"group1[i] -> S2[i,j] : 0 <= i,j < 10; "
-		"group1[i] -> S3[i,j] : 0 <= i,j < 10 }";
+		snprintf(buf, sizeof(buf), "{ [i] -> [(%d)] : i = %d }",
+			k % 2, k);
+		pa_k = isl_pw_aff_read_from_str(ctx, buf);
+		pa = isl_pw_aff_union_add(pa, pa_k);
+	}
 
-	expansion2 = isl_union_map_read_from_str(ctx, str);
+	return pa;
+}
 
-	equal = isl_union_map_is_equal(umap1, umap2);
-	equal_expansion = isl_union_map_is_equal(expansion1, expansion2);
+/* Check that setting the pw_coalesce_threshold option keeps
+ * the number of pieces in a chain of isl_pw_aff_union_add calls
+ * bounded and does not change the result.
+ */
+static int test_pw_coalesce_threshold(isl_ctx *ctx)
+{
+	int threshold;
+	isl_pw_aff *pa, *ref;
+	isl_size n, n_ref;
+	isl_bool equal;
 
-	isl_union_map_free(umap1);
-	isl_union_map_free(umap2);
-	isl_union_map_free(expansion1);
-	isl_union_map_free(expansion2);
+	threshold = isl_options_get_pw_coalesce_threshold(ctx);
+	isl_options_set_pw_coalesce_threshold(ctx, 0);
+	ref = pw_aff_union_chain(ctx, 20);
+	isl_options_set_pw_coalesce_threshold(ctx, 4);
+	pa = pw_aff_union_chain(ctx, 20);
+	isl_options_set_pw_coalesce_threshold(ctx, threshold);
 
-	if (equal < 0 || equal_expansion < 0)
+	n_ref = isl_pw_aff_n_piece(ref);
+	n = isl_pw_aff_n_piece(pa);
+	equal = isl_pw_aff_is_equal(pa, ref);
+	isl_pw_aff_free(pa);
+	isl_pw_aff_free(ref);
+	if (n_ref < 0 || n < 0 || equal < 0)
 		return -1;
 	if (!equal)
-		isl_die(ctx, isl_error_unknown,
-			"expressions not equal", return -1);
-	if (!equal_expansion)
-		isl_die(ctx, isl_error_unknown,
-			"unexpected expansion", return -1);
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+	if (n_ref != 20 || n > 4)
+		isl_die(ctx, isl_error_unknown, "unexpected number of pieces",
+			return -1);
 
 	return 0;
 }
 
-/* Some tests for the isl_schedule_node_group function.
+/* Check the basic operations on associative arrays,
+ * including isl_id_to_id_reserve and isl_id_to_id_peek.
+ * In particular, check that the entries survive the growth
+ * of the hash table, the removal of other entries and
+ * the modification of a shared copy.
  */
-static int test_schedule_tree_group(isl_ctx *ctx)
+static int test_id_to_id(isl_ctx *ctx)
 {
-	if (test_schedule_tree_group_1(ctx) < 0)
-		return -1;
-	if (test_schedule_tree_group_2(ctx) < 0)
+	int i;
+	int n = 300;
+	isl_id **ids;
+	isl_id_to_id *map, *copy;
+	int ok = 1;
+
+	ids = isl_alloc_array(ctx, isl_id *, n);
+	if (!ids)
+		return -1;
+	for (i = 0; i < n; ++i)
+		ids[i] = isl_id_alloc(ctx, NULL, &ids[i]);
+
+	map = isl_id_to_id_alloc(ctx, 0);
+	for (i = 0; i < n / 2; ++i)
+		map = isl_id_to_id_set(map, isl_id_copy(ids[i]),
+					isl_id_copy(ids[(i + 1) % n]));
+	map = isl_id_to_id_reserve(map, n);
+	for (i = n / 2; i < n; ++i)
+		map = isl_id_to_id_set(map, isl_id_copy(ids[i]),
+					isl_id_copy(ids[(i + 1) % n]));
+	copy = isl_id_to_id_copy(map);
+	for (i = 0; i < n; i += 2)
+		map = isl_id_to_id_drop(map, isl_id_copy(ids[i]));
+	for (i = 0; map && ok && i < n; ++i) {
+		isl_bool has = isl_id_to_id_has(map, ids[i]);
+		isl_id *val = isl_id_to_id_peek(map, ids[i]);
+		isl_id *val_copy = isl_id_to_id_peek(copy, ids[i]);
+
+		if (has < 0)
+			ok = -1;
+		else if (has != (i % 2 == 1) || val_copy != ids[(i + 1) % n])
+			ok = 0;
+		else if (has && val != ids[(i + 1) % n])
+			ok = 0;
+	}
+
+	isl_id_to_id_free(copy);
+	isl_id_to_id_free(map);
+	for (i = 0; i < n; ++i)
+		isl_id_free(ids[i]);
+	free(ids);
+
+	if (!map || ok < 0)
 		return -1;
+	if (!ok)
+		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+
 	return 0;
 }
 
-struct {
-	const char *set;
-	const char *dual;
-} coef_tests[] = {
-	{ "{ rat: [i] : 0 <= i <= 10 }",
-	  "{ rat: coefficients[[cst] -> [a]] : cst >= 0 and 10a + cst >= 0 }" },
-	{ "{ rat: [i] : FALSE }",
-	  "{ rat: coefficients[[cst] -> [a]] }" },
-	{ "{ rat: [i] : }",
-	  "{ rat: coefficients[[cst] -> [0]] : cst >= 0 }" },
-	{ "{ [0:,1,2:3] }",
-	  "{ rat: coefficients[[c_cst] -> [a, b, c]] : "
-		"a >= 0 and 2c >= -c_cst - b and 3c >= -c_cst - b }" },
-	{ "[M, N] -> { [x = (1 - N):-1, -4x:(M - 4x)] }",
-	  "{ rat: coefficients[[c_cst, c_M = 0:, c_N = 0:] -> [a, b = -c_M:]] :"
-		"4b >= -c_N + a and 4b >= -c_cst - 2c_N + a }" },
-	{ "{ rat : [x, y] : 1 <= 2x <= 9 and 2 <= 3y <= 16 }",
-	  "{ rat: coefficients[[c_cst] -> [c_x, c_y]] : "
-		"4c_y >= -6c_cst - 3c_x and 4c_y >= -6c_cst - 27c_x and "
-		"32c_y >= -6c_cst - 3c_x and 32c_y >= -6c_cst - 27c_x }" },
-	{ "{ [x, y, z] : 3y <= 2x - 2 and y >= -2 + 2x and 2y >= 2 - x }",
-	  "{ rat: coefficients[[cst] -> [a, b, c]] }" },
-};
-
-struct {
-	const char *set;
-	const char *dual;
-} sol_tests[] = {
-	{ "{ rat: coefficients[[cst] -> [a]] : cst >= 0 and 10a + cst >= 0 }",
-	  "{ rat: [i] : 0 <= i <= 10 }" },
-	{ "{ rat: coefficients[[cst] -> [a]] : FALSE }",
-	  "{ rat: [i] }" },
-	{ "{ rat: coefficients[[cst] -> [a]] }",
-	  "{ rat: [i] : FALSE }" },
+/* Objective functions used in test_lp_solver,
+ * as the constant term followed by the coefficients of x and y.
+ */
+static int lp_solver_objectives[][3] = {
+	{ 0, 1, 0 }, { 0, 0, 1 }, { 3, 1, 1 }, { -2, 1, -1 }, { 0, 2, -3 },
+	{ 0, 1, 0 },
 };
 
-/* Test the basic functionality of isl_basic_set_coefficients and
- * isl_basic_set_solutions.
+/* Check that solving a sequence of LPs with an isl_lp_solver
+ * produces the same results as solving each of them from scratch.
  */
-static int test_dual(isl_ctx *ctx)
+static int test_lp_solver(isl_ctx *ctx)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(coef_tests); ++i) {
-		int equal;
-		isl_basic_set *bset1, *bset2;
+	const char *str = "{ [x, y] : 0 <= x <= 10 and 0 <= y <= 2x; "
+				"[x, y] : -5 <= x <= 0 and -x <= y <= 3 - x }";
+	int i, j, max;
+	isl_set *set;
+	isl_lp_solver *lp;
+	isl_vec *f;
+	isl_int opt1, den1, opt2, den2;
+	int ok = 1;
 
-		bset1 = isl_basic_set_read_from_str(ctx, coef_tests[i].set);
-		bset2 = isl_basic_set_read_from_str(ctx, coef_tests[i].dual);
-		bset1 = isl_basic_set_coefficients(bset1);
-		equal = isl_basic_set_is_equal(bset1, bset2);
-		isl_basic_set_free(bset1);
-		isl_basic_set_free(bset2);
-		if (equal < 0)
-			return -1;
-		if (!equal)
-			isl_die(ctx, isl_error_unknown,
-				"incorrect dual", return -1);
+	set = isl_set_read_from_str(ctx, str);
+	lp = isl_set_lp_solver_alloc(set);
+	f = isl_vec_alloc(ctx, 3);
+	if (!lp || !f)
+		ok = 0;
+	isl_int_init(opt1);
+	isl_int_init(den1);
+	isl_int_init(opt2);
+	isl_int_init(den2);
+	for (i = 0; ok && i < ARRAY_SIZE(lp_solver_objectives); ++i) {
+		for (j = 0; j < 3; ++j)
+			isl_int_set_si(f->el[j], lp_solver_objectives[i][j]);
+		for (max = 0; ok && max <= 1; ++max) {
+			enum isl_lp_result res1, res2;
+
+			res1 = isl_lp_solver_solve(lp, max, f->el, ctx->one,
+						    &opt1, &den1, NULL);
+			res2 = isl_set_solve_lp(set, max, f->el, ctx->one,
+						    &opt2, &den2, NULL);
+			if (res1 != isl_lp_ok || res2 != isl_lp_ok)
+				ok = 0;
+			else if (isl_int_ne(opt1, opt2) ||
+				 isl_int_ne(den1, den2))
+				ok = 0;
+		}
 	}
+	isl_int_clear(opt1);
+	isl_int_clear(den1);
+	isl_int_clear(opt2);
+	isl_int_clear(den2);
+	isl_vec_free(f);
+	isl_lp_solver_free(lp);
+	isl_set_free(set);
 
-	for (i = 0; i < ARRAY_SIZE(sol_tests); ++i) {
-		int equal;
-		isl_basic_set *bset1, *bset2;
-
-		bset1 = isl_basic_set_read_from_str(ctx, sol_tests[i].set);
-		bset2 = isl_basic_set_read_from_str(ctx, sol_tests[i].dual);
-		bset1 = isl_basic_set_solutions(bset1);
-		equal = isl_basic_set_is_equal(bset1, bset2);
-		isl_basic_set_free(bset1);
-		isl_basic_set_free(bset2);
-		if (equal < 0)
-			return -1;
-		if (!equal)
-			isl_die(ctx, isl_error_unknown,
-				"incorrect dual", return -1);
-	}
+	if (!ok)
+		isl_die(ctx, isl_error_unknown, "unexpected LP result",
+			return -1);
 
 	return 0;
 }
 
-struct {
-	int scale_tile;
-	int shift_point;
-	const char *domain;
-	const char *schedule;
-	const char *sizes;
-	const char *tile;
-	const char *point;
-} tile_tests[] = {
-	{ 0, 0, "[n] -> { S[i,j] : 0 <= i,j < n }",
-	  "[{ S[i,j] -> [i] }, { S[i,j] -> [j] }]",
-	  "{ [32,32] }",
-	  "[{ S[i,j] -> [floor(i/32)] }, { S[i,j] -> [floor(j/32)] }]",
-	  "[{ S[i,j] -> [i] }, { S[i,j] -> [j] }]",
-	},
-	{ 1, 0, "[n] -> { S[i,j] : 0 <= i,j < n }",
-	  "[{ S[i,j] -> [i] }, { S[i,j] -> [j] }]",
-	  "{ [32,32] }",
-	  "[{ S[i,j] -> [32*floor(i/32)] }, { S[i,j] -> [32*floor(j/32)] }]",
-	  "[{ S[i,j] -> [i] }, { S[i,j] -> [j] }]",
-	},
-	{ 0, 1, "[n] -> { S[i,j] : 0 <= i,j < n }",
-	  "[{ S[i,j] -> [i] }, { S[i,j] -> [j] }]",
-	  "{ [32,32] }",
-	  "[{ S[i,j] -> [floor(i/32)] }, { S[i,j] -> [floor(j/32)] }]",
-	  "[{ S[i,j] -> [i%32] }, { S[i,j] -> [j%32] }]",
-	},
-	{ 1, 1, "[n] -> { S[i,j] : 0 <= i,j < n }",
-	  "[{ S[i,j] -> [i] }, { S[i,j] -> [j] }]",
-	  "{ [32,32] }",
-	  "[{ S[i,j] -> [32*floor(i/32)] }, { S[i,j] -> [32*floor(j/32)] }]",
-	  "[{ S[i,j] -> [i%32] }, { S[i,j] -> [j%32] }]",
-	},
-};
+/* Check that the lexicographic minimum of "tl" is "expected",
+ * which is given as the denominator followed by the coordinates.
+ */
+static isl_bool tab_lexmin_is(__isl_keep isl_tab_lexmin *tl,
+	int *expected, int n)
+{
+	int i;
+	isl_vec *sol;
+	isl_bool ok;
 
-/* Basic tiling tests.  Create a schedule tree with a domain and a band node,
- * tile the band and then check if the tile and point bands have the
- * expected partial schedule.
+	sol = isl_tab_lexmin_get_solution(tl);
+	if (!sol)
+		return isl_bool_error;
+	ok = isl_bool_ok(sol->size == n);
+	for (i = 0; ok && i < n; ++i)
+		if (isl_int_cmp_si(sol->el[i], expected[i]) != 0)
+			ok = isl_bool_false;
+	isl_vec_free(sol);
+
+	return ok;
+}
+
+/* Check that isl_tab_lexmin_pop removes the constraints
+ * that were added since the matching isl_tab_lexmin_push,
+ * restoring the earlier lexicographic minimum, including
+ * after the problem became empty.
  */
-static int test_tile(isl_ctx *ctx)
+static int test_tab_lexmin_push(isl_ctx *ctx)
 {
+	const char *str = "{ [x, y, z] : x + y >= 1 and y + z >= 1 }";
+	int min[] = { 1, 0, 1, 0 };
+	int min_x1[] = { 1, 1, 0, 1 };
+	int min_y0[] = { 1, 1, 0, 1 };
+	isl_int eq[4];
+	isl_basic_set *bset;
+	isl_tab_lexmin *tl;
+	isl_bool ok;
 	int i;
-	int scale;
-	int shift;
 
-	scale = isl_options_get_tile_scale_tile_loops(ctx);
-	shift = isl_options_get_tile_shift_point_loops(ctx);
+	for (i = 0; i < 4; ++i)
+		isl_int_init(eq[i]);
+	bset = isl_basic_set_read_from_str(ctx, str);
+	tl = isl_tab_lexmin_from_basic_set(bset);
+	ok = tab_lexmin_is(tl, min, 4);
+
+	tl = isl_tab_lexmin_push(tl);
+	isl_int_set_si(eq[0], -1);
+	isl_int_set_si(eq[1], 1);
+	tl = isl_tab_lexmin_add_eq(tl, eq);
+	if (ok == isl_bool_true)
+		ok = tab_lexmin_is(tl, min_x1, 4);
+	tl = isl_tab_lexmin_push(tl);
+	tl = isl_tab_lexmin_cut_to_integer(tl);
+	if (ok == isl_bool_true)
+		ok = tab_lexmin_is(tl, min_x1, 4);
+	isl_int_set_si(eq[0], 1);
+	isl_int_set_si(eq[1], 1);
+	tl = isl_tab_lexmin_add_eq(tl, eq);
+	if (ok == isl_bool_true)
+		ok = tab_lexmin_is(tl, NULL, 0);
+	tl = isl_tab_lexmin_pop(tl);
+	tl = isl_tab_lexmin_pop(tl);
+	if (ok == isl_bool_true)
+		ok = tab_lexmin_is(tl, min, 4);
+
+	tl = isl_tab_lexmin_push(tl);
+	isl_int_set_si(eq[0], 0);
+	isl_int_set_si(eq[1], 0);
+	isl_int_set_si(eq[2], 1);
+	tl = isl_tab_lexmin_add_eq(tl, eq);
+	if (ok == isl_bool_true)
+		ok = tab_lexmin_is(tl, min_y0, 4);
+	tl = isl_tab_lexmin_pop(tl);
+	if (ok == isl_bool_true)
+		ok = tab_lexmin_is(tl, min, 4);
+
+	isl_tab_lexmin_free(tl);
+	for (i = 0; i < 4; ++i)
+		isl_int_clear(eq[i]);
+
+	if (!tl || ok < 0)
+		return -1;
+	if (!ok)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected lexicographic minimum", return -1);
 
-	for (i = 0; i < ARRAY_SIZE(tile_tests); ++i) {
-		int opt;
-		int equal;
-		const char *str;
-		isl_union_set *domain;
-		isl_multi_union_pw_aff *mupa, *mupa2;
-		isl_schedule_node *node;
-		isl_multi_val *sizes;
+	return 0;
+}
 
-		opt = tile_tests[i].scale_tile;
-		isl_options_set_tile_scale_tile_loops(ctx, opt);
-		opt = tile_tests[i].shift_point;
-		isl_options_set_tile_shift_point_loops(ctx, opt);
+/* Inputs to lexicographic optimization that require
+ * several splits of the context.
+ */
+static const char *pip_threads_tests[] = {
+	"[N, M, K] -> { [i] -> [j] : j >= i and 2j >= N and 3j >= M - i and "
+		"j >= K + i and j <= 100 }",
+	"[N, M] -> { [i, j] -> [a, b] : a >= i and a >= N - j and "
+		"b >= a + M and 2b >= i + j and a + b <= 50 }",
+	"[n, m] -> { [x] -> [y, z] : 0 <= y <= n and 0 <= z <= m and "
+		"3y + 2z >= x and y + z >= n - m and 2z >= x - y }",
+};
 
-		str = tile_tests[i].domain;
-		domain = isl_union_set_read_from_str(ctx, str);
-		node = isl_schedule_node_from_domain(domain);
-		node = isl_schedule_node_child(node, 0);
-		str = tile_tests[i].schedule;
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
-		node = isl_schedule_node_insert_partial_schedule(node, mupa);
-		str = tile_tests[i].sizes;
-		sizes = isl_multi_val_read_from_str(ctx, str);
-		node = isl_schedule_node_band_tile(node, sizes);
+/* Check that lexicographic optimization using several threads
+ * produces the same result as using a single thread,
+ * both when computing an isl_map (and the part of the domain
+ * where there is no solution) and when computing an isl_pw_multi_aff.
+ */
+static int test_pip_threads(isl_ctx *ctx)
+{
+	int i, threads;
+	isl_stat r = isl_stat_ok;
+
+	threads = isl_options_get_pip_threads(ctx);
+	for (i = 0; r >= 0 && i < ARRAY_SIZE(pip_threads_tests); ++i) {
+		const char *str = pip_threads_tests[i];
+		isl_basic_map *bmap;
+		isl_basic_set *dom;
+		isl_map *map1, *map2;
+		isl_set *empty1, *empty2;
+		isl_pw_multi_aff *pma1, *pma2;
+		isl_bool equal, equal_empty, equal_pma;
+
+		bmap = isl_basic_map_read_from_str(ctx, str);
+		dom = isl_basic_set_universe(
+			isl_space_domain(isl_basic_map_get_space(bmap)));
+
+		isl_options_set_pip_threads(ctx, 0);
+		map1 = isl_basic_map_partial_lexmin(isl_basic_map_copy(bmap),
+				isl_basic_set_copy(dom), &empty1);
+		pma1 = isl_basic_map_lexmin_pw_multi_aff(
+				isl_basic_map_copy(bmap));
+		isl_options_set_pip_threads(ctx, 4);
+		map2 = isl_basic_map_partial_lexmin(isl_basic_map_copy(bmap),
+				dom, &empty2);
+		pma2 = isl_basic_map_lexmin_pw_multi_aff(bmap);
 
-		str = tile_tests[i].tile;
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
-		mupa2 = isl_schedule_node_band_get_partial_schedule(node);
-		equal = isl_multi_union_pw_aff_plain_is_equal(mupa, mupa2);
-		isl_multi_union_pw_aff_free(mupa);
-		isl_multi_union_pw_aff_free(mupa2);
+		equal = isl_map_is_equal(map1, map2);
+		equal_empty = isl_set_is_equal(empty1, empty2);
+		equal_pma = isl_pw_multi_aff_is_equal(pma1, pma2);
+		if (equal < 0 || equal_empty < 0 || equal_pma < 0)
+			r = isl_stat_error;
+		else if (!equal || !equal_empty || !equal_pma)
+			isl_die(ctx, isl_error_unknown,
+				"threads produce different result",
+				r = isl_stat_error);
 
-		node = isl_schedule_node_child(node, 0);
+		isl_map_free(map1);
+		isl_map_free(map2);
+		isl_set_free(empty1);
+		isl_set_free(empty2);
+		isl_pw_multi_aff_free(pma1);
+		isl_pw_multi_aff_free(pma2);
+	}
+	isl_options_set_pip_threads(ctx, threads);
 
-		str = tile_tests[i].point;
-		mupa = isl_multi_union_pw_aff_read_from_str(ctx, str);
-		mupa2 = isl_schedule_node_band_get_partial_schedule(node);
-		if (equal >= 0 && equal)
-			equal = isl_multi_union_pw_aff_plain_is_equal(mupa,
-									mupa2);
-		isl_multi_union_pw_aff_free(mupa);
-		isl_multi_union_pw_aff_free(mupa2);
+	return r < 0 ? -1 : 0;
+}
 
-		isl_schedule_node_free(node);
+/* Elements of the rows used in test_seq.
+ * They include values close to the largest values that can be stored
+ * in a machine integer.
+ */
+static const char *seq_values[] = {
+	"0", "1", "-3", "6", "-12",
+	"2305843009213693951", "-2305843009213693952",
+	"4611686018427387903", "-4611686018427387903",
+	"4611686018427387904", "1537228672809129301",
+};
 
-		if (equal < 0)
-			return -1;
-		if (!equal)
-			isl_die(ctx, isl_error_unknown,
-				"unexpected result", return -1);
+/* A row where the terms of the inner product with a row of ones
+ * cancel out in floating point arithmetic.
+ */
+static const char *seq_cancel[] = {
+	"4611686018427387904", "1", "-4611686018427387904", "-1", "1",
+};
+
+/* Multipliers used in test_seq.
+ */
+static const char *seq_multipliers[] = { "0", "1", "-1", "2", "-3" };
+
+/* Check that isl_seq_combine applied to "src1" and "src2"
+ * with multipliers "m1" and "m2", both out of place and in place,
+ * as well as isl_seq_combine_sparse,
+ * produces the same result as the element-wise isl_int operations.
+ */
+static isl_stat check_seq_combine(isl_ctx *ctx, isl_int m1, isl_int *src1,
+	isl_int m2, isl_int *src2, unsigned len)
+{
+	int i, equal, n_nz;
+	int *nz;
+	isl_int *expected, *dst;
+
+	expected = isl_alloc_array(ctx, isl_int, len);
+	dst = isl_alloc_array(ctx, isl_int, len);
+	nz = isl_alloc_array(ctx, int, len);
+	if (!expected || !dst || !nz)
+		goto error;
+	for (i = 0; i < len; ++i) {
+		isl_int_init(expected[i]);
+		isl_int_init(dst[i]);
+		isl_int_mul(expected[i], m1, src1[i]);
+		isl_int_addmul(expected[i], m2, src2[i]);
 	}
 
-	isl_options_set_tile_scale_tile_loops(ctx, scale);
-	isl_options_set_tile_shift_point_loops(ctx, shift);
+	isl_seq_combine(dst, m1, src1, m2, src2, len);
+	equal = isl_seq_eq(dst, expected, len);
+	if (equal) {
+		isl_seq_cpy(dst, src1, len);
+		isl_seq_combine(dst, m1, dst, m2, src2, len);
+		equal = isl_seq_eq(dst, expected, len);
+	}
+	if (equal) {
+		isl_seq_cpy(dst, src1, len);
+		n_nz = isl_seq_non_zero_pos(src2, len, nz);
+		isl_seq_combine_sparse(dst, m1, m2, src2, nz, n_nz, len);
+		equal = isl_seq_eq(dst, expected, len);
+	}
 
-	return 0;
+	for (i = 0; i < len; ++i) {
+		isl_int_clear(expected[i]);
+		isl_int_clear(dst[i]);
+	}
+	free(expected);
+	free(dst);
+	free(nz);
+
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result of isl_seq_combine",
+			return isl_stat_error);
+	return isl_stat_ok;
+error:
+	free(expected);
+	free(dst);
+	free(nz);
+	return isl_stat_error;
 }
 
-/* Check that the domain hash of a space is equal to the hash
- * of the domain of the space, both ignoring parameters.
+/* Check that isl_seq_inner_product, isl_seq_inner_product_sgn and
+ * isl_seq_gcd applied to "p1" (and "p2") produce the same results
+ * as the element-wise isl_int operations.
  */
-static int test_domain_hash(isl_ctx *ctx)
+static isl_stat check_seq_inner_product_gcd(isl_ctx *ctx,
+	isl_int *p1, isl_int *p2, unsigned len)
 {
-	isl_map *map;
-	isl_space *space;
-	uint32_t hash1, hash2;
+	int i, equal;
+	isl_int expected, result;
 
-	map = isl_map_read_from_str(ctx, "[n] -> { A[B[x] -> C[]] -> D[] }");
-	space = isl_map_get_space(map);
-	isl_map_free(map);
-	hash1 = isl_space_get_tuple_domain_hash(space);
-	space = isl_space_domain(space);
-	hash2 = isl_space_get_tuple_hash(space);
-	isl_space_free(space);
+	isl_int_init(expected);
+	isl_int_init(result);
 
-	if (!space)
-		return -1;
-	if (hash1 != hash2)
-		isl_die(ctx, isl_error_unknown,
-			"domain hash not equal to hash of domain", return -1);
+	isl_int_set_si(expected, 0);
+	for (i = 0; i < len; ++i)
+		isl_int_addmul(expected, p1[i], p2[i]);
+	isl_seq_inner_product(p1, p2, len, &result);
+	equal = isl_int_eq(expected, result);
+	equal = equal && isl_seq_inner_product_sgn(p1, p2, len, &result) ==
+				isl_int_sgn(expected);
 
-	return 0;
+	isl_int_set_si(expected, 0);
+	for (i = 0; i < len; ++i)
+		isl_int_gcd(expected, expected, p1[i]);
+	isl_seq_gcd(p1, len, &result);
+	equal = equal && isl_int_eq(expected, result);
+
+	isl_int_clear(expected);
+	isl_int_clear(result);
+
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result of isl_seq operation",
+			return isl_stat_error);
+	return isl_stat_ok;
 }
 
-/* Check that a universe basic set that is not obviously equal to the universe
- * is still recognized as being equal to the universe.
+/* Check that the isl_seq operations on rows of integers produce
+ * the same results as the element-wise isl_int operations,
+ * both on rows where all results fit in a machine integer
+ * (prefixes of the rows containing only small values) and
+ * on rows where they do not.
  */
-static int test_universe(isl_ctx *ctx)
+static int test_seq(isl_ctx *ctx)
 {
-	const char *s;
-	isl_basic_set *bset;
-	isl_bool is_univ;
+	int i, j, k, len;
+	int n = ARRAY_SIZE(seq_values);
+	int n_m = ARRAY_SIZE(seq_multipliers);
+	isl_int p1[ARRAY_SIZE(seq_values)];
+	isl_int p2[ARRAY_SIZE(seq_values)];
+	isl_int m1, m2;
+	isl_stat r = isl_stat_ok;
+
+	isl_int_init(m1);
+	isl_int_init(m2);
+	for (i = 0; i < n; ++i) {
+		isl_int_init(p1[i]);
+		isl_int_init(p2[i]);
+		isl_int_read(p1[i], seq_values[i]);
+		isl_int_read(p2[i], seq_values[n - 1 - i]);
+	}
 
-	s = "{ [] : exists x, y : 3y <= 2x and y >= -3 + 2x and 2y >= 2 - x }";
-	bset = isl_basic_set_read_from_str(ctx, s);
-	is_univ = isl_basic_set_is_universe(bset);
-	isl_basic_set_free(bset);
+	for (len = 1; r >= 0 && len <= n; ++len) {
+		r = check_seq_inner_product_gcd(ctx, p1, p2, len);
+		for (i = 0; r >= 0 && i < n_m; ++i) {
+			isl_int_read(m1, seq_multipliers[i]);
+			for (j = 0; r >= 0 && j < n_m; ++j) {
+				isl_int_read(m2, seq_multipliers[j]);
+				r = check_seq_combine(ctx, m1, p1, m2, p2, len);
+			}
+		}
+	}
+	for (k = 1; r >= 0 && k < n; ++k)
+		r = check_seq_inner_product_gcd(ctx, p1 + k, p1 + k, n - k);
+	for (i = 0; i < ARRAY_SIZE(seq_cancel); ++i) {
+		isl_int_read(p1[i], seq_cancel[i]);
+		isl_int_set_si(p2[i], 1);
+	}
+	for (len = 1; r >= 0 && len <= ARRAY_SIZE(seq_cancel); ++len)
+		r = check_seq_inner_product_gcd(ctx, p1, p2, len);
 
-	if (is_univ < 0)
-		return -1;
-	if (!is_univ)
-		isl_die(ctx, isl_error_unknown,
-			"not recognized as universe set", return -1);
+	for (i = 0; i < n; ++i) {
+		isl_int_clear(p1[i]);
+		isl_int_clear(p2[i]);
+	}
+	isl_int_clear(m1);
+	isl_int_clear(m2);
 
-	return 0;
+	return r < 0 ? -1 : 0;
 }
 
-/* Sets for which chambers are computed and checked.
+/* Check that objects that are created inside (nested) arena scopes
+ * can still be used after the scopes have been left.
  */
-const char *chambers_tests[] = {
-	"[A, B, C] -> { [x, y, z] : x >= 0 and y >= 0 and y <= A - x and "
-				"z >= 0 and z <= C - y and z <= B - x - y }",
-};
+static int test_arena(isl_ctx *ctx)
+{
+	const char *str;
+	isl_set *set;
+	isl_stat r;
 
-/* Add the domain of "cell" to "cells".
+	if (isl_ctx_push_arena(ctx) < 0)
+		return -1;
+	if (isl_ctx_push_arena(ctx) < 0)
+		return -1;
+	str = "{ [x, y] : 0 <= x <= 10 and 0 <= y <= 10 or "
+		"x >= 11 and x <= 20 and 0 <= y <= 10 }";
+	set = isl_set_read_from_str(ctx, str);
+	set = isl_set_coalesce(set);
+	if (isl_ctx_pop_arena(ctx) < 0)
+		set = isl_set_free(set);
+	set = isl_set_union(isl_set_copy(set), set);
+	set = isl_set_coalesce(set);
+	if (isl_ctx_pop_arena(ctx) < 0)
+		set = isl_set_free(set);
+	r = set_check_equal(set, "{ [x, y] : 0 <= x <= 20 and 0 <= y <= 10 }");
+	isl_set_free(set);
+
+	return r;
+}
+
+/* Return the number of blocks of integers in the block cache of "ctx".
  */
-static isl_stat add_cell(__isl_take isl_cell *cell, void *user)
+static int n_cached_blocks(isl_ctx *ctx)
 {
-	isl_basic_set_list **cells = user;
-	isl_basic_set *dom;
+	int c, n = 0;
 
-	dom = isl_cell_get_domain(cell);
-	isl_cell_free(cell);
-	*cells = isl_basic_set_list_add(*cells, dom);
+	for (c = 0; c < ISL_BLK_N_CLASS; ++c)
+		n += ctx->n_cached[c];
 
-	return *cells ? isl_stat_ok : isl_stat_error;
+	return n;
 }
 
-/* Check that the elements of "list" are pairwise disjoint.
+/* Compute the simple hull of the map described by "str" twice and
+ * return the number of times a cached simple hull was reused.
  */
-static isl_stat check_pairwise_disjoint(__isl_keep isl_basic_set_list *list)
+static int count_simple_hull_reuses(isl_ctx *ctx, const char *str)
 {
-	int i, j;
-	isl_size n;
+	isl_map *map;
+	isl_basic_map *hull1, *hull2;
+	struct isl_stats stats;
 
-	n = isl_basic_set_list_n_basic_set(list);
-	if (n < 0)
-		return isl_stat_error;
+	map = isl_map_read_from_str(ctx, str);
+	isl_ctx_reset_stats(ctx);
+	hull1 = isl_map_simple_hull(isl_map_copy(map));
+	hull2 = isl_map_simple_hull(map);
+	isl_basic_map_free(hull1);
+	isl_basic_map_free(hull2);
+	if (!hull1 || !hull2 || isl_ctx_get_stats(ctx, &stats) < 0)
+		return -1;
 
-	for (i = 0; i < n; ++i) {
-		isl_basic_set *bset_i;
+	return stats.simple_hull_cache_hits;
+}
 
-		bset_i = isl_basic_set_list_get_basic_set(list, i);
-		for (j = i + 1; j < n; ++j) {
-			isl_basic_set *bset_j;
-			isl_bool disjoint;
+/* Check that isl_ctx_trim_memory releases the memory that is
+ * kept around for later reuse, without affecting the objects
+ * that are still alive, and that no freed memory or derived data
+ * is kept around if the memory_lean option is set.
+ */
+static int test_trim_memory(isl_ctx *ctx)
+{
+	int i, bits, size, reuses;
+	const char *str, *map_str;
+	isl_id_list *ids;
+	isl_basic_set *bset;
+	isl_set *set;
+	isl_point *pnt;
+	isl_stat r;
 
-			bset_j = isl_basic_set_list_get_basic_set(list, j);
-			disjoint = isl_basic_set_is_disjoint(bset_i, bset_j);
-			isl_basic_set_free(bset_j);
-			if (!disjoint)
-				isl_die(isl_basic_set_list_get_ctx(list),
-					isl_error_unknown, "not disjoint",
-					break);
-			if (disjoint < 0 || !disjoint)
-				break;
-		}
-		isl_basic_set_free(bset_i);
-		if (j < n)
-			return isl_stat_error;
+	size = isl_options_get_sample_cache_size(ctx);
+	isl_options_set_sample_cache_size(ctx, 4);
+	str = "{ [x, y] : 0 <= x, y <= 10 and x + y >= 3 }";
+	set = isl_set_read_from_str(ctx, str);
+	bset = isl_basic_set_sample(isl_set_simple_hull(isl_set_copy(set)));
+	isl_basic_set_free(bset);
+	ids = isl_id_list_alloc(ctx, 100);
+	for (i = 0; i < 100; ++i) {
+		char name[10];
+
+		snprintf(name, sizeof(name), "i%d", i);
+		ids = isl_id_list_add(ids, isl_id_alloc(ctx, name, NULL));
 	}
+	isl_id_list_free(ids);
+	isl_val_free(isl_val_int_from_si(ctx, 1));
+	bits = ctx->id_table.bits;
+	r = isl_ctx_trim_memory(ctx);
+	isl_options_set_sample_cache_size(ctx, size);
+	if (r < 0 || !bset || !ids)
+		set = isl_set_free(set);
+	if (set && (ctx->sample_cache || ctx->n_val_cached != 0 ||
+		    n_cached_blocks(ctx) != 0 || ctx->id_table.bits >= bits))
+		isl_die(ctx, isl_error_unknown, "memory not released",
+			set = isl_set_free(set));
+	r = set_check_equal(set, str);
+	isl_set_free(set);
+	if (r < 0)
+		return -1;
 
-	return isl_stat_ok;
+	map_str = "{ [x] -> [y] : 0 <= x <= 10 and y = x or "
+		"20 <= x <= 30 and y = 0 }";
+	isl_options_set_memory_lean(ctx, 1);
+	reuses = count_simple_hull_reuses(ctx, map_str);
+	pnt = isl_set_sample_point(isl_set_read_from_str(ctx, str));
+	isl_point_free(pnt);
+	isl_options_set_memory_lean(ctx, 0);
+	if (reuses < 0 || !pnt)
+		return -1;
+	if (reuses != 0 || ctx->n_val_cached != 0 || n_cached_blocks(ctx) != 0)
+		isl_die(ctx, isl_error_unknown, "memory kept around",
+			return -1);
+	reuses = count_simple_hull_reuses(ctx, map_str);
+	if (reuses < 0)
+		return -1;
+	if (reuses == 0)
+		isl_die(ctx, isl_error_unknown, "simple hull not reused",
+			return -1);
+
+	return 0;
 }
 
-/* Check that the chambers computed by isl_vertices_foreach_disjoint_cell
- * are pairwise disjoint.
+/* Inputs for test_stats_json.
  */
-static int test_chambers(isl_ctx *ctx)
+static const char *stats_json_tests[] = {
+	"{ [i] : 0 <= i < 10 or 10 <= i < 20 }",
+	"[n] -> { [i, j] -> [k] : 0 <= i < n and k = 2i or "
+		"i >= n and k = 2i and j > 0 }",
+	"{ [i] : i = 0 or i = 1 or i = 2 or i = 3 }",
+};
+
+/* Check that the most expensive calls to isl_map_coalesce are recorded
+ * in decreasing order of cost if the "stats_top_coalesce" option is set,
+ * that the recorded inputs can be read back and
+ * that the statistics can be exported in JSON format.
+ * A separate isl_ctx is used to avoid affecting the statistics
+ * of the main isl_ctx.
+ */
+static int test_stats_json(isl_ctx *ctx)
 {
-	int i;
+	int i, j;
+	char *json;
+	isl_stat r = isl_stat_ok;
 
-	for (i = 0; i < ARRAY_SIZE(chambers_tests); ++i) {
-		isl_basic_set *bset;
-		isl_vertices *vertices;
-		isl_basic_set_list *cells;
-		isl_stat ok;
+	ctx = isl_ctx_alloc();
+	if (!ctx)
+		return -1;
+	isl_options_set_stats_top_coalesce(ctx, 2);
+	for (i = 0; i < ARRAY_SIZE(stats_json_tests); ++i) {
+		isl_map *map;
 
-		bset = isl_basic_set_read_from_str(ctx, chambers_tests[i]);
-		vertices = isl_basic_set_compute_vertices(bset);
-		cells = isl_basic_set_list_alloc(ctx, 0);
-		if (isl_vertices_foreach_disjoint_cell(vertices, &add_cell,
-							&cells) < 0)
-			cells = isl_basic_set_list_free(cells);
-		ok = check_pairwise_disjoint(cells);
-		isl_basic_set_list_free(cells);
-		isl_vertices_free(vertices);
-		isl_basic_set_free(bset);
+		map = isl_map_read_from_str(ctx, stats_json_tests[i]);
+		map = isl_map_coalesce(map);
+		isl_map_free(map);
+		if (!map)
+			r = isl_stat_error;
+	}
+	if (r >= 0 && ctx->n_top_coalesce != 2)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected number of records", r = isl_stat_error);
+	for (i = 0; r >= 0 && i < ctx->n_top_coalesce; ++i) {
+		struct isl_coalesce_record *record = &ctx->top_coalesce[i];
+		isl_bool found = isl_bool_false;
+		isl_map *map;
 
-		if (ok < 0)
-			return -1;
+		if (i > 0 && (record->time > record[-1].time ||
+		    (record->time == record[-1].time &&
+		     record->operations > record[-1].operations)))
+			isl_die(ctx, isl_error_unknown,
+				"records not sorted", r = isl_stat_error);
+		map = isl_map_read_from_binary_str(ctx, record->input);
+		for (j = 0; map && !found && j < ARRAY_SIZE(stats_json_tests);
+		     ++j) {
+			isl_map *test;
+
+			test = isl_map_read_from_str(ctx, stats_json_tests[j]);
+			found = isl_map_is_equal(map, test);
+			isl_map_free(test);
+		}
+		isl_map_free(map);
+		if (found < 0 || !map)
+			r = isl_stat_error;
+		else if (!found)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected record", r = isl_stat_error);
 	}
 
-	return 0;
+	json = isl_ctx_stats_to_json_str(ctx);
+	if (r >= 0 && !json)
+		r = isl_stat_error;
+	if (r >= 0 && (strncmp(json, "{ \"operations\": ", 16) ||
+	    !strstr(json, "\"caches\": { \"block\": { \"hits\": ") ||
+	    !strstr(json, "\"top_coalesce\": [ { \"time\": ")))
+		isl_die(ctx, isl_error_unknown,
+			"unexpected JSON output", r = isl_stat_error);
+	free(json);
+
+	isl_ctx_reset_stats(ctx);
+	if (r >= 0 && ctx->n_top_coalesce != 0)
+		isl_die(ctx, isl_error_unknown,
+			"records not cleared", r = isl_stat_error);
+	isl_ctx_free(ctx);
+
+	return r;
 }
 
 struct {
 	const char *name;
 	int (*fn)(isl_ctx *ctx);
 } tests [] = {
+	{ "arena", &test_arena },
+	{ "trim memory", &test_trim_memory },
+	{ "stats (JSON)", &test_stats_json },
+	{ "seq", &test_seq },
+	{ "intern spaces", &test_intern_spaces },
+	{ "child context", &test_ctx_child },
+	{ "statistics", &test_stats },
+	{ "budget", &test_budget },
+	{ "abort", &test_abort },
+	{ "memory statistics", &test_memory_stats },
+	{ "allocator", &test_allocator },
+	{ "operation scopes", &test_scope },
+	{ "sample cache", &test_sample_cache },
+	{ "lexopt cache", &test_lexopt_cache },
+	{ "pw coalesce threshold", &test_pw_coalesce_threshold },
+	{ "associative arrays", &test_id_to_id },
+	{ "lp solver", &test_lp_solver },
+	{ "tableau lexmin push", &test_tab_lexmin_push },
+	{ "pip threads", &test_pip_threads },
 	{ "universe", &test_universe },
 	{ "domain hash", &test_domain_hash },
 	{ "dual", &test_dual },
@@ -10833,6 +18829,7 @@ struct {
 	{ "multi piecewise affine expressions", &test_multi_pw_aff },
 	{ "conversion", &test_conversion },
 	{ "list", &test_list },
+	{ "list bulk", &test_list_bulk },
 	{ "align parameters", &test_align_parameters },
 	{ "drop unused parameters", &test_drop_unused_parameters },
 	{ "pullback", &test_pullback },
@@ -10840,12 +18837,24 @@ struct {
 	{ "AST build", &test_ast_build },
 	{ "AST generation", &test_ast_gen },
 	{ "eliminate", &test_eliminate },
+	{ "deltas", &test_deltas },
 	{ "deltas_map", &test_deltas_map },
 	{ "residue class", &test_residue_class },
 	{ "div", &test_div },
 	{ "slice", &test_slice },
 	{ "fixed power", &test_fixed_power },
 	{ "sample", &test_sample },
+	{ "gbr threads", &test_gbr_threads },
+	{ "emptiness stages", &test_empty_stages },
+	{ "variable index", &test_var_index },
+	{ "normalize duplicates", &test_normalize_duplicates },
+	{ "every", &test_every },
+	{ "int64 constraints", &test_from_int64_constraints },
+	{ "point blocks", &test_point_block },
+	{ "scan threads", &test_scan_threads },
+	{ "scan triangular", &test_scan_triangular },
+	{ "matrix elements", &test_mat_elements },
+	{ "modular Hermite normal form", &test_hermite_modular },
 	{ "empty projection", &test_empty_projection },
 	{ "output", &test_output },
 	{ "vertices", &test_vertices },
@@ -10859,11 +18868,22 @@ struct {
 	{ "injective", &test_injective },
 	{ "schedule (whole component)", &test_schedule_whole },
 	{ "schedule (incremental)", &test_schedule_incremental },
+	{ "schedule (threads)", &test_schedule_threads },
+	{ "schedule (coefficients threads)",
+		&test_schedule_coefficients_threads },
+	{ "schedule (recompute)", &test_schedule_recompute },
+	{ "schedule (LP backend)", &test_schedule_lp_backend },
+	{ "schedule (offload)", &test_schedule_offload },
+	{ "schedule (budget)", &test_schedule_budget },
+	{ "schedule (trace)", &test_schedule_trace },
 	{ "schedule tree", &test_schedule_tree },
+	{ "schedule tree in place", &test_schedule_tree_inplace },
+	{ "schedule tree cached map", &test_schedule_tree_cached_map },
 	{ "schedule tree prefix", &test_schedule_tree_prefix },
 	{ "schedule tree grouping", &test_schedule_tree_group },
 	{ "tile", &test_tile },
 	{ "union map", &test_union_map },
+	{ "thread equivalence", &test_thread_equivalence },
 	{ "union_pw", &test_union_pw },
 	{ "locus", &test_locus },
 	{ "eval", &test_eval },
@@ -10871,6 +18891,8 @@ struct {
 	{ "single-valued", &test_sv },
 	{ "recession cone", &test_recession_cone },
 	{ "affine hull", &test_affine_hull },
+	{ "implicit equalities", &test_implicit_equalities },
+	{ "redundancies", &test_redundancies },
 	{ "simple_hull", &test_simple_hull },
 	{ "box hull", &test_box_hull },
 	{ "coalesce", &test_coalesce },
@@ -10895,6 +18917,7 @@ struct {
 	{ "dataflow analysis", &test_dep },
 	{ "reading", &test_read },
 	{ "bounded", &test_bounded },
+	{ "cost estimate", &test_estimate_cost },
 	{ "construction", &test_construction },
 	{ "dimension manipulation", &test_dim },
 	{ "map application", &test_application },
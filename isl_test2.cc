@@ -14,9 +14,12 @@
 /* A binary isl function that appears in the C++ bindings
  * as a unary method in a class T, taking an extra argument
  * of type A1 and returning an object of type R.
+ * Since the isl function takes ownership of its first argument,
+ * the method has both an lvalue and an rvalue overload.
+ * Select the lvalue overload.
  */
 template <typename A1, typename R, typename T>
-using binary_fn = R (T::*)(A1) const;
+using binary_fn = R (T::*)(A1) const &;
 
 /* A function for selecting an overload of a pointer to a unary C++ method
  * based on the single argument type.
@@ -65,8 +68,8 @@ static bool is_equal(const T &a, const T &b)
  * throwing an exception when an unexpected result is produced.
  */
 template <typename R, typename T, typename A1>
-static void test(isl::ctx ctx, R (T::*fn)(A1) const, const std::string &name,
-	const std::vector<binary> &tests)
+static void test(isl::ctx ctx, R (T::*fn)(A1) const &,
+	const std::string &name, const std::vector<binary> &tests)
 {
 	for (const auto &test : tests) {
 		T obj(ctx, test.arg1);
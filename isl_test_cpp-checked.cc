@@ -7,6 +7,7 @@
 
 #include <vector>
 #include <string>
+#include <utility>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -282,6 +283,7 @@ static void test_ast_build(isl::ctx ctx)
  *  - Object construction
  *  - Different parameter types
  *  - Different return types
+ *  - Methods called on rvalues
  *  - Foreach functions
  *  - Every functions
  *  - Spaces
@@ -299,6 +301,7 @@ int main()
 	test_constructors(ctx);
 	test_parameters(ctx);
 	test_return(ctx);
+	test_rvalue(ctx);
 	test_foreach(ctx);
 	test_every(ctx);
 	test_space(ctx);
@@ -192,6 +192,35 @@ void test_return_string(isl::ctx ctx)
 	assert(expected_string == expr.to_C_str());
 }
 
+/* Test that a method called on an rvalue passes the object itself
+ * to the isl function.
+ *
+ * In particular, check that such a call produces the same result
+ * as a call on an lvalue, that the lvalue overload leaves the object
+ * intact and that an object that is explicitly moved from
+ * has given up its pointer.
+ * Also check a chain of calls on temporaries.
+ */
+void test_rvalue(isl::ctx ctx)
+{
+	isl::set s(ctx, "{ [i] : 0 <= i < 10 }");
+	isl::set t(ctx, "{ [i] : 5 <= i < 20 }");
+	isl::set expected(ctx, "{ [i] : 5 <= i < 10 }");
+
+	isl::set res = s.intersect(t);
+	assert(!s.is_null());
+	assert(IS_TRUE(res.is_equal(expected)));
+
+	isl::set copy = s;
+	res = std::move(copy).intersect(t);
+	assert(copy.is_null());
+	assert(!s.is_null());
+	assert(IS_TRUE(res.is_equal(expected)));
+
+	res = isl::set(ctx, "{ [i] : 0 <= i < 10 }").intersect(t).coalesce();
+	assert(IS_TRUE(res.is_equal(expected)));
+}
+
 /* Test the functionality of "every" functions
  * that does not depend on the type of C++ bindings.
  */
@@ -5,8 +5,10 @@
  * Written by Tobias Grosser, Weststrasse 47, CH-8003, Zurich
  */
 
+#include <iterator>
 #include <vector>
 #include <string>
+#include <utility>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -148,6 +150,31 @@ static void test_foreach_scc(isl::ctx ctx)
 	assert(sorted.at(2).name() == "a");
 }
 
+/* Test that the elements of a list can be traversed
+ * in a range-based for loop and that the iterators can be passed
+ * to standard library functions that take a pair of input iterators.
+ */
+static void test_list_range(isl::ctx ctx)
+{
+	isl::union_set uset(ctx, "{ A[0]; A[1]; B[2] }");
+	isl::set_list list = uset.set_list();
+	unsigned n = 0;
+
+	for (isl::set set : list) {
+		assert(isl::union_set(set).is_subset(uset));
+		++n;
+	}
+	assert(n == 2);
+	assert(list.begin() != list.end());
+
+	std::vector<isl::set> sets(list.begin(), list.end());
+	assert(sets.size() == 2);
+	assert(std::distance(list.begin(), list.end()) == 2);
+
+	isl::set_list empty(ctx, 0);
+	assert(empty.begin() == empty.end());
+}
+
 /* Test the functionality of "every" functions.
  *
  * In particular, test the generic functionality and
@@ -346,8 +373,10 @@ static void test_typed(isl::ctx ctx)
  *  - Object construction
  *  - Different parameter types
  *  - Different return types
+ *  - Methods called on rvalues
  *  - Foreach functions
  *  - Foreach SCC function
+ *  - Range-based for loops over lists
  *  - Exceptions
  *  - Spaces
  *  - Schedule trees
@@ -365,8 +394,10 @@ int main()
 	test_constructors(ctx);
 	test_parameters(ctx);
 	test_return(ctx);
+	test_rvalue(ctx);
 	test_foreach(ctx);
 	test_foreach_scc(ctx);
+	test_list_range(ctx);
 	test_every(ctx);
 	test_exception(ctx);
 	test_space(ctx);
@@ -10,7 +10,10 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 #include <isl_int.h>
+#include <isl/version.h>
 
 #define ARRAY_SIZE(array) (sizeof(array)/sizeof(*array))
 
@@ -57,6 +60,10 @@ struct {
 	{ &int_test_hash, "-2147483647" },
 	{ &int_test_hash, "2147483648" },
 	{ &int_test_hash, "-2147483648" },
+	{ &int_test_hash, "4611686018427387903" },
+	{ &int_test_hash, "-4611686018427387903" },
+	{ &int_test_hash, "4611686018427387904" },
+	{ &int_test_hash, "-4611686018427387904" },
 };
 
 static void int_test_single_value()
@@ -504,6 +511,9 @@ struct {
 	{ &int_test_sum, "2147483648", "2147483647", "1" },
 	{ &int_test_sum, "-2147483648", "-2147483647", "-1" },
 
+	{ &int_test_sum, "4611686018427387904", "4611686018427387903", "1" },
+	{ &int_test_sum, "-4611686018427387904", "-4611686018427387903", "-1" },
+
 	{ &int_test_product, "0", "0", "0" },
 	{ &int_test_product, "0", "0", "1" },
 	{ &int_test_product, "1", "1", "1" },
@@ -530,6 +540,13 @@ struct {
 	{ &int_test_product,
 	  "4611686016279904256", "-2147483647", "-2147483648" },
 
+	{ &int_test_product,
+	  "4611686018427387904", "2147483648", "2147483648" },
+	{ &int_test_product,
+	  "-9223372036854775808", "-4294967296", "2147483648" },
+	{ &int_test_product,
+	  "18446744073709551616", "4294967296", "4294967296" },
+
 	{ &int_test_product, "85070591730234615847396907784232501249",
 	  "9223372036854775807", "9223372036854775807" },
 	{ &int_test_product, "-85070591730234615847396907784232501249",
@@ -576,6 +593,8 @@ struct {
 	{ &int_test_cdiv, "1073741824", "2147483648", "2" },
 	{ &int_test_cdiv, "-1073741824", "-2147483648", "2" },
 	{ &int_test_cdiv, "-1073741823", "-2147483647", "2" },
+	{ &int_test_cdiv, "2305843009213693952", "4611686018427387903", "2" },
+	{ &int_test_fdiv, "-2305843009213693952", "-4611686018427387903", "2" },
 
 	{ &int_test_tdiv, "0", "1", "2" },
 	{ &int_test_tdiv, "0", "-1", "2" },
@@ -596,6 +615,7 @@ struct {
 	{ &int_test_lcm, "18", "6", "9" },
 	{ &int_test_gcd, "1", "14", "2147483647" },
 	{ &int_test_lcm, "15032385529", "7", "2147483647" },
+	{ &int_test_lcm, "9223372036854775806", "4611686018427387903", "2" },
 	{ &int_test_gcd, "2", "6", "-2147483648" },
 	{ &int_test_lcm, "6442450944", "6", "-2147483648" },
 	{ &int_test_gcd, "1", "6", "9223372036854775807" },
@@ -641,13 +661,115 @@ struct {
 	{ &int_test_divisible, "0", "9223372036854775807", "2" },
 };
 
+/* The number of coefficients in each row of the micro-benchmark and
+ * the number of times each row is processed.
+ */
+#define BENCH_SIZE	64
+#define BENCH_ROUNDS	20000
+
+/* Initialize the "n" elements of "v" to pseudo-random values
+ * that are the product of "factors" numbers of at most 30 bits each.
+ */
+static void bench_init_row(isl_int *v, int n, int factors, unsigned *seed)
+{
+	int i, j;
+
+	for (i = 0; i < n; ++i) {
+		isl_int_init(v[i]);
+		isl_int_set_si(v[i], 1);
+		for (j = 0; j < factors; ++j) {
+			*seed = *seed * 1103515245 + 12345;
+			isl_int_mul_ui(v[i], v[i], 1 + (*seed >> 2) % (1 << 30));
+		}
+		if (i % 2)
+			isl_int_neg(v[i], v[i]);
+	}
+}
+
+/* Perform the operations that dominate the use of isl_int
+ * in the rest of isl on rows of "n" coefficients "a" and "b"
+ * and return the time this takes.
+ * In particular, compute the inner product of the two rows,
+ * a linear combination of the two rows and the gcd of the result
+ * and divide the result by this gcd.
+ */
+static double bench_rows(isl_int *a, isl_int *b, isl_int *c, int n)
+{
+	int i, round;
+	isl_int sum, gcd;
+	clock_t start;
+
+	isl_int_init(sum);
+	isl_int_init(gcd);
+	start = clock();
+	for (round = 0; round < BENCH_ROUNDS; ++round) {
+		isl_int_set_si(sum, 0);
+		for (i = 0; i < n; ++i)
+			isl_int_addmul(sum, a[i], b[i]);
+		isl_int_set_si(gcd, 0);
+		for (i = 0; i < n; ++i) {
+			isl_int_mul(c[i], a[i], b[0]);
+			isl_int_submul(c[i], b[i], a[0]);
+			isl_int_gcd(gcd, gcd, c[i]);
+		}
+		if (isl_int_is_zero(gcd) || isl_int_is_one(gcd))
+			continue;
+		for (i = 0; i < n; ++i)
+			isl_int_fdiv_q(c[i], c[i], gcd);
+	}
+	isl_int_clear(gcd);
+	isl_int_clear(sum);
+
+	return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* Run the micro-benchmark on coefficients that are the product
+ * of "factors" numbers of at most 30 bits each and print the result.
+ */
+static void bench_size(const char *name, int factors)
+{
+	int i;
+	unsigned seed = 1;
+	isl_int a[BENCH_SIZE], b[BENCH_SIZE], c[BENCH_SIZE];
+	double t;
+
+	bench_init_row(a, BENCH_SIZE, factors, &seed);
+	bench_init_row(b, BENCH_SIZE, factors, &seed);
+	bench_init_row(c, BENCH_SIZE, 0, &seed);
+	t = bench_rows(a, b, c, BENCH_SIZE);
+	printf("%s: %.3f s\n", name, t);
+	for (i = 0; i < BENCH_SIZE; ++i) {
+		isl_int_clear(a[i]);
+		isl_int_clear(b[i]);
+		isl_int_clear(c[i]);
+	}
+}
+
+/* Time the isl_int backend that isl was configured with
+ * on small and large coefficients.
+ * The backend is part of the version string.
+ * Running this benchmark on builds configured with different
+ * --with-int options shows which backend suits a given range
+ * of coefficients best.
+ */
+static void bench(void)
+{
+	printf("version: %s", isl_version());
+	bench_size("small (30 bits)", 1);
+	bench_size("medium (120 bits)", 4);
+	bench_size("large (600 bits)", 20);
+}
+
 /* Tests the isl_int_* function to give the expected results. Tests are
  * grouped by the number of arguments they take.
  *
  * If small integer optimization is enabled, we also test whether the results
  * are the same in small and big representation.
+ *
+ * If the "--bench" argument is passed, then the isl_int backend
+ * is also timed on a micro-benchmark.
  */
-int main()
+int main(int argc, char **argv)
 {
 	int i;
 
@@ -665,5 +787,8 @@ int main()
 		    int_binary_tests[i].rhs, int_binary_tests[i].fn);
 	}
 
+	if (argc > 1 && !strcmp(argv[1], "--bench"))
+		bench();
+
 	return 0;
 }
@@ -213,6 +213,59 @@ def test_foreach():
 		caught = True
 	assert(caught)
 
+# Test the bulk conversion functions.
+#
+# In particular, check that the constraints of a basic set
+# can be extracted and used to construct the same basic set again,
+# also when there are no equality constraints, and
+# that the points of a set can be enumerated into a single array,
+# also for a zero-dimensional set.
+#
+def test_bulk():
+	bs = isl.basic_set("[n] -> { [i, j] : i = 2j and 0 <= j <= n }")
+	eq, ineq = bs.constraint_matrix()
+	assert(len(eq) == 1 and len(eq[0]) == 4)
+	assert(len(ineq) == 2)
+	bs2 = isl.basic_set.from_constraint_matrix(bs.space(), eq, ineq)
+	assert(bs.is_equal(bs2))
+	bs3 = isl.basic_set.from_constraint_matrix(bs.space(), [], ineq)
+	assert(bs3.is_equal(isl.basic_set("[n] -> { [i, j] : 0 <= i <= 2n }")))
+
+	s = isl.set("{ [i, j] : 0 <= i < 3 and 0 <= j <= i }")
+	points = s.points_array()
+	assert(len(points) == 6)
+	assert([int(x) for x in points[5]] == [2, 2])
+	count = [0]
+	def add(pnt):
+		count[0] += 1
+	s.foreach_point(add)
+	assert(count[0] == len(points))
+
+	points = isl.set("{ [] }").points_array()
+	assert(len(points) == 1 and len(points[0]) == 0)
+	points = isl.set("{ [i] : 0 <= i < 0 }").points_array()
+	assert(len(points) == 0)
+
+# Test that independent computations can be performed concurrently.
+#
+# In particular, check that each thread uses its own default context and
+# that the results computed in different threads are correct.
+#
+def test_threads():
+	from concurrent.futures import ThreadPoolExecutor
+
+	def compute(i):
+		s = isl.set("{ [x, y] : 0 <= x <= %d and 0 <= y <= x }" % i)
+		s = s.subtract(isl.set("{ [x, y] : y = 0 }")).coalesce()
+		m = s.lexmin()
+		return (s.ctx.ptr, m.is_equal(isl.set("{ [1, 1] }")))
+
+	ctx = isl.Context.getDefaultInstance()
+	with ThreadPoolExecutor(max_workers=4) as executor:
+		results = list(executor.map(compute, range(1, 17)))
+	assert(all(equal for _, equal in results))
+	assert(all(ptr != ctx.ptr for ptr, _ in results))
+
 # Test the functionality of "foreach_scc" functions.
 #
 # In particular, test it on a list of elements that can be completely sorted
@@ -484,6 +537,8 @@ def test_ast_build_expr():
 #  - Different return types
 #  - isl.id.user
 #  - Foreach functions
+#  - Bulk conversions
+#  - Concurrent computations
 #  - Foreach SCC function
 #  - Every functions
 #  - Spaces
@@ -496,6 +551,8 @@ test_parameters()
 test_return()
 test_user()
 test_foreach()
+test_bulk()
+test_threads()
 test_foreach_scc()
 test_every()
 test_space()
@@ -19,6 +19,7 @@
 #include <isl_vec_private.h>
 #include <isl_options_private.h>
 #include <isl_tarjan.h>
+#include "isl_task.h"
 
 isl_bool isl_map_is_transitively_closed(__isl_keep isl_map *map)
 {
@@ -2175,6 +2176,7 @@ static __isl_give isl_map *box_closure_on_domain(__isl_take isl_map *map,
 	isl_basic_set *aff = NULL;
 	isl_basic_map *bmap = NULL;
 	isl_vec *obj = NULL;
+	isl_lp_solver *lp = NULL;
 	isl_int opt;
 
 	isl_int_init(opt);
@@ -2215,12 +2217,15 @@ static __isl_give isl_map *box_closure_on_domain(__isl_take isl_map *map,
 	if (!obj)
 		goto error;
 	isl_seq_clr(obj->el, 1 + nparam + d);
+	lp = isl_set_lp_solver_alloc(delta);
+	if (!lp)
+		goto error;
 	for (i = 0; i < d; ++ i) {
 		enum isl_lp_result res;
 
 		isl_int_set_si(obj->el[1 + nparam + i], 1);
 
-		res = isl_set_solve_lp(delta, 0, obj->el, map->ctx->one, &opt,
+		res = isl_lp_solver_solve(lp, 0, obj->el, map->ctx->one, &opt,
 					NULL, NULL);
 		if (res == isl_lp_error)
 			goto error;
@@ -2235,7 +2240,7 @@ static __isl_give isl_map *box_closure_on_domain(__isl_take isl_map *map,
 			isl_int_neg(bmap->ineq[k][1 + nparam + 2 * d + aff->n_div], opt);
 		}
 
-		res = isl_set_solve_lp(delta, 1, obj->el, map->ctx->one, &opt,
+		res = isl_lp_solver_solve(lp, 1, obj->el, map->ctx->one, &opt,
 					NULL, NULL);
 		if (res == isl_lp_error)
 			goto error;
@@ -2263,6 +2268,7 @@ static __isl_give isl_map *box_closure_on_domain(__isl_take isl_map *map,
 
 	app = isl_map_from_domain_and_range(dom, ran);
 
+	isl_lp_solver_free(lp);
 	isl_vec_free(obj);
 	isl_basic_set_free(aff);
 	isl_map_free(map);
@@ -2275,6 +2281,7 @@ static __isl_give isl_map *box_closure_on_domain(__isl_take isl_map *map,
 
 	return map;
 error:
+	isl_lp_solver_free(lp);
 	isl_vec_free(obj);
 	isl_basic_map_free(bmap);
 	isl_basic_set_free(aff);
@@ -2548,11 +2555,54 @@ error:
 	return NULL;
 }
 
+/* Compute the transitive closure of "map" using map_power,
+ * performing at most "budget" operations.
+ *
+ * The computation is performed in a separate budget scope.
+ * If the budget is exceeded, then the (partial) result is discarded and
+ * the cheap overapproximation computed by box_closure is returned instead,
+ * with *exact set to isl_bool_false since the exactness of this
+ * overapproximation is not checked.
+ * Errors are not reported during the attempt since
+ * an exceeded budget is not considered to be an error.
+ * Other errors are passed on to the caller.
+ */
+static __isl_give isl_map *transitive_closure_budget(__isl_take isl_map *map,
+	isl_bool *exact, int budget)
+{
+	isl_ctx *ctx;
+	isl_map *res;
+	int on_error;
+
+	ctx = isl_map_get_ctx(map);
+	on_error = isl_options_get_on_error(ctx);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+	if (isl_ctx_push_budget(ctx, "transitive_closure", budget) < 0)
+		res = NULL;
+	else {
+		res = map_power(isl_map_copy(map), exact, 1);
+		if (isl_ctx_pop_budget(ctx) < 0)
+			res = isl_map_free(res);
+	}
+	isl_options_set_on_error(ctx, on_error);
+	if (res || isl_ctx_last_error(ctx) != isl_error_quota) {
+		isl_map_free(map);
+		return res;
+	}
+	isl_ctx_reset_error(ctx);
+
+	if (exact)
+		*exact = isl_bool_false;
+	return box_closure(map);
+}
+
 /* Compute the transitive closure  of "map", or an overapproximation.
  * If the result is exact, then *exact is set to 1.
  * Simply use map_power to compute the powers of map, but tell
  * it to project out the lengths of the paths instead of equating
  * the length to a parameter.
+ * If the closure_budget option is set, then fall back
+ * to a cheap overapproximation if this takes too many operations.
  */
 __isl_give isl_map *isl_map_transitive_closure(__isl_take isl_map *map,
 	isl_bool *exact)
@@ -2578,7 +2628,11 @@ __isl_give isl_map *isl_map_transitive_closure(__isl_take isl_map *map,
 	}
 
 	target_dim = isl_map_get_space(map);
-	map = map_power(map, exact, 1);
+	if (map->ctx->opt->closure_budget > 0)
+		map = transitive_closure_budget(map, exact,
+					map->ctx->opt->closure_budget);
+	else
+		map = map_power(map, exact, 1);
 	map = isl_map_reset_space(map, target_dim);
 
 	return map;
@@ -2747,10 +2801,87 @@ error:
 	return NULL;
 }
 
+/* Data used by union_closures.
+ * Task "k" computes the closure of the strongly connected component
+ * "comp[k]" of a union relation and stores the result in "res[k]".
+ * If "exact" is not NULL, then the exactness of the closure
+ * of component "k" is stored in "exact[k]".
+ */
+struct isl_union_closure_tasks {
+	isl_union_map **comp;
+	isl_union_map **res;
+	isl_bool *exact;
+};
+
+/* Compute the closure of task "k" in "ctx".
+ */
+static isl_stat union_closure_task_run(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_union_closure_tasks *data = user;
+	isl_union_map *comp;
+	isl_bool *exact = NULL;
+
+	comp = isl_union_map_copy_to_ctx(data->comp[k], ctx);
+	if (data->exact) {
+		exact = &data->exact[k];
+		*exact = isl_bool_true;
+	}
+	data->res[k] = union_floyd_warshall(comp, exact);
+	return data->res[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* Copy the closure computed by task "k" to "ctx".
+ */
+static isl_stat union_closure_task_merge(isl_ctx *ctx, int k, void *user)
+{
+	struct isl_union_closure_tasks *data = user;
+	isl_union_map *child = data->res[k];
+
+	data->res[k] = isl_union_map_copy_to_ctx(child, ctx);
+	isl_union_map_free(child);
+	return data->res[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* Compute the closures of the "n" strongly connected components "comp"
+ * using up to "n_thread" threads, each closure being computed
+ * in a task of isl_ctx_run_tasks, and store the results in "res".
+ * If "exact" is not NULL, then the exactness of the closure
+ * of component "k" is stored in "exact[k]".
+ */
+static isl_stat union_closures(isl_ctx *ctx, isl_union_map **comp,
+	int n, isl_union_map **res, isl_bool *exact, int n_thread)
+{
+	struct isl_union_closure_tasks data = { comp, res, exact };
+
+	return isl_ctx_run_tasks(ctx, n, n_thread, &union_closure_task_run,
+				&union_closure_task_merge, &data);
+}
+
+/* Free the first "n" elements of "list" as well as "list" itself.
+ */
+static void free_union_map_array(isl_union_map **list, int n)
+{
+	int i;
+
+	if (!list)
+		return;
+	for (i = 0; i < n; ++i)
+		isl_union_map_free(list[i]);
+	free(list);
+}
+
 /* Decompose the give union relation into strongly connected components.
  * The implementation is essentially the same as that of
  * construct_power_components with the major difference that all
  * operations are performed on union maps.
+ *
+ * The closure of a strongly connected component does not depend
+ * on those of the other components, so if the closure_threads option
+ * is set to a value greater than one, then all closures are
+ * first computed in parallel, each with its own exactness check.
+ * Otherwise, they are computed one by one and the exactness checks
+ * are skipped as soon as one of them turns out to be inexact.
+ * The results are then combined in topological order.
  */
 static __isl_give isl_union_map *union_components(
 	__isl_take isl_union_map *umap, isl_bool *exact)
@@ -2760,10 +2891,14 @@ static __isl_give isl_union_map *union_components(
 	isl_ctx *ctx;
 	isl_basic_map **list = NULL;
 	isl_basic_map **next;
+	isl_union_map **comp = NULL;
+	isl_union_map **path_comp = NULL;
+	isl_bool *exact_comp = NULL;
 	isl_union_map *path = NULL;
 	struct isl_tc_follows_data data;
 	struct isl_tarjan_graph *g = NULL;
-	int c, l;
+	int c, k, l;
+	int n_thread;
 	int recheck = 0;
 
 	n = 0;
@@ -2777,7 +2912,10 @@ static __isl_give isl_union_map *union_components(
 
 	ctx = isl_union_map_get_ctx(umap);
 	list = isl_calloc_array(ctx, isl_basic_map *, n);
-	if (!list)
+	comp = isl_calloc_array(ctx, isl_union_map *, n);
+	path_comp = isl_calloc_array(ctx, isl_union_map *, n);
+	exact_comp = isl_calloc_array(ctx, isl_bool, n);
+	if (!list || !comp || !path_comp || !exact_comp)
 		goto error;
 
 	next = list;
@@ -2793,26 +2931,43 @@ static __isl_give isl_union_map *union_components(
 	c = 0;
 	i = 0;
 	l = n;
-	path = isl_union_map_empty(isl_union_map_get_space(umap));
 	while (l) {
-		isl_union_map *comp;
-		isl_union_map *path_comp, *path_comb;
-		comp = isl_union_map_empty(isl_union_map_get_space(umap));
+		comp[c] = isl_union_map_empty(isl_union_map_get_space(umap));
 		while (g->order[i] != -1) {
-			comp = isl_union_map_add_map(comp,
+			comp[c] = isl_union_map_add_map(comp[c],
 				    isl_map_from_basic_map(
 					isl_basic_map_copy(list[g->order[i]])));
 			--l;
 			++i;
 		}
-		path_comp = union_floyd_warshall(comp, exact);
+		if (!comp[c++])
+			goto error;
+		++i;
+	}
+
+	n_thread = isl_options_get_closure_threads(ctx);
+	if (n_thread > 1 &&
+	    union_closures(ctx, comp, c, path_comp,
+				    exact ? exact_comp : NULL, n_thread) < 0)
+		goto error;
+
+	path = isl_union_map_empty(isl_union_map_get_space(umap));
+	for (k = 0; k < c; ++k) {
+		isl_union_map *path_comb;
+
+		if (!path_comp[k]) {
+			path_comp[k] = union_floyd_warshall(comp[k], exact);
+			comp[k] = NULL;
+		} else if (exact && *exact == isl_bool_true)
+			*exact = exact_comp[k];
 		path_comb = isl_union_map_apply_range(isl_union_map_copy(path),
-						isl_union_map_copy(path_comp));
-		path = isl_union_map_union(path, path_comp);
+					isl_union_map_copy(path_comp[k]));
+		path = isl_union_map_union(path, path_comp[k]);
+		path_comp[k] = NULL;
 		path = isl_union_map_union(path, path_comb);
-		++i;
-		++c;
 	}
+	if (!path)
+		goto error;
 
 	if (c > 1 && data.check_closed && !*exact) {
 		isl_bool closed;
@@ -2828,6 +2983,9 @@ static __isl_give isl_union_map *union_components(
 	for (i = 0; i < n; ++i)
 		isl_basic_map_free(list[i]);
 	free(list);
+	free_union_map_array(comp, n);
+	free_union_map_array(path_comp, n);
+	free(exact_comp);
 
 	if (recheck) {
 		isl_union_map_free(path);
@@ -2844,6 +3002,9 @@ error:
 			isl_basic_map_free(list[i]);
 		free(list);
 	}
+	free_union_map_array(comp, n);
+	free_union_map_array(path_comp, n);
+	free(exact_comp);
 	isl_union_map_free(umap);
 	isl_union_map_free(path);
 	return NULL;
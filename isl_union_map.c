@@ -13,10 +13,13 @@
  * B.P. 105 - 78153 Le Chesnay, France
  */
 
+#include <limits.h>
+
 #include <isl_map_private.h>
 #include <isl_union_map_private.h>
 #include <isl/ctx.h>
 #include <isl/hash.h>
+#include <isl/options.h>
 #include <isl_aff_private.h>
 #include <isl/map.h>
 #include <isl/set.h>
@@ -24,6 +27,8 @@
 #include <isl/union_set.h>
 #include <isl_maybe_map.h>
 #include <isl_id_private.h>
+#include <isl_sort.h>
+#include "isl_task.h"
 
 #include <bset_from_bmap.c>
 #include <set_to_map.c>
@@ -129,6 +134,17 @@ static __isl_give isl_union_map *isl_union_map_alloc(
 	return umap;
 }
 
+/* Create an empty union map living in "space" with room
+ * for as many maps as "umap" contains.
+ */
+static __isl_give isl_union_map *isl_union_map_alloc_same_size(
+	__isl_take isl_space *space, __isl_keep isl_union_map *umap)
+{
+	if (!umap)
+		space = isl_space_free(space);
+	return isl_union_map_alloc(space, umap ? umap->table.n : 0);
+}
+
 /* Create an empty union map without specifying any parameters.
  */
 __isl_give isl_union_map *isl_union_map_empty_ctx(isl_ctx *ctx)
@@ -236,7 +252,7 @@ __isl_give isl_union_map *isl_union_map_dup(__isl_keep isl_union_map *umap)
 	if (!umap)
 		return NULL;
 
-	dup = isl_union_map_empty(isl_space_copy(umap->dim));
+	dup = isl_union_map_alloc(isl_space_copy(umap->dim), umap->table.n);
 	if (isl_union_map_foreach_map(umap, &add_map, &dup) < 0)
 		goto error;
 	return dup;
@@ -245,17 +261,43 @@ error:
 	return NULL;
 }
 
+/* Return a copy of "umap" that can be modified.
+ * Since the caller is about to modify the result,
+ * any cached hash value is cleared.
+ */
 __isl_give isl_union_map *isl_union_map_cow(__isl_take isl_union_map *umap)
 {
 	if (!umap)
 		return NULL;
 
-	if (umap->ref == 1)
+	if (umap->ref == 1) {
+		umap->has_cached_hash = 0;
 		return umap;
+	}
 	umap->ref--;
 	return isl_union_map_dup(umap);
 }
 
+/* Make sure that "umap" can hold at least "n" maps
+ * without having to grow its internal hash table.
+ */
+__isl_give isl_union_map *isl_union_map_reserve(__isl_take isl_union_map *umap,
+	int n)
+{
+	umap = isl_union_map_cow(umap);
+	if (!umap)
+		return NULL;
+	if (isl_hash_table_reserve(umap->dim->ctx, &umap->table, n) < 0)
+		return isl_union_map_free(umap);
+	return umap;
+}
+
+__isl_give isl_union_set *isl_union_set_reserve(__isl_take isl_union_set *uset,
+	int n)
+{
+	return isl_union_map_reserve(uset, n);
+}
+
 struct isl_union_align {
 	isl_reordering *exp;
 	isl_union_map *res;
@@ -337,6 +379,7 @@ __isl_give isl_union_map *isl_union_map_union(__isl_take isl_union_map *umap1,
 	if (!umap1 || !umap2)
 		goto error;
 
+	umap1 = isl_union_map_reserve(umap1, umap1->table.n + umap2->table.n);
 	if (isl_union_map_foreach_map(umap2, &add_map, &umap1) < 0)
 		goto error;
 
@@ -369,6 +412,61 @@ __isl_give isl_union_set *isl_union_set_copy(__isl_keep isl_union_set *uset)
 	return isl_union_map_copy(uset);
 }
 
+/* Internal data structure for isl_union_map_copy_to_ctx.
+ * "ctx" is the context to which the maps are copied and
+ * "res" collects the copies.
+ */
+struct isl_union_map_copy_to_ctx_data {
+	isl_ctx *ctx;
+	isl_union_map *res;
+};
+
+/* Add a copy of the map that "entry" points to in data->ctx
+ * to data->res.
+ */
+static isl_stat copy_map_to_ctx(void **entry, void *user)
+{
+	struct isl_union_map_copy_to_ctx_data *data = user;
+	isl_map *map = *entry;
+
+	data->res = isl_union_map_add_map(data->res,
+					isl_map_copy_to_ctx(map, data->ctx));
+
+	return data->res ? isl_stat_ok : isl_stat_error;
+}
+
+/* Return a copy of "umap" in "ctx".
+ * Unless "umap" already belongs to "ctx", "umap" itself
+ * is not modified, not even its reference count.
+ * The maps are therefore accessed directly through the hash table
+ * rather than through isl_union_map_foreach_map.
+ */
+__isl_give isl_union_map *isl_union_map_copy_to_ctx(
+	__isl_keep isl_union_map *umap, isl_ctx *ctx)
+{
+	struct isl_union_map_copy_to_ctx_data data = { ctx };
+	isl_space *space;
+
+	if (!umap)
+		return NULL;
+	if (isl_union_map_get_ctx(umap) == ctx)
+		return isl_union_map_copy(umap);
+
+	space = isl_space_copy_to_ctx(umap->dim, ctx);
+	data.res = isl_union_map_alloc(space, umap->table.n);
+	if (isl_hash_table_foreach(isl_union_map_get_ctx(umap), &umap->table,
+				    &copy_map_to_ctx, &data) < 0)
+		data.res = isl_union_map_free(data.res);
+
+	return data.res;
+}
+
+__isl_give isl_union_set *isl_union_set_copy_to_ctx(
+	__isl_keep isl_union_set *uset, isl_ctx *ctx)
+{
+	return isl_union_map_copy_to_ctx(uset, ctx);
+}
+
 __isl_null isl_union_map *isl_union_map_free(__isl_take isl_union_map *umap)
 {
 	if (!umap)
@@ -581,6 +679,48 @@ isl_size isl_union_set_n_set(__isl_keep isl_union_set *uset)
 	return uset ? uset->table.n : isl_size_error;
 }
 
+/* Add the estimated cost of the map in "entry" to *user.
+ */
+static isl_stat add_estimated_cost(void **entry, void *user)
+{
+	isl_map *map = *entry;
+	double *cost = user;
+	double c;
+
+	c = isl_map_estimate_cost(map);
+	if (c < 0)
+		return isl_stat_error;
+	*cost += c;
+
+	return isl_stat_ok;
+}
+
+/* Return a cheap estimate of the cost of operating on "umap",
+ * based only on its shape, or a negative value on error.
+ * Since maps in different spaces do not interact,
+ * this is simply the sum of the estimates of the maps.
+ */
+double isl_union_map_estimate_cost(__isl_keep isl_union_map *umap)
+{
+	double cost = 0;
+
+	if (!umap)
+		return -1;
+
+	if (isl_hash_table_foreach(umap->dim->ctx, &umap->table,
+				    &add_estimated_cost, &cost) < 0)
+		return -1;
+
+	return cost;
+}
+
+/* Return a cheap estimate of the cost of operating on "uset".
+ */
+double isl_union_set_estimate_cost(__isl_keep isl_union_set *uset)
+{
+	return isl_union_map_estimate_cost(uset);
+}
+
 isl_stat isl_union_map_foreach_map(__isl_keep isl_union_map *umap,
 	isl_stat (*fn)(__isl_take isl_map *map, void *user), void *user)
 {
@@ -859,22 +999,25 @@ struct isl_union_set_foreach_point_data {
 	void *user;
 };
 
-static isl_stat foreach_point(__isl_take isl_set *set, void *user)
+/* Call data->fn on each point of the set in "entry".
+ */
+static isl_stat foreach_point(void **entry, void *user)
 {
+	isl_set *set = *entry;
 	struct isl_union_set_foreach_point_data *data = user;
-	isl_stat r;
 
-	r = isl_set_foreach_point(set, data->fn, data->user);
-	isl_set_free(set);
-
-	return r;
+	return isl_set_foreach_point(set, data->fn, data->user);
 }
 
 isl_stat isl_union_set_foreach_point(__isl_keep isl_union_set *uset,
 	isl_stat (*fn)(__isl_take isl_point *pnt, void *user), void *user)
 {
 	struct isl_union_set_foreach_point_data data = { fn, user };
-	return isl_union_set_foreach_set(uset, &foreach_point, &data);
+
+	if (!uset)
+		return isl_stat_error;
+	return isl_hash_table_foreach(uset->dim->ctx, &uset->table,
+				      &foreach_point, &data);
 }
 
 /* Data structure that specifies how gen_bin_op should
@@ -1562,43 +1705,232 @@ __isl_give isl_union_map *isl_union_map_intersect_range_factor_range(
 	return gen_bin_op(umap, factor, &control);
 }
 
-struct isl_union_map_bin_data {
-	isl_union_map *umap2;
-	isl_union_map *res;
+/* A description of a number of independent computations on maps
+ * that may be performed by separate threads.
+ * The result of computation "k" is obtained by applying "fn"
+ * to map1[k] or, if "fn2" is set, by applying "fn2" to map1[k] and map2[k].
+ * If "drop_empty" is set, then empty results are replaced by
+ * (obviously empty) maps without any disjuncts.
+ * The input maps are only read.
+ */
+struct isl_union_map_par {
+	isl_map **map1;
+	isl_map **map2;
+	__isl_give isl_map *(*fn)(__isl_take isl_map *map);
+	__isl_give isl_map *(*fn2)(__isl_take isl_map *map1,
+		__isl_take isl_map *map2);
+	int drop_empty;
+};
+
+/* Perform computation "k" of "par" on copies of the input maps
+ * in "ctx" and return the result.
+ */
+static __isl_give isl_map *par_compute(struct isl_union_map_par *par, int k,
+	isl_ctx *ctx)
+{
 	isl_map *map;
-	isl_stat (*fn)(void **entry, void *user);
+	isl_bool empty;
+
+	map = isl_map_copy_to_ctx(par->map1[k], ctx);
+	if (par->fn2)
+		map = par->fn2(map, isl_map_copy_to_ctx(par->map2[k], ctx));
+	else
+		map = par->fn(map);
+	if (!par->drop_empty)
+		return map;
+	empty = isl_map_is_empty(map);
+	if (empty < 0)
+		return isl_map_free(map);
+	if (empty) {
+		isl_space *space = isl_map_get_space(map);
+		isl_map_free(map);
+		map = isl_map_empty(space);
+	}
+	return map;
+}
+
+#define MIN_MAPS_PER_THREAD	2
+
+/* Data used by par_run.
+ * Task "t" performs computation "order[t]" of "par" and
+ * stores the result in the corresponding element of "res".
+ */
+struct isl_union_map_tasks {
+	struct isl_union_map_par *par;
+	int *order;
+	isl_map **res;
 };
 
-static isl_stat apply_range_entry(void **entry, void *user)
+/* Perform the computation of task "t" in "ctx".
+ */
+static isl_stat union_map_task_run(isl_ctx *ctx, int t, void *user)
 {
-	struct isl_union_map_bin_data *data = user;
-	isl_map *map2 = *entry;
-	isl_bool empty, match;
+	struct isl_union_map_tasks *data = user;
+	int k = data->order[t];
 
-	match = isl_map_tuple_is_equal(data->map, isl_dim_out,
-				map2, isl_dim_in);
-	if (match < 0)
-		return isl_stat_error;
-	if (!match)
-		return isl_stat_ok;
+	data->res[k] = par_compute(data->par, k, ctx);
+	return data->res[k] ? isl_stat_ok : isl_stat_error;
+}
 
-	map2 = isl_map_apply_range(isl_map_copy(data->map), isl_map_copy(map2));
+/* Copy the result of task "t" to "ctx".
+ */
+static isl_stat union_map_task_merge(isl_ctx *ctx, int t, void *user)
+{
+	struct isl_union_map_tasks *data = user;
+	int k = data->order[t];
+	isl_map *child = data->res[k];
 
-	empty = isl_map_is_empty(map2);
-	if (empty < 0) {
-		isl_map_free(map2);
+	data->res[k] = isl_map_copy_to_ctx(child, ctx);
+	isl_map_free(child);
+	return data->res[k] ? isl_stat_ok : isl_stat_error;
+}
+
+/* An estimate "weight" of the cost of computation "k".
+ */
+struct isl_union_map_par_weight {
+	int k;
+	int weight;
+};
+
+/* Sort callback for ordering computations by decreasing weight,
+ * breaking ties by position in order to obtain a deterministic order.
+ */
+static int cmp_par_weight(const void *a, const void *b, void *user)
+{
+	const struct isl_union_map_par_weight *wa = a;
+	const struct isl_union_map_par_weight *wb = b;
+
+	if (wa->weight != wb->weight)
+		return wb->weight - wa->weight;
+	return wa->k - wb->k;
+}
+
+/* Return an estimate of the cost of computation "k" of "par",
+ * i.e., the number of disjuncts in the input or
+ * the number of pairs of disjuncts if there are two inputs.
+ */
+static int par_weight(struct isl_union_map_par *par, int k)
+{
+	isl_size n1, n2;
+
+	n1 = isl_map_n_basic_map(par->map1[k]);
+	if (n1 < 1)
+		n1 = 1;
+	if (!par->fn2)
+		return n1;
+	n2 = isl_map_n_basic_map(par->map2[k]);
+	if (n2 < 1)
+		n2 = 1;
+	if (n1 > INT_MAX / n2)
+		return INT_MAX;
+	return n1 * n2;
+}
+
+/* Store the "n" computations of "par" in "order"
+ * in order of decreasing weight.
+ *
+ * Since the tasks are handed out in order to the first thread
+ * that asks for one, this ensures that the expensive computations
+ * get started first, such that a single expensive computation
+ * does not end up being started last.
+ * The results are stored in the position of the computation
+ * and therefore do not depend on the order.
+ */
+static isl_stat par_order(isl_ctx *ctx, struct isl_union_map_par *par, int n,
+	int *order)
+{
+	int k;
+	struct isl_union_map_par_weight *w;
+
+	w = isl_alloc_array(ctx, struct isl_union_map_par_weight, n);
+	if (!w)
 		return isl_stat_error;
+	for (k = 0; k < n; ++k) {
+		w[k].k = k;
+		w[k].weight = par_weight(par, k);
 	}
-	if (empty) {
-		isl_map_free(map2);
+	if (isl_sort(w, n, sizeof(w[0]), &cmp_par_weight, NULL) < 0) {
+		free(w);
+		return isl_stat_error;
+	}
+	for (k = 0; k < n; ++k)
+		order[k] = w[k].k;
+
+	free(w);
+	return isl_stat_ok;
+}
+
+/* Perform the "n" computations of "par" using up to "n_thread" threads,
+ * each in a task of isl_ctx_run_tasks, and store the results
+ * in "res".
+ *
+ * The number of threads is chosen such that there are
+ * at least MIN_MAPS_PER_THREAD computations per thread on average.
+ * If this leaves fewer than two threads, then nothing is computed
+ * and all computations are left for the caller.
+ * Otherwise, the computations are handed out in the order
+ * determined by par_order.
+ */
+static isl_stat par_run(isl_ctx *ctx, struct isl_union_map_par *par, int n,
+	isl_map **res, int n_thread)
+{
+	struct isl_union_map_tasks data = { par, NULL, res };
+	isl_stat r;
+
+	if (n_thread > n / MIN_MAPS_PER_THREAD)
+		n_thread = n / MIN_MAPS_PER_THREAD;
+	if (n_thread < 2)
 		return isl_stat_ok;
+
+	data.order = isl_alloc_array(ctx, int, n);
+	if (!data.order || par_order(ctx, par, n, data.order) < 0) {
+		free(data.order);
+		return isl_stat_error;
 	}
+	r = isl_ctx_run_tasks(ctx, n, n_thread, &union_map_task_run,
+				&union_map_task_merge, &data);
+	free(data.order);
 
-	data->res = isl_union_map_add_map(data->res, map2);
+	return r;
+}
 
+/* Perform the "n" computations of "par" and store the results in "res",
+ * using up to "n_thread" threads if "n_thread" is greater than one.
+ * The computations that were not performed by par_run
+ * are performed by the calling thread.
+ * If anything goes wrong, then the results that have been
+ * computed are freed.
+ */
+static isl_stat par_compute_all(isl_ctx *ctx, struct isl_union_map_par *par,
+	int n, isl_map **res, int n_thread)
+{
+	int k;
+
+	for (k = 0; k < n; ++k)
+		res[k] = NULL;
+	if (n_thread > 1 && par_run(ctx, par, n, res, n_thread) < 0)
+		goto error;
+	for (k = 0; k < n; ++k) {
+		if (res[k])
+			continue;
+		res[k] = par_compute(par, k, ctx);
+		if (!res[k])
+			goto error;
+	}
 	return isl_stat_ok;
+error:
+	for (k = 0; k < n; ++k)
+		res[k] = isl_map_free(res[k]);
+	return isl_stat_error;
 }
 
+struct isl_union_map_bin_data {
+	isl_union_map *umap2;
+	isl_union_map *res;
+	isl_map *map;
+	isl_stat (*fn)(void **entry, void *user);
+};
+
 static isl_stat bin_entry(void **entry, void *user)
 {
 	struct isl_union_map_bin_data *data = user;
@@ -1675,10 +2007,587 @@ isl_union_map_intersect_range_wrapped_domain_union_set(
 	return gen_bin_op(umap, domain, &control);
 }
 
+/* A group of maps in the same union map that all have
+ * the same domain tuples.
+ * "map" contains pointers to the "n" maps in the group,
+ * which are not owned by the group, with room for "size" maps.
+ */
+struct isl_union_map_domain_group {
+	int n;
+	int size;
+	isl_map **map;
+};
+
+/* isl_hash_table_find callback for looking up the group of maps
+ * with the same domain tuples as the map "val".
+ */
+static isl_bool has_domain_tuples(const void *entry, const void *val)
+{
+	const struct isl_union_map_domain_group *group = entry;
+	isl_map *map = (isl_map *) val;
+
+	return isl_map_tuple_is_equal(group->map[0], isl_dim_in,
+				map, isl_dim_in);
+}
+
+/* isl_hash_table_find callback for looking up the group of maps
+ * with domain tuples equal to the range tuples of the map "val".
+ */
+static isl_bool has_domain_tuples_of_range(const void *entry, const void *val)
+{
+	const struct isl_union_map_domain_group *group = entry;
+	isl_map *map = (isl_map *) val;
+
+	return isl_map_tuple_is_equal(group->map[0], isl_dim_in,
+				map, isl_dim_out);
+}
+
+/* isl_hash_table_find callback for looking up the group of maps
+ * with the same range tuples as the map "val".
+ */
+static isl_bool has_range_tuples(const void *entry, const void *val)
+{
+	const struct isl_union_map_domain_group *group = entry;
+	isl_map *map = (isl_map *) val;
+
+	return isl_map_tuple_is_equal(group->map[0], isl_dim_out,
+				map, isl_dim_out);
+}
+
+/* Add "map" to the group that "group_entry" points to,
+ * creating a new group if the entry is still empty.
+ */
+static isl_stat add_to_group(isl_ctx *ctx,
+	struct isl_hash_table_entry *group_entry, __isl_keep isl_map *map)
+{
+	struct isl_union_map_domain_group *group;
+
+	group = group_entry->data;
+	if (!group) {
+		group = isl_calloc_type(ctx, struct isl_union_map_domain_group);
+		if (!group)
+			return isl_stat_error;
+		group->map = isl_alloc_array(ctx, isl_map *, 1);
+		if (!group->map) {
+			free(group);
+			return isl_stat_error;
+		}
+		group->size = 1;
+		group_entry->data = group;
+	} else if (group->n >= group->size) {
+		int size = 2 * group->size;
+		isl_map **list;
+
+		list = isl_realloc_array(ctx, group->map, isl_map *, size);
+		if (!list)
+			return isl_stat_error;
+		group->map = list;
+		group->size = size;
+	}
+	group->map[group->n++] = map;
+
+	return isl_stat_ok;
+}
+
+/* Add the map that "entry" points to to the group in the hash table
+ * "user" with the same domain tuples, creating a new group
+ * if there is no such group yet.
+ */
+static isl_stat add_to_domain_index(void **entry, void *user)
+{
+	struct isl_hash_table *index = user;
+	isl_map *map = *entry;
+	isl_ctx *ctx;
+	uint32_t hash;
+	struct isl_hash_table_entry *group_entry;
+
+	ctx = isl_map_get_ctx(map);
+	hash = isl_space_get_tuple_domain_hash(map->dim);
+	group_entry = isl_hash_table_find(ctx, index, hash,
+					&has_domain_tuples, map, 1);
+	if (!group_entry)
+		return isl_stat_error;
+	return add_to_group(ctx, group_entry, map);
+}
+
+/* Add the map that "entry" points to to the group in the hash table
+ * "user" with the same range tuples, creating a new group
+ * if there is no such group yet.
+ */
+static isl_stat add_to_range_index(void **entry, void *user)
+{
+	struct isl_hash_table *index = user;
+	isl_map *map = *entry;
+	isl_ctx *ctx;
+	uint32_t hash;
+	struct isl_hash_table_entry *group_entry;
+
+	ctx = isl_map_get_ctx(map);
+	hash = isl_space_get_tuple_range_hash(map->dim);
+	group_entry = isl_hash_table_find(ctx, index, hash,
+					&has_range_tuples, map, 1);
+	if (!group_entry)
+		return isl_stat_error;
+	return add_to_group(ctx, group_entry, map);
+}
+
+/* Free the group of maps that "entry" points to.
+ */
+static isl_stat free_domain_group(void **entry, void *user)
+{
+	struct isl_union_map_domain_group *group = *entry;
+
+	free(group->map);
+	free(group);
+
+	return isl_stat_ok;
+}
+
+/* Free the groups in the hash table "index" constructed
+ * by build_domain_index, along with the table itself.
+ */
+static void clear_domain_index(isl_ctx *ctx, struct isl_hash_table *index)
+{
+	isl_hash_table_foreach(ctx, index, &free_domain_group, NULL);
+	isl_hash_table_clear(index);
+}
+
+/* Construct a hash table "index" that groups the maps in "umap"
+ * using "add", which adds a map to the appropriate group.
+ * The maps within each group appear in the same order
+ * as in the hash table of "umap".
+ */
+static isl_stat build_index(isl_ctx *ctx, struct isl_hash_table *index,
+	__isl_keep isl_union_map *umap,
+	isl_stat (*add)(void **entry, void *user))
+{
+	if (isl_hash_table_init(ctx, index, umap->table.n) < 0)
+		return isl_stat_error;
+	if (isl_hash_table_foreach(ctx, &umap->table, add, index) >= 0)
+		return isl_stat_ok;
+	clear_domain_index(ctx, index);
+	return isl_stat_error;
+}
+
+/* Construct a hash table "index" that groups the maps in "umap"
+ * by their domain tuples.
+ */
+static isl_stat build_domain_index(isl_ctx *ctx, struct isl_hash_table *index,
+	__isl_keep isl_union_map *umap)
+{
+	return build_index(ctx, index, umap, &add_to_domain_index);
+}
+
+/* Construct a hash table "index" that groups the maps in "umap"
+ * by their range tuples.
+ */
+static isl_stat build_range_index(isl_ctx *ctx, struct isl_hash_table *index,
+	__isl_keep isl_union_map *umap)
+{
+	return build_index(ctx, index, umap, &add_to_range_index);
+}
+
+/* isl_hash_table_find callback for looking up the group of maps
+ * with range tuples equal to the tuples of the set "val".
+ */
+static isl_bool has_range_tuples_of_set(const void *entry, const void *val)
+{
+	const struct isl_union_map_domain_group *group = entry;
+	isl_set *set = (isl_set *) val;
+
+	return isl_map_tuple_is_equal(group->map[0], isl_dim_out,
+				set_to_map(set), isl_dim_out);
+}
+
+/* Internal data structure for isl_union_map_range_tuples_list.
+ * "index" groups the maps of the input union map by their range tuples.
+ * "res" collects the maps for the current union set.
+ */
+struct isl_union_map_range_tuples_data {
+	struct isl_hash_table *index;
+	isl_union_map *res;
+};
+
+/* Add the maps in data->index with range tuples equal to those of "set"
+ * to data->res.
+ */
+static isl_stat add_range_tuples(__isl_take isl_set *set, void *user)
+{
+	struct isl_union_map_range_tuples_data *data = user;
+	struct isl_hash_table_entry *group_entry;
+	struct isl_union_map_domain_group *group;
+	uint32_t hash;
+	int i;
+
+	hash = isl_space_get_tuple_hash(set->dim);
+	group_entry = isl_hash_table_find(isl_set_get_ctx(set), data->index,
+				hash, &has_range_tuples_of_set, set, 0);
+	isl_set_free(set);
+	if (!group_entry)
+		return isl_stat_error;
+	if (group_entry == isl_hash_table_entry_none)
+		return isl_stat_ok;
+	group = group_entry->data;
+	for (i = 0; i < group->n; ++i)
+		data->res = isl_union_map_add_map(data->res,
+						isl_map_copy(group->map[i]));
+
+	return isl_stat_non_null(data->res);
+}
+
+/* For each union set in "list", construct the union map containing
+ * the maps in "umap" with range tuples that are equal to those
+ * of one of the sets in that union set and
+ * return the list of these union maps.
+ * The maps themselves are not modified.
+ * In particular, intersecting the range of element i of the result
+ * with element i of "list" produces the same result as
+ * intersecting the range of "umap" with element i of "list".
+ *
+ * The maps in "umap" are first grouped by their range tuples
+ * such that the time taken does not depend on the number
+ * of maps in "umap" multiplied by the number of elements of "list".
+ */
+__isl_give isl_union_map_list *isl_union_map_range_tuples_list(
+	__isl_keep isl_union_map *umap, __isl_keep isl_union_set_list *list)
+{
+	int i;
+	isl_size n;
+	isl_ctx *ctx;
+	isl_space *space;
+	struct isl_hash_table index;
+	struct isl_union_map_range_tuples_data data = { &index };
+	isl_union_map_list *res;
+
+	n = isl_union_set_list_size(list);
+	if (!umap || n < 0)
+		return NULL;
+
+	ctx = isl_union_map_get_ctx(umap);
+	if (build_range_index(ctx, &index, umap) < 0)
+		return NULL;
+	space = isl_union_map_get_space(umap);
+	res = isl_union_map_list_alloc(ctx, n);
+	for (i = 0; i < n; ++i) {
+		isl_union_set *uset;
+		isl_stat r;
+
+		uset = isl_union_set_list_get_at(list, i);
+		data.res = isl_union_map_empty(isl_space_copy(space));
+		r = isl_union_set_foreach_set(uset, &add_range_tuples, &data);
+		isl_union_set_free(uset);
+		if (r < 0)
+			data.res = isl_union_map_free(data.res);
+		res = isl_union_map_list_add(res, data.res);
+	}
+	isl_space_free(space);
+	clear_domain_index(ctx, &index);
+
+	return res;
+}
+
+/* Internal data structure for foreach_apply_range_pair.
+ * "index" groups the maps of the second union map by their domain tuples.
+ * "fn" is the function that needs to be called on each pair.
+ */
+struct isl_union_map_apply_range_pair_data {
+	struct isl_hash_table *index;
+	isl_stat (*fn)(__isl_keep isl_map *map1, __isl_keep isl_map *map2,
+		void *user);
+	void *user;
+};
+
+/* Call data->fn on the map that "entry" points to and
+ * each map in data->index with a domain that matches its range.
+ */
+static isl_stat apply_range_pair_entry(void **entry, void *user)
+{
+	struct isl_union_map_apply_range_pair_data *data = user;
+	isl_map *map = *entry;
+	uint32_t hash;
+	struct isl_hash_table_entry *group_entry;
+	struct isl_union_map_domain_group *group;
+	int i;
+
+	hash = isl_space_get_tuple_range_hash(map->dim);
+	group_entry = isl_hash_table_find(isl_map_get_ctx(map), data->index,
+				hash, &has_domain_tuples_of_range, map, 0);
+	if (!group_entry)
+		return isl_stat_error;
+	if (group_entry == isl_hash_table_entry_none)
+		return isl_stat_ok;
+	group = group_entry->data;
+	for (i = 0; i < group->n; ++i)
+		if (data->fn(map, group->map[i], data->user) < 0)
+			return isl_stat_error;
+
+	return isl_stat_ok;
+}
+
+/* Call "fn" on each pair of maps from "umap1" and "umap2"
+ * such that the range of the first matches the domain of the second.
+ *
+ * Rather than comparing every map in "umap1" to every map in "umap2",
+ * the maps in "umap2" are first grouped by their domain tuples
+ * such that each map in "umap1" can look up the matching maps directly.
+ * The pairs are visited in the same order as when iterating
+ * over all pairs of maps in "umap1" and "umap2".
+ */
+static isl_stat foreach_apply_range_pair(__isl_keep isl_union_map *umap1,
+	__isl_keep isl_union_map *umap2,
+	isl_stat (*fn)(__isl_keep isl_map *map1, __isl_keep isl_map *map2,
+		void *user), void *user)
+{
+	isl_ctx *ctx;
+	isl_stat r;
+	struct isl_hash_table index;
+	struct isl_union_map_apply_range_pair_data data = { &index, fn, user };
+
+	if (!umap1 || !umap2)
+		return isl_stat_error;
+
+	ctx = isl_union_map_get_ctx(umap1);
+	if (build_domain_index(ctx, &index, umap2) < 0)
+		return isl_stat_error;
+	r = isl_hash_table_foreach(ctx, &umap1->table,
+				&apply_range_pair_entry, &data);
+	clear_domain_index(ctx, &index);
+
+	return r;
+}
+
+/* Internal data structure for apply_range_pair.
+ * "fn" is applied to each pair of maps and
+ * the result is added to "res".
+ */
+struct isl_union_map_apply_range_data {
+	__isl_give isl_map *(*fn)(__isl_take isl_map *map1,
+		__isl_take isl_map *map2);
+	isl_union_map *res;
+};
+
+/* Apply data->fn to "map1" and "map2" and add the result to data->res,
+ * provided the result is not empty.
+ */
+static isl_stat apply_range_pair(__isl_keep isl_map *map1,
+	__isl_keep isl_map *map2, void *user)
+{
+	struct isl_union_map_apply_range_data *data = user;
+	isl_map *map;
+	isl_bool empty;
+
+	map = data->fn(isl_map_copy(map1), isl_map_copy(map2));
+
+	empty = isl_map_is_empty(map);
+	if (empty < 0 || empty) {
+		isl_map_free(map);
+		return empty < 0 ? isl_stat_error : isl_stat_ok;
+	}
+
+	data->res = isl_union_map_add_map(data->res, map);
+
+	return isl_stat_ok;
+}
+
+/* Internal data structure for collecting the pairs of maps
+ * that need to be composed by apply_range_parallel.
+ * "par" collects the pairs of maps that need to be composed,
+ * with room for "size" pairs, of which "n" are in use.
+ */
+struct isl_union_map_pairs_data {
+	isl_ctx *ctx;
+	struct isl_union_map_par par;
+	int n;
+	int size;
+};
+
+/* Add the pair of "map1" and "map2" to data->par.
+ */
+static isl_stat add_pair(__isl_keep isl_map *map1, __isl_keep isl_map *map2,
+	void *user)
+{
+	struct isl_union_map_pairs_data *data = user;
+
+	if (data->n >= data->size) {
+		int size = 2 * data->size + 8;
+		isl_map **list;
+
+		list = isl_realloc_array(data->ctx, data->par.map1,
+					isl_map *, size);
+		if (!list)
+			return isl_stat_error;
+		data->par.map1 = list;
+		list = isl_realloc_array(data->ctx, data->par.map2,
+					isl_map *, size);
+		if (!list)
+			return isl_stat_error;
+		data->par.map2 = list;
+		data->size = size;
+	}
+	data->par.map1[data->n] = map1;
+	data->par.map2[data->n] = map2;
+	data->n++;
+	return isl_stat_ok;
+}
+
+/* Apply "fn" to each pair of maps in "umap1" and "umap2"
+ * with matching range and domain as in gen_apply_range,
+ * performing the computations on the individual pairs of maps
+ * in up to "n_thread" threads.
+ *
+ * The pairs of maps with matching range and domain are first collected
+ * in the order in which they are handled by gen_apply_range.
+ * The results that are not empty are then added
+ * to the result in the same order.
+ */
+static __isl_give isl_union_map *apply_range_parallel(
+	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2,
+	__isl_give isl_map *(*fn)(__isl_take isl_map *map1,
+		__isl_take isl_map *map2), int n_thread)
+{
+	int k;
+	isl_map **res = NULL;
+	isl_union_map *result = NULL;
+	struct isl_union_map_pairs_data data = { NULL };
+
+	if (!umap1 || !umap2)
+		goto error;
+
+	data.ctx = isl_union_map_get_ctx(umap1);
+	data.par.fn2 = fn;
+	data.par.drop_empty = 1;
+	if (foreach_apply_range_pair(umap1, umap2, &add_pair, &data) < 0)
+		goto error;
+
+	res = isl_alloc_array(data.ctx, isl_map *, data.n);
+	if (data.n && !res)
+		goto error;
+	if (par_compute_all(data.ctx, &data.par, data.n, res, n_thread) < 0)
+		goto error;
+
+	result = isl_union_map_alloc(isl_space_copy(umap1->dim),
+				umap1->table.n);
+	for (k = 0; k < data.n; ++k) {
+		isl_bool empty;
+
+		empty = isl_map_plain_is_empty(res[k]);
+		if (empty < 0 || empty)
+			isl_map_free(res[k]);
+		else
+			result = isl_union_map_add_map(result, res[k]);
+		if (empty < 0)
+			result = isl_union_map_free(result);
+	}
+
+	free(res);
+	free(data.par.map1);
+	free(data.par.map2);
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+	return result;
+error:
+	free(res);
+	free(data.par.map1);
+	free(data.par.map2);
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+	return NULL;
+}
+
+/* Apply "fn" to each pair of maps in "umap1" and "umap2"
+ * such that the range of the first matches the domain of the second
+ * and collect the non-empty results.
+ *
+ * These pairs are found through foreach_apply_range_pair.
+ * If the union_map_threads option is set to a value greater than one,
+ * then the computations on the individual pairs of maps
+ * are performed by apply_range_parallel.
+ */
+static __isl_give isl_union_map *gen_apply_range(
+	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2,
+	__isl_give isl_map *(*fn)(__isl_take isl_map *map1,
+		__isl_take isl_map *map2))
+{
+	int n_thread;
+	struct isl_union_map_apply_range_data data = { fn };
+
+	umap1 = isl_union_map_align_params(umap1, isl_union_map_get_space(umap2));
+	umap2 = isl_union_map_align_params(umap2, isl_union_map_get_space(umap1));
+	if (!umap1 || !umap2)
+		goto error;
+
+	n_thread = isl_options_get_union_map_threads(umap1->dim->ctx);
+	if (n_thread > 1)
+		return apply_range_parallel(umap1, umap2, fn, n_thread);
+
+	data.res = isl_union_map_alloc(isl_space_copy(umap1->dim),
+					umap1->table.n);
+	if (foreach_apply_range_pair(umap1, umap2,
+					&apply_range_pair, &data) < 0)
+		data.res = isl_union_map_free(data.res);
+
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+	return data.res;
+error:
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+	return NULL;
+}
+
+/* Compose "umap1" with "umap2".
+ */
 __isl_give isl_union_map *isl_union_map_apply_range(
 	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2)
 {
-	return bin_op(umap1, umap2, &apply_range_entry);
+	return gen_apply_range(umap1, umap2, &isl_map_apply_range);
+}
+
+/* Compute the domain of the composition of "map1" with "map2",
+ * i.e., the elements of the domain of "map1" that are mapped
+ * to an element of the domain of "map2".
+ * This avoids computing the composition itself.
+ */
+static __isl_give isl_map *map_apply_range_domain(__isl_take isl_map *map1,
+	__isl_take isl_map *map2)
+{
+	map1 = isl_map_intersect_range(map1, isl_map_domain(map2));
+	return set_to_map(isl_map_domain(map1));
+}
+
+/* Compute the range of the composition of "map1" with "map2",
+ * i.e., the image under "map2" of the range of "map1".
+ * This avoids computing the composition itself.
+ */
+static __isl_give isl_map *map_apply_range_range(__isl_take isl_map *map1,
+	__isl_take isl_map *map2)
+{
+	map2 = isl_map_intersect_domain(map2, isl_map_range(map1));
+	return set_to_map(isl_map_range(map2));
+}
+
+/* Compute the domain of the composition of "umap1" with "umap2",
+ * without constructing the composition.
+ * The computation is fused per pair of maps with matching
+ * range and domain, such that only the (typically much smaller)
+ * domains are collected.
+ */
+__isl_give isl_union_set *isl_union_map_apply_range_domain(
+	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2)
+{
+	return gen_apply_range(umap1, umap2, &map_apply_range_domain);
+}
+
+/* Compute the range of the composition of "umap1" with "umap2",
+ * without constructing the composition.
+ * The computation is fused per pair of maps with matching
+ * range and domain, such that only the (typically much smaller)
+ * ranges are collected.
+ */
+__isl_give isl_union_set *isl_union_map_apply_range_range(
+	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2)
+{
+	return gen_apply_range(umap1, umap2, &map_apply_range_range);
 }
 
 __isl_give isl_union_map *isl_union_map_apply_domain(
@@ -1913,10 +2822,14 @@ __isl_give isl_union_map *isl_union_map_flat_range_product(
  * At most one of "fn_map" or "fn_map2" can be set, specifying
  * how the maps (selected by "filter") should be transformed.
  * If "fn_map2" is set, then "fn_map2_user" is passed as the second argument.
+ * If "parallel" is set, then "fn_map" is (relatively) expensive and
+ * may be applied to the maps in separate threads.
+ * This is only allowed if "filter" and "fn_map2" are not set.
  */
 struct isl_un_op_control {
 	int inplace;
 	int total;
+	int parallel;
 	isl_bool (*filter)(__isl_keep isl_map *map, void *user);
 	void *filter_user;
 	__isl_give isl_map *(*fn_map)(__isl_take isl_map *map);
@@ -1994,17 +2907,99 @@ static isl_stat un_entry(void **entry, void *user)
 	return isl_stat_ok;
 }
 
+/* Internal data structure for collecting the entries of a union map
+ * in an array.
+ * "entry" is the array with room for "size" elements,
+ * of which the first "n" are in use.
+ */
+struct isl_union_map_entries {
+	void ***entry;
+	int n;
+	int size;
+};
+
+/* isl_hash_table_foreach callback for collecting the entries
+ * of a union map in an isl_union_map_entries.
+ */
+static isl_stat collect_entry(void **entry, void *user)
+{
+	struct isl_union_map_entries *data = user;
+
+	data->entry[data->n++] = entry;
+	return isl_stat_ok;
+}
+
+/* Modify the maps in "umap" based on "control", for the case
+ * where control->parallel is set, using up to "n_thread" threads.
+ * The results are stored in "res", which may be equal to "umap"
+ * if control->inplace is set.
+ *
+ * The entries are first collected in an array such that
+ * the computations can be performed independently.
+ * The results are then stored in the same order
+ * as they would have been by un_entry.
+ */
+static __isl_give isl_union_map *un_op_parallel(
+	__isl_keep isl_union_map *umap, struct isl_un_op_control *control,
+	__isl_take isl_union_map *res, int n_thread)
+{
+	int k;
+	isl_ctx *ctx;
+	struct isl_union_map_entries data;
+	struct isl_union_map_par par = { NULL, NULL, control->fn_map };
+	isl_map **map;
+
+	ctx = isl_union_map_get_ctx(umap);
+	data.n = 0;
+	data.size = umap->table.n;
+	data.entry = isl_alloc_array(ctx, void **, data.size);
+	map = isl_alloc_array(ctx, isl_map *, 2 * data.size);
+	if ((data.size && (!data.entry || !map)) ||
+	    isl_hash_table_foreach(ctx, &umap->table,
+				    &collect_entry, &data) < 0)
+		goto error;
+
+	for (k = 0; k < data.n; ++k)
+		map[k] = *data.entry[k];
+	par.map1 = map;
+	if (par_compute_all(ctx, &par, data.n, map + data.size, n_thread) < 0)
+		goto error;
+
+	for (k = 0; k < data.n; ++k) {
+		isl_map *map_k = map[data.size + k];
+
+		if (control->inplace) {
+			isl_map_free(*data.entry[k]);
+			*data.entry[k] = map_k;
+		} else {
+			res = isl_union_map_add_map(res, map_k);
+		}
+	}
+
+	free(map);
+	free(data.entry);
+	return res;
+error:
+	free(map);
+	free(data.entry);
+	return isl_union_map_free(res);
+}
+
 /* Modify the maps in "umap" based on "control".
  * If control->inplace is set, then modify the maps in "umap" in-place.
  * Otherwise, create a new union map to hold the results.
  * If control->total is set, then perform an inplace computation
  * if "umap" is only referenced once.  Otherwise, create a new union map
  * to store the results.
+ * If control->parallel is set and the union_map_threads option
+ * is set to a value greater than one, then the maps are handled
+ * by un_op_parallel.
  */
 static __isl_give isl_union_map *un_op(__isl_take isl_union_map *umap,
 	struct isl_un_op_control *control)
 {
 	struct isl_union_map_un_data data = { control };
+	int n_thread;
 
 	if (!umap)
 		return NULL;
@@ -2020,6 +3015,7 @@ static __isl_give isl_union_map *un_op(__isl_take isl_union_map *umap,
 	if (control->total && umap->ref == 1)
 		control->inplace = 1;
 	if (control->inplace) {
+		umap->has_cached_hash = 0;
 		data.res = umap;
 	} else {
 		isl_space *space;
@@ -2027,7 +3023,13 @@ static __isl_give isl_union_map *un_op(__isl_take isl_union_map *umap,
 		space = isl_union_map_get_space(umap);
 		data.res = isl_union_map_alloc(space, umap->table.n);
 	}
-	if (isl_hash_table_foreach(isl_union_map_get_ctx(umap),
+	n_thread = 0;
+	if (control->parallel && control->fn_map && !control->filter &&
+	    !control->fn_map2)
+		n_thread = isl_options_get_union_map_threads(umap->dim->ctx);
+	if (n_thread > 1)
+		data.res = un_op_parallel(umap, control, data.res, n_thread);
+	else if (isl_hash_table_foreach(isl_union_map_get_ctx(umap),
 				    &umap->table, &un_entry, &data) < 0)
 		data.res = isl_union_map_free(data.res);
 
@@ -2073,6 +3075,24 @@ static __isl_give isl_union_map *total(__isl_take isl_union_map *umap,
 	return un_op(umap, &control);
 }
 
+/* Modify the maps in "umap" by applying "fn" on them,
+ * where "fn" is a (relatively) expensive operation that
+ * may be applied in separate threads.
+ * "fn" should apply to all maps in "umap" and should not modify the space.
+ */
+static __isl_give isl_union_map *total_parallel(
+	__isl_take isl_union_map *umap,
+	__isl_give isl_map *(*fn)(__isl_take isl_map *))
+{
+	struct isl_un_op_control control = {
+		.total = 1,
+		.parallel = 1,
+		.fn_map = fn,
+	};
+
+	return un_op(umap, &control);
+}
+
 /* Compute the affine hull of "map" and return the result as an isl_map.
  */
 static __isl_give isl_map *isl_map_affine_hull_map(__isl_take isl_map *map)
@@ -2083,7 +3103,7 @@ static __isl_give isl_map *isl_map_affine_hull_map(__isl_take isl_map *map)
 __isl_give isl_union_map *isl_union_map_affine_hull(
 	__isl_take isl_union_map *umap)
 {
-	return total(umap, &isl_map_affine_hull_map);
+	return total_parallel(umap, &isl_map_affine_hull_map);
 }
 
 __isl_give isl_union_set *isl_union_set_affine_hull(
@@ -2124,7 +3144,7 @@ static __isl_give isl_map *isl_map_polyhedral_hull_map(__isl_take isl_map *map)
 __isl_give isl_union_map *isl_union_map_polyhedral_hull(
 	__isl_take isl_union_map *umap)
 {
-	return total(umap, &isl_map_polyhedral_hull_map);
+	return total_parallel(umap, &isl_map_polyhedral_hull_map);
 }
 
 __isl_give isl_union_set *isl_union_set_polyhedral_hull(
@@ -2145,7 +3165,7 @@ static __isl_give isl_map *isl_map_simple_hull_map(__isl_take isl_map *map)
 __isl_give isl_union_map *isl_union_map_simple_hull(
 	__isl_take isl_union_map *umap)
 {
-	return total(umap, &isl_map_simple_hull_map);
+	return total_parallel(umap, &isl_map_simple_hull_map);
 }
 
 __isl_give isl_union_set *isl_union_set_simple_hull(
@@ -2154,11 +3174,16 @@ __isl_give isl_union_set *isl_union_set_simple_hull(
 	return isl_union_map_simple_hull(uset);
 }
 
+/* Modify the maps in "umap" in place by applying "fn" on them,
+ * possibly in separate threads.
+ * "fn" should not change the meaning of the maps.
+ */
 static __isl_give isl_union_map *inplace(__isl_take isl_union_map *umap,
 	__isl_give isl_map *(*fn)(__isl_take isl_map *))
 {
 	struct isl_un_op_control control = {
 		.inplace = 1,
+		.parallel = 1,
 		.fn_map = fn,
 	};
 
@@ -2222,7 +3247,7 @@ __isl_give isl_union_set *isl_union_set_compute_divs(
 __isl_give isl_union_map *isl_union_map_lexmin(
 	__isl_take isl_union_map *umap)
 {
-	return total(umap, &isl_map_lexmin);
+	return total_parallel(umap, &isl_map_lexmin);
 }
 
 __isl_give isl_union_set *isl_union_set_lexmin(
@@ -2234,7 +3259,7 @@ __isl_give isl_union_set *isl_union_set_lexmin(
 __isl_give isl_union_map *isl_union_map_lexmax(
 	__isl_take isl_union_map *umap)
 {
-	return total(umap, &isl_map_lexmax);
+	return total_parallel(umap, &isl_map_lexmax);
 }
 
 __isl_give isl_union_set *isl_union_set_lexmax(
@@ -2654,6 +3679,51 @@ isl_bool isl_union_set_is_equal(__isl_keep isl_union_set *uset1,
 	return isl_union_map_is_equal(uset1, uset2);
 }
 
+/* Does "umap" (passed as "user") contain a map that is obviously equal
+ * to "map"?
+ */
+static isl_bool has_plain_equal_map(__isl_keep isl_map *map, void *user)
+{
+	isl_union_map *umap = user;
+	struct isl_hash_table_entry *entry;
+
+	entry = isl_union_map_find_entry(umap, map->dim, 0);
+	if (!entry)
+		return isl_bool_error;
+	if (entry == isl_hash_table_entry_none)
+		return isl_bool_false;
+	return isl_map_plain_is_equal(map, entry->data);
+}
+
+/* Are "umap1" and "umap2" obviously equal?
+ * That is, do they live in the same parameter space,
+ * do they contain the same number of maps and
+ * is each map in "umap1" obviously equal to the map
+ * in the same space in "umap2"?
+ *
+ * If the hash values of both union maps have already been computed,
+ * then they can only be obviously equal if these hash values are the same.
+ */
+isl_bool isl_union_map_plain_is_equal(__isl_keep isl_union_map *umap1,
+	__isl_keep isl_union_map *umap2)
+{
+	isl_bool equal;
+
+	if (!umap1 || !umap2)
+		return isl_bool_error;
+	if (umap1 == umap2)
+		return isl_bool_true;
+	if (umap1->table.n != umap2->table.n)
+		return isl_bool_false;
+	if (umap1->has_cached_hash && umap2->has_cached_hash &&
+	    umap1->cached_hash != umap2->cached_hash)
+		return isl_bool_false;
+	equal = isl_space_has_equal_params(umap1->dim, umap2->dim);
+	if (equal < 0 || !equal)
+		return equal;
+	return isl_union_map_every_map(umap1, &has_plain_equal_map, umap2);
+}
+
 isl_bool isl_union_map_is_strict_subset(__isl_keep isl_union_map *umap1,
 	__isl_keep isl_union_map *umap2)
 {
@@ -3858,7 +4928,8 @@ static __isl_give isl_union_map *preimage_union_pw_multi_aff(
 	struct isl_union_map_preimage_upma_data data;
 
 	data.umap = umap;
-	data.res = isl_union_map_empty(isl_union_map_get_space(umap));
+	data.res = isl_union_map_alloc_same_size(
+				isl_union_map_get_space(umap), umap);
 	data.fn = fn;
 	if (isl_union_pw_multi_aff_foreach_pw_multi_aff(upma,
 						    &preimage_upma, &data) < 0)
@@ -4007,7 +5078,7 @@ __isl_give isl_union_map *isl_union_map_project_out(
 
 	space = isl_union_map_get_space(umap);
 	space = isl_space_drop_dims(space, type, first, n);
-	data.res = isl_union_map_empty(space);
+	data.res = isl_union_map_alloc_same_size(space, umap);
 	if (isl_union_map_foreach_map(umap, &project_out, &data) < 0)
 		data.res = isl_union_map_free(data.res);
 
@@ -4126,7 +5197,8 @@ __isl_give isl_union_map *isl_union_map_reset_range_space(
 {
 	struct isl_union_map_reset_range_space_data data = { space };
 
-	data.res = isl_union_map_empty(isl_union_map_get_space(umap));
+	data.res = isl_union_map_alloc_same_size(
+				isl_union_map_get_space(umap), umap);
 	if (isl_union_map_foreach_map(umap, &reset_range_space, &data) < 0)
 		data.res = isl_union_map_free(data.res);
 
@@ -4201,7 +5273,7 @@ __isl_give isl_union_map *isl_union_map_reset_equal_dim_space(
 	if (check_union_map_space_equal_dim(umap, space) < 0)
 		goto error;
 
-	data.res = isl_union_map_empty(isl_space_copy(space));
+	data.res = isl_union_map_alloc_same_size(isl_space_copy(space), umap);
 	if (isl_union_map_foreach_map(umap, &reset_params, &data) < 0)
 		data.res = isl_union_map_free(data.res);
 
@@ -4302,7 +5374,8 @@ static __isl_give isl_union_map *isl_union_map_order_at_multi_union_pw_aff(
 	umap = intersect_explicit_domain(umap, mupa);
 	data.mupa = mupa;
 	data.order = order;
-	data.res = isl_union_map_empty(isl_union_map_get_space(umap));
+	data.res = isl_union_map_alloc_same_size(
+				isl_union_map_get_space(umap), umap);
 	if (isl_union_map_foreach_map(umap, &order_at, &data) < 0)
 		data.res = isl_union_map_free(data.res);
 
@@ -4371,32 +5444,42 @@ error:
 	return NULL;
 }
 
-/* Update *hash with the hash value of "map".
+/* Add the hash value of the map in "entry" to *sum.
  */
-static isl_stat add_hash(__isl_take isl_map *map, void *user)
+static isl_stat add_hash(void **entry, void *user)
 {
-	uint32_t *hash = user;
-	uint32_t map_hash;
+	isl_map *map = *entry;
+	uint32_t *sum = user;
 
-	map_hash = isl_map_get_hash(map);
-	isl_hash_hash(*hash, map_hash);
+	*sum += isl_map_get_hash(map);
 
-	isl_map_free(map);
 	return isl_stat_ok;
 }
 
 /* Return a hash value that digests "umap".
+ *
+ * The hash values of the maps are added up such that the result
+ * does not depend on the order in which the maps happen to be stored.
+ * The result is cached in "umap" until it gets modified.
  */
 uint32_t isl_union_map_get_hash(__isl_keep isl_union_map *umap)
 {
 	uint32_t hash;
+	uint32_t sum = 0;
 
 	if (!umap)
 		return 0;
+	if (umap->has_cached_hash)
+		return umap->cached_hash;
 
-	hash = isl_hash_init();
-	if (isl_union_map_foreach_map(umap, &add_hash, &hash) < 0)
+	if (isl_hash_table_foreach(umap->dim->ctx, &umap->table,
+				    &add_hash, &sum) < 0)
 		return 0;
+	hash = isl_hash_init();
+	isl_hash_hash(hash, sum);
+
+	umap->cached_hash = hash;
+	umap->has_cached_hash = 1;
 
 	return hash;
 }
@@ -4408,16 +5491,16 @@ uint32_t isl_union_set_get_hash(__isl_keep isl_union_set *uset)
 	return isl_union_map_get_hash(uset);
 }
 
-/* Add the number of basic sets in "set" to "n".
+/* Add the number of basic sets in the set in "entry" to "n".
  */
-static isl_stat add_n(__isl_take isl_set *set, void *user)
+static isl_stat add_n(void **entry, void *user)
 {
+	isl_set *set = *entry;
 	int *n = user;
 	isl_size set_n;
 
 	set_n = isl_set_n_basic_set(set);
 	*n += set_n;
-	isl_set_free(set);
 
 	return set_n < 0 ? isl_stat_error : isl_stat_ok;
 }
@@ -4428,7 +5511,10 @@ int isl_union_set_n_basic_set(__isl_keep isl_union_set *uset)
 {
 	int n = 0;
 
-	if (isl_union_set_foreach_set(uset, &add_n, &n) < 0)
+	if (!uset)
+		return -1;
+	if (isl_hash_table_foreach(uset->dim->ctx, &uset->table,
+				    &add_n, &n) < 0)
 		return -1;
 
 	return n;
@@ -3,10 +3,18 @@
 #include <isl/union_map.h>
 #include <isl/union_set.h>
 
+/* "cached_hash" is the hash value of the union map,
+ * which is only valid if "has_cached_hash" is set.
+ * It is computed on demand by isl_union_map_get_hash and
+ * cleared whenever the union map may get modified.
+ */
 struct isl_union_map {
 	int ref;
 	isl_space *dim;
 
+	int has_cached_hash;
+	uint32_t cached_hash;
+
 	struct isl_hash_table	table;
 };
 
@@ -25,3 +33,5 @@ __isl_give isl_union_map *isl_union_map_reset_range_space(
 	__isl_take isl_union_map *umap, __isl_take isl_space *space);
 __isl_give isl_union_map *isl_union_map_reset_equal_dim_space(
 	__isl_take isl_union_map *umap, __isl_take isl_space *space);
+__isl_give isl_union_map_list *isl_union_map_range_tuples_list(
+	__isl_keep isl_union_map *umap, __isl_keep isl_union_set_list *list);
@@ -9,6 +9,7 @@
 
 #include <isl_int.h>
 #include <isl_ctx_private.h>
+#include <isl_options_private.h>
 #include <isl_val_private.h>
 
 #undef EL_BASE
@@ -18,20 +19,32 @@
 #include <isl_list_read_templ.c>
 
 /* Allocate an isl_val object with indeterminate value.
+ *
+ * Reuse a previously freed object from the cache of "ctx", if any.
+ * The numerator and denominator of such an object are still initialized
+ * and may have memory allocated to them that can then also be reused.
  */
 __isl_give isl_val *isl_val_alloc(isl_ctx *ctx)
 {
 	isl_val *v;
 
-	v = isl_alloc_type(ctx, struct isl_val);
-	if (!v)
+	if (!ctx)
 		return NULL;
+	if (ctx->n_val_cached > 0) {
+		ctx->n_val_hit++;
+		v = ctx->val_cache[--ctx->n_val_cached];
+	} else {
+		ctx->n_val_miss++;
+		v = isl_alloc_type(ctx, struct isl_val);
+		if (!v)
+			return NULL;
+		isl_int_init(v->n);
+		isl_int_init(v->d);
+	}
 
 	v->ctx = ctx;
 	isl_ctx_ref(ctx);
 	v->ref = 1;
-	isl_int_init(v->n);
-	isl_int_init(v->d);
 
 	return v;
 }
@@ -244,6 +257,29 @@ __isl_give isl_val *isl_val_dup(__isl_keep isl_val *val)
 	return dup;
 }
 
+/* Return a copy of "val" in "ctx".
+ * Unless "val" already belongs to "ctx", "val" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_val *isl_val_copy_to_ctx(__isl_keep isl_val *val, isl_ctx *ctx)
+{
+	isl_val *dup;
+
+	if (!val)
+		return NULL;
+	if (val->ctx == ctx)
+		return isl_val_copy(val);
+
+	dup = isl_val_alloc(ctx);
+	if (!dup)
+		return NULL;
+
+	isl_int_set(dup->n, val->n);
+	isl_int_set(dup->d, val->d);
+
+	return dup;
+}
+
 /* Return an isl_val that is equal to "val" and that has only
  * a single reference.
  */
@@ -259,6 +295,8 @@ __isl_give isl_val *isl_val_cow(__isl_take isl_val *val)
 }
 
 /* Free "v" and return NULL.
+ * The object is kept around for later reuse,
+ * unless the cache is full or the memory_lean option is set.
  */
 __isl_null isl_val *isl_val_free(__isl_take isl_val *v)
 {
@@ -269,12 +307,33 @@ __isl_null isl_val *isl_val_free(__isl_take isl_val *v)
 		return NULL;
 
 	isl_ctx_deref(v->ctx);
+	if (!v->ctx->opt->memory_lean &&
+	    v->ctx->n_val_cached < ISL_VAL_CACHE_SIZE) {
+		v->ctx->val_cache[v->ctx->n_val_cached++] = v;
+		return NULL;
+	}
 	isl_int_clear(v->n);
 	isl_int_clear(v->d);
 	free(v);
 	return NULL;
 }
 
+/* Free all isl_val objects in the cache of "ctx".
+ */
+void isl_val_clear_cache(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ctx->n_val_cached; ++i) {
+		isl_val *v = ctx->val_cache[i];
+
+		isl_int_clear(v->n);
+		isl_int_clear(v->d);
+		free(v);
+	}
+	ctx->n_val_cached = 0;
+}
+
 /* Extract the numerator of a rational value "v" as an integer.
  *
  * If "v" is not a rational value, then the result is undefined.
@@ -621,12 +680,38 @@ error:
 	return NULL;
 }
 
+/* Should the result of an operation on the integer values "v1" and "v2"
+ * be stored in "v2" rather than in "v1"?
+ * This is the case if "v1" is shared and "v2" is not,
+ * such that no new isl_val needs to be allocated.
+ */
+static int int_result_in_second(__isl_keep isl_val *v1,
+	__isl_keep isl_val *v2)
+{
+	return v1->ref != 1 && v2->ref == 1;
+}
+
 /* Return the sum of "v1" and "v2".
+ *
+ * The common case of two integer values is handled first.
  */
 __isl_give isl_val *isl_val_add(__isl_take isl_val *v1, __isl_take isl_val *v2)
 {
 	if (!v1 || !v2)
 		goto error;
+	if (isl_val_is_int(v1) && isl_val_is_int(v2)) {
+		if (int_result_in_second(v1, v2)) {
+			isl_int_add(v2->n, v1->n, v2->n);
+			isl_val_free(v1);
+			return v2;
+		}
+		v1 = isl_val_cow(v1);
+		if (!v1)
+			goto error;
+		isl_int_add(v1->n, v1->n, v2->n);
+		isl_val_free(v2);
+		return v1;
+	}
 	if (isl_val_is_nan(v1)) {
 		isl_val_free(v2);
 		return v1;
@@ -700,11 +785,26 @@ __isl_give isl_val *isl_val_add_ui(__isl_take isl_val *v1, unsigned long v2)
 }
 
 /* Subtract "v2" from "v1".
+ *
+ * The common case of two integer values is handled first.
  */
 __isl_give isl_val *isl_val_sub(__isl_take isl_val *v1, __isl_take isl_val *v2)
 {
 	if (!v1 || !v2)
 		goto error;
+	if (isl_val_is_int(v1) && isl_val_is_int(v2)) {
+		if (int_result_in_second(v1, v2)) {
+			isl_int_sub(v2->n, v1->n, v2->n);
+			isl_val_free(v1);
+			return v2;
+		}
+		v1 = isl_val_cow(v1);
+		if (!v1)
+			goto error;
+		isl_int_sub(v1->n, v1->n, v2->n);
+		isl_val_free(v2);
+		return v1;
+	}
 	if (isl_val_is_nan(v1)) {
 		isl_val_free(v2);
 		return v1;
@@ -778,11 +878,26 @@ __isl_give isl_val *isl_val_sub_ui(__isl_take isl_val *v1, unsigned long v2)
 }
 
 /* Return the product of "v1" and "v2".
+ *
+ * The common case of two integer values is handled first.
  */
 __isl_give isl_val *isl_val_mul(__isl_take isl_val *v1, __isl_take isl_val *v2)
 {
 	if (!v1 || !v2)
 		goto error;
+	if (isl_val_is_int(v1) && isl_val_is_int(v2)) {
+		if (int_result_in_second(v1, v2)) {
+			isl_int_mul(v2->n, v1->n, v2->n);
+			isl_val_free(v1);
+			return v2;
+		}
+		v1 = isl_val_cow(v1);
+		if (!v1)
+			goto error;
+		isl_int_mul(v1->n, v1->n, v2->n);
+		isl_val_free(v2);
+		return v1;
+	}
 	if (isl_val_is_nan(v1)) {
 		isl_val_free(v2);
 		return v1;
@@ -1046,7 +1161,7 @@ error:
 
 /* Compute x, y and g such that g = gcd(a,b) and a*x+b*y = g.
  */
-static void isl_int_gcdext(isl_int *g, isl_int *x, isl_int *y,
+void isl_int_gcdext(isl_int *g, isl_int *x, isl_int *y,
 	isl_int a, isl_int b)
 {
 	isl_int d, tmp;
@@ -1589,6 +1704,30 @@ __isl_give isl_val *isl_val_zero_on_domain(__isl_take isl_local_space *ls)
 #include <isl_multi_tuple_id_templ.c>
 #include <isl_multi_zero_templ.c>
 
+/* Return a copy of "mv" in "ctx".
+ * Unless "mv" already belongs to "ctx", "mv" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_multi_val *isl_multi_val_copy_to_ctx(
+	__isl_keep isl_multi_val *mv, isl_ctx *ctx)
+{
+	int i;
+	isl_space *space;
+	isl_multi_val *dup;
+
+	if (!mv)
+		return NULL;
+	if (isl_multi_val_get_ctx(mv) == ctx)
+		return isl_multi_val_copy(mv);
+
+	space = isl_space_copy_to_ctx(isl_multi_val_peek_space(mv), ctx);
+	dup = isl_multi_val_alloc(space);
+	for (i = 0; i < mv->n; ++i)
+		dup = isl_multi_val_set_at(dup, i,
+				    isl_val_copy_to_ctx(mv->u.p[i], ctx));
+	return dup;
+}
+
 /* Does "mv" consist of only zeros?
  */
 isl_bool isl_multi_val_is_zero(__isl_keep isl_multi_val *mv)
@@ -216,6 +216,25 @@ __isl_give isl_vec *isl_vec_dup(__isl_keep isl_vec *vec)
 	return vec2;
 }
 
+/* Return a copy of "vec" in "ctx".
+ * Unless "vec" already belongs to "ctx", "vec" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_vec *isl_vec_copy_to_ctx(__isl_keep isl_vec *vec, isl_ctx *ctx)
+{
+	struct isl_vec *vec2;
+
+	if (!vec)
+		return NULL;
+	if (vec->ctx == ctx)
+		return isl_vec_copy(vec);
+	vec2 = isl_vec_alloc(ctx, vec->size);
+	if (!vec2)
+		return NULL;
+	isl_seq_cpy(vec2->el, vec->el, vec->size);
+	return vec2;
+}
+
 __isl_give isl_vec *isl_vec_cow(__isl_take isl_vec *vec)
 {
 	struct isl_vec *vec2;
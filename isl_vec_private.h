@@ -18,6 +18,7 @@ struct isl_vec {
 uint32_t isl_vec_get_hash(__isl_keep isl_vec *vec);
 
 __isl_give isl_vec *isl_vec_cow(__isl_take isl_vec *vec);
+__isl_give isl_vec *isl_vec_copy_to_ctx(__isl_keep isl_vec *vec, isl_ctx *ctx);
 
 void isl_vec_lcm(__isl_keep isl_vec *vec, isl_int *lcm);
 __isl_give isl_vec *isl_vec_set(__isl_take isl_vec *vec, isl_int v);
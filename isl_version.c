@@ -9,9 +9,9 @@ const char *isl_version(void)
 #endif
 #ifdef USE_IMATH_FOR_MP
 	"-IMath"
+#endif
 #ifdef USE_SMALL_INT_OPT
 	"-32"
-#endif
 #endif
 	"\n";
 }
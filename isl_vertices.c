@@ -35,6 +35,63 @@ __isl_give isl_vertices *isl_vertices_copy(__isl_keep isl_vertices *vertices)
 	return vertices;
 }
 
+/* Return a copy of "vertices" in "ctx".
+ * Unless "vertices" already belongs to "ctx", "vertices" itself
+ * is not modified, not even its reference count.
+ */
+__isl_give isl_vertices *isl_vertices_copy_to_ctx(
+	__isl_keep isl_vertices *vertices, isl_ctx *ctx)
+{
+	int i;
+	isl_vertices *dup;
+
+	if (!vertices)
+		return NULL;
+	if (isl_vertices_get_ctx(vertices) == ctx)
+		return isl_vertices_copy(vertices);
+
+	dup = isl_calloc_type(ctx, isl_vertices);
+	if (!dup)
+		return NULL;
+	dup->ref = 1;
+	dup->bset = isl_basic_set_copy_to_ctx(vertices->bset, ctx);
+	dup->v = isl_calloc_array(ctx, struct isl_vertex, vertices->n_vertices);
+	if (!dup->bset || (vertices->n_vertices && !dup->v))
+		return isl_vertices_free(dup);
+	dup->n_vertices = vertices->n_vertices;
+	for (i = 0; i < vertices->n_vertices; ++i) {
+		struct isl_vertex *v = &vertices->v[i];
+
+		if (v->dom) {
+			dup->v[i].dom = isl_basic_set_copy_to_ctx(v->dom, ctx);
+			if (!dup->v[i].dom)
+				return isl_vertices_free(dup);
+		}
+		dup->v[i].vertex = isl_basic_set_copy_to_ctx(v->vertex, ctx);
+		if (!dup->v[i].vertex)
+			return isl_vertices_free(dup);
+	}
+	dup->c = isl_calloc_array(ctx, struct isl_chamber,
+				vertices->n_chambers);
+	if (vertices->n_chambers && !dup->c)
+		return isl_vertices_free(dup);
+	dup->n_chambers = vertices->n_chambers;
+	for (i = 0; i < vertices->n_chambers; ++i) {
+		struct isl_chamber *c = &vertices->c[i];
+
+		dup->c[i].n_vertices = c->n_vertices;
+		dup->c[i].vertices = isl_alloc_array(ctx, int, c->n_vertices);
+		dup->c[i].dom = isl_basic_set_copy_to_ctx(c->dom, ctx);
+		if ((c->n_vertices && !dup->c[i].vertices) || !dup->c[i].dom)
+			return isl_vertices_free(dup);
+		if (c->n_vertices)
+			memcpy(dup->c[i].vertices, c->vertices,
+				c->n_vertices * sizeof(int));
+	}
+
+	return dup;
+}
+
 __isl_null isl_vertices *isl_vertices_free(__isl_take isl_vertices *vertices)
 {
 	int i;
@@ -547,6 +604,178 @@ error:
 	return NULL;
 }
 
+/* Is "bset" known to be full-dimensional?
+ * That is, is it non-empty and does it not have any
+ * (implicit) equality constraints?
+ */
+static isl_bool is_full_dim(__isl_keep isl_basic_set *bset)
+{
+	isl_size n_eq;
+
+	bset = isl_basic_set_detect_equalities(isl_basic_set_copy(bset));
+	n_eq = isl_basic_set_n_equality(bset);
+	isl_basic_set_free(bset);
+	if (n_eq < 0)
+		return isl_bool_error;
+	return isl_bool_ok(n_eq == 0);
+}
+
+/* Given the parametric vertices and chamber decomposition "vertices"
+ * of a full-dimensional parametric polytope P that was computed
+ * by isl_basic_set_compute_vertices, update them to those of
+ * the intersection of P with the parameter domain "context",
+ * provided this intersection is also full-dimensional.
+ *
+ * The constraints of "context" do not involve any set variables,
+ * so they cannot contribute to the definition of any vertex.
+ * The vertices of the intersection are therefore those vertices of P
+ * that have a full-dimensional activity domain within "context".
+ * Similarly, the chambers are the full-dimensional intersections
+ * of the chambers of P with "context".
+ * A vertex is active on such an intersection if and only if
+ * it is active on the original chamber.
+ * As in compute_chambers, the activity domains of the vertices
+ * are not stored in the result.  They are recomputed on demand
+ * by isl_vertex_get_domain.
+ *
+ * "bset" is the intersection of P with "context".
+ * Store the result in *res and return isl_bool_true on success.
+ * Return isl_bool_false if the intersection is not full-dimensional or
+ * if "vertices" has not been computed in the general way.
+ * The caller then needs to fall back to a computation from scratch.
+ */
+static isl_bool intersect_params_full(__isl_keep isl_vertices *vertices,
+	__isl_keep isl_basic_set *context, __isl_keep isl_basic_set *bset,
+	isl_vertices **res_p)
+{
+	int i, j;
+	int *pos;
+	isl_ctx *ctx;
+	isl_bool full;
+	isl_vertices *res;
+
+	if (vertices->bset->n_eq != 0 || vertices->n_chambers == 0)
+		return isl_bool_false;
+	full = is_full_dim(bset);
+	if (full < 0 || !full)
+		return full;
+
+	ctx = isl_basic_set_get_ctx(bset);
+	res = isl_calloc_type(ctx, isl_vertices);
+	pos = isl_alloc_array(ctx, int, vertices->n_vertices);
+	if (!res || (vertices->n_vertices && !pos))
+		goto error;
+	res->ref = 1;
+	res->bset = isl_basic_set_copy(bset);
+	res->v = isl_calloc_array(ctx, struct isl_vertex,
+				vertices->n_vertices);
+	res->c = isl_calloc_array(ctx, struct isl_chamber,
+				vertices->n_chambers);
+	if ((vertices->n_vertices && !res->v) ||
+	    (vertices->n_chambers && !res->c))
+		goto error;
+
+	for (i = 0; i < vertices->n_vertices; ++i) {
+		isl_basic_set *vertex, *dom;
+
+		pos[i] = -1;
+		vertex = isl_basic_set_copy(vertices->v[i].vertex);
+		vertex = isl_basic_set_intersect_params(vertex,
+						isl_basic_set_copy(context));
+		dom = isl_basic_set_params(isl_basic_set_copy(vertex));
+		full = is_full_dim(dom);
+		isl_basic_set_free(dom);
+		if (full < 0 || !full) {
+			isl_basic_set_free(vertex);
+			if (full < 0)
+				goto error;
+			continue;
+		}
+		pos[i] = res->n_vertices;
+		res->v[res->n_vertices++].vertex = vertex;
+	}
+
+	for (i = 0; i < vertices->n_chambers; ++i) {
+		struct isl_chamber *c = &vertices->c[i];
+		struct isl_chamber *c_res = &res->c[res->n_chambers];
+		isl_basic_set *dom;
+
+		dom = isl_basic_set_copy(c->dom);
+		dom = isl_basic_set_intersect(dom, isl_basic_set_copy(context));
+		full = is_full_dim(dom);
+		if (full < 0 || !full) {
+			isl_basic_set_free(dom);
+			if (full < 0)
+				goto error;
+			continue;
+		}
+		c_res->dom = dom;
+		c_res->vertices = isl_alloc_array(ctx, int, c->n_vertices);
+		res->n_chambers++;
+		if (c->n_vertices && !c_res->vertices)
+			goto error;
+		for (j = 0; j < c->n_vertices; ++j) {
+			int v = pos[c->vertices[j]];
+			if (v < 0)
+				isl_die(ctx, isl_error_internal,
+					"inactive vertex in chamber",
+					goto error);
+			c_res->vertices[c_res->n_vertices++] = v;
+		}
+	}
+
+	free(pos);
+	*res_p = res;
+	return isl_bool_true;
+error:
+	free(pos);
+	isl_vertices_free(res);
+	return isl_bool_error;
+}
+
+/* Given the parametric vertices and chamber decomposition "vertices"
+ * of a parametric polytope P, compute those of the intersection of P
+ * with the parameter domain "context".
+ *
+ * If possible, the result is derived from "vertices"
+ * by intersect_params_full.  Otherwise, it is computed from scratch.
+ * In the first case, the chamber decomposition may differ
+ * from the one that would be computed from scratch,
+ * but it is an equally valid decomposition.
+ * "context" is assumed not to have any existentially quantified variables.
+ */
+__isl_give isl_vertices *isl_vertices_intersect_params(
+	__isl_take isl_vertices *vertices, __isl_take isl_basic_set *context)
+{
+	isl_basic_set *bset;
+	isl_vertices *res = NULL;
+	isl_bool full;
+
+	if (!vertices || !context)
+		goto error;
+	if (isl_basic_set_check_no_locals(context) < 0)
+		goto error;
+
+	bset = isl_basic_set_copy(vertices->bset);
+	bset = isl_basic_set_intersect_params(bset,
+					isl_basic_set_copy(context));
+	bset = isl_basic_set_set_rational(bset);
+	if (!bset)
+		goto error;
+	full = intersect_params_full(vertices, context, bset, &res);
+	if (full == isl_bool_false)
+		res = isl_basic_set_compute_vertices(bset);
+
+	isl_basic_set_free(bset);
+	isl_basic_set_free(context);
+	isl_vertices_free(vertices);
+	return res;
+error:
+	isl_vertices_free(vertices);
+	isl_basic_set_free(context);
+	return NULL;
+}
+
 struct isl_chamber_list {
 	struct isl_chamber c;
 	struct isl_chamber_list *next;
@@ -1157,6 +1386,39 @@ error:
 	return NULL;
 }
 
+/* Return a copy of "cell" that refers to "vertices",
+ * a copy of the vertices of "cell" in a possibly different context,
+ * in the context of "vertices".
+ * "cell" itself is not modified.
+ */
+__isl_give isl_cell *isl_cell_copy_to_vertices(__isl_keep isl_cell *cell,
+	__isl_take isl_vertices *vertices)
+{
+	isl_ctx *ctx;
+	isl_cell *dup;
+
+	if (!cell || !vertices)
+		goto error;
+
+	ctx = isl_vertices_get_ctx(vertices);
+	dup = isl_calloc_type(ctx, isl_cell);
+	if (!dup)
+		goto error;
+	dup->vertices = vertices;
+	dup->n_vertices = cell->n_vertices;
+	dup->ids = isl_alloc_array(ctx, int, cell->n_vertices);
+	dup->dom = isl_basic_set_copy_to_ctx(cell->dom, ctx);
+	if ((cell->n_vertices && !dup->ids) || !dup->dom)
+		return isl_cell_free(dup);
+	if (cell->n_vertices)
+		memcpy(dup->ids, cell->ids, cell->n_vertices * sizeof(int));
+
+	return dup;
+error:
+	isl_vertices_free(vertices);
+	return NULL;
+}
+
 __isl_null isl_cell *isl_cell_free(__isl_take isl_cell *cell)
 {
 	if (!cell)
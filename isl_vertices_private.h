@@ -56,6 +56,12 @@ struct isl_external_vertex {
 	int id;
 };
 
+__isl_give isl_vertices *isl_vertices_copy(__isl_keep isl_vertices *vertices);
+__isl_give isl_vertices *isl_vertices_copy_to_ctx(
+	__isl_keep isl_vertices *vertices, isl_ctx *ctx);
+__isl_give isl_cell *isl_cell_copy_to_vertices(__isl_keep isl_cell *cell,
+	__isl_take isl_vertices *vertices);
+
 isl_stat isl_vertices_foreach_disjoint_cell(__isl_keep isl_vertices *vertices,
 	isl_stat (*fn)(__isl_take isl_cell *cell, void *user), void *user);
 isl_stat isl_cell_foreach_simplex(__isl_take isl_cell *cell,
@@ -71,6 +71,22 @@ class IslPrintCommand (gdb.Command):
 
 IslPrintCommand()
 
+class IslStatsCommand (gdb.Command):
+	"""Print the statistics of an isl_ctx in JSON format."""
+	def __init__ (self):
+		super (IslStatsCommand, self).__init__ ("islstats",
+							gdb.COMMAND_OBSCURE)
+	def invoke (self, arg, from_tty):
+		ctx = gdb.parse_and_eval(arg)
+		void_ptr = gdb.lookup_type('void').pointer()
+		value = str(ctx.cast(void_ptr))
+		string = gdb.parse_and_eval("(char*)isl_ctx_stats_to_json_str("
+					    + value + ")")
+		print(string.string())
+		gdb.parse_and_eval("free((void *) " + str(int(string)) + ")")
+
+IslStatsCommand()
+
 def str_lookup_function (val):
 	if val.type.code != gdb.TYPE_CODE_PTR:
 		if str(val.type) == "isl_int":
@@ -8,6 +8,7 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <isl_map_private.h>
 #include <isl/aff.h>
@@ -22,6 +23,8 @@
 #include <isl/options.h>
 #include <isl_config.h>
 
+#include "batch.h"
+
 /* The input of this program is the same as that of the "example" program
  * from the PipLib distribution, except that the "big parameter column"
  * should always be -1.
@@ -36,12 +39,18 @@
  *	Rational	compute rational optimum instead of integer optimum
  *	Urs_parms	don't assume parameters are non-negative
  *	Urs_unknowns	don't assume unknowns are non-negative
+ *
+ * The input is read from stdin, unless one or more file names
+ * are specified on the command line, in which case each file
+ * is treated as a separate problem.  See batch.c.
  */
 
 struct options {
 	struct isl_options	*isl;
 	unsigned		 verify;
 	unsigned		 format;
+	int			 threads;
+	int			 time;
 };
 
 #define FORMAT_SET	0
@@ -58,6 +67,10 @@ ISL_ARG_CHILD(struct options, isl, "isl", &isl_options_args, "isl options")
 ISL_ARG_BOOL(struct options, verify, 'T', "verify", 0, NULL)
 ISL_ARG_CHOICE(struct options, format, 0, "format",
 	pip_format, FORMAT_SET, "output format")
+ISL_ARG_INT(struct options, threads, 0, "threads", "n", 1,
+	"number of threads over which to distribute the input files")
+ISL_ARG_BOOL(struct options, time, 0, "time", 0,
+	"print the time taken by each input file on stderr")
 ISL_ARGS_END
 
 ISL_ARG_DEF(options, struct options, options_args)
@@ -245,6 +258,7 @@ struct isl_scan_pip {
 	int stride;
 	int n;
 	int max;
+	FILE *out;
 };
 
 /* Check if the "manually" computed optimum of bset at the "sample"
@@ -283,15 +297,15 @@ static isl_stat scan_one(struct isl_scan_callback *callback,
 	}
 
 	if (!(sp->n % sp->stride)) {
-		printf("o");
-		fflush(stdout);
+		fprintf(sp->out, "o");
+		fflush(sp->out);
 	}
 
 	return sp->n >= 1 ? isl_stat_ok : isl_stat_error;
 }
 
 static void check_solution(isl_basic_set *bset, isl_basic_set *context,
-	isl_set *sol, isl_set *empty, int max)
+	isl_set *sol, isl_set *empty, int max, FILE *out)
 {
 	struct isl_scan_pip sp;
 	isl_int count, count_max;
@@ -319,22 +333,28 @@ static void check_solution(isl_basic_set *bset, isl_basic_set *context,
 	sp.n = n;
 	sp.stride = n > 70 ? 1 + (n + 1)/70 : 1;
 	sp.max = max;
+	sp.out = out;
 
 	for (i = 0; i < n; i += sp.stride)
-		printf(".");
-	printf("\r");
-	fflush(stdout);
+		fprintf(out, ".");
+	fprintf(out, "\r");
+	fflush(out);
 
 	isl_basic_set_scan(context, &sp.callback);
 
-	printf("\n");
+	fprintf(out, "\n");
 
 	isl_basic_set_free(bset);
 }
 
-int main(int argc, char **argv)
+/* Read a single problem from "in", solve it and print the result
+ * on "out" or, if options->verify is set, check the result and
+ * print the progress of the check on "out".
+ * Return 0 on success.
+ */
+static int pip(isl_ctx *ctx, FILE *in, FILE *out, void *user)
 {
-	struct isl_ctx *ctx;
+	struct options *options = user;
 	struct isl_basic_set *context, *bset, *copy, *context_copy;
 	struct isl_set *set = NULL;
 	struct isl_set *empty;
@@ -346,22 +366,15 @@ int main(int argc, char **argv)
 	int max = 0;
 	int rational = 0;
 	int n;
-	struct options *options;
 
-	options = options_new_with_defaults();
-	assert(options);
-	argc = options_parse(options, argc, argv, ISL_ARG_ALL);
-
-	ctx = isl_ctx_alloc_with_options(&options_args, options);
-
-	context = isl_basic_set_read_from_file(ctx, stdin);
+	context = isl_basic_set_read_from_file(ctx, in);
 	assert(context);
-	n = fscanf(stdin, "%d", &neg_one);
+	n = fscanf(in, "%d", &neg_one);
 	assert(n == 1);
 	assert(neg_one == -1);
-	bset = isl_basic_set_read_from_file(ctx, stdin);
+	bset = isl_basic_set_read_from_file(ctx, in);
 
-	while (fgets(s, sizeof(s), stdin)) {
+	while (fgets(s, sizeof(s), in)) {
 		if (strncasecmp(s, "Maximize", 8) == 0)
 			max = 1;
 		if (strncasecmp(s, "Rational", 8) == 0) {
@@ -407,11 +420,11 @@ int main(int argc, char **argv)
 		assert(!rational);
 		if (options->format == FORMAT_AFF)
 			set = isl_set_from_pw_multi_aff(pma);
-		check_solution(copy, context_copy, set, empty, max);
+		check_solution(copy, context_copy, set, empty, max, out);
 		isl_set_free(set);
 	} else {
 		isl_printer *p;
-		p = isl_printer_to_file(ctx, stdout);
+		p = isl_printer_to_file(ctx, out);
 		if (options->format == FORMAT_AFF)
 			p = isl_printer_print_pw_multi_aff(p, pma);
 		else
@@ -426,7 +439,31 @@ int main(int argc, char **argv)
 	}
 
 	isl_set_free(empty);
-	isl_ctx_free(ctx);
 
 	return 0;
 }
+
+int main(int argc, char **argv)
+{
+	struct isl_ctx *ctx;
+	struct options *options;
+	int r;
+
+	options = options_new_with_defaults();
+	assert(options);
+	argc = options_parse(options, argc, argv, 0);
+
+	ctx = isl_ctx_alloc_with_options(&options_args, options);
+
+	if (batch_check_args(argc, argv) < 0) {
+		isl_ctx_free(ctx);
+		return EXIT_FAILURE;
+	}
+
+	r = batch_process(ctx, argc - 1, argv + 1, options->threads,
+			options->time, &pip, options);
+
+	isl_ctx_free(ctx);
+
+	return r < 0 ? EXIT_FAILURE : 0;
+}
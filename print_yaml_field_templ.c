@@ -1,3 +1,5 @@
+#include <isl_printer_private.h>
+
 #define xCAT(A,B) A ## B
 #define CAT(A,B) xCAT(A,B)
 #undef TYPE
@@ -7,15 +9,31 @@
 
 /* Print a key-value pair of a YAML mapping to "p",
  * with key "name" and value "val".
+ *
+ * If "p" replaces repeated values by aliases, then the value
+ * is first printed to a separate string such that it can be compared
+ * to earlier values.
  */
 static __isl_give isl_printer *FN(print_yaml_field,BASE)(
 	__isl_take isl_printer *p, const char *name, __isl_keep TYPE *val)
 {
 	p = isl_printer_print_str(p, name);
 	p = isl_printer_yaml_next(p);
-	p = isl_printer_print_str(p, "\"");
-	p = FN(isl_printer_print,BASE)(p, val);
-	p = isl_printer_print_str(p, "\"");
+	if (isl_printer_get_yaml_anchors(p) > 0) {
+		isl_printer *p_str;
+		char *str;
+
+		p_str = isl_printer_to_str(isl_printer_get_ctx(p));
+		p_str = FN(isl_printer_print,BASE)(p_str, val);
+		str = isl_printer_get_str(p_str);
+		isl_printer_free(p_str);
+		p = isl_printer_yaml_print_anchored_str(p, str);
+		free(str);
+	} else {
+		p = isl_printer_print_str(p, "\"");
+		p = FN(isl_printer_print,BASE)(p, val);
+		p = isl_printer_print_str(p, "\"");
+	}
 	p = isl_printer_yaml_next(p);
 
 	return p;
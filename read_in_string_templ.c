@@ -10,8 +10,9 @@
 /* Read an object of type TYPE from "s", where the object may
  * either be specified directly or as a string.
  *
- * First check if the next token in "s" is a string.  If so, try and
- * extract the object from the string.
+ * First check if the next token in "s" is a string,
+ * possibly preceded by a YAML anchor ("&"), or a YAML alias ("*").
+ * If so, try and extract the object from the (referenced) string.
  * Otherwise, try and read the object directly from "s".
  */
 static __isl_give TYPE *FN(read,BASE)(__isl_keep isl_stream *s)
@@ -21,18 +22,19 @@ static __isl_give TYPE *FN(read,BASE)(__isl_keep isl_stream *s)
 
 	tok = isl_stream_next_token(s);
 	type = isl_token_get_type(tok);
-	if (type == ISL_TOKEN_STRING) {
+	isl_stream_push_token(s, tok);
+	if (type == ISL_TOKEN_STRING || type == ISL_TOKEN_AND || type == '*') {
 		char *str;
 		isl_ctx *ctx;
 		TYPE *res;
 
 		ctx = isl_stream_get_ctx(s);
-		str = isl_token_get_str(ctx, tok);
+		str = isl_stream_yaml_read_str(s);
+		if (!str)
+			return NULL;
 		res = FN(TYPE,read_from_str)(ctx, str);
 		free(str);
-		isl_token_free(tok);
 		return res;
 	}
-	isl_stream_push_token(s, tok);
 	return FN(isl_stream_read,BASE)(s);
 }